@@ -63,6 +63,26 @@ TEST(BCastTest, GetBroadcastedShape) {
         GetBroadcastedShape(TensorShape({3, 1, 1}), TensorShape({1, 4, 2}));
     ASSERT_EQ(ShapeOf(shape), "[3, 4, 2]");
   }
+  {
+    auto shape =
+        GetBroadcastedShape(TensorShape(ArrayRef<Index>{4}), TensorShape({}));
+    ASSERT_EQ(ShapeOf(shape), "[4]");
+  }
+  {
+    auto shape =
+        GetBroadcastedShape(TensorShape({2, 1, 4}), TensorShape({3, 1}));
+    ASSERT_EQ(ShapeOf(shape), "[2, 3, 4]");
+  }
+  {
+    auto shape = GetBroadcastedShape(TensorShape({2, 1, 1, 1, 1, 1, 5}),
+                                     TensorShape({3, 1, 1, 1, 1, 1}));
+    ASSERT_EQ(ShapeOf(shape), "[2, 3, 1, 1, 1, 1, 5]");
+  }
+  {
+    auto shape = GetBroadcastedShape(TensorShape({3, 2}), TensorShape({3, 4}));
+    ASSERT_FALSE(static_cast<bool>(shape));
+    llvm::consumeError(shape.takeError());
+  }
 }
 
 TEST(BCastTest, GetArgumentBCast) {
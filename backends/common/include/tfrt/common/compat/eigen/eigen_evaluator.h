@@ -26,6 +26,7 @@
 #include <type_traits>
 
 #include "./thread_pool_device.h"
+#include "tfrt/host_context/parallel_for.h"
 #include "tfrt/support/error_util.h"
 
 namespace tfrt {
@@ -69,6 +70,22 @@ class AsyncEigenEvaluator {
                        std::move(args));
   }
 
+  // Calls `compute(begin, end)` for non-overlapping blocks of the [0, n) range
+  // in parallel, for kernels that are not expressible as Eigen expressions.
+  template <typename Compute, typename ArgLifetimeExtension>
+  AsyncValueRef<Chain> EvaluateParallel(
+      const ExecutionContext& exec_ctx, size_t n,
+      const ParallelFor::BlockSizes& block_sizes, Compute compute,
+      ArgLifetimeExtension args) {
+    auto chain = MakeUnconstructedAsyncValueRef<Chain>();
+    ParallelFor(exec_ctx).Execute(
+        n, block_sizes, std::move(compute),
+        [args = std::move(args), chain = chain.CopyRef()]() {
+          chain.emplace();
+        });
+    return chain;
+  }
+
   template <typename... Args>
   DependencyToken MakeError(Args&&... args) {
     return MakeErrorAsyncValueRef(StrCat(std::forward<Args>(args)...));
@@ -121,6 +138,14 @@ class SyncEigenEvaluator {
     return Error::success();
   }
 
+  template <typename Compute>
+  Error EvaluateParallel(const ExecutionContext& exec_ctx, size_t n,
+                         const ParallelFor::BlockSizes& block_sizes,
+                         Compute compute, NoKeepAlive) {
+    compute(0, n);
+    return Error::success();
+  }
+
   template <typename... Args>
   Error MakeError(Args&&... args) {
     return MakeStringError(std::forward<Args>(args)...);
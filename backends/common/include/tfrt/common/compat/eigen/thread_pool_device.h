@@ -26,7 +26,10 @@
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/host_context.h"
 #include "tfrt/host_context/kernel_frame.h"
+#include "tfrt/host_context/parallel_for.h"
 #include "tfrt/host_context/shared_context.h"
 #include "tfrt/support/thread_local.h"
 #include "tfrt/tensor/dense_host_tensor.h"
@@ -69,6 +72,14 @@ class EigenHostContext : public SharedContext {
 
     // Submits a closure to be run by a thread in the pool.
     void Schedule(std::function<void()> fn) override {
+      // Eigen's cost model doesn't know that the other blocks of a ParallelFor
+      // already keep the worker threads busy, so Eigen expressions evaluated
+      // by a block run in the caller thread instead of oversubscribing them.
+      if (ParallelFor::IsInParallelRegion()) {
+        fn();
+        return;
+      }
+
       // TODO(tfrt-dev): Need to find a way to pass in ExecutionContext here for
       // the async task, so that the task can be scheduled properly.
       EnqueueWork(host_context_, std::move(fn));
@@ -79,7 +90,14 @@ class EigenHostContext : public SharedContext {
       return host_context_->GetNumWorkerThreads();
     }
 
+    // Eigen uses the thread id to pick per-thread scratch buffers (e.g. in
+    // tensor contractions), so it must be in [0, NumThreads()).
     int CurrentThreadId() const override {
+      // Use the real worker thread id if the work queue numbers its workers.
+      int worker_thread_id =
+          host_context_->work_queue().CurrentWorkerThreadId();
+      if (worker_thread_id >= 0) return worker_thread_id;
+
       if (!host_context_->IsInWorkerThread()) return -1;
       return thread_id_.Local();
     }
@@ -14,14 +14,18 @@
  * limitations under the License.
  */
 
-// Conv2D kernel implementation using Eigen contraction.
+// Conv2D kernel implementation using Eigen contraction, or Winograd
+// convolution for stride 1 3x3 kernels.
 
 #ifndef TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_KERNELS_CONV2D_H_
 #define TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_KERNELS_CONV2D_H_
 
+#include <algorithm>
 #include <cstdint>
+#include <type_traits>
 
 #include "conv2d_shape_functions.h"
+#include "conv2d_winograd.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/Error.h"
 #include "tfrt/common/compat/eigen/contraction_output_kernel.h"
@@ -69,6 +73,39 @@ inline llvm::Error CheckBatchNormArgs(const Conv2DParams& params,
   return llvm::Error::success();
 }
 
+enum class Conv2DAlgorithm {
+  // 1x1 convolution as a contraction of the input with the filter matrix.
+  kContraction,
+  // Winograd F(2x2, 3x3), see conv2d_winograd.h.
+  kWinograd,
+  // Contraction of the filter with the image patches (im2col).
+  kSpatialConvolution,
+};
+
+// Winograd input and output transforms are only amortized by the matrix
+// multiplications with at least this many input and output channels.
+constexpr Index kMinWinogradChannels = 16;
+
+// Selects the Conv2D algorithm from the convolution shapes.
+template <typename T>
+Conv2DAlgorithm SelectConv2DAlgorithm(const Conv2DParams& params) {
+  const FixedRankShape<4>& kernel_shape = params.kernel_shape;
+  if (kernel_shape[0] == 1 && kernel_shape[1] == 1 &&      // 1x1 kernel
+      params.strides[0] == 1 && params.strides[1] == 1 &&  // 1x1 stride
+      params.padding_type != PaddingType::kExplicit)
+    return Conv2DAlgorithm::kContraction;
+
+  // The filter transform divides by 2, so integer types can't use Winograd.
+  // Tiles are 2x2, and smaller outputs would mostly compute padding.
+  if (std::is_floating_point<T>::value && IsWinogradConv2D(params) &&
+      kernel_shape[2] >= kMinWinogradChannels &&
+      kernel_shape[3] >= kMinWinogradChannels &&
+      params.output_shape[1] >= 4 && params.output_shape[2] >= 4)
+    return Conv2DAlgorithm::kWinograd;
+
+  return Conv2DAlgorithm::kSpatialConvolution;
+}
+
 template <typename T, typename OutputKernelBuilder>
 inline AsyncValueRef<Chain> Conv2DImpl(
     const DenseHostTensor& input, const DenseHostTensor& filter,
@@ -103,11 +140,18 @@ inline AsyncValueRef<Chain> Conv2DImpl(
   }
 
   const FixedRankShape<4>& kernel_shape = filter_view.FixedShape();
+  const Conv2DAlgorithm algorithm = SelectConv2DAlgorithm<T>(params.get());
+
+  if (algorithm == Conv2DAlgorithm::kWinograd) {
+    // Integer types never select Winograd, and are not instantiated.
+    if constexpr (std::is_floating_point<T>::value) {
+      return WinogradConv2D<T>(input, filter, output, params.get(),
+                               output_kernel.get(), exec_ctx);
+    }
+  }
 
   // 1x1 convolution can be computed as a simple Tensor contraction.
-  if (kernel_shape[0] == 1 && kernel_shape[1] == 1 &&  // 1x1 kernel
-      strides[0] == 1 && strides[1] == 1 &&            // 1x1 stride
-      params->padding_type != PaddingType::kExplicit) {
+  if (algorithm == Conv2DAlgorithm::kContraction) {
     const Index rest_size = params->output_shape[0] *  // batch
                             params->output_shape[1] *  // output height
                             params->output_shape[2];   // output width
@@ -208,6 +252,71 @@ AsyncValueRef<Chain> Conv2DBias(const DenseHostTensor& input,
                        std::move(output_kernel), exec_ctx);
 }
 
+// Folds inference batch normalization of the Conv2D output into the filter
+// and a bias:
+//
+//   scaling_factor = (variance + epsilon).rsqrt() * scale
+//   folded_filter[..., c] = filter[..., c] * scaling_factor[c]
+//   bias[c] = offset[c] - mean[c] * scaling_factor[c]
+//
+// Conv2DBias with the folded filter and bias then computes Conv2DBatchNorm,
+// but skips the batch normalization output kernel. Meant for constant weights
+// (e.g. folded once when a model is loaded). When the batch normalization
+// parameters are not constant, Conv2DBatchNorm fuses them into the
+// contraction output kernel instead.
+template <typename T>
+AsyncValueRef<Chain> FoldConv2DBatchNorm(
+    const DenseHostTensor& filter,
+    const DenseHostTensor& scale,   // aka gamma
+    const DenseHostTensor& offset,  // aka beta
+    const DenseHostTensor& mean, const DenseHostTensor& variance,
+    DenseHostTensor* folded_filter, DenseHostTensor* bias, Chain chain_in,
+    Attribute<float> epsilon, const ExecutionContext& exec_ctx) {
+  DHTIndexableView<T, 4> filter_view(&filter);
+  MutableDHTIndexableView<T, 4> folded_filter_view(folded_filter);
+  DHTIndexableView<T, 1> scale_view(&scale);
+  DHTIndexableView<T, 1> offset_view(&offset);
+  DHTIndexableView<T, 1> mean_view(&mean);
+  DHTIndexableView<T, 1> variance_view(&variance);
+  MutableDHTIndexableView<T, 1> bias_view(bias);
+
+  const FixedRankShape<4>& filter_shape = filter_view.FixedShape();
+  if (auto error = CheckShapeMatch("folded filter shape",
+                                   folded_filter_view.FixedShape(),
+                                   "filter shape", filter_shape)) {
+    return EmitErrorAsync(exec_ctx, StrCat(error));
+  }
+
+  // All batch normalization arguments must match output channels dimension.
+  const Index depth = filter_shape[3];
+  for (const DenseHostTensor* arg : {&scale, &offset, &mean, &variance, bias}) {
+    if (arg->NumElements() != depth) {
+      return EmitErrorAsync(
+          exec_ctx, "batch norm parameter does not match output channels size");
+    }
+  }
+
+  const Index rest_size = filter.NumElements() / std::max<Index>(depth, 1);
+  const FixedRankShape<2> rest_by_depth({rest_size, depth});
+  Eigen::IndexList<Eigen::type2index<1>, Index> one_by_depth;
+  one_by_depth.set(1, depth);
+  Eigen::IndexList<Index, Eigen::type2index<1>> rest_by_one;
+  rest_by_one.set(0, rest_size);
+
+  Eigen::Tensor<T, 1, Eigen::RowMajor, Index> scaling_factor =
+      (AsEigenConstTensor(variance_view) + static_cast<T>(epsilon.get()))
+          .rsqrt() *
+      AsEigenConstTensor(scale_view);
+
+  AsEigenTensor(folded_filter_view, rest_by_depth) =
+      AsEigenConstTensor(filter_view, rest_by_depth) *
+      scaling_factor.reshape(one_by_depth).broadcast(rest_by_one);
+  AsEigenTensor(bias_view) = AsEigenConstTensor(offset_view) -
+                             AsEigenConstTensor(mean_view) * scaling_factor;
+
+  return MakeAvailableAsyncValueRef<Chain>();
+}
+
 }  // namespace internal
 }  // namespace compat
 }  // namespace tfrt
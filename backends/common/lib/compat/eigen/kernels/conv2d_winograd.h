@@ -0,0 +1,301 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Winograd F(2x2, 3x3) convolution for stride 1 3x3 Conv2D.
+//
+// The output is split into 2x2 tiles, and each tile is computed from a 4x4
+// input tile. With the transformed filter U = G g G^T and the transformed
+// input tile V = B^T d B, the output tile is Y = A^T (U . V) A, where `.` is
+// an element wise product that is summed over the input channels. For all
+// tiles, this sum is 16 independent [tiles, in_channels] x [in_channels,
+// out_channels] matrix multiplications, one for each of the 4x4 positions, and
+// it needs 16 multiplications per tile instead of the 36 of the direct 3x3
+// convolution.
+//
+// The larger F(4x4, 3x3) variant needs fewer multiplications still, but its
+// transforms have larger coefficients and a much larger float rounding error,
+// so it is not implemented.
+
+#ifndef TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_KERNELS_CONV2D_WINOGRAD_H_
+#define TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_KERNELS_CONV2D_WINOGRAD_H_
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "conv2d_shape_functions.h"
+#include "tfrt/common/compat/eigen/contraction_output_kernel.h"
+#include "tfrt/common/compat/eigen/tensor_types.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace compat {
+namespace internal {
+
+// Number of 4x4 positions of the transformed tiles.
+constexpr Eigen::Index kWinogradTileSize = 16;
+
+// Number of tiles transformed and multiplied together. The transformed input
+// and output tiles of a block stay in the L2 cache between the transforms and
+// the matrix multiplications.
+constexpr Eigen::Index kWinogradTileBlock = 32;
+
+// Returns true if the convolution can be computed with Winograd F(2x2, 3x3).
+inline bool IsWinogradConv2D(const Conv2DParams& params) {
+  return params.kernel_shape[0] == 3 && params.kernel_shape[1] == 3 &&
+         params.strides[0] == 1 && params.strides[1] == 1 &&
+         params.dilations[0] == 1 && params.dilations[1] == 1;
+}
+
+// Transforms the [3, 3, in_channels, out_channels] filter into U = G g G^T for
+// every pair of channels. `u` is [16, in_channels, out_channels], where
+//
+//       | 1    0    0   |
+//   G = | 1/2  1/2  1/2 |
+//       | 1/2 -1/2  1/2 |
+//       | 0    0    1   |
+template <typename T>
+void WinogradFilterTransform(const T* filter, Eigen::Index size, T* u) {
+  const T half = static_cast<T>(0.5);
+  for (Eigen::Index i = 0; i < size; ++i) {
+    T g[3][3];
+    for (int r = 0; r < 3; ++r)
+      for (int s = 0; s < 3; ++s) g[r][s] = filter[(r * 3 + s) * size + i];
+
+    // G g.
+    T t[4][3];
+    for (int s = 0; s < 3; ++s) {
+      t[0][s] = g[0][s];
+      t[1][s] = half * (g[0][s] + g[1][s] + g[2][s]);
+      t[2][s] = half * (g[0][s] - g[1][s] + g[2][s]);
+      t[3][s] = g[2][s];
+    }
+    // (G g) G^T.
+    for (int r = 0; r < 4; ++r) {
+      T* row = u + r * 4 * size + i;
+      row[0 * size] = t[r][0];
+      row[1 * size] = half * (t[r][0] + t[r][1] + t[r][2]);
+      row[2 * size] = half * (t[r][0] - t[r][1] + t[r][2]);
+      row[3 * size] = t[r][2];
+    }
+  }
+}
+
+// Transforms the 4x4 input tile `d` into V = B^T d B. Tile elements point to
+// vectors of `channels` values, or are nullptr in the padding. `v` is written
+// with a stride of `v_stride` between the 16 positions, where
+//
+//         | 1  0 -1  0 |
+//   B^T = | 0  1  1  0 |
+//         | 0 -1  1  0 |
+//         | 0  1  0 -1 |
+template <typename T>
+void WinogradInputTransform(const T* const (&d)[4][4], Eigen::Index channels,
+                            T* v, Eigen::Index v_stride) {
+  for (Eigen::Index c = 0; c < channels; ++c) {
+    T x[4][4];
+    for (int r = 0; r < 4; ++r)
+      for (int s = 0; s < 4; ++s) x[r][s] = d[r][s] ? d[r][s][c] : T(0);
+
+    // B^T d.
+    T t[4][4];
+    for (int s = 0; s < 4; ++s) {
+      t[0][s] = x[0][s] - x[2][s];
+      t[1][s] = x[1][s] + x[2][s];
+      t[2][s] = x[2][s] - x[1][s];
+      t[3][s] = x[1][s] - x[3][s];
+    }
+    // (B^T d) B.
+    for (int r = 0; r < 4; ++r) {
+      T* row = v + r * 4 * v_stride + c;
+      row[0 * v_stride] = t[r][0] - t[r][2];
+      row[1 * v_stride] = t[r][1] + t[r][2];
+      row[2 * v_stride] = t[r][2] - t[r][1];
+      row[3 * v_stride] = t[r][1] - t[r][3];
+    }
+  }
+}
+
+// Transforms the 16 products `m`, with a stride of `m_stride` between the
+// positions, into the 2x2 output tile Y = A^T m A, where
+//
+//   A^T = | 1  1  1  0 |
+//         | 0  1 -1 -1 |
+//
+// Output tile elements are vectors of `channels` values, and elements outside
+// of the output are nullptr.
+template <typename T>
+void WinogradOutputTransform(const T* m, Eigen::Index m_stride,
+                             Eigen::Index channels, T* const (&y)[2][2]) {
+  for (Eigen::Index c = 0; c < channels; ++c) {
+    T x[4][4];
+    for (int r = 0; r < 4; ++r)
+      for (int s = 0; s < 4; ++s) x[r][s] = m[(r * 4 + s) * m_stride + c];
+
+    // A^T m.
+    T t[2][4];
+    for (int s = 0; s < 4; ++s) {
+      t[0][s] = x[0][s] + x[1][s] + x[2][s];
+      t[1][s] = x[1][s] - x[2][s] - x[3][s];
+    }
+    // (A^T m) A.
+    for (int r = 0; r < 2; ++r) {
+      if (y[r][0]) y[r][0][c] = t[r][0] + t[r][1] + t[r][2];
+      if (y[r][1]) y[r][1][c] = t[r][1] - t[r][2] - t[r][3];
+    }
+  }
+}
+
+// Computes the stride 1 3x3 convolution of the NHWC `input` with the HWIO
+// `filter` into `output`, and applies `output_kernel` (see
+// contraction_output_kernel.h) to every output pixel. Tiles are computed in
+// parallel. Returned chain becomes available when `output` is computed.
+template <typename T, typename OutputKernel>
+AsyncValueRef<Chain> WinogradConv2D(const DenseHostTensor& input,
+                                    const DenseHostTensor& filter,
+                                    DenseHostTensor* output,
+                                    const Conv2DParams& params,
+                                    OutputKernel output_kernel,
+                                    const ExecutionContext& exec_ctx) {
+  using Index = Eigen::Index;
+  using Matrix =
+      Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  using MatrixMap = Eigen::Map<Matrix>;
+  using ConstMatrixMap = Eigen::Map<const Matrix>;
+
+  const Index batch = params.input_shape[0];
+  const Index in_height = params.input_shape[1];
+  const Index in_width = params.input_shape[2];
+  const Index in_channels = params.input_shape[3];
+  const Index out_height = params.output_shape[1];
+  const Index out_width = params.output_shape[2];
+  const Index out_channels = params.output_shape[3];
+  const Index padding_top = params.paddings[0];
+  const Index padding_left = params.paddings[2];
+
+  const Index tile_rows = (out_height + 1) / 2;
+  const Index tile_cols = (out_width + 1) / 2;
+  const Index num_tiles = batch * tile_rows * tile_cols;
+  if (num_tiles == 0) return GetReadyChain();
+
+  // Filters are transformed on every call, it is cheap compared to the
+  // convolution of a whole batch.
+  auto u = std::make_shared<std::vector<T>>(kWinogradTileSize * in_channels *
+                                            out_channels);
+  WinogradFilterTransform(static_cast<const T*>(filter.data()),
+                          in_channels * out_channels, u->data());
+
+  auto compute = [=, input_buffer = input.buffer().CopyRef(),
+                  output_buffer = output->buffer().CopyRef()](size_t begin,
+                                                              size_t end) {
+    const T* in = static_cast<const T*>(input_buffer->data());
+    T* out = static_cast<T*>(output_buffer->data());
+
+    Eigen::TensorContractionParams contraction_params;
+    contraction_params.swapped_arguments = true;
+
+    // Transformed input and output tiles of a block: [16, tiles, channels].
+    std::vector<T> v(kWinogradTileSize * kWinogradTileBlock * in_channels);
+    std::vector<T> m(kWinogradTileSize * kWinogradTileBlock * out_channels);
+
+    for (Index block = begin; block < end; block += kWinogradTileBlock) {
+      const Index block_size = std::min<Index>(kWinogradTileBlock, end - block);
+      const Index v_stride = kWinogradTileBlock * in_channels;
+      const Index m_stride = kWinogradTileBlock * out_channels;
+
+      // Decodes a tile index into the batch and the top left output pixel.
+      auto tile_origin = [&](Index tile, Index* b, Index* y, Index* x) {
+        *b = tile / (tile_rows * tile_cols);
+        *y = (tile / tile_cols) % tile_rows * 2;
+        *x = tile % tile_cols * 2;
+      };
+
+      for (Index t = 0; t < block_size; ++t) {
+        Index b, y, x;
+        tile_origin(block + t, &b, &y, &x);
+        const T* d[4][4];
+        for (int r = 0; r < 4; ++r) {
+          for (int s = 0; s < 4; ++s) {
+            const Index iy = y + r - padding_top;
+            const Index ix = x + s - padding_left;
+            const bool inside =
+                iy >= 0 && iy < in_height && ix >= 0 && ix < in_width;
+            d[r][s] =
+                inside ? in + ((b * in_height + iy) * in_width + ix) *
+                                  in_channels
+                       : nullptr;
+          }
+        }
+        WinogradInputTransform(d, in_channels, v.data() + t * in_channels,
+                               v_stride);
+      }
+
+      for (Index i = 0; i < kWinogradTileSize; ++i) {
+        ConstMatrixMap lhs(v.data() + i * v_stride, block_size, in_channels);
+        ConstMatrixMap rhs(u->data() + i * in_channels * out_channels,
+                           in_channels, out_channels);
+        MatrixMap(m.data() + i * m_stride, block_size, out_channels)
+            .noalias() = lhs * rhs;
+      }
+
+      for (Index t = 0; t < block_size; ++t) {
+        Index b, y, x;
+        tile_origin(block + t, &b, &y, &x);
+        T* pixels[2][2];
+        for (int r = 0; r < 2; ++r) {
+          for (int s = 0; s < 2; ++s) {
+            const bool inside = y + r < out_height && x + s < out_width;
+            pixels[r][s] =
+                inside ? out + ((b * out_height + y + r) * out_width + x + s) *
+                                   out_channels
+                       : nullptr;
+          }
+        }
+        WinogradOutputTransform(m.data() + t * out_channels, m_stride,
+                                out_channels, pixels);
+
+        // Output channels of the pixels in a tile row are contiguous, and form
+        // the columns of a contraction output block.
+        for (int r = 0; r < 2; ++r) {
+          if (!pixels[r][0]) continue;
+          const Index num_cols = pixels[r][1] ? 2 : 1;
+          output_kernel(ContractionOutputMapper<T>(pixels[r][0], out_channels),
+                        contraction_params, 0, 0, out_channels, num_cols);
+        }
+      }
+    }
+  };
+
+  // Every tile loads a 4x4 input tile and stores a 2x2 output tile, and
+  // multiplies 16 input channel vectors with the transformed filter.
+  const double bytes_loaded = kWinogradTileSize * in_channels * sizeof(T);
+  const double bytes_stored = 4 * out_channels * sizeof(T);
+  const double compute_cycles =
+      static_cast<double>(kWinogradTileSize) * in_channels * out_channels;
+
+  return ParallelFor(exec_ctx).Execute(
+      num_tiles,
+      ParallelFor::BlockSizes::Cost(bytes_loaded, bytes_stored, compute_cycles),
+      std::move(compute));
+}
+
+}  // namespace internal
+}  // namespace compat
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_KERNELS_CONV2D_WINOGRAD_H_
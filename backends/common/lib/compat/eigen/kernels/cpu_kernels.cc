@@ -48,6 +48,17 @@ static AsyncValueRef<Chain> MaxPool2D(const DenseHostTensor& input,
                         ksize.data(), exec_ctx);
 }
 
+template <typename T>
+static AsyncValueRef<Chain> AvgPool2D(const DenseHostTensor& input,
+                                      DenseHostTensor* output, Chain chain_in,
+                                      StringAttribute padding,
+                                      ArrayAttribute<Index> ksize,
+                                      ArrayAttribute<Index> strides,
+                                      const ExecutionContext& exec_ctx) {
+  return AvgPoolImpl<T>(input, output, padding.get(), strides.data(),
+                        ksize.data(), exec_ctx);
+}
+
 template <typename T>
 static AsyncValueRef<Chain> Conv2D(const DenseHostTensor& input,
                                    const DenseHostTensor& filter,
@@ -82,6 +93,8 @@ void RegisterEigenKernels(KernelRegistry* registry) {
                       TFRT_KERNEL(compat::ZeroPadding<float>));
   registry->AddKernel("eigen.max_pooling_2d.f32",
                       TFRT_KERNEL(compat::MaxPool2D<float>));
+  registry->AddKernel("eigen.avg_pooling_2d.f32",
+                      TFRT_KERNEL(compat::AvgPool2D<float>));
   registry->AddKernel("eigen.conv2d.f32", TFRT_KERNEL(compat::Conv2D<float>));
   registry->AddKernel("eigen.batch_norm.f32",
                       TFRT_KERNEL(compat::FusedBatchNormV3Kernel<float>));
@@ -92,6 +105,12 @@ void RegisterEigenKernels(KernelRegistry* registry) {
       TFRT_KERNEL(compat::internal::Conv2DBatchNorm<float, compat::Relu>));
   registry->AddKernel("eigen.conv2d.bias.f32",
                       TFRT_KERNEL(compat::internal::Conv2DBias<float>));
+  registry->AddKernel(
+      "eigen.conv2d.bias.relu.f32",
+      TFRT_KERNEL(compat::internal::Conv2DBias<float, compat::Relu>));
+  registry->AddKernel(
+      "eigen.conv2d.fold_batch_norm.f32",
+      TFRT_KERNEL(compat::internal::FoldConv2DBatchNorm<float>));
 }
 
 }  // namespace tfrt
@@ -12,11 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-// Max Pooling 2D implemented with Eigen.
+// Max and Average Pooling 2D implemented with Eigen.
 
 #ifndef TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_KERNELS_MAX_POOLING_H_
 #define TFRT_BACKENDS_COMMON_LIB_COMPAT_EIGEN_KERNELS_MAX_POOLING_H_
 
+#include <algorithm>
 #include <cstdint>
 
 #include "tfrt/common/compat/eigen/eigen_kernel.h"
@@ -29,14 +30,21 @@
 
 namespace tfrt {
 namespace compat {
-
-template <typename T>
-static AsyncValueRef<Chain> MaxPoolImpl(const DenseHostTensor& input,
-                                        DenseHostTensor* output,
-                                        string_view padding,
-                                        ArrayRef<Index> strides,
-                                        ArrayRef<Index> ksize,
-                                        const ExecutionContext& exec_ctx) {
+namespace internal {
+
+enum class PoolingType { kMax, kAvg };
+
+// Pools NHWC `input` into `output` over `ksize` windows. Channels are the
+// innermost dimension, so every window tap is a contiguous channel vector, and
+// the reduction runs directly on the input without extracting image patches.
+// Window bounds are clipped to the input once per output row and column, and
+// padded taps are never visited. Like Tensorflow, average pooling divides by
+// the number of valid (non padded) taps.
+template <typename T, PoolingType Type>
+AsyncValueRef<Chain> Pool2DImpl(const DenseHostTensor& input,
+                                DenseHostTensor* output, string_view padding,
+                                ArrayRef<Index> strides, ArrayRef<Index> ksize,
+                                const ExecutionContext& exec_ctx) {
   // TODO(ezhulenev): Move shape computation into support library and share with
   // shape computations in convolution.
   DHTIndexableView<T, 4> input_view(&input);
@@ -88,137 +96,122 @@ static AsyncValueRef<Chain> MaxPoolImpl(const DenseHostTensor& input,
     return EmitErrorAsync(exec_ctx, "output tensor has the wrong shape");
   }
 
-  // In the following code we treat every channels vector (innermost dimension)
-  // as a single unit for the purpose of computing a maximum value, and pretend
-  // that we are working with a tensor of size: [batch, height, width].
+  const Index num_channels = shape_output[3];
+  const Index num_rows = shape_output[0] * shape_output[1];
+  if (num_rows * shape_output[2] * num_channels == 0) return GetReadyChain();
+
+  // Every pixel is a vector of [num_channels] elements. Offsets into the input
+  // are not aligned to the packet size.
   using ChannelVector = Eigen::Tensor<T, 1, Eigen::RowMajor, Index>;
   using InputChannels = Eigen::TensorMap<const ChannelVector, Eigen::Unaligned>;
   using OutputChannels = Eigen::TensorMap<ChannelVector, Eigen::Unaligned>;
 
-  // At every 3 dimensional coordinate we have a vector of size [num_channels].
-  const size_t num_channels = shape_output[3];
-
-  // Coordinates: [batch, row, col].
-  using Coords = std::array<Index, 3>;
-
-  // Returns OutputChannels for 3 dimensional coordinates.
-  auto output_channels = [output = output->CopyRef(),
-                          num_channels](const Coords& coords) mutable {
-    MutableDHTIndexableView<T, 4> output_view(&output);
-    T* data = &output_view.ElementAt(coords[0], coords[1], coords[2], 0);
-    return OutputChannels(data, num_channels);
-  };
-
-  // Returns InputChannels for 3 dimensional coordinates.
-  auto input_channels = [input = input.CopyRef(),
-                         num_channels](const Coords& coords) mutable {
+  // Computes output rows in the [start, end) range, where the row index is
+  // batch * output_height + row. All the state is captured by value, because
+  // this function will be executed asynchronously.
+  const Index stride_h = strides[0], stride_w = strides[1];
+  const Index ksize_h = ksize[0], ksize_w = ksize[1];
+  const Index pad_top = padding_numbers[0], pad_left = padding_numbers[2];
+  auto compute = [=, input = input.CopyRef(), output = output->CopyRef()](
+                     size_t start, size_t end) mutable -> void {
     DHTIndexableView<T, 4> input_view(&input);
-    const T* data = &input_view.ElementAt(coords[0], coords[1], coords[2], 0);
-    return InputChannels(data, num_channels);
-  };
-
-  // Strides in the output tensor (excluding innermost channels dimensions).
-  const Coords output_strides = {
-      shape_output[1] * shape_output[2],  // batch stride
-      shape_output[2],                    // height stride
-      1                                   // width stride
-  };
-
-  // Number of output channel-vectors.
-  const Index num_outputs = shape_output[0] * shape_output[1] * shape_output[2];
-
-  // Computes [batch, row, col] coordinates of an output channels from one
-  // dimensional index in [0, num_outputs) range.
-  const auto output_coords = [output_strides](Index index) -> Coords {
-    const Index i0 = index / output_strides[0];
-    index -= i0 * output_strides[0];
-
-    const Index i1 = index / output_strides[1];
-    index -= i1 * output_strides[1];
-
-    const Index i2 = index;
-
-    return {i0, i1, i2};
-  };
+    MutableDHTIndexableView<T, 4> output_view(&output);
+    const Index in_height = shape_input[1];
+    const Index in_width = shape_input[2];
+    const Index out_height = shape_output[1];
+    const Index out_width = shape_output[2];
 
-  // Computes MaxPool outputs in the [start, end) range. All the state captured
-  // by value explicitly, because this function will be executed asynchonously.
-  std::array<Index, 2> strides_t{strides[0], strides[1]};
-  std::array<Index, 2> ksize_t{ksize[0], ksize[1]};
-  auto compute = [strides = strides_t, ksize = ksize_t, padding_numbers,
-                  shape_input, input_channels = std::move(input_channels),
-                  output_channels = std::move(output_channels),
-                  output_coords](size_t start, size_t end) mutable -> void {
-    // Image patch input channels.
-    std::vector<InputChannels> input_channels_pool;
-    input_channels_pool.reserve(ksize[0] * ksize[1]);
-
-    // Iterate over all outputs in the [start, end) range.
     for (Index index = start; index < end; ++index) {
-      const Coords coords = output_coords(index);
-      input_channels_pool.clear();
-
-      // Iterate over the spatial pooling patch.
-      for (Index x = 0; x < ksize[0]; ++x) {
-        for (Index y = 0; y < ksize[1]; ++y) {
-          // Coordinates in the input tensor.
-          const Coords input_coords = {
-              coords[0],                                        // batch
-              coords[1] * strides[0] + x - padding_numbers[0],  // row (height)
-              coords[2] * strides[1] + y - padding_numbers[2],  // col (width)
-          };
-
-          // Check if the input coordinates are in the padded space.
-          const bool pad =
-              input_coords[1] < 0 || input_coords[1] >= shape_input[1] ||
-              input_coords[2] < 0 || input_coords[2] >= shape_input[2];
-          if (!pad) {
-            input_channels_pool.push_back(input_channels(input_coords));
+      const Index batch = index / out_height;
+      const Index row = index % out_height;
+
+      // Window rows clipped to the input.
+      const Index h_start = row * stride_h - pad_top;
+      const Index h_begin = std::max<Index>(h_start, 0);
+      const Index h_end = std::min<Index>(h_start + ksize_h, in_height);
+
+      for (Index col = 0; col < out_width; ++col) {
+        // Window columns clipped to the input.
+        const Index w_start = col * stride_w - pad_left;
+        const Index w_begin = std::max<Index>(w_start, 0);
+        const Index w_end = std::min<Index>(w_start + ksize_w, in_width);
+        assert(h_begin < h_end && w_begin < w_end);
+
+        OutputChannels out(&output_view.ElementAt(batch, row, col, 0),
+                           num_channels);
+        auto in = [&](Index h, Index w) {
+          return InputChannels(&input_view.ElementAt(batch, h, w, 0),
+                               num_channels);
+        };
+
+        // Initialize output channels with the first valid tap, and reduce the
+        // rest of the window into it one input row at a time.
+        out = in(h_begin, w_begin);
+        for (Index h = h_begin; h < h_end; ++h) {
+          Index w = h == h_begin ? w_begin + 1 : w_begin;
+          // Reduce 2 taps in a single Eigen expression to halve the number of
+          // output loads and stores.
+          for (; w + 1 < w_end; w += 2) {
+            if (Type == PoolingType::kMax) {
+              out = out.cwiseMax(in(h, w).cwiseMax(in(h, w + 1)));
+            } else {
+              out = out + (in(h, w) + in(h, w + 1));
+            }
+          }
+          if (w < w_end) {
+            if (Type == PoolingType::kMax) {
+              out = out.cwiseMax(in(h, w));
+            } else {
+              out = out + in(h, w);
+            }
           }
         }
-      }
-
-      assert(!input_channels_pool.empty());
-      Index i = 0;
-
-      // Initialize output channels.
-      auto out = output_channels(coords);
-      out = out.constant(std::numeric_limits<T>::min());
-
-      // Process 3 input channels in a single Eigen expression to minimize
-      // memory traffic and keep temporary data in the registers.
-      const Index vectorized_pooling =
-          static_cast<Index>(input_channels_pool.size()) - 3;
-      for (; i < vectorized_pooling; i += 3) {
-        auto in0 = input_channels_pool[i + 0];
-        auto in1 = input_channels_pool[i + 1];
-        auto in2 = input_channels_pool[i + 2];
-        out = out.cwiseMax(in0).cwiseMax(in1.cwiseMax(in2));
-      }
 
-      // Process remaining channels one by one.
-      for (; i < static_cast<Index>(input_channels_pool.size()); ++i) {
-        auto in0 = input_channels_pool[i];
-        out = out.cwiseMax(in0);
+        if (Type == PoolingType::kAvg) {
+          const T count = static_cast<T>((h_end - h_begin) * (w_end - w_begin));
+          out = out * out.constant(T(1) / count);
+        }
       }
     }
   };
 
-  // Compute minimum parallel for block size, to make sure that we do not create
-  // too many small tasks if extracted image patches are tiny.
-  // TODO(ezhulenev): Use Eigen expression cost model? Or add TFRT cost model?
-  static constexpr size_t kMinPatchSize = 1000;
-  const size_t image_patch_size = num_channels * ksize[0] * ksize[1];
-  const size_t min_block_size =
-      std::max(static_cast<size_t>(1), kMinPatchSize / image_patch_size);
-  auto chain = MakeUnconstructedAsyncValueRef<Chain>();
-  auto args = KeepBuffers::alive(&input, output);
-
-  ParallelFor(exec_ctx).Execute(
-      num_outputs, ParallelFor::BlockSizes::Min(min_block_size),
-      std::move(compute),
-      [chain = chain.CopyRef(), args = std::move(args)]() { chain.emplace(); });
-  return chain;
+  // Every output row loads ksize[0] input rows (shared with neighbouring rows
+  // if windows overlap) and stores a single row.
+  const Index row_size = shape_output[2] * num_channels;
+  const double bytes_loaded =
+      static_cast<double>(ksize_h) * shape_input[2] * num_channels * sizeof(T);
+  const double bytes_stored = static_cast<double>(row_size) * sizeof(T);
+  const double compute_cycles =
+      static_cast<double>(row_size) * ksize_h * ksize_w;
+
+  return ParallelFor(exec_ctx).Execute(
+      num_rows,
+      ParallelFor::BlockSizes::Cost(bytes_loaded, bytes_stored, compute_cycles),
+      std::move(compute));
+}
+
+}  // namespace internal
+
+template <typename T>
+static AsyncValueRef<Chain> MaxPoolImpl(const DenseHostTensor& input,
+                                        DenseHostTensor* output,
+                                        string_view padding,
+                                        ArrayRef<Index> strides,
+                                        ArrayRef<Index> ksize,
+                                        const ExecutionContext& exec_ctx) {
+  return internal::Pool2DImpl<T, internal::PoolingType::kMax>(
+      input, output, padding, strides, ksize, exec_ctx);
+}
+
+template <typename T>
+static AsyncValueRef<Chain> AvgPoolImpl(const DenseHostTensor& input,
+                                        DenseHostTensor* output,
+                                        string_view padding,
+                                        ArrayRef<Index> strides,
+                                        ArrayRef<Index> ksize,
+                                        const ExecutionContext& exec_ctx) {
+  return internal::Pool2DImpl<T, internal::PoolingType::kAvg>(
+      input, output, padding, strides, ksize, exec_ctx);
 }
 
 }  // namespace compat
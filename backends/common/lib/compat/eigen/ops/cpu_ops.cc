@@ -60,7 +60,8 @@ static AsyncValueRef<DenseHostTensor> TfPadOp(
   return ForwardValue(output.getValue(), std::move(chain));
 }
 
-static AsyncValueRef<DenseHostTensor> TfMaxPoolOp(
+template <internal::PoolingType Type>
+static AsyncValueRef<DenseHostTensor> TfPoolOp(
     const DenseHostTensor& input, const OpAttrsRef& attrs,
     const TensorMetadata& output_md, const ExecutionContext& exec_ctx) {
   HostContext* host = exec_ctx.host();
@@ -91,11 +92,11 @@ static AsyncValueRef<DenseHostTensor> TfMaxPoolOp(
   AsyncValueRef<Chain> chain;
   switch (input.dtype()) {
     default:
-      chain = EmitErrorAsync(exec_ctx, "unsupported dtype for TfMaxPoolOp");
+      chain = EmitErrorAsync(exec_ctx, "unsupported dtype for TfPoolOp");
       break;
 #define DTYPE_FLOAT(ENUM)                                                   \
   case DType::ENUM:                                                         \
-    chain = MaxPoolImpl<EigenTypeForDTypeKind<DType::ENUM>>(                \
+    chain = internal::Pool2DImpl<EigenTypeForDTypeKind<DType::ENUM>, Type>( \
         input, output.getPointer(), padding, strides_t, ksize_t, exec_ctx); \
     break;
 #include "tfrt/dtype/dtype.def"  // NOLINT
@@ -220,10 +221,18 @@ static std::array<AsyncValueRef<DenseHostTensor>, 6> TfFusedBatchNormV3Op(
 void RegisterEigenTFOps(CpuOpRegistry* op_registry) {
   op_registry->AddOp("tf.Pad", TFRT_CPU_OP(compat::TfPadOp),
                      CpuOpFlags::NoSideEffects);
-  op_registry->AddOp("tf.MaxPool", TFRT_CPU_OP(compat::TfMaxPoolOp),
-                     CpuOpFlags::NoSideEffects,
-                     {"padding", "explicit_paddings", "data_format", "strides",
-                      "dilations", "ksize"});
+  op_registry->AddOp(
+      "tf.MaxPool",
+      TFRT_CPU_OP(compat::TfPoolOp<compat::internal::PoolingType::kMax>),
+      CpuOpFlags::NoSideEffects,
+      {"padding", "explicit_paddings", "data_format", "strides", "dilations",
+       "ksize"});
+  op_registry->AddOp(
+      "tf.AvgPool",
+      TFRT_CPU_OP(compat::TfPoolOp<compat::internal::PoolingType::kAvg>),
+      CpuOpFlags::NoSideEffects,
+      {"padding", "explicit_paddings", "data_format", "strides", "dilations",
+       "ksize"});
   op_registry->AddOp(
       "tf.Conv2D", TFRT_CPU_OP(compat::TfConv2DOp), CpuOpFlags::NoSideEffects,
       {"padding", "explicit_paddings", "data_format", "strides", "dilations"});
@@ -20,6 +20,8 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
+
 #include "llvm/Support/raw_ostream.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/forward_decls.h"
@@ -27,35 +29,67 @@
 
 namespace tfrt {
 
-Expected<TensorShape> GetBroadcastedShape(const TensorShape& arg0_shape,
-                                          const TensorShape& arg1_shape) {
-  const int rank = std::max(arg0_shape.GetRank(), arg1_shape.GetRank());
-
-  llvm::SmallVector<Index, 8> ret;
-  ret.reserve(rank);
+namespace {
 
-  auto dim = [](const TensorShape& shape, int i) -> Index {
-    if (i >= shape.GetRank()) return 1;
-    return shape.GetDimensionSize(shape.GetRank() - i - 1);
-  };
+// Shapes up to this rank are broadcast in fixed size arrays on the stack.
+constexpr int kMaxInlineRank = 6;
 
-  for (int i = 0; i < rank; i++) {
-    const Index arg0_dim = dim(arg0_shape, i);
-    const Index arg1_dim = dim(arg1_shape, i);
+// Broadcasts dimensions aligned to the right into `ret`. `arg0_dims` and
+// `arg1_dims` must have `rank` elements, shorter shapes padded with ones.
+Error BroadcastDims(const Index* arg0_dims, const Index* arg1_dims, int rank,
+                    Index* ret) {
+  for (int i = 0; i < rank; ++i) {
+    const Index arg0_dim = arg0_dims[i];
+    const Index arg1_dim = arg1_dims[i];
 
-    if (arg0_dim == arg1_dim) {
-      ret.push_back(arg0_dim);
+    if (arg0_dim == arg1_dim || arg1_dim == 1) {
+      ret[i] = arg0_dim;
     } else if (arg0_dim == 1) {
-      ret.push_back(arg1_dim);
-    } else if (arg1_dim == 1) {
-      ret.push_back(arg0_dim);
+      ret[i] = arg1_dim;
     } else {
       return MakeStringError("Dimensions must be equal, but are ", arg0_dim,
                              " and ", arg1_dim);
     }
   }
+  return Error::success();
+}
+
+// Reads the dimensions of `shape` into the last GetRank() elements of `dims`
+// and fills the leading `rank - GetRank()` elements with ones.
+void GetPaddedDimensions(const TensorShape& shape, int rank, Index* dims) {
+  const int pad = rank - shape.GetRank();
+  std::fill(dims, dims + pad, 1);
+  shape.GetDimensions(MutableArrayRef<Index>(dims + pad, shape.GetRank()));
+}
+
+}  // namespace
+
+Expected<TensorShape> GetBroadcastedShape(const TensorShape& arg0_shape,
+                                          const TensorShape& arg1_shape) {
+  // Identical shapes and broadcasts of a scalar are the common cases in
+  // elementwise ops and do not need to look at individual dimensions.
+  if (arg0_shape == arg1_shape) return arg0_shape;
+  if (arg1_shape.GetRank() == 0) return arg0_shape;
+  if (arg0_shape.GetRank() == 0) return arg1_shape;
+
+  const int rank = std::max(arg0_shape.GetRank(), arg1_shape.GetRank());
+
+  if (rank <= kMaxInlineRank) {
+    Index arg0_dims[kMaxInlineRank], arg1_dims[kMaxInlineRank];
+    Index ret[kMaxInlineRank];
+    GetPaddedDimensions(arg0_shape, rank, arg0_dims);
+    GetPaddedDimensions(arg1_shape, rank, arg1_dims);
+    if (auto err = BroadcastDims(arg0_dims, arg1_dims, rank, ret))
+      return std::move(err);
+    return TensorShape(ArrayRef<Index>(ret, rank));
+  }
 
-  std::reverse(ret.begin(), ret.end());
+  llvm::SmallVector<Index, 8> arg0_dims(rank), arg1_dims(rank), ret(rank);
+  GetPaddedDimensions(arg0_shape, rank, arg0_dims.data());
+  GetPaddedDimensions(arg1_shape, rank, arg1_dims.data());
+  if (auto err = BroadcastDims(arg0_dims.data(), arg1_dims.data(), rank,
+                               ret.data()))
+    return std::move(err);
   return TensorShape(ret);
 }
 
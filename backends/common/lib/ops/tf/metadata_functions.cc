@@ -92,6 +92,20 @@ static TensorMetadata UnaryIdentityMd(const TensorMetadata& input) {
   return input;
 }
 
+// result = fused cwise ops applied to source. Result and source have same
+// metadata, operands of the fused ops have source shape or a single element.
+static Expected<TensorMetadata> TfFusedCwiseOpMd(
+    const TensorMetadata& input, VariadicOpArg<TensorMetadata> fusion_inputs) {
+  for (size_t i = 0; i < fusion_inputs.size(); ++i) {
+    const TensorMetadata& operand = fusion_inputs[i];
+    if (operand.dtype != input.dtype)
+      return MakeStringError("incompatible dtypes for FusedCwise operand ", i);
+    if (operand.shape.GetNumElements() != 1 && operand.shape != input.shape)
+      return MakeStringError("incompatible shape for FusedCwise operand ", i);
+  }
+  return input;
+}
+
 static Expected<TensorMetadata> MatMulMd(const TensorMetadata& a,
                                          const TensorMetadata& b,
                                          VariadicOpArg<TensorMetadata> _,
@@ -138,6 +152,54 @@ static Expected<TensorMetadata> MatMulMd(const TensorMetadata& a,
                                   b.shape.GetDimensionSize(b_remaining_dim)});
 }
 
+static Expected<TensorMetadata> BatchMatMulMd(const TensorMetadata& a,
+                                              const TensorMetadata& b,
+                                              const OpAttrsRef& attrs) {
+  if (a.dtype != b.dtype)
+    return MakeStringError("incompatible dtypes for BatchMatMul: In[0]: ",
+                           a.dtype, ", In[1]: ", b.dtype);
+
+  const int a_rank = a.shape.GetRank();
+  const int b_rank = b.shape.GetRank();
+  if (a_rank < 2 || b_rank < 2)
+    return MakeStringError(
+        "arguments of batch matmul op must have rank >= 2. Actual ranks are ",
+        a_rank, " and ", b_rank);
+
+  bool adj_x;
+  if (!attrs.Get("adj_x", &adj_x)) {
+    return MakeStringError(
+        "'adj_x' attribute is not specified for BatchMatMul op");
+  }
+  bool adj_y;
+  if (!attrs.Get("adj_y", &adj_y)) {
+    return MakeStringError(
+        "'adj_y' attribute is not specified for BatchMatMul op");
+  }
+
+  Index m = a.shape.GetDimensionSize(adj_x ? a_rank - 1 : a_rank - 2);
+  Index a_k = a.shape.GetDimensionSize(adj_x ? a_rank - 2 : a_rank - 1);
+  Index b_k = b.shape.GetDimensionSize(adj_y ? b_rank - 1 : b_rank - 2);
+  Index n = b.shape.GetDimensionSize(adj_y ? b_rank - 2 : b_rank - 1);
+  if (a_k != b_k)
+    return MakeStringError(
+        "batch matmul arguments have incompatible shapes: In[0]: ", a.shape,
+        ", In[1]: ", b.shape, ". adj_x: ", adj_x, ", adj_y: ", adj_y);
+
+  // Batch dimensions are broadcasted.
+  auto a_dims = GetDimensions(a.shape);
+  auto b_dims = GetDimensions(b.shape);
+  auto batch_shape = GetBroadcastedShape(
+      TensorShape(llvm::makeArrayRef(a_dims).drop_back(2)),
+      TensorShape(llvm::makeArrayRef(b_dims).drop_back(2)));
+  if (!batch_shape) return batch_shape.takeError();
+
+  auto dims = GetDimensions(*batch_shape);
+  dims.push_back(m);
+  dims.push_back(n);
+  return TensorMetadata(a.dtype, dims);
+}
+
 static Expected<TensorMetadata> TfConvOpMd(const TensorMetadata& input,
                                            const TensorMetadata& filter,
                                            const OpAttrsRef& attrs) {
@@ -434,7 +496,7 @@ static Expected<TensorMetadata> TfCastOpMd(const TensorMetadata& input,
 }
 
 template <typename ReductionIndexT>
-static Expected<TensorMetadata> TfMeanOpMdImpl(
+static Expected<TensorMetadata> TfReductionOpMdImpl(
     const TensorMetadata& input, ArrayRef<ReductionIndexT> reduction_indices,
     const OpAttrsRef& attrs) {
   static_assert(std::is_same<ReductionIndexT, int32_t>::value ||
@@ -444,10 +506,10 @@ static Expected<TensorMetadata> TfMeanOpMdImpl(
   for (auto reduction_index : reduction_indices) {
     if (reduction_index < 0 || reduction_index >= input.shape.GetRank()) {
       return MakeStringError(
-          "tf.Mean reduction index must be in [0, input_rank) range");
+          "Reduction index must be in [0, input_rank) range");
     }
     if (reduced_dim[reduction_index]) {
-      return MakeStringError("tf.Mean reduction indices must be unique");
+      return MakeStringError("Reduction indices must be unique");
     }
 
     reduced_dim[reduction_index] = true;
@@ -461,12 +523,12 @@ static Expected<TensorMetadata> TfMeanOpMdImpl(
   return TensorMetadata(input.dtype, output_dims);
 }
 
-static Expected<TensorMetadata> TfMeanOpFoldedMd(const TensorMetadata& input,
-                                                 const OpAttrsRef& attrs) {
+static Expected<TensorMetadata> TfReductionOpFoldedMd(
+    const TensorMetadata& input, const OpAttrsRef& attrs) {
   DenseAttr dense_attr;
   if (!attrs.Get("reduction_indices", &dense_attr)) {
     return MakeStringError(
-        "tf.Mean needs a `reduction_indices` dense attribute");
+        "Reduction needs a `reduction_indices` dense attribute");
   }
 
   DenseView reduction_indices = CreateDenseView(dense_attr);
@@ -474,12 +536,41 @@ static Expected<TensorMetadata> TfMeanOpFoldedMd(const TensorMetadata& input,
 
   switch (reduction_indices.dtype()) {
     case DType::I32:
-      return TfMeanOpMdImpl(input, reduction_indices.GetFlat<int32_t>(), attrs);
+      return TfReductionOpMdImpl(input, reduction_indices.GetFlat<int32_t>(),
+                                 attrs);
     case DType::I64:
-      return TfMeanOpMdImpl(input, reduction_indices.GetFlat<int64_t>(), attrs);
+      return TfReductionOpMdImpl(input, reduction_indices.GetFlat<int64_t>(),
+                                 attrs);
     default:
-      llvm_unreachable("unsupported dtype for reduction_indices in tf.Mean");
+      llvm_unreachable("unsupported dtype for reduction_indices");
+  }
+}
+
+// Metadata function for tf.ArgMax and tf.ArgMin, with the `dimension` argument
+// folded into an attribute.
+static Expected<TensorMetadata> TfArgReductionOpFoldedMd(
+    const TensorMetadata& input, const OpAttrsRef& attrs) {
+  DenseAttr dense_attr;
+  if (!attrs.Get("dimension", &dense_attr))
+    return MakeStringError("ArgMax and ArgMin need a `dimension` attribute");
+
+  DenseView dimension_view = CreateDenseView(dense_attr);
+  int64_t dimension = dimension_view.dtype() == DType::I32
+                          ? dimension_view.GetFlat<int32_t>()[0]
+                          : dimension_view.GetFlat<int64_t>()[0];
+  if (dimension < 0) dimension += input.shape.GetRank();
+  if (dimension < 0 || dimension >= input.shape.GetRank())
+    return MakeStringError("ArgMax and ArgMin dimension must be in [0, rank)");
+
+  OpAttrType output_type = OpAttrType::I64;
+  attrs.Get("output_type", &output_type);
+
+  llvm::SmallVector<Index, 4> output_dims;
+  for (int i = 0; i < input.shape.GetRank(); ++i) {
+    if (i != dimension) output_dims.push_back(input.shape.GetDimensionSize(i));
   }
+
+  return TensorMetadata(OpAttrTypeToDType(output_type), output_dims);
 }
 
 llvm::ArrayRef<std::pair<llvm::StringRef, OpMetadataFn>>
@@ -491,13 +582,22 @@ GetAllTFMetadataFunctions() {
     result->emplace_back("tf.Tanh", TFRT_METADATA(UnaryIdentityMd));
     result->emplace_back("tf.MatMul", TFRT_METADATA(MatMulMd));
     result->emplace_back("tf._FusedMatMul", TFRT_METADATA(MatMulMd));
+    result->emplace_back("tf.BatchMatMulV2", TFRT_METADATA(BatchMatMulMd));
+    result->emplace_back("tf._FusedCwise", TFRT_METADATA(TfFusedCwiseOpMd));
     result->emplace_back("tf.Less", TFRT_METADATA(TfBinaryComparisonOpMd));
     result->emplace_back("tf.Log", TFRT_METADATA(UnaryIdentityMd));
     result->emplace_back("tf.Log1p", TFRT_METADATA(UnaryIdentityMd));
     result->emplace_back("tf.Relu", TFRT_METADATA(UnaryIdentityMd));
     result->emplace_back("tf.Conv2D", TFRT_METADATA(TfConvOpMd));
     result->emplace_back("tf.MaxPool", TFRT_METADATA(TfMaxPoolOpMd));
-    result->emplace_back("_tf.Mean", TFRT_METADATA(TfMeanOpFoldedMd));
+    result->emplace_back("tf.AvgPool", TFRT_METADATA(TfMaxPoolOpMd));
+    result->emplace_back("_tf.Mean", TFRT_METADATA(TfReductionOpFoldedMd));
+    result->emplace_back("_tf.Sum", TFRT_METADATA(TfReductionOpFoldedMd));
+    result->emplace_back("_tf.Max", TFRT_METADATA(TfReductionOpFoldedMd));
+    result->emplace_back("_tf.Min", TFRT_METADATA(TfReductionOpFoldedMd));
+    result->emplace_back("_tf.Prod", TFRT_METADATA(TfReductionOpFoldedMd));
+    result->emplace_back("_tf.ArgMax", TFRT_METADATA(TfArgReductionOpFoldedMd));
+    result->emplace_back("_tf.ArgMin", TFRT_METADATA(TfArgReductionOpFoldedMd));
     result->emplace_back("tf.Mul", TFRT_METADATA(TfBinaryOpMd));
     result->emplace_back("tf.RealDiv", TFRT_METADATA(TfBinaryOpMd));
     result->emplace_back("tf.Rsqrt", TFRT_METADATA(UnaryIdentityMd));
@@ -0,0 +1,156 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Batch normalization folded into the Conv2D filter and bias must match the
+// fused eigen.conv2d.batch_norm results in conv2d_batch_norm_f32.btf.
+
+// RUN: bef_executor %s.bef | FileCheck %s --dump-input=always
+
+// CHECK-LABEL: --- Running 'test_fold_batch_norm_in_1x9x9x8_f_1x1_c16_padding_valid_s_1x1_eps0.01'
+func.func @test_fold_batch_norm_in_1x9x9x8_f_1x1_c16_padding_valid_s_1x1_eps0.01() {
+  %ch0 = tfrt.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/common/mlir_tests/compat/eigen/test_data/conv2d_batch_norm_f32.btf"
+  } : () -> !tfrt.string
+
+  %input_index    = tfrt.constant.i32 0
+  %filter_index   = tfrt.constant.i32 1
+  %scale_index    = tfrt.constant.i32 2
+  %offset_index   = tfrt.constant.i32 3
+  %mean_index     = tfrt.constant.i32 4
+  %var_index      = tfrt.constant.i32 5
+  %expected_index = tfrt.constant.i32 6
+
+  %input = "btf.read_dense_tensor.f32.4"(%path, %input_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %filter = "btf.read_dense_tensor.f32.4"(%path, %filter_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %scale = "btf.read_dense_tensor.f32.1"(%path, %scale_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %offset = "btf.read_dense_tensor.f32.1"(%path, %offset_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %mean = "btf.read_dense_tensor.f32.1"(%path, %mean_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %var = "btf.read_dense_tensor.f32.1"(%path, %var_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %expected = "btf.read_dense_tensor.f32.4"(%path, %expected_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %folded_filter = "tfrt_dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 1 : i64, 8 : i64, 16 : i64] }
+    : () -> !t.tensor
+
+  %bias = "tfrt_dht.create_uninitialized_tensor.f32.1"()
+    { shape = [16 : i64] }
+    : () -> !t.tensor
+
+  %ch1 = "eigen.conv2d.fold_batch_norm.f32"(%filter, %scale, %offset, %mean,
+                                            %var, %folded_filter, %bias, %ch0)
+    { epsilon = 0.01 : f32 }
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor,
+       !t.tensor, !t.tensor, !t.tensor, !tfrt.chain) -> !tfrt.chain
+
+  %output = "tfrt_dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 9 : i64, 9 : i64, 16 : i64] }
+    : () -> !t.tensor
+
+  %ch2 = "eigen.conv2d.bias.f32"(%input, %folded_filter, %bias, %output, %ch1)
+    { padding = "valid",  strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !t.tensor,
+       !t.tensor, !tfrt.chain) -> !tfrt.chain
+
+  %cmp, %ch3 = "tfrt_dht.tensor_allclose.1000ulp.f32"(%expected, %output, %ch2)
+    : (!t.tensor, !t.tensor, !tfrt.chain) -> (i1, !tfrt.chain)
+
+  // CHECK: int1 = 1
+  tfrt.print.i1 %cmp, %ch3
+
+  tfrt.return
+}
+
+// CHECK-LABEL: --- Running 'test_fold_batch_norm_in_1x7x9x10_f_3x2_c16_padding_same_s_1x1_eps0.01'
+func.func @test_fold_batch_norm_in_1x7x9x10_f_3x2_c16_padding_same_s_1x1_eps0.01() {
+  %ch0 = tfrt.new.chain
+
+  %path = "tfrt_test.get_string"() {
+      value = "backends/common/mlir_tests/compat/eigen/test_data/conv2d_batch_norm_f32.btf"
+  } : () -> !tfrt.string
+
+  %input_index    = tfrt.constant.i32 2632
+  %filter_index   = tfrt.constant.i32 2633
+  %scale_index    = tfrt.constant.i32 2634
+  %offset_index   = tfrt.constant.i32 2635
+  %mean_index     = tfrt.constant.i32 2636
+  %var_index      = tfrt.constant.i32 2637
+  %expected_index = tfrt.constant.i32 2638
+
+  %input = "btf.read_dense_tensor.f32.4"(%path, %input_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %filter = "btf.read_dense_tensor.f32.4"(%path, %filter_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %scale = "btf.read_dense_tensor.f32.1"(%path, %scale_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %offset = "btf.read_dense_tensor.f32.1"(%path, %offset_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %mean = "btf.read_dense_tensor.f32.1"(%path, %mean_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %var = "btf.read_dense_tensor.f32.1"(%path, %var_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %expected = "btf.read_dense_tensor.f32.4"(%path, %expected_index)
+    : (!tfrt.string, i32) -> (!t.tensor)
+
+  %folded_filter = "tfrt_dht.create_uninitialized_tensor.f32.4"()
+    { shape = [3 : i64, 2 : i64, 10 : i64, 16 : i64] }
+    : () -> !t.tensor
+
+  %bias = "tfrt_dht.create_uninitialized_tensor.f32.1"()
+    { shape = [16 : i64] }
+    : () -> !t.tensor
+
+  %ch1 = "eigen.conv2d.fold_batch_norm.f32"(%filter, %scale, %offset, %mean,
+                                            %var, %folded_filter, %bias, %ch0)
+    { epsilon = 0.01 : f32 }
+    : (!t.tensor, !t.tensor, !t.tensor, !t.tensor,
+       !t.tensor, !t.tensor, !t.tensor, !tfrt.chain) -> !tfrt.chain
+
+  %output = "tfrt_dht.create_uninitialized_tensor.f32.4"()
+    { shape = [1 : i64, 7 : i64, 9 : i64, 16 : i64] }
+    : () -> !t.tensor
+
+  %ch2 = "eigen.conv2d.bias.f32"(%input, %folded_filter, %bias, %output, %ch1)
+    { padding = "same",  strides = [1 : i64, 1 : i64] }
+    : (!t.tensor, !t.tensor, !t.tensor,
+       !t.tensor, !tfrt.chain) -> !tfrt.chain
+
+  %cmp, %ch3 = "tfrt_dht.tensor_allclose.1000ulp.f32"(%expected, %output, %ch2)
+    : (!t.tensor, !t.tensor, !tfrt.chain) -> (i1, !tfrt.chain)
+
+  // CHECK: int1 = 1
+  tfrt.print.i1 %cmp, %ch3
+
+  tfrt.return
+}
@@ -16,6 +16,9 @@
 
 #include "../../lib/kernels/cwise_binary_kernels.h"
 
+#include <numeric>
+#include <vector>
+
 #include "benchmark/benchmark.h"
 #include "gtest/gtest.h"
 #include "tfrt/common/ops/tf/bcast.h"
@@ -27,6 +30,8 @@
 #include "tfrt/host_context/host_context.h"
 #include "tfrt/support/latch.h"
 #include "tfrt/tensor/dense_host_tensor.h"
+#include "tfrt/tensor/dense_host_tensor_view.h"
+#include "tfrt/tensor/dense_view.h"
 #include "tfrt/tensor/tensor_metadata.h"
 #include "tfrt/tensor/tensor_shape.h"
 
@@ -39,6 +44,58 @@ std::unique_ptr<HostContext> CreateTestHostContext(int num_threads) {
 }
 }  // namespace
 
+TEST(CwiseBinaryKernelsTest, StridedSliceAdd) {
+  auto host = CreateTestHostContext(1);
+
+  // lhs is a 3x4 matrix holding 0, 1, ..., 11.
+  auto lhs = DenseHostTensor::CreateUninitialized<float>(TensorShape({3, 4}),
+                                                         host.get());
+  auto out = DenseHostTensor::CreateUninitialized<float>(TensorShape({2, 2}),
+                                                         host.get());
+  ASSERT_TRUE(lhs.hasValue() && out.hasValue());
+  auto lhs_view = MutableDHTArrayView<float>(lhs.getPointer());
+  std::iota(lhs_view.begin(), lhs_view.end(), 0.0f);
+
+  StridedDenseView dense(DenseView(GetDType<float>(), {3, 4}, lhs->data()));
+  // The [1:3, 1:3] slice plus the transposed [0:2, 0:2] slice.
+  StridedDenseView slice = dense.Slice({1, 1}, {2, 2});
+  StridedDenseView transposed = dense.Slice({0, 0}, {2, 2}).Transpose({1, 0});
+
+  using Functor = typename ::tfrt::cpu::functor::Add::Functor<float>;
+  Error err = ::tfrt::cpu::StridedBinaryKernel<Functor>(slice, transposed,
+                                                         out.getPointer());
+  ASSERT_FALSE(err);
+
+  auto out_view = DHTArrayView<float>(out.getPointer());
+  EXPECT_EQ(out_view[0], 5.0f + 0.0f);
+  EXPECT_EQ(out_view[1], 6.0f + 4.0f);
+  EXPECT_EQ(out_view[2], 9.0f + 1.0f);
+  EXPECT_EQ(out_view[3], 10.0f + 5.0f);
+}
+
+TEST(CwiseBinaryKernelsTest, StridedBroadcast) {
+  auto host = CreateTestHostContext(1);
+
+  float lhs[] = {1.0f, 2.0f, 3.0f};
+  float rhs[] = {10.0f, 20.0f};
+  auto out = DenseHostTensor::CreateUninitialized<float>(TensorShape({2, 3}),
+                                                         host.get());
+  ASSERT_TRUE(out.hasValue());
+
+  // [3] + [2, 1] -> [2, 3].
+  StridedDenseView lhs_view(DenseView(GetDType<float>(), {3}, lhs));
+  StridedDenseView rhs_view(DenseView(GetDType<float>(), {2, 1}, rhs));
+
+  using Functor = typename ::tfrt::cpu::functor::Add::Functor<float>;
+  Error err = ::tfrt::cpu::StridedBinaryKernel<Functor>(lhs_view, rhs_view,
+                                                         out.getPointer());
+  ASSERT_FALSE(err);
+
+  auto out_view = DHTArrayView<float>(out.getPointer());
+  std::vector<float> expected = {11.0f, 12.0f, 13.0f, 21.0f, 22.0f, 23.0f};
+  EXPECT_EQ(std::vector<float>(out_view.begin(), out_view.end()), expected);
+}
+
 void BinaryKernel(benchmark::State& state, int num_threads,
                   const TensorShape& lhs_shape, const TensorShape& rhs_shape) {
   auto host = CreateTestHostContext(num_threads);
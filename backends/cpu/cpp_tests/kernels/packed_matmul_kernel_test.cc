@@ -0,0 +1,113 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//  Packed weights MatMul kernel tests.
+
+#include "../../lib/kernels/packed_matmul_kernel.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "tfrt/tensor/dense_host_tensor_view.h"
+#include "tfrt/tensor/tensor_shape.h"
+
+namespace tfrt {
+namespace {
+
+std::unique_ptr<HostContext> CreateTestHostContext() {
+  return std::make_unique<HostContext>([](const DecodedDiagnostic&) {},
+                                       CreateMallocAllocator(),
+                                       CreateSingleThreadedWorkQueue());
+}
+
+// Checks PackedMatMul against a naive matrix multiplication.
+void TestPackedMatMul(Index m, Index k, Index n, bool transpose_a,
+                      bool transpose_b) {
+  auto host = CreateTestHostContext();
+
+  auto a = DenseHostTensor::CreateUninitialized<float>(
+      transpose_a ? TensorShape({k, m}) : TensorShape({m, k}), host.get());
+  auto c = DenseHostTensor::CreateUninitialized<float>(TensorShape({m, n}),
+                                                       host.get());
+  ASSERT_TRUE(a.hasValue() && c.hasValue());
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  auto a_view = MutableDHTArrayView<float>(a.getPointer());
+  for (float& value : a_view) value = dist(gen);
+  std::vector<float> b(k * n);
+  for (float& value : b) value = dist(gen);
+
+  cpu::PackedMatMulWeights<float> weights(b.data(), k, n, transpose_b);
+  ASSERT_FALSE(static_cast<bool>(cpu::PackedMatMul<float>(
+      a.getValue(), weights, c.getPointer(), transpose_a)));
+
+  auto a_at = [&](Index i, Index l) {
+    return transpose_a ? a_view[l * m + i] : a_view[i * k + l];
+  };
+  auto b_at = [&](Index l, Index j) {
+    return transpose_b ? b[j * k + l] : b[l * n + j];
+  };
+  auto c_view = DHTArrayView<float>(c.getPointer());
+  for (Index i = 0; i < m; ++i) {
+    for (Index j = 0; j < n; ++j) {
+      double expected = 0.0;
+      for (Index l = 0; l < k; ++l) expected += a_at(i, l) * b_at(l, j);
+      EXPECT_NEAR(c_view[i * n + j], expected, 1e-3) << i << ", " << j;
+    }
+  }
+}
+
+TEST(PackedMatMulTest, Small) {
+  TestPackedMatMul(1, 1, 1, false, false);
+  TestPackedMatMul(2, 3, 2, false, false);
+}
+
+// Shapes that span multiple blocks and leave partial panels.
+TEST(PackedMatMulTest, Blocked) {
+  TestPackedMatMul(1, 300, 1030, false, false);
+  TestPackedMatMul(17, 700, 7, false, false);
+}
+
+TEST(PackedMatMulTest, Transposed) {
+  TestPackedMatMul(3, 700, 64, true, false);
+  TestPackedMatMul(17, 700, 7, false, true);
+  TestPackedMatMul(5, 300, 1030, true, true);
+}
+
+TEST(PackedMatMulTest, ShapeMismatch) {
+  auto host = CreateTestHostContext();
+  auto a = DenseHostTensor::CreateUninitialized<float>(TensorShape({2, 3}),
+                                                       host.get());
+  auto c = DenseHostTensor::CreateUninitialized<float>(TensorShape({2, 2}),
+                                                       host.get());
+  ASSERT_TRUE(a.hasValue() && c.hasValue());
+
+  std::vector<float> b(4 * 2);
+  cpu::PackedMatMulWeights<float> weights(b.data(), 4, 2,
+                                          /*transpose_b=*/false);
+  auto error = cpu::PackedMatMul<float>(a.getValue(), weights, c.getPointer(),
+                                        /*transpose_a=*/false);
+  EXPECT_TRUE(static_cast<bool>(error));
+  llvm::consumeError(std::move(error));
+}
+
+}  // namespace
+}  // namespace tfrt
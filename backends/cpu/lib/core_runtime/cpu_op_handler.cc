@@ -162,7 +162,7 @@ TensorHandle MaybeConvertArgument(const ExecutionContext& exec_ctx,
       return TensorHandle(std::move(device), arg.GetAvailableMetadata(),
                           AsyncValueRef<Tensor>(std::move(result_ind_av)));
     } else {
-      return TensorHandle(std::move(device), arg.GetAsyncMetadata().CopyRef(),
+      return TensorHandle(std::move(device), arg.GetAsyncMetadata(),
                           AsyncValueRef<Tensor>(std::move(result_ind_av)));
     }
   }
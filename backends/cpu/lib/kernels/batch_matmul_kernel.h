@@ -0,0 +1,199 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Batched MatMul kernel implementation.
+
+#ifndef TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_BATCH_MATMUL_KERNEL_H_
+#define TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_BATCH_MATMUL_KERNEL_H_
+
+#include <algorithm>
+
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/common/compat/eigen/contraction_kernel.h"
+#include "tfrt/common/compat/eigen/tensor_types.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace cpu {
+namespace internal {
+
+// Output matrices are split into row tiles of at least this many rows, when
+// there are too few batches to keep all worker threads busy.
+constexpr Eigen::Index kMinBatchMatMulTileRows = 32;
+
+// Returns the offsets of the lhs and rhs matrices that are multiplied into
+// each output matrix. Batch dimensions are broadcasted like in numpy: they are
+// aligned to the right, and dimensions of size 1 are repeated.
+inline void GetBatchMatMulOffsets(
+    const TensorShape& a, const TensorShape& b, const TensorShape& c,
+    llvm::SmallVectorImpl<Eigen::Index>* a_offsets,
+    llvm::SmallVectorImpl<Eigen::Index>* b_offsets) {
+  const int batch_rank = c.GetRank() - 2;
+  const int a_batch_rank = a.GetRank() - 2;
+  const int b_batch_rank = b.GetRank() - 2;
+  const Eigen::Index a_matrix_size =
+      a.GetDimensionSize(a_batch_rank) * a.GetDimensionSize(a_batch_rank + 1);
+  const Eigen::Index b_matrix_size =
+      b.GetDimensionSize(b_batch_rank) * b.GetDimensionSize(b_batch_rank + 1);
+
+  // Size of the dimension `d` of the output batch shape in the `shape` batch.
+  auto batch_dim = [&](const TensorShape& shape, int shape_batch_rank, int d) {
+    int shape_d = d - (batch_rank - shape_batch_rank);
+    return shape_d < 0 ? 1 : shape.GetDimensionSize(shape_d);
+  };
+
+  Eigen::Index num_batches = 1;
+  for (int d = 0; d < batch_rank; ++d) num_batches *= c.GetDimensionSize(d);
+
+  a_offsets->reserve(num_batches);
+  b_offsets->reserve(num_batches);
+  for (Eigen::Index batch = 0; batch < num_batches; ++batch) {
+    Eigen::Index remaining = batch;
+    Eigen::Index a_index = 0, a_stride = 1;
+    Eigen::Index b_index = 0, b_stride = 1;
+    for (int d = batch_rank - 1; d >= 0; --d) {
+      const Eigen::Index size = c.GetDimensionSize(d);
+      const Eigen::Index index = remaining % size;
+      remaining /= size;
+
+      const Eigen::Index a_size = batch_dim(a, a_batch_rank, d);
+      if (a_size != 1) a_index += index * a_stride;
+      a_stride *= a_size;
+
+      const Eigen::Index b_size = batch_dim(b, b_batch_rank, d);
+      if (b_size != 1) b_index += index * b_stride;
+      b_stride *= b_size;
+    }
+    a_offsets->push_back(a_index * a_matrix_size);
+    b_offsets->push_back(b_index * b_matrix_size);
+  }
+}
+
+}  // namespace internal
+
+// Batched matrix multiplication with broadcasted batch dimensions:
+//   C[..., :, :] = A[..., :, :] * B[..., :, :]
+//
+// Every output matrix is computed by a single threaded contraction, and the
+// contractions run in parallel. With many small matrices each task computes
+// a block of whole matrices. With fewer batches than worker threads, output
+// matrices are also split into row tiles, so that large matrices still use all
+// threads. Returned chain becomes available when `c` is computed.
+template <typename T>
+AsyncValueRef<Chain> BatchMatMul(const DenseHostTensor& a,
+                                 const DenseHostTensor& b, DenseHostTensor* c,
+                                 bool transpose_a, bool transpose_b,
+                                 const ExecutionContext& exec_ctx) {
+  using Index = Eigen::Index;
+  // Batch offsets are not aligned to the packet size.
+  using ConstMatrix = Eigen::TensorMap<
+      const Eigen::Tensor<T, 2, Eigen::RowMajor, Index>, Eigen::Unaligned>;
+  using Matrix = Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor, Index>,
+                                  Eigen::Unaligned>;
+
+  const int rank = c->shape().GetRank();
+  if (rank < 2 || a.shape().GetRank() < 2 || b.shape().GetRank() < 2)
+    return EmitErrorAsync(exec_ctx, "batch matmul operands must be matrices");
+
+  const int a_rank = a.shape().GetRank();
+  const int b_rank = b.shape().GetRank();
+  const Index m = c->shape().GetDimensionSize(rank - 2);
+  const Index n = c->shape().GetDimensionSize(rank - 1);
+  const Index k = a.shape().GetDimensionSize(transpose_a ? a_rank - 2
+                                                         : a_rank - 1);
+  if (b.shape().GetDimensionSize(transpose_b ? b_rank - 1 : b_rank - 2) != k)
+    return EmitErrorAsync(exec_ctx,
+                          StrCat("incompatible shapes for batch matmul: ",
+                                 a.shape(), ", ", b.shape()));
+
+  T* c_data = static_cast<T*>(c->data());
+  if (c->NumElements() == 0) return GetReadyChain();
+  if (k == 0) {
+    std::fill(c_data, c_data + c->NumElements(), T(0));
+    return GetReadyChain();
+  }
+
+  llvm::SmallVector<Index, 16> a_offsets;
+  llvm::SmallVector<Index, 16> b_offsets;
+  internal::GetBatchMatMulOffsets(a.shape(), b.shape(), c->shape(), &a_offsets,
+                                  &b_offsets);
+  const Index num_batches = a_offsets.size();
+
+  // Split output matrices into row tiles only if there are not enough batches
+  // to give every worker thread a couple of tasks.
+  const Index num_threads = exec_ctx.host()->GetNumWorkerThreads();
+  Index num_tiles = 1;
+  if (num_batches < 2 * num_threads) {
+    Index max_tiles = (m + internal::kMinBatchMatMulTileRows - 1) /
+                      internal::kMinBatchMatMulTileRows;
+    Index wanted_tiles = (2 * num_threads + num_batches - 1) / num_batches;
+    num_tiles = std::max<Index>(1, std::min(max_tiles, wanted_tiles));
+  }
+  const Index tile_rows = (m + num_tiles - 1) / num_tiles;
+  num_tiles = (m + tile_rows - 1) / tile_rows;
+
+  Eigen::array<Eigen::IndexPair<Index>, 1> contract_dim;
+  contract_dim[0].first = transpose_a ? 0 : 1;
+  contract_dim[0].second = transpose_b ? 1 : 0;
+
+  auto compute = [=, a_offsets = std::move(a_offsets),
+                  b_offsets = std::move(b_offsets),
+                  a_buffer = a.buffer().CopyRef(),
+                  b_buffer = b.buffer().CopyRef(),
+                  c_buffer = c->buffer().CopyRef()](size_t begin, size_t end) {
+    const T* a_data = static_cast<const T*>(a_buffer->data());
+    const T* b_data = static_cast<const T*>(b_buffer->data());
+    for (size_t task = begin; task < end; ++task) {
+      const Index batch = task / num_tiles;
+      const Index row_begin = (task % num_tiles) * tile_rows;
+      const Index rows = std::min(tile_rows, m - row_begin);
+
+      ConstMatrix rhs(b_data + b_offsets[batch], transpose_b ? n : k,
+                      transpose_b ? k : n);
+      Matrix out(c_data + batch * m * n + row_begin * n, rows, n);
+
+      if (transpose_a) {
+        // Rows of the output are columns of the stored lhs matrix.
+        ConstMatrix lhs(a_data + a_offsets[batch], k, m);
+        Eigen::DSizes<Index, 2> offsets(0, row_begin);
+        Eigen::DSizes<Index, 2> extents(k, rows);
+        out = lhs.slice(offsets, extents).contract(rhs, contract_dim);
+      } else {
+        ConstMatrix lhs(a_data + a_offsets[batch] + row_begin * k, rows, k);
+        out = lhs.contract(rhs, contract_dim);
+      }
+    }
+  };
+
+  // Each task loads a lhs tile and the whole rhs matrix, and stores an output
+  // tile.
+  const double bytes_loaded = (tile_rows * k + k * n) * sizeof(T);
+  const double bytes_stored = tile_rows * n * sizeof(T);
+  const double compute_cycles = static_cast<double>(tile_rows) * k * n;
+
+  return ParallelFor(exec_ctx).Execute(
+      num_batches * num_tiles,
+      ParallelFor::BlockSizes::Cost(bytes_loaded, bytes_stored, compute_cycles),
+      std::move(compute));
+}
+
+}  // namespace cpu
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_BATCH_MATMUL_KERNEL_H_
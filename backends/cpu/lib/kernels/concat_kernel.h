@@ -19,7 +19,12 @@
 #ifndef TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_CONCAT_KERNEL_H_
 #define TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_CONCAT_KERNEL_H_
 
+#include <algorithm>
+#include <cstring>
+
+#include "llvm/ADT/SmallVector.h"
 #include "tfrt/common/compat/eigen/eigen_kernel.h"
+#include "tfrt/host_context/parallel_for.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/ranges.h"
 #include "tfrt/tensor/dense_host_tensor.h"
@@ -100,78 +105,111 @@ Expected<TensorMetadata> ConcatMetadataKernel(const TensorRange& args,
   return TensorMetadata(arg0_dtype, TensorShape(output_dims));
 }
 
-template <int rank>
-using ConcatRankTag = std::integral_constant<int, rank>;
-
-template <typename T, typename DHTRange>
-Error ConcatKernel(const DHTRange& args, int axis, DenseHostTensor* output) {
-  const int input_rank = args[0].shape().GetRank();
-
-  // Handle scalars concatenation separately to keep the common path simple.
-  if (input_rank == 0) {
-    for (int i = 0; i < args.size(); ++i) {
-      const T* inp = static_cast<const T*>(args[i].data());
-      T* out = static_cast<T*>(output->data());
-      out[i] = *inp;
+namespace internal {
+
+// Row-major concatenation copies contiguous slabs: if the output is viewed as
+// a [outer, row] matrix, where `outer` is the product of the dimensions before
+// the concatenation axis, every output row is a concatenation of one slab from
+// each input. Sizes and offsets are in bytes.
+struct ConcatSlabs {
+  Index num_rows = 0;
+  Index row_size = 0;
+
+  // Input data and the slab size of every input.
+  llvm::SmallVector<const char*, 8> inputs;
+  llvm::SmallVector<Index, 8> slab_sizes;
+
+  // Offsets of the input slabs in the output row, followed by `row_size`.
+  llvm::SmallVector<Index, 9> offsets;
+
+  Index size() const { return num_rows * row_size; }
+
+  // Copies the [begin, end) byte range of the output.
+  void Copy(char* output, Index begin, Index end) const {
+    if (begin >= end) return;
+
+    Index row = begin / row_size;
+    Index col = begin % row_size;
+    // The last input slab that starts at or before `col` is not empty.
+    size_t i = std::upper_bound(offsets.begin(), offsets.end(), col) -
+               offsets.begin() - 1;
+
+    while (begin < end) {
+      const Index size = std::min(offsets[i + 1] - col, end - begin);
+      if (size > 0) {
+        std::memcpy(output + begin,
+                    inputs[i] + row * slab_sizes[i] + (col - offsets[i]),
+                    size);
+      }
+      begin += size;
+      col += size;
+      if (col == offsets[i + 1] && ++i == inputs.size()) {
+        i = 0;
+        col = 0;
+        ++row;
+      }
     }
-
-    return Error::success();
   }
+};
 
-  // Compute the actual axis from a negative value.
-  axis = axis < 0 ? axis + input_rank : axis;
-
-  // TODO(ezhulenev): Make this asynchronous/multithreaded.
-  auto rank_dispatch = [&](auto rank_tag) -> void {
-    static constexpr int rank = decltype(rank_tag)::value;
-
-    auto output_view = MutableDHTIndexableView<T, rank>(output);
-    auto output_t = compat::AsEigenTensor(output_view);
-
-    // Offset for writing to the output along the axis dimension.
-    Index offset = 0;
-
-    for (auto& dht : args) {
-      auto arg_view = DHTIndexableView<T, rank>(&dht);
-      auto arg_t = compat::AsEigenConstTensor(arg_view);
+template <typename T, typename DHTRange>
+ConcatSlabs GetConcatSlabs(const DHTRange& args, int axis) {
+  ConcatSlabs slabs;
+  const TensorShape& shape = args[0].shape();
+  const int rank = shape.GetRank();
+  axis = axis < 0 ? axis + rank : axis;
 
-      // Offsets for the output slice.
-      Eigen::DSizes<Index, rank> offsets;
-      for (int d = 0; d < rank; d++) offsets[d] = 0;
-      offsets[axis] = offset;
+  // Scalars are concatenated as vectors of length 1.
+  slabs.num_rows = 1;
+  for (int d = 0; d < axis; ++d) slabs.num_rows *= shape.GetDimensionSize(d);
+
+  for (auto& dht : args) {
+    Index slab_size = sizeof(T);
+    for (int d = axis; d < rank; ++d)
+      slab_size *= dht.shape().GetDimensionSize(d);
+    slabs.inputs.push_back(static_cast<const char*>(dht.data()));
+    slabs.slab_sizes.push_back(slab_size);
+    slabs.offsets.push_back(slabs.row_size);
+    slabs.row_size += slab_size;
+  }
+  slabs.offsets.push_back(slabs.row_size);
 
-      // Size of the output slice.
-      Eigen::DSizes<Index, rank> sizes;
-      for (int d = 0; d < rank; d++) sizes[d] = dht.shape().GetDimensionSize(d);
+  return slabs;
+}
 
-      // It's possible for this input tensor to have zero dimension along the
-      // specified axis, in which case no work is needed, b/172595919
-      if (sizes[axis] == 0) continue;
+}  // namespace internal
 
-      offset += sizes[axis];
+template <typename T, typename DHTRange>
+Error ConcatKernel(const DHTRange& args, int axis, DenseHostTensor* output) {
+  auto slabs = internal::GetConcatSlabs<T>(args, axis);
+  slabs.Copy(static_cast<char*>(output->data()), 0, slabs.size());
+  return Error::success();
+}
 
-      // Write argument into the output tensor slice.
-      output_t.slice(offsets, sizes) = arg_t;
-    }
+// Concatenates `args` into `output` in parallel. The output byte range is split
+// into blocks, so that concatenations of a few large slabs and of many small
+// slabs are both evenly balanced. Returned chain becomes available when the
+// output is written.
+template <typename T, typename DHTRange>
+AsyncValueRef<Chain> ConcatKernel(const DHTRange& args, int axis,
+                                  DenseHostTensor* output,
+                                  const ExecutionContext& exec_ctx) {
+  auto slabs = internal::GetConcatSlabs<T>(args, axis);
+  const Index size = slabs.size();
+
+  llvm::SmallVector<RCReference<HostBuffer>, 8> buffers;
+  for (auto& dht : args) buffers.push_back(dht.buffer().CopyRef());
+  buffers.push_back(output->buffer().CopyRef());
+
+  auto compute = [slabs = std::move(slabs), buffers = std::move(buffers),
+                  output = static_cast<char*>(output->data())](size_t begin,
+                                                               size_t end) {
+    slabs.Copy(output, begin, end);
   };
 
-  auto rank = output->shape().GetRank();
-  // Dispatch based on the output tensor rank.
-  if (rank == 1) {
-    rank_dispatch(ConcatRankTag<1>{});
-  } else if (rank == 2) {
-    rank_dispatch(ConcatRankTag<2>{});
-  } else if (rank == 3) {
-    rank_dispatch(ConcatRankTag<3>{});
-  } else if (rank == 4) {
-    rank_dispatch(ConcatRankTag<4>{});
-  } else if (rank == 5) {
-    rank_dispatch(ConcatRankTag<4>{});
-  } else {
-    return MakeStringError("Unsupported output tensor rank");
-  }
-
-  return Error::success();
+  // Every output byte is loaded from an input and stored once.
+  return ParallelFor(exec_ctx).Execute(
+      size, ParallelFor::BlockSizes::Cost(1, 1, 0), std::move(compute));
 }
 
 }  // namespace cpu
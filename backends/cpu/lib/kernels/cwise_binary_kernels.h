@@ -27,6 +27,8 @@
 #include "tfrt/host_context/chain.h"
 #include "tfrt/host_context/kernel_utils.h"
 #include "tfrt/support/string_util.h"
+#include "tfrt/tensor/dense_host_tensor_view.h"
+#include "tfrt/tensor/dense_view.h"
 #include "tfrt/tensor/host_tensor.h"
 #include "tfrt/tensor/scalar_host_tensor.h"
 
@@ -367,6 +369,77 @@ void BinaryKernel(const HostTensor& lhs, const HostTensor& rhs,
   }
 }
 
+// Computes the binary functor of strided views into `output`, broadcasting
+// `lhs` and `rhs` to the output shape with zero strides. Slices, transposes and
+// broadcasts of the arguments are read in place instead of being copied into
+// dense temporaries first. Runs on the calling thread.
+template <typename BinaryFunctor>
+Error StridedBinaryKernel(const StridedDenseView& lhs,
+                          const StridedDenseView& rhs,
+                          DenseHostTensor* output) {
+  using Functor = typename BinaryFunctor::Functor;
+  using Input = typename BinaryFunctor::Input;
+  using Output = typename BinaryFunctor::Output;
+
+  const TensorShape& shape = output->shape();
+  auto lhs_bcast = lhs.BroadcastTo(shape);
+  auto rhs_bcast = rhs.BroadcastTo(shape);
+  if (!lhs_bcast || !rhs_bcast)
+    return MakeStringError("Unsupported binary kernel broadcasting: lhs=",
+                           lhs.shape(), " rhs=", rhs.shape(), " out=", shape);
+
+  const auto* lhs_data = static_cast<const Input*>(lhs_bcast->data());
+  const auto* rhs_data = static_cast<const Input*>(rhs_bcast->data());
+  Output* out_data = MutableDHTArrayView<Output>(output).data();
+  Functor functor;
+
+  const int rank = shape.GetRank();
+  const Index num_elements = shape.GetNumElements();
+  if (num_elements == 0) return Error::success();
+  if (rank == 0) {
+    *out_data = functor(*lhs_data, *rhs_data);
+    return Error::success();
+  }
+
+  // Both arguments are dense (the common case after a broadcast of a dense
+  // tensor to its own shape): a single flat loop.
+  if (lhs_bcast->IsContiguous() && rhs_bcast->IsContiguous()) {
+    for (Index i = 0; i < num_elements; ++i)
+      out_data[i] = functor(lhs_data[i], rhs_data[i]);
+    return Error::success();
+  }
+
+  // Walk the outer dimensions with an index counter and run the innermost
+  // dimension as a strided loop.
+  ArrayRef<Index> lhs_strides = lhs_bcast->strides();
+  ArrayRef<Index> rhs_strides = rhs_bcast->strides();
+  const Index inner_size = shape.GetDimensionSize(rank - 1);
+  const Index lhs_inner = lhs_strides.back();
+  const Index rhs_inner = rhs_strides.back();
+
+  llvm::SmallVector<Index, 4> index(rank, 0);
+  Index lhs_offset = 0, rhs_offset = 0;
+  for (Index out = 0; out < num_elements; out += inner_size) {
+    const Input* lhs_row = lhs_data + lhs_offset;
+    const Input* rhs_row = rhs_data + rhs_offset;
+    Output* out_row = out_data + out;
+    for (Index i = 0; i < inner_size; ++i)
+      out_row[i] = functor(lhs_row[i * lhs_inner], rhs_row[i * rhs_inner]);
+
+    // Advance the index of the outer dimensions.
+    for (int dim = rank - 2; dim >= 0; --dim) {
+      lhs_offset += lhs_strides[dim];
+      rhs_offset += rhs_strides[dim];
+      if (++index[dim] < shape.GetDimensionSize(dim)) break;
+      lhs_offset -= index[dim] * lhs_strides[dim];
+      rhs_offset -= index[dim] * rhs_strides[dim];
+      index[dim] = 0;
+    }
+  }
+
+  return Error::success();
+}
+
 template <typename BinaryFunctor>
 AsyncValueRef<Chain> BinaryKernel(const HostTensor& lhs, const HostTensor& rhs,
                                   HostTensor* output,
@@ -37,6 +37,11 @@ struct UnaryFunctor {
   using Output = R;
 };
 
+struct Exp {
+  template <typename T>
+  using Functor = UnaryFunctor<T, Eigen::internal::scalar_exp_op<T>>;
+};
+
 struct Log {
   template <typename T>
   using Functor = UnaryFunctor<T, Eigen::internal::scalar_log_op<T>>;
@@ -57,6 +62,16 @@ struct Sigmoid {
   using Functor = UnaryFunctor<T, Eigen::internal::scalar_logistic_op<T>>;
 };
 
+struct Sqrt {
+  template <typename T>
+  using Functor = UnaryFunctor<T, Eigen::internal::scalar_sqrt_op<T>>;
+};
+
+struct Tanh {
+  template <typename T>
+  using Functor = UnaryFunctor<T, Eigen::internal::scalar_tanh_op<T>>;
+};
+
 }  // namespace functor
 
 template <typename UnaryFunctor, typename OnDone>
@@ -0,0 +1,267 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Embedding lookup kernel implementations.
+
+#include "./embedding_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/support/bf16.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/fp16.h"
+#include "tfrt/tensor/dense_host_tensor_view.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+
+namespace tfrt {
+namespace cpu {
+namespace {
+
+// Number of rows ahead of the current one whose table rows are prefetched.
+// Table lookups are random accesses, so hardware prefetchers do not help.
+constexpr size_t kPrefetchDistance = 8;
+constexpr size_t kCacheLineBytes = 64;
+
+void PrefetchRow(const char* row, size_t row_bytes) {
+  for (size_t offset = 0; offset < row_bytes; offset += kCacheLineBytes)
+    Eigen::internal::prefetch(row + offset);
+}
+
+template <typename I>
+ArrayRef<I> IndicesOf(const DenseHostTensor& tensor) {
+  return {static_cast<const I*>(tensor.data()),
+          static_cast<size_t>(tensor.NumElements())};
+}
+
+template <typename I>
+Error CheckIndices(ArrayRef<I> indices, Index num_rows) {
+  for (size_t i = 0; i < indices.size(); ++i) {
+    if (indices[i] < 0 || indices[i] >= num_rows)
+      return MakeStringError("indices[", i, "] = ", indices[i],
+                             " is not in [0, ", num_rows, ")");
+  }
+  return Error::success();
+}
+
+// Calls `fn` with the indices of the I32 or I64 `tensor`.
+template <typename F>
+auto DispatchIndices(const DenseHostTensor& tensor, F&& fn) {
+  if (tensor.dtype() == DType::I64) return fn(IndicesOf<int64_t>(tensor));
+  assert(tensor.dtype() == DType::I32);
+  return fn(IndicesOf<int32_t>(tensor));
+}
+
+template <typename I>
+AsyncValueRef<Chain> GatherRows(const DenseHostTensor& params,
+                                const DenseHostTensor& indices_tensor,
+                                ArrayRef<I> indices, DenseHostTensor* output,
+                                const ExecutionContext& exec_ctx) {
+  const size_t row_bytes =
+      params.DataSizeInBytes() / params.shape().GetDimensionSize(0);
+
+  auto compute = [table = static_cast<const char*>(params.data()), indices,
+                  out = static_cast<char*>(output->data()), row_bytes,
+                  params = params.buffer().CopyRef(),
+                  indices_buffer = indices_tensor.buffer().CopyRef(),
+                  output = output->buffer().CopyRef()](size_t begin,
+                                                       size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      if (i + kPrefetchDistance < end)
+        PrefetchRow(table + indices[i + kPrefetchDistance] * row_bytes,
+                    row_bytes);
+      std::memcpy(out + i * row_bytes, table + indices[i] * row_bytes,
+                  row_bytes);
+    }
+  };
+
+  return ParallelFor(exec_ctx).Execute(
+      indices.size(),
+      ParallelFor::BlockSizes::Cost(row_bytes, row_bytes, /*compute_cycles=*/0),
+      std::move(compute));
+}
+
+// Adds a table row to the f32 accumulator. 16-bit floating point rows are
+// converted with the bulk conversions of tfrt/support into `scratch` first.
+void AccumulateRow(const float* row, float* acc, float*, size_t n) {
+  for (size_t i = 0; i < n; ++i) acc[i] += row[i];
+}
+
+template <typename T>
+void AccumulateRow(const T* row, float* acc, float* scratch, size_t n) {
+  ConvertBuffer(row, scratch, n);
+  for (size_t i = 0; i < n; ++i) acc[i] += scratch[i];
+}
+
+// Stores the scaled accumulator as an output row.
+void StoreRow(const float* acc, float scale, float* out, float*, size_t n) {
+  for (size_t i = 0; i < n; ++i) out[i] = acc[i] * scale;
+}
+
+template <typename T>
+void StoreRow(const float* acc, float scale, T* out, float* scratch,
+              size_t n) {
+  for (size_t i = 0; i < n; ++i) scratch[i] = acc[i] * scale;
+  ConvertBuffer(scratch, out, n);
+}
+
+template <typename T, typename I>
+AsyncValueRef<Chain> ReduceSegments(const DenseHostTensor& data,
+                                    const DenseHostTensor& indices_tensor,
+                                    ArrayRef<I> indices,
+                                    std::vector<size_t> segment_offsets,
+                                    SegmentReduction reduction,
+                                    DenseHostTensor* output,
+                                    const ExecutionContext& exec_ctx) {
+  const size_t num_segments = segment_offsets.size() - 1;
+  const size_t row_size =
+      data.NumElements() / data.shape().GetDimensionSize(0);
+
+  auto compute = [table = static_cast<const T*>(data.data()), indices,
+                  out = static_cast<T*>(output->data()), row_size, reduction,
+                  segment_offsets = std::move(segment_offsets),
+                  data = data.buffer().CopyRef(),
+                  indices_buffer = indices_tensor.buffer().CopyRef(),
+                  output = output->buffer().CopyRef()](size_t begin,
+                                                       size_t end) {
+    std::vector<float> buffer(2 * row_size);
+    float* acc = buffer.data();
+    float* scratch = buffer.data() + row_size;
+
+    for (size_t s = begin; s < end; ++s) {
+      const size_t first = segment_offsets[s];
+      const size_t last = segment_offsets[s + 1];
+      std::fill_n(acc, row_size, 0.0f);
+      for (size_t j = first; j < last; ++j) {
+        if (j + kPrefetchDistance < last)
+          PrefetchRow(reinterpret_cast<const char*>(
+                          table + indices[j + kPrefetchDistance] * row_size),
+                      row_size * sizeof(T));
+        AccumulateRow(table + indices[j] * row_size, acc, scratch, row_size);
+      }
+
+      float scale = 1.0f;
+      const size_t count = last - first;
+      if (count > 0 && reduction == SegmentReduction::kMean)
+        scale = 1.0f / count;
+      if (count > 0 && reduction == SegmentReduction::kSqrtN)
+        scale = 1.0f / std::sqrt(static_cast<float>(count));
+      StoreRow(acc, scale, out + s * row_size, scratch, row_size);
+    }
+  };
+
+  // Every segment loads its rows once, converts and adds every element, and
+  // stores a single row.
+  const double rows_per_segment =
+      static_cast<double>(indices.size()) / num_segments;
+  const double bytes_loaded = rows_per_segment * row_size * sizeof(T);
+  const double bytes_stored = row_size * sizeof(T);
+  const double compute_cycles = rows_per_segment * row_size * 2;
+
+  return ParallelFor(exec_ctx).Execute(
+      num_segments,
+      ParallelFor::BlockSizes::Cost(bytes_loaded, bytes_stored, compute_cycles),
+      std::move(compute));
+}
+
+// Returns the offsets of the segments in the sorted `segment_ids`: segment `s`
+// spans [offsets[s], offsets[s + 1]).
+template <typename I>
+std::vector<size_t> SegmentOffsets(ArrayRef<I> segment_ids,
+                                   size_t num_segments) {
+  std::vector<size_t> offsets(num_segments + 1);
+  size_t pos = 0;
+  for (size_t s = 0; s <= num_segments; ++s) {
+    while (pos < segment_ids.size() &&
+           static_cast<size_t>(segment_ids[pos]) < s)
+      ++pos;
+    offsets[s] = pos;
+  }
+  return offsets;
+}
+
+}  // namespace
+
+bool IsSegmentReductionSupported(DType dtype) {
+  return dtype == DType::F32 || dtype == DType::F16 || dtype == DType::BF16;
+}
+
+Expected<Index> NumSegments(const DenseHostTensor& segment_ids) {
+  return DispatchIndices(segment_ids, [](auto ids) -> Expected<Index> {
+    for (size_t i = 0; i < ids.size(); ++i) {
+      if (ids[i] < 0)
+        return MakeStringError("segment_ids[", i, "] = ", ids[i],
+                               " is negative");
+      if (i > 0 && ids[i] < ids[i - 1])
+        return MakeStringError("segment_ids are not sorted");
+    }
+    return ids.empty() ? 0 : static_cast<Index>(ids.back()) + 1;
+  });
+}
+
+AsyncValueRef<Chain> Gather(const DenseHostTensor& params,
+                            const DenseHostTensor& indices,
+                            DenseHostTensor* output,
+                            const ExecutionContext& exec_ctx) {
+  if (output->NumElements() == 0) return GetReadyChain();
+
+  return DispatchIndices(indices, [&](auto ids) -> AsyncValueRef<Chain> {
+    if (auto error = CheckIndices(ids, params.shape().GetDimensionSize(0)))
+      return EmitErrorAsync(exec_ctx, std::move(error));
+    return GatherRows(params, indices, ids, output, exec_ctx);
+  });
+}
+
+AsyncValueRef<Chain> SparseSegmentReduce(const DenseHostTensor& data,
+                                         const DenseHostTensor& indices,
+                                         const DenseHostTensor& segment_ids,
+                                         SegmentReduction reduction,
+                                         DenseHostTensor* output,
+                                         const ExecutionContext& exec_ctx) {
+  if (output->NumElements() == 0) return GetReadyChain();
+
+  const size_t num_segments = output->shape().GetDimensionSize(0);
+  auto segment_offsets = DispatchIndices(segment_ids, [&](auto ids) {
+    return SegmentOffsets(ids, num_segments);
+  });
+
+  return DispatchIndices(indices, [&](auto ids) -> AsyncValueRef<Chain> {
+    if (auto error = CheckIndices(ids, data.shape().GetDimensionSize(0)))
+      return EmitErrorAsync(exec_ctx, std::move(error));
+    auto reduce = [&](auto zero) {
+      return ReduceSegments<decltype(zero)>(data, indices, ids,
+                                            std::move(segment_offsets),
+                                            reduction, output, exec_ctx);
+    };
+    switch (data.dtype()) {
+      case DType::F32:
+        return reduce(float{0});
+      case DType::F16:
+        return reduce(fp16{});
+      case DType::BF16:
+        return reduce(bf16{});
+      default:
+        return EmitErrorAsync(exec_ctx, StrCat("Unsupported dtype: ",
+                                               data.dtype()));
+    }
+  });
+}
+
+}  // namespace cpu
+}  // namespace tfrt
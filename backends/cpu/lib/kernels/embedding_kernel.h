@@ -0,0 +1,67 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Embedding lookup kernels: gather and sparse segment reductions of the rows
+// of a table.
+
+#ifndef TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_EMBEDDING_KERNEL_H_
+#define TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_EMBEDDING_KERNEL_H_
+
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace cpu {
+
+enum class SegmentReduction { kSum, kMean, kSqrtN };
+
+// Returns true if SparseSegmentReduce supports tables of `dtype`.
+bool IsSegmentReductionSupported(DType dtype);
+
+// Returns the number of segments of the sorted `segment_ids`, which is the
+// last segment id plus one.
+Expected<Index> NumSegments(const DenseHostTensor& segment_ids);
+
+// Copies the rows of `params` selected by the I32 or I64 `indices` to
+// `output`, independent of the element type. Output rows are copied in
+// parallel, and the table rows of upcoming indices are prefetched into the
+// cache while the current row is copied. The returned chain becomes available
+// when the output is computed, or is an error if an index is out of range.
+AsyncValueRef<Chain> Gather(const DenseHostTensor& params,
+                            const DenseHostTensor& indices,
+                            DenseHostTensor* output,
+                            const ExecutionContext& exec_ctx);
+
+// Reduces the rows of `data` selected by `indices` into the segments given by
+// the sorted `segment_ids`, i.e. fuses a Gather with the pooling of its rows.
+// Output row `s` is the sum of the rows of segment `s`, scaled by 1/n for
+// kMean and 1/sqrt(n) for kSqrtN. Empty segments are zero. Segments are
+// reduced in parallel, with the same prefetching as Gather, and 16-bit
+// floating point tables are accumulated in f32.
+AsyncValueRef<Chain> SparseSegmentReduce(const DenseHostTensor& data,
+                                         const DenseHostTensor& indices,
+                                         const DenseHostTensor& segment_ids,
+                                         SegmentReduction reduction,
+                                         DenseHostTensor* output,
+                                         const ExecutionContext& exec_ctx);
+
+}  // namespace cpu
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_EMBEDDING_KERNEL_H_
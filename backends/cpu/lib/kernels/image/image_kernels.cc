@@ -14,9 +14,11 @@
 
 // This file implements kernels that process images.
 
+#include <algorithm>
 #include <utility>
 
 #include "jpeg/jpeg_mem.h"
+#include "llvm/ADT/SmallVector.h"
 #include "resize_bilinear_op.h"
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/diagnostic.h"
@@ -118,10 +120,100 @@ static AsyncValueRef<DenseHostTensor> ResizeBilinear(
       });
 }
 
+// Returns the largest libjpeg DCT scaling denominator that decodes an image of
+// `width` x `height` to at least `target_width` x `target_height`. Decoding at
+// 1/2, 1/4 or 1/8 scale skips most of the inverse DCT work, and the bilinear
+// resize never has to upsample the reduced image.
+static int GetJpegScaleRatio(int width, int height, Index target_width,
+                             Index target_height) {
+  for (int ratio : {8, 4, 2}) {
+    // libjpeg rounds scaled dimensions up.
+    if ((width + ratio - 1) / ratio >= target_width &&
+        (height + ratio - 1) / ratio >= target_height)
+      return ratio;
+  }
+  return 1;
+}
+
+// Decodes the RGB jpeg `data`, resizes it to the height and width of `batch`
+// like tfrt_test.resize_bilinear, and writes
+// (pixel - mean[channel]) / stddev[channel] into batch[index]. `batch` is a
+// float [batch_size, height, width, 3] tensor. The jpeg is decoded at reduced
+// size when the target is much smaller, and there are no intermediate full
+// resolution float images.
+static AsyncValueRef<Chain> DecodeResizeNormalizeJpeg(
+    Argument<std::string> data, Argument<DenseHostTensor> batch,
+    Argument<Index> index, Argument<Chain> chain, ArrayAttribute<float> mean,
+    ArrayAttribute<float> stddev, const ExecutionContext& exec_ctx) {
+  constexpr int kChannels = 3;
+  const TensorShape& shape = batch->shape();
+  if (batch->dtype() != DType::F32 || shape.GetRank() != 4 ||
+      shape.GetDimensionSize(3) != kChannels)
+    return EmitErrorAsync(exec_ctx,
+                          "batch must be a float [N, H, W, 3] tensor");
+  if (*index < 0 || *index >= shape.GetDimensionSize(0))
+    return EmitErrorAsync(exec_ctx, "batch index is out of range");
+  if (mean.size() != kChannels || stddev.size() != kChannels)
+    return EmitErrorAsync(exec_ctx, "mean and stddev must have 3 channels");
+
+  const Index output_height = shape.GetDimensionSize(1);
+  const Index output_width = shape.GetDimensionSize(2);
+  llvm::SmallVector<float, kChannels> mean_values(mean.data().begin(),
+                                                  mean.data().end());
+  llvm::SmallVector<float, kChannels> inv_stddev;
+  for (float value : stddev.data()) inv_stddev.push_back(1.0f / value);
+
+  using ReturnTy = Expected<Chain>;
+  return EnqueueWork(
+      exec_ctx,
+      [data = data.ValueRef(), batch = batch.ValueRef(), index = *index,
+       output_height, output_width, mean_values = std::move(mean_values),
+       inv_stddev = std::move(inv_stddev), exec_ctx]() -> ReturnTy {
+        TFRT_TRACE_SCOPE(Default, "DecodeResizeNormalizeJpeg");
+        const std::string& jpeg = data.get();
+        int width = 0, height = 0;
+        if (!llvm::StringRef(jpeg).startswith("\xff\xd8\xff") ||
+            !jpeg::GetImageInfo(jpeg.data(), jpeg.size(), &width, &height,
+                                nullptr))
+          return MakeStringError("image does not have jpeg format");
+
+        jpeg::UncompressFlags flags;
+        flags.components = kChannels;
+        flags.dct_method = JDCT_IFAST;
+        flags.ratio =
+            GetJpegScaleRatio(width, height, output_width, output_height);
+
+        Optional<DenseHostTensor> decoded;
+        uint8_t* pixels = jpeg::Uncompress(
+            jpeg.data(), jpeg.size(), flags, nullptr /* nwarn */,
+            [&](int decoded_width, int decoded_height,
+                int channels) -> uint8_t* {
+              auto tensor = DenseHostTensor::CreateUninitialized<uint8_t>(
+                  TensorShape({decoded_height, decoded_width, channels}),
+                  exec_ctx.host());
+              if (!tensor) return nullptr;
+              decoded = std::move(*tensor);
+              return static_cast<uint8_t*>(decoded->data());
+            });
+        if (pixels == nullptr) return MakeStringError("cannot decode jpeg");
+
+        const TensorShape& decoded_shape = decoded->shape();
+        float* output = static_cast<float*>(batch->data()) +
+                        index * output_height * output_width * kChannels;
+        ResizeAndNormalizeImage(pixels, decoded_shape.GetDimensionSize(0),
+                                decoded_shape.GetDimensionSize(1), kChannels,
+                                output_height, output_width, mean_values,
+                                inv_stddev, output);
+        return Chain();
+      });
+}
+
 // This is the entrypoint to the library.
 void RegisterImageKernels(KernelRegistry* registry) {
   registry->AddKernel("tfrt_test.decode_jpeg", TFRT_KERNEL(DecodeJpeg));
   registry->AddKernel("tfrt_test.resize_bilinear", TFRT_KERNEL(ResizeBilinear));
+  registry->AddKernel("tfrt_test.decode_resize_normalize_jpeg",
+                      TFRT_KERNEL(DecodeResizeNormalizeJpeg));
 }
 
 }  // namespace image
@@ -132,5 +132,53 @@ void resize_image(const DenseHostTensor& input, const float height_scale,
   }
 }
 
+void ResizeAndNormalizeImage(const uint8_t* input, Index input_height,
+                             Index input_width, Index channels,
+                             Index output_height, Index output_width,
+                             ArrayRef<float> mean, ArrayRef<float> inv_stddev,
+                             float* output) {
+  const float height_scale = input_height / static_cast<float>(output_height);
+  const float width_scale = input_width / static_cast<float>(output_width);
+
+  std::vector<CachedInterpolation> ys(output_height + 1);
+  std::vector<CachedInterpolation> xs(output_width + 1);
+  compute_interpolation_weights(output_height, input_height, height_scale,
+                                ys.data());
+  compute_interpolation_weights(output_width, input_width, width_scale,
+                                xs.data());
+  for (auto& x : xs) {
+    x.lower *= channels;
+    x.upper *= channels;
+  }
+
+  // Bilinear interpolation is separable. Every output row first interpolates
+  // its two input rows into `row`, in a contiguous loop the compiler
+  // vectorizes, and then interpolates the columns of `row` and normalizes.
+  const Index in_row_size = input_width * channels;
+  std::vector<float> row(in_row_size);
+
+  for (Index y = 0; y < output_height; ++y) {
+    const uint8_t* top = input + ys[y].lower * in_row_size;
+    const uint8_t* bottom = input + ys[y].upper * in_row_size;
+    const float y_lerp = ys[y].lerp;
+    for (Index i = 0; i < in_row_size; ++i) {
+      const float t = top[i];
+      row[i] = t + (static_cast<float>(bottom[i]) - t) * y_lerp;
+    }
+
+    float* output_row = output + y * output_width * channels;
+    for (Index x = 0; x < output_width; ++x) {
+      const float* left = row.data() + xs[x].lower;
+      const float* right = row.data() + xs[x].upper;
+      const float x_lerp = xs[x].lerp;
+      float* out = output_row + x * channels;
+      for (Index c = 0; c < channels; ++c) {
+        const float value = left[c] + (right[c] - left[c]) * x_lerp;
+        out[c] = (value - mean[c]) * inv_stddev[c];
+      }
+    }
+  }
+}
+
 }  // namespace image
 }  // namespace tfrt
@@ -33,6 +33,16 @@ namespace image {
 void resize_image(const DenseHostTensor& input, const float height_scale,
                   const float width_scale, DenseHostTensor& output);
 
+// Resizes the uint8 [input_height, input_width, channels] image at `input` to
+// the float [output_height, output_width, channels] image at `output` with the
+// same bilinear interpolation as resize_image, and normalizes every channel c
+// to (value - mean[c]) * inv_stddev[c] in the same pass.
+void ResizeAndNormalizeImage(const uint8_t* input, Index input_height,
+                             Index input_width, Index channels,
+                             Index output_height, Index output_width,
+                             ArrayRef<float> mean, ArrayRef<float> inv_stddev,
+                             float* output);
+
 }  // namespace image
 }  // namespace tfrt
 
@@ -0,0 +1,230 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// MatMul kernel with the weights (B operand) packed ahead of time.
+//
+// Eigen contractions pack blocks of both operands into the panel layout of the
+// gebp micro-kernel on every call. When B is a constant, e.g. the weights of a
+// fully connected layer, PackedMatMulWeights packs it once, and PackedMatMul
+// passes the packed panels directly to the micro-kernel and only packs A. For
+// small batch sizes packing B costs about as much as the multiplication.
+//
+// Like Eigen contractions, PackedMatMul computes the row-major C = A * B as the
+// col-major C' = B' * A', where B' and C' share memory with B and C. This makes
+// B the left-hand side of the micro-kernel.
+//
+// PackedMatMul always uses the Eigen gebp kernel: DNNL sgemm (see
+// contraction_kernel.h) takes unpacked col-major blocks and packs them again
+// internally, so it can't consume prepacked panels.
+
+#ifndef TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_PACKED_MATMUL_KERNEL_H_
+#define TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_PACKED_MATMUL_KERNEL_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "tfrt/common/compat/eigen/tensor_types.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace cpu {
+namespace internal {
+
+// The micro-kernel loads packed panels with aligned packet loads.
+constexpr size_t kPackedPanelAlignment = 64;
+
+template <typename T>
+Eigen::Index AlignPanelOffset(Eigen::Index offset) {
+  static_assert(kPackedPanelAlignment % sizeof(T) == 0, "Unsupported type");
+  constexpr Eigen::Index kAlignment = kPackedPanelAlignment / sizeof(T);
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+template <typename T>
+using PackedBuffer = std::vector<T, Eigen::aligned_allocator<T>>;
+
+}  // namespace internal
+
+// B operand of a MatMul packed into the gebp micro-kernel panel layout. It is
+// immutable once packed, and can be shared by concurrent PackedMatMul calls.
+template <typename T>
+class PackedMatMulWeights {
+ public:
+  using Index = Eigen::Index;
+
+  // Packs `data`, a row-major [k, n] matrix, or [n, k] if `transpose_b`.
+  PackedMatMulWeights(const T* data, Index k, Index n, bool transpose_b)
+      : k_(k), n_(n), kc_(k), mc_(n) {
+    Index nc = n;
+    Eigen::internal::computeProductBlockingSizes<T, T>(kc_, mc_, nc);
+    kc_ = std::max<Index>(kc_, 1);
+    mc_ = std::max<Index>(mc_, 1);
+    num_k_blocks_ = (k_ + kc_ - 1) / kc_;
+
+    // B' is [n, k]: col-major B, or row-major B if it's transposed.
+    if (transpose_b) {
+      Pack<Eigen::RowMajor>(data, /*stride=*/k);
+    } else {
+      Pack<Eigen::ColMajor>(data, /*stride=*/n);
+    }
+  }
+
+  Index k() const { return k_; }
+  Index n() const { return n_; }
+
+  // Block sizes along the k and n dimensions.
+  Index kc() const { return kc_; }
+  Index mc() const { return mc_; }
+
+  // Returns the packed panel of the block starting at [i, k] of B'.
+  const T* Panel(Index i, Index k) const {
+    return packed_.data() + offsets_[(i / mc_) * num_k_blocks_ + k / kc_];
+  }
+
+ private:
+  template <int StorageOrder>
+  void Pack(const T* data, Index stride) {
+    using Traits = Eigen::internal::gebp_traits<T, T>;
+    using Mapper =
+        Eigen::internal::const_blas_data_mapper<T, Index, StorageOrder>;
+    Eigen::internal::gemm_pack_lhs<T, Index, Mapper, Traits::mr,
+                                   Traits::LhsProgress,
+                                   typename Traits::LhsPacket4Packing,
+                                   StorageOrder>
+        pack_lhs;
+
+    Index size = 0;
+    for (Index i2 = 0; i2 < n_; i2 += mc_) {
+      const Index actual_mc = std::min(i2 + mc_, n_) - i2;
+      for (Index k2 = 0; k2 < k_; k2 += kc_) {
+        const Index actual_kc = std::min(k2 + kc_, k_) - k2;
+        offsets_.push_back(size);
+        size = internal::AlignPanelOffset<T>(size + actual_mc * actual_kc);
+      }
+    }
+    packed_.resize(size);
+
+    Mapper lhs(data, stride);
+    for (Index i2 = 0; i2 < n_; i2 += mc_) {
+      const Index actual_mc = std::min(i2 + mc_, n_) - i2;
+      for (Index k2 = 0; k2 < k_; k2 += kc_) {
+        const Index actual_kc = std::min(k2 + kc_, k_) - k2;
+        pack_lhs(const_cast<T*>(Panel(i2, k2)), lhs.getSubMapper(i2, k2),
+                 actual_kc, actual_mc);
+      }
+    }
+  }
+
+  Index k_;
+  Index n_;
+  Index kc_;
+  Index mc_;
+  Index num_k_blocks_;
+
+  // Offsets of the packed panels, in the row-major order of the blocks.
+  std::vector<Index> offsets_;
+  internal::PackedBuffer<T> packed_;
+};
+
+// Computes C = A * B with prepacked B, then applies `output_kernel` (see
+// contraction_output_kernel.h) to every finished block of C. `a` is [m, k], or
+// [k, m] if `transpose_a`. Runs on the calling thread.
+template <typename T, typename OutputKernel = Eigen::NoOpOutputKernel>
+Error PackedMatMul(const DenseHostTensor& a, const PackedMatMulWeights<T>& b,
+                   DenseHostTensor* c, bool transpose_a,
+                   OutputKernel output_kernel = OutputKernel()) {
+  using Index = Eigen::Index;
+  using Traits = Eigen::internal::gebp_traits<T, T>;
+
+  if (a.shape().GetRank() != 2)
+    return MakeStringError("PackedMatMul lhs must be a matrix: ", a.shape());
+  const Index m = a.shape().GetDimensionSize(transpose_a ? 1 : 0);
+  const Index k = a.shape().GetDimensionSize(transpose_a ? 0 : 1);
+  const Index n = b.n();
+  if (k != b.k())
+    return MakeStringError("PackedMatMul contraction dimension mismatch: lhs=",
+                           a.shape(), " rhs depth=", b.k());
+  if (c->shape().GetRank() != 2 || c->shape().GetDimensionSize(0) != m ||
+      c->shape().GetDimensionSize(1) != n)
+    return MakeStringError("PackedMatMul unexpected output shape: ",
+                           c->shape());
+
+  const auto* a_data = static_cast<const T*>(a.data());
+  auto* c_data = static_cast<T*>(c->data());
+  std::fill(c_data, c_data + m * n, T(0));
+  if (m == 0 || n == 0 || k == 0) return Error::success();
+
+  // Pack A', the [k, m] right-hand side, once for all blocks of B'. This path
+  // is meant for small batch sizes m, so all of it fits into the cache.
+  internal::PackedBuffer<T> packed_a;
+  std::vector<Index> a_offsets;
+  {
+    Index size = 0;
+    for (Index k2 = 0; k2 < k; k2 += b.kc()) {
+      const Index actual_kc = std::min(k2 + b.kc(), k) - k2;
+      a_offsets.push_back(size);
+      size = internal::AlignPanelOffset<T>(size + actual_kc * m);
+    }
+    packed_a.resize(size);
+  }
+
+  auto pack_a = [&](auto storage_order, Index stride) {
+    constexpr int kStorageOrder = decltype(storage_order)::value;
+    using Mapper =
+        Eigen::internal::const_blas_data_mapper<T, Index, kStorageOrder>;
+    Eigen::internal::gemm_pack_rhs<T, Index, Mapper, Traits::nr, kStorageOrder>
+        pack_rhs;
+    Mapper rhs(a_data, stride);
+    for (Index k2 = 0, kb = 0; k2 < k; k2 += b.kc(), ++kb) {
+      const Index actual_kc = std::min(k2 + b.kc(), k) - k2;
+      pack_rhs(packed_a.data() + a_offsets[kb], rhs.getSubMapper(k2, 0),
+               actual_kc, m);
+    }
+  };
+  // A' is [k, m]: col-major A, or row-major A if it's transposed.
+  if (transpose_a) {
+    pack_a(std::integral_constant<int, Eigen::RowMajor>(), /*stride=*/m);
+  } else {
+    pack_a(std::integral_constant<int, Eigen::ColMajor>(), /*stride=*/k);
+  }
+
+  using ResMapper =
+      Eigen::internal::blas_data_mapper<T, Index, Eigen::ColMajor>;
+  Eigen::internal::gebp_kernel<T, T, Index, ResMapper, Traits::mr, Traits::nr>
+      gebp;
+
+  Eigen::TensorContractionParams params;
+  params.swapped_arguments = true;
+
+  ResMapper res(c_data, /*stride=*/n);
+  for (Index i2 = 0; i2 < n; i2 += b.mc()) {
+    const Index actual_mc = std::min(i2 + b.mc(), n) - i2;
+    for (Index k2 = 0, kb = 0; k2 < k; k2 += b.kc(), ++kb) {
+      const Index actual_kc = std::min(k2 + b.kc(), k) - k2;
+      gebp(res.getSubMapper(i2, 0), b.Panel(i2, k2),
+           packed_a.data() + a_offsets[kb], actual_mc, actual_kc, m, T(1));
+    }
+    output_kernel(res.getSubMapper(i2, 0), params, i2, 0, actual_mc, m);
+  }
+
+  return Error::success();
+}
+
+}  // namespace cpu
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_PACKED_MATMUL_KERNEL_H_
@@ -0,0 +1,474 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Quantized MatMul and Conv2D kernels.
+
+#include "./quantized_matmul_kernel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/msan.h"
+
+#ifdef __x86_64__
+#include "dnnl.h"  // from @dnnl
+#endif
+
+namespace tfrt {
+namespace cpu {
+namespace {
+
+// Scratch memory (image patches and int32 accumulators) of a tile of output
+// rows. Tiles are contracted and requantized while they are in the L2 cache.
+constexpr size_t kTileBytes = 256 * 1024;
+
+// Rough number of int8 multiply-accumulates per cycle, for the parallel block
+// size heuristic.
+constexpr double kMacsPerCycle = 32;
+
+bool IsI8(DType dtype) { return dtype == DType::I8 || dtype == DType::QI8; }
+bool IsUI8(DType dtype) { return dtype == DType::UI8 || dtype == DType::QUI8; }
+
+Index TileRows(Index k, Index n, size_t lhs_size) {
+  const size_t row_bytes = k * lhs_size + n * sizeof(int32_t);
+  return std::max<Index>(1, kTileBytes / std::max<size_t>(row_bytes, 1));
+}
+
+#ifdef __x86_64__
+dnnl_status_t IntegerGemm(char trans_a, char trans_b, Index m, Index n,
+                          Index k, const uint8_t* a, Index lda,
+                          const int8_t* b, Index ldb, int32_t* c) {
+  const int32_t c_offset = 0;
+  return dnnl_gemm_u8s8s32(trans_a, trans_b, 'F', m, n, k, 1.0f, a, lda, 0, b,
+                           ldb, 0, 0.0f, c, n, &c_offset);
+}
+
+dnnl_status_t IntegerGemm(char trans_a, char trans_b, Index m, Index n,
+                          Index k, const int8_t* a, Index lda, const int8_t* b,
+                          Index ldb, int32_t* c) {
+  const int32_t c_offset = 0;
+  return dnnl_gemm_s8s8s32(trans_a, trans_b, 'F', m, n, k, 1.0f, a, lda, 0, b,
+                           ldb, 0, 0.0f, c, n, &c_offset);
+}
+#endif  // __x86_64__
+
+// Computes the row-major int32 `c` [rows, n] = A * B for `rows` rows of A
+// starting at `a`, which are strided by `lda` (or are columns if
+// `transpose_a`).
+template <typename T>
+void Contract(const T* a, Index lda, bool transpose_a, const int8_t* b,
+              bool transpose_b, Index rows, Index n, Index k, int32_t* c) {
+#ifdef __x86_64__
+  dnnl_status_t status =
+      IntegerGemm(transpose_a ? 'T' : 'N', transpose_b ? 'T' : 'N', rows, n, k,
+                  a, lda, b, transpose_b ? k : n, c);
+  assert(status == dnnl_status_t::dnnl_success);
+  (void)status;
+
+  // DNNL is a pre-built library, see cpu_kernels.h.
+  TFRT_MSAN_MEMORY_IS_INITIALIZED(c, rows * n * sizeof(int32_t));
+#else
+  for (Index i = 0; i < rows; ++i) {
+    auto lhs = [&](Index kk) -> int32_t {
+      return transpose_a ? a[kk * lda + i] : a[i * lda + kk];
+    };
+    int32_t* c_row = c + i * n;
+    if (transpose_b) {
+      for (Index j = 0; j < n; ++j) {
+        int32_t sum = 0;
+        for (Index kk = 0; kk < k; ++kk) sum += lhs(kk) * b[j * k + kk];
+        c_row[j] = sum;
+      }
+    } else {
+      std::fill_n(c_row, n, 0);
+      for (Index kk = 0; kk < k; ++kk) {
+        const int32_t value = lhs(kk);
+        const int8_t* b_row = b + kk * n;
+        for (Index j = 0; j < n; ++j) c_row[j] += value * b_row[j];
+      }
+    }
+  }
+#endif  // __x86_64__
+}
+
+// Requantizes the int32 accumulators per output channel j:
+//
+//   out = (acc - zero_point_sums[j]) * multipliers[j] + offsets[j]
+//
+// The lhs zero point contributes lhs_zero_point * sum_k B(k, j) to every
+// accumulator, which is subtracted in int32 to keep the result exact. The
+// multipliers and offsets fold the scales, the bias and the output zero point.
+struct OutputStage {
+  std::vector<int32_t> zero_point_sums;
+  std::vector<float> multipliers;
+  std::vector<float> offsets;
+};
+
+OutputStage MakeOutputStage(const QuantizedContractionParams& params,
+                            const int8_t* b, bool transpose_b, Index k,
+                            Index n, DType output_dtype) {
+  const bool real_output = output_dtype == DType::F32;
+  const float output_scale = real_output ? 1.0f : params.output_scale;
+  const float output_zero_point =
+      real_output ? 0.0f : static_cast<float>(params.output_zero_point);
+
+  OutputStage stage;
+  stage.zero_point_sums.resize(n, 0);
+  stage.multipliers.resize(n);
+  stage.offsets.resize(n);
+
+  if (params.lhs_zero_point != 0) {
+    for (Index kk = 0; kk < k; ++kk) {
+      for (Index j = 0; j < n; ++j)
+        stage.zero_point_sums[j] += transpose_b ? b[j * k + kk] : b[kk * n + j];
+    }
+    for (int32_t& sum : stage.zero_point_sums) sum *= params.lhs_zero_point;
+  }
+
+  for (Index j = 0; j < n; ++j) {
+    const float rhs_scale =
+        params.rhs_scales.size() == 1 ? params.rhs_scales[0]
+                                      : params.rhs_scales[j];
+    const float bias = params.bias.empty() ? 0.0f : params.bias[j];
+    stage.multipliers[j] = params.lhs_scale * rhs_scale / output_scale;
+    stage.offsets[j] = bias / output_scale + output_zero_point;
+  }
+  return stage;
+}
+
+float Requantize(float value, float) { return value; }
+
+template <typename T>
+T Requantize(float value, T) {
+  value = std::nearbyint(value);
+  value = std::max<float>(value, std::numeric_limits<T>::min());
+  value = std::min<float>(value, std::numeric_limits<T>::max());
+  return static_cast<T>(value);
+}
+
+template <typename T>
+void StoreRows(const int32_t* acc, Index rows, Index n,
+               const OutputStage& stage, T* out) {
+  const int32_t* sums = stage.zero_point_sums.data();
+  const float* multipliers = stage.multipliers.data();
+  const float* offsets = stage.offsets.data();
+  for (Index i = 0; i < rows; ++i) {
+    const int32_t* acc_row = acc + i * n;
+    T* out_row = out + i * n;
+    for (Index j = 0; j < n; ++j) {
+      const float value =
+          static_cast<float>(acc_row[j] - sums[j]) * multipliers[j] +
+          offsets[j];
+      out_row[j] = Requantize(value, T());
+    }
+  }
+}
+
+// Calls `fn` with values of the lhs and output element types.
+template <typename F>
+AsyncValueRef<Chain> DispatchTypes(DType lhs, DType output, F&& fn) {
+  auto dispatch_output = [&](auto lhs_tag) -> AsyncValueRef<Chain> {
+    if (output == DType::F32) return fn(lhs_tag, float{});
+    if (IsI8(output)) return fn(lhs_tag, int8_t{});
+    assert(IsUI8(output));
+    return fn(lhs_tag, uint8_t{});
+  };
+  if (IsUI8(lhs)) return dispatch_output(uint8_t{});
+  assert(IsI8(lhs));
+  return dispatch_output(int8_t{});
+}
+
+Error CheckParams(const DenseHostTensor& lhs, const DenseHostTensor& rhs,
+                  const QuantizedContractionParams& params,
+                  const DenseHostTensor& output, Index n) {
+  if (!IsQuantizedContractionSupported(lhs.dtype(), rhs.dtype()))
+    return MakeStringError("Unsupported input dtypes: ", lhs.dtype(), " and ",
+                           rhs.dtype());
+  if (!IsQuantizedOutputSupported(output.dtype()))
+    return MakeStringError("Unsupported output dtype: ", output.dtype());
+  if (params.rhs_scales.size() != 1 &&
+      params.rhs_scales.size() != static_cast<size_t>(n))
+    return MakeStringError("Expected 1 or ", n, " rhs scales, got ",
+                           params.rhs_scales.size());
+  if (!params.bias.empty() && params.bias.size() != static_cast<size_t>(n))
+    return MakeStringError("Expected ", n, " bias values, got ",
+                           params.bias.size());
+  return Error::success();
+}
+
+ParallelFor::BlockSizes ContractionBlockSizes(Index k, Index n,
+                                              size_t lhs_size,
+                                              size_t output_size) {
+  return ParallelFor::BlockSizes::Cost(
+      /*bytes_loaded=*/k * lhs_size, /*bytes_stored=*/n * output_size,
+      /*compute_cycles=*/static_cast<double>(n) * k / kMacsPerCycle);
+}
+
+template <typename LhsT, typename OutT>
+AsyncValueRef<Chain> MatMulImpl(const DenseHostTensor& a,
+                                const DenseHostTensor& b, bool transpose_a,
+                                bool transpose_b, Index m, Index n, Index k,
+                                OutputStage stage, DenseHostTensor* output,
+                                const ExecutionContext& exec_ctx) {
+  const Index tile_rows = TileRows(k, n, sizeof(LhsT));
+
+  auto compute = [a_data = static_cast<const LhsT*>(a.data()),
+                  b_data = static_cast<const int8_t*>(b.data()),
+                  out = static_cast<OutT*>(output->data()), transpose_a,
+                  transpose_b, m, n, k, tile_rows, stage = std::move(stage),
+                  a_buffer = a.buffer().CopyRef(),
+                  b_buffer = b.buffer().CopyRef(),
+                  output = output->buffer().CopyRef()](size_t begin,
+                                                       size_t end) {
+    const Index rows = end - begin;
+    std::vector<int32_t> acc(std::min(tile_rows, rows) * n);
+    for (Index row = begin; row < static_cast<Index>(end); row += tile_rows) {
+      const Index tile = std::min<Index>(tile_rows, end - row);
+      const LhsT* a_tile = transpose_a ? a_data + row : a_data + row * k;
+      Contract(a_tile, transpose_a ? m : k, transpose_a, b_data, transpose_b,
+               tile, n, k, acc.data());
+      StoreRows(acc.data(), tile, n, stage, out + row * n);
+    }
+  };
+
+  return ParallelFor(exec_ctx).Execute(
+      m, ContractionBlockSizes(k, n, sizeof(LhsT), sizeof(OutT)),
+      std::move(compute));
+}
+
+struct Conv2DGeometry {
+  Index batch, in_h, in_w, in_c;
+  Index filter_h, filter_w, out_c;
+  Index out_h, out_w;
+  Index stride_h, stride_w;
+  Index pad_top, pad_left;
+};
+
+// Computes the output size and the leading padding of a spatial dimension.
+Error ComputeWindow(Index in, Index filter, Index stride, bool same,
+                    Index* out, Index* pad) {
+  if (stride <= 0) return MakeStringError("strides must be positive");
+  if (same) {
+    *out = (in + stride - 1) / stride;
+    *pad = std::max<Index>((*out - 1) * stride + filter - in, 0) / 2;
+  } else {
+    if (in < filter)
+      return MakeStringError("filter size ", filter,
+                             " is larger than the input size ", in);
+    *out = (in - filter) / stride + 1;
+    *pad = 0;
+  }
+  return Error::success();
+}
+
+Expected<Conv2DGeometry> ComputeConv2DGeometry(const TensorShape& input,
+                                               const TensorShape& filter,
+                                               std::array<Index, 2> strides,
+                                               string_view padding) {
+  if (input.GetRank() != 4 || filter.GetRank() != 4)
+    return MakeStringError("input and filter must be 4-D tensors");
+  if (padding != "SAME" && padding != "VALID")
+    return MakeStringError("Unsupported padding: ", padding);
+
+  Conv2DGeometry geometry;
+  geometry.batch = input.GetDimensionSize(0);
+  geometry.in_h = input.GetDimensionSize(1);
+  geometry.in_w = input.GetDimensionSize(2);
+  geometry.in_c = input.GetDimensionSize(3);
+  geometry.filter_h = filter.GetDimensionSize(0);
+  geometry.filter_w = filter.GetDimensionSize(1);
+  geometry.out_c = filter.GetDimensionSize(3);
+  geometry.stride_h = strides[0];
+  geometry.stride_w = strides[1];
+  if (filter.GetDimensionSize(2) != geometry.in_c)
+    return MakeStringError("filter input depth ", filter.GetDimensionSize(2),
+                           " does not match input depth ", geometry.in_c);
+
+  const bool same = padding == "SAME";
+  if (auto error = ComputeWindow(geometry.in_h, geometry.filter_h,
+                                 geometry.stride_h, same, &geometry.out_h,
+                                 &geometry.pad_top))
+    return std::move(error);
+  if (auto error = ComputeWindow(geometry.in_w, geometry.filter_w,
+                                 geometry.stride_w, same, &geometry.out_w,
+                                 &geometry.pad_left))
+    return std::move(error);
+  return geometry;
+}
+
+// Copies the image patches of the output pixels [begin, begin + rows) into the
+// row-major `patches` [rows, filter_h * filter_w * in_c].
+template <typename T>
+void Im2Col(const T* input, const Conv2DGeometry& g, Index begin, Index rows,
+            T pad_value, T* patches) {
+  for (Index r = 0; r < rows; ++r) {
+    const Index pixel = begin + r;
+    const Index ow = pixel % g.out_w;
+    const Index oh = (pixel / g.out_w) % g.out_h;
+    const Index b = pixel / (g.out_w * g.out_h);
+    for (Index fh = 0; fh < g.filter_h; ++fh) {
+      const Index ih = oh * g.stride_h - g.pad_top + fh;
+      for (Index fw = 0; fw < g.filter_w; ++fw) {
+        const Index iw = ow * g.stride_w - g.pad_left + fw;
+        if (ih >= 0 && ih < g.in_h && iw >= 0 && iw < g.in_w) {
+          const Index offset = ((b * g.in_h + ih) * g.in_w + iw) * g.in_c;
+          std::memcpy(patches, input + offset, g.in_c * sizeof(T));
+        } else {
+          std::fill_n(patches, g.in_c, pad_value);
+        }
+        patches += g.in_c;
+      }
+    }
+  }
+}
+
+template <typename LhsT, typename OutT>
+AsyncValueRef<Chain> Conv2DImpl(const DenseHostTensor& input,
+                                const DenseHostTensor& filter,
+                                const Conv2DGeometry& geometry,
+                                int32_t lhs_zero_point, OutputStage stage,
+                                DenseHostTensor* output,
+                                const ExecutionContext& exec_ctx) {
+  const Index m = geometry.batch * geometry.out_h * geometry.out_w;
+  const Index k = geometry.filter_h * geometry.filter_w * geometry.in_c;
+  const Index n = geometry.out_c;
+  const Index tile_rows = TileRows(k, n, sizeof(LhsT));
+
+  // 1x1 convolutions with unit strides contract the input pixels directly.
+  const bool direct = geometry.filter_h == 1 && geometry.filter_w == 1 &&
+                      geometry.stride_h == 1 && geometry.stride_w == 1;
+  const LhsT pad_value = static_cast<LhsT>(std::min<int32_t>(
+      std::max<int32_t>(lhs_zero_point, std::numeric_limits<LhsT>::min()),
+      std::numeric_limits<LhsT>::max()));
+
+  auto compute = [in = static_cast<const LhsT*>(input.data()),
+                  f = static_cast<const int8_t*>(filter.data()),
+                  out = static_cast<OutT*>(output->data()), geometry, direct,
+                  pad_value, n, k, tile_rows, stage = std::move(stage),
+                  input_buffer = input.buffer().CopyRef(),
+                  filter_buffer = filter.buffer().CopyRef(),
+                  output = output->buffer().CopyRef()](size_t begin,
+                                                       size_t end) {
+    const Index rows = std::min<Index>(tile_rows, end - begin);
+    std::vector<int32_t> acc(rows * n);
+    std::vector<LhsT> patches(direct ? 0 : rows * k);
+    for (Index row = begin; row < static_cast<Index>(end); row += tile_rows) {
+      const Index tile = std::min<Index>(tile_rows, end - row);
+      const LhsT* lhs = in + row * k;
+      if (!direct) {
+        Im2Col(in, geometry, row, tile, pad_value, patches.data());
+        lhs = patches.data();
+      }
+      Contract(lhs, k, /*transpose_a=*/false, f, /*transpose_b=*/false, tile,
+               n, k, acc.data());
+      StoreRows(acc.data(), tile, n, stage, out + row * n);
+    }
+  };
+
+  return ParallelFor(exec_ctx).Execute(
+      m, ContractionBlockSizes(k, n, sizeof(LhsT), sizeof(OutT)),
+      std::move(compute));
+}
+
+}  // namespace
+
+bool IsQuantizedContractionSupported(DType lhs, DType rhs) {
+  return (IsI8(lhs) || IsUI8(lhs)) && IsI8(rhs);
+}
+
+bool IsQuantizedOutputSupported(DType output) {
+  return output == DType::F32 || IsI8(output) || IsUI8(output);
+}
+
+AsyncValueRef<Chain> QuantizedMatMul(const DenseHostTensor& a,
+                                     const DenseHostTensor& b,
+                                     bool transpose_a, bool transpose_b,
+                                     const QuantizedContractionParams& params,
+                                     DenseHostTensor* output,
+                                     const ExecutionContext& exec_ctx) {
+  if (a.shape().GetRank() != 2 || b.shape().GetRank() != 2)
+    return EmitErrorAsync(exec_ctx, "a and b must be matrices");
+  const Index m = a.shape().GetDimensionSize(transpose_a ? 1 : 0);
+  const Index k = a.shape().GetDimensionSize(transpose_a ? 0 : 1);
+  const Index n = b.shape().GetDimensionSize(transpose_b ? 0 : 1);
+  if (b.shape().GetDimensionSize(transpose_b ? 1 : 0) != k)
+    return EmitErrorAsync(exec_ctx, "inner dimensions of a and b must match");
+  if (output->shape() != TensorShape({m, n}))
+    return EmitErrorAsync(exec_ctx, "output shape must be [m, n]");
+  if (auto error = CheckParams(a, b, params, *output, n))
+    return EmitErrorAsync(exec_ctx, std::move(error));
+  if (output->NumElements() == 0) return GetReadyChain();
+
+  OutputStage stage =
+      MakeOutputStage(params, static_cast<const int8_t*>(b.data()),
+                      transpose_b, k, n, output->dtype());
+  return DispatchTypes(
+      a.dtype(), output->dtype(), [&](auto lhs_tag, auto out_tag) {
+        return MatMulImpl<decltype(lhs_tag), decltype(out_tag)>(
+            a, b, transpose_a, transpose_b, m, n, k, std::move(stage), output,
+            exec_ctx);
+      });
+}
+
+Expected<TensorShape> QuantizedConv2DOutputShape(const TensorShape& input,
+                                                 const TensorShape& filter,
+                                                 std::array<Index, 2> strides,
+                                                 string_view padding) {
+  auto geometry = ComputeConv2DGeometry(input, filter, strides, padding);
+  if (!geometry) return geometry.takeError();
+  return TensorShape(
+      {geometry->batch, geometry->out_h, geometry->out_w, geometry->out_c});
+}
+
+AsyncValueRef<Chain> QuantizedConv2D(const DenseHostTensor& input,
+                                     const DenseHostTensor& filter,
+                                     std::array<Index, 2> strides,
+                                     string_view padding,
+                                     const QuantizedContractionParams& params,
+                                     DenseHostTensor* output,
+                                     const ExecutionContext& exec_ctx) {
+  auto geometry =
+      ComputeConv2DGeometry(input.shape(), filter.shape(), strides, padding);
+  if (!geometry) return EmitErrorAsync(exec_ctx, geometry.takeError());
+  const Conv2DGeometry& g = *geometry;
+  if (output->shape() != TensorShape({g.batch, g.out_h, g.out_w, g.out_c}))
+    return EmitErrorAsync(exec_ctx, "output shape does not match the Conv2D");
+  if (auto error = CheckParams(input, filter, params, *output, g.out_c))
+    return EmitErrorAsync(exec_ctx, std::move(error));
+  if (output->NumElements() == 0) return GetReadyChain();
+
+  // The HWIO filter is the row-major [filter_h * filter_w * in_c, out_c] rhs.
+  OutputStage stage =
+      MakeOutputStage(params, static_cast<const int8_t*>(filter.data()),
+                      /*transpose_b=*/false, g.filter_h * g.filter_w * g.in_c,
+                      g.out_c, output->dtype());
+  return DispatchTypes(
+      input.dtype(), output->dtype(), [&](auto lhs_tag, auto out_tag) {
+        return Conv2DImpl<decltype(lhs_tag), decltype(out_tag)>(
+            input, filter, g, params.lhs_zero_point, std::move(stage), output,
+            exec_ctx);
+      });
+}
+
+}  // namespace cpu
+}  // namespace tfrt
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Quantized MatMul and Conv2D kernels: int8 x int8 -> int32 contractions with
+// a fused requantization output stage.
+//
+// The lhs (MatMul A operand, Conv2D input) is I8 or UI8 with an affine
+// quantization, the rhs (MatMul B operand, Conv2D filter) is I8 with a
+// symmetric quantization per output channel. Quantized dtypes (QI8, QUI8) are
+// accepted in place of the integer dtypes with the same storage.
+//
+// On x86-64 the int32 contractions are DNNL integer gemms, which use the
+// AVX512-VNNI instructions where available. Elsewhere they fall back to a
+// portable loop. Row blocks of the output are computed in parallel, and every
+// block is requantized right after its contraction while it is in the cache.
+
+#ifndef TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_QUANTIZED_MATMUL_KERNEL_H_
+#define TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_QUANTIZED_MATMUL_KERNEL_H_
+
+#include <array>
+#include <cstdint>
+
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace cpu {
+
+// Quantization of the operands and the result of a quantized contraction. A
+// quantized value q represents the real value scale * (q - zero_point).
+struct QuantizedContractionParams {
+  float lhs_scale = 1.0f;
+  int32_t lhs_zero_point = 0;
+
+  // Scales of the rhs output channels, or a single scale for all channels.
+  // The rhs zero point is always 0.
+  llvm::SmallVector<float, 1> rhs_scales;
+
+  // Real valued bias of the output channels, or empty if there is no bias.
+  llvm::SmallVector<float, 0> bias;
+
+  // Quantization of QI8 or QUI8 results. F32 results are real values.
+  float output_scale = 1.0f;
+  int32_t output_zero_point = 0;
+};
+
+// Returns true if the lhs and rhs dtypes are supported.
+bool IsQuantizedContractionSupported(DType lhs, DType rhs);
+
+// Returns true if the result dtype is supported.
+bool IsQuantizedOutputSupported(DType output);
+
+// Computes the row-major [m, n] `output` = A * B, where A is `a` [m, k] (or
+// [k, m] if `transpose_a`) and B is `b` [k, n] (or [n, k] if `transpose_b`).
+// The int32 products are converted to real values with the scales, the bias
+// is added, and the result is requantized to the output dtype.
+AsyncValueRef<Chain> QuantizedMatMul(const DenseHostTensor& a,
+                                     const DenseHostTensor& b,
+                                     bool transpose_a, bool transpose_b,
+                                     const QuantizedContractionParams& params,
+                                     DenseHostTensor* output,
+                                     const ExecutionContext& exec_ctx);
+
+// Returns the NHWC output shape of a Conv2D of the NHWC `input` and the HWIO
+// `filter` with "SAME" or "VALID" `padding`.
+Expected<TensorShape> QuantizedConv2DOutputShape(const TensorShape& input,
+                                                 const TensorShape& filter,
+                                                 std::array<Index, 2> strides,
+                                                 string_view padding);
+
+// Computes the Conv2D of the NHWC `input` with the HWIO `filter` as the
+// contraction of the image patches with the filter, with the same output
+// stage as QuantizedMatMul. Padding is filled with the lhs zero point, i.e.
+// the real value 0. 1x1 convolutions contract the input without copying it.
+AsyncValueRef<Chain> QuantizedConv2D(const DenseHostTensor& input,
+                                     const DenseHostTensor& filter,
+                                     std::array<Index, 2> strides,
+                                     string_view padding,
+                                     const QuantizedContractionParams& params,
+                                     DenseHostTensor* output,
+                                     const ExecutionContext& exec_ctx);
+
+}  // namespace cpu
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_QUANTIZED_MATMUL_KERNEL_H_
@@ -19,97 +19,100 @@
 #ifndef TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_SOFTMAX_KERNEL_H_
 #define TFRT_BACKENDS_CPU_LIB_KERNELS_CPU_SOFTMAX_KERNEL_H_
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "tfrt/common/compat/eigen/eigen_kernel.h"
 #include "tfrt/common/compat/eigen/tensor_types.h"
 #include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/host_context/parallel_for.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 #include "tfrt/tensor/tensor_shape.h"
 
 namespace tfrt {
 namespace cpu {
+namespace internal {
+
+// Rows are reduced in blocks of this many classes, that fit into the L1 cache
+// together with the logits of the next block.
+constexpr Eigen::Index kSoftmaxBlockSize = 1024;
+
+// Computes softmax (or log softmax) of a single row of logits.
+//
+// The first pass computes max(logits) and sum(exp(logits - max)) together: for
+// every block it loads the logits from memory once, updates the running
+// maximum, rescales the running sum if the maximum has changed, and adds the
+// block exponents reading the block from the cache. The second pass reads the
+// logits again and writes the result.
+template <typename T, bool log>
+void SoftmaxRow(const T* logits, T* softmax, Eigen::Index num_classes) {
+  using ConstArray = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+  using Array = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+
+  T max = -std::numeric_limits<T>::infinity();
+  T sum = T(0);
+  for (Eigen::Index i = 0; i < num_classes; i += kSoftmaxBlockSize) {
+    ConstArray block(logits + i, std::min(kSoftmaxBlockSize, num_classes - i));
+    T block_max = block.maxCoeff();
+    if (block_max > max) {
+      sum *= std::exp(max - block_max);
+      max = block_max;
+    }
+    sum += (block - max).exp().sum();
+  }
+
+  ConstArray in(logits, num_classes);
+  Array out(softmax, num_classes);
+  if (log) {
+    // softmax = logits - max - log(sum(exp(logits - max)))
+    out = in - (max + std::log(sum));
+  } else {
+    // softmax = exp(logits - max) / sum(exp(logits - max))
+    out = (in - max).exp() * (T(1) / sum);
+  }
+}
 
+}  // namespace internal
+
+// Computes softmax along the innermost dimension of `logits`. Rows are
+// computed in parallel, each one in two passes over the logits (see
+// SoftmaxRow).
 template <typename T, bool log, typename EigenEvaluator>
 static typename EigenEvaluator::DependencyToken Softmax(
     const DenseHostTensor& logits, DenseHostTensor* softmax,
     const ExecutionContext& exec_ctx) {
-  // TODO(b/172291736): Avoid creating another DHT by having a generic view
-  // class that operates on only a shape and a pointer.
-  DenseHostTensor reshaped_logits(
-      TensorMetadata(logits.dtype(), GetFlattenedInnerDimsShape(
-                                         logits.shape(), /*num_out_dims=*/2)),
-      logits.buffer());
-  DenseHostTensor reshaped_softmax(
-      TensorMetadata(
-          softmax->dtype(),
-          GetFlattenedInnerDimsShape(softmax->shape(), /*num_out_dims=*/2)),
-      softmax->buffer());
-  DHTIndexableView<T, 2> logits_view(&reshaped_logits);
-  MutableDHTIndexableView<T, 2> softmax_view(&reshaped_softmax);
-
-  auto logits_t = compat::AsEigenConstTensor(logits_view);
-  auto softmax_t = compat::AsEigenTensor(softmax_view);
-
-  static constexpr int kBatchDim = 0;
-  static constexpr int kClassDim = 1;
-
-  const int batch_size = logits_t.dimension(kBatchDim);
-  const int num_classes = logits_t.dimension(kClassDim);
-
-  // Reduce along the class dimension.
-  Eigen::IndexList<Eigen::type2index<kClassDim>> along_class;
-
-  // Broadcast from [num_classes] to [batch, num_classes]
-  Eigen::IndexList<int, Eigen::type2index<1>> batch_by_one;
-  batch_by_one.set(0, batch_size);
-
-  // Broadcast from [batch] to [batch, num_classes]
-  Eigen::IndexList<Eigen::type2index<1>, int> one_by_class;
-  one_by_class.set(1, num_classes);
-
-  // In both cases we first pre-compute temporary logits reduction into the
-  // output (softmax) tensor, and after that evaluate a second expression that
-  // uses pre-computed values to get a final result.
-
-  // shifted_logits = logits - max(logits along classes);
-  auto shifted_logits_expr = (logits_t - logits_t.maximum(along_class)
-                                             .eval()
-                                             .reshape(batch_by_one)
-                                             .broadcast(one_by_class));
-  EigenEvaluator eigen{exec_ctx.host()};
-
-  if (log) {
-    // softmax = logits - max(logits along classes);
-    auto logits_ready =
-        eigen.Evaluate(softmax_t, std::move(shifted_logits_expr),
-                       eigen.KeepAlive(&logits, softmax));
-
-    // softmax = softmax - log(sum(exp(softmax along classes)));
-    auto softmax_expr = (softmax_t - softmax_t.exp()
-                                         .sum(along_class)
-                                         .log()
-                                         .eval()
-                                         .reshape(batch_by_one)
-                                         .broadcast(one_by_class));
-
-    return eigen.Evaluate(logits_ready, softmax_t, std::move(softmax_expr),
-                          eigen.KeepAlive(&logits, softmax));
+  const TensorShape& shape = logits.shape();
+  const int rank = shape.GetRank();
+  const Eigen::Index num_classes =
+      rank == 0 ? 1 : shape.GetDimensionSize(rank - 1);
+  const Eigen::Index batch_size =
+      num_classes == 0 ? 0 : shape.GetNumElements() / num_classes;
+
+  const T* logits_data = static_cast<const T*>(logits.data());
+  T* softmax_data = static_cast<T*>(softmax->data());
+  auto compute = [logits_data, softmax_data, num_classes](size_t begin,
+                                                           size_t end) {
+    for (size_t row = begin; row < end; ++row) {
+      internal::SoftmaxRow<T, log>(logits_data + row * num_classes,
+                                   softmax_data + row * num_classes,
+                                   num_classes);
+    }
+  };
+
+  // Every row is loaded twice and stored once, and every class computes two
+  // exponents (one in log softmax).
+  using ExpOp = Eigen::internal::scalar_exp_op<T>;
+  const double exp_cycles = Eigen::internal::functor_traits<ExpOp>::Cost;
+  const double bytes_loaded = 2.0 * num_classes * sizeof(T);
+  const double bytes_stored = 1.0 * num_classes * sizeof(T);
+  const double compute_cycles = num_classes * ((log ? 1 : 2) * exp_cycles + 3);
 
-  } else {
-    // softmax = exp(logits - max(logits along classes));
-    auto logits_ready =
-        eigen.Evaluate(softmax_t, std::move(shifted_logits_expr.exp()),
-                       eigen.KeepAlive(&logits, softmax));
-
-    // softmax = softmax * (1 / sum(softmax along classes));
-    auto softmax_expr = (softmax_t * softmax_t.sum(along_class)
-                                         .inverse()
-                                         .eval()
-                                         .reshape(batch_by_one)
-                                         .broadcast(one_by_class));
-
-    return eigen.Evaluate(logits_ready, softmax_t, std::move(softmax_expr),
-                          eigen.KeepAlive(&logits, softmax));
-  }
+  EigenEvaluator eigen{exec_ctx.host()};
+  return eigen.EvaluateParallel(
+      exec_ctx, batch_size,
+      ParallelFor::BlockSizes::Cost(bytes_loaded, bytes_stored, compute_cycles),
+      std::move(compute), eigen.KeepAlive(&logits, softmax));
 }
 
 }  // namespace cpu
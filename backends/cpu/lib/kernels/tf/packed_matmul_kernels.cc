@@ -0,0 +1,101 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// MatMul Tensorflow kernels with constant weights.
+
+#include <memory>
+#include <utility>
+
+#include "../packed_matmul_kernel.h"
+#include "llvm/ADT/DenseMap.h"
+#include "tfrt/common/compat/eigen/eigen_dtype.h"
+#include "tfrt/host_context/shared_context.h"
+#include "tfrt/host_context/sync_kernel_utils.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+
+namespace {
+
+// Weights packed by _ConstMatMul kernels, keyed by the address of the weights
+// attribute in the BEF file and whether they are transposed. BEF attributes
+// stay alive and in place as long as the HostContext.
+template <typename T>
+class PackedWeightsCache : public SharedContext {
+ public:
+  explicit PackedWeightsCache(HostContext* host) {}
+
+  const cpu::PackedMatMulWeights<T>& GetOrPack(DenseAttr weights,
+                                               bool transpose_b) {
+    Key key(weights.GetElements(), transpose_b ? 1 : 0);
+    mutex_lock lock(mu_);
+    auto& packed = cache_[key];
+    if (!packed) {
+      auto dims = weights.shape();
+      Eigen::Index k = dims[transpose_b ? 1 : 0];
+      Eigen::Index n = dims[transpose_b ? 0 : 1];
+      packed = std::make_unique<cpu::PackedMatMulWeights<T>>(
+          static_cast<const T*>(weights.GetElements()), k, n, transpose_b);
+    }
+    return *packed;
+  }
+
+ private:
+  using Key = std::pair<const void*, int>;
+
+  mutex mu_;
+  llvm::DenseMap<Key, std::unique_ptr<cpu::PackedMatMulWeights<T>>> cache_
+      TFRT_GUARDED_BY(mu_);
+};
+
+// Computes output = a * weights, where weights is a constant attribute. The
+// weights are packed on the first execution and reused by later executions.
+template <typename T>
+Error ConstMatMul(const DenseHostTensor& a, DenseHostTensor* output,
+                  DenseAttr weights, Attribute<bool> transpose_a,
+                  Attribute<bool> transpose_b,
+                  const ExecutionContext& exec_ctx) {
+  if (weights.dtype() != GetDType<T>())
+    return MakeStringError("_ConstMatMul weights dtype mismatch: ",
+                           weights.dtype());
+  if (weights.shape().size() != 2)
+    return MakeStringError("_ConstMatMul weights must be a matrix");
+
+  auto& cache =
+      exec_ctx.host()->GetOrCreateSharedContext<PackedWeightsCache<T>>();
+  return cpu::PackedMatMul<T>(a, cache.GetOrPack(weights, *transpose_b),
+                              output, *transpose_a);
+}
+
+}  // namespace
+
+namespace tf {
+
+void RegisterPackedMatmulKernels(KernelRegistry* registry) {
+#define DTYPE_FLOAT(ENUM)                                      \
+  {                                                            \
+    using CPP_TYPE = EigenTypeForDTypeKind<DType::ENUM>;       \
+    registry->AddSyncKernel(                                   \
+        StrCat("tf_sync._ConstMatMul.", GetDType<CPP_TYPE>()), \
+        TFRT_SYNC_KERNEL(ConstMatMul<CPP_TYPE>));              \
+  }
+#include "tfrt/dtype/dtype.def"
+}
+
+}  // namespace tf
+
+}  // namespace tfrt
@@ -26,6 +26,7 @@ void RegisterBinaryCpuKernels(KernelRegistry* registry);
 void RegisterSoftmaxCpuKernels(KernelRegistry* registry);
 void RegisterConstCpuKernels(KernelRegistry* registry);
 void RegisterFusedMatmulKernels(KernelRegistry* registry);
+void RegisterPackedMatmulKernels(KernelRegistry* registry);
 void RegisterConcatCpuKernels(KernelRegistry* registry);
 void RegisterTileCpuKernels(KernelRegistry* registry);
 
@@ -34,6 +35,7 @@ TFRT_STATIC_KERNEL_REGISTRATION(RegisterBinaryCpuKernels);
 TFRT_STATIC_KERNEL_REGISTRATION(RegisterSoftmaxCpuKernels);
 TFRT_STATIC_KERNEL_REGISTRATION(RegisterConstCpuKernels);
 TFRT_STATIC_KERNEL_REGISTRATION(RegisterFusedMatmulKernels);
+TFRT_STATIC_KERNEL_REGISTRATION(RegisterPackedMatmulKernels);
 TFRT_STATIC_KERNEL_REGISTRATION(RegisterConcatCpuKernels);
 TFRT_STATIC_KERNEL_REGISTRATION(RegisterTileCpuKernels);
 
@@ -18,8 +18,102 @@
 
 #include "./tile_kernel.h"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#include "tfrt/host_context/parallel_for.h"
+
 namespace tfrt {
 namespace cpu {
+namespace {
+
+// Input lines shorter than this are tiled with the Eigen broadcast.
+constexpr size_t kMinTileByCopyLineBytes = 64;
+
+// Tiling along a single dimension. Every unit is an output block that holds
+// `replicas` copies of a `block_bytes` region. At the innermost dimension the
+// region is copied from the input, at outer dimensions from the first copy in
+// the block, which is filled by the previous levels.
+struct TileLevel {
+  llvm::SmallVector<Index, 5> unit_dims;      // input dims enumerating units
+  llvm::SmallVector<Index, 5> unit_strides;   // output strides of unit dims
+  Index block_bytes;
+  Index replicas;
+  bool from_input;
+};
+
+struct TileByCopyState {
+  llvm::SmallVector<TileLevel, 5> levels;
+  RCReference<HostBuffer> input;
+  RCReference<HostBuffer> output;
+  AsyncValueRef<Chain> done;
+};
+
+// Copies replicas [begin, end) of the unit blocks of `level`, where the index
+// is unit * num_copies + copy.
+void CopyTileReplicas(const TileLevel& level, const char* input, char* output,
+                      size_t begin, size_t end) {
+  const Index first_copy = level.from_input ? 0 : 1;
+  const Index num_copies = level.replicas - first_copy;
+  const Index block = level.block_bytes;
+
+  while (begin < end) {
+    const Index unit = begin / num_copies;
+    const Index copy_begin = first_copy + begin % num_copies;
+    const Index copy_end =
+        std::min<Index>(level.replicas, copy_begin + (end - begin));
+
+    // Offsets of the unit block in the input and the output.
+    Index remaining = unit;
+    Index out_offset = 0;
+    for (int d = level.unit_dims.size() - 1; d >= 0; --d) {
+      out_offset += (remaining % level.unit_dims[d]) * level.unit_strides[d];
+      remaining /= level.unit_dims[d];
+    }
+    char* out = output + out_offset;
+    const char* src = level.from_input ? input + unit * block : out;
+
+    // Copy a single replica, and then double the copied region.
+    char* dst = out + copy_begin * block;
+    std::memcpy(dst, src, block);
+    const Index total = (copy_end - copy_begin) * block;
+    for (Index filled = block; filled < total;) {
+      const Index bytes = std::min(filled, total - filled);
+      std::memcpy(dst + filled, dst, bytes);
+      filled += bytes;
+    }
+
+    begin += copy_end - copy_begin;
+  }
+}
+
+// Tiles all levels starting from `index`, one level after another.
+void RunTileLevel(std::shared_ptr<TileByCopyState> state, size_t index,
+                  const ExecutionContext& exec_ctx) {
+  if (index == state->levels.size()) {
+    state->done.emplace();
+    return;
+  }
+
+  const TileLevel& level = state->levels[index];
+  Index num_units = 1;
+  for (Index dim : level.unit_dims) num_units *= dim;
+  const Index num_copies = level.replicas - (level.from_input ? 0 : 1);
+
+  const double bytes = level.block_bytes;
+  ParallelFor(exec_ctx).Execute(
+      num_units * num_copies,
+      ParallelFor::BlockSizes::Cost(bytes, bytes, 0),
+      [state, &level](size_t begin, size_t end) {
+        CopyTileReplicas(level, static_cast<const char*>(state->input->data()),
+                         static_cast<char*>(state->output->data()), begin,
+                         end);
+      },
+      [state, index, exec_ctx]() { RunTileLevel(state, index + 1, exec_ctx); });
+}
+
+}  // namespace
 
 Expected<llvm::SmallVector<Index, 5>> TileMultiples(
     const DenseHostTensor& multiples_arg) {
@@ -46,6 +140,73 @@ Expected<llvm::SmallVector<Index, 5>> TileMultiples(
   return multiples;
 }
 
+bool IsTileByCopyPreferred(DType dtype, const TensorShape& input_shape,
+                           ArrayRef<Index> multiples) {
+  if (GetHostSizeInBits(dtype) % 8 != 0) return false;
+  if (input_shape.GetRank() > 5) return true;
+
+  // Bytes in the innermost input line that is tiled, including all trailing
+  // dimensions that are not tiled.
+  size_t line_bytes = GetHostSize(dtype);
+  for (int d = input_shape.GetRank() - 1; d >= 0; --d) {
+    line_bytes *= input_shape.GetDimensionSize(d);
+    if (multiples[d] != 1) break;
+  }
+  return line_bytes >= kMinTileByCopyLineBytes;
+}
+
+AsyncValueRef<Chain> TileByCopy(const DenseHostTensor& input,
+                                ArrayRef<Index> multiples,
+                                DenseHostTensor* output,
+                                const ExecutionContext& exec_ctx) {
+  const TensorShape& shape = input.shape();
+  const int rank = shape.GetRank();
+  if (output->NumElements() == 0) return GetReadyChain();
+
+  // Trailing dimensions that are not tiled are copied as a single line.
+  int tiled_rank = rank;
+  while (tiled_rank > 0 && multiples[tiled_rank - 1] == 1) --tiled_rank;
+
+  Index line_bytes = GetHostSize(input.dtype());
+  for (int d = tiled_rank; d < rank; ++d)
+    line_bytes *= shape.GetDimensionSize(d);
+
+  if (tiled_rank == 0) {
+    std::memcpy(output->data(), input.data(), line_bytes);
+    return GetReadyChain();
+  }
+
+  // Output strides in bytes of the tiled dimensions.
+  llvm::SmallVector<Index, 5> out_strides(tiled_rank);
+  out_strides[tiled_rank - 1] = line_bytes;
+  for (int d = tiled_rank - 2; d >= 0; --d)
+    out_strides[d] =
+        out_strides[d + 1] * shape.GetDimensionSize(d + 1) * multiples[d + 1];
+
+  auto state = std::make_shared<TileByCopyState>();
+  for (int d = tiled_rank - 1; d >= 0; --d) {
+    const bool from_input = d == tiled_rank - 1;
+    if (!from_input && multiples[d] == 1) continue;
+
+    TileLevel level;
+    for (int u = 0; u < d; ++u) {
+      level.unit_dims.push_back(shape.GetDimensionSize(u));
+      level.unit_strides.push_back(out_strides[u]);
+    }
+    level.block_bytes = shape.GetDimensionSize(d) * out_strides[d];
+    level.replicas = multiples[d];
+    level.from_input = from_input;
+    state->levels.push_back(std::move(level));
+  }
+  state->input = input.buffer().CopyRef();
+  state->output = output->buffer().CopyRef();
+  state->done = MakeUnconstructedAsyncValueRef<Chain>();
+
+  auto done = state->done.CopyRef();
+  RunTileLevel(std::move(state), 0, exec_ctx);
+  return done;
+}
+
 void TileStringTensor(const StringHostTensor& input, StringHostTensor* output) {
   // Compute strides from the shape.
   auto strides = [](const TensorShape& shape) -> llvm::SmallVector<Index, 5> {
@@ -22,6 +22,8 @@
 #include "tfrt/common/compat/eigen/eigen_evaluator.h"
 #include "tfrt/common/compat/eigen/eigen_kernel.h"
 #include "tfrt/common/compat/eigen/tensor_types.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/chain.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/tensor/dense_host_tensor.h"
@@ -79,6 +81,23 @@ static typename EigenEvaluator::DependencyToken Tile(
   }
 }
 
+// Returns true if TileByCopy is expected to be faster than the Eigen broadcast
+// in Tile. Copying wins when the contiguous input lines are large enough to be
+// copied with memcpy, and it also supports ranks above 5.
+bool IsTileByCopyPreferred(DType dtype, const TensorShape& input_shape,
+                           ArrayRef<Index> multiples);
+
+// Tiles `input` into `output` with memcpy, independent of the element type.
+// Dimensions are processed from the innermost to the outermost: the first
+// tile of every output block is filled, and then it is replicated along the
+// tiled dimension by repeatedly doubling the copied region. Copies of a single
+// dimension run in parallel, and the returned chain becomes available when
+// the output is computed.
+AsyncValueRef<Chain> TileByCopy(const DenseHostTensor& input,
+                                ArrayRef<Index> multiples,
+                                DenseHostTensor* output,
+                                const ExecutionContext& exec_ctx);
+
 void TileStringTensor(const StringHostTensor& input, StringHostTensor* output);
 
 }  // namespace cpu
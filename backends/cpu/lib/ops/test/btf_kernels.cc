@@ -18,9 +18,42 @@
 #include "tfrt/host_context/kernel_registry.h"
 #include "tfrt/host_context/kernel_utils.h"
 #include "tfrt/tensor/btf_util.h"
+#include "tfrt/tensor/constant_store.h"
 
 namespace tfrt {
 
+// Reads the tensor at `index` of the BTF-file at `path` without copying its
+// data. The tensor points into a private memory mapping of the file, and is
+// shared with identical tensors through the ConstantStore.
+static AsyncValueRef<DenseHostTensor> ReadMappedTensorFromBTF(
+    std::string path, int32_t index, const ExecutionContext& exec_ctx) {
+  return EnqueueBlockingWork(
+      exec_ctx.host(), [path, index, exec_ctx]() -> Expected<DenseHostTensor> {
+        auto read = [&]() -> Expected<DenseHostTensor> {
+          auto& store = ConstantStore::Global();
+          auto file = store.MapBTFFile(path);
+          if (!file) return file.takeError();
+          auto offsets = ReadBTFOffsets(**file);
+          if (!offsets) return offsets.takeError();
+          if (index < 0 || static_cast<size_t>(index) >= offsets->size()) {
+            return MakeStringError("invalid tensor index ", index,
+                                   " to read tensor from path ", path,
+                                   " which contains ", offsets->size(),
+                                   " tensors");
+          }
+          auto tensor = ReadDHTFromBTF(*file, (*offsets)[index]);
+          if (!tensor) return tensor.takeError();
+          return store.GetOrInsert(std::move(*tensor));
+        };
+        auto result = read();
+        if (!result) {
+          auto diag = EmitError(exec_ctx, result.takeError());
+          return MakeStringError(diag.message());
+        }
+        return result;
+      });
+}
+
 //===----------------------------------------------------------------------===//
 // Registration
 //===----------------------------------------------------------------------===//
@@ -67,6 +100,8 @@ void RegisterBTFIOKernels(KernelRegistry* registry) {
   RegisterDenseTensorReaders<2>(registry);
   RegisterDenseTensorReaders<3>(registry);
   RegisterDenseTensorReaders<4>(registry);
+  registry->AddKernel("btf.read_mapped_dense_tensor",
+                      TFRT_KERNEL(ReadMappedTensorFromBTF));
 }
 
 }  // namespace tfrt
@@ -30,6 +30,7 @@
 #include "tfrt/host_context/chain.h"
 #include "tfrt/host_context/diagnostic.h"
 #include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/host_context/parallel_for.h"
 #include "tfrt/host_context/sync_kernel_utils.h"
 #include "tfrt/tensor/btf.h"
 #include "tfrt/tensor/dense_host_tensor_view.h"
@@ -276,6 +277,23 @@ static AsyncValueRef<Chain> CastForOutType(const DenseHostTensor& A,
   }
 }
 
+// Casts between f32 and the 16-bit floating point types with the bulk
+// conversions of tfrt/support, which use SIMD instructions.
+template <typename Tin, typename Tout>
+static AsyncValueRef<Chain> ConvertBufferCast(
+    const DenseHostTensor& A, DenseHostTensor* B,
+    const ExecutionContext& exec_ctx) {
+  const auto* src = static_cast<const Tin*>(A.data());
+  auto* dst = static_cast<Tout*>(B->data());
+  return ParallelFor(exec_ctx).Execute(
+      A.NumElements(),
+      ParallelFor::BlockSizes::Cost(sizeof(Tin), sizeof(Tout),
+                                    /*compute_cycles=*/1),
+      [src, dst, buffer = A.buffer().CopyRef()](size_t start, size_t end) {
+        ConvertBuffer(src + start, dst + start, end - start);
+      });
+}
+
 static void CastOp(const DenseHostTensor& A, const TensorMetadata& B_md,
                    RCReference<AsyncValue>* B_tensor,
                    const ExecutionContext& exec_ctx) {
@@ -290,16 +308,26 @@ static void CastOp(const DenseHostTensor& A, const TensorMetadata& B_md,
   *B_tensor = MakeUnconstructedAsyncValueRef<DenseHostTensor>().ReleaseRCRef();
 
   AsyncValueRef<Chain> chain;
-  switch (B_md.dtype) {
-    default:
-      *B_tensor = EmitErrorAsync(exec_ctx, "unsupported dtype for cast");
-      return;
+  if (A.dtype() == DType::F32 && B_md.dtype == DType::F16) {
+    chain = ConvertBufferCast<float, fp16>(A, dest.getPointer(), exec_ctx);
+  } else if (A.dtype() == DType::F16 && B_md.dtype == DType::F32) {
+    chain = ConvertBufferCast<fp16, float>(A, dest.getPointer(), exec_ctx);
+  } else if (A.dtype() == DType::F32 && B_md.dtype == DType::BF16) {
+    chain = ConvertBufferCast<float, bf16>(A, dest.getPointer(), exec_ctx);
+  } else if (A.dtype() == DType::BF16 && B_md.dtype == DType::F32) {
+    chain = ConvertBufferCast<bf16, float>(A, dest.getPointer(), exec_ctx);
+  } else {
+    switch (B_md.dtype) {
+      default:
+        *B_tensor = EmitErrorAsync(exec_ctx, "unsupported dtype for cast");
+        return;
 #define DTYPE_NUMERIC(ENUM)                                     \
   case DType::ENUM:                                             \
     chain = CastForOutType<EigenTypeForDTypeKind<DType::ENUM>>( \
         A, dest.getPointer(), exec_ctx);                        \
     break;
 #include "tfrt/dtype/dtype.def"
+    }
   }
 
   auto* chain_av = chain.GetAsyncValue();
@@ -33,38 +33,55 @@
 namespace tfrt {
 namespace {
 
-static Expected<DenseHostTensor> TfConcatOpDense(
+static AsyncValueRef<DenseHostTensor> TfConcatOpDense(
     RepeatedArguments<DenseHostTensor> args, int64_t axis,
     const TensorMetadata& output_md, const ExecutionContext& exec_ctx) {
   auto* host = exec_ctx.host();
+
+  // If at most one input has any elements, the output has the same layout as
+  // that input, and shares its buffer.
+  int num_non_empty = 0;
+  const DenseHostTensor* non_empty = &args[0];
+  for (auto& arg : args) {
+    if (arg.NumElements() == 0) continue;
+    ++num_non_empty;
+    non_empty = &arg;
+  }
+  if (num_non_empty <= 1 && non_empty->buffer()) {
+    return MakeAvailableAsyncValueRef<DenseHostTensor>(
+        output_md, non_empty->buffer().CopyRef());
+  }
+
   // Allocate output tensor.
   auto dest = DenseHostTensor::CreateUninitialized(output_md, host);
   if (!dest) {
-    return MakeStringError("out of memory allocating result");
+    return EmitErrorAsync(exec_ctx, "out of memory allocating result");
   }
 
   // Call concat kernel.
+  AsyncValueRef<Chain> chain;
   switch (args[0].dtype()) {
     default:
-      return MakeStringError("Unsupported dtype: ", args[0].dtype());
+      chain = EmitErrorAsync(exec_ctx,
+                             StrCat("Unsupported dtype: ", args[0].dtype()));
       break;
     case DType::I1: {
       using T = EigenTypeForDTypeKind<DType::I1>;
-      auto error = ::tfrt::cpu::ConcatKernel<T>(args, axis, dest.getPointer());
-      if (error) return std::move(error);
+      chain = ::tfrt::cpu::ConcatKernel<T>(args, axis, dest.getPointer(),
+                                           exec_ctx);
       break;
     }
-#define DTYPE_NUMERIC(ENUM)                                                   \
-  case DType::ENUM: {                                                         \
-    using T = EigenTypeForDTypeKind<DType::ENUM>;                             \
-    auto error = ::tfrt::cpu::ConcatKernel<T>(args, axis, dest.getPointer()); \
-    if (error) return std::move(error);                                       \
-    break;                                                                    \
+#define DTYPE_NUMERIC(ENUM)                                             \
+  case DType::ENUM: {                                                   \
+    using T = EigenTypeForDTypeKind<DType::ENUM>;                       \
+    chain = ::tfrt::cpu::ConcatKernel<T>(args, axis, dest.getPointer(), \
+                                         exec_ctx);                     \
+    break;                                                              \
   }
 #include "tfrt/dtype/dtype.def"  // NOLINT
   }
 
-  return std::move(*dest);
+  return ForwardValue(dest.getValue(), std::move(chain));
 }
 
 // TODO(tfrt-devs): The implemention below for the string type is synchronous.
@@ -168,7 +185,7 @@ static AsyncValueRef<HostTensor> TfConcatOp(
 
   if (llvm::isa<DenseHostTensor>(&args[0])) {
     RepeatedArguments<DenseHostTensor> dense_args(inputs.values().drop_back());
-    return make_async(TfConcatOpDense(dense_args, *axis, *output_md, exec_ctx));
+    return TfConcatOpDense(dense_args, *axis, *output_md, exec_ctx);
   }
 
   return EmitErrorAsync(
@@ -20,9 +20,12 @@
 #include "concat_op.h"
 #include "constant_ops.h"
 #include "cwise_binary_ops.h"
+#include "cwise_fusion_ops.h"
 #include "cwise_unary_ops.h"
+#include "embedding_ops.h"
 #include "matmul_fusion_ops.h"
 #include "matmul_ops.h"
+#include "quantized_ops.h"
 #include "shape_ops.h"
 #include "softmax_ops.h"
 #include "tfrt/common/compat/eigen/eigen_dtype.h"
@@ -264,11 +267,14 @@ void RegisterTfCpuOps(CpuOpRegistry* op_registry) {
   RegisterTfConstantCpuOps(op_registry);
   RegisterTfUnaryCpuOps(op_registry);
   RegisterTfBinaryCpuOps(op_registry);
+  RegisterTfCwiseFusionCpuOps(op_registry);
   RegisterTfShapeCpuOps(op_registry);
   RegisterTfSofmaxCpuOps(op_registry);
   RegisterTfMatmulFusionCpuOps(op_registry);
   RegisterTfMatmulCpuOps(op_registry);
   RegisterTfTileCpuOp(op_registry);
+  RegisterTfEmbeddingCpuOps(op_registry);
+  RegisterTfQuantizedCpuOps(op_registry);
 }
 
 }  // namespace tfrt
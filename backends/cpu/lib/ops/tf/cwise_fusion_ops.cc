@@ -0,0 +1,308 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tensorflow coefficient wise operations fusion.
+//
+// tf._FusedCwise applies a chain of coefficient wise operations, listed in the
+// `fused_ops` attribute, to its first operand in a single pass over memory.
+// Binary operations take their right operand from the remaining operands in
+// order, which must have the shape of the first operand or a single element.
+// The chain is evaluated in small blocks that stay in the cache between the
+// fused operations, so intermediate results are never materialized.
+//
+// The `fused_ops` list is compiled into a FusedCwiseProgram the first time it
+// is seen, and the program is cached by the op sequence signature, so repeated
+// executions of the same chain skip resolving the fused operations.
+
+#include "cwise_fusion_ops.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "../../kernels/cwise_binary_kernels.h"
+#include "../../kernels/cwise_unary_kernels.h"
+#include "buffer_forwarding.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "tfrt/common/compat/eigen/eigen_dtype.h"
+#include "tfrt/core_runtime/op_attrs.h"
+#include "tfrt/core_runtime/op_utils.h"
+#include "tfrt/cpu/core_runtime/cpu_op_registry.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/host_context/parallel_for.h"
+#include "tfrt/host_context/shared_context.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "type_dispatch.h"
+
+namespace tfrt {
+namespace {
+
+// Number of elements evaluated by all fused operations before moving to the
+// next block. Small enough for the block to stay in the L1 cache.
+constexpr size_t kFusionBlockSize = 1024;
+
+template <typename T>
+using ConstBlock = Eigen::TensorMap<const Eigen::Tensor<T, 1, Eigen::RowMajor>>;
+template <typename T>
+using MutableBlock = Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>>;
+
+// Compute a block of `size` elements of a fused operation from the `input`
+// block, and the `operand` block of binary operations, into `output`. Scalar
+// operands are broadcasted. `output` may alias `input`.
+template <typename T>
+using FusedBlockFn = void (*)(const T* input, const T* operand,
+                              bool scalar_operand, T* output, size_t size);
+
+template <typename T, typename UnaryFunctor>
+void UnaryBlock(const T* input, const T*, bool, T* output, size_t size) {
+  using F = typename UnaryFunctor::template Functor<T>::Functor;
+  MutableBlock<T>(output, size) = ConstBlock<T>(input, size).unaryExpr(F());
+}
+
+template <typename T>
+void ReluBlock(const T* input, const T*, bool, T* output, size_t size) {
+  MutableBlock<T>(output, size) =
+      ConstBlock<T>(input, size).cwiseMax(static_cast<T>(0));
+}
+
+template <typename T, typename BinaryFunctor>
+void BinaryBlock(const T* input, const T* operand, bool scalar_operand,
+                 T* output, size_t size) {
+  using F = typename BinaryFunctor::template Functor<T>::Functor;
+  ConstBlock<T> lhs(input, size);
+  MutableBlock<T> result(output, size);
+  if (scalar_operand) {
+    result = lhs.binaryExpr(lhs.constant(*operand), F());
+  } else {
+    result = lhs.binaryExpr(ConstBlock<T>(operand, size), F());
+  }
+}
+
+// Operations that can be fused into tf._FusedCwise, named as in `fused_ops`.
+template <typename T>
+struct FusibleOp {
+  string_view name;
+  FusedBlockFn<T> fn;
+  bool binary;
+};
+
+template <typename T>
+ArrayRef<FusibleOp<T>> GetFusibleOps() {
+  static const FusibleOp<T> ops[] = {
+      {"AddV2", BinaryBlock<T, cpu::functor::Add>, true},
+      {"Sub", BinaryBlock<T, cpu::functor::Sub>, true},
+      {"Mul", BinaryBlock<T, cpu::functor::Mul>, true},
+      {"RealDiv", BinaryBlock<T, cpu::functor::Div>, true},
+      {"Relu", ReluBlock<T>, false},
+      {"Exp", UnaryBlock<T, cpu::functor::Exp>, false},
+      {"Log", UnaryBlock<T, cpu::functor::Log>, false},
+      {"Log1p", UnaryBlock<T, cpu::functor::Log1p>, false},
+      {"Rsqrt", UnaryBlock<T, cpu::functor::Rsqrt>, false},
+      {"Sigmoid", UnaryBlock<T, cpu::functor::Sigmoid>, false},
+      {"Sqrt", UnaryBlock<T, cpu::functor::Sqrt>, false},
+      {"Tanh", UnaryBlock<T, cpu::functor::Tanh>, false},
+  };
+  return ops;
+}
+
+// A chain of fused operations resolved from its `fused_ops` attribute.
+template <typename T>
+struct FusedCwiseProgram {
+  llvm::SmallVector<const FusibleOp<T>*, 4> ops;
+  size_t num_operands = 0;
+};
+
+// Compiled fused operation chains, keyed by the op sequence signature (the
+// names of the fused operations joined with ','). Only valid programs are
+// cached.
+template <typename T>
+class FusedCwiseProgramCache : public SharedContext {
+ public:
+  explicit FusedCwiseProgramCache(HostContext* host) {}
+
+  Expected<const FusedCwiseProgram<T>*> GetOrCompile(
+      AggregateAttr fused_ops_attr) {
+    std::string signature;
+    for (int i = 0; i < fused_ops_attr.GetNumElements(); ++i) {
+      if (i > 0) signature += ',';
+      signature +=
+          fused_ops_attr.GetAttribute(i).cast<StringAttr>().GetValue().str();
+    }
+
+    mutex_lock lock(mu_);
+    auto it = programs_.find(signature);
+    if (it != programs_.end()) return it->second.get();
+
+    auto program = Compile(fused_ops_attr);
+    if (!program) return program.takeError();
+    auto& cached = programs_[signature];
+    cached = std::make_unique<FusedCwiseProgram<T>>(std::move(*program));
+    return cached.get();
+  }
+
+ private:
+  static Expected<FusedCwiseProgram<T>> Compile(AggregateAttr fused_ops_attr) {
+    FusedCwiseProgram<T> program;
+    auto ops = GetFusibleOps<T>();
+    for (int i = 0; i < fused_ops_attr.GetNumElements(); ++i) {
+      string_view name =
+          fused_ops_attr.GetAttribute(i).cast<StringAttr>().GetValue();
+      auto op = llvm::find_if(ops, [&](const FusibleOp<T>& fusible) {
+        return fusible.name == name;
+      });
+      if (op == ops.end())
+        return MakeStringError("Unsupported fused operation: ", name);
+      program.ops.push_back(op);
+      if (op->binary) ++program.num_operands;
+    }
+    if (program.ops.empty())
+      return MakeStringError("FusedCwise must specify fused operations");
+    return std::move(program);
+  }
+
+  mutex mu_;
+  llvm::StringMap<std::unique_ptr<FusedCwiseProgram<T>>> programs_
+      TFRT_GUARDED_BY(mu_);
+};
+
+// A fused operation bound to its operand.
+template <typename T>
+struct FusedStep {
+  FusedBlockFn<T> fn;
+  const T* operand = nullptr;
+  bool scalar_operand = false;
+};
+
+template <typename T>
+static AsyncValueRef<DenseHostTensor> FusedCwise(
+    Argument<DenseHostTensor> input,
+    RepeatedArguments<DenseHostTensor> fusion_inputs,
+    AggregateAttr fused_ops_attr, const TensorMetadata& output_md,
+    const ExecutionContext& exec_ctx) {
+  const size_t num_elements = input->NumElements();
+
+  auto& cache =
+      exec_ctx.host()->GetOrCreateSharedContext<FusedCwiseProgramCache<T>>();
+  auto program = cache.GetOrCompile(fused_ops_attr);
+  if (!program) return EmitErrorAsync(exec_ctx, program.takeError());
+  if ((*program)->num_operands > fusion_inputs.size())
+    return EmitErrorAsync(exec_ctx, "FusedCwise is missing operands");
+  if ((*program)->num_operands < fusion_inputs.size())
+    return EmitErrorAsync(exec_ctx, "FusedCwise has unused operands");
+
+  // Bind the fused operations to their operands.
+  llvm::SmallVector<FusedStep<T>, 4> steps;
+  llvm::SmallVector<RCReference<HostBuffer>, 4> buffers;
+  size_t num_operands = 0;
+  for (const FusibleOp<T>* op : (*program)->ops) {
+    FusedStep<T> step;
+    step.fn = op->fn;
+    if (op->binary) {
+      const DenseHostTensor& operand = fusion_inputs[num_operands++];
+      if (operand.dtype() != input->dtype())
+        return EmitErrorAsync(exec_ctx, StrCat("Operand of ", op->name,
+                                               " has incompatible dtype ",
+                                               operand.dtype()));
+      if (operand.NumElements() != 1 && operand.shape() != input->shape())
+        return EmitErrorAsync(exec_ctx, StrCat("Operand of ", op->name,
+                                               " has incompatible shape ",
+                                               operand.shape()));
+
+      step.operand = static_cast<const T*>(operand.data());
+      step.scalar_operand = operand.NumElements() == 1;
+      buffers.push_back(operand.buffer().CopyRef());
+    }
+    steps.push_back(step);
+  }
+
+  // Operands are read at the output position before it is written, so the
+  // input buffer can be forwarded to the output.
+  AsyncValueRef<DenseHostTensor> output =
+      ForwardInputOrAllocateOutput(exec_ctx, output_md, input);
+  if (output.IsError()) return output;
+
+  const T* input_data = static_cast<const T*>(input->data());
+  T* output_data = static_cast<T*>(output->data());
+  buffers.push_back(input->buffer().CopyRef());
+
+  auto compute = [steps, input_data, output_data](size_t begin, size_t end) {
+    for (size_t offset = begin; offset < end; offset += kFusionBlockSize) {
+      const size_t size = std::min(kFusionBlockSize, end - offset);
+      const T* block_input = input_data + offset;
+      for (const FusedStep<T>& step : steps) {
+        const T* operand =
+            step.scalar_operand ? step.operand : step.operand + offset;
+        step.fn(block_input, operand, step.scalar_operand,
+                output_data + offset, size);
+        block_input = output_data + offset;
+      }
+    }
+  };
+
+  auto on_done = [output = output.CopyRef(), buffers = std::move(buffers)]() {
+    output.SetStateConcrete();
+  };
+
+  // Each element is loaded from the input and the non scalar operands once, and
+  // stored to the output once.
+  double bytes_loaded = sizeof(T);
+  for (const FusedStep<T>& step : steps)
+    if (step.operand && !step.scalar_operand) bytes_loaded += sizeof(T);
+
+  ParallelFor(exec_ctx).Execute(
+      num_elements,
+      ParallelFor::BlockSizes::Cost(bytes_loaded, sizeof(T), steps.size()),
+      std::move(compute), std::move(on_done));
+
+  return output;
+}
+
+static AsyncValueRef<DenseHostTensor> TfFusedCwiseOp(
+    Argument<DenseHostTensor> input,
+    RepeatedArguments<DenseHostTensor> fusion_inputs, const OpAttrsRef& attrs,
+    const TensorMetadata& output_md, const ExecutionContext& exec_ctx) {
+  auto fused_ops_attr = attrs.GetAsserting<AggregateAttr>("fused_ops");
+
+  // Dispatch based on the input data type.
+  auto unsupported = [&](DType dtype) -> AsyncValueRef<DenseHostTensor> {
+    return EmitErrorAsync(exec_ctx, StrCat("Unsupported input dtype: ", dtype));
+  };
+
+  auto dispatch = [&](auto type_tag) -> AsyncValueRef<DenseHostTensor> {
+    using T = decltype(type_tag);
+    return FusedCwise<T>(input, fusion_inputs, fused_ops_attr, output_md,
+                         exec_ctx);
+  };
+
+  internal::TypeDispatch<float, double> type_dispatch(input->dtype());
+  return type_dispatch(dispatch, unsupported);
+}
+
+}  // namespace
+
+void RegisterTfCwiseFusionCpuOps(CpuOpRegistry* op_registry) {
+  op_registry->AddOp("tf._FusedCwise", TFRT_CPU_OP(TfFusedCwiseOp),
+                     CpuOpFlags::NoSideEffects, {"fused_ops"});
+}
+
+}  // namespace tfrt
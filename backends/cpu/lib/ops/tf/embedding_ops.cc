@@ -0,0 +1,151 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tensorflow embedding lookup operations.
+
+#include "embedding_ops.h"
+
+#include <cstdint>
+
+#include "../../kernels/embedding_kernel.h"
+#include "tfrt/core_runtime/op_attrs.h"
+#include "tfrt/core_runtime/op_utils.h"
+#include "tfrt/cpu/core_runtime/cpu_op_registry.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "tfrt/tensor/dense_host_tensor_view.h"
+
+namespace tfrt {
+namespace {
+
+static bool IsIndexDType(DType dtype) {
+  return dtype == DType::I32 || dtype == DType::I64;
+}
+
+// Returns `outer_dims` followed by all but the first dimension of `table`.
+static TensorShape RowsShape(ArrayRef<Index> outer_dims,
+                             const TensorShape& table) {
+  llvm::SmallVector<Index, 4> dims(outer_dims.begin(), outer_dims.end());
+  for (int d = 1; d < table.GetRank(); ++d)
+    dims.push_back(table.GetDimensionSize(d));
+  return TensorShape(dims);
+}
+
+//===----------------------------------------------------------------------===//
+// tf.GatherV2 op
+//===----------------------------------------------------------------------===//
+
+static AsyncValueRef<DenseHostTensor> TfGatherV2Op(
+    const DenseHostTensor& params, const DenseHostTensor& indices,
+    const DenseHostTensor& axis, const OpAttrsRef& attrs,
+    const ExecutionContext& exec_ctx) {
+  // Only gathers of the rows of a table are supported, which is how embedding
+  // lookups use tf.GatherV2.
+  if (axis.NumElements() != 1 || !IsIndexDType(axis.dtype()))
+    return EmitErrorAsync(exec_ctx, "tf.GatherV2 axis must be an int scalar");
+  int64_t axis_value = axis.dtype() == DType::I32
+                           ? DHTArrayView<int32_t>(&axis).Elements()[0]
+                           : DHTArrayView<int64_t>(&axis).Elements()[0];
+  if (params.shape().GetRank() == 0 ||
+      (axis_value != 0 && axis_value != -params.shape().GetRank()))
+    return EmitErrorAsync(exec_ctx,
+                          "tf.GatherV2 only supports gathers along axis 0");
+  if (auto batch_dims = attrs.GetOptional<int64_t>("batch_dims")) {
+    if (*batch_dims != 0)
+      return EmitErrorAsync(exec_ctx,
+                            "tf.GatherV2 does not support batch_dims");
+  }
+  if (!IsIndexDType(indices.dtype()))
+    return EmitErrorAsync(exec_ctx, "tf.GatherV2 indices must be int32/int64");
+
+  llvm::SmallVector<Index, 4> indices_dims(indices.shape().GetRank());
+  indices.shape().GetDimensions(indices_dims);
+  TensorMetadata output_md(params.dtype(),
+                           RowsShape(indices_dims, params.shape()));
+
+  auto output =
+      DenseHostTensor::CreateUninitialized(output_md, exec_ctx.host());
+  if (!output) {
+    return EmitErrorAsync(exec_ctx, "out of memory allocating result");
+  }
+
+  auto chain = cpu::Gather(params, indices, output.getPointer(), exec_ctx);
+  return ForwardValue(output.getValue(), std::move(chain));
+}
+
+//===----------------------------------------------------------------------===//
+// tf.SparseSegmentSum, tf.SparseSegmentMean and tf.SparseSegmentSqrtN ops
+//===----------------------------------------------------------------------===//
+
+template <cpu::SegmentReduction reduction>
+static AsyncValueRef<DenseHostTensor> TfSparseSegmentReduceOp(
+    const DenseHostTensor& data, const DenseHostTensor& indices,
+    const DenseHostTensor& segment_ids, const ExecutionContext& exec_ctx) {
+  if (data.shape().GetRank() == 0)
+    return EmitErrorAsync(exec_ctx, "data must be at least a vector");
+  if (!cpu::IsSegmentReductionSupported(data.dtype()))
+    return EmitErrorAsync(exec_ctx,
+                          StrCat("Unsupported data dtype: ", data.dtype()));
+  if (!IsIndexDType(indices.dtype()) || !IsIndexDType(segment_ids.dtype()))
+    return EmitErrorAsync(exec_ctx,
+                          "indices and segment_ids must be int32/int64");
+  if (indices.shape().GetRank() != 1 ||
+      segment_ids.shape() != indices.shape())
+    return EmitErrorAsync(
+        exec_ctx, "indices and segment_ids must be vectors of the same size");
+
+  auto num_segments = cpu::NumSegments(segment_ids);
+  if (!num_segments)
+    return EmitErrorAsync(exec_ctx, num_segments.takeError());
+
+  TensorMetadata output_md(data.dtype(),
+                           RowsShape({*num_segments}, data.shape()));
+
+  auto output =
+      DenseHostTensor::CreateUninitialized(output_md, exec_ctx.host());
+  if (!output) {
+    return EmitErrorAsync(exec_ctx, "out of memory allocating result");
+  }
+
+  auto chain = cpu::SparseSegmentReduce(data, indices, segment_ids, reduction,
+                                        output.getPointer(), exec_ctx);
+  return ForwardValue(output.getValue(), std::move(chain));
+}
+
+}  // namespace
+
+void RegisterTfEmbeddingCpuOps(CpuOpRegistry* op_registry) {
+  op_registry->AddOp("tf.GatherV2", TFRT_CPU_OP(TfGatherV2Op),
+                     CpuOpFlags::NoSideEffects, {"batch_dims"});
+  op_registry->AddOp(
+      "tf.SparseSegmentSum",
+      TFRT_CPU_OP(TfSparseSegmentReduceOp<cpu::SegmentReduction::kSum>),
+      CpuOpFlags::NoSideEffects);
+  op_registry->AddOp(
+      "tf.SparseSegmentMean",
+      TFRT_CPU_OP(TfSparseSegmentReduceOp<cpu::SegmentReduction::kMean>),
+      CpuOpFlags::NoSideEffects);
+  op_registry->AddOp(
+      "tf.SparseSegmentSqrtN",
+      TFRT_CPU_OP(TfSparseSegmentReduceOp<cpu::SegmentReduction::kSqrtN>),
+      CpuOpFlags::NoSideEffects);
+}
+
+}  // namespace tfrt
@@ -22,6 +22,7 @@
 #include <complex>
 #include <initializer_list>
 
+#include "../../kernels/batch_matmul_kernel.h"
 #include "../../kernels/matmul_kernel.h"
 #include "tfrt/common/compat/eigen/eigen_evaluator.h"
 #include "tfrt/core_runtime/op_attrs.h"
@@ -70,11 +71,42 @@ static AsyncValueRef<DenseHostTensor> TfMatMulOp(
   return ForwardValue(output.getValue(), type_dispatch(dispatch, unsupported));
 }
 
+static AsyncValueRef<DenseHostTensor> TfBatchMatMulOp(
+    const DenseHostTensor& a, const DenseHostTensor& b, const OpAttrsRef& attrs,
+    const TensorMetadata& output_md, const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+
+  auto output = DenseHostTensor::CreateUninitialized(output_md, host);
+  if (!output) {
+    return EmitErrorAsync(exec_ctx, "out of memory allocating result");
+  }
+
+  // Adjoint of a real matrix is its transpose.
+  bool adj_x = attrs.GetAsserting<bool>("adj_x");
+  bool adj_y = attrs.GetAsserting<bool>("adj_y");
+
+  // Dispatch based on the input data type.
+  auto unsupported = [&](DType dtype) -> AsyncValueRef<Chain> {
+    return EmitErrorAsync(exec_ctx, StrCat("Unsupported input dtype: ", dtype));
+  };
+
+  auto dispatch = [&](auto type_tag) -> AsyncValueRef<Chain> {
+    using T = decltype(type_tag);
+    return cpu::BatchMatMul<T>(a, b, &*output, adj_x, adj_y, exec_ctx);
+  };
+
+  internal::TypeDispatch<float, double, int32_t, int64_t> type_dispatch(
+      a.dtype());
+  return ForwardValue(output.getValue(), type_dispatch(dispatch, unsupported));
+}
+
 }  // namespace
 
 void RegisterTfMatmulCpuOps(CpuOpRegistry* op_registry) {
   op_registry->AddOp("tf.MatMul", TFRT_CPU_OP(TfMatMulOp),
                      CpuOpFlags::NoSideEffects, {"transpose_a", "transpose_b"});
+  op_registry->AddOp("tf.BatchMatMulV2", TFRT_CPU_OP(TfBatchMatMulOp),
+                     CpuOpFlags::NoSideEffects, {"adj_x", "adj_y"});
 }
 
 }  // namespace tfrt
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tensorflow quantized MatMul and Conv2D operations.
+//
+// The quantization of the operands is given by their real ranges, as in the
+// Tensorflow MKL kernels: an 8-bit tensor with range [min, max] is quantized
+// with scale max(|min|, |max|) / 127 (or / 255 if unsigned) and zero point 0
+// in the SCALED mode. In the MIN_FIRST mode, which only applies to the MatMul
+// A operand, min is mapped to the lowest quantized value. Filters are always
+// SCALED, with one range per output channel or a single range.
+
+#include "quantized_ops.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "../../kernels/quantized_matmul_kernel.h"
+#include "tfrt/core_runtime/op_attrs.h"
+#include "tfrt/core_runtime/op_utils.h"
+#include "tfrt/cpu/core_runtime/cpu_op_registry.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace {
+
+using Results = std::array<AsyncValueRef<DenseHostTensor>, 3>;
+
+static bool IsUnsigned(DType dtype) {
+  return dtype == DType::UI8 || dtype == DType::QUI8;
+}
+
+// Returns the largest quantized value of an 8-bit `dtype`.
+static float MaxQuantized(DType dtype) { return IsUnsigned(dtype) ? 255 : 127; }
+
+static float ScaleOf(float min, float max, DType dtype) {
+  float scale = std::max(std::abs(min), std::abs(max)) / MaxQuantized(dtype);
+  return scale > 0 ? scale : 1.0f;
+}
+
+// Returns the values of the F32 `tensor`.
+static Expected<llvm::SmallVector<float, 1>> GetValues(
+    const DenseHostTensor& tensor, string_view name) {
+  if (tensor.dtype() != DType::F32)
+    return MakeStringError(name, " must be a f32 tensor");
+  const float* data = static_cast<const float*>(tensor.data());
+  return llvm::SmallVector<float, 1>(data, data + tensor.NumElements());
+}
+
+static Expected<float> GetScalar(const DenseHostTensor& tensor,
+                                 string_view name) {
+  auto values = GetValues(tensor, name);
+  if (!values) return values.takeError();
+  if (values->size() != 1) return MakeStringError(name, " must be a scalar");
+  return values->front();
+}
+
+// Returns the dtype of a quantized output `attr`, or `default_dtype` if the
+// attribute is not set.
+static DType GetOutputDType(const OpAttrsRef& attrs, string_view attr,
+                            DType default_dtype) {
+  OpAttrType type;
+  if (!attrs.Get(attr, &type)) return default_dtype;
+  switch (type) {
+    case OpAttrType::UNSUPPORTED_QI8:
+      return DType::QI8;
+    case OpAttrType::UNSUPPORTED_QUI8:
+      return DType::QUI8;
+    default:
+      return DType::Invalid;
+  }
+}
+
+// Computes the quantization of the lhs, the rhs and the bias of a contraction
+// with `n` output channels from the ranges of the operands.
+static Expected<cpu::QuantizedContractionParams> GetContractionParams(
+    const DenseHostTensor& lhs, const DenseHostTensor& bias,
+    const DenseHostTensor& min_lhs, const DenseHostTensor& max_lhs,
+    const DenseHostTensor& min_rhs, const DenseHostTensor& max_rhs,
+    bool min_first, Index n) {
+  cpu::QuantizedContractionParams params;
+
+  TFRT_ASSIGN_OR_RETURN(float min_lhs_value, GetScalar(min_lhs, "input min"));
+  TFRT_ASSIGN_OR_RETURN(float max_lhs_value, GetScalar(max_lhs, "input max"));
+  if (min_first) {
+    const float range = max_lhs_value - min_lhs_value;
+    params.lhs_scale = range > 0 ? range / 255 : 1.0f;
+    const int32_t lowest = IsUnsigned(lhs.dtype()) ? 0 : -128;
+    params.lhs_zero_point =
+        lowest + std::lround(-min_lhs_value / params.lhs_scale);
+  } else {
+    params.lhs_scale = ScaleOf(min_lhs_value, max_lhs_value, lhs.dtype());
+  }
+
+  TFRT_ASSIGN_OR_RETURN(auto min_rhs_values, GetValues(min_rhs, "filter min"));
+  TFRT_ASSIGN_OR_RETURN(auto max_rhs_values, GetValues(max_rhs, "filter max"));
+  if (min_rhs_values.size() != max_rhs_values.size() ||
+      (min_rhs_values.size() != 1 &&
+       min_rhs_values.size() != static_cast<size_t>(n)))
+    return MakeStringError("filter ranges must be scalars or have ", n,
+                           " elements");
+  for (size_t i = 0; i < min_rhs_values.size(); ++i) {
+    params.rhs_scales.push_back(
+        ScaleOf(min_rhs_values[i], max_rhs_values[i], DType::I8));
+  }
+
+  if (bias.NumElements() != n)
+    return MakeStringError("bias must have ", n, " elements");
+  params.bias.resize(n);
+  if (bias.dtype() == DType::F32) {
+    const float* data = static_cast<const float*>(bias.data());
+    std::copy(data, data + n, params.bias.begin());
+  } else if (bias.dtype() == DType::I32 || bias.dtype() == DType::QI32) {
+    // Integer bias is quantized like the int32 accumulators.
+    const int32_t* data = static_cast<const int32_t*>(bias.data());
+    for (Index j = 0; j < n; ++j) {
+      const float rhs_scale = params.rhs_scales.size() == 1
+                                  ? params.rhs_scales[0]
+                                  : params.rhs_scales[j];
+      params.bias[j] = data[j] * params.lhs_scale * rhs_scale;
+    }
+  } else {
+    return MakeStringError("Unsupported bias dtype: ", bias.dtype());
+  }
+  return params;
+}
+
+static Error SetOutputRange(const DenseHostTensor& min_output,
+                            const DenseHostTensor& max_output, DType dtype,
+                            cpu::QuantizedContractionParams* params) {
+  TFRT_ASSIGN_OR_RETURN(float min, GetScalar(min_output, "output min"));
+  TFRT_ASSIGN_OR_RETURN(float max, GetScalar(max_output, "output max"));
+  params->output_scale = ScaleOf(min, max, dtype);
+  return Error::success();
+}
+
+// Returns the results of the *AndRequantize ops: the output and its range,
+// which is the frozen output range.
+static Results RequantizeResults(AsyncValueRef<DenseHostTensor> output,
+                                 const DenseHostTensor& min_output,
+                                 const DenseHostTensor& max_output) {
+  if (output.IsError())
+    return {output.CopyRef(), output.CopyRef(), std::move(output)};
+  return {std::move(output),
+          MakeAvailableAsyncValueRef<DenseHostTensor>(min_output.CopyRef()),
+          MakeAvailableAsyncValueRef<DenseHostTensor>(max_output.CopyRef())};
+}
+
+//===----------------------------------------------------------------------===//
+// tf.QuantizedMatMulWithBiasAndRequantize and
+// tf.QuantizedMatMulWithBiasAndDequantize ops
+//===----------------------------------------------------------------------===//
+
+static AsyncValueRef<DenseHostTensor> QuantizedMatMul(
+    const DenseHostTensor& a, const DenseHostTensor& b,
+    const DenseHostTensor& bias, const DenseHostTensor& min_a,
+    const DenseHostTensor& max_a, const DenseHostTensor& min_b,
+    const DenseHostTensor& max_b, const DenseHostTensor& min_output,
+    const DenseHostTensor& max_output, const OpAttrsRef& attrs,
+    DType output_dtype, const ExecutionContext& exec_ctx) {
+  if (!cpu::IsQuantizedContractionSupported(a.dtype(), b.dtype()))
+    return EmitErrorAsync(exec_ctx, StrCat("Unsupported input dtypes: ",
+                                           a.dtype(), " and ", b.dtype()));
+  if (!cpu::IsQuantizedOutputSupported(output_dtype))
+    return EmitErrorAsync(exec_ctx,
+                          StrCat("Unsupported output dtype: ", output_dtype));
+  if (a.shape().GetRank() != 2 || b.shape().GetRank() != 2)
+    return EmitErrorAsync(exec_ctx, "a and b must be matrices");
+
+  bool transpose_a = false;
+  bool transpose_b = false;
+  attrs.Get("transpose_a", &transpose_a);
+  attrs.Get("transpose_b", &transpose_b);
+  auto mode = attrs.GetStringOptional("input_quant_mode");
+  if (mode && *mode != "MIN_FIRST" && *mode != "SCALED")
+    return EmitErrorAsync(exec_ctx,
+                          StrCat("Unsupported input_quant_mode: ", *mode));
+  const bool min_first = !mode || *mode == "MIN_FIRST";
+
+  const Index m = a.shape().GetDimensionSize(transpose_a ? 1 : 0);
+  const Index n = b.shape().GetDimensionSize(transpose_b ? 0 : 1);
+
+  auto params = GetContractionParams(a, bias, min_a, max_a, min_b, max_b,
+                                     min_first, n);
+  if (!params) return EmitErrorAsync(exec_ctx, params.takeError());
+  if (output_dtype != DType::F32) {
+    if (auto error =
+            SetOutputRange(min_output, max_output, output_dtype, &*params))
+      return EmitErrorAsync(exec_ctx, std::move(error));
+  }
+
+  auto output = DenseHostTensor::CreateUninitialized(
+      TensorMetadata(output_dtype, {m, n}), exec_ctx.host());
+  if (!output) {
+    return EmitErrorAsync(exec_ctx, "out of memory allocating result");
+  }
+
+  auto chain = cpu::QuantizedMatMul(a, b, transpose_a, transpose_b, *params,
+                                    output.getPointer(), exec_ctx);
+  return ForwardValue(output.getValue(), std::move(chain));
+}
+
+static Results TfQuantizedMatMulWithBiasAndRequantizeOp(
+    const DenseHostTensor& a, const DenseHostTensor& b,
+    const DenseHostTensor& bias, const DenseHostTensor& min_a,
+    const DenseHostTensor& max_a, const DenseHostTensor& min_b,
+    const DenseHostTensor& max_b, const DenseHostTensor& min_output,
+    const DenseHostTensor& max_output, const OpAttrsRef& attrs,
+    const ExecutionContext& exec_ctx) {
+  DType output_dtype = GetOutputDType(attrs, "Toutput", DType::QUI8);
+  auto output =
+      QuantizedMatMul(a, b, bias, min_a, max_a, min_b, max_b, min_output,
+                      max_output, attrs, output_dtype, exec_ctx);
+  return RequantizeResults(std::move(output), min_output, max_output);
+}
+
+static AsyncValueRef<DenseHostTensor> TfQuantizedMatMulWithBiasAndDequantizeOp(
+    const DenseHostTensor& a, const DenseHostTensor& b,
+    const DenseHostTensor& bias, const DenseHostTensor& min_a,
+    const DenseHostTensor& max_a, const DenseHostTensor& min_b,
+    const DenseHostTensor& max_b, const DenseHostTensor& min_output,
+    const DenseHostTensor& max_output, const OpAttrsRef& attrs,
+    const ExecutionContext& exec_ctx) {
+  return QuantizedMatMul(a, b, bias, min_a, max_a, min_b, max_b, min_output,
+                         max_output, attrs, DType::F32, exec_ctx);
+}
+
+//===----------------------------------------------------------------------===//
+// tf.QuantizedConv2DWithBiasAndRequantize op
+//===----------------------------------------------------------------------===//
+
+static Results TfQuantizedConv2DWithBiasAndRequantizeOp(
+    const DenseHostTensor& input, const DenseHostTensor& filter,
+    const DenseHostTensor& bias, const DenseHostTensor& min_input,
+    const DenseHostTensor& max_input, const DenseHostTensor& min_filter,
+    const DenseHostTensor& max_filter, const DenseHostTensor& min_output,
+    const DenseHostTensor& max_output, const OpAttrsRef& attrs,
+    const ExecutionContext& exec_ctx) {
+  auto error = [&](string_view message) {
+    return RequantizeResults(EmitErrorAsync(exec_ctx, message), min_output,
+                             max_output);
+  };
+
+  DType output_dtype = GetOutputDType(attrs, "out_type", DType::QI8);
+  if (!cpu::IsQuantizedContractionSupported(input.dtype(), filter.dtype()))
+    return error(StrCat("Unsupported input dtypes: ", input.dtype(), " and ",
+                        filter.dtype()));
+  if (output_dtype != DType::QI8 && output_dtype != DType::QUI8)
+    return error(StrCat("Unsupported output dtype: ", output_dtype));
+
+  auto padding = attrs.GetStringAsserting("padding");
+  auto strides = attrs.GetArrayOptional<Index>("strides");
+  auto dilations = attrs.GetArrayOptional<Index>("dilations");
+  if (strides.size() != 4 || strides[0] != 1 || strides[3] != 1)
+    return error("strides must be [1, stride_h, stride_w, 1]");
+  if (llvm::any_of(dilations, [](Index d) { return d != 1; }))
+    return error("dilated convolutions are not supported");
+  if (!attrs.GetArrayOptional<int>("padding_list").empty())
+    return error("explicit padding is not supported");
+
+  std::array<Index, 2> spatial_strides{strides[1], strides[2]};
+  auto output_shape = cpu::QuantizedConv2DOutputShape(
+      input.shape(), filter.shape(), spatial_strides, padding);
+  if (!output_shape) return error(StrCat(output_shape.takeError()));
+
+  auto params = GetContractionParams(
+      input, bias, min_input, max_input, min_filter, max_filter,
+      /*min_first=*/false, filter.shape().GetDimensionSize(3));
+  if (!params) return error(StrCat(params.takeError()));
+  if (auto err = SetOutputRange(min_output, max_output, output_dtype, &*params))
+    return error(StrCat(err));
+
+  auto output = DenseHostTensor::CreateUninitialized(
+      TensorMetadata(output_dtype, *output_shape), exec_ctx.host());
+  if (!output) return error("out of memory allocating result");
+
+  auto chain = cpu::QuantizedConv2D(input, filter, spatial_strides, padding,
+                                    *params, output.getPointer(), exec_ctx);
+  return RequantizeResults(ForwardValue(output.getValue(), std::move(chain)),
+                           min_output, max_output);
+}
+
+}  // namespace
+
+void RegisterTfQuantizedCpuOps(CpuOpRegistry* op_registry) {
+  op_registry->AddOp("tf.QuantizedMatMulWithBiasAndRequantize",
+                     TFRT_CPU_OP(TfQuantizedMatMulWithBiasAndRequantizeOp),
+                     CpuOpFlags::NoSideEffects,
+                     {"Toutput", "transpose_a", "transpose_b",
+                      "input_quant_mode"});
+  op_registry->AddOp("tf.QuantizedMatMulWithBiasAndDequantize",
+                     TFRT_CPU_OP(TfQuantizedMatMulWithBiasAndDequantizeOp),
+                     CpuOpFlags::NoSideEffects,
+                     {"transpose_a", "transpose_b", "input_quant_mode"});
+  op_registry->AddOp("tf.QuantizedConv2DWithBiasAndRequantize",
+                     TFRT_CPU_OP(TfQuantizedConv2DWithBiasAndRequantizeOp),
+                     CpuOpFlags::NoSideEffects,
+                     {"out_type", "padding", "strides", "dilations",
+                      "padding_list"});
+}
+
+}  // namespace tfrt
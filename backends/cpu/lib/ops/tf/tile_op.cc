@@ -76,6 +76,13 @@ static AsyncValueRef<HostTensor> TfTileOp(const HostTensor& input_arg,
     // Call tile kernel.
     AsyncValueRef<Chain> chain;
 
+    if (cpu::IsTileByCopyPreferred(input.dtype(), input_shape,
+                                   *expected_multiples)) {
+      chain = cpu::TileByCopy(input, *expected_multiples, dest.getPointer(),
+                              exec_ctx);
+      return ForwardValue(dest.getValue(), std::move(chain));
+    }
+
     switch (input.dtype()) {
       default:
         chain = EmitErrorAsync(exec_ctx,
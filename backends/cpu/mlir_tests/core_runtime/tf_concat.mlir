@@ -126,3 +126,48 @@ func.func @concat_string() -> !tfrt.chain {
 
   tfrt.return %ch_print_cpu : !tfrt.chain
 }
+
+// CHECK: --- Running 'concat_f32_axis_0'
+func.func @concat_f32_axis_0() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %operand_0 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1, 3], values = [1.0 : f32, 2.0 : f32, 3.0 : f32] } : 1
+  %operand_1 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 3], values = [4.0 : f32, 5.0 : f32, 6.0 : f32, 7.0 : f32, 8.0 : f32, 9.0 : f32] } : 1
+
+  %axis = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1], values = [0 : i32] } : 1
+
+  %cpu_handle_result = corert.executeop(%cpu) "tf.ConcatV2"(%operand_0, %operand_1, %axis)
+    { N = 2 : i64 }: 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [3, 3]
+  // CHECK-SAME: values = [1.000000e+00, 2.000000e+00, 3.000000e+00, 4.000000e+00, 5.000000e+00, 6.000000e+00,
+  // CHECK-SAME:           7.000000e+00, 8.000000e+00, 9.000000e+00]
+  %ch_print_cpu = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
+
+// CHECK: --- Running 'concat_f32_single_input'
+func.func @concat_f32_single_input() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %operand_0 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 2], values = [1.0 : f32, 2.0 : f32, 3.0 : f32, 4.0 : f32] } : 1
+
+  %axis = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1], values = [1 : i32] } : 1
+
+  %cpu_handle_result = corert.executeop(%cpu) "tf.ConcatV2"(%operand_0, %axis)
+    { N = 1 : i64 }: 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 2]
+  // CHECK-SAME: values = [1.000000e+00, 2.000000e+00, 3.000000e+00, 4.000000e+00]
+  %ch_print_cpu = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
@@ -88,3 +88,22 @@ func.func @conv2d_same_strides() -> !tfrt.chain {
   %ch_print_cpu = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%conv2d_th) : 0
   tfrt.return %ch_print_cpu : !tfrt.chain
 }
+
+// 3x3 stride 1 convolution with 16 channels uses Winograd F(2x2, 3x3). The
+// 5x5 output ends with partial tiles.
+// CHECK: --- Running 'conv2d_same_winograd'
+func.func @conv2d_same_winograd() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %conv2d_in_th1 = corert.executeop(%cpu) "tf.Const"()
+      { dtype = f32, value = dense<1.0> : tensor<1x5x5x16xf32> } : 1
+  %conv2d_in_th2 = corert.executeop(%cpu) "tf.Const"()
+      { dtype = f32, value = dense<1.0> : tensor<3x3x16x16xf32> } : 1
+  %conv2d_th = corert.executeop(%cpu) "tf.Conv2D"(%conv2d_in_th1, %conv2d_in_th2)
+    { T = f32, data_format = "NHWC",  dilations = [1, 1, 1, 1], explicit_paddings = [], padding = "SAME", strides = [1, 1, 1, 1], use_cudnn_on_gpu = false }  : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [1, 5, 5, 16], values = [6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 6.400000e+01, 9.600000e+01
+  %ch_print_cpu = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%conv2d_th) : 0
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
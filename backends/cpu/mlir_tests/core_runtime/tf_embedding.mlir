@@ -0,0 +1,109 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: bef_executor --test_init_function=register_op_handlers_cpu %s.bef | FileCheck %s
+
+func.func @register_op_handlers_cpu() {
+  %null = "corert.create_null_op_handler"() : () -> !corert.ophandler
+  %cpu = "corert.create_cpu_op_handler"(%null) : (!corert.ophandler) -> !corert.ophandler
+  corert.register_op_handler %cpu "cpu"
+  tfrt.return
+}
+
+// CHECK: --- Running 'gather_f32'
+func.func @gather_f32() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %params = corert.const_dense_tensor dense<[[0.0, 1.0], [2.0, 3.0], [4.0, 5.0], [6.0, 7.0]]> : tensor<4x2xf32>
+  %indices = corert.const_dense_tensor dense<[[3, 0], [3, 1]]> : tensor<2x2xi32>
+  %axis = corert.const_dense_tensor dense<0> : tensor<i32>
+
+  %result = corert.executeop(%cpu) "tf.GatherV2"(%params, %indices, %axis) : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 2, 2]
+  // CHECK-SAME: values = [6.000000e+00, 7.000000e+00, 0.000000e+00, 1.000000e+00, 6.000000e+00, 7.000000e+00, 2.000000e+00, 3.000000e+00]
+  %ch_print = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%result) : 0
+
+  tfrt.return %ch_print : !tfrt.chain
+}
+
+// CHECK: --- Running 'gather_i8'
+func.func @gather_i8() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %params = corert.const_dense_tensor dense<[[1, 2, 3], [4, 5, 6]]> : tensor<2x3xi8>
+  %indices = corert.const_dense_tensor dense<[1, 1, 0]> : tensor<3xi64>
+  %axis = corert.const_dense_tensor dense<0> : tensor<i64>
+
+  %result = corert.executeop(%cpu) "tf.GatherV2"(%params, %indices, %axis) : 1
+
+  // CHECK: DenseHostTensor dtype = i8, shape = [3, 3]
+  // CHECK-SAME: values = [4, 5, 6, 4, 5, 6, 1, 2, 3]
+  %ch_print = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%result) : 0
+
+  tfrt.return %ch_print : !tfrt.chain
+}
+
+// CHECK: --- Running 'gather_out_of_range'
+func.func @gather_out_of_range() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %params = corert.const_dense_tensor dense<[[0.0, 1.0], [2.0, 3.0]]> : tensor<2x2xf32>
+  %indices = corert.const_dense_tensor dense<[0, 2]> : tensor<2xi32>
+  %axis = corert.const_dense_tensor dense<0> : tensor<i32>
+
+  // expected-error @+1 {{runtime error: indices[1] = 2 is not in [0, 2)}}
+  %result = corert.executeop(%cpu) "tf.GatherV2"(%params, %indices, %axis) : 1
+
+  tfrt.return %ch_epoch : !tfrt.chain
+}
+
+// CHECK: --- Running 'sparse_segment_sum_f32'
+func.func @sparse_segment_sum_f32() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %data = corert.const_dense_tensor dense<[[0.0, 1.0], [2.0, 3.0], [4.0, 5.0], [6.0, 7.0]]> : tensor<4x2xf32>
+  %indices = corert.const_dense_tensor dense<[0, 1, 2, 3]> : tensor<4xi32>
+  %segment_ids = corert.const_dense_tensor dense<[0, 0, 2, 2]> : tensor<4xi32>
+
+  %result = corert.executeop(%cpu) "tf.SparseSegmentSum"(%data, %indices, %segment_ids) : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [3, 2]
+  // CHECK-SAME: values = [2.000000e+00, 4.000000e+00, 0.000000e+00, 0.000000e+00, 1.000000e+01, 1.200000e+01]
+  %ch_print = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%result) : 0
+
+  tfrt.return %ch_print : !tfrt.chain
+}
+
+// CHECK: --- Running 'sparse_segment_mean_f32'
+func.func @sparse_segment_mean_f32() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %data = corert.const_dense_tensor dense<[[0.0, 1.0], [2.0, 3.0], [4.0, 5.0], [6.0, 7.0]]> : tensor<4x2xf32>
+  %indices = corert.const_dense_tensor dense<[3, 1, 0, 2]> : tensor<4xi64>
+  %segment_ids = corert.const_dense_tensor dense<[0, 0, 1, 1]> : tensor<4xi64>
+
+  %result = corert.executeop(%cpu) "tf.SparseSegmentMean"(%data, %indices, %segment_ids) : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 2]
+  // CHECK-SAME: values = [4.000000e+00, 5.000000e+00, 2.000000e+00, 3.000000e+00]
+  %ch_print = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%result) : 0
+
+  tfrt.return %ch_print : !tfrt.chain
+}
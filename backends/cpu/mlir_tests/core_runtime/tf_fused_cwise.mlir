@@ -0,0 +1,96 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: bef_executor --test_init_function=register_op_handlers_cpu %s.bef | FileCheck %s
+
+func.func @register_op_handlers_cpu() {
+  %null = "corert.create_null_op_handler"() : () -> !corert.ophandler
+  %cpu = "corert.create_cpu_op_handler"(%null) : (!corert.ophandler) -> !corert.ophandler
+  corert.register_op_handler %cpu "cpu"
+  tfrt.return
+}
+
+// CHECK: --- Running 'fusedCwise_add_relu_mul_f32'
+func.func @fusedCwise_add_relu_mul_f32() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %operand_0 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 3], values = [-1.0 : f32, -0.5 : f32, 0.0 : f32, 0.5 : f32, 1.0 : f32, 1.5 : f32] } : 1
+  %operand_1 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 3], values = [0.0 : f32, 1.0 : f32, 2.0 : f32, -3.0 : f32, 4.0 : f32, 5.0 : f32] } : 1
+  %operand_2 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [], values = [2.0 : f32] } : 1
+
+  %cpu_handle_result = corert.executeop(%cpu)
+      "tf._FusedCwise"(%operand_0, %operand_1, %operand_2)
+      { fused_ops = ["AddV2", "Relu", "Mul"] } : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 3]
+  // CHECK-SAME: values = [0.000000e+00, 1.000000e+00, 4.000000e+00, 0.000000e+00, 1.000000e+01, 1.300000e+01]
+  %ch_print_cpu = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
+
+// CHECK: --- Running 'fusedCwise_relu_div_broadcast_f32'
+func.func @fusedCwise_relu_div_broadcast_f32() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %operand_0 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [4], values = [-2.0 : f32, 1.0 : f32, 4.0 : f32, 16.0 : f32] } : 1
+  %operand_1 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [], values = [4.0 : f32] } : 1
+  %operand_2 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [4], values = [1.0 : f32, 1.0 : f32, 2.0 : f32, 3.0 : f32] } : 1
+
+  %cpu_handle_result = corert.executeop(%cpu)
+      "tf._FusedCwise"(%operand_0, %operand_1, %operand_2)
+      { fused_ops = ["Relu", "RealDiv", "Sub"] } : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [4]
+  // CHECK-SAME: values = [-1.000000e+00, -7.500000e-01, -1.000000e+00, 1.000000e+00]
+  %ch_print_cpu = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
+
+// CHECK: --- Running 'fusedCwise_sqrt_mul_tanh_cached_f32'
+func.func @fusedCwise_sqrt_mul_tanh_cached_f32() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %operand_0 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [4], values = [0.0 : f32, 1.0 : f32, 4.0 : f32, 9.0 : f32] } : 1
+  %operand_1 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [], values = [10.0 : f32] } : 1
+
+  // The second execution reuses the program compiled by the first one.
+  %cpu_handle_result_0 = corert.executeop(%cpu)
+      "tf._FusedCwise"(%operand_0, %operand_1)
+      { fused_ops = ["Sqrt", "Mul", "Tanh"] } : 1
+  %cpu_handle_result_1 = corert.executeop(%cpu)
+      "tf._FusedCwise"(%operand_0, %operand_1)
+      { fused_ops = ["Sqrt", "Mul", "Tanh"] } : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [4]
+  // CHECK-SAME: values = [0.000000e+00, 1.000000e+00, 1.000000e+00, 1.000000e+00]
+  %ch_print_0 = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result_0) : 0
+  // CHECK: DenseHostTensor dtype = f32, shape = [4]
+  // CHECK-SAME: values = [0.000000e+00, 1.000000e+00, 1.000000e+00, 1.000000e+00]
+  %ch_print_1 = corert.executeop.seq(%cpu, %ch_print_0) "tfrt_test.print"(%cpu_handle_result_1) : 0
+
+  tfrt.return %ch_print_1 : !tfrt.chain
+}
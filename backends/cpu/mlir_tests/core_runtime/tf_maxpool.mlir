@@ -51,3 +51,36 @@ func.func @maxpool_same_padding() -> !tfrt.chain {
   %ch_print_cpu = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
   tfrt.return %ch_print_cpu : !tfrt.chain
 }
+
+// CHECK: --- Running 'maxpool_negative_values'
+func.func @maxpool_negative_values() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %cpu_handle_input = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1, 3, 3, 1], values = [-9.0 : f32, -8.0 : f32, -7.0 : f32, -6.0 : f32, -5.0 : f32, -4.0 : f32, -3.0 : f32, -2.0 : f32, -1.0 : f32] } : 1
+
+  %cpu_handle_result = corert.executeop(%cpu) "tf.MaxPool"(%cpu_handle_input)
+    { ksize = [1, 2, 2, 1], padding = "VALID", strides = [1, 1, 1, 1], data_format="NHWC" } : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [1, 2, 2, 1], values = [-5.000000e+00, -4.000000e+00, -2.000000e+00, -1.000000e+00]
+  %ch_print_cpu = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
+
+// CHECK: --- Running 'avgpool_same_padding'
+func.func @avgpool_same_padding() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %cpu_handle_input = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1, 3, 3, 1], values = [0.0 : f32, 1.0 : f32, 2.0 : f32,  3.0 : f32,  4.0 : f32,  5.0 : f32,  6.0 : f32,  7.0 : f32,  8.0 : f32] } : 1
+
+  // Padded elements are not counted in the average.
+  %cpu_handle_result = corert.executeop(%cpu) "tf.AvgPool"(%cpu_handle_input)
+    { ksize = [1, 2, 2, 1], padding = "SAME", strides = [1, 1, 1, 1], data_format="NHWC" } : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [1, 3, 3, 1], values = [2.000000e+00, 3.000000e+00, 3.500000e+00, 5.000000e+00, 6.000000e+00, 6.500000e+00, 6.500000e+00, 7.500000e+00, 8.000000e+00]
+  %ch_print_cpu = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
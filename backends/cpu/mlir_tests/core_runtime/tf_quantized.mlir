@@ -0,0 +1,169 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: bef_executor --test_init_function=register_op_handlers_cpu %s.bef | FileCheck %s
+
+func.func @register_op_handlers_cpu() {
+  %null = "corert.create_null_op_handler"() : () -> !corert.ophandler
+  %cpu = "corert.create_cpu_op_handler"(%null) : (!corert.ophandler) -> !corert.ophandler
+  corert.register_op_handler %cpu "cpu"
+  tfrt.return
+}
+
+// CHECK: --- Running 'quantized_matmul_dequantize_scaled'
+func.func @quantized_matmul_dequantize_scaled() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %a = corert.const_dense_tensor dense<[[1, 2, 3], [4, 5, 6]]> : tensor<2x3xui8>
+  %b = corert.const_dense_tensor dense<[[1, -1], [2, 0], [3, 1]]> : tensor<3x2xi8>
+  %bias = corert.const_dense_tensor dense<[0.5, -1.0]> : tensor<2xf32>
+  %min_a = corert.const_dense_tensor dense<0.0> : tensor<f32>
+  %max_a = corert.const_dense_tensor dense<255.0> : tensor<f32>
+  %min_b = corert.const_dense_tensor dense<-127.0> : tensor<f32>
+  %max_b = corert.const_dense_tensor dense<127.0> : tensor<f32>
+
+  %result = corert.executeop(%cpu) "tf.QuantizedMatMulWithBiasAndDequantize"(%a, %b, %bias, %min_a, %max_a, %min_b, %max_b, %min_a, %max_a)
+      {transpose_a = false, transpose_b = false, input_quant_mode = "SCALED"} : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 2]
+  // CHECK-SAME: values = [1.450000e+01, 1.000000e+00, 3.250000e+01, 1.000000e+00]
+  %ch_print = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%result) : 0
+
+  tfrt.return %ch_print : !tfrt.chain
+}
+
+// CHECK: --- Running 'quantized_matmul_dequantize_min_first'
+func.func @quantized_matmul_dequantize_min_first() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  // With range [-1.0, 1.55], a has scale 0.01 and zero point 100.
+  %a = corert.const_dense_tensor dense<[[100, 200]]> : tensor<1x2xui8>
+  // Per channel filter scales are 1.0 and 0.1.
+  %b = corert.const_dense_tensor dense<[[50, 10], [100, -20]]> : tensor<2x2xi8>
+  %bias = corert.const_dense_tensor dense<[0.0, 0.0]> : tensor<2xf32>
+  %min_a = corert.const_dense_tensor dense<-1.0> : tensor<f32>
+  %max_a = corert.const_dense_tensor dense<1.55> : tensor<f32>
+  %min_b = corert.const_dense_tensor dense<[-127.0, -12.7]> : tensor<2xf32>
+  %max_b = corert.const_dense_tensor dense<[127.0, 12.7]> : tensor<2xf32>
+
+  %result = corert.executeop(%cpu) "tf.QuantizedMatMulWithBiasAndDequantize"(%a, %b, %bias, %min_a, %max_a, %min_b, %max_b, %min_a, %max_a)
+      {transpose_a = false, transpose_b = false} : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [1, 2]
+  // CHECK-SAME: values = [1.000000e+02, -2.000000e+00]
+  %ch_print = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%result) : 0
+
+  tfrt.return %ch_print : !tfrt.chain
+}
+
+// CHECK: --- Running 'quantized_matmul_requantize'
+func.func @quantized_matmul_requantize() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %a = corert.const_dense_tensor dense<[[1, 4], [2, 5], [3, 6]]> : tensor<3x2xui8>
+  %b = corert.const_dense_tensor dense<[[1, 2, 3], [-1, 0, 1]]> : tensor<2x3xi8>
+  %bias = corert.const_dense_tensor dense<[0.5, -1.0]> : tensor<2xf32>
+  %min_a = corert.const_dense_tensor dense<0.0> : tensor<f32>
+  %max_a = corert.const_dense_tensor dense<255.0> : tensor<f32>
+  %min_b = corert.const_dense_tensor dense<-127.0> : tensor<f32>
+  %max_b = corert.const_dense_tensor dense<127.0> : tensor<f32>
+  // The output scale is 0.5.
+  %min_out = corert.const_dense_tensor dense<-63.5> : tensor<f32>
+  %max_out = corert.const_dense_tensor dense<63.5> : tensor<f32>
+
+  %result, %min, %max = corert.executeop(%cpu) "tf.QuantizedMatMulWithBiasAndRequantize"(%a, %b, %bias, %min_a, %max_a, %min_b, %max_b, %min_out, %max_out)
+      {Toutput = !corert.qint8, transpose_a = true, transpose_b = true, input_quant_mode = "SCALED"} : 3
+
+  // CHECK: DenseHostTensor dtype = qi8, shape = [2, 2]
+  // CHECK-SAME: values = [qi8(29), qi8(2), qi8(65), qi8(2)]
+  %ch_print = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%result) : 0
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [], values = [-6.350000e+01]
+  %ch_min = corert.executeop.seq(%cpu, %ch_print) "tfrt_test.print"(%min) : 0
+
+  tfrt.return %ch_min : !tfrt.chain
+}
+
+// CHECK: --- Running 'quantized_conv2d_valid'
+func.func @quantized_conv2d_valid() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %input = corert.const_dense_tensor dense<[[[[1], [2], [3]], [[4], [5], [6]], [[7], [8], [9]]]]> : tensor<1x3x3x1xui8>
+  %filter = corert.const_dense_tensor dense<[[[[1, 1]], [[1, 0]]], [[[1, 0]], [[1, -1]]]]> : tensor<2x2x1x2xi8>
+  %bias = corert.const_dense_tensor dense<[0.0, 0.0]> : tensor<2xf32>
+  %min_input = corert.const_dense_tensor dense<0.0> : tensor<f32>
+  %max_input = corert.const_dense_tensor dense<255.0> : tensor<f32>
+  %min_filter = corert.const_dense_tensor dense<[-127.0, -127.0]> : tensor<2xf32>
+  %max_filter = corert.const_dense_tensor dense<[127.0, 127.0]> : tensor<2xf32>
+  %min_out = corert.const_dense_tensor dense<-63.5> : tensor<f32>
+  %max_out = corert.const_dense_tensor dense<63.5> : tensor<f32>
+
+  %result, %min, %max = corert.executeop(%cpu) "tf.QuantizedConv2DWithBiasAndRequantize"(%input, %filter, %bias, %min_input, %max_input, %min_filter, %max_filter, %min_out, %max_out)
+      {out_type = !corert.qint8, padding = "VALID", strides = [1, 1, 1, 1], dilations = [1, 1, 1, 1]} : 3
+
+  // CHECK: DenseHostTensor dtype = qi8, shape = [1, 2, 2, 2]
+  // CHECK-SAME: values = [qi8(24), qi8(-8), qi8(32), qi8(-8), qi8(48), qi8(-8), qi8(56), qi8(-8)]
+  %ch_print = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%result) : 0
+
+  tfrt.return %ch_print : !tfrt.chain
+}
+
+// CHECK: --- Running 'quantized_conv2d_same_strides'
+func.func @quantized_conv2d_same_strides() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %input = corert.const_dense_tensor dense<[[[[1], [2], [3]], [[4], [5], [6]], [[7], [8], [9]]]]> : tensor<1x3x3x1xui8>
+  %filter = corert.const_dense_tensor dense<[[[[1, 1]], [[1, 0]]], [[[1, 0]], [[1, -1]]]]> : tensor<2x2x1x2xi8>
+  %bias = corert.const_dense_tensor dense<[0.0, 0.0]> : tensor<2xf32>
+  %min_input = corert.const_dense_tensor dense<0.0> : tensor<f32>
+  %max_input = corert.const_dense_tensor dense<255.0> : tensor<f32>
+  %min_filter = corert.const_dense_tensor dense<-127.0> : tensor<f32>
+  %max_filter = corert.const_dense_tensor dense<127.0> : tensor<f32>
+  %min_out = corert.const_dense_tensor dense<0.0> : tensor<f32>
+  %max_out = corert.const_dense_tensor dense<127.5> : tensor<f32>
+
+  // Padding is added at the bottom and on the right, and negative results are
+  // clamped to zero.
+  %result, %min, %max = corert.executeop(%cpu) "tf.QuantizedConv2DWithBiasAndRequantize"(%input, %filter, %bias, %min_input, %max_input, %min_filter, %max_filter, %min_out, %max_out)
+      {out_type = !corert.quint8, padding = "SAME", strides = [1, 2, 2, 1]} : 3
+
+  // CHECK: DenseHostTensor dtype = qu8, shape = [1, 2, 2, 2]
+  // CHECK-SAME: values = [qu8(24), qu8(0), qu8(18), qu8(6), qu8(30), qu8(14), qu8(18), qu8(18)]
+  %ch_print = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%result) : 0
+
+  tfrt.return %ch_print : !tfrt.chain
+}
+
+// CHECK: --- Running 'quantized_conv2d_dilations'
+func.func @quantized_conv2d_dilations() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %input = corert.const_dense_tensor dense<1> : tensor<1x3x3x1xui8>
+  %filter = corert.const_dense_tensor dense<1> : tensor<2x2x1x1xi8>
+  %bias = corert.const_dense_tensor dense<[0.0]> : tensor<1xf32>
+  %min = corert.const_dense_tensor dense<0.0> : tensor<f32>
+  %max = corert.const_dense_tensor dense<127.0> : tensor<f32>
+
+  // expected-error @+1 {{runtime error: dilated convolutions are not supported}}
+  %result, %min_out, %max_out = corert.executeop(%cpu) "tf.QuantizedConv2DWithBiasAndRequantize"(%input, %filter, %bias, %min, %max, %min, %max, %min, %max)
+      {padding = "VALID", strides = [1, 1, 1, 1], dilations = [1, 2, 2, 1]} : 3
+
+  tfrt.return %ch_epoch : !tfrt.chain
+}
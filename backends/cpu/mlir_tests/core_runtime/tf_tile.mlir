@@ -77,3 +77,45 @@ func.func @tile_i1() -> !tfrt.chain{
 
   tfrt.return %ch_print_cpu : !tfrt.chain
 }
+
+// CHECK: --- Running 'tile_by_copy_i64'
+func.func @tile_by_copy_i64() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  // Input lines are 64 bytes, so they are tiled with memcpy.
+  %operand_0 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 1, 8], values = [0 : i64, 1 : i64, 2 : i64, 3 : i64, 4 : i64, 5 : i64, 6 : i64, 7 : i64,
+                                   8 : i64, 9 : i64, 10 : i64, 11 : i64, 12 : i64, 13 : i64, 14 : i64, 15 : i64] } : 1
+
+  %operand_1 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [3], values = [2 : i32, 3 : i32, 1 : i32] } : 1
+
+  %cpu_handle_result = corert.executeop(%cpu) "tf.Tile"(%operand_0, %operand_1) : 1
+
+  // CHECK: DenseHostTensor dtype = i64, shape = [4, 3, 8]
+  // CHECK-SAME: values = [0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7, ...
+  %ch_print_cpu = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
+
+// CHECK: --- Running 'tile_rank6_f32'
+func.func @tile_rank6_f32() -> !tfrt.chain{
+  %ch_epoch = tfrt.new.chain
+  %cpu = corert.get_op_handler %ch_epoch "cpu"
+
+  %operand_0 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [1, 1, 1, 1, 2, 1], values = [1.0 : f32, 2.0 : f32] } : 1
+
+  %operand_1 = corert.executeop(%cpu) "tfrt_test.create_dense_tensor"()
+    { shape = [6], values = [2 : i32, 1 : i32, 1 : i32, 1 : i32, 1 : i32, 3 : i32] } : 1
+
+  %cpu_handle_result = corert.executeop(%cpu) "tf.Tile"(%operand_0, %operand_1) : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 1, 1, 1, 2, 3]
+  // CHECK-SAME: values = [1.000000e+00, 1.000000e+00, 1.000000e+00, 2.000000e+00, 2.000000e+00, 2.000000e+00, 1.000000e+00, 1.000000e+00, 1.000000e+00, 2.000000e+00, 2.000000e+00, 2.000000e+00]
+  %ch_print_cpu = corert.executeop.seq(%cpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
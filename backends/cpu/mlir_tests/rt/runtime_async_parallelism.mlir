@@ -0,0 +1,36 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: jitrt_opt %s -cost-driven-async-parallel-for="num-workers=8 runtime-parallelism=true" | FileCheck %s
+
+// CHECK: func private @jitrt_async_parallelism(index) -> index
+
+// CHECK-LABEL: func @loop1d
+func.func @loop1d(%arg: memref<?xf32>) {
+  %cst = arith.constant 42.0 : f32
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %d0 = memref.dim %arg, %c0 : memref<?xf32>
+  // CHECK: %[[WORKERS:.*]] = arith.constant 8 : index
+  // CHECK: %[[AVAILABLE:.*]] = call @jitrt_async_parallelism(%[[WORKERS]])
+  // CHECK: %[[SCALE:.*]] = arith.ceildivsi %[[WORKERS]]
+  // CHECK: %[[SCALED:.*]] = arith.muli {{.*}}%[[SCALE]]
+  // CHECK: %[[SERIAL:.*]] = arith.cmpi sle, %[[AVAILABLE]]
+  // CHECK: arith.select %[[SERIAL]], {{.*}}, %[[SCALED]]
+  scf.parallel (%i) = (%c0) to (%d0) step (%c1) {
+    memref.store %cst, %arg[%i] : memref<?xf32>
+    scf.yield
+  }
+  func.return
+}
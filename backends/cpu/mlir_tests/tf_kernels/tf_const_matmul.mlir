@@ -0,0 +1,51 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: bef_executor %s.bef | FileCheck %s
+
+// CHECK: --- Running 'const_matmul_f32'
+func.func @const_matmul_f32() attributes {tfrt.sync} {
+  %operand_0 = "tfrt_dht_sync.create_dense_tensor.f32"()
+    { shape = [2, 3], values = [-1.0 : f32, -0.5 : f32, 0.0 : f32, 0.5 : f32, 1.0 : f32, 1.5 : f32] } : () -> !t.tensor
+
+  %result = tfrt_dht_sync.create_uninitialized_tensor.f32.2 [2: i64, 2: i64]
+  "tf_sync._ConstMatMul.f32"(%operand_0, %result)
+      { weights = dense<[[0.0, 1.0], [2.0, 3.0], [4.0, 5.0]]> : tensor<3x2xf32>,
+        transpose_a = false, transpose_b = false }
+      : (!t.tensor, !t.tensor)->()
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 2]
+  // CHECK-SAME: values = [-1.000000e+00, -2.500000e+00, 8.000000e+00, 1.100000e+01]
+  tfrt_dht_sync.print_tensor %result
+
+  tfrt.return
+}
+
+// CHECK: --- Running 'const_matmul_transpose_b_f32'
+func.func @const_matmul_transpose_b_f32() attributes {tfrt.sync} {
+  %operand_0 = "tfrt_dht_sync.create_dense_tensor.f32"()
+    { shape = [2, 3], values = [-1.0 : f32, -0.5 : f32, 0.0 : f32, 0.5 : f32, 1.0 : f32, 1.5 : f32] } : () -> !t.tensor
+
+  %result = tfrt_dht_sync.create_uninitialized_tensor.f32.2 [2: i64, 2: i64]
+  "tf_sync._ConstMatMul.f32"(%operand_0, %result)
+      { weights = dense<[[0.0, 2.0, 4.0], [1.0, 3.0, 5.0]]> : tensor<2x3xf32>,
+        transpose_a = false, transpose_b = true }
+      : (!t.tensor, !t.tensor)->()
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 2]
+  // CHECK-SAME: values = [-1.000000e+00, -2.500000e+00, 8.000000e+00, 1.100000e+01]
+  tfrt_dht_sync.print_tensor %result
+
+  tfrt.return
+}
@@ -0,0 +1,91 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit test for the autotuning cache.
+#include "tfrt/gpu/autotune/autotune_cache.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace tfrt {
+namespace gpu {
+namespace {
+
+std::string GetTempPath() {
+  llvm::SmallString<128> path;
+  EXPECT_FALSE(llvm::sys::fs::createTemporaryFile("autotune", "txt", path));
+  llvm::sys::fs::remove(path);
+  return std::string(path.str());
+}
+
+TEST(AutotuneCacheTest, InsertKeepsFirstResult) {
+  AutotuneCache cache;
+  EXPECT_FALSE(cache.Lookup("device", "problem").hasValue());
+
+  auto result = cache.Insert("device", "problem", {1, 1024, 2});
+  EXPECT_EQ(result.algorithm, 1);
+  result = cache.Insert("device", "problem", {3, 0, 0});
+  EXPECT_EQ(result.algorithm, 1);
+
+  auto cached = cache.Lookup("device", "problem");
+  ASSERT_TRUE(cached.hasValue());
+  EXPECT_EQ(cached->algorithm, 1);
+  EXPECT_EQ(cached->workspace_bytes, 1024);
+  EXPECT_EQ(cached->math_type, 2);
+
+  // Results are per device.
+  EXPECT_FALSE(cache.Lookup("other device", "problem").hasValue());
+}
+
+TEST(AutotuneCacheTest, PersistsResults) {
+  std::string path = GetTempPath();
+  {
+    AutotuneCache cache(path);
+    cache.Insert("device", "problem", {4, 512, 1});
+  }
+
+  AutotuneCache cache(path);
+  auto cached = cache.Lookup("device", "problem");
+  ASSERT_TRUE(cached.hasValue());
+  EXPECT_EQ(cached->algorithm, 4);
+  EXPECT_EQ(cached->workspace_bytes, 512);
+  EXPECT_EQ(cached->math_type, 1);
+  llvm::sys::fs::remove(path);
+}
+
+TEST(AutotuneCacheTest, IgnoresMalformedLines) {
+  std::string path = GetTempPath();
+  {
+    std::error_code error_code;
+    llvm::raw_fd_ostream os(path, error_code, llvm::sys::fs::OF_Text);
+    ASSERT_FALSE(error_code);
+    os << "device\tproblem\t5\t0\t0\n";
+    os << "device\tbroken\tnot a number\t0\t0\n";
+    os << "truncated line\n";
+  }
+
+  AutotuneCache cache(path);
+  auto cached = cache.Lookup("device", "problem");
+  ASSERT_TRUE(cached.hasValue());
+  EXPECT_EQ(cached->algorithm, 5);
+  EXPECT_FALSE(cache.Lookup("device", "broken").hasValue());
+  llvm::sys::fs::remove(path);
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace tfrt
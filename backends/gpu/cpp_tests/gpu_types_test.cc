@@ -47,6 +47,45 @@ TEST_P(Test, GpuContext) {
   EXPECT_THAT(gpu_context.get(), IsNull());
 }
 
+TEST_P(Test, GpuContextPinnedHostMemoryPool) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, wrapper::CtxGetCurrent());
+
+  GpuContext gpu_context(std::move(context));
+  auto* pool = gpu_context.pinned_host_memory_pool();
+  ASSERT_THAT(pool, NotNull());
+  void* ptr = nullptr;
+  {
+    TFRT_ASSERT_AND_ASSIGN(auto buffer, pool->Allocate(current, 1 << 16));
+    ptr = buffer->data();
+    EXPECT_TRUE(pool->IsPinned(ptr));
+  }
+  // Pinned pages are reused by later requests.
+  TFRT_ASSERT_AND_ASSIGN(auto buffer, pool->Allocate(current, 1 << 15));
+  EXPECT_EQ(buffer->data(), ptr);
+}
+
+TEST_P(Test, GpuContextSolverHandlePool) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+
+  auto gpu_context = MakeAvailableAsyncValueRef<GpuContext>(std::move(context));
+  EXPECT_THAT(gpu_context->TakeSolverHandle(), IsNull());
+  wrapper::SolverHandle released;
+  {
+    TFRT_ASSERT_AND_ASSIGN(auto handle, wrapper::SolverCreate(GetParam()));
+    released = handle.get();
+    GpuSolverHandle solver_handle(gpu_context.CopyRef(), std::move(handle));
+  }
+  // Destroyed handles are reused by later requests.
+  auto handle = gpu_context->TakeSolverHandle();
+  EXPECT_EQ(handle.get(), released);
+  EXPECT_THAT(gpu_context->TakeSolverHandle(), IsNull());
+}
+
 TEST_P(Test, GpuStream) {
   ASSERT_THAT(Init(GetParam()), IsSuccess());
   TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
@@ -218,5 +257,56 @@ TEST_F(Test, CallbackManagerCUDA) {
   EXPECT_TRUE(invoked.load());
 }
 
+TEST_F(Test, GpuModuleCacheCUDA) {
+  wrapper::Platform platform = wrapper::Platform::CUDA;
+  ASSERT_THAT(Init(platform), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(wrapper::Device device,
+                         wrapper::DeviceGet(platform, /*ordinal=*/0));
+
+  const char* kernel_ptx = R"(
+        .version 6.0
+        .target sm_35
+        .address_size 64
+
+        .visible .entry Kernel() {
+          ret;
+        })";
+  int num_loads = 0;
+  auto load = [&](wrapper::CurrentContext current) {
+    ++num_loads;
+    return ModuleLoadData(current, kernel_ptx);
+  };
+  GpuModuleCache& cache = GpuModuleCache::Global();
+
+  {
+    // Modules loaded into the primary context are cached.
+    TFRT_ASSERT_AND_ASSIGN(wrapper::OwningContext context,
+                           DevicePrimaryCtxRetain(device));
+    TFRT_ASSERT_AND_ASSIGN(wrapper::CurrentContext current,
+                           CtxSetCurrent(context.get()));
+    TFRT_ASSERT_AND_ASSIGN(
+        wrapper::Module module,
+        cache.GetOrLoad(current, kernel_ptx, [&] { return load(current); }));
+    EXPECT_THAT(module, NotNull());
+    TFRT_ASSERT_AND_ASSIGN(
+        wrapper::Module other,
+        cache.GetOrLoad(current, kernel_ptx, [&] { return load(current); }));
+    EXPECT_EQ(module, other);
+    EXPECT_EQ(num_loads, 1);
+  }
+
+  {
+    // Modules loaded into other contexts are not cached.
+    TFRT_ASSERT_AND_ASSIGN(wrapper::OwningContext context, CtxCreate(device));
+    TFRT_ASSERT_AND_ASSIGN(wrapper::CurrentContext current,
+                           wrapper::CtxGetCurrent());
+    TFRT_ASSERT_AND_ASSIGN(
+        wrapper::Module module,
+        cache.GetOrLoad(current, kernel_ptx, [&] { return load(current); }));
+    EXPECT_THAT(module, IsNull());
+    EXPECT_EQ(num_loads, 1);
+  }
+}
+
 }  // namespace gpu
 }  // namespace tfrt
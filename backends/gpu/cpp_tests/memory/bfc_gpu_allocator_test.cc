@@ -0,0 +1,77 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit test for the BFC GPU allocator.
+
+#include "tfrt/gpu/memory/bfc_gpu_allocator.h"
+
+#include "common.h"
+#include "gtest/gtest.h"
+#include "tfrt/gpu/wrapper/driver_wrapper.h"
+
+namespace tfrt {
+namespace gpu {
+using wrapper::Test;
+
+TEST_P(Test, BfcGpuAllocatorStats) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, wrapper::CtxGetCurrent());
+  TFRT_ASSERT_AND_ASSIGN(auto stream,
+                         wrapper::StreamCreateNonBlocking(current));
+
+  BfcGpuAllocator allocator(current);
+  auto stats = allocator.GetStats();
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_GT(stats.bytes_reserved, 0);
+  EXPECT_EQ(stats.largest_free_chunk, stats.bytes_reserved);
+
+  // Allocations are rounded up to a multiple of 256 bytes.
+  TFRT_ASSERT_AND_ASSIGN(auto pointer, allocator.Allocate(1000, stream.get()));
+  stats = allocator.GetStats();
+  EXPECT_EQ(stats.bytes_in_use, 1024);
+  EXPECT_EQ(stats.peak_bytes_in_use, 1024);
+  EXPECT_EQ(stats.num_allocs, 1);
+  EXPECT_EQ(stats.largest_free_chunk, stats.bytes_reserved - 1024);
+  int64_t num_chunks_in_use = 0;
+  for (const auto& bin : stats.bins)
+    num_chunks_in_use += bin.num_chunks_in_use;
+  EXPECT_EQ(num_chunks_in_use, 1);
+
+  EXPECT_THAT(allocator.Deallocate(pointer, stream.get()), IsSuccess());
+  stats = allocator.GetStats();
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_EQ(stats.peak_bytes_in_use, 1024);
+  EXPECT_EQ(stats.largest_free_chunk, stats.bytes_reserved);
+}
+
+TEST_P(Test, BfcGpuAllocatorOutOfMemoryReportsFreeBytes) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, wrapper::CtxGetCurrent());
+  TFRT_ASSERT_AND_ASSIGN(auto stream,
+                         wrapper::StreamCreateNonBlocking(current));
+
+  BfcGpuAllocator allocator(current);
+  auto stats = allocator.GetStats();
+  auto pointer = allocator.Allocate(stats.bytes_reserved + 1, stream.get());
+  ASSERT_FALSE(static_cast<bool>(pointer));
+  EXPECT_NE(toString(pointer.takeError()).find("largest free chunk"),
+            std::string::npos);
+}
+
+}  // namespace gpu
+}  // namespace tfrt
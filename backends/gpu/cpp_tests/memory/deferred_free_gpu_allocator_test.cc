@@ -0,0 +1,79 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit test for the deferred free GPU allocator.
+
+#include "tfrt/gpu/memory/deferred_free_gpu_allocator.h"
+
+#include "common.h"
+#include "gtest/gtest.h"
+#include "tfrt/gpu/memory/stream_caching_gpu_allocator.h"
+#include "tfrt/gpu/wrapper/driver_wrapper.h"
+
+namespace tfrt {
+namespace gpu {
+using wrapper::Test;
+
+TEST_P(Test, DeferredFreeGpuAllocatorFreesAfterAllStreams) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, wrapper::CtxGetCurrent());
+  TFRT_ASSERT_AND_ASSIGN(auto stream,
+                         wrapper::StreamCreateNonBlocking(current));
+  TFRT_ASSERT_AND_ASSIGN(auto other_stream,
+                         wrapper::StreamCreateNonBlocking(current));
+
+  auto allocator = MakeAvailableAsyncValueRef<DeferredFreeGpuAllocator>(
+      current,
+      MakeAvailableAsyncValueRef<StreamCachingGpuAllocator>(current));
+
+  TFRT_ASSERT_AND_ASSIGN(auto pointer, allocator->Allocate(256, stream.get()));
+  wrapper::Stream streams[] = {stream.get(), other_stream.get()};
+  EXPECT_THAT(allocator->DeallocateAfter(pointer, streams), IsSuccess());
+  EXPECT_EQ(allocator->num_pending(), 1);
+
+  // Once both streams are done, the memory is reused by the next allocation.
+  EXPECT_THAT(wrapper::StreamSynchronize(stream.get()), IsSuccess());
+  EXPECT_THAT(wrapper::StreamSynchronize(other_stream.get()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto reused, allocator->Allocate(256, stream.get()));
+  EXPECT_EQ(allocator->num_pending(), 0);
+  EXPECT_EQ(reused, pointer);
+  EXPECT_THAT(allocator->Deallocate(reused, stream.get()), IsSuccess());
+}
+
+TEST_P(Test, DeferredFreeGpuAllocatorForwardsSingleStream) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, wrapper::CtxGetCurrent());
+  TFRT_ASSERT_AND_ASSIGN(auto stream,
+                         wrapper::StreamCreateNonBlocking(current));
+
+  auto allocator = MakeAvailableAsyncValueRef<DeferredFreeGpuAllocator>(
+      current,
+      MakeAvailableAsyncValueRef<StreamCachingGpuAllocator>(current));
+
+  // Memory freed in the order of one stream is reused on it right away.
+  TFRT_ASSERT_AND_ASSIGN(auto pointer, allocator->Allocate(256, stream.get()));
+  wrapper::Stream streams[] = {stream.get()};
+  EXPECT_THAT(allocator->DeallocateAfter(pointer, streams), IsSuccess());
+  EXPECT_EQ(allocator->num_pending(), 0);
+  TFRT_ASSERT_AND_ASSIGN(auto reused, allocator->Allocate(256, stream.get()));
+  EXPECT_EQ(reused, pointer);
+  EXPECT_THAT(allocator->Deallocate(reused, stream.get()), IsSuccess());
+}
+
+}  // namespace gpu
+}  // namespace tfrt
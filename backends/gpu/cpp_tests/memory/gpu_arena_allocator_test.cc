@@ -0,0 +1,81 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit test for the GPU arena allocator.
+
+#include "tfrt/gpu/memory/gpu_arena_allocator.h"
+
+#include "common.h"
+#include "gtest/gtest.h"
+#include "tfrt/gpu/memory/stream_caching_gpu_allocator.h"
+#include "tfrt/gpu/wrapper/driver_wrapper.h"
+
+namespace tfrt {
+namespace gpu {
+using wrapper::Test;
+
+TEST_P(Test, GpuArenaAllocatorBumpAllocatesFromBlock) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, wrapper::CtxGetCurrent());
+  TFRT_ASSERT_AND_ASSIGN(auto stream,
+                         wrapper::StreamCreateNonBlocking(current));
+
+  auto allocator = MakeAvailableAsyncValueRef<StreamCachingGpuAllocator>(
+      current);
+  TFRT_ASSERT_AND_ASSIGN(
+      auto arena, GpuArenaAllocator::Create(current, allocator.CopyRef(),
+                                            /*block_size=*/1024, stream.get()));
+
+  TFRT_ASSERT_AND_ASSIGN(auto first, arena->Allocate(100, stream.get()));
+  TFRT_ASSERT_AND_ASSIGN(auto second, arena->Allocate(100, stream.get()));
+  EXPECT_EQ(static_cast<char*>(second.raw()) -
+                static_cast<char*>(first.raw()),
+            GpuAllocator::kAlignment);
+
+  // Deallocating from the block does not make the memory available again.
+  EXPECT_THAT(arena->Deallocate(second, stream.get()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto third, arena->Allocate(100, stream.get()));
+  EXPECT_NE(third, second);
+  EXPECT_EQ(arena->requested_bytes(), 3 * GpuAllocator::kAlignment);
+}
+
+TEST_P(Test, GpuArenaAllocatorForwardsWhenBlockIsFull) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, wrapper::CtxGetCurrent());
+  TFRT_ASSERT_AND_ASSIGN(auto stream,
+                         wrapper::StreamCreateNonBlocking(current));
+
+  auto allocator = MakeAvailableAsyncValueRef<StreamCachingGpuAllocator>(
+      current);
+  TFRT_ASSERT_AND_ASSIGN(
+      auto arena, GpuArenaAllocator::Create(current, allocator.CopyRef(),
+                                            /*block_size=*/256, stream.get()));
+
+  TFRT_ASSERT_AND_ASSIGN(auto pointer, arena->Allocate(256, stream.get()));
+  TFRT_ASSERT_AND_ASSIGN(auto other, arena->Allocate(4096, stream.get()));
+  // Memory outside of the block is returned to the underlying allocator.
+  EXPECT_THAT(arena->Deallocate(other, stream.get()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto reused,
+                         allocator->Allocate(4096, stream.get()));
+  EXPECT_EQ(reused, other);
+  EXPECT_THAT(allocator->Deallocate(reused, stream.get()), IsSuccess());
+  EXPECT_EQ(arena->requested_bytes(), 256 + 4096);
+}
+
+}  // namespace gpu
+}  // namespace tfrt
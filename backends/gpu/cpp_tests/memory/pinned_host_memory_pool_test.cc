@@ -0,0 +1,66 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit test for the pinned host memory pool.
+
+#include "tfrt/gpu/memory/pinned_host_memory_pool.h"
+
+#include "common.h"
+#include "gtest/gtest.h"
+#include "tfrt/gpu/wrapper/driver_wrapper.h"
+
+namespace tfrt {
+namespace gpu {
+using wrapper::Test;
+
+TEST_P(Test, PinnedHostMemoryPoolReusesBlocks) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, wrapper::CtxGetCurrent());
+
+  auto pool = TakeRef(new PinnedHostMemoryPool());
+  void* ptr = nullptr;
+  {
+    TFRT_ASSERT_AND_ASSIGN(auto buffer, pool->Allocate(current, 1000));
+    EXPECT_EQ(buffer->size(), 1000);
+    ptr = buffer->data();
+    EXPECT_TRUE(pool->IsPinned(ptr));
+  }
+  EXPECT_FALSE(pool->IsPinned(ptr));
+
+  // Sizes in the same size class reuse the released block.
+  TFRT_ASSERT_AND_ASSIGN(auto buffer, pool->Allocate(current, 2000));
+  EXPECT_EQ(buffer->data(), ptr);
+
+  int host_value = 0;
+  EXPECT_FALSE(pool->IsPinned(&host_value));
+}
+
+TEST_P(Test, PinnedHostMemoryPoolRespectsCacheLimit) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, wrapper::CtxGetCurrent());
+
+  // Nothing is cached. The buffer keeps the pool alive after its last other
+  // reference is dropped.
+  auto pool = TakeRef(new PinnedHostMemoryPool(/*max_cached_bytes=*/0));
+  TFRT_ASSERT_AND_ASSIGN(auto buffer, pool->Allocate(current, 1 << 20));
+  pool.reset();
+  static_cast<char*>(buffer->data())[0] = 1;
+}
+
+}  // namespace gpu
+}  // namespace tfrt
@@ -0,0 +1,91 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit test for the stream caching GPU allocator.
+
+#include "tfrt/gpu/memory/stream_caching_gpu_allocator.h"
+
+#include "common.h"
+#include "gtest/gtest.h"
+#include "tfrt/gpu/wrapper/driver_wrapper.h"
+
+namespace tfrt {
+namespace gpu {
+using wrapper::Test;
+
+TEST_P(Test, StreamCachingGpuAllocatorReusesBlocksOnSameStream) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, wrapper::CtxGetCurrent());
+  TFRT_ASSERT_AND_ASSIGN(auto stream,
+                         wrapper::StreamCreateNonBlocking(current));
+
+  StreamCachingGpuAllocator allocator(current);
+  TFRT_ASSERT_AND_ASSIGN(auto pointer, allocator.Allocate(1000, stream.get()));
+  EXPECT_THAT(allocator.Deallocate(pointer, stream.get()), IsSuccess());
+
+  // Sizes in the same size class reuse the released block.
+  TFRT_ASSERT_AND_ASSIGN(auto other, allocator.Allocate(1024, stream.get()));
+  EXPECT_EQ(other, pointer);
+  EXPECT_THAT(allocator.Deallocate(other, stream.get()), IsSuccess());
+}
+
+TEST_P(Test, StreamCachingGpuAllocatorReusesBlocksAcrossStreams) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, wrapper::CtxGetCurrent());
+  TFRT_ASSERT_AND_ASSIGN(auto stream,
+                         wrapper::StreamCreateNonBlocking(current));
+  TFRT_ASSERT_AND_ASSIGN(auto other_stream,
+                         wrapper::StreamCreateNonBlocking(current));
+
+  StreamCachingGpuAllocator allocator(current);
+  TFRT_ASSERT_AND_ASSIGN(auto pointer, allocator.Allocate(4096, stream.get()));
+  EXPECT_THAT(wrapper::MemsetD32Async(current, pointer, /*value=*/1,
+                                      /*count=*/1024, stream.get()),
+              IsSuccess());
+  EXPECT_THAT(allocator.Deallocate(pointer, stream.get()), IsSuccess());
+
+  // The block freed on 'stream' is reused on 'other_stream' after an event.
+  TFRT_ASSERT_AND_ASSIGN(auto other,
+                         allocator.Allocate(4096, other_stream.get()));
+  EXPECT_EQ(other, pointer);
+  EXPECT_THAT(allocator.Deallocate(other, other_stream.get()), IsSuccess());
+
+  // The default stream waits on the host for the other stream.
+  TFRT_ASSERT_AND_ASSIGN(auto shared, allocator.Allocate(4096, {}));
+  EXPECT_EQ(shared, pointer);
+  EXPECT_THAT(allocator.Deallocate(shared, {}), IsSuccess());
+}
+
+TEST_P(Test, StreamCachingGpuAllocatorLargeBlocks) {
+  ASSERT_THAT(Init(GetParam()), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, wrapper::DeviceGet(GetParam(), 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, wrapper::CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, wrapper::CtxGetCurrent());
+
+  StreamCachingGpuAllocator allocator(current);
+  size_t size = (size_t{256} << 20) + 1;
+  TFRT_ASSERT_AND_ASSIGN(auto pointer, allocator.Allocate(size, {}));
+  EXPECT_THAT(allocator.Deallocate(pointer, {}), IsSuccess());
+  // Large blocks are not cached, deallocating twice fails.
+  auto error = allocator.Deallocate(pointer, {});
+  EXPECT_TRUE(static_cast<bool>(error));
+  llvm::consumeError(std::move(error));
+}
+
+}  // namespace gpu
+}  // namespace tfrt
@@ -604,6 +604,49 @@ TEST_F(Test, TestEventsCUDA) {
   EXPECT_EQ(result, desired);
 }
 
+TEST_P(Test, TestGraphCaptureAndReplay) {
+  auto platform = GetParam();
+  ASSERT_THAT(Init(platform), IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto device, DeviceGet(platform, 0));
+  TFRT_ASSERT_AND_ASSIGN(auto context, CtxCreate(device));
+  TFRT_ASSERT_AND_ASSIGN(auto current, CtxGetCurrent());
+  TFRT_ASSERT_AND_ASSIGN(auto stream, StreamCreateNonBlocking(current));
+  TFRT_ASSERT_AND_ASSIGN(auto dst, MemAlloc(current, sizeof(int)));
+
+  // Captured work is recorded, not executed.
+  EXPECT_THAT(StreamBeginCapture(stream.get()), IsSuccess());
+  EXPECT_THAT(MemsetD32Async(current, dst.get(), /*value=*/42, /*count=*/1,
+                             stream.get()),
+              IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto graph, StreamEndCapture(stream.get()));
+  TFRT_ASSERT_AND_ASSIGN(auto graph_exec,
+                         GraphInstantiate(current, graph.get()));
+
+  int result = 0;
+  EXPECT_THAT(MemsetD32(current, dst.get(), /*value=*/0, /*count=*/1),
+              IsSuccess());
+  EXPECT_THAT(GraphLaunch(graph_exec.get(), stream.get()), IsSuccess());
+  EXPECT_THAT(StreamSynchronize(stream.get()), IsSuccess());
+  EXPECT_THAT(Memcpy(current, {&result, platform}, dst.get(), sizeof(int)),
+              IsSuccess());
+  EXPECT_EQ(result, 42);
+
+  // A graph with the same topology updates the instantiated graph in place.
+  EXPECT_THAT(StreamBeginCapture(stream.get()), IsSuccess());
+  EXPECT_THAT(MemsetD32Async(current, dst.get(), /*value=*/7, /*count=*/1,
+                             stream.get()),
+              IsSuccess());
+  TFRT_ASSERT_AND_ASSIGN(auto other_graph, StreamEndCapture(stream.get()));
+  TFRT_ASSERT_AND_ASSIGN(auto updated,
+                         GraphExecUpdate(graph_exec.get(), other_graph.get()));
+  EXPECT_TRUE(updated);
+  EXPECT_THAT(GraphLaunch(graph_exec.get(), stream.get()), IsSuccess());
+  EXPECT_THAT(StreamSynchronize(stream.get()), IsSuccess());
+  EXPECT_THAT(Memcpy(current, {&result, platform}, dst.get(), sizeof(int)),
+              IsSuccess());
+  EXPECT_EQ(result, 7);
+}
+
 TEST_P(Test, UnalignedPointeeType) {
   auto platform = GetParam();
   Pointer<const char>(reinterpret_cast<const char*>(0x1), platform);
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Autotuning cache
+//
+// This file declares a cache of the algorithms picked by benchmarking GPU
+// library routines, which can be persisted across processes.
+#ifndef TFRT_GPU_AUTOTUNE_AUTOTUNE_CACHE_H_
+#define TFRT_GPU_AUTOTUNE_AUTOTUNE_CACHE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Error.h"
+#include "tfrt/gpu/wrapper/driver_wrapper.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace gpu {
+
+// The winner of benchmarking the candidate algorithms of a problem.
+struct AutotuneResult {
+  // Library specific algorithm enum, e.g. cudnnConvolutionFwdAlgo_t.
+  int64_t algorithm = 0;
+  // Scratch memory the algorithm needs.
+  uint64_t workspace_bytes = 0;
+  // Library specific math mode enum, e.g. cudnnMathType_t.
+  int64_t math_type = 0;
+};
+
+// A thread-safe cache of autotuning results, keyed by device and problem.
+//
+// If constructed with a file path, results in the file are loaded on
+// construction and new results are appended to it. The file contains one
+// tab-separated result per line. Later lines take precedence.
+class AutotuneCache {
+ public:
+  explicit AutotuneCache(std::string path = {});
+
+  // Returns the process wide cache. It is persisted in the file named by the
+  // TFRT_GPU_AUTOTUNE_CACHE environment variable, if set.
+  static AutotuneCache& Global();
+
+  llvm::Optional<AutotuneResult> Lookup(string_view device,
+                                        string_view problem) const;
+
+  // Adds `result` unless the cache already has a result for the problem, and
+  // returns the cached result.
+  AutotuneResult Insert(string_view device, string_view problem,
+                        const AutotuneResult& result);
+
+ private:
+  static std::string MakeKey(string_view device, string_view problem);
+
+  void Load();
+
+  const std::string path_;
+  mutable mutex mutex_;
+  llvm::StringMap<AutotuneResult> results_ TFRT_GUARDED_BY(mutex_);
+};
+
+// Returns the part of the autotuning key that identifies the device `current`
+// is bound to. Results are not portable between device models.
+llvm::Expected<std::string> GetAutotuneDeviceKey(
+    wrapper::CurrentContext current);
+
+}  // namespace gpu
+}  // namespace tfrt
+
+#endif  // TFRT_GPU_AUTOTUNE_AUTOTUNE_CACHE_H_
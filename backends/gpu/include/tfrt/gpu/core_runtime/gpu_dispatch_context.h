@@ -20,6 +20,7 @@
 #ifndef TFRT_GPU_CORE_RUNTIME_GPU_DISPATCH_CONTEXT_H_
 #define TFRT_GPU_CORE_RUNTIME_GPU_DISPATCH_CONTEXT_H_
 
+#include "tfrt/dtype/dtype.h"
 #include "tfrt/gpu/device/device.h"
 #include "tfrt/gpu/gpu_types.h"
 #include "tfrt/gpu/wrapper/blas_wrapper.h"
@@ -43,7 +44,25 @@ class GpuDispatchContext {
     if (!current_context) {
       return current_context.takeError();
     }
-    return GpuDispatchContext(device, std::move(current_context.get()));
+    return GpuDispatchContext(device, std::move(current_context.get()),
+                              /*stream_index=*/0, device->allocator());
+  }
+
+  // Creates a context that dispatches on stream `stream_index` of the device's
+  // pool and allocates memory with `allocator`.
+  static Expected<GpuDispatchContext> Create(
+      const GpuDevice* device, int stream_index,
+      AsyncValueRef<gpu::GpuAllocator> allocator) {
+    if (device == nullptr) {
+      return MakeStringError("The device is null.");
+    }
+    Expected<wrapper::CurrentContext> current_context =
+        device->SetCurrentContext();
+    if (!current_context) {
+      return current_context.takeError();
+    }
+    return GpuDispatchContext(device, std::move(current_context.get()),
+                              stream_index, std::move(allocator));
   }
 
   // The inputs to the GPU dispatch function are available for reading on this
@@ -53,17 +72,23 @@ class GpuDispatchContext {
 
   // Allocator for allocating GPU device memory.
   AsyncValueRef<gpu::GpuAllocator> allocator() const {
-    return device_->allocator();
+    return allocator_.CopyRef();
   }
 
   // Eigen GPU device. Used to launch Eigen kernels.
   Eigen::GpuDevice* eigen_gpu_device() const { return eigen_gpu_device_; }
 
-  // GPU BLAS library handle. Used to launch BLAS routines.
-  wrapper::BlasHandle blas_handle() const { return blas_handle_; }
+  // GPU BLAS library handle. Used to launch BLAS routines. Created on first
+  // use, see GpuDevice::blas_handle().
+  wrapper::BlasHandle blas_handle() const {
+    return device_->blas_handle(current_context_, stream_index_);
+  }
 
-  // GPU DNN library handle. Used to launch convolutions etc.
-  wrapper::DnnHandle dnn_handle() const { return dnn_handle_; }
+  // GPU DNN library handle. Used to launch convolutions etc. Created on first
+  // use, see GpuDevice::dnn_handle().
+  wrapper::DnnHandle dnn_handle() const {
+    return device_->dnn_handle(current_context_, stream_index_);
+  }
 
   // The GPU device sets the current context before calling into the dispatch
   // function.  See the documentation for wrapper::CurrentContext for more
@@ -72,22 +97,32 @@ class GpuDispatchContext {
 
   const GpuDevice& device() const { return *device_; }
 
+  // The dtype in which F32 matmuls and convolutions are computed, see
+  // GpuMixedPrecisionPolicy. Invalid if the op runs in the dtype of its
+  // inputs.
+  DType mixed_precision_dtype() const { return mixed_precision_dtype_; }
+  void set_mixed_precision_dtype(DType dtype) {
+    mixed_precision_dtype_ = dtype;
+  }
+
  private:
   GpuDispatchContext(const GpuDevice* device,
-                     wrapper::CurrentContext current_context)
+                     wrapper::CurrentContext current_context, int stream_index,
+                     AsyncValueRef<gpu::GpuAllocator> allocator)
       : device_(device),
-        stream_(device->stream()),
-        eigen_gpu_device_(device->eigen_gpu_device()),
-        blas_handle_(device->blas_handle()),
-        dnn_handle_(device->dnn_handle()),
+        stream_index_(stream_index),
+        stream_(device->stream(stream_index)),
+        allocator_(std::move(allocator)),
+        eigen_gpu_device_(device->eigen_gpu_device(stream_index)),
         current_context_(std::move(current_context)) {}
 
   const GpuDevice* device_;
+  int stream_index_;
   wrapper::Stream stream_;
+  AsyncValueRef<gpu::GpuAllocator> allocator_;
   Eigen::GpuDevice* eigen_gpu_device_;
-  wrapper::BlasHandle blas_handle_;
-  wrapper::DnnHandle dnn_handle_;
   wrapper::CurrentContext current_context_;
+  DType mixed_precision_dtype_ = DType::Invalid;
 };
 }  // namespace gpu
 }  // namespace tfrt
@@ -21,9 +21,18 @@
 #define TFRT_BACKENDS_GPU_CORE_RUNTIME_GPU_OP_HANDLER_H_
 
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "llvm/ADT/DenseMap.h"
 #include "tfrt/core_runtime/op_handler.h"
+#include "tfrt/dtype/dtype.h"
+#include "tfrt/gpu/gpu_types.h"
+#include "tfrt/gpu/memory/gpu_arena_allocator.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/support/mutex.h"
 #include "tfrt/support/ref_count.h"
+#include "tfrt/support/thread_annotations.h"
 
 namespace tfrt {
 namespace gpu {
@@ -32,6 +41,59 @@ class GpuDevice;
 llvm::Expected<OpHandler*> CreateGpuOpHandler(CoreRuntime* runtime,
                                               RCReference<GpuDevice> device,
                                               OpHandler* fallback);
+
+// Policy of the automatic mixed precision mode of a GPU op handler. Ops on the
+// allow list and not on the deny list compute F32 inputs in `compute_dtype`:
+// the inputs are cast on the fly, the weight operands (the second operand of
+// tf.MatMul, the filter of tf.Conv2D) are cast once and cached, and the math
+// runs on tensor cores with F32 accumulation. The results stay F32.
+//
+// Only tf.MatMul and tf.Conv2D implement the mode, other ops on the allow list
+// are unaffected. tf.Conv2D only supports F16.
+struct GpuMixedPrecisionPolicy {
+  // F16 or BF16.
+  DType compute_dtype = DType::F16;
+  std::vector<std::string> allow_list = {"tf.MatMul", "tf.Conv2D"};
+  std::vector<std::string> deny_list;
+};
+
+// Creates a GPU op handler which runs the ops allowed by `mixed_precision` in
+// reduced precision. Mixed precision changes the numerics, so it is only
+// enabled for models which are known to tolerate it.
+llvm::Expected<OpHandler*> CreateGpuOpHandler(
+    CoreRuntime* runtime, RCReference<GpuDevice> device, OpHandler* fallback,
+    const GpuMixedPrecisionPolicy& mixed_precision);
+
+// The GPU arenas of a request, one per device. If the request context data
+// contains this (see EnableGpuRequestArenas), GPU op handlers allocate the
+// buffers of the request from a GpuArenaAllocator instead of the device
+// allocator. The arena block is sized to the usage of the last finished
+// request on the device, so requests of static-shape models hardly ever go to
+// the device allocator. The block is released when the request and all
+// tensors allocated by it are gone.
+class GpuRequestArenas {
+ public:
+  GpuRequestArenas() = default;
+  GpuRequestArenas(const GpuRequestArenas&) = delete;
+  GpuRequestArenas& operator=(const GpuRequestArenas&) = delete;
+  // Records the usage of each arena as the arena size of its device.
+  ~GpuRequestArenas();
+
+  // Returns the arena of `device`, and reserves its block on first use.
+  llvm::Expected<AsyncValueRef<GpuAllocator>> GetOrCreate(
+      const GpuDevice& device);
+
+ private:
+  mutex mutex_;
+  llvm::SmallDenseMap<const GpuDevice*, AsyncValueRef<GpuArenaAllocator>, 2>
+      arenas_ TFRT_GUARDED_BY(mutex_);
+};
+
+// Makes the GPU op handlers allocate from per-request arenas for the request
+// built by `builder`.
+inline void EnableGpuRequestArenas(RequestContextBuilder* builder) {
+  builder->context_data().emplace<GpuRequestArenas>();
+}
 }  // namespace gpu
 }  // namespace tfrt
 
@@ -34,15 +34,22 @@ namespace gpu {
 class GpuAllocator;
 class GpuDispatchContext;
 class DenseGpuTensor;
+class PinnedHostMemoryPool;
 
+// If `pinned_pool` is not null, the result tensor is allocated from it and
+// keeps the pinned buffer until the tensor is destroyed.
 AsyncValueRef<DenseHostTensor> ConvertDenseGpuTensorToDenseHostTensor(
     wrapper::CurrentContext current_context, wrapper::Stream stream,
-    const DenseGpuTensor& tensor, HostContext* host);
+    const DenseGpuTensor& tensor, HostContext* host,
+    PinnedHostMemoryPool* pinned_pool = nullptr);
 
+// If `pinned_pool` is not null and `tensor` is not backed by one of its
+// buffers, `tensor` is copied to a pinned staging buffer first, so that the
+// copy to the device is asynchronous.
 Expected<DenseGpuTensor> ConvertDenseHostTensorToDenseGpuTensor(
     wrapper::CurrentContext current_context, wrapper::Stream stream,
     AsyncValueRef<GpuAllocator> allocator, const DenseHostTensor& tensor,
-    HostContext* host);
+    HostContext* host, PinnedHostMemoryPool* pinned_pool = nullptr);
 
 void RegisterGpuTensorConversionFn(TensorConversionFnRegistry* registry);
 
@@ -32,6 +32,7 @@ class GpuDevice;
 namespace tfrt {
 namespace gpu {
 class GpuAllocator;
+class PinnedHostMemoryPool;
 
 class GpuDevice : public Device, public DeviceTraits<GpuDevice> {
  public:
@@ -40,7 +41,10 @@ class GpuDevice : public Device, public DeviceTraits<GpuDevice> {
     return kName;
   }
 
-  explicit GpuDevice(string_view name, int gpu_ordinal);
+  // `num_streams` is the size of the pool of streams that independent ops can
+  // run on concurrently. The first stream of the pool is stream(). Devices
+  // using external GPU resources (see gpu_config.h) only have that stream.
+  explicit GpuDevice(string_view name, int gpu_ordinal, int num_streams = 1);
 
   llvm::Error Initialize();
 
@@ -49,17 +53,59 @@ class GpuDevice : public Device, public DeviceTraits<GpuDevice> {
   // this stream.
   wrapper::Stream stream() const;
 
-  // Allocator for allocating GPU device memory.
+  // Number of streams in the pool, at least one.
+  int num_streams() const;
+
+  // Stream `index` of the pool, and the Eigen device bound to it. Index 0 is
+  // stream().
+  wrapper::Stream stream(int index) const;
+  Eigen::GpuDevice* eigen_gpu_device(int index) const;
+
+  // Allocator for allocating GPU device memory. If the device has more than
+  // one stream, memory allocated or deallocated on the default stream is
+  // ordered on stream().
   AsyncValueRef<gpu::GpuAllocator> allocator() const;
 
+  // Pool of pinned host buffers for staging copies between host and device.
+  PinnedHostMemoryPool* pinned_host_memory_pool() const;
+
+  // The device and context this GpuDevice runs on.
+  wrapper::Device device() const;
+  wrapper::Context context() const;
+
+  // Stream for copies from this device to other GPUs, and for prefetching
+  // host data, so that they overlap with the work on stream(). Devices using
+  // external GPU resources copy on stream().
+  wrapper::Stream copy_stream() const;
+
+  // Returns whether this device can access the memory of `peer` directly, over
+  // NVLink or PCIe, and enables that access the first time it is queried for
+  // `peer`. The result is cached per peer.
+  llvm::Expected<bool> EnablePeerAccess(const GpuDevice& peer) const;
+
+  // Size of the GPU arena block to reserve for a request, see
+  // GpuRequestArenas. It is the arena usage of the last finished request.
+  size_t request_arena_size() const;
+  void set_request_arena_size(size_t size) const;
+
   // Eigen GPU device. Used to launch Eigen kernels.
   Eigen::GpuDevice* eigen_gpu_device() const;
 
-  // GPU BLAS library handle. Used to launch BLAS routines.
-  wrapper::BlasHandle blas_handle() const;
-
-  // GPU DNN library handle. Used to launch convolutions etc.
-  wrapper::DnnHandle dnn_handle() const;
+  // GPU BLAS library handle bound to stream `index`. Used to launch BLAS
+  // routines. The handle is created the first time it is requested, with
+  // `current` being the context of this device. Returns null if creating the
+  // handle failed. Thread-safe.
+  wrapper::BlasHandle blas_handle(wrapper::CurrentContext current,
+                                  int index = 0) const;
+
+  // GPU DNN library handle bound to stream `index`. Used to launch
+  // convolutions etc. Created on first use, like blas_handle().
+  wrapper::DnnHandle dnn_handle(wrapper::CurrentContext current,
+                                int index = 0) const;
+
+  // Creates the library handles of all streams, which are otherwise created on
+  // first use. See PrewarmGpuDevice() for doing so in the background.
+  llvm::Error InitializeLibraryHandles() const;
 
   // Set the context of current thread and return it. See the documentation
   // for wrapper::CurrentContext for more details.
@@ -26,11 +26,16 @@ class HostContext;
 namespace gpu {
 class GpuDevice;
 
-// Create and return a GPU device. If the device has been created before
-// return the existing device directly. Thread-safe.
-llvm::Expected<RCReference<GpuDevice>> GetOrCreateGpuDevice(string_view name,
-                                                            int gpu_ordinal,
-                                                            HostContext* host);
+// Create and return a GPU device with a pool of `num_streams` streams. If the
+// device has been created before return the existing device directly.
+// Thread-safe.
+llvm::Expected<RCReference<GpuDevice>> GetOrCreateGpuDevice(
+    string_view name, int gpu_ordinal, HostContext* host, int num_streams = 1);
+
+// Creates the BLAS and DNN handles of `device` on a blocking thread of `host`,
+// so that the first ops using them do not pay for it. Errors are logged, and
+// handles that failed stay null.
+void PrewarmGpuDevice(RCReference<GpuDevice> device, HostContext* host);
 
 }  // namespace gpu
 }  // namespace tfrt
@@ -22,6 +22,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Error.h"
@@ -29,6 +30,7 @@
 #include "mlir/IR/MLIRContext.h"
 #include "tfrt/gpu/gpu_types.h"
 #include "tfrt/gpu/wrapper/dense_map_utils.h"
+#include "tfrt/gpu/wrapper/driver_wrapper.h"
 #include "tfrt/gpu/wrapper/wrapper.h"
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/host_context/chain.h"
@@ -127,6 +129,50 @@ AsyncValueRef<Chain> Execute(const ExecutionContext& exec_ctx,
                              AsyncValueRef<GpuStream> stream,
                              ArrayRef<AsyncValueRef<GpuBuffer>> buffers);
 
+// Executes a BEF function by replaying the work it enqueues on the stream as
+// a GPU graph (CUDA graph or HIP graph). This removes the per-launch CPU
+// overhead of the individual kernel, memcpy and library calls.
+//
+// The first execution captures the stream work of the function into a graph
+// and instantiates it. Later executions with the same context and buffers
+// only launch the instantiated graph, without running the BEF function. When
+// the buffers change, the function is captured again and the parameters of
+// the instantiated graph are updated in place, which is much cheaper than
+// instantiating a new graph.
+//
+// The function must only enqueue work on the stream, with launch dimensions
+// that don't depend on buffer contents (i.e. static shapes). It must not
+// synchronize with the host, e.g. through tfrt_gpu.stream.synchronize or
+// tfrt_gpu.mem.copy to host memory.
+//
+// Execute() blocks until the arguments are available and the graph has been
+// launched. Concurrent calls are serialized.
+class CapturedFunction {
+ public:
+  explicit CapturedFunction(const Function& function) : function_(function) {}
+
+  AsyncValueRef<Chain> Execute(const ExecutionContext& exec_ctx,
+                               AsyncValueRef<Chain> chain,
+                               AsyncValueRef<GpuStream> stream,
+                               ArrayRef<AsyncValueRef<GpuBuffer>> buffers);
+
+ private:
+  // Captures the function into a graph and updates or creates graph_exec_.
+  llvm::Error Capture(wrapper::CurrentContext current,
+                      const ExecutionContext& exec_ctx,
+                      AsyncValueRef<Chain> chain,
+                      AsyncValueRef<GpuStream> stream,
+                      ArrayRef<AsyncValueRef<GpuBuffer>> buffers)
+      TFRT_REQUIRES(mutex_);
+
+  const Function& function_;
+  mutex mutex_;
+  // Context and buffer pointers of the captured graph.
+  AsyncValueRef<GpuContext> context_ TFRT_GUARDED_BY(mutex_);
+  std::vector<wrapper::Pointer<void>> pointers_ TFRT_GUARDED_BY(mutex_);
+  wrapper::OwningGraphExec graph_exec_ TFRT_GUARDED_BY(mutex_);
+};
+
 }  // namespace gpu
 }  // namespace tfrt
 
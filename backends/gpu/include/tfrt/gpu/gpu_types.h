@@ -26,10 +26,15 @@
 #include <map>
 #include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "tfrt/gpu/memory/pinned_host_memory_pool.h"
 #include "tfrt/gpu/wrapper/blas_wrapper.h"
 #include "tfrt/gpu/wrapper/ccl_types.h"
+#include "tfrt/gpu/wrapper/dense_map_utils.h"
 #include "tfrt/gpu/wrapper/dnn_wrapper.h"
 #include "tfrt/gpu/wrapper/driver_wrapper.h"
 #include "tfrt/gpu/wrapper/fft_wrapper.h"
@@ -75,6 +80,7 @@ class GpuContext {
   };
 
   class CallbackManager;
+  class HandlePool;
 
  public:
   template <typename T>
@@ -105,6 +111,13 @@ class GpuContext {
     return HostPoolMemory<T>(pointer, {host_memory_pool_.get(), size_bytes});
   }
 
+  // Pool of page-locked host buffers, rounded up to a power-of-two size class
+  // and reused across requests. Used to stage copies between pageable host
+  // memory and the GPU. Buffers must be destroyed before the context.
+  PinnedHostMemoryPool* pinned_host_memory_pool() const {
+    return pinned_host_memory_pool_.get();
+  }
+
   // Adds a 'callback' that will be invoked (from an unspecified thread) after
   // work that is currently enqueued on the 'stream' has completed.
   // Work enqueued afterwards does not wait for the callback to complete.
@@ -121,9 +134,27 @@ class GpuContext {
   // not be called. Returns whether all pending callbacks were invoked.
   Expected<bool> MaybeInvokeCallbacks() const;
 
+  // Creating FFT plans and solver handles takes milliseconds, which dominates
+  // running small transforms and factorizations. GpuFftHandle and
+  // GpuSolverHandle therefore return their plan or handle to the context when
+  // they are destroyed, and the Take*() functions below return one of these
+  // (or null if there is none) for reuse. Pooled plans and handles are only
+  // destroyed with the context.
+
+  // Takes a pooled FFT plan that was made with the same 'key'.
+  wrapper::OwningFftHandle TakeFftPlan(ArrayRef<int64_t> key) const;
+  void ReleaseFftPlan(ArrayRef<int64_t> key,
+                      wrapper::OwningFftHandle plan) const;
+
+  // Takes a pooled solver handle.
+  wrapper::OwningSolverHandle TakeSolverHandle() const;
+  void ReleaseSolverHandle(wrapper::OwningSolverHandle handle) const;
+
  private:
   wrapper::OwningContext context_;
   std::unique_ptr<HostMemoryPool> host_memory_pool_;
+  std::unique_ptr<HandlePool> handle_pool_;
+  RCReference<PinnedHostMemoryPool> pinned_host_memory_pool_;
   RCReference<CallbackManager> callback_manager_;
 };
 
@@ -171,17 +202,63 @@ class GpuModule {
  public:
   explicit GpuModule(AsyncValueRef<GpuContext> context,
                      wrapper::OwningModule module);
+  // Creates a module which does not own 'module', e.g. because it is owned by
+  // the GpuModuleCache.
+  GpuModule(AsyncValueRef<GpuContext> context, wrapper::Module module);
   ~GpuModule();
 
   GpuModule(GpuModule&&) = default;
   GpuModule& operator=(GpuModule&&) = default;
 
-  const wrapper::OwningModule& operator->() const { return module_; }
-  wrapper::Module get() const { return module_.get(); }
+  wrapper::Module get() const { return module_; }
 
  private:
   AsyncValueRef<GpuContext> context_;
-  wrapper::OwningModule module_;
+  wrapper::OwningModule owned_module_;
+  wrapper::Module module_;
+};
+
+// Process-wide cache of modules loaded into device primary contexts.
+//
+// Loading a module JIT-compiles PTX or HIP source, which takes much longer
+// than launching the kernels in it. Modules are therefore cached by the hash
+// of their image and the primary context they are loaded into, and shared by
+// all GpuModules created from the same image, e.g. when the same BEF file is
+// loaded more than once. The cache retains the primary contexts it has seen,
+// and cached modules are never unloaded.
+//
+// Modules loaded into other contexts are not cached, because those contexts
+// can be destroyed while the process is running.
+class GpuModuleCache {
+ public:
+  // Returns the process-wide instance.
+  static GpuModuleCache& Global();
+
+  // Returns the module of 'image' in the current context, calling 'load' to
+  // load it on first use. Returns null without calling 'load' if the current
+  // context is not a device primary context.
+  llvm::Expected<wrapper::Module> GetOrLoad(
+      wrapper::CurrentContext current, string_view image,
+      llvm::function_ref<llvm::Expected<wrapper::OwningModule>()> load);
+
+ private:
+  struct Entry {
+    mutex mu;
+    // Modules keyed by hash and size of their image.
+    llvm::DenseMap<std::pair<uint64_t, size_t>, wrapper::OwningModule> modules
+        TFRT_GUARDED_BY(mu);
+  };
+
+  // Returns the entry of the current context, or null if the current context
+  // is not a device primary context.
+  llvm::Expected<Entry*> GetEntry(wrapper::CurrentContext current);
+
+  mutex mutex_;
+  // Retained primary contexts, per device.
+  std::vector<std::pair<wrapper::Device, wrapper::Context>> primary_contexts_
+      TFRT_GUARDED_BY(mutex_);
+  llvm::DenseMap<wrapper::Context, std::unique_ptr<Entry>> entries_
+      TFRT_GUARDED_BY(mutex_);
 };
 
 class GpuFunction {
@@ -226,6 +303,12 @@ class GpuAllocator {
     return allocator->Deallocate(pointer, stream);
   }
 
+  static Error DeallocateAfter(GpuAllocator* allocator, GpuPointer pointer,
+                               ArrayRef<wrapper::Stream> streams) {
+    assert(allocator != nullptr);
+    return allocator->DeallocateAfter(pointer, streams);
+  }
+
  private:
   // Allocates memory of at least `size` bytes. If `stream` is the default, the
   // memory is accessible on any stream. Otherwise, accessing the memory on
@@ -236,6 +319,14 @@ class GpuAllocator {
   // Deallocates memory. If `stream` is not the default, any other stream
   // accessing the memory needs to be to be synchronized with `stream`.
   virtual Error Deallocate(GpuPointer pointer, wrapper::Stream stream) = 0;
+
+  // Deallocates memory which is used by the work enqueued so far on all of
+  // `streams`. The default implementation deallocates on the only stream, or
+  // otherwise waits for all streams on the host. Allocators which support it
+  // defer reusing the memory until the work has completed instead, see
+  // DeferredFreeGpuAllocator.
+  virtual Error DeallocateAfter(GpuPointer pointer,
+                                ArrayRef<wrapper::Stream> streams);
 };
 
 class GpuDefaultAllocator : public GpuAllocator {
@@ -319,6 +410,10 @@ class GpuBuffer {
   // accessing the buffer needs to be to be synchronized with `stream`.
   Error Deallocate(wrapper::Stream stream = {});
 
+  // Deallocates the buffer, which is used by the work enqueued so far on all
+  // of `streams`. No synchronization is needed by the caller.
+  Error DeallocateAfter(ArrayRef<wrapper::Stream> streams);
+
   explicit operator bool() const { return pointer_ != nullptr; }
   wrapper::Pointer<void> pointer() const { return pointer_; }
   size_t size() const { return size_; }
@@ -364,22 +459,67 @@ class GpuCclHandle {
   GpuCclHandle(GpuCclHandle&&) = default;
   GpuCclHandle& operator=(GpuCclHandle&&) = default;
 
+  // All-reduces of buffers smaller than this are fused into buckets.
+  static constexpr size_t kMaxFusedAllReduceBytes = 1 << 20;
+  // Maximum size of a bucket of fused all-reduces.
+  static constexpr size_t kAllReduceBucketBytes = 16 << 20;
+
   void AddCallback(Callback callback);
 
-  // Executes and clears all accumulated callbacks.
+  // Adds an all-reduce from 'input' to 'output'. Small all-reduces with the
+  // same data type and reduction op are fused: their inputs are copied into a
+  // flat bucket, which is reduced in place by a single collective and copied
+  // out to the outputs. Buckets only depend on the order of the calls, so all
+  // ranks fuse the same way.
+  void AddAllReduce(AsyncValueRef<GpuBuffer> input,
+                    AsyncValueRef<GpuBuffer> output,
+                    wrapper::CclDataType data_type,
+                    wrapper::CclReductionOp reduction_op);
+
+  // Executes and clears all accumulated callbacks and all-reduces.
   llvm::Error ExecuteCallbacks(wrapper::CurrentContext current,
                                wrapper::Stream stream);
 
+  // Same as above, but executes on a communication stream owned by the handle.
+  // The collectives wait for the work currently enqueued on 'stream'. The
+  // returned event is recorded when they complete, so 'stream' can run
+  // independent work (e.g. backward computation of the next layer) and only
+  // wait for the event when it needs the results.
+  llvm::Expected<wrapper::OwningEvent> ExecuteCallbacksAsync(
+      wrapper::CurrentContext current, wrapper::Stream stream);
+
   const wrapper::OwningCclComm& operator->() const { return comm_; }
   wrapper::CclComm get() const { return comm_.get(); }
 
   const AsyncValueRef<GpuContext>& context() const { return context_; }
 
  private:
+  struct AllReduce {
+    AsyncValueRef<GpuBuffer> input;
+    AsyncValueRef<GpuBuffer> output;
+    wrapper::CclDataType data_type;
+    wrapper::CclReductionOp reduction_op;
+  };
+
+  // Makes 'bucket_memory_' at least 'size_bytes' large and orders its use on
+  // 'stream' after previous uses.
+  llvm::Error ReserveBucketMemory(wrapper::CurrentContext current,
+                                  wrapper::Stream stream, size_t size_bytes);
+
   AsyncValueRef<GpuContext> context_;
   wrapper::OwningCclComm comm_;
   llvm::unique_function<void(wrapper::CclComm)> custom_deleter_;
   std::vector<Callback> callbacks_;
+  std::vector<AllReduce> all_reduces_;
+
+  // Flat buffer for fused all-reduces, reused across executions. The event is
+  // recorded after the last use.
+  wrapper::DeviceMemory<void> bucket_memory_;
+  size_t bucket_memory_size_ = 0;
+  wrapper::OwningEvent bucket_event_;
+
+  // Created on first use by ExecuteCallbacksAsync().
+  wrapper::OwningStream comm_stream_;
 };
 
 class GpuDnnHandle {
@@ -401,6 +541,8 @@ class GpuDnnHandle {
   wrapper::OwningDnnHandle handle_;
 };
 
+// Returns its handle to the context's pool when destroyed, see
+// GpuContext::TakeSolverHandle().
 class GpuSolverHandle {
  public:
   explicit GpuSolverHandle(AsyncValueRef<GpuContext> context,
@@ -420,10 +562,13 @@ class GpuSolverHandle {
   wrapper::OwningSolverHandle handle_;
 };
 
+// If created with a non-empty 'plan_key', returns its plan to the context's
+// pool when destroyed, see GpuContext::TakeFftPlan().
 class GpuFftHandle {
  public:
   explicit GpuFftHandle(AsyncValueRef<GpuContext> context,
-                        wrapper::OwningFftHandle handle, wrapper::FftType type);
+                        wrapper::OwningFftHandle handle, wrapper::FftType type,
+                        std::vector<int64_t> plan_key = {});
   ~GpuFftHandle();
 
   GpuFftHandle(GpuFftHandle&&) = default;
@@ -439,6 +584,7 @@ class GpuFftHandle {
   AsyncValueRef<GpuContext> context_;
   wrapper::OwningFftHandle handle_;
   wrapper::FftType type_;
+  std::vector<int64_t> plan_key_;
 };
 
 template <typename T>
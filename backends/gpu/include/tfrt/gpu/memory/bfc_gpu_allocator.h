@@ -20,14 +20,17 @@
 #ifndef TFRT_GPU_MEMORY_BFC_GPU_ALLOCATOR_H_
 #define TFRT_GPU_MEMORY_BFC_GPU_ALLOCATOR_H_
 
+#include <cstdint>
 #include <map>
 #include <set>
 #include <unordered_map>
+#include <vector>
 
 #include "llvm/Support/Error.h"
 #include "tfrt/gpu/gpu_types.h"
 #include "tfrt/gpu/wrapper/driver_wrapper.h"
 #include "tfrt/host_context/host_context.h"
+#include "tfrt/metrics/metrics.h"
 #include "tfrt/support/mutex.h"
 #include "tfrt/support/ref_count.h"
 #include "tfrt/support/thread_annotations.h"
@@ -42,8 +45,35 @@ namespace gpu {
 // coalescing.  One assumption we make is that the process using this
 // allocator owns pretty much all of the GPU memory, and that nearly
 // all requests to allocate GPU memory go through this interface.
+//
+// Memory usage is exported to the metrics registry under
+// /tfrt/gpu/bfc_allocator/device_<ordinal>/. The bytes in use, their peak and
+// the allocation latency are updated on every allocation and deallocation.
+// The largest free chunk and the per-bin chunk counts require a scan of all
+// chunks, and are only updated by GetStats() and when an allocation fails.
 class BfcGpuAllocator : public gpu::GpuAllocator {
  public:
+  struct BinStats {
+    size_t bin_size = 0;
+    int64_t num_chunks = 0;
+    int64_t num_chunks_in_use = 0;
+    size_t bytes_in_bin = 0;
+    size_t bytes_in_use = 0;
+  };
+
+  struct Stats {
+    // Bytes of the chunks handed out by Allocate().
+    size_t bytes_in_use = 0;
+    size_t peak_bytes_in_use = 0;
+    // Bytes allocated from the driver.
+    size_t bytes_reserved = 0;
+    // If an allocation fails while bytes_reserved - bytes_in_use would fit it,
+    // memory is fragmented.
+    size_t largest_free_chunk = 0;
+    int64_t num_allocs = 0;
+    std::vector<BinStats> bins;
+  };
+
   explicit BfcGpuAllocator(const wrapper::CurrentContext& current);
 
   // BfcGpuAllocator does not support streams. If it is asked to allocate
@@ -55,9 +85,27 @@ class BfcGpuAllocator : public gpu::GpuAllocator {
   llvm::Error Deallocate(gpu::GpuPointer pointer,
                          wrapper::Stream stream) override;
 
+  // Returns the current memory usage and exports it to the metrics registry.
+  Stats GetStats() const;
+
  private:
   struct Bin;
 
+  // Metrics, owned by the metrics registry.
+  struct Metrics {
+    metrics::Gauge<int64_t>* bytes_in_use;
+    metrics::Gauge<int64_t>* peak_bytes_in_use;
+    metrics::Gauge<int64_t>* bytes_reserved;
+    metrics::Gauge<int64_t>* largest_free_chunk;
+    metrics::Histogram* allocation_latency_us;
+    // Number of chunks and chunks in use, per bin.
+    std::vector<metrics::Gauge<int64_t>*> bin_chunks;
+    std::vector<metrics::Gauge<int64_t>*> bin_chunks_in_use;
+  };
+
+  Stats GetStatsLocked() const TFRT_REQUIRES(mu_);
+  void ExportStats(const Stats& stats) const;
+
   // Chunks point to GPU memory.  Their prev/next pointers form a
   // doubly-linked list of addresses sorted by GPU base address that
   // must be contiguous.  Chunks contain information about whether
@@ -146,6 +194,12 @@ class BfcGpuAllocator : public gpu::GpuAllocator {
   //  synchronization can happen after the stream is destroyed causing
   //  segfault.
   wrapper::Stream stream_ TFRT_GUARDED_BY(mu_);
+
+  size_t bytes_in_use_ TFRT_GUARDED_BY(mu_) = 0;
+  size_t peak_bytes_in_use_ TFRT_GUARDED_BY(mu_) = 0;
+  int64_t num_allocs_ TFRT_GUARDED_BY(mu_) = 0;
+
+  Metrics metrics_;
 };
 
 }  // namespace gpu
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Deferred free GPU allocator
+//
+// This file defines a GPU memory allocator that defers deallocations until the
+// work on the streams using the memory has completed.
+#ifndef TFRT_GPU_MEMORY_DEFERRED_FREE_GPU_ALLOCATOR_H_
+#define TFRT_GPU_MEMORY_DEFERRED_FREE_GPU_ALLOCATOR_H_
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Error.h"
+#include "tfrt/gpu/gpu_types.h"
+#include "tfrt/gpu/wrapper/driver_wrapper.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace gpu {
+// A thread-safe GPU memory allocator that forwards to an underlying allocator,
+// and makes deallocations stream-ordered across several streams.
+//
+// DeallocateAfter() records an event on each stream that used the memory and
+// returns without blocking. The memory is handed back to the underlying
+// allocator, as free on all streams, once all of those events have completed.
+// Completed deallocations are collected on every call to the allocator by
+// querying the events. Only when an allocation fails does the allocator wait
+// on the host for the pending deallocations, and then tries again.
+//
+// Deallocate() on a single stream is forwarded to the underlying allocator,
+// which orders it on that stream.
+class DeferredFreeGpuAllocator : public gpu::GpuAllocator {
+ public:
+  DeferredFreeGpuAllocator(const wrapper::CurrentContext& current,
+                           AsyncValueRef<GpuAllocator> allocator);
+  // Waits for the pending deallocations and completes them.
+  ~DeferredFreeGpuAllocator() override;
+
+  llvm::Expected<gpu::GpuPointer> Allocate(size_t num_bytes,
+                                           wrapper::Stream stream) override;
+
+  llvm::Error Deallocate(gpu::GpuPointer pointer,
+                         wrapper::Stream stream) override;
+
+  llvm::Error DeallocateAfter(gpu::GpuPointer pointer,
+                              ArrayRef<wrapper::Stream> streams) override;
+
+  // Number of deallocations waiting for their streams.
+  size_t num_pending() const;
+
+ private:
+  struct PendingFree {
+    GpuPointer pointer;
+    llvm::SmallVector<wrapper::OwningEvent, 2> events;
+  };
+
+  // Completes the pending deallocations whose events have completed. If
+  // `wait` is true, waits for all of them on the host.
+  llvm::Error CollectPending(bool wait);
+
+  wrapper::Context context_;
+  AsyncValueRef<GpuAllocator> allocator_;
+
+  mutable mutex mu_;
+  // Pending deallocations, in the order they were requested.
+  std::deque<PendingFree> pending_ TFRT_GUARDED_BY(mu_);
+  // Completed events, for reuse by later deallocations.
+  std::vector<wrapper::OwningEvent> free_events_ TFRT_GUARDED_BY(mu_);
+};
+
+}  // namespace gpu
+}  // namespace tfrt
+
+#endif  // TFRT_GPU_MEMORY_DEFERRED_FREE_GPU_ALLOCATOR_H_
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// GPU arena allocator
+//
+// This file defines a GPU memory allocator that suballocates from one block
+// with a bump pointer.
+#ifndef TFRT_GPU_MEMORY_GPU_ARENA_ALLOCATOR_H_
+#define TFRT_GPU_MEMORY_GPU_ARENA_ALLOCATOR_H_
+
+#include <atomic>
+#include <cstddef>
+
+#include "llvm/Support/Error.h"
+#include "tfrt/gpu/gpu_types.h"
+#include "tfrt/gpu/wrapper/driver_wrapper.h"
+#include "tfrt/host_context/async_value_ref.h"
+
+namespace tfrt {
+namespace gpu {
+// A thread-safe GPU memory allocator that bump allocates from a block
+// reserved from an underlying allocator. Deallocating memory of the block is a
+// no-op, so the arena is meant for the buffers of a single request. The block
+// is returned to the underlying allocator when the arena is destroyed, i.e.
+// after all buffers allocated from it are gone. Allocations that don't fit
+// into the block are forwarded to the underlying allocator.
+//
+// The block is reserved in the order of one stream. Allocations on other
+// streams make those streams wait for an event recorded after the
+// reservation. Allocations on the default stream are ordered on that stream.
+class GpuArenaAllocator : public gpu::GpuAllocator {
+ public:
+  // Reserves a block of `block_size` bytes from `allocator` on `stream`. If
+  // `block_size` is zero, all allocations are forwarded to `allocator`.
+  static llvm::Expected<AsyncValueRef<GpuArenaAllocator>> Create(
+      wrapper::CurrentContext current, AsyncValueRef<GpuAllocator> allocator,
+      size_t block_size, wrapper::Stream stream);
+
+  GpuArenaAllocator(AsyncValueRef<GpuAllocator> allocator,
+                    wrapper::Stream stream, GpuPointer block,
+                    size_t block_size, wrapper::OwningEvent reserved);
+  ~GpuArenaAllocator() override;
+
+  llvm::Expected<gpu::GpuPointer> Allocate(size_t num_bytes,
+                                           wrapper::Stream stream) override;
+
+  llvm::Error Deallocate(gpu::GpuPointer pointer,
+                         wrapper::Stream stream) override;
+
+  // Total size of the allocations so far, including the ones which did not
+  // fit into the block. An arena with a block of this size would not have
+  // forwarded any of them.
+  size_t requested_bytes() const {
+    return offset_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  bool Contains(GpuPointer pointer) const;
+
+  AsyncValueRef<GpuAllocator> allocator_;
+  wrapper::Stream stream_;
+  GpuPointer block_;
+  size_t block_size_;
+  // Recorded on `stream_` after reserving `block_`.
+  wrapper::OwningEvent reserved_;
+  std::atomic<size_t> offset_{0};
+};
+
+}  // namespace gpu
+}  // namespace tfrt
+
+#endif  // TFRT_GPU_MEMORY_GPU_ARENA_ALLOCATOR_H_
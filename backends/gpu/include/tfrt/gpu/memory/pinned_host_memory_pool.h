@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Pinned host memory pool
+//
+// This file defines a pool of page-locked host buffers used to stage copies
+// between host and GPU memory.
+#ifndef TFRT_GPU_MEMORY_PINNED_HOST_MEMORY_POOL_H_
+#define TFRT_GPU_MEMORY_PINNED_HOST_MEMORY_POOL_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Error.h"
+#include "tfrt/gpu/wrapper/driver_wrapper.h"
+#include "tfrt/host_context/host_buffer.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/ref_count.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace gpu {
+// A thread-safe pool of pinned (page-locked) host memory blocks.
+//
+// Copies between pageable host memory and the GPU are synchronous, and
+// allocating pinned memory for every copy is expensive. The pool hands out
+// HostBuffers backed by pinned blocks, rounded up to a power-of-two size
+// class, and takes the blocks back when the last reference to the buffer is
+// dropped. Each HostBuffer holds a reference to the pool, so the pool outlives
+// all buffers allocated from it.
+class PinnedHostMemoryPool : public ReferenceCounted<PinnedHostMemoryPool> {
+ public:
+  // `max_cached_bytes` bounds the total size of the free blocks kept for
+  // reuse. Blocks freed beyond that limit are returned to the driver.
+  explicit PinnedHostMemoryPool(size_t max_cached_bytes = kDefaultMaxCached);
+  ~PinnedHostMemoryPool();
+
+  // Returns a pinned host buffer of at least `size` bytes. `current` is only
+  // used if a new block needs to be allocated from the driver.
+  llvm::Expected<RCReference<HostBuffer>> Allocate(
+      wrapper::CurrentContext current, size_t size);
+
+  // Returns whether `ptr` is the start of a buffer allocated from the pool
+  // that has not been released yet.
+  bool IsPinned(const void* ptr) const;
+
+ private:
+  static constexpr size_t kDefaultMaxCached = size_t{256} << 20;
+
+  struct Block {
+    wrapper::HostMemory<void> memory;
+    size_t size = 0;
+  };
+
+  void Deallocate(void* ptr);
+
+  const size_t max_cached_bytes_;
+
+  mutable mutex mu_;
+  // Free blocks keyed by the log2 of their size.
+  llvm::DenseMap<unsigned, std::vector<Block>> free_blocks_
+      TFRT_GUARDED_BY(mu_);
+  size_t cached_bytes_ TFRT_GUARDED_BY(mu_) = 0;
+  // Blocks handed out by Allocate(), keyed by their start address.
+  llvm::DenseMap<const void*, Block> live_blocks_ TFRT_GUARDED_BY(mu_);
+};
+
+}  // namespace gpu
+}  // namespace tfrt
+
+#endif  // TFRT_GPU_MEMORY_PINNED_HOST_MEMORY_POOL_H_
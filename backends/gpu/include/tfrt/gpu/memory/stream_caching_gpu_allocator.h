@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Stream caching GPU allocator
+//
+// This file defines a GPU memory allocator that caches freed blocks per stream.
+#ifndef TFRT_GPU_MEMORY_STREAM_CACHING_GPU_ALLOCATOR_H_
+#define TFRT_GPU_MEMORY_STREAM_CACHING_GPU_ALLOCATOR_H_
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Error.h"
+#include "tfrt/gpu/gpu_types.h"
+#include "tfrt/gpu/wrapper/driver_wrapper.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace gpu {
+// A thread-safe GPU memory allocator that keeps freed blocks in per-stream
+// free lists, rounded up to a power-of-two size class.
+//
+// Memory deallocated on a stream is free in stream order, so a later
+// allocation on the same stream can reuse it without any synchronization.
+// Each stream has its own free lists and lock, so allocations on different
+// streams don't contend. Only the lookup of a block's size class on
+// deallocation takes one of several sharded locks.
+//
+// If the free list of the requested stream is empty, the allocator takes a
+// block from another stream and orders the reuse with an event recorded on
+// the stream that freed it. Memory deallocated on the default stream is not
+// used by any stream anymore and is shared by all streams.
+//
+// Freed blocks are only returned to the driver when an allocation runs out of
+// memory, or when the allocator is destroyed. Blocks larger than the biggest
+// size class are not cached.
+//
+// Like BfcGpuAllocator, the allocator is not notified when streams are
+// destroyed. Streams must outlive the memory deallocated on them.
+class StreamCachingGpuAllocator : public gpu::GpuAllocator {
+ public:
+  explicit StreamCachingGpuAllocator(const wrapper::CurrentContext& current);
+  ~StreamCachingGpuAllocator() override;
+
+  llvm::Expected<gpu::GpuPointer> Allocate(size_t num_bytes,
+                                           wrapper::Stream stream) override;
+
+  llvm::Error Deallocate(gpu::GpuPointer pointer,
+                         wrapper::Stream stream) override;
+
+ private:
+  // Size classes are powers of two from 256 bytes to 256 MiB.
+  static constexpr int kMinSizeLog2 = 8;
+  static constexpr int kMaxSizeLog2 = 28;
+  static constexpr int kNumSizeClasses = kMaxSizeLog2 - kMinSizeLog2 + 1;
+  // Size class of blocks that are not cached.
+  static constexpr int kUncached = -1;
+  // Capacity of the table of per-stream caches.
+  static constexpr int kMaxStreams = 64;
+  static constexpr int kNumShards = 16;
+
+  using FreeLists = std::array<std::vector<GpuPointer>, kNumSizeClasses>;
+
+  struct StreamCache {
+    explicit StreamCache(wrapper::Stream stream) : stream(stream) {}
+
+    const wrapper::Stream stream;
+    mutex mu;
+    FreeLists free_lists TFRT_GUARDED_BY(mu);
+  };
+
+  // Size classes of the blocks handed out by Allocate(), keyed by pointer.
+  struct alignas(64) Shard {
+    mutex mu;
+    llvm::DenseMap<void*, int> size_classes TFRT_GUARDED_BY(mu);
+  };
+
+  static int GetSizeClass(size_t num_bytes);
+  Shard& GetShard(GpuPointer pointer);
+
+  // Returns the cache of 'stream', creating it if necessary. Returns nullptr
+  // for the default stream, or if the table of stream caches is full.
+  StreamCache* GetStreamCache(wrapper::Stream stream);
+
+  // Takes a free block of 'size_class' from a stream other than 'stream', or
+  // from the shared free lists. Returns nullptr if there is none.
+  llvm::Expected<GpuPointer> TakeOtherBlock(int size_class,
+                                            wrapper::Stream stream);
+
+  // Makes work enqueued on 'stream' after this call wait for the work already
+  // enqueued on 'other'. If 'stream' is the default stream, waits on the host.
+  llvm::Error WaitForStream(wrapper::Stream stream, wrapper::Stream other);
+
+  // Returns all cached blocks to the driver.
+  llvm::Error ReleaseCachedBlocks();
+
+  llvm::Expected<GpuPointer> AllocateAndTrack(size_t num_bytes,
+                                              int size_class);
+
+  wrapper::Context context_;
+
+  std::array<Shard, kNumShards> shards_;
+
+  // Open addressing hash table of stream caches, read without locking. Caches
+  // are only added, and never removed before the allocator is destroyed.
+  std::array<std::atomic<StreamCache*>, kMaxStreams> stream_caches_ = {};
+
+  mutex mu_;
+  std::vector<std::unique_ptr<StreamCache>> owned_stream_caches_
+      TFRT_GUARDED_BY(mu_);
+  // Blocks deallocated on the default stream.
+  FreeLists shared_free_lists_ TFRT_GUARDED_BY(mu_);
+};
+
+}  // namespace gpu
+}  // namespace tfrt
+
+#endif  // TFRT_GPU_MEMORY_STREAM_CACHING_GPU_ALLOCATOR_H_
@@ -117,6 +117,18 @@ std::unique_ptr<mlir::OperationPass<mlir::ModuleOp>> CreateSetEntryPointPass(
     wrapper::Platform platform, mlir::StringRef function_name,
     mlir::ArrayRef<int64_t> buffer_sizes);
 
+// Creates a pass which converts f16 and bf16 tf.Conv2D corert.executeop ops
+// from NCHW to NHWC, the layout tensor cores compute in, and removes the
+// resulting transposes where possible.
+std::unique_ptr<mlir::OperationPass<mlir::func::FuncOp>>
+CreateTensorCoreLayoutPass();
+
+// Creates a pass which suballocates the buffers that a function allocates and
+// deallocates itself from one slab per stream. Buffers with disjoint lifetimes
+// share memory.
+std::unique_ptr<mlir::OperationPass<mlir::func::FuncOp>>
+CreateMemoryPlanningPass();
+
 }  // namespace gpu
 }  // namespace tfrt
 
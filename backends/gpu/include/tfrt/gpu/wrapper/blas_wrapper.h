@@ -101,6 +101,13 @@ llvm::Error BlasTrsmBatched(CurrentContext current, BlasHandle handle,
                             Pointer<const void> alpha, Pointer<const void*> A,
                             int lda, Pointer<void*> B, int ldb, int batchCount);
 
+// LU factorization with partial pivoting of an array of n x n matrices. Uses
+// rocSOLVER on ROCm, which takes the rocBLAS handle.
+llvm::Error BlasGetrfBatched(CurrentContext current, BlasHandle handle,
+                             BlasDataType dataType, int n, Pointer<void*> A,
+                             int lda, Pointer<int> pivotArray,
+                             Pointer<int> infoArray, int batchCount);
+
 }  // namespace wrapper
 }  // namespace gpu
 }  // namespace tfrt
@@ -144,6 +144,12 @@ llvm::Error CublasTrsmBatched(CurrentContext current, cublasHandle_t handle,
                               Pointer<const void*> A, int lda, Pointer<void*> B,
                               int ldb, int batchCount);
 
+llvm::Error CublasGetrfBatched(CurrentContext current, cublasHandle_t handle,
+                               cudaDataType dataType, int n,
+                               Pointer<void*> Aarray, int lda,
+                               Pointer<int> pivotArray, Pointer<int> infoArray,
+                               int batchSize);
+
 }  // namespace wrapper
 }  // namespace gpu
 }  // namespace tfrt
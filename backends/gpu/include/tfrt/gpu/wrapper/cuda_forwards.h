@@ -25,6 +25,8 @@ using CUmodule = struct CUmod_st *;
 using CUstream = struct CUstream_st *;
 using CUevent = struct CUevent_st *;
 using CUfunction = struct CUfunc_st *;
+using CUgraph = struct CUgraph_st *;
+using CUgraphExec = struct CUgraphExec_st *;
 
 // Enums for corresponding #defines in the CUDA headers.
 enum CUmemhostalloc_flags_enum : int {
@@ -106,6 +106,8 @@ llvm::Expected<int> CuStreamGetPriority(CUstream stream);
 llvm::Error CuStreamSynchronize(CUstream stream);
 llvm::Expected<bool> CuStreamQuery(CUstream stream);
 llvm::Error CuStreamWaitEvent(CUstream stream, CUevent event);
+llvm::Error CuStreamBeginCapture(CUstream stream, CUstreamCaptureMode mode);
+llvm::Expected<OwningGraph> CuStreamEndCapture(CUstream stream);
 
 llvm::Expected<OwningEvent> CuEventCreate(CurrentContext current,
                                           CUevent_flags flags);
@@ -211,6 +213,13 @@ llvm::Error CuLaunchCooperativeKernel(
     unsigned shared_memory_size_bytes, CUstream stream,
     llvm::ArrayRef<const void*> arguments);
 
+llvm::Error CuGraphDestroy(CUgraph graph);
+llvm::Expected<OwningGraphExec> CuGraphInstantiate(CurrentContext current,
+                                                   CUgraph graph);
+llvm::Error CuGraphExecDestroy(CUgraphExec graph_exec);
+llvm::Expected<bool> CuGraphExecUpdate(CUgraphExec graph_exec, CUgraph graph);
+llvm::Error CuGraphLaunch(CUgraphExec graph_exec, CUstream stream);
+
 llvm::Expected<int> CuOccupancyMaxActiveBlocksPerMultiprocessor(
     CurrentContext current, CUfunction function, int block_size,
     size_t dynamic_shared_memory_size);
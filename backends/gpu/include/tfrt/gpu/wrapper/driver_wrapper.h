@@ -71,6 +71,8 @@ using Module = Resource<CUmodule, hipModule_t>;
 // with PointerIntPair. Will fail runtime asserts if used.
 using Event = Resource<CUevent, hipEvent_t>;
 using Function = Resource<CUfunction, hipFunction_t>;
+using Graph = Resource<CUgraph, hipGraph_t>;
+using GraphExec = Resource<CUgraphExec, hipGraphExec_t>;
 
 namespace internal {
 struct ModuleDeleter {
@@ -81,6 +83,14 @@ struct EventDeleter {
   using pointer = Event;
   void operator()(Event event) const;
 };
+struct GraphDeleter {
+  using pointer = Graph;
+  void operator()(Graph graph) const;
+};
+struct GraphExecDeleter {
+  using pointer = GraphExec;
+  void operator()(GraphExec graph_exec) const;
+};
 
 struct DeviceMemoryDeallocator {
   void operator()(Pointer<void> pointer) const;
@@ -107,6 +117,8 @@ using OwningMemory = std::unique_ptr<T, MemoryDeleter<T, Deleter>>;
 // appropriate care.
 using OwningModule = internal::OwningResource<internal::ModuleDeleter>;
 using OwningEvent = internal::OwningResource<internal::EventDeleter>;
+using OwningGraph = internal::OwningResource<internal::GraphDeleter>;
+using OwningGraphExec = internal::OwningResource<internal::GraphExecDeleter>;
 
 // RAII wrappers for GPU memory. Instances own the underlying memory.
 template <typename T>
@@ -184,6 +196,11 @@ llvm::Expected<StreamFlags> StreamGetFlags(Stream stream);
 llvm::Error StreamSynchronize(Stream stream);
 llvm::Expected<bool> StreamQuery(Stream stream);
 llvm::Error StreamWaitEvent(Stream stream, Event event);
+// Begins capturing the work enqueued on 'stream' into a graph instead of
+// executing it. Uses the relaxed capture mode, i.e. other threads may keep
+// calling APIs which are unsafe during capture.
+llvm::Error StreamBeginCapture(Stream stream);
+llvm::Expected<OwningGraph> StreamEndCapture(Stream stream);
 
 llvm::Expected<OwningEvent> EventCreate(CurrentContext current,
                                         EventFlags flags);
@@ -278,6 +295,16 @@ llvm::Error LaunchCooperativeKernel(CurrentContext current, Function function,
                                     Stream stream,
                                     llvm::ArrayRef<void*> arguments);
 
+llvm::Error GraphDestroy(Graph graph);
+llvm::Expected<OwningGraphExec> GraphInstantiate(CurrentContext current,
+                                                 Graph graph);
+llvm::Error GraphExecDestroy(GraphExec graph_exec);
+// Updates the node parameters (e.g. kernel arguments) of 'graph_exec' to the
+// ones of 'graph'. Returns false if the topology differs and 'graph' needs to
+// be instantiated instead.
+llvm::Expected<bool> GraphExecUpdate(GraphExec graph_exec, Graph graph);
+llvm::Error GraphLaunch(GraphExec graph_exec, Stream stream);
+
 llvm::Expected<int> OccupancyMaxActiveBlocksPerMultiprocessor(
     CurrentContext current, Function function, int block_size,
     size_t dynamic_shared_memory_size);
@@ -107,6 +107,9 @@ llvm::Expected<hipStreamFlags_t> HipStreamGetFlags(hipStream_t stream);
 llvm::Error HipStreamSynchronize(hipStream_t stream);
 llvm::Expected<bool> HipStreamQuery(hipStream_t stream);
 llvm::Error HipStreamWaitEvent(hipStream_t stream, hipEvent_t event);
+llvm::Error HipStreamBeginCapture(hipStream_t stream,
+                                  hipStreamCaptureMode mode);
+llvm::Expected<OwningGraph> HipStreamEndCapture(hipStream_t stream);
 
 llvm::Expected<OwningEvent> HipEventCreate(CurrentContext current,
                                            hipEventFlags_t flags);
@@ -189,6 +192,14 @@ llvm::Error HipLaunchCooperativeKernel(
     unsigned shared_memory_size_bytes, hipStream_t stream,
     llvm::ArrayRef<void*> arguments);
 
+llvm::Error HipGraphDestroy(hipGraph_t graph);
+llvm::Expected<OwningGraphExec> HipGraphInstantiate(CurrentContext current,
+                                                    hipGraph_t graph);
+llvm::Error HipGraphExecDestroy(hipGraphExec_t graph_exec);
+llvm::Expected<bool> HipGraphExecUpdate(hipGraphExec_t graph_exec,
+                                        hipGraph_t graph);
+llvm::Error HipGraphLaunch(hipGraphExec_t graph_exec, hipStream_t stream);
+
 llvm::Expected<int> HipOccupancyMaxActiveBlocksPerMultiprocessor(
     CurrentContext current, hipFunction_t function, int block_size,
     size_t dynamic_shared_memory_size);
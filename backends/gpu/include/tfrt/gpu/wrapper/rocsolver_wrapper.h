@@ -39,6 +39,11 @@ llvm::Error RocsolverPotrfBatched(CurrentContext current, rocblas_handle handle,
                                   rocblas_fill fillMode, int n,
                                   Pointer<void *> Aarray, int heightA,
                                   Pointer<int> devInfo, int batchSize);
+llvm::Error RocsolverGetrfBatched(CurrentContext current, rocblas_handle handle,
+                                  rocblas_datatype dataType, int n,
+                                  Pointer<void *> Aarray, int heightA,
+                                  Pointer<int> pivotArray, Pointer<int> devInfo,
+                                  int batchSize);
 
 }  // namespace wrapper
 }  // namespace gpu
@@ -0,0 +1,117 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the autotuning cache.
+
+#include "tfrt/gpu/autotune/autotune_cache.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/support/logging.h"
+#include "tfrt/support/string_util.h"
+
+namespace tfrt {
+namespace gpu {
+
+AutotuneCache::AutotuneCache(std::string path) : path_(std::move(path)) {
+  if (!path_.empty()) Load();
+}
+
+AutotuneCache& AutotuneCache::Global() {
+  static auto* cache = [] {
+    const char* path = std::getenv("TFRT_GPU_AUTOTUNE_CACHE");
+    return new AutotuneCache(path ? path : "");
+  }();
+  return *cache;
+}
+
+std::string AutotuneCache::MakeKey(string_view device, string_view problem) {
+  return StrCat(device, "\t", problem);
+}
+
+llvm::Optional<AutotuneResult> AutotuneCache::Lookup(
+    string_view device, string_view problem) const {
+  mutex_lock lock(mutex_);
+  auto it = results_.find(MakeKey(device, problem));
+  if (it == results_.end()) return llvm::None;
+  return it->second;
+}
+
+AutotuneResult AutotuneCache::Insert(string_view device, string_view problem,
+                                     const AutotuneResult& result) {
+  std::string key = MakeKey(device, problem);
+  mutex_lock lock(mutex_);
+  auto pair = results_.try_emplace(key, result);
+  if (!pair.second || path_.empty()) return pair.first->second;
+
+  // Append the new result, so that concurrent processes don't drop results.
+  std::error_code error_code;
+  llvm::raw_fd_ostream os(path_, error_code,
+                          llvm::sys::fs::OF_Append | llvm::sys::fs::OF_Text);
+  if (error_code) {
+    TFRT_LOG(WARNING) << "Failed to open autotune cache " << path_ << ": "
+                      << error_code.message();
+  } else {
+    os << key << '\t' << result.algorithm << '\t' << result.workspace_bytes
+       << '\t' << result.math_type << '\n';
+  }
+  return result;
+}
+
+void AutotuneCache::Load() {
+  auto buffer = llvm::MemoryBuffer::getFile(path_, /*IsText=*/true);
+  // The file is created when the first result is inserted.
+  if (!buffer) return;
+
+  llvm::SmallVector<llvm::StringRef, 16> lines;
+  (*buffer)->getBuffer().split(lines, '\n', /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  mutex_lock lock(mutex_);
+  for (llvm::StringRef line : lines) {
+    // device, problem, algorithm, workspace bytes, math type.
+    llvm::SmallVector<llvm::StringRef, 5> fields;
+    line.split(fields, '\t');
+    AutotuneResult result;
+    if (fields.size() != 5 || fields[2].getAsInteger(10, result.algorithm) ||
+        fields[3].getAsInteger(10, result.workspace_bytes) ||
+        fields[4].getAsInteger(10, result.math_type)) {
+      TFRT_LOG(WARNING) << "Ignoring malformed line in autotune cache "
+                        << path_ << ": " << line;
+      continue;
+    }
+    results_[MakeKey(fields[0], fields[1])] = result;
+  }
+}
+
+llvm::Expected<std::string> GetAutotuneDeviceKey(
+    wrapper::CurrentContext current) {
+  auto device = wrapper::CtxGetDevice(current);
+  if (!device) return device.takeError();
+  auto name = wrapper::DeviceGetName(*device);
+  if (!name) return name.takeError();
+  auto total_mem = wrapper::DeviceTotalMem(*device);
+  if (!total_mem) return total_mem.takeError();
+  // Tabs separate the fields of the cache file.
+  std::replace(name->begin(), name->end(), '\t', ' ');
+  return StrCat(current.platform(), ":", *name, ":", *total_mem);
+}
+
+}  // namespace gpu
+}  // namespace tfrt
@@ -16,8 +16,17 @@
 
 #include "tfrt/gpu/core_runtime/gpu_op_handler.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include "gpu_op_registry_impl.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Error.h"
 #include "tfrt/core_runtime/core_runtime.h"
@@ -34,7 +43,10 @@
 #include "tfrt/host_context/device.h"
 #include "tfrt/host_context/execution_context.h"
 #include "tfrt/support/error_util.h"
+#include "tfrt/support/logging.h"
+#include "tfrt/support/mutex.h"
 #include "tfrt/support/string_util.h"
+#include "tfrt/support/thread_annotations.h"
 #include "tfrt/tensor/conversion_registry.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 #include "tfrt/tensor/host_tensor.h"
@@ -47,6 +59,196 @@ class Tensor;
 namespace gpu {
 class GpuOpRegistry;
 
+namespace {
+// Allocator of an op dispatched on a side stream of the device's pool.
+//
+// Memory allocated on the default stream is allocated on the side stream.
+// Until the side stream has been joined into the device stream, memory
+// deallocated on the default stream (e.g. temporary buffers) is only used by
+// the op and is deallocated on the side stream. Afterwards it is deallocated
+// on the device stream, which is ordered after all ops using it.
+class SideStreamAllocator : public GpuAllocator {
+ public:
+  SideStreamAllocator(AsyncValueRef<GpuAllocator> allocator,
+                      wrapper::Stream stream)
+      : allocator_(std::move(allocator)), stream_(stream) {}
+
+  void SetJoined() { joined_.store(true, std::memory_order_release); }
+
+ private:
+  Expected<GpuPointer> Allocate(size_t size, wrapper::Stream stream) override {
+    if (stream == nullptr) stream = stream_;
+    return GpuAllocator::Allocate(&allocator_.get(), size, stream);
+  }
+
+  Error Deallocate(GpuPointer pointer, wrapper::Stream stream) override {
+    if (stream == nullptr && !joined_.load(std::memory_order_acquire))
+      stream = stream_;
+    return GpuAllocator::Deallocate(&allocator_.get(), pointer, stream);
+  }
+
+  AsyncValueRef<GpuAllocator> allocator_;
+  wrapper::Stream stream_;
+  std::atomic<bool> joined_{false};
+};
+
+// Assigns ops to the streams of a GpuDevice's pool, following the rule of the
+// compiler's stream analysis (see tfrt/compiler/stream_analysis.h): an op
+// continues on the stream of an input if the op producing it is still the
+// last op of that stream. Otherwise, independent ops are spread round-robin
+// over the side streams. That analysis is not visible at op dispatch, so the
+// dataflow is reconstructed from the GPU buffers of the ops' inputs and
+// results.
+//
+// Ops on a side stream wait for the events of inputs produced on other
+// streams. Afterwards, the device stream waits for the op, which keeps the
+// GpuDispatchContext contract that results are ready on the device stream.
+// Ops with inputs of unknown origin run on the device stream.
+class GpuStreamAssigner {
+ public:
+  explicit GpuStreamAssigner(int num_streams)
+      : last_ops_(num_streams, kNoOp) {}
+
+  struct Assignment {
+    int stream_index;
+    uint64_t op_id;
+  };
+
+  // Returns the stream for an op reading `inputs`, after making it wait for
+  // the inputs produced on other streams.
+  Expected<Assignment> Assign(const GpuDevice& device,
+                              ArrayRef<AsyncValue*> inputs);
+
+  // Records an event on the stream after the op `assignment` and joins a side
+  // stream into the device stream. Tracks the GPU buffers of `results`.
+  Error Finish(const GpuDevice& device, wrapper::CurrentContext current,
+               Assignment assignment,
+               ArrayRef<RCReference<AsyncValue>> results);
+
+ private:
+  static constexpr uint64_t kNoOp = 0;
+  // Minimum number of tracked buffers before pruning.
+  static constexpr size_t kMinPruneSize = 64;
+
+  // The op producing a GPU buffer.
+  struct Producer {
+    // Keeps the buffer, and therefore the key of the entry, alive.
+    RCReference<AsyncValue> buffer;
+    int stream_index;
+    uint64_t op_id;
+    // Recorded on the stream after the op.
+    std::shared_ptr<wrapper::OwningEvent> event;
+  };
+
+  // Drops buffers only referenced by the producer map. Returns them so that
+  // they are deallocated outside of the lock.
+  std::vector<RCReference<AsyncValue>> Prune() TFRT_REQUIRES(mutex_);
+
+  mutex mutex_;
+  uint64_t next_op_id_ TFRT_GUARDED_BY(mutex_) = kNoOp;
+  int next_side_stream_ TFRT_GUARDED_BY(mutex_) = 0;
+  // Id of the last op assigned to each stream.
+  std::vector<uint64_t> last_ops_ TFRT_GUARDED_BY(mutex_);
+  llvm::DenseMap<const GpuBuffer*, Producer> producers_ TFRT_GUARDED_BY(mutex_);
+  size_t prune_size_ TFRT_GUARDED_BY(mutex_) = kMinPruneSize;
+};
+
+Expected<GpuStreamAssigner::Assignment> GpuStreamAssigner::Assign(
+    const GpuDevice& device, ArrayRef<AsyncValue*> inputs) {
+  Assignment assignment;
+  std::vector<const Producer*> producers;
+  std::vector<std::shared_ptr<wrapper::OwningEvent>> events;
+  {
+    mutex_lock lock(mutex_);
+    assignment.op_id = ++next_op_id_;
+    bool unknown_input = false;
+    for (AsyncValue* input : inputs) {
+      if (!input->IsType<DenseGpuTensor>()) continue;
+      auto it = producers_.find(&input->get<DenseGpuTensor>().buffer());
+      if (it == producers_.end()) {
+        unknown_input = true;
+        break;
+      }
+      producers.push_back(&it->second);
+    }
+
+    auto continues = [&](const Producer* producer) {
+      return last_ops_[producer->stream_index] == producer->op_id;
+    };
+    int num_streams = last_ops_.size();
+    if (unknown_input) {
+      assignment.stream_index = 0;
+    } else if (auto it = llvm::find_if(producers, continues);
+               it != producers.end()) {
+      assignment.stream_index = (*it)->stream_index;
+    } else {
+      assignment.stream_index = 1 + next_side_stream_;
+      next_side_stream_ = (next_side_stream_ + 1) % (num_streams - 1);
+    }
+    last_ops_[assignment.stream_index] = assignment.op_id;
+
+    // The device stream has already waited for all ops on side streams.
+    if (assignment.stream_index != 0) {
+      for (const Producer* producer : producers) {
+        if (producer->stream_index != assignment.stream_index)
+          events.push_back(producer->event);
+      }
+    }
+  }
+
+  wrapper::Stream stream = device.stream(assignment.stream_index);
+  for (const auto& event : events) {
+    if (auto error = wrapper::StreamWaitEvent(stream, event->get()))
+      return std::move(error);
+  }
+  return assignment;
+}
+
+Error GpuStreamAssigner::Finish(const GpuDevice& device,
+                                wrapper::CurrentContext current,
+                                Assignment assignment,
+                                ArrayRef<RCReference<AsyncValue>> results) {
+  wrapper::Stream stream = device.stream(assignment.stream_index);
+  auto event = wrapper::EventCreateNoTiming(current);
+  if (!event) return event.takeError();
+  if (auto error = wrapper::EventRecord(event->get(), stream)) return error;
+  if (assignment.stream_index != 0) {
+    if (auto error = wrapper::StreamWaitEvent(device.stream(), event->get()))
+      return error;
+  }
+  auto shared_event =
+      std::make_shared<wrapper::OwningEvent>(std::move(event.get()));
+
+  // Declared before the lock, so that pruned buffers are deallocated after the
+  // lock is released.
+  std::vector<RCReference<AsyncValue>> pruned;
+  mutex_lock lock(mutex_);
+  for (const auto& result : results) {
+    // Results which become available later are of unknown origin.
+    if (!result || !result->IsAvailable() ||
+        !result->IsType<DenseGpuTensor>())
+      continue;
+    const auto& tensor = result->get<DenseGpuTensor>();
+    producers_[&tensor.buffer()] =
+        Producer{tensor.CopyBufferRef().ReleaseRCRef(),
+                 assignment.stream_index, assignment.op_id, shared_event};
+  }
+  if (producers_.size() >= prune_size_) pruned = Prune();
+  return Error::success();
+}
+
+std::vector<RCReference<AsyncValue>> GpuStreamAssigner::Prune() {
+  std::vector<RCReference<AsyncValue>> pruned;
+  for (auto it = producers_.begin(); it != producers_.end(); ++it) {
+    if (!it->second.buffer->IsUnique()) continue;
+    pruned.push_back(std::move(it->second.buffer));
+    producers_.erase(it);
+  }
+  prune_size_ = std::max(kMinPruneSize, 2 * producers_.size());
+  return pruned;
+}
+}  // namespace
+
 class GpuOpHandler : public OpHandler {
  public:
   explicit GpuOpHandler(CoreRuntime* runtime, OpHandler* fallback,
@@ -55,15 +257,36 @@ class GpuOpHandler : public OpHandler {
 
   Expected<CoreRuntimeOp> MakeOp(string_view op_name) override;
 
-  Expected<GpuDispatchContext> MakeGpuDispatchContext();
+  Expected<GpuDispatchContext> MakeGpuDispatchContext(
+      const ExecutionContext& exec_ctx);
+
+  // Returns the arena of the request if it has GpuRequestArenas, otherwise
+  // the device allocator.
+  Expected<AsyncValueRef<GpuAllocator>> GetAllocator(
+      const ExecutionContext& exec_ctx);
 
   RCReference<Device> GetDeviceRef() { return device_; }
 
+  // Runs the ops allowed by `policy` in mixed precision.
+  Error EnableMixedPrecision(const GpuMixedPrecisionPolicy& policy);
+
+  void Dispatch(const GpuOpEntry& op_entry, ArrayRef<AsyncValue*> inputs,
+                const OpAttrsRef& attrs, ArrayRef<TensorMetadata> result_mds,
+                MutableArrayRef<RCReference<AsyncValue>> results,
+                AsyncValueRef<Chain>* chain, const ExecutionContext& exec_ctx);
+
  private:
   const GpuOpRegistry op_registry_;
 
   RCReference<GpuDevice> device_;
 
+  // Null if the device has a single stream.
+  std::unique_ptr<GpuStreamAssigner> stream_assigner_;
+
+  // The ops which run in mixed precision, and the dtype they compute in.
+  llvm::DenseSet<const GpuOpEntry*> mixed_precision_ops_;
+  DType mixed_precision_dtype_ = DType::Invalid;
+
   friend llvm::Expected<OpHandler*> CreateGpuOpHandler(
       CoreRuntime* runtime, RCReference<Device> device, OpHandler* fallback);
 };
@@ -80,16 +303,8 @@ struct GpuOpHandlerTraits {
                        MutableArrayRef<RCReference<AsyncValue>> results,
                        AsyncValueRef<Chain>* chain,
                        const ExecutionContext& exec_ctx) {
-    llvm::Expected<GpuDispatchContext> dctx =
-        gpu_op_handler->MakeGpuDispatchContext();
-    if (!dctx) {
-      if (chain && *chain)
-        chain->SetError(absl::InternalError(toString(dctx.takeError())));
-      return;
-    }
-
-    op_entry.dispatch_fn(exec_ctx, &dctx.get(), inputs, attrs, result_mds,
-                         results, chain);
+    gpu_op_handler->Dispatch(op_entry, inputs, attrs, result_mds, results,
+                             chain, exec_ctx);
   }
 
   // TODO(fishx): Remove this method.
@@ -123,15 +338,140 @@ llvm::Expected<OpHandler*> CreateGpuOpHandler(CoreRuntime* runtime,
   return gpu_op_handler_ptr;
 }
 
+llvm::Expected<OpHandler*> CreateGpuOpHandler(
+    CoreRuntime* runtime, RCReference<GpuDevice> device, OpHandler* fallback,
+    const GpuMixedPrecisionPolicy& mixed_precision) {
+  GpuOpRegistry op_registry;
+  RegisterStaticGpuOps(&op_registry);
+  auto gpu_op_handler = std::make_unique<GpuOpHandler>(
+      runtime, fallback, std::move(op_registry), std::move(device));
+  if (auto error = gpu_op_handler->EnableMixedPrecision(mixed_precision))
+    return std::move(error);
+
+  auto gpu_op_handler_ptr = gpu_op_handler.get();
+  runtime->TakeOpHandler(std::move(gpu_op_handler));
+  return gpu_op_handler_ptr;
+}
+
 GpuOpHandler::GpuOpHandler(CoreRuntime* runtime, OpHandler* fallback,
                            GpuOpRegistry op_registry,
                            RCReference<GpuDevice> device)
     : OpHandler("gpu", runtime, fallback),
       op_registry_(std::move(op_registry)),
-      device_(std::move(device)) {}
+      device_(std::move(device)) {
+  if (device_->num_streams() > 1) {
+    stream_assigner_ =
+        std::make_unique<GpuStreamAssigner>(device_->num_streams());
+  }
+}
+
+Error GpuOpHandler::EnableMixedPrecision(
+    const GpuMixedPrecisionPolicy& policy) {
+  if (policy.compute_dtype != DType::F16 && policy.compute_dtype != DType::BF16)
+    return MakeStringError("Unsupported mixed precision dtype: ",
+                           policy.compute_dtype);
+  mixed_precision_dtype_ = policy.compute_dtype;
+  for (const auto& op_name : policy.allow_list) {
+    if (llvm::is_contained(policy.deny_list, op_name)) continue;
+    auto* op_entry = op_registry_.impl_->LookupOpEntry(op_name);
+    if (op_entry->dispatch_fn == nullptr) continue;
+    mixed_precision_ops_.insert(op_entry);
+  }
+  return Error::success();
+}
+
+Expected<GpuDispatchContext> GpuOpHandler::MakeGpuDispatchContext(
+    const ExecutionContext& exec_ctx) {
+  TFRT_ASSIGN_OR_RETURN(auto allocator, GetAllocator(exec_ctx));
+  return GpuDispatchContext::Create(device_.get(), /*stream_index=*/0,
+                                    std::move(allocator));
+}
+
+Expected<AsyncValueRef<GpuAllocator>> GpuOpHandler::GetAllocator(
+    const ExecutionContext& exec_ctx) {
+  RequestContext* request_ctx = exec_ctx.request_ctx();
+  if (request_ctx == nullptr) return device_->allocator();
+  auto* arenas = request_ctx->GetDataIfExists<GpuRequestArenas>();
+  if (arenas == nullptr) return device_->allocator();
+  return arenas->GetOrCreate(*device_);
+}
+
+void GpuOpHandler::Dispatch(const GpuOpEntry& op_entry,
+                            ArrayRef<AsyncValue*> inputs,
+                            const OpAttrsRef& attrs,
+                            ArrayRef<TensorMetadata> result_mds,
+                            MutableArrayRef<RCReference<AsyncValue>> results,
+                            AsyncValueRef<Chain>* chain,
+                            const ExecutionContext& exec_ctx) {
+  auto set_error = [&](Error error) {
+    if (chain && *chain)
+      chain->SetError(absl::InternalError(toString(std::move(error))));
+  };
+
+  DType mixed_precision_dtype = DType::Invalid;
+  if (mixed_precision_ops_.contains(&op_entry))
+    mixed_precision_dtype = mixed_precision_dtype_;
+
+  if (!stream_assigner_) {
+    llvm::Expected<GpuDispatchContext> dctx = MakeGpuDispatchContext(exec_ctx);
+    if (!dctx) return set_error(dctx.takeError());
+    dctx->set_mixed_precision_dtype(mixed_precision_dtype);
+    op_entry.dispatch_fn(exec_ctx, &dctx.get(), inputs, attrs, result_mds,
+                         results, chain);
+    return;
+  }
+
+  auto assignment = stream_assigner_->Assign(*device_, inputs);
+  if (!assignment) return set_error(assignment.takeError());
+
+  auto allocator = GetAllocator(exec_ctx);
+  if (!allocator) return set_error(allocator.takeError());
+  AsyncValueRef<SideStreamAllocator> side_allocator;
+  if (assignment->stream_index != 0) {
+    side_allocator = MakeAvailableAsyncValueRef<SideStreamAllocator>(
+        std::move(*allocator), device_->stream(assignment->stream_index));
+    *allocator = side_allocator.CopyRef();
+  }
+
+  llvm::Expected<GpuDispatchContext> dctx = GpuDispatchContext::Create(
+      device_.get(), assignment->stream_index, std::move(*allocator));
+  if (!dctx) return set_error(dctx.takeError());
+  dctx->set_mixed_precision_dtype(mixed_precision_dtype);
+  op_entry.dispatch_fn(exec_ctx, &dctx.get(), inputs, attrs, result_mds,
+                       results, chain);
+
+  if (auto error = stream_assigner_->Finish(*device_, dctx->current_context(),
+                                            *assignment, results)) {
+    // Results must be ready on the device stream, fall back to waiting for
+    // the side stream on the host.
+    TFRT_LOG(ERROR) << error;
+    if (auto sync_error = wrapper::StreamSynchronize(dctx->stream()))
+      return set_error(std::move(sync_error));
+  }
+  if (side_allocator) side_allocator->SetJoined();
+}
+
+GpuRequestArenas::~GpuRequestArenas() {
+  mutex_lock lock(mutex_);
+  for (auto& pair : arenas_)
+    pair.first->set_request_arena_size(pair.second->requested_bytes());
+}
+
+Expected<AsyncValueRef<GpuAllocator>> GpuRequestArenas::GetOrCreate(
+    const GpuDevice& device) {
+  mutex_lock lock(mutex_);
+  auto it = arenas_.find(&device);
+  if (it != arenas_.end())
+    return AsyncValueRef<GpuAllocator>(it->second.CopyRef());
 
-Expected<GpuDispatchContext> GpuOpHandler::MakeGpuDispatchContext() {
-  return GpuDispatchContext::Create(device_.get());
+  TFRT_ASSIGN_OR_RETURN(auto current, device.SetCurrentContext());
+  TFRT_ASSIGN_OR_RETURN(
+      auto arena,
+      GpuArenaAllocator::Create(current, device.allocator(),
+                                device.request_arena_size(), device.stream()));
+  AsyncValueRef<GpuAllocator> allocator = arena.CopyRef();
+  arenas_.try_emplace(&device, std::move(arena));
+  return std::move(allocator);
 }
 
 Expected<CoreRuntimeOp> GpuOpHandler::MakeOp(string_view op_name) {
@@ -0,0 +1,51 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the input pipeline kernels which move data to a GPU.
+
+#include "device_prefetch_dataset.h"
+#include "tfrt/gpu/device/device.h"
+#include "tfrt/host_context/device.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/kernel_registry.h"
+#include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/support/error_util.h"
+
+namespace tfrt {
+namespace gpu {
+
+//===----------------------------------------------------------------------===//
+// DevicePrefetchDataset
+//===----------------------------------------------------------------------===//
+
+static Expected<RCReference<DevicePrefetchDataset>> MakeDevicePrefetchDataset(
+    RCReference<data::Dataset>* dataset, int64_t prefetch_num,
+    StringAttribute device_name, const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  auto device =
+      host->GetDeviceManager()->GetDeviceRef<GpuDevice>(device_name.get());
+  if (!device)
+    return MakeStringError("Unknown GPU device: ", device_name.get());
+  return TakeRef(host->Construct<DevicePrefetchDataset>(
+      *dataset, prefetch_num, std::move(device), host));
+}
+
+void RegisterGpuDataKernels(KernelRegistry* registry) {
+  registry->AddKernel("tfrt_data.device_prefetch_dataset",
+                      TFRT_KERNEL(MakeDevicePrefetchDataset));
+}
+
+}  // namespace gpu
+}  // namespace tfrt
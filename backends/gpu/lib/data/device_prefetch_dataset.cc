@@ -0,0 +1,146 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements DevicePrefetchDataset class which wraps around another
+// dataset instance and copies the DenseHostTensors of the prefetched elements
+// to a GPU.
+
+#include "device_prefetch_dataset.h"
+
+#include <cstring>
+
+#include "tfrt/gpu/gpu_types.h"
+#include "tfrt/gpu/memory/pinned_host_memory_pool.h"
+#include "tfrt/gpu/tensor/dense_gpu_tensor.h"
+#include "tfrt/gpu/wrapper/wrapper.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/string_util.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace gpu {
+
+// Copies `tensor` to `device` on its copy stream and blocks until the copy is
+// done. Tensors in pageable memory are staged through a pinned buffer, because
+// copies from pageable memory are synchronous with respect to the host.
+static Expected<DenseGpuTensor> CopyTensorToDevice(
+    const DenseHostTensor& tensor, const GpuDevice& device) {
+  size_t size_in_bytes = tensor.metadata().GetHostSizeInBytes();
+
+  TFRT_ASSIGN_OR_RETURN(wrapper::CurrentContext current,
+                        device.SetCurrentContext());
+  TFRT_ASSIGN_OR_RETURN(
+      GpuBuffer buffer,
+      GpuBuffer::Allocate(device.allocator(), size_in_bytes, device.stream()));
+  // The allocation is ordered on stream(), which may still use the memory.
+  TFRT_ASSIGN_OR_RETURN(wrapper::OwningEvent allocated,
+                        wrapper::EventCreateNoTiming(current));
+  if (auto error = wrapper::EventRecord(allocated.get(), device.stream()))
+    return std::move(error);
+
+  DenseHostTensor staging = tensor.CopyRef();
+  PinnedHostMemoryPool* pinned_pool = device.pinned_host_memory_pool();
+  if (pinned_pool && !pinned_pool->IsPinned(tensor.data())) {
+    TFRT_ASSIGN_OR_RETURN(RCReference<HostBuffer> staging_buffer,
+                          pinned_pool->Allocate(current, size_in_bytes));
+    std::memcpy(staging_buffer->data(), tensor.data(), size_in_bytes);
+    staging = DenseHostTensor(tensor.metadata(), std::move(staging_buffer));
+  }
+
+  wrapper::Stream copy_stream = device.copy_stream();
+  if (auto error = wrapper::StreamWaitEvent(copy_stream, allocated.get()))
+    return std::move(error);
+  wrapper::Pointer<const void> memcpy_src(staging.data(), current.platform());
+  if (auto error = wrapper::MemcpyAsync(current, /*dst=*/buffer.pointer(),
+                                        /*src=*/memcpy_src, size_in_bytes,
+                                        copy_stream))
+    return std::move(error);
+
+  // Wait on the host rather than making stream() wait for the copy. Otherwise
+  // the work of the current step, which is enqueued on stream() before the
+  // prefetched tensor is consumed, would be stalled by the copy.
+  TFRT_ASSIGN_OR_RETURN(wrapper::OwningEvent copied,
+                        wrapper::EventCreateNoTiming(current));
+  if (auto error = wrapper::EventRecord(copied.get(), copy_stream))
+    return std::move(error);
+  if (auto error = wrapper::EventSynchronize(copied.get()))
+    return std::move(error);
+
+  return DenseGpuTensor(
+      tensor.metadata(),
+      MakeAvailableAsyncValueRef<GpuBuffer>(std::move(buffer)));
+}
+
+//===----------------------------------------------------------------------===//
+// DevicePrefetchDataset methods
+//===----------------------------------------------------------------------===//
+RCReference<data::Iterator> DevicePrefetchDataset::MakeIteratorInternal(
+    const data::IteratorContext& context) {
+  return TakeRef(
+      host_->Construct<DevicePrefetchDatasetIterator>(FormRef(this), context));
+}
+
+//===----------------------------------------------------------------------===//
+// DevicePrefetchDatasetIterator methods
+//===----------------------------------------------------------------------===//
+data::IterationResult DevicePrefetchDatasetIterator::GetNext(
+    const ExecutionContext& exec_ctx) {
+  while (buffer_.size() < parent_dataset_->PrefetchNum(prefetch_num_) + 1) {
+    auto input = input_iterator_->GetNext(exec_ctx);
+    for (auto& value : input.values) value = CopyToDevice(std::move(value));
+    buffer_.push(std::move(input));
+  }
+  if (stage_) stage_->RecordBufferSize(buffer_.size());
+  auto result = std::move(buffer_.front());
+  buffer_.pop();
+  if (prefetch_num_) prefetch_num_->RecordGetNext(result.eof);
+  return result;
+}
+
+RCReference<AsyncValue> DevicePrefetchDatasetIterator::CopyToDevice(
+    RCReference<AsyncValue> value) {
+  auto result = MakeIndirectAsyncValue();
+  AsyncValue* value_ptr = value.get();
+  value_ptr->AndThen([value = std::move(value), result = result.CopyRef(),
+                      device = parent_dataset_->device_.CopyRef(),
+                      host = parent_dataset_->host_]() mutable {
+    if (value->IsError() || !value->IsType<DenseHostTensor>())
+      return result->ForwardTo(std::move(value));
+    // The copy blocks until the data is resident, so run it on a blocking
+    // thread. This also keeps the host tensor alive until the copy is done.
+    bool work_enqueued = EnqueueBlockingWork(
+        host, [value = std::move(value), result = result.CopyRef(),
+               device = std::move(device)] {
+          auto tensor =
+              CopyTensorToDevice(value->get<DenseHostTensor>(), *device);
+          if (!tensor)
+            return result->ForwardTo(
+                MakeErrorAsyncValueRef(StrCat(tensor.takeError())));
+          result->ForwardTo(
+              MakeAvailableAsyncValueRef<DenseGpuTensor>(std::move(*tensor))
+                  .ReleaseRCRef());
+        });
+    if (!work_enqueued) {
+      result->ForwardTo(MakeErrorAsyncValueRef(
+          "could not enqueue work to copy a prefetched tensor to the device"));
+    }
+  });
+  return result;
+}
+
+}  // namespace gpu
+}  // namespace tfrt
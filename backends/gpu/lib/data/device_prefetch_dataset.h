@@ -0,0 +1,132 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file declares DevicePrefetchDataset class which wraps around another
+// dataset instance and copies the DenseHostTensors of the prefetched elements
+// to a GPU.
+
+#ifndef TFRT_BACKENDS_GPU_LIB_DATA_DEVICE_PREFETCH_DATASET_H_
+#define TFRT_BACKENDS_GPU_LIB_DATA_DEVICE_PREFETCH_DATASET_H_
+
+#include <limits>
+#include <queue>
+
+#include "tfrt/data/dataset.h"
+#include "tfrt/gpu/device/device.h"
+#include "tfrt/support/forward_decls.h"
+
+namespace tfrt {
+namespace gpu {
+
+class DevicePrefetchDatasetIterator;
+
+// DevicePrefetchDataset class which wraps around another dataset instance and
+// prefetches elements from the underlying dataset in an internal buffer, like
+// data::PrefetchDataset. The DenseHostTensor values of the prefetched elements
+// are copied to `device` on its copy stream, staged through pinned host
+// memory, while the previous elements are consumed. They are replaced by
+// DenseGpuTensors, which only become available once their data is resident on
+// the device. Other values are passed through.
+class DevicePrefetchDataset : public data::Dataset {
+ public:
+  explicit DevicePrefetchDataset(RCReference<data::Dataset> input_dataset,
+                                 int64_t prefetch_num,
+                                 RCReference<GpuDevice> device,
+                                 HostContext* host)
+      : input_dataset_(std::move(input_dataset)),
+        prefetch_num_(prefetch_num),
+        device_(std::move(device)),
+        host_(host) {}
+
+  // This class is not copyable or movable.
+  DevicePrefetchDataset(const DevicePrefetchDataset&) = delete;
+  DevicePrefetchDataset& operator=(const DevicePrefetchDataset&) = delete;
+
+  string_view name() const override { return "device_prefetch_dataset"; }
+
+ private:
+  // Allow iterator to rely on private data members of this dataset.
+  friend class DevicePrefetchDatasetIterator;
+
+  RCReference<data::Iterator> MakeIteratorInternal(
+      const data::IteratorContext& context) override;
+
+  void Destroy() override {
+    data::internal::DestroyImpl<DevicePrefetchDataset>(this,
+                                                       host_->allocator());
+  }
+
+  // Returns the tunable prefetch depth for an iterator if prefetch_num_ is
+  // kAutotune, or null otherwise.
+  RCReference<data::TunableParameter> MakePrefetchNumParameter(
+      const data::IteratorContext& context) const {
+    if (prefetch_num_ != data::kAutotune) return {};
+    return context.autotuner->MakeParameter(
+        /*initial_value=*/1, /*min_value=*/0,
+        /*max_value=*/std::numeric_limits<int64_t>::max());
+  }
+
+  int64_t PrefetchNum(
+      const RCReference<data::TunableParameter>& parameter) const {
+    return parameter ? parameter->value() : prefetch_num_;
+  }
+
+  RCReference<data::Dataset> input_dataset_;
+  // The number of elements to prefetch, or kAutotune.
+  int64_t prefetch_num_;
+  RCReference<GpuDevice> device_;
+  HostContext* host_;
+};
+
+class DevicePrefetchDatasetIterator : public data::Iterator {
+ public:
+  explicit DevicePrefetchDatasetIterator(
+      RCReference<DevicePrefetchDataset> parent_dataset,
+      const data::IteratorContext& context)
+      : data::Iterator(),
+        parent_dataset_(std::move(parent_dataset)),
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+        prefetch_num_(parent_dataset_->MakePrefetchNumParameter(context)),
+        stage_(context.stage) {}
+
+  // This class is not copyable or movable.
+  DevicePrefetchDatasetIterator(const DevicePrefetchDatasetIterator&) = delete;
+  DevicePrefetchDatasetIterator& operator=(
+      const DevicePrefetchDatasetIterator&) = delete;
+
+  data::IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  void Destroy() override {
+    data::internal::DestroyImpl<DevicePrefetchDatasetIterator>(
+        this, parent_dataset_->host_->allocator());
+  }
+
+  // Returns `value` copied to the device if it is a DenseHostTensor, or
+  // `value` itself otherwise.
+  RCReference<AsyncValue> CopyToDevice(RCReference<AsyncValue> value);
+
+  RCReference<DevicePrefetchDataset> parent_dataset_;
+  RCReference<data::Iterator> input_iterator_;
+  // Null unless the prefetch depth is autotuned.
+  RCReference<data::TunableParameter> prefetch_num_;
+  // Null unless the pipeline records statistics.
+  RCReference<data::IteratorStats> stage_;
+  std::queue<data::IterationResult> buffer_;
+};
+
+}  // namespace gpu
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_GPU_LIB_DATA_DEVICE_PREFETCH_DATASET_H_
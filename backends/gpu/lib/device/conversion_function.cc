@@ -13,12 +13,15 @@
 // limitations under the License.
 
 // This file implements GPU tensor conversion functions for copying between gpu
-// and host.
+// and host, and between gpus.
 
 #include "tfrt/gpu/device/conversion_function.h"
 
+#include <cstring>
+
 #include "tfrt/gpu/device/device.h"
 #include "tfrt/gpu/gpu_types.h"
+#include "tfrt/gpu/memory/pinned_host_memory_pool.h"
 #include "tfrt/gpu/tensor/dense_gpu_tensor.h"
 #include "tfrt/gpu/wrapper/wrapper.h"
 #include "tfrt/host_context/async_dispatch.h"
@@ -39,21 +42,36 @@ using wrapper::EventRecord;
 using wrapper::EventSynchronize;
 using wrapper::OwningEvent;
 using wrapper::Pointer;
+using wrapper::StreamWaitEvent;
 
 AsyncValueRef<DenseHostTensor> ConvertDenseGpuTensorToDenseHostTensor(
     wrapper::CurrentContext current_context, wrapper::Stream stream,
-    const DenseGpuTensor& gpu_tensor, HostContext* host) {
-  llvm::Optional<DenseHostTensor> result_or_error =
-      DenseHostTensor::CreateUninitialized(gpu_tensor.metadata(), host);
-  if (!result_or_error) {
-    return MakeErrorAsyncValueRef("cannot allocate result tensor");
+    const DenseGpuTensor& gpu_tensor, HostContext* host,
+    PinnedHostMemoryPool* pinned_pool) {
+  size_t size_in_bytes = gpu_tensor.metadata().GetHostSizeInBytes();
+
+  // Copy into pinned memory if possible, the result tensor then keeps the
+  // pooled buffer until it is destroyed.
+  DenseHostTensor result;
+  if (pinned_pool) {
+    auto buffer = pinned_pool->Allocate(current_context, size_in_bytes);
+    if (!buffer) {
+      return MakeErrorAsyncValueRef("cannot allocate result tensor: " +
+                                    toString(buffer.takeError()));
+    }
+    result = DenseHostTensor(gpu_tensor.metadata(), std::move(*buffer));
+  } else {
+    llvm::Optional<DenseHostTensor> result_or_error =
+        DenseHostTensor::CreateUninitialized(gpu_tensor.metadata(), host);
+    if (!result_or_error) {
+      return MakeErrorAsyncValueRef("cannot allocate result tensor");
+    }
+    result = std::move(*result_or_error);
   }
-  DenseHostTensor result = std::move(*result_or_error);
 
   Pointer<void> memcpy_dst(result.data(), current_context.platform());
   Pointer<void> memcpy_src = gpu_tensor.buffer().pointer();
 
-  size_t size_in_bytes = gpu_tensor.metadata().GetHostSizeInBytes();
   llvm::Error memcpy_error =
       MemcpyAsync(current_context, /*dst=*/memcpy_dst, /*src=*/memcpy_src,
                   size_in_bytes, stream);
@@ -101,20 +119,33 @@ DenseGpuTensorToDenseHostTensorConversionFn(const DenseGpuTensor& tensor,
     return MakeErrorAsyncValueRef(StrCat(current_context.takeError()));
   }
   return ConvertDenseGpuTensorToDenseHostTensor(
-      std::move(current_context.get()), src.stream(), tensor, exec_ctx.host());
+      std::move(current_context.get()), src.stream(), tensor, exec_ctx.host(),
+      src.pinned_host_memory_pool());
 }
 
 Expected<DenseGpuTensor> ConvertDenseHostTensorToDenseGpuTensor(
     wrapper::CurrentContext current_context, wrapper::Stream stream,
     AsyncValueRef<GpuAllocator> allocator, const DenseHostTensor& tensor,
-    HostContext* host) {
+    HostContext* host, PinnedHostMemoryPool* pinned_pool) {
   size_t size_in_bytes = tensor.metadata().GetHostSizeInBytes();
 
   TFRT_ASSIGN_OR_RETURN(
       GpuBuffer buffer,
       GpuBuffer::Allocate(std::move(allocator), size_in_bytes, stream));
 
-  Pointer<const void> memcpy_src(tensor.data(), current_context.platform());
+  // Copies from pageable memory are synchronous. Stage the tensor through a
+  // pinned buffer, unless it already lives in one, so that the copy overlaps
+  // with the work on the host.
+  DenseHostTensor staging = tensor.CopyRef();
+  if (pinned_pool && !pinned_pool->IsPinned(tensor.data())) {
+    TFRT_ASSIGN_OR_RETURN(
+        RCReference<HostBuffer> staging_buffer,
+        pinned_pool->Allocate(current_context, size_in_bytes));
+    std::memcpy(staging_buffer->data(), tensor.data(), size_in_bytes);
+    staging = DenseHostTensor(tensor.metadata(), std::move(staging_buffer));
+  }
+
+  Pointer<const void> memcpy_src(staging.data(), current_context.platform());
   if (auto error = MemcpyAsync(current_context, /*dst=*/buffer.pointer(),
                                /*src=*/memcpy_src, size_in_bytes, stream))
     return std::move(error);
@@ -127,9 +158,9 @@ Expected<DenseGpuTensor> ConvertDenseHostTensorToDenseGpuTensor(
 
   if (auto error = EventRecord(event.get(), stream)) return std::move(error);
 
-  // The underlying buffer of `tensor` needs to live until the memcpy is done.
+  // The buffer copied from needs to live until the memcpy is done.
   bool work_enqueued = EnqueueBlockingWork(
-      host, [tensor = tensor.CopyRef(), event = std::move(event)] {
+      host, [staging = std::move(staging), event = std::move(event)] {
         // FIXME(sanjoy): How do we handle an error from EventSynchronize here?
         llvm::ExitOnError die_if_error;
         die_if_error(EventSynchronize(event.get()));
@@ -152,7 +183,76 @@ static Expected<DenseGpuTensor> DenseHostTensorToDenseGpuTensorConversionFn(
 
   return ConvertDenseHostTensorToDenseGpuTensor(
       std::move(current_context.get()), dst.stream(), dst.allocator(), tensor,
-      exec_ctx.host());
+      exec_ctx.host(), dst.pinned_host_memory_pool());
+}
+
+// Copies `tensor` from `src` to `dst` without a round trip through a host
+// tensor. The copy is enqueued on the copy stream of `src` after the work on
+// src.stream(), and dst.stream() waits for it. If the devices are peers, the
+// copy goes directly over NVLink or PCIe. Otherwise the driver stages it
+// through host memory.
+static Expected<DenseGpuTensor> DenseGpuTensorToDenseGpuTensorConversionFn(
+    const DenseGpuTensor& tensor, const GpuDevice& src, const GpuDevice& dst,
+    const ExecutionContext& exec_ctx) {
+  if (&src == &dst) return tensor.CopyRef();
+
+  if (auto error = src.EnablePeerAccess(dst).takeError())
+    return std::move(error);
+
+  size_t size_in_bytes = tensor.metadata().GetHostSizeInBytes();
+
+  TFRT_ASSIGN_OR_RETURN(wrapper::CurrentContext dst_context,
+                        dst.SetCurrentContext());
+  TFRT_ASSIGN_OR_RETURN(
+      GpuBuffer buffer,
+      GpuBuffer::Allocate(dst.allocator(), size_in_bytes, dst.stream()));
+  // The allocation is ordered on dst.stream(), which may still use the memory.
+  TFRT_ASSIGN_OR_RETURN(OwningEvent allocated,
+                        wrapper::EventCreateNoTiming(dst_context));
+  if (auto error = EventRecord(allocated.get(), dst.stream()))
+    return std::move(error);
+
+  TFRT_ASSIGN_OR_RETURN(wrapper::CurrentContext src_context,
+                        src.SetCurrentContext());
+  TFRT_ASSIGN_OR_RETURN(OwningEvent ready,
+                        wrapper::EventCreateNoTiming(src_context));
+  if (auto error = EventRecord(ready.get(), src.stream()))
+    return std::move(error);
+
+  wrapper::Stream copy_stream = src.copy_stream();
+  if (auto error = StreamWaitEvent(copy_stream, ready.get()))
+    return std::move(error);
+  if (auto error = StreamWaitEvent(copy_stream, allocated.get()))
+    return std::move(error);
+  if (auto error = MemcpyPeerAsync(
+          /*dst_ptr=*/buffer.pointer(), dst.context(),
+          /*src_ptr=*/tensor.buffer().pointer(), src.context(), size_in_bytes,
+          copy_stream))
+    return std::move(error);
+
+  TFRT_ASSIGN_OR_RETURN(OwningEvent copied,
+                        wrapper::EventCreateNoTiming(src_context));
+  if (auto error = EventRecord(copied.get(), copy_stream))
+    return std::move(error);
+  if (auto error = StreamWaitEvent(dst.stream(), copied.get()))
+    return std::move(error);
+
+  // The buffer copied from is deallocated on src.stream(), so it needs to live
+  // until the memcpy is done.
+  bool work_enqueued = EnqueueBlockingWork(
+      exec_ctx.host(),
+      [source = tensor.CopyRef(), copied = std::move(copied)] {
+        llvm::ExitOnError die_if_error;
+        die_if_error(EventSynchronize(copied.get()));
+      });
+  if (!work_enqueued) {
+    return MakeStringError(
+        "could not enqueue work to synchronize after issuing device to device "
+        "memcpy");
+  }
+  return DenseGpuTensor(
+      tensor.metadata(),
+      MakeAvailableAsyncValueRef<GpuBuffer>(std::move(buffer)));
 }
 
 void RegisterGpuTensorConversionFn(TensorConversionFnRegistry* registry) {
@@ -160,6 +260,8 @@ void RegisterGpuTensorConversionFn(TensorConversionFnRegistry* registry) {
       TFRT_CONVERSION(DenseHostTensorToDenseGpuTensorConversionFn));
   registry->AddTensorConversionFn(
       TFRT_CONVERSION(DenseGpuTensorToDenseHostTensorConversionFn));
+  registry->AddTensorConversionFn(
+      TFRT_CONVERSION(DenseGpuTensorToDenseGpuTensorConversionFn));
 }
 
 }  // namespace gpu
@@ -17,36 +17,57 @@
 // This file implements GPU device.
 #include "tfrt/gpu/device/device.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include "eigen_support.h"
+#include "llvm/ADT/DenseMap.h"
 #include "tfrt/gpu/device/gpu_config.h"
 #include "tfrt/gpu/gpu_types.h"
 #include "tfrt/gpu/memory/bfc_gpu_allocator.h"
+#include "tfrt/gpu/memory/pinned_host_memory_pool.h"
+#include "tfrt/gpu/memory/stream_caching_gpu_allocator.h"
 #include "tfrt/gpu/wrapper/cublas_wrapper.h"
+#include "tfrt/gpu/wrapper/cuda_wrapper.h"
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/support/error_util.h"
+#include "tfrt/support/logging.h"
+#include "tfrt/support/mutex.h"
 #include "tfrt/support/string_util.h"
+#include "tfrt/support/thread_annotations.h"
 
 namespace tfrt {
 namespace gpu {
 
-// A mere wrapper of a GpuAllocator.
+// A mere wrapper of a GpuAllocator. If `default_stream` is not null, requests
+// on the default stream are forwarded on `default_stream` instead.
 class GpuAllocatorWrapper : public GpuAllocator {
  public:
   // `allocator` should not be nullptr.
-  explicit GpuAllocatorWrapper(GpuAllocator* allocator);
+  explicit GpuAllocatorWrapper(GpuAllocator* allocator,
+                               wrapper::Stream default_stream = {});
 
   ~GpuAllocatorWrapper() override;
 
  private:
   Expected<GpuPointer> Allocate(size_t size, wrapper::Stream stream) override;
   Error Deallocate(GpuPointer pointer, wrapper::Stream stream) override;
+  Error DeallocateAfter(GpuPointer pointer,
+                        ArrayRef<wrapper::Stream> streams) override;
+
+  wrapper::Stream GetStream(wrapper::Stream stream) const {
+    return stream == nullptr ? default_stream_ : stream;
+  }
 
   // The class does not own the underlying allocator.
   GpuAllocator* allocator_;
+  wrapper::Stream default_stream_;
 };
 
-GpuAllocatorWrapper::GpuAllocatorWrapper(GpuAllocator* allocator)
-    : allocator_(allocator) {
+GpuAllocatorWrapper::GpuAllocatorWrapper(GpuAllocator* allocator,
+                                         wrapper::Stream default_stream)
+    : allocator_(allocator), default_stream_(default_stream) {
   assert(allocator_ != nullptr);
 }
 
@@ -54,21 +75,59 @@ GpuAllocatorWrapper::~GpuAllocatorWrapper() = default;
 
 Expected<GpuPointer> GpuAllocatorWrapper::Allocate(size_t size,
                                                    wrapper::Stream stream) {
-  return GpuAllocator::Allocate(allocator_, size, stream);
+  return GpuAllocator::Allocate(allocator_, size, GetStream(stream));
 }
 
 Error GpuAllocatorWrapper::Deallocate(GpuPointer pointer,
                                       wrapper::Stream stream) {
-  return GpuAllocator::Deallocate(allocator_, pointer, stream);
+  return GpuAllocator::Deallocate(allocator_, pointer, GetStream(stream));
+}
+
+Error GpuAllocatorWrapper::DeallocateAfter(GpuPointer pointer,
+                                           ArrayRef<wrapper::Stream> streams) {
+  return GpuAllocator::DeallocateAfter(allocator_, pointer, streams);
 }
 
 class GpuDevice::Impl {
  public:
-  explicit Impl(int gpu_ordinal) : gpu_ordinal_(gpu_ordinal) {}
+  // A stream of the pool and the library handles bound to it.
+  struct StreamResources {
+    // If `owned_stream` is null, `stream` points to a non-owning stream.
+    // Otherwise, `stream` is set to be `owned_stream.get()`.
+    wrapper::OwningStream owned_stream;
+    wrapper::Stream stream;
+
+    // Creating the library handles loads the BLAS and DNN libraries and their
+    // kernels, which dominates the cost of creating a device. They are created
+    // on first use instead, see BlasHandle() and DnnHandle(). The handles stay
+    // null if creating them failed.
+    std::once_flag blas_once;
+    wrapper::OwningBlasHandle blas_handle;
+    std::once_flag dnn_once;
+    wrapper::OwningDnnHandle dnn_handle;
+
+    // NB! The declaration order here is important. The eigen_gpu_device
+    // references eigen_stream_interface, which references stream.
+    gpu::OwningEigenStreamInterface eigen_stream_interface;
+    gpu::OwningEigenGpuDevice eigen_gpu_device;
+  };
+
+  explicit Impl(int gpu_ordinal, int num_streams)
+      : gpu_ordinal_(gpu_ordinal),
+        num_streams_(num_streams),
+        pinned_host_memory_pool_(TakeRef(new PinnedHostMemoryPool())) {
+    assert(num_streams_ >= 1);
+  }
 
   llvm::Error Initialize();
 
+  // Returns the library handles bound to stream `index`, creating them the
+  // first time. Thread-safe.
+  wrapper::BlasHandle BlasHandle(wrapper::CurrentContext current, int index);
+  wrapper::DnnHandle DnnHandle(wrapper::CurrentContext current, int index);
+
   int gpu_ordinal_;
+  int num_streams_;
 
   // TODO(sanjoy): we need to figure out how the lifetimes of these objects
   // interact with the lifetime of the GPU op handler.
@@ -82,90 +141,222 @@ class GpuDevice::Impl {
   // Otherwise, `context_` is set to be `owned_context_.get()`.
   wrapper::OwningContext owned_context_;
   wrapper::Context context_;
-  // If `owned_stream` is null, `stream_` points to a non-owning stream.
-  // Otherwise, `stream_` is set to be `owned_stream_.get()`.
-  wrapper::OwningStream owned_stream_;
-  wrapper::Stream stream_;
-  wrapper::OwningBlasHandle blas_handle_;
-  wrapper::OwningDnnHandle dnn_handle_;
-
-  // NB! The declaration order here is important. The eigen_gpu_device_
-  // references eigen_stream_interface_, which references stream_.
-  gpu::OwningEigenStreamInterface eigen_stream_interface_;
-  gpu::OwningEigenGpuDevice eigen_gpu_device_;
+  // The pool of `num_streams_` streams, the first one is the device stream.
+  std::unique_ptr<StreamResources[]> streams_;
+  // Same as for `streams_`, `copy_stream_` points to `owned_copy_stream_` if
+  // the latter is not null.
+  wrapper::OwningStream owned_copy_stream_;
+  wrapper::Stream copy_stream_;
 
   std::unique_ptr<gpu::GpuAllocator> allocator_;
+
+  // Staging buffers for copies between host and device. Declared after
+  // `owned_context_` so that cached blocks are freed while it is alive.
+  RCReference<PinnedHostMemoryPool> pinned_host_memory_pool_;
+
+  // Whether peer access is enabled, keyed by the ordinal of the peer.
+  mutex peer_access_mutex_;
+  llvm::SmallDenseMap<int, bool> peer_access_
+      TFRT_GUARDED_BY(peer_access_mutex_);
+
+  std::atomic<size_t> request_arena_size_{0};
 };
 
 llvm::Error GpuDevice::Impl::Initialize() {
   // TODO(zhangqiaorjc): Generalize to multi-GPU.
   TFRT_ASSIGN_OR_RETURN(device_,
                         DeviceGet(wrapper::Platform::CUDA, gpu_ordinal_));
-  llvm::Optional<wrapper::CurrentContext> current_context;
 
   // Use external GPU resources if they are available.
   if (auto gpu_resources = gpu::GetTfrtGpuResources(device_)) {
     // Set a non-owning context.
     context_ = gpu_resources->gpu_context;
     TFRT_ASSIGN_OR_RETURN(auto current, CtxSetCurrent(context_));
-    current_context.emplace(current);
 
     allocator_ = gpu_resources->allocator_factory(context_);
 
-    stream_ = gpu_resources->stream;
+    // The external allocator may not support more than one stream.
+    num_streams_ = 1;
+    streams_ = std::make_unique<StreamResources[]>(num_streams_);
+    streams_[0].stream = gpu_resources->stream;
+    copy_stream_ = gpu_resources->stream;
   } else {
     TFRT_ASSIGN_OR_RETURN(owned_context_, DevicePrimaryCtxRetain(device_));
     context_ = owned_context_.get();
     TFRT_ASSIGN_OR_RETURN(auto current, CtxSetCurrent(context_));
-    current_context.emplace(current);
 
-    TFRT_ASSIGN_OR_RETURN(owned_stream_, StreamCreateNonBlocking(current));
-    stream_ = owned_stream_.get();
+    streams_ = std::make_unique<StreamResources[]>(num_streams_);
+    for (int i = 0; i < num_streams_; ++i) {
+      TFRT_ASSIGN_OR_RETURN(streams_[i].owned_stream,
+                            StreamCreateNonBlocking(current));
+      streams_[i].stream = streams_[i].owned_stream.get();
+    }
+    TFRT_ASSIGN_OR_RETURN(owned_copy_stream_, StreamCreateNonBlocking(current));
+    copy_stream_ = owned_copy_stream_.get();
+
+    // BfcGpuAllocator only supports a single stream.
+    if (num_streams_ == 1) {
+      allocator_ = std::make_unique<gpu::BfcGpuAllocator>(current);
+    } else {
+      allocator_ = std::make_unique<gpu::StreamCachingGpuAllocator>(current);
+    }
+  }
 
-    allocator_ = std::make_unique<gpu::BfcGpuAllocator>(current);
+  for (int i = 0; i < num_streams_; ++i) {
+    StreamResources& resources = streams_[i];
+    resources.eigen_stream_interface =
+        gpu::CreateEigenStreamInterface(resources.stream);
+    resources.eigen_gpu_device =
+        gpu::CreateEigenGpuDevice(resources.eigen_stream_interface.get());
   }
 
-  eigen_stream_interface_ = gpu::CreateEigenStreamInterface(stream_);
-  eigen_gpu_device_ = gpu::CreateEigenGpuDevice(eigen_stream_interface_.get());
+  return Error::success();
+}
 
-  // TODO(iga): Only log errors during BLAS handle creation?
-  TFRT_ASSIGN_OR_RETURN(blas_handle_, BlasCreate(*current_context));
-  if (auto error = wrapper::BlasSetStream(blas_handle_.get(), stream_))
-    return error;
+// Creates library handles bound to `stream`.
+static llvm::Expected<wrapper::OwningBlasHandle> CreateBlasHandle(
+    wrapper::CurrentContext current, wrapper::Stream stream) {
+  TFRT_ASSIGN_OR_RETURN(auto handle, BlasCreate(current));
+  if (auto error = wrapper::BlasSetStream(handle.get(), stream))
+    return std::move(error);
   if (auto error = wrapper::CublasSetMathMode(
-          static_cast<cublasHandle_t>(blas_handle_.get()),
-          CUBLAS_TENSOR_OP_MATH))
-    return error;
+          static_cast<cublasHandle_t>(handle.get()), CUBLAS_TENSOR_OP_MATH))
+    return std::move(error);
+  return std::move(handle);
+}
 
-  TFRT_ASSIGN_OR_RETURN(dnn_handle_, wrapper::DnnCreate(*current_context));
-  if (auto error = wrapper::DnnSetStream(dnn_handle_.get(), stream_))
-    return error;
+static llvm::Expected<wrapper::OwningDnnHandle> CreateDnnHandle(
+    wrapper::CurrentContext current, wrapper::Stream stream) {
+  TFRT_ASSIGN_OR_RETURN(auto handle, wrapper::DnnCreate(current));
+  if (auto error = wrapper::DnnSetStream(handle.get(), stream))
+    return std::move(error);
+  return std::move(handle);
+}
 
-  return Error::success();
+wrapper::BlasHandle GpuDevice::Impl::BlasHandle(
+    wrapper::CurrentContext current, int index) {
+  assert(current.context() == context_);
+  StreamResources& resources = streams_[index];
+  std::call_once(resources.blas_once, [&] {
+    auto handle = CreateBlasHandle(current, resources.stream);
+    if (!handle) {
+      TFRT_LOG(ERROR) << "Failed to create BLAS handle: " << handle.takeError();
+      return;
+    }
+    resources.blas_handle = std::move(*handle);
+  });
+  return resources.blas_handle.get();
+}
+
+wrapper::DnnHandle GpuDevice::Impl::DnnHandle(wrapper::CurrentContext current,
+                                              int index) {
+  assert(current.context() == context_);
+  StreamResources& resources = streams_[index];
+  std::call_once(resources.dnn_once, [&] {
+    auto handle = CreateDnnHandle(current, resources.stream);
+    if (!handle) {
+      TFRT_LOG(ERROR) << "Failed to create DNN handle: " << handle.takeError();
+      return;
+    }
+    resources.dnn_handle = std::move(*handle);
+  });
+  return resources.dnn_handle.get();
 }
 
-GpuDevice::GpuDevice(string_view name, int gpu_ordinal)
-    : Device(kDeviceType, name), impl_(std::make_unique<Impl>(gpu_ordinal)) {}
+GpuDevice::GpuDevice(string_view name, int gpu_ordinal, int num_streams)
+    : Device(kDeviceType, name),
+      impl_(std::make_unique<Impl>(gpu_ordinal, num_streams)) {}
 
 llvm::Error GpuDevice::Initialize() { return impl_->Initialize(); }
 
-wrapper::Stream GpuDevice::stream() const { return impl_->stream_; }
+llvm::Error GpuDevice::InitializeLibraryHandles() const {
+  TFRT_ASSIGN_OR_RETURN(auto current, SetCurrentContext());
+  for (int i = 0; i < impl_->num_streams_; ++i) {
+    if (blas_handle(current, i) == nullptr)
+      return MakeStringError("Failed to create BLAS handle for stream ", i);
+    if (dnn_handle(current, i) == nullptr)
+      return MakeStringError("Failed to create DNN handle for stream ", i);
+  }
+  return Error::success();
+}
+
+wrapper::Stream GpuDevice::stream() const { return stream(0); }
+
+int GpuDevice::num_streams() const { return impl_->num_streams_; }
+
+wrapper::Stream GpuDevice::stream(int index) const {
+  return impl_->streams_[index].stream;
+}
 
 AsyncValueRef<gpu::GpuAllocator> GpuDevice::allocator() const {
+  wrapper::Stream default_stream;
+  if (impl_->num_streams_ > 1) default_stream = stream();
   return MakeAvailableAsyncValueRef<GpuAllocatorWrapper>(
-      impl_->allocator_.get());
+      impl_->allocator_.get(), default_stream);
+}
+
+PinnedHostMemoryPool* GpuDevice::pinned_host_memory_pool() const {
+  return impl_->pinned_host_memory_pool_.get();
+}
+
+wrapper::Device GpuDevice::device() const { return impl_->device_; }
+
+wrapper::Context GpuDevice::context() const { return impl_->context_; }
+
+wrapper::Stream GpuDevice::copy_stream() const { return impl_->copy_stream_; }
+
+llvm::Expected<bool> GpuDevice::EnablePeerAccess(const GpuDevice& peer) const {
+  int peer_ordinal = peer.impl_->gpu_ordinal_;
+  if (peer_ordinal == impl_->gpu_ordinal_) return true;
+
+  mutex_lock lock(impl_->peer_access_mutex_);
+  auto it = impl_->peer_access_.find(peer_ordinal);
+  if (it != impl_->peer_access_.end()) return it->second;
+
+  TFRT_ASSIGN_OR_RETURN(int can_access,
+                        DeviceCanAccessPeer(impl_->device_, peer.device()));
+  if (can_access) {
+    TFRT_ASSIGN_OR_RETURN(auto current, SetCurrentContext());
+    // Devices of other host contexts may share the primary contexts and have
+    // enabled the access already.
+    if (auto error = llvm::handleErrors(
+            wrapper::CuCtxEnablePeerAccess(current, peer.context()),
+            [](std::unique_ptr<wrapper::ErrorInfo<CUresult>> info) {
+              if (wrapper::GetResult(*info) ==
+                  CUDA_ERROR_PEER_ACCESS_ALREADY_ENABLED)
+                return llvm::Error::success();
+              return llvm::Error(std::move(info));
+            }))
+      return std::move(error);
+  }
+  impl_->peer_access_[peer_ordinal] = can_access;
+  return can_access != 0;
+}
+
+size_t GpuDevice::request_arena_size() const {
+  return impl_->request_arena_size_.load(std::memory_order_relaxed);
+}
+
+void GpuDevice::set_request_arena_size(size_t size) const {
+  impl_->request_arena_size_.store(size, std::memory_order_relaxed);
 }
 
 Eigen::GpuDevice* GpuDevice::eigen_gpu_device() const {
-  return impl_->eigen_gpu_device_.get();
+  return eigen_gpu_device(0);
+}
+
+Eigen::GpuDevice* GpuDevice::eigen_gpu_device(int index) const {
+  return impl_->streams_[index].eigen_gpu_device.get();
 }
 
-wrapper::BlasHandle GpuDevice::blas_handle() const {
-  return impl_->blas_handle_.get();
+wrapper::BlasHandle GpuDevice::blas_handle(wrapper::CurrentContext current,
+                                           int index) const {
+  return impl_->BlasHandle(current, index);
 }
 
-wrapper::DnnHandle GpuDevice::dnn_handle() const {
-  return impl_->dnn_handle_.get();
+wrapper::DnnHandle GpuDevice::dnn_handle(wrapper::CurrentContext current,
+                                         int index) const {
+  return impl_->DnnHandle(current, index);
 }
 
 llvm::Expected<wrapper::CurrentContext> GpuDevice::SetCurrentContext() const {
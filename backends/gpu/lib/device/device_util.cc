@@ -20,16 +20,17 @@
 #include <memory>
 
 #include "tfrt/gpu/device/device.h"
+#include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/device.h"
 #include "tfrt/host_context/host_context.h"
+#include "tfrt/support/logging.h"
 #include "tfrt/support/string_util.h"
 
 namespace tfrt {
 namespace gpu {
 
-llvm::Expected<RCReference<GpuDevice>> GetOrCreateGpuDevice(string_view name,
-                                                            int gpu_ordinal,
-                                                            HostContext* host) {
+llvm::Expected<RCReference<GpuDevice>> GetOrCreateGpuDevice(
+    string_view name, int gpu_ordinal, HostContext* host, int num_streams) {
   if (llvm::Error result = wrapper::Init(wrapper::Platform::CUDA))
     return std::move(result);
 
@@ -38,7 +39,7 @@ llvm::Expected<RCReference<GpuDevice>> GetOrCreateGpuDevice(string_view name,
   if (existing_device) {
     return std::move(existing_device);
   }
-  auto gpu_device = MakeRef<GpuDevice>(name, gpu_ordinal);
+  auto gpu_device = MakeRef<GpuDevice>(name, gpu_ordinal, num_streams);
   if (auto error = gpu_device->Initialize()) {
     return std::move(error);
   }
@@ -46,5 +47,16 @@ llvm::Expected<RCReference<GpuDevice>> GetOrCreateGpuDevice(string_view name,
   return host->GetDeviceManager()->MaybeAddDevice(std::move(gpu_device));
 }
 
+void PrewarmGpuDevice(RCReference<GpuDevice> device, HostContext* host) {
+  bool work_enqueued =
+      EnqueueBlockingWork(host, [device = std::move(device)] {
+        if (auto error = device->InitializeLibraryHandles())
+          TFRT_LOG(WARNING) << "Failed to prewarm " << device->name() << ": "
+                            << std::move(error);
+      });
+  if (!work_enqueued)
+    TFRT_LOG(WARNING) << "Could not enqueue work to prewarm GPU device";
+}
+
 }  // namespace gpu
 }  // namespace tfrt
@@ -516,6 +516,74 @@ AsyncValueRef<Chain> Execute(const ExecutionContext& exec_ctx,
   return AsyncValueRef<Chain>(std::move(result));
 }
 
+AsyncValueRef<Chain> CapturedFunction::Execute(
+    const ExecutionContext& exec_ctx, AsyncValueRef<Chain> chain,
+    AsyncValueRef<GpuStream> stream,
+    ArrayRef<AsyncValueRef<GpuBuffer>> buffers) {
+  // The graph depends on the stream context and buffer pointers.
+  llvm::SmallVector<RCReference<AsyncValue>, 4> arguments = {
+      chain.CopyRCRef(), stream.CopyRCRef()};
+  for (const auto& buffer : buffers) arguments.push_back(buffer.CopyRCRef());
+  tfrt::Await(arguments);
+  for (const auto& argument : arguments) {
+    if (argument->IsError()) return AsyncValueRef<Chain>(argument.CopyRef());
+  }
+
+  std::vector<wrapper::Pointer<void>> pointers;
+  pointers.reserve(buffers.size());
+  for (const auto& buffer : buffers) pointers.push_back(buffer->pointer());
+
+  auto current = wrapper::CtxSetCurrent(stream->context()->get());
+  if (!current) return MakeErrorAsyncValueRef(current.takeError());
+
+  mutex_lock lock(mutex_);
+  if (!graph_exec_ ||
+      context_.GetAsyncValue() != stream->context().GetAsyncValue() ||
+      pointers_ != pointers) {
+    if (auto error = Capture(*current, exec_ctx, chain.CopyRef(),
+                             stream.CopyRef(), buffers)) {
+      return MakeErrorAsyncValueRef(std::move(error));
+    }
+    context_ = stream->context().CopyRef();
+    pointers_ = std::move(pointers);
+  }
+
+  if (auto error = wrapper::GraphLaunch(graph_exec_.get(), stream->get()))
+    return MakeErrorAsyncValueRef(std::move(error));
+  return MakeAvailableAsyncValueRef<Chain>();
+}
+
+llvm::Error CapturedFunction::Capture(
+    wrapper::CurrentContext current, const ExecutionContext& exec_ctx,
+    AsyncValueRef<Chain> chain, AsyncValueRef<GpuStream> stream,
+    ArrayRef<AsyncValueRef<GpuBuffer>> buffers) {
+  if (auto error = wrapper::StreamBeginCapture(stream->get())) return error;
+  auto result = gpu::Execute(exec_ctx, function_, std::move(chain),
+                             stream.CopyRef(), buffers);
+  tfrt::Await(result.GetAsyncValue());
+  // End the capture even if the execution failed, to reset the stream.
+  auto graph = wrapper::StreamEndCapture(stream->get());
+  if (result.IsError()) {
+    llvm::consumeError(graph.takeError());
+    return MakeStringError(result.GetError().message());
+  }
+  if (!graph) return graph.takeError();
+
+  // Try to update the parameters of the instantiated graph in place. This
+  // fails if the new graph has a different topology.
+  if (graph_exec_ &&
+      context_.GetAsyncValue() == stream->context().GetAsyncValue()) {
+    auto updated = wrapper::GraphExecUpdate(graph_exec_.get(), graph->get());
+    if (!updated) return updated.takeError();
+    if (*updated) return llvm::Error::success();
+  }
+
+  auto graph_exec = wrapper::GraphInstantiate(current, graph->get());
+  if (!graph_exec) return graph_exec.takeError();
+  graph_exec_ = std::move(*graph_exec);
+  return llvm::Error::success();
+}
+
 static llvm::Expected<EntryPoint> GetEntryPointKernel(
     ArrayAttribute<int64_t> buffer_sizes, StringAttribute function_name,
     Attribute<int32_t> platform, Attribute<int64_t> version) {
@@ -21,6 +21,9 @@
 #include <utility>
 #include <vector>
 
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/xxhash.h"
 #include "tfrt/gpu/wrapper/blas_wrapper.h"
 #include "tfrt/gpu/wrapper/ccl_wrapper.h"
 #include "tfrt/gpu/wrapper/cuda_wrapper.h"
@@ -57,6 +60,45 @@ void GpuContext::HostMemoryPool::Deallocate(GpuPointer pointer,
   pool_.emplace(size_bytes, pointer);
 }
 
+// Implements the FFT plan and solver handle pools of GpuContext.
+class GpuContext::HandlePool {
+ public:
+  wrapper::OwningFftHandle TakeFftPlan(ArrayRef<int64_t> key) {
+    mutex_lock lock(mutex_);
+    auto it = fft_plans_.find(std::vector<int64_t>(key.begin(), key.end()));
+    if (it == fft_plans_.end()) return nullptr;
+    auto plan = std::move(it->second);
+    fft_plans_.erase(it);
+    return plan;
+  }
+
+  void ReleaseFftPlan(ArrayRef<int64_t> key, wrapper::OwningFftHandle plan) {
+    mutex_lock lock(mutex_);
+    fft_plans_.emplace(std::vector<int64_t>(key.begin(), key.end()),
+                       std::move(plan));
+  }
+
+  wrapper::OwningSolverHandle TakeSolverHandle() {
+    mutex_lock lock(mutex_);
+    if (solver_handles_.empty()) return nullptr;
+    auto handle = std::move(solver_handles_.back());
+    solver_handles_.pop_back();
+    return handle;
+  }
+
+  void ReleaseSolverHandle(wrapper::OwningSolverHandle handle) {
+    mutex_lock lock(mutex_);
+    solver_handles_.push_back(std::move(handle));
+  }
+
+ private:
+  mutex mutex_;
+  std::multimap<std::vector<int64_t>, wrapper::OwningFftHandle> fft_plans_
+      TFRT_GUARDED_BY(mutex_);
+  std::vector<wrapper::OwningSolverHandle> solver_handles_
+      TFRT_GUARDED_BY(mutex_);
+};
+
 // Implements 'AddEventualCallback()' and 'MaybeInvokeCallbacks()'.
 //
 // Holds a list of event/callback pairs and queries (on-demand and regularly)
@@ -178,6 +220,8 @@ class GpuContext::CallbackManager : public ReferenceCounted<CallbackManager> {
 GpuContext::GpuContext(wrapper::OwningContext context)
     : context_(std::move(context)),
       host_memory_pool_(new HostMemoryPool()),
+      handle_pool_(new HandlePool()),
+      pinned_host_memory_pool_(TakeRef(new PinnedHostMemoryPool())),
       callback_manager_(TakeRef(new CallbackManager)) {}
 
 GpuContext::~GpuContext() {
@@ -191,9 +235,28 @@ wrapper::Context GpuContext::release() {
   callback_manager_->ClearPool();
   callback_manager_.reset();
   host_memory_pool_.reset();
+  handle_pool_.reset();
+  pinned_host_memory_pool_.reset();
   return context_.release();
 }
 
+wrapper::OwningFftHandle GpuContext::TakeFftPlan(ArrayRef<int64_t> key) const {
+  return handle_pool_->TakeFftPlan(key);
+}
+
+void GpuContext::ReleaseFftPlan(ArrayRef<int64_t> key,
+                                wrapper::OwningFftHandle plan) const {
+  handle_pool_->ReleaseFftPlan(key, std::move(plan));
+}
+
+wrapper::OwningSolverHandle GpuContext::TakeSolverHandle() const {
+  return handle_pool_->TakeSolverHandle();
+}
+
+void GpuContext::ReleaseSolverHandle(wrapper::OwningSolverHandle handle) const {
+  handle_pool_->ReleaseSolverHandle(std::move(handle));
+}
+
 Error GpuContext::AddEventualCallback(wrapper::CurrentContext current,
                                       const GpuStream& stream,
                                       llvm::unique_function<void()> callback,
@@ -230,16 +293,87 @@ wrapper::Event GpuEvent::release() {
 
 GpuModule::GpuModule(AsyncValueRef<GpuContext> context,
                      wrapper::OwningModule module)
-    : context_(std::move(context)), module_(std::move(module)) {}
+    : context_(std::move(context)),
+      owned_module_(std::move(module)),
+      module_(owned_module_.get()) {}
+
+GpuModule::GpuModule(AsyncValueRef<GpuContext> context, wrapper::Module module)
+    : context_(std::move(context)), module_(module) {}
 
 GpuModule::~GpuModule() = default;
 
+GpuModuleCache& GpuModuleCache::Global() {
+  // Leaked, modules must not be unloaded after the driver has shut down.
+  static auto* cache = new GpuModuleCache;
+  return *cache;
+}
+
+Expected<GpuModuleCache::Entry*> GpuModuleCache::GetEntry(
+    wrapper::CurrentContext current) {
+  wrapper::Context context = current.context();
+  {
+    mutex_lock lock(mutex_);
+    auto it = entries_.find(context);
+    if (it != entries_.end()) return it->second.get();
+  }
+
+  auto device = wrapper::CtxGetDevice(current);
+  if (!device) return device.takeError();
+
+  mutex_lock lock(mutex_);
+  auto it = llvm::find_if(primary_contexts_, [&](const auto& pair) {
+    return pair.first == *device;
+  });
+  if (it == primary_contexts_.end()) {
+    auto primary = wrapper::DevicePrimaryCtxRetain(*device);
+    if (!primary) return primary.takeError();
+    // Keep the primary context alive for as long as its modules are cached.
+    primary_contexts_.emplace_back(*device, primary->release());
+    it = std::prev(primary_contexts_.end());
+  }
+  if (it->second != context) return nullptr;
+
+  auto& entry = entries_[context];
+  if (!entry) entry = std::make_unique<Entry>();
+  return entry.get();
+}
+
+Expected<wrapper::Module> GpuModuleCache::GetOrLoad(
+    wrapper::CurrentContext current, string_view image,
+    llvm::function_ref<Expected<wrapper::OwningModule>()> load) {
+  auto entry = GetEntry(current);
+  if (!entry) return entry.takeError();
+  if (*entry == nullptr) return wrapper::Module();
+
+  std::pair<uint64_t, size_t> key(llvm::xxHash64(image), image.size());
+  mutex_lock lock((*entry)->mu);
+  auto& module = (*entry)->modules[key];
+  if (module == nullptr) {
+    auto loaded = load();
+    if (!loaded) {
+      (*entry)->modules.erase(key);
+      return loaded.takeError();
+    }
+    module = std::move(*loaded);
+  }
+  return module.get();
+}
+
 GpuFunction::GpuFunction(AsyncValueRef<GpuModule> module,
                          wrapper::Function function)
     : module_(std::move(module)), function_(function) {}
 
 GpuFunction::~GpuFunction() = default;
 
+Error GpuAllocator::DeallocateAfter(GpuPointer pointer,
+                                    ArrayRef<wrapper::Stream> streams) {
+  if (streams.size() == 1) return Deallocate(pointer, streams.front());
+  for (auto stream : streams) {
+    if (auto error = wrapper::StreamSynchronize(stream)) return error;
+  }
+  return Deallocate(pointer, wrapper::Stream());
+}
+
 GpuDefaultAllocator::GpuDefaultAllocator(AsyncValueRef<GpuContext> context)
     : context_(std::move(context)) {}
 
@@ -337,6 +471,15 @@ Error GpuBuffer::Deallocate(wrapper::Stream stream) {
   return allocator->Deallocate(pointer, stream);
 }
 
+Error GpuBuffer::DeallocateAfter(ArrayRef<wrapper::Stream> streams) {
+  size_ = 0;
+  auto allocator = std::move(allocator_);
+  if (!pointer_) return Error::success();
+  auto pointer = pointer_;
+  pointer_ = GpuPointer();
+  return allocator->DeallocateAfter(pointer, streams);
+}
+
 GpuBlasHandle::GpuBlasHandle(AsyncValueRef<GpuContext> context,
                              wrapper::OwningBlasHandle handle)
     : context_(std::move(context)), handle_(std::move(handle)) {}
@@ -361,16 +504,175 @@ void GpuCclHandle::AddCallback(Callback callback) {
   callbacks_.push_back(std::move(callback));
 }
 
+void GpuCclHandle::AddAllReduce(AsyncValueRef<GpuBuffer> input,
+                                AsyncValueRef<GpuBuffer> output,
+                                wrapper::CclDataType data_type,
+                                wrapper::CclReductionOp reduction_op) {
+  all_reduces_.push_back(
+      {std::move(input), std::move(output), data_type, reduction_op});
+}
+
+namespace {
+// A flat buffer of all-reduces fused into one collective.
+struct AllReduceBucket {
+  struct Member {
+    GpuPointer input;
+    GpuPointer output;
+    size_t offset;  // Within the bucket.
+    size_t size_bytes;
+  };
+
+  wrapper::CclDataType data_type;
+  wrapper::CclReductionOp reduction_op;
+  size_t offset = 0;  // Within bucket memory.
+  size_t size_bytes = 0;
+  llvm::SmallVector<Member, 16> members;
+};
+}  // namespace
+
+llvm::Error GpuCclHandle::ReserveBucketMemory(wrapper::CurrentContext current,
+                                              wrapper::Stream stream,
+                                              size_t size_bytes) {
+  if (size_bytes <= bucket_memory_size_) {
+    // The previous execution may have used another stream.
+    return wrapper::StreamWaitEvent(stream, bucket_event_.get());
+  }
+  if (bucket_event_) {
+    if (auto error = wrapper::EventSynchronize(bucket_event_.get()))
+      return error;
+  } else {
+    auto event = wrapper::EventCreateNoTiming(current);
+    if (!event) return event.takeError();
+    bucket_event_ = std::move(*event);
+  }
+  bucket_memory_.reset();
+  bucket_memory_size_ = 0;
+  auto memory = wrapper::MemAlloc(current, size_bytes);
+  if (!memory) return memory.takeError();
+  bucket_memory_ = std::move(*memory);
+  bucket_memory_size_ = size_bytes;
+  return llvm::Error::success();
+}
+
 llvm::Error GpuCclHandle::ExecuteCallbacks(wrapper::CurrentContext current,
                                            wrapper::Stream stream) {
+  // Assign small all-reduces to buckets, and run the others unfused.
+  std::vector<AllReduceBucket> buckets;
+  llvm::SmallDenseMap<std::pair<int, int>, size_t> open_buckets;
+  std::vector<AllReduce*> unfused;
+  size_t total_bytes = 0;
+  for (auto& all_reduce : all_reduces_) {
+    size_t size_bytes = all_reduce.input->size();
+    if (size_bytes == 0 || size_bytes >= kMaxFusedAllReduceBytes ||
+        size_bytes != all_reduce.output->size()) {
+      unfused.push_back(&all_reduce);
+      continue;
+    }
+    auto key = std::make_pair(all_reduce.data_type.ToOpaqueValue(),
+                              all_reduce.reduction_op.ToOpaqueValue());
+    auto it = open_buckets.find(key);
+    if (it == open_buckets.end() ||
+        buckets[it->second].size_bytes + size_bytes > kAllReduceBucketBytes) {
+      // Start a new bucket.
+      total_bytes = llvm::alignTo(total_bytes, GpuAllocator::kAlignment);
+      AllReduceBucket bucket;
+      bucket.data_type = all_reduce.data_type;
+      bucket.reduction_op = all_reduce.reduction_op;
+      bucket.offset = total_bytes;
+      buckets.push_back(std::move(bucket));
+      open_buckets[key] = buckets.size() - 1;
+      it = open_buckets.find(key);
+    }
+    auto& bucket = buckets[it->second];
+    bucket.members.push_back({all_reduce.input->pointer(),
+                              all_reduce.output->pointer(), bucket.size_bytes,
+                              size_bytes});
+    bucket.size_bytes += size_bytes;
+    total_bytes = bucket.offset + bucket.size_bytes;
+  }
+
+  // Returns a pointer 'offset' bytes into the bucket memory.
+  auto get_bucket_pointer = [&](size_t offset) -> GpuPointer {
+    return static_cast<wrapper::Pointer<char>>(bucket_memory_.get()) + offset;
+  };
+
+  if (!buckets.empty()) {
+    if (auto error = ReserveBucketMemory(current, stream, total_bytes))
+      return error;
+    for (const auto& bucket : buckets) {
+      for (const auto& member : bucket.members) {
+        if (auto error = wrapper::MemcpyAsync(
+                current, get_bucket_pointer(bucket.offset + member.offset),
+                member.input, member.size_bytes, stream))
+          return error;
+      }
+    }
+  }
+
   if (auto error = wrapper::CclGroupStart(current.platform())) return error;
   for (auto& callback : callbacks_)
     if (auto error = callback(current, stream, comm_.get())) return error;
+  for (auto* all_reduce : unfused) {
+    auto width = wrapper::GetCclDataTypeSizeBytes(all_reduce->data_type);
+    if (!width) return width.takeError();
+    if (auto error = wrapper::CclAllReduce(
+            current, all_reduce->input->pointer(),
+            all_reduce->output->pointer(), all_reduce->input->size() / *width,
+            all_reduce->data_type, all_reduce->reduction_op, comm_.get(),
+            stream))
+      return error;
+  }
+  for (const auto& bucket : buckets) {
+    auto width = wrapper::GetCclDataTypeSizeBytes(bucket.data_type);
+    if (!width) return width.takeError();
+    auto pointer = get_bucket_pointer(bucket.offset);
+    if (auto error = wrapper::CclAllReduce(
+            current, pointer, pointer, bucket.size_bytes / *width,
+            bucket.data_type, bucket.reduction_op, comm_.get(), stream))
+      return error;
+  }
   if (auto error = wrapper::CclGroupEnd(current.platform())) return error;
+
+  for (const auto& bucket : buckets) {
+    for (const auto& member : bucket.members) {
+      if (auto error = wrapper::MemcpyAsync(
+              current, member.output,
+              get_bucket_pointer(bucket.offset + member.offset),
+              member.size_bytes, stream))
+        return error;
+    }
+  }
+  if (!buckets.empty()) {
+    if (auto error = wrapper::EventRecord(bucket_event_.get(), stream))
+      return error;
+  }
+
   callbacks_.clear();
+  all_reduces_.clear();
   return llvm::Error::success();
 }
 
+llvm::Expected<wrapper::OwningEvent> GpuCclHandle::ExecuteCallbacksAsync(
+    wrapper::CurrentContext current, wrapper::Stream stream) {
+  if (!comm_stream_) {
+    auto comm_stream = wrapper::StreamCreateNonBlocking(current);
+    if (!comm_stream) return comm_stream.takeError();
+    comm_stream_ = std::move(*comm_stream);
+  }
+  auto event = wrapper::EventCreateNoTiming(current);
+  if (!event) return event.takeError();
+  if (auto error = wrapper::EventRecord(event->get(), stream))
+    return std::move(error);
+  if (auto error = wrapper::StreamWaitEvent(comm_stream_.get(), event->get()))
+    return std::move(error);
+  if (auto error = ExecuteCallbacks(current, comm_stream_.get()))
+    return std::move(error);
+  // Reuse the event, the wait above has already been enqueued.
+  if (auto error = wrapper::EventRecord(event->get(), comm_stream_.get()))
+    return std::move(error);
+  return std::move(*event);
+}
+
 GpuDnnHandle::GpuDnnHandle(AsyncValueRef<GpuContext> context,
                            wrapper::OwningDnnHandle handle)
     : context_(std::move(context)), handle_(std::move(handle)) {}
@@ -381,14 +683,23 @@ GpuSolverHandle::GpuSolverHandle(AsyncValueRef<GpuContext> context,
                                  wrapper::OwningSolverHandle handle)
     : context_(std::move(context)), handle_(std::move(handle)) {}
 
-GpuSolverHandle::~GpuSolverHandle() = default;
+GpuSolverHandle::~GpuSolverHandle() {
+  if (context_ && handle_) context_->ReleaseSolverHandle(std::move(handle_));
+}
 
 GpuFftHandle::GpuFftHandle(AsyncValueRef<GpuContext> context,
                            wrapper::OwningFftHandle handle,
-                           wrapper::FftType type)
-    : context_(std::move(context)), handle_(std::move(handle)), type_(type) {}
+                           wrapper::FftType type,
+                           std::vector<int64_t> plan_key)
+    : context_(std::move(context)),
+      handle_(std::move(handle)),
+      type_(type),
+      plan_key_(std::move(plan_key)) {}
 
-GpuFftHandle::~GpuFftHandle() = default;
+GpuFftHandle::~GpuFftHandle() {
+  if (context_ && handle_ && !plan_key_.empty())
+    context_->ReleaseFftPlan(plan_key_, std::move(handle_));
+}
 
 }  // namespace gpu
 }  // namespace tfrt
@@ -243,6 +243,44 @@ static Error BlasTrsmBatch(
       a_array_ptr, heightA, b_array_ptr, heightB, batchCount);
 }
 
+// Factorizes many small matrices in one call, which is much faster than one
+// tfrt_gpu.solver call per matrix.
+static Error BlasGetrfBatch(const GpuBlasHandle& handle,
+                            const GpuStream& stream, int32_t n,
+                            const GpuBuffer& buffer, int32_t heightA,
+                            const GpuBuffer& pivots, const GpuBuffer& devInfo,
+                            int32_t batchCount,
+                            // Needs to be sorted alphabetically by attribute
+                            // name!
+                            Attribute<int32_t> dataType) {
+  auto data_type = wrapper::BlasDataType::FromOpaqueValue(*dataType);
+  auto data_type_size_bytes = wrapper::GetBlasDataTypeSizeBytes(data_type);
+  if (!data_type_size_bytes) return data_type_size_bytes.takeError();
+
+  auto current = wrapper::CtxSetCurrent(handle.context()->get());
+  if (!current) return current.takeError();
+
+  if (auto error = wrapper::BlasSetStream(handle.get(), stream.get()))
+    return error;
+
+  auto pointer_array =
+      handle.context()->AllocateHostPoolMemory<void*>(*current, batchCount);
+  if (!pointer_array) return pointer_array.takeError();
+
+  wrapper::Platform platform = handle->platform();
+  void** a_array = pointer_array->get().raw(platform);
+  ptrdiff_t batch_stride_bytes = *data_type_size_bytes * heightA * n;
+  char* a_ptr = static_cast<char*>(buffer.pointer().raw(platform));
+  for (int32_t i = 0; i < batchCount; ++i)
+    a_array[i] = a_ptr + i * batch_stride_bytes;
+
+  wrapper::Pointer<void*> a_array_ptr(a_array, platform);
+  return wrapper::BlasGetrfBatched(
+      *current, handle.get(), data_type, n, a_array_ptr, heightA,
+      static_cast<wrapper::Pointer<int>>(pivots.pointer()),
+      static_cast<wrapper::Pointer<int>>(devInfo.pointer()), batchCount);
+}
+
 void RegisterGpuBlasKernels(KernelRegistry* kernel_reg) {
   kernel_reg->AddKernel("tfrt_gpu.blas.create", TFRT_KERNEL(BlasCreate));
   kernel_reg->AddKernel("tfrt_gpu.blas.axpy",
@@ -256,6 +294,8 @@ void RegisterGpuBlasKernels(KernelRegistry* kernel_reg) {
                         TFRT_KERNEL_WITH_CHAIN_RESULT(BlasScal));
   kernel_reg->AddKernel("tfrt_gpu.blas.trsm.batch",
                         TFRT_KERNEL_WITH_CHAIN_RESULT(BlasTrsmBatch));
+  kernel_reg->AddKernel("tfrt_gpu.blas.getrf.batch",
+                        TFRT_KERNEL_WITH_CHAIN_RESULT(BlasGetrfBatch));
 }
 }  // namespace gpu
 }  // namespace tfrt
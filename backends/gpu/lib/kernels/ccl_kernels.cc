@@ -81,15 +81,8 @@ static Error CclAllReduce(
   if (!width) return width.takeError();
   assert(*width != 0);
 
-  handle->AddCallback([input = input.ValueRef(), output = output.ValueRef(),
-                       count = input->size() / *width, type,
-                       op = static_cast<ncclRedOp_t>(*reduction_op)](
-                          wrapper::CurrentContext current,
-                          wrapper::Stream stream,
-                          wrapper::CclComm comm) -> llvm::Error {
-    return wrapper::CclAllReduce(current, input->pointer(), output->pointer(),
-                                 count, type, op, comm, stream);
-  });
+  handle->AddAllReduce(input.ValueRef(), output.ValueRef(), type,
+                       static_cast<ncclRedOp_t>(*reduction_op));
 
   return Error::success();
 }
@@ -224,6 +217,26 @@ static AsyncValueRef<Chain> CclExecute(Argument<GpuStream> stream,
           }));
 }
 
+// Same as CclExecute, but runs the collectives on the communication stream of
+// the handle and returns an event which is recorded when they complete.
+static AsyncValueRef<GpuEvent> CclExecuteAsync(
+    Argument<GpuStream> stream, Argument<GpuCclHandle> handle,
+    const ExecutionContext& exec_ctx) {
+  // CclGroupEnd() blocks to wait for all participants and therefore needs to
+  // run inside a blocking task.
+  return RunBlockingWork(
+      exec_ctx.host(),
+      DestroyCapturesOnInvoke(
+          [stream = stream.ValueRef(),
+           handle = handle.ValueRef()]() -> Expected<GpuEvent> {
+            auto current = wrapper::CtxSetCurrent(stream->context()->get());
+            if (!current) return current.takeError();
+            auto event = handle->ExecuteCallbacksAsync(*current, stream->get());
+            if (!event) return event.takeError();
+            return GpuEvent(stream->context().CopyRef(), std::move(*event));
+          }));
+}
+
 void RegisterGpuCclKernels(KernelRegistry* kernel_reg) {
   kernel_reg->AddKernel("tfrt_gpu.ccl.unique_id", TFRT_KERNEL(CclUniqueId));
   kernel_reg->AddKernel("tfrt_gpu.ccl.create", TFRT_KERNEL(CclCreate));
@@ -240,6 +253,8 @@ void RegisterGpuCclKernels(KernelRegistry* kernel_reg) {
   kernel_reg->AddKernel("tfrt_gpu.ccl.all_to_all",
                         TFRT_KERNEL_WITH_CHAIN_RESULT(CclAllToAll));
   kernel_reg->AddKernel("tfrt_gpu.ccl.execute", TFRT_KERNEL(CclExecute));
+  kernel_reg->AddKernel("tfrt_gpu.ccl.execute_async",
+                        TFRT_KERNEL(CclExecuteAsync));
 }
 }  // namespace gpu
 }  // namespace tfrt
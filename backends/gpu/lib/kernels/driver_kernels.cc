@@ -13,11 +13,19 @@
 // limitations under the License.
 
 // This file implements the tfrt_gpu kernels that talk to the driver API.
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <string>
+#include <thread>
 #include <tuple>
 #include <utility>
+#include <vector>
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Error.h"
 #include "llvm_derived/Support/raw_ostream.h"
 #include "tfrt/dtype/dtype.h"
@@ -32,13 +40,115 @@
 #include "tfrt/host_context/attribute_utils.h"
 #include "tfrt/host_context/kernel_registry.h"
 #include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
 #include "tfrt/support/ref_count.h"
+#include "tfrt/support/thread_annotations.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 #include "tfrt/tensor/tensor_shape.h"
 
 namespace tfrt {
 namespace gpu {
 
+namespace {
+// Sets chains available when their events complete, without blocking a thread
+// per synchronization. A single poller thread queries all pending events, and
+// hands the completed ones in one batch per host to the non-blocking work
+// queue, where their chains are set available.
+//
+// The poller thread sleeps while there are no pending events, and backs off
+// exponentially (up to kMaxPollInterval) while none of them completes.
+class EventPoller {
+ public:
+  static EventPoller& Get() {
+    // Never destroyed, the poller thread is detached.
+    static auto* poller = new EventPoller();
+    return *poller;
+  }
+
+  // Returns a chain that becomes available when all work recorded by 'event'
+  // has completed and the pending callbacks of the event's context have been
+  // invoked.
+  AsyncValueRef<Chain> Await(HostContext* host,
+                             AsyncValueRef<GpuEvent> event) {
+    auto chain = MakeUnconstructedAsyncValueRef<Chain>();
+    mutex_lock lock(mutex_);
+    bool was_empty = new_entries_.empty();
+    new_entries_.push_back({host, std::move(event), chain.CopyRef()});
+    if (was_empty) cv_.notify_one();
+    return chain;
+  }
+
+ private:
+  static constexpr std::chrono::microseconds kMinPollInterval{10};
+  static constexpr std::chrono::microseconds kMaxPollInterval{500};
+
+  struct Entry {
+    HostContext* host;
+    AsyncValueRef<GpuEvent> event;
+    AsyncValueRef<Chain> chain;
+    std::string error;
+  };
+
+  EventPoller() { std::thread([this] { Run(); }).detach(); }
+
+  void Run() {
+    std::vector<Entry> pending;
+    auto poll_interval = kMinPollInterval;
+    while (true) {
+      {
+        mutex_lock lock(mutex_);
+        while (pending.empty() && new_entries_.empty()) cv_.wait(lock);
+        std::move(new_entries_.begin(), new_entries_.end(),
+                  std::back_inserter(pending));
+        new_entries_.clear();
+      }
+
+      // Move completed (or failed) entries to the end of 'pending'.
+      auto first_completed = std::stable_partition(
+          pending.begin(), pending.end(), [](Entry& entry) {
+            auto ready = wrapper::EventQuery(entry.event->get());
+            if (!ready) entry.error = StrCat(ready.takeError());
+            return ready && !*ready;
+          });
+
+      if (first_completed == pending.end()) {
+        std::this_thread::sleep_for(poll_interval);
+        poll_interval = std::min(2 * poll_interval, kMaxPollInterval);
+        continue;
+      }
+      poll_interval = kMinPollInterval;
+
+      // Entries are usually all from the same host, dispatch one batch each.
+      for (auto it = first_completed; it != pending.end();) {
+        HostContext* host = it->host;
+        auto batch_end = std::stable_partition(
+            it, pending.end(),
+            [&](const Entry& entry) { return entry.host == host; });
+        std::vector<Entry> batch(std::make_move_iterator(it),
+                                 std::make_move_iterator(batch_end));
+        EnqueueWork(host, [batch = std::move(batch)] {
+          for (const auto& entry : batch) SetAvailable(entry);
+        });
+        it = batch_end;
+      }
+      pending.erase(first_completed, pending.end());
+    }
+  }
+
+  static void SetAvailable(const Entry& entry) {
+    if (!entry.error.empty()) return entry.chain.SetError(entry.error);
+    auto none_pending = entry.event->context()->MaybeInvokeCallbacks();
+    if (!none_pending)
+      return entry.chain.SetError(StrCat(none_pending.takeError()));
+    entry.chain.emplace();
+  }
+
+  mutex mutex_;
+  condition_variable cv_;
+  std::vector<Entry> new_entries_ TFRT_GUARDED_BY(mutex_);
+};
+}  // namespace
+
 // tfrt_gpu.device.get returns the gpu device at the given index.
 static Expected<wrapper::Device> GpuDeviceGet(int32_t ordinal,
                                               Attribute<int32_t> platform) {
@@ -86,16 +196,24 @@ static Error GpuStreamWait(const GpuStream& stream, const GpuEvent& event) {
 // (including callbacks) previously enqueued on the stream is completed.
 static AsyncValueRef<Chain> GpuStreamSynchronize(
     Argument<GpuStream> stream, const ExecutionContext& exec_ctx) {
-  return EnqueueBlockingWork(
-      exec_ctx.host(),
-      DestroyCapturesOnInvoke(
-          [stream = stream.ValueRef()]() -> Expected<Chain> {
-            if (auto error = wrapper::StreamSynchronize(stream->get()))
-              return std::move(error);
-            auto none_pending = stream->context()->MaybeInvokeCallbacks();
-            if (auto error = none_pending.takeError()) return std::move(error);
-            return Chain();
-          }));
+  // Check if the stream is already idle and we can skip polling.
+  auto ready = wrapper::StreamQuery(stream->get());
+  if (!ready) return MakeErrorAsyncValueRef(StrCat(ready.takeError()));
+  if (*ready) {
+    if (auto error = stream->context()->MaybeInvokeCallbacks().takeError())
+      return MakeErrorAsyncValueRef(StrCat(std::move(error)));
+    return GetReadyChain();
+  }
+  // Record an event on the stream and wait for it to complete.
+  auto current = wrapper::CtxSetCurrent(stream->context()->get());
+  if (!current) return MakeErrorAsyncValueRef(StrCat(current.takeError()));
+  auto event = wrapper::EventCreateNoTiming(*current);
+  if (!event) return MakeErrorAsyncValueRef(StrCat(event.takeError()));
+  if (auto error = wrapper::EventRecord(event->get(), stream->get()))
+    return MakeErrorAsyncValueRef(StrCat(std::move(error)));
+  return EventPoller::Get().Await(
+      exec_ctx.host(), MakeAvailableAsyncValueRef<GpuEvent>(
+                           stream->context().CopyRef(), std::move(*event)));
 }
 
 // tfrt_gpu.event.create creates a new cuda event.
@@ -117,6 +235,9 @@ static Error GpuEventRecord(const GpuEvent& event, const GpuStream& stream) {
 // tfrt_gpu.event.synchronize sets the output chain when the event has been
 // reached, i.e. all work (including callbacks) scheduled prior to the last call
 // to tfrt_gpu.event.record has been completed.
+//
+// The event is polled until it completes, so it must not be recorded again
+// before the output chain is available.
 static AsyncValueRef<Chain> GpuEventSynchronize(
     Argument<GpuEvent> event, const ExecutionContext& exec_ctx) {
   // Check if event has already completed and we can skip enqueuing work.
@@ -127,15 +248,7 @@ static AsyncValueRef<Chain> GpuEventSynchronize(
       return MakeErrorAsyncValueRef(StrCat(std::move(error)));
     return GetReadyChain();
   }
-  return EnqueueBlockingWork(
-      exec_ctx.host(),
-      DestroyCapturesOnInvoke([event = event.ValueRef()]() -> Expected<Chain> {
-        if (auto error = wrapper::EventSynchronize(event->get()))
-          return std::move(error);
-        if (auto error = event->context()->MaybeInvokeCallbacks().takeError())
-          return std::move(error);
-        return Chain();
-      }));
+  return EventPoller::Get().Await(exec_ctx.host(), event.ValueRef());
 }
 
 // tfrt_gpu.allocator.create creates a new allocator.
@@ -205,6 +318,10 @@ static Error GpuMemSet(const GpuBuffer& buffer, AsyncValue* untyped_value,
                                  count, stream.get());
 }
 
+// Larger copies from pageable host memory are not staged, to bound the pinned
+// memory held by the pool.
+static constexpr size_t kMaxStagedCopyBytes = size_t{64} << 20;
+
 // tfrt_gpu.mem.copy copies memory between host or device.
 static Error GpuMemCopy(RemainingArguments args,
                         const ExecutionContext& exec_ctx) {
@@ -240,6 +357,26 @@ static Error GpuMemCopy(RemainingArguments args,
   // Skip copy if source and destination are the same.
   if (dst_ptr == src_ptr) return Error::success();
 
+  // Stage copies from pageable host memory to the GPU through a pinned
+  // buffer. The copy then runs at full bandwidth and does not block the host.
+  // Copies to pageable host memory stay synchronous.
+  auto* pool = stream.context()->pinned_host_memory_pool();
+  const void* src_host_ptr = src_ptr.raw(current->platform());
+  if (args[0]->IsType<GpuBuffer>() &&
+      args[1]->IsType<RCReference<HostBuffer>>() &&
+      dst_size <= kMaxStagedCopyBytes && !pool->IsPinned(src_host_ptr)) {
+    auto staging = pool->Allocate(*current, dst_size);
+    if (!staging) return staging.takeError();
+    std::memcpy((*staging)->data(), src_host_ptr, dst_size);
+    GpuPointer staging_ptr((*staging)->data(), current->platform());
+    if (auto error = wrapper::MemcpyAsync(*current, dst_ptr, staging_ptr,
+                                          dst_size, stream.get()))
+      return error;
+    // Return the staging buffer to the pool once the copy has completed.
+    return GpuContext::AddEventualCallback(
+        *current, stream, [staging = std::move(*staging)] {}, exec_ctx.host());
+  }
+
   return wrapper::MemcpyAsync(*current, dst_ptr, src_ptr, dst_size,
                               stream.get());
 }
@@ -339,23 +476,32 @@ static Expected<GpuModule> GpuModuleLoad(Argument<GpuContext> context,
   auto current = wrapper::CtxSetCurrent(context->get());
   if (!current) return current.takeError();
 
+  auto load = [&]() -> Expected<wrapper::OwningModule> {
 #ifdef NDEBUG
-  auto module = wrapper::ModuleLoadData(*current, blob.data());
-  if (!module) return module.takeError();
+    return wrapper::ModuleLoadData(*current, blob.data());
 #else
-  std::string info_log;
-  std::string error_log;
+    std::string info_log;
+    std::string error_log;
 
-  wrapper::ModuleLoadOptions options{&info_log, &error_log, 1};
-  auto module = wrapper::ModuleLoadDataEx(*current, blob.data(), options);
-  if (!info_log.empty()) TFRT_LOG_INFO << "GPU JIT info log: " << info_log;
+    wrapper::ModuleLoadOptions options{&info_log, &error_log, 1};
+    auto module = wrapper::ModuleLoadDataEx(*current, blob.data(), options);
+    if (!info_log.empty()) TFRT_LOG_INFO << "GPU JIT info log: " << info_log;
 
-  if (!module) {
-    return llvm::joinErrors(module.takeError(),
-                            MakeStringError("GPU JIT error log: ", error_log));
-  }
+    if (!module) {
+      return llvm::joinErrors(
+          module.takeError(), MakeStringError("GPU JIT error log: ", error_log));
+    }
+    return module;
 #endif
+  };
+
+  // Share modules loaded into primary contexts across BEF files and contexts.
+  auto cached = GpuModuleCache::Global().GetOrLoad(*current, blob, load);
+  if (!cached) return cached.takeError();
+  if (*cached != nullptr) return GpuModule(context.ValueRef(), *cached);
 
+  auto module = load();
+  if (!module) return module.takeError();
   return GpuModule(context.ValueRef(), std::move(*module));
 }
 
@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <iterator>
 #include <utility>
+#include <vector>
 
 #include "llvm/ADT/SmallVector.h"
 #include "tfrt/gpu/gpu_types.h"
@@ -30,7 +31,8 @@
 namespace tfrt {
 namespace gpu {
 
-// tfrt_gpu.fft_create_handle creates an FFT handle
+// tfrt_gpu.fft_create_handle creates an FFT handle. Reuses a plan of an FFT
+// handle with the same parameters that has been destroyed, if there is one.
 static Expected<GpuFftHandle> FftCreate(
     Argument<GpuContext> context,
     // Needs to be sorted alphabetically by attribute name!
@@ -55,6 +57,18 @@ static Expected<GpuFftHandle> FftCreate(
   if (dims.size() != in_dims.size() || dims.size() != out_dims.size())
     return MakeStringError("Inconsistent dims/strides lengths");
 
+  auto fft_type = wrapper::FftType::FromOpaqueValue(*type);
+  std::vector<int64_t> plan_key = {*type, *batch};
+  for (ArrayRef<int64_t> values :
+       {dims.data(), in_strides.data(), out_strides.data()}) {
+    plan_key.push_back(values.size());
+    plan_key.insert(plan_key.end(), values.begin(), values.end());
+  }
+  if (auto plan = context->TakeFftPlan(plan_key)) {
+    return GpuFftHandle(context.ValueRef(), std::move(plan), fft_type,
+                        std::move(plan_key));
+  }
+
   auto current = wrapper::CtxSetCurrent(context->get());
   if (!current) return current.takeError();
 
@@ -63,14 +77,14 @@ static Expected<GpuFftHandle> FftCreate(
   if (auto error = wrapper::FftDisableAutoAllocation(handle->get()))
     return std::move(error);
 
-  auto fft_type = wrapper::FftType::FromOpaqueValue(*type);
   auto workspace_size = wrapper::FftMakePlanMany(
       handle->get(), fft_type, *batch, dims.data(), in_dims,
       in_strides[dims.size()], in_strides[0], out_dims,
       out_strides[dims.size()], out_strides[0]);
   if (!workspace_size) return workspace_size.takeError();
 
-  return GpuFftHandle(context.ValueRef(), std::move(*handle), fft_type);
+  return GpuFftHandle(context.ValueRef(), std::move(*handle), fft_type,
+                      std::move(plan_key));
 }
 
 static Expected<int64_t> FftGetWorkspaceSize(const GpuFftHandle& handle) {
@@ -31,8 +31,11 @@
 namespace tfrt {
 namespace gpu {
 
+// Reuses a solver handle that has been destroyed, if there is one.
 static llvm::Expected<GpuSolverHandle> SolverCreate(
     Argument<GpuContext> context) {
+  if (auto handle = context->TakeSolverHandle())
+    return GpuSolverHandle(context.ValueRef(), std::move(handle));
   auto current = wrapper::CtxSetCurrent(context->get());
   if (!current) return current.takeError();
   auto handle = wrapper::SolverCreate(current->platform());
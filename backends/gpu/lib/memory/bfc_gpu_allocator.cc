@@ -19,6 +19,7 @@
 #include "tfrt/gpu/memory/bfc_gpu_allocator.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 
 #include "llvm/Support/Errc.h"
@@ -68,11 +69,36 @@ BfcGpuAllocator::BfcGpuAllocator(const wrapper::CurrentContext& current)
 
   // Insert the chunk into the right bin.
   ReassignChunkToBin(c);
+
+  wrapper::Device device = die_if_error(wrapper::CtxGetDevice(current));
+  auto prefix = StrCat("/tfrt/gpu/bfc_allocator/device_",
+                       device.id(device.platform()), "/");
+  metrics_.bytes_in_use =
+      metrics::NewGauge<int64_t>(StrCat(prefix, "bytes_in_use"));
+  metrics_.peak_bytes_in_use =
+      metrics::NewGauge<int64_t>(StrCat(prefix, "peak_bytes_in_use"));
+  metrics_.bytes_reserved =
+      metrics::NewGauge<int64_t>(StrCat(prefix, "bytes_reserved"));
+  metrics_.largest_free_chunk =
+      metrics::NewGauge<int64_t>(StrCat(prefix, "largest_free_chunk"));
+  metrics_.allocation_latency_us = metrics::NewHistogram(
+      StrCat(prefix, "allocation_latency_us"),
+      metrics::Buckets::Explicit({1, 2, 5, 10, 20, 50, 100, 200, 500, 1000}));
+  for (const auto& bin : bins_) {
+    auto bin_prefix = StrCat(prefix, "bin_", bin.first, "/");
+    metrics_.bin_chunks.push_back(
+        metrics::NewGauge<int64_t>(StrCat(bin_prefix, "chunks")));
+    metrics_.bin_chunks_in_use.push_back(
+        metrics::NewGauge<int64_t>(StrCat(bin_prefix, "chunks_in_use")));
+  }
+  metrics_.bytes_reserved->Set(gpu_memory_size_);
+  metrics_.largest_free_chunk->Set(gpu_memory_size_);
 }
 
 llvm::Expected<gpu::GpuPointer> BfcGpuAllocator::Allocate(
     size_t num_bytes, wrapper::Stream stream) {
   TFRT_TRACE_SCOPE(Default, "BfcGpuAllocator::Allocate");
+  auto start_time = std::chrono::steady_clock::now();
   // First, always allocate memory of at least 256 bytes, and always
   // allocate multiples of 256 bytes so all memory addresses are
   // nicely byte aligned.
@@ -123,6 +149,16 @@ llvm::Expected<gpu::GpuPointer> BfcGpuAllocator::Allocate(
           SplitChunk(chunk, rounded_bytes);
         }
 
+        bytes_in_use_ += chunk->size;
+        peak_bytes_in_use_ = std::max(peak_bytes_in_use_, bytes_in_use_);
+        ++num_allocs_;
+        metrics_.bytes_in_use->Set(bytes_in_use_);
+        metrics_.peak_bytes_in_use->Set(peak_bytes_in_use_);
+        metrics_.allocation_latency_us->Record(
+            std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start_time)
+                .count());
+
         return wrapper::Pointer<void>(chunk->ptr, stream.platform());
       }
     }
@@ -130,10 +166,17 @@ llvm::Expected<gpu::GpuPointer> BfcGpuAllocator::Allocate(
 
   // We searched all bins for an existing free chunk to use and
   // couldn't find one.  This means we must have run out of memory,
+  // or that the free memory is fragmented.
+  Stats stats = GetStatsLocked();
+  ExportStats(stats);
   return llvm::createStringError(
       llvm::errc::not_enough_memory,
       tfrt::StrCat("Ran out of memory trying to allocate ",
-                   HumanReadableNumBytes(num_bytes)));
+                   HumanReadableNumBytes(num_bytes), ", ",
+                   HumanReadableNumBytes(stats.bytes_reserved -
+                                         stats.bytes_in_use),
+                   " free, largest free chunk is ",
+                   HumanReadableNumBytes(stats.largest_free_chunk)));
 }
 
 void BfcGpuAllocator::SplitChunk(BfcGpuAllocator::Chunk* c, size_t num_bytes) {
@@ -177,6 +220,8 @@ llvm::Error BfcGpuAllocator::Deallocate(gpu::GpuPointer pointer,
   BfcGpuAllocator::Chunk* c = it->second;
   // Mark the chunk as no longer in use
   c->in_use = false;
+  bytes_in_use_ -= c->size;
+  metrics_.bytes_in_use->Set(bytes_in_use_);
 
   // Consider coalescing it.
   MaybeCoalesce(c);
@@ -329,6 +374,51 @@ void BfcGpuAllocator::DumpMemoryLog(size_t num_bytes) {
   }
 }
 
+BfcGpuAllocator::Stats BfcGpuAllocator::GetStats() const {
+  Stats stats;
+  {
+    mutex_lock l(mu_);
+    stats = GetStatsLocked();
+  }
+  ExportStats(stats);
+  return stats;
+}
+
+BfcGpuAllocator::Stats BfcGpuAllocator::GetStatsLocked() const {
+  Stats stats;
+  stats.bytes_in_use = bytes_in_use_;
+  stats.peak_bytes_in_use = peak_bytes_in_use_;
+  stats.bytes_reserved = gpu_memory_size_;
+  stats.num_allocs = num_allocs_;
+  stats.bins.reserve(bins_.size());
+  for (const auto& bin : bins_) {
+    BinStats bin_stats;
+    bin_stats.bin_size = bin.first;
+    for (const Chunk* c : bin.second->chunks) {
+      ++bin_stats.num_chunks;
+      bin_stats.bytes_in_bin += c->size;
+      if (c->in_use) {
+        ++bin_stats.num_chunks_in_use;
+        bin_stats.bytes_in_use += c->size;
+      } else {
+        stats.largest_free_chunk = std::max(stats.largest_free_chunk, c->size);
+      }
+    }
+    stats.bins.push_back(bin_stats);
+  }
+  return stats;
+}
+
+void BfcGpuAllocator::ExportStats(const Stats& stats) const {
+  metrics_.bytes_in_use->Set(stats.bytes_in_use);
+  metrics_.peak_bytes_in_use->Set(stats.peak_bytes_in_use);
+  metrics_.largest_free_chunk->Set(stats.largest_free_chunk);
+  for (size_t i = 0; i < stats.bins.size(); ++i) {
+    metrics_.bin_chunks[i]->Set(stats.bins[i].num_chunks);
+    metrics_.bin_chunks_in_use[i]->Set(stats.bins[i].num_chunks_in_use);
+  }
+}
+
 std::string BfcGpuAllocator::Chunk::DebugString(bool with_neighbors) const {
   std::string dbg;
   StrAppend(&dbg, "  Size: ", HumanReadableNumBytes(size),
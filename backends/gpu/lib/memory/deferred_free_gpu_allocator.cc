@@ -0,0 +1,134 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file implements the deferred free GPU allocator.
+
+#include "tfrt/gpu/memory/deferred_free_gpu_allocator.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/logging.h"
+
+namespace tfrt {
+namespace gpu {
+
+DeferredFreeGpuAllocator::DeferredFreeGpuAllocator(
+    const wrapper::CurrentContext& current,
+    AsyncValueRef<GpuAllocator> allocator)
+    : context_(current.context()), allocator_(std::move(allocator)) {}
+
+DeferredFreeGpuAllocator::~DeferredFreeGpuAllocator() {
+  if (auto error = CollectPending(/*wait=*/true))
+    TFRT_LOG(ERROR) << "Failed to complete pending GPU deallocations: "
+                    << error;
+}
+
+llvm::Expected<GpuPointer> DeferredFreeGpuAllocator::Allocate(
+    size_t num_bytes, wrapper::Stream stream) {
+  if (auto error = CollectPending(/*wait=*/false)) return std::move(error);
+  auto pointer = GpuAllocator::Allocate(&allocator_.get(), num_bytes, stream);
+  if (pointer || num_pending() == 0) return pointer;
+
+  // The memory may be held by pending deallocations. Wait for them and try
+  // again.
+  llvm::consumeError(pointer.takeError());
+  if (auto error = CollectPending(/*wait=*/true)) return std::move(error);
+  return GpuAllocator::Allocate(&allocator_.get(), num_bytes, stream);
+}
+
+llvm::Error DeferredFreeGpuAllocator::Deallocate(GpuPointer pointer,
+                                                 wrapper::Stream stream) {
+  if (auto error = CollectPending(/*wait=*/false)) return error;
+  return GpuAllocator::Deallocate(&allocator_.get(), pointer, stream);
+}
+
+llvm::Error DeferredFreeGpuAllocator::DeallocateAfter(
+    GpuPointer pointer, ArrayRef<wrapper::Stream> streams) {
+  if (streams.size() <= 1) {
+    return Deallocate(pointer,
+                      streams.empty() ? wrapper::Stream() : streams.front());
+  }
+  if (auto error = CollectPending(/*wait=*/false)) return error;
+
+  PendingFree pending = {pointer, {}};
+  mutex_lock lock(mu_);
+  for (auto stream : streams) {
+    wrapper::OwningEvent event;
+    if (!free_events_.empty()) {
+      event = std::move(free_events_.back());
+      free_events_.pop_back();
+    } else {
+      TFRT_ASSIGN_OR_RETURN(auto current, wrapper::CtxSetCurrent(context_));
+      TFRT_ASSIGN_OR_RETURN(event, wrapper::EventCreateNoTiming(current));
+    }
+    if (auto error = wrapper::EventRecord(event.get(), stream)) return error;
+    pending.events.push_back(std::move(event));
+  }
+  pending_.push_back(std::move(pending));
+  return llvm::Error::success();
+}
+
+size_t DeferredFreeGpuAllocator::num_pending() const {
+  mutex_lock lock(mu_);
+  return pending_.size();
+}
+
+llvm::Error DeferredFreeGpuAllocator::CollectPending(bool wait) {
+  // Returns whether all events of `pending` have completed.
+  auto is_completed = [&](const PendingFree& pending) -> llvm::Expected<bool> {
+    for (const auto& event : pending.events) {
+      if (wait) {
+        if (auto error = wrapper::EventSynchronize(event.get()))
+          return std::move(error);
+        continue;
+      }
+      TFRT_ASSIGN_OR_RETURN(bool ready, wrapper::EventQuery(event.get()));
+      if (!ready) return false;
+    }
+    return true;
+  };
+
+  llvm::Error result = llvm::Error::success();
+  llvm::SmallVector<GpuPointer, 4> completed;
+  {
+    mutex_lock lock(mu_);
+    for (auto it = pending_.begin(); it != pending_.end();) {
+      auto is_ready = is_completed(*it);
+      if (!is_ready) {
+        result = is_ready.takeError();
+        break;
+      }
+      if (!*is_ready) {
+        ++it;
+        continue;
+      }
+      completed.push_back(it->pointer);
+      for (auto& event : it->events) free_events_.push_back(std::move(event));
+      it = pending_.erase(it);
+    }
+  }
+
+  // The memory is not used by any stream anymore.
+  for (auto pointer : completed) {
+    result = llvm::joinErrors(std::move(result),
+                              GpuAllocator::Deallocate(&allocator_.get(),
+                                                       pointer, /*stream=*/{}));
+  }
+  return result;
+}
+
+}  // namespace gpu
+}  // namespace tfrt
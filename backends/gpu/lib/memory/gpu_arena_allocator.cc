@@ -0,0 +1,98 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file implements the GPU arena allocator.
+
+#include "tfrt/gpu/memory/gpu_arena_allocator.h"
+
+#include "llvm/Support/MathExtras.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/logging.h"
+
+namespace tfrt {
+namespace gpu {
+
+llvm::Expected<AsyncValueRef<GpuArenaAllocator>> GpuArenaAllocator::Create(
+    wrapper::CurrentContext current, AsyncValueRef<GpuAllocator> allocator,
+    size_t block_size, wrapper::Stream stream) {
+  block_size = llvm::alignTo(block_size, kAlignment);
+  GpuPointer block;
+  wrapper::OwningEvent reserved;
+  if (block_size > 0) {
+    TFRT_ASSIGN_OR_RETURN(
+        block, GpuAllocator::Allocate(&allocator.get(), block_size, stream));
+    auto event = wrapper::EventCreateNoTiming(current);
+    if (!event) {
+      llvm::consumeError(
+          GpuAllocator::Deallocate(&allocator.get(), block, stream));
+      return event.takeError();
+    }
+    reserved = std::move(*event);
+    if (auto error = wrapper::EventRecord(reserved.get(), stream)) {
+      llvm::consumeError(
+          GpuAllocator::Deallocate(&allocator.get(), block, stream));
+      return std::move(error);
+    }
+  }
+  return MakeAvailableAsyncValueRef<GpuArenaAllocator>(
+      std::move(allocator), stream, block, block_size, std::move(reserved));
+}
+
+GpuArenaAllocator::GpuArenaAllocator(AsyncValueRef<GpuAllocator> allocator,
+                                     wrapper::Stream stream, GpuPointer block,
+                                     size_t block_size,
+                                     wrapper::OwningEvent reserved)
+    : allocator_(std::move(allocator)),
+      stream_(stream),
+      block_(block),
+      block_size_(block_size),
+      reserved_(std::move(reserved)) {}
+
+GpuArenaAllocator::~GpuArenaAllocator() {
+  if (!block_) return;
+  if (auto error = GpuAllocator::Deallocate(&allocator_.get(), block_, stream_))
+    TFRT_LOG(ERROR) << "Failed to release GPU arena: " << error;
+}
+
+llvm::Expected<GpuPointer> GpuArenaAllocator::Allocate(size_t num_bytes,
+                                                       wrapper::Stream stream) {
+  size_t size = llvm::alignTo(num_bytes, kAlignment);
+  size_t offset = offset_.fetch_add(size, std::memory_order_relaxed);
+  if (offset + size > block_size_)
+    return GpuAllocator::Allocate(&allocator_.get(), num_bytes, stream);
+
+  if (stream != nullptr && stream != stream_) {
+    if (auto error = wrapper::StreamWaitEvent(stream, reserved_.get()))
+      return std::move(error);
+  }
+  return GpuPointer(static_cast<char*>(block_.raw()) + offset,
+                    block_.platform());
+}
+
+llvm::Error GpuArenaAllocator::Deallocate(GpuPointer pointer,
+                                          wrapper::Stream stream) {
+  if (Contains(pointer)) return llvm::Error::success();
+  return GpuAllocator::Deallocate(&allocator_.get(), pointer, stream);
+}
+
+bool GpuArenaAllocator::Contains(GpuPointer pointer) const {
+  auto* begin = static_cast<char*>(block_.raw());
+  auto* ptr = static_cast<char*>(pointer.raw());
+  return begin != nullptr && begin <= ptr && ptr < begin + block_size_;
+}
+
+}  // namespace gpu
+}  // namespace tfrt
@@ -0,0 +1,98 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the pinned host memory pool.
+
+#include "tfrt/gpu/memory/pinned_host_memory_pool.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "llvm/Support/MathExtras.h"
+
+namespace tfrt {
+namespace gpu {
+
+// Smallest block handed out by the pool, to avoid caching lots of tiny blocks.
+static constexpr unsigned kMinBlockSizeLog2 = 12;
+
+PinnedHostMemoryPool::PinnedHostMemoryPool(size_t max_cached_bytes)
+    : max_cached_bytes_(max_cached_bytes) {}
+
+PinnedHostMemoryPool::~PinnedHostMemoryPool() {
+  // Every buffer holds a reference to the pool.
+  assert(live_blocks_.empty());
+}
+
+llvm::Expected<RCReference<HostBuffer>> PinnedHostMemoryPool::Allocate(
+    wrapper::CurrentContext current, size_t size) {
+  unsigned size_log2 =
+      std::max<unsigned>(llvm::Log2_64_Ceil(size), kMinBlockSizeLog2);
+
+  Block block;
+  {
+    mutex_lock lock(mu_);
+    auto it = free_blocks_.find(size_log2);
+    if (it != free_blocks_.end() && !it->second.empty()) {
+      block = std::move(it->second.back());
+      it->second.pop_back();
+      cached_bytes_ -= block.size;
+    }
+  }
+
+  if (!block.memory) {
+    size_t block_size = size_t{1} << size_log2;
+    auto memory = wrapper::MemHostAlloc(
+        current, block_size, wrapper::MemHostAllocFlags(0, current.platform()));
+    if (!memory) return memory.takeError();
+    block = Block{std::move(*memory), block_size};
+  }
+
+  void* ptr = block.memory.get().raw(current.platform());
+  {
+    mutex_lock lock(mu_);
+    live_blocks_[ptr] = std::move(block);
+  }
+
+  return HostBuffer::CreateFromExternal(
+      ptr, size, [pool = FormRef(this)](void* ptr, size_t) {
+        pool->Deallocate(ptr);
+      });
+}
+
+bool PinnedHostMemoryPool::IsPinned(const void* ptr) const {
+  mutex_lock lock(mu_);
+  return live_blocks_.count(ptr);
+}
+
+void PinnedHostMemoryPool::Deallocate(void* ptr) {
+  Block block;
+  {
+    mutex_lock lock(mu_);
+    auto it = live_blocks_.find(ptr);
+    assert(it != live_blocks_.end() && "pointer not allocated from the pool");
+    block = std::move(it->second);
+    live_blocks_.erase(it);
+
+    if (cached_bytes_ + block.size <= max_cached_bytes_) {
+      cached_bytes_ += block.size;
+      free_blocks_[llvm::Log2_64(block.size)].push_back(std::move(block));
+      return;
+    }
+  }
+  // Release the block to the driver outside of the lock.
+}
+
+}  // namespace gpu
+}  // namespace tfrt
@@ -0,0 +1,255 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the stream caching GPU allocator.
+
+#include "tfrt/gpu/memory/stream_caching_gpu_allocator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MathExtras.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/logging.h"
+#include "tfrt/tracing/tracing.h"
+
+namespace tfrt {
+namespace gpu {
+
+StreamCachingGpuAllocator::StreamCachingGpuAllocator(
+    const wrapper::CurrentContext& current)
+    : context_(current.context()) {
+  static_assert(GpuAllocator::kAlignment <= (size_t{1} << kMinSizeLog2),
+                "Smallest size class must be a multiple of the alignment");
+}
+
+StreamCachingGpuAllocator::~StreamCachingGpuAllocator() {
+  if (auto error = ReleaseCachedBlocks()) TFRT_LOG(ERROR) << error;
+}
+
+int StreamCachingGpuAllocator::GetSizeClass(size_t num_bytes) {
+  if (num_bytes > (size_t{1} << kMaxSizeLog2)) return kUncached;
+  int size_log2 = llvm::Log2_64_Ceil(num_bytes);
+  return std::max(size_log2, kMinSizeLog2) - kMinSizeLog2;
+}
+
+StreamCachingGpuAllocator::Shard& StreamCachingGpuAllocator::GetShard(
+    GpuPointer pointer) {
+  auto address = reinterpret_cast<uintptr_t>(pointer.raw());
+  return shards_[(address >> kMinSizeLog2) % kNumShards];
+}
+
+StreamCachingGpuAllocator::StreamCache*
+StreamCachingGpuAllocator::GetStreamCache(wrapper::Stream stream) {
+  if (stream == nullptr) return nullptr;
+  // Stream handles are aligned pointers, spread them with a multiplicative
+  // hash.
+  uint64_t hash = static_cast<uint64_t>(Hash(stream)) * 0x9E3779B97F4A7C15ull;
+  int begin = static_cast<int>(hash >> 32) % kMaxStreams;
+
+  // Fast path: find the cache without taking a lock.
+  for (int i = 0; i < kMaxStreams; ++i) {
+    auto& slot = stream_caches_[(begin + i) % kMaxStreams];
+    StreamCache* cache = slot.load(std::memory_order_acquire);
+    if (cache == nullptr) break;
+    if (cache->stream == stream) return cache;
+  }
+
+  mutex_lock lock(mu_);
+  for (int i = 0; i < kMaxStreams; ++i) {
+    auto& slot = stream_caches_[(begin + i) % kMaxStreams];
+    StreamCache* cache = slot.load(std::memory_order_relaxed);
+    if (cache == nullptr) {
+      owned_stream_caches_.push_back(std::make_unique<StreamCache>(stream));
+      cache = owned_stream_caches_.back().get();
+      slot.store(cache, std::memory_order_release);
+      return cache;
+    }
+    if (cache->stream == stream) return cache;
+  }
+  return nullptr;
+}
+
+llvm::Expected<gpu::GpuPointer> StreamCachingGpuAllocator::Allocate(
+    size_t num_bytes, wrapper::Stream stream) {
+  TFRT_TRACE_SCOPE(Default, "StreamCachingGpuAllocator::Allocate");
+  if (num_bytes == 0) {
+    return llvm::createStringError(llvm::errc::invalid_argument,
+                                   "Tried to allocate a size 0 buffer.");
+  }
+
+  int size_class = GetSizeClass(num_bytes);
+  if (size_class == kUncached) return AllocateAndTrack(num_bytes, kUncached);
+
+  // Reuse a block freed on the same stream, no synchronization needed.
+  if (StreamCache* cache = GetStreamCache(stream)) {
+    mutex_lock lock(cache->mu);
+    auto& free_list = cache->free_lists[size_class];
+    if (!free_list.empty()) {
+      GpuPointer pointer = free_list.back();
+      free_list.pop_back();
+      return pointer;
+    }
+  }
+
+  auto pointer = TakeOtherBlock(size_class, stream);
+  if (!pointer || *pointer != nullptr) return pointer;
+
+  size_t block_size = size_t{1} << (size_class + kMinSizeLog2);
+  pointer = AllocateAndTrack(block_size, size_class);
+  if (pointer) return pointer;
+
+  // Return all cached blocks to the driver and try again.
+  llvm::consumeError(pointer.takeError());
+  if (auto error = ReleaseCachedBlocks()) return std::move(error);
+  return AllocateAndTrack(block_size, size_class);
+}
+
+llvm::Error StreamCachingGpuAllocator::Deallocate(gpu::GpuPointer pointer,
+                                                  wrapper::Stream stream) {
+  int size_class;
+  {
+    Shard& shard = GetShard(pointer);
+    mutex_lock lock(shard.mu);
+    auto it = shard.size_classes.find(pointer.raw());
+    if (it == shard.size_classes.end()) {
+      return MakeStringError(
+          "StreamCachingGpuAllocator asked to deallocate unknown pointer");
+    }
+    size_class = it->second;
+    if (size_class == kUncached) shard.size_classes.erase(it);
+  }
+  if (size_class == kUncached) return wrapper::MemFree(pointer);
+
+  if (StreamCache* cache = GetStreamCache(stream)) {
+    mutex_lock lock(cache->mu);
+    cache->free_lists[size_class].push_back(pointer);
+    return llvm::Error::success();
+  }
+
+  // The table of stream caches is full. Make the block free on all streams.
+  if (stream != nullptr) {
+    if (auto error = wrapper::StreamSynchronize(stream)) return error;
+  }
+  mutex_lock lock(mu_);
+  shared_free_lists_[size_class].push_back(pointer);
+  return llvm::Error::success();
+}
+
+llvm::Expected<GpuPointer> StreamCachingGpuAllocator::TakeOtherBlock(
+    int size_class, wrapper::Stream stream) {
+  {
+    mutex_lock lock(mu_);
+    auto& free_list = shared_free_lists_[size_class];
+    if (!free_list.empty()) {
+      GpuPointer pointer = free_list.back();
+      free_list.pop_back();
+      return pointer;
+    }
+  }
+
+  auto pop_block = [&](StreamCache* cache) -> GpuPointer {
+    mutex_lock lock(cache->mu);
+    auto& free_list = cache->free_lists[size_class];
+    if (free_list.empty()) return GpuPointer();
+    GpuPointer pointer = free_list.back();
+    free_list.pop_back();
+    return pointer;
+  };
+
+  for (auto& slot : stream_caches_) {
+    StreamCache* cache = slot.load(std::memory_order_acquire);
+    if (cache == nullptr || cache->stream == stream) continue;
+    GpuPointer pointer = pop_block(cache);
+    if (pointer == nullptr) continue;
+    // The block is free once the work enqueued on the other stream so far has
+    // completed.
+    if (auto error = WaitForStream(stream, cache->stream)) {
+      mutex_lock lock(cache->mu);
+      cache->free_lists[size_class].push_back(pointer);
+      return std::move(error);
+    }
+    return pointer;
+  }
+  return GpuPointer();
+}
+
+llvm::Error StreamCachingGpuAllocator::WaitForStream(wrapper::Stream stream,
+                                                     wrapper::Stream other) {
+  auto current = wrapper::CtxSetCurrent(context_);
+  if (!current) return current.takeError();
+  auto event = wrapper::EventCreateNoTiming(*current);
+  if (!event) return event.takeError();
+  if (auto error = wrapper::EventRecord(event->get(), other)) return error;
+  if (stream == nullptr) return wrapper::EventSynchronize(event->get());
+  return wrapper::StreamWaitEvent(stream, event->get());
+}
+
+llvm::Error StreamCachingGpuAllocator::ReleaseCachedBlocks() {
+  std::vector<GpuPointer> pointers;
+  std::vector<wrapper::Stream> streams;
+  auto move_blocks = [&](FreeLists& free_lists) {
+    bool moved = false;
+    for (auto& free_list : free_lists) {
+      moved |= !free_list.empty();
+      std::move(free_list.begin(), free_list.end(),
+                std::back_inserter(pointers));
+      free_list.clear();
+    }
+    return moved;
+  };
+  {
+    mutex_lock lock(mu_);
+    move_blocks(shared_free_lists_);
+    for (const auto& cache : owned_stream_caches_) {
+      mutex_lock cache_lock(cache->mu);
+      if (move_blocks(cache->free_lists)) streams.push_back(cache->stream);
+    }
+  }
+
+  // Blocks may still be used by work enqueued before they were deallocated.
+  llvm::Error result = llvm::Error::success();
+  for (auto stream : streams) {
+    result = llvm::joinErrors(std::move(result),
+                              wrapper::StreamSynchronize(stream));
+  }
+  for (auto pointer : pointers) {
+    {
+      Shard& shard = GetShard(pointer);
+      mutex_lock lock(shard.mu);
+      shard.size_classes.erase(pointer.raw());
+    }
+    result = llvm::joinErrors(std::move(result), wrapper::MemFree(pointer));
+  }
+  return result;
+}
+
+llvm::Expected<GpuPointer> StreamCachingGpuAllocator::AllocateAndTrack(
+    size_t num_bytes, int size_class) {
+  auto current = wrapper::CtxSetCurrent(context_);
+  if (!current) return current.takeError();
+  auto memory = wrapper::MemAlloc(*current, num_bytes);
+  if (!memory) return memory.takeError();
+  GpuPointer pointer = memory->release();
+  Shard& shard = GetShard(pointer);
+  mutex_lock lock(shard.mu);
+  shard.size_classes[pointer.raw()] = size_class;
+  return pointer;
+}
+
+}  // namespace gpu
+}  // namespace tfrt
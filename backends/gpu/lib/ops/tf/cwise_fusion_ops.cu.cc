@@ -0,0 +1,323 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tensorflow coefficient wise operations fusion on GPU.
+//
+// tf._FusedCwise applies a chain of coefficient wise operations, listed in the
+// `fused_ops` attribute, to its first operand with a single kernel launch.
+// Binary operations take their right operand from the remaining operands in
+// order, which must have the shape of the first operand or a single element.
+// Each thread keeps its element in registers for the whole chain, so the
+// intermediate results never go through device memory.
+//
+// The `fused_ops` list is compiled into a FusedCwiseProgram the first time it
+// is seen, and the program is cached by the op sequence signature. The program
+// does not depend on the device, so one cache serves all contexts.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Error.h"
+#include "tfrt/common/compat/eigen/eigen_dtype.h"
+#include "tfrt/core_runtime/op_attrs.h"
+#include "tfrt/core_runtime/op_utils.h"
+#include "tfrt/gpu/core_runtime/gpu_dispatch_context.h"
+#include "tfrt/gpu/core_runtime/gpu_op_registry.h"
+#include "tfrt/gpu/core_runtime/gpu_op_utils.h"
+#include "tfrt/gpu/gpu_types.h"
+#include "tfrt/gpu/tensor/dense_gpu_tensor.h"
+#include "tfrt/gpu/wrapper/cudart_wrapper.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace gpu {
+namespace {
+
+// Maximum number of operations in a fused chain. The operations are passed to
+// the kernel by value, so this bounds the size of the kernel parameters.
+constexpr int kMaxFusedOps = 16;
+
+enum class FusedOpCode : int8_t {
+  kAdd,
+  kSub,
+  kMul,
+  kDiv,
+  kRelu,
+  kExp,
+  kLog,
+  kLog1p,
+  kRsqrt,
+  kSigmoid,
+  kSqrt,
+  kTanh,
+};
+
+// Operations that can be fused into tf._FusedCwise, named as in `fused_ops`.
+struct FusibleOp {
+  string_view name;
+  FusedOpCode code;
+  bool binary;
+};
+
+constexpr FusibleOp kFusibleOps[] = {
+    {"AddV2", FusedOpCode::kAdd, true},
+    {"Sub", FusedOpCode::kSub, true},
+    {"Mul", FusedOpCode::kMul, true},
+    {"RealDiv", FusedOpCode::kDiv, true},
+    {"Relu", FusedOpCode::kRelu, false},
+    {"Exp", FusedOpCode::kExp, false},
+    {"Log", FusedOpCode::kLog, false},
+    {"Log1p", FusedOpCode::kLog1p, false},
+    {"Rsqrt", FusedOpCode::kRsqrt, false},
+    {"Sigmoid", FusedOpCode::kSigmoid, false},
+    {"Sqrt", FusedOpCode::kSqrt, false},
+    {"Tanh", FusedOpCode::kTanh, false},
+};
+
+//===----------------------------------------------------------------------===//
+// Fused coefficient wise CUDA kernel.
+//===----------------------------------------------------------------------===//
+
+// Half precision chains are evaluated in single precision.
+template <typename T>
+using ComputeType =
+    std::conditional_t<std::is_same<T, Eigen::half>::value, float, T>;
+
+// A chain of fused operations bound to their operands.
+template <typename T>
+struct FusedCwiseSteps {
+  FusedOpCode codes[kMaxFusedOps];
+  const T* operands[kMaxFusedOps];  // Null for unary operations.
+  bool scalar_operands[kMaxFusedOps];
+  int num_steps;
+};
+
+template <typename C>
+__device__ C ApplyFusedOp(FusedOpCode code, C x, C y) {
+  switch (code) {
+    case FusedOpCode::kAdd:
+      return x + y;
+    case FusedOpCode::kSub:
+      return x - y;
+    case FusedOpCode::kMul:
+      return x * y;
+    case FusedOpCode::kDiv:
+      return x / y;
+    case FusedOpCode::kRelu:
+      return x > C(0) ? x : C(0);
+    case FusedOpCode::kExp:
+      return exp(x);
+    case FusedOpCode::kLog:
+      return log(x);
+    case FusedOpCode::kLog1p:
+      return log1p(x);
+    case FusedOpCode::kRsqrt:
+      return rsqrt(x);
+    case FusedOpCode::kSigmoid:
+      return C(1) / (C(1) + exp(-x));
+    case FusedOpCode::kSqrt:
+      return sqrt(x);
+    case FusedOpCode::kTanh:
+      return tanh(x);
+  }
+  return x;
+}
+
+// All threads of the grid run the same chain, so switching on the operation
+// does not diverge.
+template <typename T>
+__global__ void FusedCwiseKernel(const T* input, T* output, int num_elements,
+                                 FusedCwiseSteps<T> steps) {
+  using C = ComputeType<T>;
+  for (int i = threadIdx.x + blockIdx.x * blockDim.x; i < num_elements;
+       i += blockDim.x * gridDim.x) {
+    C x = static_cast<C>(input[i]);
+    for (int s = 0; s < steps.num_steps; ++s) {
+      C y = C(0);
+      if (const T* operand = steps.operands[s])
+        y = static_cast<C>(operand[steps.scalar_operands[s] ? 0 : i]);
+      x = ApplyFusedOp(steps.codes[s], x, y);
+    }
+    output[i] = static_cast<T>(x);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Host code for compiling and launching fused chains.
+//===----------------------------------------------------------------------===//
+
+// A chain of fused operations resolved from its `fused_ops` attribute.
+struct FusedCwiseProgram {
+  llvm::SmallVector<const FusibleOp*, 4> ops;
+  size_t num_operands = 0;
+};
+
+// Compiled fused operation chains, keyed by the op sequence signature (the
+// names of the fused operations joined with ','). Only valid programs are
+// cached.
+class FusedCwiseProgramCache {
+ public:
+  static FusedCwiseProgramCache& Get() {
+    static auto* cache = new FusedCwiseProgramCache;
+    return *cache;
+  }
+
+  Expected<const FusedCwiseProgram*> GetOrCompile(
+      AggregateAttr fused_ops_attr) {
+    std::string signature;
+    for (int i = 0; i < fused_ops_attr.GetNumElements(); ++i) {
+      if (i > 0) signature += ',';
+      signature +=
+          fused_ops_attr.GetAttribute(i).cast<StringAttr>().GetValue().str();
+    }
+
+    mutex_lock lock(mu_);
+    auto it = programs_.find(signature);
+    if (it != programs_.end()) return it->second.get();
+
+    auto program = Compile(fused_ops_attr);
+    if (!program) return program.takeError();
+    auto& cached = programs_[signature];
+    cached = std::make_unique<FusedCwiseProgram>(std::move(*program));
+    return cached.get();
+  }
+
+ private:
+  static Expected<FusedCwiseProgram> Compile(AggregateAttr fused_ops_attr) {
+    FusedCwiseProgram program;
+    for (int i = 0; i < fused_ops_attr.GetNumElements(); ++i) {
+      string_view name =
+          fused_ops_attr.GetAttribute(i).cast<StringAttr>().GetValue();
+      auto op = llvm::find_if(kFusibleOps, [&](const FusibleOp& fusible) {
+        return fusible.name == name;
+      });
+      if (op == std::end(kFusibleOps))
+        return MakeStringError("Unsupported fused operation: ", name);
+      program.ops.push_back(op);
+      if (op->binary) ++program.num_operands;
+    }
+    if (program.ops.empty())
+      return MakeStringError("FusedCwise must specify fused operations");
+    if (program.ops.size() > kMaxFusedOps)
+      return MakeStringError("FusedCwise supports at most ", kMaxFusedOps,
+                             " fused operations");
+    return std::move(program);
+  }
+
+  mutex mu_;
+  llvm::StringMap<std::unique_ptr<FusedCwiseProgram>> programs_
+      TFRT_GUARDED_BY(mu_);
+};
+
+template <typename T>
+static llvm::Error FusedCwise(GpuDispatchContext* dctx,
+                              const FusedCwiseProgram& program,
+                              const DenseGpuTensor& input,
+                              RepeatedArguments<DenseGpuTensor> fusion_inputs,
+                              const GpuBuffer& output) {
+  // Bind the fused operations to their operands.
+  FusedCwiseSteps<T> steps = {};
+  size_t num_operands = 0;
+  for (const FusibleOp* op : program.ops) {
+    int s = steps.num_steps++;
+    steps.codes[s] = op->code;
+    if (!op->binary) continue;
+    const DenseGpuTensor& operand = fusion_inputs[num_operands++];
+    if (operand.dtype() != input.dtype())
+      return MakeStringError("Operand of ", op->name,
+                             " has incompatible dtype ", operand.dtype());
+    if (operand.NumElements() != 1 && operand.shape() != input.shape())
+      return MakeStringError("Operand of ", op->name,
+                             " has incompatible shape ", operand.shape());
+    steps.operands[s] = GetRawPointer<const T>(operand);
+    steps.scalar_operands[s] = operand.NumElements() == 1;
+  }
+
+  int num_elements = input.NumElements();
+  if (num_elements == 0) return llvm::Error::success();
+
+  const int threads_per_block = 256;
+  const int kMaxBlocks = 4096;
+  int num_blocks = std::min(
+      kMaxBlocks, (num_elements + threads_per_block - 1) / threads_per_block);
+  return wrapper::CudaLaunchKernel(
+      dctx->current_context(), &FusedCwiseKernel<T>, num_blocks,
+      threads_per_block, 0, dctx->stream(), GetRawPointer<const T>(input),
+      GetRawPointer<T>(output), num_elements, steps);
+}
+
+static llvm::Expected<DenseGpuTensor> ComputeFusedCwiseGpuOp(
+    GpuDispatchContext* dctx, const DenseGpuTensor& input,
+    RepeatedArguments<DenseGpuTensor> fusion_inputs, const OpAttrsRef& attrs,
+    const TensorMetadata& result_md) {
+  auto fused_ops_attr = attrs.GetAsserting<AggregateAttr>("fused_ops");
+  TFRT_ASSIGN_OR_RETURN(
+      const FusedCwiseProgram* program,
+      FusedCwiseProgramCache::Get().GetOrCompile(fused_ops_attr));
+  if (program->num_operands > fusion_inputs.size())
+    return MakeStringError("FusedCwise is missing operands");
+  if (program->num_operands < fusion_inputs.size())
+    return MakeStringError("FusedCwise has unused operands");
+
+  size_t size_in_bytes =
+      GetHostSize(result_md.dtype) * result_md.shape.GetNumElements();
+  TFRT_ASSIGN_OR_RETURN(
+      GpuBuffer output_buffer,
+      GpuBuffer::Allocate(dctx->allocator(),
+                          /*size=*/size_in_bytes, dctx->stream()));
+
+  auto fused_cwise = [&](auto zero) {
+    return FusedCwise<decltype(zero)>(dctx, *program, input, fusion_inputs,
+                                      output_buffer);
+  };
+
+  llvm::Error error = llvm::Error::success();
+  switch (input.dtype()) {
+    default:
+      return MakeStringError("Unsupported input dtype: ", input.dtype());
+    case DType::F16:
+      error = fused_cwise(Eigen::half{0});
+      break;
+    case DType::F32:
+      error = fused_cwise(float{0});
+      break;
+    case DType::F64:
+      error = fused_cwise(double{0});
+      break;
+  }
+  if (error) return std::move(error);
+
+  return DenseGpuTensor(
+      result_md.shape, result_md.dtype,
+      MakeAvailableAsyncValueRef<GpuBuffer>(std::move(output_buffer)));
+}
+
+}  // namespace
+
+void RegisterCwiseFusionGpuTfOps(GpuOpRegistry* registry) {
+  registry->AddOp("tf._FusedCwise", TFRT_GPU_OP(ComputeFusedCwiseGpuOp),
+                  {"fused_ops"});
+}
+
+}  // namespace gpu
+}  // namespace tfrt
@@ -15,7 +15,7 @@
 // Collates list of all TF DNN operations.
 
 #include <numeric>
-#include <unordered_map>
+#include <string>
 
 #include "dnn_ops_cu.h"
 #include "llvm/ADT/ArrayRef.h"
@@ -24,10 +24,12 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/raw_ostream.h"
 #include "matmul_op.h"
+#include "mixed_precision.h"
 #include "pad_op_noncuda.h"
 #include "tfrt/common/ops/tf/dnn_ops_util.h"
 #include "tfrt/core_runtime/op_attrs.h"
 #include "tfrt/dtype/dtype.h"
+#include "tfrt/gpu/autotune/autotune_cache.h"
 #include "tfrt/gpu/core_runtime/gpu_dispatch_context.h"
 #include "tfrt/gpu/core_runtime/gpu_op_registry.h"
 #include "tfrt/gpu/core_runtime/gpu_op_utils.h"
@@ -210,49 +212,72 @@ DefaultCudnnCovolutionForwardAlgorithm() {
   return default_algo;
 }
 
-using ConvolutionAlgorithmKey =
-    std::tuple<TensorDescriptorData, TensorDescriptorData,
-               TensorDescriptorData>;
-
-struct ConvolutionAlgorithmHash {
-  size_t operator()(const ConvolutionAlgorithmKey& key) const {
-    auto result = Hash(std::get<0>(key));
-    Combine(result, Hash(std::get<1>(key)));
-    Combine(result, Hash(std::get<2>(key)));
-    return result;
-  }
+// Returns the autotuning key of a forward convolution. Besides the shapes,
+// the padding, strides and dilations determine which algorithms apply.
+static std::string GetConvolutionForwardProblem(
+    const TensorDescriptorData& input, const TensorDescriptorData& filter,
+    const TensorDescriptorData& output, llvm::ArrayRef<Index> paddings,
+    llvm::ArrayRef<Index> strides, llvm::ArrayRef<Index> dilations) {
+  return StrCat("conv_fwd(", input, ", ", filter, ", ", output,
+                ", paddings=[", Join(paddings, ", "), "], strides=[",
+                Join(strides, ", "), "], dilations=[", Join(dilations, ", "),
+                "])");
+}
 
- private:
-  static size_t Hash(const TensorDescriptorData& data) {
-    std::hash<int> hash;
-    size_t result = hash(data.dtype);
-    for (const auto& dim : data.dimensions) Combine(result, hash(dim));
-    for (const auto& stride : data.strides) Combine(result, hash(stride));
-    return result;
+// Benchmarks the forward convolution algorithms and returns the fastest one
+// that succeeds with the workspace that could be allocated.
+static llvm::Expected<AutotuneResult> AutotuneConvolutionForward(
+    GpuDispatchContext* dctx, cudnnTensorDescriptor_t input_desc,
+    wrapper::Pointer<const void> input_ptr, cudnnFilterDescriptor_t filter_desc,
+    wrapper::Pointer<const void> filter_ptr,
+    cudnnConvolutionDescriptor_t conv_desc, cudnnTensorDescriptor_t output_desc,
+    wrapper::Pointer<void> output_ptr) {
+  GpuBuffer workspace_buffer;
+  for (size_t mega_bytes : {1024, 128, 16}) {
+    auto workspace_buffer_or_error = GpuBuffer::Allocate(
+        dctx->allocator(), mega_bytes * 1024 * 1024, dctx->stream());
+    if (workspace_buffer_or_error) {
+      workspace_buffer = std::move(*workspace_buffer_or_error);
+      break;
+    }
+    llvm::consumeError(workspace_buffer_or_error.takeError());
   }
 
-  static void Combine(size_t& seed, size_t value) {
-    // boost::hash_combine.
-    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  TFRT_ASSIGN_OR_RETURN(
+      auto algo_perfs,
+      wrapper::CudnnFindConvolutionForwardAlgorithm(
+          dctx->current_context(), dctx->dnn_handle(), input_desc, input_ptr,
+          filter_desc, filter_ptr, conv_desc, output_desc, output_ptr,
+          CUDNN_CONVOLUTION_FWD_ALGO_COUNT, workspace_buffer.pointer(),
+          workspace_buffer.size()));
+  // Results are sorted by execution time.
+  for (const auto& algo_perf : algo_perfs) {
+    if (algo_perf.status != CUDNN_STATUS_SUCCESS) continue;
+    return AutotuneResult{algo_perf.algo, algo_perf.memory, algo_perf.mathType};
   }
-};
-
-// T should be cudnnConvolution{Fwd,BwdData,BwdFilter}Algo_t.
-template <typename T>
-using ConvolutionAlgorithmMap = std::unordered_map<
-    ConvolutionAlgorithmKey,
-    std::tuple<T /*algo*/, size_t /*workspace_size_bytes*/, cudnnMathType_t>,
-    ConvolutionAlgorithmHash>;
-
-auto& GetConvolutionForwardAlgorithmMap() {
-  static auto* map = new ConvolutionAlgorithmMap<cudnnConvolutionFwdAlgo_t>();
-  return *map;
+  return MakeStringError("No convolution forward algorithm succeeded");
 }
 
 static llvm::Expected<DenseGpuTensor> ComputeConvGpuOp(
     GpuDispatchContext* dctx, const DenseGpuTensor& input,
     const DenseGpuTensor& filter, const OpAttrsRef& attrs,
     const TensorMetadata& result_md) {
+  // In mixed precision, run the F16 convolution (cuDNN accumulates in F32) on
+  // cast operands and cast the result back. The cuDNN descriptors used here
+  // don't support BF16, so BF16 convolutions run in F32.
+  if (dctx->mixed_precision_dtype() == DType::F16 &&
+      input.dtype() == DType::F32 && filter.dtype() == DType::F32) {
+    TFRT_ASSIGN_OR_RETURN(auto cast_input,
+                          CastGpuTensor(dctx, input, DType::F16));
+    TFRT_ASSIGN_OR_RETURN(auto cast_filter,
+                          CastGpuWeight(dctx, filter, DType::F16));
+    TFRT_ASSIGN_OR_RETURN(
+        auto cast_output,
+        ComputeConvGpuOp(dctx, cast_input, cast_filter, attrs,
+                         TensorMetadata(DType::F16, result_md.shape)));
+    return CastGpuTensor(dctx, cast_output, DType::F32);
+  }
+
   TFRT_ASSIGN_OR_RETURN(auto temp_buffer,
                         AllocateBuffer(dctx, filter.dtype(), filter.shape()));
 
@@ -414,7 +439,6 @@ static llvm::Expected<DenseGpuTensor> ComputeConvGpuOp(
 
   cudnnConvolutionFwdAlgo_t algo;
   size_t workspace_size_bytes = 0;
-  GpuBuffer workspace_buffer;
 
   // TODO(tfrt-devs): Instead of reading default algorithms from an
   // environment variable, we need to pass these options explicitly through op
@@ -427,50 +451,41 @@ static llvm::Expected<DenseGpuTensor> ComputeConvGpuOp(
             dctx->dnn_handle(), input_desc.get(), filter_desc.get(),
             conv_desc.get(), output_desc.get(), algo));
   } else {
-    auto& map = GetConvolutionForwardAlgorithmMap();
-    auto key = std::make_tuple(input_data, filter_data, output_data);
-    auto it = map.find(key);
-    if (it == map.end()) {
-      for (size_t mega_bytes : {1024, 128, 16, 0}) {
-        workspace_size_bytes = mega_bytes * 1024 * 1024;
-        if (workspace_size_bytes == 0) break;
-        if (auto workspace_buffer_or_error = GpuBuffer::Allocate(
-                dctx->allocator(), workspace_size_bytes, dctx->stream())) {
-          workspace_buffer = std::move(*workspace_buffer_or_error);
-          break;
-        }
-      }
+    // Benchmark the algorithms the first time a problem is seen on a device
+    // model, and reuse the winner afterwards, also across processes.
+    auto& cache = AutotuneCache::Global();
+    TFRT_ASSIGN_OR_RETURN(auto device,
+                          GetAutotuneDeviceKey(dctx->current_context()));
+    auto problem = GetConvolutionForwardProblem(
+        input_data, filter_data, output_data, paddings,
+        windowed_output_data.strides, windowed_output_data.dilations);
+    auto result = cache.Lookup(device, problem);
+    if (!result) {
       TFRT_ASSIGN_OR_RETURN(
-          auto algo_perfs,
-          wrapper::CudnnFindConvolutionForwardAlgorithm(
-              dctx->current_context(), dctx->dnn_handle(), input_desc.get(),
-              input_ptr, filter_desc.get(), temp_buffer.pointer(),
-              conv_desc.get(), output_desc.get(), output_buffer.pointer(), 1,
-              workspace_buffer.pointer(), workspace_size_bytes));
-      const auto& algo_perf = algo_perfs.front();
-      it = map.emplace_hint(it, key,
-                            std::make_tuple(algo_perf.algo, algo_perf.memory,
-                                            algo_perf.mathType));
+          auto tuned,
+          AutotuneConvolutionForward(
+              dctx, input_desc.get(), input_ptr, filter_desc.get(),
+              temp_buffer.pointer(), conv_desc.get(), output_desc.get(),
+              output_buffer.pointer()));
+      result = cache.Insert(device, problem, tuned);
     }
-    algo = std::get<cudnnConvolutionFwdAlgo_t>(it->second);
-    workspace_size_bytes = std::get<size_t>(it->second);
+    algo = static_cast<cudnnConvolutionFwdAlgo_t>(result->algorithm);
+    workspace_size_bytes = result->workspace_bytes;
     if (auto error = wrapper::CudnnSetConvolutionMathType(
-            conv_desc.get(), std::get<cudnnMathType_t>(it->second)))
+            conv_desc.get(), static_cast<cudnnMathType_t>(result->math_type)))
       return std::move(error);
   }
 
+  GpuBuffer workspace_buffer;
   TFRT_ASSIGN_OR_RETURN(
       auto workspace_ptr, [&]() -> llvm::Expected<wrapper::Pointer<void>> {
         if (workspace_size_bytes == 0) {
           return wrapper::Pointer<void>(nullptr, platform);
         }
-        if (!workspace_buffer ||
-            workspace_buffer.size() < workspace_size_bytes) {
-          TFRT_ASSIGN_OR_RETURN(
-              workspace_buffer,
-              GpuBuffer::Allocate(dctx->allocator(), workspace_size_bytes,
-                                  dctx->stream()));
-        }
+        TFRT_ASSIGN_OR_RETURN(
+            workspace_buffer,
+            GpuBuffer::Allocate(dctx->allocator(), workspace_size_bytes,
+                                dctx->stream()));
         return workspace_buffer.pointer();
       }());
 
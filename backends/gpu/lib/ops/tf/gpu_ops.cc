@@ -33,6 +33,7 @@ namespace tfrt {
 namespace gpu {
 
 void RegisterBinaryGpuTfOps(GpuOpRegistry* registry);
+void RegisterCwiseFusionGpuTfOps(GpuOpRegistry* registry);
 void RegisterDnnGpuTfOps(GpuOpRegistry* registry);
 void RegisterMatmulGpuTfOps(GpuOpRegistry* registry);
 void RegisterMlirGpuTfOps(GpuOpRegistry* registry);
@@ -52,6 +53,7 @@ void RegisterTfGpuOps(GpuOpRegistry* registry) {
   RegisterNullaryGpuTfOps(registry);
 #ifdef TFRT_GPU_CUDA_ENABLED
   RegisterBinaryGpuTfOps(registry);
+  RegisterCwiseFusionGpuTfOps(registry);
   RegisterDnnGpuTfOps(registry);
   RegisterPadGpuTfOps(registry);
   RegisterReductionGpuTfOps(registry);
@@ -17,16 +17,25 @@
 
 #include <immintrin.h>
 
+#include <array>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "mixed_precision.h"
+
 #include "tfrt/core_runtime/op_attr_type.h"
 #include "tfrt/core_runtime/op_attrs.h"
 #include "tfrt/core_runtime/op_utils.h"
 #include "tfrt/dtype/dtype.h"
+#include "tfrt/gpu/autotune/autotune_cache.h"
 #include "tfrt/gpu/core_runtime/gpu_dispatch_context.h"
 #include "tfrt/gpu/core_runtime/gpu_op_registry.h"
 #include "tfrt/gpu/core_runtime/gpu_op_utils.h"
 #include "tfrt/gpu/gpu_types.h"
 #include "tfrt/gpu/tensor/dense_gpu_tensor.h"
 #include "tfrt/gpu/wrapper/cublas_wrapper.h"
+#include "tfrt/gpu/wrapper/cuda_wrapper.h"
 #include "tfrt/host_context/host_context.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/fp16.h"
@@ -75,7 +84,9 @@ static llvm::Error CallCublasGemm(wrapper::CurrentContext current,
                                   const gpu::DenseGpuTensor& b,
                                   const GpuBuffer& result,
                                   cudaDataType data_type,
-                                  cublasComputeType_t compute_type) {
+                                  cudaDataType result_data_type,
+                                  cublasComputeType_t compute_type,
+                                  cublasGemmAlgo_t algo) {
   TFRT_TRACE_SCOPE(Default, "CublasGemm");
   // Blas expects matrices in column major.
   // Use C' = B' x A' (' stands for transpose)
@@ -86,7 +97,107 @@ static llvm::Error CallCublasGemm(wrapper::CurrentContext current,
       ConstValue<T>(1.0).pointer(handle.platform()), b.buffer().pointer(),
       data_type, transpose_b ? k : n, a.buffer().pointer(), data_type,
       transpose_a ? m : k, ConstValue<T>(0.0).pointer(handle.platform()),
-      result.pointer(), data_type, n, compute_type, CUBLAS_GEMM_DEFAULT);
+      result.pointer(), result_data_type, n, compute_type, algo);
+}
+
+// Returns the candidate algorithms for cublasGemmEx.
+static std::vector<cublasGemmAlgo_t> GetCublasGemmAlgorithms() {
+  std::vector<cublasGemmAlgo_t> algos = {CUBLAS_GEMM_DEFAULT,
+                                         CUBLAS_GEMM_DEFAULT_TENSOR_OP};
+  for (int algo = CUBLAS_GEMM_ALGO0; algo <= CUBLAS_GEMM_ALGO23; ++algo)
+    algos.push_back(static_cast<cublasGemmAlgo_t>(algo));
+  for (int algo = CUBLAS_GEMM_ALGO0_TENSOR_OP;
+       algo <= CUBLAS_GEMM_ALGO15_TENSOR_OP; ++algo)
+    algos.push_back(static_cast<cublasGemmAlgo_t>(algo));
+  return algos;
+}
+
+// Times every candidate algorithm of `run_gemm` on the stream of `handle` and
+// returns the fastest one. Algorithms which are not supported for the problem
+// are skipped.
+template <typename RunGemm>
+static llvm::Expected<cublasGemmAlgo_t> AutotuneCublasGemm(
+    wrapper::CurrentContext current, wrapper::BlasHandle handle,
+    RunGemm run_gemm) {
+  TFRT_TRACE_SCOPE(Default, "AutotuneCublasGemm");
+  TFRT_ASSIGN_OR_RETURN(auto stream, wrapper::BlasGetStream(handle));
+  wrapper::EventFlags flags(CU_EVENT_DEFAULT, current.platform());
+  TFRT_ASSIGN_OR_RETURN(auto start, wrapper::EventCreate(current, flags));
+  TFRT_ASSIGN_OR_RETURN(auto stop, wrapper::EventCreate(current, flags));
+
+  // Warm up, so that the first candidate does not pay for initialization.
+  if (auto error = run_gemm(CUBLAS_GEMM_DEFAULT)) return std::move(error);
+
+  cublasGemmAlgo_t best_algo = CUBLAS_GEMM_DEFAULT;
+  float best_time_ms = std::numeric_limits<float>::max();
+  for (auto algo : GetCublasGemmAlgorithms()) {
+    if (auto error = wrapper::EventRecord(start.get(), stream))
+      return std::move(error);
+    if (auto error = run_gemm(algo)) {
+      llvm::consumeError(std::move(error));
+      continue;
+    }
+    if (auto error = wrapper::EventRecord(stop.get(), stream))
+      return std::move(error);
+    if (auto error = wrapper::EventSynchronize(stop.get()))
+      return std::move(error);
+    TFRT_ASSIGN_OR_RETURN(float time_ms,
+                          wrapper::EventElapsedTime(start.get(), stop.get()));
+    if (time_ms < best_time_ms) {
+      best_time_ms = time_ms;
+      best_algo = algo;
+    }
+  }
+  return best_algo;
+}
+
+// Runs gemm with the algorithm that is fastest for the problem on the current
+// device, benchmarking the candidates the first time the problem is seen.
+// The result is of `result_dtype`, which is only different from the dtype of
+// `a` and `b` in mixed precision.
+template <typename T>
+static llvm::Error RunAutotunedCublasGemm(
+    wrapper::CurrentContext current, wrapper::BlasHandle handle,
+    bool transpose_a, bool transpose_b, uint64_t m, uint64_t k, uint64_t n,
+    const gpu::DenseGpuTensor& a, const gpu::DenseGpuTensor& b,
+    const GpuBuffer& result, DType result_dtype, cudaDataType data_type,
+    cudaDataType result_data_type, cublasComputeType_t compute_type) {
+  auto run_gemm = [&](cublasGemmAlgo_t algo) {
+    return CallCublasGemm<T>(current, handle, transpose_a, transpose_b, m, k,
+                             n, a, b, result, data_type, result_data_type,
+                             compute_type, algo);
+  };
+
+  auto& cache = AutotuneCache::Global();
+  TFRT_ASSIGN_OR_RETURN(auto device, GetAutotuneDeviceKey(current));
+  std::string dtype = StrCat(a.dtype());
+  if (result_dtype != a.dtype()) dtype = StrCat(dtype, "->", result_dtype);
+  auto problem = StrCat("gemm(", dtype, ", transpose_a=", transpose_a,
+                        ", transpose_b=", transpose_b, ", m=", m, ", k=", k,
+                        ", n=", n, ")");
+  auto cached = cache.Lookup(device, problem);
+  if (!cached) {
+    TFRT_ASSIGN_OR_RETURN(auto algo,
+                          AutotuneCublasGemm(current, handle, run_gemm));
+    AutotuneResult tuned;
+    tuned.algorithm = algo;
+    cached = cache.Insert(device, problem, tuned);
+  }
+  return run_gemm(static_cast<cublasGemmAlgo_t>(cached->algorithm));
+}
+
+// Returns the m, k and n dimensions of the gemm of `a` and `b`.
+static std::array<uint64_t, 3> GetGemmDimensions(bool transpose_a,
+                                                 bool transpose_b,
+                                                 const gpu::DenseGpuTensor& a,
+                                                 const gpu::DenseGpuTensor& b) {
+  const int a_matching_dim = transpose_a ? 0 : 1;
+  const int b_matching_dim = transpose_b ? 1 : 0;
+  const int a_remaining_dim = 1 - a_matching_dim;
+  const int b_remaining_dim = 1 - b_matching_dim;
+  return {static_cast<uint64_t>(a.shape().GetDimensionSize(a_remaining_dim)),
+          static_cast<uint64_t>(a.shape().GetDimensionSize(a_matching_dim)),
+          static_cast<uint64_t>(b.shape().GetDimensionSize(b_remaining_dim))};
 }
 
 llvm::Error RunCublasGemm(wrapper::CurrentContext current,
@@ -94,26 +205,20 @@ llvm::Error RunCublasGemm(wrapper::CurrentContext current,
                           bool transpose_b, const gpu::DenseGpuTensor& a,
                           const gpu::DenseGpuTensor& b,
                           const GpuBuffer& result) {
-  const int a_matching_dim = transpose_a ? 0 : 1;
-  const int b_matching_dim = transpose_b ? 1 : 0;
-  const int a_remaining_dim = 1 - a_matching_dim;
-  const int b_remaining_dim = 1 - b_matching_dim;
-  const uint64_t m = a.shape().GetDimensionSize(a_remaining_dim);
-  const uint64_t k = a.shape().GetDimensionSize(a_matching_dim);
-  const uint64_t n = b.shape().GetDimensionSize(b_remaining_dim);
+  auto [m, k, n] = GetGemmDimensions(transpose_a, transpose_b, a, b);
   switch (a.dtype()) {
     case DType::F16:
-      return CallCublasGemm<__half>(current, handle, transpose_a, transpose_b,
-                                    m, k, n, a, b, result, CUDA_R_16F,
-                                    CUBLAS_COMPUTE_16F);
+      return RunAutotunedCublasGemm<__half>(
+          current, handle, transpose_a, transpose_b, m, k, n, a, b, result,
+          DType::F16, CUDA_R_16F, CUDA_R_16F, CUBLAS_COMPUTE_16F);
     case DType::F32:
-      return CallCublasGemm<float>(current, handle, transpose_a, transpose_b, m,
-                                   k, n, a, b, result, CUDA_R_32F,
-                                   CUBLAS_COMPUTE_32F);
+      return RunAutotunedCublasGemm<float>(
+          current, handle, transpose_a, transpose_b, m, k, n, a, b, result,
+          DType::F32, CUDA_R_32F, CUDA_R_32F, CUBLAS_COMPUTE_32F);
     case DType::F64:
-      return CallCublasGemm<double>(current, handle, transpose_a, transpose_b,
-                                    m, k, n, a, b, result, CUDA_R_64F,
-                                    CUBLAS_COMPUTE_64F);
+      return RunAutotunedCublasGemm<double>(
+          current, handle, transpose_a, transpose_b, m, k, n, a, b, result,
+          DType::F64, CUDA_R_64F, CUDA_R_64F, CUBLAS_COMPUTE_64F);
     // TODO(iga): Handle complex numbers.
     default:
       return llvm::createStringError(
@@ -122,6 +227,28 @@ llvm::Error RunCublasGemm(wrapper::CurrentContext current,
   }
 }
 
+llvm::Error RunMixedPrecisionCublasGemm(wrapper::CurrentContext current,
+                                        wrapper::BlasHandle handle,
+                                        bool transpose_a, bool transpose_b,
+                                        const gpu::DenseGpuTensor& a,
+                                        const gpu::DenseGpuTensor& b,
+                                        const GpuBuffer& result) {
+  auto [m, k, n] = GetGemmDimensions(transpose_a, transpose_b, a, b);
+  switch (a.dtype()) {
+    case DType::F16:
+      return RunAutotunedCublasGemm<float>(
+          current, handle, transpose_a, transpose_b, m, k, n, a, b, result,
+          DType::F32, CUDA_R_16F, CUDA_R_32F, CUBLAS_COMPUTE_32F);
+    case DType::BF16:
+      return RunAutotunedCublasGemm<float>(
+          current, handle, transpose_a, transpose_b, m, k, n, a, b, result,
+          DType::F32, CUDA_R_16BF, CUDA_R_32F, CUBLAS_COMPUTE_32F);
+    default:
+      return MakeStringError("Type ", a.dtype(),
+                             " is not supported by mixed precision gemm");
+  }
+}
+
 static llvm::Expected<DenseGpuTensor> GpuMatmulOp(
     GpuDispatchContext* dctx, const gpu::DenseGpuTensor& a,
     const gpu::DenseGpuTensor& b, const OpAttrsRef& attrs,
@@ -159,6 +286,25 @@ static llvm::Expected<DenseGpuTensor> GpuMatmulOp(
   // metadata function checks for attribute presence
   bool transpose_a = attrs.GetAsserting<bool>("transpose_a");
   bool transpose_b = attrs.GetAsserting<bool>("transpose_b");
+
+  DType mixed_precision_dtype = dctx->mixed_precision_dtype();
+  if (IsValid(mixed_precision_dtype) && a.dtype() == DType::F32 &&
+      b.dtype() == DType::F32) {
+    TFRT_ASSIGN_OR_RETURN(auto cast_a,
+                          CastGpuTensor(dctx, a, mixed_precision_dtype));
+    // The second operand is usually the weight of a dense layer.
+    TFRT_ASSIGN_OR_RETURN(auto cast_b,
+                          CastGpuWeight(dctx, b, mixed_precision_dtype));
+    if (auto error = RunMixedPrecisionCublasGemm(
+            dctx->current_context(), dctx->blas_handle(), transpose_a,
+            transpose_b, cast_a, cast_b, buffer)) {
+      return std::move(error);
+    }
+    return DenseGpuTensor(
+        result_md.shape, result_md.dtype,
+        MakeAvailableAsyncValueRef<GpuBuffer>(std::move(buffer)));
+  }
+
   if (auto error = RunCublasGemm(dctx->current_context(), dctx->blas_handle(),
                                  transpose_a, transpose_b, a, b, buffer)) {
     // TODO(iga): Propagate original error.
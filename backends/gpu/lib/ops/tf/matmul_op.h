@@ -32,6 +32,15 @@ llvm::Error RunCublasGemm(wrapper::CurrentContext current,
                           wrapper::BlasHandle handle, bool transpose_a,
                           bool transpose_b, const DenseGpuTensor& a,
                           const DenseGpuTensor& b, const GpuBuffer& result);
+
+// Runs gemm of F16 or BF16 `a` and `b` into an F32 `result`, accumulating in
+// F32 on tensor cores.
+llvm::Error RunMixedPrecisionCublasGemm(wrapper::CurrentContext current,
+                                        wrapper::BlasHandle handle,
+                                        bool transpose_a, bool transpose_b,
+                                        const DenseGpuTensor& a,
+                                        const DenseGpuTensor& b,
+                                        const GpuBuffer& result);
 }  // namespace gpu
 }  // namespace tfrt
 
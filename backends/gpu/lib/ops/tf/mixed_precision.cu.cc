@@ -0,0 +1,236 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Implements the casts used by ops running in mixed precision.
+
+#include "mixed_precision.h"
+
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "tfrt/gpu/core_runtime/gpu_dispatch_context.h"
+#include "tfrt/gpu/gpu_types.h"
+#include "tfrt/gpu/tensor/dense_gpu_tensor.h"
+#include "tfrt/gpu/wrapper/cudart_wrapper.h"
+#include "tfrt/gpu/wrapper/driver_wrapper.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace gpu {
+namespace {
+
+template <typename To, typename From>
+struct Converter;
+
+template <>
+struct Converter<__half, float> {
+  __device__ static __half Apply(float x) { return __float2half_rn(x); }
+};
+
+template <>
+struct Converter<__nv_bfloat16, float> {
+  __device__ static __nv_bfloat16 Apply(float x) {
+    return __float2bfloat16_rn(x);
+  }
+};
+
+template <>
+struct Converter<float, __half> {
+  __device__ static float Apply(__half x) { return __half2float(x); }
+};
+
+template <>
+struct Converter<float, __nv_bfloat16> {
+  __device__ static float Apply(__nv_bfloat16 x) { return __bfloat162float(x); }
+};
+
+template <typename To, typename From>
+__global__ void CastKernel(const From* input, To* output, int num_elements) {
+  for (int i = threadIdx.x + blockIdx.x * blockDim.x; i < num_elements;
+       i += blockDim.x * gridDim.x) {
+    output[i] = Converter<To, From>::Apply(input[i]);
+  }
+}
+
+template <typename To, typename From>
+llvm::Error LaunchCast(GpuDispatchContext* dctx, const DenseGpuTensor& input,
+                       const GpuBuffer& output) {
+  int num_elements = input.NumElements();
+  if (num_elements == 0) return llvm::Error::success();
+
+  const int threads_per_block = 256;
+  const int kMaxBlocks = 4096;
+  int num_blocks = std::min(
+      kMaxBlocks, (num_elements + threads_per_block - 1) / threads_per_block);
+  return wrapper::CudaLaunchKernel(
+      dctx->current_context(), &CastKernel<To, From>, num_blocks,
+      threads_per_block, 0, dctx->stream(), GetRawPointer<const From>(input),
+      GetRawPointer<To>(output), num_elements);
+}
+
+llvm::Expected<DenseGpuTensor> Cast(GpuDispatchContext* dctx,
+                                    AsyncValueRef<GpuAllocator> allocator,
+                                    const DenseGpuTensor& input, DType dtype) {
+  size_t size_in_bytes = GetHostSize(dtype) * input.NumElements();
+  TFRT_ASSIGN_OR_RETURN(
+      GpuBuffer output_buffer,
+      GpuBuffer::Allocate(std::move(allocator),
+                          /*size=*/size_in_bytes, dctx->stream()));
+
+  auto error = [&] {
+    switch (input.dtype()) {
+      case DType::F32:
+        if (dtype == DType::F16)
+          return LaunchCast<__half, float>(dctx, input, output_buffer);
+        if (dtype == DType::BF16)
+          return LaunchCast<__nv_bfloat16, float>(dctx, input, output_buffer);
+        break;
+      case DType::F16:
+        if (dtype == DType::F32)
+          return LaunchCast<float, __half>(dctx, input, output_buffer);
+        break;
+      case DType::BF16:
+        if (dtype == DType::F32)
+          return LaunchCast<float, __nv_bfloat16>(dctx, input, output_buffer);
+        break;
+      default:
+        break;
+    }
+    return MakeStringError("Unsupported mixed precision cast from ",
+                           input.dtype(), " to ", dtype);
+  }();
+  if (error) return std::move(error);
+
+  return DenseGpuTensor(
+      input.shape(), dtype,
+      MakeAvailableAsyncValueRef<GpuBuffer>(std::move(output_buffer)));
+}
+
+// Cast weights, keyed by the buffer of the weight and the cast dtype.
+class CastWeightCache {
+ public:
+  static CastWeightCache& Get() {
+    static auto* cache = new CastWeightCache;
+    return *cache;
+  }
+
+  llvm::Expected<DenseGpuTensor> GetOrCast(GpuDispatchContext* dctx,
+                                           const DenseGpuTensor& weight,
+                                           DType dtype);
+
+ private:
+  // Minimum number of cached weights before pruning.
+  static constexpr size_t kMinPruneSize = 64;
+
+  using Key = std::pair<const GpuBuffer*, int>;
+
+  struct Entry {
+    // Keeps the weight, and therefore the key of the entry, alive.
+    RCReference<AsyncValue> weight;
+    DenseGpuTensor result;
+    // Recorded on `stream` after the cast.
+    wrapper::Stream stream;
+    std::shared_ptr<wrapper::OwningEvent> event;
+  };
+
+  // Drops the entries of weights only referenced by the cache. Returns them so
+  // that they are deallocated outside of the lock.
+  std::vector<Entry> Prune() TFRT_REQUIRES(mutex_);
+
+  mutex mutex_;
+  llvm::DenseMap<Key, Entry> entries_ TFRT_GUARDED_BY(mutex_);
+  size_t prune_size_ TFRT_GUARDED_BY(mutex_) = kMinPruneSize;
+};
+
+llvm::Expected<DenseGpuTensor> CastWeightCache::GetOrCast(
+    GpuDispatchContext* dctx, const DenseGpuTensor& weight, DType dtype) {
+  Key key(&weight.buffer(), static_cast<int>(dtype));
+  {
+    wrapper::Stream stream;
+    std::shared_ptr<wrapper::OwningEvent> event;
+    llvm::Optional<DenseGpuTensor> result;
+    {
+      mutex_lock lock(mutex_);
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        stream = it->second.stream;
+        event = it->second.event;
+        result.emplace(it->second.result.CopyRef());
+      }
+    }
+    if (result) {
+      auto error = stream == dctx->stream()
+                       ? llvm::Error::success()
+                       : wrapper::StreamWaitEvent(dctx->stream(), event->get());
+      if (error) return std::move(error);
+      return std::move(*result);
+    }
+  }
+
+  TFRT_ASSIGN_OR_RETURN(
+      auto result, Cast(dctx, dctx->device().allocator(), weight, dtype));
+  TFRT_ASSIGN_OR_RETURN(auto event,
+                        wrapper::EventCreateNoTiming(dctx->current_context()));
+  if (auto error = wrapper::EventRecord(event.get(), dctx->stream()))
+    return std::move(error);
+
+  // Declared before the lock, so that pruned weights are deallocated after the
+  // lock is released.
+  std::vector<Entry> pruned;
+  mutex_lock lock(mutex_);
+  // If another op cast the weight concurrently, keep the first result.
+  entries_.try_emplace(
+      key, Entry{weight.CopyBufferRef().ReleaseRCRef(), result.CopyRef(),
+                 dctx->stream(),
+                 std::make_shared<wrapper::OwningEvent>(std::move(event))});
+  if (entries_.size() >= prune_size_) pruned = Prune();
+  return std::move(result);
+}
+
+std::vector<CastWeightCache::Entry> CastWeightCache::Prune() {
+  std::vector<Entry> pruned;
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (!it->second.weight->IsUnique()) continue;
+    pruned.push_back(std::move(it->second));
+    entries_.erase(it);
+  }
+  prune_size_ = std::max(kMinPruneSize, 2 * entries_.size());
+  return pruned;
+}
+
+}  // namespace
+
+llvm::Expected<DenseGpuTensor> CastGpuTensor(GpuDispatchContext* dctx,
+                                             const DenseGpuTensor& input,
+                                             DType dtype) {
+  return Cast(dctx, dctx->allocator(), input, dtype);
+}
+
+llvm::Expected<DenseGpuTensor> CastGpuWeight(GpuDispatchContext* dctx,
+                                             const DenseGpuTensor& weight,
+                                             DType dtype) {
+  return CastWeightCache::Get().GetOrCast(dctx, weight, dtype);
+}
+
+}  // namespace gpu
+}  // namespace tfrt
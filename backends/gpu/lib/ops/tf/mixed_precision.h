@@ -0,0 +1,46 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Declares the casts used by ops running in mixed precision, see
+// GpuMixedPrecisionPolicy.
+#ifndef TFRT_BACKENDS_GPU_LIB_OPS_TF_MIXED_PRECISION_H_
+#define TFRT_BACKENDS_GPU_LIB_OPS_TF_MIXED_PRECISION_H_
+
+#include "llvm/Support/Error.h"
+#include "tfrt/dtype/dtype.h"
+
+namespace tfrt {
+namespace gpu {
+class DenseGpuTensor;
+class GpuDispatchContext;
+
+// Returns `input` cast to `dtype` on the stream of `dctx`. Supports casts from
+// F32 to F16 or BF16 and back.
+llvm::Expected<DenseGpuTensor> CastGpuTensor(GpuDispatchContext* dctx,
+                                             const DenseGpuTensor& input,
+                                             DType dtype);
+
+// Same as CastGpuTensor, but caches the result for as long as `weight` is
+// alive, so that the weights of a model are only cast once. The cached result
+// is allocated from the device allocator, because it outlives the request.
+llvm::Expected<DenseGpuTensor> CastGpuWeight(GpuDispatchContext* dctx,
+                                             const DenseGpuTensor& weight,
+                                             DType dtype);
+
+}  // namespace gpu
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_GPU_LIB_OPS_TF_MIXED_PRECISION_H_
@@ -14,8 +14,11 @@
 
 // Implementations of TF reduction ops.
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
+#include <type_traits>
 
 #include "cub/device/device_reduce.cuh"               // from @cub_archive
 #include "cub/device/device_segmented_reduce.cuh"     // from @cub_archive
@@ -63,6 +66,30 @@ __global__ void OuterReductionKernel(const T* input, T* output,
   output[gid] = transform(sum);
 }
 
+// Reduces `rows_per_split` rows of each column, and writes the partial result
+// of split `blockIdx.y` to `partials[blockIdx.y * inner_dim_size + column]`.
+// Used for tall and narrow inputs, where one thread per column leaves most of
+// the GPU idle.
+template <typename T, typename ReduceOp>
+__global__ void OuterPartialReductionKernel(const T* input, T* partials,
+                                            int outer_dim_size,
+                                            int inner_dim_size,
+                                            int rows_per_split, T init,
+                                            ReduceOp reduce) {
+  const int gid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (gid >= inner_dim_size) return;
+
+  const int begin = blockIdx.y * rows_per_split;
+  const int end = min(begin + rows_per_split, outer_dim_size);
+
+  T sum = init;
+  for (int outer_idx = begin; outer_idx < end; ++outer_idx) {
+    sum = reduce(sum, input[outer_idx * inner_dim_size + gid]);
+  }
+
+  partials[blockIdx.y * inner_dim_size + gid] = sum;
+}
+
 // Reduces the columns of batch of matrices.
 //
 // Run with a [inner_dim_size/32, outer_dim_size] blocks of [1024] threads.
@@ -105,8 +132,15 @@ __global__ void __launch_bounds__(1024)
   }
 }
 
-// Inner reduction kernel that maps a warp to each row.
-template <typename T, typename ReduceOp, typename TransformOp>
+// Elements loaded with a single instruction.
+template <typename T, int N>
+struct alignas(sizeof(T) * N) Vector {
+  T values[N];
+};
+
+// Inner reduction kernel that maps a warp to each row. Loads `kVectorSize`
+// elements at a time, which requires that the rows are aligned accordingly.
+template <int kVectorSize, typename T, typename ReduceOp, typename TransformOp>
 __global__ void InnerReductionKernel(const T* input, T* output,
                                      int outer_dim_size, int inner_dim_size,
                                      T init, ReduceOp reduce,
@@ -131,14 +165,19 @@ __global__ void InnerReductionKernel(const T* input, T* output,
   const int row = blockIdx.x * warps_per_block + warp_index;
   if (row >= outer_dim_size) return;
 
-  // Index along the inner dimension (aka col).
+  // Index along the inner dimension (aka col), in vectors.
   int col = lane;
+  const int num_vectors = inner_dim_size / kVectorSize;
+  const auto* vectors = reinterpret_cast<const Vector<T, kVectorSize>*>(
+      input + row * inner_dim_size);
 
   auto sum = init;
 
   // Compute partial reduction over inner dimension.
-  for (; col < inner_dim_size; col += kWarpSize) {
-    sum = reduce(sum, input[row * inner_dim_size + col]);
+  for (; col < num_vectors; col += kWarpSize) {
+    Vector<T, kVectorSize> vector = vectors[col];
+#pragma unroll
+    for (int i = 0; i < kVectorSize; ++i) sum = reduce(sum, vector.values[i]);
   }
 
   // Reduce partial results using warp reduce.
@@ -146,14 +185,110 @@ __global__ void InnerReductionKernel(const T* input, T* output,
   __shared__ typename WarpReduce::TempStorage tmp_storage;
 
   sum = WarpReduce(tmp_storage)
-            .Reduce(sum, reduce, min(inner_dim_size, kWarpSize));
+            .Reduce(sum, reduce, min(num_vectors, kWarpSize));
   if (lane == 0) output[row] = transform(sum);
 }
 
+// Computes the index of the element along the middle dimension of a
+// [outer_dim_size, middle_dim_size, inner_dim_size] tensor that wins all
+// comparisons (i.e. ArgMax or ArgMin), one thread per output element. Ties
+// resolve to the smallest index.
+template <typename T, typename IndexT, typename CompareOp>
+__global__ void ArgReductionKernel(const T* input, IndexT* output,
+                                   int outer_dim_size, int middle_dim_size,
+                                   int inner_dim_size, CompareOp compare) {
+  const int gid = threadIdx.x + blockIdx.x * blockDim.x;
+  if (gid >= outer_dim_size * inner_dim_size) return;
+
+  const int outer_idx = gid / inner_dim_size;
+  const int inner_idx = gid % inner_dim_size;
+  input += outer_idx * middle_dim_size * inner_dim_size + inner_idx;
+
+  T best = input[0];
+  IndexT best_idx = 0;
+  for (int middle_idx = 1; middle_idx < middle_dim_size; ++middle_idx) {
+    T value = input[middle_idx * inner_dim_size];
+    if (compare(value, best)) {
+      best = value;
+      best_idx = middle_idx;
+    }
+  }
+
+  output[gid] = best_idx;
+}
+
+// Same as above for an inner dimension size of 1, which maps a warp to each
+// row of the [outer_dim_size, middle_dim_size] tensor.
+template <typename T, typename IndexT, typename CompareOp>
+__global__ void InnerArgReductionKernel(const T* input, IndexT* output,
+                                        int outer_dim_size,
+                                        int middle_dim_size,
+                                        CompareOp compare) {
+  assert(blockDim.x % kWarpSize == 0);
+
+  const int warps_per_block = blockDim.x / kWarpSize;
+  const int lane = threadIdx.x % kWarpSize;
+  const int row = blockIdx.x * warps_per_block + threadIdx.x / kWarpSize;
+  if (row >= outer_dim_size) return;
+
+  input += row * middle_dim_size;
+
+  // Every lane starts with the first element, lanes past the end of the row
+  // keep it.
+  T best = input[0];
+  IndexT best_idx = 0;
+  for (int col = lane; col < middle_dim_size; col += kWarpSize) {
+    T value = input[col];
+    if (compare(value, best)) {
+      best = value;
+      best_idx = col;
+    }
+  }
+
+  for (int offset = kWarpSize / 2; offset > 0; offset /= 2) {
+    T value = static_cast<T>(__shfl_down_sync(~0u, best, offset));
+    IndexT idx = __shfl_down_sync(~0u, best_idx, offset);
+    if (compare(value, best) || (!compare(best, value) && idx < best_idx)) {
+      best = value;
+      best_idx = idx;
+    }
+  }
+
+  if (lane == 0) output[row] = best_idx;
+}
+
 //===----------------------------------------------------------------------===//
 // Host code for launching reduction kernels.
 //===----------------------------------------------------------------------===//
 
+struct Identity {
+  template <typename T>
+  __host__ __device__ T operator()(const T& x) const {
+    return x;
+  }
+};
+
+struct Product {
+  template <typename T>
+  __host__ __device__ T operator()(const T& a, const T& b) const {
+    return a * b;
+  }
+};
+
+struct Greater {
+  template <typename T>
+  __device__ bool operator()(const T& a, const T& b) const {
+    return a > b;
+  }
+};
+
+struct Less {
+  template <typename T>
+  __device__ bool operator()(const T& a, const T& b) const {
+    return a < b;
+  }
+};
+
 template <typename T>
 struct Multiplies {
   __host__ __device__ explicit Multiplies(T multiplier)
@@ -237,10 +372,41 @@ static llvm::Error OuterReduction(GpuDispatchContext* dctx, const T* input,
   Index threads_per_block = 128;
   Index num_blocks = NumBlocks(inner_dim_size, threads_per_block);
 
+  // If there are only a few columns but many rows, split the rows into blocks
+  // which compute partial results first, and reduce these in a second pass.
+  const Index kMinRowsPerSplit = 256;
+  const Index kMinBlocks = 64;
+  Index num_splits = std::min(NumBlocks(kMinBlocks, num_blocks),
+                              outer_dim_size / kMinRowsPerSplit);
+  if (num_splits < 2) {
+    return wrapper::CudaLaunchKernel(
+        dctx->current_context(),
+        &OuterReductionKernel<T, ReduceOp, TransformOp>, num_blocks,
+        threads_per_block, 0, dctx->stream(), input, output, outer_dim_size,
+        inner_dim_size, init, reduce, transform);
+  }
+
+  Index rows_per_split = NumBlocks(outer_dim_size, num_splits);
+  TFRT_ASSIGN_OR_RETURN(
+      GpuBuffer partials,
+      GpuBuffer::Allocate(dctx->allocator(),
+                          /*size=*/num_splits * inner_dim_size * sizeof(T),
+                          dctx->stream()));
+  T* partials_ptr = GetRawPointer<T>(partials);
+
+  dim3 grid_dim = {static_cast<unsigned>(num_blocks),
+                   static_cast<unsigned>(num_splits), 1};
+  if (auto err = wrapper::CudaLaunchKernel(
+          dctx->current_context(), &OuterPartialReductionKernel<T, ReduceOp>,
+          grid_dim, threads_per_block, 0, dctx->stream(), input, partials_ptr,
+          outer_dim_size, inner_dim_size, rows_per_split, init, reduce))
+    return std::move(err);
+
   return wrapper::CudaLaunchKernel(
       dctx->current_context(), &OuterReductionKernel<T, ReduceOp, TransformOp>,
-      num_blocks, threads_per_block, 0, dctx->stream(), input, output,
-      outer_dim_size, inner_dim_size, init, reduce, transform);
+      num_blocks, threads_per_block, 0, dctx->stream(),
+      static_cast<const T*>(partials_ptr), output, num_splits, inner_dim_size,
+      init, reduce, transform);
 }
 
 template <typename T, typename ReduceOp, typename TransformOp>
@@ -256,11 +422,17 @@ static llvm::Error InnerReduction(GpuDispatchContext* dctx, const T* input,
     const int warps_per_block = threads_per_block / kWarpSize;
     const int num_blocks = NumBlocks(outer_dim_size, warps_per_block);
 
+    // Load 16 bytes at a time if all rows are aligned to 16 bytes.
+    constexpr int kVectorSize = sizeof(T) < 16 ? 16 / sizeof(T) : 1;
+    auto kernel = &InnerReductionKernel<1, T, ReduceOp, TransformOp>;
+    if (inner_dim_size % kVectorSize == 0 &&
+        reinterpret_cast<uintptr_t>(input) % (kVectorSize * sizeof(T)) == 0)
+      kernel = &InnerReductionKernel<kVectorSize, T, ReduceOp, TransformOp>;
+
     return wrapper::CudaLaunchKernel(
-        dctx->current_context(),
-        &InnerReductionKernel<T, ReduceOp, TransformOp>, num_blocks,
-        threads_per_block, 0, dctx->stream(), input, output, outer_dim_size,
-        inner_dim_size, init, reduce, transform);
+        dctx->current_context(), kernel, num_blocks, threads_per_block, 0,
+        dctx->stream(), input, output, outer_dim_size, inner_dim_size, init,
+        reduce, transform);
   }
 
   size_t temp_storage_bytes = 0;
@@ -290,7 +462,7 @@ static llvm::Error InnerReduction(GpuDispatchContext* dctx, const T* input,
   TFRT_ASSIGN_OR_RETURN(
       GpuBuffer tmp_buffer,
       GpuBuffer::Allocate(dctx->allocator(),
-                          /*size=*/sizeof(uint8_t), dctx->stream()));
+                          /*size=*/temp_storage_bytes, dctx->stream()));
 
   // Do reduction.
   return launch(GetRawPointer<void>(tmp_buffer));
@@ -425,20 +597,38 @@ static llvm::Error Reduce(GpuDispatchContext* dctx, const DenseGpuTensor& input,
 // TFRT reduction op implementations.
 //===----------------------------------------------------------------------===//
 
+enum class ReductionKind { kSum, kMean, kMax, kMin, kProd };
+
 template <typename T>
-static llvm::Error ReduceMean(GpuDispatchContext* dctx,
-                              const DenseGpuTensor& input,
-                              const GpuBuffer& output,
-                              const TensorMetadata& out_md,
-                              ArrayRef<int32_t> reduction_indices) {
-  // Number of input elements per output element.
-  Index num_reduced = input.NumElements() / out_md.shape.GetNumElements();
-  return Reduce(dctx, input, output, out_md, reduction_indices, T{0},
-                cub::Sum(), Multiplies<T>(T{1} / num_reduced));
+static llvm::Error Reduce(GpuDispatchContext* dctx, ReductionKind kind,
+                          const DenseGpuTensor& input, const GpuBuffer& output,
+                          const TensorMetadata& out_md,
+                          ArrayRef<int32_t> reduction_indices) {
+  switch (kind) {
+    case ReductionKind::kSum:
+      return Reduce(dctx, input, output, out_md, reduction_indices, T{0},
+                    cub::Sum(), Identity());
+    case ReductionKind::kMean: {
+      // Number of input elements per output element.
+      Index num_reduced = input.NumElements() / out_md.shape.GetNumElements();
+      return Reduce(dctx, input, output, out_md, reduction_indices, T{0},
+                    cub::Sum(), Multiplies<T>(T{1} / num_reduced));
+    }
+    case ReductionKind::kMax:
+      return Reduce(dctx, input, output, out_md, reduction_indices,
+                    Eigen::NumTraits<T>::lowest(), cub::Max(), Identity());
+    case ReductionKind::kMin:
+      return Reduce(dctx, input, output, out_md, reduction_indices,
+                    Eigen::NumTraits<T>::highest(), cub::Min(), Identity());
+    case ReductionKind::kProd:
+      return Reduce(dctx, input, output, out_md, reduction_indices, T{1},
+                    Product(), Identity());
+  }
+  llvm_unreachable("unknown reduction kind");
 }
 
-static llvm::Expected<DenseGpuTensor> ComputeMeanGpuOpImpl(
-    GpuDispatchContext* dctx, const DenseGpuTensor& input,
+static llvm::Expected<DenseGpuTensor> ComputeReductionGpuOpImpl(
+    GpuDispatchContext* dctx, ReductionKind kind, const DenseGpuTensor& input,
     ArrayRef<int32_t> reduction_indices, const TensorMetadata& result_md) {
   size_t num_result_elements = result_md.shape.GetNumElements();
   size_t size_in_bytes = GetHostSize(result_md.dtype) * num_result_elements;
@@ -448,53 +638,172 @@ static llvm::Expected<DenseGpuTensor> ComputeMeanGpuOpImpl(
       GpuBuffer::Allocate(dctx->allocator(),
                           /*size=*/size_in_bytes, dctx->stream()));
 
+  auto reduce = [&](auto zero) {
+    return Reduce<decltype(zero)>(dctx, kind, input, output_buffer, result_md,
+                                  reduction_indices);
+  };
+
+  llvm::Error error = llvm::Error::success();
   switch (input.dtype()) {
     default:
       return MakeStringError("Unsupported data type: ", input.dtype());
 
     case DType::F16:
-      if (auto err = ReduceMean<Eigen::half>(dctx, input, output_buffer,
-                                             result_md, reduction_indices))
-        return std::move(err);
+      error = reduce(Eigen::half{0});
       break;
 
     case DType::F32:
-      if (auto err = ReduceMean<float>(dctx, input, output_buffer, result_md,
-                                       reduction_indices))
-        return std::move(err);
+      error = reduce(float{0});
+      break;
+
+    case DType::F64:
+      error = reduce(double{0});
+      break;
+
+    case DType::I32:
+      if (kind == ReductionKind::kMean)
+        return MakeStringError("tf.Mean requires a floating point type");
+      error = reduce(int32_t{0});
+      break;
+
+    case DType::I64:
+      if (kind == ReductionKind::kMean)
+        return MakeStringError("tf.Mean requires a floating point type");
+      error = reduce(int64_t{0});
       break;
   }
+  if (error) return std::move(error);
 
   return DenseGpuTensor(
       result_md.shape, result_md.dtype,
       MakeAvailableAsyncValueRef<GpuBuffer>(std::move(output_buffer)));
 }
 
-static llvm::Expected<DenseGpuTensor> ComputeMeanGpuOpFolded(
+template <ReductionKind kind>
+static llvm::Expected<DenseGpuTensor> ComputeReductionGpuOpFolded(
     GpuDispatchContext* dctx, const DenseGpuTensor& input,
     const OpAttrsRef& attrs, const TensorMetadata& result_md) {
   DenseAttr dense_attr;
   if (!attrs.Get("reduction_indices", &dense_attr)) {
     return MakeStringError(
-        "tf.Mean needs a `reduction_indices` dense attribute");
+        "Reduction needs a `reduction_indices` dense attribute");
   }
 
   DenseView dense_view = CreateDenseView(dense_attr);
   switch (dense_view.dtype()) {
     case DType::I32:
-      return ComputeMeanGpuOpImpl(dctx, input, dense_view.GetFlat<int32_t>(),
-                                  result_md);
+      return ComputeReductionGpuOpImpl(
+          dctx, kind, input, dense_view.GetFlat<int32_t>(), result_md);
     case DType::I64: {
       llvm::SmallVector<int32_t, 4> reduction_indices;
       llvm::copy(dense_view.GetFlat<int64_t>(),
                  std::back_inserter(reduction_indices));
-      return ComputeMeanGpuOpImpl(dctx, input, reduction_indices, result_md);
+      return ComputeReductionGpuOpImpl(dctx, kind, input, reduction_indices,
+                                       result_md);
     }
     default:
-      llvm_unreachable("unsupported dtype for reduction indices input tf.Mean");
+      llvm_unreachable("unsupported dtype for reduction indices");
   }
 }
 
+template <typename T, typename CompareOp>
+static llvm::Error ArgReduce(GpuDispatchContext* dctx,
+                             const DenseGpuTensor& input,
+                             const GpuBuffer& output, DType index_dtype,
+                             const ReductionDims3& dims, CompareOp compare) {
+  auto launch = [&](auto* output_ptr) -> llvm::Error {
+    using IndexT = std::remove_pointer_t<decltype(output_ptr)>;
+    const int threads_per_block = 128;
+    if (dims.inner_dim_size == 1) {
+      const int warps_per_block = threads_per_block / kWarpSize;
+      return wrapper::CudaLaunchKernel(
+          dctx->current_context(),
+          &InnerArgReductionKernel<T, IndexT, CompareOp>,
+          NumBlocks(dims.outer_dim_size, warps_per_block), threads_per_block,
+          0, dctx->stream(), GetRawPointer<const T>(input), output_ptr,
+          dims.outer_dim_size, dims.middle_dim_size, compare);
+    }
+    return wrapper::CudaLaunchKernel(
+        dctx->current_context(), &ArgReductionKernel<T, IndexT, CompareOp>,
+        NumBlocks(dims.outer_dim_size * dims.inner_dim_size,
+                  threads_per_block),
+        threads_per_block, 0, dctx->stream(), GetRawPointer<const T>(input),
+        output_ptr, dims.outer_dim_size, dims.middle_dim_size,
+        dims.inner_dim_size, compare);
+  };
+
+  if (index_dtype == DType::I32) return launch(GetRawPointer<int32_t>(output));
+  return launch(GetRawPointer<int64_t>(output));
+}
+
+// Computes tf.ArgMax or tf.ArgMin, with the `dimension` argument folded into
+// an attribute.
+template <typename CompareOp>
+static llvm::Expected<DenseGpuTensor> ComputeArgReductionGpuOpFolded(
+    GpuDispatchContext* dctx, const DenseGpuTensor& input,
+    const OpAttrsRef& attrs, const TensorMetadata& result_md) {
+  DenseAttr dense_attr;
+  if (!attrs.Get("dimension", &dense_attr))
+    return MakeStringError("ArgMax and ArgMin need a `dimension` attribute");
+  DenseView dimension_view = CreateDenseView(dense_attr);
+  int64_t dimension = dimension_view.dtype() == DType::I32
+                          ? dimension_view.GetFlat<int32_t>()[0]
+                          : dimension_view.GetFlat<int64_t>()[0];
+  const TensorShape& shape = input.shape();
+  if (dimension < 0) dimension += shape.GetRank();
+  if (dimension < 0 || dimension >= shape.GetRank() ||
+      shape.GetDimensionSize(dimension) == 0)
+    return MakeStringError("Invalid ArgMax/ArgMin dimension: ", dimension);
+  if (result_md.dtype != DType::I32 && result_md.dtype != DType::I64)
+    return MakeStringError("Unsupported output type: ", result_md.dtype);
+
+  // View input tensor as a 3d tensor:
+  //     [outer_dim_size, middle_dim_size, inner_dims_size].
+  ReductionDims3 dims = {1, shape.GetDimensionSize(dimension), 1};
+  for (int i = 0; i < dimension; ++i)
+    dims.outer_dim_size *= shape.GetDimensionSize(i);
+  for (int i = dimension + 1; i < shape.GetRank(); ++i)
+    dims.inner_dim_size *= shape.GetDimensionSize(i);
+
+  size_t size_in_bytes =
+      GetHostSize(result_md.dtype) * result_md.shape.GetNumElements();
+  TFRT_ASSIGN_OR_RETURN(
+      GpuBuffer output_buffer,
+      GpuBuffer::Allocate(dctx->allocator(),
+                          /*size=*/size_in_bytes, dctx->stream()));
+
+  auto arg_reduce = [&](auto zero) {
+    return ArgReduce<decltype(zero)>(dctx, input, output_buffer,
+                                     result_md.dtype, dims, CompareOp());
+  };
+
+  llvm::Error error = llvm::Error::success();
+  switch (input.dtype()) {
+    default:
+      return MakeStringError("Unsupported data type: ", input.dtype());
+    case DType::F16:
+      error = arg_reduce(Eigen::half{0});
+      break;
+    case DType::F32:
+      error = arg_reduce(float{0});
+      break;
+    case DType::F64:
+      error = arg_reduce(double{0});
+      break;
+    case DType::I32:
+      error = arg_reduce(int32_t{0});
+      break;
+    case DType::I64:
+      error = arg_reduce(int64_t{0});
+      break;
+  }
+  if (error) return std::move(error);
+
+  return DenseGpuTensor(
+      result_md.shape, result_md.dtype,
+      MakeAvailableAsyncValueRef<GpuBuffer>(std::move(output_buffer)));
+}
+
 static llvm::Expected<DenseGpuTensor> ComputeMeanGpuOp(
     GpuDispatchContext* dctx, const DenseGpuTensor& input,
     const DenseGpuTensor& /*reduction_indices*/) {
@@ -515,7 +824,8 @@ static llvm::Expected<DenseGpuTensor> ComputeMeanGpuOp(
   }
   TensorMetadata result_md(input.dtype(), result_dims);
 
-  return ComputeMeanGpuOpImpl(dctx, input, reduction_indices, result_md);
+  return ComputeReductionGpuOpImpl(dctx, ReductionKind::kMean, input,
+                                   reduction_indices, result_md);
 }
 
 void RegisterReductionGpuTfOps(GpuOpRegistry* registry) {
@@ -523,8 +833,35 @@ void RegisterReductionGpuTfOps(GpuOpRegistry* registry) {
 
   // "_tf.Mean" is a compiler-optimized version of "tf.Mean", where the argument
   // "reduction_indices" is folded to an attribute.
-  registry->AddOp("_tf.Mean", TFRT_GPU_OP(gpu::ComputeMeanGpuOpFolded),
-                  {"reduction_indices"});
+  registry->AddOp(
+      "_tf.Mean",
+      TFRT_GPU_OP(gpu::ComputeReductionGpuOpFolded<ReductionKind::kMean>),
+      {"reduction_indices"});
+  registry->AddOp(
+      "_tf.Sum",
+      TFRT_GPU_OP(gpu::ComputeReductionGpuOpFolded<ReductionKind::kSum>),
+      {"reduction_indices"});
+  registry->AddOp(
+      "_tf.Max",
+      TFRT_GPU_OP(gpu::ComputeReductionGpuOpFolded<ReductionKind::kMax>),
+      {"reduction_indices"});
+  registry->AddOp(
+      "_tf.Min",
+      TFRT_GPU_OP(gpu::ComputeReductionGpuOpFolded<ReductionKind::kMin>),
+      {"reduction_indices"});
+  registry->AddOp(
+      "_tf.Prod",
+      TFRT_GPU_OP(gpu::ComputeReductionGpuOpFolded<ReductionKind::kProd>),
+      {"reduction_indices"});
+
+  // "_tf.ArgMax" and "_tf.ArgMin" have the argument "dimension" folded to an
+  // attribute.
+  registry->AddOp("_tf.ArgMax",
+                  TFRT_GPU_OP(gpu::ComputeArgReductionGpuOpFolded<Greater>),
+                  {"dimension", "output_type"});
+  registry->AddOp("_tf.ArgMin",
+                  TFRT_GPU_OP(gpu::ComputeArgReductionGpuOpFolded<Less>),
+                  {"dimension", "output_type"});
 }
 
 }  // namespace gpu
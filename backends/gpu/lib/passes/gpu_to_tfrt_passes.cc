@@ -1739,6 +1739,7 @@ void PopulateGpuToTfrtGpuPasses(OpPassManager &pm) {
   pm.addPass(std::make_unique<ConvertGpuToTfrtGpuPass>());
   pm.addPass(std::make_unique<ReconcileCastsPass>());
   pm.addPass(std::make_unique<ConvertAsyncToTfrtPass>());
+  pm.addNestedPass<func::FuncOp>(CreateMemoryPlanningPass());
   pm.addPass(std::make_unique<HoistingPass>());
 }
 
@@ -1751,6 +1752,8 @@ void RegisterPasses() {
   PassRegistration<ConvertAsyncToTfrtPass>();
   PassRegistration<HoistingPass>();
   registerPass([] { return CreateSetEntryPointPass(); });
+  registerPass([] { return CreateTensorCoreLayoutPass(); });
+  registerPass([] { return CreateMemoryPlanningPass(); });
 
   PassPipelineRegistration<>(
       "gpu-to-tfrt-gpu",
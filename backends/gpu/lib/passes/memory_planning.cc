@@ -0,0 +1,237 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements a pass which plans the device memory of the buffers
+// that a function allocates and deallocates itself, and suballocates them from
+// one slab per stream.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MathExtras.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Pass/Pass.h"
+#include "tfrt/basic_kernels/opdefs/basic_kernels.h"
+#include "tfrt/basic_kernels/opdefs/types.h"
+#include "tfrt/gpu/kernels/gpu_ops.h"
+#include "tfrt/gpu/passes/passes.h"
+
+namespace tfrt {
+namespace gpu {
+
+namespace {
+
+// A pass which assigns the buffers allocated with tfrt_gpu.mem.allocate and
+// deallocated with tfrt_gpu.mem.deallocate in the body of a function to
+// offsets in a single slab per stream, which is allocated instead.
+//
+// Two buffers may share memory if one is deallocated before the other is
+// allocated, i.e. if the chain of one allocation depends on the deallocation
+// of the other buffer. This is the condition under which the allocator could
+// have reused the memory as well, so uses of the buffers are synchronized
+// accordingly.
+struct MemoryPlanningPass
+    : public PassWrapper<MemoryPlanningPass, OperationPass<func::FuncOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(MemoryPlanningPass)
+
+ private:
+  void runOnOperation() override;
+  StringRef getArgument() const final { return "tfrt-gpu-plan-memory"; }
+};
+
+// Device buffers are allocated with this alignment, see GpuAllocator.
+constexpr uint64_t kAlignment = 256;
+
+// A buffer allocated and deallocated in the body of the function.
+struct PlannedBuffer {
+  MemAllocateOp alloc_op;
+  MemDeallocateOp dealloc_op;
+  uint64_t size;  // In bytes, not rounded up.
+  uint64_t offset = 0;
+};
+
+}  // namespace
+
+// Returns the deallocation of the buffer allocated by 'alloc_op', or null if
+// the buffer is not deallocated on the same stream in the same block, or if it
+// may outlive the deallocation.
+static MemDeallocateOp GetLocalDeallocation(MemAllocateOp alloc_op) {
+  Block *block = alloc_op->getBlock();
+  Value stream = alloc_op->getOperand(1);
+  MemDeallocateOp result;
+  for (Operation *user : alloc_op->getUsers()) {
+    if (auto dealloc_op = dyn_cast<MemDeallocateOp>(user)) {
+      if (result || dealloc_op->getBlock() != block ||
+          dealloc_op->getOperand(1) != stream)
+        return nullptr;
+      result = dealloc_op;
+      continue;
+    }
+    if (!block->findAncestorOpInBlock(*user)) return nullptr;
+    // The buffer escapes through calls, returns and ops that return buffers
+    // (e.g. views).
+    if (isa<compiler::CallOp, compiler::ReturnOp>(user)) return nullptr;
+    if (llvm::any_of(user->getResultTypes(),
+                     [](Type type) { return type.isa<BufferType>(); }))
+      return nullptr;
+  }
+  return result;
+}
+
+// Returns whether 'value' is only available after 'op' has been executed.
+static bool DependsOn(Value value, Operation *op) {
+  SmallVector<Value, 8> worklist = {value};
+  llvm::SmallPtrSet<Operation *, 16> visited;
+  while (!worklist.empty()) {
+    Operation *def_op = worklist.pop_back_val().getDefiningOp();
+    if (!def_op || !visited.insert(def_op).second) continue;
+    if (def_op == op) return true;
+    worklist.append(def_op->operand_begin(), def_op->operand_end());
+  }
+  return false;
+}
+
+// Returns whether 'lhs' is allocated after 'rhs' has been deallocated.
+static bool IsAllocatedAfter(const PlannedBuffer &lhs,
+                             const PlannedBuffer &rhs) {
+  return DependsOn(lhs.alloc_op->getOperand(3), rhs.dealloc_op);
+}
+
+// Assigns offsets to 'buffers' so that buffers which are live at the same time
+// don't overlap, and returns the size of the slab. Larger buffers are placed
+// first, each at the lowest offset that fits.
+static uint64_t AssignOffsets(MutableArrayRef<PlannedBuffer> buffers) {
+  SmallVector<PlannedBuffer *, 8> order;
+  for (auto &buffer : buffers) order.push_back(&buffer);
+  llvm::stable_sort(order, [](PlannedBuffer *lhs, PlannedBuffer *rhs) {
+    return lhs->size > rhs->size;
+  });
+
+  uint64_t slab_size = 0;
+  for (auto it = order.begin(); it != order.end(); ++it) {
+    PlannedBuffer *buffer = *it;
+    SmallVector<std::pair<uint64_t, uint64_t>, 8> live_ranges;
+    for (PlannedBuffer *placed : llvm::make_range(order.begin(), it)) {
+      if (IsAllocatedAfter(*buffer, *placed) ||
+          IsAllocatedAfter(*placed, *buffer))
+        continue;
+      live_ranges.emplace_back(placed->offset,
+                               placed->offset + placed->size);
+    }
+    llvm::sort(live_ranges);
+
+    uint64_t offset = 0;
+    for (auto range : live_ranges) {
+      if (offset + buffer->size <= range.first) break;
+      offset = std::max(offset, llvm::alignTo(range.second, kAlignment));
+    }
+    buffer->offset = offset;
+    slab_size = std::max(slab_size, offset + buffer->size);
+  }
+  return slab_size;
+}
+
+// Replaces the allocations and deallocations of 'buffers', which are in
+// program order, with views of a slab of 'slab_size' bytes.
+static void SuballocateFromSlab(ArrayRef<PlannedBuffer> buffers,
+                                uint64_t slab_size) {
+  MemAllocateOp first_alloc_op = buffers.front().alloc_op;
+  Location loc = first_alloc_op->getLoc();
+  Value stream = first_alloc_op->getOperand(1);
+  OpBuilder builder(first_alloc_op);
+  Value size = builder.create<compiler::ConstantI64Op>(loc, slab_size);
+  Value slab = builder.create<MemAllocateOp>(
+      loc, first_alloc_op->getOperand(0), stream, size,
+      first_alloc_op->getOperand(3));
+
+  // Uses of a buffer must not start before the allocation's chain is ready,
+  // which orders them after the uses of buffers deallocated before.
+  for (const PlannedBuffer &buffer : buffers) {
+    MemAllocateOp alloc_op = buffer.alloc_op;
+    builder.setInsertionPoint(alloc_op);
+    Value offset =
+        builder.create<compiler::ConstantUI64Op>(loc, buffer.offset);
+    Value view_size =
+        builder.create<compiler::ConstantUI64Op>(loc, buffer.size);
+    Value view = builder.create<MemViewOp>(loc, slab, offset, view_size);
+    Value alias = builder.create<AliasOp>(loc, view.getType(), view,
+                                          alloc_op->getOperand(3));
+    alloc_op->replaceAllUsesWith(ValueRange(alias));
+  }
+
+  // Deallocate the slab after the last deallocation, once the uses of all
+  // buffers are synchronized with the stream.
+  MemDeallocateOp last_dealloc_op = buffers.front().dealloc_op;
+  SmallVector<Value, 8> chains;
+  for (const PlannedBuffer &buffer : buffers) {
+    if (last_dealloc_op->isBeforeInBlock(buffer.dealloc_op))
+      last_dealloc_op = buffer.dealloc_op;
+    chains.push_back(buffer.dealloc_op->getOperand(2));
+  }
+  builder.setInsertionPointAfter(last_dealloc_op);
+  Value chain = builder.create<compiler::MergeChainsOp>(
+      loc, builder.getType<compiler::ChainType>(), chains);
+  Value slab_chain =
+      builder.create<MemDeallocateOp>(loc, slab, stream, chain);
+
+  for (const PlannedBuffer &buffer : buffers) {
+    MemDeallocateOp dealloc_op = buffer.dealloc_op;
+    Value result = dealloc_op == last_dealloc_op ? slab_chain
+                                                 : dealloc_op->getOperand(2);
+    dealloc_op->replaceAllUsesWith(ValueRange(result));
+    dealloc_op->erase();
+  }
+  for (const PlannedBuffer &buffer : buffers) {
+    Operation *size_op = buffer.alloc_op.getSize().getDefiningOp();
+    buffer.alloc_op->erase();
+    if (size_op->use_empty()) size_op->erase();
+  }
+}
+
+void MemoryPlanningPass::runOnOperation() {
+  Block &body = getOperation().getBody().front();
+
+  // Buffers grouped by stream, in program order.
+  llvm::MapVector<Value, SmallVector<PlannedBuffer, 8>> buffers_by_stream;
+  for (auto alloc_op : body.getOps<MemAllocateOp>()) {
+    auto size_op = alloc_op.getSize().getDefiningOp<compiler::ConstantI64Op>();
+    if (!size_op || size_op.getValue() == 0) continue;
+    auto dealloc_op = GetLocalDeallocation(alloc_op);
+    if (!dealloc_op) continue;
+    buffers_by_stream[alloc_op->getOperand(1)].push_back(
+        {alloc_op, dealloc_op, size_op.getValue()});
+  }
+
+  for (auto &pair : buffers_by_stream) {
+    MutableArrayRef<PlannedBuffer> buffers = pair.second;
+    // A single buffer is best left to the allocator.
+    if (buffers.size() < 2) continue;
+    uint64_t slab_size = AssignOffsets(buffers);
+    SuballocateFromSlab(buffers, slab_size);
+  }
+}
+
+std::unique_ptr<OperationPass<func::FuncOp>> CreateMemoryPlanningPass() {
+  return std::make_unique<MemoryPlanningPass>();
+}
+
+}  // namespace gpu
+}  // namespace tfrt
@@ -0,0 +1,313 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements a pass which runs half precision convolutions on
+// corert.executeop ops in NHWC layout, the layout tensor cores compute in, and
+// removes the transposes this inserts where possible.
+
+#include <cstdint>
+#include <utility>
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/Pass/Pass.h"
+#include "tfrt/core_runtime/opdefs/core_runtime.h"
+#include "tfrt/gpu/passes/passes.h"
+
+namespace tfrt {
+namespace gpu {
+
+namespace {
+
+// A pass which converts tf.Conv2D ops with f16 or bf16 inputs from NCHW to
+// NHWC layout. The pass transposes the input and output of each convolution,
+// sinks transposes below elementwise ops and removes pairs of transposes which
+// cancel each other.
+//
+// cuDNN transposes NCHW data to NHWC internally to use tensor cores, so the
+// pass should only run for GPUs with tensor cores (compute capability 7.0 and
+// later).
+struct TensorCoreLayoutPass
+    : public PassWrapper<TensorCoreLayoutPass, OperationPass<func::FuncOp>> {
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(TensorCoreLayoutPass)
+
+ private:
+  void runOnOperation() override;
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<corert::CoreRTDialect>();
+  }
+  StringRef getArgument() const final { return "tfrt-gpu-tensor-core-layout"; }
+};
+
+using Permutation = SmallVector<int64_t, 4>;
+
+constexpr int64_t kNchwToNhwc[] = {0, 2, 3, 1};
+constexpr int64_t kNhwcToNchw[] = {0, 3, 1, 2};
+
+// Elementwise ops whose result layout is the layout of their operands, if all
+// operands have the same rank.
+constexpr llvm::StringLiteral kElementwiseOpNames[] = {
+    "tf.Abs",     "tf.Add",     "tf.AddV2",   "tf.Cast",    "tf.Elu",
+    "tf.Exp",     "tf.Log",     "tf.Maximum", "tf.Minimum", "tf.Mul",
+    "tf.Neg",     "tf.RealDiv", "tf.Relu",    "tf.Relu6",   "tf.Rsqrt",
+    "tf.Sigmoid", "tf.Sqrt",    "tf.Square",  "tf.Sub",     "tf.Tanh",
+};
+
+}  // namespace
+
+// Returns the value of the op attribute 'name' of 'op', or null.
+static Attribute GetOpAttr(corert::ExecuteOp op, StringRef name) {
+  for (auto attr : op.getOpAttrs().getAsRange<ArrayAttr>()) {
+    if (attr[0].cast<StringAttr>().getValue() == name) return attr[1];
+  }
+  return nullptr;
+}
+
+// Returns the op attributes of 'op', with the values in 'replacements'.
+static ArrayAttr ReplaceOpAttrs(corert::ExecuteOp op,
+                                ArrayRef<NamedAttribute> replacements) {
+  SmallVector<Attribute, 8> attrs;
+  for (auto attr : op.getOpAttrs().getAsRange<ArrayAttr>()) {
+    auto name = attr[0].cast<StringAttr>();
+    auto it = llvm::find_if(replacements, [&](NamedAttribute replacement) {
+      return replacement.getName() == name;
+    });
+    if (it == replacements.end()) {
+      attrs.push_back(attr);
+      continue;
+    }
+    Attribute key_value[] = {name, it->getValue()};
+    attrs.push_back(ArrayAttr::get(op.getContext(), key_value));
+  }
+  return ArrayAttr::get(op.getContext(), attrs);
+}
+
+// Returns the tensor handle operands of 'op', without the op handler.
+static OperandRange GetTensorOperands(corert::ExecuteOp op) {
+  return op->getOperands().drop_front();
+}
+
+// Creates a copy of 'op' with different operands and op attributes.
+static corert::ExecuteOp CloneExecuteOp(OpBuilder &builder,
+                                        corert::ExecuteOp op,
+                                        ValueRange operands,
+                                        ArrayAttr op_attrs) {
+  return builder.create<corert::ExecuteOp>(
+      op.getLoc(), op->getResultTypes(), op.getOpHandler(), operands, op_attrs,
+      op.getOpFuncAttrs(), op.getOpName());
+}
+
+static Value CreateTranspose(OpBuilder &builder, Location loc,
+                             Value op_handler, Value input,
+                             ArrayRef<int64_t> perm) {
+  SmallVector<int32_t, 4> values(perm.begin(), perm.end());
+  auto type = RankedTensorType::get({static_cast<int64_t>(values.size())},
+                                    builder.getI32Type());
+  std::pair<StringRef, Attribute> op_attrs[] = {
+      {"perm", DenseIntElementsAttr::get(type, llvm::makeArrayRef(values))}};
+  Type result_type = input.getType();
+  return builder
+      .create<corert::ExecuteOp>(loc, TypeRange(result_type), op_handler,
+                                 input, op_attrs,
+                                 ArrayRef<std::pair<StringRef, Attribute>>(),
+                                 "_tf.Transpose")
+      .getResult(0);
+}
+
+// Returns the permutation of 'value' if it is the result of a transpose,
+// otherwise none.
+static llvm::Optional<Permutation> GetTransposePermutation(Value value) {
+  auto op = value.getDefiningOp<corert::ExecuteOp>();
+  if (!op || op.getOpName() != "_tf.Transpose" ||
+      GetTensorOperands(op).size() != 1)
+    return llvm::None;
+  auto perm = GetOpAttr(op, "perm").dyn_cast_or_null<DenseIntElementsAttr>();
+  if (!perm) return llvm::None;
+  Permutation result;
+  for (const APInt &index : perm.getValues<APInt>())
+    result.push_back(index.getSExtValue());
+  return result;
+}
+
+// Returns 'attr', an array with 'group_size' elements per dimension, with the
+// dimensions permuted by 'perm'. Returns null if 'attr' does not match 'perm'.
+static ArrayAttr PermuteArrayAttr(Attribute attr, ArrayRef<int64_t> perm,
+                                  int group_size = 1) {
+  auto array = attr.dyn_cast_or_null<ArrayAttr>();
+  if (!array || array.size() != perm.size() * group_size) return nullptr;
+  SmallVector<Attribute, 8> result;
+  for (auto dim : perm) {
+    auto group = array.getValue().slice(dim * group_size, group_size);
+    result.append(group.begin(), group.end());
+  }
+  return ArrayAttr::get(attr.getContext(), result);
+}
+
+// Converts a half precision NCHW convolution to NHWC. The filter is HWIO in
+// either case.
+static void ConvertConvolutionToNhwc(corert::ExecuteOp op) {
+  if (op.getOpName() != "tf.Conv2D" || GetTensorOperands(op).size() != 2 ||
+      op->getNumResults() != 1)
+    return;
+  auto data_format =
+      GetOpAttr(op, "data_format").dyn_cast_or_null<StringAttr>();
+  if (!data_format || data_format.getValue() != "NCHW") return;
+  auto type = GetOpAttr(op, "T").dyn_cast_or_null<TypeAttr>();
+  if (!type || !(type.getValue().isF16() || type.getValue().isBF16())) return;
+
+  OpBuilder builder(op);
+  SmallVector<NamedAttribute, 4> replacements = {
+      builder.getNamedAttr("data_format", builder.getStringAttr("NHWC"))};
+  for (auto name : {"strides", "dilations"}) {
+    auto attr = GetOpAttr(op, name);
+    if (!attr) continue;
+    auto permuted = PermuteArrayAttr(attr, kNchwToNhwc);
+    if (!permuted) return;
+    replacements.push_back(builder.getNamedAttr(name, permuted));
+  }
+  auto paddings =
+      GetOpAttr(op, "explicit_paddings").dyn_cast_or_null<ArrayAttr>();
+  if (paddings && !paddings.empty()) {
+    // Paddings are pairs of before and after padding per dimension.
+    auto permuted = PermuteArrayAttr(paddings, kNchwToNhwc, 2);
+    if (!permuted) return;
+    replacements.push_back(builder.getNamedAttr("explicit_paddings", permuted));
+  }
+
+  auto loc = op.getLoc();
+  auto op_handler = op.getOpHandler();
+  auto operands = GetTensorOperands(op);
+  Value input =
+      CreateTranspose(builder, loc, op_handler, operands[0], kNchwToNhwc);
+  auto conv_op = CloneExecuteOp(builder, op, {input, operands[1]},
+                                ReplaceOpAttrs(op, replacements));
+  Value output = CreateTranspose(builder, loc, op_handler,
+                                 conv_op.getResult(0), kNhwcToNchw);
+  op.getResult(0).replaceAllUsesWith(output);
+  op.erase();
+}
+
+// Replaces transpose(transpose(x)) with x if the permutations are inverse.
+static bool CancelTransposes(corert::ExecuteOp op) {
+  if (op->getNumResults() != 1) return false;
+  auto outer = GetTransposePermutation(op.getResult(0));
+  if (!outer) return false;
+  auto operand = GetTensorOperands(op).front();
+  auto inner = GetTransposePermutation(operand);
+  if (!inner || inner->size() != outer->size()) return false;
+  auto inner_op = operand.getDefiningOp<corert::ExecuteOp>();
+  if (inner_op.getOpHandler() != op.getOpHandler()) return false;
+  for (int64_t i = 0, e = outer->size(); i < e; ++i) {
+    if ((*inner)[(*outer)[i]] != i) return false;
+  }
+  op.getResult(0).replaceAllUsesWith(GetTensorOperands(inner_op).front());
+  op.erase();
+  if (inner_op.use_empty()) inner_op.erase();
+  return true;
+}
+
+// Replaces elementwise(transpose(x), transpose(y)) with
+// transpose(elementwise(x, y)), so that the transpose can cancel with a later
+// one. Similarly moves an NHWC to NCHW transpose below tf.BiasAdd.
+static bool SinkTransposes(corert::ExecuteOp op) {
+  if (op->getNumResults() != 1) return false;
+  auto operands = GetTensorOperands(op);
+  if (operands.empty()) return false;
+
+  bool is_bias_add = op.getOpName() == "tf.BiasAdd";
+  if (is_bias_add) {
+    auto data_format =
+        GetOpAttr(op, "data_format").dyn_cast_or_null<StringAttr>();
+    if (!data_format || data_format.getValue() != "NCHW") return false;
+    // Only the value is transposed, the bias is a vector.
+    operands = operands.take_front();
+  } else if (!llvm::is_contained(kElementwiseOpNames, op.getOpName())) {
+    return false;
+  }
+
+  llvm::Optional<Permutation> perm;
+  for (auto operand : operands) {
+    auto operand_perm = GetTransposePermutation(operand);
+    if (!operand_perm || (perm && *perm != *operand_perm)) return false;
+    perm = std::move(operand_perm);
+    auto transpose_op = operand.getDefiningOp<corert::ExecuteOp>();
+    if (transpose_op.getOpHandler() != op.getOpHandler()) return false;
+    // Don't duplicate transposes which are used elsewhere.
+    if (llvm::any_of(transpose_op->getUsers(),
+                     [&](Operation *user) { return user != op; }))
+      return false;
+  }
+  if (is_bias_add &&
+      llvm::makeArrayRef(*perm) != llvm::makeArrayRef(kNhwcToNchw))
+    return false;
+
+  // Replace the transposed operands with the transpose inputs.
+  SmallVector<Value, 4> new_operands(GetTensorOperands(op));
+  for (auto operand : llvm::enumerate(operands)) {
+    auto transpose_op = operand.value().getDefiningOp<corert::ExecuteOp>();
+    new_operands[operand.index()] = GetTensorOperands(transpose_op).front();
+  }
+  OpBuilder builder(op);
+  auto op_attrs = op.getOpAttrs();
+  if (is_bias_add) {
+    op_attrs = ReplaceOpAttrs(
+        op, builder.getNamedAttr("data_format", builder.getStringAttr("NHWC")));
+  }
+  auto new_op = CloneExecuteOp(builder, op, new_operands, op_attrs);
+  Value output = CreateTranspose(builder, op.getLoc(), op.getOpHandler(),
+                                 new_op.getResult(0), *perm);
+
+  SmallVector<Operation *, 2> transpose_ops;
+  for (auto operand : operands) {
+    // Both operands may be the same transpose.
+    if (!llvm::is_contained(transpose_ops, operand.getDefiningOp()))
+      transpose_ops.push_back(operand.getDefiningOp());
+  }
+  op.getResult(0).replaceAllUsesWith(output);
+  op.erase();
+  for (auto *transpose_op : transpose_ops) {
+    if (transpose_op->use_empty()) transpose_op->erase();
+  }
+  return true;
+}
+
+void TensorCoreLayoutPass::runOnOperation() {
+  SmallVector<corert::ExecuteOp, 8> ops;
+  getOperation().walk([&](corert::ExecuteOp op) { ops.push_back(op); });
+  for (auto op : ops) ConvertConvolutionToNhwc(op);
+
+  // Every rewrite removes a transpose or moves one closer to the results, so
+  // this reaches a fixed point. The walk is restarted after each rewrite
+  // because rewrites erase ops.
+  while (getOperation()
+             .walk([&](corert::ExecuteOp op) {
+               if (CancelTransposes(op) || SinkTransposes(op))
+                 return WalkResult::interrupt();
+               return WalkResult::advance();
+             })
+             .wasInterrupted()) {
+  }
+}
+
+std::unique_ptr<OperationPass<func::FuncOp>> CreateTensorCoreLayoutPass() {
+  return std::make_unique<TensorCoreLayoutPass>();
+}
+
+}  // namespace gpu
+}  // namespace tfrt
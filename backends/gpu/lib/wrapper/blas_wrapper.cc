@@ -23,6 +23,7 @@
 #include "tfrt/gpu/wrapper/cublas_wrapper.h"
 #include "tfrt/gpu/wrapper/rocblas_stub.h"
 #include "tfrt/gpu/wrapper/rocblas_wrapper.h"
+#include "tfrt/gpu/wrapper/rocsolver_wrapper.h"
 #include "wrapper_detail.h"
 
 namespace tfrt {
@@ -225,6 +226,23 @@ llvm::Error BlasTrsmBatched(CurrentContext current, BlasHandle handle,
   }
 }
 
+llvm::Error BlasGetrfBatched(CurrentContext current, BlasHandle handle,
+                             BlasDataType dataType, int n, Pointer<void*> A,
+                             int lda, Pointer<int> pivotArray,
+                             Pointer<int> infoArray, int batchCount) {
+  auto platform = handle.platform();
+  switch (platform) {
+    case Platform::CUDA:
+      return CublasGetrfBatched(current, handle, dataType, n, A, lda,
+                                pivotArray, infoArray, batchCount);
+    case Platform::ROCm:
+      return RocsolverGetrfBatched(current, handle, dataType, n, A, lda,
+                                   pivotArray, infoArray, batchCount);
+    default:
+      return InvalidPlatform(platform);
+  }
+}
+
 }  // namespace wrapper
 }  // namespace gpu
 }  // namespace tfrt
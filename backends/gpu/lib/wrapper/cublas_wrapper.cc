@@ -176,6 +176,34 @@ llvm::Error CublasTrsmBatched(CurrentContext current, cublasHandle_t handle,
   }
 }
 
+llvm::Error CublasGetrfBatched(CurrentContext current, cublasHandle_t handle,
+                               cudaDataType dataType, int n,
+                               Pointer<void*> Aarray, int lda,
+                               Pointer<int> pivotArray, Pointer<int> infoArray,
+                               int batchSize) {
+  CheckCudaContext(current);
+  switch (dataType) {
+    case CUDA_R_32F:
+      return TO_ERROR(cublasSgetrfBatched(
+          handle, n, reinterpret_cast<float* const*>(ToCuda(Aarray)), lda,
+          ToCuda(pivotArray), ToCuda(infoArray), batchSize));
+    case CUDA_C_32F:
+      return TO_ERROR(cublasCgetrfBatched(
+          handle, n, reinterpret_cast<cuComplex* const*>(ToCuda(Aarray)), lda,
+          ToCuda(pivotArray), ToCuda(infoArray), batchSize));
+    case CUDA_R_64F:
+      return TO_ERROR(cublasDgetrfBatched(
+          handle, n, reinterpret_cast<double* const*>(ToCuda(Aarray)), lda,
+          ToCuda(pivotArray), ToCuda(infoArray), batchSize));
+    case CUDA_C_64F:
+      return TO_ERROR(cublasZgetrfBatched(
+          handle, n, reinterpret_cast<cuDoubleComplex* const*>(ToCuda(Aarray)),
+          lda, ToCuda(pivotArray), ToCuda(infoArray), batchSize));
+    default:
+      return MakeStringError("Unsupported data type: ", Printed(dataType));
+  }
+}
+
 }  // namespace wrapper
 }  // namespace gpu
 }  // namespace tfrt
@@ -356,6 +356,16 @@ llvm::Error CuStreamWaitEvent(CUstream stream, CUevent event) {
   return TO_ERROR(cuStreamWaitEvent(stream, event, /*flags=*/0));
 }
 
+llvm::Error CuStreamBeginCapture(CUstream stream, CUstreamCaptureMode mode) {
+  return TO_ERROR(cuStreamBeginCapture(stream, mode));
+}
+
+llvm::Expected<OwningGraph> CuStreamEndCapture(CUstream stream) {
+  CUgraph graph;
+  RETURN_IF_ERROR(cuStreamEndCapture(stream, &graph));
+  return OwningGraph(graph);
+}
+
 llvm::Expected<OwningEvent> CuEventCreate(CurrentContext current,
                                           CUevent_flags flags) {
   CheckCudaContext(current);
@@ -699,6 +709,40 @@ llvm::Error CuLaunchCooperativeKernel(
       const_cast<void**>(arguments.data())));
 }
 
+llvm::Error CuGraphDestroy(CUgraph graph) {
+  if (graph == nullptr) return llvm::Error::success();
+  return TO_ERROR(cuGraphDestroy(graph));
+}
+
+llvm::Expected<OwningGraphExec> CuGraphInstantiate(CurrentContext current,
+                                                   CUgraph graph) {
+  CheckCudaContext(current);
+  CUgraphExec graph_exec;
+  RETURN_IF_ERROR(cuGraphInstantiate(&graph_exec, graph, /*phErrorNode=*/nullptr,
+                                     /*logBuffer=*/nullptr,
+                                     /*bufferSize=*/0));
+  return OwningGraphExec(graph_exec);
+}
+
+llvm::Error CuGraphExecDestroy(CUgraphExec graph_exec) {
+  if (graph_exec == nullptr) return llvm::Error::success();
+  return TO_ERROR(cuGraphExecDestroy(graph_exec));
+}
+
+llvm::Expected<bool> CuGraphExecUpdate(CUgraphExec graph_exec, CUgraph graph) {
+  CUgraphNode error_node;
+  CUgraphExecUpdateResult update_result;
+  auto result =
+      cuGraphExecUpdate(graph_exec, graph, &error_node, &update_result);
+  if (result == CUDA_ERROR_GRAPH_EXEC_UPDATE_FAILURE) return false;
+  RETURN_IF_ERROR(result);
+  return true;
+}
+
+llvm::Error CuGraphLaunch(CUgraphExec graph_exec, CUstream stream) {
+  return TO_ERROR(cuGraphLaunch(graph_exec, stream));
+}
+
 llvm::Expected<int> CuOccupancyMaxActiveBlocksPerMultiprocessor(
     CurrentContext current, CUfunction function, int block_size,
     size_t dynamic_shared_memory_size) {
@@ -15,8 +15,18 @@
 // Thin abstraction layer for CUDA and HIP driver API.
 #include "tfrt/gpu/wrapper/driver_wrapper.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include "tfrt/gpu/wrapper/cuda_wrapper.h"
 #include "tfrt/gpu/wrapper/hip_wrapper.h"
 #include "tfrt/gpu/wrapper/hiprtc_wrapper.h"
@@ -120,6 +130,12 @@ void internal::StreamDeleter::operator()(Stream stream) const {
 void internal::EventDeleter::operator()(Event event) const {
   LogIfError(EventDestroy(event));
 }
+void internal::GraphDeleter::operator()(Graph graph) const {
+  LogIfError(GraphDestroy(graph));
+}
+void internal::GraphExecDeleter::operator()(GraphExec graph_exec) const {
+  LogIfError(GraphExecDestroy(graph_exec));
+}
 void internal::DeviceMemoryDeallocator::operator()(
     Pointer<void> pointer) const {
   LogIfError(MemFree(pointer));
@@ -495,6 +511,30 @@ llvm::Error StreamWaitEvent(Stream stream, Event event) {
   }
 }
 
+llvm::Error StreamBeginCapture(Stream stream) {
+  auto platform = stream.platform();
+  switch (platform) {
+    case Platform::CUDA:
+      return CuStreamBeginCapture(stream, CU_STREAM_CAPTURE_MODE_RELAXED);
+    case Platform::ROCm:
+      return HipStreamBeginCapture(stream, hipStreamCaptureModeRelaxed);
+    default:
+      return InvalidPlatform(platform);
+  }
+}
+
+llvm::Expected<OwningGraph> StreamEndCapture(Stream stream) {
+  auto platform = stream.platform();
+  switch (platform) {
+    case Platform::CUDA:
+      return CuStreamEndCapture(stream);
+    case Platform::ROCm:
+      return HipStreamEndCapture(stream);
+    default:
+      return InvalidPlatform(platform);
+  }
+}
+
 llvm::Expected<OwningEvent> EventCreate(CurrentContext current,
                                         EventFlags flags) {
   auto platform = current.platform();
@@ -846,14 +886,84 @@ llvm::Error MemsetD32Async(CurrentContext current, Pointer<void> dst,
   }
 }
 
+// Returns the file which caches the compiled code of 'src' for the current
+// device, or an empty string if the TFRT_GPU_MODULE_CACHE_DIR environment
+// variable is not set.
+static std::string GetCompiledCodePath(CurrentContext current,
+                                       llvm::StringRef src) {
+  const char* dir = std::getenv("TFRT_GPU_MODULE_CACHE_DIR");
+  if (dir == nullptr || *dir == '\0') return {};
+  auto props = HipGetDeviceProperties(current);
+  if (!props) {
+    LogIfError(props.takeError());
+    return {};
+  }
+  auto version = HiprtcGetVersion();
+  if (!version) {
+    LogIfError(version.takeError());
+    return {};
+  }
+  // The architecture name includes target features, e.g. 'gfx90a:xnack-'.
+  std::string arch = props->gcnArchName;
+  std::replace(arch.begin(), arch.end(), ':', '_');
+  llvm::SmallString<128> path(dir);
+  llvm::sys::path::append(
+      path, llvm::formatv("{0:x-}_{1}_hiprtc{2}.{3}.{4}.hsaco",
+                          llvm::xxHash64(src), arch, version->major,
+                          version->minor, version->patch)
+                .str());
+  return std::string(path);
+}
+
+// Writes 'code' to 'path' through a temporary file, so that concurrent
+// processes never read a partially written file.
+static llvm::Error WriteCompiledCode(llvm::StringRef path,
+                                     llvm::StringRef code) {
+  int fd;
+  llvm::SmallString<128> temp_path;
+  if (auto error = llvm::sys::fs::createUniqueFile(path + ".tmp-%%%%%%", fd,
+                                                    temp_path)) {
+    return llvm::errorCodeToError(error);
+  }
+  {
+    llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+    os << code;
+    os.close();
+    if (os.has_error()) {
+      llvm::sys::fs::remove(temp_path);
+      return llvm::errorCodeToError(os.error());
+    }
+  }
+  if (auto error = llvm::sys::fs::rename(temp_path, path)) {
+    llvm::sys::fs::remove(temp_path);
+    return llvm::errorCodeToError(error);
+  }
+  return llvm::Error::success();
+}
+
+// Compiles the HIP source 'src' with hiprtc and loads the result. The compiled
+// code is cached on disk if the TFRT_GPU_MODULE_CACHE_DIR environment variable
+// names a directory.
 static llvm::Expected<OwningModule> CompileProgram(CurrentContext current,
                                                    const void* src) {
+  std::string path =
+      GetCompiledCodePath(current, static_cast<const char*>(src));
+  if (!path.empty()) {
+    if (auto buffer = llvm::MemoryBuffer::getFile(path)) {
+      auto module = HipModuleLoadData(current, (*buffer)->getBufferStart());
+      if (module) return module;
+      // Fall back to compiling, which overwrites the stale file.
+      LogIfError(module.takeError());
+    }
+  }
+
   auto program = HiprtcCreateProgram(static_cast<const char*>(src));
   if (!program) return program.takeError();
   if (auto err = HiprtcCompileProgram(program->get(), /*options=*/{}))
     return std::move(err);
   auto code = HiprtcGetCode(program->get());
   if (!code) return code.takeError();
+  if (!path.empty()) LogIfError(WriteCompiledCode(path, *code));
   return HipModuleLoadData(current, code->data());
 }
 
@@ -1111,6 +1221,67 @@ llvm::Error LaunchCooperativeKernel(CurrentContext current, Function function,
   }
 }
 
+llvm::Error GraphDestroy(Graph graph) {
+  auto platform = graph.platform();
+  switch (platform) {
+    case Platform::CUDA:
+      return CuGraphDestroy(graph);
+    case Platform::ROCm:
+      return HipGraphDestroy(graph);
+    default:
+      return llvm::Error::success();
+  }
+}
+
+llvm::Expected<OwningGraphExec> GraphInstantiate(CurrentContext current,
+                                                 Graph graph) {
+  auto platform = current.platform();
+  switch (platform) {
+    case Platform::CUDA:
+      return CuGraphInstantiate(current, graph);
+    case Platform::ROCm:
+      return HipGraphInstantiate(current, graph);
+    default:
+      return InvalidPlatform(platform);
+  }
+}
+
+llvm::Error GraphExecDestroy(GraphExec graph_exec) {
+  auto platform = graph_exec.platform();
+  switch (platform) {
+    case Platform::CUDA:
+      return CuGraphExecDestroy(graph_exec);
+    case Platform::ROCm:
+      return HipGraphExecDestroy(graph_exec);
+    default:
+      return llvm::Error::success();
+  }
+}
+
+llvm::Expected<bool> GraphExecUpdate(GraphExec graph_exec, Graph graph) {
+  auto platform = graph_exec.platform();
+  switch (platform) {
+    case Platform::CUDA:
+      return CuGraphExecUpdate(graph_exec, graph);
+    case Platform::ROCm:
+      return HipGraphExecUpdate(graph_exec, graph);
+    default:
+      return InvalidPlatform(platform);
+  }
+}
+
+llvm::Error GraphLaunch(GraphExec graph_exec, Stream stream) {
+  auto platform = graph_exec.platform();
+  switch (platform) {
+    case Platform::CUDA:
+      return CuGraphLaunch(graph_exec, stream);
+    case Platform::ROCm:
+      return HipGraphLaunch(graph_exec, stream);
+    default:
+      return InvalidPlatform(platform);
+  }
+}
+
 llvm::Expected<int> OccupancyMaxActiveBlocksPerMultiprocessor(
     CurrentContext current, Function function, int block_size,
     size_t dynamic_shared_memory_size) {
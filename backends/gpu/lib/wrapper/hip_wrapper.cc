@@ -343,6 +343,17 @@ llvm::Error HipStreamWaitEvent(hipStream_t stream, hipEvent_t event) {
   return TO_ERROR(hipStreamWaitEvent(stream, event, /*flags=*/0));
 }
 
+llvm::Error HipStreamBeginCapture(hipStream_t stream,
+                                  hipStreamCaptureMode mode) {
+  return TO_ERROR(hipStreamBeginCapture(stream, mode));
+}
+
+llvm::Expected<OwningGraph> HipStreamEndCapture(hipStream_t stream) {
+  hipGraph_t graph;
+  RETURN_IF_ERROR(hipStreamEndCapture(stream, &graph));
+  return OwningGraph(graph);
+}
+
 llvm::Expected<OwningEvent> HipEventCreate(CurrentContext current,
                                            hipEventFlags_t flags) {
   CheckHipContext(current);
@@ -610,6 +621,42 @@ llvm::Error HipLaunchCooperativeKernel(
       shared_memory_size_bytes, stream));
 }
 
+llvm::Error HipGraphDestroy(hipGraph_t graph) {
+  if (graph == nullptr) return llvm::Error::success();
+  return TO_ERROR(hipGraphDestroy(graph));
+}
+
+llvm::Expected<OwningGraphExec> HipGraphInstantiate(CurrentContext current,
+                                                    hipGraph_t graph) {
+  CheckHipContext(current);
+  hipGraphExec_t graph_exec;
+  RETURN_IF_ERROR(hipGraphInstantiate(&graph_exec, graph,
+                                      /*pErrorNode=*/nullptr,
+                                      /*pLogBuffer=*/nullptr,
+                                      /*bufferSize=*/0));
+  return OwningGraphExec(graph_exec);
+}
+
+llvm::Error HipGraphExecDestroy(hipGraphExec_t graph_exec) {
+  if (graph_exec == nullptr) return llvm::Error::success();
+  return TO_ERROR(hipGraphExecDestroy(graph_exec));
+}
+
+llvm::Expected<bool> HipGraphExecUpdate(hipGraphExec_t graph_exec,
+                                        hipGraph_t graph) {
+  hipGraphNode_t error_node;
+  hipGraphExecUpdateResult update_result;
+  auto result =
+      hipGraphExecUpdate(graph_exec, graph, &error_node, &update_result);
+  if (result == hipErrorGraphExecUpdateFailure) return false;
+  RETURN_IF_ERROR(result);
+  return true;
+}
+
+llvm::Error HipGraphLaunch(hipGraphExec_t graph_exec, hipStream_t stream) {
+  return TO_ERROR(hipGraphLaunch(graph_exec, stream));
+}
+
 llvm::Expected<int> HipOccupancyMaxActiveBlocksPerMultiprocessor(
     CurrentContext current, hipFunction_t function, int block_size,
     size_t dynamic_shared_memory_size) {
@@ -104,6 +104,38 @@ llvm::Error RocsolverPotrfBatched(CurrentContext current, rocblas_handle handle,
   }
 }
 
+llvm::Error RocsolverGetrfBatched(CurrentContext current, rocblas_handle handle,
+                                  rocblas_datatype dataType, int n,
+                                  Pointer<void*> Aarray, int heightA,
+                                  Pointer<int> pivotArray, Pointer<int> devInfo,
+                                  int batchSize) {
+  CheckHipContext(current);
+  // The pivots of consecutive matrices are n elements apart.
+  rocblas_stride pivot_stride = n;
+  switch (dataType) {
+    case rocblas_datatype_f32_r:
+      return TO_ERROR(rocsolver_sgetrf_batched(
+          handle, n, n, reinterpret_cast<float**>(ToRocm(Aarray)), heightA,
+          ToRocm(pivotArray), pivot_stride, ToRocm(devInfo), batchSize));
+    case rocblas_datatype_f32_c:
+      return TO_ERROR(rocsolver_cgetrf_batched(
+          handle, n, n,
+          reinterpret_cast<rocblas_float_complex**>(ToRocm(Aarray)), heightA,
+          ToRocm(pivotArray), pivot_stride, ToRocm(devInfo), batchSize));
+    case rocblas_datatype_f64_r:
+      return TO_ERROR(rocsolver_dgetrf_batched(
+          handle, n, n, reinterpret_cast<double**>(ToRocm(Aarray)), heightA,
+          ToRocm(pivotArray), pivot_stride, ToRocm(devInfo), batchSize));
+    case rocblas_datatype_f64_c:
+      return TO_ERROR(rocsolver_zgetrf_batched(
+          handle, n, n,
+          reinterpret_cast<rocblas_double_complex**>(ToRocm(Aarray)), heightA,
+          ToRocm(pivotArray), pivot_stride, ToRocm(devInfo), batchSize));
+    default:
+      return MakeStringError("Unsupported type: ", Printed(dataType));
+  }
+}
+
 }  // namespace wrapper
 }  // namespace gpu
 }  // namespace tfrt
@@ -0,0 +1,100 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_gpu_opt %s -tfrt-gpu-plan-memory | FileCheck %s
+
+// CHECK-LABEL: @reuse_deallocated_memory
+func.func @reuse_deallocated_memory(
+  %arg0 : !tfrt.chain,
+  %arg1 : !tfrt_gpu.stream
+) -> !tfrt.chain {
+  %ctx = tfrt_gpu.stream.get_context %arg1
+  %allocator = tfrt_gpu.allocator.create %ctx
+  %value = tfrt.constant.i32 0
+  %size0 = tfrt.constant.i64 1000
+  %size1 = tfrt.constant.i64 2048
+
+  // CHECK: %[[slab_size:.*]] = tfrt.constant.i64 2048
+  // CHECK: %[[slab:.*]] = tfrt_gpu.mem.allocate
+  // CHECK-SAME: %arg1, %[[slab_size]], %arg0
+  // CHECK: %[[offset0:.*]] = tfrt.constant.ui64 0
+  // CHECK: %[[size0:.*]] = tfrt.constant.ui64 1000
+  // CHECK: %[[view0:.*]] = tfrt_gpu.mem.view %[[slab]], %[[offset0]], %[[size0]]
+  // CHECK: %[[buffer0:.*]] = tfrt_gpu.alias %[[view0]], %arg0
+  %buffer0 = tfrt_gpu.mem.allocate %allocator, %arg1, %size0, %arg0
+  // CHECK: %[[ch1:.*]] = tfrt_gpu.mem.set %[[buffer0]]
+  %ch1 = tfrt_gpu.mem.set %buffer0, %value, %arg1, %arg0 : i32
+  // CHECK-NOT: tfrt_gpu.mem.deallocate %[[buffer0]]
+  %ch2 = tfrt_gpu.mem.deallocate %buffer0, %arg1, %ch1
+
+  // CHECK: %[[offset1:.*]] = tfrt.constant.ui64 0
+  // CHECK: %[[size1:.*]] = tfrt.constant.ui64 2048
+  // CHECK: %[[view1:.*]] = tfrt_gpu.mem.view %[[slab]], %[[offset1]], %[[size1]]
+  // CHECK: %[[buffer1:.*]] = tfrt_gpu.alias %[[view1]], %[[ch1]]
+  %buffer1 = tfrt_gpu.mem.allocate %allocator, %arg1, %size1, %ch2
+  // CHECK: %[[ch3:.*]] = tfrt_gpu.mem.set %[[buffer1]], {{.*}}, %[[ch1]]
+  %ch3 = tfrt_gpu.mem.set %buffer1, %value, %arg1, %ch2 : i32
+  // CHECK: %[[ch4:.*]] = tfrt.merge.chains %[[ch1]], %[[ch3]]
+  // CHECK: %[[ch5:.*]] = tfrt_gpu.mem.deallocate %[[slab]], %arg1, %[[ch4]]
+  %ch4 = tfrt_gpu.mem.deallocate %buffer1, %arg1, %ch3
+
+  // CHECK: tfrt.return %[[ch5]] : !tfrt.chain
+  tfrt.return %ch4 : !tfrt.chain
+}
+
+// CHECK-LABEL: @separate_live_buffers
+func.func @separate_live_buffers(
+  %arg0 : !tfrt.chain,
+  %arg1 : !tfrt_gpu.stream
+) -> !tfrt.chain {
+  %ctx = tfrt_gpu.stream.get_context %arg1
+  %allocator = tfrt_gpu.allocator.create %ctx
+  %size0 = tfrt.constant.i64 100
+  %size1 = tfrt.constant.i64 1024
+
+  // CHECK: %[[slab_size:.*]] = tfrt.constant.i64 1124
+  // CHECK: %[[slab:.*]] = tfrt_gpu.mem.allocate
+  // CHECK: tfrt.constant.ui64 1024
+  // CHECK: tfrt.constant.ui64 100
+  %buffer0 = tfrt_gpu.mem.allocate %allocator, %arg1, %size0, %arg0
+  // CHECK: tfrt.constant.ui64 0
+  // CHECK: tfrt.constant.ui64 1024
+  %buffer1 = tfrt_gpu.mem.allocate %allocator, %arg1, %size1, %arg0
+  %ch0 = tfrt_gpu.mem.copy %buffer1, %buffer0, %arg1, %arg0
+    : !tfrt_gpu.buffer, !tfrt_gpu.buffer
+  %ch1 = tfrt_gpu.mem.deallocate %buffer0, %arg1, %ch0
+  %ch2 = tfrt_gpu.mem.deallocate %buffer1, %arg1, %ch0
+  // CHECK: tfrt_gpu.mem.deallocate %[[slab]]
+  %ch3 = tfrt.merge.chains %ch1, %ch2 : !tfrt.chain, !tfrt.chain
+  tfrt.return %ch3 : !tfrt.chain
+}
+
+// CHECK-LABEL: @keep_returned_buffer
+func.func @keep_returned_buffer(
+  %arg0 : !tfrt.chain,
+  %arg1 : !tfrt_gpu.stream
+) -> !tfrt_gpu.buffer {
+  %ctx = tfrt_gpu.stream.get_context %arg1
+  %allocator = tfrt_gpu.allocator.create %ctx
+  %size = tfrt.constant.i64 64
+  // CHECK-NOT: tfrt_gpu.mem.view
+  // CHECK: %[[buffer0:.*]] = tfrt_gpu.mem.allocate
+  %buffer0 = tfrt_gpu.mem.allocate %allocator, %arg1, %size, %arg0
+  // CHECK: %[[buffer1:.*]] = tfrt_gpu.mem.allocate
+  %buffer1 = tfrt_gpu.mem.allocate %allocator, %arg1, %size, %arg0
+  // CHECK: tfrt_gpu.mem.deallocate %[[buffer0]]
+  %ch0 = tfrt_gpu.mem.deallocate %buffer0, %arg1, %arg0
+  // CHECK: tfrt.return %[[buffer1]]
+  tfrt.return %buffer1 : !tfrt_gpu.buffer
+}
@@ -160,6 +160,11 @@ func.func @blas_ops() {
   %ch4 = tfrt_gpu.blas.trsm.batch %blas, %stream, CUBLAS_SIDE_LEFT,
     CUBLAS_FILL_MODE_LOWER, CUBLAS_OP_N, CUBLAS_DIAG_UNIT, %stride, %stride,
     CUDA_R_32F, %alpha, %buffer, %stride, %buffer, %stride, %stride, %ch3
+  // CHECK: tfrt_gpu.blas.getrf.batch %[[blas]], %[[stream]], %[[stride]],
+  // CHECK-SAME: CUDA_R_32F, %[[buffer]], %[[stride]], %[[buffer]], %[[buffer]],
+  // CHECK-SAME: %[[stride]], %{{.*}}
+  %ch6 = tfrt_gpu.blas.getrf.batch %blas, %stream, %stride, CUDA_R_32F,
+    %buffer, %stride, %buffer, %buffer, %stride, %ch4
 
   // CHECK: tfrt_gpu.blas.scal %[[blas]], %[[stream]], %[[width]], %[[alpha]],
   // CHECK-SAME: CUDA_R_32F, %[[buffer]], CUDA_R_32F, %[[stride]], CUDA_R_32F,
@@ -397,6 +402,8 @@ func.func @ccl_ops() {
   %ch6 = tfrt_gpu.ccl.all_to_all %ccl, %buffer, %buffer, ncclFloat32, %ch5
   // CHECK: tfrt_gpu.ccl.execute %[[stream]], %[[ccl]], %{{.*}}
   %ch7 = tfrt_gpu.ccl.execute %stream, %ccl, %ch6
+  // CHECK: tfrt_gpu.ccl.execute_async %[[stream]], %[[ccl]], %{{.*}}
+  %event = tfrt_gpu.ccl.execute_async %stream, %ccl, %ch7
 
   tfrt.return
 }
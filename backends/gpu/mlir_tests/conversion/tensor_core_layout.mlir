@@ -0,0 +1,86 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_gpu_opt %s -tfrt-gpu-tensor-core-layout | FileCheck %s
+
+// CHECK-LABEL: @conv_relu_conv
+func.func @conv_relu_conv(
+  %gpu : !corert.ophandler,
+  %input : !corert.tensorhandle,
+  %filter : !corert.tensorhandle
+) -> !corert.tensorhandle {
+  // CHECK: %[[in:.*]] = corert.executeop(%arg0) "_tf.Transpose"(%arg1)
+  // CHECK-SAME: perm = dense<[0, 2, 3, 1]> : tensor<4xi32>
+  // CHECK: %[[conv0:.*]] = corert.executeop(%arg0) "tf.Conv2D"(%[[in]], %arg2)
+  // CHECK-SAME: data_format = "NHWC"
+  // CHECK-SAME: dilations = [1, 1, 1, 1]
+  // CHECK-SAME: explicit_paddings = [0, 0, 1, 1, 2, 2, 0, 0]
+  // CHECK-SAME: strides = [1, 2, 2, 1]
+  %conv0 = corert.executeop(%gpu) "tf.Conv2D"(%input, %filter)
+      {T = f16, data_format = "NCHW", dilations = [1, 1, 1, 1],
+       explicit_paddings = [0, 0, 0, 0, 1, 1, 2, 2], padding = "EXPLICIT",
+       strides = [1, 1, 2, 2]} : 1
+  // CHECK: %[[bias:.*]] = corert.executeop(%arg0) "tf.BiasAdd"(%[[conv0]], %arg2)
+  // CHECK-SAME: data_format = "NHWC"
+  %bias = corert.executeop(%gpu) "tf.BiasAdd"(%conv0, %filter)
+      {T = f16, data_format = "NCHW"} : 1
+  // CHECK: %[[relu:.*]] = corert.executeop(%arg0) "tf.Relu"(%[[bias]])
+  %relu = corert.executeop(%gpu) "tf.Relu"(%bias) {T = f16} : 1
+  // CHECK: %[[conv1:.*]] = corert.executeop(%arg0) "tf.Conv2D"(%[[relu]], %arg2)
+  // CHECK-SAME: data_format = "NHWC"
+  %conv1 = corert.executeop(%gpu) "tf.Conv2D"(%relu, %filter)
+      {T = f16, data_format = "NCHW", padding = "SAME",
+       strides = [1, 1, 1, 1]} : 1
+  // CHECK: %[[add:.*]] = corert.executeop(%arg0) "tf.AddV2"(%[[conv1]], %[[relu]])
+  %add = corert.executeop(%gpu) "tf.AddV2"(%conv1, %relu) {T = f16} : 1
+  // CHECK: %[[out:.*]] = corert.executeop(%arg0) "_tf.Transpose"(%[[add]])
+  // CHECK-SAME: perm = dense<[0, 3, 1, 2]> : tensor<4xi32>
+  // CHECK-NOT: "_tf.Transpose"
+  // CHECK: tfrt.return %[[out]]
+  tfrt.return %add : !corert.tensorhandle
+}
+
+// CHECK-LABEL: @conv_f32
+func.func @conv_f32(
+  %gpu : !corert.ophandler,
+  %input : !corert.tensorhandle,
+  %filter : !corert.tensorhandle
+) -> !corert.tensorhandle {
+  // CHECK-NOT: "_tf.Transpose"
+  // CHECK: "tf.Conv2D"(%arg1, %arg2)
+  // CHECK-SAME: data_format = "NCHW"
+  %conv = corert.executeop(%gpu) "tf.Conv2D"(%input, %filter)
+      {T = f32, data_format = "NCHW", padding = "SAME",
+       strides = [1, 1, 1, 1]} : 1
+  tfrt.return %conv : !corert.tensorhandle
+}
+
+// CHECK-LABEL: @transpose_with_other_use
+func.func @transpose_with_other_use(
+  %gpu : !corert.ophandler,
+  %input : !corert.tensorhandle,
+  %filter : !corert.tensorhandle
+) -> (!corert.tensorhandle, !corert.tensorhandle) {
+  // CHECK: %[[conv:.*]] = corert.executeop(%arg0) "tf.Conv2D"
+  // CHECK: %[[out:.*]] = corert.executeop(%arg0) "_tf.Transpose"(%[[conv]])
+  %conv = corert.executeop(%gpu) "tf.Conv2D"(%input, %filter)
+      {T = bf16, data_format = "NCHW", padding = "SAME",
+       strides = [1, 1, 1, 1]} : 1
+  // The transpose is not sunk below tf.Relu because the convolution result is
+  // also returned.
+  // CHECK: %[[relu:.*]] = corert.executeop(%arg0) "tf.Relu"(%[[out]])
+  %relu = corert.executeop(%gpu) "tf.Relu"(%conv) : 1
+  // CHECK: tfrt.return %[[out]], %[[relu]]
+  tfrt.return %conv, %relu : !corert.tensorhandle, !corert.tensorhandle
+}
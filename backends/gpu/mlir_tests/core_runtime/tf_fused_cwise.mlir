@@ -0,0 +1,95 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// RUN: bef_executor --test_init_function=register_op_handlers_gpu %s.bef | FileCheck %s --dump-input=always
+
+func.func @register_op_handlers_gpu() {
+  %null = "corert.create_null_op_handler"() : () -> !corert.ophandler
+  %gpu_ordinal = tfrt.constant.i32 0
+  %gpu = "corert.create_gpu_op_handler" (%gpu_ordinal, %null) : (i32, !corert.ophandler) -> !corert.ophandler
+  corert.register_op_handler %gpu "gpu"
+  tfrt.return
+}
+
+// CHECK: --- Running 'fused_cwise_add_relu_mul_f32'
+func.func @fused_cwise_add_relu_mul_f32() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %gpu = corert.get_op_handler %ch_epoch "gpu"
+
+  %operand_0 = corert.executeop(%gpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 3], values = [-1.0 : f32, -0.5 : f32, 0.0 : f32, 0.5 : f32, 1.0 : f32, 1.5 : f32] } : 1
+  %operand_1 = corert.executeop(%gpu) "tfrt_test.create_dense_tensor"()
+    { shape = [2, 3], values = [0.0 : f32, 1.0 : f32, 2.0 : f32, -3.0 : f32, 4.0 : f32, 5.0 : f32] } : 1
+  %operand_2 = corert.executeop(%gpu) "tfrt_test.create_dense_tensor"()
+    { shape = [], values = [2.0 : f32] } : 1
+
+  %gpu_handle_result = corert.executeop(%gpu)
+      "tf._FusedCwise"(%operand_0, %operand_1, %operand_2)
+      { fused_ops = ["AddV2", "Relu", "Mul"] } : 1
+
+  %cpu_handle_result = corert.executeop(%gpu) "tfrt_test.gpu_tensor_to_host_tensor"(%gpu_handle_result) : 1
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 3], values = [0, 1, 4, 0, 10, 13]
+  %ch_print_cpu = corert.executeop.seq(%gpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
+
+// CHECK: --- Running 'fused_cwise_relu_div_sub_f32'
+func.func @fused_cwise_relu_div_sub_f32() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %gpu = corert.get_op_handler %ch_epoch "gpu"
+
+  %operand_0 = corert.executeop(%gpu) "tfrt_test.create_dense_tensor"()
+    { shape = [4], values = [-2.0 : f32, 1.0 : f32, 4.0 : f32, 16.0 : f32] } : 1
+  %operand_1 = corert.executeop(%gpu) "tfrt_test.create_dense_tensor"()
+    { shape = [], values = [4.0 : f32] } : 1
+  %operand_2 = corert.executeop(%gpu) "tfrt_test.create_dense_tensor"()
+    { shape = [4], values = [1.0 : f32, 1.0 : f32, 2.0 : f32, 3.0 : f32] } : 1
+
+  %gpu_handle_result = corert.executeop(%gpu)
+      "tf._FusedCwise"(%operand_0, %operand_1, %operand_2)
+      { fused_ops = ["Relu", "RealDiv", "Sub"] } : 1
+
+  %cpu_handle_result = corert.executeop(%gpu) "tfrt_test.gpu_tensor_to_host_tensor"(%gpu_handle_result) : 1
+  // CHECK: DenseHostTensor dtype = f32, shape = [4], values = [-1, -0.75, -1, 1]
+  %ch_print_cpu = corert.executeop.seq(%gpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
+
+// CHECK: --- Running 'fused_cwise_sqrt_mul_tanh_cached_f32'
+func.func @fused_cwise_sqrt_mul_tanh_cached_f32() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %gpu = corert.get_op_handler %ch_epoch "gpu"
+
+  %operand_0 = corert.executeop(%gpu) "tfrt_test.create_dense_tensor"()
+    { shape = [4], values = [0.0 : f32, 1.0 : f32, 4.0 : f32, 9.0 : f32] } : 1
+  %operand_1 = corert.executeop(%gpu) "tfrt_test.create_dense_tensor"()
+    { shape = [], values = [10.0 : f32] } : 1
+
+  // The second execution reuses the program compiled by the first one.
+  %gpu_handle_result_0 = corert.executeop(%gpu)
+      "tf._FusedCwise"(%operand_0, %operand_1)
+      { fused_ops = ["Sqrt", "Mul", "Tanh"] } : 1
+  %gpu_handle_result_1 = corert.executeop(%gpu)
+      "tf._FusedCwise"(%operand_0, %operand_1)
+      { fused_ops = ["Sqrt", "Mul", "Tanh"] } : 1
+
+  %cpu_handle_result_0 = corert.executeop(%gpu) "tfrt_test.gpu_tensor_to_host_tensor"(%gpu_handle_result_0) : 1
+  %cpu_handle_result_1 = corert.executeop(%gpu) "tfrt_test.gpu_tensor_to_host_tensor"(%gpu_handle_result_1) : 1
+  // CHECK: DenseHostTensor dtype = f32, shape = [4], values = [0, 1, 1, 1]
+  %ch_print_0 = corert.executeop.seq(%gpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result_0) : 0
+  // CHECK: DenseHostTensor dtype = f32, shape = [4], values = [0, 1, 1, 1]
+  %ch_print_1 = corert.executeop.seq(%gpu, %ch_print_0) "tfrt_test.print"(%cpu_handle_result_1) : 0
+  tfrt.return %ch_print_1 : !tfrt.chain
+}
@@ -92,3 +92,84 @@ func.func @mean_inner_reduce_f32() -> !tfrt.chain {
 
   tfrt.return %ch_print_cpu : !tfrt.chain
 }
+
+// CHECK: --- Running 'sum_inner_reduce_f32'
+func.func @sum_inner_reduce_f32() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %gpu = corert.get_op_handler %ch_epoch "gpu"
+
+  %gpu_handle_input = corert.executeop(%gpu) "tfrt_test.create_dense_tensor"()
+  { shape = [2, 4], values = [1.0 : f32, 2.0 : f32, 3.0 : f32, 4.0 : f32,
+                              5.0 : f32, 6.0 : f32, 7.0 : f32, 8.0 : f32] } : 1
+
+  %gpu_handle_result = corert.executeop(%gpu) "_tf.Sum"(%gpu_handle_input)
+  { reduction_indices = dense<[1]> : tensor<1xi32> } : 1
+
+  %cpu_handle_result = corert.executeop(%gpu) "tfrt_test.gpu_tensor_to_host_tensor"(%gpu_handle_result) : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2], values = [10, 26]
+  %ch_print_cpu = corert.executeop.seq(%gpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
+
+// CHECK: --- Running 'max_outer_reduce_f32'
+func.func @max_outer_reduce_f32() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %gpu = corert.get_op_handler %ch_epoch "gpu"
+
+  %gpu_handle_input = corert.executeop(%gpu) "tfrt_test.create_dense_tensor"()
+  { shape = [2, 3], values = [1.0 : f32, 8.0 : f32, -3.0 : f32,
+                              4.0 : f32, 5.0 : f32, -6.0 : f32] } : 1
+
+  %gpu_handle_result = corert.executeop(%gpu) "_tf.Max"(%gpu_handle_input)
+  { reduction_indices = dense<[0]> : tensor<1xi32> } : 1
+
+  %cpu_handle_result = corert.executeop(%gpu) "tfrt_test.gpu_tensor_to_host_tensor"(%gpu_handle_result) : 1
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [3], values = [4, 8, -3]
+  %ch_print_cpu = corert.executeop.seq(%gpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
+
+// CHECK: --- Running 'argmax_inner_f32'
+func.func @argmax_inner_f32() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %gpu = corert.get_op_handler %ch_epoch "gpu"
+
+  %gpu_handle_input = corert.executeop(%gpu) "tfrt_test.create_dense_tensor"()
+  { shape = [2, 3], values = [1.0 : f32, 5.0 : f32, 2.0 : f32,
+                              7.0 : f32, 3.0 : f32, 7.0 : f32] } : 1
+
+  %gpu_handle_result = corert.executeop(%gpu) "_tf.ArgMax"(%gpu_handle_input)
+  { dimension = dense<1> : tensor<i32>, output_type = i32 } : 1
+
+  %cpu_handle_result = corert.executeop(%gpu) "tfrt_test.gpu_tensor_to_host_tensor"(%gpu_handle_result) : 1
+
+  // CHECK: DenseHostTensor dtype = i32, shape = [2], values = [1, 0]
+  %ch_print_cpu = corert.executeop.seq(%gpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
+
+// CHECK: --- Running 'argmin_outer_f32'
+func.func @argmin_outer_f32() -> !tfrt.chain {
+  %ch_epoch = tfrt.new.chain
+  %gpu = corert.get_op_handler %ch_epoch "gpu"
+
+  %gpu_handle_input = corert.executeop(%gpu) "tfrt_test.create_dense_tensor"()
+  { shape = [3, 2], values = [4.0 : f32, 2.0 : f32,
+                              1.0 : f32, 6.0 : f32,
+                              3.0 : f32, 2.0 : f32] } : 1
+
+  %gpu_handle_result = corert.executeop(%gpu) "_tf.ArgMin"(%gpu_handle_input)
+  { dimension = dense<0> : tensor<i32>, output_type = i64 } : 1
+
+  %cpu_handle_result = corert.executeop(%gpu) "tfrt_test.gpu_tensor_to_host_tensor"(%gpu_handle_result) : 1
+
+  // CHECK: DenseHostTensor dtype = i64, shape = [2], values = [1, 0]
+  %ch_print_cpu = corert.executeop.seq(%gpu, %ch_epoch) "tfrt_test.print"(%cpu_handle_result) : 0
+
+  tfrt.return %ch_print_cpu : !tfrt.chain
+}
@@ -0,0 +1,71 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: bef_executor_lite %s.bef -work_queue_type=mstd | FileCheck %s
+
+func.func @all_reduce_async(
+  %rank : i32, %count : i32, %id : !tfrt_gpu.ccl.id
+) -> (!tfrt.chain, !t.tensor, !t.tensor) {
+  %ch0 = tfrt.new.chain
+  %device = tfrt_gpu.device.get CUDA, %rank
+  %context = tfrt_gpu.context.primary %device
+
+  %tensor0 = tfrt_dht.create_uninitialized_tensor.i32.1 [2: i64]
+  %ch1 = tfrt_dht.set_tensor_with_constant_values.i32 %tensor0, %ch0 [1: i32, 2: i32]
+  %buffer0:2 = tfrt_dht.get_buffer %tensor0, %ch0
+  %pinned0 = tfrt_gpu.mem.register %context, %buffer0#0
+
+  %tensor1 = tfrt_dht.create_uninitialized_tensor.i32.1 [1: i64]
+  %ch2 = tfrt_dht.set_tensor_with_constant_values.i32 %tensor1, %ch1 [3: i32]
+  %buffer1:2 = tfrt_dht.get_buffer %tensor1, %ch0
+  %pinned1 = tfrt_gpu.mem.register %context, %buffer1#0
+
+  // Both all-reduces are fused into one bucket.
+  %ccl = tfrt_gpu.ccl.create %context, %rank, %count, %id
+  %ch3 = tfrt_gpu.ccl.all_reduce %ccl, %pinned0, %pinned0, ncclInt32, ncclSum, %ch2
+  %ch4 = tfrt_gpu.ccl.all_reduce %ccl, %pinned1, %pinned1, ncclInt32, ncclSum, %ch3
+
+  %stream = tfrt_gpu.stream.create %context
+  %event = tfrt_gpu.ccl.execute_async %stream, %ccl, %ch4
+  %ch5 = tfrt_gpu.stream.wait %stream, %event, %ch4
+  %ch6 = tfrt_gpu.stream.synchronize %stream, %ch5
+
+  tfrt.return %ch6, %tensor0, %tensor1 : !tfrt.chain, !t.tensor, !t.tensor
+}
+
+// CHECK-LABEL: --- Running 'all_reduce_async_test'
+func.func @all_reduce_async_test() {
+  %count = tfrt.constant.i32 2
+  %id = tfrt_gpu.ccl.unique_id CUDA
+
+  %rank0 = tfrt.constant.i32 0
+  %rank1 = tfrt.constant.i32 1
+
+  %ch0, %t00, %t01 = tfrt.call @all_reduce_async(%rank0, %count, %id)
+      : (i32, i32, !tfrt_gpu.ccl.id) -> (!tfrt.chain, !t.tensor, !t.tensor)
+  %ch1, %t10, %t11 = tfrt.call @all_reduce_async(%rank1, %count, %id)
+      : (i32, i32, !tfrt_gpu.ccl.id) -> (!tfrt.chain, !t.tensor, !t.tensor)
+
+  // CHECK: DenseHostTensor dtype = i32, shape = [2], values = [2, 4]
+  %ch2 = tfrt_dht.print_tensor %t00, %ch0
+  // CHECK: DenseHostTensor dtype = i32, shape = [1], values = [6]
+  %ch3 = tfrt_dht.print_tensor %t01, %ch2
+  %ch4 = tfrt.merge.chains %ch1, %ch3 : !tfrt.chain, !tfrt.chain
+  // CHECK: DenseHostTensor dtype = i32, shape = [2], values = [2, 4]
+  %ch5 = tfrt_dht.print_tensor %t10, %ch4
+  // CHECK: DenseHostTensor dtype = i32, shape = [1], values = [6]
+  %ch6 = tfrt_dht.print_tensor %t11, %ch5
+
+  tfrt.return
+}
@@ -191,3 +191,49 @@ func.func @blas_trsm_batched() {
 
   tfrt.return
 }
+
+// CHECK-LABEL: --- Running 'blas_getrf_batched'
+func.func @blas_getrf_batched() {
+  %ch0 = tfrt.new.chain
+  %ordinal = tfrt.constant.i32 0
+  %device = tfrt_gpu.device.get CUDA, %ordinal
+  %context = tfrt_gpu.context.create %device
+  %allocator = tfrt_gpu.allocator.create %context
+  %stream = tfrt_gpu.stream.create %context
+  %blas = tfrt_gpu.blas.create %context
+
+  %buffer_size_bytes = tfrt.constant.i64 32 // 2 * [2, 2] * 4 bytes floats = 32 bytes
+
+  // Two column-major matrices, the second one is the identity.
+  %host_tensor = tfrt_dht.create_uninitialized_tensor.f32.3 [2 : i64, 2 : i64, 2 : i64]
+  %host_buffer, %ch1 = tfrt_dht.get_buffer %host_tensor, %ch0
+  %ch2 = tfrt_dht.set_tensor_with_constant_values.f32 %host_tensor, %ch1
+    [2.0 : f32, 4.0 : f32, 1.0 : f32, 3.0 : f32, 1.0 : f32, 0.0 : f32, 0.0 : f32, 1.0 : f32]
+  %gpu_buffer = tfrt_gpu.mem.allocate %allocator, %stream, %buffer_size_bytes, %ch2
+  %ch3 = tfrt_gpu.mem.copy %gpu_buffer, %host_buffer, %stream, %ch2 : !tfrt_gpu.buffer, !ht.host_buffer
+
+  %pivots_size_bytes = tfrt.constant.i64 16 // 2 * 2 * 4 bytes ints = 16 bytes
+  %pivots = tfrt_gpu.mem.allocate %allocator, %stream, %pivots_size_bytes, %ch3
+  %devinfo_size_bytes = tfrt.constant.i64 8 // 2 * 4 bytes ints = 8 bytes
+  %devinfo = tfrt_gpu.mem.allocate %allocator, %stream, %devinfo_size_bytes, %ch3
+
+  %dim = tfrt.constant.i32 2
+  %batch_count = tfrt.constant.i32 2
+  %ch4 = tfrt_gpu.blas.getrf.batch %blas, %stream, %dim, CUDA_R_32F,
+    %gpu_buffer, %dim, %pivots, %devinfo, %batch_count, %ch3
+
+  %ch5 = tfrt_gpu.mem.copy %host_buffer, %gpu_buffer, %stream, %ch4 : !ht.host_buffer, !tfrt_gpu.buffer
+
+  %pivots_tensor = tfrt_dht.create_uninitialized_tensor.i32.2 [2 : i64, 2 : i64]
+  %pivots_buffer, %ch6 = tfrt_dht.get_buffer %pivots_tensor, %ch5
+  %ch7 = tfrt_gpu.mem.copy %pivots_buffer, %pivots, %stream, %ch6 : !ht.host_buffer, !tfrt_gpu.buffer
+  %ch8 = tfrt_gpu.stream.synchronize %stream, %ch7
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 2, 2]
+  // CHECK-SAME: values = [4.000000e+00, 5.000000e-01, 3.000000e+00, -5.000000e-01, 1.000000e+00, 0.000000e+00, 0.000000e+00, 1.000000e+00]
+  %ch9 = tfrt_dht.print_tensor %host_tensor, %ch8
+  // CHECK: DenseHostTensor dtype = i32, shape = [2, 2], values = [2, 2, 1, 2]
+  %ch10 = tfrt_dht.print_tensor %pivots_tensor, %ch9
+
+  tfrt.return
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tfrt/jitrt/compilation_executor.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/support/latch.h"
+
+namespace tfrt {
+namespace jitrt {
+namespace {
+
+using Priority = CompilationExecutor::Priority;
+
+TEST(CompilationExecutorTest, BlockingTasksRunFirst) {
+  CompilationExecutor executor(/*num_threads=*/1);
+
+  // Occupy the only thread until all other tasks are enqueued.
+  latch enqueued(1);
+  ASSERT_TRUE(executor.Execute(Priority::kBlocking, [&] { enqueued.wait(); }));
+
+  std::vector<int> order;
+  auto push = [&](int i) { return [&order, i] { order.push_back(i); }; };
+  ASSERT_TRUE(executor.Execute(Priority::kBackground, push(0)));
+  ASSERT_TRUE(executor.Execute(Priority::kBlocking, push(1)));
+  ASSERT_TRUE(executor.Execute(Priority::kBackground, push(2)));
+  ASSERT_TRUE(executor.Execute(Priority::kBlocking, push(3)));
+
+  enqueued.count_down();
+  executor.Quiesce();
+
+  EXPECT_EQ(order, std::vector<int>({1, 3, 0, 2}));
+}
+
+TEST(CompilationExecutorTest, RejectBackgroundTasks) {
+  CompilationExecutor executor(/*num_threads=*/1,
+                               /*max_pending_background=*/1);
+
+  latch enqueued(1);
+  ASSERT_TRUE(executor.Execute(Priority::kBlocking, [&] { enqueued.wait(); }));
+
+  int num_completed = 0;
+  auto complete = [&] { ++num_completed; };
+  EXPECT_TRUE(executor.Execute(Priority::kBackground, complete));
+  EXPECT_FALSE(executor.Execute(Priority::kBackground, complete));
+  EXPECT_TRUE(executor.Execute(Priority::kBlocking, complete));
+
+  enqueued.count_down();
+  executor.Quiesce();
+
+  EXPECT_EQ(num_completed, 2);
+}
+
+}  // namespace
+}  // namespace jitrt
+}  // namespace tfrt
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tfrt/jitrt/object_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Path.h"
+#include "tfrt/jitrt/arguments.h"
+#include "tfrt/jitrt/jitrt_compiler.h"
+#include "third_party/tensorflow/compiler/xla/runtime/jit_executable.h"
+
+namespace tfrt {
+namespace jitrt {
+namespace {
+
+using ::xla::PrimitiveType;
+
+using namespace xla::runtime;  // NOLINT
+
+// Simple function that copies 2xf32 values from `arg0` to `arg1`.
+static const char* mlir_module = R"(
+    func.func @compute(%arg0: memref<?xf32>, %arg1: memref<?xf32>) {
+      %c0 = arith.constant 0 : index
+      %c1 = arith.constant 1 : index
+      %0 = memref.load %arg0[%c0] : memref<?xf32>
+      %1 = memref.load %arg0[%c1] : memref<?xf32>
+      memref.store %0, %arg1[%c0] : memref<?xf32>
+      memref.store %1, %arg1[%c1] : memref<?xf32>
+      func.return
+    })";
+
+static const char* entrypoint = "compute";
+
+static std::string GetCacheDirectory(const char* name) {
+  llvm::SmallString<128> path(::testing::TempDir());
+  llvm::sys::path::append(path, name);
+  return std::string(path);
+}
+
+TEST(ObjectCacheTest, Fingerprint) {
+  CompilationPipelineOptions copts;
+  std::string fingerprint =
+      CompilationFingerprint(mlir_module, entrypoint, copts);
+  EXPECT_EQ(fingerprint,
+            CompilationFingerprint(mlir_module, entrypoint, copts));
+  EXPECT_NE(fingerprint, CompilationFingerprint(mlir_module, "other", copts));
+
+  copts.alignment = 64;
+  EXPECT_NE(fingerprint,
+            CompilationFingerprint(mlir_module, entrypoint, copts));
+}
+
+TEST(ObjectCacheTest, LookupMissing) {
+  ObjectCache cache(GetCacheDirectory("lookup_missing"));
+  EXPECT_EQ(cache.Lookup("missing"), nullptr);
+}
+
+TEST(ObjectCacheTest, SaveRestore) {
+  JitExecutable::Options opts;
+  opts.specialization = JitExecutable::Specialization::kDisabled;
+  opts.compiler.register_dialects = RegisterDefaultJitRtDialects;
+
+  CompilationPipelineOptions copts;
+  opts.compiler.create_compilation_pipeline =
+      [&](xla::runtime::PassManager& passes) {
+        CreateDefaultJitRtCompilationPipeline(passes, copts);
+      };
+
+  absl::StatusOr<JitExecutable> jit_executable =
+      JitExecutable::Instantiate(mlir_module, entrypoint, opts);
+  ASSERT_TRUE(jit_executable.ok());
+
+  AsyncValuePtr<Executable> executable = jit_executable->DefaultExecutable();
+  Await(executable.value());  // make sure executable is available
+
+  ObjectCache cache(GetCacheDirectory("save_restore"));
+  std::string fingerprint =
+      CompilationFingerprint(mlir_module, entrypoint, copts);
+  EXPECT_TRUE(
+      absl::IsNotFound(LoadCachedExecutable(cache, fingerprint, mlir_module,
+                                            entrypoint, opts)
+                           .status()));
+
+  ASSERT_FALSE(InsertCachedExecutable(cache, fingerprint, executable.get()));
+
+  absl::StatusOr<Executable> loaded = LoadCachedExecutable(
+      cache, fingerprint, mlir_module, entrypoint, opts);
+  ASSERT_TRUE(loaded.ok()) << loaded.status().message();
+
+  std::vector<float> arg0 = {1.0, 2.0};
+  std::vector<float> arg1(2, 0.0);
+
+  std::vector<int64_t> dims = {2};
+  std::vector<int64_t> strides = {1};
+
+  llvm::SmallVector<MemrefDesc> args;
+  args.emplace_back(PrimitiveType::F32, arg0.data(), 0, dims, strides);
+  args.emplace_back(PrimitiveType::F32, arg1.data(), 0, dims, strides);
+
+  Executable::ExecuteOpts execute_opts;
+  execute_opts.async_task_runner =
+      reinterpret_cast<jitrt::AsyncTaskRunner*>(0XDEADBEEF);
+
+  NoResultConverter converter;
+
+  // Execute the executable loaded from the object cache.
+  ASSERT_TRUE(loaded->Execute(args, converter, execute_opts).ok());
+  EXPECT_EQ(arg1, arg0);
+}
+
+}  // namespace
+}  // namespace jitrt
+}  // namespace tfrt
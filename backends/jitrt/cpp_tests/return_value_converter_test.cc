@@ -22,7 +22,9 @@
 #include "llvm/ADT/SmallVector.h"
 #include "mlir/ExecutionEngine/CRunnerUtils.h"
 #include "tfrt/dtype/dtype.h"
+#include "tfrt/host_context/host_allocator.h"
 #include "tfrt/jitrt/results.h"
+#include "tfrt/tensor/dense_host_tensor.h"
 
 namespace tfrt {
 namespace jitrt {
@@ -83,6 +85,44 @@ static void BM_StaticRemainingResultsConverter(benchmark::State& state) {
   }
 }
 
+TEST(ReturnValueConverterTest, ForwardOperand) {
+  auto allocator = CreateMallocAllocator();
+  auto operand = DenseHostTensor::CreateUninitialized(
+      TensorMetadata::Create<float>(4), allocator.get());
+  ASSERT_TRUE(operand.has_value());
+
+  struct ForwardingContext {
+    llvm::SmallVector<const DenseHostTensor*> operands;
+  };
+  ForwardingContext context;
+  context.operands.push_back(&*operand);
+
+  auto dims = std::array<int64_t, 1>({2});
+  auto type = std::make_unique<MemrefType>(dims, xla::PrimitiveType::F32);
+
+  // Returned memref is a view into the second half of the operand buffer.
+  auto memref = StridedMemRefType<float, 1>();
+  memref.basePtr = operand->data<float>();
+  memref.data = operand->data<float>() + 2;
+  memref.offset = 0;
+  memref.sizes[0] = 2;
+  memref.strides[0] = 1;
+
+  std::array<RCReference<AsyncValue>, 1> storage;
+  RemainingResults results(storage);
+
+  RemainingResultsConverter<ForwardingContext> converter(results, context);
+  converter.AddConversion(
+      ReturnMemrefAsDenseHostTensorOrOperand<ForwardingContext>);
+  ASSERT_TRUE(mlir::succeeded(
+      converter.ReturnValue(0, type.get(), type.get(), &memref)));
+
+  // The result shares the operand buffer, and must not free the memref.
+  auto& result = storage[0]->get<DenseHostTensor>();
+  EXPECT_EQ(result.NumElements(), 2);
+  EXPECT_EQ(result.data(), operand->data<float>() + 2);
+}
+
 BENCHMARK(BM_RemainingResultsConverter);
 BENCHMARK(BM_StaticRemainingResultsConverter);
 
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tfrt/jitrt/tiered_execution.h"
+
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/jitrt/compilation_executor.h"
+#include "tfrt/jitrt/jitrt_compiler.h"
+
+namespace tfrt {
+namespace jitrt {
+namespace {
+
+using ::llvm::SmallVector;
+using ::xla::PrimitiveType;
+
+using namespace xla::runtime;  // NOLINT
+
+static const char* mlir_module = R"(
+    func.func @compute(%arg0: memref<?xf32>) {
+      func.return
+    })";
+
+static const char* entrypoint = "compute";
+
+// Tiers are tracked per JitExecutable address for the lifetime of the process,
+// so the executables are leaked to keep tests independent.
+static JitExecutable* Instantiate() {
+  JitExecutable::Options opts;
+  opts.specialization = JitExecutable::Specialization::kEnabled;
+  opts.compiler.register_dialects = RegisterDefaultJitRtDialects;
+
+  CompilationPipelineOptions copts;
+  opts.compiler.create_compilation_pipeline =
+      [copts](xla::runtime::PassManager& passes) {
+        CreateDefaultJitRtCompilationPipeline(passes, copts);
+      };
+
+  absl::StatusOr<JitExecutable> jit_executable =
+      JitExecutable::Instantiate(mlir_module, entrypoint, opts);
+  if (!jit_executable.ok()) return nullptr;
+  return new JitExecutable(std::move(*jit_executable));
+}
+
+// Returns the executable for operands of the given size.
+static AsyncValuePtr<Executable> GetExecutable(JitExecutable* jit_executable,
+                                               CompilationExecutor& executor,
+                                               int64_t size) {
+  SmallVector<int64_t> sizes = {size};
+  SmallVector<MemrefDesc> memrefs;
+  memrefs.emplace_back(PrimitiveType::F32, nullptr, 0, sizes, sizes);
+  auto specialize = [=]() -> absl::StatusOr<AsyncValuePtr<Executable>> {
+    SmallVector<int64_t> sizes = {size};
+    SmallVector<MemrefDesc> memrefs;
+    memrefs.emplace_back(PrimitiveType::F32, nullptr, 0, sizes, sizes);
+    return jit_executable->GetExecutable(memrefs);
+  };
+  auto executable = GetTieredExecutable(*jit_executable, memrefs, executor,
+                                        std::move(specialize));
+  EXPECT_TRUE(executable.ok());
+  return *executable;
+}
+
+TEST(TieredExecutionTest, SpecializeHotShapes) {
+  CompilationExecutor executor(/*num_threads=*/1);
+  JitExecutable* jit_executable = Instantiate();
+  ASSERT_NE(jit_executable, nullptr);
+  AsyncValuePtr<Executable> default_executable =
+      jit_executable->DefaultExecutable();
+  Await(default_executable.value());
+  ASSERT_TRUE(default_executable.IsConcrete());
+
+  auto get_executable = [&] {
+    return GetExecutable(jit_executable, executor, /*size=*/4);
+  };
+
+  // Cold shapes run the default executable, also while the specialization
+  // is compiling.
+  for (int i = 0; i < kSpecializeAfterNumCalls; ++i)
+    EXPECT_EQ(get_executable().GetAsyncValue(),
+              default_executable.GetAsyncValue());
+
+  // Hot shapes run the specialization once it has been compiled.
+  executor.Quiesce();
+  AsyncValuePtr<Executable> specialized = get_executable();
+  Await(specialized.value());
+  EXPECT_TRUE(specialized.IsConcrete());
+  EXPECT_NE(specialized.GetAsyncValue(), default_executable.GetAsyncValue());
+}
+
+TEST(TieredExecutionTest, BoundedSpecializations) {
+  CompilationExecutor executor(/*num_threads=*/1);
+  JitExecutable* jit_executable = Instantiate();
+  ASSERT_NE(jit_executable, nullptr);
+  AsyncValuePtr<Executable> default_executable =
+      jit_executable->DefaultExecutable();
+  Await(default_executable.value());
+  ASSERT_TRUE(default_executable.IsConcrete());
+
+  // Make one more shape hot than can be specialized.
+  for (int64_t size = 1; size <= kMaxSpecializations + 1; ++size) {
+    for (int i = 0; i < kSpecializeAfterNumCalls; ++i)
+      GetExecutable(jit_executable, executor, size);
+  }
+  executor.Quiesce();
+
+  for (int64_t size = 1; size <= kMaxSpecializations; ++size) {
+    EXPECT_NE(GetExecutable(jit_executable, executor, size).GetAsyncValue(),
+              default_executable.GetAsyncValue());
+  }
+
+  // The last hot shape keeps running the default executable.
+  EXPECT_EQ(GetExecutable(jit_executable, executor, kMaxSpecializations + 1)
+                .GetAsyncValue(),
+            default_executable.GetAsyncValue());
+}
+
+}  // namespace
+}  // namespace jitrt
+}  // namespace tfrt
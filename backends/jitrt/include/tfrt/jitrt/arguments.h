@@ -17,7 +17,11 @@
 #ifndef TFRT_BACKENDS_JITRT_JITRT_H_
 #define TFRT_BACKENDS_JITRT_JITRT_H_
 
+#include <cstdint>
+
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Error.h"
+#include "tfrt/tensor/tensor_metadata.h"
 #include "third_party/tensorflow/compiler/xla/runtime/arguments.h"
 
 namespace tfrt {
@@ -32,6 +36,38 @@ namespace jitrt {
 llvm::Expected<xla::runtime::MemrefDesc> ConvertTensorToMemrefDesc(
     const Tensor& tensor);
 
+// Plan for converting the operands of one executable to memref descriptors.
+//
+// Converting a tensor derives the memref sizes and strides from its shape,
+// which for tiny kernels costs about as much as running them. The plan keeps
+// the element types, sizes and strides of the operands of the previous call,
+// and if the operands have the same dtypes and shapes only the data pointers
+// are taken from the tensors.
+//
+// Plans are not thread safe, executables should use the plan returned by
+// GetThreadLocal().
+class MemrefDescPlan {
+ public:
+  // Appends the memref descriptor for `tensor`, passed as the operand at
+  // `index`, to `memrefs`. Supports the same tensor types as
+  // ConvertTensorToMemrefDesc().
+  llvm::Error Append(unsigned index, const Tensor& tensor,
+                     llvm::SmallVectorImpl<xla::runtime::MemrefDesc>* memrefs);
+
+  // Returns the plan of the calling thread for the executable `key`.
+  static MemrefDescPlan& GetThreadLocal(const void* key);
+
+ private:
+  struct Operand {
+    TensorMetadata metadata;
+    xla::PrimitiveType type = xla::PrimitiveType::PRIMITIVE_TYPE_INVALID;
+    llvm::SmallVector<int64_t, 4> sizes;
+    llvm::SmallVector<int64_t, 4> strides;
+  };
+
+  llvm::SmallVector<Operand, 4> operands_;
+};
+
 }  // namespace jitrt
 }  // namespace tfrt
 
@@ -17,11 +17,13 @@
 #ifndef TFRT_BACKENDS_JITRT_INCLUDE_TFRT_JITRT_ASYNC_TASK_RUNNER_H_
 #define TFRT_BACKENDS_JITRT_INCLUDE_TFRT_JITRT_ASYNC_TASK_RUNNER_H_
 
+#include <atomic>
 #include <utility>
 
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/host_context.h"
 #include "third_party/tensorflow/compiler/xla/runtime/async_runtime.h"
+#include "third_party/tensorflow/compiler/xla/runtime/execution_engine.h"
 
 namespace tfrt {
 namespace jitrt {
@@ -29,15 +31,52 @@ namespace jitrt {
 using xla::runtime::AsyncTaskRunner;
 
 // Runs async tasks by enqueing them into the host context work queue.
+//
+// The runner also tracks the load it puts on the work queue, so that compiled
+// code can size its parallel loops to the worker threads that are available
+// when it runs (see CompilationPipelineOptions::runtime_async_parallelism).
 class HostContextAsyncTaskRunner : public AsyncTaskRunner {
  public:
   explicit HostContextAsyncTaskRunner(tfrt::HostContext* host) : host_(host) {}
-  void Schedule(Task task) override { EnqueueWork(host_, std::move(task)); }
+
+  void Schedule(Task task) override {
+    num_pending_tasks_.fetch_add(1, std::memory_order_relaxed);
+    EnqueueWork(host_, [this, task = std::move(task)]() mutable {
+      task();
+      num_pending_tasks_.fetch_sub(1, std::memory_order_relaxed);
+    });
+  }
+
+  // Returns the number of worker threads that are not busy with the tasks or
+  // the other executions of this runner. Always at least one, the calling
+  // thread.
+  int AvailableParallelism() const;
+
+  // Makes `runner` the runner of the compiled code executed by the calling
+  // thread until the end of the scope.
+  class ExecutionScope {
+   public:
+    explicit ExecutionScope(HostContextAsyncTaskRunner* runner);
+    ~ExecutionScope();
+
+    ExecutionScope(const ExecutionScope&) = delete;
+    ExecutionScope& operator=(const ExecutionScope&) = delete;
+
+   private:
+    HostContextAsyncTaskRunner* runner_;
+    HostContextAsyncTaskRunner* parent_;
+  };
 
  private:
   HostContext* host_;
+  std::atomic<int> num_pending_tasks_{0};
+  std::atomic<int> num_executions_{0};
 };
 
+// Binds the runtime functions called by code compiled with
+// CompilationPipelineOptions::runtime_async_parallelism.
+xla::runtime::ExecutionEngine::SymbolsBinding AsyncParallelismSymbolsBinding();
+
 }  // namespace jitrt
 }  // namespace tfrt
 
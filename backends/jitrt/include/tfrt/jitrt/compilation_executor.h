@@ -0,0 +1,111 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TFRT_BACKENDS_JITRT_INCLUDE_TFRT_JITRT_COMPILATION_EXECUTOR_H_
+#define TFRT_BACKENDS_JITRT_INCLUDE_TFRT_JITRT_COMPILATION_EXECUTOR_H_
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "llvm/ADT/FunctionExtras.h"
+#include "mlir/Pass/PassInstrumentation.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+#include "tfrt/support/thread_environment.h"
+
+namespace tfrt {
+namespace jitrt {
+
+// Runs JitRt compilation tasks on a dedicated, bounded set of threads.
+//
+// Compiling with LLVM takes much longer than running a typical kernel, and if
+// compilation tasks run on the same work queue as the inference, a burst of
+// new operand shapes (e.g. during a model rollout) can occupy every worker.
+// Compilation tasks instead run on at most `num_threads` threads, and tasks
+// that block a request (the first compilation of a kernel) always run before
+// the background tasks (specializations compiled by tiered execution).
+//
+// Exports the following metrics under /tfrt/jitrt/compilation/:
+// queue_time_ms/blocking and queue_time_ms/background (time from enqueue
+// until a thread picks up the task), and rejected_background_tasks.
+class CompilationExecutor {
+ public:
+  enum class Priority {
+    kBlocking,    // a request waits for the compilation result
+    kBackground,  // nothing waits, the task can be dropped
+  };
+
+  using Task = llvm::unique_function<void()>;
+
+  // Returns the process-wide executor. The number of threads defaults to a
+  // quarter of the hardware threads, and can be overridden with the
+  // TFRT_JITRT_COMPILATION_THREADS environment variable.
+  static CompilationExecutor& Default();
+
+  // Background tasks are rejected while `max_pending_background` of them are
+  // waiting for a thread. Blocking tasks are never rejected.
+  explicit CompilationExecutor(int num_threads,
+                               size_t max_pending_background = 64);
+
+  // Runs all pending tasks before returning.
+  ~CompilationExecutor();
+
+  CompilationExecutor(const CompilationExecutor&) = delete;
+  CompilationExecutor& operator=(const CompilationExecutor&) = delete;
+
+  // Enqueues `task`, and returns false if the task was rejected.
+  [[nodiscard]] bool Execute(Priority priority, Task task);
+
+  // Blocks until all enqueued tasks have completed.
+  void Quiesce();
+
+  int num_threads() const { return static_cast<int>(threads_.size()); }
+
+ private:
+  struct PendingTask {
+    Task task;
+    std::chrono::steady_clock::time_point enqueued;
+  };
+
+  void WorkerLoop();
+
+  mutex mu_;
+  condition_variable cv_;
+  std::deque<PendingTask> blocking_ TFRT_GUARDED_BY(mu_);
+  std::deque<PendingTask> background_ TFRT_GUARDED_BY(mu_);
+  size_t num_running_ TFRT_GUARDED_BY(mu_) = 0;
+  bool stopping_ TFRT_GUARDED_BY(mu_) = false;
+
+  const size_t max_pending_background_;
+  std::vector<std::unique_ptr<ThreadingEnvironment::Thread>> threads_;
+};
+
+// Records the wall time of every compilation pipeline pass to histograms
+// named /tfrt/jitrt/compilation/pass_time_ms/<pass name>.
+class PassTimingMetrics : public mlir::PassInstrumentation {
+ public:
+  void runBeforePass(mlir::Pass* pass, mlir::Operation* op) override;
+  void runAfterPass(mlir::Pass* pass, mlir::Operation* op) override;
+  void runAfterPassFailed(mlir::Pass* pass, mlir::Operation* op) override;
+};
+
+}  // namespace jitrt
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_JITRT_INCLUDE_TFRT_JITRT_COMPILATION_EXECUTOR_H_
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TFRT_BACKENDS_JITRT_CUSTOM_CALLS_ASYNC_CUSTOM_CALL_H_
+#define TFRT_BACKENDS_JITRT_CUSTOM_CALLS_ASYNC_CUSTOM_CALL_H_
+
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/chain.h"
+#include "third_party/tensorflow/compiler/xla/mlir/runtime/utils/async_runtime_api.h"
+#include "third_party/tensorflow/compiler/xla/runtime/custom_call.h"
+#include "third_party/tensorflow/compiler/xla/runtime/type_id.h"
+
+namespace xla {
+namespace runtime {
+class CustomCallRetEncodingSet;
+}  // namespace runtime
+}  // namespace xla
+
+namespace tfrt {
+namespace jitrt {
+
+// Async custom calls return an `!async.token` instead of completing the work
+// before returning to the compiled code:
+//
+//   func.func private @offload(%arg0: memref<?xf32>) -> !async.token
+//     attributes { rt.dynamic, rt.custom_call = "offload" }
+//
+//   %token = func.call @offload(%arg0) : (memref<?xf32>) -> !async.token
+//   ... compute that does not depend on %arg0 ...
+//   async.await %token : !async.token
+//
+// The handler starts the work (e.g. I/O or an accelerator launch), and returns
+// the token with a `CustomCall::Result<mlir::runtime::AsyncToken*>` result.
+// The compiled code keeps running until it awaits the token through the async
+// runtime, and inside `async.execute` regions the await suspends the task
+// instead of blocking the worker thread.
+//
+// Custom call arguments are only valid until the handler returns, so the work
+// must not keep references to them (e.g. memref sizes), only to the buffers
+// whose lifetime is managed by the compiled code.
+
+// Returns an async token that becomes available (or an error) together with
+// `chain`. The returned token is owned by the caller, and the completion of
+// `chain` holds its own reference until it updates the token.
+mlir::runtime::AsyncToken* ConvertChainToAsyncToken(AsyncValueRef<Chain> chain);
+
+// Registers names for the TypeIDs used for encoding async custom call results.
+void PopulateAsyncCustomCallTypeIdNames(
+    xla::runtime::TypeIDNameRegistry& registry);
+
+// Populates encoding for the `!async.token` custom call results.
+void PopulateAsyncCustomCallRetEncoding(
+    xla::runtime::CustomCallRetEncodingSet& encoding);
+
+}  // namespace jitrt
+}  // namespace tfrt
+
+namespace xla {
+namespace runtime {
+
+// Async tokens are returned from the custom calls as opaque pointers.
+XLA_RUNTIME_REGISTER_OPAQUE_RET_DECODING(
+    mlir::runtime::AsyncToken*,
+    TypeID::get<Tagged<mlir::runtime::AsyncToken>>());
+
+}  // namespace runtime
+}  // namespace xla
+
+XLA_RUNTIME_DECLARE_EXPLICIT_TYPE_ID(mlir::runtime::AsyncToken);
+
+#endif  // TFRT_BACKENDS_JITRT_CUSTOM_CALLS_ASYNC_CUSTOM_CALL_H_
@@ -25,6 +25,7 @@
 namespace xla {
 namespace runtime {
 class CustomCallAttrEncodingSet;
+class CustomCallRetEncodingSet;
 }  // namespace runtime
 }  // namespace xla
 
@@ -56,6 +57,10 @@ void PopulateCustomCallTypeIdNames(xla::runtime::TypeIDNameRegistry& registry);
 void PopulateCustomCallAttrEncoding(
     xla::runtime::CustomCallAttrEncodingSet& encoding);
 
+// Populate encoding for the async custom call results.
+void PopulateCustomCallRetEncoding(
+    xla::runtime::CustomCallRetEncodingSet& encoding);
+
 }  // namespace jitrt
 }  // namespace tfrt
 
@@ -28,6 +28,7 @@ namespace runtime {
 class TypeIDNameRegistry;
 class CustomCallArgEncodingSet;
 class CustomCallAttrEncodingSet;
+class CustomCallRetEncodingSet;
 
 }  // namespace runtime
 }  // namespace xla
@@ -39,6 +40,19 @@ namespace jitrt {
 // required by the default JitRt compilation pipeline.
 void RegisterDefaultJitRtDialects(xla::runtime::DialectRegistry& dialects);
 
+// Instruction set extensions of the CPU the process runs on. JitRt compiles for
+// the host CPU, so the features are detected at run time rather than taken from
+// the flags the binary was built with, and one binary deployed to different
+// CPU generations uses the extensions available on each of them.
+struct HostCpuFeatures {
+  static const HostCpuFeatures& Get();
+
+  bool avx2 = false;
+  bool avx512f = false;
+  bool amx_tile = false;
+  bool neon = false;
+};
+
 struct CompilationPipelineOptions {
   // Byte alignment for allocated memrefs. Depending on the compiler flags
   // Tensorflow requires tensors to be aligned on 16, 32 or 64 bytes.
@@ -51,12 +65,21 @@ struct CompilationPipelineOptions {
   // Use experimental cost model for lowering scf.parallel to async dialect.
   bool cost_driven_async_parallel_for = false;
 
+  // Size the parallel loops at run time to the worker threads that are not
+  // busy with other work of the HostContextAsyncTaskRunner, instead of always
+  // splitting them for `num_worker_threads`. Executables compiled with this
+  // option must bind AsyncParallelismSymbolsBinding() (async_task_runner.h).
+  bool runtime_async_parallelism = false;
+
   // Enables math approximations that emit AVX2 intrinsics.
-#ifdef __AVX2__
-  bool math_avx2 = true;
-#else
-  bool math_avx2 = false;
-#endif
+  bool math_avx2 = HostCpuFeatures::Get().avx2;
+
+  // Enable lowering of the target specific vector dialects (X86Vector AVX-512,
+  // AMX tiles and ArmNeon), which can be used by the compiled kernels (e.g.
+  // matmul codegen) when the host CPU supports them.
+  bool avx512 = HostCpuFeatures::Get().avx512f;
+  bool amx = HostCpuFeatures::Get().amx_tile;
+  bool arm_neon = HostCpuFeatures::Get().neon;
 
   // Register names for the TypeIDs used for encoding types of custom arguments
   // and attributes.
@@ -67,13 +90,16 @@ struct CompilationPipelineOptions {
   // corresponding runtime APIs (including custom calls).
   std::function<void(mlir::TypeConverter&)> populate_type_conversions;
 
-  // Add user-defined encoding for JitRt custom call arguments and attributes.
+  // Add user-defined encoding for JitRt custom call arguments, results and
+  // attributes.
   //
   // Custom encodings allow to pass dialect-specific attributes (enums and
   // structs) to the custom calls, and decode them into dialect-specific runtime
   // values in the custom call handlers (see custom_call_to_llvm.h for details).
   std::function<void(xla::runtime::CustomCallArgEncodingSet&)>
       populate_arg_encodings;
+  std::function<void(xla::runtime::CustomCallRetEncodingSet&)>
+      populate_ret_encodings;
   std::function<void(xla::runtime::CustomCallAttrEncodingSet&)>
       populate_attr_encodings;
 };
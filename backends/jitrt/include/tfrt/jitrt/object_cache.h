@@ -0,0 +1,94 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TFRT_BACKENDS_JITRT_INCLUDE_TFRT_JITRT_OBJECT_CACHE_H_
+#define TFRT_BACKENDS_JITRT_INCLUDE_TFRT_JITRT_OBJECT_CACHE_H_
+
+#include <memory>
+#include <string>
+
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "tfrt/jitrt/jitrt_compiler.h"
+#include "tfrt/support/forward_decls.h"
+#include "third_party/tensorflow/compiler/xla/runtime/executable.h"
+#include "third_party/tensorflow/compiler/xla/runtime/jit_executable.h"
+
+namespace tfrt {
+namespace jitrt {
+
+// Returns a fingerprint of the inputs that determine the object file compiled
+// for the `entrypoint` function of the MLIR `module`: the module source, the
+// entrypoint, the compilation pipeline options and the host CPU name and
+// features. The fingerprint is a hex string that can be used as a file name.
+//
+// Options that are callbacks (e.g. `populate_type_conversions`) can't be
+// fingerprinted, and users that customize them must make them part of the
+// cache directory instead.
+std::string CompilationFingerprint(string_view module, string_view entrypoint,
+                                   const CompilationPipelineOptions& opts);
+
+// A content-addressed cache of object files compiled by JitRt. Object files
+// are stored in a directory, keyed by the compilation fingerprint, so that
+// they survive process restarts and can be shared by processes running on
+// the same kind of host.
+//
+// Object files are written through a temporary file and a rename, so
+// concurrent writers never corrupt an entry and readers never see a partially
+// written object file.
+class ObjectCache {
+ public:
+  explicit ObjectCache(std::string directory);
+
+  // Returns the cache in the directory named by the TFRT_JITRT_OBJECT_CACHE_DIR
+  // environment variable, or nullptr if the variable is not set.
+  static const ObjectCache* Default();
+
+  // Returns the object file with the given fingerprint, or nullptr if it is
+  // not in the cache.
+  std::unique_ptr<llvm::MemoryBuffer> Lookup(string_view fingerprint) const;
+
+  // Adds the object file with the given fingerprint to the cache.
+  llvm::Error Insert(string_view fingerprint,
+                     llvm::MemoryBufferRef obj_file) const;
+
+ private:
+  std::string GetPath(string_view fingerprint) const;
+
+  std::string directory_;
+};
+
+// Loads the default executable for the `entrypoint` function of the MLIR
+// `module` from the object cache, skipping the MLIR compilation pipeline and
+// LLVM code generation. The function signatures are recovered from the module
+// using the type converter and calling convention in `opts`. Returns a
+// NotFound error if the object file is not in the cache.
+absl::StatusOr<xla::runtime::Executable> LoadCachedExecutable(
+    const ObjectCache& cache, string_view fingerprint, string_view module,
+    string_view entrypoint, const xla::runtime::JitExecutable::Options& opts);
+
+// Adds the object file behind `executable` to the object cache. The
+// executable must be the default (not specialized) executable of a
+// JitExecutable, because LoadCachedExecutable() recovers the unspecialized
+// signatures.
+llvm::Error InsertCachedExecutable(const ObjectCache& cache,
+                                   string_view fingerprint,
+                                   const xla::runtime::Executable& executable);
+
+}  // namespace jitrt
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_JITRT_INCLUDE_TFRT_JITRT_OBJECT_CACHE_H_
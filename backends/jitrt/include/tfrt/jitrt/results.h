@@ -21,11 +21,13 @@
 #include <type_traits>
 #include <utility>
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/Support/Compiler.h"
 #include "mlir/Support/LogicalResult.h"
 #include "tfrt/host_context/kernel_utils.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/msan.h"
+#include "tfrt/tensor/dense_host_tensor.h"
 #include "third_party/tensorflow/compiler/xla/mlir/runtime/utils/async_runtime_api.h"
 #include "third_party/tensorflow/compiler/xla/runtime/results.h"
 #include "third_party/tensorflow/compiler/xla/runtime/types.h"
@@ -252,6 +254,16 @@ mlir::LogicalResult ReturnMemrefAsDenseHostTensor(
     const xla::runtime::Type* type, const xla::runtime::Type* runtime_type,
     void* result_ptr);
 
+// Converts returned values of `memref<...>` type to the async values of
+// DenseHostTensors. If the returned memref points into the buffer of one of the
+// `operands` (the compiled function forwarded or updated an operand in place),
+// the result shares the operand buffer, otherwise it takes ownership of the
+// memref allocated by the compiled function.
+mlir::LogicalResult ReturnMemrefAsDenseHostTensorOrOperand(
+    llvm::ArrayRef<const DenseHostTensor*> operands, RemainingResults results,
+    unsigned result_index, const xla::runtime::Type* type,
+    const xla::runtime::Type* runtime_type, void* result_ptr);
+
 }  // namespace internal
 
 #define DECLARE_CONTEXT_ADAPTOR(NAME)                                         \
@@ -270,6 +282,18 @@ DECLARE_CONTEXT_ADAPTOR(ReturnMemrefAsDenseHostTensor)
 
 #undef DECLARE_CONTEXT_ADAPTOR
 
+// Returns memrefs that can alias the operands. The conversion context must have
+// an `operands` member convertible to `ArrayRef<const DenseHostTensor*>`, with
+// the DenseHostTensors passed to the executable.
+template <typename ConversionContext>
+static mlir::LogicalResult ReturnMemrefAsDenseHostTensorOrOperand(
+    ConversionContext& ctx, RemainingResults results, unsigned result_index,
+    const xla::runtime::Type* type, const xla::runtime::Type* runtime_type,
+    void* result_ptr) {
+  return internal::ReturnMemrefAsDenseHostTensorOrOperand(
+      ctx.operands, results, result_index, type, runtime_type, result_ptr);
+}
+
 // -------------------------------------------------------------------------- //
 
 // Converts returned memref values to Tensors using a user-provided Converter
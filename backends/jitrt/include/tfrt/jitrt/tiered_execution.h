@@ -0,0 +1,93 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TFRT_BACKENDS_JITRT_INCLUDE_TFRT_JITRT_TIERED_EXECUTION_H_
+#define TFRT_BACKENDS_JITRT_INCLUDE_TFRT_JITRT_TIERED_EXECUTION_H_
+
+#include <cstddef>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/FunctionExtras.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/jitrt/compilation_executor.h"
+#include "third_party/tensorflow/compiler/xla/runtime/arguments.h"
+#include "third_party/tensorflow/compiler/xla/runtime/executable.h"
+#include "third_party/tensorflow/compiler/xla/runtime/jit_executable.h"
+
+namespace tfrt {
+namespace jitrt {
+
+// Number of calls with the same operand shapes after which the specialized
+// executable for these shapes is compiled.
+inline constexpr int kSpecializeAfterNumCalls = 4;
+
+// Maximum number of specializations compiled for one JitExecutable. Operand
+// shapes which become hot after that keep running the default executable.
+inline constexpr int kMaxSpecializations = 32;
+
+// Maximum total object file size of the specializations compiled for one
+// JitExecutable. Once exceeded, no further specializations are compiled.
+inline constexpr size_t kMaxSpecializedCodeBytes = 64 << 20;
+
+// Maximum number of cold operand shapes tracked for one JitExecutable. When
+// exceeded, the least recently used cold shape is forgotten (and its call
+// count restarts if it is seen again).
+inline constexpr size_t kMaxTrackedShapes = 1024;
+
+// Compiles (or looks up) the specialized executable for the operands of one
+// call. Runs on the compilation executor, so it must not refer to the stack of
+// the call and must keep the operands alive itself.
+using SpecializeFn = llvm::unique_function<
+    absl::StatusOr<AsyncValuePtr<xla::runtime::Executable>>()>;
+
+// Returns the executable to run `jit_executable` with `memrefs`, compiling
+// specializations in tiers.
+//
+// JitExecutable::GetExecutable() compiles a specialization synchronously the
+// first time it sees new operand shapes, which stalls that call. Instead, calls
+// run the default (shape polymorphic) executable while their operand shapes
+// are cold. When the same operand shapes have been seen
+// kSpecializeAfterNumCalls times, `specialize` is run on `executor` with
+// background priority, and later calls with these shapes use the
+// specialization once it is available. If compiling the specialization fails,
+// or the executor rejects it, calls keep using the default executable.
+//
+// Programs which can't run without specialization (e.g. because they require
+// value specialization) don't have a usable default executable, and always get
+// their executable from JitExecutable::GetExecutable().
+//
+// JitExecutable never evicts its specializations, so for programs with highly
+// variable operand shapes (e.g. sequence lengths) they are bounded here
+// instead: at most kMaxSpecializations, or kMaxSpecializedCodeBytes of code,
+// are compiled per JitExecutable, and only kMaxTrackedShapes cold shapes are
+// remembered.
+//
+// Call counts are tracked per JitExecutable address and never released, so
+// `jit_executable` must live until the end of the process, like the
+// executables cached by the jitrt.compile kernels.
+//
+// Exports the following metrics under /tfrt/jitrt/tiered_execution/:
+// default_calls and specialized_calls (the specialization hit rate),
+// compilations, compilation_failures, evicted_shapes and code_bytes.
+absl::StatusOr<AsyncValuePtr<xla::runtime::Executable>> GetTieredExecutable(
+    xla::runtime::JitExecutable& jit_executable,
+    llvm::ArrayRef<xla::runtime::MemrefDesc> memrefs,
+    CompilationExecutor& executor, SpecializeFn specialize);
+
+}  // namespace jitrt
+}  // namespace tfrt
+
+#endif  // TFRT_BACKENDS_JITRT_INCLUDE_TFRT_JITRT_TIERED_EXECUTION_H_
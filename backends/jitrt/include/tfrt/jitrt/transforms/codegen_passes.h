@@ -27,7 +27,8 @@ namespace jitrt {
 std::unique_ptr<mlir::Pass> CreateCostDrivenAsyncParallelForPass();
 
 std::unique_ptr<mlir::Pass> CreateCostDrivenAsyncParallelForPass(
-    bool async_dispatch, int32_t num_worker_threads, bool legacy_behavior);
+    bool async_dispatch, int32_t num_worker_threads, bool legacy_behavior,
+    bool runtime_parallelism = false);
 
 #define GEN_PASS_REGISTRATION
 #include "tfrt/jitrt/transforms/codegen_gen_passes.h.inc"
@@ -17,6 +17,7 @@
 #include "tfrt/jitrt/arguments.h"
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
 #include "tfrt/dtype/dtype.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/tensor/dense_host_tensor.h"
@@ -88,5 +89,35 @@ Expected<MemrefDesc> ConvertTensorToMemrefDesc(const Tensor& tensor) {
   return MakeStringError("unsupported tensor type: ", tensor.tensor_type());
 }
 
+Error MemrefDescPlan::Append(unsigned index, const Tensor& tensor,
+                             llvm::SmallVectorImpl<MemrefDesc>* memrefs) {
+  auto* dht = dyn_cast<DenseHostTensor>(&tensor);
+  if (!dht)
+    return MakeStringError("unsupported tensor type: ", tensor.tensor_type());
+
+  if (index >= operands_.size()) operands_.resize(index + 1);
+  Operand& operand = operands_[index];
+
+  // Re-plan the operand if its dtype or shape changed since the last call (the
+  // default metadata has an invalid dtype and never matches).
+  if (operand.metadata != dht->metadata()) {
+    operand.metadata = dht->metadata();
+    operand.type = ToPrimitiveType(dht->dtype());
+    operand.sizes.resize(dht->shape().GetRank());
+    operand.strides.resize(dht->shape().GetRank());
+    dht->shape().GetDimensions(operand.sizes);
+    dht->shape().GetStrides(operand.strides);
+  }
+
+  memrefs->emplace_back(operand.type, const_cast<void*>(dht->data()), 0,
+                        operand.sizes, operand.strides);
+  return Error::success();
+}
+
+MemrefDescPlan& MemrefDescPlan::GetThreadLocal(const void* key) {
+  static thread_local llvm::DenseMap<const void*, MemrefDescPlan> plans;
+  return plans[key];
+}
+
 }  // namespace jitrt
 }  // namespace tfrt
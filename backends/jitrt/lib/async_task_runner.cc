@@ -0,0 +1,76 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- async_task_runner.cc - ---------------------------------------------===//
+// Runs JitRt async tasks in the host context work queue.
+//===----------------------------------------------------------------------===//
+
+#include "tfrt/jitrt/async_task_runner.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "llvm/ExecutionEngine/JITSymbol.h"
+#include "llvm/ExecutionEngine/Orc/Core.h"
+#include "llvm/ExecutionEngine/Orc/Mangling.h"
+
+namespace tfrt {
+namespace jitrt {
+
+// The runner of the compiled code executed by the current thread.
+static thread_local HostContextAsyncTaskRunner* current_runner = nullptr;
+
+int HostContextAsyncTaskRunner::AvailableParallelism() const {
+  // The calling thread is one of the executions and can run a task itself.
+  int busy = num_pending_tasks_.load(std::memory_order_relaxed) +
+             num_executions_.load(std::memory_order_relaxed) - 1;
+  return std::max(1, host_->GetNumWorkerThreads() - busy);
+}
+
+HostContextAsyncTaskRunner::ExecutionScope::ExecutionScope(
+    HostContextAsyncTaskRunner* runner)
+    : runner_(runner), parent_(current_runner) {
+  runner_->num_executions_.fetch_add(1, std::memory_order_relaxed);
+  current_runner = runner_;
+}
+
+HostContextAsyncTaskRunner::ExecutionScope::~ExecutionScope() {
+  current_runner = parent_;
+  runner_->num_executions_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// Returns the number of worker threads available to the parallel loops of the
+// compiled code running on the current thread. Async tasks run outside of an
+// execution scope, and nested parallel loops get the compile time value.
+static int64_t AsyncParallelism(int64_t num_worker_threads) {
+  if (current_runner == nullptr) return num_worker_threads;
+  return std::min<int64_t>(num_worker_threads,
+                           current_runner->AvailableParallelism());
+}
+
+xla::runtime::ExecutionEngine::SymbolsBinding
+AsyncParallelismSymbolsBinding() {
+  return [](llvm::orc::MangleAndInterner mangle) {
+    llvm::orc::SymbolMap symbol_map;
+    symbol_map[mangle("jitrt_async_parallelism")] = llvm::JITEvaluatedSymbol(
+        llvm::pointerToJITTargetAddress(&AsyncParallelism),
+        llvm::JITSymbolFlags());
+    return symbol_map;
+  };
+}
+
+}  // namespace jitrt
+}  // namespace tfrt
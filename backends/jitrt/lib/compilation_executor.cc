@@ -0,0 +1,198 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- compilation_executor.cc - ------------------------------------------===//
+// Dedicated executor for JitRt compilation tasks.
+//===----------------------------------------------------------------------===//
+
+#include "tfrt/jitrt/compilation_executor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "mlir/Pass/Pass.h"
+#include "tfrt/metrics/metrics.h"
+
+namespace tfrt {
+namespace jitrt {
+
+using Clock = std::chrono::steady_clock;
+
+static metrics::Buckets MillisecondBuckets() {
+  return metrics::Buckets::Explicit(
+      {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000});
+}
+
+static double ElapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+namespace {
+struct Metrics {
+  static Metrics& Global() {
+    static auto* instance = new Metrics;
+    return *instance;
+  }
+
+  metrics::Histogram* blocking_queue_time = metrics::NewHistogram(
+      "/tfrt/jitrt/compilation/queue_time_ms/blocking", MillisecondBuckets());
+  metrics::Histogram* background_queue_time = metrics::NewHistogram(
+      "/tfrt/jitrt/compilation/queue_time_ms/background", MillisecondBuckets());
+  metrics::Counter* rejected_background_tasks = metrics::NewCounter(
+      "/tfrt/jitrt/compilation/rejected_background_tasks");
+};
+}  // namespace
+
+//===----------------------------------------------------------------------===//
+// CompilationExecutor.
+//===----------------------------------------------------------------------===//
+
+CompilationExecutor& CompilationExecutor::Default() {
+  static auto* executor = [] {
+    int num_threads =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / 4);
+    const char* env = std::getenv("TFRT_JITRT_COMPILATION_THREADS");
+    if (env != nullptr && std::atoi(env) > 0) num_threads = std::atoi(env);
+    return new CompilationExecutor(num_threads);
+  }();
+  return *executor;
+}
+
+CompilationExecutor::CompilationExecutor(int num_threads,
+                                         size_t max_pending_background)
+    : max_pending_background_(max_pending_background) {
+  threads_.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i)
+    threads_.push_back(ThreadingEnvironment::StartThread(
+        "tfrt-jitrt-compile", [this] { WorkerLoop(); }));
+}
+
+CompilationExecutor::~CompilationExecutor() {
+  {
+    mutex_lock lock(mu_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  threads_.clear();  // joins the threads
+}
+
+bool CompilationExecutor::Execute(Priority priority, Task task) {
+  {
+    mutex_lock lock(mu_);
+    if (priority == Priority::kBlocking) {
+      blocking_.push_back({std::move(task), Clock::now()});
+    } else if (background_.size() < max_pending_background_) {
+      background_.push_back({std::move(task), Clock::now()});
+    } else {
+      Metrics::Global().rejected_background_tasks->IncrementBy(1);
+      return false;
+    }
+  }
+  cv_.notify_all();
+  return true;
+}
+
+void CompilationExecutor::Quiesce() {
+  mutex_lock lock(mu_);
+  cv_.wait(lock, [this]() TFRT_REQUIRES(mu_) {
+    return blocking_.empty() && background_.empty() && num_running_ == 0;
+  });
+}
+
+void CompilationExecutor::WorkerLoop() {
+  Metrics& metrics = Metrics::Global();
+
+  while (true) {
+    PendingTask pending;
+    bool blocking;
+
+    {
+      mutex_lock lock(mu_);
+      cv_.wait(lock, [this]() TFRT_REQUIRES(mu_) {
+        return stopping_ || !blocking_.empty() || !background_.empty();
+      });
+
+      // Stopping and no pending tasks left.
+      if (blocking_.empty() && background_.empty()) return;
+
+      // Blocking tasks always go first.
+      blocking = !blocking_.empty();
+      std::deque<PendingTask>& queue = blocking ? blocking_ : background_;
+      pending = std::move(queue.front());
+      queue.pop_front();
+      ++num_running_;
+    }
+
+    (blocking ? metrics.blocking_queue_time : metrics.background_queue_time)
+        ->Record(ElapsedMs(pending.enqueued));
+    pending.task();
+    pending.task = nullptr;  // destroy captured state before Quiesce() returns
+
+    {
+      mutex_lock lock(mu_);
+      --num_running_;
+    }
+    cv_.notify_all();  // wake up Quiesce()
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// PassTimingMetrics.
+//===----------------------------------------------------------------------===//
+
+static metrics::Histogram* GetPassTimeHistogram(llvm::StringRef pass_name) {
+  static auto* mu = new mutex;
+  static auto* histograms = new llvm::StringMap<metrics::Histogram*>;
+
+  mutex_lock lock(*mu);
+  metrics::Histogram*& histogram = (*histograms)[pass_name];
+  if (histogram == nullptr) {
+    histogram = metrics::NewHistogram(
+        ("/tfrt/jitrt/compilation/pass_time_ms/" + pass_name).str(),
+        MillisecondBuckets());
+  }
+  return histogram;
+}
+
+// Passes run on nested operations concurrently on multiple threads, but on
+// each thread they nest properly, so a stack of start times is enough.
+static llvm::SmallVectorImpl<Clock::time_point>& PassStartTimes() {
+  static thread_local llvm::SmallVector<Clock::time_point, 4> start_times;
+  return start_times;
+}
+
+void PassTimingMetrics::runBeforePass(mlir::Pass* pass, mlir::Operation* op) {
+  PassStartTimes().push_back(Clock::now());
+}
+
+void PassTimingMetrics::runAfterPass(mlir::Pass* pass, mlir::Operation* op) {
+  Clock::time_point start = PassStartTimes().pop_back_val();
+  GetPassTimeHistogram(pass->getName())->Record(ElapsedMs(start));
+}
+
+void PassTimingMetrics::runAfterPassFailed(mlir::Pass* pass,
+                                           mlir::Operation* op) {
+  runAfterPass(pass, op);
+}
+
+}  // namespace jitrt
+}  // namespace tfrt
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- async_custom_call.cc - ---------------------------------------------===//
+// Custom calls returning async tokens.
+//===----------------------------------------------------------------------===//
+
+#include "tfrt/jitrt/custom_calls/async_custom_call.h"
+
+#include <utility>
+
+#include "mlir/Dialect/Async/IR/AsyncTypes.h"
+#include "third_party/tensorflow/compiler/xla/mlir/runtime/transforms/custom_call_encoding.h"
+#include "third_party/tensorflow/compiler/xla/runtime/async_runtime.h"
+
+XLA_RUNTIME_DEFINE_EXPLICIT_TYPE_ID(mlir::runtime::AsyncToken);
+
+namespace tfrt {
+namespace jitrt {
+
+using xla::runtime::AsyncRuntime;
+using xla::runtime::CustomCallRetEncodingSet;
+using xla::runtime::OpaqueRetEncoding;
+using xla::runtime::Tagged;
+using xla::runtime::TypeID;
+using xla::runtime::TypeIDNameRegistry;
+
+mlir::runtime::AsyncToken* ConvertChainToAsyncToken(
+    AsyncValueRef<Chain> chain) {
+  // Async tokens are created with a reference count of 2, one reference is
+  // returned to the caller, and the other one is dropped when the token is
+  // set available (or an error).
+  mlir::runtime::AsyncToken* token = AsyncRuntime::CreateToken();
+
+  chain.AndThen([token, chain = chain.CopyRef()] {
+    if (chain.IsError()) {
+      AsyncRuntime::SetError(token);
+    } else {
+      AsyncRuntime::SetAvailable(token);
+    }
+  });
+
+  return token;
+}
+
+void PopulateAsyncCustomCallTypeIdNames(TypeIDNameRegistry& registry) {
+  registry.Register<Tagged<mlir::runtime::AsyncToken>>(
+      "__type_id_async_token");
+}
+
+void PopulateAsyncCustomCallRetEncoding(CustomCallRetEncodingSet& encoding) {
+  encoding.Add<OpaqueRetEncoding>(
+      [](mlir::Type type) { return type.isa<mlir::async::TokenType>(); },
+      TypeID::get<Tagged<mlir::runtime::AsyncToken>>());
+}
+
+}  // namespace jitrt
+}  // namespace tfrt
@@ -25,6 +25,10 @@
 
 #include "llvm_derived/Support/raw_ostream.h"
 #include "mlir/Support/LogicalResult.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/jitrt/custom_calls/async_custom_call.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/string_util.h"
 #include "third_party/tensorflow/compiler/xla/mlir/runtime/transforms/custom_call_encoding.h"
@@ -47,6 +51,7 @@ void PopulateCustomCallTypeIdNames(xla::runtime::TypeIDNameRegistry& registry) {
   registry.Register<Tagged<EnumType>>("__type_id_enumtype");
   registry.Register<Tagged<RuntimeEnumType>>("__type_id_runtime_enumtype");
   registry.Register<Tagged<RuntimePairOfDims>>("__type_id_runtime_pairofdims");
+  PopulateAsyncCustomCallTypeIdNames(registry);
 }
 
 // Explicitly register attributes encoding for enums passed to the custom calls.
@@ -72,6 +77,10 @@ void PopulateCustomCallAttrEncoding(CustomCallAttrEncodingSet& encoding) {
                     .Add("b", &PairOfDimsAttr::getB));
 }
 
+void PopulateCustomCallRetEncoding(CustomCallRetEncodingSet& encoding) {
+  PopulateAsyncCustomCallRetEncoding(encoding);
+}
+
 static std::string StringifyEnumType(RuntimeEnumType value) {
   switch (value) {
     case RuntimeEnumType::kFoo:
@@ -89,21 +98,52 @@ static LogicalResult NoOp(FlatMemrefView, FlatMemrefView, FlatMemrefView,
   return success();
 }
 
-static absl::Status Multiply(MemrefView input, MemrefView output, float cst) {
+static absl::Status CheckMultiplyArgs(MemrefView input, MemrefView output) {
   // TODO(ezhulenev): Support all floating point dtypes.
   if (input.dtype != output.dtype || input.sizes != output.sizes ||
       input.dtype != xla::PrimitiveType::F32)
     return absl::InvalidArgumentError("Unsupported floating point dtype");
+  return absl::OkStatus();
+}
+
+static void MultiplyData(const float* input, float* output,
+                         int64_t num_elements, float cst) {
+  for (int64_t i = 0; i < num_elements; ++i) output[i] = input[i] * cst;
+}
+
+static absl::Status Multiply(MemrefView input, MemrefView output, float cst) {
+  if (auto status = CheckMultiplyArgs(input, output); !status.ok())
+    return status;
+
+  int64_t num_elements = 1;
+  for (int64_t d : input.sizes) num_elements *= d;
+
+  MultiplyData(reinterpret_cast<const float*>(input.data),
+               reinterpret_cast<float*>(output.data), num_elements, cst);
+  return absl::OkStatus();
+}
+
+// Multiplies on the blocking work queue, and returns a token that becomes
+// available when the output is ready.
+static absl::Status AsyncMultiply(
+    HostContext* host, MemrefView input, MemrefView output, float cst,
+    CustomCall::Result<mlir::runtime::AsyncToken*> done) {
+  if (auto status = CheckMultiplyArgs(input, output); !status.ok())
+    return status;
 
   int64_t num_elements = 1;
   for (int64_t d : input.sizes) num_elements *= d;
 
-  float* input_data = reinterpret_cast<float*>(input.data);
+  // Memref views are only valid until we return, capture just the data.
+  const float* input_data = reinterpret_cast<const float*>(input.data);
   float* output_data = reinterpret_cast<float*>(output.data);
 
-  for (int64_t i = 0; i < num_elements; ++i)
-    output_data[i] = input_data[i] * cst;
+  AsyncValueRef<Chain> chain = EnqueueBlockingWork(host, [=] {
+    MultiplyData(input_data, output_data, num_elements, cst);
+    return Chain();
+  });
 
+  done.Set(ConvertChainToAsyncToken(std::move(chain)));
   return absl::OkStatus();
 }
 
@@ -378,6 +418,14 @@ void RegisterDynamicCustomCallTestLib(DynamicCustomCallRegistry& registry) {
                         .Value(3.0)         // cst
                         .To(Multiply));
 
+  registry.Register(CustomCall::Bind("testlib.async_multiply")
+                        .UserData<HostContext*>()
+                        .Arg<MemrefView>()  // input
+                        .Arg<MemrefView>()  // output
+                        .Attr<float>("cst")
+                        .Ret<mlir::runtime::AsyncToken*>()
+                        .To(AsyncMultiply));
+
   registry.Register(CustomCall::Bind("testlib.print_attrs", {false})
                         .UserData<const char*>()
                         .Attr<int32_t>("i32")
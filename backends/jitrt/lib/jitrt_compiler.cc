@@ -23,6 +23,8 @@
 #include <memory>
 #include <utility>
 
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Host.h"
 #include "mlir/Conversion/AffineToStandard/AffineToStandard.h"
 #include "mlir/Conversion/AsyncToLLVM/AsyncToLLVM.h"
 #include "mlir/Conversion/ComplexToLLVM/ComplexToLLVM.h"
@@ -52,6 +54,7 @@
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
 #include "mlir/Target/LLVMIR/Dialect/X86Vector/X86VectorToLLVMIRTranslation.h"
 #include "mlir/Transforms/Passes.h"
+#include "tfrt/jitrt/compilation_executor.h"
 #include "tfrt/jitrt/transforms/codegen_passes.h"
 #include "third_party/tensorflow/compiler/xla/mlir/memref/transforms/passes.h"
 #include "third_party/tensorflow/compiler/xla/mlir/runtime/transforms/compiler.h"
@@ -86,6 +89,20 @@ void RegisterDefaultJitRtDialects(xla::runtime::DialectRegistry& dialects) {
   mlir::tensor::registerInferTypeOpInterfaceExternalModels(*dialects);
 }
 
+const HostCpuFeatures& HostCpuFeatures::Get() {
+  static const HostCpuFeatures* features = [] {
+    auto* features = new HostCpuFeatures;
+    llvm::StringMap<bool> host;
+    if (!llvm::sys::getHostCPUFeatures(host)) return features;
+    features->avx2 = host.lookup("avx2");
+    features->avx512f = host.lookup("avx512f");
+    features->amx_tile = host.lookup("amx-tile");
+    features->neon = host.lookup("neon");
+    return features;
+  }();
+  return *features;
+}
+
 void CreateDefaultJitRtCompilationPipeline(
     mlir::OpPassManager& pm, const CompilationPipelineOptions& opts) {
   // Convert entry function to the XLA entrypoint.
@@ -112,7 +129,8 @@ void CreateDefaultJitRtCompilationPipeline(
   if (opts.num_worker_threads > 1) {
     pm.addPass(CreateCostDrivenAsyncParallelForPass(
         /*asyncDispatch=*/false, /*numWorkerThreads=*/opts.num_worker_threads,
-        /*legacyBehavior=*/!opts.cost_driven_async_parallel_for));
+        /*legacyBehavior=*/!opts.cost_driven_async_parallel_for,
+        /*runtimeParallelism=*/opts.runtime_async_parallelism));
 
     // Run canonicalization after async-parallel-for pass to remove async
     // operations that are not needed for executing small and cheap loops.
@@ -144,8 +162,8 @@ void CreateDefaultJitRtCompilationPipeline(
   // Convert runtime operations and custom calls to LLVM dialect.
   xla::runtime::ConvertRuntimeToLLvmOpts rt_opts = {
       opts.populate_type_id_names, opts.populate_type_conversions,
-      opts.populate_arg_encodings,
-      /*populate_ret_encodings=*/{}, opts.populate_attr_encodings};
+      opts.populate_arg_encodings, opts.populate_ret_encodings,
+      opts.populate_attr_encodings};
   pm.addPass(xla::runtime::CreateConvertRuntimeToLLVMPass(std::move(rt_opts)));
 
   // Convert async dialect to LLVM once everything else is in the LLVM dialect.
@@ -159,7 +177,9 @@ void CreateDefaultJitRtCompilationPipeline(
   pm.addPass(mlir::createConvertMathToLibmPass());
 
   mlir::LowerVectorToLLVMOptions vector_to_llvm_opts;
-  if (opts.math_avx2) vector_to_llvm_opts.enableX86Vector();
+  if (opts.math_avx2 || opts.avx512) vector_to_llvm_opts.enableX86Vector();
+  if (opts.amx) vector_to_llvm_opts.enableAMX();
+  if (opts.arm_neon) vector_to_llvm_opts.enableArmNeon();
   pm.addPass(mlir::createConvertVectorToLLVMPass(vector_to_llvm_opts));
   pm.addPass(mlir::createMemRefToLLVMConversionPass());
   pm.addPass(mlir::createConvertFuncToLLVMPass());
@@ -173,6 +193,7 @@ void CreateDefaultJitRtCompilationPipeline(
 
 void CreateDefaultJitRtCompilationPipeline(
     xla::runtime::PassManager& passes, const CompilationPipelineOptions& opts) {
+  passes->addInstrumentation(std::make_unique<PassTimingMetrics>());
   CreateDefaultJitRtCompilationPipeline(*passes, opts);
 }
 
@@ -25,6 +25,7 @@
 #include <memory>
 #include <utility>
 
+#include "llvm/ADT/Hashing.h"
 #include "tfrt/core_runtime/core_runtime.h"
 #include "tfrt/core_runtime/tensor_handle.h"
 #include "tfrt/host_context/async_dispatch.h"
@@ -39,11 +40,13 @@
 #include "tfrt/host_context/shared_context.h"
 #include "tfrt/jitrt/arguments.h"
 #include "tfrt/jitrt/async_task_runner.h"
+#include "tfrt/jitrt/compilation_executor.h"
 #include "tfrt/jitrt/jitrt_compiler.h"
 #include "tfrt/jitrt/results.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/rc_array.h"
 #include "tfrt/support/ref_count.h"
+#include "tfrt/tensor/dense_host_tensor.h"
 #include "tfrt/tensor/tensor.h"
 #include "tfrt/tensor/tensor_metadata.h"
 #include "third_party/tensorflow/compiler/xla/runtime/arguments.h"
@@ -78,13 +81,13 @@ static AsyncValueRef<JitExecutable> Compile(CompilationUnitAttribute kernel,
     return EmitErrorAsync(
         exec_ctx, "compiled kernel must be referenced by one nested symbol");
 
-  ResourceContext* res_ctx = exec_ctx.resource_context();
-  auto* jit_executable_cache =
-      res_ctx->GetOrCreateResource<JitExecutableCache>("jitrt.cache");
+  // Executables are shared by all BEF files and host contexts in the process,
+  // so identical kernels in different models are compiled only once.
+  static auto* jit_executable_cache = new JitExecutableCache();
 
-  // TODO(ezhulenev): Compute cache key based on the content of MLIR module, or
-  // better keep module fingerprint in the BEF file.
-  intptr_t key = exec_ctx.location().data;
+  // The compilation pipeline depends on the number of worker threads.
+  size_t key = llvm::hash_combine(kernel.fingerprint(),
+                                  host->GetNumWorkerThreads());
 
   // Maybe return JitExecutable from the cache.
   if (auto cached = jit_executable_cache->Find(key)) return cached.CopyRef();
@@ -95,12 +98,15 @@ static AsyncValueRef<JitExecutable> Compile(CompilationUnitAttribute kernel,
   // We lost the race; some other invocation will do the compilation.
   if (!entry.allocated) return entry.ptr.CopyRef();
 
-  // Compile kernel asynchronously in the host context thread pool.
-  EnqueueWork(exec_ctx, [kernel, host, ref = entry.ptr.CopyRef()]() {
+  // Compile kernel asynchronously on the compilation executor. A request waits
+  // for the result, so it runs before the background compilations.
+  auto compile = [kernel, host, ref = entry.ptr.CopyRef()]() {
     CompilationPipelineOptions copts;
     copts.num_worker_threads = host->GetNumWorkerThreads();
+    copts.runtime_async_parallelism = true;
 
     JitExecutable::Options opts;
+    opts.compiler.symbols_binding = AsyncParallelismSymbolsBinding();
     opts.compiler.register_dialects = RegisterDefaultJitRtDialects;
     opts.compiler.create_compilation_pipeline =
         [copts](xla::runtime::PassManager& passes) {
@@ -119,7 +125,11 @@ static AsyncValueRef<JitExecutable> Compile(CompilationUnitAttribute kernel,
       ref.SetError(jit_executable.status());
     else
       ref.emplace(std::move(*jit_executable));
-  });
+  };
+  bool enqueued = CompilationExecutor::Default().Execute(
+      CompilationExecutor::Priority::kBlocking, std::move(compile));
+  if (!enqueued)
+    entry.ptr.SetError(absl::InternalError("failed to enqueue compilation"));
 
   return entry.ptr.CopyRef();
 }
@@ -129,8 +139,10 @@ static AsyncValueRef<JitExecutable> Compile(CompilationUnitAttribute kernel,
 // -------------------------------------------------------------------------- //
 
 namespace {
-// We do not record any operands information for results conversion.
-struct ConversionCtx {};
+// Dense host tensor operands, results can forward their buffers.
+struct ConversionCtx {
+  llvm::SmallVector<const DenseHostTensor*, 4> operands;
+};
 
 // Use HostContextAsyncTaskRunner to execute all async tasks.
 struct AsyncTaskRunnerContext : public SharedContext {
@@ -140,16 +152,14 @@ struct AsyncTaskRunnerContext : public SharedContext {
 }  // namespace
 
 static Error ConvertTensorHandleOperandsToMemrefDesc(
-    RepeatedArguments<TensorHandle> operands,
+    RepeatedArguments<TensorHandle> operands, MemrefDescPlan& plan,
     llvm::SmallVectorImpl<MemrefDesc>* memrefs) {
   assert(memrefs->empty() && "memrefs must be empty");
   memrefs->reserve(operands.size());
 
   for (unsigned i = 0; i < operands.size(); ++i) {
     const Tensor& tensor = operands[i].GetAsyncTensor()->get<Tensor>();
-    Expected<MemrefDesc> memref = ConvertTensorToMemrefDesc(tensor);
-    if (auto err = memref.takeError()) return err;
-    memrefs->push_back(std::move(*memref));
+    if (auto err = plan.Append(i, tensor, memrefs)) return err;
   }
 
   return Error::success();
@@ -169,9 +179,16 @@ static void ExecuteImpl(const Executable& executable,
   // Execute compiled kernel and get back raw return values that we'll need to
   // wrap into TensorHandles later on.
   ConversionCtx conversion_ctx;
+  for (unsigned i = 0; i < operands.size(); ++i) {
+    const Tensor& tensor = operands[i].GetAsyncTensor()->get<Tensor>();
+    if (auto* dht = dyn_cast<DenseHostTensor>(&tensor))
+      conversion_ctx.operands.push_back(dht);
+  }
+
   RemainingResultsConverter<ConversionCtx> converter{
       RemainingResults(kernel_ret), conversion_ctx};
-  converter.AddConversion(ReturnMemrefAsDenseHostTensor<ConversionCtx>);
+  converter.AddConversion(
+      ReturnMemrefAsDenseHostTensorOrOperand<ConversionCtx>);
   converter.AddConversion(ReturnAsyncMemrefAsDenseHostTensor<ConversionCtx>);
 
   // Use HostContext to execute all async tasks.
@@ -180,6 +197,9 @@ static void ExecuteImpl(const Executable& executable,
   Executable::ExecuteOpts opts;
   opts.async_task_runner = &runner_ctx.runner;
 
+  // Let parallel loops see the load of the runner.
+  HostContextAsyncTaskRunner::ExecutionScope scope(&runner_ctx.runner);
+
   // We skip error handling at this point and rely on error forwarding to the
   // kernel results below.
   auto err = executable.Execute(memrefs, converter, opts);
@@ -232,14 +252,29 @@ static void Execute(KernelArgument<JitExecutable> jit_executable,
                     RemainingResults results,
                     const ExecutionContext& exec_ctx) {
   // Extract tensors from tensor handle operands to pass them as the compiled
-  // kernel arguments.
+  // kernel arguments, reusing the sizes and strides of the previous call on
+  // this thread if the operand shapes did not change.
+  MemrefDescPlan& plan = MemrefDescPlan::GetThreadLocal(&*jit_executable);
   llvm::SmallVector<MemrefDesc, 4> memrefs;
-  if (auto err = ConvertTensorHandleOperandsToMemrefDesc(operands, &memrefs))
+  if (auto err =
+          ConvertTensorHandleOperandsToMemrefDesc(operands, plan, &memrefs))
     return ReturnErrors(results, std::move(err));
 
+  // Compiles the specialization for the operand shapes in the background.
+  auto specialize = [jit_executable = jit_executable.ValueRef(),
+                     o = RCArray<AsyncValue>(operands.values())]()
+      -> absl::StatusOr<AsyncValuePtr<Executable>> {
+    MemrefDescPlan plan;
+    llvm::SmallVector<MemrefDesc, 4> memrefs;
+    if (auto err = ConvertTensorHandleOperandsToMemrefDesc(
+            RepeatedArguments<TensorHandle>(o.values()), plan, &memrefs))
+      return absl::InternalError(toString(std::move(err)));
+    return jit_executable->GetExecutable(memrefs);
+  };
+
   // Get an executable that might be specialized to the operands.
-  absl::StatusOr<AsyncValuePtr<Executable>> executable =
-      jit_executable->GetExecutable(memrefs);
+  absl::StatusOr<AsyncValuePtr<Executable>> executable = GetTieredExecutable(
+      *jit_executable, memrefs, exec_ctx.host(), std::move(specialize));
   if (!executable.ok())
     return ReturnErrors(results,
                         MakeStringError(executable.status().message()));
@@ -25,6 +25,7 @@
 #include <string>
 #include <utility>
 
+#include "llvm/ADT/Hashing.h"
 #include "tfrt/dtype/dtype.h"
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/async_value.h"
@@ -39,9 +40,11 @@
 #include "tfrt/host_context/shared_context.h"
 #include "tfrt/jitrt/arguments.h"
 #include "tfrt/jitrt/async_task_runner.h"
+#include "tfrt/jitrt/compilation_executor.h"
 #include "tfrt/jitrt/custom_calls/custom_call_testlib.h"
 #include "tfrt/jitrt/jitrt_compiler.h"
 #include "tfrt/jitrt/results.h"
+#include "tfrt/jitrt/tiered_execution.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/rc_array.h"
@@ -56,6 +59,7 @@
 #include "third_party/tensorflow/compiler/xla/runtime/custom_call_registry.h"
 #include "third_party/tensorflow/compiler/xla/runtime/diagnostics.h"
 #include "third_party/tensorflow/compiler/xla/runtime/executable.h"
+#include "third_party/tensorflow/compiler/xla/runtime/execution_engine.h"
 #include "third_party/tensorflow/compiler/xla/runtime/jit_executable.h"
 #include "third_party/tensorflow/compiler/xla/runtime/types.h"
 
@@ -70,6 +74,7 @@ using xla::runtime::CustomCall;
 using xla::runtime::Diagnostic;
 using xla::runtime::DiagnosticEngine;
 using xla::runtime::Executable;
+using xla::runtime::ExecutionEngine;
 using xla::runtime::JitExecutable;
 using xla::runtime::MemrefDesc;
 
@@ -88,13 +93,13 @@ static AsyncValueRef<JitExecutable> Compile(CompilationUnitAttribute kernel,
     return EmitErrorAsync(
         exec_ctx, "compiled kernel must be referenced by one nested symbol");
 
-  ResourceContext* res_ctx = exec_ctx.resource_context();
-  auto* jit_executable_cache =
-      res_ctx->GetOrCreateResource<JitExecutableCache>("jitrt.cache");
+  // Executables are shared by all BEF files and host contexts in the process,
+  // so identical kernels in different models are compiled only once.
+  static auto* jit_executable_cache = new JitExecutableCache();
 
-  // TODO(ezhulenev): Compute cache key based on the content of MLIR module, or
-  // better keep module fingerprint in the BEF file.
-  intptr_t key = exec_ctx.location().data;
+  // The compilation pipeline depends on the number of worker threads.
+  size_t key = llvm::hash_combine(kernel.fingerprint(),
+                                  host->GetNumWorkerThreads());
 
   // Maybe return JitExecutable from the cache.
   if (auto cached = jit_executable_cache->Find(key)) return cached.CopyRef();
@@ -105,16 +110,21 @@ static AsyncValueRef<JitExecutable> Compile(CompilationUnitAttribute kernel,
   // We lost the race; some other invocation will do the compilation.
   if (!entry.allocated) return entry.ptr.CopyRef();
 
-  // Compile kernel asynchronously in the host context thread pool.
-  EnqueueWork(exec_ctx, [kernel, host, ref = entry.ptr.CopyRef()]() {
+  // Compile kernel asynchronously on the compilation executor. A request waits
+  // for the result, so it runs before the background compilations.
+  auto compile = [kernel, host, ref = entry.ptr.CopyRef()]() {
     CompilationPipelineOptions copts;
     copts.num_worker_threads = host->GetNumWorkerThreads();
+    copts.runtime_async_parallelism = true;
     copts.populate_type_id_names = PopulateCustomCallTypeIdNames;
     copts.populate_attr_encodings = PopulateCustomCallAttrEncoding;
+    copts.populate_ret_encodings = PopulateCustomCallRetEncoding;
 
     JitExecutable::Options opts;
-    opts.compiler.symbols_binding = ToSymbolsBinding(
-        RegisterDirectCustomCallTestLib, PopulateCustomCallTypeIdNames);
+    opts.compiler.symbols_binding = ExecutionEngine::BindAll(
+        {ToSymbolsBinding(RegisterDirectCustomCallTestLib,
+                          PopulateCustomCallTypeIdNames),
+         AsyncParallelismSymbolsBinding()});
 
     opts.compiler.register_dialects =
         [](xla::runtime::DialectRegistry& dialects) {
@@ -139,7 +149,11 @@ static AsyncValueRef<JitExecutable> Compile(CompilationUnitAttribute kernel,
       ref.SetError(jit_executable.status());
     else
       ref.emplace(std::move(*jit_executable));
-  });
+  };
+  bool enqueued = CompilationExecutor::Default().Execute(
+      CompilationExecutor::Priority::kBlocking, std::move(compile));
+  if (!enqueued)
+    entry.ptr.SetError(absl::InternalError("failed to enqueue compilation"));
 
   return entry.ptr.CopyRef();
 }
@@ -149,8 +163,10 @@ static AsyncValueRef<JitExecutable> Compile(CompilationUnitAttribute kernel,
 // -------------------------------------------------------------------------- //
 
 namespace {
-// We do not record any operands information for results conversion.
-struct ConversionCtx {};
+// Dense host tensor operands, results can forward their buffers.
+struct ConversionCtx {
+  llvm::SmallVector<const DenseHostTensor*, 4> operands;
+};
 
 // Use HostContextAsyncTaskRunner to execute all async tasks.
 struct AsyncTaskRunnerContext : public SharedContext {
@@ -160,16 +176,13 @@ struct AsyncTaskRunnerContext : public SharedContext {
 }  // namespace
 
 static Error ConvertTensorOperandsToMemrefDesc(
-    RepeatedArguments<Tensor> operands,
+    RepeatedArguments<Tensor> operands, MemrefDescPlan& plan,
     llvm::SmallVectorImpl<MemrefDesc>* memrefs) {
   assert(memrefs->empty() && "memrefs must be empty");
   memrefs->reserve(operands.size());
 
-  for (unsigned i = 0; i < operands.size(); ++i) {
-    Expected<MemrefDesc> memref = ConvertTensorToMemrefDesc(operands[i]);
-    if (auto err = memref.takeError()) return err;
-    memrefs->push_back(std::move(*memref));
-  }
+  for (unsigned i = 0; i < operands.size(); ++i)
+    if (auto err = plan.Append(i, operands[i], memrefs)) return err;
 
   return Error::success();
 }
@@ -189,6 +202,7 @@ static void ExecuteImpl(const Executable& executable,
   static const char* kCaller = "Called from: jitrt.execute";
   CustomCall::UserData custom_call_data;
   custom_call_data.insert(kCaller);
+  custom_call_data.insert(host);  // for async custom calls
 
   // Collect all emitted diagnostic messages.
   DiagnosticEngine diagnostic_engine;
@@ -215,12 +229,19 @@ static void ExecuteImpl(const Executable& executable,
 
   // If execution failed errors will be automatically allocated for all results.
   ConversionCtx conversion_ctx;
+  for (unsigned i = 0; i < operands.size(); ++i)
+    if (auto* dht = dyn_cast<DenseHostTensor>(&operands[i]))
+      conversion_ctx.operands.push_back(dht);
+
   RemainingResultsConverter<ConversionCtx> converter(results, conversion_ctx,
                                                      std::move(augment_errors));
   converter.AddConversion(ReturnAsyncToken<ConversionCtx>);
   converter.AddConversion(ReturnAsyncMemrefAsDenseHostTensor<ConversionCtx>);
-  converter.AddConversion(ReturnMemrefAsDenseHostTensor<ConversionCtx>);
+  converter.AddConversion(
+      ReturnMemrefAsDenseHostTensorOrOperand<ConversionCtx>);
 
+  // Let parallel loops see the load of the runner.
+  HostContextAsyncTaskRunner::ExecutionScope scope(&runner_ctx.runner);
   if (auto st = executable.Execute(memrefs, converter, opts); !st.ok()) return;
 
   // Keep operands alive if we have unavailable results.
@@ -233,14 +254,29 @@ static void Execute(KernelArgument<JitExecutable> jit_executable,
                     RepeatedArguments<Tensor> operands,
                     RemainingResults results,
                     const ExecutionContext& exec_ctx) {
-  // Extract Memrefs from Tensor operands.
+  // Extract Memrefs from Tensor operands, reusing the sizes and strides of the
+  // previous call on this thread if the operand shapes did not change.
+  MemrefDescPlan& plan = MemrefDescPlan::GetThreadLocal(&*jit_executable);
   llvm::SmallVector<MemrefDesc, 4> memrefs;
-  if (auto err = ConvertTensorOperandsToMemrefDesc(operands, &memrefs))
+  if (auto err = ConvertTensorOperandsToMemrefDesc(operands, plan, &memrefs))
     return ReturnErrors(results, std::move(err));
 
+  // Compiles the specialization for the operand shapes in the background.
+  auto specialize = [jit_executable = jit_executable.ValueRef(),
+                     o = RCArray<AsyncValue>(operands.values())]()
+      -> absl::StatusOr<AsyncValuePtr<Executable>> {
+    MemrefDescPlan plan;
+    llvm::SmallVector<MemrefDesc, 4> memrefs;
+    if (auto err = ConvertTensorOperandsToMemrefDesc(
+            RepeatedArguments<Tensor>(o.values()), plan, &memrefs))
+      return absl::InternalError(toString(std::move(err)));
+    return jit_executable->GetExecutable(memrefs);
+  };
+
   // Get an executable that might be specialized to the operands.
-  absl::StatusOr<AsyncValuePtr<Executable>> executable =
-      jit_executable->GetExecutable(memrefs);
+  absl::StatusOr<AsyncValuePtr<Executable>> executable = GetTieredExecutable(
+      *jit_executable, memrefs, CompilationExecutor::Default(),
+      std::move(specialize));
   if (!executable.ok())
     return ReturnErrors(results,
                         MakeStringError(executable.status().message()));
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- object_cache.cc - --------------------------------------------------===//
+// Persistent cache of object files compiled by JitRt.
+//===----------------------------------------------------------------------===//
+
+#include "tfrt/jitrt/object_cache.h"
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
+#include "third_party/tensorflow/compiler/xla/mlir/runtime/transforms/compiler.h"
+
+namespace tfrt {
+namespace jitrt {
+
+using xla::runtime::Executable;
+using xla::runtime::JitExecutable;
+
+std::string CompilationFingerprint(string_view module, string_view entrypoint,
+                                   const CompilationPipelineOptions& opts) {
+  std::string data;
+  llvm::raw_string_ostream os(data);
+
+  // Prefix strings with their size to keep the encoding unambiguous.
+  auto add = [&](string_view str) { os << str.size() << ':' << str << ';'; };
+
+  add(module);
+  add(entrypoint);
+  os << opts.alignment << ';' << opts.num_worker_threads << ';'
+     << opts.cost_driven_async_parallel_for << ';'
+     << opts.runtime_async_parallelism << ';' << opts.math_avx2 << ';'
+     << opts.avx512 << ';' << opts.amx << ';' << opts.arm_neon << ';';
+
+  // Object files are compiled for the host CPU.
+  add(llvm::sys::getHostCPUName());
+  llvm::StringMap<bool> features;
+  if (llvm::sys::getHostCPUFeatures(features)) {
+    // StringMap iteration order is unspecified, sort the enabled features.
+    std::vector<string_view> enabled;
+    for (const auto& feature : features)
+      if (feature.getValue()) enabled.push_back(feature.getKey());
+    llvm::sort(enabled);
+    for (string_view feature : enabled) add(feature);
+  }
+
+  return llvm::toHex(llvm::SHA1::hash(llvm::arrayRefFromStringRef(os.str())),
+                     /*LowerCase=*/true);
+}
+
+ObjectCache::ObjectCache(std::string directory)
+    : directory_(std::move(directory)) {}
+
+const ObjectCache* ObjectCache::Default() {
+  static const ObjectCache* cache = []() -> ObjectCache* {
+    const char* directory = std::getenv("TFRT_JITRT_OBJECT_CACHE_DIR");
+    if (directory == nullptr || *directory == '\0') return nullptr;
+    return new ObjectCache(directory);
+  }();
+  return cache;
+}
+
+std::string ObjectCache::GetPath(string_view fingerprint) const {
+  llvm::SmallString<128> path(directory_);
+  llvm::sys::path::append(path, fingerprint + ".o");
+  return std::string(path);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> ObjectCache::Lookup(
+    string_view fingerprint) const {
+  auto buffer = llvm::MemoryBuffer::getFile(GetPath(fingerprint),
+                                            /*IsText=*/false,
+                                            /*RequiresNullTerminator=*/false);
+  if (!buffer) return nullptr;
+  return std::move(*buffer);
+}
+
+llvm::Error ObjectCache::Insert(string_view fingerprint,
+                                llvm::MemoryBufferRef obj_file) const {
+  if (auto ec = llvm::sys::fs::create_directories(directory_))
+    return llvm::errorCodeToError(ec);
+
+  std::string path = GetPath(fingerprint);
+  int fd;
+  llvm::SmallString<128> temp_path;
+  if (auto ec =
+          llvm::sys::fs::createUniqueFile(path + ".tmp-%%%%%%", fd, temp_path))
+    return llvm::errorCodeToError(ec);
+
+  {
+    llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+    os << obj_file.getBuffer();
+    os.close();
+    if (os.has_error()) {
+      llvm::sys::fs::remove(temp_path);
+      return llvm::errorCodeToError(os.error());
+    }
+  }
+
+  if (auto ec = llvm::sys::fs::rename(temp_path, path)) {
+    llvm::sys::fs::remove(temp_path);
+    return llvm::errorCodeToError(ec);
+  }
+  return llvm::Error::success();
+}
+
+absl::StatusOr<Executable> LoadCachedExecutable(
+    const ObjectCache& cache, string_view fingerprint, string_view module,
+    string_view entrypoint, const JitExecutable::Options& opts) {
+  std::unique_ptr<llvm::MemoryBuffer> obj_file = cache.Lookup(fingerprint);
+  if (!obj_file)
+    return absl::NotFoundError("object file is not in the cache");
+
+  // Parse the module to recover the entrypoint signatures, which are not
+  // stored in the object file.
+  xla::runtime::DialectRegistry dialects;
+  if (opts.compiler.register_dialects)
+    opts.compiler.register_dialects(dialects);
+  mlir::MLIRContext context(*dialects);
+
+  mlir::OwningOpRef<mlir::ModuleOp> parsed =
+      mlir::parseSourceString<mlir::ModuleOp>(module, &context);
+  if (!parsed) return absl::InvalidArgumentError("failed to parse the module");
+
+  auto func = parsed->lookupSymbol<mlir::func::FuncOp>(entrypoint);
+  if (!func)
+    return absl::InvalidArgumentError("entrypoint function not found");
+
+  mlir::FunctionType type = func.getFunctionType();
+  auto signature = opts.compiler.type_converter.Convert(type);
+  if (!signature.ok()) return signature.status();
+
+  auto rt_signature = opts.compiler.type_converter.Convert(
+      opts.compiler.calling_convention(type));
+  if (!rt_signature.ok()) return rt_signature.status();
+
+  std::vector<Executable::LoadFunction> functions;
+  functions.push_back({std::string(entrypoint), std::move(*signature),
+                       std::move(*rt_signature)});
+
+  return Executable::LoadFromObjFile(
+      std::string(entrypoint), std::move(obj_file), std::move(functions),
+      opts.compiler.symbols_binding, "jitrt_object_cache");
+}
+
+llvm::Error InsertCachedExecutable(const ObjectCache& cache,
+                                   string_view fingerprint,
+                                   const Executable& executable) {
+  std::unique_ptr<llvm::MemoryBuffer> obj_file = executable.obj_file();
+  if (!obj_file) {
+    return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                   "executable has no object file");
+  }
+  return cache.Insert(fingerprint, obj_file->getMemBufferRef());
+}
+
+}  // namespace jitrt
+}  // namespace tfrt
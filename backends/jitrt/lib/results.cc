@@ -84,6 +84,39 @@ struct ConvertDenseHostTensor {
                                                  std::move(deallocator)));
   }
 };
+
+// Converts StridedMemref to the DenseHostTensor that shares the buffer of the
+// operand the memref points into, or to a new DenseHostTensor if the memref was
+// allocated by the compiled function.
+struct ConvertDenseHostTensorOrOperand {
+  using ResultType = DenseHostTensor;
+  using ConversionContext = ArrayRef<const DenseHostTensor*>;
+
+  template <typename T, int rank>
+  static DenseHostTensor Convert(ConversionContext& operands,
+                                 void* memref_ptr) {
+    auto* memref = static_cast<StridedMemRefType<T, rank>*>(memref_ptr);
+    TFRT_MSAN_MEMORY_IS_INITIALIZED(memref, sizeof(StridedMemRefType<T, rank>));
+    TensorMetadata metadata(GetDType<T>(), Sizes(memref));
+    size_t size = metadata.GetHostSizeInBytes();
+
+    auto* data = reinterpret_cast<const char*>(memref->data);
+    for (const DenseHostTensor* operand : operands) {
+      const RCReference<HostBuffer>& buffer = operand->buffer();
+      if (!buffer) continue;
+
+      auto* begin = static_cast<const char*>(buffer->data());
+      if (data < begin || data + size > begin + buffer->size()) continue;
+
+      return DenseHostTensor(metadata,
+                             HostBuffer::CreateFromExternal(
+                                 buffer.CopyRef(), data - begin, size));
+    }
+
+    ConversionCtx ctx;
+    return ConvertDenseHostTensor::Convert<T, rank>(ctx, memref_ptr);
+  }
+};
 }  // namespace
 
 namespace internal {
@@ -122,6 +155,14 @@ mlir::LogicalResult ReturnMemrefAsDenseHostTensor(RemainingResults results,
       ctx, results, result_index, type, runtime_type, result_ptr);
 }
 
+mlir::LogicalResult ReturnMemrefAsDenseHostTensorOrOperand(
+    ArrayRef<const DenseHostTensor*> operands, RemainingResults results,
+    unsigned result_index, const Type* type, const Type* runtime_type,
+    void* result_ptr) {
+  return ReturnStridedMemref<ConvertDenseHostTensorOrOperand>(
+      operands, results, result_index, type, runtime_type, result_ptr);
+}
+
 }  // namespace internal
 
 void ReturnErrors(RemainingResults results, Error error) {
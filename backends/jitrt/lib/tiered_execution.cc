@@ -0,0 +1,249 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//===- tiered_execution.cc - ----------------------------------------------===//
+// Tiered compilation of JitExecutable specializations.
+//===----------------------------------------------------------------------===//
+
+#include "tfrt/jitrt/tiered_execution.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <utility>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/xxhash.h"
+#include "tfrt/metrics/metrics.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace jitrt {
+
+using xla::runtime::Executable;
+using xla::runtime::JitExecutable;
+using xla::runtime::MemrefDesc;
+
+namespace {
+
+enum class Tier {
+  kCold,         // running the default executable, counting calls
+  kCompiling,    // running the default executable, specialization compiling
+  kSpecialized,  // running the specialization
+  kFailed,       // running the default executable, specialization failed
+};
+
+struct Metrics {
+  static Metrics& Global() {
+    static auto* instance = new Metrics;
+    return *instance;
+  }
+
+  metrics::Counter* default_calls =
+      metrics::NewCounter("/tfrt/jitrt/tiered_execution/default_calls");
+  metrics::Counter* specialized_calls =
+      metrics::NewCounter("/tfrt/jitrt/tiered_execution/specialized_calls");
+  metrics::Counter* compilations =
+      metrics::NewCounter("/tfrt/jitrt/tiered_execution/compilations");
+  metrics::Counter* compilation_failures = metrics::NewCounter(
+      "/tfrt/jitrt/tiered_execution/compilation_failures");
+  metrics::Counter* evicted_shapes =
+      metrics::NewCounter("/tfrt/jitrt/tiered_execution/evicted_shapes");
+  metrics::Gauge<int64_t>* code_bytes = metrics::NewGauge<int64_t>(
+      "/tfrt/jitrt/tiered_execution/code_bytes");
+};
+
+struct ShapeState {
+  int num_calls = 0;
+  Tier tier = Tier::kCold;
+  std::list<uint64_t>::iterator lru;  // only valid for kCold
+};
+
+// Tiers of the operand shapes seen by one JitExecutable.
+struct ExecutableTiers {
+  bool CanSpecialize() const {
+    return num_specializations < kMaxSpecializations &&
+           code_bytes < kMaxSpecializedCodeBytes;
+  }
+
+  llvm::DenseMap<uint64_t, ShapeState> shapes;
+  // Cold shapes, most recently used first. Shapes in other tiers are bounded
+  // by kMaxSpecializations and are never evicted.
+  std::list<uint64_t> lru;
+  // Specializations which are compiling, compiled or failed to compile.
+  int num_specializations = 0;
+  size_t code_bytes = 0;
+};
+
+// Tiers of all operand shapes seen by all JitExecutables. JitExecutables are
+// never removed, see the lifetime requirement in the header.
+class Tiers {
+ public:
+  using Key = std::pair<const JitExecutable*, uint64_t>;
+
+  static Tiers& Global() {
+    static auto* tiers = new Tiers;
+    return *tiers;
+  }
+
+  // Records a call and returns the tier it should run in. Returns kCompiling
+  // for the one call that must start compiling the specialization.
+  Tier RecordCall(const Key& key) {
+    mutex_lock lock(mu_);
+    ExecutableTiers& tiers = executables_[key.first];
+
+    auto it = tiers.shapes.find(key.second);
+    if (it == tiers.shapes.end()) {
+      if (tiers.lru.size() >= kMaxTrackedShapes) EvictColdShape(tiers);
+      it = tiers.shapes.try_emplace(key.second).first;
+      tiers.lru.push_front(key.second);
+      it->second.lru = tiers.lru.begin();
+    }
+
+    ShapeState& state = it->second;
+    if (state.tier != Tier::kCold) {
+      // Only the call which started compilation sees kCompiling.
+      return state.tier == Tier::kCompiling ? Tier::kCold : state.tier;
+    }
+
+    tiers.lru.splice(tiers.lru.begin(), tiers.lru, state.lru);
+    if (state.num_calls < kSpecializeAfterNumCalls) ++state.num_calls;
+    if (state.num_calls < kSpecializeAfterNumCalls || !tiers.CanSpecialize())
+      return Tier::kCold;
+
+    tiers.lru.erase(state.lru);
+    ++tiers.num_specializations;
+    state.tier = Tier::kCompiling;
+    return Tier::kCompiling;
+  }
+
+  // Records that the specialization for `key` is available.
+  void SetSpecialized(const Key& key, size_t code_bytes) {
+    mutex_lock lock(mu_);
+    ExecutableTiers& tiers = executables_[key.first];
+    tiers.shapes[key.second].tier = Tier::kSpecialized;
+    tiers.code_bytes += code_bytes;
+    total_code_bytes_ += code_bytes;
+    Metrics::Global().code_bytes->Set(total_code_bytes_);
+  }
+
+  // Records that the specialization for `key` failed to compile. It keeps
+  // counting towards kMaxSpecializations, so that shapes which fail to compile
+  // can't be retried without bound.
+  void SetFailed(const Key& key) {
+    mutex_lock lock(mu_);
+    executables_[key.first].shapes[key.second].tier = Tier::kFailed;
+  }
+
+  // Records that the specialization for `key` was not compiled after all, and
+  // returns the shape to the cold tier.
+  void SetCold(const Key& key) {
+    mutex_lock lock(mu_);
+    ExecutableTiers& tiers = executables_[key.first];
+    ShapeState& state = tiers.shapes[key.second];
+    state.num_calls = 0;
+    state.tier = Tier::kCold;
+    tiers.lru.push_front(key.second);
+    state.lru = tiers.lru.begin();
+    --tiers.num_specializations;
+  }
+
+ private:
+  void EvictColdShape(ExecutableTiers& tiers) TFRT_REQUIRES(mu_) {
+    tiers.shapes.erase(tiers.lru.back());
+    tiers.lru.pop_back();
+    Metrics::Global().evicted_shapes->IncrementBy(1);
+  }
+
+  mutex mu_;
+  llvm::DenseMap<const JitExecutable*, ExecutableTiers> executables_
+      TFRT_GUARDED_BY(mu_);
+  int64_t total_code_bytes_ TFRT_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace
+
+// Returns a hash of the operand element types and shapes.
+static uint64_t ShapeSignature(llvm::ArrayRef<MemrefDesc> memrefs) {
+  llvm::SmallVector<int64_t, 16> data;
+  for (const MemrefDesc& memref : memrefs) {
+    data.push_back(static_cast<int64_t>(memref.dtype()));
+    data.push_back(memref.rank());
+    data.append(memref.sizes().begin(), memref.sizes().end());
+  }
+  return llvm::xxHash64(llvm::ArrayRef<uint8_t>(
+      reinterpret_cast<const uint8_t*>(data.data()),
+      data.size() * sizeof(int64_t)));
+}
+
+// Returns the size of the object file of `executable`, or 0 if it is not
+// available.
+static size_t CodeBytes(const Executable& executable) {
+  std::unique_ptr<llvm::MemoryBuffer> obj_file = executable.obj_file();
+  return obj_file ? obj_file->getBufferSize() : 0;
+}
+
+absl::StatusOr<AsyncValuePtr<Executable>> GetTieredExecutable(
+    JitExecutable& jit_executable, llvm::ArrayRef<MemrefDesc> memrefs,
+    CompilationExecutor& executor, SpecializeFn specialize) {
+  AsyncValuePtr<Executable> default_executable =
+      jit_executable.DefaultExecutable();
+  if (!default_executable.IsConcrete())
+    return jit_executable.GetExecutable(memrefs);
+
+  Metrics& metrics = Metrics::Global();
+  Tiers::Key key(&jit_executable, ShapeSignature(memrefs));
+  switch (Tiers::Global().RecordCall(key)) {
+    case Tier::kCold:
+    case Tier::kFailed:
+      metrics.default_calls->IncrementBy(1);
+      return default_executable;
+    case Tier::kSpecialized:
+      metrics.specialized_calls->IncrementBy(1);
+      return jit_executable.GetExecutable(memrefs);
+    case Tier::kCompiling:
+      metrics.default_calls->IncrementBy(1);
+      break;
+  }
+
+  // Compile the specialization in the background, this call and the calls
+  // until it is available keep running the default executable.
+  auto compile = [key, specialize = std::move(specialize)]() mutable {
+    Metrics::Global().compilations->IncrementBy(1);
+    auto failed = [key] {
+      Metrics::Global().compilation_failures->IncrementBy(1);
+      Tiers::Global().SetFailed(key);
+    };
+
+    absl::StatusOr<AsyncValuePtr<Executable>> executable = specialize();
+    if (!executable.ok()) return failed();
+    executable->AndThen([key, failed, executable = *executable] {
+      if (executable.IsError()) return failed();
+      Tiers::Global().SetSpecialized(key, CodeBytes(executable.get()));
+    });
+  };
+  bool enqueued = executor.Execute(CompilationExecutor::Priority::kBackground,
+                                   std::move(compile));
+  if (!enqueued) Tiers::Global().SetCold(key);
+
+  return default_executable;
+}
+
+}  // namespace jitrt
+}  // namespace tfrt
@@ -15,12 +15,15 @@ limitations under the License.
 
 #include <utility>
 
+#include <limits>
+
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Debug.h"
 #include "mlir/Dialect/Arith/IR/Arith.h"
 #include "mlir/Dialect/Async/IR/Async.h"
 #include "mlir/Dialect/Async/Transforms.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Math/IR/Math.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/Dialect/SCF/IR/SCF.h"
@@ -41,6 +44,7 @@ namespace math = mlir::math;
 namespace arith = mlir::arith;
 namespace scf = mlir::scf;
 namespace memref = mlir::memref;
+namespace func = mlir::func;
 
 using llvm::Optional;
 using mlir::dyn_cast;
@@ -63,10 +67,12 @@ struct CostDrivenAsyncParallelForPass
 
   CostDrivenAsyncParallelForPass(bool async_dispatch,
                                  int32_t num_worker_threads,
-                                 bool legacy_behavior) {
+                                 bool legacy_behavior,
+                                 bool runtime_parallelism) {
     this->async_dispatch_ = async_dispatch;
     this->num_worker_threads_ = num_worker_threads;
     this->legacy_behavior_ = legacy_behavior;
+    this->runtime_parallelism_ = runtime_parallelism;
   }
 
   void runOnOperation() override;
@@ -376,24 +382,70 @@ Value CostModel::CostToNanoseconds(Cost cost) {
              builder_.create<arith::ConstantIndexOp>(1));
 }
 
+// Runtime function that returns the number of worker threads available to
+// the parallel loops at run time, given the number they were compiled for.
+constexpr const char *kAsyncParallelismFn = "jitrt_async_parallelism";
+
+// Scales the minimal task size of a parallel loop compiled for `num_workers`
+// worker threads by the ratio of compile time and run time workers, so that
+// the loop is split into fewer blocks when the host is busy, and runs serially
+// in the caller thread if no other workers are available.
+Value ScaleToAsyncParallelism(ImplicitLocOpBuilder &builder,
+                              Value min_task_size, int32_t num_workers) {
+  Value workers = builder.create<arith::ConstantIndexOp>(num_workers);
+  Value available =
+      builder
+          .create<func::CallOp>(kAsyncParallelismFn, builder.getIndexType(),
+                                workers)
+          .getResult(0);
+
+  Value one = builder.create<arith::ConstantIndexOp>(1);
+  Value scale = builder.create<arith::CeilDivSIOp>(
+      workers, builder.create<arith::MaxSIOp>(available, one));
+  Value scaled = builder.create<arith::MulIOp>(min_task_size, scale);
+
+  Value serial = builder.create<arith::CmpIOp>(arith::CmpIPredicate::sle,
+                                               available, one);
+  Value unbounded = builder.create<arith::ConstantIndexOp>(
+      std::numeric_limits<int32_t>::max());
+  return builder.create<arith::SelectOp>(serial, unbounded, scaled);
+}
+
 }  // namespace
 
 void CostDrivenAsyncParallelForPass::runOnOperation() {
   MLIRContext *ctx = &getContext();
+  ModuleOp module = getOperation();
+
+  // Declare the runtime function queried by the parallel loops. It is removed
+  // by symbol DCE if all loops are canonicalized away.
+  if (runtime_parallelism_ && !module.lookupSymbol(kAsyncParallelismFn)) {
+    auto builder =
+        ImplicitLocOpBuilder::atBlockEnd(module.getLoc(), module.getBody());
+    auto index = builder.getIndexType();
+    auto fn = builder.create<func::FuncOp>(
+        kAsyncParallelismFn, builder.getFunctionType({index}, {index}));
+    fn.setPrivate();
+  }
 
   mlir::RewritePatternSet patterns(ctx);
 
   mlir::async::populateAsyncParallelForPatterns(
       patterns, async_dispatch_, num_worker_threads_,
       [&](ImplicitLocOpBuilder builder, scf::ParallelOp op) -> Value {
+        Value min_task_size;
         if (legacy_behavior_) {
-          return (Value)builder.create<arith::ConstantIndexOp>(16 * 1024);
+          min_task_size = builder.create<arith::ConstantIndexOp>(16 * 1024);
+        } else {
+          CostModel costModel(builder, *op, true);
+          min_task_size = builder.create<arith::CeilDivSIOp>(
+              builder.create<arith::ConstantIndexOp>(512 * 1024),
+              costModel.CostToNanoseconds(
+                  costModel.EstimateCost(op.getLoopBody())));
         }
-        CostModel costModel(builder, *op, true);
-        return builder.create<arith::CeilDivSIOp>(
-            builder.create<arith::ConstantIndexOp>(512 * 1024),
-            costModel.CostToNanoseconds(
-                costModel.EstimateCost(op.getLoopBody())));
+        if (!runtime_parallelism_) return min_task_size;
+        return ScaleToAsyncParallelism(builder, min_task_size,
+                                       num_worker_threads_);
       });
 
   if (failed(mlir::applyPatternsAndFoldGreedily(getOperation(),
@@ -406,9 +458,11 @@ std::unique_ptr<mlir::Pass> CreateCostDrivenAsyncParallelForPass() {
 }
 
 std::unique_ptr<mlir::Pass> CreateCostDrivenAsyncParallelForPass(
-    bool async_dispatch, int32_t num_worker_threads, bool legacy_behavior) {
+    bool async_dispatch, int32_t num_worker_threads, bool legacy_behavior,
+    bool runtime_parallelism) {
   return std::make_unique<CostDrivenAsyncParallelForPass>(
-      async_dispatch, num_worker_threads, legacy_behavior);
+      async_dispatch, num_worker_threads, legacy_behavior,
+      runtime_parallelism);
 }
 
 }  // namespace jitrt
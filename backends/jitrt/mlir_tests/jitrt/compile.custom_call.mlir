@@ -44,6 +44,39 @@ module @multiply attributes { tfrt.compiled } {
   }
 }
 
+// Async custom call returns a token, and the compiled code awaits it only after
+// computing the result that does not depend on the custom call.
+module @async_multiply attributes { tfrt.compiled } {
+  func.func private @async_multiply.cc(%arg0: memref<?x?xf32>,
+                                       %arg1: memref<?x?xf32>) -> !async.token
+    attributes { rt.dynamic, rt.custom_call = "testlib.async_multiply" }
+
+  func.func private @multiply.x3.cc(%arg0: memref<?x?xf32>,
+                                    %arg1: memref<?x?xf32>)
+    attributes { rt.dynamic, rt.custom_call = "testlib.multiply.x3" }
+
+  func.func @main(%input: memref<?x?xf32>) -> (memref<?x?xf32>,
+                                               memref<?x?xf32>) {
+    %c0 = arith.constant 0 : index
+    %c1 = arith.constant 1 : index
+    %0 = memref.dim %input, %c0 : memref<?x?xf32>
+    %1 = memref.dim %input, %c1 : memref<?x?xf32>
+
+    %out0 = memref.alloc(%0, %1) : memref<?x?xf32>
+    %out1 = memref.alloc(%0, %1) : memref<?x?xf32>
+
+    %token = func.call @async_multiply.cc(%input, %out0) { cst = 2.0 : f32 }
+      : (memref<?x?xf32>, memref<?x?xf32>) -> !async.token
+
+    func.call @multiply.x3.cc(%input, %out1)
+      : (memref<?x?xf32>, memref<?x?xf32>) -> ()
+
+    async.await %token : !async.token
+
+    func.return %out0, %out1 : memref<?x?xf32>, memref<?x?xf32>
+  }
+}
+
 // Test that custom calls with incorrect signatures emit error messages.
 module @multiply_errors attributes { tfrt.compiled } {
 
@@ -286,6 +319,41 @@ func.func @compiled_custom_call() -> !tfrt.chain {
   tfrt.return %printed1 : !tfrt.chain
 }
 
+// CHECK: --- Running 'compiled_async_custom_call'
+func.func @compiled_async_custom_call() -> !tfrt.chain {
+  %ch0 = tfrt.new.chain
+
+  // Allocate and initialize input tensor.
+  %input = tfrt_dht.create_uninitialized_tensor.f32.2 [16 : i64, 16 : i64]
+  %ch1 = tfrt_dht.fill_tensor_with_constant.f32 %input, %ch0 1.0 : f32
+
+  // Allocate tensor for the expected values.
+  %expected = tfrt_dht.create_uninitialized_tensor.f32.2 [16 : i64, 16 : i64]
+
+  // Compile a kernel with an async custom call.
+  %executable = jitrt.compile { kernel = @async_multiply::@main }
+
+  // Execute compiled kernel with tensor operands.
+  %output0, %output1 = jitrt.execute %executable[%ch1](%input)
+    : (!t.tensor) -> (!t.tensor, !t.tensor)
+
+  // Wait for the execution completion and compare result with expected.
+  %ch2 = tfrt_dht.fill_tensor_with_constant.f32 %expected, %ch1 2.0 : f32
+  %cmp0, %cmp0_ch = "tfrt_dht.tensor_allclose.f32"(%expected, %output0, %ch2)
+    : (!t.tensor, !t.tensor, !tfrt.chain) -> (i1, !tfrt.chain)
+
+  %ch3 = tfrt_dht.fill_tensor_with_constant.f32 %expected, %cmp0_ch 3.0 : f32
+  %cmp1, %cmp1_ch = "tfrt_dht.tensor_allclose.f32"(%expected, %output1, %ch3)
+    : (!t.tensor, !t.tensor, !tfrt.chain) -> (i1, !tfrt.chain)
+
+  // CHECK: int1 = 1
+  // CHECK: int1 = 1
+  %printed0 = tfrt.print.i1 %cmp0, %cmp1_ch
+  %printed1 = tfrt.print.i1 %cmp1, %printed0
+
+  tfrt.return %printed1 : !tfrt.chain
+}
+
 // CHECK: --- Running 'compiled_custom_call_error'
 func.func @compiled_custom_call_error() -> !t.tensor {
   %ch0 = tfrt.new.chain
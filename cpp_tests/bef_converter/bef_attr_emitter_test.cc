@@ -18,6 +18,7 @@
 
 #include "../../lib/bef_converter/mlir_to_bef/bef_attr_emitter.h"
 
+#include "../../lib/bef_converter/mlir_to_bef/bef_compilation_units.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "llvm/ADT/ArrayRef.h"
@@ -25,6 +26,7 @@
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
 #include "mlir/Tools/mlir-translate/Translation.h"
 #include "tfrt/bef/bef_encoding.h"
 #include "tfrt/cpp_tests/test_util.h"
@@ -287,5 +289,73 @@ TEST_F(BefAttrEmitterTest, EmitAggregateAttribute) {
             kTestAggregateAttr3);
 }
 
+TEST_F(BefAttrEmitterTest, EmitAggregateAttributeWithRepeatedElements) {
+  mlir::Builder builder(&context_);
+
+  auto string_attr = mlir::StringAttr::get(&context_, kTestAggregateAttr2);
+  auto float_attr =
+      mlir::FloatAttr::get(builder.getF32Type(), kTestAggregateAttr3);
+
+  auto unique_attr = mlir::ArrayAttr::get(&context_, {string_attr, float_attr});
+  BefAttrEmitter unique_emitter;
+  unique_emitter.EmitAttribute(unique_attr);
+  const size_t unique_size = unique_emitter.size();
+
+  auto mlir_attr = mlir::ArrayAttr::get(
+      &context_, {string_attr, float_attr, string_attr, string_attr});
+  auto offset = emitter_.EmitAttribute(mlir_attr);
+  auto buffer = emitter_.TakeResult();
+
+  // Only the offset table grows for the repeated elements.
+  EXPECT_LE(buffer.size(), unique_size + 2 * sizeof(AttrSizeT));
+
+  AggregateAttr attr(buffer.data() + offset);
+  EXPECT_EQ(attr.GetNumElements(), 4);
+  EXPECT_EQ(attr.GetElementOffset(0), attr.GetElementOffset(2));
+  EXPECT_EQ(attr.GetElementOffset(0), attr.GetElementOffset(3));
+  for (int i : {0, 2, 3}) {
+    EXPECT_EQ(attr.GetElementType(i),
+              static_cast<BEFAttributeType>(DType::String));
+    EXPECT_EQ(attr.GetAttributeOfType<StringAttribute>(i).get(),
+              kTestAggregateAttr2);
+  }
+  EXPECT_EQ(attr.GetAttributeOfType<Attribute<float>>(1).get(),
+            kTestAggregateAttr3);
+}
+
+constexpr char kTestCompiledModule[] = R"(
+  module {
+    module @kernels attributes { tfrt.compiled } {
+      func.func @compute() { func.return }
+      func.func @other() { func.return }
+    }
+  }
+)";
+
+TEST_F(BefAttrEmitterTest, EmitCompilationUnitFingerprint) {
+  // Emits the compilation unit of @kernels::@<name> from a fresh copy of the
+  // module, as if it was compiled into a separate BEF file.
+  auto emit = [&](string_view name) {
+    auto module =
+        mlir::parseSourceString<mlir::ModuleOp>(kTestCompiledModule, &context_);
+    EXPECT_TRUE(module);
+    BefCompilationUnits compilation_units(*module);
+    auto symbol = mlir::SymbolRefAttr::get(
+        &context_, "kernels",
+        {mlir::FlatSymbolRefAttr::get(&context_, name)});
+    BefAttrEmitter emitter;
+    size_t offset = emitter.EmitSymbolRefAttribute(compilation_units, symbol);
+    auto buffer = emitter.TakeResult();
+    CompilationUnitAttribute attr(buffer.data() + offset);
+    EXPECT_EQ(attr.root_symbol(), "kernels");
+    EXPECT_EQ(attr.nested_symbols().size(), 1);
+    EXPECT_EQ(attr.nested_symbols()[0], name);
+    return attr.fingerprint();
+  };
+
+  EXPECT_EQ(emit("compute"), emit("compute"));
+  EXPECT_NE(emit("compute"), emit("other"));
+}
+
 }  // namespace
 }  // namespace tfrt
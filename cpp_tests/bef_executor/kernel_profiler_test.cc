@@ -0,0 +1,117 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit tests for the kernel profiler.
+
+#include "tfrt/bef_executor/kernel_profiler.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace tfrt {
+namespace {
+
+using kernel_profiler::GetKernelId;
+using kernel_profiler::ProfiledKernelCall;
+using kernel_profiler::ShouldProfileExecution;
+
+const KernelProfile* FindProfile(const std::vector<KernelProfile>& profiles,
+                                 const std::string& name) {
+  for (const KernelProfile& profile : profiles)
+    if (profile.name == name) return &profile;
+  return nullptr;
+}
+
+TEST(KernelProfilerTest, SelectExecutions) {
+  EXPECT_FALSE(ShouldProfileExecution("main"));
+
+  KernelProfilerOptions options;
+  options.functions = {"main"};
+  options.sampling_period = 2;
+  EnableKernelProfiler(options);
+  EXPECT_FALSE(ShouldProfileExecution("other"));
+  int num_profiled = 0;
+  for (int i = 0; i < 4; ++i) num_profiled += ShouldProfileExecution("main");
+  EXPECT_EQ(num_profiled, 2);
+
+  // Executions called by a profiled kernel are profiled.
+  {
+    ProfiledKernelCall call(GetKernelId("test.caller", "select"));
+    EXPECT_TRUE(ShouldProfileExecution("other"));
+  }
+
+  DisableKernelProfiler();
+  EXPECT_FALSE(ShouldProfileExecution("main"));
+}
+
+TEST(KernelProfilerTest, SelfTime) {
+  uint32_t outer_id = GetKernelId("test.outer", "loc:1:1");
+  uint32_t inner_id = GetKernelId("test.inner", "loc:2:1");
+  EXPECT_EQ(GetKernelId("test.outer", "loc:1:1"), outer_id);
+  EXPECT_NE(inner_id, outer_id);
+
+  {
+    ProfiledKernelCall outer(outer_id);
+    for (int i = 0; i < 2; ++i) {
+      ProfiledKernelCall inner(inner_id);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  // Outline calls recorded by another thread are aggregated.
+  std::thread([&] { kernel_profiler::RecordOutlineCall(inner_id); }).join();
+
+  std::vector<KernelProfile> profiles = GetKernelProfiles();
+  const KernelProfile* outer = FindProfile(profiles, "test.outer");
+  const KernelProfile* inner = FindProfile(profiles, "test.inner");
+  ASSERT_NE(outer, nullptr);
+  ASSERT_NE(inner, nullptr);
+
+  EXPECT_EQ(outer->location, "loc:1:1");
+  EXPECT_EQ(outer->calls, 1);
+  EXPECT_EQ(inner->calls, 2);
+  EXPECT_EQ(inner->outline_calls, 1);
+  EXPECT_GE(inner->total_time, std::chrono::milliseconds(2));
+  EXPECT_EQ(inner->self_time, inner->total_time);
+  EXPECT_GE(outer->total_time, inner->total_time);
+  EXPECT_EQ(outer->self_time, outer->total_time - inner->total_time);
+  EXPECT_GE(inner->p50_time, std::chrono::microseconds(750));
+  EXPECT_LE(inner->p50_time, inner->p99_time);
+}
+
+TEST(KernelProfilerTest, CostProfile) {
+  uint32_t id = GetKernelId("test.cost", "loc:3:1");
+  for (int i = 0; i < 2; ++i) {
+    ProfiledKernelCall call(id);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  WriteKernelCostProfile(os);
+
+  size_t pos = os.str().find("\tloc:3:1\n");
+  ASSERT_NE(pos, std::string::npos);
+  size_t begin = os.str().rfind('\n', pos);
+  begin = begin == std::string::npos ? 0 : begin + 1;
+  int64_t mean_ns = std::stoll(os.str().substr(begin, pos - begin));
+  EXPECT_GE(mean_ns, 750000);
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit tests for the cost profile and its use by StreamAnalysis.
+
+#include "tfrt/compiler/cost_profile.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Location.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
+#include "tfrt/basic_kernels/opdefs/tfrt_base.h"
+#include "tfrt/compiler/stream_analysis.h"
+
+namespace tfrt {
+namespace compiler {
+namespace {
+
+class CostProfileTest : public ::testing::Test {
+ protected:
+  CostProfileTest() {
+    context_.loadDialect<mlir::func::FuncDialect, TFRTDialect>();
+  }
+
+  mlir::MLIRContext context_;
+};
+
+TEST_F(CostProfileTest, FormatKernelLocation) {
+  mlir::Location file_loc = mlir::FileLineColLoc::get(&context_, "f", 1, 2);
+  EXPECT_EQ(FormatKernelLocation(file_loc), "f:1:2");
+
+  auto name = mlir::StringAttr::get(&context_, "name");
+  EXPECT_EQ(FormatKernelLocation(mlir::NameLoc::get(name)), "name");
+  EXPECT_EQ(FormatKernelLocation(mlir::NameLoc::get(name, file_loc)),
+            "f;1;2(name)");
+
+  mlir::Location caller_loc = mlir::FileLineColLoc::get(&context_, "g", 3, 4);
+  EXPECT_EQ(FormatKernelLocation(mlir::CallSiteLoc::get(file_loc, caller_loc)),
+            "f;1;2<-g;3;4");
+
+  EXPECT_EQ(FormatKernelLocation(mlir::OpaqueLoc::get<uintptr_t>(9, &context_)),
+            "");
+}
+
+TEST_F(CostProfileTest, Parse) {
+  auto profile = CostProfile::Parse("1500\tf:1:2\n\n20\tname\n");
+  ASSERT_TRUE(!!profile) << llvm::toString(profile.takeError());
+  EXPECT_EQ(profile->size(), 2u);
+
+  mlir::Location file_loc = mlir::FileLineColLoc::get(&context_, "f", 1, 2);
+  EXPECT_EQ(profile->GetMeanTime(file_loc), 1500);
+  mlir::Location other_loc = mlir::FileLineColLoc::get(&context_, "f", 2, 2);
+  EXPECT_EQ(profile->GetMeanTime(other_loc), llvm::None);
+
+  auto invalid = CostProfile::Parse("1500 f:1:2\n");
+  EXPECT_FALSE(!!invalid);
+  llvm::consumeError(invalid.takeError());
+}
+
+TEST_F(CostProfileTest, StreamAnalysis) {
+  llvm::SmallString<128> path(::testing::TempDir());
+  llvm::sys::path::append(path, "cost_profile.txt");
+  {
+    std::error_code error;
+    llvm::raw_fd_ostream os(path, error);
+    ASSERT_FALSE(error);
+    // The three constants are cheap, much cheaper than the threshold.
+    os << "1000\tm:1:1\n1000\tm:2:1\n1000\tm:3:1\n";
+  }
+
+  auto analyze = [&](bool use_profile) {
+    std::string attrs = "tfrt.cost_threshold = 10 : i64";
+    if (use_profile)
+      attrs += ", tfrt.cost_profile = \"" + path.str().str() + "\"";
+    std::string source = "module attributes {" + attrs + R"(} {
+      func.func @constants() -> (i32, i32, i32) {
+        %0 = tfrt.constant.i32 0 loc("m":1:1)
+        %1 = tfrt.constant.i32 1 loc("m":2:1)
+        %2 = tfrt.constant.i32 2 loc("m":3:1)
+        tfrt.return %0, %1, %2 : i32, i32, i32
+      }
+    })";
+    auto module = mlir::parseSourceString<mlir::ModuleOp>(source, &context_);
+    EXPECT_TRUE(module);
+    auto func = module->lookupSymbol<mlir::func::FuncOp>("constants");
+    StreamAnalysis analysis(func);
+
+    // Returns the number of distinct streams of the ops.
+    llvm::SmallDenseSet<int, 4> stream_ids;
+    for (mlir::Operation& op : func.front())
+      stream_ids.insert(analysis.GetStream(&op).id());
+    return static_cast<int>(stream_ids.size());
+  };
+
+  // Without profile, the constants take the cost threshold as cost and run in
+  // parallel streams.
+  EXPECT_EQ(analyze(/*use_profile=*/false), 3);
+  // With profile, the cheap constants are merged into one stream.
+  EXPECT_EQ(analyze(/*use_profile=*/true), 1);
+}
+
+}  // namespace
+}  // namespace compiler
+}  // namespace tfrt
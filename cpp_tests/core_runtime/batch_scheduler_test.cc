@@ -0,0 +1,176 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file contains unit tests for BatchScheduler.
+
+#include "tfrt/core_runtime/batch_scheduler.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/cpp_tests/test_util.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/function.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "tfrt/tensor/dense_host_tensor_view.h"
+
+namespace tfrt {
+namespace {
+
+// A function which doubles its f32 argument, and records the number of rows
+// of the arguments it was called with.
+class DoubleFunction : public Function {
+ public:
+  DoubleFunction()
+      : Function("double", FunctionKind::kNativeFunction, {TypeName()},
+                 {TypeName()}) {}
+
+  void Execute(const ExecutionContext& exec_ctx,
+               ArrayRef<AsyncValue*> arguments,
+               MutableArrayRef<RCReference<AsyncValue>> results) const final {
+    HostContext* host = exec_ctx.host();
+    auto& arg = llvm::cast<DenseHostTensor>(
+        arguments[0]->get<TensorHandle>().GetAsyncTensor()->get<Tensor>());
+    batch_sizes.push_back(arg.shape().GetDimensionSize(0));
+
+    auto result =
+        DenseHostTensor::CreateUninitialized(arg.metadata(), host).getValue();
+    DHTArrayView<float> input(&arg);
+    MutableDHTArrayView<float> output(&result);
+    for (size_t i = 0; i < input.NumElements(); ++i)
+      output[i] = 2 * input[i];
+
+    TensorMetadata metadata = result.metadata();
+    results[0] = MakeAvailableAsyncValueRef<TensorHandle>(
+        host->GetHostDeviceRef(), metadata,
+        MakeAvailableAsyncValueRef<DenseHostTensor>(std::move(result)));
+  }
+
+  void ExecuteAsync(
+      const ExecutionContext& exec_ctx, ArrayRef<AsyncValue*> arguments,
+      MutableArrayRef<RCReference<AsyncValue>> results) const final {
+    Execute(exec_ctx, arguments, results);
+  }
+
+  void AddRef() const final {}
+  void DropRef() const final {}
+
+  mutable std::vector<Index> batch_sizes;
+};
+
+class BatchSchedulerTest : public ::testing::Test {
+ protected:
+  TensorHandle CreateArgument(ArrayRef<float> values) {
+    Index num_rows = values.size();
+    return TensorHandle(
+        host_->GetHostDeviceRef(), TensorMetadata(DType(DType::F32), num_rows),
+        MakeAvailableAsyncValueRef<DenseHostTensor>(
+            CreateTensorFromValues<float>(num_rows, values, host_.get())));
+  }
+
+  // Waits for `result` and returns its values.
+  std::vector<float> GetValues(const AsyncValueRef<TensorHandle>& result) {
+    host_->Await(result.CopyRCRef());
+    AsyncValue* tensor = result->GetAsyncTensor();
+    host_->Await(FormRef(tensor));
+    DHTArrayView<float> view(&tensor->get<DenseHostTensor>());
+    return std::vector<float>(view.begin(), view.end());
+  }
+
+  std::unique_ptr<HostContext> host_ = CreateHostContext();
+  ExecutionContext exec_ctx_{std::move(
+      *RequestContextBuilder(host_.get(), /*resource_context=*/nullptr)
+           .build())};
+  DoubleFunction function_;
+};
+
+TEST_F(BatchSchedulerTest, RunsFullBatch) {
+  BatchSchedulerOptions options;
+  options.max_batch_size = 3;
+  options.batch_timeout = std::chrono::hours(1);
+  BatchScheduler scheduler(&function_, options);
+
+  auto first = scheduler.Execute(exec_ctx_, {CreateArgument({1, 2})});
+  auto second = scheduler.Execute(exec_ctx_, {CreateArgument({3})});
+
+  EXPECT_EQ(GetValues(first[0]), std::vector<float>({2, 4}));
+  EXPECT_EQ(GetValues(second[0]), std::vector<float>({6}));
+  EXPECT_EQ(function_.batch_sizes, std::vector<Index>({3}));
+}
+
+TEST_F(BatchSchedulerTest, RunsBatchOnTimeout) {
+  BatchSchedulerOptions options;
+  options.max_batch_size = 8;
+  options.batch_timeout = std::chrono::milliseconds(1);
+  BatchScheduler scheduler(&function_, options);
+
+  auto first = scheduler.Execute(exec_ctx_, {CreateArgument({1})});
+  auto second = scheduler.Execute(exec_ctx_, {CreateArgument({2})});
+
+  EXPECT_EQ(GetValues(first[0]), std::vector<float>({2}));
+  EXPECT_EQ(GetValues(second[0]), std::vector<float>({4}));
+  EXPECT_EQ(function_.batch_sizes, std::vector<Index>({2}));
+}
+
+TEST_F(BatchSchedulerTest, StartsNewBatchIfCallDoesNotFit) {
+  BatchSchedulerOptions options;
+  options.max_batch_size = 3;
+  options.batch_timeout = std::chrono::hours(1);
+  std::vector<AsyncValueRef<TensorHandle>> results;
+  {
+    BatchScheduler scheduler(&function_, options);
+    results.push_back(
+        scheduler.Execute(exec_ctx_, {CreateArgument({1, 2})})[0]);
+    results.push_back(
+        scheduler.Execute(exec_ctx_, {CreateArgument({3, 4})})[0]);
+  }
+
+  EXPECT_EQ(GetValues(results[0]), std::vector<float>({2, 4}));
+  EXPECT_EQ(GetValues(results[1]), std::vector<float>({6, 8}));
+  EXPECT_EQ(function_.batch_sizes, std::vector<Index>({2, 2}));
+}
+
+TEST_F(BatchSchedulerTest, PadsToAllowedBatchSize) {
+  BatchSchedulerOptions options;
+  options.max_batch_size = 8;
+  options.batch_timeout = std::chrono::hours(1);
+  options.allowed_batch_sizes = {1, 4, 8};
+  llvm::SmallVector<AsyncValueRef<TensorHandle>, 4> results;
+  {
+    BatchScheduler scheduler(&function_, options);
+    results = scheduler.Execute(exec_ctx_, {CreateArgument({1, 2, 3})});
+  }
+
+  EXPECT_EQ(GetValues(results[0]), std::vector<float>({2, 4, 6}));
+  EXPECT_EQ(function_.batch_sizes, std::vector<Index>({4}));
+}
+
+TEST_F(BatchSchedulerTest, RejectsScalarArguments) {
+  BatchScheduler scheduler(&function_, BatchSchedulerOptions());
+  TensorHandle scalar(
+      host_->GetHostDeviceRef(), TensorMetadata(DType(DType::F32), {}),
+      MakeAvailableAsyncValueRef<DenseHostTensor>(
+          CreateTensorFromValues<float>({}, {1}, host_.get())));
+
+  auto results = scheduler.Execute(exec_ctx_, {std::move(scalar)});
+  host_->Await(results[0].CopyRCRef());
+  EXPECT_TRUE(results[0].IsError());
+  EXPECT_TRUE(function_.batch_sizes.empty());
+}
+
+}  // namespace
+}  // namespace tfrt
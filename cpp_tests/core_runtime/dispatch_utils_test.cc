@@ -0,0 +1,156 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file contains unit tests for the metadata function dispatch utilities.
+
+#include "tfrt/core_runtime/dispatch_utils.h"
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/bef_converter/bef_attr_encoder.h"
+#include "tfrt/core_runtime/op_attrs.h"
+#include "tfrt/core_runtime/op_invocation.h"
+#include "tfrt/core_runtime/tensor_handle.h"
+#include "tfrt/cpp_tests/test_util.h"
+#include "tfrt/host_context/attribute_utils.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/tensor/tensor_metadata.h"
+
+namespace tfrt {
+namespace {
+
+int num_metadata_fn_calls = 0;
+
+// Returns the metadata of the first argument with the `dim` attribute
+// appended to the shape.
+RCReference<AsyncValue> AppendDimMetadataFn(
+    const ExecutionContext& exec_ctx, ArrayRef<TensorMetadata> inputs,
+    const OpAttrsRef& attrs, MutableArrayRef<TensorMetadata> results) {
+  ++num_metadata_fn_calls;
+  llvm::SmallVector<Index, 4> dims;
+  inputs[0].shape.GetDimensions(&dims);
+  dims.push_back(attrs.GetAsserting<int64_t>("dim"));
+  results[0] = TensorMetadata(inputs[0].dtype, dims);
+  return {};
+}
+
+class DispatchUtilsTest : public ::testing::Test {
+ protected:
+  // Executes the metadata function for a single argument with metadata `md`.
+  TensorMetadata Execute(const TensorMetadata& md, int64_t dim) {
+    OpAttrs attrs;
+    attrs.Set<int64_t>("dim", dim);
+    OpAttrsRef attrs_ref(attrs);
+
+    TensorHandle arguments[] = {
+        TensorHandle(host_->GetHostDeviceRef(), md,
+                     MakeErrorAsyncValueRef("unused tensor"))};
+    TensorHandle results[1];
+    OpInvocation invocation{"test.append_dim", exec_ctx_, arguments,
+                            attrs_ref, results, /*chain=*/nullptr};
+
+    llvm::SmallVector<TensorMetadata, 4> result_mds;
+    auto result = internal::ExecuteMetadataFunction(AppendDimMetadataFn,
+                                                    invocation, result_mds);
+    EXPECT_EQ(result, internal::MDFunctionExecResult::kSuccess);
+    EXPECT_EQ(result_mds.size(), 1);
+    return result_mds[0];
+  }
+
+  std::unique_ptr<HostContext> host_ = CreateHostContext();
+  ExecutionContext exec_ctx_{
+      std::move(*RequestContextBuilder(host_.get(), nullptr).build())};
+};
+
+TEST_F(DispatchUtilsTest, MetadataFunctionResultsAreCached) {
+  TensorMetadata md(DType(DType::F32), {2, 3});
+  TensorMetadata expected(DType(DType::F32), {2, 3, 4});
+
+  num_metadata_fn_calls = 0;
+  EXPECT_EQ(Execute(md, 4), expected);
+  EXPECT_EQ(Execute(md, 4), expected);
+  EXPECT_EQ(num_metadata_fn_calls, 1);
+
+  // Different attributes or arguments run the metadata function again.
+  EXPECT_EQ(Execute(md, 5), TensorMetadata(DType(DType::F32), {2, 3, 5}));
+  EXPECT_EQ(num_metadata_fn_calls, 2);
+
+  TensorMetadata other_md(DType(DType::I32), {2, 3});
+  EXPECT_EQ(Execute(other_md, 4), TensorMetadata(DType(DType::I32), {2, 3, 4}));
+  EXPECT_EQ(num_metadata_fn_calls, 3);
+}
+
+// Encodes the kResultMetadataAttrName attribute value for results with dtype
+// `dtype` and shapes `shapes`.
+size_t EncodeResultMetadata(BefAttrEncoder* encoder, DType dtype,
+                            ArrayRef<std::vector<int64_t>> shapes) {
+  return encoder->EncodeListAttr(
+      shapes.size(), BEFAttributeType::kAggregate, alignof(AttrShapeT),
+      [&](int index) -> AttrSizeT {
+        size_t offset_offset;
+        size_t offset = encoder->EncodeAggregatedAttrHeader(
+            alignof(AttrShapeT), /*element_count=*/2, &offset_offset);
+        encoder->EmitDummyByte();
+        encoder->EncodeAggregatedAttrEntryTypeAndOffset(
+            offset, &offset_offset, BEFAttributeType::kType,
+            encoder->EncodeAttr(static_cast<uint8_t>(dtype)));
+        encoder->EmitDummyByte();
+        encoder->EncodeAggregatedAttrEntryTypeAndOffset(
+            offset, &offset_offset, BEFAttributeType::kShape,
+            encoder->EncodeRankedShapeAttr(shapes[index]));
+        encoder->EncodeAggregatedAttrLength(offset);
+        return offset;
+      });
+}
+
+TEST_F(DispatchUtilsTest, StaticResultMetadata) {
+  BefAttrEncoder encoder;
+  std::vector<std::vector<int64_t>> shapes = {{2, 3}, {}};
+  size_t static_offset = EncodeResultMetadata(&encoder, DType::F32, shapes);
+  shapes[0][1] = -1;
+  size_t dynamic_offset = EncodeResultMetadata(&encoder, DType::F32, shapes);
+  auto buffer = encoder.TakeResult();
+
+  OpAttrs attrs;
+  llvm::SmallVector<TensorMetadata, 4> result_mds;
+  EXPECT_FALSE(internal::GetStaticResultMetadata(
+      OpAttrsRef(attrs), /*num_results=*/2, result_mds));
+
+  OpAttrs static_attrs;
+  static_attrs.Set(kResultMetadataAttrName,
+                   AggregateAttr(buffer.data() + static_offset));
+  EXPECT_TRUE(internal::GetStaticResultMetadata(
+      OpAttrsRef(static_attrs), /*num_results=*/2, result_mds));
+  ASSERT_EQ(result_mds.size(), 2);
+  EXPECT_EQ(result_mds[0], TensorMetadata(DType(DType::F32), {2, 3}));
+  EXPECT_EQ(result_mds[1], TensorMetadata(DType(DType::F32), {}));
+
+  // The number of results has to match.
+  result_mds.clear();
+  EXPECT_FALSE(internal::GetStaticResultMetadata(
+      OpAttrsRef(static_attrs), /*num_results=*/1, result_mds));
+
+  // Unknown dimensions fall back to the metadata function.
+  OpAttrs dynamic_attrs;
+  dynamic_attrs.Set(kResultMetadataAttrName,
+                    AggregateAttr(buffer.data() + dynamic_offset));
+  EXPECT_FALSE(internal::GetStaticResultMetadata(
+      OpAttrsRef(dynamic_attrs), /*num_results=*/2, result_mds));
+  EXPECT_TRUE(result_mds.empty());
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -340,5 +340,30 @@ void BM_CpuMakeOpDriverTest(benchmark::State& state) {
 }
 BENCHMARK(BM_CpuMakeOpDriverTest);
 
+// Dispatches an op on a single element tensor, which mostly measures the cost
+// of the op dispatch (e.g. of corert.executeop) rather than of the op itself.
+void BM_CpuMakeOpDispatch(benchmark::State& state) {
+  example::CoreRuntimeCpuDriver driver;
+
+  tfrt::OpAttrs attrs1;
+  tfrt::TensorHandle a1;
+  attrs1.SetArray("shape", tfrt::ArrayRef<Index>{1});
+  attrs1.SetArray("values", tfrt::ArrayRef<float>{1.0});
+  driver.Execute(driver.CreateExecutionContext(__FILE__, __LINE__),
+                 "tfrt_test.create_dense_tensor", {}, attrs1.freeze(), a1);
+
+  auto add_op = driver.MakeOp("tfrt_test.add");
+  tfrt::OpAttrs add_attrs;
+  tfrt::OpAttrsRef add_attrs_ref = add_attrs.freeze();
+
+  for (auto _ : state) {
+    tfrt::TensorHandle add_args[2] = {a1.CopyRef(), a1.CopyRef()};
+    tfrt::TensorHandle a2;
+    add_op(driver.CreateExecutionContext(__FILE__, __LINE__), add_args,
+           add_attrs_ref, a2, /*chain=*/nullptr);
+  }
+}
+BENCHMARK(BM_CpuMakeOpDispatch);
+
 }  // namespace
 }  // namespace tfrt
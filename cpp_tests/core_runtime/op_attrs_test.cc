@@ -19,6 +19,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -219,6 +220,51 @@ TEST(OpAttrsTest, ArrayAsserting) {
   ASSERT_EQ(op_attrs_ref.GetArrayAsserting<int32_t>("bar"), empty_ref);
 }
 
+TEST(OpAttrsTest, FrozenAttrsAreInterned) {
+  OpAttrs attrs1;
+  ASSERT_TRUE(attrs1.Set<int32_t>("foo", 1));
+  ASSERT_TRUE(attrs1.SetString("bar", "baz"));
+
+  // Set the same attributes in another order.
+  OpAttrs attrs2;
+  ASSERT_TRUE(attrs2.SetString("bar", "baz"));
+  ASSERT_TRUE(attrs2.Set<int32_t>("foo", 1));
+
+  OpAttrs attrs3;
+  ASSERT_TRUE(attrs3.Set<int32_t>("foo", 2));
+  ASSERT_TRUE(attrs3.SetString("bar", "baz"));
+
+  OpAttrsRef frozen1 = attrs1.freeze();
+  OpAttrsRef frozen2 = attrs2.freeze();
+  OpAttrsRef frozen3 = attrs3.freeze();
+
+  EXPECT_TRUE(frozen1 == frozen2);
+  EXPECT_TRUE(frozen1 != frozen3);
+  EXPECT_EQ(frozen1.GetHash(), frozen2.GetHash());
+
+  // Mutable sets are compared with frozen sets by value.
+  EXPECT_TRUE(OpAttrsRef(attrs2) == frozen1);
+  EXPECT_TRUE(OpAttrsRef(attrs3) != frozen1);
+  EXPECT_EQ(OpAttrsRef(attrs2).GetHash(), frozen1.GetHash());
+
+  EXPECT_TRUE(OpAttrs().freeze() == OpAttrsRef(OpAttrs()));
+}
+
+TEST(OpAttrsTest, FrozenAttrsAreInternedAcrossThreads) {
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([] {
+      for (int j = 0; j < 1000; ++j) {
+        OpAttrs attrs;
+        ASSERT_TRUE(attrs.Set<int32_t>("foo", j % 3));
+        OpAttrsRef frozen = attrs.freeze();
+        ASSERT_EQ(frozen.GetAsserting<int32_t>("foo"), j % 3);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
 void BM_OpAttrSetBool(benchmark::State& state) {
   for (auto _ : state) {
     tfrt::OpAttrs attrs;
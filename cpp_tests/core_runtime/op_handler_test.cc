@@ -17,9 +17,15 @@
 #include "tfrt/core_runtime/op_handler.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "tfrt/core_runtime/core_runtime.h"
+#include "tfrt/core_runtime/core_runtime_op.h"
+#include "tfrt/core_runtime/op_attrs.h"
+#include "tfrt/core_runtime/op_invocation.h"
+#include "tfrt/core_runtime/tensor_handle.h"
 #include "tfrt/cpp_tests/test_util.h"
 #include "tfrt/cpu/core_runtime/cpu_op_handler.h"
 #include "tfrt/cpu/core_runtime/null_op_handler.h"
@@ -40,6 +46,25 @@ class DummyOpHandler : public OpHandler {
   }
 };
 
+// Supports only the "test.known" op, and counts the MakeOp() calls and the op
+// executions.
+class CountingOpHandler : public OpHandler {
+ public:
+  explicit CountingOpHandler(CoreRuntime* runtime)
+      : OpHandler("counting", runtime, /*fallback=*/nullptr) {}
+
+  Expected<CoreRuntimeOp> MakeOp(string_view op_name) override {
+    ++num_make_op_calls;
+    if (op_name != "test.known")
+      return MakeStringError(op_name, " is not supported.");
+    return CoreRuntimeOp([this](const OpInvocation&) { ++num_executions; },
+                         /*is_fallback=*/false);
+  }
+
+  int num_make_op_calls = 0;
+  int num_executions = 0;
+};
+
 static std::unique_ptr<CoreRuntime> CreateCoreRuntime() {
   constexpr const char* kCpuOpHandlerName = "cpu";
   auto diag_handler = [](const DecodedDiagnostic& diag) {
@@ -85,5 +110,67 @@ TEST(OpHandlerTest, Registration) {
   ASSERT_EQ(core_runtime->GetOpHandler(chain_name), chain_root);
   ASSERT_FALSE(core_runtime->GetOpHandler(op_handler_name));
 }
+
+TEST(OpHandlerTest, GetOrMakeOp) {
+  auto core_runtime = CreateCoreRuntime();
+  auto op_handler = std::make_unique<CountingOpHandler>(core_runtime.get());
+  auto* counting_op_handler = op_handler.get();
+  core_runtime->TakeOpHandler(std::move(op_handler));
+
+  auto op = core_runtime->GetOrMakeOp("test.known", counting_op_handler);
+  ASSERT_TRUE(!!op);
+  EXPECT_EQ(counting_op_handler->num_make_op_calls, 1);
+
+  // The op is created once, and found by name from other op name buffers.
+  std::string op_name = "test.known";
+  for (int i = 0; i < 3; ++i) {
+    auto cached_op = core_runtime->GetOrMakeOp(op_name, counting_op_handler);
+    ASSERT_TRUE(!!cached_op);
+    EXPECT_EQ(*cached_op, *op);
+  }
+  EXPECT_EQ(counting_op_handler->num_make_op_calls, 1);
+
+  // Reusing the op name buffer for another op name does not return a stale op.
+  op_name = "test.other";
+  auto unknown_op = core_runtime->GetOrMakeOp(op_name, counting_op_handler);
+  EXPECT_FALSE(!!unknown_op);
+  llvm::consumeError(unknown_op.takeError());
+
+  // Errors are not cached.
+  unknown_op = core_runtime->GetOrMakeOp(op_name, counting_op_handler);
+  EXPECT_FALSE(!!unknown_op);
+  llvm::consumeError(unknown_op.takeError());
+  EXPECT_EQ(counting_op_handler->num_make_op_calls, 3);
+}
+
+TEST(OpHandlerTest, ExecuteBatch) {
+  auto core_runtime = CreateCoreRuntime();
+  auto op_handler = std::make_unique<CountingOpHandler>(core_runtime.get());
+  auto* counting_op_handler = op_handler.get();
+  core_runtime->TakeOpHandler(std::move(op_handler));
+
+  auto* host = core_runtime->GetHostContext();
+  ExecutionContext exec_ctx(
+      std::move(*RequestContextBuilder(host, nullptr).build()));
+  OpAttrsRef attrs;
+  TensorHandle results[3];
+
+  std::vector<OpInvocation> invocations;
+  for (int i = 0; i < 3; ++i) {
+    invocations.push_back(
+        OpInvocation{i == 1 ? "test.unknown" : "test.known", exec_ctx, {},
+                     attrs, MutableArrayRef<TensorHandle>(&results[i], 1),
+                     /*chain=*/nullptr});
+  }
+  counting_op_handler->ExecuteBatch(invocations);
+
+  // Ops are created once, and unsupported ops fail their results.
+  EXPECT_EQ(counting_op_handler->num_executions, 2);
+  EXPECT_EQ(counting_op_handler->num_make_op_calls, 2);
+  EXPECT_FALSE(results[0].IsValid());
+  EXPECT_TRUE(results[1].IsError());
+  EXPECT_FALSE(results[2].IsValid());
+}
+
 }  // namespace
 }  // namespace tfrt
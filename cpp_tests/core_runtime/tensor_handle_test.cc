@@ -0,0 +1,86 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file contains unit tests for TensorHandle.
+
+#include "tfrt/core_runtime/tensor_handle.h"
+
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "tfrt/cpp_tests/test_util.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "tfrt/tensor/tensor_metadata.h"
+
+namespace tfrt {
+namespace {
+
+class TensorHandleTest : public ::testing::Test {
+ protected:
+  std::unique_ptr<HostContext> host_ = CreateHostContext();
+};
+
+TEST_F(TensorHandleTest, MetadataFromAvailableTensor) {
+  auto tensor = MakeAvailableAsyncValueRef<DenseHostTensor>(
+      CreateDummyTensor<float>({2, 3}, host_.get()));
+  TensorHandle th(host_->GetHostDeviceRef(),
+                  AsyncValueRef<Tensor>(tensor.ReleaseRCRef()));
+
+  ASSERT_TRUE(th.IsMetadataAvailable());
+  EXPECT_FALSE(th.IsMetadataError());
+  EXPECT_EQ(th.GetAvailableMetadata(),
+            TensorMetadata(DType(DType::F32), {2, 3}));
+}
+
+TEST_F(TensorHandleTest, MetadataFromUnavailableTensor) {
+  auto tensor = MakeIndirectAsyncValue();
+  TensorHandle th(host_->GetHostDeviceRef(), AsyncValueRef<Tensor>(tensor));
+
+  EXPECT_FALSE(th.IsMetadataAvailable());
+  EXPECT_EQ(th.GetAsyncMetadataValue(), tensor.get());
+
+  AsyncValueRef<TensorMetadata> metadata = th.GetAsyncMetadata();
+  EXPECT_TRUE(metadata.IsUnavailable());
+
+  TensorHandle copy = th.CopyRef();
+  EXPECT_FALSE(copy.IsMetadataAvailable());
+
+  tensor->ForwardTo(MakeAvailableAsyncValueRef<DenseHostTensor>(
+      CreateDummyTensor<int32_t>({4}, host_.get())));
+
+  TensorMetadata expected(DType(DType::I32), {4});
+  ASSERT_TRUE(th.IsMetadataAvailable());
+  EXPECT_EQ(th.GetAvailableMetadata(), expected);
+  ASSERT_TRUE(copy.IsMetadataAvailable());
+  EXPECT_EQ(copy.GetAvailableMetadata(), expected);
+  ASSERT_TRUE(metadata.IsConcrete());
+  EXPECT_EQ(metadata.get(), expected);
+}
+
+TEST_F(TensorHandleTest, MetadataFromErrorTensor) {
+  auto tensor = MakeIndirectAsyncValue();
+  TensorHandle th(host_->GetHostDeviceRef(), AsyncValueRef<Tensor>(tensor));
+  AsyncValueRef<TensorMetadata> metadata = th.GetAsyncMetadata();
+
+  tensor->SetError(absl::InternalError("tensor error"));
+
+  EXPECT_TRUE(th.IsError());
+  EXPECT_TRUE(th.IsMetadataError());
+  ASSERT_TRUE(metadata.IsError());
+  EXPECT_EQ(metadata.GetError().message(), "tensor error");
+}
+
+}  // namespace
+}  // namespace tfrt
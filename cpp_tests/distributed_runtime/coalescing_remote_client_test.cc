@@ -0,0 +1,202 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tfrt/distributed_runtime/coalescing_remote_client.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/distributed_runtime/proto/remote_message.pb.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/support/latch.h"
+#include "tfrt/support/mutex.h"
+
+namespace tfrt {
+namespace {
+
+// Records the DeleteRemoteObjects requests it receives, and rejects the first
+// `num_overloaded` RemoteExecute requests as overloaded.
+class FakeRemoteClient : public RemoteClientInterface {
+ public:
+  explicit FakeRemoteClient(std::vector<DeleteRemoteObjectsRequest>* requests,
+                            int num_overloaded = 0)
+      : requests_(requests), num_overloaded_(num_overloaded) {}
+
+  void RemoteExecuteAsync(RemoteCallContext* call_ctx,
+                          const RemoteExecuteRequest* request,
+                          RemoteExecuteResponse* response,
+                          CallbackFn done) final {
+    ++num_executes_;
+    if (num_overloaded_ > 0) {
+      --num_overloaded_;
+      done(llvm::make_error<ResourceExhaustedErrorInfo>("overloaded"));
+      return;
+    }
+    done(Error::success());
+  }
+
+  int num_executes() const { return num_executes_; }
+
+  void DeleteRemoteObjectsAsync(RemoteCallContext* call_ctx,
+                                const DeleteRemoteObjectsRequest* request,
+                                DeleteRemoteObjectsResponse* response,
+                                CallbackFn done) final {
+    requests_->push_back(*request);
+    done(Error::success());
+  }
+
+#define UNUSED_CLIENT_METHOD(method)                                  \
+  void method##Async(RemoteCallContext* call_ctx,                     \
+                     const method##Request* request,                  \
+                     method##Response* response, CallbackFn done) final { \
+    done(MakeStringError("unexpected request"));                      \
+  }
+
+  UNUSED_CLIENT_METHOD(GetDevices);
+  UNUSED_CLIENT_METHOD(CreateContext);
+  UNUSED_CLIENT_METHOD(CloseContext);
+  UNUSED_CLIENT_METHOD(SendReadyChains);
+  UNUSED_CLIENT_METHOD(SendData);
+  UNUSED_CLIENT_METHOD(RegisterFunction);
+  UNUSED_CLIENT_METHOD(RemoteExecuteOp);
+  UNUSED_CLIENT_METHOD(KeepAlive);
+
+#undef UNUSED_CLIENT_METHOD
+
+ private:
+  std::vector<DeleteRemoteObjectsRequest>* requests_;
+  // Requests are retried from timer callbacks, one at a time.
+  std::atomic<int> num_overloaded_;
+  std::atomic<int> num_executes_{0};
+};
+
+std::unique_ptr<HostContext> CreateHostContext() {
+  return std::make_unique<HostContext>(
+      [](const DecodedDiagnostic&) {}, CreateMallocAllocator(),
+      CreateMultiThreadedWorkQueue(/*num_threads=*/2,
+                                   /*num_blocking_threads=*/2));
+}
+
+DeleteRemoteObjectsRequest DeleteRequest(uint64_t context_id,
+                                         uint64_t prefix_id) {
+  DeleteRemoteObjectsRequest request;
+  request.set_context_id(context_id);
+  request.add_input()->set_prefix_id(prefix_id);
+  return request;
+}
+
+// Sends DeleteRemoteObjects requests and returns the requests which reach the
+// wrapped client.
+std::vector<DeleteRemoteObjectsRequest> Coalesce(
+    const std::vector<DeleteRemoteObjectsRequest>& requests,
+    CoalescingRemoteClient::Options options) {
+  auto host = CreateHostContext();
+  std::vector<DeleteRemoteObjectsRequest> sent;
+  latch done(requests.size());
+  {
+    CoalescingRemoteClient client(
+        host.get(), std::make_unique<FakeRemoteClient>(&sent), options);
+    DeleteRemoteObjectsResponse response;
+    for (const auto& request : requests) {
+      client.DeleteRemoteObjectsAsync(RemoteCallContext::GetDefault(),
+                                      &request, &response, [&](Error e) {
+                                        EXPECT_FALSE(e);
+                                        done.count_down();
+                                      });
+    }
+    client.Flush();
+  }
+  done.wait();
+  return sent;
+}
+
+TEST(CoalescingRemoteClient, CoalesceRequests) {
+  CoalescingRemoteClient::Options options;
+  options.window = std::chrono::seconds(60);
+
+  auto sent = Coalesce({DeleteRequest(1, 0), DeleteRequest(1, 1)}, options);
+  ASSERT_EQ(sent.size(), 1);
+  EXPECT_EQ(sent[0].context_id(), 1);
+  ASSERT_EQ(sent[0].input_size(), 2);
+  EXPECT_EQ(sent[0].input(0).prefix_id(), 0);
+  EXPECT_EQ(sent[0].input(1).prefix_id(), 1);
+}
+
+TEST(CoalescingRemoteClient, SplitContexts) {
+  CoalescingRemoteClient::Options options;
+  options.window = std::chrono::seconds(60);
+
+  auto sent = Coalesce({DeleteRequest(1, 0), DeleteRequest(2, 1)}, options);
+  ASSERT_EQ(sent.size(), 2);
+  EXPECT_EQ(sent[0].context_id(), 1);
+  EXPECT_EQ(sent[1].context_id(), 2);
+}
+
+TEST(CoalescingRemoteClient, MaxBatchSize) {
+  CoalescingRemoteClient::Options options;
+  options.window = std::chrono::seconds(60);
+  options.max_batch_size = 2;
+
+  auto sent = Coalesce(
+      {DeleteRequest(1, 0), DeleteRequest(1, 1), DeleteRequest(1, 2)},
+      options);
+  ASSERT_EQ(sent.size(), 2);
+  EXPECT_EQ(sent[0].input_size(), 2);
+  EXPECT_EQ(sent[1].input_size(), 1);
+}
+
+// Sends a RemoteExecute request to a task which rejects the first
+// `num_overloaded` requests, and returns the number of attempts.
+int ExecuteOverloaded(int num_overloaded, bool expect_success) {
+  auto host = CreateHostContext();
+  std::vector<DeleteRemoteObjectsRequest> sent;
+  auto fake = std::make_unique<FakeRemoteClient>(&sent, num_overloaded);
+  FakeRemoteClient* fake_ptr = fake.get();
+
+  CoalescingRemoteClient::Options options;
+  options.overload_backoff = std::chrono::microseconds(10);
+  options.max_overload_retries = 3;
+  CoalescingRemoteClient client(host.get(), std::move(fake), options);
+
+  latch done(1);
+  RemoteExecuteRequest request;
+  RemoteExecuteResponse response;
+  client.RemoteExecuteAsync(RemoteCallContext::GetDefault(), &request,
+                            &response, [&](Error e) {
+                              EXPECT_EQ(!e, expect_success);
+                              llvm::consumeError(std::move(e));
+                              done.count_down();
+                            });
+  done.wait();
+  return fake_ptr->num_executes();
+}
+
+TEST(CoalescingRemoteClient, RetryOverloadedExecute) {
+  EXPECT_EQ(ExecuteOverloaded(/*num_overloaded=*/2, /*expect_success=*/true),
+            3);
+}
+
+TEST(CoalescingRemoteClient, MaxOverloadRetries) {
+  EXPECT_EQ(ExecuteOverloaded(/*num_overloaded=*/5, /*expect_success=*/false),
+            4);
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tfrt/distributed_runtime/payload_codec.h"
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/host_context/host_allocator.h"
+
+namespace tfrt {
+namespace {
+
+constexpr size_t kAlignment = 16;
+
+std::vector<float> DecodeFloats(const SendDataRequest& request,
+                                HostAllocator* allocator) {
+  auto payload = DecodePayloads(request, kAlignment, allocator);
+  EXPECT_TRUE(!!payload);
+  const HostBuffer& buffer = *payload->buffers[0];
+  std::vector<float> values(buffer.size() / sizeof(float));
+  std::memcpy(values.data(), buffer.data(), buffer.size());
+  return values;
+}
+
+string_view AsBytes(const std::vector<float>& values) {
+  return string_view(reinterpret_cast<const char*>(values.data()),
+                     values.size() * sizeof(float));
+}
+
+TEST(PayloadCodecTest, ZlibRoundTrip) {
+  auto allocator = CreateMallocAllocator();
+  std::string data(4096, 'a');
+  SendDataRequest request;
+  SetPayload(PAYLOAD_CODEC_ZLIB, data, &request);
+  EXPECT_EQ(request.codec(), PAYLOAD_CODEC_ZLIB);
+  EXPECT_LT(request.payload(0).size(), data.size());
+
+  auto payload = DecodePayloads(request, kAlignment, allocator.get());
+  ASSERT_TRUE(!!payload);
+  const HostBuffer& buffer = *payload->buffers[0];
+  EXPECT_EQ(string_view(static_cast<const char*>(buffer.data()),
+                        buffer.size()),
+            data);
+}
+
+TEST(PayloadCodecTest, IncompressibleDataIsSentAsIs) {
+  std::string data = "abc";
+  SendDataRequest request;
+  SetPayload(PAYLOAD_CODEC_ZLIB, data, &request);
+  EXPECT_EQ(request.codec(), PAYLOAD_CODEC_NONE);
+  EXPECT_EQ(request.payload(0), data);
+}
+
+TEST(PayloadCodecTest, LossyRoundTrip) {
+  auto allocator = CreateMallocAllocator();
+  std::vector<float> values = {0.f, 1.f, -2.5f, 100.f, 0.001f};
+  for (PayloadCodec codec :
+       {PAYLOAD_CODEC_BF16, PAYLOAD_CODEC_FP16, PAYLOAD_CODEC_INT8}) {
+    SendDataRequest request;
+    SetPayload(codec, AsBytes(values), &request);
+    EXPECT_EQ(request.codec(), codec);
+    EXPECT_LT(request.payload(0).size(), values.size() * sizeof(float));
+
+    std::vector<float> decoded = DecodeFloats(request, allocator.get());
+    ASSERT_EQ(decoded.size(), values.size());
+    for (size_t i = 0; i < values.size(); ++i)
+      EXPECT_NEAR(decoded[i], values[i], 0.5f) << codec;
+  }
+}
+
+TEST(PayloadCodecTest, ErrorFeedback) {
+  auto allocator = CreateMallocAllocator();
+  GradientCompressor compressor(PAYLOAD_CODEC_INT8);
+  // 0.3 is not representable with the scale of 100 / 127, the error is
+  // carried over to the next gradients, so that their sum is preserved.
+  std::vector<float> gradient = {100.f, 0.3f};
+  float sum = 0;
+  const int kNumSteps = 10;
+  for (int i = 0; i < kNumSteps; ++i) {
+    SendDataRequest request;
+    compressor.SetPayload("key", AsBytes(gradient), &request);
+    EXPECT_EQ(request.codec(), PAYLOAD_CODEC_INT8);
+    sum += DecodeFloats(request, allocator.get())[1];
+  }
+  EXPECT_NEAR(sum, kNumSteps * 0.3f, 100.f / 127);
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit test for RemoteInputCache and RemoteInputStore.
+
+#include "tfrt/distributed_runtime/remote_input_cache.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "tfrt/host_context/async_value_ref.h"
+
+namespace tfrt {
+namespace {
+
+using Action = RemoteInputCache::Action;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+RemoteObjectId MakeId(int64_t local_id) {
+  return RemoteObjectId(/*prefix_id=*/1, local_id, RCReference<Device>());
+}
+
+TEST(RemoteInputCache, ReferenceAfterPush) {
+  RemoteInputCache cache(/*capacity_bytes=*/100);
+  const TaskHandle task(7);
+
+  auto push = cache.Acquire(task, MakeId(1), 10);
+  EXPECT_EQ(push.action, Action::kPushAndCache);
+
+  // Not referred to before the push succeeded.
+  EXPECT_EQ(cache.Acquire(task, MakeId(1), 10).action, Action::kPush);
+  cache.Release(task, push.key, /*ok=*/true);
+
+  auto ref = cache.Acquire(task, MakeId(1), 10);
+  EXPECT_EQ(ref.action, Action::kReference);
+  EXPECT_EQ(ref.key, push.key);
+  cache.Release(task, ref.key, /*ok=*/true);
+
+  // Other tasks don't keep the input.
+  EXPECT_EQ(cache.Acquire(TaskHandle(8), MakeId(1), 10).action,
+            Action::kPushAndCache);
+}
+
+TEST(RemoteInputCache, FailedPushIsDropped) {
+  RemoteInputCache cache(/*capacity_bytes=*/100);
+  const TaskHandle task(7);
+
+  auto push = cache.Acquire(task, MakeId(1), 10);
+  cache.Release(task, push.key, /*ok=*/false);
+  EXPECT_THAT(cache.TakeEvictedKeys(task), ElementsAre(push.key));
+
+  auto retry = cache.Acquire(task, MakeId(1), 10);
+  EXPECT_EQ(retry.action, Action::kPushAndCache);
+  EXPECT_NE(retry.key, push.key);
+}
+
+TEST(RemoteInputCache, EvictLeastRecentlyUsed) {
+  RemoteInputCache cache(/*capacity_bytes=*/30);
+  const TaskHandle task(7);
+
+  std::vector<uint64_t> keys;
+  for (int i = 0; i < 3; ++i) {
+    auto push = cache.Acquire(task, MakeId(i), 10);
+    cache.Release(task, push.key, /*ok=*/true);
+    keys.push_back(push.key);
+  }
+  // Input 0 becomes the most recently used.
+  cache.Release(task, cache.Acquire(task, MakeId(0), 10).key, /*ok=*/true);
+
+  EXPECT_EQ(cache.Acquire(task, MakeId(3), 10).action, Action::kPushAndCache);
+  EXPECT_THAT(cache.TakeEvictedKeys(task), ElementsAre(keys[1]));
+  EXPECT_THAT(cache.TakeEvictedKeys(task), IsEmpty());
+
+  // Too large inputs are not cached.
+  EXPECT_EQ(cache.Acquire(task, MakeId(4), 40).action, Action::kPush);
+}
+
+TEST(RemoteInputCache, InFlightInputsAreNotEvicted) {
+  RemoteInputCache cache(/*capacity_bytes=*/20);
+  const TaskHandle task(7);
+
+  auto first = cache.Acquire(task, MakeId(1), 10);
+  cache.Release(task, first.key, /*ok=*/true);
+  auto ref = cache.Acquire(task, MakeId(1), 10);
+  auto second = cache.Acquire(task, MakeId(2), 10);
+  EXPECT_EQ(second.action, Action::kPushAndCache);
+
+  // Both inputs are in flight.
+  EXPECT_EQ(cache.Acquire(task, MakeId(3), 10).action, Action::kPush);
+  EXPECT_THAT(cache.TakeEvictedKeys(task), IsEmpty());
+
+  cache.Release(task, ref.key, /*ok=*/true);
+  cache.Release(task, second.key, /*ok=*/true);
+  EXPECT_EQ(cache.Acquire(task, MakeId(3), 10).action, Action::kPushAndCache);
+  EXPECT_THAT(cache.TakeEvictedKeys(task), ElementsAre(first.key));
+}
+
+TEST(RemoteInputCache, EraseDeletedInput) {
+  RemoteInputCache cache(/*capacity_bytes=*/100);
+  const TaskHandle task(7);
+
+  auto push = cache.Acquire(task, MakeId(1), 10);
+  cache.Release(task, push.key, /*ok=*/true);
+  auto ref = cache.Acquire(task, MakeId(1), 10);
+
+  // Dropped once the request referring to the input completes.
+  cache.Erase(MakeId(1));
+  EXPECT_EQ(cache.Acquire(task, MakeId(1), 10).action, Action::kPush);
+  EXPECT_THAT(cache.TakeEvictedKeys(task), IsEmpty());
+  cache.Release(task, ref.key, /*ok=*/true);
+  EXPECT_THAT(cache.TakeEvictedKeys(task), ElementsAre(push.key));
+}
+
+TEST(RemoteInputStore, InsertFindErase) {
+  RemoteInputStore store;
+  RCReference<AsyncValue> value = MakeAvailableAsyncValueRef<int>(42);
+  store.Insert(/*sender_id=*/1, /*key=*/5, value.CopyRef());
+
+  EXPECT_EQ(store.Find(1, 5).get(), value.get());
+  EXPECT_EQ(store.Find(2, 5).get(), nullptr);
+
+  const uint64_t keys[] = {5, 6};
+  store.Erase(1, keys);
+  EXPECT_EQ(store.Find(1, 5).get(), nullptr);
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Unit tests for the shared memory fabric communicator.
+
+#include "tfrt/distributed_runtime/shared_memory_communicator.h"
+
+#include <memory>
+
+#include "google/protobuf/text_format.h"
+#include "gtest/gtest.h"
+#include "tfrt/distributed_runtime/callback_registry.h"
+#include "tfrt/distributed_runtime/distributed_context.h"
+#include "tfrt/distributed_runtime/payload.h"
+#include "tfrt/distributed_runtime/remote_client.h"
+#include "tfrt/distributed_runtime/server_context.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_buffer.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/support/latch.h"
+#include "tfrt/support/string_util.h"
+
+namespace tfrt {
+namespace {
+
+DistributedContextConfiguration GetDistributedConfiguration(int task_id) {
+  const std::string dist_config_str =
+      "  cluster_config {"
+      "    jobs {"
+      "      name: 'worker'"
+      "      tasks: { key: 0 value: 'shared_memory_test:0' }"
+      "      tasks: { key: 1 value: 'shared_memory_test:1' }"
+      "    }"
+      "  }"
+      "  job_name: 'worker'";
+
+  DistributedContextConfiguration config;
+  EXPECT_TRUE(::google::protobuf::TextFormat::ParseFromString(dist_config_str,
+                                                              &config));
+  config.set_task_id(task_id);
+  return config;
+}
+
+std::unique_ptr<HostContext> CreateHostContext() {
+  return std::make_unique<HostContext>(
+      [](const DecodedDiagnostic&) {}, CreateMallocAllocator(),
+      CreateMultiThreadedWorkQueue(/*num_threads=*/2,
+                                   /*num_blocking_threads=*/2));
+}
+
+ServerContextConfiguration GetServerConfiguration(int task_id) {
+  FabricCommunicatorConfiguration fabric_config{
+      kSharedMemoryCommunicatorType, StrCat("shared_memory_test:", task_id)};
+  return ServerContextConfiguration{fabric_config};
+}
+
+TEST(SharedMemoryCommunicator, SendPayloadWithoutCopy) {
+  const uint64_t context_id = 1;
+  auto host = CreateHostContext();
+
+  ServerContext sender(host.get(), GetServerConfiguration(0));
+  ServerContext receiver(host.get(), GetServerConfiguration(1));
+  ASSERT_NE(sender.GetOrCreateFabricCommunicator(), nullptr);
+
+  auto sender_context = sender.CreateDistributedContext(
+      context_id, GetDistributedConfiguration(0));
+  ASSERT_FALSE(!sender_context);
+  auto receiver_context = receiver.CreateDistributedContext(
+      context_id, GetDistributedConfiguration(1));
+  ASSERT_FALSE(!receiver_context);
+
+  auto buffer = HostBuffer::CreateUninitialized(
+      /*size=*/64, /*alignment=*/64, host->allocator());
+  llvm::SmallVector<RCReference<HostBuffer>, 4> buffers;
+  buffers.push_back(buffer.CopyRef());
+
+  TaskHandle receiver_task =
+      (*sender_context)->GetTaskHandle("/job:worker/task:1");
+  latch sent(1);
+  (*sender_context)
+      ->GetRemoteClient(receiver_task)
+      ->SendPayloadAsync(RemoteCallContext::GetDefault(), context_id, "key",
+                         Payload(std::move(buffers)), [&](Error e) {
+                           EXPECT_FALSE(e);
+                           sent.count_down();
+                         });
+  sent.wait();
+
+  // The receiver gets the buffer that was sent, not a copy.
+  latch received(1);
+  (*receiver_context)
+      ->GetCallbackRegistry()
+      ->SetCallback("key", [&](const InstanceKey&, Payload payload) {
+        ASSERT_EQ(payload.buffers.size(), 1);
+        EXPECT_EQ(payload.buffers[0].get(), buffer.get());
+        received.count_down();
+      });
+  received.wait();
+}
+
+}  // namespace
+}  // namespace tfrt
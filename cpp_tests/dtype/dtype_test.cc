@@ -16,6 +16,8 @@
 
 #include "tfrt/dtype/dtype.h"
 
+#include <cmath>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "tfrt/dtype/dtype_formatter.h"
@@ -87,6 +89,71 @@ TEST(DType, DTypeFormatter) {
 
   EXPECT_EQ(as_str(quint16(3)), "qu16(3)");
   EXPECT_EQ(as_str(qint16(3)), "qi16(3)");
+
+  EXPECT_EQ(as_str(int4(-3)), "i4(-3)");
+  EXPECT_EQ(as_str(uint4(3)), "u4(3)");
+}
+
+TEST(DType, LowPrecisionTraits) {
+  EXPECT_EQ(StrCat(DType::I4), "i4");
+  EXPECT_EQ(StrCat(DType::F8E4M3FN), "f8e4m3fn");
+
+  EXPECT_EQ(GetHostSizeInBits(DType::I4), 4);
+  EXPECT_EQ(GetHostSizeInBits(DType::UI4), 4);
+  EXPECT_EQ(GetHostSizeInBits(DType::F8E5M2), 8);
+  EXPECT_EQ(GetHostSizeInBits(DType::F32), 32);
+
+  EXPECT_TRUE(IsPacked(DType::I4));
+  EXPECT_TRUE(IsPacked(DType::UI4));
+  EXPECT_FALSE(IsPacked(DType::F8E4M3FN));
+  EXPECT_FALSE(IsPacked(DType::I8));
+  EXPECT_FALSE(IsPacked(DType::String));
+
+  EXPECT_EQ(GetHostSizeInBytes(DType::I4, 4), 2);
+  EXPECT_EQ(GetHostSizeInBytes(DType::I4, 5), 3);
+  EXPECT_EQ(GetHostSizeInBytes(DType::F8E5M2, 5), 5);
+  EXPECT_EQ(GetHostSizeInBytes(DType::F32, 5), 20);
+}
+
+TEST(DType, PackedInt4) {
+  uint8_t data[2] = {0, 0};
+  SetPackedInt4(data, 0, int4(-8));
+  SetPackedInt4(data, 1, int4(7));
+  SetPackedInt4(data, 2, int4(-1));
+  EXPECT_EQ(data[0], 0x78);
+  EXPECT_EQ(data[1], 0x0f);
+  EXPECT_EQ(GetPackedInt4<int4>(data, 0).value, -8);
+  EXPECT_EQ(GetPackedInt4<int4>(data, 1).value, 7);
+  EXPECT_EQ(GetPackedInt4<int4>(data, 2).value, -1);
+  EXPECT_EQ(GetPackedInt4<uint4>(data, 2).value, 15);
+  EXPECT_EQ(GetPackedInt4<uint4>(data, 3).value, 0);
+}
+
+TEST(DType, Fp8Conversion) {
+  // Exactly representable values round trip.
+  for (float f : {0.0f, 1.0f, -1.5f, 0.125f, 240.0f, 448.0f}) {
+    EXPECT_EQ(f8e4m3fn::FromFloat(f).ToFloat(), f);
+  }
+  for (float f : {0.0f, 1.0f, -1.5f, 0.75f, 57344.0f}) {
+    EXPECT_EQ(f8e5m2::FromFloat(f).ToFloat(), f);
+  }
+
+  // Rounds to the nearest even value.
+  EXPECT_EQ(f8e4m3fn::FromFloat(1.0625f).ToFloat(), 1.0f);
+  EXPECT_EQ(f8e4m3fn::FromFloat(1.1875f).ToFloat(), 1.25f);
+  EXPECT_EQ(f8e5m2::FromFloat(1.125f).ToFloat(), 1.0f);
+
+  // Subnormals.
+  EXPECT_EQ(f8e4m3fn::FromFloat(0x1p-9f).ToFloat(), 0x1p-9f);
+  EXPECT_EQ(f8e5m2::FromFloat(0x1p-16f).ToFloat(), 0x1p-16f);
+  EXPECT_EQ(f8e4m3fn::FromFloat(0x1p-11f).ToFloat(), 0.0f);
+
+  // f8e4m3fn saturates and f8e5m2 overflows to infinity.
+  EXPECT_EQ(f8e4m3fn::FromFloat(1e6f).ToFloat(), 448.0f);
+  EXPECT_EQ(f8e4m3fn::FromFloat(-1e6f).ToFloat(), -448.0f);
+  EXPECT_TRUE(std::isinf(f8e5m2::FromFloat(1e6f).ToFloat()));
+  EXPECT_TRUE(std::isnan(f8e4m3fn::FromFloat(NAN).ToFloat()));
+  EXPECT_TRUE(std::isnan(f8e5m2::FromFloat(NAN).ToFloat()));
 }
 
 }  // namespace
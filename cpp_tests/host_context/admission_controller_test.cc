@@ -0,0 +1,137 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit tests for AdmissionController.
+
+#include "tfrt/host_context/admission_controller.h"
+
+#include <chrono>
+
+#include "gtest/gtest.h"
+#include "tfrt/cpp_tests/test_util.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_context.h"
+
+namespace tfrt {
+namespace {
+
+AdmissionOptions Options(int max_in_flight, size_t max_queued) {
+  AdmissionOptions options;
+  options.max_in_flight = max_in_flight;
+  options.max_queued = max_queued;
+  options.max_queue_delay = std::chrono::seconds(100);
+  return options;
+}
+
+TEST(AdmissionControllerTest, TryAdmitRejectsWhenFull) {
+  auto host = CreateHostContext();
+  AdmissionController controller(host.get(), "try_admit", Options(2, 0));
+
+  auto first = controller.TryAdmit(TaskPriority::kDefault);
+  auto second = controller.TryAdmit(TaskPriority::kDefault);
+  ASSERT_TRUE(!!first);
+  ASSERT_TRUE(!!second);
+  EXPECT_EQ(controller.in_flight(), 2);
+
+  auto third = controller.TryAdmit(TaskPriority::kCritical);
+  EXPECT_FALSE(!!third);
+  llvm::consumeError(third.takeError());
+
+  // Destroying a token frees its slot.
+  *first = AdmissionToken();
+  EXPECT_EQ(controller.in_flight(), 1);
+  auto fourth = controller.TryAdmit(TaskPriority::kDefault);
+  EXPECT_TRUE(!!fourth);
+}
+
+TEST(AdmissionControllerTest, AdmitsQueuedRequestsByPriority) {
+  auto host = CreateHostContext();
+  AdmissionController controller(host.get(), "by_priority", Options(1, 4));
+
+  auto running = controller.Admit(TaskPriority::kDefault);
+  ASSERT_TRUE(running.IsConcrete());
+
+  auto low = controller.Admit(TaskPriority::kLow);
+  auto high = controller.Admit(TaskPriority::kHigh);
+  EXPECT_EQ(controller.queued(), 2);
+  EXPECT_FALSE(low.IsAvailable());
+  EXPECT_FALSE(high.IsAvailable());
+
+  // A request is never admitted ahead of a queued request of the same or a
+  // higher priority.
+  auto rejected = controller.TryAdmit(TaskPriority::kDefault);
+  EXPECT_FALSE(!!rejected);
+  llvm::consumeError(rejected.takeError());
+
+  running.get() = AdmissionToken();
+  host->Quiesce();
+  EXPECT_TRUE(high.IsConcrete());
+  EXPECT_FALSE(low.IsAvailable());
+  EXPECT_EQ(controller.in_flight(), 1);
+
+  high.get() = AdmissionToken();
+  host->Quiesce();
+  EXPECT_TRUE(low.IsConcrete());
+
+  low.get() = AdmissionToken();
+  EXPECT_EQ(controller.in_flight(), 0);
+  EXPECT_EQ(controller.queued(), 0);
+}
+
+TEST(AdmissionControllerTest, EvictsLowerPriorityWhenQueueIsFull) {
+  auto host = CreateHostContext();
+  AdmissionController controller(host.get(), "evict", Options(1, 1));
+
+  auto running = controller.Admit(TaskPriority::kDefault);
+  auto low = controller.Admit(TaskPriority::kLow);
+  auto high = controller.Admit(TaskPriority::kHigh);
+  EXPECT_TRUE(low.IsError());
+  EXPECT_FALSE(high.IsAvailable());
+
+  // Nothing of a lower priority is queued, so the request is rejected.
+  auto another = controller.Admit(TaskPriority::kLow);
+  EXPECT_TRUE(another.IsError());
+
+  running.get() = AdmissionToken();
+  host->Quiesce();
+  EXPECT_TRUE(high.IsConcrete());
+  high.get() = AdmissionToken();
+}
+
+TEST(AdmissionControllerTest, RequestContextHoldsToken) {
+  auto host = CreateHostContext();
+  AdmissionController controller(host.get(), "request_context",
+                                 Options(1, 0));
+
+  auto request = RequestContextBuilder(host.get(), nullptr)
+                     .set_admission_controller(&controller)
+                     .build();
+  ASSERT_TRUE(!!request);
+  EXPECT_EQ(controller.in_flight(), 1);
+
+  auto rejected = RequestContextBuilder(host.get(), nullptr)
+                      .set_admission_controller(&controller)
+                      .build();
+  EXPECT_FALSE(!!rejected);
+  llvm::consumeError(rejected.takeError());
+
+  request->reset();
+  EXPECT_EQ(controller.in_flight(), 0);
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit tests for TFRT ArenaAllocator.
+
+#include "tfrt/host_context/arena_allocator.h"
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace tfrt {
+namespace {
+
+bool IsAligned(void* ptr, size_t alignment) {
+  return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+TEST(ArenaAllocatorTest, AllocateWithAlignment) {
+  auto allocator = CreateMallocAllocator();
+  auto arena = TakeRef(new ArenaAllocator(allocator.get(), 1024));
+
+  for (size_t size : {1, 7, 64, 100, 1000, 4096}) {
+    for (size_t alignment : {1, 8, 16, 64, 256}) {
+      void* ptr = arena->AllocateBytes(size, alignment);
+      ASSERT_NE(ptr, nullptr);
+      EXPECT_TRUE(IsAligned(ptr, alignment));
+      memset(ptr, 0, size);
+      arena->DeallocateBytes(ptr, size);
+    }
+  }
+}
+
+TEST(ArenaAllocatorTest, BumpAllocate) {
+  auto allocator = CreateMallocAllocator();
+  auto arena = TakeRef(new ArenaAllocator(allocator.get(), 1024));
+
+  auto* first = static_cast<char*>(arena->AllocateBytes(16, 16));
+  auto* second = static_cast<char*>(arena->AllocateBytes(16, 16));
+  EXPECT_EQ(first + 16, second);
+  EXPECT_EQ(arena->allocated_bytes(), 1024);
+
+  arena->DeallocateBytes(first, 16);
+  arena->DeallocateBytes(second, 16);
+}
+
+TEST(ArenaAllocatorTest, AllocationsKeepArenaAlive) {
+  auto allocator = CreateMallocAllocator();
+  auto arena = TakeRef(new ArenaAllocator(allocator.get()));
+
+  void* ptr = arena->AllocateBytes(128, 8);
+  EXPECT_EQ(arena->NumRef(), 2);
+
+  ArenaAllocator* raw_arena = arena.release();
+  raw_arena->DropRef();
+  memset(ptr, 0, 128);
+  raw_arena->DeallocateBytes(ptr, 128);
+}
+
+TEST(ArenaAllocatorTest, ConcurrentAllocate) {
+  auto allocator = CreateMallocAllocator();
+  auto arena = TakeRef(new ArenaAllocator(allocator.get(), 4096));
+
+  constexpr int kNumThreads = 4;
+  constexpr int kNumAllocations = 1000;
+
+  std::vector<std::vector<int64_t*>> allocations(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < kNumAllocations; ++i) {
+        auto* ptr = arena->Allocate<int64_t>(4);
+        for (int j = 0; j < 4; ++j) ptr[j] = t * kNumAllocations + i;
+        allocations[t].push_back(ptr);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (int t = 0; t < kNumThreads; ++t) {
+    for (int i = 0; i < kNumAllocations; ++i) {
+      for (int j = 0; j < 4; ++j)
+        EXPECT_EQ(allocations[t][i][j], t * kNumAllocations + i);
+      arena->Deallocate(allocations[t][i], 4);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace tfrt
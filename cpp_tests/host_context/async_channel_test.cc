@@ -0,0 +1,111 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file contains unit tests for AsyncChannel.
+
+#include "tfrt/concurrency/async_channel.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/concurrency/async_value_ref.h"
+#include "tfrt/concurrency/chain.h"
+
+namespace tsl {
+namespace {
+
+TEST(AsyncChannelTest, ReceivesBufferedValuesInOrder) {
+  AsyncChannel<int> channel(/*capacity=*/2);
+  EXPECT_TRUE(channel.Send(1).IsConcrete());
+  EXPECT_TRUE(channel.Send(2).IsConcrete());
+  EXPECT_EQ(channel.size(), 2);
+
+  EXPECT_EQ(*channel.Receive(), 1);
+  EXPECT_EQ(*channel.Receive(), 2);
+  EXPECT_EQ(channel.size(), 0);
+}
+
+TEST(AsyncChannelTest, CompletesWaitingReceive) {
+  AsyncChannel<int> channel(/*capacity=*/1);
+  auto value = channel.Receive();
+  EXPECT_FALSE(value.IsAvailable());
+
+  EXPECT_TRUE(channel.Send(42).IsConcrete());
+  ASSERT_TRUE(value.IsConcrete());
+  EXPECT_EQ(*value, 42);
+  EXPECT_EQ(channel.size(), 0);
+}
+
+TEST(AsyncChannelTest, DelaysSendToFullChannel) {
+  AsyncChannel<int> channel(/*capacity=*/1);
+  EXPECT_TRUE(channel.Send(1).IsConcrete());
+  auto accepted = channel.Send(2);
+  EXPECT_FALSE(accepted.IsAvailable());
+
+  EXPECT_EQ(*channel.Receive(), 1);
+  EXPECT_TRUE(accepted.IsConcrete());
+  EXPECT_EQ(*channel.Receive(), 2);
+}
+
+TEST(AsyncChannelTest, DrainsClosedChannel) {
+  AsyncChannel<int> channel(/*capacity=*/1);
+  EXPECT_TRUE(channel.Send(1).IsConcrete());
+  auto rejected = channel.Send(2);
+  channel.Close();
+
+  EXPECT_TRUE(rejected.IsError());
+  EXPECT_TRUE(channel.Send(3).IsError());
+  EXPECT_EQ(*channel.Receive(), 1);
+  auto end = channel.Receive();
+  ASSERT_TRUE(end.IsError());
+  EXPECT_EQ(end.GetError().code(), absl::StatusCode::kOutOfRange);
+}
+
+TEST(AsyncChannelTest, FailsWaitingReceiveOnClose) {
+  AsyncChannel<int> channel(/*capacity=*/1);
+  auto value = channel.Receive();
+  channel.Close();
+  ASSERT_TRUE(value.IsError());
+  EXPECT_EQ(value.GetError().code(), absl::StatusCode::kOutOfRange);
+}
+
+TEST(AsyncChannelTest, MultipleProducersAndConsumers) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumValues = 1000;
+  AsyncChannel<int> channel(/*capacity=*/8);
+
+  std::vector<AsyncValueRef<int>> received(kNumThreads * kNumValues);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < kNumValues; ++j) channel.Send(1);
+    });
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < kNumValues; ++j)
+        received[i * kNumValues + j] = channel.Receive();
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  int sum = 0;
+  for (const auto& value : received) {
+    ASSERT_TRUE(value.IsConcrete());
+    sum += *value;
+  }
+  EXPECT_EQ(sum, kNumThreads * kNumValues);
+}
+
+}  // namespace
+}  // namespace tsl
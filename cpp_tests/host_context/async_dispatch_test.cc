@@ -18,13 +18,70 @@
 
 #include <chrono>
 #include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
 #include "tfrt/support/ref_count.h"
 
 namespace tfrt {
 namespace {
 
+// Work queue that runs tasks in the caller thread and records how they were
+// submitted.
+class RecordingWorkQueue : public ConcurrentWorkQueue {
+ public:
+  std::string name() const override { return "recording"; }
+
+  void AddTask(TaskFunction work) override {
+    ++num_add_task_calls;
+    work();
+  }
+
+  void AddTasks(MutableArrayRef<TaskFunction> work) override {
+    batch_sizes.push_back(work.size());
+    for (auto& task : work) task();
+  }
+
+  void AddTaskWithPriority(TaskFunction work, TaskPriority priority) override {
+    priorities.push_back(priority);
+    AddTask(std::move(work));
+  }
+
+  void AddTasksWithPriority(MutableArrayRef<TaskFunction> work,
+                            TaskPriority priority) override {
+    priorities.push_back(priority);
+    AddTasks(work);
+  }
+
+  Optional<TaskFunction> AddBlockingTask(TaskFunction work,
+                                         bool allow_queuing) override {
+    return std::move(work);
+  }
+
+  void Await(ArrayRef<RCReference<AsyncValue>> values) override {}
+  void Quiesce() override {}
+  int GetParallelismLevel() const override { return 1; }
+  bool IsInWorkerThread() const override { return false; }
+
+  int num_add_task_calls = 0;
+  std::vector<size_t> batch_sizes;
+  std::vector<TaskPriority> priorities;
+};
+
+std::unique_ptr<HostContext> CreateTestHostContext(
+    RecordingWorkQueue** work_queue) {
+  auto queue = std::make_unique<RecordingWorkQueue>();
+  *work_queue = queue.get();
+  return std::make_unique<HostContext>([](const DecodedDiagnostic&) {},
+                                       CreateMallocAllocator(),
+                                       std::move(queue));
+}
+
 TEST(AsyncDispatchTest, Await) {
   AsyncValueRef<int> av = MakeConstructedAsyncValueRef<int>(42);
 
@@ -76,5 +133,90 @@ TEST(AsyncDispatchTest, AwaitRangeRCRefs) {
   thread.join();
 }
 
+TEST(AsyncDispatchTest, WaitersEnqueueWorkInOneBatch) {
+  RecordingWorkQueue* work_queue;
+  auto host = CreateTestHostContext(&work_queue);
+
+  AsyncValueRef<int> av = MakeConstructedAsyncValueRef<int>(42);
+  int num_tasks_run = 0;
+  for (int i = 0; i < 3; ++i) {
+    av.AndThen([&] { EnqueueWork(host.get(), [&] { ++num_tasks_run; }); });
+  }
+
+  av.SetStateConcrete();
+  EXPECT_EQ(num_tasks_run, 3);
+  EXPECT_EQ(work_queue->num_add_task_calls, 0);
+  EXPECT_EQ(work_queue->batch_sizes, std::vector<size_t>({3}));
+}
+
+TEST(AsyncDispatchTest, SingleWaiterIsNotBatched) {
+  RecordingWorkQueue* work_queue;
+  auto host = CreateTestHostContext(&work_queue);
+
+  AsyncValueRef<int> av = MakeConstructedAsyncValueRef<int>(42);
+  int num_tasks_run = 0;
+  av.AndThen([&] { EnqueueWork(host.get(), [&] { ++num_tasks_run; }); });
+
+  av.SetStateConcrete();
+  EXPECT_EQ(num_tasks_run, 1);
+  EXPECT_EQ(work_queue->num_add_task_calls, 1);
+  EXPECT_TRUE(work_queue->batch_sizes.empty());
+}
+
+TEST(AsyncDispatchTest, NestedEnqueueWorkBatch) {
+  RecordingWorkQueue* work_queue;
+  auto host = CreateTestHostContext(&work_queue);
+
+  int num_tasks_run = 0;
+  {
+    EnqueueWorkBatch outer;
+    EnqueueWork(host.get(), [&] { ++num_tasks_run; });
+    {
+      EnqueueWorkBatch inner;
+      EnqueueWork(host.get(), [&] { ++num_tasks_run; });
+    }
+    EXPECT_EQ(num_tasks_run, 0);
+  }
+
+  EXPECT_EQ(num_tasks_run, 2);
+  EXPECT_EQ(work_queue->batch_sizes, std::vector<size_t>({2}));
+
+  // Work enqueued outside of a batch goes directly to the work queue.
+  EnqueueWork(host.get(), [&] { ++num_tasks_run; });
+  EXPECT_EQ(num_tasks_run, 3);
+  EXPECT_EQ(work_queue->num_add_task_calls, 1);
+}
+
+TEST(AsyncDispatchTest, RequestPriority) {
+  RecordingWorkQueue* work_queue;
+  auto host = CreateTestHostContext(&work_queue);
+  ResourceContext resource_context;
+
+  RequestOptions request_options;
+  request_options.priority = TaskPriority::kHigh;
+  auto request_context = RequestContextBuilder(host.get(), &resource_context)
+                             .set_request_options(request_options)
+                             .build();
+  ASSERT_FALSE(!request_context);
+  ExecutionContext exec_ctx(std::move(*request_context));
+
+  int num_tasks_run = 0;
+  EnqueueWork(exec_ctx, [&] { ++num_tasks_run; });
+  {
+    // Work of different priorities is submitted in separate batches.
+    EnqueueWorkBatch batch;
+    EnqueueWork(exec_ctx, [&] { ++num_tasks_run; });
+    EnqueueWork(exec_ctx, [&] { ++num_tasks_run; });
+    EnqueueWork(host.get(), [&] { ++num_tasks_run; });
+  }
+
+  EXPECT_EQ(num_tasks_run, 4);
+  EXPECT_EQ(work_queue->priorities,
+            std::vector<TaskPriority>({TaskPriority::kHigh,
+                                       TaskPriority::kHigh}));
+  EXPECT_EQ(work_queue->batch_sizes, std::vector<size_t>({2}));
+  EXPECT_EQ(work_queue->num_add_task_calls, 2);
+}
+
 }  // namespace
 }  // namespace tfrt
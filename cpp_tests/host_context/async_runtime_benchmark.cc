@@ -0,0 +1,128 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks of the async values and work queues the runtime is built on.
+//
+// Run with --benchmark_out=<file> --benchmark_out_format=json to record the
+// results for regression tracking.
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/parallel_for.h"
+
+namespace tfrt {
+namespace {
+
+static std::unique_ptr<HostContext> CreateTestHostContext(int num_threads) {
+  return std::make_unique<HostContext>(
+      [](const DecodedDiagnostic&) {}, CreateMallocAllocator(),
+      CreateMultiThreadedWorkQueue(num_threads, /*num_blocking_threads=*/1));
+}
+
+static void BM_MakeAvailableAsyncValue(benchmark::State& state) {
+  for (auto _ : state) {
+    AsyncValueRef<int32_t> value = MakeAvailableAsyncValueRef<int32_t>(42);
+    benchmark::DoNotOptimize(value);
+  }
+}
+BENCHMARK(BM_MakeAvailableAsyncValue);
+
+static void BM_AndThenAvailable(benchmark::State& state) {
+  AsyncValueRef<int32_t> value = MakeAvailableAsyncValueRef<int32_t>(42);
+  int64_t count = 0;
+  for (auto _ : state) {
+    value.AndThen([&count] { ++count; });
+  }
+  benchmark::DoNotOptimize(count);
+}
+BENCHMARK(BM_AndThenAvailable);
+
+// Creates an unavailable value, adds `state.range(0)` waiters and makes it
+// available, which runs the waiters.
+static void BM_AndThenUnavailable(benchmark::State& state) {
+  int num_waiters = state.range(0);
+  int64_t count = 0;
+  for (auto _ : state) {
+    AsyncValueRef<int32_t> value = MakeConstructedAsyncValueRef<int32_t>(42);
+    for (int i = 0; i < num_waiters; ++i) value.AndThen([&count] { ++count; });
+    value.SetStateConcrete();
+  }
+  benchmark::DoNotOptimize(count);
+  state.SetItemsProcessed(state.iterations() * num_waiters);
+}
+BENCHMARK(BM_AndThenUnavailable)->Arg(1)->Arg(8);
+
+// Enqueues tasks to a work queue with `state.range(0)` threads from one
+// producer, and waits for them to complete.
+static void BM_WorkQueueThroughput(benchmark::State& state) {
+  constexpr int kNumTasks = 1000;
+  auto host = CreateTestHostContext(state.range(0));
+  std::atomic<int64_t> count{0};
+  for (auto _ : state) {
+    for (int i = 0; i < kNumTasks; ++i) {
+      EnqueueWork(host.get(),
+                  [&count] { count.fetch_add(1, std::memory_order_relaxed); });
+    }
+    host->Quiesce();
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTasks);
+}
+BENCHMARK(BM_WorkQueueThroughput)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime();
+
+// Sums an array with ParallelFor on a work queue with `state.range(0)` threads.
+static void BM_ParallelFor(benchmark::State& state) {
+  constexpr size_t kSize = 1 << 20;
+  constexpr size_t kBlockSize = 1 << 14;
+  auto host = CreateTestHostContext(state.range(0));
+  ExecutionContext exec_ctx(
+      *RequestContextBuilder(host.get(), /*resource_context=*/nullptr).build());
+  ParallelFor pfor(exec_ctx);
+
+  std::vector<float> data(kSize, 1.0f);
+  std::vector<float> sums(kSize / kBlockSize);
+  for (auto _ : state) {
+    AsyncValueRef<Chain> done = pfor.Execute(
+        kSize, ParallelFor::BlockSizes::Fixed(kBlockSize),
+        [&](size_t begin, size_t end) {
+          float sum = 0.0f;
+          for (size_t i = begin; i < end; ++i) sum += data[i];
+          sums[begin / kBlockSize] = sum;
+        });
+    host->Await(done.CopyRCRef());
+  }
+  benchmark::DoNotOptimize(sums);
+  state.SetBytesProcessed(state.iterations() * kSize * sizeof(float));
+}
+BENCHMARK(BM_ParallelFor)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+}  // namespace
+}  // namespace tfrt
@@ -0,0 +1,92 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file contains unit tests for TFRT AsyncTask coroutines.
+
+#include "tfrt/host_context/async_task.h"
+
+#if TFRT_HAS_COROUTINES
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "tfrt/cpp_tests/test_util.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/support/error_util.h"
+
+namespace tfrt {
+namespace {
+
+AsyncTask<int32_t> AddAsync(AsyncValueRef<int32_t> a, AsyncValueRef<int32_t> b,
+                            HostContext* host) {
+  auto x = co_await std::move(a);
+  auto y = co_await std::move(b);
+  if (x.IsError()) co_return x.GetError();
+  if (y.IsError()) co_return y.GetError();
+  co_return *x + *y;
+}
+
+AsyncTask<int32_t> DoubleSumAsync(AsyncValueRef<int32_t> a,
+                                  AsyncValueRef<int32_t> b, HostContext* host) {
+  auto sum = co_await AddAsync(std::move(a), std::move(b), host);
+  if (sum.IsError()) co_return sum.GetError();
+  co_return 2 * *sum;
+}
+
+AsyncTask<int32_t> FailAsync() { co_return MakeStringError("failed"); }
+
+TEST(AsyncTaskTest, CompletesWithAvailableValues) {
+  auto host = CreateHostContext();
+  auto result = AddAsync(MakeAvailableAsyncValueRef<int32_t>(1),
+                         MakeAvailableAsyncValueRef<int32_t>(2), host.get())
+                    .result();
+  ASSERT_TRUE(result.IsConcrete());
+  EXPECT_EQ(*result, 3);
+}
+
+TEST(AsyncTaskTest, ResumesWhenValuesBecomeAvailable) {
+  auto host = CreateHostContext();
+  auto a = MakeUnconstructedAsyncValueRef<int32_t>();
+  auto b = MakeUnconstructedAsyncValueRef<int32_t>();
+  auto result = DoubleSumAsync(a.CopyRef(), b.CopyRef(), host.get()).result();
+  EXPECT_FALSE(result.IsAvailable());
+
+  b.emplace(2);
+  EXPECT_FALSE(result.IsAvailable());
+  a.emplace(1);
+  ASSERT_TRUE(result.IsConcrete());
+  EXPECT_EQ(*result, 6);
+}
+
+TEST(AsyncTaskTest, PropagatesErrors) {
+  auto host = CreateHostContext();
+  auto a = MakeUnconstructedAsyncValueRef<int32_t>();
+  auto result = AddAsync(a.CopyRef(), MakeAvailableAsyncValueRef<int32_t>(2),
+                         host.get())
+                    .result();
+  a.SetError("error");
+  ASSERT_TRUE(result.IsError());
+  EXPECT_EQ(result.GetError().message(), "error");
+
+  EXPECT_TRUE(FailAsync().result().IsError());
+}
+
+}  // namespace
+}  // namespace tfrt
+
+#endif  // TFRT_HAS_COROUTINES
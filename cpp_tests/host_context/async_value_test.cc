@@ -16,8 +16,11 @@
 
 #include "tfrt/host_context/async_value.h"
 
+#include <atomic>
 #include <memory>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "tfrt/host_context/async_value_ref.h"
@@ -179,5 +182,66 @@ TEST(AsyncValueTest, StackAllocatedAsyncValue) {
   EXPECT_EQ(2, counter);
 }
 
+TEST(AsyncValueTest, AddRefToUniqueValue) {
+  AsyncValue* value = MakeAvailableAsyncValueRef<int32_t>(123).release();
+  EXPECT_TRUE(value->IsUnique());
+
+  // Unique value takes a fast path that does not do an atomic increment.
+  value->AddRef(3);
+  EXPECT_EQ(value->NumRef(), 4);
+
+  value->AddRef();
+  EXPECT_EQ(value->NumRef(), 5);
+
+  value->DropRef(4);
+  EXPECT_TRUE(value->IsUnique());
+  value->DropRef();
+}
+
+TEST(AsyncValueTest, PooledSmallValues) {
+  // Small async values are created in one thread, and released in another.
+  constexpr int kNumValues = 10000;
+  std::vector<AsyncValueRef<int32_t>> values;
+  for (int i = 0; i < kNumValues; ++i)
+    values.push_back(MakeAvailableAsyncValueRef<int32_t>(i));
+
+  std::thread releaser([&] {
+    for (int i = 0; i < kNumValues; ++i) {
+      EXPECT_EQ(values[i].get(), i);
+      values[i].reset();
+    }
+    // Blocks released by this thread are reused by its allocations.
+    auto value = MakeAvailableAsyncValueRef<int64_t>(42);
+    EXPECT_EQ(value.get(), 42);
+  });
+  releaser.join();
+
+  // Blocks cached by the exited thread are available to other threads.
+  for (int i = 0; i < kNumValues; ++i) {
+    auto value = MakeConstructedAsyncValueRef<int32_t>(i);
+    value.SetStateConcrete();
+    EXPECT_EQ(value.get(), i);
+  }
+}
+
+TEST(AsyncValueTest, PooledWaiters) {
+  // Waiters are enqueued in one thread, and run and released in another.
+  constexpr int kNumValues = 1000;
+  constexpr int kNumWaiters = 4;
+  std::vector<AsyncValueRef<int32_t>> values;
+  std::atomic<int> num_notified{0};
+  for (int i = 0; i < kNumValues; ++i) {
+    values.push_back(MakeUnconstructedAsyncValueRef<int32_t>());
+    for (int j = 0; j < kNumWaiters; ++j)
+      values.back().AndThen([&num_notified] { ++num_notified; });
+  }
+
+  std::thread notifier([&] {
+    for (auto& value : values) value.emplace(42);
+  });
+  notifier.join();
+  EXPECT_EQ(num_notified, kNumValues * kNumWaiters);
+}
+
 }  // namespace
 }  // namespace tfrt
@@ -19,8 +19,14 @@
 #include "tfrt/host_context/host_allocator.h"
 
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "tfrt/support/numa.h"
 
 namespace tfrt {
 namespace {
@@ -53,6 +59,267 @@ TEST_F(HostAllocatorTest, AllocateDeallocate) {
   allocator_->Deallocate<uint64_t>(entries, kTestAllocateEntryCount);
 }
 
+class SlabAllocatorTest : public ::testing::Test {
+ protected:
+  SlabAllocatorTest()
+      : allocator_(CreateSlabAllocator(CreateMallocAllocator())) {}
+  std::unique_ptr<HostAllocator> allocator_;
+};
+
+TEST_F(SlabAllocatorTest, AllocateDeallocateBytesWithAlignment) {
+  auto is_aligned = [](void* ptr, size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+  };
+
+  for (size_t size : {1, 8, 24, 64, 100, 512, 513, 4096}) {
+    for (size_t alignment : {1, 8, 16, 64, 256, 1024}) {
+      void* buffer = allocator_->AllocateBytes(size, alignment);
+      ASSERT_NE(nullptr, buffer);
+      EXPECT_TRUE(is_aligned(buffer, alignment));
+      memset(buffer, 0, size);
+      allocator_->DeallocateBytes(buffer, size);
+    }
+  }
+}
+
+TEST_F(SlabAllocatorTest, ReusesDeallocatedBlocks) {
+  void* buffer = allocator_->AllocateBytes(32, 8);
+  allocator_->DeallocateBytes(buffer, 32);
+  EXPECT_EQ(buffer, allocator_->AllocateBytes(32, 8));
+  allocator_->DeallocateBytes(buffer, 32);
+}
+
+TEST_F(SlabAllocatorTest, DistinctLiveBlocks) {
+  std::vector<uint64_t*> entries;
+  for (int i = 0; i < 10000; ++i) {
+    entries.push_back(allocator_->Allocate<uint64_t>());
+    *entries.back() = i;
+  }
+  for (int i = 0; i < 10000; ++i) {
+    EXPECT_EQ(*entries[i], i);
+    allocator_->Deallocate(entries[i]);
+  }
+}
+
+TEST_F(SlabAllocatorTest, CrossThreadDeallocate) {
+  constexpr int kNumBlocks = 1000;
+  std::vector<void*> blocks;
+  for (int i = 0; i < kNumBlocks; ++i)
+    blocks.push_back(allocator_->AllocateBytes(64, 16));
+
+  std::thread thread([&]() {
+    for (void* block : blocks) allocator_->DeallocateBytes(block, 64);
+    for (int i = 0; i < kNumBlocks; ++i)
+      blocks[i] = allocator_->AllocateBytes(64, 16);
+  });
+  thread.join();
+
+  for (void* block : blocks) allocator_->DeallocateBytes(block, 64);
+}
+
+TEST_F(SlabAllocatorTest, MultipleAllocatorsOnOneThread) {
+  auto other = CreateSlabAllocator(CreateMallocAllocator());
+  for (int i = 0; i < 100; ++i) {
+    void* a = allocator_->AllocateBytes(16, 8);
+    void* b = other->AllocateBytes(16, 8);
+    EXPECT_NE(a, b);
+    allocator_->DeallocateBytes(a, 16);
+    other->DeallocateBytes(b, 16);
+  }
+  other.reset();
+  void* buffer = allocator_->AllocateBytes(16, 8);
+  allocator_->DeallocateBytes(buffer, 16);
+}
+
+class BufferPoolAllocatorTest : public ::testing::Test {
+ protected:
+  BufferPoolAllocatorTest()
+      : allocator_(CreateBufferPoolAllocator(CreateMallocAllocator())) {}
+  std::unique_ptr<HostAllocator> allocator_;
+};
+
+TEST_F(BufferPoolAllocatorTest, AllocateDeallocateBytesWithAlignment) {
+  auto is_aligned = [](void* ptr, size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+  };
+
+  for (size_t size : {16, 512, 513, 1000, 4096, 100000, 1 << 26, 1 << 27}) {
+    for (size_t alignment : {1, 8, 64, 256, 4096}) {
+      void* buffer = allocator_->AllocateBytes(size, alignment);
+      ASSERT_NE(nullptr, buffer);
+      EXPECT_TRUE(is_aligned(buffer, alignment));
+      memset(buffer, 0, size);
+      allocator_->DeallocateBytes(buffer, size);
+    }
+  }
+}
+
+TEST_F(BufferPoolAllocatorTest, ReusesDeallocatedBuffers) {
+  void* buffer = allocator_->AllocateBytes(4000, 64);
+  allocator_->DeallocateBytes(buffer, 4000);
+
+  // Sizes in the same size class share buffers.
+  EXPECT_EQ(buffer, allocator_->AllocateBytes(3900, 64));
+  allocator_->DeallocateBytes(buffer, 3900);
+}
+
+TEST_F(BufferPoolAllocatorTest, CrossThreadDeallocate) {
+  constexpr int kNumBuffers = 100;
+  constexpr size_t kSize = 1024 * 1024;
+  std::vector<void*> buffers;
+  for (int i = 0; i < kNumBuffers; ++i)
+    buffers.push_back(allocator_->AllocateBytes(kSize, 64));
+
+  // More than fits into one thread cache, the rest goes to the shared pool.
+  std::thread thread([&]() {
+    for (void* buffer : buffers) allocator_->DeallocateBytes(buffer, kSize);
+  });
+  thread.join();
+
+  for (int i = 0; i < kNumBuffers; ++i) {
+    buffers[i] = allocator_->AllocateBytes(kSize, 64);
+    memset(buffers[i], 0, kSize);
+  }
+  for (void* buffer : buffers) allocator_->DeallocateBytes(buffer, kSize);
+}
+
+TEST_F(BufferPoolAllocatorTest, MultipleAllocatorsOnOneThread) {
+  auto other = CreateBufferPoolAllocator(CreateMallocAllocator());
+  for (int i = 0; i < 100; ++i) {
+    void* a = allocator_->AllocateBytes(2048, 8);
+    void* b = other->AllocateBytes(2048, 8);
+    EXPECT_NE(a, b);
+    allocator_->DeallocateBytes(a, 2048);
+    other->DeallocateBytes(b, 2048);
+  }
+  other.reset();
+  void* buffer = allocator_->AllocateBytes(2048, 8);
+  allocator_->DeallocateBytes(buffer, 2048);
+}
+
+// Forwards to a malloc allocator and counts the allocations.
+class CountingAllocator : public HostAllocator {
+ public:
+  explicit CountingAllocator(int* num_allocations)
+      : allocator_(CreateMallocAllocator()),
+        num_allocations_(num_allocations) {}
+
+  void* AllocateBytes(size_t size, size_t alignment) override {
+    ++*num_allocations_;
+    return allocator_->AllocateBytes(size, alignment);
+  }
+  void DeallocateBytes(void* ptr, size_t size) override {
+    allocator_->DeallocateBytes(ptr, size);
+  }
+
+ private:
+  std::unique_ptr<HostAllocator> allocator_;
+  int* num_allocations_;
+};
+
+TEST(BufferPoolProfileTest, WarmUpFromProfile) {
+  const std::string path = ::testing::TempDir() + "/buffer_pool_profile";
+  const size_t kSize = 4096;
+  std::remove(path.c_str());
+
+  int num_allocations = 0;
+  auto allocate_all = [&](HostAllocator* allocator) {
+    std::vector<void*> buffers;
+    for (int i = 0; i < 3; ++i)
+      buffers.push_back(allocator->AllocateBytes(kSize, 8));
+    for (void* buffer : buffers) allocator->DeallocateBytes(buffer, kSize);
+  };
+
+  auto allocator = CreateBufferPoolAllocator(
+      std::make_unique<CountingAllocator>(&num_allocations),
+      /*max_cached_bytes=*/1 << 20, path);
+  allocate_all(allocator.get());
+  EXPECT_EQ(num_allocations, 3);
+  allocator.reset();
+
+  // The new pool allocates the three buffers when it is created.
+  num_allocations = 0;
+  allocator = CreateBufferPoolAllocator(
+      std::make_unique<CountingAllocator>(&num_allocations),
+      /*max_cached_bytes=*/1 << 20, path);
+  EXPECT_EQ(num_allocations, 3);
+  allocate_all(allocator.get());
+  EXPECT_EQ(num_allocations, 3);
+  allocator.reset();
+  std::remove(path.c_str());
+}
+
+TEST(HugePageAllocatorTest, AllocateDeallocateBytesWithAlignment) {
+  auto allocator = CreateHugePageAllocator(CreateMallocAllocator());
+
+  for (size_t size : {size_t{16}, size_t{2 << 20}, size_t{5 << 20} + 1}) {
+    for (size_t alignment : {size_t{16}, size_t{4 << 20}}) {
+      void* ptr = allocator->AllocateBytes(size, alignment);
+      ASSERT_NE(ptr, nullptr);
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignment, 0);
+      memset(ptr, 0xab, size);
+      allocator->DeallocateBytes(ptr, size);
+    }
+  }
+}
+
+TEST(HugePageAllocatorTest, ReservedRegion) {
+  constexpr size_t kSize = 2 << 20;
+  auto allocator = CreateHugePageAllocator(CreateMallocAllocator(), 3 * kSize);
+
+  // Three buffers fit into the reserved region, the fourth is mapped.
+  std::vector<void*> buffers;
+  for (int i = 0; i < 4; ++i) {
+    buffers.push_back(allocator->AllocateBytes(kSize, 64));
+    ASSERT_NE(buffers.back(), nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffers.back()) % kSize, 0);
+    memset(buffers.back(), 0xab, kSize);
+  }
+  auto* region = static_cast<char*>(buffers[0]);
+  EXPECT_EQ(buffers[1], region + kSize);
+  EXPECT_EQ(buffers[2], region + 2 * kSize);
+
+  // Freed ranges are merged and reused.
+  allocator->DeallocateBytes(buffers[0], kSize);
+  allocator->DeallocateBytes(buffers[1], kSize);
+  void* ptr = allocator->AllocateBytes(2 * kSize, 64);
+  EXPECT_EQ(ptr, buffers[0]);
+  allocator->DeallocateBytes(ptr, 2 * kSize);
+
+  allocator->DeallocateBytes(buffers[2], kSize);
+  allocator->DeallocateBytes(buffers[3], kSize);
+}
+
+TEST(NumaAllocatorTest, AllocateDeallocateBytesWithAlignment) {
+  auto allocator = CreateNumaAllocator(CreateMallocAllocator());
+
+  // Allocate from a thread assigned to a NUMA node and from the main thread.
+  std::thread thread([&] {
+    numa::SetCurrentThreadNode(0);
+    for (size_t size : {size_t{16}, size_t{128 * 1024}, size_t{1 << 20} + 1}) {
+      for (size_t alignment : {size_t{16}, size_t{64 * 1024}}) {
+        void* ptr = allocator->AllocateBytes(size, alignment);
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignment, 0);
+        memset(ptr, 0xab, size);
+        allocator->DeallocateBytes(ptr, size);
+      }
+    }
+  });
+  thread.join();
+
+  void* ptr = allocator->AllocateBytes(1 << 20, 64);
+  ASSERT_NE(ptr, nullptr);
+  memset(ptr, 0xab, 1 << 20);
+  allocator->DeallocateBytes(ptr, 1 << 20);
+}
+
+TEST(NumaAllocatorTest, NodeCpus) {
+  ASSERT_GE(numa::GetNumNodes(), 1);
+  for (const auto& cpus : numa::GetNodeCpus()) EXPECT_FALSE(cpus.empty());
+  EXPECT_EQ(numa::GetCurrentThreadNode(), -1);
+}
+
 // Tests for HostArray class.
 constexpr size_t kTestArraySize = 16;
 class HostArrayTest : public ::testing::Test {
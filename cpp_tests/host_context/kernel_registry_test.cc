@@ -0,0 +1,78 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit test for TFRT KernelRegistry.
+
+#include "tfrt/host_context/kernel_registry.h"
+
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/support/string_util.h"
+
+namespace tfrt {
+namespace {
+
+std::unique_ptr<HostContext> CreateTestHostContext() {
+  return std::make_unique<HostContext>(
+      [](const DecodedDiagnostic&) {}, CreateMallocAllocator(),
+      CreateSingleThreadedWorkQueue());
+}
+
+void AsyncKernel(AsyncKernelFrame*) {}
+void SyncKernel(SyncKernelFrame*) {}
+
+TEST(KernelRegistryTest, FrozenLookup) {
+  auto host = CreateTestHostContext();
+  KernelRegistry* registry = host->GetMutableRegistry();
+
+  for (int i = 0; i < 1000; ++i) {
+    registry->AddKernel(StrCat("test.async.", i), AsyncKernel);
+    registry->AddSyncKernel(StrCat("test.sync.", i), SyncKernel);
+  }
+  registry->Freeze();
+
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(registry->GetKernel(StrCat("test.async.", i))
+                    .is<AsyncKernelImplementation>());
+    EXPECT_TRUE(registry->GetKernel(StrCat("test.sync.", i))
+                    .is<SyncKernelImplementation>());
+  }
+  EXPECT_TRUE(registry->GetKernel("test.async.1000").is<Monostate>());
+  EXPECT_TRUE(registry->GetKernel("").is<Monostate>());
+}
+
+TEST(KernelRegistryTest, AddAfterFreeze) {
+  auto host = CreateTestHostContext();
+  KernelRegistry* registry = host->GetMutableRegistry();
+
+  registry->AddKernel("test.first", AsyncKernel);
+  registry->Freeze();
+  registry->AddKernel("test.second", AsyncKernel);
+
+  EXPECT_TRUE(
+      registry->GetKernel("test.first").is<AsyncKernelImplementation>());
+  EXPECT_TRUE(
+      registry->GetKernel("test.second").is<AsyncKernelImplementation>());
+}
+
+}  // namespace
+}  // namespace tfrt
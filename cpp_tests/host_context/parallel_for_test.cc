@@ -102,6 +102,106 @@ TEST(ParallelForTest, MinBlockSize) {
   ASSERT_EQ(ranges, expected);
 }
 
+TEST(ParallelForTest, CostBlockSizeInline) {
+  auto host = CreateTestHostContext(4);
+  ParallelFor pfor(CreateTestExecutionContext(host.get()));
+
+  // Cheap range is not worth parallelizing and runs in the caller thread.
+  std::vector<Range> ranges;
+  AsyncValueRef<Chain> done = pfor.Execute(
+      1000, BlockSizes::Cost(/*bytes_loaded=*/8, /*bytes_stored=*/4,
+                             /*compute_cycles=*/1),
+      [&](size_t begin, size_t end) { ranges.push_back({begin, end}); });
+
+  ASSERT_TRUE(done.IsAvailable());
+  const std::vector<Range> expected = {{0, 1000}};
+  ASSERT_EQ(ranges, expected);
+}
+
+TEST(ParallelForTest, CostBlockSize) {
+  auto host = CreateTestHostContext(4);
+  ParallelFor pfor(CreateTestExecutionContext(host.get()));
+
+  latch barrier(1);
+  mutex mu;
+  std::vector<Range> ranges;
+
+  // Expensive range is split to assign a few balanced blocks to each thread.
+  AsyncValueRef<Chain> done = pfor.Execute(
+      1000, BlockSizes::Cost(/*bytes_loaded=*/8, /*bytes_stored=*/4,
+                             /*compute_cycles=*/100000),
+      [&](size_t begin, size_t end) {
+        mutex_lock lock(mu);
+        ranges.push_back({begin, end});
+      });
+  done.AndThen([&]() { barrier.count_down(); });
+
+  barrier.wait();
+
+  std::sort(ranges.begin(), ranges.end());
+  ASSERT_EQ(ranges.size(), 16);
+  EXPECT_EQ(ranges.front().first, 0);
+  EXPECT_EQ(ranges.back().second, 1000);
+  for (size_t i = 1; i < ranges.size(); ++i)
+    EXPECT_EQ(ranges[i - 1].second, ranges[i].first);
+}
+
+TEST(ParallelForTest, SplitInWorkers) {
+  auto host = CreateTestHostContext(4);
+  ParallelFor pfor(CreateTestExecutionContext(host.get()),
+                   ParallelFor::SplitMode::kWorkers);
+
+  latch barrier(1);
+  mutex mu;
+  std::vector<Range> ranges;
+  std::atomic<int32_t> caller_blocks{0};
+  const std::thread::id caller = std::this_thread::get_id();
+
+  AsyncValueRef<Chain> done =
+      pfor.Execute(1000, BlockSizes::Fixed(10), [&](size_t begin, size_t end) {
+        if (std::this_thread::get_id() == caller) caller_blocks++;
+        mutex_lock lock(mu);
+        ranges.push_back({begin, end});
+      });
+  done.AndThen([&]() { barrier.count_down(); });
+
+  barrier.wait();
+
+  // All blocks are evaluated by the worker threads.
+  EXPECT_EQ(caller_blocks.load(), 0);
+
+  std::sort(ranges.begin(), ranges.end());
+  ASSERT_EQ(ranges.size(), 100);
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    EXPECT_EQ(ranges[i].first, i * 10);
+    EXPECT_EQ(ranges[i].second, (i + 1) * 10);
+  }
+}
+
+TEST(ParallelForTest, IsInParallelRegion) {
+  auto host = CreateTestHostContext(4);
+  ParallelFor pfor(CreateTestExecutionContext(host.get()));
+
+  // A range computed as a single block is not a parallel region.
+  bool in_region = true;
+  pfor.Execute(10, BlockSizes::Fixed(10), [&](size_t begin, size_t end) {
+    in_region = ParallelFor::IsInParallelRegion();
+  });
+  EXPECT_FALSE(in_region);
+
+  latch barrier(1);
+  std::atomic<int32_t> region_blocks{0};
+  AsyncValueRef<Chain> done =
+      pfor.Execute(100, BlockSizes::Fixed(10), [&](size_t begin, size_t end) {
+        if (ParallelFor::IsInParallelRegion()) region_blocks++;
+      });
+  done.AndThen([&]() { barrier.count_down(); });
+  barrier.wait();
+
+  EXPECT_EQ(region_blocks.load(), 10);
+  EXPECT_FALSE(ParallelFor::IsInParallelRegion());
+}
+
 TEST(ParallelForTest, BlockTasksCompletion) {
   auto host = CreateTestHostContext(4);
   ParallelFor pfor(CreateTestExecutionContext(host.get()));
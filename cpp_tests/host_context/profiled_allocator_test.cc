@@ -0,0 +1,93 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit tests for allocation sampling of the profiled allocator.
+
+#include "tfrt/host_context/profiled_allocator.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/host_context/host_allocator.h"
+
+namespace tfrt {
+namespace {
+
+TEST(ProfiledAllocatorTest, AllocationSiteScope) {
+  auto outer_name = [] { return std::string("outer"); };
+  auto inner_name = [] { return std::string("inner"); };
+
+  EXPECT_EQ(AllocationSiteScope::CurrentName(), "");
+  {
+    AllocationSiteScope outer(outer_name);
+    {
+      AllocationSiteScope inner(inner_name);
+      // Scopes are only tracked while allocations are sampled.
+      EXPECT_EQ(AllocationSiteScope::CurrentName(), "");
+    }
+  }
+
+  AllocationSamplingOptions options;
+  EnableAllocationSampling(options);
+  {
+    AllocationSiteScope outer(outer_name);
+    {
+      AllocationSiteScope inner(inner_name);
+      EXPECT_EQ(AllocationSiteScope::CurrentName(), "inner");
+    }
+    EXPECT_EQ(AllocationSiteScope::CurrentName(), "outer");
+  }
+  EXPECT_EQ(AllocationSiteScope::CurrentName(), "");
+  DisableAllocationSampling();
+}
+
+TEST(ProfiledAllocatorTest, SampleAllocationSites) {
+  auto allocator = CreateProfiledAllocator(CreateMallocAllocator());
+
+  AllocationSamplingOptions options;
+  options.sampling_bytes = 1024;
+  EnableAllocationSampling(options);
+
+  constexpr int kNumAllocations = 1000;
+  constexpr size_t kAllocationSize = 4096;
+  auto site_name = [] { return std::string("test_site"); };
+  {
+    AllocationSiteScope scope(site_name);
+    for (int i = 0; i < kNumAllocations; ++i) {
+      void* ptr = allocator->AllocateBytes(kAllocationSize, alignof(int));
+      allocator->DeallocateBytes(ptr, kAllocationSize);
+    }
+  }
+  DisableAllocationSampling();
+
+  std::vector<AllocationSiteProfile> profiles = GetAllocationSiteProfiles();
+  auto it = std::find_if(
+      profiles.begin(), profiles.end(),
+      [](const AllocationSiteProfile& p) { return p.site == "test_site"; });
+  ASSERT_NE(it, profiles.end());
+  EXPECT_GT(it->samples, 0);
+  // Allocations of 4 times the sampling interval are almost always sampled,
+  // so the estimates are close to the actual allocations.
+  EXPECT_NEAR(it->allocations, kNumAllocations, kNumAllocations / 10);
+  EXPECT_NEAR(it->bytes, kNumAllocations * kAllocationSize,
+              kNumAllocations * kAllocationSize / 10);
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -16,11 +16,15 @@
 
 // Unit test for TFRT RequestContext.
 
+#include <cstring>
+
 #include "gtest/gtest.h"
 #include "tfrt/host_context/concurrent_work_queue.h"
 #include "tfrt/host_context/execution_context.h"
 #include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_buffer.h"
 #include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/host_counters.h"
 
 namespace tfrt {
 namespace {
@@ -60,5 +64,112 @@ TEST(RequestContextTest, ContextData) {
   EXPECT_EQ(expected_request_context.get()->GetDataIfExists<int>(), nullptr);
 }
 
+TEST(RequestContextTest, Priority) {
+  auto host = CreateTestHostContext();
+  ResourceContext resource_context;
+
+  auto default_request_context =
+      RequestContextBuilder(host.get(), &resource_context).build();
+  ASSERT_FALSE(!default_request_context);
+  EXPECT_EQ(default_request_context.get()->priority(), TaskPriority::kDefault);
+
+  RequestOptions request_options;
+  request_options.priority = TaskPriority::kCritical;
+  auto request_context = RequestContextBuilder(host.get(), &resource_context)
+                             .set_request_options(request_options)
+                             .build();
+  ASSERT_FALSE(!request_context);
+  EXPECT_EQ(request_context.get()->priority(), TaskPriority::kCritical);
+
+  ExecutionContext exec_ctx(std::move(*request_context));
+  EXPECT_EQ(exec_ctx.priority(), TaskPriority::kCritical);
+}
+
+TEST(RequestContextTest, ArenaDisabledByDefault) {
+  auto host = CreateTestHostContext();
+  ResourceContext resource_context;
+  auto request_context =
+      RequestContextBuilder(host.get(), &resource_context).build();
+  ASSERT_FALSE(!request_context);
+  EXPECT_EQ(request_context.get()->arena(), nullptr);
+
+  ExecutionContext exec_ctx(std::move(*request_context));
+  EXPECT_EQ(exec_ctx.temporary_allocator(), host->allocator());
+}
+
+TEST(RequestContextTest, Arena) {
+  auto host = CreateTestHostContext();
+  ResourceContext resource_context;
+  auto request_context = RequestContextBuilder(host.get(), &resource_context)
+                             .enable_arena(/*block_size=*/1024)
+                             .build();
+  ASSERT_FALSE(!request_context);
+  ASSERT_NE(request_context.get()->arena(), nullptr);
+
+  ExecutionContext exec_ctx(std::move(*request_context));
+  HostAllocator* allocator = exec_ctx.temporary_allocator();
+  EXPECT_EQ(allocator, exec_ctx.request_ctx()->arena());
+
+  // Arena allocations outlive the request context.
+  auto buffer = HostBuffer::CreateUninitialized(/*size=*/128,
+                                                /*alignment=*/64, allocator);
+  ASSERT_TRUE(buffer);
+  exec_ctx = ExecutionContext(
+      std::move(*RequestContextBuilder(host.get(), &resource_context).build()));
+  memset(buffer->data(), 0, buffer->size());
+}
+
+TEST(RequestContextTest, CancelSharesError) {
+  auto host = CreateTestHostContext();
+  ResourceContext resource_context;
+  auto build = [&] {
+    return std::move(
+        *RequestContextBuilder(host.get(), &resource_context).build());
+  };
+  RCReference<RequestContext> first = build();
+  RCReference<RequestContext> second = build();
+  EXPECT_FALSE(first->IsCancelled());
+
+  first->Cancel();
+  first->Cancel();
+  second->Cancel();
+  ASSERT_TRUE(first->IsCancelled());
+  EXPECT_EQ(first->GetCancelAsyncValue(), second->GetCancelAsyncValue());
+  EXPECT_TRUE(absl::IsCancelled(first->GetCancelAsyncValue()->GetError()));
+
+  // The error outlives the cancelled requests.
+  ErrorAsyncValue* error = first->GetCancelAsyncValue();
+  first.reset();
+  second.reset();
+  build()->Cancel();
+  EXPECT_TRUE(error->IsError());
+}
+
+TEST(RequestContextTest, HostCounters) {
+  auto host = CreateTestHostContext();
+  ResourceContext resource_context;
+  auto build = [&] {
+    return std::move(
+        *RequestContextBuilder(host.get(), &resource_context).build());
+  };
+  EXPECT_EQ(build()->host_counters(), nullptr);
+
+  // One out of two requests is sampled.
+  SetHostCountersSamplingPeriod(2);
+  RCReference<RequestContext> requests[] = {build(), build(), build()};
+  SetHostCountersSamplingPeriod(0);
+  int num_sampled = 0;
+  for (auto& request : requests) {
+    if (request->host_counters() == nullptr) continue;
+    ++num_sampled;
+    internal::AddHostCounter(request.get(), HostCounter::kTasks, 2);
+    EXPECT_EQ(request->host_counters()->Get(HostCounter::kTasks), 2);
+    EXPECT_EQ(request->host_counters()->Get(HostCounter::kExecutors), 0);
+  }
+  EXPECT_GE(num_sampled, 1);
+  EXPECT_LE(num_sampled, 2);
+  FlushHostCounters();
+}
+
 }  // namespace
 }  // namespace tfrt
@@ -54,5 +54,25 @@ TEST(RequestDeadlineTrackerTest, CancelRequest) {
   ASSERT_TRUE((*req_ctx)->IsCancelled());
 }
 
+TEST(RequestDeadlineTrackerTest, CancelDeadline) {
+  std::unique_ptr<HostContext> host = CreateTestHostContext(1);
+  RequestDeadlineTracker req_deadline_tracker{host.get()};
+  Expected<RCReference<RequestContext>> req_ctx =
+      RequestContextBuilder(host.get(), /*resource_context=*/nullptr).build();
+  ASSERT_FALSE(!req_ctx);
+
+  std::chrono::system_clock::time_point deadline =
+      std::chrono::system_clock::now() + 500ms;
+  auto timer = req_deadline_tracker.CancelRequestOnDeadline(
+      deadline, req_ctx->CopyRef());
+
+  // Request completed before the deadline.
+  req_deadline_tracker.CancelDeadline(timer);
+  ASSERT_TRUE((*req_ctx)->IsUnique());
+
+  std::this_thread::sleep_for(1s);
+  ASSERT_FALSE((*req_ctx)->IsCancelled());
+}
+
 }  // namespace
 }  // namespace tfrt
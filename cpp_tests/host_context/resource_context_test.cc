@@ -79,6 +79,37 @@ TEST(ResourceContextTest, CreateAndGet) {
   EXPECT_EQ(resource.getValue()->GetData(), 41);
 }
 
+TEST(ResourceContextTest, Slot) {
+  static ResourceSlot<SomeResource> slot("some_name");
+
+  ResourceContext resource_context;
+  EXPECT_FALSE(resource_context.GetResource(slot).has_value());
+
+  SomeResource* rc = resource_context.GetOrCreateResource(slot, 41);
+  ASSERT_EQ(rc->GetData(), 41);
+  EXPECT_EQ(resource_context.GetOrCreateResource(slot, 42), rc);
+  EXPECT_EQ(resource_context.GetResource(slot).getValue(), rc);
+
+  // Slots and names refer to the same resource.
+  EXPECT_EQ(resource_context.GetResourceOrDie<SomeResource>("some_name"), rc);
+
+  // Other resource contexts have their own resource.
+  ResourceContext other_resource_context;
+  EXPECT_NE(other_resource_context.GetOrCreateResource(slot, 42), rc);
+
+  resource_context.DeleteResource("some_name");
+  EXPECT_FALSE(resource_context.GetResource(slot).has_value());
+}
+
+TEST(ResourceContextTest, SlotCreatedByName) {
+  static ResourceSlot<SomeResource> slot("some_name");
+
+  ResourceContext resource_context;
+  SomeResource* rc =
+      resource_context.CreateResource<SomeResource>("some_name", 41);
+  EXPECT_EQ(resource_context.GetResource(slot).getValue(), rc);
+}
+
 TEST(ResourceContextTest, DestructionOrder) {
   static bool parent_destroyed = false;
   struct Parent {
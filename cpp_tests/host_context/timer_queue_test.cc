@@ -18,9 +18,12 @@
 
 #include "tfrt/host_context/timer_queue.h"
 
+#include <atomic>
 #include <chrono>
 #include <ctime>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -93,5 +96,49 @@ TEST(TimerQueueTest, TimerQueueTimerCancelled) {
   ASSERT_FALSE(expired_2);
 }
 
+// This test checks that timers scheduled and cancelled concurrently from
+// multiple threads expire exactly once, and never before their deadline.
+TEST(TimerQueueTest, TimerQueueConcurrentTimers) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumTimers = 1000;
+
+  std::atomic<int> expired{0};
+  std::atomic<int> expired_early{0};
+  std::atomic<int> expired_cancelled{0};
+
+  {
+    TimerQueue tq;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kNumThreads; ++t) {
+      threads.emplace_back([&, t]() {
+        for (int i = 0; i < kNumTimers; ++i) {
+          // Timeouts within [0ms, 300ms) cover the two lowest wheel levels.
+          // Cancelled timers get extra time to be cancelled before expiring.
+          const bool cancel = i % 2 == 0;
+          const auto timeout =
+              std::chrono::microseconds((i * 7919 + t) % 300000) +
+              (cancel ? 500ms : 0ms);
+          const auto deadline = std::chrono::system_clock::now() + timeout;
+
+          auto timer = tq.ScheduleTimer(timeout, [&, deadline, cancel]() {
+            if (std::chrono::system_clock::now() < deadline) expired_early++;
+            if (cancel) expired_cancelled++;
+            expired++;
+          });
+          if (cancel) tq.CancelTimer(timer);
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+
+    std::this_thread::sleep_for(1s);
+  }
+
+  EXPECT_EQ(expired, kNumThreads * kNumTimers / 2);
+  EXPECT_EQ(expired_early, 0);
+  EXPECT_EQ(expired_cancelled, 0);
+}
+
 }  // namespace
 }  // namespace tfrt
@@ -32,6 +32,19 @@
 namespace tfrt {
 namespace {
 
+TEST(SingleThreadeWorkQueueTest, IsSingleThreaded) {
+  std::unique_ptr<ConcurrentWorkQueue> work_queue =
+      CreateSingleThreadedWorkQueue();
+  EXPECT_EQ(work_queue->GetParallelismLevel(), 1);
+  EXPECT_TRUE(work_queue->IsSingleThreaded());
+
+  std::unique_ptr<ConcurrentWorkQueue> multi_threaded_work_queue =
+      CreateMultiThreadedWorkQueue(/*num_threads=*/1,
+                                   /*num_blocking_threads=*/1);
+  EXPECT_EQ(multi_threaded_work_queue->GetParallelismLevel(), 1);
+  EXPECT_FALSE(multi_threaded_work_queue->IsSingleThreaded());
+}
+
 TEST(SingleThreadeWorkQueueTest, AsyncValueCompletesOnAnotherThread) {
   std::unique_ptr<ConcurrentWorkQueue> work_queue =
       CreateSingleThreadedWorkQueue();
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tfrt/metrics/default_metrics_registry.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace tfrt {
+namespace metrics {
+namespace {
+
+std::string Snapshot(const DefaultMetricsRegistry& registry) {
+  std::string text;
+  llvm::raw_string_ostream os(text);
+  registry.WritePrometheusText(os);
+  return os.str();
+}
+
+TEST(DefaultMetricsRegistryTest, Counter) {
+  DefaultMetricsRegistry registry;
+  Counter* counter = registry.NewCounter("/tfrt/test/counter");
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([counter] {
+      for (int j = 0; j < 1000; ++j) counter->IncrementBy(2);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  EXPECT_EQ(Snapshot(registry),
+            "# TYPE tfrt_test_counter counter\n"
+            "tfrt_test_counter 8000\n");
+}
+
+TEST(DefaultMetricsRegistryTest, Gauges) {
+  DefaultMetricsRegistry registry;
+  registry.NewIntGauge("/tfrt/test/int")->Set(42);
+  registry.NewStringGauge("/tfrt/test/string")->Set("a\"b");
+
+  EXPECT_EQ(Snapshot(registry),
+            "# TYPE tfrt_test_int gauge\n"
+            "tfrt_test_int 42\n"
+            "# TYPE tfrt_test_string gauge\n"
+            "tfrt_test_string{value=\"a\\\"b\"} 1\n");
+}
+
+TEST(DefaultMetricsRegistryTest, Histogram) {
+  DefaultMetricsRegistry registry;
+  Histogram* histogram =
+      registry.NewHistogram("/tfrt/test/histogram", Buckets::Explicit({1, 10}));
+  for (double value : {0.5, 1.0, 5.0, 20.0, 30.0}) histogram->Record(value);
+
+  EXPECT_EQ(Snapshot(registry),
+            "# TYPE tfrt_test_histogram histogram\n"
+            "tfrt_test_histogram_bucket{le=\"1\"} 1\n"
+            "tfrt_test_histogram_bucket{le=\"10\"} 3\n"
+            "tfrt_test_histogram_bucket{le=\"+Inf\"} 5\n"
+            "tfrt_test_histogram_sum 56.5\n"
+            "tfrt_test_histogram_count 5\n");
+}
+
+TEST(DefaultMetricsRegistryTest, SameName) {
+  DefaultMetricsRegistry registry;
+  Counter* counter = registry.NewCounter("/tfrt/test/metric");
+  EXPECT_EQ(registry.NewCounter("/tfrt/test/metric"), counter);
+
+  // Metrics of another kind with the same name work, but are not exported.
+  registry.NewIntGauge("/tfrt/test/metric")->Set(1);
+  counter->IncrementBy(3);
+
+  EXPECT_EQ(Snapshot(registry),
+            "# TYPE tfrt_test_metric counter\n"
+            "tfrt_test_metric 3\n");
+}
+
+}  // namespace
+}  // namespace metrics
+}  // namespace tfrt
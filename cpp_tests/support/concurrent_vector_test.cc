@@ -16,7 +16,9 @@
 
 #include "tfrt/support/concurrent_vector.h"
 
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -101,4 +103,68 @@ TEST(ConcurrentVectorTest, TwoWritersTwoReaders) {
   reader2.join();
 }
 
+TEST(ConcurrentVectorTest, EmplaceBackN) {
+  tfrt::ConcurrentVector<int> vec(4);
+
+  ASSERT_EQ(0, vec.emplace_back(1));
+  ASSERT_EQ(1, vec.emplace_back_n(10, 2));
+  ASSERT_EQ(11, vec.emplace_back_n(0, 3));
+  ASSERT_EQ(11, vec.emplace_back(4));
+  ASSERT_EQ(12, vec.size());
+
+  EXPECT_EQ(1, vec[0]);
+  for (int i = 1; i < 11; ++i) EXPECT_EQ(2, vec[i]);
+  EXPECT_EQ(4, vec[11]);
+}
+
+TEST(ConcurrentVectorTest, ElementsAreNotMoved) {
+  tfrt::ConcurrentVector<std::unique_ptr<int>> vec(1);
+
+  vec.emplace_back(std::make_unique<int>(0));
+  int* first = vec[0].get();
+  const std::unique_ptr<int>* first_addr = &vec[0];
+
+  for (int i = 1; i < 1000; ++i) vec.emplace_back(std::make_unique<int>(i));
+
+  EXPECT_EQ(first, vec[0].get());
+  EXPECT_EQ(first_addr, &vec[0]);
+  for (int i = 0; i < 1000; ++i) EXPECT_EQ(i, *vec[i]);
+}
+
+TEST(ConcurrentVectorTest, BulkWritersAndReaders) {
+  tfrt::ConcurrentVector<int> vec(1);
+
+  constexpr int kNumWriters = 4;
+  constexpr int kNumBatches = 100;
+  constexpr int kBatchSize = 10;
+  constexpr int kCount = kNumWriters * kNumBatches * kBatchSize;
+
+  // Each writer appends batches of its own id, so every batch must be stored
+  // at consecutive indices.
+  std::vector<std::thread> writers;
+  for (int w = 0; w < kNumWriters; ++w) {
+    writers.emplace_back([&vec, w] {
+      for (int i = 0; i < kNumBatches; ++i) {
+        size_t index = vec.emplace_back_n(kBatchSize, w);
+        ASSERT_EQ(index % kBatchSize, 0);
+        for (int j = 0; j < kBatchSize; ++j) ASSERT_EQ(vec[index + j], w);
+      }
+    });
+  }
+
+  std::thread reader([&] {
+    std::vector<int> counts(kNumWriters);
+    for (int i = 0; i < kCount; ++i) {
+      while (i >= vec.size())
+        ;
+      counts[vec[i]]++;
+    }
+    for (int w = 0; w < kNumWriters; ++w)
+      EXPECT_EQ(counts[w], kNumBatches * kBatchSize);
+  });
+
+  for (auto& writer : writers) writer.join();
+  reader.join();
+}
+
 }  // namespace
@@ -14,6 +14,8 @@
 
 #include "tfrt/support/crc32c.h"
 
+#include <vector>
+
 #include "gtest/gtest.h"
 
 namespace tfrt {
@@ -47,13 +49,29 @@ TEST(Crc32cTest, AcceleratedExtend) {
   if (CanAccelerate()) {
     for (int buffer_size = 1; buffer_size <= sizeof(kTestBuffer);
          ++buffer_size) {
-      uint32_t crc1 = AcceleratedExtend(0, kTestBuffer, sizeof(kTestBuffer));
-      uint32_t crc2 = RegularExtend(0, kTestBuffer, sizeof(kTestBuffer));
+      uint32_t crc1 = AcceleratedExtend(0, kTestBuffer, buffer_size);
+      uint32_t crc2 = RegularExtend(0, kTestBuffer, buffer_size);
       EXPECT_EQ(crc1, crc2);
     }
   }
 }
 
+TEST(Crc32cTest, AcceleratedExtendLargeBuffers) {
+  if (!CanAccelerate()) return;
+  std::vector<char> buffer(3 * 8192 * 2 + 3 * 256 + 100);
+  for (size_t i = 0; i < buffer.size(); ++i) buffer[i] = i * 7 + (i >> 8);
+
+  // Cover the three stream paths at different alignments and with tails.
+  for (size_t offset : {0u, 1u, 5u}) {
+    for (size_t size : {767, 768, 3 * 256 + 9, 24575, 24576, 3 * 8192 + 800,
+                        static_cast<int>(buffer.size() - offset)}) {
+      uint32_t crc1 = AcceleratedExtend(42, buffer.data() + offset, size);
+      uint32_t crc2 = RegularExtend(42, buffer.data() + offset, size);
+      EXPECT_EQ(crc1, crc2) << "offset " << offset << ", size " << size;
+    }
+  }
+}
+
 }  // namespace
 }  // namespace crc32c
 }  // namespace tfrt
@@ -0,0 +1,131 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file tests the bulk conversions between float and fp16 or bf16.
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/support/bf16.h"
+#include "tfrt/support/fp16.h"
+
+namespace tfrt {
+namespace {
+
+// More than the SIMD width, so that vector and scalar loops both run.
+constexpr size_t kNumRepeats = 5;
+
+template <typename T>
+std::vector<uint16_t> ToBits(const std::vector<float>& values) {
+  std::vector<float> src;
+  for (size_t i = 0; i < kNumRepeats; ++i) {
+    src.insert(src.end(), values.begin(), values.end());
+  }
+  std::vector<T> dst(src.size());
+  ConvertBuffer(src.data(), dst.data(), src.size());
+  std::vector<uint16_t> bits;
+  for (const T& v : dst) bits.push_back(v.value);
+  return bits;
+}
+
+template <typename T>
+std::vector<float> FromBits(const std::vector<uint16_t>& values) {
+  std::vector<T> src;
+  for (size_t i = 0; i < kNumRepeats; ++i) {
+    for (uint16_t v : values) src.push_back(T(v));
+  }
+  std::vector<float> dst(src.size());
+  ConvertBuffer(src.data(), dst.data(), src.size());
+  return dst;
+}
+
+TEST(FloatConversionTest, FloatToFp16) {
+  const float inf = std::numeric_limits<float>::infinity();
+  std::vector<float> values = {0.0f,
+                               -0.0f,
+                               1.0f,
+                               -2.0f,
+                               65504.0f,
+                               65520.0f,
+                               inf,
+                               -inf,
+                               0x1p-24f,
+                               0x1p-26f,
+                               1.0f + 0x1p-11f,
+                               1.0f + 3 * 0x1p-11f,
+                               0x1p-14f};
+  std::vector<uint16_t> expected = {0x0000, 0x8000, 0x3c00, 0xc000, 0x7bff,
+                                    0x7c00, 0x7c00, 0xfc00, 0x0001, 0x0000,
+                                    0x3c00, 0x3c02, 0x0400};
+  auto bits = ToBits<fp16>(values);
+  for (size_t i = 0; i < bits.size(); ++i) {
+    EXPECT_EQ(bits[i], expected[i % expected.size()]) << "index " << i;
+  }
+
+  auto nan = ToBits<fp16>({std::numeric_limits<float>::quiet_NaN()});
+  for (uint16_t v : nan) {
+    EXPECT_EQ(v & 0x7c00, 0x7c00);
+    EXPECT_NE(v & 0x3ff, 0);
+  }
+}
+
+TEST(FloatConversionTest, Fp16ToFloat) {
+  std::vector<uint16_t> values = {0x0000, 0x8000, 0x3c00, 0xc000,
+                                  0x7bff, 0x7c00, 0x0001, 0x0400};
+  const float inf = std::numeric_limits<float>::infinity();
+  std::vector<float> expected = {0.0f,     -0.0f, 1.0f,     -2.0f,
+                                 65504.0f, inf,   0x1p-24f, 0x1p-14f};
+  auto floats = FromBits<fp16>(values);
+  for (size_t i = 0; i < floats.size(); ++i) {
+    EXPECT_EQ(floats[i], expected[i % expected.size()]) << "index " << i;
+  }
+  for (float f : FromBits<fp16>({0x7e00})) EXPECT_TRUE(std::isnan(f));
+}
+
+TEST(FloatConversionTest, FloatToBf16) {
+  std::vector<float> values = {0.0f,
+                               -0.0f,
+                               1.0f,
+                               -2.0f,
+                               1.0f + 0x1p-8f,
+                               1.0f + 3 * 0x1p-8f,
+                               3.0e38f,
+                               std::numeric_limits<float>::infinity()};
+  std::vector<uint16_t> expected = {0x0000, 0x8000, 0x3f80, 0xc000,
+                                    0x3f80, 0x3f82, 0x7f62, 0x7f80};
+  auto bits = ToBits<bf16>(values);
+  for (size_t i = 0; i < bits.size(); ++i) {
+    EXPECT_EQ(bits[i], expected[i % expected.size()]) << "index " << i;
+  }
+
+  auto nan = ToBits<bf16>({std::numeric_limits<float>::quiet_NaN()});
+  for (uint16_t v : nan) {
+    EXPECT_EQ(v & 0x7f80, 0x7f80);
+    EXPECT_NE(v & 0x7f, 0);
+  }
+}
+
+TEST(FloatConversionTest, Bf16ToFloat) {
+  std::vector<uint16_t> values = {0x0000, 0x8000, 0x3f80, 0xc000, 0x3f82};
+  std::vector<float> expected = {0.0f, -0.0f, 1.0f, -2.0f, 1.0f + 0x1p-6f};
+  auto floats = FromBits<bf16>(values);
+  for (size_t i = 0; i < floats.size(); ++i) {
+    EXPECT_EQ(floats[i], expected[i % expected.size()]) << "index " << i;
+  }
+}
+
+}  // namespace
+}  // namespace tfrt
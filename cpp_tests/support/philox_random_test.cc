@@ -16,6 +16,8 @@
 
 #include "tfrt/support/philox_random.h"
 
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -28,5 +30,57 @@ TEST(PhiloxRandomTest, GenerateNumber) {
   EXPECT_THAT(generator(), 3724722508);
 }
 
+TEST(PhiloxRandomTest, FillUint32) {
+  random::PhiloxRandom generator(100, 200);
+  std::vector<uint32_t> expected(103);
+  for (uint32_t& value : expected) value = generator();
+
+  random::PhiloxRandom fill_generator(100, 200);
+  std::vector<uint32_t> values(expected.size());
+  fill_generator.FillUint32(values.data(), values.size());
+  EXPECT_EQ(values, expected);
+}
+
+TEST(PhiloxRandomTest, SkipAndFill) {
+  random::PhiloxRandom generator(100, 200);
+  std::vector<uint32_t> expected(100);
+  generator.FillUint32(expected.data(), expected.size());
+
+  // Fill the two halves with separate generators.
+  std::vector<uint32_t> values(expected.size());
+  random::PhiloxRandom first(100, 200);
+  random::PhiloxRandom second = first;
+  first.FillUint32(values.data(), 48);
+  second.Skip(48 / 4);
+  second.FillUint32(values.data() + 48, values.size() - 48);
+  EXPECT_EQ(values, expected);
+}
+
+TEST(PhiloxRandomTest, FillUniform) {
+  random::PhiloxRandom generator(100, 200);
+  std::vector<float> values(1000);
+  generator.FillUniform(values.data(), values.size());
+  double sum = 0;
+  for (float value : values) {
+    EXPECT_GE(value, 0.0f);
+    EXPECT_LT(value, 1.0f);
+    sum += value;
+  }
+  EXPECT_NEAR(sum / values.size(), 0.5, 0.05);
+}
+
+TEST(PhiloxRandomTest, FillNormal) {
+  random::PhiloxRandom generator(100, 200);
+  std::vector<float> values(10001);
+  generator.FillNormal(values.data(), values.size());
+  double sum = 0, sum_squares = 0;
+  for (float value : values) {
+    sum += value;
+    sum_squares += value * value;
+  }
+  EXPECT_NEAR(sum / values.size(), 0.0, 0.05);
+  EXPECT_NEAR(sum_squares / values.size(), 1.0, 0.05);
+}
+
 }  // namespace
 }  // namespace tfrt
@@ -18,7 +18,10 @@
 
 #include "tfrt/tensor/btf.h"
 
+#include <fstream>
+
 #include "gtest/gtest.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 #include "tfrt/cpp_tests/test_util.h"
 #include "tfrt/tensor/btf_util.h"
@@ -103,6 +106,41 @@ TEST(BTFTest, BTFWriteAndRead) {
   }
 }
 
+TEST(BTFTest, BTFWriteAndReadMapped) {
+  auto context = CreateHostContext();
+  const auto a = CreateDummyTensor<int>({3, 2}, context.get());
+  const auto b = CreateDummyTensor<uint8_t>({63}, context.get());
+  const auto c = CreateDummyTensor<double>({5}, context.get());
+  std::vector<const Tensor*> tensors{&a, &b, &c};
+  llvm::SmallString<128> path;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("btf_test", "btf", path));
+  {
+    std::ofstream os(path.str().str(), std::ios_base::binary);
+    EXPECT_FALSE(WriteTensorsToBTF(&os, tensors));
+  }
+  auto file = MapBTFFile(path.str().str());
+  ASSERT_TRUE(!!file);
+  auto offsets = ReadBTFOffsets(**file).get();
+  EXPECT_EQ(offsets.size(), tensors.size());
+  for (int i = 0; i < tensors.size(); i++) {
+    const auto& expected =
+        reinterpret_cast<const DenseHostTensor&>(*tensors[i]);
+    auto out = ReadDHTFromBTF(*file, offsets[i]);
+    ASSERT_TRUE(!!out);
+    EXPECT_EQ(*out, expected);
+    // The tensor data points into the mapped file.
+    const char* begin = static_cast<const char*>((*file)->data());
+    const char* data = static_cast<const char*>(out->data());
+    EXPECT_GE(data, begin);
+    EXPECT_LE(data + out->DataSizeInBytes(), begin + (*file)->size());
+  }
+  // Truncated records are rejected.
+  auto truncated = ReadDHTFromBTF(*file, (*file)->size() - 8);
+  EXPECT_FALSE(!!truncated);
+  llvm::consumeError(truncated.takeError());
+  llvm::sys::fs::remove(path);
+}
+
 }  // namespace
 }  // namespace btf
 }  // namespace tfrt
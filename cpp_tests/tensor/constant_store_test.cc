@@ -0,0 +1,116 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit test for TFRT ConstantStore.
+
+#include "tfrt/tensor/constant_store.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tfrt/cpp_tests/test_util.h"
+#include "tfrt/tensor/dense_view.h"
+
+namespace tfrt {
+namespace {
+
+constexpr int64_t kNumElements = 4096;
+
+std::vector<float> MakeData(float start) {
+  std::vector<float> data(kNumElements);
+  for (int64_t i = 0; i < kNumElements; ++i) data[i] = start + i;
+  return data;
+}
+
+TEST(ConstantStoreTest, SharesIdenticalTensorsAcrossHostContexts) {
+  auto host_a = CreateHostContext();
+  auto host_b = CreateHostContext();
+  auto data = MakeData(1.0f);
+  auto copy = data;
+
+  auto& store = ConstantStore::Global();
+  auto a = store.GetOrCopy(
+      DenseView(DType::F32, {kNumElements}, data.data()), host_a.get());
+  auto b = store.GetOrCopy(
+      DenseView(DType::F32, {kNumElements}, copy.data()), host_b.get());
+  ASSERT_TRUE(!!a);
+  ASSERT_TRUE(!!b);
+
+  EXPECT_EQ(a->data(), b->data());
+  EXPECT_NE(a->data(), data.data());
+  EXPECT_FALSE(a->buffer()->IsExclusiveDataOwner());
+
+  // The shared buffer outlives the HostContexts.
+  host_a.reset();
+  host_b.reset();
+  EXPECT_EQ(a->data<float>()[kNumElements - 1], kNumElements);
+}
+
+TEST(ConstantStoreTest, DoesNotShareDifferentTensors) {
+  auto host = CreateHostContext();
+  auto data = MakeData(2.0f);
+  auto other = MakeData(3.0f);
+
+  auto& store = ConstantStore::Global();
+  auto a = store.GetOrCopy(DenseView(DType::F32, {kNumElements}, data.data()),
+                           host.get());
+  auto b = store.GetOrCopy(
+      DenseView(DType::F32, {kNumElements}, other.data()), host.get());
+  auto c = store.GetOrCopy(
+      DenseView(DType::F32, {2, kNumElements / 2}, data.data()), host.get());
+  ASSERT_TRUE(!!a);
+  ASSERT_TRUE(!!b);
+  ASSERT_TRUE(!!c);
+
+  EXPECT_NE(a->data(), b->data());
+  EXPECT_NE(a->data(), c->data());
+}
+
+TEST(ConstantStoreTest, CopiesSmallTensors) {
+  auto host = CreateHostContext();
+  std::vector<float> data = {1.0f, 2.0f};
+
+  auto& store = ConstantStore::Global();
+  auto a = store.GetOrCopy(DenseView(DType::F32, {2}, data.data()), host.get());
+  auto b = store.GetOrCopy(DenseView(DType::F32, {2}, data.data()), host.get());
+  ASSERT_TRUE(!!a);
+  ASSERT_TRUE(!!b);
+
+  EXPECT_NE(a->data(), b->data());
+  EXPECT_TRUE(a->buffer()->IsExclusiveDataOwner());
+}
+
+TEST(ConstantStoreTest, GetOrInsertReturnsStoredTensor) {
+  auto host = CreateHostContext();
+  auto data = MakeData(4.0f);
+  TensorMetadata metadata(DType::F32, {kNumElements});
+
+  auto& store = ConstantStore::Global();
+  auto a = store.GetOrCopy(DenseView(DType::F32, {kNumElements}, data.data()),
+                           host.get());
+  ASSERT_TRUE(!!a);
+
+  auto tensor = DenseHostTensor::CreateUninitialized(metadata, host.get());
+  ASSERT_TRUE(tensor.hasValue());
+  std::copy(data.begin(), data.end(), tensor->data<float>());
+  auto b = store.GetOrInsert(std::move(*tensor));
+
+  EXPECT_EQ(a->data(), b.data());
+}
+
+}  // namespace
+}  // namespace tfrt
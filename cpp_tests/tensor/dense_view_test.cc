@@ -0,0 +1,77 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit test for TFRT StridedDenseView.
+
+#include "tfrt/tensor/dense_view.h"
+
+#include <numeric>
+
+#include "gtest/gtest.h"
+
+namespace tfrt {
+namespace {
+
+// A 3x4 matrix holding 0, 1, ..., 11.
+class StridedDenseViewTest : public ::testing::Test {
+ protected:
+  StridedDenseViewTest() { std::iota(data_, data_ + 12, 0); }
+
+  StridedDenseView View() const {
+    return StridedDenseView(DenseView(GetDType<int32_t>(), {3, 4}, data_));
+  }
+
+  int32_t data_[12];
+};
+
+TEST_F(StridedDenseViewTest, Dense) {
+  StridedDenseView view = View();
+  EXPECT_TRUE(view.IsContiguous());
+  EXPECT_EQ(view.strides(), llvm::makeArrayRef<Index>({4, 1}));
+  EXPECT_EQ(view.ElementAt<int32_t>({2, 3}), 11);
+}
+
+TEST_F(StridedDenseViewTest, Slice) {
+  StridedDenseView slice = View().Slice({1, 1}, {2, 2});
+  EXPECT_FALSE(slice.IsContiguous());
+  EXPECT_EQ(slice.shape(), TensorShape({2, 2}));
+  EXPECT_EQ(slice.ElementAt<int32_t>({0, 0}), 5);
+  EXPECT_EQ(slice.ElementAt<int32_t>({1, 1}), 10);
+
+  // Full rows of a row-major matrix stay contiguous.
+  EXPECT_TRUE(View().Slice({1, 0}, {2, 4}).IsContiguous());
+}
+
+TEST_F(StridedDenseViewTest, Transpose) {
+  StridedDenseView transposed = View().Transpose({1, 0});
+  EXPECT_FALSE(transposed.IsContiguous());
+  EXPECT_EQ(transposed.shape(), TensorShape({4, 3}));
+  EXPECT_EQ(transposed.ElementAt<int32_t>({3, 1}), 7);
+}
+
+TEST_F(StridedDenseViewTest, BroadcastTo) {
+  StridedDenseView row = View().Slice({2, 0}, {1, 4});
+  auto broadcast = row.BroadcastTo(TensorShape({2, 3, 4}));
+  ASSERT_TRUE(broadcast.hasValue());
+  EXPECT_EQ(broadcast->strides(), llvm::makeArrayRef<Index>({0, 0, 1}));
+  EXPECT_EQ(broadcast->ElementAt<int32_t>({1, 2, 3}), 11);
+
+  EXPECT_FALSE(View().BroadcastTo(TensorShape({3, 5})).hasValue());
+  EXPECT_FALSE(View().BroadcastTo(TensorShape(ArrayRef<Index>{4})).hasValue());
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit test for PackedStringHostTensor.
+
+#include "tfrt/tensor/packed_string_host_tensor.h"
+
+#include <array>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "tfrt/cpp_tests/test_util.h"
+#include "tfrt/tensor/string_host_tensor.h"
+#include "tfrt/tensor/tensor_shape.h"
+
+namespace tfrt {
+namespace {
+
+TEST(PackedStringHostTensorTest, Create) {
+  auto host = CreateHostContext();
+  std::vector<string_view> strings = {"hello", "", "world", "!"};
+  auto tensor = PackedStringHostTensor::Create(TensorShape({2, 2}), strings,
+                                               host.get());
+  ASSERT_TRUE(tensor.hasValue());
+  EXPECT_EQ(tensor->NumElements(), 4);
+  for (size_t i = 0; i < strings.size(); ++i) {
+    EXPECT_EQ((*tensor)[i], strings[i]);
+  }
+  EXPECT_EQ(tensor->offsets().size(), 5);
+  EXPECT_EQ(tensor->offsets().back(), 11);
+  EXPECT_EQ(string_view(tensor->chars(), 11), "helloworld!");
+}
+
+TEST(PackedStringHostTensorTest, CreateEmptyStrings) {
+  auto host = CreateHostContext();
+  std::vector<string_view> strings = {"", ""};
+  auto tensor = PackedStringHostTensor::Create(
+      TensorShape(std::array<Index, 1>{2}), strings, host.get());
+  ASSERT_TRUE(tensor.hasValue());
+  EXPECT_EQ((*tensor)[0], "");
+  EXPECT_EQ((*tensor)[1], "");
+  EXPECT_FALSE(tensor->chars_buffer());
+}
+
+TEST(PackedStringHostTensorTest, CopyRefSharesBuffers) {
+  auto host = CreateHostContext();
+  std::vector<string_view> strings = {"a", "bc"};
+  auto tensor = PackedStringHostTensor::Create(
+      TensorShape(std::array<Index, 1>{2}), strings, host.get());
+  ASSERT_TRUE(tensor.hasValue());
+  auto copy = tensor->CopyRef();
+  EXPECT_EQ(copy.chars(), tensor->chars());
+  EXPECT_EQ(copy[1], "bc");
+}
+
+TEST(PackedStringHostTensorTest, CreateFromStringHostTensor) {
+  auto host = CreateHostContext();
+  auto sht = StringHostTensor::CreateUninitialized(
+      TensorShape(std::array<Index, 1>{3}), host.get());
+  ASSERT_TRUE(sht.hasValue());
+  sht->strings()[0] = "x";
+  sht->strings()[1] = "yy";
+  sht->strings()[2] = "zzz";
+  auto tensor = PackedStringHostTensor::Create(*sht, host.get());
+  ASSERT_TRUE(tensor.hasValue());
+  EXPECT_EQ(tensor->shape(), sht->shape());
+  EXPECT_EQ((*tensor)[0], "x");
+  EXPECT_EQ((*tensor)[1], "yy");
+  EXPECT_EQ((*tensor)[2], "zzz");
+}
+
+}  // namespace
+}  // namespace tfrt
@@ -95,5 +95,38 @@ TEST_F(TensorSerializeUtilsTest, SerializeDeserialzeDenseHostTensor) {
   EXPECT_EQ(expected.get(), dht_);
 }
 
+TEST_F(TensorSerializeUtilsTest, SerializeDenseHostTensorSharesData) {
+  auto serialized = SerializeDenseHostTensor(dht_, host_context_.get());
+  ASSERT_TRUE(!!serialized);
+  ASSERT_EQ(serialized->size(), 2);
+  EXPECT_EQ((*serialized)[1]->data(), dht_.data());
+  auto expected =
+      DeserializeDenseHostTensor(serialized.get(), host_context_.get());
+  ASSERT_TRUE(!!expected);
+  EXPECT_EQ(expected->data(), dht_.data());
+}
+
+TEST_F(TensorSerializeUtilsTest, DeserializeDenseHostTensorIntoAllocatedData) {
+  auto metadata = SerializeTensorMetadata(dht_.metadata());
+  auto data = AllocateDenseHostTensorData(metadata, host_context_.get());
+  ASSERT_TRUE(!!data);
+  ASSERT_EQ((*data)->size(), dht_.DataSizeInBytes());
+  // Simulates reading the data slice from the wire.
+  std::memcpy((*data)->data(), dht_.data(), dht_.DataSizeInBytes());
+  auto expected = DeserializeDenseHostTensor(metadata, data->CopyRef());
+  ASSERT_TRUE(!!expected);
+  EXPECT_EQ(*expected, dht_);
+  EXPECT_EQ(expected->data(), (*data)->data());
+}
+
+TEST_F(TensorSerializeUtilsTest, DeserializeDenseHostTensorSizeMismatch) {
+  auto metadata = SerializeTensorMetadata(dht_.metadata());
+  auto data = HostBuffer::CreateUninitialized(
+      /*size=*/4, /*alignment=*/4, host_context_.get()->allocator());
+  auto expected = DeserializeDenseHostTensor(metadata, std::move(data));
+  EXPECT_FALSE(!!expected);
+  llvm::consumeError(expected.takeError());
+}
+
 }  // namespace
 }  // namespace tfrt
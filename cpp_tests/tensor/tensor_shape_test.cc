@@ -36,5 +36,20 @@ TEST(TensorShapeTest, Strides) {
   EXPECT_EQ(strides, expected);
 }
 
+TEST(TensorShapeTest, NumElements) {
+  EXPECT_EQ(TensorShape({}).GetNumElements(), 1);
+  EXPECT_EQ(TensorShape({2, 3, 4}).GetNumElements(), 24);
+  EXPECT_EQ(TensorShape({70000, 3}).GetNumElements(), 210000);
+
+  // Dimensions that do not fit in 32 bits are stored out of line.
+  std::array<Index, 2> dims = {Index{1} << 33, 3};
+  TensorShape shape(dims);
+  EXPECT_EQ(shape.GetNumElements(), (Index{1} << 33) * 3);
+
+  TensorShape copy = shape;
+  EXPECT_EQ(copy, shape);
+  EXPECT_EQ(copy.GetNumElements(), (Index{1} << 33) * 3);
+}
+
 }  // namespace
 }  // namespace tfrt
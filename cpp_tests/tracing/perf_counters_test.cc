@@ -0,0 +1,45 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit tests for the hardware performance counters.
+
+#include "tfrt/tracing/perf_counters.h"
+
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "llvm/Support/Error.h"
+
+namespace tfrt {
+namespace tracing {
+namespace {
+
+TEST(PerfCountersTest, CountsIncrease) {
+  auto counters = PerfCounters::Create();
+  if (!counters) {
+    GTEST_SKIP() << llvm::toString(counters.takeError());
+  }
+
+  PerfCounterValues begin = (*counters)->Read();
+  volatile uint64_t sum = 0;
+  for (int i = 0; i < 1000000; ++i) sum += i;
+  PerfCounterValues delta = (*counters)->Read() - begin;
+
+  EXPECT_GT(delta.cycles, 0u);
+  EXPECT_GT(delta.instructions, 1000000u);
+}
+
+}  // namespace
+}  // namespace tracing
+}  // namespace tfrt
@@ -0,0 +1,83 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unit tests for the ring buffer tracing sink.
+
+#include "tfrt/tracing/ring_buffer_tracing_sink.h"
+
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/tracing/tracing.h"
+
+namespace tfrt {
+namespace tracing {
+namespace {
+
+#define TFRT_SKIP_IF(cond) \
+  if (cond) GTEST_SKIP() << #cond;
+
+// Returns the number of events with `name` and phase `ph` in the snapshot.
+int CountEvents(llvm::StringRef name, llvm::StringRef ph) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  WriteRingBufferTracingSnapshot(os);
+
+  llvm::Expected<llvm::json::Value> trace = llvm::json::parse(os.str());
+  EXPECT_TRUE(static_cast<bool>(trace));
+  if (!trace) return -1;
+  int count = 0;
+  for (const llvm::json::Value& event :
+       *trace->getAsObject()->getArray("traceEvents")) {
+    const llvm::json::Object* object = event.getAsObject();
+    if (object->getString("name") == name && object->getString("ph") == ph)
+      ++count;
+  }
+  return count;
+}
+
+TEST(RingBufferTracingSinkTest, Snapshot) {
+  TFRT_SKIP_IF(internal::kMaxTracingLevel < TracingLevel::Default);
+
+  TracingRequester requester;
+  {
+    TFRT_TRACE_SCOPE(Default, "scope \"quoted\"");
+    TFRT_TRACE_EVENT(Default, "event");
+  }
+  EXPECT_EQ(CountEvents("scope \"quoted\"", "X"), 1);
+  EXPECT_EQ(CountEvents("event", "i"), 1);
+
+  // Taking a snapshot doesn't stop tracing.
+  TFRT_TRACE_EVENT(Default, "event");
+  EXPECT_EQ(CountEvents("event", "i"), 2);
+}
+
+TEST(RingBufferTracingSinkTest, BoundedPerThread) {
+  TFRT_SKIP_IF(internal::kMaxTracingLevel < TracingLevel::Default);
+
+  TracingRequester requester;
+  std::thread thread([] {
+    for (size_t i = 0; i < kRingBufferEventsPerThread + 10; ++i)
+      TFRT_TRACE_EVENT(Default, "wrapped");
+  });
+  thread.join();
+  EXPECT_EQ(CountEvents("wrapped", "i"), int{kRingBufferEventsPerThread});
+}
+
+}  // namespace
+}  // namespace tracing
+}  // namespace tfrt
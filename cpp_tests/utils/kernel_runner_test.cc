@@ -110,5 +110,34 @@ TEST(KernelRunnerTest, BefInterpreterTest) {
   EXPECT_EQ(kernel_runner.RunAndGetResult<int>(), 4);
 }
 
+TEST(KernelRunnerTest, Benchmark) {
+  KernelRunner runner("tfrt_test.async_add.i32");
+  runner.SetArgs(1, 2);
+  KernelBenchmarkStats stats = runner.Benchmark(/*num_results=*/1,
+                                                /*num_runs=*/20);
+
+  EXPECT_EQ(stats.num_runs, 20);
+  EXPECT_LE(stats.min_ns, stats.median_ns);
+  EXPECT_LE(stats.median_ns, stats.p90_ns);
+  EXPECT_LE(stats.p90_ns, stats.max_ns);
+  EXPECT_GE(stats.allocations_per_run, 0);
+  EXPECT_EQ(runner.GetResultAt<int>(0), 3);
+}
+
+TEST(KernelRunnerTest, BenchmarkSyncKernel) {
+  auto host_ctx = CreateHostContext();
+  host_ctx->GetMutableRegistry()->AddSyncKernel("kernel_runner_test.sum",
+                                                TFRT_SYNC_KERNEL(sum));
+  KernelRunner runner("kernel_runner_test.sum", host_ctx.get());
+  runner.SetArgs(1, 2).AddAttribute(1);
+  KernelBenchmarkStats stats = runner.Benchmark(/*num_results=*/1,
+                                                /*num_runs=*/20);
+
+  EXPECT_EQ(stats.num_runs, 20);
+  // Allocations are only counted with the default HostContext.
+  EXPECT_EQ(stats.allocations_per_run, -1);
+  EXPECT_EQ(runner.GetResultAt<int>(0), 4);
+}
+
 }  // namespace
 }  // namespace tfrt
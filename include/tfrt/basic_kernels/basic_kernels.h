@@ -32,6 +32,7 @@ void RegisterFloatKernels(KernelRegistry* registry);
 void RegisterControlFlowKernels(KernelRegistry* registry);
 void RegisterParallelKernels(KernelRegistry* registry);
 void RegisterDeviceKernels(KernelRegistry* registry);
+void RegisterChannelKernels(KernelRegistry* registry);
 
 }  // namespace tfrt
 
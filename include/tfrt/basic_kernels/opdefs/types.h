@@ -48,6 +48,12 @@ class DeviceType
   using Base::Base;
 };
 
+class ChannelType
+    : public mlir::Type::TypeBase<ChannelType, mlir::Type, mlir::TypeStorage> {
+ public:
+  using Base::Base;
+};
+
 }  // namespace compiler
 }  // namespace tfrt
 
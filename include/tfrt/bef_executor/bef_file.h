@@ -32,6 +32,9 @@ class SmallVectorImpl;
 }  // namespace llvm
 
 namespace tfrt {
+namespace io {
+class ReadOnlyMemoryRegion;
+}  // namespace io
 
 struct DecodedDiagnostic;
 class Function;
@@ -52,14 +55,40 @@ class BEFFile : public ReferenceCounted<BEFFile> {
   // pointer to our initialized object on success.  On failure, an error
   // message is emitted to the error_handler and nullptr is returned.
   //
-  // TODO: This should (optionally) manage ownership of the underlying data
-  // passed in, taking a closure to run when the lifetime of the BEFFile is
-  // done.
+  // The caller must keep `file` alive for the lifetime of the BEFFile.
   static RCReference<BEFFile> Open(ArrayRef<uint8_t> file,
                                    const KernelRegistry& registry,
                                    ErrorHandler error_handler,
                                    HostAllocator* host_allocator);
 
+  // Same as above, but the BEFFile takes ownership of `file_region`, e.g. a
+  // file mapped by io::FileSystem::NewReadOnlyMemoryRegion(), and releases it
+  // when the BEFFile is destroyed.
+  //
+  // Opening only resolves the kernels, types and function index. Function
+  // bodies, attributes and locations are decoded in place on first use, so
+  // pages of a memory-mapped file that are never used are never read, and the
+  // pages that are read can be shared between processes.
+  static RCReference<BEFFile> Open(
+      std::unique_ptr<io::ReadOnlyMemoryRegion> file_region,
+      const KernelRegistry& registry, ErrorHandler error_handler,
+      HostAllocator* host_allocator);
+
+  // Same as above, but returns the live BEFFile opened by OpenShared() from a
+  // file with the same content and `registry` if there is one, and releases
+  // `file_region`. This is meant for loading a new version of a model while
+  // the old version still runs: if the BEF file did not change, the new
+  // version shares the resolved kernels, the decoded functions and the pages
+  // of the old one. Constants and JitRt executables of changed BEF files are
+  // shared by content separately.
+  //
+  // A shared BEFFile reports errors to the `error_handler` of its first
+  // opener. The whole file is read to compute its fingerprint.
+  static RCReference<BEFFile> OpenShared(
+      std::unique_ptr<io::ReadOnlyMemoryRegion> file_region,
+      const KernelRegistry& registry, ErrorHandler error_handler,
+      HostAllocator* host_allocator);
+
   // Get a list of functions out of the BEF file.
   void GetFunctionList(llvm::SmallVectorImpl<const Function*>* result) const;
 
@@ -0,0 +1,130 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Kernel profiler
+//
+// This file declares the kernel profiler, which aggregates the calls of the
+// kernels run by the BEFExecutor into per-kernel profiles.
+
+#ifndef TFRT_BEF_EXECUTOR_KERNEL_PROFILER_H_
+#define TFRT_BEF_EXECUTOR_KERNEL_PROFILER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tfrt/support/forward_decls.h"
+
+namespace tfrt {
+
+struct KernelProfilerOptions {
+  // Names of the functions whose executions are profiled. If empty, the
+  // executions of all functions are profiled.
+  std::vector<std::string> functions;
+  // Profile one out of every `sampling_period` executions of the selected
+  // functions on each thread.
+  int sampling_period = 1;
+};
+
+// Starts profiling the kernels of the selected executions. Functions called
+// synchronously by a profiled kernel are profiled too, so that the self time
+// of a kernel can exclude them.
+//
+// Calls are recorded into per-thread counters without locks. Executions which
+// are not profiled only check an atomic flag.
+void EnableKernelProfiler(const KernelProfilerOptions& options);
+
+// Stops profiling. Executions which started profiling keep profiling their
+// kernels until they complete. Profiles are kept.
+void DisableKernelProfiler();
+
+// The aggregated calls of one kernel at one location.
+struct KernelProfile {
+  std::string name;
+  std::string location;
+
+  int64_t calls = 0;
+  // Calls which were launched to another thread. The other calls ran inline
+  // in the thread which made the kernel ready.
+  int64_t outline_calls = 0;
+
+  // Time spent in the kernel implementation, including (total) or excluding
+  // (self) the profiled kernels it called synchronously. Asynchronous kernels
+  // only account for the time until they return.
+  std::chrono::nanoseconds total_time{0};
+  std::chrono::nanoseconds self_time{0};
+
+  // Percentiles of the total time of one call, with a resolution of 25%.
+  std::chrono::nanoseconds p50_time{0};
+  std::chrono::nanoseconds p99_time{0};
+};
+
+// Returns the profiles of all profiled kernels, by decreasing self time.
+std::vector<KernelProfile> GetKernelProfiles();
+
+// Prints the profiles returned by GetKernelProfiles() as a table.
+void PrintKernelProfiles(raw_ostream& os);
+
+// Writes the mean total time of one call of the profiled kernels by location,
+// as one "<mean ns>\t<location>" line per location. This is the cost profile
+// format read by compiler::CostProfile, which lets stream analysis use the
+// measured kernel costs. Kernels without location are skipped.
+void WriteKernelCostProfile(raw_ostream& os);
+
+// Exports the kernel profiles to the metrics registry, as counters and gauges
+// under /tfrt/bef_executor/kernel_profile/<kernel>@<location>/. Counters are
+// incremented by the calls recorded since the previous export.
+void ExportKernelProfileMetrics();
+
+namespace kernel_profiler {
+// The interface used by the BEFExecutor.
+
+extern std::atomic<bool> kEnabled;
+
+bool ShouldProfileExecutionSlow(string_view function_name);
+
+// Returns true if the execution of `function_name` should be profiled.
+inline bool ShouldProfileExecution(string_view function_name) {
+  if (!kEnabled.load(std::memory_order_relaxed)) return false;
+  return ShouldProfileExecutionSlow(function_name);
+}
+
+// Returns the id of the kernel `name` at `location`, or 0 if too many kernels
+// have been profiled.
+uint32_t GetKernelId(string_view name, string_view location);
+
+// Records that a call of the kernel `id` is launched to another thread.
+void RecordOutlineCall(uint32_t id);
+
+// Records a call of the kernel `id` for the lifetime of the instance.
+class ProfiledKernelCall {
+ public:
+  explicit ProfiledKernelCall(uint32_t id);
+  ~ProfiledKernelCall();
+
+  ProfiledKernelCall(const ProfiledKernelCall&) = delete;
+  ProfiledKernelCall& operator=(const ProfiledKernelCall&) = delete;
+
+ private:
+  const uint32_t id_;
+  int64_t start_ns_;
+  int64_t outer_nested_ns_;
+};
+
+}  // namespace kernel_profiler
+}  // namespace tfrt
+
+#endif  // TFRT_BEF_EXECUTOR_KERNEL_PROFILER_H_
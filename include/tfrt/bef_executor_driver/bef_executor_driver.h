@@ -45,6 +45,19 @@ enum class HostAllocatorType {
   // Allocator wrapped around profiled malloc and exit(1) on detecting memory
   // leak.
   kLeakCheckMalloc,
+
+  // Thread-caching slab allocator for small allocations on top of malloc.
+  kSlab,
+
+  // Allocator that places large allocations on the NUMA node of the calling
+  // worker thread. Use with the "numa" work queue.
+  kNuma,
+
+  // Size-bucketed pool for tensor buffers on top of malloc.
+  kBufferPool,
+
+  // Allocator that backs large allocations with huge pages on top of malloc.
+  kHugePage,
 };
 
 struct RunBefConfig {
@@ -57,6 +70,13 @@ struct RunBefConfig {
   std::string work_queue_type;
   tfrt::HostAllocatorType host_allocator_type;
   bool print_error_code = false;
+  // Schedule outline kernels in BEFExecutor with work stealing.
+  bool work_stealing = false;
+  // Number of timed runs of each function after the first run, which prints
+  // the results. If positive, a latency summary of the timed runs is printed.
+  int num_benchmark_runs = 0;
+  // Maximum number of timed runs of a function in flight at the same time.
+  int max_in_flight = 1;
 };
 
 // Run the BEF program with default execution context.
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// CostProfile: the kernel costs measured by the kernel profiler of the BEF
+// executor (see WriteKernelCostProfile() and the --kernel_cost_profile flag of
+// bef_executor). StreamAnalysis uses them instead of the static op costs,
+// which can mispredict the execution time of ops by orders of magnitude.
+
+#ifndef TFRT_COMPILER_COST_PROFILE_H_
+#define TFRT_COMPILER_COST_PROFILE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include "mlir/IR/Location.h"
+#include "tfrt/support/forward_decls.h"
+
+namespace tfrt {
+namespace compiler {
+
+class CostProfile {
+ public:
+  // Parses a profile with one "<mean ns>\t<location>" line per kernel
+  // location. Empty lines are ignored.
+  static Expected<CostProfile> Parse(string_view text);
+
+  // Reads and parses the profile in the file `path`.
+  static Expected<CostProfile> Read(string_view path);
+
+  // Returns the mean execution time in nanoseconds of the kernel at `loc`, or
+  // None if it has not been profiled.
+  llvm::Optional<int64_t> GetMeanTime(mlir::Location loc) const;
+
+  size_t size() const { return mean_times_.size(); }
+
+ private:
+  llvm::StringMap<int64_t> mean_times_;
+};
+
+// Returns `loc` formatted the way the BEF executor decodes kernel locations,
+// which is how the kernel profiler identifies kernels. Returns an empty string
+// if `loc` is not encoded in BEF.
+std::string FormatKernelLocation(mlir::Location loc);
+
+}  // namespace compiler
+}  // namespace tfrt
+
+#endif  // TFRT_COMPILER_COST_PROFILE_H_
@@ -26,6 +26,13 @@
 // worth doing so. Note that dependent streams can still be merged regardless of
 // the cost. It is set through the module attribute `tfrt.cost_threshold`.
 //
+// Cost Profile: Static op costs can mispredict the execution time of ops by
+// orders of magnitude. If the module attribute `tfrt.cost_profile` names a file
+// with kernel costs measured by the BEF executor (see cost_profile.h), the
+// measured mean time of the ops found in the profile is used as their cost
+// instead, in units of `tfrt.cost_profile_unit_ns` nanoseconds (default 1000).
+// The cost threshold is in the same units.
+//
 // The algorithm can be summarized as follows:
 //
 // 1. Build a naive stream tree where each stream contains only one operation:
@@ -53,6 +60,7 @@
 #include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Operation.h"
+#include "tfrt/compiler/cost_profile.h"
 
 namespace tfrt {
 namespace compiler {
@@ -187,6 +195,11 @@ class StreamAnalysis {
     // If `merge_inter_dependent_streams` is true, when merging independent
     // streams, it will try to merge those with inter data dependencies first.
     bool merge_inter_dependent_streams = false;
+    // If `cost_profile` is not null, the measured costs of the ops it contains
+    // are used instead of their static costs.
+    const CostProfile* cost_profile = nullptr;
+    // `cost_profile_unit_ns` is the measured time of one unit of cost.
+    int64_t cost_profile_unit_ns = 1000;
   };
 
   BuildInfo build_info_;
@@ -0,0 +1,164 @@
+/* Copyright 2022 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TSL_CONCURRENCY_ASYNC_CHANNEL_H_
+#define TSL_CONCURRENCY_ASYNC_CHANNEL_H_
+
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "tfrt/concurrency/async_value_ref.h"
+#include "tfrt/concurrency/chain.h"
+#include "absl/base/thread_annotations.h"  // from @com_google_absl
+#include "absl/status/status.h"            // from @com_google_absl
+#include "absl/synchronization/mutex.h"    // from @com_google_absl
+
+namespace tsl {
+
+// A bounded multi-producer multi-consumer channel of values of type T, for
+// streaming values between concurrently running functions. Neither end ever
+// blocks a thread: Send() and Receive() return AsyncValueRefs which become
+// available when the operation completes.
+//
+// The channel buffers up to `capacity` values. A Send() to a full channel is
+// only accepted once a receiver makes room, which gives producers
+// backpressure: a producer which waits for the chain returned by Send() before
+// sending the next value never runs more than `capacity` values ahead.
+// Values are received in the order their sends were accepted.
+//
+// Close() ends the stream. Values which were accepted before can still be
+// received, afterwards Receive() returns an OutOfRange error. Sends which are
+// not accepted yet, and all later sends, fail with a FailedPrecondition error.
+//
+// Sample usage:
+//
+//   AsyncChannel<int> channel(/*capacity=*/2);
+//   channel.Send(1).AndThen([&] { channel.Send(2); });
+//   channel.Receive().AndThen([](absl::StatusOr<int*> value) { ... });
+template <typename T>
+class AsyncChannel {
+ public:
+  explicit AsyncChannel(size_t capacity) : capacity_(capacity) {
+    assert(capacity > 0 && "channel capacity must be positive");
+  }
+
+  AsyncChannel(const AsyncChannel&) = delete;
+  AsyncChannel& operator=(const AsyncChannel&) = delete;
+
+  ~AsyncChannel() { Close(); }
+
+  // Sends `value`. The returned chain becomes available when the channel
+  // accepts the value, or is an error if the channel is closed first.
+  AsyncValueRef<Chain> Send(T value) {
+    AsyncValueRef<T> receiver;
+    {
+      absl::MutexLock lock(&mu_);
+      if (closed_) return MakeErrorAsyncValueRef(ClosedSendError());
+      if (!receivers_.empty()) {
+        // The buffer is empty, hand the value to the oldest receiver.
+        receiver = std::move(receivers_.front());
+        receivers_.pop_front();
+      } else if (buffer_.size() < capacity_) {
+        buffer_.push_back(std::move(value));
+        return MakeAvailableAsyncValueRef<Chain>();
+      } else {
+        auto accepted = MakeUnconstructedAsyncValueRef<Chain>();
+        senders_.push_back({std::move(value), accepted.CopyRef()});
+        return accepted;
+      }
+    }
+    receiver.emplace(std::move(value));
+    return MakeAvailableAsyncValueRef<Chain>();
+  }
+
+  // Receives the next value. The returned value becomes available when a value
+  // is sent, or is an error if the channel is closed and drained first.
+  AsyncValueRef<T> Receive() {
+    AsyncValueRef<Chain> accepted;
+    AsyncValueRef<T> result;
+    {
+      absl::MutexLock lock(&mu_);
+      if (buffer_.empty()) {
+        if (closed_) return MakeErrorAsyncValueRef(ClosedReceiveError());
+        receivers_.push_back(MakeUnconstructedAsyncValueRef<T>());
+        return receivers_.back().CopyRef();
+      }
+      result = MakeAvailableAsyncValueRef<T>(std::move(buffer_.front()));
+      buffer_.pop_front();
+      // Accept the oldest waiting send into the free slot.
+      if (!senders_.empty()) {
+        buffer_.push_back(std::move(senders_.front().value));
+        accepted = std::move(senders_.front().accepted);
+        senders_.pop_front();
+      }
+    }
+    if (accepted) accepted.SetStateConcrete();
+    return result;
+  }
+
+  // Closes the channel. Closing a closed channel has no effect.
+  void Close() {
+    std::deque<AsyncValueRef<T>> receivers;
+    std::deque<Sender> senders;
+    {
+      absl::MutexLock lock(&mu_);
+      if (closed_) return;
+      closed_ = true;
+      receivers.swap(receivers_);
+      senders.swap(senders_);
+    }
+    for (auto& receiver : receivers) receiver.SetError(ClosedReceiveError());
+    for (auto& sender : senders) sender.accepted.SetError(ClosedSendError());
+  }
+
+  // Returns the number of buffered values.
+  size_t size() const {
+    absl::MutexLock lock(&mu_);
+    return buffer_.size();
+  }
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  // A send waiting for room in the buffer.
+  struct Sender {
+    T value;
+    AsyncValueRef<Chain> accepted;
+  };
+
+  static absl::Status ClosedSendError() {
+    return absl::FailedPreconditionError("Send on closed channel");
+  }
+  static absl::Status ClosedReceiveError() {
+    return absl::OutOfRangeError("Receive on closed channel");
+  }
+
+  const size_t capacity_;
+
+  mutable absl::Mutex mu_;
+  bool closed_ ABSL_GUARDED_BY(mu_) = false;
+  // Accepted values. If there are waiting senders, the buffer is full. If
+  // there are waiting receivers, the buffer is empty.
+  std::deque<T> buffer_ ABSL_GUARDED_BY(mu_);
+  std::deque<Sender> senders_ ABSL_GUARDED_BY(mu_);
+  std::deque<AsyncValueRef<T>> receivers_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace tsl
+
+#endif  // TSL_CONCURRENCY_ASYNC_CHANNEL_H_
@@ -48,6 +48,25 @@ class ConcreteAsyncValue;
 template <typename T>
 constexpr bool kMaybeBase = std::is_class<T>::value && !std::is_final<T>::value;
 
+template <typename T, typename... Args>
+T* AllocateAndConstruct(Args&&... args);
+
+// Small async values (e.g. ConcreteAsyncValue<T> with a payload of up to 16
+// bytes, like int32_t, bool or Chain) are allocated from a pool of fixed size
+// blocks with a per-thread free list, instead of the heap. Control flow heavy
+// programs allocate and release a lot of such values.
+constexpr size_t kPooledAsyncValueSize = 32;
+constexpr size_t kPooledAsyncValueAlignment = 16;
+
+template <typename T>
+constexpr bool kIsPooledAsyncValue = sizeof(T) <= kPooledAsyncValueSize &&
+                                     alignof(T) <= kPooledAsyncValueAlignment;
+
+// Allocates a block of kPooledAsyncValueSize bytes from the pool.
+void* AllocatePooledAsyncValue();
+// Returns the block allocated by AllocatePooledAsyncValue() to the pool.
+void FreePooledAsyncValue(void* ptr);
+
 }  // namespace internal
 
 // This is a future of the specified value type. Arbitrary C++ types may be used
@@ -160,6 +179,19 @@ class AsyncValue {
   template <typename WaiterT>
   void AndThen(WaiterT waiter);
 
+  // Hooks that are called on the notifying thread right before and right after
+  // an AsyncValue runs its waiters, if it has more than one waiter. A task
+  // submission layer can use them to batch the work enqueued by the waiters.
+  // Calls may nest, and `end` is called once for every `begin`.
+  struct WaiterBatchHooks {
+    void (*begin)() = nullptr;
+    void (*end)() = nullptr;
+  };
+
+  // Installs hooks for all AsyncValues. Must be called before any AsyncValue
+  // runs waiters concurrently, e.g. from a static initializer.
+  static void SetWaiterBatchHooks(WaiterBatchHooks hooks);
+
   // Return the total number of async values that are currently live in the
   // process. This is intended for debugging/assertions only, and shouldn't be
   // used for mainline logic in the runtime.
@@ -264,12 +296,16 @@ class AsyncValue {
   struct TypeTag {};
 
   friend class IndirectAsyncValue;
+  template <typename T, typename... Args>
+  friend T* internal::AllocateAndConstruct(Args&&... args);
+
   template <typename T>
   AsyncValue(Kind kind, State state, bool is_refcounted, TypeTag<T>)
       : refcount_(1),
         kind_(kind),
         has_vtable_(std::is_polymorphic<T>()),
         is_refcounted_(is_refcounted),
+        is_pooled_(false),
         type_id_(GetTypeId<T>()),
         waiters_and_state_(WaitersAndState(nullptr, state)) {
     if (AsyncValueAllocationTrackingEnabled() && is_refcounted)
@@ -281,6 +317,7 @@ class AsyncValue {
         kind_(kind),
         has_vtable_(false),
         is_refcounted_(is_refcounted),
+        is_pooled_(false),
         type_id_(0),
         waiters_and_state_(WaitersAndState(nullptr, state)) {
     if (AsyncValueAllocationTrackingEnabled() && is_refcounted)
@@ -347,6 +384,10 @@ class AsyncValue {
   // references.
   const bool is_refcounted_ : 1;
 
+  // When is_pooled_ is true, the async value was allocated from the small
+  // async values pool, and is returned to the pool when destroyed.
+  bool is_pooled_ : 1;
+
   // This is a 16-bit value that identifies the type.
   uint16_t type_id_ = 0;
 
@@ -832,7 +873,16 @@ inline AsyncValue* AsyncValue::AddRef(uint32_t count) {
     // memory_order_relaxed: New references to an object can only be formed from
     // an existing reference, and passing an existing reference from one thread
     // to another must already provide any required synchronization.
-    refcount_.fetch_add(count, std::memory_order_relaxed);
+    //
+    // If the caller holds the only reference, no other thread can concurrently
+    // change the reference counter, and we can avoid the read-modify-write
+    // operation. This is common for freshly created values that are shared by
+    // multiple users (e.g. kernel results stored in the BEF registers).
+    if (refcount_.load(std::memory_order_relaxed) == 1) {
+      refcount_.store(count + 1, std::memory_order_relaxed);
+    } else {
+      refcount_.fetch_add(count, std::memory_order_relaxed);
+    }
   }
   return this;
 }
@@ -877,21 +927,22 @@ const T& AsyncValue::GetConcreteValue() const {
 
 template <typename T>
 const T& AsyncValue::get() const {
-  auto s = state();
-  (void)s;
-
+  // The state is only loaded by the debug checks: get() is on the hot path of
+  // every kernel argument, and callers already know that the value is
+  // available, so optimized builds only branch on the kind and read the
+  // payload at its fixed offset.
   switch (kind()) {
     case Kind::kConcrete:
       TFRT_DLOG_IF(FATAL, !GetTypeInfo().has_data(this))
           << "Cannot call get() when ConcreteAsyncValue isn't "
              "constructed; state: "
-          << s.DebugString()
+          << state().DebugString()
           << ", error message: " << (IsError() ? GetError().message() : "None");
       return GetConcreteValue<T>();
     case Kind::kIndirect:
-      TFRT_DLOG_IF(FATAL, s != State::kConcrete)
+      TFRT_DLOG_IF(FATAL, state() != State::kConcrete)
           << "Cannot call get() when IndirectAsyncValue isn't concrete; state: "
-          << s.DebugString()
+          << state().DebugString()
           << ", error message: " << (IsError() ? GetError().message() : "None");
       auto* iv_value = static_cast<const IndirectAsyncValue*>(this)->value_;
       assert(iv_value && "Indirect value not resolved");
@@ -959,20 +1010,30 @@ void AsyncValue::AndThen(WaiterT waiter) {
 }
 
 inline void AsyncValue::Destroy() {
-  // Copy `is_refcounted` flag before destroying the async value object.
+  // Copy `is_refcounted` and `is_pooled` flags before destroying the async
+  // value object.
   bool was_ref_counted = is_refcounted_;
+  bool was_pooled = is_pooled_;
+
+  auto deallocate = [](AsyncValue* value, bool pooled) {
+    if (pooled) {
+      internal::FreePooledAsyncValue(value);
+    } else {
+      tfrt::AlignedFree(value);
+    }
+  };
 
   if (kind() == Kind::kIndirect) {
     // Depending on what the benchmarks say, it might make sense to remove this
     // explicit check and instead make ~IndirectAsyncValue go through the
     // GetTypeInfo().destructor case below.
     static_cast<IndirectAsyncValue*>(this)->~IndirectAsyncValue();
-    if (was_ref_counted) tfrt::AlignedFree(this);
+    if (was_ref_counted) deallocate(this, was_pooled);
     return;
   }
 
   GetTypeInfo().destructor(this);
-  if (was_ref_counted) tfrt::AlignedFree(this);
+  if (was_ref_counted) deallocate(this, was_pooled);
 }
 
 }  // namespace tsl
@@ -320,8 +320,17 @@ T* PlacementConstruct(void* buf, Args&&... args) {
 
 template <typename T, typename... Args>
 T* AllocateAndConstruct(Args&&... args) {
-  void* buf = tfrt::AlignedAlloc(alignof(T), sizeof(T));
-  return PlacementConstruct<T, Args...>(buf, std::forward<Args>(args)...);
+  // Small async values are allocated from the pool, and are returned to it by
+  // AsyncValue::Destroy().
+  if constexpr (std::is_base_of_v<AsyncValue, T> && kIsPooledAsyncValue<T>) {
+    void* buf = AllocatePooledAsyncValue();
+    T* value = PlacementConstruct<T, Args...>(buf, std::forward<Args>(args)...);
+    static_cast<AsyncValue*>(value)->is_pooled_ = true;
+    return value;
+  } else {
+    void* buf = tfrt::AlignedAlloc(alignof(T), sizeof(T));
+    return PlacementConstruct<T, Args...>(buf, std::forward<Args>(args)...);
+  }
 }
 
 }  // namespace internal
@@ -17,15 +17,16 @@ limitations under the License.
 #define TSL_CONCURRENCY_CONCURRENT_VECTOR_H_
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <vector>
+#include <new>
+#include <thread>
 
-// TODO(b/254083070): migrate to TSL mutex once moved to TSL.
-#include "absl/base/thread_annotations.h"  // from @com_google_absl
-#include "absl/synchronization/mutex.h"    // from @com_google_absl
-#include "absl/types/span.h"               // from @com_google_absl
+#include "absl/numeric/bits.h"  // from @com_google_absl
 
 namespace tsl {
 namespace internal {
@@ -33,9 +34,18 @@ namespace internal {
 // A simple concurrent sequential container that allows concurrent reads and
 // writes and is optimized for read access. It is designed for the usage pattern
 // where objects are inserted once but are read many times. The key difference
-// between this data structure and std::vector is that when we re-allocate the
-// underlying buffer, we do not free the previous buffer. This allows us to
-// implement read access with a single atomic load.
+// between this data structure and std::vector is that elements are stored in
+// a table of separately allocated chunks (segments), and are never moved or
+// copied when the vector grows. This allows us to implement read access with
+// a single atomic load of the segment pointer, and appends without a lock.
+//
+// The first segment has `initial_capacity` elements (rounded up to a power of
+// two), and each next segment doubles the capacity of the vector. Writers
+// reserve indices with an atomic increment, publish newly allocated segments
+// in the segments table with a compare-and-swap, and construct elements in
+// place. The size of the vector is published in the order of reserved indices,
+// so a writer only waits for the concurrent writers that reserved earlier
+// indices to finish constructing their elements.
 //
 // Sample usage:
 //
@@ -45,6 +55,7 @@ namespace internal {
 //
 // size_t index1 = vec.emplace_back(args);
 // size_t index2 = vec.emplace_back(args);
+// size_t index3 = vec.emplace_back_n(count, args);
 //
 // On the reader side, concurrent readers are allowed.
 //
@@ -53,119 +64,148 @@ namespace internal {
 //
 // Requirements:
 //
-// Type T needs to be copyable.
-
+// Type T needs to be constructible from the arguments of emplace_back.
 template <typename T>
 class ConcurrentVector {
  public:
   // Initialize the vector with the given initial_capapcity
-  explicit ConcurrentVector(size_t initial_capacity) : state_(0ull) {
-    // ConcurrentVector does not support inserting more than 2^64 elements,
-    // which should be more than enough for any reasonable use case.
-    all_allocated_elements_.reserve(65);
-    all_allocated_elements_.emplace_back();
-    auto& v = all_allocated_elements_.back();
-    v.reserve(std::max(static_cast<size_t>(1), initial_capacity));
+  explicit ConcurrentVector(size_t initial_capacity)
+      : first_segment_log2_(absl::bit_width(
+            std::max(static_cast<size_t>(1), initial_capacity) - 1)) {}
+
+  ~ConcurrentVector() {
+    const size_t size = size_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < size; ++i) Slot(i)->~T();
+
+    std::allocator<T> allocator;
+    for (int segment = 0; segment < kMaxSegments; ++segment) {
+      T* data = segments_[segment].load(std::memory_order_relaxed);
+      if (data) allocator.deallocate(data, SegmentSize(segment));
+    }
   }
 
+  ConcurrentVector(const ConcurrentVector&) = delete;
+  ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
   T& operator[](size_t index) {
-    auto state = State::Decode(state_.load(std::memory_order_acquire));
-    assert(index < state.size);
-    return all_allocated_elements_[state.last_allocated][index];
+    // Acquire load of the size synchronizes with the writer that published the
+    // element, even if the index was obtained from a relaxed size() call.
+    [[maybe_unused]] size_t size = size_.load(std::memory_order_acquire);
+    assert(index < size);
+    return *Slot(index);
   }
 
   const T& operator[](size_t index) const {
-    auto state = State::Decode(state_.load(std::memory_order_acquire));
-    assert(index < state.size);
-    return all_allocated_elements_[state.last_allocated][index];
-  }
-
-  absl::Span<const T> ToConstSpan() const {
-    auto state = State::Decode(state_.load(std::memory_order_acquire));
-    auto& storage = all_allocated_elements_[state.last_allocated];
-    return absl::MakeConstSpan(&storage[0], &storage[state.size]);
+    [[maybe_unused]] size_t size = size_.load(std::memory_order_acquire);
+    assert(index < size);
+    return *Slot(index);
   }
 
   // Return the number of elements currently valid in this vector.  The vector
   // only grows, so this is conservative w.r.t. the execution of the current
   // thread.
-  size_t size() const {
-    return State::Decode(state_.load(std::memory_order_relaxed)).size;
-  }
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
 
-  // Insert a new element at the end. If the current buffer is full, we allocate
-  // a new buffer with twice as much capacity and copy the items in the
-  // previous buffer over.
+  // Insert a new element at the end. If the last segment is full, we allocate
+  // a new segment with as much capacity as all the previous segments, and
+  // construct the element in it. Existing elements are not moved.
   //
   // Returns the index of the newly inserted item.
   template <typename... Args>
   size_t emplace_back(Args&&... args) {
-    absl::MutexLock lock(&mutex_);
+    const size_t index = Reserve(1);
+    new (Slot(index)) T(std::forward<Args>(args)...);
+    Publish(index, 1);
+    return index;  // return insertion index
+  }
 
-    auto& last = all_allocated_elements_.back();
+  // Insert `count` new elements constructed from `args` at the end. Elements
+  // get consecutive indices, and become visible to readers at once.
+  //
+  // Returns the index of the first inserted item.
+  template <typename... Args>
+  size_t emplace_back_n(size_t count, const Args&... args) {
+    const size_t index = Reserve(count);
+    for (size_t i = 0; i < count; ++i) new (Slot(index + i)) T(args...);
+    Publish(index, count);
+    return index;  // return insertion index
+  }
 
-    if (last.size() < last.capacity()) {
-      // There is still room in the current vector without reallocation. Just
-      // add the new element there.
-      last.emplace_back(std::forward<Args>(args)...);
+ private:
+  // Segment `k > 0` keeps elements in the [2^(f + k - 1), 2^(f + k)) range,
+  // where `f` is the log2 of the first segment size, so we need at most 65
+  // segments to index 2^64 elements.
+  static constexpr int kMaxSegments = 65;
+
+  int SegmentIndex(size_t index) const {
+    if ((index >> first_segment_log2_) == 0) return 0;
+    return absl::bit_width(index) - first_segment_log2_;
+  }
 
-      // Increment the size of the concurrent vector.
-      auto state = State::Decode(state_.load(std::memory_order_relaxed));
-      state.size += 1;
-      state_.store(state.Encode(), std::memory_order_release);
+  size_t SegmentStart(int segment) const {
+    if (segment == 0) return 0;
+    return size_t{1} << (first_segment_log2_ + segment - 1);
+  }
 
-      return state.size - 1;  // return insertion index
-    }
-    // There is no more room in the current vector without reallocation.
-    // Allocate a new vector with twice as much capacity, copy the elements
-    // from the previous vector, and set elements_ to point to the data of the
-    // new vector.
-    all_allocated_elements_.emplace_back();
-    auto& new_last = all_allocated_elements_.back();
-    auto& prev = *(all_allocated_elements_.rbegin() + 1);
-    new_last.reserve(prev.capacity() * 2);
-    assert(prev.size() == prev.capacity());
-
-    // Copy over the previous vector to the new vector.
-    new_last.insert(new_last.begin(), prev.begin(), prev.end());
-    new_last.emplace_back(std::forward<Args>(args)...);
-
-    // Increment the size of the concurrent vector and index of the last
-    // allocated vector.
-    auto state = State::Decode(state_.load(std::memory_order_relaxed));
-    state.last_allocated += 1;
-    state.size += 1;
-    state_.store(state.Encode(), std::memory_order_release);
-
-    return state.size - 1;  // return insertion index
+  size_t SegmentSize(int segment) const {
+    if (segment == 0) return size_t{1} << first_segment_log2_;
+    return size_t{1} << (first_segment_log2_ + segment - 1);
   }
 
- private:
-  // Concurrent vector state layout:
-  // - Low 32 bits encode the index of the last allocated vector.
-  // - High 32 bits encode the size of the concurrent vector.
-  static constexpr uint64_t kLastAllocatedMask = (1ull << 32) - 1;
-  static constexpr uint64_t kSizeMask = ((1ull << 32) - 1) << 32;
-
-  struct State {
-    uint64_t last_allocated;  // index of last allocated vector
-    uint64_t size;            // size of the concurrent vector
-
-    static State Decode(uint64_t state) {
-      uint64_t last_allocated = (state & kLastAllocatedMask);
-      uint64_t size = (state & kSizeMask) >> 32;
-      return {last_allocated, size};
+  // Returns the memory location of the element at `index`. The segment that
+  // holds the element must be allocated.
+  T* Slot(size_t index) const {
+    const int segment = SegmentIndex(index);
+    T* data = segments_[segment].load(std::memory_order_acquire);
+    assert(data != nullptr);
+    return data + (index - SegmentStart(segment));
+  }
+
+  // Reserves `count` consecutive indices, and allocates the segments that will
+  // hold them. Returns the first reserved index.
+  size_t Reserve(size_t count) {
+    const size_t index = reserved_.fetch_add(count, std::memory_order_relaxed);
+    if (count == 0) return index;
+
+    const int last = SegmentIndex(index + count - 1);
+    for (int segment = SegmentIndex(index); segment <= last; ++segment) {
+      if (segments_[segment].load(std::memory_order_acquire)) continue;
+
+      // Concurrent writers might race to allocate the same segment, only one
+      // of them succeeds to publish it.
+      std::allocator<T> allocator;
+      T* data = allocator.allocate(SegmentSize(segment));
+      T* expected = nullptr;
+      if (!segments_[segment].compare_exchange_strong(
+              expected, data, std::memory_order_acq_rel,
+              std::memory_order_acquire)) {
+        allocator.deallocate(data, SegmentSize(segment));
+      }
     }
 
-    uint64_t Encode() const { return (size << 32) | last_allocated; }
-  };
+    return index;
+  }
+
+  // Publishes `count` elements starting at `index` to the readers, after all
+  // elements at the earlier indices are published.
+  void Publish(size_t index, size_t count) {
+    while (size_.load(std::memory_order_acquire) != index)
+      std::this_thread::yield();
+    size_.store(index + count, std::memory_order_release);
+  }
+
+  const int first_segment_log2_;
+
+  // The number of indices reserved by writers.
+  std::atomic<size_t> reserved_{0};
 
-  // Stores/loads to/from this atomic used to enforce happens-before
-  // relationship between emplace_back and operator[].
-  std::atomic<uint64_t> state_;
+  // The number of published elements. Stores/loads to/from this atomic used to
+  // enforce happens-before relationship between emplace_back and operator[].
+  std::atomic<size_t> size_{0};
 
-  absl::Mutex mutex_;
-  std::vector<std::vector<T>> all_allocated_elements_ ABSL_GUARDED_BY(mutex_);
+  // Segments table. Segments are allocated on demand, and are never freed
+  // before the vector is destroyed.
+  std::array<std::atomic<T*>, kMaxSegments> segments_{};
 };
 
 }  // namespace internal
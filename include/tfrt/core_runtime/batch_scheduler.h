@@ -0,0 +1,94 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares BatchScheduler, which batches concurrent calls of a
+// function on TensorHandles.
+
+#ifndef TFRT_CORE_RUNTIME_BATCH_SCHEDULER_H_
+#define TFRT_CORE_RUNTIME_BATCH_SCHEDULER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/core_runtime/tensor_handle.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/ref_count.h"
+
+namespace tfrt {
+
+class ExecutionContext;
+class Function;
+
+struct BatchSchedulerOptions {
+  // Maximum number of rows (the size of the first dimension of the arguments)
+  // of a batch. A call with more rows runs in a batch of its own.
+  int64_t max_batch_size = 32;
+
+  // Maximum time the first call of a batch waits for more calls.
+  std::chrono::microseconds batch_timeout{1000};
+
+  // If not empty, batches are padded with zero rows to the smallest of these
+  // sizes that fits, so that the function only sees a few different shapes
+  // (e.g. to bound the number of compiled specializations). Must be sorted.
+  // Batches larger than the last size are not padded.
+  std::vector<int64_t> allowed_batch_sizes;
+};
+
+// BatchScheduler runs concurrent calls of a function as one call on batched
+// arguments.
+//
+// Serving requests one at a time runs every model at batch size 1, which
+// leaves most of the throughput of the hardware unused. Calls are queued until
+// the queued calls have `max_batch_size` rows or the first call has waited for
+// `batch_timeout`. The arguments of the queued calls are then concatenated
+// along the first dimension, the function runs once, and the rows of its
+// results are split into the results of the calls.
+//
+// The function takes and returns !corert.tensorhandle values only. Its tensors
+// must be DenseHostTensors, and the first dimension of every result must be the
+// first dimension of the arguments.
+class BatchScheduler {
+ public:
+  BatchScheduler(const Function* function, BatchSchedulerOptions options);
+
+  // Runs the calls that are still queued. Batches keep running after the
+  // scheduler is destroyed.
+  ~BatchScheduler();
+
+  BatchScheduler(const BatchScheduler&) = delete;
+  BatchScheduler& operator=(const BatchScheduler&) = delete;
+
+  // Enqueues a call of the function with `arguments`, and returns its results.
+  // The arguments of all calls must have the same dtypes and the same
+  // dimensions except for the first one. A batch runs with the
+  // ExecutionContext of its first call.
+  llvm::SmallVector<AsyncValueRef<TensorHandle>, 4> Execute(
+      const ExecutionContext& exec_ctx, ArrayRef<TensorHandle> arguments);
+
+ private:
+  // The queue, reference counted because timers and pending arguments refer
+  // to it.
+  class Queue;
+
+  RCReference<Queue> queue_;
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_CORE_RUNTIME_BATCH_SCHEDULER_H_
@@ -100,6 +100,14 @@ class CoreRuntime final {
   // directly, or an error if it cannot find the op in the op registry.
   Expected<CoreRuntimeOp> MakeOp(string_view op_name, OpHandler* op_handler);
 
+  // [Experimental]
+  // Same as MakeOp(), but the op is created once for each op name and op
+  // handler, and is owned by this core runtime. This avoids the op lookup for
+  // the kernels executing the same op repeatedly. `op_handler` must be alive
+  // as long as this core runtime.
+  Expected<const CoreRuntimeOp*> GetOrMakeOp(string_view op_name,
+                                             OpHandler* op_handler);
+
   // [Experimental]
   // Construct and return a CoreRuntimeOp (a callable) from a Function. To
   // handle side effects, the first argument must be an input chain, and the
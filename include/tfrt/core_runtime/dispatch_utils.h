@@ -78,16 +78,33 @@ namespace tfrt {
 //
 // This overload will be SFINAE'ed out if OpHandlerTraits::OpHandlerInfoTy
 // doesn't exist.
+//
+// If the compiler statically inferred the result metadata of the op, it can
+// attach it as the kResultMetadataAttrName attribute, an aggregate with a
+// [dtype, shape] aggregate for each result, e.g.
+//
+//   _result_metadata = [[f32, #corert.shape<2x3>]]
+//
+// The metadata function is then not run, and the result TensorHandles get the
+// attached metadata even if the metadata of the arguments is not available.
 template <typename OpHandlerTraits>
 bool ExecuteOnOpHandler(
     bool update_chain, const OpInvocation& invocation,
     typename OpHandlerTraits::OpEntryTy op_entry,
     typename OpHandlerTraits::OpHandlerInfoTy op_handler_info);
 
+constexpr char kResultMetadataAttrName[] = "_result_metadata";
+
 namespace internal {
 // Internal implementaion details, please do not depend on things inside this
 // namespace.
 
+// Fills in `result_mds` from the kResultMetadataAttrName attribute in `attrs`
+// and returns true, or returns false if there is no such attribute with fully
+// defined metadata for `num_results` results.
+bool GetStaticResultMetadata(const OpAttrsRef& attrs, size_t num_results,
+                             llvm::SmallVectorImpl<TensorMetadata>& result_mds);
+
 enum class MDFunctionExecResult {
   kMetadataUnavailable,
   kError,
@@ -173,17 +190,11 @@ class AsyncOpDispatcher {
     return result_ind_avs_;
   }
 
-  llvm::SmallVector<AsyncValueRef<TensorMetadata>, 4>&
-  result_missing_md_avs_ref() {
-    return result_missing_md_avs_;
-  }
-
   static void RunDispatchFunctionSync(
       typename OpHandlerTraits::OpEntryTy& op_entry,
       typename OpHandlerTraits::OpHandlerInfoTy op_handler_info,
       ArrayRef<RCReference<AsyncValue>> inputs, const OpAttrsRef& attrs,
       size_t num_results, ArrayRef<TensorMetadata> result_mds,
-      MutableArrayRef<AsyncValueRef<TensorMetadata>> result_missing_md_avs,
       llvm::SmallVectorImpl<RCReference<AsyncValue>>* results,
       AsyncValueRef<Chain>* chain, const ExecutionContext& exec_ctx);
 
@@ -217,10 +228,6 @@ class AsyncOpDispatcher {
   // fulfill.
   llvm::SmallVector<RCReference<IndirectAsyncValue>, 4> result_ind_avs_;
 
-  // If we had no metadata function, then these will be the AsyncValues that
-  // need to be fulfilled with a TensorMetadata.
-  llvm::SmallVector<AsyncValueRef<TensorMetadata>, 4> result_missing_md_avs_;
-
   typename OpHandlerTraits::OpEntryTy op_entry_;
   typename OpHandlerTraits::OpHandlerInfoTy op_handler_info_;
 };
@@ -234,11 +241,6 @@ LLVM_ATTRIBUTE_NOINLINE void AsyncOpDispatcher<OpHandlerTraits>::PropagateError(
   for (auto& result : result_ind_avs_)
     if (result->IsUnresolvedIndirect()) result->ForwardTo(FormRef(error));
 
-  // If the op lacked a shape function, then propagate the error into each
-  // of the TensorHandle metadata results.
-  for (auto& metadata_av : result_missing_md_avs_)
-    if (metadata_av.IsUnavailable()) metadata_av.SetError(error->GetError());
-
   // If this is a side effecting operation, propagate the error through the
   // result.
   if (chain_ && chain_.IsUnavailable()) chain_.SetError(error->GetError());
@@ -258,8 +260,8 @@ void AsyncOpDispatcher<OpHandlerTraits>::RunDispatchFunction() {
   llvm::SmallVector<RCReference<AsyncValue>, 4> result_tensors;
   RunDispatchFunctionSync(op_entry_, op_handler_info_, arguments_,
                           frozen_attrs_, result_ind_avs_.size(), result_mds_,
-                          result_missing_md_avs_, &result_tensors,
-                          chain_ ? &chain_ : nullptr, exec_ctx_);
+                          &result_tensors, chain_ ? &chain_ : nullptr,
+                          exec_ctx_);
 
   // Fulfill the result async values with the results of the op.
   for (size_t i = 0, e = result_ind_avs_.size(); i != e; ++i) {
@@ -287,7 +289,6 @@ template <typename OpHandlerTraits>
     typename OpHandlerTraits::OpHandlerInfoTy op_handler_info,
     ArrayRef<RCReference<AsyncValue>> inputs, const OpAttrsRef& attrs,
     size_t num_results, ArrayRef<TensorMetadata> result_mds,
-    MutableArrayRef<AsyncValueRef<TensorMetadata>> result_missing_md_avs,
     llvm::SmallVectorImpl<RCReference<AsyncValue>>* results,
     AsyncValueRef<Chain>* chain, const ExecutionContext& exec_ctx) {
   llvm::SmallVector<InputTensorTy*, 4> arg_tensors;
@@ -302,11 +303,6 @@ template <typename OpHandlerTraits>
     // Any unresolved tensor results become the error.
     for (auto& result : *results) result = FormRef(cancel_error);
 
-    // If the op lacked a shape function, then propagate the error into each
-    // of the TensorHandle metadata results.
-    for (auto& metadata_av : result_missing_md_avs)
-      metadata_av.SetError(cancel_error->GetError());
-
     // If this is a side effecting operation, propagate the error through the
     // result.
     if (chain && *chain) chain->SetError(cancel_error->GetError());
@@ -335,27 +331,6 @@ template <typename OpHandlerTraits>
           }
         });
   }
-
-  // result_missing_md_avs will be empty if there was a metadata function
-  // which already computed these results.
-  if (result_missing_md_avs.empty()) {
-    return;
-  }
-  assert(result_missing_md_avs.size() == results->size());
-
-  // Fulfill the result metadata async values with the results of the op.
-  for (size_t i = 0, e = results->size(); i != e; ++i) {
-    auto& result_tensor = (*results)[i];
-    result_tensor->AndThen([md = result_missing_md_avs[i].CopyRef(),
-                            result_tensor = result_tensor.get()]() mutable {
-      if (result_tensor->IsError()) {
-        md.SetError(result_tensor->GetError());
-      } else {
-        // Fulfill the metadata async_value.
-        md.emplace(result_tensor->get<Tensor>().metadata());
-      }
-    });
-  }
 }
 
 // Execute the dispatch function for an op when the metadata for the results is
@@ -365,32 +340,19 @@ template <typename OpHandlerTraits>
 // either have result metadata entries or not.
 //
 // We have result metadata's when there is a shape function for the op.  In that
-// case, the result_md's ArrayRef specifies the results of the op, and
-// result_md_avs is null.
+// case, the result_md's ArrayRef specifies the results of the op.
 //
-// If there is no shape function, then result_mds is empty, and result_md_avs
-// must be filled in with the AsyncValue's for the eventually computed shape
-// results of the tensor op.
+// If there is no shape function, then result_mds is empty, and the metadata of
+// the results is read from the result tensors once they are available.
 template <typename OpHandlerTraits>
 void ExecuteWithResultMetadataResolved(
     const ExecutionContext& exec_ctx, MutableArrayRef<TensorHandle> arguments,
     const OpAttrsRef& attrs, size_t num_results,
     const llvm::SmallVector<TensorMetadata, 4>& result_mds,
-    llvm::SmallVectorImpl<AsyncValueRef<TensorMetadata>>* result_md_avs,
     llvm::SmallVectorImpl<AsyncValueRef<Tensor>>* result_tensor_avs,
     AsyncValueRef<Chain>* chain, bool update_chain,
     typename OpHandlerTraits::OpEntryTy op_entry,
     typename OpHandlerTraits::OpHandlerInfoTy op_handler_info) {
-  // If we have no input metadatas (from a metadata function) then we need to
-  // resolve the TensorHandle metadata's from the op results.
-  if (result_md_avs) {
-    result_md_avs->reserve(num_results);
-    for (size_t i = 0; i != num_results; ++i) {
-      result_md_avs->push_back(
-          MakeUnconstructedAsyncValueRef<TensorMetadata>());
-    }
-  }
-
   // Keep track of all the non-resolved values to see if we can dispatch the
   // kernel immediately. If not we will "and then" on these non-resolved values.
   llvm::SmallVector<AsyncValue*, 4> async_args;
@@ -424,11 +386,9 @@ void ExecuteWithResultMetadataResolved(
     // All input tensor and input chain are available. We can immediately
     // dispatch the kernel synchronously.
     llvm::SmallVector<RCReference<AsyncValue>, 4> result_tensors;
-    llvm::SmallVector<AsyncValueRef<TensorMetadata>, 0> empty_md_avs;
     internal::AsyncOpDispatcher<OpHandlerTraits>::RunDispatchFunctionSync(
         op_entry, op_handler_info, arg_tensors, attrs, num_results, result_mds,
-        result_md_avs ? *result_md_avs : empty_md_avs, &result_tensors,
-        update_chain ? chain : nullptr, exec_ctx);
+        &result_tensors, update_chain ? chain : nullptr, exec_ctx);
     result_tensor_avs->reserve(num_results);
     // Fulfill the result async values with the results of the op.
     for (size_t i = 0; i != num_results; ++i) {
@@ -454,10 +414,6 @@ void ExecuteWithResultMetadataResolved(
     auto tensor = MakeIndirectAsyncValue();
     op_dispatcher.result_ind_avs_ref().push_back(tensor);
     result_tensor_avs->push_back(AsyncValueRef<Tensor>(std::move(tensor)));
-    if (result_md_avs) {
-      op_dispatcher.result_missing_md_avs_ref().push_back(
-          (*result_md_avs)[i].CopyRef());
-    }
   }
 
   RunWhenReady(async_args,
@@ -489,8 +445,8 @@ LLVM_ATTRIBUTE_NOINLINE void ExecuteWithMetadataAsync(
           AsyncValueRef<Chain>* chain) mutable {
         ExecuteWithResultMetadataResolved<OpHandlerTraits>(
             exec_ctx, arguments, attrs, num_results, result_mds,
-            /*result_md_avs=*/nullptr, result_tensor_avs, chain, update_chain,
-            std::move(op_entry), std::move(op_handler_info));
+            result_tensor_avs, chain, update_chain, std::move(op_entry),
+            std::move(op_handler_info));
       });
 }
 
@@ -506,15 +462,20 @@ bool ExecuteOnOpHandlerImpl(
   // without emitting an error.
   if (!op_entry.dispatch_fn) return false;
 
-  // This gets filled in with the TensorMetadata's for the op results if it has
-  // a registered metadata function.
+  // This gets filled in with the TensorMetadata's for the op results if they
+  // are attached to the op, or if it has a registered metadata function.
   llvm::SmallVector<TensorMetadata, 4> result_mds;
+  bool has_static_result_mds = internal::GetStaticResultMetadata(
+      invocation.attrs, invocation.results.size(), result_mds);
+  bool has_result_mds =
+      has_static_result_mds || op_entry.metadata_fn != nullptr;
 
   // If the op has a metadata function, then we make sure to execute it, because
   // it may be checking the op invariants, and the op implementation may be slow
   // or async - but we want to propagate the shape synchronously whenever
-  // possible.
-  if (op_entry.metadata_fn) {
+  // possible. Statically known result metadata was already checked by the
+  // compiler.
+  if (op_entry.metadata_fn && !has_static_result_mds) {
     auto md_exec_result =
         ExecuteMetadataFunction(op_entry.metadata_fn, invocation, result_mds);
     if (md_exec_result == MDFunctionExecResult::kError) {
@@ -532,17 +493,13 @@ bool ExecuteOnOpHandlerImpl(
   // Okay, now that the metadata function returned successfully, we can run our
   // op.
 
-  llvm::SmallVector<AsyncValueRef<TensorMetadata>, 8> result_md_avs;
   llvm::SmallVector<AsyncValueRef<Tensor>, 8> result_tensor_avs;
-
-  // Don't pass a pointer to result_md_avs if we had a metadata function.
-  auto* result_md_avs_ptr = op_entry.metadata_fn ? nullptr : &result_md_avs;
   auto results = invocation.results;
 
   internal::ExecuteWithResultMetadataResolved<OpHandlerTraits>(
       invocation.exec_ctx, invocation.arguments, invocation.attrs,
-      results.size(), result_mds, result_md_avs_ptr, &result_tensor_avs,
-      invocation.chain, update_chain, op_entry, std::move(op_handler_info));
+      results.size(), result_mds, &result_tensor_avs, invocation.chain,
+      update_chain, op_entry, std::move(op_handler_info));
 
   for (size_t i = 0, e = results.size(); i != e; ++i) {
     Variant<RCReference<Device>, AsyncValueRef<RCReference<Device>>>
@@ -556,25 +513,27 @@ bool ExecuteOnOpHandlerImpl(
               .ReleaseRCRef());
       continue;
     }
-    if (op_entry.metadata_fn && result_device.is<RCReference<Device>>()) {
+    if (has_result_mds && result_device.is<RCReference<Device>>()) {
       results[i] =
           TensorHandle(std::move(result_device.get<RCReference<Device>>()),
                        result_mds[i], std::move(result_tensor_avs[i]));
-    } else if (op_entry.metadata_fn &&
+    } else if (has_result_mds &&
                result_device.is<AsyncValueRef<RCReference<Device>>>()) {
       results[i] = TensorHandle(
           std::move(result_device.get<AsyncValueRef<RCReference<Device>>>()),
           result_mds[i], std::move(result_tensor_avs[i]));
-    } else if (!op_entry.metadata_fn &&
+    } else if (!has_result_mds &&
                result_device.is<RCReference<Device>>()) {
-      results[i] = TensorHandle(
-          std::move(result_device.get<RCReference<Device>>()),
-          std::move(result_md_avs[i]), std::move(result_tensor_avs[i]));
-    } else if (!op_entry.metadata_fn &&
+      // Without result metadata, the TensorHandle reads the metadata from the
+      // tensor, so that we don't need to allocate an AsyncValue for it.
+      results[i] =
+          TensorHandle(std::move(result_device.get<RCReference<Device>>()),
+                       std::move(result_tensor_avs[i]));
+    } else if (!has_result_mds &&
                result_device.is<AsyncValueRef<RCReference<Device>>>()) {
       results[i] = TensorHandle(
           std::move(result_device.get<AsyncValueRef<RCReference<Device>>>()),
-          std::move(result_md_avs[i]), std::move(result_tensor_avs[i]));
+          std::move(result_tensor_avs[i]));
     }
   }
 
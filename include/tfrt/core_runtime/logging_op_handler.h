@@ -19,6 +19,8 @@
 #ifndef TFRT_CORE_RUNTIME_LOGGING_OP_HANDLER_H_
 #define TFRT_CORE_RUNTIME_LOGGING_OP_HANDLER_H_
 
+#include <cstdint>
+
 #include "tfrt/support/forward_decls.h"
 
 namespace tfrt {
@@ -29,6 +31,12 @@ class CoreRuntime;
 llvm::Expected<tfrt::OpHandler *> CreateLoggingOpHandler(
     tfrt::CoreRuntime *runtime, OpHandler *fallback, bool sync_log_results);
 
+// Creates a logging op handler with low overhead for production use. It logs
+// the name, device, input shapes and latency of one in `sample_rate` ops, and
+// records the latencies in a histogram metric.
+llvm::Expected<tfrt::OpHandler *> CreateSampledLoggingOpHandler(
+    tfrt::CoreRuntime *runtime, OpHandler *fallback, uint32_t sample_rate);
+
 }  // namespace tfrt
 
 #endif  // TFRT_CORE_RUNTIME_LOGGING_OP_HANDLER_H_
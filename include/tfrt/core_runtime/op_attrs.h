@@ -629,6 +629,17 @@ class OpAttrsRef {
   // Return a reference that is guaranteed stable on the heap.
   OpAttrsRef freeze() const;
 
+  // Return a hash of the attribute set that doesn't depend on the order in
+  // which the attributes were set. This is precomputed for frozen sets.
+  uint64_t GetHash() const;
+
+  // Return true if both references have the same attributes. Frozen attribute
+  // sets are interned, so two frozen sets are compared in constant time.
+  friend bool operator==(const OpAttrsRef& lhs, const OpAttrsRef& rhs);
+  friend bool operator!=(const OpAttrsRef& lhs, const OpAttrsRef& rhs) {
+    return !(lhs == rhs);
+  }
+
   // Print the state of this attribute set, this is only intended for debugging.
   void Print(raw_ostream& os) const;
   void Dump() const;
@@ -51,6 +51,12 @@ class OpHandler {
 
   virtual Expected<CoreRuntimeOp> MakeOp(string_view op_name) = 0;
 
+  // Execute `invocations` in order. Op handlers that can amortize the per-op
+  // overhead over many ops, e.g. by synchronizing a stream or sending an RPC
+  // once for the whole batch, should override this. The default implementation
+  // executes the ops one at a time, and fails the results of unsupported ops.
+  virtual void ExecuteBatch(ArrayRef<OpInvocation> invocations);
+
   virtual ~OpHandler();
 
  private:
@@ -60,6 +60,15 @@ class TensorHandle final {
   TensorHandle(RCReference<Device> device, const TensorMetadata& metadata,
                AsyncValueRef<Tensor> tensor);
 
+  // The metadata of a TensorHandle created without a metadata is the metadata
+  // of `tensor`, and becomes available together with `tensor`. This avoids
+  // allocating a separate metadata AsyncValue for op results whose shapes are
+  // only known once the op has run.
+  TensorHandle(AsyncValueRef<RCReference<Device>> async_device,
+               AsyncValueRef<Tensor> tensor);
+
+  TensorHandle(RCReference<Device> device, AsyncValueRef<Tensor> tensor);
+
   // TODO(fishx): Change the argument to RCReference<ErrorAsyncValue> since
   // right now we cannot convert an AsyncValueRef to
   // RCReference<ErrorAsyncValue> easily.
@@ -105,23 +114,38 @@ class TensorHandle final {
     // metadata from the tensor unless the metadata is already available, in
     // which case the metadata should be provided to the c'tor at the
     // construction time.
-    return IsMetadataInline() || async_metadata_.IsConcrete() ||
-           GetAsyncTensor()->IsConcrete();
+    return IsMetadataInline() || GetAsyncTensor()->IsConcrete() ||
+           (!IsMetadataFromTensor() && async_metadata_.IsConcrete());
   }
 
   bool IsMetadataError() const {
-    return !IsMetadataInline() && async_metadata_.IsError() &&
-           GetAsyncTensor()->IsError();
+    return !IsMetadataInline() && GetAsyncTensor()->IsError() &&
+           (IsMetadataFromTensor() || async_metadata_.IsError());
   }
 
-  const AsyncValueRef<TensorMetadata>& GetAsyncMetadata() const;
+  // Return the metadata as an AsyncValue. If the metadata is read from the
+  // tensor, this allocates a new AsyncValue unless the tensor is an error.
+  // Use this method only if IsMetadataAvailable() returns false.
+  AsyncValueRef<TensorMetadata> GetAsyncMetadata() const;
+
+  // Return the AsyncValue that becomes available when the metadata becomes
+  // available, which is the tensor if the metadata is read from the tensor.
+  // The AsyncValue is an error iff IsMetadataError() returns true. Unlike
+  // GetAsyncMetadata(), this never allocates.
+  // Use this method only if IsMetadataAvailable() returns false.
+  AsyncValue* GetAsyncMetadataValue() const {
+    assert(IsValid() && !IsMetadataInline());
+    if (IsMetadataFromTensor()) return GetAsyncTensor();
+    return async_metadata_.GetAsyncValue();
+  }
 
   // Return reference of the TensorMetadata.
   // Use this method only if IsMetadataAvailable() returns true.
   const TensorMetadata& GetAvailableMetadata() const {
     assert(IsValid());
     if (IsMetadataInline()) return inlined_metadata_;
-    if (async_metadata_.IsConcrete()) return async_metadata_.get();
+    if (!IsMetadataFromTensor() && async_metadata_.IsConcrete())
+      return async_metadata_.get();
     return GetAsyncTensor()->get<Tensor>().metadata();
   }
 
@@ -176,6 +200,14 @@ class TensorHandle final {
     return tensor_and_flags_.getInt() & Flags::MetadataInline;
   }
 
+  // Returns true if the metadata is neither inline nor in its own AsyncValue,
+  // and is read from the tensor instead.
+  bool IsMetadataFromTensor() const {
+    return !IsMetadataInline() && !async_metadata_.GetAsyncValue();
+  }
+
+  AsyncValueRef<TensorMetadata> GetAsyncMetadataFromTensor() const;
+
   // Reset both tensor and metadata to default initialized state.
   void Reset() {
     if (IsMetadataInline()) {
@@ -216,7 +248,8 @@ class TensorHandle final {
   // prepared to handle a 'future' metadata.
   //
   // `async_metadata_` is null and IsMetadataInline() is false for an invalid
-  // TensorHandle.
+  // TensorHandle, and for a TensorHandle that reads its metadata from the
+  // tensor.
   union {
     AsyncValueRef<TensorMetadata> async_metadata_;
     TensorMetadata inlined_metadata_;
@@ -322,11 +355,11 @@ inline const AsyncValueRef<RCReference<Device>>& TensorHandle::GetAsyncDevice()
   return async_device_;
 }
 
-inline const AsyncValueRef<TensorMetadata>& TensorHandle::GetAsyncMetadata()
-    const {
+inline AsyncValueRef<TensorMetadata> TensorHandle::GetAsyncMetadata() const {
   assert(IsValid() && !IsMetadataInline());
 
-  return async_metadata_;
+  if (IsMetadataFromTensor()) return GetAsyncMetadataFromTensor();
+  return async_metadata_.CopyRef();
 }
 
 inline TensorHandle TensorHandle::CopyRef() const {
@@ -336,6 +369,10 @@ inline TensorHandle TensorHandle::CopyRef() const {
   } else if (!IsDeviceInline() && IsMetadataInline()) {
     return TensorHandle(async_device_.CopyRef(), inlined_metadata_,
                         std::move(tensor));
+  } else if (IsMetadataFromTensor()) {
+    if (IsDeviceInline())
+      return TensorHandle(inlined_device_, std::move(tensor));
+    return TensorHandle(async_device_.CopyRef(), std::move(tensor));
   } else if (IsDeviceInline() && !IsMetadataInline()) {
     return TensorHandle(inlined_device_, async_metadata_.CopyRef(),
                         std::move(tensor));
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares the data pipeline autotuner, which adjusts the prefetch
+// depth and the parallelism of iterators at runtime.
+
+#ifndef TFRT_DATA_AUTOTUNER_H_
+#define TFRT_DATA_AUTOTUNER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/ref_count.h"
+
+namespace tfrt {
+namespace data {
+
+// Dataset arguments and attributes set to kAutotune are tuned at runtime.
+constexpr int64_t kAutotune = -1;
+
+class Autotuner;
+
+// A tunable parameter of an iterator, e.g. its prefetch depth.
+//
+// The iterator reads value() whenever it needs the parameter, and reports each
+// result returned by GetNext() through RecordGetNext(). Every kPeriod calls,
+// the parameter is adjusted based on the fraction of the time that the
+// consumer waited for unavailable results, and on the throughput of GetNext():
+//
+//  - If the consumer waited for more than kStarvedWaitFraction of the time,
+//    the value is incremented, as long as the autotuner budget allows it.
+//  - If the increment did not improve the throughput by at least
+//    kMinImprovement in the following period, it is reverted and the value is
+//    not incremented beyond that point again.
+//  - If the consumer did not wait at all for kIdlePeriods periods, the value
+//    is decremented to release its budget to other iterators.
+class TunableParameter : public ReferenceCounted<TunableParameter> {
+ public:
+  TunableParameter(RCReference<Autotuner> autotuner, int64_t value,
+                   int64_t min_value, int64_t max_value);
+  ~TunableParameter();
+
+  // This class is not copyable or movable.
+  TunableParameter(const TunableParameter&) = delete;
+  TunableParameter& operator=(const TunableParameter&) = delete;
+
+  // Can be called from any thread.
+  int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+  // Records that GetNext() returned a result with `eof`. Calls must not be
+  // concurrent, like the calls to GetNext().
+  void RecordGetNext(const AsyncValueRef<bool>& eof);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr int kPeriod = 100;
+  static constexpr double kStarvedWaitFraction = 0.1;
+  static constexpr double kMinImprovement = 1.05;
+  static constexpr int kIdlePeriods = 8;
+
+  void Tune(Clock::time_point now);
+
+  RCReference<Autotuner> autotuner_;
+  const int64_t min_value_;
+  int64_t max_value_;
+  std::atomic<int64_t> value_;
+
+  // Statistics of the current period.
+  Clock::time_point period_start_;
+  int num_calls_ = 0;
+  // Updated when results become available, possibly by other threads.
+  std::atomic<int64_t> wait_ns_{0};
+
+  // The throughput before the last increment, or 0 if the value was not
+  // incremented in the last period.
+  double throughput_before_increment_ = 0;
+  int num_idle_periods_ = 0;
+};
+
+// The autotuner of a data pipeline. It bounds the sum of the values of the
+// tunable parameters of all iterators, which approximates the number of
+// elements that the pipeline buffers or computes ahead of its consumer.
+class Autotuner : public ReferenceCounted<Autotuner> {
+ public:
+  static constexpr int64_t kDefaultBudget = 4096;
+
+  explicit Autotuner(int64_t budget = kDefaultBudget) : available_(budget) {}
+
+  // Creates a parameter that starts at `initial_value`, or lower if the budget
+  // does not allow it, and is tuned within [min_value, max_value]. Reaching
+  // `min_value` is always allowed, even if it exceeds the budget.
+  RCReference<TunableParameter> MakeParameter(int64_t initial_value,
+                                              int64_t min_value,
+                                              int64_t max_value);
+
+  // Returns the remaining budget.
+  int64_t available() const {
+    return available_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  friend class TunableParameter;
+
+  // Reserves `n` from the budget, or returns false if not enough is left.
+  bool TryReserve(int64_t n);
+  void Reserve(int64_t n) {
+    available_.fetch_sub(n, std::memory_order_relaxed);
+  }
+  void Release(int64_t n) {
+    available_.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  std::atomic<int64_t> available_;
+};
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_DATA_AUTOTUNER_H_
@@ -21,6 +21,8 @@
 
 #include <memory>
 
+#include "tfrt/data/autotuner.h"
+#include "tfrt/data/stats.h"
 #include "tfrt/host_context/execution_context.h"
 #include "tfrt/host_context/host_allocator.h"
 #include "tfrt/host_context/host_context.h"
@@ -122,6 +124,9 @@ void DestroyImpl(SubClass* ptr, HostAllocator* allocator) {
 
 bool IsConcreteAndEmpty(const IterationResult& result);
 
+// Returns true if `eof` and all `values` are available and `eof` is false.
+bool AvailableAndNotEof(const IterationResult& result);
+
 template <typename... T, size_t... I>
 static void AllocateTupleResult(
     MutableArrayRef<RCReference<AsyncValue>> results, HostContext* host,
@@ -133,7 +138,17 @@ static void AllocateTupleResult(
 }  // namespace internal
 
 // This struct provides parameters specific to iterator creation.
-struct IteratorContext {};
+struct IteratorContext {
+  // Shared by all iterators of the pipeline to tune their parameters set to
+  // kAutotune.
+  RCReference<Autotuner> autotuner = MakeRef<Autotuner>();
+  // If not null, the iterators of the pipeline record their statistics in it.
+  RCReference<PipelineStats> stats;
+  // The stage of the iterator being created, if `stats` is not null. It is set
+  // by Dataset::MakeIterator() before the iterator is created, so iterators
+  // can record the time in their functions and the size of their buffers.
+  RCReference<IteratorStats> stage;
+};
 
 class Iterator : public ReferenceCounted<Iterator> {
  public:
@@ -155,12 +170,29 @@ class Dataset : public ReferenceCounted<Dataset> {
  public:
   virtual ~Dataset() {}
 
-  // Creates an iterator that points to the first element of the dataset.
-  // The iterator should keep +1 reference to the parent_dataset.
-  virtual RCReference<Iterator> MakeIterator(
-      const IteratorContext& context) = 0;
+  // Creates an iterator that points to the first element of the dataset. If
+  // `context.stats` is not null, the iterator records the statistics of its
+  // GetNext() results in the stage of this dataset.
+  RCReference<Iterator> MakeIterator(const IteratorContext& context);
+
+  // The name of this dataset in statistics, e.g. "map_dataset".
+  virtual string_view name() const = 0;
+
+  // Returns a dataset with the `index`-th of `num_shards` disjoint shards of
+  // the elements of this dataset, if this dataset can split its elements
+  // without reading the elements of the other shards, e.g. by assigning whole
+  // files to each shard. Returns nullptr otherwise, in which case ShardDataset
+  // falls back to skipping the elements of the other shards.
+  virtual RCReference<Dataset> MakeShard(int64_t num_shards, int64_t index) {
+    return {};
+  }
 
  private:
+  // Creates the iterator of this dataset. The iterator should keep +1
+  // reference to the parent_dataset.
+  virtual RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) = 0;
+
   // For access to Destroy().
   friend class ReferenceCounted<Dataset>;
 
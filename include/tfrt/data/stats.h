@@ -0,0 +1,175 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares the data pipeline statistics, which instrument the
+// iterators of a pipeline to find the stage that limits its throughput.
+
+#ifndef TFRT_DATA_STATS_H_
+#define TFRT_DATA_STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tfrt/metrics/metrics.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/ref_count.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace data {
+
+// The statistics of a stage of a data pipeline, i.e. of the iterators of a
+// dataset created by the same parent stage. For example, all the intermediate
+// iterators of an interleave_dataset share a stage.
+//
+// Each counter is also exported to the metrics registry under
+// /tfrt/data/<pipeline>/<path of the stage>/<counter>. All methods are
+// thread-safe.
+class IteratorStats : public ReferenceCounted<IteratorStats> {
+ public:
+  using Duration = std::chrono::nanoseconds;
+
+  IteratorStats(std::string name, RCReference<IteratorStats> parent,
+                string_view pipeline_name);
+
+  // This class is not copyable or movable.
+  IteratorStats(const IteratorStats&) = delete;
+  IteratorStats& operator=(const IteratorStats&) = delete;
+
+  const std::string& name() const { return name_; }
+  // The path of the stage from the root of the pipeline, e.g.
+  // "batch_dataset/map_dataset".
+  const std::string& path() const { return path_; }
+  // Returns nullptr for the root stage.
+  IteratorStats* parent() const { return parent_.get(); }
+
+  // Records that a GetNext() result of this stage became available `wait`
+  // after the call. If the result is an element, i.e. its eof is false,
+  // `bytes` is the size of its values.
+  void RecordGetNext(Duration wait, bool is_element, size_t bytes);
+
+  // Records `duration` spent in the synchronous part of the user-defined
+  // function of this stage.
+  void RecordFunction(Duration duration);
+
+  // Records the number of elements buffered by this stage, e.g. prefetched.
+  void RecordBufferSize(size_t size);
+
+  int64_t num_elements() const { return num_elements_.load(); }
+  int64_t bytes() const { return bytes_.load(); }
+  // The time that the consumer of this stage waited for its results.
+  Duration wait() const { return Duration(wait_ns_.load()); }
+  // The time that this stage waited for the results of its input stages.
+  Duration input_wait() const { return Duration(input_wait_ns_.load()); }
+  Duration function_time() const { return Duration(function_ns_.load()); }
+  double average_buffer_size() const;
+  int64_t max_buffer_size() const { return max_buffer_size_.load(); }
+
+ private:
+  const std::string name_;
+  const RCReference<IteratorStats> parent_;
+  const std::string path_;
+
+  std::atomic<int64_t> num_elements_{0};
+  std::atomic<int64_t> bytes_{0};
+  std::atomic<int64_t> wait_ns_{0};
+  std::atomic<int64_t> input_wait_ns_{0};
+  std::atomic<int64_t> function_ns_{0};
+  std::atomic<int64_t> buffer_size_sum_{0};
+  std::atomic<int64_t> num_buffer_samples_{0};
+  std::atomic<int64_t> max_buffer_size_{0};
+
+  // Owned by the metrics registry.
+  metrics::Counter* elements_metric_;
+  metrics::Counter* bytes_metric_;
+  metrics::Counter* wait_metric_;
+  metrics::Counter* input_wait_metric_;
+  metrics::Counter* function_metric_;
+  metrics::Histogram* buffer_size_metric_;
+};
+
+// The statistics of all the stages of a data pipeline. Iterators record their
+// statistics if the IteratorContext they are created with has a PipelineStats.
+class PipelineStats : public ReferenceCounted<PipelineStats> {
+ public:
+  // If `log_summary` is true, the summary is logged when the last reference
+  // is dropped, i.e. when all the iterators of the pipeline are destroyed.
+  explicit PipelineStats(std::string name = "pipeline",
+                         bool log_summary = false)
+      : name_(std::move(name)), log_summary_(log_summary) {}
+  ~PipelineStats();
+
+  // This class is not copyable or movable.
+  PipelineStats(const PipelineStats&) = delete;
+  PipelineStats& operator=(const PipelineStats&) = delete;
+
+  // Returns the stage of the iterators of dataset `name` created by the stage
+  // `parent`, or by the consumer of the pipeline if `parent` is nullptr.
+  RCReference<IteratorStats> GetOrCreateStage(string_view name,
+                                              IteratorStats* parent)
+      TFRT_EXCLUDES(mu_);
+
+  // Returns a report of the statistics of each stage, which names the stage
+  // that limits the throughput of the pipeline.
+  //
+  // The limiting stage is the one with the longest self wait, i.e. the time
+  // that its consumer waited for it minus the time that it waited for its
+  // inputs. The self wait is approximate since the waits of asynchronous
+  // results overlap, but the stage that starves its consumer while its inputs
+  // keep up stands out.
+  std::string Summary() const TFRT_EXCLUDES(mu_);
+
+ private:
+  const std::string name_;
+  const bool log_summary_;
+
+  mutable mutex mu_;
+  // In creation order, so that parents precede their children.
+  std::vector<RCReference<IteratorStats>> stages_ TFRT_GUARDED_BY(mu_);
+};
+
+// FunctionTimer records the time from its construction to its destruction as
+// time spent in the user-defined function of `stage`, unless `stage` is null.
+class FunctionTimer {
+ public:
+  explicit FunctionTimer(IteratorStats* stage) : stage_(stage) {
+    if (stage_) start_ = std::chrono::steady_clock::now();
+  }
+
+  ~FunctionTimer() {
+    if (!stage_) return;
+    stage_->RecordFunction(std::chrono::duration_cast<IteratorStats::Duration>(
+        std::chrono::steady_clock::now() - start_));
+  }
+
+  // This class is not copyable or movable.
+  FunctionTimer(const FunctionTimer&) = delete;
+  FunctionTimer& operator=(const FunctionTimer&) = delete;
+
+ private:
+  IteratorStats* stage_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_DATA_STATS_H_
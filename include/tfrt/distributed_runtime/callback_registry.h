@@ -22,11 +22,14 @@
 #ifndef TFRT_DISTRIBUTED_RUNTIME_CALLBACK_REGISTRY_H_
 #define TFRT_DISTRIBUTED_RUNTIME_CALLBACK_REGISTRY_H_
 
+#include <array>
+
 #include "llvm/ADT/StringMap.h"
 #include "tfrt/distributed_runtime/distributed_context.h"
 #include "tfrt/distributed_runtime/payload.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
 
 namespace tfrt {
 
@@ -51,15 +54,25 @@ class CallbackRegistry {
   using ValueMap = llvm::StringMap<CallbackValue>;
   using CallbackMap = llvm::StringMap<Callback>;
 
+  // Keys are sharded by hash, so that concurrent requests for different keys
+  // don't contend on one lock. The value and the callback for a key must be
+  // matched atomically, so they are kept in the same shard.
+  static constexpr int kNumShards = 16;
+
+  struct alignas(64) Shard {
+    mutex hashmap_mutex;
+    ValueMap values TFRT_GUARDED_BY(hashmap_mutex);
+    CallbackMap callbacks TFRT_GUARDED_BY(hashmap_mutex);
+  };
+
+  Shard& GetShard(const InstanceKey& key);
+
   void ExecuteCallback(const InstanceKey& key, Callback* callback,
                        CallbackValue value);
   // Print the registry state - for debugging.
   void DebugDump();
 
-  // TODO(xldrx): use separate mutexes for values and callbacks
-  mutex hashmap_mutex_;
-  ValueMap values_ TFRT_GUARDED_BY(hashmap_mutex_);
-  CallbackMap callbacks_ TFRT_GUARDED_BY(hashmap_mutex_);
+  std::array<Shard, kNumShards> shards_;
 };
 
 }  // namespace tfrt
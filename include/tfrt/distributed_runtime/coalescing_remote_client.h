@@ -0,0 +1,100 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Coalescing Remote Client
+//
+// This file declares a remote client which coalesces control plane requests.
+
+#ifndef TFRT_DISTRIBUTED_RUNTIME_COALESCING_REMOTE_CLIENT_H_
+#define TFRT_DISTRIBUTED_RUNTIME_COALESCING_REMOTE_CLIENT_H_
+
+#include <chrono>
+#include <memory>
+
+#include "tfrt/distributed_runtime/remote_client.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/support/ref_count.h"
+
+namespace tfrt {
+
+// CoalescingRemoteClient wraps a remote client and coalesces the
+// DeleteRemoteObjects and SendReadyChains requests sent to its task: requests
+// for the same distributed context are buffered for up to `window`, or until
+// they name `max_batch_size` objects, and then sent as one request. All other
+// requests are forwarded to the wrapped client as is.
+//
+// Each buffered request completes when the coalesced request completes, and
+// all of them see the same error. The response messages of the coalesced
+// requests are empty, so they are left untouched.
+//
+// Execute requests (RemoteExecute, RemoteExecuteOp and RegisterFunction) which
+// the remote task rejects with ResourceExhausted because it is overloaded are
+// sent again after an exponential backoff, up to `max_overload_retries` times.
+class CoalescingRemoteClient : public RemoteClientInterface {
+ public:
+  struct Options {
+    std::chrono::microseconds window = std::chrono::milliseconds(1);
+    int max_batch_size = 1024;
+    // The first backoff, which doubles with every retry.
+    std::chrono::microseconds overload_backoff = std::chrono::milliseconds(1);
+    int max_overload_retries = 10;
+  };
+
+  CoalescingRemoteClient(HostContext* host,
+                         std::unique_ptr<RemoteClientInterface> client,
+                         Options options);
+  CoalescingRemoteClient(HostContext* host,
+                         std::unique_ptr<RemoteClientInterface> client)
+      : CoalescingRemoteClient(host, std::move(client), Options()) {}
+
+  // Sends all buffered requests.
+  ~CoalescingRemoteClient() override;
+
+#define CLIENT_METHOD(method)                                             \
+  void method##Async(RemoteCallContext* call_ctx,                         \
+                     const method##Request* request,                      \
+                     method##Response* response, CallbackFn done) final;
+
+  CLIENT_METHOD(GetDevices);
+  CLIENT_METHOD(CreateContext);
+  CLIENT_METHOD(CloseContext);
+  CLIENT_METHOD(SendReadyChains);
+  CLIENT_METHOD(SendData);
+  CLIENT_METHOD(RegisterFunction);
+  CLIENT_METHOD(RemoteExecute);
+  CLIENT_METHOD(RemoteExecuteOp);
+  CLIENT_METHOD(DeleteRemoteObjects);
+  CLIENT_METHOD(KeepAlive);
+
+#undef CLIENT_METHOD
+
+  void SendPayloadAsync(RemoteCallContext* call_ctx, uint64_t context_id,
+                        string_view instance_key, Payload payload,
+                        CallbackFn done) final;
+
+  // Sends all buffered requests now.
+  void Flush();
+
+ private:
+  class Coalescer;
+
+  // Buffered requests are owned by the coalescer, which is kept alive by the
+  // pending flush timers.
+  RCReference<Coalescer> coalescer_;
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_DISTRIBUTED_RUNTIME_COALESCING_REMOTE_CLIENT_H_
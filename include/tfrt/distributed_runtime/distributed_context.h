@@ -44,6 +44,10 @@ class CallbackRegistry;
 class RemoteObjectManager;
 class RemoteClientInterface;
 class FunctionCache;
+class RemoteOpCache;
+class RemoteInputCache;
+class RemoteInputStore;
+class GradientCompressor;
 
 // Collective group membership stored inside DistributedContext. Different from
 // the CollectiveGroupConfiguration, the members are represented by TaskHandles
@@ -118,6 +122,34 @@ class DistributedContext {
 
   FunctionCache* GetFunctionCache() const { return function_cache_.get(); }
 
+  RemoteOpCache* GetRemoteOpCache() const { return remote_op_cache_.get(); }
+
+  // Inline inputs kept by the remote tasks, or nullptr if they are not cached.
+  RemoteInputCache* GetRemoteInputCache() const {
+    return remote_input_cache_.get();
+  }
+
+  // Inline inputs that other tasks asked this task to keep.
+  RemoteInputStore* GetRemoteInputStore() const {
+    return remote_input_store_.get();
+  }
+
+  // Codec for the payloads sent to other tasks. All tasks of the cluster get
+  // the same configuration.
+  PayloadCodec GetPayloadCodec() const { return dist_config_.payload_codec(); }
+
+  // Compressor for the partial results of float32 all-reduce.
+  GradientCompressor* GetGradientCompressor() const {
+    return gradient_compressor_.get();
+  }
+
+  // Returns the handle of the program registered on the remote task, or 0 if
+  // it is not known.
+  uint64_t GetRemoteProgramHandle(TaskHandle task_handle,
+                                  string_view program_name);
+  void SetRemoteProgramHandle(TaskHandle task_handle, string_view program_name,
+                              uint64_t program_handle);
+
   RemoteClientInterface* GetRemoteClient(TaskHandle task_handle);
 
   using CallbackFn = llvm::unique_function<void(Error)>;
@@ -178,6 +210,17 @@ class DistributedContext {
 
   std::unique_ptr<FunctionCache> function_cache_;
 
+  std::unique_ptr<RemoteOpCache> remote_op_cache_;
+
+  std::unique_ptr<RemoteInputCache> remote_input_cache_;
+  std::unique_ptr<RemoteInputStore> remote_input_store_;
+
+  std::unique_ptr<GradientCompressor> gradient_compressor_;
+
+  mutex remote_program_handles_mu_;
+  llvm::DenseMap<TaskHandle, llvm::StringMap<uint64_t>> remote_program_handles_
+      TFRT_GUARDED_BY(remote_program_handles_mu_);
+
   std::unique_ptr<RemoteObjectId> local_ready_chain_;
   mutex ready_chains_mu_;
   llvm::DenseMap<TaskHandle, RemoteObjectId> ready_chains_
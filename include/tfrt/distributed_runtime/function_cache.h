@@ -22,12 +22,18 @@
 #ifndef TFRT_DISTRIBUTED_RUNTIME_FUNCTION_CACHE_H_
 #define TFRT_DISTRIBUTED_RUNTIME_FUNCTION_CACHE_H_
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <unordered_map>
 
 #include "tfrt/bef/bef_buffer.h"
 #include "tfrt/bef_executor/bef_file.h"
 #include "tfrt/host_context/chain.h"
 #include "tfrt/host_context/resource_context.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
 
 namespace tfrt {
 
@@ -37,10 +43,13 @@ class HostContext;
 class FunctionCache {
  public:
   explicit FunctionCache(HostContext* host_context) : host_(host_context) {}
+  ~FunctionCache();
 
   // Register the given program. A program can have multiple functions in it.
-  // The program_name serves as both unique ID of this program.
-  Error Register(const std::string& program_name, BefBuffer bef_buffer);
+  // The program_name serves as both unique ID of this program. Returns the
+  // handle of the program, which is never 0.
+  Expected<uint64_t> Register(const std::string& program_name,
+                              BefBuffer bef_buffer);
 
   // Create BEFFile corresponding to the program with the given name.
   // A struct representing a BEFFile and the respective buffer.
@@ -53,13 +62,32 @@ class FunctionCache {
   };
   CachedBEF* Prepare(const std::string& program_name);
 
+  // Returns the program with the given handle, or nullptr if there is none.
+  // This doesn't take a lock, so that concurrent requests executing
+  // registered programs don't contend.
+  CachedBEF* Prepare(uint64_t handle);
+
  private:
+  // Programs are stored in chunks which are never moved or freed while the
+  // cache is alive, so that they can be looked up by handle without a lock.
+  static constexpr int kChunkSize = 64;
+  static constexpr int kMaxChunks = 1024;
+
+  struct Entry {
+    BefBuffer bef_buffer;
+    CachedBEF cached_bef;
+  };
+  using Chunk = std::array<std::atomic<Entry*>, kChunkSize>;
+
   HostContext* host_;
 
   mutex cached_bef_mutex_;
-  // Map from the program name to the CachedBEF.
-  std::unordered_map<std::string, std::pair<BefBuffer, CachedBEF>> cached_bef_
+  // Map from the program name to its handle.
+  std::unordered_map<std::string, uint64_t> handles_
       TFRT_GUARDED_BY(cached_bef_mutex_);
+  // Entry of the program with handle `h` is at index `h - 1`.
+  std::array<std::atomic<Chunk*>, kMaxChunks> chunks_{};
+  uint64_t num_entries_ TFRT_GUARDED_BY(cached_bef_mutex_) = 0;
 };
 
 }  // namespace tfrt
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Payload Codec
+//
+// This file declares the codecs which compress the payloads of SendDataRequest.
+
+#ifndef TFRT_DISTRIBUTED_RUNTIME_PAYLOAD_CODEC_H_
+#define TFRT_DISTRIBUTED_RUNTIME_PAYLOAD_CODEC_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+#include "tfrt/distributed_runtime/payload.h"
+#include "tfrt/distributed_runtime/proto/remote_message.pb.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+
+// Returns whether `codec` loses information. Lossy codecs only apply to
+// float32 data.
+bool IsLossyPayloadCodec(PayloadCodec codec);
+
+// Encodes `data` with `codec` and appends the result to `output`.
+Error EncodePayload(PayloadCodec codec, string_view data, std::string* output);
+
+// Decodes `data`, which was encoded with `codec`, into a new buffer.
+Expected<RCReference<HostBuffer>> DecodePayload(PayloadCodec codec,
+                                                string_view data,
+                                                size_t alignment,
+                                                HostAllocator* allocator);
+
+// Sets `data` as the only payload of `request`, encoded with `codec`. If the
+// codec fails, or a lossless codec does not make `data` smaller, it is sent
+// unencoded instead.
+void SetPayload(PayloadCodec codec, string_view data, SendDataRequest* request);
+
+// Decodes the payloads of `request`.
+Expected<Payload> DecodePayloads(const SendDataRequest& request,
+                                 size_t alignment, HostAllocator* allocator);
+
+// GradientCompressor encodes float32 gradients with a lossy codec and error
+// feedback: the compression error of a gradient is added to the next gradient
+// sent under the same key, so that it is delayed instead of lost. It keeps one
+// float32 residual per key for its lifetime.
+class GradientCompressor {
+ public:
+  explicit GradientCompressor(PayloadCodec codec) : codec_(codec) {}
+  GradientCompressor(const GradientCompressor&) = delete;
+  GradientCompressor& operator=(const GradientCompressor&) = delete;
+
+  PayloadCodec codec() const { return codec_; }
+
+  // Sets the float32 values in `data` as the only payload of `request`.
+  // Calls with the same `key` must not run concurrently.
+  void SetPayload(string_view key, string_view data, SendDataRequest* request);
+
+ private:
+  const PayloadCodec codec_;
+
+  mutex mu_;
+  // StringMap values have stable addresses, so a residual can be updated after
+  // releasing the lock.
+  llvm::StringMap<std::vector<float>> residuals_ TFRT_GUARDED_BY(mu_);
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_DISTRIBUTED_RUNTIME_PAYLOAD_CODEC_H_
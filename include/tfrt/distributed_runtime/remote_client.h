@@ -21,6 +21,7 @@
 
 #include "llvm/ADT/FunctionExtras.h"
 #include "llvm/Support/Error.h"
+#include "tfrt/distributed_runtime/payload.h"
 #include "tfrt/distributed_runtime/proto/remote_message.pb.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/mutex.h"
@@ -136,6 +137,14 @@ class RemoteClientInterface {
   CLIENT_METHOD(KeepAlive);
 
 #undef CLIENT_METHOD
+
+  // Send `payload` to `instance_key` in the DistributedContext `context_id` on
+  // the remote task. The default implementation copies the payload buffers
+  // into a SendDataRequest. Clients that can move host buffers without
+  // serialization (e.g. to tasks in the same process) override it.
+  virtual void SendPayloadAsync(RemoteCallContext* call_ctx,
+                                uint64_t context_id, string_view instance_key,
+                                Payload payload, CallbackFn done);
 };
 
 }  // namespace tfrt
@@ -21,8 +21,12 @@
 #ifndef TFRT_DISTRIBUTED_RUNTIME_REMOTE_EXECUTE_H_
 #define TFRT_DISTRIBUTED_RUNTIME_REMOTE_EXECUTE_H_
 
+#include <cstdint>
+#include <string>
+
 #include "llvm/ADT/SmallVector.h"
 #include "tfrt/host_context/device.h"
+#include "tfrt/support/string_util.h"
 
 namespace tfrt {
 // A specification for remote_execute kernel calls.
@@ -35,6 +39,13 @@ struct RemoteExecuteSpec {
   llvm::SmallVector<RCReference<Device>, 4> output_devices;
 };
 
+// Returns the instance key under which the metadata of the remote execute
+// output with the given id is streamed back to the caller.
+inline std::string RemoteExecuteOutputKey(uint64_t prefix_id,
+                                          uint64_t local_id) {
+  return StrCat("remote_execute_output:", prefix_id, ":", local_id);
+}
+
 }  // namespace tfrt
 
 #endif  // TFRT_DISTRIBUTED_RUNTIME_REMOTE_EXECUTE_H_
\ No newline at end of file
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Remote Input Cache
+//
+// This file declares RemoteInputCache, which tracks the inputs pushed with
+// RemoteExecute requests that the remote tasks keep, and RemoteInputStore,
+// which keeps these inputs on the remote task.
+
+#ifndef TFRT_DISTRIBUTED_RUNTIME_REMOTE_INPUT_CACHE_H_
+#define TFRT_DISTRIBUTED_RUNTIME_REMOTE_INPUT_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "tfrt/distributed_runtime/remote_object.h"
+#include "tfrt/distributed_runtime/task_handle.h"
+#include "tfrt/host_context/async_value.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+
+// RemoteInputCache lets a task push an input that is read by many requests,
+// e.g. a parameter read every step, to a remote task once, and refer to it by
+// key in the later RemoteExecute requests to that task. Remote objects are
+// immutable, and a new version of a value gets a new id, so cached inputs
+// never go stale; they are dropped when they are deleted or evicted.
+//
+// The size of the inputs that each remote task keeps is bounded by the
+// capacity; the least recently used inputs are evicted first. The remote task
+// learns about the evicted keys with the next request it gets.
+//
+// An input is referred to by key only after the request that pushed it
+// succeeded, and is evicted only when no request that refers to it is in
+// flight, so that the remote task has every input a request refers to
+// regardless of the order in which it handles the requests.
+class RemoteInputCache {
+ public:
+  enum class Action {
+    // Push the input without caching it.
+    kPush,
+    // Push the input, and ask the remote task to keep it under the key.
+    kPushAndCache,
+    // The remote task keeps the input under the key; don't push it.
+    kReference,
+  };
+
+  struct Decision {
+    Action action;
+    // The cache key, or 0 for kPush.
+    uint64_t key;
+  };
+
+  explicit RemoteInputCache(size_t capacity_bytes)
+      : capacity_bytes_(capacity_bytes) {}
+  RemoteInputCache(const RemoteInputCache&) = delete;
+  RemoteInputCache& operator=(const RemoteInputCache&) = delete;
+
+  // Decides how to send the input `id` of `size_bytes` bytes to `task`. Unless
+  // the action is kPush, the key must be released with Release() when the
+  // request completes.
+  Decision Acquire(TaskHandle task, const RemoteObjectId& id,
+                   size_t size_bytes);
+
+  // Releases the `key` acquired for a request to `task`. If the request
+  // failed, the input is dropped, since the remote task might not keep it.
+  void Release(TaskHandle task, uint64_t key, bool ok);
+
+  // Returns the keys evicted from `task` since the last call, which must be
+  // sent with the next request to `task`.
+  std::vector<uint64_t> TakeEvictedKeys(TaskHandle task);
+
+  // Drops the input `id` from all tasks, e.g. when the object is deleted.
+  void Erase(const RemoteObjectId& id);
+
+ private:
+  using ObjectKey = std::pair<uint64_t, uint64_t>;
+
+  struct CachedInput {
+    ObjectKey id;
+    uint64_t key;
+    size_t size_bytes;
+    // Number of requests in flight that push or refer to the input.
+    int num_pending = 0;
+    // Set when a request that pushed the input succeeded.
+    bool resident = false;
+    // Set when the input must be dropped once no request is in flight.
+    bool dropped = false;
+  };
+
+  struct TaskCache {
+    size_t size_bytes = 0;
+    // Most recently used first.
+    std::list<CachedInput> inputs;
+    llvm::DenseMap<ObjectKey, std::list<CachedInput>::iterator> by_id;
+    llvm::DenseMap<uint64_t, std::list<CachedInput>::iterator> by_key;
+    std::vector<uint64_t> evicted_keys;
+  };
+
+  // Removes `it`, which must not be in flight, from `cache`.
+  static void Evict(TaskCache* cache, std::list<CachedInput>::iterator it);
+
+  const size_t capacity_bytes_;
+
+  mutex mu_;
+  uint64_t next_key_ TFRT_GUARDED_BY(mu_) = 1;
+  llvm::DenseMap<TaskHandle, TaskCache> tasks_ TFRT_GUARDED_BY(mu_);
+};
+
+// RemoteInputStore keeps the inputs that other tasks pushed with RemoteExecute
+// requests and asked to cache, under the id of the sender and the cache key
+// the sender picked.
+class RemoteInputStore {
+ public:
+  RemoteInputStore() = default;
+  RemoteInputStore(const RemoteInputStore&) = delete;
+  RemoteInputStore& operator=(const RemoteInputStore&) = delete;
+
+  void Insert(uint64_t sender_id, uint64_t key, RCReference<AsyncValue> value);
+
+  // Returns the input with the given key, or nullptr if there is none.
+  RCReference<AsyncValue> Find(uint64_t sender_id, uint64_t key);
+
+  // Drops the inputs with the given keys. Unknown keys are ignored.
+  void Erase(uint64_t sender_id, ArrayRef<uint64_t> keys);
+
+ private:
+  mutex mu_;
+  llvm::DenseMap<std::pair<uint64_t, uint64_t>, RCReference<AsyncValue>>
+      inputs_ TFRT_GUARDED_BY(mu_);
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_DISTRIBUTED_RUNTIME_REMOTE_INPUT_CACHE_H_
@@ -21,6 +21,7 @@
 #ifndef TFRT_DISTRIBUTED_RUNTIME_REMOTE_OBJECT_MANAGER_H_
 #define TFRT_DISTRIBUTED_RUNTIME_REMOTE_OBJECT_MANAGER_H_
 
+#include <array>
 #include <unordered_map>
 
 #include "llvm/ADT/DenseMap.h"
@@ -29,6 +30,8 @@
 #include "tfrt/distributed_runtime/remote_object.h"
 #include "tfrt/distributed_runtime/task_handle.h"
 #include "tfrt/host_context/async_value.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
 
 namespace tfrt {
 class RemoteObjectManager {
@@ -53,6 +56,10 @@ class RemoteObjectManager {
   // objects input to the remote_execute.
   RCReference<AsyncValue> GetRemoteObject(const RemoteObjectId& id);
 
+  // Retrieve Remote Object with given id if it is stored locally, or nullptr.
+  // Unlike GetRemoteObject, this doesn't create a placeholder for it.
+  RCReference<AsyncValue> FindRemoteObject(const RemoteObjectId& id);
+
   // Delete the given remote object ids.
   Error DeleteRemoteObjects(const llvm::SmallVectorImpl<RemoteObjectId>& ids);
 
@@ -61,10 +68,19 @@ class RemoteObjectManager {
   const uint64_t prefix_id_;
   HostContext* host_context_;
 
-  tfrt::mutex mutex_;
+  // Objects are sharded by id, so that concurrent requests looking up
+  // different objects don't contend on one lock.
+  static constexpr int kNumShards = 16;
+
+  struct alignas(64) Shard {
+    tfrt::mutex mutex;
+    llvm::DenseMap<RemoteObjectId, RCReference<AsyncValue>> object_maps
+        TFRT_GUARDED_BY(mutex);
+  };
+
+  Shard& GetShard(const RemoteObjectId& id);
 
-  llvm::DenseMap<RemoteObjectId, RCReference<AsyncValue>> object_maps_
-      TFRT_GUARDED_BY(mutex_);
+  std::array<Shard, kNumShards> shards_;
 };
 }  // namespace tfrt
 namespace llvm {
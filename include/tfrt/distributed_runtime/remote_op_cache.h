@@ -0,0 +1,72 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Remote Op Cache
+//
+// This file declares RemoteOpCache, which caches the ops executed from remote
+// RemoteExecuteOp requests.
+
+#ifndef TFRT_DISTRIBUTED_RUNTIME_REMOTE_OP_CACHE_H_
+#define TFRT_DISTRIBUTED_RUNTIME_REMOTE_OP_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tfrt/core_runtime/core_runtime_op.h"
+#include "tfrt/core_runtime/op_attrs.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+
+// RemoteOpCache keeps the ops that clients registered with a RemoteExecuteOp
+// request, so that later requests can refer to the op and its attributes by
+// handle instead of sending them again, and don't resolve the op again.
+class RemoteOpCache {
+ public:
+  // An op resolved on its op handler, with frozen attributes.
+  struct CachedOp {
+    CachedOp(std::string op_name, CoreRuntimeOp op, OpAttrsRef attrs)
+        : op_name(std::move(op_name)),
+          op(std::move(op)),
+          attrs(std::move(attrs)) {}
+
+    const std::string op_name;
+    const CoreRuntimeOp op;
+    const OpAttrsRef attrs;
+  };
+
+  RemoteOpCache() = default;
+  RemoteOpCache(const RemoteOpCache&) = delete;
+  RemoteOpCache& operator=(const RemoteOpCache&) = delete;
+
+  // Caches `op` and returns its handle, which is never 0. Cached ops live as
+  // long as the cache.
+  uint64_t Register(std::unique_ptr<CachedOp> op);
+
+  // Returns the op with the given handle, or nullptr if there is none.
+  const CachedOp* Lookup(uint64_t handle);
+
+ private:
+  mutex mu_;
+  // The handle of an op is its index plus one.
+  std::vector<std::unique_ptr<CachedOp>> ops_ TFRT_GUARDED_BY(mu_);
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_DISTRIBUTED_RUNTIME_REMOTE_OP_CACHE_H_
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Latency breakdown tracing of remote calls
+//
+// This file declares helpers to trace remote execute calls across the client
+// and the server. The client sends a TraceContext with the request, and the
+// server returns the ServerTiming of the call with the response. Both record a
+// tracing event tagged with the trace id, so that the client and server traces
+// of a call can be joined, and the client event breaks the latency of the call
+// down into serialization, network, queueing, execution and response time.
+
+#ifndef TFRT_DISTRIBUTED_RUNTIME_REMOTE_TRACE_H_
+#define TFRT_DISTRIBUTED_RUNTIME_REMOTE_TRACE_H_
+
+#include <cstdint>
+
+#include "llvm/ADT/FunctionExtras.h"
+#include "llvm/Support/Error.h"
+#include "tfrt/distributed_runtime/proto/remote_message.pb.h"
+#include "tfrt/support/forward_decls.h"
+
+namespace tfrt {
+
+// Returns the wall time in microseconds, used for the ServerTiming.
+int64_t RemoteTraceMicros();
+
+// Client side trace of one remote call. The trace is only active if tracing is
+// enabled when it is constructed, otherwise all methods are no-ops.
+class RemoteCallTrace {
+ public:
+  RemoteCallTrace();
+
+  bool IsActive() const { return trace_id_ != 0; }
+
+  // Sets the trace context of the request, and records that the request has
+  // been serialized and is being sent. Only call it on active traces, as
+  // requests with a trace context are traced by the server.
+  void StartCall(TraceContext* trace_context);
+
+  // Records the tracing event of the call named `name` once the response
+  // has been received.
+  void FinishCall(string_view name, const ServerTiming& server_timing);
+
+ private:
+  uint64_t trace_id_ = 0;
+  int64_t start_us_ = 0;
+  int64_t send_us_ = 0;
+};
+
+// Wraps the `done` callback of a remote call handled by the server. Stamps the
+// receive time (unless the request was already stamped when it was queued) and
+// the start time into `server_timing`. The returned callback stamps the send
+// time and records the tracing event of the call before invoking `done`. The
+// handler stamps the end time once the results are computed.
+llvm::unique_function<void(llvm::Error)> TraceServerCall(
+    string_view name, const TraceContext& trace_context,
+    ServerTiming* server_timing,
+    llvm::unique_function<void(llvm::Error)> done);
+
+}  // namespace tfrt
+
+#endif  // TFRT_DISTRIBUTED_RUNTIME_REMOTE_TRACE_H_
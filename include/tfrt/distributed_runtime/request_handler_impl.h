@@ -23,11 +23,24 @@
 
 namespace tfrt {
 
+class HostContext;
 class ServerContext;
 
 std::unique_ptr<RequestHandlerInterface> NewRequestHandler(
     ServerContext* server_context);
 
+// Returns a request handler which bounds the execute requests (RemoteExecute,
+// RemoteExecuteOp and RegisterFunction) that `handler` processes concurrently
+// for each distributed context. Execute requests beyond
+// `max_inflight_execute_requests` wait in a queue in arrival order, and are
+// rejected with ResourceExhausted once `max_queued_execute_requests` are
+// waiting. All other requests are control requests, such as KeepAlive and
+// SendData, and are passed to `handler` right away, so that a burst of
+// executes can't delay them.
+std::unique_ptr<RequestHandlerInterface> NewAdmissionControlRequestHandler(
+    HostContext* host, std::unique_ptr<RequestHandlerInterface> handler,
+    int max_inflight_execute_requests, int max_queued_execute_requests);
+
 }  // namespace tfrt
 
 #endif  // TFRT_DISTRIBUTED_RUNTIME_REQUEST_HANDLER_IMPL_H_
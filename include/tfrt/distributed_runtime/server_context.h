@@ -44,6 +44,13 @@ struct ServerContextConfiguration {
 
   // Timeout for garbage collecting inactive distributed contexts.
   int context_gc_timeout_secs = 600;
+
+  // Maximum number of execute requests processed concurrently for one
+  // distributed context, and maximum number of execute requests waiting for
+  // them. Execute requests beyond both are rejected with ResourceExhausted.
+  // Admission control is disabled if `max_inflight_execute_requests` is 0.
+  int max_inflight_execute_requests = 256;
+  int max_queued_execute_requests = 4096;
 };
 
 // ServerContext constructs and owns fabric communicators.
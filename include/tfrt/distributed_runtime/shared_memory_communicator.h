@@ -0,0 +1,58 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Shared Memory Fabric Communicator
+//
+// This file declares a fabric communicator for tasks running in the same
+// process, which passes requests and tensor payloads without serialization.
+
+#ifndef TFRT_DISTRIBUTED_RUNTIME_SHARED_MEMORY_COMMUNICATOR_H_
+#define TFRT_DISTRIBUTED_RUNTIME_SHARED_MEMORY_COMMUNICATOR_H_
+
+#include <memory>
+
+#include "tfrt/distributed_runtime/fabric_communicator.h"
+
+namespace tfrt {
+
+// Fabric communicator type registered for SharedMemoryFabricCommunicator.
+inline constexpr char kSharedMemoryCommunicatorType[] = "shared_memory";
+
+// SharedMemoryFabricCommunicator connects server contexts in the same process
+// (e.g. co-located tasks of a pipeline-parallel job). Each communicator is
+// reachable by the server address of its server context, and remote clients
+// call the request handler of the peer server context directly.
+//
+// Payloads sent with RemoteClientInterface::SendPayloadAsync() are not copied:
+// the receiver gets references to the same host buffers, so the sender must
+// not modify them after sending.
+class SharedMemoryFabricCommunicator : public FabricCommunicator {
+ public:
+  explicit SharedMemoryFabricCommunicator(ServerContext* server_context);
+  ~SharedMemoryFabricCommunicator() override;
+
+  std::unique_ptr<RemoteClientInterface> CreateRemoteClient(
+      DistributedContext* dist_context, TaskHandle task_handle) override;
+
+ private:
+  const std::string server_address_;
+};
+
+FabricCommunicator* CreateSharedMemoryFabricCommunicator(
+    ServerContext* server_context);
+
+}  // namespace tfrt
+
+#endif  // TFRT_DISTRIBUTED_RUNTIME_SHARED_MEMORY_COMMUNICATOR_H_
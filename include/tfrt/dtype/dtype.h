@@ -26,10 +26,12 @@
 #include <type_traits>
 
 #include "llvm/Support/raw_ostream.h"
+#include "tfrt/dtype/int4.h"
 #include "tfrt/dtype/quantized_types.h"
 #include "tfrt/support/bf16.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/fp16.h"
+#include "tfrt/support/fp8.h"
 
 namespace tfrt {
 
@@ -45,8 +47,20 @@ enum class DType : uint8_t {
 };
 
 // Return the size of one value of this dtype when represented on the host.
+// For the packed dtypes, this is the size of a single unpacked value; use
+// GetHostSizeInBytes() for the size of a buffer of values.
 size_t GetHostSize(DType dtype);
 
+// Return the number of bits of one value of this dtype in a host tensor.
+size_t GetHostSizeInBits(DType dtype);
+
+// Return whether several values of this dtype are packed in one byte of a host
+// tensor.
+bool IsPacked(DType dtype);
+
+// Return the size of a host buffer of `num_elements` values of this dtype.
+size_t GetHostSizeInBytes(DType dtype, size_t num_elements);
+
 // Return the alignment of this dtype when represented on the host.
 size_t GetHostAlignment(DType dtype);
 
@@ -111,21 +125,27 @@ struct IsDTypeTriviallyCopyable<UnsupportedDataType<dtype>> : std::false_type {
     return DType{DType::ENUM};                  \
   }
 
-#define TFRT_DEFINE_DTYPE(ENUM, CPP_TYPE, NAME)        \
-  TFRT_REGISTER_DTYPE(CPP_TYPE, ENUM)                  \
-  template <>                                          \
-  struct DTypeData<DType::ENUM> {                      \
-    static constexpr DType kDType{DType::ENUM};        \
-    using Type = CPP_TYPE;                             \
-    static constexpr const char *kName = NAME;         \
-    static constexpr bool kIsTriviallyCopyable =       \
-        detail::IsDTypeTriviallyCopyable<CPP_TYPE>();  \
-    static constexpr size_t kByteSize =                \
-        kIsTriviallyCopyable ? sizeof(CPP_TYPE) : -1;  \
-    static constexpr size_t kAlignment =               \
-        kIsTriviallyCopyable ? alignof(CPP_TYPE) : -1; \
+#define TFRT_DEFINE_DTYPE_WITH_BITS(ENUM, CPP_TYPE, NAME, BITS) \
+  TFRT_REGISTER_DTYPE(CPP_TYPE, ENUM)                           \
+  template <>                                                   \
+  struct DTypeData<DType::ENUM> {                               \
+    static constexpr DType kDType{DType::ENUM};                 \
+    using Type = CPP_TYPE;                                      \
+    static constexpr const char *kName = NAME;                  \
+    static constexpr bool kIsTriviallyCopyable =                \
+        detail::IsDTypeTriviallyCopyable<CPP_TYPE>();           \
+    static constexpr size_t kByteSize =                         \
+        kIsTriviallyCopyable ? sizeof(CPP_TYPE) : -1;           \
+    static constexpr size_t kAlignment =                        \
+        kIsTriviallyCopyable ? alignof(CPP_TYPE) : -1;          \
+    static constexpr size_t kBitSize = BITS;                    \
   };
 
+#define TFRT_DEFINE_DTYPE(ENUM, CPP_TYPE, NAME) \
+  TFRT_DEFINE_DTYPE_WITH_BITS(                  \
+      ENUM, CPP_TYPE, NAME,                     \
+      detail::IsDTypeTriviallyCopyable<CPP_TYPE>() ? 8 * sizeof(CPP_TYPE) : -1)
+
 // LINT.IfChange
 TFRT_DEFINE_DTYPE(UI8, uint8_t, "u8")
 TFRT_DEFINE_DTYPE(UI16, uint16_t, "u16")
@@ -151,6 +171,10 @@ TFRT_DEFINE_DTYPE(QUI16, quint16, "qu16")
 TFRT_DEFINE_DTYPE(QI8, qint8, "qi8")
 TFRT_DEFINE_DTYPE(QI16, qint16, "qi16")
 TFRT_DEFINE_DTYPE(QI32, qint32, "qi32")
+TFRT_DEFINE_DTYPE_WITH_BITS(I4, int4, "i4", 4)
+TFRT_DEFINE_DTYPE_WITH_BITS(UI4, uint4, "u4", 4)
+TFRT_DEFINE_DTYPE(F8E4M3FN, f8e4m3fn, "f8e4m3fn")
+TFRT_DEFINE_DTYPE(F8E5M2, f8e5m2, "f8e5m2")
 
 TFRT_DEFINE_DTYPE(Resource, detail::UnsupportedDataType<DType::Resource>,
                   "resource")
@@ -160,6 +184,7 @@ TFRT_DEFINE_DTYPE(Variant, detail::UnsupportedDataType<DType::Variant>,
 // LINT.ThenChange(//depot/tf_runtime/include/tfrt/dtype/dtype.def)
 
 #undef TFRT_DEFINE_DTYPE
+#undef TFRT_DEFINE_DTYPE_WITH_BITS
 
 // Dispatch to an overload of function f based on the given dtype.
 //
@@ -193,6 +218,24 @@ LLVM_ATTRIBUTE_ALWAYS_INLINE size_t GetHostAlignment(DType dtype) {
   return DispatchByDType(dtype, [](auto d) { return d.kAlignment; });
 }
 
+LLVM_ATTRIBUTE_ALWAYS_INLINE size_t GetHostSizeInBits(DType dtype) {
+  return DispatchByDType(dtype, [](auto d) { return d.kBitSize; });
+}
+
+LLVM_ATTRIBUTE_ALWAYS_INLINE bool IsPacked(DType dtype) {
+  return DispatchByDType(dtype, [](auto d) {
+    return d.kIsTriviallyCopyable && d.kBitSize < 8 * d.kByteSize;
+  });
+}
+
+LLVM_ATTRIBUTE_ALWAYS_INLINE size_t GetHostSizeInBytes(DType dtype,
+                                                       size_t num_elements) {
+  if (IsPacked(dtype)) {
+    return (GetHostSizeInBits(dtype) * num_elements + 7) / 8;
+  }
+  return GetHostSize(dtype) * num_elements;
+}
+
 LLVM_ATTRIBUTE_ALWAYS_INLINE bool IsTriviallyCopyable(DType dtype) {
   return DispatchByDType(dtype, [](auto d) { return d.kIsTriviallyCopyable; });
 }
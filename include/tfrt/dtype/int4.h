@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file defines the 4-bit integer types int4 and uint4, and the helpers
+// to access them in packed storage.
+
+#ifndef TFRT_DTYPE_INT4_H_
+#define TFRT_DTYPE_INT4_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/support/forward_decls.h"
+
+namespace tfrt {
+
+// A 4-bit integer. A single value is stored in the low bits of a byte, but
+// tensors of 4-bit integers are packed, two values per byte: the value at
+// even index 2 * i is in the low nibble of byte i, and the value at index
+// 2 * i + 1 in its high nibble. Use GetPackedInt4() and SetPackedInt4() to
+// access them.
+template <bool Signed>
+struct Int4 {
+  using UnderlyingT = std::conditional_t<Signed, int8_t, uint8_t>;
+
+  static constexpr int kMin = Signed ? -8 : 0;
+  static constexpr int kMax = Signed ? 7 : 15;
+
+  Int4() : value(0) {}
+  explicit Int4(UnderlyingT v) : value(v) {}
+
+  UnderlyingT value;
+};
+
+// Print Int4 in format as type(value), e.g. i4(-2).
+template <bool Signed>
+raw_ostream& operator<<(raw_ostream& os, Int4<Signed> in) {
+  return os << (Signed ? "i4(" : "u4(") << +in.value << ')';
+}
+
+using int4 = Int4<true>;
+using uint4 = Int4<false>;
+
+// Returns the value at `index` of the packed 4-bit integers at `data`.
+template <typename T>
+T GetPackedInt4(const void* data, size_t index) {
+  uint8_t byte = static_cast<const uint8_t*>(data)[index / 2];
+  uint8_t nibble = (index % 2 == 0) ? (byte & 0x0f) : (byte >> 4);
+  // Sign-extend the nibble of signed integers.
+  if (std::is_signed<typename T::UnderlyingT>::value) {
+    return T(static_cast<int8_t>(static_cast<int8_t>(nibble << 4) >> 4));
+  }
+  return T(nibble);
+}
+
+// Sets the value at `index` of the packed 4-bit integers at `data`.
+template <typename T>
+void SetPackedInt4(void* data, size_t index, T value) {
+  uint8_t& byte = static_cast<uint8_t*>(data)[index / 2];
+  uint8_t nibble = static_cast<uint8_t>(value.value) & 0x0f;
+  if (index % 2 == 0) {
+    byte = (byte & 0xf0) | nibble;
+  } else {
+    byte = (byte & 0x0f) | static_cast<uint8_t>(nibble << 4);
+  }
+}
+
+}  // namespace tfrt
+
+#endif  // TFRT_DTYPE_INT4_H_
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares AdmissionController, which bounds the number of requests
+// executing at the same time.
+
+#ifndef TFRT_HOST_CONTEXT_ADMISSION_CONTROLLER_H_
+#define TFRT_HOST_CONTEXT_ADMISSION_CONTROLLER_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <utility>
+
+#include "llvm/Support/Error.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/task_function.h"
+#include "tfrt/metrics/metrics.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+
+class AdmissionController;
+class HostContext;
+
+// A slot for one in-flight request. The slot is released when the token is
+// destroyed. A RequestContext built with a token keeps it until the request is
+// finished, i.e. until the last reference to the RequestContext is dropped.
+class AdmissionToken {
+ public:
+  AdmissionToken() = default;
+  AdmissionToken(AdmissionToken&& other)
+      : controller_(std::exchange(other.controller_, nullptr)) {}
+  AdmissionToken& operator=(AdmissionToken&& other) {
+    Release();
+    controller_ = std::exchange(other.controller_, nullptr);
+    return *this;
+  }
+  ~AdmissionToken() { Release(); }
+
+  explicit operator bool() const { return controller_ != nullptr; }
+
+ private:
+  friend class AdmissionController;
+
+  explicit AdmissionToken(AdmissionController* controller)
+      : controller_(controller) {}
+
+  void Release();
+
+  AdmissionController* controller_ = nullptr;
+};
+
+struct AdmissionOptions {
+  // Maximum number of requests in flight.
+  int max_in_flight = 64;
+
+  // Maximum number of requests waiting for admission in Admit(). When the
+  // queue is full, a new request evicts the most recently queued request of a
+  // lower priority, or is rejected if there is none.
+  size_t max_queued = 128;
+
+  // Queued requests which waited longer than this are rejected when their
+  // turn comes, so that the backlog of an overload is shed instead of being
+  // served late.
+  std::chrono::microseconds max_queue_delay = std::chrono::milliseconds(100);
+};
+
+// Admission control for the requests of a server, to degrade gracefully under
+// overload instead of queueing unbounded work in the work queue. Requests are
+// either admitted immediately with TryAdmit(), which rejects the request if
+// all slots are taken, or queued with Admit(), which admits waiting requests
+// in the order of their priority as slots are released. Rejected requests
+// fail with a ResourceExhausted error.
+//
+// The controller exports the metrics /tfrt/admission/<name>/{admitted,
+// rejected, queued, in_flight, queue_delay_us}.
+//
+// Sample usage:
+//
+//   AdmissionController controller(host, "serving", AdmissionOptions());
+//   auto request_ctx = RequestContextBuilder(host, resource_ctx)
+//                          .set_admission_controller(&controller)
+//                          .build();
+//   if (!request_ctx) ...  // Rejected, the server is overloaded.
+class AdmissionController {
+ public:
+  AdmissionController(HostContext* host, string_view name,
+                      AdmissionOptions options);
+
+  // All tokens must have been destroyed. Queued requests are rejected.
+  ~AdmissionController();
+
+  AdmissionController(const AdmissionController&) = delete;
+  AdmissionController& operator=(const AdmissionController&) = delete;
+
+  // Admits a request of `priority` if a slot is free and no request of the
+  // same or a higher priority is queued. Otherwise returns an error.
+  Expected<AdmissionToken> TryAdmit(TaskPriority priority);
+
+  // Admits a request of `priority`, or queues it until a slot is free. The
+  // returned token is an error if the request is rejected. Queued requests are
+  // admitted on the work queue of the HostContext.
+  AsyncValueRef<AdmissionToken> Admit(TaskPriority priority);
+
+  int in_flight() const;
+  size_t queued() const;
+
+ private:
+  friend class AdmissionToken;
+
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr int kNumPriorities =
+      static_cast<int>(TaskPriority::kLow) + 1;
+
+  struct Waiter {
+    AsyncValueRef<AdmissionToken> token;
+    Clock::time_point enqueue_time;
+  };
+
+  bool HasWaiters(TaskPriority priority) const TFRT_REQUIRES(mu_);
+
+  // Releases a slot, and passes it to the next queued request if any.
+  void Release();
+
+  void Reject(AsyncValueRef<AdmissionToken> token, string_view reason);
+
+  HostContext* const host_;
+  const std::string name_;
+  const AdmissionOptions options_;
+
+  mutable mutex mu_;
+  int in_flight_ TFRT_GUARDED_BY(mu_) = 0;
+  // Queued requests by priority, oldest first.
+  std::array<std::deque<Waiter>, kNumPriorities> waiters_ TFRT_GUARDED_BY(mu_);
+  size_t num_waiters_ TFRT_GUARDED_BY(mu_) = 0;
+
+  metrics::Counter* const admitted_metric_;
+  metrics::Counter* const rejected_metric_;
+  metrics::Counter* const queued_metric_;
+  metrics::Gauge<int64_t>* const in_flight_metric_;
+  metrics::Histogram* const queue_delay_metric_;
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_HOST_CONTEXT_ADMISSION_CONTROLLER_H_
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Bump pointer arena allocator
+//
+// This file declares ArenaAllocator, a HostAllocator that releases all of its
+// memory at once.
+
+#ifndef TFRT_HOST_CONTEXT_ARENA_ALLOCATOR_H_
+#define TFRT_HOST_CONTEXT_ARENA_ALLOCATOR_H_
+
+#include <atomic>
+#include <cstddef>
+
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/ref_count.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+
+// ArenaAllocator is a thread-safe bump pointer allocator. Memory is allocated
+// from large blocks obtained from the underlying allocator, and deallocation of
+// individual allocations is a no-op. All blocks are released together when the
+// arena is destroyed.
+//
+// ArenaAllocator is reference counted, and every allocation holds a reference
+// to the arena until it is deallocated. This keeps the arena memory alive for
+// allocations that outlive the owner of the arena (e.g. a tensor returned from
+// a request that allocated it in the request arena).
+class ArenaAllocator : public HostAllocator,
+                       public ReferenceCounted<ArenaAllocator> {
+ public:
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+  // `allocator` is used to allocate arena blocks and must outlive the arena.
+  explicit ArenaAllocator(HostAllocator* allocator,
+                          size_t block_size = kDefaultBlockSize);
+  ~ArenaAllocator() override;
+
+  void* AllocateBytes(size_t size, size_t alignment) override;
+
+  // Individual allocations are freed only when the arena is destroyed.
+  void DeallocateBytes(void* ptr, size_t size) override { DropRef(); }
+
+  // Returns the total size of arena blocks allocated so far.
+  size_t allocated_bytes() const {
+    return allocated_bytes_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  friend class ReferenceCounted<ArenaAllocator>;
+
+  struct Block {
+    Block* next;
+    size_t size;
+    std::atomic<size_t> offset;
+    // Block data immediately follows the block header.
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+  };
+
+  // Tries to bump allocate `size` bytes from `block`, returns nullptr if the
+  // block does not have enough space.
+  static void* TryAllocate(Block* block, size_t size, size_t alignment);
+
+  // Allocates `size` bytes from the current block if it was replaced by another
+  // thread, or from a new block. Returns nullptr on allocation failure.
+  void* AllocateSlow(Block* block, size_t size, size_t alignment);
+
+  // Allocates a new block with `size` bytes of data and links it into the list
+  // of all blocks. Returns nullptr if the underlying allocator fails.
+  Block* NewBlock(size_t size) TFRT_REQUIRES(mu_);
+
+  void Destroy() { delete this; }
+
+  HostAllocator* const allocator_;
+  const size_t block_size_;
+
+  // The block used for bump allocation.
+  std::atomic<Block*> current_{nullptr};
+  std::atomic<size_t> allocated_bytes_{0};
+
+  mutex mu_;
+  // Singly linked list of all blocks owned by this arena.
+  Block* blocks_ TFRT_GUARDED_BY(mu_) = nullptr;
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_HOST_CONTEXT_ARENA_ALLOCATOR_H_
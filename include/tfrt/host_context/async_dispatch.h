@@ -97,10 +97,36 @@ inline void Await(ArrayRef<RCReference<AsyncValue>> rc_refs) {
 void Await(const ExecutionContext& exec_ctx,
            ArrayRef<RCReference<AsyncValue>> values);
 
-// Add some non-blocking work to the work_queue used by the ExecutionContext.
+// Add some non-blocking work to the work_queue used by the ExecutionContext,
+// with the priority of the request that owns the ExecutionContext.
 void EnqueueWork(const ExecutionContext& exec_ctx,
                  llvm::unique_function<void()> work);
 
+// Same as above, but for work that continues the work of the current thread,
+// e.g. processes a value the current thread has just produced. If the current
+// thread is a worker thread, the work queue can run `work` in it right after
+// the current task (see ConcurrentWorkQueue::AddNextTask), so the caller must
+// not wait for `work`. Work of non-default priority, and work enqueued while an
+// EnqueueWorkBatch is alive, is enqueued as with EnqueueWork().
+void EnqueueNextWork(const ExecutionContext& exec_ctx,
+                     llvm::unique_function<void()> work);
+
+// While an EnqueueWorkBatch is alive, non-blocking work enqueued by the current
+// thread with EnqueueWork() is kept in a thread local batch, and submitted with
+// ConcurrentWorkQueue::AddTasks() when the outermost batch is destroyed.
+//
+// AsyncValue opens a batch while it runs more than one waiter, so a value that
+// feeds many consumers submits their tasks to the work queue at once. The
+// thread that owns the batch must not wait for the batched work.
+class EnqueueWorkBatch {
+ public:
+  EnqueueWorkBatch();
+  ~EnqueueWorkBatch();
+
+  EnqueueWorkBatch(const EnqueueWorkBatch&) = delete;
+  EnqueueWorkBatch& operator=(const EnqueueWorkBatch&) = delete;
+};
+
 // An overload set that automatically converts llvm::Expected values to the
 // corresponding absl::StatusOr when emplacing async values.
 //
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares AsyncTask, the return type of C++20 coroutines which
+// complete an AsyncValue. Inside such a coroutine, `co_await` on an
+// AsyncValueRef<T>, an RCReference<AsyncValue> or another AsyncTask suspends
+// until the value is available, without allocating a continuation:
+//
+//   AsyncTask<int32_t> AddAsync(AsyncValueRef<int32_t> a,
+//                               AsyncValueRef<int32_t> b,
+//                               ExecutionContext exec_ctx) {
+//     auto x = co_await std::move(a);
+//     auto y = co_await std::move(b);
+//     if (x.IsError()) co_return x.GetError();
+//     if (y.IsError()) co_return y.GetError();
+//     co_return *x + *y;
+//   }
+//
+// A kernel registered with TFRT_KERNEL may return AsyncTask<T> directly; its
+// result becomes the kernel result.
+//
+// The coroutine frame is allocated from the HostAllocator of the HostContext
+// (or ExecutionContext) found in the coroutine arguments, and from the heap if
+// there is none. The coroutine starts running immediately and resumes on the
+// thread which makes the awaited value available, like an AndThen callback.
+// Arguments are copied into the frame, but references are not: coroutines
+// must take AsyncValueRefs and the ExecutionContext by value, not as
+// Argument<T> or const references which dangle after the first suspension.
+//
+// Coroutines require C++20. With older language versions TFRT_HAS_COROUTINES
+// is 0 and this file declares nothing.
+
+#ifndef TFRT_HOST_CONTEXT_ASYNC_TASK_H_
+#define TFRT_HOST_CONTEXT_ASYNC_TASK_H_
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define TFRT_HAS_COROUTINES 1
+#else
+#define TFRT_HAS_COROUTINES 0
+#endif
+
+#if TFRT_HAS_COROUTINES
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdlib>
+#include <type_traits>
+#include <utility>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "llvm/Support/Error.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/string_util.h"
+
+namespace tfrt {
+
+template <typename T>
+class AsyncTask;
+
+namespace internal {
+
+// Allocates coroutine frames from the HostAllocator of the first HostContext*
+// or ExecutionContext argument of the coroutine.
+class CoroutineFrameAllocator {
+ public:
+  template <typename... Args>
+  static void* operator new(size_t size, const Args&... args) {
+    HostContext* host = FindHost(args...);
+    void* ptr = host ? host->AllocateBytes(kHeaderSize + size, kAlignment)
+                     : ::operator new(kHeaderSize + size);
+    *static_cast<HostContext**>(ptr) = host;
+    return static_cast<char*>(ptr) + kHeaderSize;
+  }
+
+  static void operator delete(void* ptr, size_t size) {
+    void* header = static_cast<char*>(ptr) - kHeaderSize;
+    if (HostContext* host = *static_cast<HostContext**>(header))
+      host->DeallocateBytes(header, kHeaderSize + size);
+    else
+      ::operator delete(header);
+  }
+
+ private:
+  // The frame is preceded by the HostContext it was allocated from, padded to
+  // keep the frame aligned.
+  static constexpr size_t kAlignment = alignof(std::max_align_t);
+  static constexpr size_t kHeaderSize = kAlignment;
+
+  static HostContext* FindHost() { return nullptr; }
+
+  template <typename T, typename... Rest>
+  static HostContext* FindHost(const T& arg, const Rest&... rest) {
+    if constexpr (std::is_same_v<T, ExecutionContext>) {
+      return arg.host();
+    } else if constexpr (std::is_convertible_v<T, HostContext*>) {
+      return arg;
+    } else {
+      return FindHost(rest...);
+    }
+  }
+};
+
+// Suspends the awaiting coroutine until `value` is available.
+template <typename Ref>
+class AsyncValueAwaiter {
+ public:
+  explicit AsyncValueAwaiter(Ref value) : value_(std::move(value)) {}
+
+  bool await_ready() const { return GetAsyncValue(value_)->IsAvailable(); }
+  void await_suspend(std::coroutine_handle<> handle) {
+    GetAsyncValue(value_)->AndThen([handle] { handle.resume(); });
+  }
+  Ref await_resume() { return std::move(value_); }
+
+ private:
+  template <typename U>
+  static AsyncValue* GetAsyncValue(const AsyncValueRef<U>& value) {
+    return value.GetAsyncValue();
+  }
+  static AsyncValue* GetAsyncValue(const RCReference<AsyncValue>& value) {
+    return value.get();
+  }
+
+  Ref value_;
+};
+
+}  // namespace internal
+
+// The result of a coroutine which completes an AsyncValueRef<T>. The
+// coroutine returns either a T, which is emplaced into the result, or an
+// error, which is set as the error of the result.
+template <typename T>
+class AsyncTask {
+ public:
+  class promise_type : public internal::CoroutineFrameAllocator {
+   public:
+    AsyncTask get_return_object() { return AsyncTask(result_.CopyRef()); }
+
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    // The frame is destroyed when the coroutine finishes.
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void return_value(Expected<T> value) {
+      if (value)
+        result_.emplace(std::move(*value));
+      else
+        result_.SetError(absl::InternalError(StrCat(value.takeError())));
+    }
+    void return_value(absl::Status status) {
+      result_.SetError(std::move(status));
+    }
+
+    // TFRT is built without exceptions.
+    void unhandled_exception() { std::abort(); }
+
+    template <typename U>
+    auto await_transform(AsyncValueRef<U> value) {
+      return internal::AsyncValueAwaiter<AsyncValueRef<U>>(std::move(value));
+    }
+    auto await_transform(RCReference<AsyncValue> value) {
+      return internal::AsyncValueAwaiter<RCReference<AsyncValue>>(
+          std::move(value));
+    }
+    template <typename U>
+    auto await_transform(AsyncTask<U> task) {
+      return await_transform(std::move(task).result());
+    }
+
+   private:
+    AsyncValueRef<T> result_ = MakeUnconstructedAsyncValueRef<T>();
+  };
+
+  // Returns the value completed by the coroutine.
+  AsyncValueRef<T> result() && { return std::move(result_); }
+
+ private:
+  explicit AsyncTask(AsyncValueRef<T> result) : result_(std::move(result)) {}
+
+  AsyncValueRef<T> result_;
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_HAS_COROUTINES
+
+#endif  // TFRT_HOST_CONTEXT_ASYNC_TASK_H_
@@ -120,9 +120,10 @@ class StringAttribute {
 // Compilation unit attribute decodes serialized MLIR module and a compilation
 // target symbol (function name).
 //
-// TODO(ezhulenev): CompilationUnitAttribute in addition to an `id` and `addr`
-// should provide a hash (or something like sha-256 fingerprint) of its content
-// for cache lookup.
+// The `fingerprint` is a hash of the symbol and the serialized module computed
+// by the BEF compiler. Unlike `id` and `addr`, it is the same for identical
+// compilation units in different BEF files, and can be used as a process-wide
+// cache key.
 class CompilationUnitAttribute {
  public:
   explicit CompilationUnitAttribute(const void* value)
@@ -131,6 +132,7 @@ class CompilationUnitAttribute {
     const auto* ptr = static_cast<const uint8_t*>(value);
 
     ptr = ReadVbrInt(ptr, &id_);
+    ptr = ReadVbrInt(ptr, &fingerprint_);
 
     size_t root_symbol_len;
     ptr = ReadVbrInt(ptr, &root_symbol_len);
@@ -162,6 +164,7 @@ class CompilationUnitAttribute {
   }
 
   size_t id() const { return id_; }
+  size_t fingerprint() const { return fingerprint_; }
   intptr_t addr() const { return addr_; }
   string_view root_symbol() const { return root_symbol_; }
   ArrayRef<string_view> nested_symbols() const { return nested_symbols_; }
@@ -169,6 +172,7 @@ class CompilationUnitAttribute {
 
  private:
   size_t id_;
+  size_t fingerprint_;
   intptr_t addr_;
   string_view root_symbol_;
   llvm::SmallVector<string_view> nested_symbols_;
@@ -24,6 +24,8 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Compiler.h"
@@ -87,6 +89,38 @@ class ConcurrentWorkQueue {
   // thread.
   virtual void AddTask(TaskFunction work) = 0;
 
+  // Enqueue a batch of independent blocks of work. Thread-safe. Tasks are moved
+  // out of `work`.
+  //
+  // Semantically equivalent to calling AddTask() for every task. The default
+  // implementation does exactly that, implementations can override it to
+  // amortize the synchronization and the wakeups of worker threads.
+  virtual void AddTasks(MutableArrayRef<TaskFunction> work);
+
+  // Enqueue a block of work with the given priority. Thread-safe.
+  //
+  // Implementations that support priorities run pending work of a higher
+  // priority first. Lower priority work that is already running is not
+  // interrupted. The default implementation ignores the priority and calls
+  // AddTask().
+  virtual void AddTaskWithPriority(TaskFunction work, TaskPriority priority);
+
+  // Enqueue a batch of independent blocks of work with the given priority.
+  // Thread-safe. The default implementation ignores the priority and calls
+  // AddTasks().
+  virtual void AddTasksWithPriority(MutableArrayRef<TaskFunction> work,
+                                    TaskPriority priority);
+
+  // Enqueue a block of work that continues the work of the caller, e.g. the
+  // consumer of a value that the caller has just produced. Thread-safe.
+  //
+  // Implementations can run `work` in the caller worker thread right after its
+  // current task, ahead of the other pending work, so that the consumer finds
+  // the produced data in the cache. Such work is not visible to other worker
+  // threads until the caller finishes its current task, so the caller must
+  // not wait for `work`. The default implementation calls AddTask().
+  virtual void AddNextTask(TaskFunction work);
+
   // Enqueue a blocking task. Thread-safe.
   //
   // If `allow_queuing` is false, implementation must guarantee that work will
@@ -118,6 +152,46 @@ class ConcurrentWorkQueue {
   // Returns true if the caller thread is one of the worker threads managed by
   // this work queue. Returns true only for threads executing compute tasks.
   virtual bool IsInWorkerThread() const = 0;
+
+  // Returns the index in [0, GetParallelismLevel()) of the caller worker
+  // thread, or -1 if the caller is not a worker thread. Implementations that
+  // don't number their worker threads return -1. The default implementation
+  // returns -1.
+  virtual int CurrentWorkerThreadId() const { return -1; }
+
+  // Returns true if the work queue has no worker threads, and runs all tasks
+  // in the client thread that is donated to it in Await() or Quiesce(). Tasks
+  // of such a work queue never run concurrently with each other or with the
+  // client, which allows the clients to skip synchronization.
+  virtual bool IsSingleThreaded() const { return false; }
+
+  // Exports scheduler statistics of the work queue (e.g. queue depth, steals,
+  // parks and busy time of the worker threads) to the metrics registry.
+  // Statistics are kept in cheap per-worker counters, and are aggregated only
+  // when exported, so callers decide how often to pay for it. The default
+  // implementation exports nothing.
+  virtual void ExportMetrics() {}
+
+  // Enables recording the time from enqueueing each task to starting it into
+  // a histogram in the metrics registry. This adds a clock read and a
+  // histogram update to every task. The default implementation ignores it.
+  virtual void EnableTaskLatencyMetrics(bool enable) {}
+};
+
+// Defines what the worker threads of a multi-threaded work queue do after they
+// run out of tasks, before they park and wait for a notification. Parking and
+// unparking a thread is expensive, spinning in a steal loop avoids it at the
+// cost of burned CPU cycles.
+enum class SpinWaitMode {
+  // Spin for a fixed number of steal attempts. This is the default.
+  kFixed,
+  // Spin for a duration derived from the recent time between a worker thread
+  // running out of tasks and getting the next one. Spin longer when new tasks
+  // arrive soon, and park right away when the queue is mostly idle.
+  kAdaptive,
+  // Never spin. Minimizes CPU usage for hosts that are idle most of the time,
+  // at the cost of thread wake up latency for every new task.
+  kLowPower,
 };
 
 // Create a thread pool that only uses the host donor thread, involving no
@@ -135,9 +209,56 @@ std::unique_ptr<ConcurrentWorkQueue> CreateSingleThreadedWorkQueue();
 // num_blocking_threads: Number of pre-allocated threads used in blocking
 // work queue.
 //
+// spin_wait_mode: What the non-blocking threads do after they run out of tasks.
+//
 // Requires `num_threads` > 0 and `num_blocking_threads` > 0.
 std::unique_ptr<ConcurrentWorkQueue> CreateMultiThreadedWorkQueue(
-    int num_threads, int num_blocking_threads);
+    int num_threads, int num_blocking_threads,
+    SpinWaitMode spin_wait_mode = SpinWaitMode::kFixed);
+
+// Create a NUMA-aware variant of the multi-threaded work queue. Non-blocking
+// threads are split into one group per NUMA node, pinned to the CPUs of the
+// node. Tasks enqueued by a worker thread stay on its node, and idle workers
+// steal from their own node before stealing from other nodes. Threads of a
+// node are marked with numa::SetCurrentThreadNode(), so CreateNumaAllocator()
+// can allocate from the node of the current worker.
+//
+// On hosts with a single NUMA node this behaves like the multi-threaded work
+// queue with pinned worker threads.
+//
+// Requires `num_threads` > 0 and `num_blocking_threads` > 0.
+std::unique_ptr<ConcurrentWorkQueue> CreateNumaWorkQueue(
+    int num_threads, int num_blocking_threads,
+    SpinWaitMode spin_wait_mode = SpinWaitMode::kFixed);
+
+// Options of a work queue that serves one tenant, e.g. one model, of a process
+// that serves several tenants with separate HostContexts.
+struct TenantWorkQueueOptions {
+  // Number of non-blocking worker threads. If zero, one thread per CPU in
+  // `cpus`, or per CPU of the host if `cpus` is empty.
+  int num_threads = 0;
+  int num_blocking_threads = 256;
+  SpinWaitMode spin_wait_mode = SpinWaitMode::kFixed;
+  // CPUs the non-blocking worker threads are pinned to. If empty, the threads
+  // are not pinned.
+  std::vector<int> cpus;
+  // Work queues of the same non-empty share group lend their idle worker
+  // threads to each other: before a worker thread parks, it steals a task
+  // from the other queues of the group. If empty, the queue only runs its own
+  // tasks.
+  std::string share_group;
+};
+
+// Create a multi-threaded work queue for one tenant. Tenants with disjoint
+// `cpus` and no share group don't compete for CPUs or worker threads, so a
+// busy tenant doesn't inflate the latency of the others. Tenants of a share
+// group run on their own CPUs first, and use the idle CPUs of the group when
+// they have more work than threads.
+//
+// A worker thread running a task of another queue keeps its CPU affinity, and
+// is not a worker thread of that queue, e.g. for IsInWorkerThread().
+std::unique_ptr<ConcurrentWorkQueue> CreateTenantWorkQueue(
+    const TenantWorkQueueOptions& options);
 
 // A factory function for creating ConcurrentWorkQueue objects. The factory
 // function defines the semantics of the argument string.
@@ -19,11 +19,16 @@
 #ifndef TFRT_HOST_CONTEXT_EXECUTION_CONTEXT_H_
 #define TFRT_HOST_CONTEXT_EXECUTION_CONTEXT_H_
 
+#include <memory>
 #include <utility>
 
 #include "llvm/Support/Error.h"
+#include "tfrt/host_context/admission_controller.h"
+#include "tfrt/host_context/arena_allocator.h"
+#include "tfrt/host_context/host_counters.h"
 #include "tfrt/host_context/location.h"
 #include "tfrt/host_context/resource_context.h"
+#include "tfrt/host_context/task_function.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/map_by_type.h"
 #include "tfrt/support/ref_count.h"
@@ -83,16 +88,32 @@ class RequestContext : public ReferenceCounted<RequestContext> {
 
   bool IsCostMeasurementEnabled() const { return enable_cost_measurement_; }
 
+  // Returns the arena allocator for request temporaries, or nullptr if the
+  // arena is not enabled for this request. The arena memory is released at
+  // once after the request is finished and all arena allocations are
+  // deallocated.
+  ArenaAllocator* arena() const { return arena_.get(); }
+
+  // Priority of the non-blocking tasks enqueued on behalf of this request.
+  TaskPriority priority() const { return priority_; }
+
+  // Returns the host counters of this request, or nullptr if the request was
+  // not sampled. See host_counters.h.
+  HostCounters* host_counters() const { return host_counters_.get(); }
+
  private:
   friend class RequestContextBuilder;
 
   RequestContext(HostContext* host, ResourceContext* resource_context,
-                 ContextData ctx_data, int64_t id, bool enable_cost_measurement)
+                 ContextData ctx_data, int64_t id, bool enable_cost_measurement,
+                 RCReference<ArenaAllocator> arena, TaskPriority priority)
       : id_{id},
         host_{host},
         resource_context_{resource_context},
         context_data_{std::move(ctx_data)},
-        enable_cost_measurement_{enable_cost_measurement} {}
+        enable_cost_measurement_{enable_cost_measurement},
+        arena_{std::move(arena)},
+        priority_{priority} {}
 
   int64_t id_;
   HostContext* const host_ = nullptr;
@@ -110,12 +131,20 @@ class RequestContext : public ReferenceCounted<RequestContext> {
   std::atomic<ErrorAsyncValue*> cancel_value_{nullptr};
   // If true, the cost of op will be measured at the execution time.
   bool enable_cost_measurement_ = false;
+  RCReference<ArenaAllocator> arena_;
+  TaskPriority priority_ = TaskPriority::kDefault;
+  std::unique_ptr<HostCounters> host_counters_;
+  // Released when the request is finished.
+  AdmissionToken admission_token_;
 };
 
 struct RequestOptions {
-  using RequestPriority = int;
+  using RequestPriority = TaskPriority;
 
-  RequestPriority priority = 0;
+  // Latency critical requests can use a higher priority to get their tasks
+  // executed ahead of the batch and background requests sharing the same work
+  // queue.
+  RequestPriority priority = TaskPriority::kDefault;
 };
 
 // A builder class for RequestContext.
@@ -143,6 +172,46 @@ class RequestContextBuilder {
     return std::move(*this);
   }
 
+  // Enable a bump pointer arena allocator for the request temporaries. The
+  // arena allocates blocks of `block_size` bytes from the host allocator.
+  RequestContextBuilder& enable_arena(
+      size_t block_size = ArenaAllocator::kDefaultBlockSize) & {
+    arena_block_size_ = block_size;
+    return *this;
+  }
+
+  RequestContextBuilder&& enable_arena(
+      size_t block_size = ArenaAllocator::kDefaultBlockSize) && {
+    arena_block_size_ = block_size;
+    return std::move(*this);
+  }
+
+  // Admit the request with `controller` in build(), which fails if the
+  // request is rejected. See admission_controller.h.
+  RequestContextBuilder& set_admission_controller(
+      AdmissionController* controller) & {
+    admission_controller_ = controller;
+    return *this;
+  }
+
+  RequestContextBuilder&& set_admission_controller(
+      AdmissionController* controller) && {
+    admission_controller_ = controller;
+    return std::move(*this);
+  }
+
+  // Use a token obtained from AdmissionController::Admit() for the request,
+  // instead of admitting it in build().
+  RequestContextBuilder& set_admission_token(AdmissionToken token) & {
+    admission_token_ = std::move(token);
+    return *this;
+  }
+
+  RequestContextBuilder&& set_admission_token(AdmissionToken token) && {
+    admission_token_ = std::move(token);
+    return std::move(*this);
+  }
+
   int64_t id() const { return id_; }
   HostContext* host() const { return host_; }
   ResourceContext* resource_context() const { return resource_context_; }
@@ -162,6 +231,10 @@ class RequestContextBuilder {
   ResourceContext* resource_context_ = nullptr;
   RequestContext::ContextData context_data_;
   bool enable_cost_measurement_ = false;
+  // Zero if the request arena is disabled.
+  size_t arena_block_size_ = 0;
+  AdmissionController* admission_controller_ = nullptr;
+  AdmissionToken admission_token_;
 };
 
 // ExecutionContext holds the context information for kernel and op execution,
@@ -198,18 +271,32 @@ class ExecutionContext {
   // Return the work queue to use for dispatching async tasks.
   ConcurrentWorkQueue& work_queue() const { return *work_queue_; }
 
+  // If enabled, BEFExecutor keeps ready outline kernels in per-worker ready
+  // queues and lets idle workers steal them, instead of enqueuing one task into
+  // the work queue for every batch of ready outline kernels.
+  void set_work_stealing(bool enabled) { work_stealing_ = enabled; }
+  bool work_stealing() const { return work_stealing_; }
+
   RequestContext* request_ctx() const { return request_ctx_.get(); }
 
+  // Priority used by EnqueueWork() for the tasks of this execution.
+  TaskPriority priority() const { return request_ctx_->priority(); }
+
   ResourceContext* resource_context() const {
     return request_ctx_->resource_context();
   }
 
+  // Returns the request arena if it is enabled, otherwise the host allocator.
+  // Use it for allocations that are not expected to outlive the request.
+  HostAllocator* temporary_allocator() const;
+
  private:
   RCReference<RequestContext> request_ctx_;
   // If set, this work queue will be used for running async tasks in the
   // execution. Otherwise, the work queue in HostContext is used.
   ConcurrentWorkQueue* work_queue_ = nullptr;
   Location location_;
+  bool work_stealing_ = false;
 };
 
 }  // namespace tfrt
@@ -21,9 +21,14 @@
 #ifndef TFRT_HOST_CONTEXT_HOST_ALLOCATOR_H_
 #define TFRT_HOST_CONTEXT_HOST_ALLOCATOR_H_
 
+#include <atomic>
 #include <memory>
+#include <string>
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Compiler.h"
 #include "tfrt/support/forward_decls.h"
 
 namespace tfrt {
@@ -74,9 +79,85 @@ class HostAllocator {
 // Create an allocator that just calls malloc/free.
 std::unique_ptr<HostAllocator> CreateMallocAllocator();
 
+// Create a thread-caching size-class slab allocator on top of `allocator`.
+// Small allocations (up to 512 bytes) are served from per-thread free lists
+// backed by large slabs, all other allocations are forwarded to `allocator`.
+// Slab memory is released only when the slab allocator is destroyed.
+std::unique_ptr<HostAllocator> CreateSlabAllocator(
+    std::unique_ptr<HostAllocator> allocator);
+
+// Create an allocator that pools the buffers of tensor-sized allocations (over
+// 512 bytes and up to 64 MiB) on top of `allocator`. Allocation sizes are
+// rounded up to one of four size classes per power of two, and deallocated
+// buffers are kept in per-thread and shared free lists for reuse. At most
+// `max_cached_bytes` are kept in the shared free lists, and at most 8 MiB in
+// the free lists of every thread. Pooled memory is returned to `allocator` when
+// the pool is destroyed.
+//
+// If `profile_path` is not empty, the pool writes the peak number of buffers of
+// every size class to this file when it is destroyed, and a pool created later
+// (e.g. by the restarted process) allocates these buffers up front, within
+// `max_cached_bytes`. This way a restarted server starts with a warm pool. The
+// profile is a hint only, a missing or unreadable file is ignored.
+std::unique_ptr<HostAllocator> CreateBufferPoolAllocator(
+    std::unique_ptr<HostAllocator> allocator,
+    size_t max_cached_bytes = 256 * 1024 * 1024, string_view profile_path = {});
+
+// Create an allocator that places large allocations on the NUMA node of the
+// calling thread, as assigned by the work queue created with
+// CreateNumaWorkQueue(). Other allocations are forwarded to `allocator`.
+std::unique_ptr<HostAllocator> CreateNumaAllocator(
+    std::unique_ptr<HostAllocator> allocator);
+
+// Create an allocator that backs allocations of 2 MiB or more with huge pages.
+// Such allocations are rounded up to a multiple of 2 MiB and aligned to 2 MiB.
+// If `reserved_bytes` is not zero, a region of that size is mapped and
+// populated up front, from the hugetlbfs pool if the system reserved huge
+// pages and with transparent huge pages otherwise, and large allocations are
+// carved from it while it has room. Other large allocations are mapped with
+// transparent huge pages, and small allocations are forwarded to `allocator`.
+std::unique_ptr<HostAllocator> CreateHugePageAllocator(
+    std::unique_ptr<HostAllocator> allocator, size_t reserved_bytes = 0);
+
 // Create an allocator of fixed size for testing.
 std::unique_ptr<HostAllocator> CreateFixedSizeAllocator(size_t capacity = 1024);
 
+// Names the code running in the calling thread for the lifetime of the
+// instance, e.g. the kernel run by the BEFExecutor, so that sampling allocation
+// profilers can attribute allocations to it (see EnableAllocationSampling()).
+// `get_name` is only called for sampled allocations, and must stay valid for
+// the lifetime of the instance. While no allocations are sampled, the scope
+// only checks an atomic flag.
+class AllocationSiteScope {
+ public:
+  explicit AllocationSiteScope(llvm::function_ref<std::string()> get_name)
+      : active_(kEnabled.load(std::memory_order_relaxed)) {
+    if (LLVM_UNLIKELY(active_)) Push(get_name);
+  }
+
+  ~AllocationSiteScope() {
+    if (LLVM_UNLIKELY(active_)) Pop();
+  }
+
+  AllocationSiteScope(const AllocationSiteScope&) = delete;
+  AllocationSiteScope& operator=(const AllocationSiteScope&) = delete;
+
+  // Returns the name of the innermost active scope of the calling thread, or
+  // an empty string if there is none.
+  static std::string CurrentName();
+
+  // Set by allocation profilers while they sample allocations.
+  static std::atomic<bool> kEnabled;
+
+ private:
+  void Push(llvm::function_ref<std::string()> get_name);
+  void Pop();
+
+  const bool active_;
+  llvm::function_ref<std::string()> get_name_;
+  AllocationSiteScope* parent_ = nullptr;
+};
+
 // An RAII-based abstraction that manages an array of objects via HostAllocator.
 template <typename ObjectT>
 class HostArray {
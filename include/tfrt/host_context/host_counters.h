@@ -0,0 +1,105 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares counters of the work done on the hot paths of the host
+// runtime, e.g. the number of enqueued tasks or allocated bytes.
+//
+// The counters are only compiled in when building with
+// --@tf_runtime//:host_counters, which defines TFRT_HOST_COUNTERS. Otherwise
+// AddHostCounter() compiles to nothing. When compiled in, counting is off
+// until SetHostCountersSamplingPeriod() is called with a positive period, and
+// then costs a relaxed atomic load when off.
+//
+// Counts are accumulated per thread and flushed to the metrics registry in
+// batches, under the names /tfrt/host_context/counters/<counter>. The counts of
+// one out of every `period` requests are also collected in its RequestContext,
+// see RequestContext::host_counters().
+
+#ifndef TFRT_HOST_CONTEXT_HOST_COUNTERS_H_
+#define TFRT_HOST_CONTEXT_HOST_COUNTERS_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#ifndef TFRT_HOST_COUNTERS
+#define TFRT_HOST_COUNTERS 0
+#endif
+
+namespace tfrt {
+
+class RequestContext;
+
+enum class HostCounter {
+  kTasks,           // Non-blocking tasks enqueued.
+  kBlockingTasks,   // Blocking tasks enqueued.
+  kExecutors,       // BEFExecutor instances created.
+  kAllocatedBytes,  // Bytes allocated by HostContext::AllocateBytes.
+};
+
+constexpr int kNumHostCounters = 4;
+
+// Returns the name of `counter`, e.g. "tasks".
+const char* GetHostCounterName(HostCounter counter);
+
+// The counts of one request.
+class HostCounters {
+ public:
+  int64_t Get(HostCounter counter) const {
+    return counts_[static_cast<int>(counter)].load(std::memory_order_relaxed);
+  }
+
+  void Add(HostCounter counter, int64_t value) {
+    counts_[static_cast<int>(counter)].fetch_add(value,
+                                                 std::memory_order_relaxed);
+  }
+
+ private:
+  std::array<std::atomic<int64_t>, kNumHostCounters> counts_{};
+};
+
+// Enables counting and collects the counts of one out of every `period`
+// requests created afterwards. Zero disables counting.
+void SetHostCountersSamplingPeriod(int period);
+
+// Returns whether the counts of the next request should be collected.
+bool SampleHostCounters();
+
+// Flushes the counts of the calling thread to the metrics registry.
+void FlushHostCounters();
+
+namespace internal {
+
+extern std::atomic<bool> host_counters_enabled;
+
+void AddHostCounter(RequestContext* request, HostCounter counter,
+                    int64_t value);
+
+}  // namespace internal
+
+// Adds `value` to `counter` of the calling thread, and of `request` if it is
+// sampled. `request` may be null for work that doesn't belong to a request.
+inline void AddHostCounter(RequestContext* request, HostCounter counter,
+                           int64_t value = 1) {
+#if TFRT_HOST_COUNTERS
+  if (internal::host_counters_enabled.load(std::memory_order_relaxed))
+    internal::AddHostCounter(request, counter, value);
+#endif
+}
+
+}  // namespace tfrt
+
+#endif  // TFRT_HOST_CONTEXT_HOST_COUNTERS_H_
@@ -68,6 +68,12 @@ class KernelRegistry {
 
   KernelImplementation GetKernel(string_view name) const;
 
+  // Freezes the registered kernels into a perfect hash table with contiguous
+  // storage, which GetKernel() then uses instead of the registration map.
+  // Adding kernels afterwards drops the table until Freeze() is called again.
+  // RegisterStaticKernels() freezes the registry.
+  void Freeze();
+
   TypeName GetType(string_view type) const;
 
  private:
@@ -95,7 +101,7 @@ class KernelRegistry {
 using KernelRegistration = void (*)(KernelRegistry*);
 
 // This is called to register all the statically linked kernels in the given
-// registry.
+// registry, and freezes it.
 void RegisterStaticKernels(KernelRegistry* kernel_reg);
 
 // Adds a kernel to the registry. This should not be used directly; use
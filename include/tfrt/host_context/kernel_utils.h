@@ -27,6 +27,7 @@
 
 #include "llvm/Support/Error.h"
 #include "tfrt/bef/bef_encoding.h"
+#include "tfrt/host_context/async_task.h"
 #include "tfrt/host_context/async_value.h"
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/host_context/attribute_utils.h"
@@ -581,6 +582,15 @@ struct TfrtKernelImpl<Return (*)(Args...), impl_fn> {
     }
   }
 
+#if TFRT_HAS_COROUTINES
+  // For kernel functions implemented as coroutines, stores the value the
+  // coroutine completes as the output AsyncValue.
+  template <typename T>
+  static void HandleReturn(AsyncKernelFrame* frame, AsyncTask<T>&& t) {
+    HandleReturn(frame, std::move(t).result());
+  }
+#endif
+
   // For kernel functions that return AsyncValueRef<std::tuple<>>, stores the
   // results in order as the output AsyncValues in the AsyncKernelFrame.
   template <typename... T>
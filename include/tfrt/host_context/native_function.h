@@ -19,6 +19,8 @@
 #ifndef TFRT_HOST_CONTEXT_NATIVE_FUNCTION_H_
 #define TFRT_HOST_CONTEXT_NATIVE_FUNCTION_H_
 
+#include <atomic>
+
 #include "llvm/ADT/StringMap.h"
 #include "tfrt/host_context/function.h"
 #include "tfrt/support/mutex.h"
@@ -46,19 +48,33 @@ class NativeFunctionRegistry {
 
   void Add(string_view name, NativeCallable callable) {
     mutex_lock lock(m_);
+    assert(!frozen_.load(std::memory_order_relaxed) &&
+           "native function registry is frozen");
     auto r = callables_.try_emplace(name, callable);
     assert(r.second && "native function already exists");
     (void)r;
   }
 
-  NativeCallable Get(string_view name) const {
+  // BEF files resolve their native functions once when they are loaded, and
+  // call the NativeCallable directly afterwards.
+  NativeCallable Get(string_view name) const TFRT_NO_THREAD_SAFETY_ANALYSIS {
+    if (frozen_.load(std::memory_order_acquire)) return callables_.lookup(name);
     mutex_lock lock(m_);
     return callables_.lookup(name);
   }
 
+  // Makes the registry immutable, so that Get() no longer takes the lock. No
+  // functions may be added afterwards. RegisterStaticKernels() freezes the
+  // global registry.
+  void Freeze() {
+    mutex_lock lock(m_);
+    frozen_.store(true, std::memory_order_release);
+  }
+
  private:
   mutable mutex m_;
   llvm::StringMap<NativeCallable> callables_ TFRT_GUARDED_BY(m_);
+  std::atomic<bool> frozen_{false};
 };
 
 // NativeFunction provides an interface for BEF Executor to run native
@@ -36,8 +36,22 @@ class HostContext;
 
 class ParallelFor {
  public:
-  explicit ParallelFor(ExecutionContext exec_ctx)
-      : exec_ctx_(std::move(exec_ctx)) {}
+  // SplitMode configures which threads split a range into blocks.
+  enum class SplitMode {
+    // The caller thread recursively splits the range in halves, submits all
+    // split ranges to the work queue as a single batch, and evaluates the
+    // first block. It enqueues O(log(num_blocks)) tasks.
+    kCaller,
+    // The caller thread only splits the range in half, submits both halves to
+    // the work queue and returns. Each task keeps splitting its range until it
+    // reaches the block size, so the submission cost is spread across the
+    // worker threads (the Eigen::ThreadPoolDevice::parallelFor approach).
+    kWorkers,
+  };
+
+  explicit ParallelFor(ExecutionContext exec_ctx,
+                       SplitMode split_mode = SplitMode::kCaller)
+      : exec_ctx_(std::move(exec_ctx)), split_mode_(split_mode) {}
 
   //===--------------------------------------------------------------------===//
   // BlockSizes configures how a range is split into parallely executed blocks.
@@ -48,22 +62,36 @@ class ParallelFor {
     static BlockSizes Fixed(size_t n);
     // Splits range into a block sizes not smaller than `min`.
     static BlockSizes Min(size_t min);
+    // Splits a range into blocks based on the cost of processing a single
+    // element of the range: the number of bytes loaded from and stored to the
+    // memory, and the number of compute cycles. Uses fewer worker threads for
+    // cheap ranges, and executes the range in the caller thread if it is not
+    // worth parallelizing. Block sizes are chosen to keep tasks large enough
+    // to amortize the scheduling overhead, and evenly balanced between the
+    // worker threads.
+    static BlockSizes Cost(double bytes_loaded, double bytes_stored,
+                           double compute_cycles);
 
    private:
     friend class ParallelFor;
 
-    explicit BlockSizes(llvm::unique_function<size_t(size_t)> impl)
+    explicit BlockSizes(llvm::unique_function<size_t(size_t, size_t)> impl)
         : impl_(std::move(impl)) {}
 
+    // Returns a block size that assigns a few blocks to each worker thread.
+    static size_t DefaultBlockSize(size_t num_worker_threads,
+                                   size_t total_size);
+
     // Returns a parallel block size for a range of `total_size` and the
     // specified number of worker threads.
     size_t GetBlockSize(size_t num_worker_threads, size_t total_size) const;
 
     // Block sizes computation internally represented as a function from the
-    // parallel for parameters to the block size. This is an internal detail,
-    // a contract between ParallelFor and BlockSizes. Users of ParallelFor
-    // must rely only on public static methods to choose block sizes policy.
-    mutable llvm::unique_function<size_t(size_t)> impl_;
+    // parallel for parameters (the number of worker threads and the total
+    // size) to the block size. This is an internal detail, a contract between
+    // ParallelFor and BlockSizes. Users of ParallelFor must rely only on
+    // public static methods to choose block sizes policy.
+    mutable llvm::unique_function<size_t(size_t, size_t)> impl_;
   };
 
   //===--------------------------------------------------------------------===//
@@ -141,9 +169,16 @@ class ParallelFor {
       llvm::unique_function<AsyncValueRef<T>(size_t, size_t)> compute,
       llvm::unique_function<R(ArrayRef<AsyncValueRef<T>>)> on_done) const;
 
+  // Returns true if the caller thread is computing a block of a range that is
+  // split into multiple blocks. The other blocks keep the worker threads busy,
+  // so nested parallel algorithms (e.g. Eigen expressions evaluated by the
+  // block) should run in the caller thread.
+  static bool IsInParallelRegion();
+
  private:
   ExecutionContext exec_ctx_;  // The data in exec_ctx_ must outlive all
                                // parallel operations in flight
+  SplitMode split_mode_;
 };
 
 template <typename T, typename R>
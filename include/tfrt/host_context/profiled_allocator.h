@@ -19,9 +19,13 @@
 // This file implements a profiling host memory allocator that does a memory
 // leak check and prints allocation statistics when destroyed.
 
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "tfrt/host_context/host_allocator.h"
+#include "tfrt/support/forward_decls.h"
 
 namespace tfrt {
 
@@ -33,4 +37,46 @@ std::unique_ptr<HostAllocator> CreateProfiledAllocator(
 std::unique_ptr<HostAllocator> CreateLeakCheckAllocator(
     std::unique_ptr<HostAllocator> allocator);
 
+//===----------------------------------------------------------------------===//
+// Allocation sampling
+//===----------------------------------------------------------------------===//
+
+struct AllocationSamplingOptions {
+  // Sample on average one allocation per `sampling_bytes` allocated bytes.
+  int64_t sampling_bytes = 1 << 20;
+  // Attribute sampled allocations made outside of any AllocationSiteScope to
+  // their call stack. Symbolizing the stack is slow, and CreateStackTrace()
+  // returns no stack in optimized builds.
+  bool stack_traces = false;
+};
+
+// Starts sampling the allocations of the allocators created by
+// CreateProfiledAllocator() and CreateLeakCheckAllocator(), and attributing
+// them to the innermost AllocationSiteScope of the allocating thread, e.g. the
+// kernel run by the BEFExecutor.
+//
+// The sampling intervals are exponentially distributed per thread, so that
+// allocations are sampled with a probability that grows with their size,
+// and the profiles estimate the allocations and bytes of each site without
+// bias. While sampling is disabled, allocations only check an atomic flag.
+void EnableAllocationSampling(const AllocationSamplingOptions& options);
+
+// Stops sampling allocations. Profiles are kept.
+void DisableAllocationSampling();
+
+// The sampled allocations of one allocation site.
+struct AllocationSiteProfile {
+  std::string site;
+  int64_t samples = 0;
+  // Estimated number and total size of the allocations of the site.
+  int64_t allocations = 0;
+  int64_t bytes = 0;
+};
+
+// Returns the profiles of all sampled allocation sites, by decreasing bytes.
+std::vector<AllocationSiteProfile> GetAllocationSiteProfiles();
+
+// Prints the top `num_sites` allocation sites by bytes and by count.
+void PrintAllocationSiteProfiles(raw_ostream& os, int num_sites = 10);
+
 }  // namespace tfrt
@@ -32,12 +32,21 @@ class RequestDeadlineTracker {
   }
 
   // Enqueue a timer that tracks the dealine of the request to the TimerQueue.
-  void CancelRequestOnDeadline(std::chrono::system_clock::time_point deadline,
-                               RCReference<RequestContext> req_ctx) {
-    timer_queue_->ScheduleTimerAt(
+  // Returns the timer handle, that can be passed to the CancelDeadline() when
+  // the request completes before the deadline, to release the request context
+  // without waiting for the deadline.
+  TimerQueue::TimerHandle CancelRequestOnDeadline(
+      std::chrono::system_clock::time_point deadline,
+      RCReference<RequestContext> req_ctx) {
+    return timer_queue_->ScheduleTimerAt(
         deadline, [req_ctx = std::move(req_ctx)] { req_ctx->Cancel(); });
   }
 
+  // Cancels the deadline timer returned from CancelRequestOnDeadline().
+  void CancelDeadline(const TimerQueue::TimerHandle& timer_handle) {
+    timer_queue_->CancelTimer(timer_handle);
+  }
+
  private:
   TimerQueue* timer_queue_;
 };
@@ -23,6 +23,7 @@
 #include <array>
 #include <atomic>
 #include <memory>
+#include <string>
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
@@ -34,10 +35,48 @@
 
 namespace tfrt {
 
+namespace internal {
+// Returns the index of a new resource slot.
+inline int NextResourceSlotIndex() {
+  static std::atomic<int> next_index{0};
+  return next_index.fetch_add(1, std::memory_order_relaxed);
+}
+}  // namespace internal
+
+// ResourceSlot is a handle of a resource T with a given name, which gives
+// lock-free access to the resource after it has been created in a
+// ResourceContext. Slots are meant to be created once per process, e.g. as
+// function-local statics in the kernels that use the resource:
+//
+//   static ResourceSlot<MyCache> slot("my.cache");
+//   MyCache* cache = exec_ctx.resource_context()->GetOrCreateResource(slot);
+//
+// Resources accessed with a slot are still accessible by name, and vice versa.
+template <typename T>
+class ResourceSlot {
+ public:
+  explicit ResourceSlot(string_view name)
+      : name_(name), index_(internal::NextResourceSlotIndex()) {}
+
+  ResourceSlot(const ResourceSlot&) = delete;
+  ResourceSlot& operator=(const ResourceSlot&) = delete;
+
+  string_view name() const { return name_; }
+  int index() const { return index_; }
+
+ private:
+  std::string name_;
+  int index_;
+};
+
 // ResourceContext is used to store and retrieve resources. This class is
 // thread-safe.
 class ResourceContext {
  public:
+  // The number of resource slots with lock-free access. Resources of slots
+  // allocated after that are looked up by name.
+  static constexpr int kNumSlots = 32;
+
   ResourceContext() = default;
 
   // Resources stored inside are destroyed in reverse insertion order. This is
@@ -59,6 +98,22 @@ class ResourceContext {
     return data;
   }
 
+  // Get a resource T with the name of `slot`. Lock-free if the resource has
+  // been created and accessed with `slot` before. Thread-safe.
+  template <typename T>
+  Optional<T*> GetResource(const ResourceSlot<T>& slot) TFRT_EXCLUDES(mu_) {
+    if (T* data = LoadSlot(slot)) return data;
+
+    tfrt::mutex_lock lock(mu_);
+    auto it = resources_.find(slot.name());
+    if (it == resources_.end()) {
+      return llvm::None;
+    }
+    T* data = tfrt::any_cast<T>(&it->second);
+    StoreSlot(slot, data);
+    return data;
+  }
+
   // Get a resource T with a `resource_name`. Asserts that the resource has
   // been created.
   // Thread-safe.
@@ -99,6 +154,22 @@ class ResourceContext {
     return tfrt::any_cast<T>(&res.first->second);
   }
 
+  // Get or create a resource T with the name of `slot`. Lock-free if the
+  // resource has been created and accessed with `slot` before. Thread-safe.
+  template <typename T, typename... Args>
+  T* GetOrCreateResource(const ResourceSlot<T>& slot, Args&&... args)
+      TFRT_EXCLUDES(mu_) {
+    if (T* data = LoadSlot(slot)) return data;
+
+    tfrt::mutex_lock lock(mu_);
+    auto res = resources_.try_emplace(slot.name(), tfrt::in_place_type<T>,
+                                      std::forward<Args>(args)...);
+    if (res.second) resource_vector_.push_back(&res.first->second);
+    T* data = tfrt::any_cast<T>(&res.first->second);
+    StoreSlot(slot, data);
+    return data;
+  }
+
   // Delete resource with name `resource_name`.  No-op if it doesn't exist.
   // Thread-safe.
   void DeleteResource(tfrt::string_view resource_name) {
@@ -111,12 +182,35 @@ class ResourceContext {
                                &map_it->second);
     resource_vector_.erase(vector_it);
     resources_.erase(map_it);
+
+    // Slots don't know which resource they refer to by name, so forget all of
+    // them. Deleting resources is rare.
+    for (auto& slot : slots_) slot.store(nullptr, std::memory_order_relaxed);
   }
 
  private:
+  template <typename T>
+  T* LoadSlot(const ResourceSlot<T>& slot) const {
+    if (slot.index() >= kNumSlots) return nullptr;
+    return static_cast<T*>(
+        slots_[slot.index()].load(std::memory_order_acquire));
+  }
+
+  // Must be called with `mu_` held, so that DeleteResource() can't clear the
+  // slot before the resource is stored.
+  template <typename T>
+  void StoreSlot(const ResourceSlot<T>& slot, T* data) TFRT_REQUIRES(mu_) {
+    if (slot.index() >= kNumSlots) return;
+    slots_[slot.index()].store(data, std::memory_order_release);
+  }
+
   tfrt::mutex mu_;
   llvm::StringMap<tfrt::UniqueAny> resources_ TFRT_GUARDED_BY(mu_);
   llvm::SmallVector<tfrt::UniqueAny*, 8> resource_vector_ TFRT_GUARDED_BY(mu_);
+
+  // Resources cached for lock-free access, indexed by the slot index. Written
+  // with `mu_` held.
+  std::array<std::atomic<void*>, kNumSlots> slots_ = {};
 };
 
 inline ResourceContext::~ResourceContext() {
@@ -26,6 +26,7 @@
 #include <utility>
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Error.h"
 #include "tfrt/host_context/attribute_utils.h"
@@ -72,6 +73,15 @@ class SyncKernelFrame {
   // Get all arguments.
   ArrayRef<uint32_t> GetArguments() const { return argument_indices_; }
 
+  // Return true if the argument at the given index is the last use of its
+  // register. The register is reset after the kernel returns, so the kernel may
+  // move the argument value out, e.g. to forward its buffer.
+  bool IsLastUse(int index) const {
+    assert(index < GetNumArgs());
+    return llvm::is_contained(last_use_arguments_,
+                              static_cast<uint32_t>(index));
+  }
+
   // Get the number of attributes.
   int GetNumAttributes() const { return attributes_.size(); }
 
@@ -141,6 +151,8 @@ class SyncKernelFrame {
 
   // These are indices into `registers_`.
   ArrayRef<uint32_t> argument_indices_;
+  // These are indices into `argument_indices_`.
+  ArrayRef<uint32_t> last_use_arguments_;
   ArrayRef<const void*> attributes_;
   // These are indices into `registers_`.
   ArrayRef<uint32_t> result_indices_;
@@ -171,6 +183,11 @@ class SyncKernelFrameBuilder : public SyncKernelFrame {
 
   void SetArguments(ArrayRef<uint32_t> argument_indices) {
     argument_indices_ = argument_indices;
+    last_use_arguments_ = {};
+  }
+  // Must be called after SetArguments().
+  void SetLastUseArguments(ArrayRef<uint32_t> last_use_arguments) {
+    last_use_arguments_ = last_use_arguments;
   }
   void SetAttributes(ArrayRef<const void*> attributes) {
     attributes_ = attributes;
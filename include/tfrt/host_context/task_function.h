@@ -16,17 +16,30 @@
 
 // Task Function Abstraction
 //
-// This file defines the TaskFunction class for representing work queue tasks.
+// This file defines the TaskFunction class for representing work queue tasks,
+// and the priorities that can be assigned to them.
 
 #ifndef TFRT_HOST_CONTEXT_TASK_FUNCTION_H_
 #define TFRT_HOST_CONTEXT_TASK_FUNCTION_H_
 
+#include <cstdint>
+
 #include "llvm/ADT/FunctionExtras.h"
 
 namespace tfrt {
 
 using TaskFunction = llvm::unique_function<void()>;
 
+// Priority of a non-blocking task. Work queues that support priorities run
+// pending tasks of a higher priority before the tasks of a lower priority,
+// other work queues ignore it.
+enum class TaskPriority : int8_t {
+  kCritical = 0,
+  kHigh = 1,
+  kDefault = 2,
+  kLow = 3
+};
+
 }  // namespace tfrt
 
 #endif  // TFRT_HOST_CONTEXT_TASK_FUNCTION_H_
@@ -16,16 +16,28 @@
 
 // Timer Queue
 //
-// This file declares TimerQueue, a priority queue to keep track of pending
-// timers. The queue is keyed by timer deadline (the sooner it expires, the
-// higher the priority). On timer expiration, it calls the associated callback.
+// This file declares TimerQueue, a queue to keep track of pending timers. On
+// timer expiration, it calls the associated callback.
+//
+// Pending timers are kept in a hierarchical timing wheel (four levels of 64
+// slots, with a 1ms tick at the lowest level), that is owned by the timer
+// thread. New timers are added to one of the sharded insertion lists, and are
+// moved into the wheel by the timer thread, so scheduling a timer only takes a
+// shard lock and does not wake up the timer thread unless the new deadline is
+// earlier than its next wake up time. Scheduling and cancelling timers are
+// O(1), which is important for timers that are usually cancelled before they
+// expire (e.g. request deadlines).
 
 #ifndef TFRT_HOST_CONTEXT_TIMER_QUEUE_H_
 #define TFRT_HOST_CONTEXT_TIMER_QUEUE_H_
 
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <queue>
+#include <cstdint>
+#include <limits>
 #include <thread>
+#include <vector>
 
 #include "llvm/ADT/FunctionExtras.h"
 #include "tfrt/support/mutex.h"
@@ -56,6 +68,7 @@ class TimerQueue {
   // Enqueue a timer. Deadline is `timeout` microseconds from now.
   TimerHandle ScheduleTimer(TimeDuration timeout, TimerCallback callback);
 
+  // Cancels the timer if it has not expired yet, and destroys its callback.
   void CancelTimer(const TimerHandle& timer_handle);
 
  private:
@@ -71,34 +84,82 @@ class TimerQueue {
       return MakeRef<TimerEntry>(deadline, std::move(timer_callback));
     }
 
-    struct TimerEntryCompare {
-      bool operator()(const RCReference<TimerEntry>& a,
-                      const RCReference<TimerEntry>& b) const {
-        return a->deadline_ > b->deadline_;
-      }
-    };
-
    private:
     friend class TimerQueue;
+
+    // Timer state transitions from kPending to either kCancelled or kExpired
+    // exactly once. The thread that does the transition owns the callback.
+    enum class State : uint8_t { kPending, kCancelled, kExpired };
+
     TimePoint deadline_;
     TimerCallback timer_callback_;
-    std::atomic<bool> cancelled_{false};
+    std::atomic<State> state_{State::kPending};
+  };
+
+  // Timing wheel parameters.
+  static constexpr TimeDuration kTickDuration = std::chrono::milliseconds(1);
+  static constexpr int kNumLevels = 4;
+  static constexpr int kSlotsLog2 = 6;
+  static constexpr int kNumSlots = 1 << kSlotsLog2;
+  static constexpr int kNumShards = 16;
+
+  // Special values of the `next_wakeup_tick_`.
+  static constexpr int64_t kAwake = std::numeric_limits<int64_t>::min();
+  static constexpr int64_t kNever = std::numeric_limits<int64_t>::max();
+
+  // Newly scheduled timers not yet moved into the timing wheel.
+  struct alignas(64) Shard {
+    mutex mu;
+    std::vector<RCReference<TimerEntry>> timers TFRT_GUARDED_BY(mu);
+  };
+
+  // A level of the timing wheel. A slot at level `L` keeps timers expiring
+  // within a range of 64^L ticks. The bit `i` in `occupied` is set if the
+  // slot `i` is not empty.
+  struct Level {
+    uint64_t occupied = 0;
+    std::array<std::vector<RCReference<TimerEntry>>, kNumSlots> slots;
   };
+
   // Timer thread. If a timeout goes off, it calls the callback.
   void TimerThreadRun();
 
-  // Obtain the top timer (timer with the closest deadline) from the queue.
-  // Returns NULL if no active (not cancelled) timer found.
-  TimerEntry* getTopTimer();
+  // Moves timers from the insertion shards into the timing wheel.
+  void DrainShards();
+
+  // Adds a timer to the timing wheel, or to the `expired_` list if its
+  // deadline tick has already been processed.
+  void AddToWheel(RCReference<TimerEntry> timer);
+
+  // Processes all ticks up to `now_tick`, and moves expired timers to the
+  // `expired_` list.
+  void AdvanceTo(int64_t now_tick);
+
+  // Returns the next tick that has timers to expire or to move to the lower
+  // level of the timing wheel, or kNever if the timing wheel is empty.
+  int64_t NextEventTick() const;
+
+  static int64_t DeadlineTick(TimePoint deadline);
+  static int64_t NowTick();
 
   mutable mutex mu_;
   condition_variable cv_;
   std::thread timer_thread_;
-  std::atomic<bool> stop_{false};
-  std::priority_queue<RCReference<TimerEntry>,
-                      std::vector<RCReference<TimerEntry>>,
-                      TimerEntry::TimerEntryCompare>
-      timers_ TFRT_GUARDED_BY(mu_);
+  bool stop_ TFRT_GUARDED_BY(mu_) = false;
+
+  // The tick at which the timer thread will wake up, kAwake if it is not
+  // waiting, or kNever if it is waiting for a new timer.
+  std::atomic<int64_t> next_wakeup_tick_{kAwake};
+
+  // The number of timers in the insertion shards.
+  std::atomic<int64_t> num_pending_{0};
+  std::array<Shard, kNumShards> shards_;
+
+  // Timing wheel state, accessed only by the timer thread (and by the
+  // destructor after the timer thread is stopped).
+  int64_t current_tick_;
+  std::array<Level, kNumLevels> levels_;
+  std::vector<RCReference<TimerEntry>> expired_;
 };
 
 }  // namespace tfrt
@@ -20,14 +20,28 @@
 #ifndef TFRT_IO_BUFFERED_INPUT_STREAM_H_
 #define TFRT_IO_BUFFERED_INPUT_STREAM_H_
 
+#include <memory>
+
 #include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
 #include "tfrt/io/input_stream.h"
 
 namespace tfrt {
 namespace io {
 
+// Options of a BufferedInputStream which reads ahead of its consumer.
+struct ReadAheadOptions {
+  // The number of bytes read from the underlying stream at a time.
+  size_t block_size = 1024 * 1024;
+  // The maximum number of blocks buffered ahead of the consumer, including the
+  // block being consumed. A depth of 2 is double buffering.
+  int depth = 2;
+};
+
 class BufferedInputStream : public InputStream {
  public:
+  // Reads blocks from `input_stream` only when the consumer runs out of
+  // buffered bytes.
   explicit BufferedInputStream(std::unique_ptr<InputStream> input_stream,
                                size_t buffer_size, HostAllocator* allocator)
       : input_stream_(std::move(input_stream)),
@@ -37,9 +51,15 @@ class BufferedInputStream : public InputStream {
     buffer_ = allocator_->Allocate<char>(buffer_size_);
   }
 
-  ~BufferedInputStream() override {
-    allocator_->Deallocate(buffer_, buffer_size_);
-  }
+  // Reads blocks from `input_stream` ahead of the consumer on the blocking
+  // work queue of `host`, so that the next blocks are fetched while the
+  // consumer drains the current one. Blocks are read sequentially, one at a
+  // time. If the consumer catches up with a block whose read has not started,
+  // it reads the block itself instead of waiting for the queue.
+  BufferedInputStream(std::unique_ptr<InputStream> input_stream,
+                      const ReadAheadOptions& options, HostContext* host);
+
+  ~BufferedInputStream() override;
 
   // This class is not copyable or movable.
   BufferedInputStream(const BufferedInputStream&) = delete;
@@ -50,6 +70,10 @@ class BufferedInputStream : public InputStream {
   llvm::Expected<size_t> Tell() override;
 
  private:
+  class ReadAhead;
+
+  llvm::Expected<size_t> ReadFromBlocks(char* buf, size_t max_count);
+
   std::unique_ptr<InputStream> input_stream_;
   HostAllocator* allocator_;
   // The pointer to the buffer.
@@ -64,6 +88,12 @@ class BufferedInputStream : public InputStream {
   llvm::Expected<size_t> buffer_limit_ = 0;
   // Current position in this stream.
   size_t stream_pos_ = 0;
+
+  // The blocks read ahead, shared with the reads in flight. Null unless the
+  // stream reads ahead.
+  std::shared_ptr<ReadAhead> read_ahead_;
+  // The unread bytes of the block being consumed.
+  string_view block_;
 };
 
 }  // namespace io
@@ -19,12 +19,18 @@
 #ifndef TFRT_IO_FILE_SYSTEM_H_
 #define TFRT_IO_FILE_SYSTEM_H_
 
+#include <string>
+#include <vector>
+
 #include "llvm/ADT/StringMap.h"
+#include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/mutex.h"
 #include "tfrt/support/thread_annotations.h"
 
 namespace tfrt {
+class HostContext;
+
 namespace io {
 
 // The priority of a FileSystem instance is used by FileSystemRegistry::Register
@@ -51,6 +57,33 @@ class RandomAccessFile {
   // On error, llvm::Error is returned.
   virtual llvm::Expected<size_t> Read(char* buf, size_t max_count,
                                       size_t offset) const = 0;
+
+  // This method is the asynchronous version of Read(). The returned value
+  // becomes available with the number of bytes read, or with an error. `buf`
+  // and this file must stay valid until then.
+  //
+  // The default implementation runs Read() on the blocking work queue of
+  // `host`, or inline if that queue is full. File systems with asynchronous IO
+  // support override it to avoid blocking a thread per outstanding read.
+  virtual AsyncValueRef<size_t> ReadAsync(char* buf, size_t max_count,
+                                          size_t offset,
+                                          HostContext* host) const;
+};
+
+// An interface for a read-only region of memory that holds the contents of a
+// file, e.g. a memory-mapped file. The memory stays valid for the lifetime of
+// this object.
+class ReadOnlyMemoryRegion {
+ public:
+  explicit ReadOnlyMemoryRegion() {}
+
+  virtual ~ReadOnlyMemoryRegion() {}
+
+  // Returns a pointer to the beginning of the region.
+  virtual const void* data() const = 0;
+
+  // Returns the size of the region in bytes.
+  virtual size_t length() const = 0;
 };
 
 // An interface that declares operations to manage files in a file system.
@@ -68,6 +101,32 @@ class FileSystem {
   virtual llvm::Error NewRandomAccessFile(
       const std::string& path, std::unique_ptr<RandomAccessFile>* file) = 0;
 
+  // Creates a read-only memory region with the contents of the file at the
+  // given `path`. File systems that can map files into memory share the pages
+  // of the file between all the processes that map it.
+  //
+  // On success, stores a pointer to the new region in `region` and returns
+  // llvm::Error::success(). Otherwise, stores NULL in `region` and returns the
+  // error.
+  virtual llvm::Error NewReadOnlyMemoryRegion(
+      const std::string& path, std::unique_ptr<ReadOnlyMemoryRegion>* region) {
+    region->reset();
+    return MakeStringError("read-only memory regions are not supported for ",
+                           path);
+  }
+
+  // Stores the paths of the files that match `pattern` in `results`, sorted by
+  // name. The pattern may contain the wildcards `*`, `?` and `[...]`, which do
+  // not match the `/` separator.
+  //
+  // Returns an error if `pattern` is malformed or the file system can not be
+  // searched. It is not an error if no file matches.
+  virtual llvm::Error GetMatchingPaths(const std::string& pattern,
+                                       std::vector<std::string>* results) {
+    results->clear();
+    return MakeStringError("file patterns are not supported for ", pattern);
+  }
+
   // Returns the priority of this file system. The file system with the highest
   // priority will be used if multiple file systems have been registered for the
   // same scheme.
@@ -105,6 +164,10 @@ class FileSystemRegistry {
   // FileSystemRegistry::Register(...).
   FileSystem* Lookup(const std::string& scheme);
 
+  // Returns the file system registered for the scheme of `path`, which is the
+  // part before "://", or the empty scheme if `path` has none.
+  FileSystem* LookupForPath(const std::string& path);
+
  private:
   mutex mu_;
   llvm::StringMap<std::unique_ptr<FileSystem>> file_systems_
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares the ObjectStoreFileSystem class which reads objects from
+// an S3 or GCS compatible object store.
+
+#ifndef TFRT_IO_OBJECT_STORE_FILE_SYSTEM_H_
+#define TFRT_IO_OBJECT_STORE_FILE_SYSTEM_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tfrt/io/file_system.h"
+
+namespace tfrt {
+class HostContext;
+
+namespace io {
+
+// A connection to an object store, e.g. a keep-alive HTTP connection to an S3
+// or GCS compatible endpoint. A connection serves one request at a time.
+class ObjectStoreConnection {
+ public:
+  explicit ObjectStoreConnection() {}
+
+  virtual ~ObjectStoreConnection() {}
+
+  // Reads up to `max_count` bytes of `object` in `bucket` starting at `offset`
+  // into `buf`, e.g. with a ranged GET. Returns the number of bytes read, which
+  // is smaller than `max_count` only at the end of the object.
+  virtual llvm::Expected<size_t> ReadRange(const std::string& bucket,
+                                           const std::string& object,
+                                           size_t offset, size_t max_count,
+                                           char* buf) = 0;
+
+  // Returns the size of `object` in `bucket` in bytes, e.g. with a HEAD
+  // request. Returns an error if the object does not exist.
+  virtual llvm::Expected<size_t> GetObjectSize(const std::string& bucket,
+                                               const std::string& object) = 0;
+
+  // Stores the names of the objects in `bucket` which start with `prefix` in
+  // `objects`.
+  virtual llvm::Error ListObjects(const std::string& bucket,
+                                  const std::string& prefix,
+                                  std::vector<std::string>* objects) = 0;
+};
+
+struct ObjectStoreOptions {
+  // Reads are split into ranged requests of this many bytes, which are issued
+  // in parallel. Ranges are aligned to this size and cached as a whole.
+  size_t range_size = 8 * 1024 * 1024;
+  // The maximum number of connections to the object store. Connections are
+  // pooled and reused across reads and files.
+  int max_connections = 16;
+  // The number of bytes of object ranges cached in memory. Zero disables the
+  // cache. Objects are assumed not to change while they are read.
+  size_t cache_size = 256 * 1024 * 1024;
+};
+
+// This class reads objects from an object store with paths of the form
+// "<scheme>://<bucket>/<object>". The network protocol is implemented by the
+// ObjectStoreConnection returned by the connection factory, so that the
+// runtime does not depend on an HTTP client library.
+//
+// A read of a file is split into ranges of `range_size` bytes. The ranges
+// missing from the cache are requested in parallel on the blocking work queue
+// of the HostContext, each on a pooled connection, so that a single large
+// read is not limited by the throughput of a single connection.
+class ObjectStoreFileSystem : public FileSystem {
+ public:
+  using ConnectionFactory =
+      std::function<llvm::Expected<std::unique_ptr<ObjectStoreConnection>>()>;
+
+  ObjectStoreFileSystem(std::string scheme, ConnectionFactory factory,
+                        const ObjectStoreOptions& options, HostContext* host);
+
+  ~ObjectStoreFileSystem() override;
+
+  // This class is not copyable or movable.
+  ObjectStoreFileSystem(const ObjectStoreFileSystem&) = delete;
+  ObjectStoreFileSystem& operator=(const ObjectStoreFileSystem&) = delete;
+
+  // The returned file must not outlive this file system.
+  llvm::Error NewRandomAccessFile(
+      const std::string& path,
+      std::unique_ptr<RandomAccessFile>* file) override;
+
+  // The pattern may only contain wildcards in the object name.
+  llvm::Error GetMatchingPaths(const std::string& pattern,
+                               std::vector<std::string>* results) override;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace io
+}  // namespace tfrt
+
+#endif  // TFRT_IO_OBJECT_STORE_FILE_SYSTEM_H_
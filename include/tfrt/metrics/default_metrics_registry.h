@@ -0,0 +1,94 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares the default, in-memory MetricsRegistry.
+
+#ifndef TFRT_METRICS_DEFAULT_METRICS_REGISTRY_H_
+#define TFRT_METRICS_DEFAULT_METRICS_REGISTRY_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/metrics/metrics_registry.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace metrics {
+
+// A MetricsRegistry that keeps the values of all metrics in memory, and
+// exports snapshots of them in the Prometheus text format.
+//
+// Counters and histograms are sharded by the CPU of the calling thread, and
+// updated with relaxed atomic operations, so instrumenting hot paths never
+// takes a lock and threads on different CPUs don't contend for cache lines.
+// Integer gauges are a single atomic. String gauges take a lock, and are meant
+// for values that rarely change (e.g. versions).
+//
+// Metrics are owned by the registry and live as long as it does. Creating a
+// metric with the name of an existing metric of the same kind returns the
+// existing one (histograms keep their original buckets), so that the same
+// metric can be created in multiple places. A metric created with the name of
+// a metric of another kind works, but is not exported.
+class DefaultMetricsRegistry : public MetricsRegistry {
+ public:
+  DefaultMetricsRegistry();
+  ~DefaultMetricsRegistry() override;
+
+  Gauge<std::string>* NewStringGauge(std::string name) override;
+  Gauge<int64_t>* NewIntGauge(std::string name) override;
+  Histogram* NewHistogram(std::string name, const Buckets& buckets) override;
+  Counter* NewCounter(std::string name) override;
+
+  // Writes a snapshot of all metrics in the Prometheus text exposition format,
+  // sorted by name. Metric names are converted to valid Prometheus names by
+  // replacing unsupported characters with '_', e.g. "/tfrt/foo/bar" is
+  // exported as "tfrt_foo_bar". Histogram values equal to a bucket bound are
+  // counted in the bucket above it (see Buckets), unlike the inclusive "le"
+  // bounds of Prometheus. String gauges are exported as gauges with the value
+  // 1 and the string in a "value" label.
+  //
+  // Updates that race with the snapshot might be partially included, e.g. in
+  // a histogram bucket but not yet in its sum.
+  void WritePrometheusText(llvm::raw_ostream& os) const;
+
+  // Base class of the metrics owned by the registry.
+  class Metric;
+
+ private:
+  template <typename T>
+  T* GetOrCreate(std::string name, std::unique_ptr<T> metric);
+
+  mutable mutex mu_;
+  llvm::StringMap<std::unique_ptr<Metric>> metrics_ TFRT_GUARDED_BY(mu_);
+  // Metrics with the name of a metric of another kind.
+  std::vector<std::unique_ptr<Metric>> unexported_ TFRT_GUARDED_BY(mu_);
+};
+
+// Creates a DefaultMetricsRegistry and registers it as the global metrics
+// registry on the first call, and returns it. Metrics created before the
+// registration are not recorded, so this should be called early in main().
+// Must not be used together with RegisterMetricsRegistry().
+DefaultMetricsRegistry* RegisterDefaultMetricsRegistry();
+
+}  // namespace metrics
+}  // namespace tfrt
+
+#endif  // TFRT_METRICS_DEFAULT_METRICS_REGISTRY_H_
@@ -19,8 +19,10 @@
 #ifndef TFRT_METRICS_METRICS_H_
 #define TFRT_METRICS_METRICS_H_
 
+#include <cstdint>
 #include <string>
 
+#include "counter.h"
 #include "gauge.h"
 #include "histogram.h"
 
@@ -37,6 +39,15 @@ Gauge<T>* NewGauge(std::string name);
 template <>
 Gauge<std::string>* NewGauge(std::string name);
 
+template <>
+Gauge<int64_t>* NewGauge(std::string name);
+
+//===----------------------------------------------------------------------===//
+// Methods to create Counter metrics
+//===----------------------------------------------------------------------===//
+
+Counter* NewCounter(std::string name);
+
 //===----------------------------------------------------------------------===//
 // Methods to create Histogram metrics
 //===----------------------------------------------------------------------===//
@@ -19,8 +19,10 @@
 #ifndef TFRT_METRICS_METRICS_REGISTRY_H_
 #define TFRT_METRICS_METRICS_REGISTRY_H_
 
+#include <cstdint>
 #include <string>
 
+#include "counter.h"
 #include "gauge.h"
 #include "histogram.h"
 
@@ -33,7 +35,13 @@ class MetricsRegistry {
 
   virtual Gauge<std::string>* NewStringGauge(std::string name) = 0;
 
+  // Returns nullptr if the registry does not support integer gauges.
+  virtual Gauge<int64_t>* NewIntGauge(std::string name) { return nullptr; }
+
   virtual Histogram* NewHistogram(std::string name, const Buckets& buckets) = 0;
+
+  // Returns nullptr if the registry does not support counters.
+  virtual Counter* NewCounter(std::string name) { return nullptr; }
 };
 
 namespace internal {
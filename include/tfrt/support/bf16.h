@@ -19,6 +19,8 @@
 #ifndef TFRT_SUPPORT_BF16_H_
 #define TFRT_SUPPORT_BF16_H_
 
+#include <cstddef>
+
 #include "llvm/Support/raw_ostream.h"
 #include "tfrt/support/forward_decls.h"
 
@@ -34,6 +36,13 @@ struct bf16 {
   uint16_t value;
 };
 
+// Converts `n` values from `src` to `dst`, rounding to the nearest even
+// bf16 value. Uses SIMD instructions if the build targets them.
+void ConvertBuffer(const float *src, bf16 *dst, size_t n);
+
+// Converts `n` values from `src` to `dst`. The conversion is exact.
+void ConvertBuffer(const bf16 *src, float *dst, size_t n);
+
 inline raw_ostream &operator<<(raw_ostream &os, bf16 v) {
   return os << "bf16(" << v.value << ')';
 }
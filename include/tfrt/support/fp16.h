@@ -19,6 +19,8 @@
 #ifndef TFRT_SUPPORT_FP16_H_
 #define TFRT_SUPPORT_FP16_H_
 
+#include <cstddef>
+
 #include "llvm/Support/raw_ostream.h"
 #include "tfrt/support/forward_decls.h"
 
@@ -33,6 +35,13 @@ struct fp16 {
   uint16_t value;
 };
 
+// Converts `n` values from `src` to `dst`, rounding to the nearest even
+// fp16 value. Uses SIMD instructions if the build targets them.
+void ConvertBuffer(const float *src, fp16 *dst, size_t n);
+
+// Converts `n` values from `src` to `dst`. The conversion is exact.
+void ConvertBuffer(const fp16 *src, float *dst, size_t n);
+
 inline raw_ostream &operator<<(raw_ostream &os, fp16 v) {
   return os << "fp16(" << v.value << ')';
 }
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file defines the 8-bit floating types: f8e4m3fn and f8e5m2.
+
+#ifndef TFRT_SUPPORT_FP8_H_
+#define TFRT_SUPPORT_FP8_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/support/forward_decls.h"
+
+namespace tfrt {
+namespace detail {
+
+// Converts between float and an 8-bit floating point encoding with one sign
+// bit, `ExpBits` exponent bits and `MantBits` mantissa bits, rounding to the
+// nearest even value.
+//
+// If `HasInf` is true, the encoding follows IEEE 754: the largest exponent
+// encodes infinities and NaNs, and finite values that overflow round to
+// infinity. Otherwise only the all-ones pattern encodes NaN, and finite values
+// that overflow saturate to the largest finite value, which is the common
+// convention when quantizing to f8e4m3fn.
+template <int ExpBits, int MantBits, bool HasInf>
+struct Fp8Codec {
+  static constexpr int kBias = (1 << (ExpBits - 1)) - 1;
+  static constexpr uint8_t kMantMask = (1 << MantBits) - 1;
+  static constexpr uint8_t kExpMask = (1 << ExpBits) - 1;
+  static constexpr uint8_t kNaN = 0x7f;
+  static constexpr uint8_t kInf = kExpMask << MantBits;
+  static constexpr uint8_t kMaxFinite = HasInf ? kInf - 1 : kNaN - 1;
+
+  static uint8_t FromFloat(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    const uint8_t sign = (bits >> 24) & 0x80;
+    const int float_exp = (bits >> 23) & 0xff;
+    if (float_exp == 0xff) {
+      if (bits & 0x7fffff) return sign | kNaN;
+      return sign | (HasInf ? kInf : kNaN);
+    }
+    // Float subnormals are far below the smallest 8-bit subnormal.
+    if (float_exp == 0) return sign;
+
+    const uint32_t mant = (bits & 0x7fffff) | 0x800000;
+    // The biased exponent of the result, if it is normal.
+    int exp = float_exp - 127 + kBias;
+    int shift = 23 - MantBits;
+    if (exp < 1) {
+      shift += 1 - exp;
+      exp = 0;
+    } else {
+      // The implicit bit of `rounded` adds one to the exponent field.
+      exp -= 1;
+    }
+    if (shift > 24) return sign;
+
+    uint32_t rounded = mant >> shift;
+    const uint32_t remainder = mant & ((1u << shift) - 1);
+    const uint32_t half = 1u << (shift - 1);
+    if (remainder > half || (remainder == half && (rounded & 1))) ++rounded;
+
+    // A carry out of the mantissa increments the exponent field, and a
+    // subnormal that rounds up becomes the smallest normal value.
+    const uint32_t encoded = (static_cast<uint32_t>(exp) << MantBits) + rounded;
+    if (encoded > kMaxFinite) return sign | (HasInf ? kInf : kMaxFinite);
+    return sign | static_cast<uint8_t>(encoded);
+  }
+
+  static float ToFloat(uint8_t v) {
+    const bool negative = v & 0x80;
+    const int exp = (v >> MantBits) & kExpMask;
+    const int mant = v & kMantMask;
+    float result;
+    if (HasInf && exp == kExpMask) {
+      result = mant == 0 ? std::numeric_limits<float>::infinity()
+                         : std::numeric_limits<float>::quiet_NaN();
+    } else if (!HasInf && (v & 0x7f) == kNaN) {
+      result = std::numeric_limits<float>::quiet_NaN();
+    } else if (exp == 0) {
+      result = std::ldexp(static_cast<float>(mant), 1 - kBias - MantBits);
+    } else {
+      result = std::ldexp(static_cast<float>(mant | (1 << MantBits)),
+                          exp - kBias - MantBits);
+    }
+    return negative ? -result : result;
+  }
+};
+
+}  // namespace detail
+
+// 8-bit floating point with 4 exponent bits and 3 mantissa bits, without
+// infinities. Its largest finite value is 448.
+struct f8e4m3fn {
+  using Codec = detail::Fp8Codec</*ExpBits=*/4, /*MantBits=*/3,
+                                 /*HasInf=*/false>;
+
+  f8e4m3fn() : value(0) {}
+  explicit f8e4m3fn(uint8_t v) : value(v) {}
+
+  static f8e4m3fn FromFloat(float f) { return f8e4m3fn(Codec::FromFloat(f)); }
+  float ToFloat() const { return Codec::ToFloat(value); }
+
+  uint8_t value;
+};
+
+// 8-bit floating point with 5 exponent bits and 2 mantissa bits, i.e. the
+// upper byte of an IEEE 754 half. Its largest finite value is 57344.
+struct f8e5m2 {
+  using Codec = detail::Fp8Codec</*ExpBits=*/5, /*MantBits=*/2,
+                                 /*HasInf=*/true>;
+
+  f8e5m2() : value(0) {}
+  explicit f8e5m2(uint8_t v) : value(v) {}
+
+  static f8e5m2 FromFloat(float f) { return f8e5m2(Codec::FromFloat(f)); }
+  float ToFloat() const { return Codec::ToFloat(value); }
+
+  uint8_t value;
+};
+
+inline raw_ostream &operator<<(raw_ostream &os, f8e4m3fn v) {
+  return os << "f8e4m3fn(" << v.ToFloat() << ')';
+}
+
+inline raw_ostream &operator<<(raw_ostream &os, f8e5m2 v) {
+  return os << "f8e5m2(" << v.ToFloat() << ')';
+}
+
+}  // namespace tfrt
+
+#endif  // TFRT_SUPPORT_FP8_H_
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Declares helpers to discover the NUMA topology of the host, and to place
+// threads and memory on NUMA nodes.
+//
+// This is implemented for Linux without depending on libnuma. On other
+// platforms the host is reported as a single node, and placement requests are
+// ignored.
+
+#ifndef TFRT_SUPPORT_NUMA_H_
+#define TFRT_SUPPORT_NUMA_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+
+namespace tfrt {
+namespace numa {
+
+// Returns the CPUs of each NUMA node of the host, indexed by the node number.
+// Nodes without CPUs are skipped. Always returns at least one node.
+const std::vector<std::vector<int>>& GetNodeCpus();
+
+inline int GetNumNodes() { return GetNodeCpus().size(); }
+
+// Restricts the calling thread to the specified CPUs. Returns false if it is
+// not supported or failed.
+bool PinCurrentThreadToCpus(llvm::ArrayRef<int> cpus);
+
+// The NUMA node that the calling thread was assigned to with
+// SetCurrentThreadNode(), or -1 if it wasn't assigned to a node.
+int GetCurrentThreadNode();
+void SetCurrentThreadNode(int node);
+
+// Asks the kernel to allocate the pages of the page aligned memory range
+// [ptr, ptr + size) on `node`. Returns false if it is not supported or failed.
+bool BindMemoryToNode(void* ptr, size_t size, int node);
+
+}  // namespace numa
+}  // namespace tfrt
+
+#endif  // TFRT_SUPPORT_NUMA_H_
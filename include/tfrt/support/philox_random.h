@@ -25,7 +25,9 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <array>
+#include <cstring>
 
 #include "tfrt/support/forward_decls.h"
 
@@ -61,7 +63,64 @@ class PhiloxRandom {
     return cached_results_[next_result_index_++];
   }
 
+  // Skips the next `count` 128-bit samples of the stream. Fill functions
+  // consume whole samples (four 32-bit values), so copies of a generator which
+  // skip `offset / 4` samples fill the same values starting at `offset` (a
+  // multiple of 4) as one fill of the whole output. This allows parallel
+  // fills, e.g. one copy for each ParallelFor block.
+  void Skip(uint64_t count) {
+    uint64_t lo = counter_[0] | (static_cast<uint64_t>(counter_[1]) << 32);
+    uint64_t new_lo = lo + count;
+    counter_[0] = static_cast<uint32_t>(new_lo);
+    counter_[1] = static_cast<uint32_t>(new_lo >> 32);
+    if (new_lo < lo && ++counter_[2] == 0) ++counter_[3];
+  }
+
+  // Fills `output` with `n` random 32-bit values. Starts at the next 128-bit
+  // sample, values cached by operator() are not used.
+  //
+  // Computes kBatchSize samples at a time in a layout which the compiler can
+  // vectorize, which is several times faster than calling operator().
+  void FillUint32(uint32_t* output, size_t n) {
+    for (; n >= kBatchSize * kCounterSize; n -= kBatchSize * kCounterSize) {
+      ComputeRandomBatch(output);
+      output += kBatchSize * kCounterSize;
+    }
+    for (; n > 0; n -= std::min<size_t>(n, kCounterSize)) {
+      CounterType bits = computeRandomBits();
+      std::memcpy(output, bits.data(),
+                  std::min<size_t>(n, kCounterSize) * sizeof(uint32_t));
+      output += kCounterSize;
+    }
+  }
+
+  // Fills `output` with `n` random floats uniformly distributed in [0, 1).
+  void FillUniform(float* output, size_t n) {
+    static_assert(sizeof(float) == sizeof(uint32_t), "");
+    auto* bits = reinterpret_cast<uint32_t*>(output);
+    FillUint32(bits, n);
+    for (size_t i = 0; i < n; ++i) output[i] = Uint32ToFloat(bits[i]);
+  }
+
+  // Fills `output` with `n` random floats from the standard normal
+  // distribution, using the Box-Muller transform.
+  void FillNormal(float* output, size_t n) {
+    FillUniform(output, n);
+    for (size_t i = 0; i + 1 < n; i += 2) {
+      BoxMuller(output[i], output[i + 1], &output[i], &output[i + 1]);
+    }
+    if (n % 2 == 1) {
+      float u[2];
+      FillUniform(u, 2);
+      float unused;
+      BoxMuller(u[0], u[1], &output[n - 1], &unused);
+    }
+  }
+
  private:
+  // Number of samples computed at a time by the fill functions.
+  static constexpr int kBatchSize = 8;
+
   // Uses the same constants as recommended by the original paper.
   static constexpr uint32_t kPhiloxW32A = 0x9E3779B9;
   static constexpr uint32_t kPhiloxW32B = 0xBB67AE85;
@@ -100,6 +159,63 @@ class PhiloxRandom {
     return counter;
   }
 
+  // Computes kBatchSize groups of four random numbers into `output`. The same
+  // as calling computeRandomBits() kBatchSize times, but with one array per
+  // counter word, so that each round is vectorized across the batch.
+  void ComputeRandomBatch(uint32_t* output) {
+    uint32_t c0[kBatchSize], c1[kBatchSize], c2[kBatchSize], c3[kBatchSize];
+    for (int i = 0; i < kBatchSize; ++i) {
+      c0[i] = counter_[0];
+      c1[i] = counter_[1];
+      c2[i] = counter_[2];
+      c3[i] = counter_[3];
+      SkipOne();
+    }
+
+    KeyType key = key_;
+    for (int round = 0; round < 10; ++round) {
+      for (int i = 0; i < kBatchSize; ++i) {
+        const uint64_t product0 = static_cast<uint64_t>(kPhiloxM4x32A) * c0[i];
+        const uint64_t product1 = static_cast<uint64_t>(kPhiloxM4x32B) * c2[i];
+        const uint32_t next0 =
+            static_cast<uint32_t>(product1 >> 32) ^ c1[i] ^ key[0];
+        const uint32_t next2 =
+            static_cast<uint32_t>(product0 >> 32) ^ c3[i] ^ key[1];
+        c1[i] = static_cast<uint32_t>(product1);
+        c3[i] = static_cast<uint32_t>(product0);
+        c0[i] = next0;
+        c2[i] = next2;
+      }
+      RaiseKey(&key);
+    }
+
+    for (int i = 0; i < kBatchSize; ++i) {
+      output[4 * i + 0] = c0[i];
+      output[4 * i + 1] = c1[i];
+      output[4 * i + 2] = c2[i];
+      output[4 * i + 3] = c3[i];
+    }
+  }
+
+  // Converts 32 random bits to a float uniformly distributed in [0, 1), by
+  // filling the mantissa of a float in [1, 2).
+  static float Uint32ToFloat(uint32_t x) {
+    const uint32_t bits = (x & 0x7fffffu) | 0x3f800000u;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result - 1.0f;
+  }
+
+  // Transforms two uniform floats in [0, 1) into two standard normal floats.
+  static void BoxMuller(float u0, float u1, float* n0, float* n1) {
+    constexpr float kEpsilon = 1.0e-7f;
+    constexpr float kTwoPi = 6.283185307179586f;
+    const float radius = sqrtf(-2.0f * logf(u0 < kEpsilon ? kEpsilon : u0));
+    const float theta = kTwoPi * u1;
+    *n0 = radius * sinf(theta);
+    *n1 = radius * cosf(theta);
+  }
+
   // Helper function to skip the next sample of 128-bits in the current stream.
   void SkipOne() {
     if (++counter_[0] == 0) {
@@ -194,6 +194,21 @@ Expected<std::vector<uint64_t>> ReadBTFOffsets(std::istream* stream);
 Expected<DenseHostTensor> ReadDHTFromBTF(std::istream* stream, uint64_t offset,
                                          HostContext* host);
 
+// Memory-maps the BTF-file at `path`. The returned buffer keeps the mapping
+// alive. The pages of the file are only read when they are accessed, and are
+// only copied if they are written to.
+Expected<RCReference<HostBuffer>> MapBTFFile(const std::string& path);
+
+// Reads the TENSOR_RECORD_OFFSETs of all tensors from a mapped BTF-file.
+Expected<std::vector<uint64_t>> ReadBTFOffsets(const HostBuffer& file);
+
+// Reads the TENSOR_RECORD at the given offset of a mapped BTF-file as a DHT
+// whose HostBuffer is a slice of `file`, without copying the tensor data.
+// Returns an error if the record is truncated, or if its data is not aligned
+// for its dtype.
+Expected<DenseHostTensor> ReadDHTFromBTF(const RCReference<HostBuffer>& file,
+                                         uint64_t offset);
+
 // Writes a BTF-file, with file header (offsets) and tensor records. Currently
 // only supports DenseHostTensors.
 Error WriteTensorsToBTF(std::ostream* stream, ArrayRef<const Tensor*> tensors);
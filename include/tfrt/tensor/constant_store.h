@@ -0,0 +1,103 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares ConstantStore, which shares the data of identical
+// constant tensors across all HostContexts and models of a process.
+
+#ifndef TFRT_TENSOR_CONSTANT_STORE_H_
+#define TFRT_TENSOR_CONSTANT_STORE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "tfrt/host_context/host_buffer.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+#include "tfrt/tensor/dense_view.h"
+
+namespace tfrt {
+
+class HostContext;
+
+// A process-wide store of constant tensors, keyed by their content. Tensors
+// with the same dtype, shape and data share a single buffer, no matter which
+// HostContext or model created them. The store holds a reference to every
+// buffer, so shared buffers are never forwarded to op results and modified in
+// place. Buffers which are only referenced by the store are released when the
+// store grows.
+//
+// BTF-files mapped through the store are shared as well: a file which is
+// mapped more than once is only mapped once, and its tensors point into the
+// mapping instead of being copied.
+class ConstantStore {
+ public:
+  // Tensors smaller than this are not worth hashing, and are copied instead.
+  static constexpr size_t kMinSharedSizeInBytes = 4096;
+
+  static ConstantStore& Global();
+
+  // Returns a tensor with the data of `view`. Tensors of at least
+  // kMinSharedSizeInBytes are shared with identical tensors in the store, and
+  // otherwise copied into a buffer that is independent of `host`. Smaller
+  // tensors are always copied into a buffer allocated from `host`.
+  Expected<DenseHostTensor> GetOrCopy(const DenseView& view, HostContext* host);
+
+  // Returns an identical tensor from the store if there is one, and otherwise
+  // adds `tensor` to the store and returns it.
+  DenseHostTensor GetOrInsert(DenseHostTensor tensor);
+
+  // Returns a private read-only mapping of the BTF-file at `path`, which is
+  // shared with all live mappings of the same path.
+  Expected<RCReference<HostBuffer>> MapBTFFile(const std::string& path);
+
+  // Returns the number of distinct tensors in the store.
+  size_t size() const;
+
+ private:
+  // Minimum number of tensors or files before pruning.
+  static constexpr size_t kMinPruneSize = 64;
+
+  struct Entry {
+    TensorMetadata metadata;
+    RCReference<HostBuffer> buffer;
+  };
+
+  ConstantStore() = default;
+
+  // Returns an entry with `metadata` and `data` in the bucket of `hash`.
+  const Entry* Find(uint64_t hash, const TensorMetadata& metadata,
+                    const void* data) const TFRT_REQUIRES(mutex_);
+
+  // Drops the tensors and files only referenced by the store. Returns their
+  // buffers so that they are released outside of the lock.
+  std::vector<RCReference<HostBuffer>> Prune() TFRT_REQUIRES(mutex_);
+
+  mutable mutex mutex_;
+  llvm::DenseMap<uint64_t, llvm::SmallVector<Entry, 1>> entries_
+      TFRT_GUARDED_BY(mutex_);
+  size_t num_entries_ TFRT_GUARDED_BY(mutex_) = 0;
+  llvm::StringMap<RCReference<HostBuffer>> files_ TFRT_GUARDED_BY(mutex_);
+  size_t prune_size_ TFRT_GUARDED_BY(mutex_) = kMinPruneSize;
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_TENSOR_CONSTANT_STORE_H_
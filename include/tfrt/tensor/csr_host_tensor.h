@@ -0,0 +1,78 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file defines the CsrHostTensor class.
+
+#ifndef TFRT_TENSOR_CSR_HOST_TENSOR_H_
+#define TFRT_TENSOR_CSR_HOST_TENSOR_H_
+
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+
+class CooHostTensor;
+class TensorConversionFnRegistry;
+
+void RegisterCsrHostTensorConversionFn(TensorConversionFnRegistry* registry);
+
+// Represents a sparse matrix in the compressed sparse row (CSR) layout. The
+// column indices and values of the non-zero elements of row i are at
+// [RowOffsets()[i], RowOffsets()[i + 1]) of ColIndices() and Values(), sorted
+// by column. Unlike a CooHostTensor, a row is accessed without a search, which
+// suits row-major kernels such as sparse x dense matrix multiplication.
+class CsrHostTensor final : public HostTensor,
+                            public TensorTraits<CsrHostTensor> {
+ public:
+  // Empty and null by default.
+  CsrHostTensor() = default;
+
+  // `row_offsets` is an int64 tensor of shape [rows + 1], `col_indices` an
+  // int64 tensor of shape [nnz] and `values` a tensor of shape [nnz].
+  CsrHostTensor(const TensorShape& shape, DType dtype,
+                DenseHostTensor&& row_offsets, DenseHostTensor&& col_indices,
+                DenseHostTensor&& values)
+      : HostTensor(TensorMetadata(dtype, shape)),
+        row_offsets_(std::move(row_offsets)),
+        col_indices_(std::move(col_indices)),
+        values_(std::move(values)) {
+    assert(shape.GetRank() == 2);
+  }
+
+  // Converts a rank-2 CooHostTensor, whose indices do not need to be sorted.
+  // Returns None if the tensor can not be allocated.
+  static llvm::Optional<CsrHostTensor> CreateFromCoo(const CooHostTensor& coo,
+                                                     HostContext* host);
+
+  // Raw access to data.
+  const DenseHostTensor* RowOffsets() const { return &row_offsets_; }
+  const DenseHostTensor* ColIndices() const { return &col_indices_; }
+  const DenseHostTensor* Values() const { return &values_; }
+  DenseHostTensor* Values() { return &values_; }
+
+  void Print(raw_ostream& os) const override;
+
+  // Tensor type for CsrHostTensor.
+  static const char* name() { return "CsrHost"; }
+
+ private:
+  DenseHostTensor row_offsets_;
+  DenseHostTensor col_indices_;
+  DenseHostTensor values_;
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_TENSOR_CSR_HOST_TENSOR_H_
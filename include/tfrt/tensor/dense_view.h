@@ -14,12 +14,15 @@
  * limitations under the License.
  */
 
-// This file defines class DenseView and class template DenseTensorView.
+// This file defines class DenseView, class template DenseTensorView and class
+// StridedDenseView.
 
 #ifndef TFRT_TENSOR_DENSE_VIEW_H_
 #define TFRT_TENSOR_DENSE_VIEW_H_
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
 #include "tfrt/tensor/tensor_metadata.h"
 
 namespace tfrt {
@@ -117,6 +120,59 @@ class DenseTensorView {
   friend class DenseView;
 };
 
+// StridedDenseView is a view to data with a shape, whose consecutive elements
+// along dimension i are strides()[i] elements apart. A stride of 0 repeats the
+// same elements along a dimension. It describes slices, transposes and
+// broadcasts of dense data without copying it.
+//
+// The underlying data must outlive the view.
+class StridedDenseView {
+ public:
+  // A view to the densely laid out data of `dense_view`.
+  explicit StridedDenseView(const DenseView& dense_view);
+
+  // `strides` are in elements, not in bytes.
+  StridedDenseView(DType dtype, ArrayRef<Index> shape, ArrayRef<Index> strides,
+                   const void* data);
+
+  DType dtype() const { return metadata_.dtype; }
+
+  const TensorShape& shape() const { return metadata_.shape; }
+
+  ArrayRef<Index> strides() const { return strides_; }
+
+  // The address of the first element.
+  const void* data() const { return data_; }
+
+  // Returns true if the elements are densely laid out in row-major order.
+  bool IsContiguous() const;
+
+  // Returns the view of the elements [begin[i], begin[i] + sizes[i]) along
+  // each dimension i.
+  StridedDenseView Slice(ArrayRef<Index> begin, ArrayRef<Index> sizes) const;
+
+  // Returns the view whose dimension i is the dimension perm[i] of this view.
+  StridedDenseView Transpose(ArrayRef<int> perm) const;
+
+  // Returns the view broadcast to `shape` with the numpy broadcasting rules,
+  // or None if the shapes are not compatible.
+  llvm::Optional<StridedDenseView> BroadcastTo(const TensorShape& shape) const;
+
+  template <typename T>
+  const T& ElementAt(ArrayRef<Index> index) const {
+    assert(dtype() == GetDType<T>());
+    assert(index.size() == strides_.size());
+    Index offset = 0;
+    for (size_t i = 0; i < index.size(); ++i) offset += index[i] * strides_[i];
+    return static_cast<const T*>(data_)[offset];
+  }
+
+ private:
+  TensorMetadata metadata_;
+  llvm::SmallVector<Index, 4> strides_;
+  const void* data_;
+};
+
 }  // namespace tfrt
 
 #endif  // TFRT_TENSOR_DENSE_VIEW_H_
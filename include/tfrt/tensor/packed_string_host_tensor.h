@@ -0,0 +1,113 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file defines the PackedStringHostTensor class.
+
+#ifndef TFRT_TENSOR_PACKED_STRING_HOST_TENSOR_H_
+#define TFRT_TENSOR_PACKED_STRING_HOST_TENSOR_H_
+
+#include <cstdint>
+
+#include "tfrt/dtype/dtype.h"
+#include "tfrt/host_context/host_buffer.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/tensor/conversion_registry.h"
+#include "tfrt/tensor/host_tensor.h"
+
+namespace tfrt {
+
+class StringHostTensor;
+
+void RegisterPackedStringHostTensorConversionFn(
+    TensorConversionFnRegistry* registry);
+
+// Represents an immutable tensor of strings. The characters of all strings are
+// stored in one contiguous buffer, in row major order with no separators, and
+// the boundaries of the strings in an array of NumElements() + 1 offsets into
+// it, like the string arrays of Apache Arrow. String i is the range
+// [offsets()[i], offsets()[i + 1]) of the characters.
+//
+// Unlike StringHostTensor, whose strings are allocated one by one, creating a
+// PackedStringHostTensor takes two allocations, and copies share the buffers.
+class PackedStringHostTensor final
+    : public HostTensor,
+      public TensorTraits<PackedStringHostTensor> {
+ public:
+  // Creates a tensor that holds a copy of `strings`. Return None on failure.
+  static llvm::Optional<PackedStringHostTensor> Create(
+      const TensorShape& shape, ArrayRef<string_view> strings,
+      HostContext* host);
+
+  // Creates a tensor that holds a copy of the strings of `tensor`. Return None
+  // on failure.
+  static llvm::Optional<PackedStringHostTensor> Create(
+      const StringHostTensor& tensor, HostContext* host);
+
+  // `offsets` must hold NumElements() + 1 non-decreasing uint64_t's, the first
+  // being 0 and the last being the size of `chars`.
+  PackedStringHostTensor(const TensorShape& shape,
+                         RCReference<HostBuffer> chars,
+                         RCReference<HostBuffer> offsets)
+      : HostTensor(TensorMetadata(DType(DType::String), shape)),
+        chars_(std::move(chars)),
+        offsets_(std::move(offsets)) {
+    assert(offsets_ && offsets_->size() ==
+                           (shape.GetNumElements() + 1) * sizeof(uint64_t));
+  }
+
+  PackedStringHostTensor(PackedStringHostTensor&& other) = default;
+  PackedStringHostTensor& operator=(PackedStringHostTensor&& other) = default;
+
+  PackedStringHostTensor(const PackedStringHostTensor& other) = delete;
+  PackedStringHostTensor& operator=(const PackedStringHostTensor& other) =
+      delete;
+
+  // Returns a tensor that shares the buffers of this tensor.
+  PackedStringHostTensor CopyRef() const {
+    return PackedStringHostTensor(shape(), chars_, offsets_);
+  }
+
+  // Returns the string at `index` in row major order.
+  string_view operator[](size_t index) const {
+    auto offsets = this->offsets();
+    return string_view(chars() + offsets[index],
+                       offsets[index + 1] - offsets[index]);
+  }
+
+  // Returns the characters of all strings. Null if all strings are empty.
+  const char* chars() const {
+    return chars_ ? static_cast<const char*>(chars_->data()) : nullptr;
+  }
+  ArrayRef<uint64_t> offsets() const { return offsets_->CastAs<uint64_t>(); }
+
+  // The buffers of the tensor, e.g. to serialize it without copies. The chars
+  // buffer is null if all strings are empty.
+  const RCReference<HostBuffer>& chars_buffer() const { return chars_; }
+  const RCReference<HostBuffer>& offsets_buffer() const { return offsets_; }
+
+  void Print(raw_ostream& os) const override;
+
+  // Tensor type for PackedStringHostTensor.
+  static const char* name() { return "PackedStringHost"; }
+
+ private:
+  RCReference<HostBuffer> chars_;
+  RCReference<HostBuffer> offsets_;
+};
+
+}  // namespace tfrt
+
+#endif  // TFRT_TENSOR_PACKED_STRING_HOST_TENSOR_H_
@@ -49,7 +49,7 @@ struct TensorMetadata {
   bool IsInvalid() const { return tfrt::IsInvalid(dtype); }
 
   size_t GetHostSizeInBytes() const {
-    return GetHostSize(dtype) * shape.GetNumElements();
+    return tfrt::GetHostSizeInBytes(dtype, shape.GetNumElements());
   }
 
   TensorShape shape;
@@ -54,13 +54,32 @@ std::string SerializeTensorMetadata(const TensorMetadata& md);
 llvm::Expected<TensorMetadata> DeserializeTensorMetadata(
     string_view serialized);
 
+// Serializes `dht` for scatter/gather IO, e.g. as RPC payloads. Returns the
+// slices to write in order: the serialized metadata, followed by the
+// HostBuffer of `dht` itself, so that the tensor data is not copied.
 llvm::Expected<llvm::SmallVector<RCReference<HostBuffer>, 4>>
 SerializeDenseHostTensor(const DenseHostTensor& dht, HostContext* host);
 
+// Deserializes the slices returned by SerializeDenseHostTensor(). The result
+// shares the data slice.
 llvm::Expected<DenseHostTensor> DeserializeDenseHostTensor(
     const llvm::SmallVector<RCReference<HostBuffer>, 4>& serialized,
     HostContext* host);
 
+// Deserializes a DenseHostTensor that shares `data` instead of copying it.
+// Returns an error if the size of `data` does not match the metadata, or if
+// `data` is not aligned for the dtype.
+llvm::Expected<DenseHostTensor> DeserializeDenseHostTensor(
+    string_view serialized_metadata, RCReference<HostBuffer> data);
+
+// Allocates an uninitialized HostBuffer for the data of the DenseHostTensor
+// whose serialized metadata is `serialized_metadata`, sized and aligned like
+// the buffer of DenseHostTensor::CreateUninitialized(). Receivers can read the
+// data slice from the wire straight into it, and then deserialize the tensor
+// without copies.
+llvm::Expected<RCReference<HostBuffer>> AllocateDenseHostTensorData(
+    string_view serialized_metadata, HostContext* host);
+
 }  // namespace tfrt
 
 #endif  // TFRT_SUPPORT_BEF_SERIALIZE_H_
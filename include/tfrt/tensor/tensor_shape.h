@@ -135,6 +135,9 @@ class TensorShape {
   };
 
   struct RepExternal {
+    // `rank` dimensions followed by the number of elements, which is computed
+    // once on construction because these shapes are too big to multiply out
+    // cheaply on every query.
     size_t* dims;
 
     // FIXME: This isn't correct for big endian systems.  static_asserts should
@@ -323,8 +326,10 @@ inline TensorShape::TensorShape(ArrayRef<T> dims) {
   }
 
   // Otherwise, nothing fits, use the most general representation.
-  auto* elts = new size_t[rank];
+  auto* elts = new size_t[rank + 1];
   memcpy(elts, dims.data(), sizeof(size_t) * rank);
+  elts[rank] = 1;
+  for (size_t i = 0; i != rank; ++i) elts[rank] *= elts[i];
   representation_.rep_external.dims = elts;
   representation_.rep_external.rank = rank;
   representation_.rep_external.kind = RepKind::kRepExternal;
@@ -360,9 +365,9 @@ inline TensorShape::TensorShape(const TensorShape& rhs) {
   memcpy(&representation_, &rhs.representation_, sizeof(representation_));
   if (rhs.IsRepresentationExternal()) {
     auto rank = GetRank();
-    representation_.rep_external.dims = new size_t[rank];
+    representation_.rep_external.dims = new size_t[rank + 1];
     memcpy(representation_.rep_external.dims,
-           rhs.representation_.rep_external.dims, rank * sizeof(size_t));
+           rhs.representation_.rep_external.dims, (rank + 1) * sizeof(size_t));
   }
 }
 
@@ -382,9 +387,9 @@ inline TensorShape& TensorShape::operator=(const TensorShape& rhs) {
   memcpy(&representation_, &rhs.representation_, sizeof(representation_));
   if (rhs.IsRepresentationExternal()) {
     auto rank = GetRank();
-    representation_.rep_external.dims = new size_t[rank];
+    representation_.rep_external.dims = new size_t[rank + 1];
     memcpy(representation_.rep_external.dims,
-           rhs.representation_.rep_external.dims, rank * sizeof(size_t));
+           rhs.representation_.rep_external.dims, (rank + 1) * sizeof(size_t));
   }
   return *this;
 }
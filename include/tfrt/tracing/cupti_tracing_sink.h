@@ -0,0 +1,55 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// CUPTI tracing sink
+//
+// This file declares the interface of the CUPTI tracing sink, which records a
+// unified host and device timeline.
+//
+// Host activities are recorded like in the chrome tracing sink. In addition,
+// each tracing scope pushes a CUPTI external correlation id, and the CUPTI
+// activity API records the start and end of the GPU kernels, memcpys and
+// memsets launched while the scope is active. Device activities are attributed
+// to the innermost enclosing scope (i.e. the TFRT kernel or op which issued
+// them) and are connected to it with flow arrows in the trace, which shows GPU
+// idle gaps caused by host-side dispatch.
+//
+// libcupti.so is loaded when tracing is first enabled, so the sink doesn't
+// require CUDA at link time. Host and device timestamps are both taken from
+// the CUPTI clock.
+//
+// Usage: replace simple_tracing_sink dependency of the binary with
+// cupti_tracing_sink and enable tracing. When tracing is disabled, the trace is
+// written to trace.json as undeclared test output, or to stdout otherwise.
+
+#ifndef TFRT_TRACING_CUPTI_TRACING_SINK_H_
+#define TFRT_TRACING_CUPTI_TRACING_SINK_H_
+
+#include "tfrt/support/forward_decls.h"
+
+namespace tfrt {
+namespace tracing {
+
+// Flushes the pending CUPTI activity buffers and writes the host and device
+// activities recorded so far to `os` in the Chrome trace event format, which
+// can be loaded in Perfetto or chrome://tracing. Host activities are in process
+// 0, activities of device N are in process N + 1 with one thread per stream.
+void WriteCuptiTrace(raw_ostream& os);
+
+}  // namespace tracing
+}  // namespace tfrt
+
+#endif  // TFRT_TRACING_CUPTI_TRACING_SINK_H_
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Hardware performance counters
+//
+// This file declares a thin wrapper around the Linux perf_event interface which
+// counts CPU cycles, retired instructions, last level cache misses and branch
+// misses of the calling thread. Tracing sinks read the counters at the
+// boundaries of tracing scopes to attribute them to the traced activities.
+//
+// Only user space is counted, which is permitted for the own process with the
+// default perf_event_paranoid setting. Counters are not available on other
+// platforms, in most containers without CAP_PERFMON, and in virtual machines
+// without a virtualized PMU.
+
+#ifndef TFRT_TRACING_PERF_COUNTERS_H_
+#define TFRT_TRACING_PERF_COUNTERS_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include "tfrt/support/forward_decls.h"
+
+namespace tfrt {
+namespace tracing {
+
+// Values of the hardware performance counters.
+struct PerfCounterValues {
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t llc_misses = 0;
+  uint64_t branch_misses = 0;
+
+  PerfCounterValues operator-(const PerfCounterValues& other) const {
+    return {cycles - other.cycles, instructions - other.instructions,
+            llc_misses - other.llc_misses, branch_misses - other.branch_misses};
+  }
+};
+
+// Hardware performance counters of the thread which created them.
+class PerfCounters {
+ public:
+  // Opens and starts the counters for the calling thread. Returns an error if
+  // the cycle counter can't be opened. The other counters are optional and
+  // read as zero if the CPU doesn't provide them.
+  static Expected<std::unique_ptr<PerfCounters>> Create();
+
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // Returns the counts since the counters were created. Must be called on the
+  // thread which created the counters. The counters are read together, so that
+  // they cover the same interval.
+  PerfCounterValues Read() const;
+
+ private:
+  PerfCounters() = default;
+
+  // File descriptors of cycles (the group leader), instructions, LLC misses
+  // and branch misses, -1 for counters which are not available.
+  std::array<int, 4> fds_ = {-1, -1, -1, -1};
+};
+
+}  // namespace tracing
+}  // namespace tfrt
+
+#endif  // TFRT_TRACING_PERF_COUNTERS_H_
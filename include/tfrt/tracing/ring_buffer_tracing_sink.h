@@ -0,0 +1,58 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Ring buffer tracing sink
+//
+// This file declares the interface of the ring buffer tracing sink, a tracing
+// sink with low and bounded overhead that can be left enabled in production.
+//
+// Each thread records its activities into a preallocated ring buffer, which
+// keeps its most recent kRingBufferEventsPerThread activities. Activity names
+// are interned once and referred to by id, and timestamps are read from the
+// time stamp counter where available. Recording an activity doesn't allocate
+// or write to memory shared between threads, except when a thread records an
+// activity name it hasn't seen before.
+//
+// Usage: depend on ring_buffer_tracing_sink, enable tracing and call
+// WriteRingBufferTracingSnapshot() whenever a trace is needed.
+
+#ifndef TFRT_TRACING_RING_BUFFER_TRACING_SINK_H_
+#define TFRT_TRACING_RING_BUFFER_TRACING_SINK_H_
+
+#include <cstddef>
+
+#include "tfrt/support/forward_decls.h"
+
+namespace tfrt {
+namespace tracing {
+
+// Number of activities kept for each thread.
+inline constexpr size_t kRingBufferEventsPerThread = 1 << 14;
+
+// Maximum number of distinct activity names. Later names are recorded as
+// "<overflow>".
+inline constexpr size_t kRingBufferMaxNames = 1 << 16;
+
+// Writes the activities currently kept in the ring buffers to `os` in the
+// Chrome trace event format, which can be loaded in Perfetto or
+// chrome://tracing. Does not stop or pause tracing, activities recorded
+// concurrently may or may not be included.
+void WriteRingBufferTracingSnapshot(raw_ostream& os);
+
+}  // namespace tracing
+}  // namespace tfrt
+
+#endif  // TFRT_TRACING_RING_BUFFER_TRACING_SINK_H_
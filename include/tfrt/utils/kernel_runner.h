@@ -17,7 +17,9 @@
 #ifndef TFRT_UTILS_KERNEL_RUNNER_H_
 #define TFRT_UTILS_KERNEL_RUNNER_H_
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <type_traits>
 
@@ -36,6 +38,25 @@
 #include "tfrt/tensor/dense_host_tensor.h"
 
 namespace tfrt {
+
+// Statistics of the runs of a kernel measured by KernelRunner::Benchmark().
+struct KernelBenchmarkStats {
+  int num_runs = 0;
+  // Wall time of one run in nanoseconds.
+  double min_ns = 0;
+  double median_ns = 0;
+  double p90_ns = 0;
+  double max_ns = 0;
+  double mean_ns = 0;
+  double stddev_ns = 0;
+  // Average number and size of the host allocations of one run, or -1 if the
+  // runner uses a HostContext provided by the caller.
+  double allocations_per_run = -1;
+  double allocated_bytes_per_run = -1;
+};
+
+raw_ostream& operator<<(raw_ostream& os, const KernelBenchmarkStats& stats);
+
 /**
  * KernelRunner allows user to run individual TFRT kernels in isolation in C++.
  * This is particularly useful for testing kernels that do not have a
@@ -57,6 +78,15 @@ namespace tfrt {
  *
  * ```
  * KernelRunner can also be used to run synchronous TFRT kernels.
+ *
+ * Benchmark() runs a kernel repeatedly and reports its run time and
+ * allocations:
+ *
+ * ```
+ * KernelRunner runner("tfrt_test.sum");
+ * runner.SetArgs(1, 2, 3);
+ * llvm::outs() << runner.Benchmark(1) << "\n";
+ * ```
  */
 
 class KernelRunner {
@@ -97,6 +127,13 @@ class KernelRunner {
 
   void Run(size_t num_results);
 
+  // Runs the kernel `num_warmup_runs` times, and then `num_runs` times while
+  // measuring the wall time of every run. The runs of an async kernel include
+  // waiting for its results. The results of the last run are available with
+  // GetResultAt().
+  KernelBenchmarkStats Benchmark(size_t num_results, int num_runs = 100,
+                                 int num_warmup_runs = 10);
+
   template <typename T>
   const T& GetResultAt(int index) {
     return is_sync_kernel() ? sync_results_[index].get<T>()
@@ -149,6 +186,13 @@ class KernelRunner {
     return kernel_fn_.is<SyncKernelImplementation>();
   }
 
+  // Host allocations made through the default HostContext.
+  struct AllocationCounts {
+    std::atomic<int64_t> allocations{0};
+    std::atomic<int64_t> bytes{0};
+  };
+
+  AllocationCounts allocation_counts_;
   std::unique_ptr<HostContext> default_host_context_;
   HostContext* host_;
   KernelImplementation kernel_fn_;
@@ -69,6 +69,13 @@ class TfrtMlirRunner {
       return *this;
     }
 
+    // Sets the CreateWorkQueue() config of the work queue that runs the MLIR
+    // function, e.g. "mstd:4,4". Defaults to the single-threaded work queue.
+    Builder& set_work_queue_config(string_view config) {
+      work_queue_config_ = config.str();
+      return *this;
+    }
+
     // Adds an input for the MLIR function. The inputs are wrapped in
     // AsyncValues before being passed in to the compiled function. The order of
     // the set calls must correspond exactly to the order in which the MLIR
@@ -90,18 +97,20 @@ class TfrtMlirRunner {
    private:
     std::string mlir_input_;
     std::string fn_name_;
+    std::string work_queue_config_ = "s";
     std::vector<RCReference<AsyncValue>> inputs_;
     mlir::MLIRContext* mlir_context_ = nullptr;
     std::unique_ptr<HostContext> host_context_ = nullptr;
   };
 
-  // Runs the MLIR function on TFRT and returns the outputs.
+  // Runs the MLIR function on TFRT, waits for the outputs and returns them.
   llvm::SmallVector<RCReference<AsyncValue>> Run();
 
  private:
   // Use TfrtMlirRunner::Builder to get a TfrtMlirRunner object.
   TfrtMlirRunner(const std::string& fn_name, BefBuffer bef_buffer,
-                 std::vector<RCReference<AsyncValue>> inputs);
+                 std::vector<RCReference<AsyncValue>> inputs,
+                 string_view work_queue_config);
 
   std::string fn_name_;
   std::vector<RCReference<AsyncValue>> inputs_;
@@ -0,0 +1,76 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// MNIST inference at batch 1 and batch 32, run by
+// mlir_tests/bef_perf/model_perf.py with bef_executor --benchmark_runs. Each
+// run of a function is one inference request; the weights and the inputs are
+// filled with constants, since only the timing matters.
+
+func.func @mnist_inference_batch_1() -> !t.tensor {
+  %ch0 = tfrt.new.chain
+  %one = tfrt.constant.f32 1.0
+
+  %w1 = tfrt_dht.create_uninitialized_tensor.f32.2 [784 : i64, 512 : i64]
+  %ch1 = tfrt_dht.fill_tensor_with_constant.f32 %w1, %ch0 1.0 : f32
+  %b1 = tfrt_dht.create_uninitialized_tensor.f32.1 [512 : i64]
+  %ch2 = tfrt_dht.fill_tensor_with_constant.f32 %b1, %ch0 1.0 : f32
+  %w2 = tfrt_dht.create_uninitialized_tensor.f32.2 [512 : i64, 10 : i64]
+  %ch3 = tfrt_dht.fill_tensor_with_constant.f32 %w2, %ch0 1.0 : f32
+  %b2 = tfrt_dht.create_uninitialized_tensor.f32.1 [10 : i64]
+  %ch4 = tfrt_dht.fill_tensor_with_constant.f32 %b2, %ch0 1.0 : f32
+  %features = tfrt_dht.create_uninitialized_tensor.f32.2 [1 : i64, 784 : i64]
+  %ch5 = tfrt_dht.fill_tensor_with_constant.f32 %features, %ch0 1.0 : f32
+  %ch6 = tfrt.merge.chains %ch1, %ch2, %ch3, %ch4, %ch5 : !tfrt.chain, !tfrt.chain, !tfrt.chain, !tfrt.chain, !tfrt.chain
+
+  %target_shape_b1 = ts.build_shape [1 : i64, 512 : i64]
+  %activation1 = "tfrt_test.broadcast.f32.2"(%b1, %target_shape_b1, %ch6) : (!t.tensor, !ts.shape, !tfrt.chain) -> !t.tensor
+  %ch7 = "tfrt_test.matmul.f32.2"(%one, %features, %w1, %one, %activation1, %ch6) : (f32, !t.tensor, !t.tensor, f32, !t.tensor, !tfrt.chain) -> !tfrt.chain
+  %ch8 = "tfrt_test.relu_inplace.f32"(%activation1, %ch7) : (!t.tensor, !tfrt.chain) -> !tfrt.chain
+
+  %target_shape_b2 = ts.build_shape [1 : i64, 10 : i64]
+  %activation2 = "tfrt_test.broadcast.f32.2"(%b2, %target_shape_b2, %ch6) : (!t.tensor, !ts.shape, !tfrt.chain) -> !t.tensor
+  %ch9 = "tfrt_test.matmul.f32.2"(%one, %activation1, %w2, %one, %activation2, %ch8) : (f32, !t.tensor, !t.tensor, f32, !t.tensor, !tfrt.chain) -> !tfrt.chain
+
+  %argmax = "tfrt_test.argmax.f32.2"(%activation2, %ch9) : (!t.tensor, !tfrt.chain) -> !t.tensor
+  tfrt.return %argmax : !t.tensor
+}
+
+func.func @mnist_inference_batch_32() -> !t.tensor {
+  %ch0 = tfrt.new.chain
+  %one = tfrt.constant.f32 1.0
+
+  %w1 = tfrt_dht.create_uninitialized_tensor.f32.2 [784 : i64, 512 : i64]
+  %ch1 = tfrt_dht.fill_tensor_with_constant.f32 %w1, %ch0 1.0 : f32
+  %b1 = tfrt_dht.create_uninitialized_tensor.f32.1 [512 : i64]
+  %ch2 = tfrt_dht.fill_tensor_with_constant.f32 %b1, %ch0 1.0 : f32
+  %w2 = tfrt_dht.create_uninitialized_tensor.f32.2 [512 : i64, 10 : i64]
+  %ch3 = tfrt_dht.fill_tensor_with_constant.f32 %w2, %ch0 1.0 : f32
+  %b2 = tfrt_dht.create_uninitialized_tensor.f32.1 [10 : i64]
+  %ch4 = tfrt_dht.fill_tensor_with_constant.f32 %b2, %ch0 1.0 : f32
+  %features = tfrt_dht.create_uninitialized_tensor.f32.2 [32 : i64, 784 : i64]
+  %ch5 = tfrt_dht.fill_tensor_with_constant.f32 %features, %ch0 1.0 : f32
+  %ch6 = tfrt.merge.chains %ch1, %ch2, %ch3, %ch4, %ch5 : !tfrt.chain, !tfrt.chain, !tfrt.chain, !tfrt.chain, !tfrt.chain
+
+  %target_shape_b1 = ts.build_shape [32 : i64, 512 : i64]
+  %activation1 = "tfrt_test.broadcast.f32.2"(%b1, %target_shape_b1, %ch6) : (!t.tensor, !ts.shape, !tfrt.chain) -> !t.tensor
+  %ch7 = "tfrt_test.matmul.f32.2"(%one, %features, %w1, %one, %activation1, %ch6) : (f32, !t.tensor, !t.tensor, f32, !t.tensor, !tfrt.chain) -> !tfrt.chain
+  %ch8 = "tfrt_test.relu_inplace.f32"(%activation1, %ch7) : (!t.tensor, !tfrt.chain) -> !tfrt.chain
+
+  %target_shape_b2 = ts.build_shape [32 : i64, 10 : i64]
+  %activation2 = "tfrt_test.broadcast.f32.2"(%b2, %target_shape_b2, %ch6) : (!t.tensor, !ts.shape, !tfrt.chain) -> !t.tensor
+  %ch9 = "tfrt_test.matmul.f32.2"(%one, %activation1, %w2, %one, %activation2, %ch8) : (f32, !t.tensor, !t.tensor, f32, !t.tensor, !tfrt.chain) -> !tfrt.chain
+
+  %argmax = "tfrt_test.argmax.f32.2"(%activation2, %ch9) : (!t.tensor, !tfrt.chain) -> !t.tensor
+  tfrt.return %argmax : !t.tensor
+}
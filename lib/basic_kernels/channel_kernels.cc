@@ -0,0 +1,98 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements host executor kernels for channels, which stream values
+// between concurrently running functions.
+
+#include <cstdint>
+#include <utility>
+
+#include "tfrt/basic_kernels/basic_kernels.h"
+#include "tfrt/concurrency/async_channel.h"
+#include "tfrt/host_context/async_value.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/ref_count.h"
+
+namespace tfrt {
+namespace {
+
+// A channel of values of any type, shared by the kernels using it.
+class AsyncValueChannel : public ReferenceCounted<AsyncValueChannel>,
+                          public ::tsl::AsyncChannel<RCReference<AsyncValue>> {
+ public:
+  using AsyncChannel::AsyncChannel;
+};
+
+Expected<RCReference<AsyncValueChannel>> TFRTChannelCreate(
+    Attribute<int32_t> capacity) {
+  if (*capacity <= 0)
+    return MakeStringError("channel capacity must be positive, got ",
+                           *capacity);
+  return TakeRef(new AsyncValueChannel(*capacity));
+}
+
+// The returned chain becomes available when the channel accepts the value.
+AsyncValueRef<Chain> TFRTChannelSend(
+    Argument<RCReference<AsyncValueChannel>> channel, RemainingArguments args) {
+  assert(args.size() == 2 && "args should contain the value and a chain");
+  return (*channel)->Send(FormRef(args.values()[0]));
+}
+
+// The result becomes available when a value is received. It is an OutOfRange
+// error when the channel is closed and drained.
+void TFRTChannelReceive(Argument<RCReference<AsyncValueChannel>> channel,
+                        Argument<Chain> chain, RemainingResults results) {
+  assert(results.size() == 1 && "results should contain one AsyncValue");
+  auto value = (*channel)->Receive();
+  if (value.IsConcrete()) {
+    results[0] = std::move(*value);
+    return;
+  }
+  // Errors are forwarded as is, instead of copying them for every receiver.
+  if (value.IsError()) {
+    results[0] = value.ReleaseRCRef();
+    return;
+  }
+  value.AndThen([value = value.CopyRef(),
+                 result = results.AllocateIndirectResultAt(0)] {
+    if (value.IsError())
+      result->ForwardTo(value.CopyRCRef());
+    else
+      result->ForwardTo(std::move(*value));
+  });
+}
+
+Chain TFRTChannelClose(Argument<RCReference<AsyncValueChannel>> channel,
+                       Argument<Chain> chain) {
+  (*channel)->Close();
+  return Chain();
+}
+
+}  // namespace
+
+//===----------------------------------------------------------------------===//
+// Registration
+//===----------------------------------------------------------------------===//
+
+void RegisterChannelKernels(KernelRegistry* registry) {
+  registry->AddKernel("tfrt.channel.create", TFRT_KERNEL(TFRTChannelCreate));
+  registry->AddKernel("tfrt.channel.send", TFRT_KERNEL(TFRTChannelSend));
+  registry->AddKernel("tfrt.channel.receive", TFRT_KERNEL(TFRTChannelReceive));
+  registry->AddKernel("tfrt.channel.close", TFRT_KERNEL(TFRTChannelClose));
+}
+
+}  // namespace tfrt
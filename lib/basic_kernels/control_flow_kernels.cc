@@ -255,15 +255,14 @@ static void TFRTWhileInlineImpl(
     // Move the results of the body, excluding the last one which is the
     // condition for the next iteration, to the arguments for the next
     // iteration.
-    body_args = std::move(body_results);
+    std::swap(body_args, body_results);
     body_arg_views.clear();
     for (auto& arg : body_args) {
       body_arg_views.push_back(arg.get());
     }
 
-    // Reallocate the `body_results` vector for the next iteration.
-    body_results.clear();  // NOLINT: supressing use-after-move as clear()
-                           // reinitialize the state.
+    // Reuse the buffer of the previous arguments for the next results.
+    body_results.clear();
     body_results.resize(body_args.size() + 1);
 
     if (!condition->IsAvailable()) {
@@ -474,8 +473,10 @@ static void TFRTOnce(RemainingArguments args, RemainingResults results,
   llvm::copy(resource->results, results.values().begin());
 }
 
-// This is a helper function that runs a block of iterations and sets up a
-// callback to run the next block at the end.
+// This is a helper function that runs blocks of iterations. Blocks run back to
+// back in the caller thread as long as the body completes synchronously, and a
+// callback to run the next block is set up when the loop-carried arguments are
+// not available yet.
 static void TFRTRepeatI32Block(
     int32_t start, int32_t block_size, int32_t count_value,
     const ExecutionContext& exec_ctx, RCReference<const Function> body_fn_ref,
@@ -489,59 +490,69 @@ static void TFRTRepeatI32Block(
   results.resize(result_refs.size());
   auto num_fn_args = args.size();
 
-  auto end = std::min(start + block_size, count_value);
+  for (;;) {
+    auto end = std::min(start + block_size, count_value);
+
+    for (int i = start; i < end; ++i) {
+      if (auto cancel_av = exec_ctx.GetCancelAsyncValue()) {
+        // Cancellation detected. DropRef on args if needed, set results to
+        // the cancel async value, and break out.
+        for (int arg = 0; arg != num_fn_args; ++arg) {
+          // If this is not the first iteration, destroy the loop-carried
+          // args. The first iteration uses TFRTRepeatI32's args, which we
+          // can't destroy.
+          if (i > 0) passed_args[arg]->DropRef();
+        }
+
+        for (auto& result : result_refs) {
+          result->ForwardTo(FormRef(cancel_av));
+        }
+        return;
+      }
+
+      body_fn_ref->Execute(exec_ctx, passed_args, results);
 
-  for (int i = start; i < end; ++i) {
-    if (auto cancel_av = exec_ctx.GetCancelAsyncValue()) {
-      // Cancellation detected. DropRef on args if needed, set results to
-      // the cancel async value, and break out.
       for (int arg = 0; arg != num_fn_args; ++arg) {
         // If this is not the first iteration, destroy the loop-carried
         // args. The first iteration uses TFRTRepeatI32's args, which we
         // can't destroy.
         if (i > 0) passed_args[arg]->DropRef();
-      }
 
-      for (auto& result : result_refs) {
-        result->ForwardTo(FormRef(cancel_av));
+        // If this is not the last iteration, set up for the next
+        // iteration by copying this iteration's results to the next
+        // iteration's args.
+        if (i + 1 != count_value) {
+          passed_args[arg] = results[arg].release();
+        }
       }
-      return;
     }
 
-    body_fn_ref->Execute(exec_ctx, passed_args, results);
-
-    for (int arg = 0; arg != num_fn_args; ++arg) {
-      // If this is not the first iteration, destroy the loop-carried
-      // args. The first iteration uses TFRTRepeatI32's args, which we
-      // can't destroy.
-      if (i > 0) passed_args[arg]->DropRef();
-
-      // If this is not the last iteration, set up for the next
-      // iteration by copying this iteration's results to the next
-      // iteration's args.
-      if (i + 1 != count_value) {
-        passed_args[arg] = results[arg].release();
+    // Forward result_refs to the actual result values from the last iteration.
+    if (end >= count_value) {
+      for (int i = 0, e = result_refs.size(); i != e; ++i) {
+        result_refs[i]->ForwardTo(std::move(results[i]));
       }
+      return;
     }
-  }
 
-  // Forward result_refs to the actual result values from the last iteration.
-  if (end >= count_value) {
-    for (int i = 0, e = result_refs.size(); i != e; ++i) {
-      result_refs[i]->ForwardTo(std::move(results[i]));
-    }
-    return;
-  } else {
     assert(num_fn_args > 0);
+    start = end;
+
+    // If the body completed synchronously, run the next block right away.
+    // Going through AndThen() would copy the arguments and recurse once per
+    // block.
+    if (passed_args[0]->IsAvailable()) continue;
+
     passed_args[0]->AndThen(
-        [end, block_size, count_value, exec_ctx,
+        [start, block_size, count_value, exec_ctx,
          body_fn_ref = std::move(body_fn_ref),
          arg_refs = RCArray<AsyncValue>(llvm::makeArrayRef(passed_args)),
          result_refs = std::move(result_refs)]() mutable {
-          TFRTRepeatI32Block(end, block_size, count_value, exec_ctx,
+          TFRTRepeatI32Block(start, block_size, count_value, exec_ctx,
                              std::move(body_fn_ref), std::move(arg_refs),
                              std::move(result_refs));
         });
+    return;
   }
 }
 
@@ -648,6 +659,15 @@ static void TFRTAliasValue(Chain chain, RemainingArguments args,
   results[0] = FormRef(args.values()[0]);
 }
 
+// tfrt.select returns the first or the second value based on a condition. The
+// values are forwarded, so this works for values of any type.
+static void TFRTSelect(Argument<bool> condition, RemainingArguments args,
+                       RemainingResults results) {
+  assert((args.size() == 2) && "args should contain two AsyncValues");
+  assert((results.size() == 1) && "results should contain one AsyncValue");
+  results[0] = FormRef(args.values()[*condition ? 0 : 1]);
+}
+
 // This is the entrypoint to the library.
 void RegisterControlFlowKernels(KernelRegistry* registry) {
   registry->AddKernel("tfrt.new.chain", TFRT_KERNEL(TFRTNewChain));
@@ -658,6 +678,7 @@ void RegisterControlFlowKernels(KernelRegistry* registry) {
   registry->AddKernel("tfrt.if", TFRT_KERNEL(TFRTIf));
   registry->AddKernel("tfrt.cond", TFRT_KERNEL(TFRTIf));
   registry->AddKernel("tfrt.case", TFRT_KERNEL(TFRTCase));
+  registry->AddKernel("tfrt.select", TFRT_KERNEL(TFRTSelect));
   registry->AddKernel("tfrt.while", TFRT_KERNEL(TFRTWhile));
   registry->AddKernel("tfrt.once", TFRT_KERNEL(TFRTOnce));
 }
@@ -70,7 +70,7 @@ TFRTDialect::TFRTDialect(mlir::MLIRContext *context)
   allowUnknownOperations();
 
   addTypes<compiler::ChainType, compiler::StringType, compiler::TensorTypeType,
-           compiler::DeviceType>();
+           compiler::DeviceType, compiler::ChannelType>();
 
   addInterfaces<TFRTInlinerInterface>();
 
@@ -87,6 +87,7 @@ mlir::Type TFRTDialect::parseType(mlir::DialectAsmParser &parser) const {
   if (spec == "string") return compiler::StringType::get(getContext());
   if (spec == "tensor_type") return compiler::TensorTypeType::get(getContext());
   if (spec == "device") return compiler::DeviceType::get(getContext());
+  if (spec == "channel") return compiler::ChannelType::get(getContext());
   if (auto type = mlir::Dialect::parseType(parser)) return type;
 
   mlir::Location loc = parser.getEncodedSourceLoc(parser.getNameLoc());
@@ -104,6 +105,8 @@ void TFRTDialect::printType(mlir::Type type,
     printer << "tensor_type";
   } else if (type.isa<compiler::DeviceType>()) {
     printer << "device";
+  } else if (type.isa<compiler::ChannelType>()) {
+    printer << "channel";
   } else {
     llvm_unreachable("unknown tfrt type");
   }
@@ -14,6 +14,7 @@
 
 // This file implements core parallel kernels.
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 
@@ -27,35 +28,96 @@
 namespace tfrt {
 namespace {
 
+//--------------------------------------------------------------------------- //
+// The body function is called once for every block of the user specified size,
+// but consecutive blocks are grouped into a single ParallelFor task when there
+// are many more blocks than worker threads, so that small blocks do not pay
+// the task scheduling cost one by one.
+//
+// Blocks of a parallel for nested in the block of another parallel for that
+// already has a block for each worker thread run sequentially in the caller
+// thread, instead of oversubscribing the work queue.
+//--------------------------------------------------------------------------- //
+
+// The number of blocks of the parallel for whose body runs in this thread, or
+// zero if the thread does not run a parallel for body.
+static thread_local size_t enclosing_num_blocks = 0;
+
+class ParallelForBlocks {
+ public:
+  ParallelForBlocks(size_t total_size, size_t block_size)
+      : total_size_(total_size),
+        block_size_(std::max<size_t>(block_size, 1)),
+        num_blocks_((total_size + block_size_ - 1) / block_size_) {}
+
+  size_t num_blocks() const { return num_blocks_; }
+
+  // Returns true if the blocks should run in the caller thread because an
+  // enclosing parallel for already keeps all worker threads busy.
+  bool RunInline(const ExecutionContext& exec_ctx) const {
+    return enclosing_num_blocks >= exec_ctx.host()->GetNumWorkerThreads();
+  }
+
+  // Calls `fn` with the [start, end) range of each block in [first, last).
+  template <typename Fn>
+  void ForEach(size_t first, size_t last, Fn fn) const {
+    size_t prev_num_blocks = enclosing_num_blocks;
+    enclosing_num_blocks = num_blocks_;
+    for (size_t i = first; i < last; ++i)
+      fn(i * block_size_, std::min(total_size_, (i + 1) * block_size_));
+    enclosing_num_blocks = prev_num_blocks;
+  }
+
+ private:
+  size_t total_size_;
+  size_t block_size_;
+  size_t num_blocks_;
+};
+
+// Packs parallel block arguments into async values and calls `body_fn`.
+static void ExecuteParallelForBlock(
+    const ExecutionContext& exec_ctx, size_t start, size_t end, size_t offset,
+    ArrayRef<AsyncValue*> args, const Function* body_fn,
+    MutableArrayRef<RCReference<AsyncValue>> fn_results) {
+  auto start_arg = MakeAvailableAsyncValueRef<int32_t>(
+      static_cast<int32_t>(start + offset));
+  auto end_arg =
+      MakeAvailableAsyncValueRef<int32_t>(static_cast<int32_t>(end + offset));
+
+  llvm::SmallVector<AsyncValue*, 6> fn_args = {start_arg.GetAsyncValue(),
+                                               end_arg.GetAsyncValue()};
+  for (AsyncValue* arg : args) fn_args.push_back(arg);
+
+  body_fn->Execute(exec_ctx, fn_args, fn_results);
+}
+
 //--------------------------------------------------------------------------- //
 // Executes parallel for operation with an asynchronous body function: body
 // function returns a chain to signal its completion.
 //--------------------------------------------------------------------------- //
 static AsyncValueRef<Chain> ExecuteAsyncParallelForBody(
-    const ExecutionContext& exec_ctx, size_t total_size, size_t offset,
-    ParallelFor::BlockSizes& block_sizes, RemainingArguments args,
-    const Function* body_fn) {
-  // Parallel for block function.
-  auto compute = [exec_ctx, offset, body_fn,
-                  args = RCArray<AsyncValue>(args.values())](size_t start,
-                                                             size_t end) {
-    // Pack parallel block arguments into async values.
-    auto start_arg = MakeAvailableAsyncValueRef<int32_t>(
-        static_cast<int32_t>(start + offset));
-    auto end_arg =
-        MakeAvailableAsyncValueRef<int32_t>(static_cast<int32_t>(end + offset));
-
-    llvm::SmallVector<AsyncValue*, 6> fn_args = {start_arg.GetAsyncValue(),
-                                                 end_arg.GetAsyncValue()};
-    for (AsyncValue* arg : args.values()) fn_args.push_back(arg);
-
-    // Function returns single AsyncValueRef<Chain>.
-    llvm::SmallVector<RCReference<AsyncValue>, 1> fn_results;
-    fn_results.resize(1);
-    body_fn->Execute(exec_ctx, fn_args, fn_results);
-    assert(fn_results.size() == 1);
-
-    return AsyncValueRef<Chain>(std::move(fn_results[0]));
+    const ExecutionContext& exec_ctx, const ParallelForBlocks& blocks,
+    size_t offset, RemainingArguments args, const Function* body_fn) {
+  // Parallel for task function, runs a range of blocks.
+  auto compute = [exec_ctx, blocks, offset, body_fn,
+                  args = RCArray<AsyncValue>(args.values())](size_t first,
+                                                             size_t last) {
+    // Function returns single AsyncValueRef<Chain> for each block.
+    llvm::SmallVector<RCReference<AsyncValue>, 4> chains;
+    blocks.ForEach(first, last, [&](size_t start, size_t end) {
+      llvm::SmallVector<RCReference<AsyncValue>, 1> fn_results;
+      fn_results.resize(1);
+      ExecuteParallelForBlock(exec_ctx, start, end, offset, args.values(),
+                              body_fn, fn_results);
+      chains.push_back(std::move(fn_results[0]));
+    });
+
+    if (chains.size() == 1) return AsyncValueRef<Chain>(std::move(chains[0]));
+
+    auto done = MakeConstructedAsyncValueRef<Chain>();
+    RunWhenReady(chains,
+                 [done = done.CopyRef()]() { done.SetStateConcrete(); });
+    return done;
   };
 
   // Return ready chain when all parallel for blocks are completed.
@@ -63,10 +125,20 @@ static AsyncValueRef<Chain> ExecuteAsyncParallelForBody(
     return Chain();
   };
 
+  if (blocks.RunInline(exec_ctx)) {
+    auto done = MakeConstructedAsyncValueRef<Chain>();
+    compute(0, blocks.num_blocks()).AndThen([done = done.CopyRef()]() {
+      done.SetStateConcrete();
+    });
+    return done;
+  }
+
   // Launch parallel for operation.
   ParallelFor parallel_for(exec_ctx);
-  return parallel_for.Execute<Chain, Chain>(
-      total_size, block_sizes, std::move(compute), std::move(on_done));
+  return parallel_for.Execute<Chain, Chain>(blocks.num_blocks(),
+                                            ParallelFor::BlockSizes::Min(1),
+                                            std::move(compute),
+                                            std::move(on_done));
 }
 
 //--------------------------------------------------------------------------- //
@@ -75,37 +147,32 @@ static AsyncValueRef<Chain> ExecuteAsyncParallelForBody(
 // in the caller thread.
 //--------------------------------------------------------------------------- //
 static AsyncValueRef<Chain> ExecuteSyncParallelForBody(
-    const ExecutionContext& exec_ctx, size_t total_size, size_t offset,
-    ParallelFor::BlockSizes& block_sizes, RemainingArguments args,
-    const Function* body_fn) {
-  // Parallel for block function.
-  auto compute = [exec_ctx, offset, body_fn,
-                  args = RCArray<AsyncValue>(args.values())](size_t start,
-                                                             size_t end) {
-    // Pack parallel block arguments into async values.
-    auto start_arg = MakeAvailableAsyncValueRef<int32_t>(
-        static_cast<int32_t>(start + offset));
-    auto end_arg =
-        MakeAvailableAsyncValueRef<int32_t>(static_cast<int32_t>(end + offset));
-
-    llvm::SmallVector<AsyncValue*, 6> fn_args = {start_arg.GetAsyncValue(),
-                                                 end_arg.GetAsyncValue()};
-    for (AsyncValue* arg : args.values()) fn_args.push_back(arg);
-
-    // Function must have empty results.
-    llvm::SmallVector<RCReference<AsyncValue>, 0> fn_results;
-    body_fn->Execute(exec_ctx, fn_args, fn_results);
-    assert(fn_results.empty());
+    const ExecutionContext& exec_ctx, const ParallelForBlocks& blocks,
+    size_t offset, RemainingArguments args, const Function* body_fn) {
+  // Parallel for task function, runs a range of blocks.
+  auto compute = [exec_ctx, blocks, offset, body_fn,
+                  args = RCArray<AsyncValue>(args.values())](size_t first,
+                                                             size_t last) {
+    blocks.ForEach(first, last, [&](size_t start, size_t end) {
+      // Function must have empty results.
+      ExecuteParallelForBlock(exec_ctx, start, end, offset, args.values(),
+                              body_fn, {});
+    });
   };
 
+  if (blocks.RunInline(exec_ctx)) {
+    compute(0, blocks.num_blocks());
+    return MakeAvailableAsyncValueRef<Chain>();
+  }
+
   // Mark result chain completed when all parallel for blocks are completed.
   auto done = MakeConstructedAsyncValueRef<Chain>();
   auto on_done = [done = done.CopyRef()]() { done.SetStateConcrete(); };
 
   // Launch parallel for operation.
   ParallelFor parallel_for(exec_ctx);
-  parallel_for.Execute(total_size, block_sizes, std::move(compute),
-                       std::move(on_done));
+  parallel_for.Execute(blocks.num_blocks(), ParallelFor::BlockSizes::Min(1),
+                       std::move(compute), std::move(on_done));
 
   return done;
 }
@@ -123,16 +190,15 @@ static AsyncValueRef<Chain> TFRTParallelFor(const ExecutionContext& exec_ctx,
   const size_t total_size = *end - *start;
   const size_t offset = *start;
 
-  auto fixed_block_sizes = ParallelFor::BlockSizes::Fixed(*block_size);
+  ParallelForBlocks blocks(total_size, *block_size);
 
   if (body_fn->result_types().empty()) {
-    return ExecuteSyncParallelForBody(exec_ctx, total_size, offset,
-                                      fixed_block_sizes, args, body_fn);
+    return ExecuteSyncParallelForBody(exec_ctx, blocks, offset, args, body_fn);
 
   } else if (body_fn->result_types().size() == 1) {
     assert(body_fn->result_types()[0].GetName() == "!tfrt.chain");
-    return ExecuteAsyncParallelForBody(exec_ctx, total_size, offset,
-                                       fixed_block_sizes, args, body_fn);
+    return ExecuteAsyncParallelForBody(exec_ctx, blocks, offset, args,
+                                       body_fn);
 
   } else {
     return MakeErrorAsyncValueRef(
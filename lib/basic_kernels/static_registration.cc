@@ -29,6 +29,7 @@ static void RegisterKernels(KernelRegistry* registry) {
   RegisterControlFlowKernels(registry);
   RegisterParallelKernels(registry);
   RegisterDeviceKernels(registry);
+  RegisterChannelKernels(registry);
 }
 
 TFRT_STATIC_KERNEL_REGISTRATION(RegisterKernels);
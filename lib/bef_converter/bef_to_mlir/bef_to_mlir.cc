@@ -834,6 +834,9 @@ mlir::Operation* BEFFunctionReader::ReadKernel(
 
   auto location = location_reader->ReadLocation(kernel.kernel_location());
 
+  // Load the dialect of the kernel if it is registered but not loaded yet, so
+  // that the op is created as a registered op.
+  context_.getOrLoadDialect(name.split('.').first);
   mlir::OperationState state(location, name);
 
   // Resolve arguments
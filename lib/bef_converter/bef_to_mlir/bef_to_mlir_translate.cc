@@ -35,9 +35,12 @@ mlir::OwningOpRef<mlir::ModuleOp> BEFToMLIRTranslate(
   RegisterTFRTDialects(registry);
   RegisterTFRTCompiledDialects(registry);
   context->appendDialectRegistry(registry);
-  for (const auto &dialect_name : context->getAvailableDialects()) {
-    context->getOrLoadDialect(dialect_name);
-  }
+  // Only load the dialects the converter creates types and ops of directly.
+  // The dialects of kernels and types are loaded when the BEF file uses them,
+  // which avoids initializing all registered dialects (e.g. linalg and vector)
+  // for every translation.
+  context->getOrLoadDialect("func");
+  context->getOrLoadDialect("corert");
 
   const llvm::MemoryBuffer *input =
       source_mgr.getMemoryBuffer(source_mgr.getMainFileID());
@@ -16,6 +16,8 @@
 
 #include "bef_attr_emitter.h"
 
+#include "llvm/ADT/DenseMap.h"
+
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinAttributes.h"
@@ -414,13 +416,21 @@ size_t BefAttrEmitter::EmitAggregatedAttribute(mlir::ArrayAttr attr) {
   size_t offset_offset;
   const size_t offset = EncodeAggregatedAttrHeader(
       GetMaximumAlignment(attr), element_count, &offset_offset);
+
+  // Repeated elements (e.g. the same shape or dtype for several operands) are
+  // emitted once and share their offset. Elements are only shared within the
+  // aggregate, so that it stays self-contained.
+  llvm::SmallDenseMap<mlir::Attribute, AttrSizeT, 8> element_offsets;
   for (auto element : attr) {
-    // Reserve a space for BEFAttributeType (1B)
-    EmitByte(kDummyByte);
+    auto it = element_offsets.find(element);
+    if (it == element_offsets.end()) {
+      // Reserve a space for BEFAttributeType (1B)
+      EmitByte(kDummyByte);
+      it = element_offsets.try_emplace(element, EmitAttribute(element)).first;
+    }
 
-    EncodeAggregatedAttrEntryTypeAndOffset(offset, &offset_offset,
-                                           GetBefAttributeType(element),
-                                           EmitAttribute(element));
+    EncodeAggregatedAttrEntryTypeAndOffset(
+        offset, &offset_offset, GetBefAttributeType(element), it->second);
   }
   EncodeAggregatedAttrLength(offset);
   return offset;
@@ -438,6 +448,9 @@ size_t BefAttrEmitter::EmitSymbolRefAttribute(
   size_t serialized_id = compilation_units.SerializedSymbolId(symbol);
   EmitVbrInt(serialized_id);
 
+  // Emit the content fingerprint of the compilation unit.
+  EmitVbrInt(compilation_units.SerializedFingerprint(symbol));
+
   // Length of the root symbol name.
   EmitVbrInt(symbol.getRootReference().getValue().size());
 
@@ -19,6 +19,8 @@
 #include <string>
 #include <utility>
 
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Block.h"
 #include "mlir/IR/BuiltinOps.h"
@@ -48,6 +50,10 @@ size_t BefCompilationUnits::SerializedSymbolId(mlir::SymbolRefAttr symbol) {
   return Serialize(symbol).id;
 }
 
+size_t BefCompilationUnits::SerializedFingerprint(mlir::SymbolRefAttr symbol) {
+  return Serialize(symbol).fingerprint;
+}
+
 size_t BefCompilationUnits::SerializedSymbolSize(mlir::SymbolRefAttr symbol) {
   return Serialize(symbol).symbol_size;
 }
@@ -103,7 +109,16 @@ const BefCompilationUnits::Serialized& BefCompilationUnits::Serialize(
 
   size_t id = serialized_.size();
   size_t operation_size = str.size() - symbol_size;
-  Serialized serialized{id, symbol_size, operation_size, std::move(str)};
+
+  // Symbol names are concatenated in `str`, hash the symbol reference as
+  // printed to tell apart e.g. @ab::@c and @a::@bc.
+  std::string content;
+  llvm::raw_string_ostream(content)
+      << symbol << string_view(str).drop_front(symbol_size);
+  size_t fingerprint = static_cast<size_t>(llvm::xxHash64(content));
+
+  Serialized serialized{id, fingerprint, symbol_size, operation_size,
+                        std::move(str)};
 
   auto emplaced = serialized_.try_emplace(symbol, std::move(serialized));
   assert(emplaced.second && "emplace must be successful");
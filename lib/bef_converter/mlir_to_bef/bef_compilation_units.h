@@ -33,6 +33,7 @@ class BefCompilationUnits {
   explicit BefCompilationUnits(mlir::ModuleOp module) : module_(module) {}
 
   size_t SerializedSymbolId(mlir::SymbolRefAttr symbol);
+  size_t SerializedFingerprint(mlir::SymbolRefAttr symbol);
   size_t SerializedSymbolSize(mlir::SymbolRefAttr symbol);
   size_t SerializedOperationSize(mlir::SymbolRefAttr symbol);
 
@@ -45,6 +46,7 @@ class BefCompilationUnits {
  private:
   struct Serialized {
     size_t id;              // sequential id of the serialized symbol
+    size_t fingerprint;     // hash of the symbol and the operation
     size_t symbol_size;     // size of the serialized symbol name
     size_t operation_size;  // size of the serialized operation
     std::string data;       // symbol_ref + operation
@@ -26,6 +26,8 @@
 #include "tfrt/bef_converter/mlir_to_bef.h"
 
 #include <cstring>
+#include <memory>
+#include <vector>
 
 #include "bef_attr_emitter.h"
 #include "bef_compilation_units.h"
@@ -46,6 +48,7 @@
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/OperationSupport.h"
+#include "mlir/IR/Threading.h"
 #include "tfrt/bef/bef_encoding.h"
 #include "tfrt/bef_converter/bef_emitter.h"
 #include "tfrt/compiler/stream_analysis.h"
@@ -732,14 +735,24 @@ void BEFModuleEmitter::EmitTypes() {
 }
 
 // This is the emitter that builds the function entry of a BEF.
+// Offsets of the function and kernel locations in the locations section.
+struct LocationOffsets {
+  llvm::DenseMap<mlir::Region*, size_t> functions;
+  llvm::DenseMap<mlir::Operation*, size_t> kernels;
+};
+
+// Emits one function. Functions only read the entity table and index, so
+// several functions can be emitted concurrently.
 class BEFFunctionEmitter : public BEFFileEmitter {
  public:
   BEFFunctionEmitter(const EntityTable& entities,
-                     const EntityIndex& entity_index)
-      : entities_(entities), entity_index_(entity_index) {}
+                     const EntityIndex& entity_index,
+                     const LocationOffsets& location_offsets)
+      : entities_(entities),
+        entity_index_(entity_index),
+        location_offsets_(location_offsets) {}
 
-  void EmitFunction(mlir::Region* region, BefLocationEmitter* locations,
-                    BEFFileEmitter* attribute_names,
+  void EmitFunction(mlir::Region* region, BEFFileEmitter* attribute_names,
                     BEFFileEmitter* register_types);
 
  private:
@@ -750,7 +763,6 @@ class BEFFunctionEmitter : public BEFFileEmitter {
   void EmitArgumentsPseudoKernel(mlir::Block* block,
                                  BEFFileEmitter* kernel_list) const;
   void EmitKernel(mlir::Operation* op, BEFFileEmitter* kernel_list,
-                  BefLocationEmitter* locations,
                   BEFFileEmitter* attribute_names) const;
 
   unsigned GetRegisterNumber(mlir::Value reg) const {
@@ -773,10 +785,10 @@ class BEFFunctionEmitter : public BEFFileEmitter {
 
   const EntityTable& entities_;
   const EntityIndex& entity_index_;
+  const LocationOffsets& location_offsets_;
 };
 
 void BEFFunctionEmitter::EmitFunction(mlir::Region* region,
-                                      BefLocationEmitter* locations,
                                       BEFFileEmitter* attribute_names,
                                       BEFFileEmitter* register_types) {
   Reset();
@@ -784,8 +796,7 @@ void BEFFunctionEmitter::EmitFunction(mlir::Region* region,
   assert(llvm::hasSingleElement(*region) && "should have a single block");
   auto& block = region->front();
 
-  auto location_offset = locations->EmitOpLocation(region->getParentOp());
-  EmitVbrInt(location_offset);
+  EmitVbrInt(location_offsets_.functions.lookup(region));
 
   // Emit the register table.
   EmitRegisterTable(&block, register_types);
@@ -849,7 +860,7 @@ void BEFFunctionEmitter::EmitFunction(mlir::Region* region,
     const auto& stream = stream_analysis.GetStream(&op);
     EmitVbrInt(stream.id());
 
-    EmitKernel(&op, &kernel_list, locations, attribute_names);
+    EmitKernel(&op, &kernel_list, attribute_names);
   }
 
   // Emit the result registers list at the end of the KERNEL_TABLE if present.
@@ -960,14 +971,12 @@ void BEFFunctionEmitter::EmitArgumentsPseudoKernel(
 
 void BEFFunctionEmitter::EmitKernel(mlir::Operation* op,
                                     BEFFileEmitter* kernel_list,
-                                    BefLocationEmitter* locations,
                                     BEFFileEmitter* attribute_names) const {
   // Each kernel starts out with an opcode record.
   kernel_list->Emit<uint32_t>(entities_.GetKernelID(op));
 
   // Include a location.
-  auto location_offset = locations->EmitOpLocation(op);
-  kernel_list->Emit<uint32_t>(location_offset);
+  kernel_list->Emit<uint32_t>(location_offsets_.kernels.lookup(op));
 
   // Because the numbers of each types of entries are emitted first, we use
   // another emitter to keep all entries and append them to kernel_list later.
@@ -1050,20 +1059,75 @@ void BEFFunctionEmitter::EmitKernel(mlir::Operation* op,
 void BEFModuleEmitter::EmitFunctions(BefLocationEmitter* locations,
                                      BEFFileEmitter* attribute_names,
                                      BEFFileEmitter* register_types) {
-  BEFFunctionEmitter functions_section(entities_, entity_index_);
+  // Emit the locations up front in the order of the functions, so that the
+  // locations section doesn't depend on the order the functions are emitted.
+  LocationOffsets location_offsets;
+  for (const auto& function_entry : entities_.functions) {
+    if (function_entry.IsNative()) continue;
+    mlir::Region* region = function_entry.region;
+    location_offsets.functions[region] =
+        locations->EmitOpLocation(region->getParentOp());
+    for (auto& op : region->front()) {
+      if (!IsReturn(&op))
+        location_offsets.kernels[&op] = locations->EmitOpLocation(&op);
+    }
+  }
+
+  // Each function is emitted into its own emitters, in parallel if the
+  // context has multithreading enabled. They are concatenated in order below,
+  // so the output is the same for any number of threads.
+  struct EmittedFunction {
+    EmittedFunction(const EntityTable& entities,
+                    const EntityIndex& entity_index,
+                    const LocationOffsets& location_offsets,
+                    mlir::Region* region)
+        : function(entities, entity_index, location_offsets),
+          region(region) {}
+
+    BEFFunctionEmitter function;
+    BEFFileEmitter attribute_names;
+    BEFFileEmitter register_types;
+    mlir::Region* region;
+  };
+  std::vector<std::unique_ptr<EmittedFunction>> emitted_functions;
+  emitted_functions.reserve(entities_.functions.size());
+  for (const auto& function_entry : entities_.functions) {
+    emitted_functions.push_back(std::make_unique<EmittedFunction>(
+        entities_, entity_index_, location_offsets,
+        function_entry.IsNative() ? nullptr : function_entry.region));
+  }
+
+  mlir::parallelForEach(
+      module_.getContext(), emitted_functions,
+      [&](const std::unique_ptr<EmittedFunction>& emitted) {
+        // Native functions have no body.
+        if (!emitted->region) return;
+        emitted->function.EmitFunction(
+            emitted->region,
+            attribute_names ? &emitted->attribute_names : nullptr,
+            register_types ? &emitted->register_types : nullptr);
+      });
 
+  BEFFileEmitter functions_section;
   if (attribute_names != nullptr)
     attribute_names->EmitVbrInt(entities_.functions.size());
   if (register_types != nullptr)
     register_types->EmitVbrInt(entities_.functions.size());
-  for (auto function_entry : entities_.functions) {
+  for (auto iter : llvm::zip(entities_.functions, emitted_functions)) {
+    const auto& function_entry = std::get<0>(iter);
+    const auto& emitted = std::get<1>(iter);
+
     // Remember that we emitted this region to this offset.
+    functions_section.EmitAlignment(
+        emitted->function.GetRequiredAlignment());
     entity_index_.AddFunction(function_entry.name, functions_section.size(),
                               function_entry.type, function_entry.kind);
-    if (!function_entry.IsNative()) {
-      functions_section.EmitFunction(function_entry.region, locations,
-                                     attribute_names, register_types);
-    }
+    functions_section.EmitEmitter(emitted->function);
+
+    if (attribute_names != nullptr)
+      attribute_names->EmitEmitter(emitted->attribute_names);
+    if (register_types != nullptr)
+      register_types->EmitEmitter(emitted->register_types);
   }
 
   // TODO(hyojun): Reduce the increased peak memory usage for keeping
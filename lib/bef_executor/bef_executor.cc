@@ -18,21 +18,32 @@
 #include <atomic>
 #include <cstdint>
 #include <cstdio>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
 
 #include "bef_file_impl.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
 #include "tfrt/bef/bef_encoding.h"
 #include "tfrt/bef/bef_reader.h"
+#include "tfrt/bef_executor/kernel_profiler.h"
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/async_value.h"
 #include "tfrt/host_context/concurrent_work_queue.h"
 #include "tfrt/host_context/diagnostic.h"
+#include "tfrt/host_context/host_allocator.h"
 #include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/host_counters.h"
 #include "tfrt/host_context/kernel_frame.h"
 #include "tfrt/host_context/location.h"
 #include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
 #include "tfrt/support/ref_count.h"
+#include "tfrt/support/string_util.h"
+#include "tfrt/support/thread_annotations.h"
 #include "tfrt/tracing/tracing.h"
 
 #ifdef TFRT_BEF_DEBUG
@@ -93,17 +104,23 @@ llvm::ArrayRef<unsigned> GetNextUsedBys(const BEFKernel& kernel,
 // path.
 class ReadyKernelQueue {
  public:
-  // Constructs an empty queue with `stream_id`.
+  // Constructs an empty queue with `stream_id`. If `single_threaded` is true,
+  // the kernels of the executor never run concurrently, and the ready counts
+  // are updated without atomic read-modify-write operations.
   ReadyKernelQueue(int stream_id,
-                   MutableArrayRef<BEFFileImpl::KernelInfo> kernel_array)
-      : stream_id_(stream_id), kernel_array_(kernel_array) {}
+                   MutableArrayRef<BEFFileImpl::KernelInfo> kernel_array,
+                   bool single_threaded)
+      : stream_id_(stream_id),
+        single_threaded_(single_threaded),
+        kernel_array_(kernel_array) {}
 
   // Constructs a queue using `kernel_ids`, all kernels of which belong to the
   // same stream with `stream_id`.
   ReadyKernelQueue(int stream_id,
                    MutableArrayRef<BEFFileImpl::KernelInfo> kernel_array,
-                   std::vector<unsigned> kernel_ids)
+                   bool single_threaded, std::vector<unsigned> kernel_ids)
       : stream_id_(stream_id),
+        single_threaded_(single_threaded),
         kernel_array_(kernel_array),
         inline_kernel_ids_(std::move(kernel_ids)) {}
 
@@ -129,6 +146,16 @@ class ReadyKernelQueue {
     outline_kernel_ids_.erase(inline_kernels_begin, outline_kernel_ids_.end());
   }
 
+  // Moves all outline kernels into the inline kernels. Used when the execution
+  // is cancelled, because kernels only propagate the cancellation error, and
+  // it is cheaper to do in the current thread than to launch new tasks.
+  void InlineOutlineKernels() {
+    inline_kernel_ids_.insert(inline_kernel_ids_.end(),
+                              outline_kernel_ids_.begin(),
+                              outline_kernel_ids_.end());
+    outline_kernel_ids_.clear();
+  }
+
   // Decrement the ready counts for `kernel_ids` and put them in the queue.
   // Depending on their stream_id, they will be either put in the inline queue
   // for inline execution or outline queue for launching to a separate thread.
@@ -144,17 +171,36 @@ class ReadyKernelQueue {
       // don't need to perform the expensive fetch_sub for this case.
       auto& ready_count = kernel_info.arguments_not_ready;
       assert(ready_count.load() > 0);
-      if (ready_count.load(std::memory_order_acquire) == 1 ||
-          ready_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-        if (kernel_info.stream_id == stream_id_) {
-          inline_kernel_ids_.push_back(kernel_id);
-        } else {
-          outline_kernel_ids_.push_back(kernel_id);
+      if (single_threaded_) {
+        // Relaxed load and store compile to plain memory accesses, there is
+        // no other thread that could update the ready count concurrently.
+        int count = ready_count.load(std::memory_order_relaxed);
+        if (count != 1) {
+          ready_count.store(count - 1, std::memory_order_relaxed);
+          continue;
         }
+      } else if (ready_count.load(std::memory_order_acquire) != 1 &&
+                 ready_count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        continue;
+      }
+
+      if (kernel_info.stream_id == stream_id_) {
+        inline_kernel_ids_.push_back(kernel_id);
+      } else {
+        outline_kernel_ids_.push_back(kernel_id);
       }
     }
   }
 
+  // Resets the queue to execute `kernel_id` inline, switching the stream id to
+  // the stream of `kernel_id`. The queue must be empty.
+  void SetInlineKernel(unsigned kernel_id) {
+    assert(inline_kernel_ids_.empty() && "inlined kernels must be empty");
+    assert(outline_kernel_ids_.empty() && "outlined kernels must be empty");
+    stream_id_ = kernel_array_[kernel_id].stream_id;
+    inline_kernel_ids_.push_back(kernel_id);
+  }
+
   // `inline_kernel_ids` contains the kernels to be executed in the same thread.
   std::vector<unsigned>& inline_kernel_ids() { return inline_kernel_ids_; }
 
@@ -171,14 +217,115 @@ class ReadyKernelQueue {
 
  private:
   int stream_id_;
+  bool single_threaded_;
   MutableArrayRef<BEFFileImpl::KernelInfo> kernel_array_;
 
   std::vector<unsigned> inline_kernel_ids_;
   std::vector<unsigned> outline_kernel_ids_;
 };
 
+// KernelStealingQueues holds the ready outline kernels of one BEFExecutor when
+// work stealing is enabled. Every worker processing ready kernels owns one of
+// the queues: it pushes its outline kernels to the back of its own queue and
+// pops them from the back (LIFO for cache locality), while idle workers steal
+// from the front of the other queues.
+class KernelStealingQueues {
+ public:
+  explicit KernelStealingQueues(int num_queues)
+      : num_queues_(std::max(num_queues, 1)),
+        queues_(new Queue[num_queues_]) {}
+
+  int num_queues() const { return num_queues_; }
+
+  // Returns the index of the queue owned by a newly started worker. Queues are
+  // assigned round robin, so the same queue might be shared by a few workers.
+  int AssignQueue() {
+    return next_queue_.fetch_add(1, std::memory_order_relaxed) % num_queues_;
+  }
+
+  // Pushes `kernel_ids` to the back of the queue at `queue_index`.
+  void Push(int queue_index, ArrayRef<unsigned> kernel_ids) {
+    Queue& queue = queues_[queue_index];
+    mutex_lock lock(queue.mu);
+    queue.kernel_ids.insert(queue.kernel_ids.end(), kernel_ids.begin(),
+                            kernel_ids.end());
+  }
+
+  // Pops a kernel from the back of the queue at `queue_index`, or steals one
+  // from the front of the other queues if that queue is empty. Returns false if
+  // all queues are empty.
+  bool PopOrSteal(int queue_index, unsigned* kernel_id) {
+    {
+      Queue& queue = queues_[queue_index];
+      mutex_lock lock(queue.mu);
+      if (!queue.kernel_ids.empty()) {
+        *kernel_id = queue.kernel_ids.back();
+        queue.kernel_ids.pop_back();
+        return true;
+      }
+    }
+
+    for (int i = 1; i < num_queues_; ++i) {
+      Queue& victim = queues_[(queue_index + i) % num_queues_];
+      mutex_lock lock(victim.mu);
+      if (!victim.kernel_ids.empty()) {
+        *kernel_id = victim.kernel_ids.front();
+        victim.kernel_ids.pop_front();
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // Tries to reserve a slot for a new stealing task. The number of stealing
+  // tasks that are enqueued or running at the same time is bounded by the
+  // number of queues.
+  bool TryReserveStealer() {
+    int num_stealers = num_stealers_.load(std::memory_order_relaxed);
+    while (num_stealers < num_queues_) {
+      if (num_stealers_.compare_exchange_weak(num_stealers, num_stealers + 1,
+                                              std::memory_order_relaxed))
+        return true;
+    }
+    return false;
+  }
+
+  // Releases the slot reserved by TryReserveStealer().
+  void ReleaseStealer() {
+    num_stealers_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+ private:
+  // Pad queues to the cache line size to avoid false sharing between workers.
+  struct alignas(64) Queue {
+    mutex mu;
+    std::deque<unsigned> kernel_ids TFRT_GUARDED_BY(mu);
+  };
+
+  const int num_queues_;
+  std::unique_ptr<Queue[]> queues_;
+
+  std::atomic<int> next_queue_{0};
+  std::atomic<int> num_stealers_{0};
+};
+
 }  // namespace
 
+/// The register and kernel infos of one execution of a BEFFunction. Finished
+/// executions leave their frame in the BEFFunction, so that loops which run
+/// the same body function many times don't allocate it for every iteration.
+struct BEFExecutionFrame {
+  BEFFileImpl::FunctionInfo function_info;
+};
+
+// Recycled frames are kept by the BEFFunction and may outlive the HostContext,
+// so their info arrays are not allocated with the host allocator.
+static HostAllocator* GetFrameAllocator() {
+  static HostAllocator* allocator = CreateMallocAllocator().release();
+  return allocator;
+}
+
 /// A BEFExecutor runs a BEF function containing a stream of asynchronous
 /// kernels. Multiple executors can be active at one time, e.g. due to
 /// concurrent control flow constructs.
@@ -223,6 +370,12 @@ class BEFExecutor final : public ReferenceCounted<BEFExecutor> {
   // kernels.
   void ProcessReadyKernels(ReadyKernelQueue& ready_kernel_queue);
 
+  // Same as above, but outline kernels are pushed to the work stealing queues
+  // instead of the concurrent work queue. Once there are no more inline
+  // kernels, the caller keeps stealing outline kernels until all work stealing
+  // queues are empty.
+  void ProcessReadyKernelsWithStealing(ReadyKernelQueue& ready_kernel_queue);
+
   // Process the first pseudo kernel and populate its ready users in
   // `ready_kernel_queue`.
   void ProcessArgumentsPseudoKernel(ArrayRef<AsyncValue*> arguments,
@@ -247,31 +400,74 @@ class BEFExecutor final : public ReferenceCounted<BEFExecutor> {
   // executed in a dfferent thread in parallel.
   void EnqueueReadyKernels(std::vector<unsigned>& kernel_ids);
 
+  // Push `kernel_ids` to the work stealing queue at `queue_index`, and enqueue
+  // a stealing task to the concurrent work queue if there are not enough
+  // workers to steal them.
+  void PushReadyKernels(int queue_index, std::vector<unsigned>& kernel_ids);
+
+  // Launch outline kernels in `ready_kernel_queue` to other threads with
+  // PushReadyKernels() or EnqueueReadyKernels(), or move them to the inline
+  // kernels if the execution has been cancelled.
+  void LaunchOutlineKernels(int queue_index,
+                            ReadyKernelQueue& ready_kernel_queue);
+
+  // Returns true if the continuation of the kernels waiting for an async
+  // result must be enqueued to the work queue instead of running in the
+  // caller thread.
+  bool MustEnqueueContinuation() const;
+
   HostContext* GetHost() const { return exec_ctx_.host(); }
   BEFFileImpl* BefFile() const { return bef_file_.get(); }
 
-  ArrayRef<uint32_t> kernels() { return function_info_.kernels; }
+  ArrayRef<uint32_t> kernels() { return frame_->function_info.kernels; }
 
   MutableArrayRef<BEFFileImpl::RegisterInfo> register_infos() {
-    return function_info_.register_infos.mutable_array();
+    return frame_->function_info.register_infos.mutable_array();
   }
 
   MutableArrayRef<BEFFileImpl::KernelInfo> kernel_infos() {
-    return function_info_.kernel_infos.mutable_array();
+    return frame_->function_info.kernel_infos.mutable_array();
   }
 
   void DebugPrintError(const BEFKernel& kernel, unsigned kernel_id,
                        AsyncValue* result);
 
+  // Returns the decoded location of `kernel`.
+  std::string GetKernelLocation(const BEFKernel& kernel);
+
+  // Returns the kernel profiler id of `kernel_id`.
+  uint32_t GetKernelProfileId(unsigned kernel_id);
+
   friend class ReferenceCounted<BEFExecutor>;
 
   /// The execution context for this BEFExecutor.
   ExecutionContext exec_ctx_;
 
-  /// Decoded BEFFunction
-  BEFFileImpl::FunctionInfo function_info_;
+  /// Execution plan cached in the BEFFunction, owned by the BEFFunction.
+  const BEFExecutionPlan* plan_ = nullptr;
+
+  /// The function being executed, which recycles `frame_` at the end.
+  const BEFFunction* function_ = nullptr;
+
+  /// Per-execution state initialized from the execution plan.
+  std::unique_ptr<BEFExecutionFrame> frame_;
 
   RCReference<BEFFileImpl> bef_file_;
+
+  /// Ready outline kernels, only allocated if work stealing is enabled in the
+  /// execution context.
+  std::unique_ptr<KernelStealingQueues> stealing_queues_;
+
+  /// True if the work queue runs all tasks in its single client thread. In
+  /// this case the executor updates ready counts with plain loads and stores,
+  /// and all kernels must run in `client_thread_`, either directly or from
+  /// the tasks enqueued to the work queue.
+  bool single_threaded_ = false;
+  std::thread::id client_thread_;
+
+  /// True if the kernels of this execution are recorded by the kernel
+  /// profiler.
+  bool profile_ = false;
 };
 
 //===----------------------------------------------------------------------===//
@@ -352,7 +548,8 @@ LLVM_ATTRIBUTE_ALWAYS_INLINE void BEFExecutor::ProcessUsedBysAndSetRegister(
     // Continue processing ready kernels.
     auto continuation = [this, stream_id, users, result_register,
                          result = std::move(result)]() mutable {
-      ReadyKernelQueue ready_kernel_queue(stream_id, kernel_infos());
+      ReadyKernelQueue ready_kernel_queue(stream_id, kernel_infos(),
+                                          single_threaded_);
 
       // SetRegisterValue() must be done before
       // DecrementReadyCountAndEnqueue() because as soon as we decrement a
@@ -363,10 +560,13 @@ LLVM_ATTRIBUTE_ALWAYS_INLINE void BEFExecutor::ProcessUsedBysAndSetRegister(
       this->DropRef();
     };
 
-    // Maybe schedule continuation as a separate task to prevent stack overflow.
-    if (StackOverflowGuard::MustEnqueue())
-      EnqueueWork(exec_ctx_,
-                  [run = std::move(continuation)]() mutable { run(); });
+    // Maybe schedule continuation as a separate task to prevent stack overflow,
+    // or to run it in the client thread of a single threaded executor. The
+    // continuation is the last thing this callback does, so in a worker thread
+    // it runs next on the same core, which has the result in the cache.
+    if (MustEnqueueContinuation())
+      EnqueueNextWork(exec_ctx_,
+                      [run = std::move(continuation)]() mutable { run(); });
     else
       continuation();
   });
@@ -438,6 +638,29 @@ void BEFExecutor::DebugPrintError(const BEFKernel& kernel, unsigned kernel_id,
 #endif
 }
 
+std::string BEFExecutor::GetKernelLocation(const BEFKernel& kernel) {
+  std::string location;
+  llvm::raw_string_ostream os(location);
+  os << Location(BefFile()->location_handler(), kernel.kernel_location())
+            .Decode();
+  return os.str();
+}
+
+uint32_t BEFExecutor::GetKernelProfileId(unsigned kernel_id) {
+  std::atomic<uint32_t>& id = plan_->kernel_profile_ids[kernel_id];
+  uint32_t id_value = id.load(std::memory_order_relaxed);
+  if (id_value != 0) return id_value;
+
+  // Kernels are registered by name and location, so concurrent executions
+  // which race to register a kernel get the same id.
+  BEFKernel kernel(kernels().data() +
+                   kernel_infos()[kernel_id].offset / kKernelEntryAlignment);
+  const char* name = BefFile()->GetKernelName(kernel.kernel_code());
+  id_value = kernel_profiler::GetKernelId(name, GetKernelLocation(kernel));
+  id.store(id_value, std::memory_order_relaxed);
+  return id_value;
+}
+
 // Process the kernel for `kernel_id` and populate `ready_kernel_queue` with
 // ready users.
 void BEFExecutor::ProcessReadyKernel(unsigned kernel_id,
@@ -455,8 +678,8 @@ void BEFExecutor::ProcessReadyKernel(unsigned kernel_id,
   AsyncValue* any_error_argument = exec_ctx_.GetCancelAsyncValue();
 
   // Find the kernel implementation of this kernel.
-  AsyncKernelImplementation kernel_fn =
-      BefFile()->GetAsyncKernel(kernel.kernel_code());
+  AsyncKernelImplementation kernel_fn = plan_->kernel_impls[kernel_id];
+  assert(kernel_fn);
 
   DEBUG_PRINT("Run kernel %u %s\n", kernel_id,
               BefFile()->GetKernelName(kernel.kernel_code()));
@@ -502,13 +725,29 @@ void BEFExecutor::ProcessReadyKernel(unsigned kernel_id,
     // so that we don't have extra bookkeeping in bef executor.
     TFRT_TRACE_SCOPE(Debug, BefFile()->GetKernelName(kernel.kernel_code()));
 
+    // Attribute the allocations of the kernel to it in allocation profiles.
+    auto allocation_site = [&] {
+      return StrCat(BefFile()->GetKernelName(kernel.kernel_code()), "@",
+                    GetKernelLocation(kernel));
+    };
+    AllocationSiteScope allocation_site_scope(allocation_site);
+
     // kernel_fn should populate results in kernel_frame with pointers to
     // AsyncValue before it returns.
-    kernel_fn(kernel_frame);
+    if (LLVM_UNLIKELY(profile_)) {
+      kernel_profiler::ProfiledKernelCall call(GetKernelProfileId(kernel_id));
+      kernel_fn(kernel_frame);
+    } else {
+      kernel_fn(kernel_frame);
+    }
   } else {
-    // Otherwise, automatically propagate errors to the result values.
-    for (size_t i = 0, e = kernel_frame->GetNumResults(); i != e; ++i) {
-      kernel_frame->SetResultAt(i, FormRef(any_error_argument));
+    // Otherwise, automatically propagate errors to the result values. Add
+    // references for all results at once, because error values (e.g. the
+    // cancellation error) are shared by many kernels.
+    const size_t num_results = kernel_frame->GetNumResults();
+    any_error_argument->AddRef(num_results);
+    for (size_t i = 0; i != num_results; ++i) {
+      kernel_frame->SetResultAt(i, TakeRef(any_error_argument));
     }
   }
 
@@ -567,7 +806,9 @@ LLVM_ATTRIBUTE_NOINLINE void BEFExecutor::EnqueueReadyKernels(
         return kernel_array[x_id].stream_id < kernel_array[y_id].stream_id;
       });
 
-  // For each stream group, we enqueue the kernels to the work queue.
+  // For each stream group, we enqueue the kernels to the work queue. All groups
+  // are submitted to the work queue at once.
+  EnqueueWorkBatch batch;
   for (auto iter = kernel_ids.begin(); iter != kernel_ids.end();) {
     int stream_id = kernel_array[*iter].stream_id;
     auto jter = iter++;
@@ -582,6 +823,7 @@ LLVM_ATTRIBUTE_NOINLINE void BEFExecutor::EnqueueReadyKernels(
         exec_ctx_,
         [this, stream_id, kernel_ids = std::move(stream_kernel_ids)]() mutable {
           ReadyKernelQueue ready_kernel_queue(stream_id, kernel_infos(),
+                                              single_threaded_,
                                               std::move(kernel_ids));
           ProcessReadyKernels(ready_kernel_queue);
           DropRef();
@@ -592,10 +834,111 @@ LLVM_ATTRIBUTE_NOINLINE void BEFExecutor::EnqueueReadyKernels(
   kernel_ids.clear();
 }
 
+// Push `kernel_ids` to the work stealing queue at `queue_index`, and enqueue
+// a stealing task to the concurrent work queue if there are not enough
+// workers to steal them.
+LLVM_ATTRIBUTE_NOINLINE void BEFExecutor::PushReadyKernels(
+    int queue_index, std::vector<unsigned>& kernel_ids) {
+  stealing_queues_->Push(queue_index, kernel_ids);
+  kernel_ids.clear();
+
+  // The caller keeps stealing kernels until all queues are empty, so if we
+  // can't reserve a new stealer, pushed kernels will still be processed.
+  if (!stealing_queues_->TryReserveStealer()) return;
+
+  AddRef();
+  EnqueueWork(exec_ctx_, [this]() {
+    // Start with an empty queue, the stream id is picked from the first stolen
+    // kernel.
+    ReadyKernelQueue ready_kernel_queue(/*stream_id=*/-1, kernel_infos(),
+                                        single_threaded_);
+    ProcessReadyKernelsWithStealing(ready_kernel_queue);
+    stealing_queues_->ReleaseStealer();
+    DropRef();
+  });
+}
+
+// Launches outline kernels in `ready_kernel_queue` to other threads, by pushing
+// them to the work stealing queue at `queue_index` if work stealing is enabled,
+// or by enqueueing them to the concurrent work queue. If the execution has been
+// cancelled, outline kernels only propagate the cancellation error, and they
+// are moved to the inline kernels instead, so that a cancelled execution does
+// not launch new tasks that compete with other requests.
+void BEFExecutor::LaunchOutlineKernels(int queue_index,
+                                       ReadyKernelQueue& ready_kernel_queue) {
+  if (LLVM_UNLIKELY(exec_ctx_.IsCancelled())) {
+    ready_kernel_queue.InlineOutlineKernels();
+    return;
+  }
+
+  if (LLVM_UNLIKELY(profile_)) {
+    for (unsigned kernel_id : ready_kernel_queue.outline_kernel_ids())
+      kernel_profiler::RecordOutlineCall(GetKernelProfileId(kernel_id));
+  }
+
+  if (stealing_queues_) {
+    PushReadyKernels(queue_index, ready_kernel_queue.outline_kernel_ids());
+  } else {
+    EnqueueReadyKernels(ready_kernel_queue.outline_kernel_ids());
+  }
+}
+
+// Async results of a single threaded executor can become available in other
+// threads, e.g. when they are produced by an I/O callback. Their users must be
+// processed in the client thread to keep all updates of the ready counts in one
+// thread, so the continuation is enqueued to the work queue.
+bool BEFExecutor::MustEnqueueContinuation() const {
+  if (StackOverflowGuard::MustEnqueue()) return true;
+  return single_threaded_ && std::this_thread::get_id() != client_thread_;
+}
+
+void BEFExecutor::ProcessReadyKernelsWithStealing(
+    ReadyKernelQueue& ready_kernel_queue) {
+  KernelFrameBuilder kernel_frame(exec_ctx_);
+  kernel_frame.SetAttributeSection(BefFile()->attribute_section_);
+  kernel_frame.SetFunctions(BefFile()->functions_);
+
+  int queue_index = stealing_queues_->AssignQueue();
+
+  auto& inline_kernel_ids = ready_kernel_queue.inline_kernel_ids();
+  auto& outline_kernel_ids = ready_kernel_queue.outline_kernel_ids();
+
+  while (true) {
+    // Switch stream id if there are no inline kernels to process.
+    if (inline_kernel_ids.empty()) ready_kernel_queue.SwitchStreamId();
+
+    // Make outline kernels available to other workers.
+    if (!outline_kernel_ids.empty())
+      LaunchOutlineKernels(queue_index, ready_kernel_queue);
+
+    while (!inline_kernel_ids.empty()) {
+      auto kernel_id = inline_kernel_ids.back();
+      inline_kernel_ids.pop_back();
+
+      ProcessReadyKernel(kernel_id, &kernel_frame, ready_kernel_queue);
+
+      if (inline_kernel_ids.empty()) ready_kernel_queue.SwitchStreamId();
+
+      if (!outline_kernel_ids.empty())
+        LaunchOutlineKernels(queue_index, ready_kernel_queue);
+    }
+
+    // Continue with a kernel from our own queue or stolen from other workers.
+    unsigned kernel_id;
+    if (!stealing_queues_->PopOrSteal(queue_index, &kernel_id)) break;
+    ready_kernel_queue.SetInlineKernel(kernel_id);
+  }
+}
+
 // Iteratively process ready kernels in `ready_kernel_queue` and inserts ready
 // users back for next round of processing, until there are no more ready
 // kernels.
 void BEFExecutor::ProcessReadyKernels(ReadyKernelQueue& ready_kernel_queue) {
+  if (stealing_queues_) {
+    ProcessReadyKernelsWithStealing(ready_kernel_queue);
+    return;
+  }
+
   // Process the kernel record to get information about what argument
   // registers, result registers, and attributes should be passed.
   KernelFrameBuilder kernel_frame(exec_ctx_);
@@ -608,7 +951,7 @@ void BEFExecutor::ProcessReadyKernels(ReadyKernelQueue& ready_kernel_queue) {
 
   // Enqueue outline kernels into the concurrent work queue.
   if (!ready_kernel_queue.outline_kernel_ids().empty())
-    EnqueueReadyKernels(ready_kernel_queue.outline_kernel_ids());
+    LaunchOutlineKernels(/*queue_index=*/-1, ready_kernel_queue);
   assert(ready_kernel_queue.outline_kernel_ids().empty());
 
   // The loop below process inline kernels in a LIFO order for cache locality.
@@ -626,7 +969,7 @@ void BEFExecutor::ProcessReadyKernels(ReadyKernelQueue& ready_kernel_queue) {
 
     // Enqueue outline kernels into the concurrent work queue.
     if (!ready_kernel_queue.outline_kernel_ids().empty())
-      EnqueueReadyKernels(ready_kernel_queue.outline_kernel_ids());
+      LaunchOutlineKernels(/*queue_index=*/-1, ready_kernel_queue);
     assert(ready_kernel_queue.outline_kernel_ids().empty());
   }
 }
@@ -636,9 +979,26 @@ void BEFExecutor::ProcessReadyKernels(ReadyKernelQueue& ready_kernel_queue) {
 //===----------------------------------------------------------------------===//
 
 BEFExecutor::BEFExecutor(ExecutionContext exec_ctx, BEFFileImpl* bef_file)
-    : exec_ctx_(std::move(exec_ctx)), bef_file_(FormRef(bef_file)) {}
+    : exec_ctx_(std::move(exec_ctx)), bef_file_(FormRef(bef_file)) {
+  AddHostCounter(exec_ctx_.request_ctx(), HostCounter::kExecutors);
+  // Work stealing is useless if work queue has no worker threads.
+  if (exec_ctx_.work_stealing()) {
+    int parallelism = exec_ctx_.work_queue().GetParallelismLevel();
+    if (parallelism > 1)
+      stealing_queues_ = std::make_unique<KernelStealingQueues>(parallelism);
+  }
 
-BEFExecutor::~BEFExecutor() {}
+  // A work queue with a parallelism level of one can still run tasks in a
+  // worker thread concurrently with the client, so we also check that the
+  // work queue runs tasks only in the client thread.
+  const ConcurrentWorkQueue& work_queue = exec_ctx_.work_queue();
+  single_threaded_ =
+      work_queue.GetParallelismLevel() == 1 && work_queue.IsSingleThreaded();
+}
+
+BEFExecutor::~BEFExecutor() {
+  if (frame_) function_->RecycleExecutionFrame(std::move(frame_));
+}
 
 void BEFExecutor::Execute(ArrayRef<AsyncValue*> arguments) {
   // Each KernelInfo::arguments_not_ready to the number of arguments (or one for
@@ -651,8 +1011,9 @@ void BEFExecutor::Execute(ArrayRef<AsyncValue*> arguments) {
   // (very cache friendly), and results in all the atomics staying in that
   // cores' cache, if these benefits outweigh the latency improvement from
   // launching these kernels in different threads.
+  client_thread_ = std::this_thread::get_id();
   ReadyKernelQueue ready_kernel_queue(kernel_infos()[kPseudoKernelId].stream_id,
-                                      kernel_infos());
+                                      kernel_infos(), single_threaded_);
 
   // The first kernel (kernel_id == 0) is a pseudo kernel that provides the
   // arguments, which gets special handling.
@@ -674,23 +1035,42 @@ RCReference<BEFExecutor> BEFExecutor::Create(
   assert(results.size() == fn.result_types().size() &&
          "incorrect number of results passed to function call");
 
+  // A cancelled execution would only propagate the cancellation error through
+  // all kernels, so the results share the cancellation error right away,
+  // without allocating an executor.
+  if (ErrorAsyncValue* cancel_value = exec_ctx.GetCancelAsyncValue()) {
+    for (RCReference<AsyncValue>& result : results) {
+      assert(!result && "result AsyncValue is not nullptr");
+      result = FormRef(cancel_value);
+    }
+    return {};
+  }
+
   HostContext* host = exec_ctx.host();
   auto* exec_ptr = host->Allocate<BEFExecutor>();
   auto* exec = new (exec_ptr) BEFExecutor(std::move(exec_ctx), bef_file);
 
-  size_t location_offset;
-  llvm::SmallVector<size_t, 4> result_regs;
-  bool success = bef_file->ReadFunction(fn.function_offset(), fn.result_types(),
-                                        &location_offset, &exec->function_info_,
-                                        &result_regs, host->allocator());
-  if (!success) {
-    for (size_t i = 0, e = results.size(); i != e; ++i) {
-      assert(!results[i] && "result AsyncValue is not nullptr");
-      results[i]->SetError(absl::InternalError("Could not read BEF function."));
+  // The register and kernel tables are decoded once per BEFFunction, so here
+  // we only need to initialize the per-execution counters.
+  const BEFExecutionPlan* plan = fn.GetExecutionPlan();
+  if (!plan) {
+    RCReference<ErrorAsyncValue> error = MakeErrorAsyncValueRef(
+        absl::InternalError("Could not read BEF function."));
+    for (RCReference<AsyncValue>& result : results) {
+      assert(!result && "result AsyncValue is not nullptr");
+      result = error;
     }
     return {};
-  };
+  }
 
+  exec->plan_ = plan;
+  exec->profile_ = kernel_profiler::ShouldProfileExecution(fn.name());
+  exec->function_ = &fn;
+  exec->frame_ = fn.TakeExecutionFrame();
+  if (!exec->frame_) exec->frame_ = std::make_unique<BEFExecutionFrame>();
+  BEFFileImpl::InitFunctionInfo(*plan, &exec->frame_->function_info,
+                                GetFrameAllocator());
+  ArrayRef<size_t> result_regs = plan->result_regs;
   assert(result_regs.size() == fn.result_types().size());
 
   MutableArrayRef<BEFFileImpl::RegisterInfo> register_array =
@@ -762,7 +1142,8 @@ void BEFExecutor::ExecuteAsync(
   }
 
   auto& work_queue = exec->exec_ctx_.work_queue();
-  work_queue.AddTask(
+  TaskPriority priority = exec->exec_ctx_.priority();
+  work_queue.AddTaskWithPriority(
       [&fn, exec = std::move(exec), arg_copies = std::move(arg_copies)]() {
         DEBUG_PRINT("Execute function %s start\n",
                     fn.name().empty() ? "(unknown)" : fn.name().str().c_str());
@@ -777,7 +1158,8 @@ void BEFExecutor::ExecuteAsync(
         DEBUG_PRINT("Execute function %s end\n",
                     fn.name().empty() ? "(unknown)" : fn.name().str().c_str());
         (void)fn;
-      });
+      },
+      priority);
 }
 
 //===----------------------------------------------------------------------===//
@@ -797,6 +1179,57 @@ void BEFFunction::ExecuteAsync(
   BEFExecutor::ExecuteAsync(exec_ctx, *this, arguments, results);
 }
 
+BEFFunction::~BEFFunction() {
+  delete execution_plan_.load();
+  delete recycled_frame_.load();
+}
+
+std::unique_ptr<BEFExecutionFrame> BEFFunction::TakeExecutionFrame() const {
+  // Check with a plain load first, so that concurrent executions of a function
+  // don't all write to the slot.
+  if (!recycled_frame_.load(std::memory_order_relaxed)) return nullptr;
+  return std::unique_ptr<BEFExecutionFrame>(
+      recycled_frame_.exchange(nullptr, std::memory_order_acquire));
+}
+
+void BEFFunction::RecycleExecutionFrame(
+    std::unique_ptr<BEFExecutionFrame> frame) const {
+  BEFExecutionFrame* expected = nullptr;
+  if (recycled_frame_.compare_exchange_strong(expected, frame.get(),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed))
+    frame.release();
+}
+
+const BEFExecutionPlan* BEFFunction::GetExecutionPlan() const {
+  if (const BEFExecutionPlan* plan =
+          execution_plan_.load(std::memory_order_acquire))
+    return plan;
+
+  auto plan = std::make_unique<BEFExecutionPlan>();
+  if (!bef_file_->ReadExecutionPlan(function_offset_, result_types(),
+                                    plan.get()))
+    return nullptr;
+
+  // Resolve the kernel implementations, so that kernel execution does not need
+  // to look them up in the BEF file. Kernel 0 is the arguments pseudo kernel.
+  plan->kernel_impls.resize(plan->kernel_templates.size(), nullptr);
+  for (size_t i = 1, e = plan->kernel_templates.size(); i < e; ++i) {
+    BEFKernel kernel(plan->kernels.data() +
+                     plan->kernel_templates[i].offset / kKernelEntryAlignment);
+    plan->kernel_impls[i] = bef_file_->GetAsyncKernel(kernel.kernel_code());
+  }
+  plan->kernel_profile_ids.reset(
+      new std::atomic<uint32_t>[plan->kernel_templates.size()]());
+
+  // Several threads may decode the plan concurrently; the first one wins.
+  BEFExecutionPlan* expected = nullptr;
+  if (execution_plan_.compare_exchange_strong(expected, plan.get(),
+                                              std::memory_order_acq_rel))
+    return plan.release();
+  return expected;
+}
+
 // To keep this function alive, we have to keep the underlying BEF file alive.
 void BEFFunction::AddRef() const { bef_file_->AddRef(); }
 
@@ -19,7 +19,14 @@
 
 #include "tfrt/bef_executor/bef_file.h"
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "bef_file_impl.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/xxhash.h"
 #include "tfrt/bef/bef_encoding.h"
 #include "tfrt/bef/bef_location.h"
 #include "tfrt/bef/bef_reader.h"
@@ -28,7 +35,10 @@
 #include "tfrt/host_context/host_context.h"
 #include "tfrt/host_context/location.h"
 #include "tfrt/host_context/native_function.h"
+#include "tfrt/io/file_system.h"
 #include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
 #include "tfrt/support/variant.h"
 
 namespace tfrt {
@@ -393,11 +403,10 @@ bool BEFFileReader::ReadFunctionIndexSection() {
         if (function_index.function_offset >=
             bef_file_->function_section_.size())
           return format_error("Invalid offset found for SyncBEFFunction");
-        auto bef_function = SyncBEFFunction::Create(
+        auto bef_function = std::make_unique<SyncBEFFunction>(
             name, function_index.arguments, function_index.results,
             function_index.function_offset, bef_file_);
-        if (!bef_function) return format_error(bef_function.takeError());
-        bef_file_->functions_.push_back(std::move(bef_function.get()));
+        bef_file_->functions_.push_back(std::move(bef_function));
         break;
       }
       case FunctionKind::kNativeFunction: {
@@ -468,6 +477,126 @@ RCReference<BEFFile> BEFFile::Open(ArrayRef<uint8_t> file,
   return bef_rc;
 }
 
+RCReference<BEFFile> BEFFile::Open(
+    std::unique_ptr<io::ReadOnlyMemoryRegion> file_region,
+    const KernelRegistry& registry, ErrorHandler error_handler,
+    tfrt::HostAllocator* host_allocator) {
+  assert(file_region);
+  ArrayRef<uint8_t> file(static_cast<const uint8_t*>(file_region->data()),
+                         file_region->length());
+  auto bef = Open(file, registry, std::move(error_handler), host_allocator);
+  if (!bef) return {};
+
+  static_cast<BEFFileImpl*>(bef.get())->file_region_ = std::move(file_region);
+  return bef;
+}
+
+namespace {
+
+// The BEF files opened by BEFFile::OpenShared(), keyed by a hash of their
+// content. A hash match is confirmed by comparing the content. Files which
+// are only referenced by the store are released when the store grows.
+class SharedBEFFiles {
+ public:
+  static SharedBEFFiles& Global() {
+    static auto* const files = new SharedBEFFiles();
+    return *files;
+  }
+
+  // Returns the file with the same content and registry, or null.
+  RCReference<BEFFile> Find(uint64_t hash, ArrayRef<uint8_t> content,
+                            const KernelRegistry* registry) {
+    mutex_lock lock(mutex_);
+    if (const Entry* entry = FindLocked(hash, content, registry))
+      return entry->bef.CopyRef();
+    return {};
+  }
+
+  // Adds `bef` with `content` to the store, unless another file with the same
+  // content was added concurrently. Returns the file in the store.
+  RCReference<BEFFile> Insert(uint64_t hash, ArrayRef<uint8_t> content,
+                              const KernelRegistry* registry,
+                              RCReference<BEFFile> bef) {
+    std::vector<RCReference<BEFFile>> pruned;
+    mutex_lock lock(mutex_);
+    if (const Entry* entry = FindLocked(hash, content, registry))
+      return entry->bef.CopyRef();
+    if (num_entries_ >= prune_size_) pruned = Prune();
+    entries_[hash].push_back(Entry{content, registry, bef.CopyRef()});
+    ++num_entries_;
+    return bef;
+  }
+
+ private:
+  // Minimum number of files before pruning.
+  static constexpr size_t kMinPruneSize = 16;
+
+  struct Entry {
+    ArrayRef<uint8_t> content;
+    const KernelRegistry* registry;
+    RCReference<BEFFile> bef;
+  };
+
+  const Entry* FindLocked(uint64_t hash, ArrayRef<uint8_t> content,
+                          const KernelRegistry* registry) const
+      TFRT_REQUIRES(mutex_) {
+    auto it = entries_.find(hash);
+    if (it == entries_.end()) return nullptr;
+    for (const Entry& entry : it->second) {
+      if (entry.registry == registry &&
+          entry.content.size() == content.size() &&
+          std::memcmp(entry.content.data(), content.data(),
+                      content.size()) == 0)
+        return &entry;
+    }
+    return nullptr;
+  }
+
+  // Drops the files only referenced by the store. Returns them so that they
+  // are released outside of the lock.
+  std::vector<RCReference<BEFFile>> Prune() TFRT_REQUIRES(mutex_) {
+    std::vector<RCReference<BEFFile>> pruned;
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      auto& bucket = it->second;
+      for (Entry& entry : bucket) {
+        if (entry.bef->IsUnique()) pruned.push_back(std::move(entry.bef));
+      }
+      llvm::erase_if(bucket, [](const Entry& entry) { return !entry.bef; });
+      if (bucket.empty()) entries_.erase(it);
+    }
+    num_entries_ -= pruned.size();
+    prune_size_ = std::max<size_t>(kMinPruneSize, 2 * num_entries_);
+    return pruned;
+  }
+
+  mutex mutex_;
+  llvm::DenseMap<uint64_t, llvm::SmallVector<Entry, 1>> entries_
+      TFRT_GUARDED_BY(mutex_);
+  size_t num_entries_ TFRT_GUARDED_BY(mutex_) = 0;
+  size_t prune_size_ TFRT_GUARDED_BY(mutex_) = kMinPruneSize;
+};
+
+}  // namespace
+
+RCReference<BEFFile> BEFFile::OpenShared(
+    std::unique_ptr<io::ReadOnlyMemoryRegion> file_region,
+    const KernelRegistry& registry, ErrorHandler error_handler,
+    tfrt::HostAllocator* host_allocator) {
+  assert(file_region);
+  ArrayRef<uint8_t> file(static_cast<const uint8_t*>(file_region->data()),
+                         file_region->length());
+  const uint64_t hash = llvm::xxHash64(file);
+
+  SharedBEFFiles& shared = SharedBEFFiles::Global();
+  if (RCReference<BEFFile> bef = shared.Find(hash, file, &registry)) return bef;
+
+  // The file stays mapped by the new BEFFile, so `file` remains valid.
+  RCReference<BEFFile> bef = Open(std::move(file_region), registry,
+                                  std::move(error_handler), host_allocator);
+  if (!bef) return {};
+  return shared.Insert(hash, file, &registry, std::move(bef));
+}
+
 DecodedLocation BEFLocationHandler::DecodeLocation(Location loc) const {
   return bef_file_->DecodeLocation(loc.data);
 }
@@ -494,6 +623,18 @@ bool BEFFileImpl::ReadFunction(size_t function_offset,
                                FunctionInfo* function_info,
                                llvm::SmallVectorImpl<size_t>* result_regs,
                                HostAllocator* host_allocator) {
+  BEFExecutionPlan plan;
+  if (!ReadExecutionPlan(function_offset, results, &plan)) return false;
+
+  InitFunctionInfo(plan, function_info, host_allocator);
+  *location_offset = plan.location_offset;
+  result_regs->append(plan.result_regs.begin(), plan.result_regs.end());
+  return true;
+}
+
+bool BEFFileImpl::ReadExecutionPlan(size_t function_offset,
+                                    ArrayRef<TypeName> results,
+                                    BEFExecutionPlan* plan) {
   auto format_error = [&]() -> bool {
     EmitFormatError("invalid Function section in BEF file");
     return false;
@@ -505,57 +646,75 @@ bool BEFFileImpl::ReadFunction(size_t function_offset,
 
   // First we have the location info and register info table.
   size_t num_registers;
-  if (!reader.ReadVbrInt(location_offset) || !reader.ReadVbrInt(&num_registers))
+  if (!reader.ReadVbrInt(&plan->location_offset) ||
+      !reader.ReadVbrInt(&num_registers))
     return format_error();
 
-  function_info->register_infos.resize(num_registers, host_allocator);
-  auto* register_info_ptr =
-      function_info->register_infos.mutable_array().data();
-  unsigned register_idx = 0;
-  while (num_registers--) {
+  plan->register_user_counts.reserve(num_registers);
+  for (size_t i = 0; i < num_registers; ++i) {
     size_t user_count;
     if (!reader.ReadVbrInt(&user_count)) return format_error();
-    new (register_info_ptr + register_idx) RegisterInfo(user_count);
-    ++register_idx;
+    plan->register_user_counts.push_back(user_count);
   }
 
   // Next we have the kernel index table.
   size_t num_kernels;
   if (!reader.ReadVbrInt(&num_kernels)) return format_error();
 
-  function_info->kernel_infos.resize(num_kernels, host_allocator);
-  auto* kernel_info_ptr = function_info->kernel_infos.mutable_array().data();
-  unsigned kernel_idx = 0;
-  while (num_kernels--) {
+  plan->kernel_templates.reserve(num_kernels);
+  for (size_t i = 0; i < num_kernels; ++i) {
     size_t offset, num_operands, stream_id;
     if (!reader.ReadVbrInt(&offset) || !reader.ReadVbrInt(&num_operands) ||
         !reader.ReadVbrInt(&stream_id))
       return format_error();
-    new (kernel_info_ptr + kernel_idx)
-        KernelInfo(offset, stream_id, num_operands);
-    ++kernel_idx;
+    plan->kernel_templates.push_back(
+        {static_cast<unsigned>(offset), static_cast<unsigned>(stream_id),
+         static_cast<unsigned>(num_operands)});
   }
 
   // Read the result registers.
-  result_regs->reserve(results.size());
+  plan->result_regs.reserve(results.size());
   for (unsigned i = 0, e = results.size(); i != e; ++i) {
     size_t result_reg;
     if (!reader.ReadVbrInt(&result_reg) || result_reg >= num_registers)
       return format_error();
-    result_regs->push_back(result_reg);
+    plan->result_regs.push_back(result_reg);
   }
 
   // Kernels are aligned to kKernelEntryAlignment.
   if (!reader.ReadAlignment(kKernelEntryAlignment)) return format_error();
 
   // We found the start of our kernel section.
-  function_info->kernels = llvm::makeArrayRef(
+  plan->kernels = llvm::makeArrayRef(
       reinterpret_cast<const uint32_t*>(reader.file().begin()),
       reader.file().size() / kKernelEntryAlignment);
 
   return true;
 }
 
+void BEFFileImpl::InitFunctionInfo(const BEFExecutionPlan& plan,
+                                   FunctionInfo* function_info,
+                                   HostAllocator* host_allocator) {
+  function_info->kernels = plan.kernels;
+
+  if (function_info->register_infos.size() !=
+      plan.register_user_counts.size())
+    function_info->register_infos.resize(plan.register_user_counts.size(),
+                                         host_allocator);
+  auto* register_info_ptr =
+      function_info->register_infos.mutable_array().data();
+  for (unsigned user_count : plan.register_user_counts)
+    new (register_info_ptr++) RegisterInfo(user_count);
+
+  if (function_info->kernel_infos.size() != plan.kernel_templates.size())
+    function_info->kernel_infos.resize(plan.kernel_templates.size(),
+                                       host_allocator);
+  auto* kernel_info_ptr = function_info->kernel_infos.mutable_array().data();
+  for (const auto& kernel : plan.kernel_templates)
+    new (kernel_info_ptr++)
+        KernelInfo(kernel.offset, kernel.stream_id, kernel.num_operands);
+}
+
 // Given an offset into locations_section_, decode it and return
 // a DecodedDiagnostic.
 DecodedLocation BEFFileImpl::DecodeLocation(size_t location_position_offset) {
@@ -600,26 +759,14 @@ const Function* BEFFile::GetFunction(string_view function_name) const {
   return impl->functions_[it->second].get();
 }
 
-Expected<std::unique_ptr<SyncBEFFunction>> SyncBEFFunction::Create(
-    string_view name, ArrayRef<TypeName> arguments, ArrayRef<TypeName> results,
-    size_t function_offset, BEFFileImpl* bef_file) {
-  // std::make_unique cannot be used, as the constructor of SyncBEFFunction is
-  // private.
-  // NOLINTNEXTLINE
-  auto bef_function = std::unique_ptr<SyncBEFFunction>(
-      new SyncBEFFunction(name, arguments, results, function_offset, bef_file));
-
-  if (auto error = bef_function->Init())
-    return std::move(error);
-  else
-    return std::move(bef_function);
+SyncBEFFunction::~SyncBEFFunction() {
+  delete sync_execution_plan_.load();
 }
 
-Error SyncBEFFunction::Init() {
-  assert(register_infos_.empty());
-  assert(kernels_.empty());
-  assert(kernel_offsets_.empty());
-  assert(result_regs_.empty());
+Error SyncBEFFunction::ReadSyncExecutionPlan(ExecutionPlan* plan) const {
+  auto& register_infos = plan->register_infos;
+  auto& kernel_offsets = plan->kernel_offsets;
+  auto& result_regs = plan->result_regs;
 
   auto format_error = [&](const char* msg) -> Error {
     return MakeStringError("Invalid SyncBEFFunction(", msg, ")");
@@ -638,7 +785,7 @@ Error SyncBEFFunction::Init() {
       !reader.ReadVbrInt(&num_registers))
     return format_error("Failed to read location_offset or num_registers");
 
-  register_infos_.reserve(num_registers);
+  register_infos.reserve(num_registers);
   for (size_t reg_index = 0; reg_index < num_registers; ++reg_index) {
     size_t user_count;
     if (!reader.ReadVbrInt(&user_count))
@@ -650,7 +797,7 @@ Error SyncBEFFunction::Init() {
       // function evaluation.
       ++user_count;
     }
-    register_infos_.push_back(
+    register_infos.push_back(
         RegisterInfo{static_cast<uint32_t>(user_count), is_arg});
   }
 
@@ -659,7 +806,7 @@ Error SyncBEFFunction::Init() {
   if (!reader.ReadVbrInt(&num_kernels))
     return format_error("Failed to read num_kernels");
 
-  kernel_offsets_.reserve(num_kernels);
+  kernel_offsets.reserve(num_kernels);
 
   size_t offset, num_operands, stream_id;
 
@@ -673,21 +820,21 @@ Error SyncBEFFunction::Init() {
         !reader.ReadVbrInt(&stream_id))
       return format_error("Failed to read kernel offset or num_operands");
 
-    kernel_offsets_.push_back(offset);
+    kernel_offsets.push_back(offset);
   }
 
   // Read the result registers.
   size_t num_results = result_types().size();
-  result_regs_.reserve(num_results);
+  result_regs.reserve(num_results);
   for (unsigned i = 0, e = num_results; i != e; ++i) {
     size_t result_reg;
     if (!reader.ReadVbrInt(&result_reg) || result_reg >= num_registers)
       return format_error("Failed to read result_reg");
-    result_regs_.push_back(result_reg);
+    result_regs.push_back(result_reg);
 
     // +1 on the user count so that we do not reset the result Value in the
     // function evaluation.
-    auto& reg_info = register_infos_[result_reg];
+    auto& reg_info = register_infos[result_reg];
     if (reg_info.is_arg_or_result) {
       return format_error("Result cannot be an argument or another result");
     }
@@ -700,7 +847,7 @@ Error SyncBEFFunction::Init() {
     return format_error("Failed to align BEF to kKernelEntryAlignment");
 
   // We found the start of our kernel section.
-  kernels_ = llvm::makeArrayRef(
+  plan->kernels = llvm::makeArrayRef(
       reinterpret_cast<const uint32_t*>(reader.file().begin()),
       reader.file().size() / kKernelEntryAlignment);
 
@@ -19,6 +19,8 @@
 #ifndef TFRT_LIB_BEF_EXECUTOR_BEF_FILE_IMPL_H_
 #define TFRT_LIB_BEF_EXECUTOR_BEF_FILE_IMPL_H_
 
+#include <atomic>
+#include <memory>
 #include <type_traits>
 
 #include "llvm/ADT/ArrayRef.h"
@@ -37,6 +39,7 @@ namespace tfrt {
 
 class BEFFileImpl;
 class Value;
+struct BEFExecutionFrame;
 
 // Inlined array to keep registers and kernels info together with a BEF executor
 // if their size is small. Default constructed as empty, and must be resized
@@ -98,6 +101,35 @@ class BEFInfoArray {
   HostArray<InfoT> host_array_;
 };
 
+// BEFExecutionPlan keeps the function information that does not depend on a
+// particular execution: the register and kernel tables decoded from the BEF
+// file and the kernel implementations resolved from the kernel codes. It is
+// decoded once per BEFFunction, and every execution only needs to copy the
+// initial user and ready counts into its own register and kernel infos.
+struct BEFExecutionPlan {
+  struct KernelTemplate {
+    unsigned offset;
+    unsigned stream_id;
+    unsigned num_operands;
+  };
+
+  // This ArrayRef contains kernel entries of all kernels of this function.
+  ArrayRef<uint32_t> kernels;
+  // The number of uses of each register, indexed by the register number.
+  llvm::SmallVector<unsigned, 24> register_user_counts;
+  // Kernel table entries indexed by the kernel number.
+  llvm::SmallVector<KernelTemplate, 8> kernel_templates;
+  // Kernel implementations indexed by the kernel number. The arguments pseudo
+  // kernel has no implementation.
+  llvm::SmallVector<AsyncKernelImplementation, 8> kernel_impls;
+  // Register numbers of the function results.
+  llvm::SmallVector<size_t, 4> result_regs;
+  size_t location_offset = 0;
+  // Kernel profiler ids indexed by the kernel number, assigned when the kernel
+  // is first profiled, or zero.
+  std::unique_ptr<std::atomic<uint32_t>[]> kernel_profile_ids;
+};
+
 // This class implements Function for BEF files.
 class BEFFunction : public Function {
  public:
@@ -110,11 +142,28 @@ class BEFFunction : public Function {
   BEFFunction(BEFFunction&& other)
       : Function(std::move(other)),
         function_offset_(other.function_offset_),
-        bef_file_(other.bef_file_) {}
+        bef_file_(other.bef_file_),
+        execution_plan_(other.execution_plan_.exchange(nullptr)),
+        recycled_frame_(other.recycled_frame_.exchange(nullptr)) {}
+
+  ~BEFFunction() override;
 
   size_t function_offset() const { return function_offset_; }
   BEFFileImpl* bef_file() const { return bef_file_; }
 
+  // Returns the execution plan of this function, decoding it on the first
+  // call. Returns nullptr and emits an error if the BEF file is malformed.
+  // Thread-safe.
+  const BEFExecutionPlan* GetExecutionPlan() const;
+
+  // Returns the frame of a finished execution of this function for reuse, or
+  // nullptr if there is none. Thread-safe.
+  std::unique_ptr<BEFExecutionFrame> TakeExecutionFrame() const;
+
+  // Keeps the frame of a finished execution for the next execution of this
+  // function. At most one frame is kept, others are freed. Thread-safe.
+  void RecycleExecutionFrame(std::unique_ptr<BEFExecutionFrame> frame) const;
+
   void Execute(const ExecutionContext& exec_ctx,
                ArrayRef<AsyncValue*> arguments,
                MutableArrayRef<RCReference<AsyncValue>> results) const override;
@@ -134,6 +183,13 @@ class BEFFunction : public Function {
 
   size_t function_offset_;
   BEFFileImpl* bef_file_;
+
+  // Lazily initialized by GetExecutionPlan().
+  mutable std::atomic<BEFExecutionPlan*> execution_plan_{nullptr};
+
+  // The frame recycled by the last finished execution, see
+  // RecycleExecutionFrame().
+  mutable std::atomic<BEFExecutionFrame*> recycled_frame_{nullptr};
 };
 
 // This class implements SyncFunction for BEF files.
@@ -144,67 +200,85 @@ class SyncBEFFunction final : public BEFFunction {
     bool is_arg_or_result : 1;
   };
 
-  // Create a SyncBEFFunction. Return nullptr if the BEF file has format error.
-  static Expected<std::unique_ptr<SyncBEFFunction>> Create(
-      string_view name, ArrayRef<TypeName> arguments,
-      ArrayRef<TypeName> results, size_t function_offset,
-      BEFFileImpl* bef_file);
-
-  void Execute(
-      const ExecutionContext& exec_ctx, ArrayRef<AsyncValue*> arguments,
-      MutableArrayRef<RCReference<AsyncValue>> results) const override {
-    // TODO(b/160501723): Implement the async Execute() function for
-    // SyncBEFFunction when we need to interoperate between sync and async
-    // functions. This requires implementing conversion between Value and
-    // AsyncValue.
-    assert(false && "Not implemented");
-  }
+  // Pre-decoded kernel of the function. The interpreter runs the function by
+  // walking the array of threaded kernels, without decoding BEF kernel entries
+  // on every execution.
+  struct ThreadedKernel {
+    SyncKernelImplementation kernel_fn;
+    // Argument and result register indices, pointing into the BEF file.
+    ArrayRef<uint32_t> arguments;
+    ArrayRef<uint32_t> results;
+    // All attributes, including function attributes.
+    ArrayRef<const void*> attributes;
+    // Registers that are retired after the execution of this kernel.
+    ArrayRef<uint32_t> retired_regs;
+    // Positions of the arguments that are the last use of their register.
+    ArrayRef<uint32_t> last_use_args;
+    uint32_t kernel_code;
+  };
 
-  // Execute SyncBEFFunction synchronously. Return excution error in the Error
-  // return value.
-  Error SyncExecute(const ExecutionContext& exec_ctx,
-                    ArrayRef<Value*> arguments, ArrayRef<Value*> results) const;
+  // The register and kernel information of the function, and its threaded
+  // code. It is decoded on the first execution of the function, so that BEF
+  // files with many rarely used functions load quickly.
+  struct ExecutionPlan {
+    // This is an array of descriptors for all of our registers, indexed by
+    // their register number.
+    llvm::SmallVector<RegisterInfo, 16> register_infos;
 
-  // Return an array of descriptors for all of our registers, indexed by
-  // their register number.
-  ArrayRef<RegisterInfo> register_infos() const { return register_infos_; }
+    // This ArrayRef contains kernel entries of all kernels of this function.
+    ArrayRef<uint32_t> kernels;
 
-  // Return the kernel entries of all kernels of this function.
-  ArrayRef<uint32_t> kernels() const { return kernels_; }
+    // This is an array of offsets for all of the kernels in this function,
+    // indexed by the kernel number. This does not include the pseudo kernel as
+    // it is not used in the interpreter.
+    llvm::SmallVector<uint32_t, 8> kernel_offsets;
 
-  // Return an array of offsets for all of the kernels in this function,
-  // indexed by the kernel number.
-  ArrayRef<uint32_t> kernel_offsets() const { return kernel_offsets_; }
+    // This is an array of register index for the result registers.
+    llvm::SmallVector<uint32_t, 4> result_regs;
 
-  // Return an array of register index for the result registers.
-  ArrayRef<uint32_t> result_regs() const { return result_regs_; }
+    // Pre-decoded kernels in execution order, and the pools that back their
+    // retired registers, last use arguments and attributes.
+    llvm::SmallVector<ThreadedKernel, 8> threaded_code;
+    llvm::SmallVector<uint32_t, 16> retired_register_pool;
+    llvm::SmallVector<uint32_t, 16> last_use_arg_pool;
+    llvm::SmallVector<const void*, 16> attribute_pool;
+  };
 
- private:
   SyncBEFFunction(string_view name, ArrayRef<TypeName> arguments,
                   ArrayRef<TypeName> results, size_t function_offset,
                   BEFFileImpl* bef_file)
       : BEFFunction(name, FunctionKind::kSyncBEFFunction, arguments, results,
                     function_offset, bef_file) {}
 
-  // Read the register and kernel information for the function. We cache
-  // this information in SyncBEFFunction to avoid repeatedly reading this
-  // information for every function execution.
-  Error Init();
+  ~SyncBEFFunction() override;
 
-  // This is an array of descriptors for all of our registers, indexed by
-  // their register number.
-  llvm::SmallVector<RegisterInfo, 16> register_infos_;
+  // Execute SyncBEFFunction from an async caller once the arguments are
+  // available. Only supports functions whose arguments and results are scalars
+  // (i1, i32, i64, f32, f64) or chains, which are converted between Value and
+  // AsyncValue.
+  void Execute(
+      const ExecutionContext& exec_ctx, ArrayRef<AsyncValue*> arguments,
+      MutableArrayRef<RCReference<AsyncValue>> results) const override;
 
-  // This ArrayRef contains kernel entries of all kernels of this function.
-  ArrayRef<uint32_t> kernels_;
+  // Execute SyncBEFFunction synchronously. Return excution error in the Error
+  // return value.
+  Error SyncExecute(const ExecutionContext& exec_ctx,
+                    ArrayRef<Value*> arguments, ArrayRef<Value*> results) const;
+
+  // Returns the execution plan of this function, decoding it on the first
+  // call. Returns nullptr and emits an error if the BEF file is malformed.
+  // Thread-safe.
+  const ExecutionPlan* GetSyncExecutionPlan() const;
+
+ private:
+  // Read the register and kernel information for the function into `plan`.
+  Error ReadSyncExecutionPlan(ExecutionPlan* plan) const;
 
-  // This is an array of offsets for all of the kernels in this function,
-  // indexed by the kernel number. This does not include the pseudo kernel as it
-  // is not used in the interpreter.
-  llvm::SmallVector<uint32_t, 8> kernel_offsets_;
+  // Decode the kernels of this function into the threaded code of `plan`.
+  void InitThreadedCode(ExecutionPlan* plan) const;
 
-  // This is an array of register index for the result registers.
-  llvm::SmallVector<uint32_t, 4> result_regs_;
+  // Lazily initialized by GetSyncExecutionPlan().
+  mutable std::atomic<ExecutionPlan*> sync_execution_plan_{nullptr};
 };
 
 class BEFFileImpl;
@@ -289,18 +363,27 @@ class BEFFileImpl : public BEFFile {
   //
   // On error, an error is emitted and false is returned.
   //
-  // ReadFunction is invoked for every BEFFunction execution. We can consider
-  // caching the kernel and register information in the BEFFunction object to
-  // avoid repeadly reading the same information from the BEF file. However, in
-  // the current implementation, we couple BEFExecutor states, e.g. AsyncValue
-  // for RegisterInfo, with the function reading. Caching kernel and register
-  // information would require us to avoid such coupling which can adversely
-  // affect the performance.
+  // BEFExecutor does not call this for every execution. It uses the execution
+  // plan cached in BEFFunction and InitFunctionInfo() instead.
   bool ReadFunction(size_t function_offset, ArrayRef<TypeName> results,
                     size_t* location_offset, FunctionInfo* function_info,
                     llvm::SmallVectorImpl<size_t>* result_regs,
                     HostAllocator* host_allocator);
 
+  // Decode the register and kernel tables of the specified BEFFunction into
+  // `plan`. Kernel implementations are not resolved.
+  //
+  // On error, an error is emitted and false is returned.
+  bool ReadExecutionPlan(size_t function_offset, ArrayRef<TypeName> results,
+                         BEFExecutionPlan* plan);
+
+  // Initialize `function_info` for a new execution from `plan`. The info
+  // arrays of a `function_info` that was initialized from the same plan
+  // before are reused.
+  static void InitFunctionInfo(const BEFExecutionPlan& plan,
+                               FunctionInfo* function_info,
+                               HostAllocator* host_allocator);
+
   // Given an offset into the LocationPositions section, decode it and return
   // a DecodedDiagnostic.
   DecodedLocation DecodeLocation(size_t location_position_offset);
@@ -328,6 +411,11 @@ class BEFFileImpl : public BEFFile {
 
   ErrorHandler error_handler_;
 
+  // The memory region that holds the BEF file if it is owned by this BEFFile.
+  // The sections and functions below point into it, so it must be declared
+  // before them.
+  std::unique_ptr<io::ReadOnlyMemoryRegion> file_region_;
+
   ArrayRef<uint8_t> string_section_;
   ArrayRef<uint8_t> attribute_section_;
   ArrayRef<uint8_t> kernels_section_;
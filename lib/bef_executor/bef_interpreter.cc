@@ -18,18 +18,25 @@
 
 #include "tfrt/bef_executor/bef_interpreter.h"
 
+#include <atomic>
 #include <cstdint>
 #include <cstdio>
 #include <memory>
 
 #include "bef_file_impl.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "tfrt/bef/bef_encoding.h"
 #include "tfrt/bef/bef_reader.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/host_context/diagnostic.h"
 #include "tfrt/host_context/host_context.h"
 #include "tfrt/host_context/location.h"
 #include "tfrt/host_context/sync_kernel_frame.h"
+#include "tfrt/support/error_util.h"
 #include "tfrt/support/forward_decls.h"
 
 #ifdef TFRT_BEF_DEBUG
@@ -55,41 +62,19 @@ class BEFInterpreterImpl final {
                 ArrayRef<Value*> results);
 
  private:
-  struct KernelEntry {
-    SyncKernelImplementation kernel_fn;
-    // KernelEntry starting location in BEF.
-    const uint32_t* kernel_start;
-    // All attributes, including, function attributes.
-    // This refers to a segment in attribute_pool_.
-    int attribute_start;
-    int num_attributes;
-    // Registers that are retired after the execution of this kernel.
-    // This refers to a segment in retired_register_pool_.
-    ArrayRef<Value*> retired_regs;
-    // Kernel code.
-    uint32_t kernel_code;
-  };
-
-  // Set up the data for each kernel.
-  void SetupKernelEntries();
   // Set up the registers for the function computation.
   void SetupRegisters(ArrayRef<Value*> arguments, ArrayRef<Value*> results);
 
   const SyncBEFFunction& func_;
 
+  // The decoded function, or nullptr if it is malformed.
+  const SyncBEFFunction::ExecutionPlan* plan_;
+
   // All registers used in the function.
   llvm::SmallVector<Value*, 16> registers_;
 
   // Store local Values used in the computation.
   llvm::SmallVector<Value, 16> local_values_;
-
-  // All kernel entries in the function.
-  llvm::SmallVector<KernelEntry, 16> kernel_entries_;
-
-  // Registers that are retired at each kernel.
-  llvm::SmallVector<Value*, 16> retired_register_pool_;
-  // Attributes used in all kernels.
-  llvm::SmallVector<const void*, 16> attribute_pool_;
 };
 
 //===----------------------------------------------------------------------===//
@@ -109,9 +94,12 @@ Error BEFInterpreter::Execute(const ExecutionContext& exec_ctx,
 }
 
 BEFInterpreterImpl::BEFInterpreterImpl(const Function& func)
-    : func_{static_cast<const SyncBEFFunction&>(func)} {
+    : func_{static_cast<const SyncBEFFunction&>(func)},
+      plan_{func_.GetSyncExecutionPlan()} {
   assert(func.function_kind() == FunctionKind::kSyncBEFFunction);
-  auto register_infos = func_.register_infos();
+  if (!plan_) return;
+  ArrayRef<SyncBEFFunction::RegisterInfo> register_infos =
+      plan_->register_infos;
 
   size_t num_registers = register_infos.size();
 
@@ -137,107 +125,21 @@ BEFInterpreterImpl::BEFInterpreterImpl(const Function& func)
       ++local_value_index;
     }
   }
-
-  SetupKernelEntries();
-}
-
-void BEFInterpreterImpl::SetupKernelEntries() {
-  llvm::SmallVector<int, 16> user_counts;
-
-  auto register_infos = func_.register_infos();
-  user_counts.reserve(register_infos.size());
-
-  // Initialize the user counts for each register.
-  for (auto& reg_info : register_infos) {
-    user_counts.emplace_back() = reg_info.user_count;
-  }
-
-  retired_register_pool_.reserve(local_values_.size());
-
-  // Prepare all kernel entries for this function.
-  for (auto kernel_offset : func_.kernel_offsets()) {
-    auto& kernel_entry = kernel_entries_.emplace_back();
-
-    // Get the KernelEntry starting location in BEF.
-    kernel_entry.kernel_start =
-        func_.kernels().data() + kernel_offset / kKernelEntryAlignment;
-
-    BEFKernel kernel(kernel_entry.kernel_start);
-
-    // Get the kernel function.
-    kernel_entry.kernel_fn =
-        func_.bef_file()->GetSyncKernel(kernel.kernel_code());
-    kernel_entry.kernel_code = kernel.kernel_code();
-    assert(kernel_entry.kernel_fn != nullptr);
-
-    int retired_reg_start = retired_register_pool_.size();
-
-    // Collect retired registers from arguments.
-    auto arguments = kernel.GetArguments();
-    for (auto reg_idx : arguments) {
-      auto& user_count = user_counts[reg_idx];
-
-      --user_count;
-      assert(user_count >= 0);
-      if (user_count == 0) {
-        auto* value = registers_[reg_idx];
-        assert(value);
-        retired_register_pool_.emplace_back(value);
-      }
-    }
-
-    // Collect retired registers from results.
-    auto results = kernel.GetResults();
-    for (auto reg_index : results) {
-      // If there is no use for the result, mark it as retired.
-      if (user_counts[reg_index] == 0) {
-        auto* value = registers_[reg_index];
-        assert(value);
-        retired_register_pool_.emplace_back(value);
-      }
-    }
-
-    // Set the retired registers for this kernel.
-    kernel_entry.retired_regs =
-        llvm::makeArrayRef(retired_register_pool_.begin() + retired_reg_start,
-                           retired_register_pool_.end());
-
-    // Collect the attributes
-    int attribute_start = attribute_pool_.size();
-    auto attributes = kernel.GetAttributes();
-    for (auto attribute_offset : attributes) {
-      // We pass the pointer here because this attribute could be an array of
-      // size 0.
-      attribute_pool_.emplace_back(func_.bef_file()->attribute_section_.data() +
-                                   attribute_offset);
-    }
-
-    // Collect the function attributes.
-    auto functions = kernel.GetFunctions();
-    for (auto fn_idx : functions) {
-      // Functions are passed as their corresponding `Function`.
-      attribute_pool_.emplace_back(func_.bef_file()->functions_[fn_idx].get());
-    }
-
-    // Set the attributes for this kernel.
-    kernel_entry.attribute_start = attribute_start;
-    kernel_entry.num_attributes = attribute_pool_.size() - attribute_start;
-  }
 }
 
 void BEFInterpreterImpl::SetupRegisters(ArrayRef<Value*> arguments,
                                         ArrayRef<Value*> results) {
   // Set up argument Value
   for (size_t i = 0; i < arguments.size(); ++i) {
-    assert(func_.register_infos()[i].is_arg_or_result);
+    assert(plan_->register_infos[i].is_arg_or_result);
     assert(!registers_[i]);
     registers_[i] = arguments[i];
   }
 
   // Set up result Value
   auto result_index = 0;
-  for (auto reg_idx : func_.result_regs()) {
-    assert(func_.register_infos()[reg_idx].is_arg_or_result);
+  for (auto reg_idx : plan_->result_regs) {
+    assert(plan_->register_infos[reg_idx].is_arg_or_result);
     assert(!registers_[reg_idx]);
 
     registers_[reg_idx] = results[result_index];
@@ -253,28 +155,28 @@ Error BEFInterpreterImpl::Execute(const ExecutionContext& exec_ctx,
   assert(results.size() == func_.num_results() &&
          "incorrect number of results passed to function call");
 
+  if (!plan_)
+    return MakeStringError("invalid SyncBEFFunction ", func_.name());
+
   SetupRegisters(arguments, results);
 
   SyncKernelFrameBuilder kernel_frame(registers_, exec_ctx);
-  // Walk through each kernel entry and invoke each kernel sequentially.
-  for (auto& kernel_entry : kernel_entries_) {
+  // Walk through the threaded code and invoke each kernel sequentially.
+  for (const auto& kernel : plan_->threaded_code) {
     DEBUG_PRINT("Running kernel %s with kernel code %d: \n",
-                func_.bef_file()->GetKernelName(kernel_entry.kernel_code),
-                kernel_entry.kernel_code);
+                func_.bef_file()->GetKernelName(kernel.kernel_code),
+                kernel.kernel_code);
 
-    BEFKernel kernel(kernel_entry.kernel_start);
+    kernel_frame.SetArguments(kernel.arguments);
+    kernel_frame.SetLastUseArguments(kernel.last_use_args);
+    kernel_frame.SetAttributes(kernel.attributes);
+    kernel_frame.SetResults(kernel.results);
 
-    kernel_frame.SetArguments(kernel.GetArguments());
-    kernel_frame.SetAttributes(llvm::makeArrayRef(
-        attribute_pool_.data() + kernel_entry.attribute_start,
-        kernel_entry.num_attributes));
-    kernel_frame.SetResults(kernel.GetResults());
-
-    kernel_entry.kernel_fn(&kernel_frame);
+    kernel.kernel_fn(&kernel_frame);
 
     // Free values that are no longer needed.
-    for (auto value : kernel_entry.retired_regs) {
-      value->reset();
+    for (uint32_t reg_idx : kernel.retired_regs) {
+      registers_[reg_idx]->reset();
     }
 
     // Check for error.
@@ -290,7 +192,7 @@ Error BEFInterpreterImpl::Execute(const ExecutionContext& exec_ctx,
     registers_[i] = nullptr;
   }
 
-  for (auto reg_idx : func_.result_regs()) {
+  for (auto reg_idx : plan_->result_regs) {
     registers_[reg_idx] = nullptr;
   }
 
@@ -316,4 +218,250 @@ Error SyncBEFFunction::SyncExecute(const ExecutionContext& exec_ctx,
   return interpreter.Execute(exec_ctx, arguments, results);
 }
 
+// Calls `fn` with a null pointer of the C++ type of the BEF type `type`. Returns
+// false if `type` is not supported by SyncBEFFunction::Execute().
+template <typename F>
+static bool DispatchAsyncType(const TypeName& type, F&& fn) {
+  string_view name = type.GetName();
+  if (name == "i1") return fn(static_cast<bool*>(nullptr));
+  if (name == "i32") return fn(static_cast<int32_t*>(nullptr));
+  if (name == "i64") return fn(static_cast<int64_t*>(nullptr));
+  if (name == "f32") return fn(static_cast<float*>(nullptr));
+  if (name == "f64") return fn(static_cast<double*>(nullptr));
+  if (name == "!tfrt.chain") return fn(static_cast<Chain*>(nullptr));
+  return false;
+}
+
+// Runs `func` with the available `arguments`, and sets `results` to available
+// async values or errors.
+static void ExecuteWithAvailableArguments(
+    const SyncBEFFunction& func, const ExecutionContext& exec_ctx,
+    ArrayRef<AsyncValue*> arguments,
+    MutableArrayRef<RCReference<AsyncValue>> results) {
+  auto set_error = [&](RCReference<AsyncValue> error) {
+    for (auto& result : results) result = error;
+  };
+
+  for (AsyncValue* argument : arguments) {
+    if (argument->IsError()) return set_error(FormRef(argument));
+  }
+
+  // Arguments point to the payload of the async values.
+  llvm::SmallVector<Value, 4> argument_values;
+  argument_values.resize(arguments.size());
+  for (auto iter : llvm::enumerate(arguments)) {
+    Value& value = argument_values[iter.index()];
+    bool supported = DispatchAsyncType(
+        func.argument_types()[iter.index()], [&](auto* type) {
+          using T = std::remove_pointer_t<decltype(type)>;
+          value.set(&iter.value()->get<T>(), Value::PointerPayload{});
+          return true;
+        });
+    if (!supported) {
+      return set_error(EmitErrorAsync(
+          exec_ctx, StrCat("unsupported argument type ",
+                           func.argument_types()[iter.index()].GetName(),
+                           " in async call of sync function ", func.name())));
+    }
+  }
+
+  llvm::SmallVector<Value, 4> result_values;
+  result_values.resize(results.size());
+  llvm::SmallVector<Value*, 4> argument_ptrs, result_ptrs;
+  for (Value& value : argument_values) argument_ptrs.push_back(&value);
+  for (Value& value : result_values) result_ptrs.push_back(&value);
+
+  if (auto error = func.SyncExecute(exec_ctx, argument_ptrs, result_ptrs))
+    return set_error(EmitErrorAsync(exec_ctx, std::move(error)));
+
+  for (auto iter : llvm::enumerate(results)) {
+    Value& value = result_values[iter.index()];
+    bool supported = DispatchAsyncType(
+        func.result_types()[iter.index()], [&](auto* type) {
+          using T = std::remove_pointer_t<decltype(type)>;
+          iter.value() =
+              MakeAvailableAsyncValueRef<T>(std::move(value.get<T>()));
+          return true;
+        });
+    if (!supported) {
+      iter.value() = EmitErrorAsync(
+          exec_ctx, StrCat("unsupported result type ",
+                           func.result_types()[iter.index()].GetName(),
+                           " in async call of sync function ", func.name()));
+    }
+  }
+}
+
+void SyncBEFFunction::Execute(
+    const ExecutionContext& exec_ctx, ArrayRef<AsyncValue*> arguments,
+    MutableArrayRef<RCReference<AsyncValue>> results) const {
+  llvm::SmallVector<AsyncValue*, 4> unavailable_args;
+  for (auto* av : arguments)
+    if (!av->IsAvailable()) unavailable_args.push_back(av);
+
+  // Run immediately if all arguments are ready.
+  if (unavailable_args.empty()) {
+    ExecuteWithAvailableArguments(*this, exec_ctx, arguments, results);
+    return;
+  }
+
+  // Otherwise create references to arguments and allocate indirect results for
+  // async execution.
+  llvm::SmallVector<RCReference<AsyncValue>, 4> args;
+  args.reserve(arguments.size());
+  for (auto* av : arguments) args.push_back(FormRef(av));
+
+  llvm::SmallVector<RCReference<IndirectAsyncValue>, 4> indirect_results;
+  indirect_results.reserve(results.size());
+  for (auto& av_ref : results) {
+    indirect_results.push_back(MakeIndirectAsyncValue());
+    av_ref = indirect_results.back();
+  }
+
+  RunWhenReady(unavailable_args,
+               [this, exec_ctx, args = std::move(args),
+                indirect_results = std::move(indirect_results)]() mutable {
+                 llvm::SmallVector<AsyncValue*, 4> arg_avs;
+                 arg_avs.reserve(args.size());
+                 for (const auto& arg : args) arg_avs.push_back(arg.get());
+
+                 llvm::SmallVector<RCReference<AsyncValue>, 4> results;
+                 results.resize(indirect_results.size());
+                 ExecuteWithAvailableArguments(*this, exec_ctx, arg_avs,
+                                               results);
+
+                 for (int i = 0, e = results.size(); i != e; ++i)
+                   indirect_results[i]->ForwardTo(std::move(results[i]));
+               });
+}
+
+const SyncBEFFunction::ExecutionPlan* SyncBEFFunction::GetSyncExecutionPlan()
+    const {
+  if (const ExecutionPlan* plan =
+          sync_execution_plan_.load(std::memory_order_acquire))
+    return plan;
+
+  auto plan = std::make_unique<ExecutionPlan>();
+  if (auto error = ReadSyncExecutionPlan(plan.get())) {
+    bef_file_->EmitFormatError(llvm::toString(std::move(error)));
+    return nullptr;
+  }
+  InitThreadedCode(plan.get());
+
+  // Several threads may decode the plan concurrently; the first one wins.
+  ExecutionPlan* expected = nullptr;
+  if (sync_execution_plan_.compare_exchange_strong(expected, plan.get(),
+                                                   std::memory_order_acq_rel))
+    return plan.release();
+  return expected;
+}
+
+void SyncBEFFunction::InitThreadedCode(ExecutionPlan* plan) const {
+  auto& register_infos = plan->register_infos;
+  auto& threaded_code = plan->threaded_code;
+  auto& retired_register_pool = plan->retired_register_pool;
+  auto& last_use_arg_pool = plan->last_use_arg_pool;
+  auto& attribute_pool = plan->attribute_pool;
+  assert(threaded_code.empty());
+
+  llvm::SmallVector<int, 16> user_counts;
+  user_counts.reserve(register_infos.size());
+
+  // Initialize the user counts for each register.
+  for (auto& reg_info : register_infos) {
+    user_counts.emplace_back() = reg_info.user_count;
+  }
+
+  // Pools are populated first, and the threaded kernels are pointed to their
+  // segments once the pools stop growing.
+  struct PoolSegments {
+    size_t retired_reg_start;
+    size_t last_use_arg_start;
+    size_t attribute_start;
+  };
+  llvm::SmallVector<PoolSegments, 8> segments;
+
+  threaded_code.reserve(plan->kernel_offsets.size());
+  segments.reserve(plan->kernel_offsets.size());
+
+  // Prepare all threaded kernels for this function.
+  for (auto kernel_offset : plan->kernel_offsets) {
+    BEFKernel kernel(plan->kernels.data() +
+                     kernel_offset / kKernelEntryAlignment);
+
+    auto& threaded_kernel = threaded_code.emplace_back();
+    auto& segment = segments.emplace_back();
+
+    // Get the kernel function.
+    threaded_kernel.kernel_fn = bef_file_->GetSyncKernel(kernel.kernel_code());
+    threaded_kernel.kernel_code = kernel.kernel_code();
+    assert(threaded_kernel.kernel_fn != nullptr);
+
+    threaded_kernel.arguments = kernel.GetArguments();
+    threaded_kernel.results = kernel.GetResults();
+
+    segment.retired_reg_start = retired_register_pool.size();
+    segment.last_use_arg_start = last_use_arg_pool.size();
+
+    // Collect retired registers from arguments. The argument that retires a
+    // register is its last use, and the kernel may move the value out of it.
+    for (auto iter : llvm::enumerate(threaded_kernel.arguments)) {
+      auto reg_idx = iter.value();
+      auto& user_count = user_counts[reg_idx];
+
+      --user_count;
+      assert(user_count >= 0);
+      if (user_count == 0) {
+        assert(!register_infos[reg_idx].is_arg_or_result);
+        retired_register_pool.emplace_back(reg_idx);
+        last_use_arg_pool.emplace_back(iter.index());
+      }
+    }
+
+    // Collect retired registers from results.
+    for (auto reg_idx : threaded_kernel.results) {
+      // If there is no use for the result, mark it as retired.
+      if (user_counts[reg_idx] == 0) {
+        assert(!register_infos[reg_idx].is_arg_or_result);
+        retired_register_pool.emplace_back(reg_idx);
+      }
+    }
+
+    // Collect the attributes.
+    segment.attribute_start = attribute_pool.size();
+    for (auto attribute_offset : kernel.GetAttributes()) {
+      // We pass the pointer here because this attribute could be an array of
+      // size 0.
+      attribute_pool.emplace_back(bef_file_->attribute_section_.data() +
+                                   attribute_offset);
+    }
+
+    // Collect the function attributes.
+    for (auto fn_idx : kernel.GetFunctions()) {
+      // Functions are passed as their corresponding `Function`.
+      attribute_pool.emplace_back(bef_file_->functions_[fn_idx].get());
+    }
+  }
+
+  // Set the retired registers, the last use arguments and the attributes of
+  // each kernel.
+  for (size_t i = 0, e = threaded_code.size(); i != e; ++i) {
+    size_t retired_reg_end = i + 1 == e ? retired_register_pool.size()
+                                        : segments[i + 1].retired_reg_start;
+    size_t last_use_arg_end = i + 1 == e ? last_use_arg_pool.size()
+                                         : segments[i + 1].last_use_arg_start;
+    size_t attribute_end = i + 1 == e ? attribute_pool.size()
+                                      : segments[i + 1].attribute_start;
+    threaded_code[i].retired_regs = llvm::makeArrayRef(
+        retired_register_pool.begin() + segments[i].retired_reg_start,
+        retired_register_pool.begin() + retired_reg_end);
+    threaded_code[i].last_use_args = llvm::makeArrayRef(
+        last_use_arg_pool.begin() + segments[i].last_use_arg_start,
+        last_use_arg_pool.begin() + last_use_arg_end);
+    threaded_code[i].attributes = llvm::makeArrayRef(
+        attribute_pool.begin() + segments[i].attribute_start,
+        attribute_pool.begin() + attribute_end);
+  }
+}
+
 }  // namespace tfrt
@@ -0,0 +1,431 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Kernel profiler
+//
+// This file implements the kernel profiler.
+
+#include "tfrt/bef_executor/kernel_profiler.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/metrics/metrics.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/string_util.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace kernel_profiler {
+
+std::atomic<bool> kEnabled{false};
+
+namespace {
+
+// Call times are recorded into histograms with four buckets per power of two.
+constexpr int kNumBuckets = 160;
+
+int GetBucket(int64_t ns) {
+  if (ns < 4) return std::max<int64_t>(ns, 0);
+  int exponent = llvm::Log2_64(ns);
+  int bucket = (exponent - 1) * 4 + ((ns >> (exponent - 2)) & 3);
+  return std::min(bucket, kNumBuckets - 1);
+}
+
+int64_t GetBucketLowerBound(int bucket) {
+  if (bucket < 4) return bucket;
+  int exponent = bucket / 4 + 1;
+  return static_cast<int64_t>(4 + bucket % 4) << (exponent - 2);
+}
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Counters of one kernel on one thread. They are only written by their thread,
+// so they are incremented without read-modify-write operations, but they are
+// atomic because GetKernelProfiles() reads them concurrently.
+struct KernelStats {
+  static void Add(std::atomic<int64_t>& counter, int64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+
+  std::atomic<int64_t> calls{0};
+  std::atomic<int64_t> outline_calls{0};
+  std::atomic<int64_t> total_ns{0};
+  std::atomic<int64_t> self_ns{0};
+  std::atomic<int64_t> buckets[kNumBuckets] = {};
+};
+
+// The kernel stats of one thread, indexed by kernel id. Entries are allocated
+// by their thread, and published with release stores so that readers can find
+// them without locks.
+class ThreadStats {
+ public:
+  static constexpr size_t kChunkSize = 256;
+  static constexpr size_t kMaxChunks = 256;
+
+  ~ThreadStats() {
+    for (auto& chunk : chunks_) {
+      Chunk* chunk_ptr = chunk.load(std::memory_order_relaxed);
+      if (chunk_ptr == nullptr) continue;
+      for (auto& stats : chunk_ptr->stats)
+        delete stats.load(std::memory_order_relaxed);
+      delete chunk_ptr;
+    }
+  }
+
+  // Returns the stats of kernel `id`, allocating them if needed. Must only be
+  // called by the owning thread.
+  KernelStats* Get(uint32_t id) {
+    std::atomic<Chunk*>& chunk = chunks_[id / kChunkSize];
+    Chunk* chunk_ptr = chunk.load(std::memory_order_relaxed);
+    if (chunk_ptr == nullptr) {
+      chunk_ptr = new Chunk;
+      chunk.store(chunk_ptr, std::memory_order_release);
+    }
+    std::atomic<KernelStats*>& stats = chunk_ptr->stats[id % kChunkSize];
+    KernelStats* stats_ptr = stats.load(std::memory_order_relaxed);
+    if (stats_ptr == nullptr) {
+      stats_ptr = new KernelStats;
+      stats.store(stats_ptr, std::memory_order_release);
+    }
+    return stats_ptr;
+  }
+
+  // Returns the stats of kernel `id`, or null if the thread didn't record any.
+  const KernelStats* Find(uint32_t id) const {
+    Chunk* chunk = chunks_[id / kChunkSize].load(std::memory_order_acquire);
+    if (chunk == nullptr) return nullptr;
+    return chunk->stats[id % kChunkSize].load(std::memory_order_acquire);
+  }
+
+ private:
+  struct Chunk {
+    std::atomic<KernelStats*> stats[kChunkSize] = {};
+  };
+
+  std::atomic<Chunk*> chunks_[kMaxChunks] = {};
+};
+
+struct Options {
+  llvm::StringSet<> functions;
+  int sampling_period = 1;
+};
+
+struct KernelKey {
+  std::string name;
+  std::string location;
+};
+
+// Metrics of one kernel, and the counts they have been incremented by.
+struct ExportedMetrics {
+  metrics::Counter* calls;
+  metrics::Counter* outline_calls;
+  metrics::Counter* total_ns;
+  metrics::Counter* self_ns;
+  metrics::Gauge<int64_t>* p50_ns;
+  metrics::Gauge<int64_t>* p99_ns;
+  KernelProfile exported;
+};
+
+class Profiler {
+ public:
+  static Profiler& Get() {
+    static auto* profiler = new Profiler;
+    return *profiler;
+  }
+
+  void SetOptions(const KernelProfilerOptions& options) {
+    auto new_options = std::make_shared<Options>();
+    for (const std::string& function : options.functions)
+      new_options->functions.insert(function);
+    new_options->sampling_period = std::max(options.sampling_period, 1);
+    mutex_lock lock(mu_);
+    options_ = std::move(new_options);
+    options_generation_.fetch_add(1, std::memory_order_release);
+  }
+
+  // Returns the options, refreshing the thread local copy if they changed.
+  std::shared_ptr<const Options> GetOptions(
+      std::shared_ptr<const Options>& cached, uint64_t& cached_generation) {
+    uint64_t generation = options_generation_.load(std::memory_order_acquire);
+    if (!cached || cached_generation != generation) {
+      mutex_lock lock(mu_);
+      cached = options_;
+      cached_generation = generation;
+    }
+    return cached;
+  }
+
+  uint32_t GetKernelId(string_view name, string_view location) {
+    std::string key = StrCat(name, "@", location);
+    mutex_lock lock(mu_);
+    auto it = kernel_ids_.find(key);
+    if (it != kernel_ids_.end()) return it->second;
+    if (kernels_.size() >= ThreadStats::kChunkSize * ThreadStats::kMaxChunks)
+      return 0;
+    uint32_t id = kernels_.size();
+    kernel_ids_.try_emplace(key, id);
+    kernels_.push_back({name.str(), location.str()});
+    return id;
+  }
+
+  ThreadStats* NewThreadStats() {
+    auto* stats = new ThreadStats;
+    mutex_lock lock(mu_);
+    threads_.push_back(stats);
+    return stats;
+  }
+
+  std::vector<KernelProfile> GetProfiles() {
+    std::vector<KernelKey> kernels;
+    std::vector<ThreadStats*> threads;
+    {
+      mutex_lock lock(mu_);
+      kernels = kernels_;
+      threads = threads_;
+    }
+
+    std::vector<KernelProfile> profiles;
+    // Id 0 is reserved for kernels which are not profiled.
+    for (uint32_t id = 1; id < kernels.size(); ++id) {
+      KernelProfile profile;
+      int64_t buckets[kNumBuckets] = {};
+      int64_t total_ns = 0, self_ns = 0;
+      for (ThreadStats* thread : threads) {
+        const KernelStats* stats = thread->Find(id);
+        if (stats == nullptr) continue;
+        profile.calls += stats->calls.load(std::memory_order_relaxed);
+        profile.outline_calls +=
+            stats->outline_calls.load(std::memory_order_relaxed);
+        total_ns += stats->total_ns.load(std::memory_order_relaxed);
+        self_ns += stats->self_ns.load(std::memory_order_relaxed);
+        for (int i = 0; i < kNumBuckets; ++i)
+          buckets[i] += stats->buckets[i].load(std::memory_order_relaxed);
+      }
+      if (profile.calls == 0) continue;
+
+      profile.name = std::move(kernels[id].name);
+      profile.location = std::move(kernels[id].location);
+      profile.total_time = std::chrono::nanoseconds(total_ns);
+      profile.self_time = std::chrono::nanoseconds(self_ns);
+
+      // Histogram counts may lag behind the call counts of running threads.
+      int64_t count = 0;
+      for (int64_t bucket_count : buckets) count += bucket_count;
+      auto percentile = [&](double fraction) {
+        int64_t rank = static_cast<int64_t>(fraction * count);
+        for (int i = 0; i < kNumBuckets; ++i) {
+          rank -= buckets[i];
+          if (rank < 0) return std::chrono::nanoseconds(GetBucketLowerBound(i));
+        }
+        return std::chrono::nanoseconds(GetBucketLowerBound(kNumBuckets - 1));
+      };
+      profile.p50_time = percentile(0.5);
+      profile.p99_time = percentile(0.99);
+      profiles.push_back(std::move(profile));
+    }
+
+    std::sort(profiles.begin(), profiles.end(),
+              [](const KernelProfile& a, const KernelProfile& b) {
+                return a.self_time > b.self_time;
+              });
+    return profiles;
+  }
+
+  void ExportMetrics() {
+    std::vector<KernelProfile> profiles = GetProfiles();
+    mutex_lock lock(export_mu_);
+    for (const KernelProfile& profile : profiles) {
+      std::string prefix = StrCat("/tfrt/bef_executor/kernel_profile/",
+                                  profile.name, "@", profile.location, "/");
+      auto it = exported_.find(prefix);
+      if (it == exported_.end()) {
+        ExportedMetrics metrics_for_kernel = {
+            metrics::NewCounter(StrCat(prefix, "calls")),
+            metrics::NewCounter(StrCat(prefix, "outline_calls")),
+            metrics::NewCounter(StrCat(prefix, "total_ns")),
+            metrics::NewCounter(StrCat(prefix, "self_ns")),
+            metrics::NewGauge<int64_t>(StrCat(prefix, "p50_ns")),
+            metrics::NewGauge<int64_t>(StrCat(prefix, "p99_ns")),
+            KernelProfile()};
+        it = exported_.try_emplace(prefix, std::move(metrics_for_kernel))
+                 .first;
+      }
+      ExportedMetrics& exported = it->second;
+      exported.calls->IncrementBy(profile.calls - exported.exported.calls);
+      exported.outline_calls->IncrementBy(profile.outline_calls -
+                                          exported.exported.outline_calls);
+      exported.total_ns->IncrementBy(
+          (profile.total_time - exported.exported.total_time).count());
+      exported.self_ns->IncrementBy(
+          (profile.self_time - exported.exported.self_time).count());
+      exported.p50_ns->Set(profile.p50_time.count());
+      exported.p99_ns->Set(profile.p99_time.count());
+      exported.exported = profile;
+    }
+  }
+
+ private:
+  Profiler() { kernels_.push_back({"<unknown>", ""}); }
+
+  mutex mu_;
+  std::shared_ptr<const Options> options_ TFRT_GUARDED_BY(mu_);
+  std::atomic<uint64_t> options_generation_{0};
+  llvm::StringMap<uint32_t> kernel_ids_ TFRT_GUARDED_BY(mu_);
+  std::vector<KernelKey> kernels_ TFRT_GUARDED_BY(mu_);
+  // Stats of threads are never deleted, so they are still included after the
+  // thread exits.
+  std::vector<ThreadStats*> threads_ TFRT_GUARDED_BY(mu_);
+
+  mutex export_mu_;
+  llvm::StringMap<ExportedMetrics> exported_ TFRT_GUARDED_BY(export_mu_);
+};
+
+struct ThreadState {
+  ThreadStats* GetStats() {
+    if (stats == nullptr) stats = Profiler::Get().NewThreadStats();
+    return stats;
+  }
+
+  ThreadStats* stats = nullptr;
+  std::shared_ptr<const Options> options;
+  uint64_t options_generation = 0;
+  uint64_t num_executions = 0;
+  // Number of profiled kernel calls on the stack of the thread.
+  int depth = 0;
+  // Time spent in the profiled kernels called by the innermost profiled call.
+  int64_t nested_ns = 0;
+};
+
+ThreadState& GetThreadState() {
+  static thread_local ThreadState state;
+  return state;
+}
+
+}  // namespace
+
+bool ShouldProfileExecutionSlow(string_view function_name) {
+  ThreadState& state = GetThreadState();
+  // Executions called synchronously by a profiled kernel are profiled, so
+  // that their time is not included in the self time of the caller.
+  if (state.depth > 0) return true;
+
+  std::shared_ptr<const Options> options = Profiler::Get().GetOptions(
+      state.options, state.options_generation);
+  if (!options->functions.empty() && !options->functions.count(function_name))
+    return false;
+  return state.num_executions++ % options->sampling_period == 0;
+}
+
+uint32_t GetKernelId(string_view name, string_view location) {
+  return Profiler::Get().GetKernelId(name, location);
+}
+
+void RecordOutlineCall(uint32_t id) {
+  if (id == 0) return;
+  KernelStats::Add(GetThreadState().GetStats()->Get(id)->outline_calls, 1);
+}
+
+ProfiledKernelCall::ProfiledKernelCall(uint32_t id) : id_(id) {
+  ThreadState& state = GetThreadState();
+  ++state.depth;
+  outer_nested_ns_ = state.nested_ns;
+  state.nested_ns = 0;
+  start_ns_ = NowNs();
+}
+
+ProfiledKernelCall::~ProfiledKernelCall() {
+  int64_t total_ns = NowNs() - start_ns_;
+  ThreadState& state = GetThreadState();
+  int64_t self_ns = total_ns - state.nested_ns;
+  state.nested_ns = outer_nested_ns_ + total_ns;
+  --state.depth;
+  if (id_ == 0) return;
+
+  KernelStats* stats = state.GetStats()->Get(id_);
+  KernelStats::Add(stats->calls, 1);
+  KernelStats::Add(stats->total_ns, total_ns);
+  KernelStats::Add(stats->self_ns, self_ns);
+  KernelStats::Add(stats->buckets[GetBucket(total_ns)], 1);
+}
+
+}  // namespace kernel_profiler
+
+void EnableKernelProfiler(const KernelProfilerOptions& options) {
+  kernel_profiler::Profiler::Get().SetOptions(options);
+  kernel_profiler::kEnabled.store(true, std::memory_order_relaxed);
+}
+
+void DisableKernelProfiler() {
+  kernel_profiler::kEnabled.store(false, std::memory_order_relaxed);
+}
+
+std::vector<KernelProfile> GetKernelProfiles() {
+  return kernel_profiler::Profiler::Get().GetProfiles();
+}
+
+void PrintKernelProfiles(raw_ostream& os) {
+  auto to_ms = [](std::chrono::nanoseconds time) {
+    return time.count() * 1e-6;
+  };
+  auto to_us = [](std::chrono::nanoseconds time) {
+    return time.count() * 1e-3;
+  };
+  os << llvm::format("%12s %8s %12s %12s %10s %10s  %s\n", "calls",
+                     "inline%", "total ms", "self ms", "p50 us", "p99 us",
+                     "kernel");
+  for (const KernelProfile& profile : GetKernelProfiles()) {
+    double inline_percent =
+        100.0 * (profile.calls - profile.outline_calls) / profile.calls;
+    os << llvm::format("%12lld %8.1f %12.3f %12.3f %10.3f %10.3f  ",
+                       static_cast<long long>(profile.calls), inline_percent,
+                       to_ms(profile.total_time), to_ms(profile.self_time),
+                       to_us(profile.p50_time), to_us(profile.p99_time))
+       << profile.name << " " << profile.location << "\n";
+  }
+}
+
+void WriteKernelCostProfile(raw_ostream& os) {
+  // Kernels at the same location are aggregated. Locations are sorted to make
+  // the output deterministic.
+  std::map<std::string, std::pair<std::chrono::nanoseconds, int64_t>> costs;
+  for (const KernelProfile& profile : GetKernelProfiles()) {
+    if (profile.location.empty() || profile.calls == 0) continue;
+    auto& cost = costs[profile.location];
+    cost.first += profile.total_time;
+    cost.second += profile.calls;
+  }
+  for (const auto& cost : costs) {
+    os << cost.second.first.count() / cost.second.second << "\t" << cost.first
+       << "\n";
+  }
+}
+
+void ExportKernelProfileMetrics() {
+  kernel_profiler::Profiler::Get().ExportMetrics();
+}
+
+}  // namespace tfrt
@@ -18,14 +18,20 @@
 // up a given mlir file and then runs it with a host executor.
 #include "tfrt/bef_executor_driver/bef_executor_driver.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <limits>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/ScopeExit.h"
 #include "llvm/Support/DynamicLibrary.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm_derived/Support/raw_ostream.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/Diagnostics.h"
@@ -36,6 +42,7 @@
 #include "tfrt/bef_executor/bef_file.h"
 #include "tfrt/core_runtime/core_runtime.h"
 #include "tfrt/core_runtime/tensor_handle.h"
+#include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/async_value.h"
 #include "tfrt/host_context/concurrent_work_queue.h"
 #include "tfrt/host_context/function.h"
@@ -57,7 +64,7 @@ static void RunBefFunction(
     HostContext* host, const Function& function,
     const std::function<llvm::Expected<ExecutionContext>(
         HostContext*, ResourceContext*)>& create_execution_context,
-    bool print_error_code);
+    const RunBefConfig& run_config);
 
 int RunBefExecutor(const RunBefConfig& run_config) {
   return RunBefExecutor(
@@ -130,6 +137,22 @@ int RunBefExecutor(
       host_allocator = CreateMallocAllocator();
       host_allocator = CreateLeakCheckAllocator(std::move(host_allocator));
       tfrt::outs() << "Choosing memory leak check allocator.\n";
+      break;
+    case HostAllocatorType::kSlab:
+      host_allocator = CreateSlabAllocator(CreateMallocAllocator());
+      tfrt::outs() << "Choosing slab allocator based on malloc.\n";
+      break;
+    case HostAllocatorType::kNuma:
+      host_allocator = CreateNumaAllocator(CreateMallocAllocator());
+      tfrt::outs() << "Choosing NUMA allocator based on malloc.\n";
+      break;
+    case HostAllocatorType::kBufferPool:
+      host_allocator = CreateBufferPoolAllocator(CreateMallocAllocator());
+      tfrt::outs() << "Choosing buffer pool allocator based on malloc.\n";
+      break;
+    case HostAllocatorType::kHugePage:
+      host_allocator = CreateHugePageAllocator(CreateMallocAllocator());
+      tfrt::outs() << "Choosing huge page allocator based on malloc.\n";
   }
   tfrt::outs().flush();
 
@@ -204,6 +227,7 @@ int RunBefExecutor(
     }
   }
 
+  auto load_start = std::chrono::steady_clock::now();
   auto bef(BEFFile::Open(buffer_arr, host->GetKernelRegistry(),
                          decoded_diagnostic_handler, host->allocator()));
 
@@ -211,6 +235,17 @@ int RunBefExecutor(
     return mlir::failed(source_mgr_handler.verify());
   }
 
+  // Report the load time with the benchmark results, so that model load
+  // regressions are tracked with the execution ones.
+  if (run_config.num_benchmark_runs > 0) {
+    tfrt::outs() << "BM:bef_file:Load Time(us): "
+                 << std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - load_start)
+                        .count()
+                 << "\n";
+    tfrt::outs().flush();
+  }
+
   llvm::SmallVector<const Function*, 8> function_list;
 
   if (run_config.functions.empty()) {
@@ -237,14 +272,13 @@ int RunBefExecutor(
 
   if (test_init_function) {
     RunBefFunction(host, *test_init_function, create_execution_context,
-                   run_config.print_error_code);
+                   run_config);
   }
 
   // Loop over each of the functions, running each as a standalone testcase.
   for (auto* fn : function_list) {
     if (fn != test_init_function) {
-      RunBefFunction(host, *fn, create_execution_context,
-                     run_config.print_error_code);
+      RunBefFunction(host, *fn, create_execution_context, run_config);
     }
   }
 
@@ -363,11 +397,103 @@ static void RunAsyncBefFunctionHelper(const ExecutionContext& exec_ctx,
   exec_ctx.host()->Quiesce();
 }
 
+// Runs `function` run_config.num_benchmark_runs times with up to
+// run_config.max_in_flight runs in flight, and prints the throughput and the
+// latency percentiles of the runs, both as a summary line and as BM: lines
+// that benchmark scripts parse (see mlir_tests/bef_perf/benchmark_utils.py).
+static void BenchmarkBefFunction(const ExecutionContext& exec_ctx,
+                                 const Function& function,
+                                 const RunBefConfig& run_config) {
+  using Clock = std::chrono::steady_clock;
+  HostContext* host = exec_ctx.host();
+  const int num_runs = run_config.num_benchmark_runs;
+  const int max_in_flight = std::max(run_config.max_in_flight, 1);
+
+  std::vector<Clock::duration> latencies(num_runs);
+  std::atomic<int> next_run{0};
+  std::atomic<int> num_errors{0};
+
+  // Each lane runs the function until all runs have been started, starting the
+  // next run when the previous one completed.
+  std::function<void()> run_async_lane = [&] {
+    int run = next_run.fetch_add(1);
+    if (run >= num_runs) return;
+    Clock::time_point start = Clock::now();
+    llvm::SmallVector<RCReference<AsyncValue>, 4> results(
+        function.num_results());
+    function.Execute(exec_ctx, /*arguments=*/{}, results);
+
+    llvm::SmallVector<AsyncValue*, 4> result_ptrs;
+    for (auto& result : results) result_ptrs.push_back(result.get());
+    RunWhenReady(result_ptrs, [&, run, start, results = std::move(results)] {
+      latencies[run] = Clock::now() - start;
+      if (llvm::any_of(results, [](const auto& r) { return r->IsError(); }))
+        ++num_errors;
+      // Continue on the work queue, so that functions which complete
+      // synchronously don't recurse.
+      EnqueueWork(exec_ctx, [&] { run_async_lane(); });
+    });
+  };
+
+  auto run_sync_lane = [&] {
+    llvm::SmallVector<Value, 4> results(function.num_results());
+    llvm::SmallVector<Value*, 4> result_ptrs;
+    for (auto& value : results) result_ptrs.push_back(&value);
+    for (int run; (run = next_run.fetch_add(1)) < num_runs;) {
+      Clock::time_point start = Clock::now();
+      if (auto error = ExecuteSyncBEFFunction(function, exec_ctx,
+                                              /*arguments=*/{}, result_ptrs)) {
+        llvm::consumeError(std::move(error));
+        ++num_errors;
+      }
+      latencies[run] = Clock::now() - start;
+      for (auto& value : results) value.reset();
+    }
+  };
+
+  Clock::time_point start = Clock::now();
+  for (int i = 0; i < max_in_flight; ++i) {
+    if (function.function_kind() == FunctionKind::kSyncBEFFunction) {
+      EnqueueWork(exec_ctx, run_sync_lane);
+    } else {
+      EnqueueWork(exec_ctx, [&] { run_async_lane(); });
+    }
+  }
+  host->Quiesce();
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile_us = [&](int percent) {
+    size_t index = std::min<size_t>(num_runs * percent / 100, num_runs - 1);
+    return std::chrono::duration<double, std::micro>(latencies[index]).count();
+  };
+  tfrt::outs() << "'" << function.name() << "' ran " << num_runs
+               << " times with up to " << max_in_flight << " in flight in "
+               << seconds * 1e3 << " ms (" << num_runs / seconds
+               << " runs/s, " << num_errors.load() << " errors), latency us: "
+               << "min " << percentile_us(0) << ", p50 " << percentile_us(50)
+               << ", p90 " << percentile_us(90) << ", p99 "
+               << percentile_us(99) << ", max " << percentile_us(100) << "\n";
+
+  std::string prefix;
+  llvm::raw_string_ostream(prefix) << "BM:" << function.name() << ':';
+  tfrt::outs() << prefix << "Count: " << num_runs << '\n';
+  tfrt::outs() << prefix << "In Flight: " << max_in_flight << '\n';
+  tfrt::outs() << prefix << "Errors: " << num_errors.load() << '\n';
+  tfrt::outs() << prefix << "Throughput(runs/s): " << num_runs / seconds
+               << '\n';
+  tfrt::outs() << prefix << "Latency Min(us): " << percentile_us(0) << '\n';
+  tfrt::outs() << prefix << "Latency 50%(us): " << percentile_us(50) << '\n';
+  tfrt::outs() << prefix << "Latency 90%(us): " << percentile_us(90) << '\n';
+  tfrt::outs() << prefix << "Latency 99%(us): " << percentile_us(99) << '\n';
+  tfrt::outs().flush();
+}
+
 static void RunBefFunction(
     HostContext* host, const Function& function,
     const std::function<llvm::Expected<ExecutionContext>(
         HostContext*, ResourceContext*)>& create_execution_context,
-    bool print_error_code) {
+    const RunBefConfig& run_config) {
   // If the function takes arguments, then we can't run it from this driver.
   if (!function.argument_types().empty()) {
     tfrt::outs() << "--- Not running '" << function.name()
@@ -402,11 +528,15 @@ static void RunBefFunction(
       llvm::errs() << "Failed to create execution context.\n";
       abort();
     }
+    if (run_config.work_stealing) exec_ctx->set_work_stealing(true);
     if (function.function_kind() == FunctionKind::kSyncBEFFunction) {
       RunSyncBefFunctionHelper(exec_ctx.get(), function);
     } else {
-      RunAsyncBefFunctionHelper(exec_ctx.get(), function, print_error_code);
+      RunAsyncBefFunctionHelper(exec_ctx.get(), function,
+                                run_config.print_error_code);
     }
+    if (run_config.num_benchmark_runs > 0)
+      BenchmarkBefFunction(exec_ctx.get(), function, run_config);
   }
 
   if (AsyncValue::AsyncValueAllocationTrackingEnabled()) {
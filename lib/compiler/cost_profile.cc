@@ -0,0 +1,126 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This implements the cost profile used by StreamAnalysis.
+
+#include "tfrt/compiler/cost_profile.h"
+
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "tfrt/support/error_util.h"
+
+namespace tfrt {
+namespace compiler {
+namespace {
+
+// Mirrors BefLocationEmitter::IsSupportedLocation().
+bool IsSupportedLocation(mlir::Location loc) {
+  if (loc.isa<mlir::UnknownLoc, mlir::NameLoc, mlir::FileLineColLoc>())
+    return true;
+  if (auto callsite_loc = loc.dyn_cast<mlir::CallSiteLoc>()) {
+    return IsSupportedLocation(callsite_loc.getCallee()) &&
+           IsSupportedLocation(callsite_loc.getCaller());
+  }
+  if (auto fused_loc = loc.dyn_cast<mlir::FusedLoc>())
+    return llvm::any_of(fused_loc.getLocations(), IsSupportedLocation);
+  return false;
+}
+
+// Mirrors the decoding of nested locations in BefLocationToStr().
+void PrintNestedLocation(mlir::Location loc, raw_ostream& os) {
+  if (loc.isa<mlir::UnknownLoc>()) {
+    os << "(unknown)";
+  } else if (auto filelinecol_loc = loc.dyn_cast<mlir::FileLineColLoc>()) {
+    os << filelinecol_loc.getFilename().getValue() << ";"
+       << filelinecol_loc.getLine() << ";" << filelinecol_loc.getColumn();
+  } else if (auto name_loc = loc.dyn_cast<mlir::NameLoc>()) {
+    bool has_child = !name_loc.getChildLoc().isa<mlir::UnknownLoc>();
+    if (has_child) {
+      PrintNestedLocation(name_loc.getChildLoc(), os);
+      os << "(";
+    }
+    os << name_loc.getName().getValue();
+    if (has_child) os << ")";
+  } else if (auto callsite_loc = loc.dyn_cast<mlir::CallSiteLoc>()) {
+    PrintNestedLocation(callsite_loc.getCallee(), os);
+    os << "<-";
+    PrintNestedLocation(callsite_loc.getCaller(), os);
+  } else if (auto fused_loc = loc.dyn_cast<mlir::FusedLoc>()) {
+    llvm::interleave(
+        llvm::make_filter_range(fused_loc.getLocations(), IsSupportedLocation),
+        os, [&](mlir::Location loc) { PrintNestedLocation(loc, os); }, ",");
+  }
+}
+
+}  // namespace
+
+std::string FormatKernelLocation(mlir::Location loc) {
+  if (!IsSupportedLocation(loc)) return "";
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  // Top-level file locations are decoded as FileLineColLocation.
+  if (auto filelinecol_loc = loc.dyn_cast<mlir::FileLineColLoc>()) {
+    os << filelinecol_loc.getFilename().getValue() << ":"
+       << filelinecol_loc.getLine() << ":" << filelinecol_loc.getColumn();
+  } else {
+    PrintNestedLocation(loc, os);
+  }
+  return os.str();
+}
+
+Expected<CostProfile> CostProfile::Parse(string_view text) {
+  CostProfile profile;
+  llvm::SmallVector<string_view, 16> lines;
+  text.split(lines, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (auto& line : llvm::enumerate(lines)) {
+    string_view mean_time, location;
+    std::tie(mean_time, location) = line.value().split('\t');
+    int64_t mean_ns;
+    if (location.empty() || !llvm::to_integer(mean_time, mean_ns) ||
+        mean_ns < 0) {
+      return MakeStringError("invalid cost profile line ", line.index() + 1,
+                             ": ", line.value());
+    }
+    profile.mean_times_[location] = mean_ns;
+  }
+  return std::move(profile);
+}
+
+Expected<CostProfile> CostProfile::Read(string_view path) {
+  auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/true);
+  if (!buffer) {
+    return MakeStringError("failed to read cost profile ", path, ": ",
+                           buffer.getError().message());
+  }
+  return Parse((*buffer)->getBuffer());
+}
+
+llvm::Optional<int64_t> CostProfile::GetMeanTime(mlir::Location loc) const {
+  auto it = mean_times_.find(FormatKernelLocation(loc));
+  if (it == mean_times_.end()) return llvm::None;
+  return it->second;
+}
+
+}  // namespace compiler
+}  // namespace tfrt
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This implements FuseSyncKernelsPass, which outlines straight-line chains of
+// basic kernels that have synchronous implementations into sync BEF functions.
+//
+// Each basic kernel in a BEF function allocates an AsyncValue per result and
+// is scheduled separately, which dominates the cost of scalar control logic
+// such as counters and loop bounds. A fused chain runs as a single tfrt.call
+// to a sync function, which passes the intermediate values directly.
+
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+#include "tfrt/basic_kernels/opdefs/basic_kernels.h"
+
+namespace tfrt {
+namespace compiler {
+namespace {
+
+// Returns the name of the sync kernel implementing `op`, or an empty string if
+// `op` has no sync implementation.
+llvm::StringRef GetSyncKernelName(mlir::Operation* op) {
+  static const auto* const kSyncKernelNames =
+      new llvm::StringMap<llvm::StringRef>{
+          {"tfrt.constant.i32", "tfrt.constant_s.i32"},
+          {"tfrt.constant.i64", "tfrt.constant_s.i64"},
+          {"tfrt.constant.f32", "tfrt.constant_s.f32"},
+          {"tfrt.constant.f64", "tfrt.constant_s.f64"},
+          {"tfrt.add.i32", "tfrt.add_s.i32"},
+          {"tfrt.add.i64", "tfrt.add_s.i64"},
+          {"tfrt.mul.i32", "tfrt.mul_s.i32"},
+          {"tfrt.mul.i64", "tfrt.mul_s.i64"},
+      };
+  return kSyncKernelNames->lookup(op->getName().getStringRef());
+}
+
+class FuseSyncKernelsPass
+    : public mlir::PassWrapper<FuseSyncKernelsPass,
+                               mlir::OperationPass<mlir::ModuleOp>> {
+ public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(FuseSyncKernelsPass)
+
+  FuseSyncKernelsPass() = default;
+  FuseSyncKernelsPass(const FuseSyncKernelsPass&) {}
+
+  llvm::StringRef getArgument() const final {
+    return "tfrt-fuse-sync-kernels";
+  }
+
+  llvm::StringRef getDescription() const final {
+    return "Outline chains of basic kernels into sync functions";
+  }
+
+  void runOnOperation() override {
+    mlir::ModuleOp module = getOperation();
+    mlir::SymbolTable symbol_table(module);
+
+    llvm::SmallVector<mlir::func::FuncOp, 4> func_ops(
+        module.getOps<mlir::func::FuncOp>());
+    for (auto func_op : func_ops) {
+      // Sync and native functions already run without async values.
+      if (func_op.isExternal() || func_op->hasAttr("tfrt.sync") ||
+          func_op->hasAttr("tfrt.native"))
+        continue;
+
+      // Collect the groups before rewriting, so that the walk does not see
+      // the inserted calls.
+      llvm::SmallVector<llvm::SmallVector<mlir::Operation*, 8>, 4> groups;
+      func_op.walk([&](mlir::Block* block) {
+        llvm::SmallVector<mlir::Operation*, 8> group;
+        auto flush = [&]() {
+          if (group.size() >= min_group_size_) groups.push_back(group);
+          group.clear();
+        };
+        for (auto& op : *block) {
+          if (GetSyncKernelName(&op).empty()) {
+            flush();
+          } else {
+            group.push_back(&op);
+          }
+        }
+        flush();
+      });
+
+      for (const auto& group : groups)
+        FuseGroup(func_op, group, symbol_table);
+    }
+  }
+
+ private:
+  // Replaces the contiguous ops in `group` with a call to a new sync function
+  // that runs their sync kernels.
+  void FuseGroup(mlir::func::FuncOp func_op,
+                 llvm::ArrayRef<mlir::Operation*> group,
+                 mlir::SymbolTable& symbol_table) {
+    llvm::SmallPtrSet<mlir::Operation*, 8> in_group(group.begin(),
+                                                    group.end());
+
+    // The group reads the values defined before it and returns the values
+    // that are used after it.
+    llvm::SetVector<mlir::Value> inputs, outputs;
+    for (auto* op : group) {
+      for (mlir::Value operand : op->getOperands()) {
+        if (!in_group.contains(operand.getDefiningOp())) inputs.insert(operand);
+      }
+      for (mlir::Value result : op->getResults()) {
+        if (llvm::any_of(result.getUsers(), [&](mlir::Operation* user) {
+              return !in_group.contains(user);
+            }))
+          outputs.insert(result);
+      }
+    }
+    // Dead chains are left to the canonicalizer.
+    if (outputs.empty()) return;
+
+    llvm::SmallVector<mlir::Type, 4> input_types, output_types;
+    for (mlir::Value input : inputs) input_types.push_back(input.getType());
+    for (mlir::Value output : outputs) output_types.push_back(output.getType());
+
+    mlir::Builder builder(func_op.getContext());
+    auto location = builder.getFusedLoc(llvm::to_vector<4>(llvm::map_range(
+        group, [](mlir::Operation* op) { return op->getLoc(); })));
+
+    // SymbolTable::insert() renames the function if the name is taken.
+    auto fused_func_op = mlir::func::FuncOp::create(
+        location, (func_op.getName() + "_fused").str(),
+        builder.getFunctionType(input_types, output_types));
+    fused_func_op->setAttr("tfrt.sync", builder.getUnitAttr());
+    symbol_table.insert(fused_func_op, std::next(func_op->getIterator()));
+
+    mlir::Block* body = fused_func_op.addEntryBlock();
+    mlir::BlockAndValueMapping mapping;
+    mapping.map(inputs.getArrayRef(), body->getArguments());
+
+    auto body_builder = mlir::OpBuilder::atBlockEnd(body);
+    for (auto* op : group) {
+      mlir::OperationState state(op->getLoc(), GetSyncKernelName(op));
+      for (mlir::Value operand : op->getOperands())
+        state.addOperands(mapping.lookup(operand));
+      state.addTypes(op->getResultTypes());
+      state.addAttributes(op->getAttrs());
+      mlir::Operation* sync_op = body_builder.create(state);
+      mapping.map(op->getResults(), sync_op->getResults());
+    }
+
+    llvm::SmallVector<mlir::Value, 4> results;
+    for (mlir::Value output : outputs)
+      results.push_back(mapping.lookup(output));
+    body_builder.create<ReturnOp>(location, results);
+
+    // All users of the outputs are after the group and all inputs are defined
+    // before it, so the call can replace the group in place.
+    mlir::OpBuilder call_builder(group.front());
+    auto call_op = call_builder.create<CallOp>(
+        location, output_types,
+        mlir::SymbolRefAttr::get(builder.getContext(),
+                                 fused_func_op.getName()),
+        inputs.getArrayRef());
+    for (auto iter : llvm::zip(outputs, call_op.getResults()))
+      std::get<0>(iter).replaceAllUsesWith(std::get<1>(iter));
+
+    for (auto* op : llvm::reverse(group)) op->erase();
+  }
+
+  Option<unsigned> min_group_size_{
+      *this, "min-group-size",
+      llvm::cl::desc("Minimum number of kernels in a fused chain."),
+      llvm::cl::init(2)};
+};
+
+static mlir::PassRegistration<FuseSyncKernelsPass> fuse_sync_kernels;
+
+}  // namespace
+}  // namespace compiler
+}  // namespace tfrt
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This implements HoistConstantOpsPass, which moves corert.executeop ops that
+// only depend on constant tensors (e.g. reshapes and transposes of weights)
+// into a function called with tfrt.once. They then run on the first execution
+// of the function, and later executions reuse the tensors cached in the
+// resource context.
+//
+// corert ops can't be evaluated by the compiler, as they run on op handlers,
+// so they are computed at the first execution instead of at compile time.
+
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+#include "tfrt/basic_kernels/opdefs/basic_kernels.h"
+#include "tfrt/core_runtime/opdefs/core_runtime.h"
+
+namespace tfrt {
+namespace compiler {
+namespace {
+
+// Returns true if `op` creates a constant tensor handle.
+bool IsConstantTensor(mlir::Operation* op) {
+  return llvm::isa<corert::ConstDenseTensorOp, corert::ConstStringTensorOp>(
+             op) ||
+         op->getName().getStringRef().startswith("corert.create_dense_tensor.");
+}
+
+class HoistConstantOpsPass
+    : public mlir::PassWrapper<HoistConstantOpsPass,
+                               mlir::OperationPass<mlir::ModuleOp>> {
+ public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(HoistConstantOpsPass)
+
+  llvm::StringRef getArgument() const final {
+    return "tfrt-hoist-constant-corert-ops";
+  }
+
+  llvm::StringRef getDescription() const final {
+    return "Run corert ops with constant operands once and cache the results";
+  }
+
+  void runOnOperation() override {
+    mlir::ModuleOp module = getOperation();
+    mlir::SymbolTable symbol_table(module);
+
+    llvm::SmallVector<mlir::func::FuncOp, 4> func_ops(
+        module.getOps<mlir::func::FuncOp>());
+    for (auto func_op : func_ops) {
+      if (func_op.isExternal() || func_op->hasAttr("tfrt.sync") ||
+          func_op->hasAttr("tfrt.native"))
+        continue;
+      HoistConstantOps(func_op, symbol_table);
+    }
+  }
+
+ private:
+  void HoistConstantOps(mlir::func::FuncOp func_op,
+                        mlir::SymbolTable& symbol_table) {
+    mlir::Block& block = func_op.front();
+
+    // The ops to run once, in program order. The tfrt.once call is inserted
+    // before the first of them, so their op handlers must be defined before
+    // that.
+    llvm::SetVector<mlir::Operation*> hoisted;
+    mlir::Operation* insertion_point = nullptr;
+    auto is_available = [&](mlir::Value value) {
+      auto* def_op = value.getDefiningOp();
+      return !def_op || !insertion_point ||
+             def_op->isBeforeInBlock(insertion_point);
+    };
+
+    for (auto& op : block) {
+      if (IsConstantTensor(&op)) {
+        hoisted.insert(&op);
+        continue;
+      }
+      auto execute_op = llvm::dyn_cast<corert::ExecuteOp>(op);
+      if (!execute_op || !is_available(execute_op.getOpHandler()) ||
+          llvm::any_of(execute_op.getOperands(), [&](mlir::Value operand) {
+            return !hoisted.contains(operand.getDefiningOp());
+          }))
+        continue;
+      hoisted.insert(&op);
+      if (!insertion_point) insertion_point = &op;
+    }
+    // Constant tensors on their own are cheap, only hoist if there are ops.
+    if (!insertion_point) return;
+
+    // The op handlers are passed to the function, and the tensors used by the
+    // rest of the program are returned.
+    llvm::SetVector<mlir::Value> inputs, outputs;
+    for (auto* op : hoisted) {
+      auto execute_op = llvm::dyn_cast<corert::ExecuteOp>(op);
+      if (!execute_op) continue;
+      inputs.insert(execute_op.getOpHandler());
+      for (mlir::Value result : op->getResults()) {
+        if (llvm::any_of(result.getUsers(), [&](mlir::Operation* user) {
+              return !hoisted.contains(user);
+            }))
+          outputs.insert(result);
+      }
+    }
+    if (outputs.empty()) return;
+
+    llvm::SmallVector<mlir::Type, 4> input_types, output_types;
+    for (mlir::Value input : inputs) input_types.push_back(input.getType());
+    for (mlir::Value output : outputs) output_types.push_back(output.getType());
+
+    mlir::Builder builder(func_op.getContext());
+    auto once_func_op = mlir::func::FuncOp::create(
+        func_op.getLoc(), (func_op.getName() + "_once").str(),
+        builder.getFunctionType(input_types, output_types));
+    symbol_table.insert(once_func_op, std::next(func_op->getIterator()));
+
+    mlir::Block* body = once_func_op.addEntryBlock();
+    mlir::BlockAndValueMapping mapping;
+    mapping.map(inputs.getArrayRef(), body->getArguments());
+    auto body_builder = mlir::OpBuilder::atBlockEnd(body);
+    for (auto* op : hoisted) body_builder.clone(*op, mapping);
+
+    llvm::SmallVector<mlir::Value, 4> results;
+    for (mlir::Value output : outputs)
+      results.push_back(mapping.lookup(output));
+    body_builder.create<ReturnOp>(func_op.getLoc(), results);
+
+    mlir::OpBuilder call_builder(insertion_point);
+    auto once_op = call_builder.create<OnceOp>(
+        insertion_point->getLoc(), output_types, inputs.getArrayRef(),
+        mlir::SymbolRefAttr::get(builder.getContext(),
+                                 once_func_op.getName()));
+    for (auto iter : llvm::zip(outputs, once_op.getResults()))
+      std::get<0>(iter).replaceAllUsesWith(std::get<1>(iter));
+
+    // Constant tensors might still be used by the rest of the program.
+    for (auto* op : llvm::reverse(hoisted)) {
+      if (op->use_empty()) op->erase();
+    }
+  }
+};
+
+static mlir::PassRegistration<HoistConstantOpsPass> hoist_constant_ops;
+
+}  // namespace
+}  // namespace compiler
+}  // namespace tfrt
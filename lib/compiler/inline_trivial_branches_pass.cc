@@ -0,0 +1,160 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This implements InlineTrivialBranchesPass, which replaces tfrt.if and
+// tfrt.cond ops with trivial branches by the ops of both branches and a
+// tfrt.select of their results.
+//
+// Each tfrt.if runs its branch as a separate BEF function, which costs a nested
+// BEFExecutor even if the branch only forwards an argument or adds two
+// integers. If both branches together have at most `max-ops` side effect free
+// ops, it is cheaper to compute both in the parent function and select the
+// results with the condition.
+
+#include "llvm/ADT/SmallVector.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+#include "tfrt/basic_kernels/opdefs/basic_kernels.h"
+
+namespace tfrt {
+namespace compiler {
+namespace {
+
+class InlineTrivialBranchesPass
+    : public mlir::PassWrapper<InlineTrivialBranchesPass,
+                               mlir::OperationPass<mlir::ModuleOp>> {
+ public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(InlineTrivialBranchesPass)
+
+  InlineTrivialBranchesPass() = default;
+  InlineTrivialBranchesPass(const InlineTrivialBranchesPass&) {}
+
+  llvm::StringRef getArgument() const final {
+    return "tfrt-inline-trivial-branches";
+  }
+
+  llvm::StringRef getDescription() const final {
+    return "Replace conditionals with trivial branches by a tfrt.select";
+  }
+
+  void runOnOperation() override {
+    mlir::ModuleOp module = getOperation();
+    mlir::SymbolTable symbol_table(module);
+
+    for (auto func_op : module.getOps<mlir::func::FuncOp>()) {
+      if (func_op.isExternal() || func_op->hasAttr("tfrt.sync")) continue;
+
+      // Walk in post order, so that nested conditionals are inlined first and
+      // count as the ops they were replaced with.
+      llvm::SmallVector<mlir::Operation*, 4> conditionals;
+      func_op.walk([&](mlir::Operation* op) {
+        if (llvm::isa<IfOp, CondOp>(op)) conditionals.push_back(op);
+      });
+
+      for (mlir::Operation* op : conditionals) {
+        if (auto if_op = llvm::dyn_cast<IfOp>(op)) {
+          InlineBranches(op, &if_op.getThenRegion().front(),
+                         &if_op.getElseRegion().front());
+        } else {
+          auto true_fn = symbol_table.lookup<mlir::func::FuncOp>(
+              op->getAttrOfType<mlir::FlatSymbolRefAttr>("a_true_fn")
+                  .getValue());
+          auto false_fn = symbol_table.lookup<mlir::func::FuncOp>(
+              op->getAttrOfType<mlir::FlatSymbolRefAttr>("b_false_fn")
+                  .getValue());
+          if (!true_fn || !false_fn || true_fn.isExternal() ||
+              false_fn.isExternal() || !true_fn.getBody().hasOneBlock() ||
+              !false_fn.getBody().hasOneBlock())
+            continue;
+          InlineBranches(op, &true_fn.front(), &false_fn.front());
+        }
+      }
+    }
+  }
+
+ private:
+  // Returns the number of ops in `block` excluding the terminator, or -1 if
+  // some of them can't be computed unconditionally.
+  static int CountSpeculatableOps(mlir::Block* block) {
+    int num_ops = 0;
+    for (mlir::Operation& op : block->without_terminator()) {
+      if (op.getNumRegions() != 0 || !mlir::isMemoryEffectFree(&op)) return -1;
+      ++num_ops;
+    }
+    return num_ops;
+  }
+
+  // Replaces the conditional `op`, whose first operand is the condition and
+  // the other operands are passed to the branches, if `then_block` and
+  // `else_block` are small enough.
+  void InlineBranches(mlir::Operation* op, mlir::Block* then_block,
+                      mlir::Block* else_block) {
+    int num_then_ops = CountSpeculatableOps(then_block);
+    int num_else_ops = CountSpeculatableOps(else_block);
+    if (num_then_ops < 0 || num_else_ops < 0 ||
+        static_cast<unsigned>(num_then_ops + num_else_ops) > max_ops_)
+      return;
+
+    mlir::OpBuilder builder(op);
+    mlir::Value cond = op->getOperand(0);
+    auto operands = op->getOperands().drop_front();
+
+    auto clone_branch = [&](mlir::Block* block) {
+      mlir::BlockAndValueMapping mapping;
+      mapping.map(block->getArguments(), operands);
+      for (mlir::Operation& branch_op : block->without_terminator())
+        builder.clone(branch_op, mapping);
+
+      llvm::SmallVector<mlir::Value, 4> results;
+      for (mlir::Value value : block->getTerminator()->getOperands())
+        results.push_back(mapping.lookupOrDefault(value));
+      return results;
+    };
+
+    llvm::SmallVector<mlir::Value, 4> then_results = clone_branch(then_block);
+    llvm::SmallVector<mlir::Value, 4> else_results = clone_branch(else_block);
+
+    for (auto result : llvm::enumerate(op->getResults())) {
+      mlir::Value then_value = then_results[result.index()];
+      mlir::Value else_value = else_results[result.index()];
+      if (then_value != else_value) {
+        then_value = builder.create<SelectOp>(
+            op->getLoc(), then_value.getType(), cond, then_value, else_value);
+      }
+      result.value().replaceAllUsesWith(then_value);
+    }
+
+    op->erase();
+  }
+
+  Option<unsigned> max_ops_{
+      *this, "max-ops",
+      llvm::cl::desc("Maximum number of ops in both branches together."),
+      llvm::cl::init(4)};
+};
+
+}  // namespace
+
+static mlir::PassRegistration<InlineTrivialBranchesPass>
+    inline_trivial_branches;
+
+}  // namespace compiler
+}  // namespace tfrt
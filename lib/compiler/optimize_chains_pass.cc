@@ -0,0 +1,170 @@
+/*
+ * Copyright 2021 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This implements OptimizeChainsPass, which removes chain plumbing that does
+// not order any side effects. Every tfrt.merge.chains and tfrt.new.chain is a
+// kernel and an async value at runtime, and every unnecessary ordering hides
+// parallelism from the executor.
+//
+// The pass
+//  * lets consecutive read-only corert.executeop.seq ops (listed in the
+//    read-only-ops option) run in parallel: they all wait for the chain before
+//    the first read, and later ops wait for all of them,
+//  * flattens trees of tfrt.merge.chains and removes their duplicate and
+//    tfrt.new.chain inputs,
+//  * forwards single-chain merges and removes unused chains.
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringSet.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Pass/Pass.h"
+#include "tfrt/basic_kernels/opdefs/basic_kernels.h"
+#include "tfrt/core_runtime/opdefs/core_runtime.h"
+
+namespace tfrt {
+namespace compiler {
+namespace {
+
+// Read-only ops that have been made to run in parallel.
+struct ReadGroup {
+  // The chain the reads wait for.
+  mlir::Value in_chain;
+  // The out chains of the reads.
+  llvm::SmallVector<mlir::Value, 4> out_chains;
+};
+
+class OptimizeChainsPass
+    : public mlir::PassWrapper<OptimizeChainsPass,
+                               mlir::OperationPass<mlir::func::FuncOp>> {
+ public:
+  MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(OptimizeChainsPass)
+
+  OptimizeChainsPass() = default;
+  OptimizeChainsPass(const OptimizeChainsPass&) {}
+
+  llvm::StringRef getArgument() const final { return "tfrt-optimize-chains"; }
+
+  llvm::StringRef getDescription() const final {
+    return "Remove chains and merges that don't order side effects";
+  }
+
+  void runOnOperation() override {
+    auto func_op = getOperation();
+
+    if (!read_only_ops_.empty()) {
+      llvm::StringSet<> read_only_ops;
+      for (const auto& op_name : read_only_ops_) read_only_ops.insert(op_name);
+      func_op.walk(
+          [&](mlir::Block* block) { RelaxReads(block, read_only_ops); });
+    }
+
+    func_op.walk([&](MergeChainsOp merge_op) { SimplifyMerge(merge_op); });
+
+    RemoveUnusedChains(func_op);
+  }
+
+ private:
+  // Makes consecutive read-only ops in `block` wait for the same chain.
+  //
+  // For `%ch1 = read(%ch0)` followed by `%ch2 = read(%ch1)`, the second read
+  // is changed to wait for %ch0, and the uses of %ch2 are changed to wait for
+  // both reads. Writes before and after the reads stay ordered with them.
+  void RelaxReads(mlir::Block* block,
+                  const llvm::StringSet<>& read_only_ops) {
+    // Maps the chains that stand for a group of reads to that group.
+    llvm::DenseMap<mlir::Value, ReadGroup> read_groups;
+
+    for (auto& op : *block) {
+      auto read_op = llvm::dyn_cast<corert::ExecuteOpSeq>(op);
+      if (!read_op || !read_only_ops.contains(read_op.getOpName())) continue;
+
+      mlir::Value out_chain = read_op.getOutOpChain();
+      auto iter = read_groups.find(read_op.getInOpChain());
+      if (iter == read_groups.end()) {
+        read_groups[out_chain] = {read_op.getInOpChain(), {out_chain}};
+        continue;
+      }
+
+      ReadGroup group = iter->second;
+      read_op.getInOpChainMutable().assign(group.in_chain);
+      group.out_chains.push_back(out_chain);
+
+      mlir::OpBuilder builder(&op);
+      builder.setInsertionPointAfter(&op);
+      auto merge_op = builder.create<MergeChainsOp>(
+          op.getLoc(), out_chain.getType(), group.out_chains);
+      out_chain.replaceAllUsesExcept(merge_op, merge_op);
+      read_groups[merge_op] = std::move(group);
+    }
+  }
+
+  // Flattens nested merges into `merge_op` and removes the inputs that don't
+  // order anything. Producers are visited before their users, so nested
+  // merges are already simplified.
+  void SimplifyMerge(MergeChainsOp merge_op) {
+    llvm::SetVector<mlir::Value> inputs;
+    for (mlir::Value input : merge_op.getInputs()) {
+      if (auto nested_op = input.getDefiningOp<MergeChainsOp>()) {
+        inputs.insert(nested_op.getInputs().begin(),
+                      nested_op.getInputs().end());
+      } else if (!input.getDefiningOp<NewChainOp>()) {
+        inputs.insert(input);
+      }
+    }
+
+    mlir::Value chain = merge_op.getResult();
+    if (inputs.empty()) {
+      mlir::OpBuilder builder(merge_op);
+      auto new_chain_op =
+          builder.create<NewChainOp>(merge_op.getLoc(), chain.getType());
+      chain.replaceAllUsesWith(new_chain_op.getResult());
+      merge_op->setOperands({});
+    } else if (inputs.size() == 1 &&
+               inputs.front().getType() == chain.getType()) {
+      chain.replaceAllUsesWith(inputs.front());
+      merge_op->setOperands({});
+    } else {
+      merge_op->setOperands(inputs.getArrayRef());
+    }
+  }
+
+  // Removes the merges and new chains that have no users. Users are visited
+  // before their producers, so chains that only feed removed merges are
+  // removed as well.
+  void RemoveUnusedChains(mlir::func::FuncOp func_op) {
+    llvm::SmallVector<mlir::Operation*, 16> chain_ops;
+    func_op.walk([&](mlir::Operation* op) {
+      if (llvm::isa<MergeChainsOp, NewChainOp>(op)) chain_ops.push_back(op);
+    });
+    for (auto* op : llvm::reverse(chain_ops)) {
+      if (op->use_empty()) op->erase();
+    }
+  }
+
+  ListOption<std::string> read_only_ops_{
+      *this, "read-only-ops",
+      llvm::cl::desc("Names of the corert ops that have no side effects other "
+                     "than reading state, e.g. tf.ReadVariableOp.")};
+};
+
+static mlir::PassRegistration<OptimizeChainsPass> optimize_chains;
+
+}  // namespace
+}  // namespace compiler
+}  // namespace tfrt
@@ -18,9 +18,13 @@
 
 #include "tfrt/compiler/stream_analysis.h"
 
+#include <memory>
+
+#include "llvm/ADT/StringMap.h"
 #include "tfrt/basic_kernels/opdefs/basic_kernels.h"
 #include "tfrt/basic_kernels/opdefs/types.h"
 #include "tfrt/compiler/opdefs/tfrt_op_interfaces.h"
+#include "tfrt/support/mutex.h"
 
 namespace tfrt {
 namespace compiler {
@@ -80,6 +84,42 @@ bool GetMergeInterDependentStreams(mlir::Block& block) {
   return false;
 }
 
+// Returns the cost profile named by the `tfrt.cost_profile` attribute, or
+// nullptr if there is none. Profiles are read once per process, a warning is
+// emitted if the profile can't be read.
+const CostProfile* GetCostProfileForBlock(mlir::Block& block) {
+  auto attr = GetOptionAttribute(block, "tfrt.cost_profile")
+                  .dyn_cast_or_null<mlir::StringAttr>();
+  if (!attr) return nullptr;
+
+  static auto* mu = new mutex;
+  static auto* profiles = new llvm::StringMap<std::unique_ptr<CostProfile>>;
+  mutex_lock lock(*mu);
+  auto it = profiles->find(attr.getValue());
+  if (it != profiles->end()) return it->second.get();
+
+  std::unique_ptr<CostProfile>& profile = (*profiles)[attr.getValue()];
+  auto read_profile = CostProfile::Read(attr.getValue());
+  if (!read_profile) {
+    mlir::emitWarning(block.getParentOp()->getLoc())
+        << "ignoring cost profile: "
+        << llvm::toString(read_profile.takeError());
+    return nullptr;
+  }
+  profile = std::make_unique<CostProfile>(std::move(*read_profile));
+  return profile.get();
+}
+
+int64_t GetCostProfileUnitNsForBlock(mlir::Block& block) {
+  static constexpr int64_t kDefaultCostProfileUnitNs = 1000;
+
+  if (auto attr = GetOptionAttribute(block, "tfrt.cost_profile_unit_ns")
+                      .dyn_cast_or_null<mlir::IntegerAttr>()) {
+    return std::max<int64_t>(1, attr.getInt());
+  }
+  return kDefaultCostProfileUnitNs;
+}
+
 }  // namespace
 
 int64_t StreamAnalysis::GetOperationCost(mlir::Operation* op) const {
@@ -89,6 +129,12 @@ int64_t StreamAnalysis::GetOperationCost(mlir::Operation* op) const {
   // A few TFRT kernels are guaranteed to be cheap.
   if (llvm::isa<ReturnOp, MergeChainsOp>(op)) return 1;
 
+  // Prefer the measured cost if the operation has been profiled.
+  if (options_.cost_profile) {
+    if (auto mean_ns = options_.cost_profile->GetMeanTime(op->getLoc()))
+      return std::max<int64_t>(1, *mean_ns / options_.cost_profile_unit_ns);
+  }
+
   // Check if operations defines a cost function.
   if (auto cost_function = mlir::dyn_cast<CostFunctionInterface>(op)) {
     int64_t cost = cost_function.cost();
@@ -515,6 +561,8 @@ void StreamAnalysis::GetOptionsForBlock(mlir::Block& block) {
   options_.cost_threshold = GetCostThresholdForBlock(block);
   options_.upper_cost_threshold = GetUpperCostThresholdForBlock(block);
   options_.merge_inter_dependent_streams = GetMergeInterDependentStreams(block);
+  options_.cost_profile = GetCostProfileForBlock(block);
+  options_.cost_profile_unit_ns = GetCostProfileUnitNsForBlock(block);
 }
 
 }  // namespace compiler
@@ -19,12 +19,183 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/base/attributes.h"                   // from @com_google_absl
+#include "absl/base/config.h"                       // from @com_google_absl
+#include "absl/base/optimization.h"                 // from @com_google_absl
+#include "absl/base/thread_annotations.h"           // from @com_google_absl
 #include "absl/container/inlined_vector.h"          // from @com_google_absl
 #include "absl/functional/any_invocable.h"          // from @com_google_absl
 #include "absl/synchronization/blocking_counter.h"  // from @com_google_absl
+#include "absl/synchronization/mutex.h"             // from @com_google_absl
 #include "tfrt/concurrency/async_value_ref.h"
 
 namespace tsl {
+namespace {
+
+AsyncValue::WaiterBatchHooks& GetWaiterBatchHooks() {
+  static AsyncValue::WaiterBatchHooks hooks;
+  return hooks;
+}
+
+//===----------------------------------------------------------------------===//
+// Pools of small async values and waiter list nodes.
+//===----------------------------------------------------------------------===//
+
+// Do not hide use-after-free errors from the address sanitizer.
+#if defined(ABSL_HAVE_ADDRESS_SANITIZER)
+constexpr bool kEnablePools = false;
+#else
+constexpr bool kEnablePools = true;
+#endif
+
+// Pools of fixed size blocks, blocks of each pool are aligned to
+// kPooledAsyncValueAlignment.
+enum Pool { kAsyncValuePool = 0, kWaiterPool = 1, kNumPools = 2 };
+
+constexpr size_t kPoolBlockSize[kNumPools] = {internal::kPooledAsyncValueSize,
+                                              64};
+
+// Number of blocks moved between a thread cache and the shared free list.
+constexpr int kPoolBatchSize = 64;
+
+// Size of the chunk of memory that is carved into the pool blocks. Chunks are
+// never returned to the heap.
+constexpr size_t kPoolChunkSize = 16 * 1024;
+
+// Free blocks are linked through their first word.
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct SharedPool {
+  absl::Mutex mu;
+  FreeBlock* head ABSL_GUARDED_BY(mu) = nullptr;
+
+  static SharedPool& Get(Pool pool) {
+    static auto* pools = new SharedPool[kNumPools];
+    return pools[pool];
+  }
+};
+
+// Per-thread free list. It is trivially destructible, so that blocks released
+// by destructors of other thread locals can still use it.
+struct ThreadPoolCache {
+  FreeBlock* head = nullptr;
+  int size = 0;
+  // Set when the thread exits, after the cached blocks are returned to the
+  // shared pool.
+  bool exited = false;
+};
+
+thread_local ThreadPoolCache thread_pool_caches[kNumPools];
+
+// Moves up to `count` blocks from the thread cache to the shared pool.
+void FlushThreadPoolCache(Pool pool, ThreadPoolCache& cache, int count) {
+  SharedPool& shared = SharedPool::Get(pool);
+  absl::MutexLock lock(&shared.mu);
+  for (; count > 0 && cache.head != nullptr; --count, --cache.size) {
+    FreeBlock* block = cache.head;
+    cache.head = block->next;
+    block->next = shared.head;
+    shared.head = block;
+  }
+}
+
+// Returns cached blocks to the shared pools when the thread exits.
+struct ThreadPoolCacheFlusher {
+  ~ThreadPoolCacheFlusher() {
+    for (int pool = 0; pool < kNumPools; ++pool) {
+      ThreadPoolCache& cache = thread_pool_caches[pool];
+      FlushThreadPoolCache(static_cast<Pool>(pool), cache, cache.size);
+      cache.exited = true;
+    }
+  }
+};
+
+void RegisterThreadPoolCacheFlusher(ThreadPoolCache& cache) {
+  if (cache.exited) return;
+  static thread_local ThreadPoolCacheFlusher flusher;
+  (void)flusher;
+}
+
+// Moves a batch of blocks from the shared pool to the thread cache, allocating
+// a new chunk if the shared pool is empty.
+ABSL_ATTRIBUTE_NOINLINE void RefillThreadPoolCache(Pool pool,
+                                                   ThreadPoolCache& cache) {
+  RegisterThreadPoolCacheFlusher(cache);
+
+  SharedPool& shared = SharedPool::Get(pool);
+  absl::MutexLock lock(&shared.mu);
+
+  if (shared.head == nullptr) {
+    auto* chunk = static_cast<char*>(tfrt::AlignedAlloc(
+        internal::kPooledAsyncValueAlignment, kPoolChunkSize));
+    for (size_t offset = 0; offset < kPoolChunkSize;
+         offset += kPoolBlockSize[pool]) {
+      auto* block = reinterpret_cast<FreeBlock*>(chunk + offset);
+      block->next = shared.head;
+      shared.head = block;
+    }
+  }
+
+  for (; cache.size < kPoolBatchSize && shared.head != nullptr; ++cache.size) {
+    FreeBlock* block = shared.head;
+    shared.head = block->next;
+    block->next = cache.head;
+    cache.head = block;
+  }
+}
+
+void* AllocatePoolBlock(Pool pool) {
+  if (!kEnablePools) {
+    return tfrt::AlignedAlloc(internal::kPooledAsyncValueAlignment,
+                              kPoolBlockSize[pool]);
+  }
+
+  ThreadPoolCache& cache = thread_pool_caches[pool];
+  if (ABSL_PREDICT_FALSE(cache.head == nullptr)) {
+    RefillThreadPoolCache(pool, cache);
+  }
+
+  FreeBlock* block = cache.head;
+  cache.head = block->next;
+  --cache.size;
+
+  // The exited thread must not keep cached blocks.
+  if (ABSL_PREDICT_FALSE(cache.exited))
+    FlushThreadPoolCache(pool, cache, cache.size);
+
+  return block;
+}
+
+void FreePoolBlock(Pool pool, void* ptr) {
+  if (!kEnablePools) return tfrt::AlignedFree(ptr);
+
+  ThreadPoolCache& cache = thread_pool_caches[pool];
+  if (ABSL_PREDICT_FALSE(cache.head == nullptr)) {
+    RegisterThreadPoolCacheFlusher(cache);
+  }
+
+  auto* block = static_cast<FreeBlock*>(ptr);
+  block->next = cache.head;
+  cache.head = block;
+  ++cache.size;
+
+  if (ABSL_PREDICT_FALSE(cache.size > 2 * kPoolBatchSize || cache.exited)) {
+    FlushThreadPoolCache(pool, cache,
+                         cache.exited ? cache.size : kPoolBatchSize);
+  }
+}
+
+}  // namespace
+
+namespace internal {
+
+void* AllocatePooledAsyncValue() { return AllocatePoolBlock(kAsyncValuePool); }
+
+void FreePooledAsyncValue(void* ptr) { FreePoolBlock(kAsyncValuePool, ptr); }
+
+}  // namespace internal
 
 // This is a singly linked list of nodes waiting for notification, hanging off
 // of AsyncValue.  When the value becomes available or if an error occurs, the
@@ -34,6 +205,14 @@ class NotifierListNode {
   explicit NotifierListNode(absl::AnyInvocable<void()> notification)
       : next_(nullptr), notification_(std::move(notification)) {}
 
+  // Waiter nodes are allocated from the pool, because every edge in the
+  // dataflow graph usually adds exactly one waiter to an async value.
+  static void* operator new(size_t size) {
+    assert(size <= kPoolBlockSize[kWaiterPool]);
+    return AllocatePoolBlock(kWaiterPool);
+  }
+  static void operator delete(void* ptr) { FreePoolBlock(kWaiterPool, ptr); }
+
  private:
   friend class AsyncValue;
   // This is the next thing waiting on the AsyncValue.
@@ -41,6 +220,12 @@ class NotifierListNode {
   absl::AnyInvocable<void()> notification_;
 };
 
+static_assert(sizeof(NotifierListNode) <= kPoolBlockSize[kWaiterPool],
+              "NotifierListNode must fit into the waiter pool block");
+static_assert(alignof(NotifierListNode) <=
+                  internal::kPooledAsyncValueAlignment,
+              "NotifierListNode is over aligned for the waiter pool block");
+
 /*static*/ uint16_t AsyncValue::CreateTypeInfoAndReturnTypeIdImpl(
     const TypeInfo& type_info) {
   size_t type_id = GetTypeInfoTableSingleton()->emplace_back(type_info) + 1;
@@ -88,7 +273,17 @@ void AsyncValue::NotifyAvailable(State available_state) {
   RunWaiters(old_value.waiter());
 }
 
+/*static*/ void AsyncValue::SetWaiterBatchHooks(WaiterBatchHooks hooks) {
+  assert((hooks.begin == nullptr) == (hooks.end == nullptr));
+  GetWaiterBatchHooks() = hooks;
+}
+
 void AsyncValue::RunWaiters(NotifierListNode* list) {
+  // A single waiter has nothing to batch with.
+  const WaiterBatchHooks& hooks = GetWaiterBatchHooks();
+  bool batch = list && list->next_ && hooks.begin;
+  if (batch) hooks.begin();
+
   while (list) {
     auto* node = list;
     // TODO(chky): pass state into notification_ so that waiters do not need to
@@ -97,6 +292,8 @@ void AsyncValue::RunWaiters(NotifierListNode* list) {
     list = node->next_;
     delete node;
   }
+
+  if (batch) hooks.end();
 }
 
 // If the value is available or becomes available, this calls the closure
@@ -0,0 +1,353 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file implements BatchScheduler.
+
+#include "tfrt/core_runtime/batch_scheduler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "llvm/Support/Casting.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/function.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/host_context/timer_queue.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace {
+
+// A call with available arguments, waiting in the queue.
+struct Call {
+  ExecutionContext exec_ctx;
+  // The DenseHostTensors of the arguments.
+  llvm::SmallVector<RCReference<AsyncValue>, 4> arguments;
+  llvm::SmallVector<AsyncValueRef<TensorHandle>, 4> results;
+  // The first dimension of the arguments.
+  Index num_rows = 0;
+};
+
+using Batch = std::vector<Call>;
+
+void SetError(Call& call, const absl::Status& status) {
+  for (auto& result : call.results) result.SetError(status);
+}
+
+void SetError(Batch& batch, size_t result_index, const absl::Status& status) {
+  for (Call& call : batch) call.results[result_index].SetError(status);
+}
+
+// Returns nullptr if `tensor` is not a DenseHostTensor.
+const DenseHostTensor* GetDenseHostTensor(const AsyncValue* tensor) {
+  return llvm::dyn_cast<DenseHostTensor>(&tensor->get<Tensor>());
+}
+
+// Checks that the available arguments of `call` can be batched, and sets the
+// number of rows of the call.
+absl::Status CheckArguments(Call& call) {
+  if (call.arguments.empty())
+    return absl::InvalidArgumentError("batched calls need arguments");
+  for (size_t i = 0; i < call.arguments.size(); ++i) {
+    const AsyncValue* argument = call.arguments[i].get();
+    if (argument->IsError()) return argument->GetError();
+    const DenseHostTensor* dht = GetDenseHostTensor(argument);
+    if (dht == nullptr || dht->shape().GetRank() == 0) {
+      return absl::InvalidArgumentError(
+          "batched arguments must be non-scalar DenseHostTensors");
+    }
+    Index num_rows = dht->shape().GetDimensionSize(0);
+    if (i == 0) call.num_rows = num_rows;
+    if (num_rows != call.num_rows) {
+      return absl::InvalidArgumentError(
+          StrCat("argument ", i, " has ", num_rows, " rows instead of ",
+                 call.num_rows));
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Returns the dimensions of the checked argument `tensor` after the first one.
+llvm::SmallVector<Index, 4> RowDimensions(const DenseHostTensor& tensor) {
+  llvm::SmallVector<Index, 4> dims;
+  tensor.shape().GetDimensions(&dims);
+  dims.erase(dims.begin());
+  return dims;
+}
+
+// Concatenates argument `index` of the calls in `batch` along the first
+// dimension and pads it with zeros to `num_rows` rows.
+absl::StatusOr<TensorHandle> ConcatArgument(const Batch& batch, size_t index,
+                                            Index num_rows, HostContext* host) {
+  const DenseHostTensor& first =
+      *GetDenseHostTensor(batch.front().arguments[index].get());
+  llvm::SmallVector<Index, 4> row_dims = RowDimensions(first);
+
+  llvm::SmallVector<Index, 4> dims = {num_rows};
+  dims.append(row_dims.begin(), row_dims.end());
+  TensorMetadata metadata(first.dtype(), dims);
+  auto dht = DenseHostTensor::CreateUninitialized(metadata, host);
+  if (!dht)
+    return absl::ResourceExhaustedError("failed to allocate batched argument");
+
+  char* output = static_cast<char*>(dht->data());
+  char* end = output + dht->DataSizeInBytes();
+  for (const Call& call : batch) {
+    const DenseHostTensor& arg =
+        *GetDenseHostTensor(call.arguments[index].get());
+    if (arg.dtype() != first.dtype() || RowDimensions(arg) != row_dims) {
+      return absl::InvalidArgumentError(
+          StrCat("argument ", index, " with shape ", arg.shape(),
+                 " can't be batched with shape ", first.shape()));
+    }
+    std::memcpy(output, arg.data(), arg.DataSizeInBytes());
+    output += arg.DataSizeInBytes();
+  }
+  std::memset(output, 0, end - output);
+
+  return TensorHandle(host->GetHostDeviceRef(), metadata,
+                      MakeAvailableAsyncValueRef<DenseHostTensor>(
+                          std::move(*dht)));
+}
+
+// Splits the rows of the function results into the results of the calls.
+void SplitResults(Batch& batch, ArrayRef<RCReference<AsyncValue>> results,
+                  Index num_rows) {
+  HostContext* host = batch.front().exec_ctx.host();
+  for (size_t i = 0; i < results.size(); ++i) {
+    if (results[i]->IsError()) {
+      SetError(batch, i, results[i]->GetError());
+      continue;
+    }
+    AsyncValue* tensor = results[i]->get<TensorHandle>().GetAsyncTensor();
+    if (tensor->IsError()) {
+      SetError(batch, i, tensor->GetError());
+      continue;
+    }
+    const DenseHostTensor* result_dht = GetDenseHostTensor(tensor);
+    if (result_dht == nullptr) {
+      SetError(batch, i,
+               absl::InvalidArgumentError(
+                   "batched results must be DenseHostTensors"));
+      continue;
+    }
+    const DenseHostTensor& dht = *result_dht;
+    if (dht.shape().GetRank() == 0 ||
+        dht.shape().GetDimensionSize(0) != num_rows) {
+      SetError(batch, i,
+               absl::InvalidArgumentError(StrCat(
+                   "result ", i, " with shape ", dht.shape(),
+                   " doesn't have the ", num_rows, " rows of the batch")));
+      continue;
+    }
+
+    llvm::SmallVector<Index, 4> dims;
+    dht.shape().GetDimensions(&dims);
+    const size_t row_size = num_rows ? dht.DataSizeInBytes() / num_rows : 0;
+    const char* input = static_cast<const char*>(dht.data());
+    for (Call& call : batch) {
+      dims[0] = call.num_rows;
+      TensorMetadata metadata(dht.dtype(), dims);
+      const char* rows = input;
+      input += call.num_rows * row_size;
+      auto result = DenseHostTensor::CreateUninitialized(metadata, host);
+      if (!result) {
+        call.results[i].SetError(
+            absl::ResourceExhaustedError("failed to allocate batched result"));
+        continue;
+      }
+      std::memcpy(result->data(), rows, call.num_rows * row_size);
+      call.results[i].emplace(
+          host->GetHostDeviceRef(), metadata,
+          MakeAvailableAsyncValueRef<DenseHostTensor>(std::move(*result)));
+    }
+  }
+}
+
+}  // namespace
+
+class BatchScheduler::Queue : public ReferenceCounted<Queue> {
+ public:
+  Queue(const Function* function, BatchSchedulerOptions options)
+      : function_(FormRef(function)), options_(std::move(options)) {}
+
+  llvm::SmallVector<AsyncValueRef<TensorHandle>, 4> Execute(
+      const ExecutionContext& exec_ctx, ArrayRef<TensorHandle> arguments) {
+    Call call{exec_ctx, {}, {}, 0};
+    llvm::SmallVector<AsyncValueRef<TensorHandle>, 4> results;
+    for (size_t i = 0; i < function_->num_results(); ++i) {
+      call.results.push_back(MakeUnconstructedAsyncValueRef<TensorHandle>());
+      results.push_back(call.results.back().CopyRef());
+    }
+
+    llvm::SmallVector<AsyncValue*, 4> tensors;
+    for (const TensorHandle& argument : arguments) {
+      call.arguments.push_back(FormRef(argument.GetAsyncTensor()));
+      tensors.push_back(argument.GetAsyncTensor());
+    }
+
+    RunWhenReady(tensors,
+                 [queue = FormRef(this), call = std::move(call)]() mutable {
+                   absl::Status status = CheckArguments(call);
+                   if (!status.ok()) return SetError(call, status);
+                   queue->Enqueue(std::move(call));
+                 });
+    return results;
+  }
+
+  // Adds a call whose arguments are available.
+  void Enqueue(Call call) {
+    llvm::SmallVector<Batch, 2> batches;
+    {
+      mutex_lock lock(mu_);
+      // A call that doesn't fit into the queued batch starts a new one.
+      if (!calls_.empty() &&
+          num_rows_ + call.num_rows > options_.max_batch_size)
+        batches.push_back(TakeBatch());
+
+      host_ = call.exec_ctx.host();
+      num_rows_ += call.num_rows;
+      calls_.push_back(std::move(call));
+
+      if (num_rows_ >= options_.max_batch_size) {
+        batches.push_back(TakeBatch());
+      } else if (calls_.size() == 1) {
+        timer_ = host_->GetTimerQueue()->ScheduleTimer(
+            options_.batch_timeout,
+            [queue = FormRef(this), batch_id = batch_id_] {
+              queue->RunOnTimeout(batch_id);
+            });
+      }
+    }
+    for (Batch& batch : batches) RunBatch(std::move(batch));
+  }
+
+  // Runs the queued calls.
+  void Flush() {
+    Batch batch;
+    {
+      mutex_lock lock(mu_);
+      batch = TakeBatch();
+    }
+    if (!batch.empty()) RunBatch(std::move(batch));
+  }
+
+ private:
+  // Runs the queued calls if they are still the batch with `batch_id`.
+  void RunOnTimeout(uint64_t batch_id) {
+    Batch batch;
+    {
+      mutex_lock lock(mu_);
+      if (batch_id != batch_id_) return;
+      // The timer has expired, it must not be cancelled.
+      timer_.reset();
+      batch = TakeBatch();
+    }
+    RunBatch(std::move(batch));
+  }
+
+  // Takes the queued calls and starts a new batch.
+  Batch TakeBatch() TFRT_REQUIRES(mu_) {
+    if (timer_) {
+      host_->GetTimerQueue()->CancelTimer(timer_);
+      timer_.reset();
+    }
+    ++batch_id_;
+    num_rows_ = 0;
+    Batch batch = std::move(calls_);
+    calls_.clear();
+    return batch;
+  }
+
+  // Returns the number of rows of a batch with `num_rows` rows after padding.
+  Index PaddedNumRows(Index num_rows) const {
+    const auto& sizes = options_.allowed_batch_sizes;
+    auto it = std::lower_bound(sizes.begin(), sizes.end(), num_rows);
+    return it == sizes.end() ? num_rows : *it;
+  }
+
+  void RunBatch(Batch calls) {
+    auto batch = std::make_shared<Batch>(std::move(calls));
+    const ExecutionContext& exec_ctx = batch->front().exec_ctx;
+
+    Index num_rows = 0;
+    for (const Call& call : *batch) num_rows += call.num_rows;
+    num_rows = PaddedNumRows(num_rows);
+
+    llvm::SmallVector<RCReference<AsyncValue>, 4> arguments;
+    llvm::SmallVector<AsyncValue*, 4> argument_ptrs;
+    for (size_t i = 0; i < batch->front().arguments.size(); ++i) {
+      auto argument = ConcatArgument(*batch, i, num_rows, exec_ctx.host());
+      if (!argument.ok()) {
+        for (Call& call : *batch) SetError(call, argument.status());
+        return;
+      }
+      arguments.push_back(
+          MakeAvailableAsyncValueRef<TensorHandle>(std::move(*argument)));
+      argument_ptrs.push_back(arguments.back().get());
+    }
+
+    llvm::SmallVector<RCReference<AsyncValue>, 4> results(
+        function_->num_results());
+    function_->Execute(exec_ctx, argument_ptrs, results);
+
+    // Wait for the results, and then for their tensors.
+    llvm::SmallVector<RCReference<AsyncValue>, 4> pending_results;
+    for (auto& result : results) pending_results.push_back(result.CopyRef());
+    RunWhenReady(pending_results, [batch, results = std::move(results),
+                                   num_rows]() mutable {
+      llvm::SmallVector<AsyncValue*, 4> tensors;
+      for (auto& result : results) {
+        if (!result->IsError())
+          tensors.push_back(result->get<TensorHandle>().GetAsyncTensor());
+      }
+      RunWhenReady(tensors, [batch = std::move(batch),
+                             results = std::move(results), num_rows] {
+        SplitResults(*batch, results, num_rows);
+      });
+    });
+  }
+
+  RCReference<const Function> function_;
+  const BatchSchedulerOptions options_;
+
+  mutex mu_;
+  Batch calls_ TFRT_GUARDED_BY(mu_);
+  Index num_rows_ TFRT_GUARDED_BY(mu_) = 0;
+  // Incremented for every batch, so that timers of past batches are ignored.
+  uint64_t batch_id_ TFRT_GUARDED_BY(mu_) = 0;
+  TimerQueue::TimerHandle timer_ TFRT_GUARDED_BY(mu_);
+  HostContext* host_ TFRT_GUARDED_BY(mu_) = nullptr;
+};
+
+BatchScheduler::BatchScheduler(const Function* function,
+                               BatchSchedulerOptions options)
+    : queue_(TakeRef(new Queue(function, std::move(options)))) {}
+
+BatchScheduler::~BatchScheduler() { queue_->Flush(); }
+
+llvm::SmallVector<AsyncValueRef<TensorHandle>, 4> BatchScheduler::Execute(
+    const ExecutionContext& exec_ctx, ArrayRef<TensorHandle> arguments) {
+  return queue_->Execute(exec_ctx, arguments);
+}
+
+}  // namespace tfrt
@@ -16,8 +16,14 @@
 
 #include "tfrt/core_runtime/core_runtime.h"
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringMap.h"
 #include "tfrt/core_runtime/core_runtime_op.h"
 #include "tfrt/core_runtime/op_handler.h"
 #include "tfrt/core_runtime/op_invocation.h"
@@ -38,6 +44,7 @@
 #include "tfrt/support/mutex.h"
 #include "tfrt/tensor/conversion_registry.h"
 #include "tfrt/tensor/tensor_metadata.h"
+#include "tfrt/support/thread_annotations.h"
 #include "tfrt/tracing/tracing.h"
 
 namespace tfrt {
@@ -70,10 +77,53 @@ class OpHandlerRegistry {
   std::vector<std::unique_ptr<OpHandler>> all_op_handlers_;
 };
 
+// Ops created by CoreRuntime::GetOrMakeOp() for one op handler and op name.
+// Traced ops are wrapped into a trace scope, so they are cached separately.
+struct CachedOps {
+  std::unique_ptr<CoreRuntimeOp> ops[2];
+};
+
+using CachedOpsEntry = llvm::StringMapEntry<CachedOps>;
+
+// Per-thread direct mapped cache of the CachedOps entries. Op names passed by
+// the same kernel point to the same BEF attribute, so the entry of a kernel is
+// found by comparing pointers, without hashing the op name or taking a lock.
+struct ThreadOpCacheSlot {
+  uint64_t runtime_id = 0;
+  const OpHandler* op_handler = nullptr;
+  const char* op_name = nullptr;
+  bool traced = false;
+  const CachedOpsEntry* entry = nullptr;
+};
+
+constexpr size_t kThreadOpCacheSize = 256;
+thread_local ThreadOpCacheSlot thread_op_cache[kThreadOpCacheSize];
+
+// CoreRuntime ids identify thread cache slots, so that the slots of a destroyed
+// CoreRuntime can't be confused with a new CoreRuntime at the same address.
+std::atomic<uint64_t> next_runtime_id{1};
+
 }  // namespace
 
 OpHandler::~OpHandler() {}
 
+void OpHandler::ExecuteBatch(ArrayRef<OpInvocation> invocations) {
+  for (const OpInvocation& invocation : invocations) {
+    auto op = runtime_->GetOrMakeOp(invocation.op_name, this);
+    if (op) {
+      (**op)(invocation);
+      continue;
+    }
+    llvm::consumeError(op.takeError());
+
+    auto err = EmitErrorAsync(
+        invocation.exec_ctx,
+        "op '" + invocation.op_name.str() + "' is not supported");
+    for (auto& result : invocation.results) result = TensorHandle(err);
+    if (invocation.chain) *invocation.chain = std::move(err);
+  }
+}
+
 class CoreRuntime::Impl {
  public:
   Impl(std::function<void(const DecodedDiagnostic&)> diag_handler,
@@ -81,7 +131,8 @@ class CoreRuntime::Impl {
        std::unique_ptr<ConcurrentWorkQueue> work_queue,
        string_view host_device_name)
       : context_(std::move(diag_handler), std::move(allocator),
-                 std::move(work_queue), host_device_name) {}
+                 std::move(work_queue), host_device_name),
+        id_(next_runtime_id.fetch_add(1, std::memory_order_relaxed)) {}
 
   HostContext* GetHostContext() { return &context_; }
 
@@ -113,6 +164,15 @@ class CoreRuntime::Impl {
   HostContext context_;
 
   OpHandlerRegistry op_handler_registry_;
+
+  // Unique id of this CoreRuntime, see ThreadOpCacheSlot.
+  const uint64_t id_;
+
+  // Ops cached by GetOrMakeOp(), keyed by the op handler and the op name. Ops
+  // are never evicted, the kernels refer to them through thread caches.
+  mutex op_cache_mu_;
+  llvm::DenseMap<OpHandler*, llvm::StringMap<CachedOps>> op_cache_
+      TFRT_GUARDED_BY(op_cache_mu_);
 };
 
 void CoreRuntime::Impl::Execute(const ExecutionContext& exec_ctx,
@@ -238,6 +298,35 @@ Expected<CoreRuntimeOp> CoreRuntime::MakeOp(string_view op_name,
       is_fallback, std::move(device), op->GetTensorType());
 }
 
+Expected<const CoreRuntimeOp*> CoreRuntime::GetOrMakeOp(string_view op_name,
+                                                        OpHandler* op_handler) {
+  bool traced = tracing::IsTracingEnabled(tracing::TracingLevel::Default);
+
+  // Fast path: the op was already used by this thread.
+  size_t index =
+      llvm::hash_combine(op_name.data(), op_handler) % kThreadOpCacheSize;
+  ThreadOpCacheSlot& slot = thread_op_cache[index];
+  if (slot.runtime_id == impl_->id_ && slot.op_handler == op_handler &&
+      slot.op_name == op_name.data() && slot.traced == traced &&
+      slot.entry->getKey() == op_name)
+    return slot.entry->getValue().ops[traced].get();
+
+  mutex_lock lock(impl_->op_cache_mu_);
+  CachedOpsEntry& entry =
+      *impl_->op_cache_[op_handler].try_emplace(op_name).first;
+  std::unique_ptr<CoreRuntimeOp>& op = entry.getValue().ops[traced];
+
+  // Errors are not cached, the op handler may learn about the op later.
+  if (!op) {
+    auto new_op = MakeOp(op_name, op_handler);
+    if (!new_op) return new_op.takeError();
+    op = std::make_unique<CoreRuntimeOp>(std::move(*new_op));
+  }
+
+  slot = {impl_->id_, op_handler, op_name.data(), traced, &entry};
+  return op.get();
+}
+
 Expected<CoreRuntimeOp> CoreRuntime::MakeCompositeOp(const Function* fn) {
   for (const auto& iter : llvm::enumerate(fn->argument_types().drop_front())) {
     size_t i = iter.index();
@@ -338,8 +427,9 @@ Expected<CoreRuntimeOp> CoreRuntime::MakeCompositeOp(const Function* fn) {
           if (th.IsMetadataAvailable()) {
             metadata_av.emplace(th.GetAvailableMetadata());
           } else {
-            th.GetAsyncMetadata().AndThen(
-                [th_metadata = th.GetAsyncMetadata().CopyRef(),
+            auto th_metadata = th.GetAsyncMetadata();
+            th_metadata.AndThen(
+                [th_metadata = th_metadata.CopyRef(),
                  metadata_av = std::move(metadata_av)]() {
                   if (th_metadata.IsError()) {
                     metadata_av.SetError(th_metadata.GetError());
@@ -17,11 +17,112 @@
 
 #include "tfrt/core_runtime/dispatch_utils.h"
 
+#include <algorithm>
+#include <cstdint>
+
+#include "llvm/ADT/Hashing.h"
+#include "tfrt/core_runtime/op_attr_type.h"
+#include "tfrt/host_context/attribute_utils.h"
 #include "tfrt/host_context/host_context.h"
 #include "tfrt/host_context/location.h"
 
 namespace tfrt {
 namespace internal {
+namespace {
+
+// Per-thread cache of the metadata function results. Ops are usually executed
+// with the same argument shapes and attributes over and over again, and
+// metadata functions are pure functions of them, so we can skip running the
+// metadata function if we have seen the same invocation before. The cache is
+// direct mapped, and a colliding invocation replaces the cached result.
+struct MetadataCacheSlot {
+  OpMetadataFn metadata_fn = nullptr;
+  uint64_t attrs_hash = 0;
+  llvm::SmallVector<TensorMetadata, 4> argument_mds;
+  llvm::SmallVector<TensorMetadata, 4> result_mds;
+};
+
+constexpr size_t kMetadataCacheSize = 64;
+thread_local MetadataCacheSlot metadata_cache[kMetadataCacheSize];
+
+// Attributes are hashed on every invocation, so ops with large attributes
+// (e.g. dense constants) are not cached.
+constexpr size_t kMaxCachedAttributeSize = 256;
+
+// Returns the hash of the attributes, or None if the attributes are too large
+// to be hashed on every invocation.
+Optional<uint64_t> HashOpAttrs(const OpAttrsRef& attrs) {
+  uint64_t hash = attrs.GetNumEntries();
+  bool cacheable = true;
+  attrs.IterateEntries([&](const OpAttrsRawEntry& entry) {
+    if (!cacheable) return;
+
+    const void* data = entry.GetData();
+    size_t size = 0;
+    if (entry.element_count != 0)
+      size = GetHostSizeAndAlignment(data, entry.type).first *
+             entry.element_count;
+    if (size > kMaxCachedAttributeSize) {
+      cacheable = false;
+      return;
+    }
+
+    // Entries of attributes that are not frozen are iterated in an arbitrary
+    // order, so the entry hashes are combined with an addition.
+    hash += llvm::hash_combine(
+        llvm::StringRef(entry.name), entry.type, entry.entry_type,
+        entry.element_count,
+        llvm::StringRef(static_cast<const char*>(data), size));
+  });
+  if (!cacheable) return llvm::None;
+  return hash;
+}
+
+MetadataCacheSlot& GetMetadataCacheSlot(OpMetadataFn metadata_fn,
+                                        uint64_t attrs_hash,
+                                        ArrayRef<TensorMetadata> mds) {
+  llvm::hash_code hash = llvm::hash_combine(metadata_fn, attrs_hash);
+  for (const TensorMetadata& md : mds)
+    hash = llvm::hash_combine(hash, md.dtype, md.shape.GetRank(),
+                              md.shape.GetNumElements());
+  return metadata_cache[static_cast<size_t>(hash) % kMetadataCacheSize];
+}
+
+}  // namespace
+
+bool GetStaticResultMetadata(
+    const OpAttrsRef& attrs, size_t num_results,
+    llvm::SmallVectorImpl<TensorMetadata>& result_mds) {
+  AggregateAttr metadata_attr;
+  if (!attrs.Get(kResultMetadataAttrName, &metadata_attr) ||
+      metadata_attr.GetNumElements() != num_results)
+    return false;
+
+  result_mds.reserve(num_results);
+  for (size_t i = 0; i != num_results; ++i) {
+    if (metadata_attr.GetElementType(i) != BEFAttributeType::kAggregate)
+      break;
+    auto md_attr = metadata_attr.GetAttributeOfType<AggregateAttr>(i);
+    if (md_attr.GetNumElements() != 2 ||
+        md_attr.GetElementType(0) != BEFAttributeType::kType ||
+        md_attr.GetElementType(1) != BEFAttributeType::kShape)
+      break;
+
+    auto shape_attr = md_attr.GetAttributeOfType<ShapeAttr>(1);
+    if (!shape_attr.HasRank()) break;
+    ArrayRef<AttrShapeT> dims = shape_attr.GetShape();
+    if (llvm::any_of(dims, [](AttrShapeT dim) { return dim < 0; })) break;
+
+    result_mds.emplace_back(md_attr.GetAttributeOfType<TypeAttr>(0).GetValue(),
+                            dims);
+  }
+
+  // Fall back to the metadata function if any metadata is not fully defined.
+  if (result_mds.size() == num_results) return true;
+  result_mds.clear();
+  return false;
+}
+
 MDFunctionExecResult ExecuteMetadataFunction(
     const OpMetadataFn& metadata_fn, const OpInvocation& invocation,
     llvm::SmallVectorImpl<TensorMetadata>& result_mds) {
@@ -47,37 +148,59 @@ MDFunctionExecResult ExecuteMetadataFunction(
       argument_mds.push_back(arguments[i].GetAvailableMetadata());
       continue;
     }
-    const auto& arg_md_av = arguments[i].GetAsyncMetadata();
+    AsyncValue* arg_md_av = arguments[i].GetAsyncMetadataValue();
 
-    auto arg_state = arg_md_av.GetAsyncValue()->state();
-    if (arg_state.IsUnconstructed()) {
+    if (!arg_md_av->IsAvailable()) {
       return MDFunctionExecResult::kMetadataUnavailable;
     }
 
     // If any input is an error, then propagate the error and bail out early.
-    if (arg_state.IsError()) {
-      propagate_error(arg_md_av.CopyRef());
+    if (arg_md_av->IsError()) {
+      propagate_error(FormRef(arg_md_av));
       return MDFunctionExecResult::kError;
     }
 
     // Otherwise, we have the metadata for the input.
-    assert(arg_state.IsConcrete());
-    argument_mds.push_back(arg_md_av.get());
+    argument_mds.push_back(arguments[i].GetAvailableMetadata());
   }
 
   // Okay, the shapes are available as we expect, get the result metadata.
   result_mds.resize(invocation.results.size());
 
+  // Reuse the result metadata of the previous invocation with the same
+  // argument metadata and attributes.
+  Optional<uint64_t> attrs_hash = HashOpAttrs(invocation.attrs);
+  MetadataCacheSlot* slot = nullptr;
+  if (attrs_hash) {
+    slot = &GetMetadataCacheSlot(metadata_fn, *attrs_hash, argument_mds);
+    if (slot->metadata_fn == metadata_fn && slot->attrs_hash == *attrs_hash &&
+        slot->result_mds.size() == result_mds.size() &&
+        llvm::makeArrayRef(slot->argument_mds) ==
+            llvm::makeArrayRef(argument_mds)) {
+      std::copy(slot->result_mds.begin(), slot->result_mds.end(),
+                result_mds.begin());
+      return MDFunctionExecResult::kSuccess;
+    }
+  }
+
   // TODO(tfrt-devs): Remove this tracing tag when finished debugging
   // dispatch performance.
   TFRT_TRACE_SCOPE(Verbose, "RunMetadataFunction");
   if (auto error = metadata_fn(invocation.exec_ctx, argument_mds,
                                invocation.attrs, result_mds)) {
-    // If the metadata function produced an error, propagate it.
+    // If the metadata function produced an error, propagate it. Errors are not
+    // cached, because they are reported through the execution context.
     propagate_error(std::move(error));
     return MDFunctionExecResult::kError;
   }
 
+  if (slot) {
+    slot->metadata_fn = metadata_fn;
+    slot->attrs_hash = *attrs_hash;
+    slot->argument_mds.assign(argument_mds.begin(), argument_mds.end());
+    slot->result_mds.assign(result_mds.begin(), result_mds.end());
+  }
+
   return MDFunctionExecResult::kSuccess;
 }
 
@@ -98,8 +221,7 @@ void ExecuteWhenMetadataIsReady(const OpInvocation& invocation,
     // this slow path.  We hand these off to RunWhenReady.
     if (!arguments[i].IsMetadataAvailable()) {
       // If metadata is not available, metadata must be async, and not inline.
-      const AsyncValueRef<TensorMetadata>& md = arguments[i].GetAsyncMetadata();
-      async_mds.push_back(md.GetAsyncValue());
+      async_mds.push_back(arguments[i].GetAsyncMetadataValue());
     }
 
     // We need to take the arguments so they are guaranteed to live for the
@@ -165,7 +287,7 @@ void ExecuteWhenMetadataIsReady(const OpInvocation& invocation,
       // If any input is an error, then propagate the error to all outputs
       // and we are done.
       if (arguments[i].IsMetadataError()) {
-        return propagate_error(arguments[i].GetAsyncMetadata().GetAsyncValue());
+        return propagate_error(arguments[i].GetAsyncMetadataValue());
       }
 
       // Otherwise, we have the metadata for the input.
@@ -144,7 +144,7 @@ void AsyncWaitForResultsFromTensorHandles(
   }
 }
 
-void ExecuteOpImpl(CoreRuntimeOp op, ArrayRef<AsyncValue *> args,
+void ExecuteOpImpl(const CoreRuntimeOp &op, ArrayRef<AsyncValue *> args,
                    AsyncValueRef<Chain> *op_chain,
                    MutableArrayRef<RCReference<AsyncValue>> results,
                    AggregateAttr op_attr_array,
@@ -187,8 +187,16 @@ void ExecuteOpImplSync(const CoreRuntimeOp &op,
   llvm::SmallVector<TensorHandle, 8> th_args;
   th_args.reserve(args.size());
 
-  for (auto &arg : args) {
-    th_args.push_back(arg.CopyRef());
+  // Move the TensorHandle if this kernel is the last user of its register, for
+  // the same reason as in ExecuteOpImpl. `args` are the trailing arguments of
+  // the kernel.
+  const int first_arg = frame->GetNumArgs() - args.size();
+  for (int i = 0, e = args.size(); i != e; ++i) {
+    if (frame->IsLastUse(first_arg + i)) {
+      th_args.push_back(std::move(args[i]));
+    } else {
+      th_args.push_back(args[i].CopyRef());
+    }
   }
 
   llvm::SmallVector<TensorHandle, 8> result_ths;
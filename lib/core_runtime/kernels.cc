@@ -17,6 +17,8 @@
 
 #include "tfrt/core_runtime/kernels.h"
 
+#include <algorithm>
+
 #include "llvm/ADT/FunctionExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "tfrt/core_runtime/core_runtime.h"
@@ -36,6 +38,7 @@
 #include "tfrt/host_context/sync_kernel_utils.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/ref_count.h"
+#include "tfrt/tensor/constant_store.h"
 #include "tfrt/tensor/conversion_registry.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 #include "tfrt/tensor/dense_host_tensor_view.h"
@@ -70,7 +73,7 @@ static void TensorHandleToShape(Argument<TensorHandle> arg,
     return;
   }
   // The metadata is not available yet.
-  const AsyncValueRef<TensorMetadata> &metadata = arg->GetAsyncMetadata();
+  AsyncValueRef<TensorMetadata> metadata = arg->GetAsyncMetadata();
 
   auto value = tensorshape_result.AllocateIndirect();
   metadata.AndThen([value_ref = std::move(value),
@@ -179,10 +182,12 @@ static llvm::Expected<TensorHandle> ConstStringTensor(
                       std::move(tensor_ref));
 }
 
+// Identical constants of all HostContexts and models share their data through
+// the ConstantStore.
 static llvm::Expected<TensorHandle> ConstDenseTensor(
     DenseAttr value, const ExecutionContext &context) {
   auto *host = context.host();
-  auto dht = DeserializeDenseHostTensorFromDenseAttr(value, host);
+  auto dht = ConstantStore::Global().GetOrCopy(CreateDenseView(value), host);
   if (!dht) return dht.takeError();
 
   auto metadata = dht->metadata();
@@ -212,14 +217,16 @@ static llvm::Expected<TensorHandle> CreateDenseTensor(
   return TensorHandle(host->GetHostDeviceRef(), metadata, std::move(dht));
 }
 
-static llvm::Expected<CoreRuntimeOp> GetCoreRuntimeOp(
+// Returns the op cached in the CoreRuntime for `op_name` and `op_handler`, so
+// that repeated executions of the kernel do not look up the op by name.
+static llvm::Expected<const CoreRuntimeOp *> GetCoreRuntimeOp(
     string_view op_name, OpHandler *op_handler,
     const ExecutionContext &exec_ctx) {
   auto *host = exec_ctx.host();
   auto *core_rt = CoreRuntime::GetFromHostContext(host);
   if (!core_rt) return MakeStringError("no CoreRuntime available");
 
-  return core_rt->MakeOp(op_name, op_handler);
+  return core_rt->GetOrMakeOp(op_name, op_handler);
 }
 
 // ExecuteOp executes the `op_name` operation on the `op_handler`.
@@ -235,7 +242,7 @@ static void ExecuteOp(Argument<OpHandler *> op_handler, RemainingArguments args,
   for (int b = 0, e = results.size(); b < e; ++b)
     results.AllocateAt<TensorHandle>(b);
 
-  ExecuteOpImpl(std::move(expected_op.get()), args.values(),
+  ExecuteOpImpl(**expected_op, args.values(),
                 /*op_chain=*/nullptr, results.values(), op_attr_array,
                 op_func_attr_array, exec_ctx);
 }
@@ -259,8 +266,8 @@ static void ExecuteOpSeq(Argument<OpHandler *> op_handler,
     results.AllocateAt<TensorHandle>(b);
 
   auto op_chain = in_op_chain.ValueRef();
-  ExecuteOpImpl(std::move(expected_op.get()), args.values(), &op_chain,
-                results.values(), op_attr_array, op_func_attr_array, exec_ctx);
+  ExecuteOpImpl(**expected_op, args.values(), &op_chain, results.values(),
+                op_attr_array, op_func_attr_array, exec_ctx);
   out_op_chain.Set(std::move(op_chain));
 }
 
@@ -274,7 +281,7 @@ static Error ExecuteOpSync(SyncArgument<OpHandler *> op_handler,
       GetCoreRuntimeOp(op_name.GetValue(), op_handler.get(), exec_ctx);
 
   if (!expected_op) return MakeStringError(expected_op.takeError());
-  ExecuteOpImplSync(expected_op.get(), args,
+  ExecuteOpImplSync(**expected_op, args,
                     /*op_chain=*/nullptr, frame, op_attr_array, exec_ctx);
   return Error::success();
 }
@@ -294,7 +301,7 @@ static void ExecuteCoreRuntimeOp(Argument<CoreRuntimeOp> op,
   for (int b = 0, e = results.size(); b < e; ++b)
     results.AllocateAt<TensorHandle>(b);
 
-  ExecuteOpImpl(std::move(op.get()), args.values(),
+  ExecuteOpImpl(op.get(), args.values(),
                 /*op_chain=*/nullptr, results.values(), op_attrs, op_func_attrs,
                 exec_ctx);
 }
@@ -357,6 +364,23 @@ void CreateLoggingOpHandlerKernel(Argument<OpHandler *> fallback,
   op_handler.Emplace(op_handler_ptr.get());
 }
 
+void CreateSampledLoggingOpHandlerKernel(Argument<OpHandler *> fallback,
+                                         Result<OpHandler *> op_handler,
+                                         Attribute<int32_t> sample_rate,
+                                         const ExecutionContext &exec_ctx) {
+  auto *runtime = tfrt::CoreRuntime::GetFromHostContext(exec_ctx.host());
+  assert(runtime);
+  auto op_handler_ptr =
+      CreateSampledLoggingOpHandler(runtime, fallback.get(),
+                                    std::max<int32_t>(*sample_rate, 0));
+  if (!op_handler_ptr) {
+    op_handler.Set(RCReference<AsyncValue>(
+        EmitErrorAsync(exec_ctx, op_handler_ptr.takeError())));
+    return;
+  }
+  op_handler.Emplace(op_handler_ptr.get());
+}
+
 static bool GetDHTPredicateValue(const DenseHostTensor &dht) {
   switch (dht.dtype()) {
     default:
@@ -949,6 +973,8 @@ void RegisterCoreRuntimeKernels(KernelRegistry *registry) {
                       TFRT_KERNEL(RegisterOpHandler));
   registry->AddKernel("corert.create_logging_op_handler",
                       TFRT_KERNEL(CreateLoggingOpHandlerKernel));
+  registry->AddKernel("corert.create_sampled_logging_op_handler",
+                      TFRT_KERNEL(CreateSampledLoggingOpHandlerKernel));
   registry->AddKernel("corert.const_dense_tensor",
                       TFRT_KERNEL(ConstDenseTensor));
   registry->AddKernel("corert.const_string_tensor",
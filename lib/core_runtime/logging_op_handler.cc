@@ -31,9 +31,16 @@
 #include <unistd.h>
 #endif
 
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <system_error>
 
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 #include "tfrt/core_runtime/core_runtime.h"
@@ -43,10 +50,14 @@
 #include "tfrt/core_runtime/op_invocation.h"
 #include "tfrt/core_runtime/tensor_handle.h"
 #include "tfrt/dtype/dtype_formatter.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/device.h"
 #include "tfrt/host_context/execution_context.h"
 #include "tfrt/host_context/kernel_utils.h"
+#include "tfrt/metrics/metrics.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/mutex.h"
+#include "tfrt/support/ref_count.h"
 #include "tfrt/support/thread_annotations.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 #include "tfrt/tensor/host_tensor.h"
@@ -82,10 +93,167 @@ void FlattenTensorAndDumpToOStream(const StringHostTensor &sht,
   }
 }
 
+// An op execution recorded by the sampled logging mode.
+struct OpSample {
+  std::string op_name;
+  std::string device;
+  // Dtypes and shapes of the arguments, or '?' for arguments whose metadata
+  // was not available when the op was dispatched.
+  std::string inputs;
+  // Wall time from the dispatch until all results are available.
+  double latency_us = 0;
+};
+
+// A bounded lock-free multi-producer multi-consumer queue of OpSamples, see
+// https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+// TryPush() fails instead of blocking when the queue is full.
+class OpSampleQueue {
+ public:
+  explicit OpSampleQueue(size_t capacity)
+      : slots_(new Slot[capacity]), mask_(capacity - 1) {
+    assert(llvm::isPowerOf2_64(capacity));
+    for (size_t i = 0; i < capacity; ++i)
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  bool TryPush(OpSample sample) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot &slot = slots_[pos & mask_];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          slot.sample = std::move(sample);
+          slot.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool TryPop(OpSample *sample) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot &slot = slots_[pos & mask_];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      auto diff =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          *sample = std::move(slot.sample);
+          slot.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  size_t ApproximateSize() const {
+    return enqueue_pos_.load(std::memory_order_relaxed) -
+           dequeue_pos_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    OpSample sample;
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  const size_t mask_;
+  // Keep the producer and consumer positions on separate cache lines.
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
+
+// Collects the samples of the sampled logging mode. Samples are printed and
+// exported to the op latency histogram by blocking work, so that ops only pay
+// for pushing to the lock-free queue. Pending work and op callbacks hold a
+// reference, which keeps the sink alive after its op handler is destroyed.
+class OpSampleSink : public ReferenceCounted<OpSampleSink> {
+ public:
+  explicit OpSampleSink(std::unique_ptr<llvm::raw_fd_ostream> ostream)
+      : ostream_(std::move(ostream)) {}
+
+  ~OpSampleSink() { Drain(); }
+
+  void Record(HostContext *host, OpSample sample) {
+    if (!queue_.TryPush(std::move(sample)))
+      num_dropped_.fetch_add(1, std::memory_order_relaxed);
+
+    if (queue_.ApproximateSize() < kDrainThreshold ||
+        drain_scheduled_.load(std::memory_order_relaxed) ||
+        drain_scheduled_.exchange(true, std::memory_order_acq_rel))
+      return;
+
+    bool enqueued = EnqueueBlockingWork(host, [sink = FormRef(this)] {
+      sink->drain_scheduled_.store(false, std::memory_order_release);
+      sink->Drain();
+    });
+    if (!enqueued) drain_scheduled_.store(false, std::memory_order_release);
+  }
+
+ private:
+  static constexpr size_t kCapacity = 4096;
+  static constexpr size_t kDrainThreshold = kCapacity / 2;
+
+  // Latency histogram with power-of-two bucket bounds from 1us to about 1s.
+  static metrics::Histogram *GetLatencyHistogram() {
+    static auto *histogram = [] {
+      std::vector<double> bounds;
+      for (int i = 0; i <= 20; ++i) bounds.push_back(double(1 << i));
+      return metrics::NewHistogram(
+          "/tensorflow/runtime/logging_op_handler/sampled_op_latency_us",
+          metrics::Buckets::Explicit(std::move(bounds)));
+    }();
+    return histogram;
+  }
+
+  void Drain() {
+    mutex_lock lock(mu_);
+    auto *histogram = GetLatencyHistogram();
+    OpSample sample;
+    while (queue_.TryPop(&sample)) {
+      histogram->Record(sample.latency_us);
+      *ostream_ << "[sampled] '" << sample.op_name << "' device "
+                << sample.device << ", inputs (" << sample.inputs << "), "
+                << sample.latency_us << "us\n";
+    }
+    if (auto num_dropped = num_dropped_.exchange(0, std::memory_order_relaxed))
+      *ostream_ << "[sampled] dropped " << num_dropped << " samples\n";
+  }
+
+  OpSampleQueue queue_{kCapacity};
+  std::atomic<uint64_t> num_dropped_{0};
+  std::atomic<bool> drain_scheduled_{false};
+
+  mutex mu_;
+  std::unique_ptr<llvm::raw_fd_ostream> ostream_ TFRT_GUARDED_BY(mu_);
+};
+
+// Number of ops executed by the current thread through sampled logging op
+// handlers. A thread local counter avoids contention between threads.
+thread_local uint32_t thread_sample_counter = 0;
+
 class LoggingOpHandler : public OpHandler {
  public:
+  // If `sample_rate` is not zero, the op handler logs the name, device, input
+  // shapes and latency of one in `sample_rate` ops, instead of the full inputs
+  // and outputs of every op.
   static llvm::Expected<std::unique_ptr<LoggingOpHandler>> Create(
-      CoreRuntime *runtime, OpHandler *fallback, bool sync_log_results) {
+      CoreRuntime *runtime, OpHandler *fallback, bool sync_log_results,
+      uint32_t sample_rate = 0) {
     std::unique_ptr<llvm::raw_fd_ostream> metadata_ostream;
     if (auto metadata_dump_prefix =
             std::getenv("LOGGING_DEV_METADATA_DUMP_PREFIX")) {
@@ -112,24 +280,39 @@ class LoggingOpHandler : public OpHandler {
     }
 
     auto op_handler = std::make_unique<LoggingOpHandler>(
-        runtime, fallback, sync_log_results, std::move(tensor_dump_prefix_str),
-        std::move(metadata_ostream));
+        runtime, fallback, sync_log_results, sample_rate,
+        std::move(tensor_dump_prefix_str), std::move(metadata_ostream));
     return std::move(op_handler);
   }
 
   explicit LoggingOpHandler(
       CoreRuntime *runtime, OpHandler *fallback, bool sync_log_results,
-      std::string tensor_dump_prefix,
+      uint32_t sample_rate, std::string tensor_dump_prefix,
       std::unique_ptr<llvm::raw_fd_ostream> metadata_ostream)
-      : OpHandler((sync_log_results ? "sync_logging" : "logging"), runtime,
+      : OpHandler(GetOpHandlerName(sync_log_results, sample_rate), runtime,
                   fallback),
         sync_log_results_(sync_log_results),
-        tensor_dump_prefix_(std::move(tensor_dump_prefix)),
-        metadata_ostream_(std::move(metadata_ostream)) {}
+        sample_rate_(sample_rate),
+        tensor_dump_prefix_(std::move(tensor_dump_prefix)) {
+    if (sample_rate_ > 0) {
+      sample_sink_ = TakeRef(new OpSampleSink(std::move(metadata_ostream)));
+    } else {
+      metadata_ostream_ = std::move(metadata_ostream);
+    }
+  }
 
   Expected<CoreRuntimeOp> MakeOp(string_view op_name) override;
 
  private:
+  static string_view GetOpHandlerName(bool sync_log_results,
+                                      uint32_t sample_rate) {
+    if (sample_rate > 0) return "sampled_logging";
+    return sync_log_results ? "sync_logging" : "logging";
+  }
+
+  Expected<CoreRuntimeOp> MakeSampledOp(string_view op_name,
+                                        CoreRuntimeOp fallback_handle);
+
   bool ShouldDumpTensorToFile() const { return !tensor_dump_prefix_.empty(); }
 
   // TODO(tfrt-devs): Handle error TensorHandle.
@@ -141,7 +324,7 @@ class LoggingOpHandler : public OpHandler {
     std::vector<RCReference<AsyncValue>> tensor_metadatas;
     for (auto &th : tensor_handles) {
       if (!th.IsMetadataAvailable()) {
-        tensor_metadatas.push_back(th.GetAsyncMetadata().CopyRCRef());
+        tensor_metadatas.push_back(FormRef(th.GetAsyncMetadataValue()));
       }
     }
 
@@ -226,8 +409,11 @@ class LoggingOpHandler : public OpHandler {
 
   // Synchronously log the op results
   const bool sync_log_results_;
+  // Log one in `sample_rate_` ops, or all ops with their tensors if zero.
+  const uint32_t sample_rate_;
   std::atomic<uint32_t> log_counter_{0};
   std::string tensor_dump_prefix_;
+  RCReference<OpSampleSink> sample_sink_;
 
   mutable mutex mu_;
   std::unique_ptr<llvm::raw_fd_ostream> metadata_ostream_ TFRT_GUARDED_BY(mu_);
@@ -237,6 +423,8 @@ class LoggingOpHandler : public OpHandler {
 Expected<CoreRuntimeOp> LoggingOpHandler::MakeOp(string_view op_name) {
   auto fallback_handle = GetFallback()->MakeOp(op_name);
   if (!fallback_handle) return fallback_handle.takeError();
+  if (sample_rate_ > 0)
+    return MakeSampledOp(op_name, std::move(fallback_handle.get()));
   return CoreRuntimeOp(
       [this, op_name = op_name.str(),
        fallback_handle =
@@ -296,6 +484,60 @@ Expected<CoreRuntimeOp> LoggingOpHandler::MakeOp(string_view op_name) {
       /*is_fallback=*/false);
 }
 
+Expected<CoreRuntimeOp> LoggingOpHandler::MakeSampledOp(
+    string_view op_name, CoreRuntimeOp fallback_handle) {
+  std::string device = fallback_handle.GetDeviceRef()
+                           ? fallback_handle.GetDeviceRef()->name().str()
+                           : GetFallback()->GetName().str();
+  bool is_fallback = fallback_handle.IsFallback();
+  auto op_device = fallback_handle.GetDeviceRef();
+  auto tensor_type = fallback_handle.GetTensorType();
+  return CoreRuntimeOp(
+      [this, op_name = op_name.str(), device = std::move(device),
+       fallback_handle =
+           std::move(fallback_handle)](const OpInvocation &invocation) {
+        if (++thread_sample_counter % sample_rate_ != 0) {
+          fallback_handle(invocation);
+          return;
+        }
+
+        OpSample sample;
+        sample.op_name = op_name;
+        sample.device = device;
+        {
+          llvm::raw_string_ostream os(sample.inputs);
+          for (auto &argument : invocation.arguments) {
+            if (&argument != invocation.arguments.begin()) os << ", ";
+            if (argument.IsMetadataAvailable()) {
+              os << argument.GetAvailableMetadata();
+            } else {
+              os << '?';
+            }
+          }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        fallback_handle(invocation);
+
+        llvm::SmallVector<AsyncValue *, 4> pending;
+        for (auto &result : invocation.results) {
+          if (result.IsValid()) pending.push_back(result.GetAsyncTensor());
+        }
+        if (invocation.chain && *invocation.chain)
+          pending.push_back(invocation.chain->GetAsyncValue());
+
+        RunWhenReady(pending, [sink = sample_sink_.CopyRef(),
+                               host = invocation.exec_ctx.host(),
+                               sample = std::move(sample), start]() mutable {
+          std::chrono::duration<double, std::micro> latency =
+              std::chrono::steady_clock::now() - start;
+          sample.latency_us = latency.count();
+          sink->Record(host, std::move(sample));
+        });
+      },
+      is_fallback, std::move(op_device), tensor_type);
+}
+
 llvm::Expected<tfrt::OpHandler *> CreateLoggingOpHandler(
     tfrt::CoreRuntime *runtime, OpHandler *fallback, bool sync_log_results) {
   auto op_handler =
@@ -308,4 +550,17 @@ llvm::Expected<tfrt::OpHandler *> CreateLoggingOpHandler(
   return op_handler_ptr;
 }
 
+llvm::Expected<tfrt::OpHandler *> CreateSampledLoggingOpHandler(
+    tfrt::CoreRuntime *runtime, OpHandler *fallback, uint32_t sample_rate) {
+  if (sample_rate == 0) return MakeStringError("sample_rate must be positive");
+  auto op_handler = LoggingOpHandler::Create(
+      runtime, fallback, /*sync_log_results=*/false, sample_rate);
+  if (auto error = op_handler.takeError()) {
+    return std::move(error);
+  }
+  auto op_handler_ptr = op_handler->get();
+  runtime->TakeOpHandler(std::move(op_handler.get()));
+  return op_handler_ptr;
+}
+
 }  // namespace tfrt
@@ -16,6 +16,11 @@
 
 #include "tfrt/core_runtime/op_attrs.h"
 
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Alignment.h"
@@ -26,6 +31,8 @@
 #include "tfrt/core_runtime/op_attr_type.h"
 #include "tfrt/dtype/quantized_types.h"
 #include "tfrt/support/alloc.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
 #include "tfrt/tensor/tensor_serialize_utils.h"
 
 namespace tfrt {
@@ -107,12 +114,19 @@ OpAttrType GetOpAttrTypeFromBEFAttributeType(BEFAttributeType kind) {
   llvm_unreachable("unsupported BEFAttributeType in Core Runtime.");
 }
 
+class InternedOpAttrsTable;
+
 // This class is an immutable copy of OpAttrs, designed for Op implementations
 // where it is convenient to capture an entire attribute set. This is designed
 // to do at most one allocation to store the entire attribute set - no matter
 // how small or large the attribute set is.
 //
-class ImmutableOpAttrs : public ReferenceCounted<ImmutableOpAttrs> {
+// Immutable attribute sets are interned by InternedOpAttrsTable, so that
+// identical frozen sets share a single instance. The intern table can hand out
+// a new reference while the last one is being dropped on another thread, which
+// is why this class keeps its own reference count instead of deriving from
+// ReferenceCounted.
+class ImmutableOpAttrs {
  public:
   // Note: users should not directly interface with this class, they should
   // generally use OpAttrsRef instead.
@@ -121,18 +135,39 @@ class ImmutableOpAttrs : public ReferenceCounted<ImmutableOpAttrs> {
   void IterateEntries(
       const std::function<void(const OpAttrsRawEntry &entry)> &fn) const;
 
+  // Hash of the attribute set, computed when the set is created.
+  uint64_t GetHash() const { return hash_; }
+
+  // Return true if this set has the same entries as `sorted_attrs`.
+  bool IsEqual(ArrayRef<const OpAttrsRawEntry *> sorted_attrs) const;
+
+  void AddRef() { ref_count_.fetch_add(1, std::memory_order_relaxed); }
+  void DropRef();
+
  private:
-  friend class ReferenceCounted<ImmutableOpAttrs>;
-  friend class OpAttrs;
+  friend class InternedOpAttrsTable;
+
+  static ImmutableOpAttrs *create(
+      ArrayRef<const OpAttrsRawEntry *> sorted_attrs, uint64_t hash);
+  ImmutableOpAttrs(size_t num_entries, uint64_t hash)
+      : ref_count_(1), num_entries_(num_entries), hash_(hash) {
+    AddNumReferenceCountedObjects();
+  }
+  ~ImmutableOpAttrs() { DropNumReferenceCountedObjects(); }
 
-  static RCReference<ImmutableOpAttrs> create(const OpAttrs &attrs);
-  explicit ImmutableOpAttrs(size_t num_entries) : num_entries_(num_entries) {}
+  // Add a reference unless the last reference was already dropped, in which
+  // case the set is about to be destroyed.
+  bool TryAddRef();
 
   void Destroy();
 
+  std::atomic<uint32_t> ref_count_;
+
   // This is the number of entries in this set.
   size_t num_entries_;
 
+  uint64_t hash_;
+
   // The entries_ array is tail allocated here, and followed by the payload
   // data for the attributes.
   OpAttrsRawEntry entries_[];
@@ -320,6 +355,40 @@ static void GetSortedAttrs(
                        });
 }
 
+// Return the payload of an internal entry.
+static string_view GetPayload(const OpAttrsRawEntry &entry) {
+  const auto type_size =
+      GetHostSizeAndAlignment(entry.GetData(), entry.type).first;
+  return string_view(static_cast<const char *>(entry.GetData()),
+                     type_size * entry.element_count);
+}
+
+// Hash the attributes sorted by name. Internal payloads are hashed by value and
+// external payloads by address, consistently with IsSameEntry.
+static uint64_t HashSortedAttrs(
+    ArrayRef<const OpAttrsRawEntry *> sorted_attrs) {
+  llvm::hash_code hash = llvm::hash_value(sorted_attrs.size());
+  for (auto *entry : sorted_attrs) {
+    hash = llvm::hash_combine(hash, string_view(entry->name), entry->type,
+                              entry->entry_type, entry->element_count);
+    if (entry->IsExternal())
+      hash = llvm::hash_combine(hash, entry->data);
+    else
+      hash = llvm::hash_combine(hash, GetPayload(*entry));
+  }
+  return hash;
+}
+
+static bool IsSameEntry(const OpAttrsRawEntry &lhs,
+                        const OpAttrsRawEntry &rhs) {
+  if (strcmp(lhs.name, rhs.name) != 0 || lhs.type != rhs.type ||
+      lhs.entry_type != rhs.entry_type ||
+      lhs.element_count != rhs.element_count)
+    return false;
+  if (lhs.IsExternal()) return lhs.data == rhs.data;
+  return GetPayload(lhs) == GetPayload(rhs);
+}
+
 //===----------------------------------------------------------------------===//
 // OpAttrs::OutOfLineRepresentation implementation
 //===----------------------------------------------------------------------===//
@@ -569,6 +638,68 @@ void OpAttrs::Print(raw_ostream &os) const { OpAttrsRef(*this).Print(os); }
 
 void OpAttrs::Dump() const { Print(llvm::errs()); }
 
+// The table of all live ImmutableOpAttrs, keyed by their hash. The table does
+// not own a reference to the sets, each set removes itself from the table when
+// its last reference is dropped.
+class InternedOpAttrsTable {
+ public:
+  static InternedOpAttrsTable &Get() {
+    static auto *table = new InternedOpAttrsTable();
+    return *table;
+  }
+
+  // Return a reference to the interned set with the entries in `sorted_attrs`,
+  // creating it if there is none.
+  RCReference<ImmutableOpAttrs> GetOrCreate(
+      ArrayRef<const OpAttrsRawEntry *> sorted_attrs) {
+    uint64_t hash = HashSortedAttrs(sorted_attrs);
+    Shard &shard = GetShard(hash);
+    mutex_lock lock(shard.mu);
+
+    auto range = shard.sets.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      ImmutableOpAttrs *attrs = it->second;
+      // Skip the sets whose last reference was dropped, they are erased as
+      // soon as their destruction gets the lock.
+      if (attrs->IsEqual(sorted_attrs) && attrs->TryAddRef())
+        return TakeRef(attrs);
+    }
+
+    auto *attrs = ImmutableOpAttrs::create(sorted_attrs, hash);
+    shard.sets.emplace(hash, attrs);
+    return TakeRef(attrs);
+  }
+
+  void Erase(ImmutableOpAttrs *attrs) {
+    Shard &shard = GetShard(attrs->GetHash());
+    mutex_lock lock(shard.mu);
+
+    auto range = shard.sets.equal_range(attrs->GetHash());
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == attrs) {
+        shard.sets.erase(it);
+        return;
+      }
+    }
+    assert(false && "ImmutableOpAttrs is not in the intern table");
+  }
+
+ private:
+  // The table is sharded by hash to reduce lock contention between threads
+  // freezing unrelated attribute sets.
+  static constexpr int kNumShards = 16;
+
+  struct Shard {
+    mutex mu;
+    std::unordered_multimap<uint64_t, ImmutableOpAttrs *> sets
+        TFRT_GUARDED_BY(mu);
+  };
+
+  Shard &GetShard(uint64_t hash) { return shards_[hash % kNumShards]; }
+
+  Shard shards_[kNumShards];
+};
+
 // Produce an immutable copy of this OpAttrs set on the heap and return a
 // reference to it.  This is the primary way to extend the lifetime of an
 // attribute set.
@@ -577,18 +708,20 @@ OpAttrsRef OpAttrs::freeze() const {
   // empty set reference.
   if (GetNumEntries() == 0) return OpAttrsRef();
 
-  // We may have already computed a frozen representation - if not, create one.
-  if (!frozen_representation_)
-    frozen_representation_ = ImmutableOpAttrs::create(*this);
+  // We may have already computed a frozen representation - if not, look up an
+  // identical interned set or create one.
+  if (!frozen_representation_) {
+    llvm::SmallVector<const OpAttrsRawEntry *, 16> sorted_attrs;
+    GetSortedAttrs(OpAttrsRef(*this), &sorted_attrs);
+    frozen_representation_ =
+        InternedOpAttrsTable::Get().GetOrCreate(sorted_attrs);
+  }
 
   return OpAttrsRef(frozen_representation_);
 }
 
-RCReference<ImmutableOpAttrs> ImmutableOpAttrs::create(const OpAttrs &attrs) {
-  // Sort the elements by attribute name.
-  llvm::SmallVector<const OpAttrsRawEntry *, 16> sorted_attrs;
-  GetSortedAttrs(OpAttrsRef(attrs), &sorted_attrs);
-
+ImmutableOpAttrs *ImmutableOpAttrs::create(
+    ArrayRef<const OpAttrsRawEntry *> sorted_attrs, uint64_t hash) {
   // Figure out how much space we need to hold these attributes.
   size_t alloc_size =
       sizeof(ImmutableOpAttrs) + sizeof(OpAttrsRawEntry) * sorted_attrs.size();
@@ -616,7 +749,7 @@ RCReference<ImmutableOpAttrs> ImmutableOpAttrs::create(const OpAttrs &attrs) {
 
   // Now that we know the size, create the result.
   auto *raw_memory = AlignedAlloc(alignof(ImmutableOpAttrs), alloc_size);
-  auto *result = new (raw_memory) ImmutableOpAttrs(sorted_attrs.size());
+  auto *result = new (raw_memory) ImmutableOpAttrs(sorted_attrs.size(), hash);
 
   char *data_ptr = static_cast<char *>(raw_memory);
 
@@ -661,20 +794,45 @@ RCReference<ImmutableOpAttrs> ImmutableOpAttrs::create(const OpAttrs &attrs) {
     out_offset += payload_size;
   }
 
-  return TakeRef(result);
+  return result;
 }
 
 //===----------------------------------------------------------------------===//
 // ImmutableOpAttrs implementation
 //===----------------------------------------------------------------------===//
 
+void ImmutableOpAttrs::DropRef() {
+  assert(ref_count_.load(std::memory_order_relaxed) > 0);
+  if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    InternedOpAttrsTable::Get().Erase(this);
+    Destroy();
+  }
+}
+
+bool ImmutableOpAttrs::TryAddRef() {
+  uint32_t ref_count = ref_count_.load(std::memory_order_relaxed);
+  do {
+    if (ref_count == 0) return false;
+  } while (!ref_count_.compare_exchange_weak(ref_count, ref_count + 1,
+                                             std::memory_order_relaxed));
+  return true;
+}
+
 // We use AlignedAlloc to allocate this, so we need to provide a custom destroy
-// hook for ReferenceCounted to use.
+// hook.
 void ImmutableOpAttrs::Destroy() {
   this->~ImmutableOpAttrs();
   AlignedFree(this);
 }
 
+bool ImmutableOpAttrs::IsEqual(
+    ArrayRef<const OpAttrsRawEntry *> sorted_attrs) const {
+  if (sorted_attrs.size() != num_entries_) return false;
+  for (size_t i = 0, e = num_entries_; i != e; ++i)
+    if (!IsSameEntry(entries_[i], *sorted_attrs[i])) return false;
+  return true;
+}
+
 // Look up an attribute by name, regardless of its underlying type.
 // On lookup failure, the result is null.
 const OpAttrsRawEntry *ImmutableOpAttrs::GetRaw(string_view attr_name) const {
@@ -741,6 +899,30 @@ const OpAttrsRawEntry *OpAttrsRef::GetRaw(string_view attr_name) const {
   return nullptr;
 }
 
+uint64_t OpAttrsRef::GetHash() const {
+  if (auto *ptr = attrs_.dyn_cast<ImmutableOpAttrs *>()) return ptr->GetHash();
+
+  llvm::SmallVector<const OpAttrsRawEntry *, 16> sorted_attrs;
+  GetSortedAttrs(*this, &sorted_attrs);
+  return HashSortedAttrs(sorted_attrs);
+}
+
+bool operator==(const OpAttrsRef &lhs, const OpAttrsRef &rhs) {
+  // Identical frozen sets are the same interned ImmutableOpAttrs, and empty
+  // frozen sets are null.
+  if (!lhs.attrs_.dyn_cast<const OpAttrs *>() &&
+      !rhs.attrs_.dyn_cast<const OpAttrs *>())
+    return lhs.attrs_ == rhs.attrs_;
+
+  llvm::SmallVector<const OpAttrsRawEntry *, 16> lhs_attrs, rhs_attrs;
+  GetSortedAttrs(lhs, &lhs_attrs);
+  GetSortedAttrs(rhs, &rhs_attrs);
+  if (lhs_attrs.size() != rhs_attrs.size()) return false;
+  for (size_t i = 0, e = lhs_attrs.size(); i != e; ++i)
+    if (!IsSameEntry(*lhs_attrs[i], *rhs_attrs[i])) return false;
+  return true;
+}
+
 // Print a single element of an attribute out.
 static void PrintElement(const void *ptr, OpAttrType type, raw_ostream &os) {
   switch (type) {
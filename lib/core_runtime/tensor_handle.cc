@@ -144,6 +144,35 @@ TensorHandle::TensorHandle(RCReference<Device> device,
   new (&inlined_device_) RCReference<Device>(std::move(device));
 }
 
+TensorHandle::TensorHandle(AsyncValueRef<RCReference<Device>> async_device,
+                           AsyncValueRef<Tensor> tensor) {
+  assert(tensor.GetAsyncValue());
+  assert(async_device.GetAsyncValue());
+  uint32_t flags = 0;
+
+  if (async_device.IsError() && !tensor.IsError()) {
+    tensor_and_flags_.setPointerAndInt(async_device.CopyRCRef().release(),
+                                       flags);
+  } else {
+    tensor_and_flags_.setPointerAndInt(tensor.release(), flags);
+  }
+
+  new (&async_device_)
+      AsyncValueRef<RCReference<Device>>(std::move(async_device));
+  new (&async_metadata_) AsyncValueRef<TensorMetadata>();
+}
+
+TensorHandle::TensorHandle(RCReference<Device> device,
+                           AsyncValueRef<Tensor> tensor) {
+  assert(tensor.GetAsyncValue());
+  assert(device);
+  uint32_t flags = Flags::DeviceInline;
+
+  tensor_and_flags_.setPointerAndInt(tensor.release(), flags);
+  new (&async_metadata_) AsyncValueRef<TensorMetadata>();
+  new (&inlined_device_) RCReference<Device>(std::move(device));
+}
+
 TensorHandle::TensorHandle(AsyncValueRef<TensorHandle> error) {
   assert(error.IsError());
   tensor_and_flags_.setPointerAndInt(error.CopyRef().release(), 0);
@@ -157,6 +186,25 @@ TensorHandle TensorHandle::CreateError(RCReference<AsyncValue> error) {
   return TensorHandle(std::move(th));
 }
 
+AsyncValueRef<TensorMetadata> TensorHandle::GetAsyncMetadataFromTensor() const {
+  AsyncValue* tensor = GetAsyncTensor();
+  if (tensor->IsError()) return AsyncValueRef<TensorMetadata>(FormRef(tensor));
+  if (tensor->IsConcrete())
+    return MakeAvailableAsyncValueRef<TensorMetadata>(
+        tensor->get<Tensor>().metadata());
+
+  auto metadata = MakeUnconstructedAsyncValueRef<TensorMetadata>();
+  tensor->AndThen([metadata = metadata.CopyRef(),
+                   tensor = AsyncValueRef<Tensor>(FormRef(tensor))]() {
+    if (tensor.IsError()) {
+      metadata.SetError(tensor.GetError());
+    } else {
+      metadata.emplace(tensor->metadata());
+    }
+  });
+  return metadata;
+}
+
 ErrorAsyncValue* TensorHandle::GetErrorAsyncValue() {
   assert(
       IsError() &&
@@ -214,7 +262,7 @@ TensorHandle TensorHandle::TransferTo(const ExecutionContext& exec_ctx,
     return TensorHandle(std::move(dst), GetAvailableMetadata(),
                         std::move(result_tensor));
   } else {
-    return TensorHandle(std::move(dst), GetAsyncMetadata().CopyRef(),
+    return TensorHandle(std::move(dst), GetAsyncMetadata(),
                         std::move(result_tensor));
   }
 }
@@ -253,8 +301,8 @@ TensorHandle TensorHandle::TransferToSameDevice(
     return TensorHandle(GetAsyncDevice().CopyRef(), GetAvailableMetadata(),
                         std::move(result_tensor));
   } else {
-    return TensorHandle(GetAsyncDevice().CopyRef(),
-                        GetAsyncMetadata().CopyRef(), std::move(result_tensor));
+    return TensorHandle(GetAsyncDevice().CopyRef(), GetAsyncMetadata(),
+                        std::move(result_tensor));
   }
 }
 
@@ -305,7 +353,7 @@ TensorHandle TensorHandle::TransferToInferredType(
     return TensorHandle(std::move(dst), GetAvailableMetadata(),
                         std::move(result_tensor));
   } else {
-    return TensorHandle(std::move(dst), GetAsyncMetadata().CopyRef(),
+    return TensorHandle(std::move(dst), GetAsyncMetadata(),
                         std::move(result_tensor));
   }
 }
@@ -314,13 +362,10 @@ raw_ostream& operator<<(raw_ostream& os, const TensorHandle& handle) {
   auto tensor = handle.GetAsyncTensor();
   // Check for invalid states.  Both null could happen when in a moved-from
   // state.
-  if (!handle.IsMetadataInline() && !handle.async_metadata_.GetAsyncValue() &&
-      !tensor)
+  if (handle.IsMetadataFromTensor() && !tensor)
     return os << "NULL TensorHandle!";
 
   // Handle truly invalid states gracefully.
-  if (!handle.IsMetadataInline() && !handle.async_metadata_.GetAsyncValue())
-    return os << "Invalid TensorHandle with null metadata!";
   if (!tensor) return os << "Invalid TensorHandle with null tensor!";
 
   // If the tensor is resolved, just print it.
@@ -335,6 +380,8 @@ raw_ostream& operator<<(raw_ostream& os, const TensorHandle& handle) {
   if (handle.IsMetadataInline())
     return os << "future TensorHandle with metadata "
               << handle.inlined_metadata_;
+  else if (handle.IsMetadataFromTensor())
+    return os << "fully future TensorHandle with unresolved metadata";
   else if (handle.async_metadata_.IsConcrete())
     return os << "future TensorHandle with metadata "
               << handle.async_metadata_.get();
@@ -0,0 +1,120 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the data pipeline autotuner.
+
+#include "tfrt/data/autotuner.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace tfrt {
+namespace data {
+
+//===----------------------------------------------------------------------===//
+// TunableParameter methods
+//===----------------------------------------------------------------------===//
+TunableParameter::TunableParameter(RCReference<Autotuner> autotuner,
+                                   int64_t value, int64_t min_value,
+                                   int64_t max_value)
+    : autotuner_(std::move(autotuner)),
+      min_value_(min_value),
+      max_value_(max_value),
+      value_(value),
+      period_start_(Clock::now()) {
+  assert(min_value_ <= value && value <= max_value_);
+}
+
+TunableParameter::~TunableParameter() { autotuner_->Release(value()); }
+
+void TunableParameter::RecordGetNext(const AsyncValueRef<bool>& eof) {
+  auto now = Clock::now();
+  if (!eof.IsAvailable()) {
+    eof.AndThen([parameter = FormRef(this), start = now]() {
+      auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          Clock::now() - start);
+      parameter->wait_ns_.fetch_add(wait.count(), std::memory_order_relaxed);
+    });
+  }
+  if (++num_calls_ == kPeriod) Tune(now);
+}
+
+void TunableParameter::Tune(Clock::time_point now) {
+  double elapsed_ns = std::max<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - period_start_)
+          .count(),
+      1);
+  int64_t wait_ns = wait_ns_.exchange(0, std::memory_order_relaxed);
+  double throughput = num_calls_ / elapsed_ns;
+  double wait_fraction = wait_ns / elapsed_ns;
+  period_start_ = now;
+  num_calls_ = 0;
+
+  int64_t value = this->value();
+  if (throughput_before_increment_ > 0) {
+    bool improved =
+        throughput >= throughput_before_increment_ * kMinImprovement;
+    throughput_before_increment_ = 0;
+    if (!improved) {
+      // More of this parameter does not help, e.g. because the iterator is
+      // limited by its input. Revert the increment and stop there.
+      max_value_ = value - 1;
+      value_.store(value - 1, std::memory_order_relaxed);
+      autotuner_->Release(1);
+      return;
+    }
+  }
+
+  if (wait_fraction > kStarvedWaitFraction) {
+    num_idle_periods_ = 0;
+    if (value < max_value_ && autotuner_->TryReserve(1)) {
+      throughput_before_increment_ = throughput;
+      value_.store(value + 1, std::memory_order_relaxed);
+    }
+    return;
+  }
+
+  if (wait_ns > 0 || ++num_idle_periods_ < kIdlePeriods) return;
+  num_idle_periods_ = 0;
+  if (value > min_value_) {
+    value_.store(value - 1, std::memory_order_relaxed);
+    autotuner_->Release(1);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Autotuner methods
+//===----------------------------------------------------------------------===//
+RCReference<TunableParameter> Autotuner::MakeParameter(int64_t initial_value,
+                                                       int64_t min_value,
+                                                       int64_t max_value) {
+  assert(min_value <= initial_value && initial_value <= max_value);
+  Reserve(min_value);
+  int64_t value = min_value;
+  int64_t extra = std::min(initial_value - min_value, available());
+  if (extra > 0 && TryReserve(extra)) value += extra;
+  return MakeRef<TunableParameter>(FormRef(this), value, min_value, max_value);
+}
+
+bool Autotuner::TryReserve(int64_t n) {
+  int64_t available = available_.load(std::memory_order_relaxed);
+  do {
+    if (available < n) return false;
+  } while (!available_.compare_exchange_weak(available, available - n,
+                                             std::memory_order_relaxed));
+  return true;
+}
+
+}  // namespace data
+}  // namespace tfrt
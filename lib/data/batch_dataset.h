@@ -372,12 +372,15 @@ class BatchDataset : public Dataset {
   BatchDataset(const BatchDataset&) = delete;
   BatchDataset& operator=(const BatchDataset&) = delete;
 
-  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+  string_view name() const override { return "batch_dataset"; }
 
  private:
   // Allow iterator to rely on private data members of this dataset.
   friend class BatchDatasetIterator<T...>;
 
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
   void Destroy() override {
     internal::DestroyImpl<BatchDataset>(this, allocator_);
   }
@@ -422,7 +425,7 @@ class BatchDatasetIterator : public Iterator {
 };
 
 template <typename... T>
-RCReference<Iterator> BatchDataset<T...>::MakeIterator(
+RCReference<Iterator> BatchDataset<T...>::MakeIteratorInternal(
     const IteratorContext& context) {
   return TakeRef(
       host_->Construct<BatchDatasetIterator<T...>>(FormRef(this), context));
@@ -0,0 +1,300 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements CacheDataset class, which caches the elements of
+// another dataset in a local file.
+
+#include "cache_dataset.h"
+
+#include <memory>
+
+#include "llvm/Support/FileSystem.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/io/buffered_input_stream.h"
+#include "tfrt/io/file_input_stream.h"
+#include "tfrt/io/file_system.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/logging.h"
+#include "tfrt/support/raw_coding.h"
+#include "tfrt/tensor/tensor_serialize_utils.h"
+
+namespace tfrt {
+namespace data {
+
+static std::string TemporaryCachePath(const std::string& path) {
+  return StrCat(path, ".tmp");
+}
+
+//===----------------------------------------------------------------------===//
+// CacheDataset methods
+//===----------------------------------------------------------------------===//
+RCReference<Iterator> CacheDataset::MakeIteratorInternal(
+    const IteratorContext& context) {
+  if (llvm::sys::fs::exists(path_)) {
+    return TakeRef(
+        host_->Construct<CacheDatasetReaderIterator>(FormRef(this), context));
+  }
+
+  RCReference<CacheWriter> writer;
+  {
+    mutex_lock lock(mu_);
+    if (!is_writing_) {
+      auto writer_or_error = CacheWriter::Create(FormRef(this));
+      if (writer_or_error) {
+        writer = std::move(*writer_or_error);
+        is_writing_ = true;
+      } else {
+        // The input dataset is still usable without the cache.
+        TFRT_LOG(WARNING) << "failed to create the cache file for " << path_
+                          << ": " << StrCat(writer_or_error.takeError());
+      }
+    }
+  }
+  return TakeRef(host_->Construct<CacheDatasetWriterIterator>(
+      FormRef(this), std::move(writer), context));
+}
+
+//===----------------------------------------------------------------------===//
+// CacheWriter methods
+//===----------------------------------------------------------------------===//
+llvm::Expected<RCReference<CacheWriter>> CacheWriter::Create(
+    RCReference<CacheDataset> dataset) {
+  std::error_code error;
+  auto stream = std::make_unique<llvm::raw_fd_ostream>(
+      TemporaryCachePath(dataset->path_), error, llvm::sys::fs::OF_None);
+  if (error) return MakeStringError(error.message());
+  stream->SetBufferSize(kWriteBufferSize);
+  return TakeRef(new CacheWriter(std::move(dataset), std::move(stream)));
+}
+
+CacheWriter::~CacheWriter() {
+  if (stream_) Discard();
+  mutex_lock lock(dataset_->mu_);
+  dataset_->is_writing_ = false;
+}
+
+void CacheWriter::Append(const IterationResult& element) {
+  // The file was already finished or discarded.
+  if (!stream_) return;
+
+  if (element.eof.IsError()) {
+    Discard();
+    return;
+  }
+  if (element.eof.get()) {
+    Finish();
+    return;
+  }
+
+  for (const auto& value : element.values) {
+    if (value->IsError()) {
+      Discard();
+      return;
+    }
+    const auto& tensor = value->get<DenseHostTensor>();
+    auto metadata = SerializeTensorMetadata(tensor.metadata());
+    WriteSize(metadata.size());
+    stream_->write(metadata.data(), metadata.size());
+    WriteSize(tensor.DataSizeInBytes());
+    stream_->write(static_cast<const char*>(tensor.data()),
+                   tensor.DataSizeInBytes());
+  }
+  if (stream_->has_error()) Discard();
+}
+
+void CacheWriter::WriteSize(uint64_t size) {
+  // The serialized TensorMetadata is little-endian too, so the cache file is
+  // only supported on little-endian hosts.
+  assert(isLittleEndian());
+  stream_->write(reinterpret_cast<const char*>(&size), sizeof(size));
+}
+
+bool CacheWriter::CloseStream() {
+  stream_->close();
+  bool has_error = stream_->has_error();
+  // Otherwise the stream reports the error as fatal when it is destroyed.
+  stream_->clear_error();
+  stream_.reset();
+  return !has_error;
+}
+
+void CacheWriter::Finish() {
+  const auto& path = dataset_->path_;
+  std::error_code error;
+  if (!CloseStream()) {
+    error = std::make_error_code(std::errc::io_error);
+  } else {
+    error = llvm::sys::fs::rename(TemporaryCachePath(path), path);
+  }
+  if (error) {
+    TFRT_LOG(WARNING) << "failed to write the cache file " << path << ": "
+                      << error.message();
+    llvm::sys::fs::remove(TemporaryCachePath(path));
+  }
+}
+
+void CacheWriter::Discard() {
+  CloseStream();
+  llvm::sys::fs::remove(TemporaryCachePath(dataset_->path_));
+}
+
+//===----------------------------------------------------------------------===//
+// CacheDatasetWriterIterator methods
+//===----------------------------------------------------------------------===//
+IterationResult CacheDatasetWriterIterator::GetNext(
+    const ExecutionContext& exec_ctx) {
+  auto input = input_iterator_->GetNext(exec_ctx);
+  if (!writer_) return input;
+
+  auto async_values = input.AsyncValues();
+  async_values.push_back(last_write_.GetAsyncValue());
+  auto write = MakeUnconstructedAsyncValueRef<Chain>();
+  // The callbacks are copyable so that `append` can run inline if the blocking
+  // work queue is full.
+  auto element = std::make_shared<IterationResult>(input.CopyRef());
+  RunWhenReady(async_values, [host = exec_ctx.host(), writer = writer_, element,
+                              write = write.CopyRCRef()]() {
+    auto append = [writer, element, write]() {
+      writer->Append(*element);
+      write->emplace<Chain>();
+    };
+    // Append() blocks on file IO, so it should not run on the non-blocking
+    // work queue.
+    if (!EnqueueBlockingWork(host, append)) append();
+  });
+  last_write_ = std::move(write);
+  return input;
+}
+
+//===----------------------------------------------------------------------===//
+// CacheDatasetReaderIterator methods
+//===----------------------------------------------------------------------===//
+IterationResult CacheDatasetReaderIterator::GetNextElement(
+    const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  auto arity = parent_dataset_->arity_;
+  if (auto error = MaybeInitializeStream()) {
+    auto async_error = MakeErrorAsyncValueRef(StrCat(error));
+    return IterationResult::Error(std::move(async_error), arity);
+  }
+
+  llvm::SmallVector<RCReference<AsyncValue>, 4> values;
+  values.reserve(arity);
+  for (int64_t i = 0; i < arity; ++i) {
+    bool eof = false;
+    auto tensor = ReadTensor(host, &eof);
+    // The file can only end at the boundary of an element.
+    if (eof && i == 0) return IterationResult::Eof(host, arity);
+    if (eof) tensor = MakeStringError("unexpected end of the cache file");
+    if (!tensor) {
+      // Do not decode location or emit error because the local handler might
+      // have been freed.
+      auto error = MakeErrorAsyncValueRef(StrCat(tensor.takeError()));
+      return IterationResult::Error(std::move(error), arity);
+    }
+    values.push_back(
+        MakeAvailableAsyncValueRef<DenseHostTensor>(std::move(*tensor)));
+  }
+  return IterationResult::Values(std::move(values), host);
+}
+
+llvm::Error CacheDatasetReaderIterator::MaybeInitializeStream() {
+  if (initialization_error_) {
+    return MakeStringError(initialization_error_);
+  }
+
+  if (stream_) return llvm::Error::success();
+
+  auto* fs_registry = ::tfrt::io::FileSystemRegistry::Default();
+  auto* file_system = fs_registry->LookupForPath(parent_dataset_->path_);
+  if (!file_system) {
+    initialization_error_ =
+        MakeStringError("No file system is found for the given scheme");
+    return MakeStringError(initialization_error_);
+  }
+
+  std::unique_ptr<::tfrt::io::RandomAccessFile> file;
+  auto error = file_system->NewRandomAccessFile(parent_dataset_->path_, &file);
+  if (error) {
+    initialization_error_ = MakeStringError(error);
+    return error;
+  }
+
+  stream_ = std::make_unique<::tfrt::io::BufferedInputStream>(
+      std::make_unique<::tfrt::io::FileInputStream>(std::move(file)),
+      kReadBufferSize, parent_dataset_->allocator_);
+  return llvm::Error::success();
+}
+
+llvm::Error CacheDatasetReaderIterator::ReadExactly(char* buf, size_t count,
+                                                    bool* eof) {
+  *eof = false;
+  auto count_or_error = stream_->Read(buf, count);
+  if (!count_or_error) return count_or_error.takeError();
+  if (*count_or_error == 0 && count > 0) {
+    *eof = true;
+    return llvm::Error::success();
+  }
+  if (*count_or_error < count) {
+    return MakeStringError("unexpected end of the cache file");
+  }
+  return llvm::Error::success();
+}
+
+llvm::Expected<uint64_t> CacheDatasetReaderIterator::ReadSize(bool* eof) {
+  char buf[sizeof(uint64_t)];
+  if (auto error = ReadExactly(buf, sizeof(buf), eof)) return std::move(error);
+  if (*eof) return 0;
+  return DecodeFixed64(buf);
+}
+
+llvm::Expected<DenseHostTensor> CacheDatasetReaderIterator::ReadTensor(
+    HostContext* host, bool* eof) {
+  auto metadata_size = ReadSize(eof);
+  if (!metadata_size) return metadata_size.takeError();
+  if (*eof) return DenseHostTensor();
+
+  bool unexpected_eof = false;
+  std::string serialized_metadata(*metadata_size, '\0');
+  if (auto error = ReadExactly(&serialized_metadata[0], *metadata_size,
+                               &unexpected_eof)) {
+    return std::move(error);
+  }
+  auto data_size = ReadSize(&unexpected_eof);
+  if (!data_size) return data_size.takeError();
+  if (unexpected_eof) {
+    return MakeStringError("unexpected end of the cache file");
+  }
+
+  auto metadata = DeserializeTensorMetadata(serialized_metadata);
+  if (!metadata) return metadata.takeError();
+  auto tensor = DenseHostTensor::CreateUninitialized(*metadata, host);
+  if (!tensor) return MakeStringError("failed to allocate a tensor");
+  if (tensor->DataSizeInBytes() != *data_size) {
+    return MakeStringError("corrupted cache file: expected ",
+                           tensor->DataSizeInBytes(), " bytes of data, got ",
+                           *data_size);
+  }
+  if (auto error = ReadExactly(static_cast<char*>(tensor->data()), *data_size,
+                               &unexpected_eof)) {
+    return std::move(error);
+  }
+  if (unexpected_eof) {
+    return MakeStringError("unexpected end of the cache file");
+  }
+  return std::move(*tensor);
+}
+
+}  // namespace data
+}  // namespace tfrt
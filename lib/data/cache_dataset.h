@@ -0,0 +1,224 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares CacheDataset class, which caches the elements of another
+// dataset in a local file.
+
+#ifndef TFRT_LIB_DATA_CACHE_DATASET_H_
+#define TFRT_LIB_DATA_CACHE_DATASET_H_
+
+#include <memory>
+#include <string>
+
+#include "io.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/data/dataset.h"
+#include "tfrt/host_context/chain.h"
+#include "tfrt/io/input_stream.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/ref_count.h"
+#include "tfrt/support/thread_annotations.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace data {
+
+// CacheDataset caches the elements of another dataset, whose components are
+// DenseHostTensor's, in the file at `path`, so that the work to produce them,
+// e.g. decoding and augmentation, is not repeated in every epoch and after
+// every restart.
+//
+// If the file does not exist when an iterator is created, the iterator returns
+// the elements of the input dataset and appends them to `path` + ".tmp" in the
+// background. The temporary file is renamed to `path` once the input iterator
+// reaches eof, so that an interrupted epoch never leaves an incomplete cache
+// behind. Only one iterator writes the cache at a time; the other iterators
+// created meanwhile just return the elements of the input dataset.
+//
+// If the file exists, the iterator reads the elements back from it with large
+// sequential reads, and the input dataset is not iterated at all.
+//
+// Each element is stored as its `arity` tensors, and each tensor as its
+// serialized TensorMetadata followed by its data, each preceded by its size in
+// bytes as a little-endian uint64.
+class CacheDataset : public Dataset {
+ public:
+  explicit CacheDataset(RCReference<Dataset> input_dataset, std::string path,
+                        int64_t arity, HostContext* host)
+      : input_dataset_(std::move(input_dataset)),
+        path_(std::move(path)),
+        arity_(arity),
+        host_(host),
+        allocator_(host->allocator()) {}
+
+  // This class is not copyable or movable.
+  CacheDataset(const CacheDataset&) = delete;
+  CacheDataset& operator=(const CacheDataset&) = delete;
+
+  string_view name() const override { return "cache_dataset"; }
+
+ private:
+  // Allow iterators and the writer to rely on private data members of this
+  // dataset.
+  friend class CacheWriter;
+  friend class CacheDatasetWriterIterator;
+  friend class CacheDatasetReaderIterator;
+
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
+  void Destroy() override {
+    internal::DestroyImpl<CacheDataset>(this, allocator_);
+  }
+
+  RCReference<Dataset> input_dataset_;
+  const std::string path_;
+  const int64_t arity_;
+  HostContext* host_;
+  HostAllocator* allocator_;
+
+  mutex mu_;
+  // Whether an iterator is writing the cache file.
+  bool is_writing_ TFRT_GUARDED_BY(mu_) = false;
+};
+
+// CacheWriter appends elements to the temporary cache file of a CacheDataset.
+// Calls to Append() must be serialized, and they block on file IO.
+class CacheWriter : public ReferenceCounted<CacheWriter> {
+ public:
+  // Creates the temporary cache file of `dataset`. Returns an error if it can
+  // not be created.
+  static llvm::Expected<RCReference<CacheWriter>> Create(
+      RCReference<CacheDataset> dataset);
+
+  // Removes the temporary cache file if the writer did not finish.
+  ~CacheWriter();
+
+  // This class is not copyable or movable.
+  CacheWriter(const CacheWriter&) = delete;
+  CacheWriter& operator=(const CacheWriter&) = delete;
+
+  // Appends the available `element` to the file. If its eof is true, renames
+  // the file to the cache path. If it has an error, discards the file.
+  void Append(const IterationResult& element);
+
+ private:
+  // The size of the write buffer, so that the file is written with large
+  // sequential writes.
+  static constexpr size_t kWriteBufferSize = 4 * 1024 * 1024;
+
+  CacheWriter(RCReference<CacheDataset> dataset,
+              std::unique_ptr<llvm::raw_fd_ostream> stream)
+      : dataset_(std::move(dataset)), stream_(std::move(stream)) {}
+
+  void WriteSize(uint64_t size);
+  // Closes and resets stream_. Returns false if any write failed.
+  bool CloseStream();
+  void Finish();
+  void Discard();
+
+  RCReference<CacheDataset> dataset_;
+  // Null once the writer finished or discarded the file.
+  std::unique_ptr<llvm::raw_fd_ostream> stream_;
+};
+
+// CacheDatasetWriterIterator returns the elements of the input dataset, and
+// writes them to the cache file if `writer` is not null.
+class CacheDatasetWriterIterator : public Iterator {
+ public:
+  explicit CacheDatasetWriterIterator(RCReference<CacheDataset> parent_dataset,
+                                      RCReference<CacheWriter> writer,
+                                      const IteratorContext& context)
+      : Iterator(),
+        parent_dataset_(std::move(parent_dataset)),
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+        writer_(std::move(writer)),
+        last_write_(MakeAvailableAsyncValueRef<Chain>()) {}
+
+  // This class is not copyable or movable.
+  CacheDatasetWriterIterator(const CacheDatasetWriterIterator&) = delete;
+  CacheDatasetWriterIterator& operator=(const CacheDatasetWriterIterator&) =
+      delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  void Destroy() override {
+    internal::DestroyImpl<CacheDatasetWriterIterator>(
+        this, parent_dataset_->allocator_);
+  }
+
+  RCReference<CacheDataset> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+  RCReference<CacheWriter> writer_;
+  // Becomes available when the last element returned by GetNext() is written.
+  // Each element is written after the previous one, in the order of the input.
+  AsyncValueRef<Chain> last_write_;
+};
+
+// CacheDatasetReaderIterator reads the elements from the cache file.
+class CacheDatasetReaderIterator : public io::PrefetchingIterator {
+ public:
+  explicit CacheDatasetReaderIterator(RCReference<CacheDataset> parent_dataset,
+                                      const IteratorContext& context)
+      : io::PrefetchingIterator(kMaxPrefetchNum, kPrefetchThreshold, context),
+        parent_dataset_(std::move(parent_dataset)) {}
+
+  // This class is not copyable or movable.
+  CacheDatasetReaderIterator(const CacheDatasetReaderIterator&) = delete;
+  CacheDatasetReaderIterator& operator=(const CacheDatasetReaderIterator&) =
+      delete;
+
+ protected:
+  // Reads the next element from the cache file. Returns an error if the file
+  // is truncated or can not be read.
+  IterationResult GetNextElement(const ExecutionContext& exec_ctx) final;
+
+ private:
+  static constexpr int64_t kMaxPrefetchNum = 16;
+  static constexpr int64_t kPrefetchThreshold = 4;
+  // The size of the read buffer, so that the file is read with large
+  // sequential reads.
+  static constexpr size_t kReadBufferSize = 4 * 1024 * 1024;
+
+  void Destroy() override {
+    internal::DestroyImpl<CacheDatasetReaderIterator>(
+        this, parent_dataset_->allocator_);
+  }
+
+  llvm::Error MaybeInitializeStream();
+
+  // Reads exactly `count` bytes into `buf`. Updates *eof to true iff the
+  // stream is at the end of the file and no bytes are read.
+  llvm::Error ReadExactly(char* buf, size_t count, bool* eof);
+
+  // Reads a size written by CacheWriter::WriteSize().
+  llvm::Expected<uint64_t> ReadSize(bool* eof);
+
+  // Reads the next tensor. Updates *eof to true iff the stream is at the end of
+  // the file and no bytes are read.
+  llvm::Expected<DenseHostTensor> ReadTensor(HostContext* host, bool* eof);
+
+  RCReference<CacheDataset> parent_dataset_;
+  std::unique_ptr<::tfrt::io::InputStream> stream_;
+  llvm::Error initialization_error_ = llvm::Error::success();
+};
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_LIB_DATA_CACHE_DATASET_H_
@@ -14,15 +14,21 @@
 
 // This file implements data kernels.
 
+#include <algorithm>
+
 #include "batch_dataset.h"
+#include "cache_dataset.h"
+#include "filter_batch_dataset.h"
 #include "filter_dataset.h"
 #include "interleave_dataset.h"
 #include "log_dataset.h"
+#include "map_and_batch_dataset.h"
 #include "map_dataset.h"
 #include "memory_dataset.h"
 #include "prefetch_dataset.h"
 #include "range_dataset.h"
 #include "repeat_dataset.h"
+#include "shard_dataset.h"
 #include "shuffle_dataset.h"
 #include "skip_dataset.h"
 #include "slice_dataset.h"
@@ -94,11 +100,14 @@ RCReference<RangeDataset> MakeRangeDataset(int64_t start, int64_t stop,
 
 RCReference<MapDataset> MakeMapDataset(RCReference<Dataset>* dataset,
                                        RemainingArguments args,
+                                       Attribute<bool> deterministic,
+                                       Attribute<int64_t> num_parallel_calls,
                                        Attribute<Function> fn,
                                        const ExecutionContext& exec_ctx) {
-  return TakeRef(exec_ctx.host()->Construct<MapDataset>(
+  HostContext* host = exec_ctx.host();
+  return TakeRef(host->Construct<MapDataset>(
       *dataset, RCArray<AsyncValue>(args.values()), FormRef(&fn.get()),
-      exec_ctx.host()));
+      *num_parallel_calls, deterministic.get(), host));
 }
 
 //===----------------------------------------------------------------------===//
@@ -113,35 +122,69 @@ RCReference<FilterDataset> MakeFilterDataset(RCReference<Dataset>* dataset,
       host->Construct<FilterDataset>((*dataset), FormRef(&fn.get()), host));
 }
 
+//===----------------------------------------------------------------------===//
+// FilterBatchDataset
+//===----------------------------------------------------------------------===//
+
+RCReference<FilterBatchDataset> MakeFilterBatchDataset(
+    RCReference<Dataset>* dataset, Attribute<Function> fn,
+    const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  return TakeRef(host->Construct<FilterBatchDataset>((*dataset),
+                                                     FormRef(&fn.get()), host));
+}
+
 //===----------------------------------------------------------------------===//
 // InterleaveDataset
 //===----------------------------------------------------------------------===//
 
 RCReference<InterleaveDataset> MakeInterleaveDataset(
     RCReference<Dataset>* dataset, int64_t cycle_length, int64_t block_length,
-    Attribute<int64_t> arity, Attribute<Function> fn,
+    Attribute<int64_t> arity, Attribute<int64_t> buffer_output_elements,
+    Attribute<bool> sloppy, Attribute<Function> fn,
     const ExecutionContext& exec_ctx) {
   assert(
       fn->result_types().size() == 1 &&
       "Interleave expects only one function output, which must be a dataset.");
 
-  return TakeRef(exec_ctx.host()->Construct<InterleaveDataset>(
+  HostContext* host = exec_ctx.host();
+  bool autotune = cycle_length == kAutotune;
+  if (autotune) {
+    cycle_length = std::max(host->GetNumWorkerThreads(), 1);
+  }
+  return TakeRef(host->Construct<InterleaveDataset>(
       *dataset, cycle_length, block_length, FormRef(&fn.get()), arity.get(),
-      exec_ctx.host()));
+      buffer_output_elements.get(), sloppy.get(), autotune, host));
 }
 
 //===----------------------------------------------------------------------===//
 // TFRecordDataset
 //===----------------------------------------------------------------------===//
 
-RCReference<TFRecordDataset> MakeTFRecordDataset(
+llvm::Expected<RCReference<TFRecordDataset>> MakeTFRecordDataset(
     std::string path, const ExecutionContext& exec_ctx) {
+  auto paths = ExpandFilePattern(path);
+  if (!paths) return paths.takeError();
   // Default buffer size to 256 KB.
   int64_t buffer_size = 256 * 1024;
   int64_t max_prefetch_num = 80;
   int64_t prefetch_threshold = 20;
   return TakeRef(exec_ctx.host()->Construct<TFRecordDataset>(
-      std::move(path), buffer_size, max_prefetch_num, prefetch_threshold,
+      std::move(*paths), buffer_size, max_prefetch_num, prefetch_threshold,
+      /*use_mmap=*/false, /*verify_checksum=*/true, exec_ctx.host()));
+}
+
+llvm::Expected<RCReference<TFRecordDataset>> MakeMappedTFRecordDataset(
+    std::string path, Attribute<bool> verify_checksum,
+    const ExecutionContext& exec_ctx) {
+  auto paths = ExpandFilePattern(path);
+  if (!paths) return paths.takeError();
+  // Reading mapped records is cheap, but may still block on page faults.
+  int64_t max_prefetch_num = 80;
+  int64_t prefetch_threshold = 20;
+  return TakeRef(exec_ctx.host()->Construct<TFRecordDataset>(
+      std::move(*paths), /*buffer_size=*/0, max_prefetch_num,
+      prefetch_threshold, /*use_mmap=*/true, verify_checksum.get(),
       exec_ctx.host()));
 }
 
@@ -178,6 +221,23 @@ RCReference<SkipDataset> MakeSkipDataset(RCReference<Dataset>* dataset,
   return TakeRef(host->Construct<SkipDataset>(*dataset, count, host));
 }
 
+//===----------------------------------------------------------------------===//
+// ShardDataset
+//===----------------------------------------------------------------------===//
+
+llvm::Expected<RCReference<Dataset>> MakeShardDataset(
+    RCReference<Dataset>* dataset, int64_t num_shards, int64_t index,
+    const ExecutionContext& exec_ctx) {
+  if (num_shards <= 0) {
+    return MakeStringError("num_shards must be positive, got ", num_shards);
+  }
+  if (index < 0 || index >= num_shards) {
+    return MakeStringError("index must be in [0, ", num_shards, "), got ",
+                           index);
+  }
+  return MakeShard(*dataset, num_shards, index, exec_ctx.host());
+}
+
 //===----------------------------------------------------------------------===//
 // MemoryDataset
 //===----------------------------------------------------------------------===//
@@ -189,6 +249,19 @@ RCReference<MemoryDataset<T...>> MakeMemoryDataset(
   return TakeRef(host->Construct<MemoryDataset<T...>>(*dataset, host));
 }
 
+//===----------------------------------------------------------------------===//
+// CacheDataset
+//===----------------------------------------------------------------------===//
+
+RCReference<CacheDataset> MakeCacheDataset(RCReference<Dataset>* dataset,
+                                           std::string path,
+                                           Attribute<int64_t> arity,
+                                           const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  return TakeRef(host->Construct<CacheDataset>(*dataset, std::move(path),
+                                               arity.get(), host));
+}
+
 //===----------------------------------------------------------------------===//
 // BatchDataset
 //===----------------------------------------------------------------------===//
@@ -202,6 +275,22 @@ RCReference<BatchDataset<T...>> MakeBatchDataset(
       *dataset, batch_size, same_input_metadata.get(), host));
 }
 
+//===----------------------------------------------------------------------===//
+// MapAndBatchDataset
+//===----------------------------------------------------------------------===//
+
+template <typename... T>
+RCReference<MapAndBatchDataset<T...>> MakeMapAndBatchDataset(
+    RCReference<Dataset>* dataset, int64_t batch_size, RemainingArguments args,
+    Attribute<int64_t> num_parallel_calls, Attribute<bool> same_input_metadata,
+    Attribute<Function> fn, const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  return TakeRef(host->Construct<MapAndBatchDataset<T...>>(
+      *dataset, batch_size, RCArray<AsyncValue>(args.values()),
+      FormRef(&fn.get()), *num_parallel_calls, same_input_metadata.get(),
+      host));
+}
+
 //===----------------------------------------------------------------------===//
 // PrefetchDataset
 //===----------------------------------------------------------------------===//
@@ -210,9 +299,6 @@ RCReference<PrefetchDataset> MakePrefetchDataset(
     RCReference<Dataset>* dataset, int64_t prefetch_num,
     Attribute<bool> is_deterministic, const ExecutionContext& exec_ctx) {
   HostContext* host = exec_ctx.host();
-  if (prefetch_num == -1) {
-    prefetch_num = host->GetNumWorkerThreads();
-  }
   return TakeRef(host->Construct<PrefetchDataset>(
       *dataset, prefetch_num, is_deterministic.get(), host));
 }
@@ -227,6 +313,15 @@ RCReference<Iterator> MakeIteratorFromDataset(RCReference<Dataset>* dataset) {
   return (*dataset)->MakeIterator(context);
 }
 
+// Create an iterator whose stages record their statistics. The statistics are
+// logged, along with the slowest stage, once the iterator is destroyed.
+RCReference<Iterator> MakeIteratorWithStatsFromDataset(
+    RCReference<Dataset>* dataset) {
+  IteratorContext context;
+  context.stats = MakeRef<PipelineStats>("pipeline", /*log_summary=*/true);
+  return (*dataset)->MakeIterator(context);
+}
+
 // Get the next element from the iterator and advance iterator.
 // The returned AsyncValueRef will contain error if the iterator has reached
 // end prior to the method invocation.
@@ -458,6 +553,8 @@ RCReference<LogDataset> MakeLogDataset(RCReference<Dataset>* dataset,
 void RegisterDataKernels(KernelRegistry* registry) {
   registry->AddKernel("tfrt_data.make_iterator",
                       TFRT_KERNEL(MakeIteratorFromDataset));
+  registry->AddKernel("tfrt_data.make_iterator_with_stats",
+                      TFRT_KERNEL(MakeIteratorWithStatsFromDataset));
   registry->AddKernel("tfrt_data.iterator_get_next",
                       TFRT_KERNEL(IteratorGetNext));
   registry->AddKernel("tfrt_data.enumerate.iterator",
@@ -486,13 +583,27 @@ void RegisterDataKernels(KernelRegistry* registry) {
   registry->AddKernel("tfrt_data.batch_dataset.i64_and_i64",
                       TFRT_KERNEL(MakeBatchDataset<int64_t, int64_t>));
 
+  registry->AddKernel("tfrt_data.map_and_batch_dataset.tensor",
+                      TFRT_KERNEL(MakeMapAndBatchDataset<DenseHostTensor>));
+  registry->AddKernel("tfrt_data.map_and_batch_dataset.i32",
+                      TFRT_KERNEL(MakeMapAndBatchDataset<int32_t>));
+  registry->AddKernel("tfrt_data.map_and_batch_dataset.i64",
+                      TFRT_KERNEL(MakeMapAndBatchDataset<int64_t>));
+  registry->AddKernel(
+      "tfrt_data.map_and_batch_dataset.tensor_and_i64",
+      TFRT_KERNEL(MakeMapAndBatchDataset<DenseHostTensor, int64_t>));
+
   registry->AddKernel("tfrt_data.memory_dataset.i64",
                       TFRT_KERNEL(MakeMemoryDataset<int64_t>));
   registry->AddKernel("tfrt_data.memory_dataset.str",
                       TFRT_KERNEL(MakeMemoryDataset<std::string>));
 
+  registry->AddKernel("tfrt_data.cache_dataset",
+                      TFRT_KERNEL(MakeCacheDataset));
   registry->AddKernel("tfrt_data.filter_dataset",
                       TFRT_KERNEL(MakeFilterDataset));
+  registry->AddKernel("tfrt_data.filter_batch_dataset",
+                      TFRT_KERNEL(MakeFilterBatchDataset));
   registry->AddKernel("tfrt_data.interleave_dataset",
                       TFRT_KERNEL(MakeInterleaveDataset));
   registry->AddKernel("tfrt_data.map_dataset", TFRT_KERNEL(MakeMapDataset));
@@ -501,8 +612,12 @@ void RegisterDataKernels(KernelRegistry* registry) {
   registry->AddKernel("tfrt_data.repeat_dataset",
                       TFRT_KERNEL(MakeRepeatDataset));
   registry->AddKernel("tfrt_data.skip_dataset", TFRT_KERNEL(MakeSkipDataset));
+  registry->AddKernel("tfrt_data.shard_dataset",
+                      TFRT_KERNEL(MakeShardDataset));
   registry->AddKernel("tfrt_data.tf_record_dataset",
                       TFRT_KERNEL(MakeTFRecordDataset));
+  registry->AddKernel("tfrt_data.mapped_tf_record_dataset",
+                      TFRT_KERNEL(MakeMappedTFRecordDataset));
   registry->AddKernel("tfrt_data.shuffle_dataset",
                       TFRT_KERNEL(MakeShuffleDataset));
   registry->AddKernel("tfrt_data.log_dataset", TFRT_KERNEL(MakeLogDataset));
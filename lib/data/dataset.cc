@@ -16,6 +16,11 @@
 
 #include "tfrt/data/dataset.h"
 
+#include <chrono>
+
+#include "tfrt/host_context/host_buffer.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
 namespace tfrt {
 namespace data {
 namespace internal {
@@ -24,6 +29,91 @@ bool IsConcreteAndEmpty(const IterationResult& result) {
   return result.eof.IsConcrete() && result.eof.get();
 }
 
+bool AvailableAndNotEof(const IterationResult& result) {
+  if (result.eof.IsConcrete() && result.eof.get()) return false;
+  if (!result.eof.IsAvailable()) return false;
+  for (auto& value : result.values) {
+    if (!value->IsAvailable()) return false;
+  }
+  return true;
+}
+
 }  // namespace internal
+
+namespace {
+
+// Returns the size of the values of the available `element` in bytes. Values
+// of types without a known size are ignored.
+size_t ElementBytes(const IterationResult& element) {
+  size_t bytes = 0;
+  for (const auto& value : element.values) {
+    if (!value->IsConcrete()) continue;
+    if (value->IsType<DenseHostTensor>()) {
+      bytes += value->get<DenseHostTensor>().DataSizeInBytes();
+    } else if (value->IsType<std::string>()) {
+      bytes += value->get<std::string>().size();
+    } else if (value->IsType<RCReference<HostBuffer>>()) {
+      bytes += value->get<RCReference<HostBuffer>>()->size();
+    }
+  }
+  return bytes;
+}
+
+// StatsIterator wraps the iterator of a dataset and records the statistics of
+// its GetNext() results in the stage of the dataset.
+class StatsIterator : public Iterator {
+ public:
+  explicit StatsIterator(RCReference<Iterator> iterator,
+                         RCReference<PipelineStats> stats,
+                         RCReference<IteratorStats> stage)
+      : iterator_(std::move(iterator)),
+        stats_(std::move(stats)),
+        stage_(std::move(stage)) {}
+
+  // This class is not copyable or movable.
+  StatsIterator(const StatsIterator&) = delete;
+  StatsIterator& operator=(const StatsIterator&) = delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override {
+    auto start = std::chrono::steady_clock::now();
+    auto result = iterator_->GetNext(exec_ctx);
+    RunWhenReady(result.AsyncValues(),
+                 [stage = stage_, start, result = result.CopyRef()]() {
+                   auto wait =
+                       std::chrono::duration_cast<IteratorStats::Duration>(
+                           std::chrono::steady_clock::now() - start);
+                   bool is_element =
+                       result.eof.IsConcrete() && !result.eof.get();
+                   stage->RecordGetNext(
+                       wait, is_element, is_element ? ElementBytes(result) : 0);
+                 });
+    return result;
+  }
+
+ private:
+  void Destroy() override { delete this; }
+
+  RCReference<Iterator> iterator_;
+  // Keeps the stages alive.
+  RCReference<PipelineStats> stats_;
+  RCReference<IteratorStats> stage_;
+};
+
+}  // namespace
+
+//===----------------------------------------------------------------------===//
+// Dataset methods
+//===----------------------------------------------------------------------===//
+RCReference<Iterator> Dataset::MakeIterator(const IteratorContext& context) {
+  if (!context.stats) return MakeIteratorInternal(context);
+
+  IteratorContext stage_context = context;
+  stage_context.stage =
+      context.stats->GetOrCreateStage(name(), context.stage.get());
+  auto iterator = MakeIteratorInternal(stage_context);
+  return TakeRef(new StatsIterator(std::move(iterator), context.stats,
+                                   std::move(stage_context.stage)));
+}
+
 }  // namespace data
 }  // namespace tfrt
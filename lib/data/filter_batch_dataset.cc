@@ -0,0 +1,140 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// This file implements FilterBatchDataset class which filters the rows of the
+// batched elements of another Dataset instance with a vectorized predicate.
+
+#include "filter_batch_dataset.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "map_dataset.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/string_util.h"
+#include "tfrt/tensor/dense_host_tensor.h"
+
+namespace tfrt {
+namespace data {
+namespace {
+
+// Returns the rows of `batch` whose value in `mask` is true.
+llvm::Expected<DenseHostTensor> CompactBatch(const DenseHostTensor& batch,
+                                             const DenseHostTensor& mask,
+                                             HostContext* host) {
+  if (mask.dtype() != DType::I1 || mask.shape().GetRank() != 1)
+    return MakeStringError("filter mask must be a 1-D bool tensor, got ",
+                           mask.metadata());
+  const auto& metadata = batch.metadata();
+  Index batch_size = mask.shape().GetDimensionSize(0);
+  if (metadata.shape.GetRank() == 0 ||
+      metadata.shape.GetDimensionSize(0) != batch_size)
+    return MakeStringError("filter mask of ", batch_size,
+                           " rows does not match batch ", metadata);
+
+  const bool* selected = mask.data<bool>();
+  Index num_selected = std::count(selected, selected + batch_size, true);
+  // Keep the batch if no row is filtered out.
+  if (num_selected == batch_size) return batch.CopyRef();
+
+  llvm::SmallVector<Index, 4> dims;
+  metadata.shape.GetDimensions(&dims);
+  dims[0] = num_selected;
+  auto result = DenseHostTensor::CreateUninitialized(
+      TensorMetadata(metadata.dtype, dims), host);
+  if (!result) return MakeStringError("out of memory");
+
+  // Copy the selected rows, merging adjacent rows into a single copy.
+  size_t row_size = batch.DataSizeInBytes() / batch_size;
+  const char* input = static_cast<const char*>(batch.data());
+  char* output = static_cast<char*>(result->data());
+  for (Index row = 0; row < batch_size;) {
+    if (!selected[row]) {
+      ++row;
+      continue;
+    }
+    Index end = row + 1;
+    while (end < batch_size && selected[end]) ++end;
+    size_t num_bytes = (end - row) * row_size;
+    std::memcpy(output, input + row * row_size, num_bytes);
+    output += num_bytes;
+    row = end;
+  }
+  return std::move(*result);
+}
+
+}  // namespace
+
+//===----------------------------------------------------------------------===//
+// FilterBatchDataset methods
+//===----------------------------------------------------------------------===//
+RCReference<Iterator> FilterBatchDataset::MakeIteratorInternal(
+    const IteratorContext& context) {
+  return TakeRef(
+      host_->Construct<FilterBatchDatasetIterator>(FormRef(this), context));
+}
+
+//===----------------------------------------------------------------------===//
+// FilterBatchDatasetIterator methods
+//===----------------------------------------------------------------------===//
+IterationResult FilterBatchDatasetIterator::GetNext(
+    const ExecutionContext& exec_ctx) {
+  auto input = input_iterator_->GetNext(exec_ctx);
+  auto mask = RunFunctionWhenReady(parent_dataset_->filter_fn_.get(),
+                                   input.CopyRef().values, exec_ctx, stage_);
+  assert(mask.size() == 1);
+
+  llvm::SmallVector<RCReference<AsyncValue>, 4> results;
+  results.reserve(input.values.size());
+  for (size_t i = 0; i < input.values.size(); ++i)
+    results.push_back(MakeIndirectAsyncValue());
+  auto result =
+      IterationResult::Pending(std::move(results), input.eof.CopyRef());
+
+  auto async_values = input.AsyncValues();
+  async_values.push_back(mask[0].get());
+  RunWhenReady(async_values, [host = exec_ctx.host(),
+                              input = std::move(input),
+                              mask = std::move(mask[0]),
+                              result = result.CopyRef()]() mutable {
+    for (size_t i = 0; i < result.values.size(); ++i) {
+      auto* output = cast<IndirectAsyncValue>(result.values[i].get());
+      // At the end of the input or on error, the values are errors.
+      if (input.eof.IsError() || *input.eof || input.values[i]->IsError()) {
+        output->ForwardTo(std::move(input.values[i]));
+      } else if (mask->IsError()) {
+        output->ForwardTo(mask);
+      } else {
+        auto compacted =
+            CompactBatch(input.values[i]->get<DenseHostTensor>(),
+                         mask->get<DenseHostTensor>(), host);
+        if (!compacted) {
+          output->ForwardTo(MakeErrorAsyncValueRef(
+              absl::InternalError(StrCat(compacted.takeError()))));
+        } else {
+          output->ForwardTo(MakeAvailableAsyncValueRef<DenseHostTensor>(
+              std::move(*compacted)));
+        }
+      }
+    }
+  });
+  return result;
+}
+
+}  // namespace data
+}  // namespace tfrt
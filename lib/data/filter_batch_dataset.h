@@ -0,0 +1,111 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares FilterBatchDataset class which filters the rows of the
+// batched elements of another Dataset instance with a vectorized predicate.
+
+#ifndef TFRT_LIB_DATA_FILTER_BATCH_DATASET_H_
+#define TFRT_LIB_DATA_FILTER_BATCH_DATASET_H_
+
+#include "tfrt/data/dataset.h"
+#include "tfrt/host_context/function.h"
+#include "tfrt/support/forward_decls.h"
+
+namespace tfrt {
+namespace data {
+
+class FilterBatchDatasetIterator;
+
+// FilterBatchDataset filters batches row by row with a single function call
+// per batch, instead of a call per element as FilterDataset does.
+//
+// Each element of the input dataset is a batch: DenseHostTensors whose
+// outermost dimension is the batch size, e.g. the output of batch_dataset. The
+// filter function takes the tensors of a batch and returns a 1-D bool
+// DenseHostTensor with a value per row. The dataset returns the batch with the
+// rows whose mask value is true, in their original order.
+//
+// A batch whose rows are all filtered out is returned with zero rows instead
+// of being dropped, so that batches are returned without waiting for the
+// masks of the previous ones.
+class FilterBatchDataset : public Dataset {
+ public:
+  explicit FilterBatchDataset(RCReference<Dataset> input_dataset,
+                              RCReference<const Function> filter_fn,
+                              HostContext* host)
+      : input_dataset_(std::move(input_dataset)),
+        host_(host),
+        allocator_(host->allocator()),
+        filter_fn_(std::move(filter_fn)) {}
+
+  // This class is not copyable or movable.
+  FilterBatchDataset(const FilterBatchDataset&) = delete;
+  FilterBatchDataset& operator=(const FilterBatchDataset&) = delete;
+
+  string_view name() const override { return "filter_batch_dataset"; }
+
+ private:
+  // Allow iterator to rely on private data members of this dataset.
+  friend class FilterBatchDatasetIterator;
+
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
+  void Destroy() override {
+    internal::DestroyImpl<FilterBatchDataset>(this, allocator_);
+  }
+
+  RCReference<Dataset> input_dataset_;
+  HostContext* host_;
+  HostAllocator* allocator_;
+  // The function takes the tensors of a batch from the `input_dataset_` and
+  // returns the mask of the rows to keep.
+  RCReference<const Function> filter_fn_;
+};
+
+class FilterBatchDatasetIterator : public Iterator {
+ public:
+  explicit FilterBatchDatasetIterator(
+      RCReference<FilterBatchDataset> parent_dataset,
+      const IteratorContext& context)
+      : Iterator(),
+        parent_dataset_(std::move(parent_dataset)),
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+        stage_(context.stage) {}
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  // This class is not copyable or movable.
+  FilterBatchDatasetIterator(const FilterBatchDatasetIterator&) = delete;
+  FilterBatchDatasetIterator& operator=(const FilterBatchDatasetIterator&) =
+      delete;
+
+  void Destroy() override {
+    internal::DestroyImpl<FilterBatchDatasetIterator>(
+        this, parent_dataset_->allocator_);
+  }
+
+  RCReference<FilterBatchDataset> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+  // Null unless the pipeline records statistics.
+  RCReference<IteratorStats> stage_;
+};
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_LIB_DATA_FILTER_BATCH_DATASET_H_
@@ -28,7 +28,7 @@ namespace data {
 //===----------------------------------------------------------------------===//
 // FilterDataset methods
 //===----------------------------------------------------------------------===//
-RCReference<Iterator> FilterDataset::MakeIterator(
+RCReference<Iterator> FilterDataset::MakeIteratorInternal(
     const IteratorContext& context) {
   return TakeRef(
       host_->Construct<FilterDatasetIterator>(FormRef(this), context));
@@ -89,8 +89,8 @@ void FilterDatasetIterator::MaybeScheduleBackgroundTask(
   const Function* filter_fn = parent_dataset_->filter_fn_.get();
   for (int i = 0; i < input_fetch_num; i++) {
     auto input = input_iterator_->GetNext(exec_ctx);
-    auto predicate_values =
-        RunFunctionWhenReady(filter_fn, input.CopyRef().values, exec_ctx);
+    auto predicate_values = RunFunctionWhenReady(
+        filter_fn, input.CopyRef().values, exec_ctx, stage_);
     assert(predicate_values.size() == 1);
 
     predicate_values[0]->AndThen([predicate_values = predicate_values[0],
@@ -52,12 +52,15 @@ class FilterDataset : public Dataset {
   FilterDataset(const FilterDataset&) = delete;
   FilterDataset& operator=(const FilterDataset&) = delete;
 
-  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+  string_view name() const override { return "filter_dataset"; }
 
  private:
   // Allow iterator to rely on private data members of this dataset.
   friend class FilterDatasetIterator;
 
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
   void Destroy() override {
     internal::DestroyImpl<FilterDataset>(this, allocator_);
   }
@@ -78,6 +81,7 @@ class FilterDatasetIterator : public Iterator {
       : Iterator(),
         parent_dataset_(std::move(parent_dataset)),
         input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+        stage_(context.stage),
         num_false_predicate_(0),
         token_owned_(false) {}
 
@@ -122,6 +126,8 @@ class FilterDatasetIterator : public Iterator {
 
   RCReference<FilterDataset> parent_dataset_;
   RCReference<Iterator> input_iterator_;
+  // Null unless the pipeline records statistics.
+  RCReference<IteratorStats> stage_;
   mutex mu_;
   // A queue of IterationResult pairs. The first value of each pair is a value
   // from the `input_iterator_`. The second value of each pair is the result of
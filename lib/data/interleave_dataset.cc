@@ -20,7 +20,12 @@
 
 #include "interleave_dataset.h"
 
+#include <atomic>
+#include <memory>
+
+#include "prefetch_dataset.h"
 #include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/chain.h"
 
 namespace tfrt {
 namespace data {
@@ -28,7 +33,7 @@ namespace data {
 //===----------------------------------------------------------------------===//
 // InterleaveDataset methods
 //===----------------------------------------------------------------------===//
-RCReference<Iterator> InterleaveDataset::MakeIterator(
+RCReference<Iterator> InterleaveDataset::MakeIteratorInternal(
     const IteratorContext& context) {
   return TakeRef(
       host_->Construct<InterleaveDatasetIterator>(FormRef(this), context));
@@ -60,15 +65,17 @@ IterationResult InterleaveDatasetIterator::GetNext(
   }
 
   MaybeScheduleBackgroundTask(exec_ctx, false, 0);
+  if (prefetch_iterator_num_) prefetch_iterator_num_->RecordGetNext(result.eof);
   return result;
 }
 
 void InterleaveDatasetIterator::PreInitializeIntermediateIterators(
     const ExecutionContext& exec_ctx) {
   if (is_input_iterator_eof_) return;
-  auto fetch_num = parent_dataset_->cycle_length_ +
-                   parent_dataset_->prefetch_iterator_num_ -
-                   num_open_iterators_;
+  // This is negative if the autotuned number of pre-initialized iterators
+  // decreased since the last call.
+  int64_t fetch_num = parent_dataset_->cycle_length_ + PrefetchIteratorNum() -
+                      static_cast<int64_t>(num_open_iterators_);
   for (int i = 0; i < fetch_num; i++) {
     // Read value from the input iterator.
     auto input_value = input_iterator_->GetNext(exec_ctx);
@@ -79,7 +86,10 @@ void InterleaveDatasetIterator::PreInitializeIntermediateIterators(
     }
     llvm::SmallVector<RCReference<AsyncValue>, 1> fn_results;
     fn_results.resize(1);
-    parent_dataset_->func_->Execute(exec_ctx, fn_args, fn_results);
+    {
+      FunctionTimer timer(context_.stage.get());
+      parent_dataset_->func_->Execute(exec_ctx, fn_args, fn_results);
+    }
 
     auto entry = IteratorAndQueue(std::move(input_value),
                                   std::move(fn_results[0]), true);
@@ -89,14 +99,25 @@ void InterleaveDatasetIterator::PreInitializeIntermediateIterators(
     entry.dataset->AndThen([dataset = entry.dataset,
                             prefetched_value = entry.prefetched_value.CopyRef(),
                             iterator = entry.iterator.CopyRef(),
-                            context = context_, exec_ctx]() mutable {
+                            buffer_output_elements =
+                                parent_dataset_->buffer_output_elements_,
+                            host = parent_dataset_->host_, context = context_,
+                            exec_ctx]() mutable {
       if (dataset->IsError()) {
         prefetched_value.SetError(dataset->GetError());
         iterator.SetError(dataset->GetError());
         return;
       }
-      auto iter =
-          dataset->template get<RCReference<Dataset>>()->MakeIterator(context);
+      auto intermediate_dataset =
+          FormRef(dataset->template get<RCReference<Dataset>>().get());
+      // Prefetch the values of each intermediate iterator in the background,
+      // independently of the position of the iterator in the cycle.
+      if (buffer_output_elements != 0) {
+        intermediate_dataset = TakeRef(host->Construct<PrefetchDataset>(
+            std::move(intermediate_dataset), buffer_output_elements,
+            /*is_deterministic=*/true, host));
+      }
+      auto iter = intermediate_dataset->MakeIterator(context);
       // IDEA(donglin): delay prefetching values from the 'future' iterators
       // until we have finished prefetching values from the iterators in the
       // current cycle.
@@ -113,6 +134,8 @@ void InterleaveDatasetIterator::PreInitializeIntermediateIterators(
 AsyncValue* InterleaveDatasetIterator::FetchInputValues(
     const ExecutionContext& exec_ctx) {
   auto output_buffer_size = OutputBufferSize();
+  // The number of consecutive positions skipped in sloppy mode.
+  int64_t num_skipped_iterators = 0;
 
   // The loop attempts to fetch enough values from the intermediate iterators to
   // fill every value in the output_buffer_*. It may stop earlier if e.g. an
@@ -174,6 +197,15 @@ AsyncValue* InterleaveDatasetIterator::FetchInputValues(
 
     auto& queue = iterator_and_queue.queue;
     if (iterator_and_queue.fetched_num_in_block == 0 && !queue.empty()) {
+      // In sloppy mode the outputs do not follow the order of the cycle. Skip
+      // the iterators whose queue has not been consumed yet, so that a slow
+      // iterator does not prevent fetching from the other iterators.
+      if (parent_dataset_->sloppy_ &&
+          ++num_skipped_iterators < parent_dataset_->cycle_length_) {
+        iterator_index_for_fetch_ =
+            (iterator_index_for_fetch_ + 1) % parent_dataset_->cycle_length_;
+        continue;
+      }
       // iterator_index_for_fetch_ is ahead of iterator_index_for_output_ by
       // one cycle of iterators. Exit the loop so that we can forward the
       // fetched values to the outputs before fetching more values. Otherwise a
@@ -181,6 +213,7 @@ AsyncValue* InterleaveDatasetIterator::FetchInputValues(
       // other iterators' queue which complicates FillOutputValues().
       break;
     }
+    num_skipped_iterators = 0;
 
     // Decide the number of values to fetch from the current iterator. It
     // should not exceed 1) the number of pending values in the the
@@ -218,6 +251,8 @@ AsyncValue* InterleaveDatasetIterator::FetchInputValues(
 
 AsyncValue* InterleaveDatasetIterator::FillOutputValues(
     const ExecutionContext& exec_ctx) {
+  if (parent_dataset_->sloppy_) return FillOutputValuesSloppy(exec_ctx);
+
   while (total_queues_size_ > 0) {
     assert(num_open_iterators_ > 0);
     auto& iterator_and_queue = iterator_and_queues_[iterator_index_for_output_];
@@ -289,6 +324,81 @@ AsyncValue* InterleaveDatasetIterator::FillOutputValues(
   return nullptr;
 }
 
+AsyncValue* InterleaveDatasetIterator::FillOutputValuesSloppy(
+    const ExecutionContext& exec_ctx) {
+  auto cycle_length = parent_dataset_->cycle_length_;
+  while (total_queues_size_ > 0) {
+    assert(num_open_iterators_ > 0);
+    // Look for the first open iterator whose next value has an available eof.
+    llvm::SmallVector<AsyncValue*, 4> unavailable_eofs;
+    auto index = iterator_index_for_output_;
+    bool found = false;
+    for (int64_t i = 0; i < cycle_length; ++i) {
+      auto& iterator_and_queue = iterator_and_queues_[index];
+      if (iterator_and_queue.is_open && !iterator_and_queue.queue.empty()) {
+        auto& eof = iterator_and_queue.queue.front().eof;
+        if (eof.IsAvailable()) {
+          found = true;
+          break;
+        }
+        unavailable_eofs.push_back(eof.GetAsyncValue());
+      }
+      index = (index + 1) % cycle_length;
+    }
+
+    // Wait for the eof of the value at the front of any queue to be available.
+    if (!found) {
+      assert(!unavailable_eofs.empty());
+      auto any_available = MakeUnconstructedAsyncValueRef<Chain>();
+      auto is_resolved = std::make_shared<std::atomic<bool>>(false);
+      for (auto* eof : unavailable_eofs) {
+        eof->AndThen([any_available = any_available.CopyRef(), is_resolved] {
+          if (!is_resolved->exchange(true)) any_available.emplace();
+        });
+      }
+      sloppy_wait_value_ = any_available.ReleaseRCRef();
+      return sloppy_wait_value_.get();
+    }
+
+    // Start the next search from the following iterator, so that the
+    // iterators with available values are consumed in a round-robin fashion.
+    iterator_index_for_output_ = (index + 1) % cycle_length;
+    auto& iterator_and_queue = iterator_and_queues_[index];
+    auto& queue = iterator_and_queue.queue;
+    auto& next_result = queue.front();
+    // The eof of the value at the front of the queue has error. Propagate the
+    // error to the next value in the output_buffer_*.
+    if (next_result.eof.IsError()) {
+      auto output = DequeueOutputBuffer();
+      output.eof.SetError(next_result.eof.GetError());
+      for (int i = 0; i < parent_dataset_->arity_; ++i) {
+        output.values[i]->SetError(next_result.eof.GetError());
+      }
+      queue.pop();
+      total_queues_size_--;
+      continue;
+    }
+    // The current iterator has reached end. Update iterator's state.
+    if (next_result.eof.get()) {
+      total_queues_size_ -= queue.size();
+      iterator_and_queue.is_open = false;
+      num_open_iterators_--;
+      break;
+    }
+    // Forward the value at the front of the queue to the next value in the
+    // output_buffer_*.
+    auto output = DequeueOutputBuffer();
+    output.eof.emplace(false);
+    for (int i = 0; i < parent_dataset_->arity_; ++i) {
+      auto* output_value = cast<IndirectAsyncValue>(output.values[i].get());
+      output_value->ForwardTo(std::move(next_result.values[i]));
+    }
+    queue.pop();
+    total_queues_size_--;
+  }
+  return nullptr;
+}
+
 void InterleaveDatasetIterator::MaybeScheduleBackgroundTask(
     const ExecutionContext& exec_ctx, bool is_token_owner, int callback_count) {
   while (true) {
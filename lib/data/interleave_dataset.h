@@ -51,17 +51,34 @@ class InterleaveDatasetIterator;
 // returned Dataset objects, and cycle through them, producing `block_length`
 // consecutive elements from each iterator, and consuming the next input
 // element each time it reaches the end of an iterator.
+//
+// If `buffer_output_elements` is not 0, every intermediate dataset is wrapped
+// in a PrefetchDataset with that prefetch_num, so that each iterator in the
+// cycle keeps its own buffer filled in the background instead of advancing
+// only when its turn comes.
+//
+// If `sloppy` is true, the order of the outputs is relaxed: the next output is
+// the first value that becomes available at the front of any iterator in the
+// cycle, and `block_length` only controls how many values are fetched from an
+// iterator at a time.
+//
+// If `autotune` is true, the number of intermediate iterators that are
+// pre-initialized ahead of the current cycle is autotuned.
 class InterleaveDataset : public Dataset {
  public:
   explicit InterleaveDataset(RCReference<Dataset> input_dataset,
                              int64_t cycle_length, int64_t block_length,
                              RCReference<const Function> func, int64_t arity,
-                             HostContext* host)
+                             int64_t buffer_output_elements, bool sloppy,
+                             bool autotune, HostContext* host)
       : input_dataset_(std::move(input_dataset)),
         cycle_length_(cycle_length),
         block_length_(block_length),
         prefetch_iterator_num_(cycle_length),
         arity_(arity),
+        buffer_output_elements_(buffer_output_elements),
+        sloppy_(sloppy),
+        autotune_(autotune),
         host_(host),
         allocator_(host->allocator()),
         func_(std::move(func)) {
@@ -73,12 +90,15 @@ class InterleaveDataset : public Dataset {
   InterleaveDataset(const InterleaveDataset&) = delete;
   InterleaveDataset& operator=(const InterleaveDataset&) = delete;
 
-  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+  string_view name() const override { return "interleave_dataset"; }
 
  private:
   // Allow iterator to rely on private data members of this dataset.
   friend class InterleaveDatasetIterator;
 
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
   void Destroy() override {
     internal::DestroyImpl<InterleaveDataset>(this, allocator_);
   }
@@ -91,6 +111,13 @@ class InterleaveDataset : public Dataset {
   // cycle.
   const int64_t prefetch_iterator_num_;
   const int64_t arity_;
+  // The prefetch_num of the PrefetchDataset wrapping each intermediate
+  // dataset, or 0 to not wrap them.
+  const int64_t buffer_output_elements_;
+  const bool sloppy_;
+  // Whether prefetch_iterator_num_ is only the initial value of the autotuned
+  // number of pre-initialized iterators, which ranges up to twice its value.
+  const bool autotune_;
   HostContext* host_;
   HostAllocator* allocator_;
   RCReference<const Function> func_;
@@ -110,6 +137,11 @@ class InterleaveDatasetIterator : public Iterator {
       iterator_and_queues_.push_back(
           IteratorAndQueue::DummyValue((parent_dataset_->host_)));
     }
+    if (parent_dataset_->autotune_) {
+      int64_t initial_num = parent_dataset_->prefetch_iterator_num_;
+      prefetch_iterator_num_ = context.autotuner->MakeParameter(
+          initial_num, /*min_value=*/1, /*max_value=*/2 * initial_num);
+    }
   }
 
   // This class is not copyable or movable.
@@ -181,7 +213,7 @@ class InterleaveDatasetIterator : public Iterator {
 
   // If the input iterator has not reached end, prefetch enough values from it
   // and transform those values into intermediate iterators until
-  // num_open_iterators_ == cycle_length_ + prefetch_iterator_num_.
+  // num_open_iterators_ == cycle_length_ + PrefetchIteratorNum().
   void PreInitializeIntermediateIterators(const ExecutionContext& exec_ctx)
       TFRT_EXCLUDES(mu_);
 
@@ -221,6 +253,21 @@ class InterleaveDatasetIterator : public Iterator {
   AsyncValue* FillOutputValues(const ExecutionContext& exec_ctx)
       TFRT_EXCLUDES(mu_);
 
+  // The sloppy version of FillOutputValues(). It forwards the value at the
+  // front of any open iterator's queue whose eof is available, starting from
+  // iterator_index_for_output_, until total_queues_size_ == 0. If the fronts of
+  // all queues are unavailable, it returns a pointer to an AsyncValue that
+  // becomes available when any of them does.
+  AsyncValue* FillOutputValuesSloppy(const ExecutionContext& exec_ctx)
+      TFRT_EXCLUDES(mu_);
+
+  // Return the number of intermediate iterators to pre-initialize ahead of the
+  // current cycle.
+  int64_t PrefetchIteratorNum() const {
+    return prefetch_iterator_num_ ? prefetch_iterator_num_->value()
+                                  : parent_dataset_->prefetch_iterator_num_;
+  }
+
   // Return the total number of values in the output buffers.
   int OutputBufferSize() TFRT_EXCLUDES(mu_) {
     mutex_lock lock(mu_);
@@ -244,6 +291,8 @@ class InterleaveDatasetIterator : public Iterator {
   RCReference<InterleaveDataset> parent_dataset_;
   RCReference<Iterator> input_iterator_;
   const IteratorContext context_;
+  // Null unless the number of pre-initialized iterators is autotuned.
+  RCReference<TunableParameter> prefetch_iterator_num_;
   bool is_input_iterator_eof_ = false;
 
   // List of intermediate iterators and their states. The positions of those
@@ -264,6 +313,9 @@ class InterleaveDatasetIterator : public Iterator {
   size_t iterator_index_for_output_ = 0;
   // Total size of queues across all iterators whose is_open is true.
   size_t total_queues_size_ = 0;
+  // The value returned by the last FillOutputValuesSloppy() call to wait for,
+  // kept alive until the token owner's callback runs.
+  RCReference<AsyncValue> sloppy_wait_value_;
 
   mutex mu_;
   // A queue of unavailable IterationResult enqueued by the caller of GetNext().
@@ -31,6 +31,7 @@ IterationResult PrefetchingIterator::GetNext(const ExecutionContext& exec_ctx) {
   auto* host = exec_ctx.host();
   {
     mutex_lock lock(mu_);
+    if (stage_) stage_->RecordBufferSize(prefetch_buffer_.size());
     // Schedule a blocking thread to fetch data if the number of prefetched
     // values has dropped below the threshold.
     if (!token_owned_ && !reached_eof_ &&
@@ -66,6 +67,7 @@ IterationResult PrefetchingIterator::GetNext(const ExecutionContext& exec_ctx) {
         host->EmitError(DecodedDiagnostic(exec_ctx.location().Decode(),
                                           input.eof.GetError()));
       }
+      max_prefetch_num_->RecordGetNext(input.eof);
       return input;
     }
   }
@@ -99,6 +101,7 @@ IterationResult PrefetchingIterator::GetNext(const ExecutionContext& exec_ctx) {
   }
 
   MaterializeOutputs(exec_ctx);
+  max_prefetch_num_->RecordGetNext(result.eof);
   return result;
 }
 
@@ -115,8 +118,11 @@ void PrefetchingIterator::ReadIOSource(const ExecutionContext& exec_ctx) {
         token_owned_ = false;
         return;
       }
-      fetch_num =
-          max_prefetch_num_ + output_buffer_.size() - prefetch_buffer_.size();
+      // This is negative if the autotuned maximum decreased below the number
+      // of prefetched values.
+      fetch_num = max_prefetch_num_->value() +
+                  static_cast<int64_t>(output_buffer_.size()) -
+                  static_cast<int64_t>(prefetch_buffer_.size());
     }
     for (int32_t i = 0; i < fetch_num; ++i) {
       if (exec_ctx.IsCancelled()) return;
@@ -53,6 +53,9 @@ namespace io {
 // This is an internal implementation detail, and it is not exposed to the end
 // user as a dataset type.
 //
+// The maximum number of prefetched elements is autotuned between
+// `prefetch_threshold` and `max_prefetch_num`, starting at `max_prefetch_num`.
+//
 // TODO(ezhulenev): Add flexible prefetching policy based not only on the number
 // of prefetched records, but also on the memory consumption.
 class PrefetchingIterator : public Iterator {
@@ -61,8 +64,10 @@ class PrefetchingIterator : public Iterator {
                                int64_t prefetch_threshold,
                                const IteratorContext& context)
       : Iterator(),
-        max_prefetch_num_(max_prefetch_num),
+        max_prefetch_num_(context.autotuner->MakeParameter(
+            max_prefetch_num, prefetch_threshold, max_prefetch_num)),
         prefetch_threshold_(prefetch_threshold),
+        stage_(context.stage),
         token_owned_(false),
         reached_eof_(false) {}
 
@@ -121,10 +126,12 @@ class PrefetchingIterator : public Iterator {
   // in addition to meeting the number of output values already requested in the
   // output_buffer_. The total number of values in the queues of the open
   // iterators is upper bounded by max_prefetch_num_ + output_buffer_size.
-  const size_t max_prefetch_num_;
+  RCReference<TunableParameter> max_prefetch_num_;
   // Schedule background blocking thread to prefetch from the underlying IO
   // source if the number of prefetched values dropped below this threadhold.
   const size_t prefetch_threshold_;
+  // Null unless the pipeline records statistics.
+  const RCReference<IteratorStats> stage_;
 
   // This is a unique logical token for this iterator instance. It effectively
   // acts as a lock to ensure in-order delivery of results by guaranteeing that
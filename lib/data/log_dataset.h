@@ -42,12 +42,15 @@ class LogDataset : public Dataset {
   LogDataset(const LogDataset&) = delete;
   LogDataset& operator=(const LogDataset&) = delete;
 
-  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+  string_view name() const override { return "log_dataset"; }
 
  private:
   // Allow iterator to rely on private data members of this dataset.
   friend class LogDatasetIterator;
 
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
   void Destroy() override {
     internal::DestroyImpl<LogDataset>(this, host_->allocator());
   }
@@ -85,7 +88,7 @@ class LogDatasetIterator : public Iterator {
   std::queue<IterationResult> buffer_;
 };
 
-inline RCReference<Iterator> LogDataset::MakeIterator(
+inline RCReference<Iterator> LogDataset::MakeIteratorInternal(
     const IteratorContext& context) {
   return TakeRef(host_->Construct<LogDatasetIterator>(FormRef(this), context));
 }
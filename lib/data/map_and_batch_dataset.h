@@ -0,0 +1,292 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares MapAndBatchDataset class which fuses MapDataset and
+// BatchDataset. It maps a user-defined function over the elements of another
+// Dataset instance and writes the results into batches.
+
+#ifndef TFRT_DATA_MAP_AND_BATCH_DATASET_H_
+#define TFRT_DATA_MAP_AND_BATCH_DATASET_H_
+
+#include <algorithm>
+
+#include "batch_dataset.h"
+#include "llvm/ADT/SmallVector.h"
+#include "map_dataset.h"
+#include "tfrt/data/dataset.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/function.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/support/rc_array.h"
+#include "tfrt/support/ref_count.h"
+
+namespace tfrt {
+namespace data {
+
+template <typename... T>
+class MapAndBatchDatasetIterator;
+
+// Runs `function` for each of `slot_arguments` in a single task on the work
+// queue once all of the arguments are available, and returns the results of
+// each invocation as IndirectAsyncValue's. If `stage` is not null, the time
+// spent in the function is recorded in it.
+inline llvm::SmallVector<llvm::SmallVector<RCReference<AsyncValue>, 4>, 4>
+EnqueueFunctionsWhenReady(
+    const Function* function,
+    llvm::SmallVector<llvm::SmallVector<RCReference<AsyncValue>, 4>, 4>
+        slot_arguments,
+    const ExecutionContext& exec_ctx, RCReference<IteratorStats> stage = {}) {
+  auto num_results = function->result_types().size();
+  llvm::SmallVector<AsyncValue*, 4> argument_ptrs;
+  llvm::SmallVector<RCReference<IndirectAsyncValue>, 4> results;
+  llvm::SmallVector<llvm::SmallVector<RCReference<AsyncValue>, 4>, 4>
+      results_copy;
+  results_copy.resize(slot_arguments.size());
+  for (size_t i = 0; i < slot_arguments.size(); ++i) {
+    for (const auto& argument : slot_arguments[i])
+      argument_ptrs.push_back(argument.get());
+    for (size_t j = 0; j < num_results; ++j) {
+      results.push_back(MakeIndirectAsyncValue());
+      results_copy[i].push_back(results.back());
+    }
+  }
+
+  auto execute = [function, slot_arguments = std::move(slot_arguments),
+                  results = std::move(results), exec_ctx,
+                  stage = std::move(stage)]() {
+    auto num_results = function->result_types().size();
+    for (size_t i = 0; i < slot_arguments.size(); ++i) {
+      llvm::SmallVector<AsyncValue*, 4> argument_ptrs;
+      for (const auto& argument : slot_arguments[i])
+        argument_ptrs.push_back(argument.get());
+      llvm::SmallVector<RCReference<AsyncValue>, 4> fn_results;
+      fn_results.resize(num_results);
+      {
+        FunctionTimer timer(stage.get());
+        function->Execute(exec_ctx, argument_ptrs, fn_results);
+      }
+      for (size_t j = 0; j < num_results; ++j) {
+        results[i * num_results + j]->ForwardTo(std::move(fn_results[j]));
+      }
+    }
+  };
+  RunWhenReady(argument_ptrs,
+               [exec_ctx, execute = std::move(execute)]() mutable {
+                 EnqueueWork(exec_ctx, std::move(execute));
+               });
+
+  return results_copy;
+}
+
+// MapAndBatchDataset is equivalent to a MapDataset followed by a BatchDataset.
+//
+// Instead of returning each mapped element to a separate batch iterator, the
+// iterator copies every map result into its slot of the batch tensor as soon as
+// it becomes available, typically on the thread that computed it. If
+// `same_input_metadata` is true, the batch tensors are allocated before the map
+// results are available, except for the first batch.
+//
+// If `num_parallel_calls` is larger than 1, the slots of each batch are split
+// into that many tasks which run the map function on the work queue in
+// parallel. Otherwise, the map function runs inline, like in MapDataset.
+template <typename... T>
+class MapAndBatchDataset : public Dataset {
+ public:
+  explicit MapAndBatchDataset(RCReference<Dataset> input_dataset,
+                              int64_t batch_size,
+                              RCArray<AsyncValue> additional_fn_args,
+                              RCReference<const Function> map_fn,
+                              int64_t num_parallel_calls,
+                              bool same_input_metadata, HostContext* host)
+      : input_dataset_(std::move(input_dataset)),
+        batch_size_(batch_size),
+        additional_fn_args_(std::move(additional_fn_args)),
+        map_fn_(std::move(map_fn)),
+        num_parallel_calls_(num_parallel_calls),
+        same_input_metadata_(same_input_metadata),
+        host_(host),
+        allocator_(host->allocator()) {
+    assert(map_fn_->result_types().size() == sizeof...(T));
+  }
+
+  // This class is not copyable or movable.
+  MapAndBatchDataset(const MapAndBatchDataset&) = delete;
+  MapAndBatchDataset& operator=(const MapAndBatchDataset&) = delete;
+
+  string_view name() const override { return "map_and_batch_dataset"; }
+
+ private:
+  // Allow iterator to rely on private data members of this dataset.
+  friend class MapAndBatchDatasetIterator<T...>;
+
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
+  void Destroy() override {
+    internal::DestroyImpl<MapAndBatchDataset>(this, allocator_);
+  }
+
+  RCReference<Dataset> input_dataset_;
+  const int64_t batch_size_;
+  RCArray<AsyncValue> additional_fn_args_;
+  RCReference<const Function> map_fn_;
+  const int64_t num_parallel_calls_;
+  const bool same_input_metadata_;
+  HostContext* host_;
+  HostAllocator* allocator_;
+};
+
+template <typename... T>
+class MapAndBatchDatasetIterator : public Iterator {
+ public:
+  explicit MapAndBatchDatasetIterator(
+      RCReference<MapAndBatchDataset<T...>> parent_dataset,
+      const IteratorContext& context)
+      : Iterator(),
+        parent_dataset_(std::move(parent_dataset)),
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+        stage_(context.stage),
+        is_initialized_(false) {}
+
+  // This class is not copyable or movable.
+  MapAndBatchDatasetIterator(const MapAndBatchDatasetIterator&) = delete;
+  MapAndBatchDatasetIterator& operator=(const MapAndBatchDatasetIterator&) =
+      delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  void Destroy() override {
+    internal::DestroyImpl<MapAndBatchDatasetIterator>(
+        this, parent_dataset_->allocator_);
+  }
+
+  // Gets up to batch_size elements from the input iterator and maps the
+  // function over them.
+  llvm::SmallVector<IterationResult, 4> MapInputs(
+      const ExecutionContext& exec_ctx);
+
+  RCReference<MapAndBatchDataset<T...>> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+  // Null unless the pipeline records statistics.
+  RCReference<IteratorStats> stage_;
+  // input_metadata_ contains TensorMetadata from each of the components of the
+  // first mapped element. When same_input_metadata_ is true, we can use
+  // input_metadata_ to allocate output tensors before map results are
+  // available.
+  llvm::SmallVector<AsyncValueRef<TensorMetadata>, 4> input_metadata_;
+  bool is_initialized_;
+};
+
+template <typename... T>
+RCReference<Iterator> MapAndBatchDataset<T...>::MakeIteratorInternal(
+    const IteratorContext& context) {
+  return TakeRef(host_->Construct<MapAndBatchDatasetIterator<T...>>(
+      FormRef(this), context));
+}
+
+template <typename... T>
+llvm::SmallVector<IterationResult, 4>
+MapAndBatchDatasetIterator<T...>::MapInputs(const ExecutionContext& exec_ctx) {
+  const Function* map_fn = parent_dataset_->map_fn_.get();
+  int64_t batch_size = parent_dataset_->batch_size_;
+
+  llvm::SmallVector<AsyncValueRef<bool>, 4> eofs;
+  llvm::SmallVector<llvm::SmallVector<RCReference<AsyncValue>, 4>, 4>
+      slot_arguments;
+  eofs.reserve(batch_size);
+  slot_arguments.resize(batch_size);
+  for (int64_t i = 0; i < batch_size; ++i) {
+    auto input = input_iterator_->GetNext(exec_ctx);
+    for (auto* value : parent_dataset_->additional_fn_args_.values())
+      slot_arguments[i].push_back(FormRef(value));
+    for (auto& value : input.values)
+      slot_arguments[i].push_back(std::move(value));
+    eofs.push_back(std::move(input.eof));
+  }
+
+  llvm::SmallVector<IterationResult, 4> results;
+  results.reserve(batch_size);
+  int64_t num_tasks =
+      std::min(parent_dataset_->num_parallel_calls_, batch_size);
+  if (num_tasks <= 1) {
+    for (int64_t i = 0; i < batch_size; ++i) {
+      results.push_back(IterationResult::Pending(
+          RunFunctionWhenReady(map_fn, std::move(slot_arguments[i]), exec_ctx,
+                               stage_),
+          std::move(eofs[i])));
+    }
+    return results;
+  }
+
+  // Split the slots into num_tasks contiguous chunks of nearly equal size.
+  for (int64_t task = 0; task < num_tasks; ++task) {
+    int64_t begin = task * batch_size / num_tasks;
+    int64_t end = (task + 1) * batch_size / num_tasks;
+    llvm::SmallVector<llvm::SmallVector<RCReference<AsyncValue>, 4>, 4>
+        task_arguments;
+    for (int64_t i = begin; i < end; ++i)
+      task_arguments.push_back(std::move(slot_arguments[i]));
+    auto task_results = EnqueueFunctionsWhenReady(
+        map_fn, std::move(task_arguments), exec_ctx, stage_);
+    for (int64_t i = begin; i < end; ++i) {
+      results.push_back(IterationResult::Pending(
+          std::move(task_results[i - begin]), std::move(eofs[i])));
+    }
+  }
+  return results;
+}
+
+template <typename... T>
+IterationResult MapAndBatchDatasetIterator<T...>::GetNext(
+    const ExecutionContext& exec_ctx) {
+  HostContext* host = exec_ctx.host();
+  auto inputs = MapInputs(exec_ctx);
+
+  llvm::SmallVector<AsyncValueRef<TensorMetadata>, 4> metadata;
+  if (parent_dataset_->same_input_metadata_) {
+    if (!is_initialized_) {
+      input_metadata_ = GetInputMetadata<T...>(inputs[0].values, host);
+      is_initialized_ = true;
+    }
+    metadata.reserve(input_metadata_.size());
+    for (const auto& m : input_metadata_) {
+      metadata.push_back(m.CopyRef());
+    }
+  } else {
+    metadata = GetInputMetadata<T...>(inputs[0].values, host);
+  }
+
+  auto temp_batched_values =
+      AllocateOutputTensors(metadata, inputs.size(), exec_ctx);
+
+  llvm::SmallVector<RCReference<AsyncValue>, 4> result_values;
+  result_values.reserve(sizeof...(T));
+  for (size_t i = 0; i < sizeof...(T); ++i) {
+    result_values.push_back(MakeUnconstructedAsyncValueRef<DenseHostTensor>());
+  }
+  // result's eof should be exactly the same as the eof of the first input.
+  auto result = IterationResult::Pending(std::move(result_values),
+                                         inputs[0].eof.CopyRef());
+  CopyToBatch<T...>(std::move(inputs), std::move(metadata),
+                    std::move(temp_batched_values), result.CopyRef(), exec_ctx);
+  return result;
+}
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_DATA_MAP_AND_BATCH_DATASET_H_
@@ -19,13 +19,16 @@
 
 #include "map_dataset.h"
 
+#include <algorithm>
+
 namespace tfrt {
 namespace data {
 
 //===----------------------------------------------------------------------===//
 // MapDataset methods
 //===----------------------------------------------------------------------===//
-RCReference<Iterator> MapDataset::MakeIterator(const IteratorContext& context) {
+RCReference<Iterator> MapDataset::MakeIteratorInternal(
+    const IteratorContext& context) {
   return TakeRef(host_->Construct<MapDatasetIterator>(FormRef(this), context));
 }
 
@@ -33,6 +36,33 @@ RCReference<Iterator> MapDataset::MakeIterator(const IteratorContext& context) {
 // MapDatasetIterator methods
 //===----------------------------------------------------------------------===//
 IterationResult MapDatasetIterator::GetNext(const ExecutionContext& exec_ctx) {
+  int64_t num_parallel_calls = parent_dataset_->num_parallel_calls_;
+  if (num_parallel_calls_) {
+    num_parallel_calls = num_parallel_calls_->value();
+  } else if (num_parallel_calls <= 1) {
+    return MapNext(exec_ctx, /*enqueue=*/false);
+  }
+
+  while (buffer_.size() < num_parallel_calls) {
+    buffer_.push_back(MapNext(exec_ctx, /*enqueue=*/true));
+  }
+
+  auto it = buffer_.begin();
+  if (!parent_dataset_->is_deterministic_) {
+    // Return the first invocation that has finished, if any.
+    auto available = std::find_if(buffer_.begin(), buffer_.end(),
+                                  internal::AvailableAndNotEof);
+    if (available != buffer_.end()) it = available;
+  }
+
+  auto result = std::move(*it);
+  buffer_.erase(it);
+  if (num_parallel_calls_) num_parallel_calls_->RecordGetNext(result.eof);
+  return result;
+}
+
+IterationResult MapDatasetIterator::MapNext(const ExecutionContext& exec_ctx,
+                                            bool enqueue) {
   auto input = input_iterator_->GetNext(exec_ctx);
   const Function* map_fn = parent_dataset_->map_fn_.get();
 
@@ -45,7 +75,10 @@ IterationResult MapDatasetIterator::GetNext(const ExecutionContext& exec_ctx) {
   for (auto* value : parent_dataset_->additional_fn_args_.values())
     arguments.push_back(FormRef(value));
   for (auto& value : values) arguments.push_back(std::move(value));
-  auto result = RunFunctionWhenReady(map_fn, std::move(arguments), exec_ctx);
+  auto result = enqueue ? EnqueueFunctionWhenReady(map_fn, std::move(arguments),
+                                                   exec_ctx, stage_)
+                        : RunFunctionWhenReady(map_fn, std::move(arguments),
+                                               exec_ctx, stage_);
   return IterationResult::Pending(std::move(result), std::move(eof));
 }
 
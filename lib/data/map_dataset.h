@@ -20,6 +20,9 @@
 #ifndef TFRT_LIB_DATA_MAP_DATASET_H_
 #define TFRT_LIB_DATA_MAP_DATASET_H_
 
+#include <algorithm>
+#include <list>
+
 #include "tfrt/data/dataset.h"
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/function.h"
@@ -32,27 +35,39 @@ class MapDatasetIterator;
 
 // MapDataset maps a user-defined function over the elements in its input
 // dataset.
+//
+// If `num_parallel_calls` is larger than 1, the iterator keeps that many
+// invocations of the function in flight, each running on the work queue. If it
+// is kAutotune, the number of invocations is autotuned up to the number of
+// worker threads.
 class MapDataset : public Dataset {
  public:
   explicit MapDataset(RCReference<Dataset> input_dataset,
                       RCArray<AsyncValue> additional_fn_args,
-                      RCReference<const Function> map_fn, HostContext* host)
+                      RCReference<const Function> map_fn,
+                      int64_t num_parallel_calls, bool is_deterministic,
+                      HostContext* host)
       : input_dataset_(std::move(input_dataset)),
         host_(host),
         allocator_(host->allocator()),
         additional_fn_args_(std::move(additional_fn_args)),
-        map_fn_(std::move(map_fn)) {}
+        map_fn_(std::move(map_fn)),
+        num_parallel_calls_(num_parallel_calls),
+        is_deterministic_(is_deterministic) {}
 
   // This class is not copyable or movable.
   MapDataset(const MapDataset&) = delete;
   MapDataset& operator=(const MapDataset&) = delete;
 
-  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+  string_view name() const override { return "map_dataset"; }
 
  private:
   // Allow iterator to rely on private data members of this dataset.
   friend class MapDatasetIterator;
 
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
   void Destroy() override {
     internal::DestroyImpl<MapDataset>(this, allocator_);
   }
@@ -62,6 +77,12 @@ class MapDataset : public Dataset {
   HostAllocator* allocator_;
   RCArray<AsyncValue> additional_fn_args_;
   RCReference<const Function> map_fn_;
+  // The number of parallel invocations, or kAutotune.
+  int64_t num_parallel_calls_;
+  // If this is set to true, the dataset returns values in the order of the
+  // input elements. Otherwise, it might return the values of the invocations
+  // that finished first.
+  bool is_deterministic_;
 };
 
 // If all AsyncValue's in `arguments` are available at the time this method is
@@ -80,10 +101,12 @@ class MapDataset : public Dataset {
 // The function is executed inline without being explicitly enqueued to the
 // threadpool. We expect the function itself to offload expensive operations to
 // the threadpool.
+//
+// If `stage` is not null, the time spent in the function is recorded in it.
 inline llvm::SmallVector<RCReference<AsyncValue>, 4> RunFunctionWhenReady(
     const Function* function,
     llvm::SmallVector<RCReference<AsyncValue>, 4> arguments,
-    const ExecutionContext& exec_ctx) {
+    const ExecutionContext& exec_ctx, RCReference<IteratorStats> stage = {}) {
   auto num_results = function->result_types().size();
   bool is_ready = true;
   llvm::SmallVector<AsyncValue*, 4> argument_ptrs;
@@ -96,6 +119,7 @@ inline llvm::SmallVector<RCReference<AsyncValue>, 4> RunFunctionWhenReady(
   if (is_ready) {
     llvm::SmallVector<RCReference<AsyncValue>, 4> fn_results;
     fn_results.resize(num_results);
+    FunctionTimer timer(stage.get());
     function->Execute(exec_ctx, argument_ptrs, fn_results);
     return fn_results;
   }
@@ -111,11 +135,14 @@ inline llvm::SmallVector<RCReference<AsyncValue>, 4> RunFunctionWhenReady(
 
   RunWhenReady(argument_ptrs, [function, arguments = std::move(arguments),
                                results = std::move(results), argument_ptrs,
-                               exec_ctx]() mutable {
+                               exec_ctx, stage = std::move(stage)]() mutable {
     auto num_results = function->result_types().size();
     llvm::SmallVector<RCReference<AsyncValue>, 4> fn_results;
     fn_results.resize(num_results);
-    function->Execute(exec_ctx, argument_ptrs, fn_results);
+    {
+      FunctionTimer timer(stage.get());
+      function->Execute(exec_ctx, argument_ptrs, fn_results);
+    }
     for (size_t i = 0; i < num_results; ++i) {
       results[i]->ForwardTo(std::move(fn_results[i]));
     }
@@ -124,6 +151,50 @@ inline llvm::SmallVector<RCReference<AsyncValue>, 4> RunFunctionWhenReady(
   return results_copy;
 }
 
+// Similar to RunFunctionWhenReady(), but the function is always executed on
+// the work queue, so that multiple invocations can run in parallel.
+inline llvm::SmallVector<RCReference<AsyncValue>, 4> EnqueueFunctionWhenReady(
+    const Function* function,
+    llvm::SmallVector<RCReference<AsyncValue>, 4> arguments,
+    const ExecutionContext& exec_ctx, RCReference<IteratorStats> stage = {}) {
+  auto num_results = function->result_types().size();
+  llvm::SmallVector<AsyncValue*, 4> argument_ptrs;
+  for (const auto& argument : arguments)
+    argument_ptrs.push_back(argument.get());
+
+  llvm::SmallVector<RCReference<IndirectAsyncValue>, 4> results;
+  llvm::SmallVector<RCReference<AsyncValue>, 4> results_copy;
+  results.resize(num_results);
+  results_copy.resize(num_results);
+  for (size_t i = 0; i < num_results; ++i) {
+    results[i] = MakeIndirectAsyncValue();
+    results_copy[i] = results[i];
+  }
+
+  auto execute = [function, arguments = std::move(arguments),
+                  results = std::move(results), exec_ctx,
+                  stage = std::move(stage)]() {
+    llvm::SmallVector<AsyncValue*, 4> argument_ptrs;
+    for (const auto& argument : arguments)
+      argument_ptrs.push_back(argument.get());
+    llvm::SmallVector<RCReference<AsyncValue>, 4> fn_results;
+    fn_results.resize(results.size());
+    {
+      FunctionTimer timer(stage.get());
+      function->Execute(exec_ctx, argument_ptrs, fn_results);
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+      results[i]->ForwardTo(std::move(fn_results[i]));
+    }
+  };
+  RunWhenReady(argument_ptrs,
+               [exec_ctx, execute = std::move(execute)]() mutable {
+                 EnqueueWork(exec_ctx, std::move(execute));
+               });
+
+  return results_copy;
+}
+
 class MapDatasetIterator : public Iterator {
  public:
   explicit MapDatasetIterator(RCReference<MapDataset> parent_dataset,
@@ -131,7 +202,15 @@ class MapDatasetIterator : public Iterator {
       : Iterator(),
         parent_dataset_(std::move(parent_dataset)),
         input_iterator_(
-            parent_dataset_->input_dataset_->MakeIterator(context)) {}
+            parent_dataset_->input_dataset_->MakeIterator(context)),
+        stage_(context.stage) {
+    if (parent_dataset_->num_parallel_calls_ == kAutotune) {
+      int64_t max_calls =
+          std::max(parent_dataset_->host_->GetNumWorkerThreads(), 1);
+      num_parallel_calls_ = context.autotuner->MakeParameter(
+          /*initial_value=*/1, /*min_value=*/1, max_calls);
+    }
+  }
 
   IterationResult GetNext(const ExecutionContext& exec_ctx) override;
 
@@ -145,8 +224,19 @@ class MapDatasetIterator : public Iterator {
                                               parent_dataset_->allocator_);
   }
 
+  // Returns the result of mapping the function over the next input element.
+  // The function runs on the work queue if `enqueue` is true.
+  IterationResult MapNext(const ExecutionContext& exec_ctx, bool enqueue);
+
   RCReference<MapDataset> parent_dataset_;
   RCReference<Iterator> input_iterator_;
+  // Null unless the pipeline records statistics.
+  RCReference<IteratorStats> stage_;
+  // Null unless the number of parallel invocations is autotuned.
+  RCReference<TunableParameter> num_parallel_calls_;
+  // Results of the in-flight invocations, in the order of the input elements.
+  // Only used if num_parallel_calls is larger than 1 or autotuned.
+  std::list<IterationResult> buffer_;
 };
 
 }  // namespace data
@@ -78,11 +78,14 @@ class MemoryDataset : public Dataset {
   MemoryDataset(const MemoryDataset&) = delete;
   MemoryDataset& operator=(const MemoryDataset&) = delete;
 
-  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+  string_view name() const override { return "memory_dataset"; }
 
  private:
   friend class MemoryDatasetIterator<T...>;
 
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
   void Destroy() override {
     internal::DestroyImpl<MemoryDataset<T...>>(this, allocator_);
   }
@@ -158,7 +161,7 @@ class MemoryDatasetIterator : public Iterator {
 };
 
 template <typename... T>
-RCReference<Iterator> MemoryDataset<T...>::MakeIterator(
+RCReference<Iterator> MemoryDataset<T...>::MakeIteratorInternal(
     const IteratorContext& context) {
   return TakeRef(
       host_->Construct<MemoryDatasetIterator<T...>>(FormRef(this), context));
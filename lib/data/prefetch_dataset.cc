@@ -25,7 +25,7 @@ namespace data {
 //===----------------------------------------------------------------------===//
 // PrefetchDataset methods
 //===----------------------------------------------------------------------===//
-RCReference<Iterator> PrefetchDataset::MakeIterator(
+RCReference<Iterator> PrefetchDataset::MakeIteratorInternal(
     const IteratorContext& context) {
   if (is_deterministic_)
     return TakeRef(
@@ -39,11 +39,13 @@ RCReference<Iterator> PrefetchDataset::MakeIterator(
 //===----------------------------------------------------------------------===//
 IterationResult PrefetchDatasetIterator::GetNext(
     const ExecutionContext& exec_ctx) {
-  while (buffer_.size() < parent_dataset_->prefetch_num_ + 1) {
+  while (buffer_.size() < parent_dataset_->PrefetchNum(prefetch_num_) + 1) {
     buffer_.push(input_iterator_->GetNext(exec_ctx));
   }
+  if (stage_) stage_->RecordBufferSize(buffer_.size());
   auto result = std::move(buffer_.front());
   buffer_.pop();
+  if (prefetch_num_) prefetch_num_->RecordGetNext(result.eof);
   return result;
 }
 
@@ -51,30 +53,24 @@ IterationResult PrefetchDatasetIterator::GetNext(
 // NonDeterministicPrefetchDatasetIterator methods
 //===----------------------------------------------------------------------===//
 
-static bool AvailableAndNotEof(const IterationResult& result) {
-  if (result.eof.IsConcrete() && result.eof.get()) return false;
-  if (!result.eof.IsAvailable()) return false;
-  for (auto& value : result.values) {
-    if (!value->IsAvailable()) return false;
-  }
-  return true;
-}
-
 IterationResult NonDeterministicPrefetchDatasetIterator::GetNext(
     const ExecutionContext& exec_ctx) {
-  while (buffer_.size() < parent_dataset_->prefetch_num_ + 1) {
+  while (buffer_.size() < parent_dataset_->PrefetchNum(prefetch_num_) + 1) {
     buffer_.push_back(input_iterator_->GetNext(exec_ctx));
   }
+  if (stage_) stage_->RecordBufferSize(buffer_.size());
   for (auto it = buffer_.begin(), e = buffer_.end(); it != e; ++it) {
-    if (AvailableAndNotEof(*it)) {
+    if (internal::AvailableAndNotEof(*it)) {
       auto value = std::move(*it);
       buffer_.erase(it);
+      if (prefetch_num_) prefetch_num_->RecordGetNext(value.eof);
       return value;
     }
   }
 
   auto result = std::move(buffer_.front());
   buffer_.pop_front();
+  if (prefetch_num_) prefetch_num_->RecordGetNext(result.eof);
   return result;
 }
 
@@ -21,6 +21,7 @@
 #ifndef TFRT_LIB_DATA_PREFETCH_DATASET_H_
 #define TFRT_LIB_DATA_PREFETCH_DATASET_H_
 
+#include <limits>
 #include <list>
 #include <queue>
 
@@ -48,18 +49,36 @@ class PrefetchDataset : public Dataset {
   PrefetchDataset(const PrefetchDataset&) = delete;
   PrefetchDataset& operator=(const PrefetchDataset&) = delete;
 
-  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+  string_view name() const override { return "prefetch_dataset"; }
 
  private:
   // Allow iterator to rely on private data members of this dataset.
   friend class PrefetchDatasetIterator;
   friend class NonDeterministicPrefetchDatasetIterator;
 
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
   void Destroy() override {
     internal::DestroyImpl<PrefetchDataset>(this, host_->allocator());
   }
 
+  // Returns the tunable prefetch depth for an iterator if prefetch_num_ is
+  // kAutotune, or null otherwise.
+  RCReference<TunableParameter> MakePrefetchNumParameter(
+      const IteratorContext& context) const {
+    if (prefetch_num_ != kAutotune) return {};
+    return context.autotuner->MakeParameter(
+        /*initial_value=*/1, /*min_value=*/0,
+        /*max_value=*/std::numeric_limits<int64_t>::max());
+  }
+
+  int64_t PrefetchNum(const RCReference<TunableParameter>& parameter) const {
+    return parameter ? parameter->value() : prefetch_num_;
+  }
+
   RCReference<Dataset> input_dataset_;
+  // The number of elements to prefetch, or kAutotune.
   int64_t prefetch_num_;
   // If this is set to true, the dataset returns values in a deterministic
   // order. Otherwise, it might return values in a non-deterministic as long as
@@ -75,8 +94,9 @@ class PrefetchDatasetIterator : public Iterator {
                                    const IteratorContext& context)
       : Iterator(),
         parent_dataset_(std::move(parent_dataset)),
-        input_iterator_(
-            parent_dataset_->input_dataset_->MakeIterator(context)) {}
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+        prefetch_num_(parent_dataset_->MakePrefetchNumParameter(context)),
+        stage_(context.stage) {}
 
   // This class is not copyable or movable.
   PrefetchDatasetIterator(const PrefetchDatasetIterator&) = delete;
@@ -92,6 +112,10 @@ class PrefetchDatasetIterator : public Iterator {
 
   RCReference<PrefetchDataset> parent_dataset_;
   RCReference<Iterator> input_iterator_;
+  // Null unless the prefetch depth is autotuned.
+  RCReference<TunableParameter> prefetch_num_;
+  // Null unless the pipeline records statistics.
+  RCReference<IteratorStats> stage_;
   std::queue<IterationResult> buffer_;
 };
 
@@ -103,8 +127,9 @@ class NonDeterministicPrefetchDatasetIterator : public Iterator {
       const IteratorContext& context)
       : Iterator(),
         parent_dataset_(std::move(parent_dataset)),
-        input_iterator_(
-            parent_dataset_->input_dataset_->MakeIterator(context)) {}
+        input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+        prefetch_num_(parent_dataset_->MakePrefetchNumParameter(context)),
+        stage_(context.stage) {}
 
   // This class is not copyable or movable.
   NonDeterministicPrefetchDatasetIterator(const PrefetchDatasetIterator&) =
@@ -122,6 +147,10 @@ class NonDeterministicPrefetchDatasetIterator : public Iterator {
 
   RCReference<PrefetchDataset> parent_dataset_;
   RCReference<Iterator> input_iterator_;
+  // Null unless the prefetch depth is autotuned.
+  RCReference<TunableParameter> prefetch_num_;
+  // Null unless the pipeline records statistics.
+  RCReference<IteratorStats> stage_;
   std::list<IterationResult> buffer_;
 };
 
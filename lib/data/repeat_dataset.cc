@@ -27,7 +27,7 @@ namespace data {
 //===----------------------------------------------------------------------===//
 // RepeatDataset methods
 //===----------------------------------------------------------------------===//
-RCReference<Iterator> RepeatDataset::MakeIterator(
+RCReference<Iterator> RepeatDataset::MakeIteratorInternal(
     const IteratorContext& context) {
   return TakeRef(
       host_->Construct<RepeatDatasetIterator>(FormRef(this), context));
@@ -46,11 +46,14 @@ class RepeatDataset : public Dataset {
   RepeatDataset(const RepeatDataset&) = delete;
   RepeatDataset& operator=(const RepeatDataset&) = delete;
 
-  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+  string_view name() const override { return "repeat_dataset"; }
 
  private:
   friend class RepeatDatasetIterator;
 
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
   void Destroy() override {
     internal::DestroyImpl<RepeatDataset>(this, allocator_);
   }
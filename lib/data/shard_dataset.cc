@@ -0,0 +1,60 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file implements ShardDataset class which wraps around another Dataset
+// instance and returns one of its disjoint shards.
+
+#include "shard_dataset.h"
+
+namespace tfrt {
+namespace data {
+
+//===----------------------------------------------------------------------===//
+// ShardDataset methods
+//===----------------------------------------------------------------------===//
+RCReference<Iterator> ShardDataset::MakeIteratorInternal(
+    const IteratorContext& context) {
+  return TakeRef(
+      host_->Construct<ShardDatasetIterator>(FormRef(this), context));
+}
+
+//===----------------------------------------------------------------------===//
+// ShardDatasetIterator methods
+//===----------------------------------------------------------------------===//
+IterationResult ShardDatasetIterator::GetNext(
+    const ExecutionContext& exec_ctx) {
+  int64_t num_skipped =
+      is_first_ ? parent_dataset_->index_ : parent_dataset_->num_shards_ - 1;
+  is_first_ = false;
+  for (int64_t i = 0; i < num_skipped; ++i) {
+    // Skip the values of the other shards. The IterationResult returned to the
+    // caller will provide the correct EOF information.
+    input_iterator_->GetNext(exec_ctx);
+  }
+  return input_iterator_->GetNext(exec_ctx);
+}
+
+RCReference<Dataset> MakeShard(RCReference<Dataset> input_dataset,
+                               int64_t num_shards, int64_t index,
+                               HostContext* host) {
+  if (num_shards == 1) return input_dataset;
+  if (auto shard = input_dataset->MakeShard(num_shards, index)) return shard;
+  return TakeRef(host->Construct<ShardDataset>(std::move(input_dataset),
+                                               num_shards, index, host));
+}
+
+}  // namespace data
+}  // namespace tfrt
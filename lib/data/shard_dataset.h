@@ -0,0 +1,110 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares ShardDataset class which wraps around another Dataset
+// instance and returns one of its disjoint shards.
+
+#ifndef TFRT_DATA_SHARD_DATASET_H_
+#define TFRT_DATA_SHARD_DATASET_H_
+
+#include "tfrt/data/dataset.h"
+
+namespace tfrt {
+namespace data {
+
+class ShardDatasetIterator;
+
+// ShardDataset wraps around another Dataset instance and returns every
+// `num_shards`-th element of that dataset, starting at the element `index`.
+// Distributed trainers can use it so that each worker, with a distinct
+// `index`, reads its own part of the data.
+//
+// The elements of the other shards are still read from the input dataset and
+// dropped. Prefer MakeShard(), which shards datasets that support it,
+// e.g. multi-file TFRecordDataset, at file granularity instead.
+class ShardDataset : public Dataset {
+ public:
+  explicit ShardDataset(RCReference<Dataset> input_dataset, int64_t num_shards,
+                        int64_t index, HostContext* host)
+      : input_dataset_(std::move(input_dataset)),
+        num_shards_(num_shards),
+        index_(index),
+        host_(host),
+        allocator_(host->allocator()) {
+    assert(index_ >= 0 && index_ < num_shards_);
+  }
+
+  // This class is not copyable or movable.
+  ShardDataset(const ShardDataset&) = delete;
+  ShardDataset& operator=(const ShardDataset&) = delete;
+
+  string_view name() const override { return "shard_dataset"; }
+
+ private:
+  friend class ShardDatasetIterator;
+
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
+  void Destroy() override {
+    internal::DestroyImpl<ShardDataset>(this, allocator_);
+  }
+
+  RCReference<Dataset> input_dataset_;
+  int64_t num_shards_;
+  int64_t index_;
+  HostContext* host_;
+  HostAllocator* allocator_;
+};
+
+class ShardDatasetIterator : public Iterator {
+ public:
+  explicit ShardDatasetIterator(RCReference<ShardDataset> dataset,
+                                const IteratorContext& context)
+      : Iterator(),
+        parent_dataset_(std::move(dataset)),
+        input_iterator_(
+            parent_dataset_->input_dataset_->MakeIterator(context)) {}
+
+  // This class is not copyable or movable.
+  ShardDatasetIterator(const ShardDatasetIterator&) = delete;
+  ShardDatasetIterator& operator=(const ShardDatasetIterator&) = delete;
+
+  IterationResult GetNext(const ExecutionContext& exec_ctx) override;
+
+ private:
+  void Destroy() override {
+    internal::DestroyImpl<ShardDatasetIterator>(this,
+                                                parent_dataset_->allocator_);
+  }
+
+  RCReference<ShardDataset> parent_dataset_;
+  RCReference<Iterator> input_iterator_;
+  // The elements before `index` are only skipped by the first GetNext() call.
+  bool is_first_ = true;
+};
+
+// Returns the `index`-th of `num_shards` shards of `input_dataset`, which is
+// split at the coarsest granularity that the dataset supports, e.g. files,
+// and otherwise at element granularity by a ShardDataset.
+RCReference<Dataset> MakeShard(RCReference<Dataset> input_dataset,
+                               int64_t num_shards, int64_t index,
+                               HostContext* host);
+
+}  // namespace data
+}  // namespace tfrt
+
+#endif  // TFRT_DATA_SHARD_DATASET_H_
@@ -18,6 +18,8 @@
 
 #include "shuffle_dataset.h"
 
+#include <utility>
+
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/support/philox_random.h"
 
@@ -27,7 +29,7 @@ namespace data {
 //===----------------------------------------------------------------------===//
 // ShuffleDataset methods
 //===----------------------------------------------------------------------===//
-RCReference<Iterator> ShuffleDataset::MakeIterator(
+RCReference<Iterator> ShuffleDataset::MakeIteratorInternal(
     const IteratorContext& context) {
   return TakeRef(
       host_->Construct<ShuffleDatasetIterator>(FormRef(this), context));
@@ -36,66 +38,67 @@ RCReference<Iterator> ShuffleDataset::MakeIterator(
 //===----------------------------------------------------------------------===//
 // ShuffleDatasetIterator methods
 //===----------------------------------------------------------------------===//
+ShuffleDatasetIterator::~ShuffleDatasetIterator() {
+  auto* node = pending_outputs_.load(std::memory_order_acquire);
+  while (node != nullptr) {
+    delete std::exchange(node, node->next);
+  }
+}
+
 IterationResult ShuffleDatasetIterator::GetNext(
     const ExecutionContext& exec_ctx) {
   // Initialize arity_ using the first value from the input_iterator_.
-  if (arity_ < 0) {
+  int arity = arity_.load(std::memory_order_acquire);
+  if (arity < 0) {
     mutex_lock lock(mu_);
-    assert(!token_owned_);
-    auto input = input_iterator_->GetNext(exec_ctx);
-    arity_ = input.values.size();
-    shuffle_buffer_.push_back(std::move(input));
-    num_shuffled_values_++;
+    arity = arity_.load(std::memory_order_relaxed);
+    if (arity < 0) {
+      assert(num_pending_outputs_.load(std::memory_order_relaxed) == 0);
+      auto input = input_iterator_->GetNext(exec_ctx);
+      arity = input.values.size();
+      shuffle_buffer_.push_back(std::move(input));
+      num_shuffled_values_++;
+      arity_.store(arity, std::memory_order_release);
+    }
   }
 
   llvm::SmallVector<RCReference<AsyncValue>, 4> result_values;
-  result_values.resize(arity_);
-  for (size_t i = 0; i < arity_; ++i) {
+  result_values.resize(arity);
+  for (size_t i = 0; i < arity; ++i) {
     result_values[i] = MakeIndirectAsyncValue();
   }
   auto result_eof = MakeUnconstructedAsyncValueRef<bool>();
   auto result =
       IterationResult::Pending(std::move(result_values), std::move(result_eof));
-  {
-    mutex_lock lock(mu_);
-    output_buffer_.push(result.CopyRef());
+
+  auto* node = new OutputNode{result.CopyRef(),
+                              pending_outputs_.load(std::memory_order_relaxed)};
+  while (!pending_outputs_.compare_exchange_weak(node->next, node,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
   }
 
-  MaybeScheduleBackgroundTask(exec_ctx, false, 0);
+  // Take the token if no other thread owns it.
+  if (num_pending_outputs_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+    FillOutputs(exec_ctx, 0);
+  }
   return result;
 }
 
-void ShuffleDatasetIterator::MaybeScheduleBackgroundTask(
-    const ExecutionContext& exec_ctx, bool is_token_owner, int callback_count) {
-  {
-    mutex_lock lock(mu_);
-    // There is no more output value to update. Release the token if the caller
-    // owns the token and then return.
-    if (output_buffer_.empty()) {
-      if (is_token_owner) {
-        token_owned_ = false;
-      }
-      return;
-    }
-    // Return since the token is already owned by another thread.
-    if (!is_token_owner && token_owned_) return;
-    // Take the token if the thread does not already own the token.
-    token_owned_ = true;
-    is_token_owner = true;
-  }
-
+void ShuffleDatasetIterator::FillOutputs(const ExecutionContext& exec_ctx,
+                                         int callback_count) {
   // Only the thread that owns the token can execute the code below. This
   // ensures in-order delivery since at most one thread can take value from the
-  // input_iterator_ and update the output value in the output_buffer_.
+  // input_iterator_ and update the output values.
   auto host = exec_ctx.host();
   auto callback = [exec_ctx, callback_count,
                    iterator = FormRef(this)]() mutable {
     if (callback_count >= MAX_RECURSIVE_CALLS) {
       EnqueueWork(exec_ctx, [exec_ctx, iterator = std::move(iterator)] {
-        iterator->MaybeScheduleBackgroundTask(exec_ctx, true, 0);
+        iterator->FillOutputs(exec_ctx, 0);
       });
     } else {
-      iterator->MaybeScheduleBackgroundTask(exec_ctx, true, callback_count + 1);
+      iterator->FillOutputs(exec_ctx, callback_count + 1);
     }
   };
 
@@ -104,7 +107,7 @@ void ShuffleDatasetIterator::MaybeScheduleBackgroundTask(
   // input iterator has reached end.
   CheckEof();
 
-  while (OutputBufferSize() > 0) {
+  do {
     // Fills shuffle_buffer_ with up to buffer_size_ values. It can have less
     // than buffer_size_ values only if the input_iterator_ has reached end.
     while (num_shuffled_values_ < max_buffer_size && !reached_eof_) {
@@ -118,12 +121,14 @@ void ShuffleDatasetIterator::MaybeScheduleBackgroundTask(
         shuffle_buffer_.push_back(std::move(input));
       }
       if (eof_async->IsUnavailable()) {
+        // Keep the token until the callback fills the remaining outputs.
         eof_async->AndThen(std::move(callback));
         return;
       }
       CheckEof();
     }
 
+    if (stage_) stage_->RecordBufferSize(num_shuffled_values_);
     if (num_shuffled_values_ > 0) {
       auto random_index =
           (random_() % num_shuffled_values_ + start_index_) % max_buffer_size;
@@ -137,16 +142,16 @@ void ShuffleDatasetIterator::MaybeScheduleBackgroundTask(
       auto input = IterationResult::Eof(host, arity_);
       HandleEofAvailableInput(std::move(input), host);
     }
-  }
-  MaybeScheduleBackgroundTask(exec_ctx, true, callback_count);
+    // Release the token if there is no more output value to fill.
+  } while (num_pending_outputs_.fetch_sub(1, std::memory_order_acq_rel) > 1);
 }
 
 void ShuffleDatasetIterator::HandleEofAvailableInput(IterationResult input,
                                                      HostContext* host) {
   auto input_eof = std::move(input.eof);
   auto input_values = std::move(input.values);
+  auto output = DequeueOutputBuffer();
   if (input_eof.IsError() || !input_eof.get()) {
-    auto output = DequeueOutputBuffer();
     for (int i = 0; i < arity_; ++i) {
       auto* output_value = cast<IndirectAsyncValue>(output.values[i].get());
       output_value->ForwardTo(std::move(input_values[i]));
@@ -160,14 +165,34 @@ void ShuffleDatasetIterator::HandleEofAvailableInput(IterationResult input,
   }
   // The input_iterator_ has been exhausted and there is no remaining count.
   auto error = MakeErrorAsyncValueRef("iterator reached end");
-  auto output_buffer_size = OutputBufferSize();
-  for (; output_buffer_size > 0; --output_buffer_size) {
-    auto output = DequeueOutputBuffer();
-    for (auto& value : output.values) {
-      value->SetError(error->GetError());
+  for (auto& value : output.values) {
+    value->SetError(error->GetError());
+  }
+  output.eof.emplace(true);
+}
+
+IterationResult ShuffleDatasetIterator::DequeueOutputBuffer() {
+  if (output_buffer_.empty()) {
+    // GetNext() pushes an output before it increments num_pending_outputs_, so
+    // pending_outputs_ is not empty.
+    auto* node = pending_outputs_.exchange(nullptr, std::memory_order_acquire);
+    assert(node != nullptr);
+    // Reverse the list to dequeue outputs in the order they were returned.
+    OutputNode* reversed = nullptr;
+    while (node != nullptr) {
+      auto* next = node->next;
+      node->next = reversed;
+      reversed = node;
+      node = next;
+    }
+    while (reversed != nullptr) {
+      output_buffer_.push(std::move(reversed->output));
+      delete std::exchange(reversed, reversed->next);
     }
-    output.eof.emplace(true);
   }
+  auto value = std::move(output_buffer_.front());
+  output_buffer_.pop();
+  return value;
 }
 
 inline void ShuffleDatasetIterator::CheckEof() {
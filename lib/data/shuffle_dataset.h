@@ -20,10 +20,12 @@
 #ifndef TFRT_DATA_SHUFFLE_DATASET_H_
 #define TFRT_DATA_SHUFFLE_DATASET_H_
 
+#include <atomic>
+#include <queue>
+
 #include "tfrt/data/dataset.h"
 #include "tfrt/support/mutex.h"
 #include "tfrt/support/philox_random.h"
-#include "tfrt/support/thread_annotations.h"
 
 namespace tfrt {
 namespace data {
@@ -31,7 +33,8 @@ namespace data {
 class ShuffleDatasetIterator;
 
 // ShuffleDataset wraps around another Dataset instance and shuffles its values
-// before outputting those values.
+// before outputting those values. For a given seed, the sequence of output
+// values is deterministic in the order in which GetNext() calls return.
 class ShuffleDataset : public Dataset {
  public:
   explicit ShuffleDataset(RCReference<Dataset> input_dataset,
@@ -50,11 +53,14 @@ class ShuffleDataset : public Dataset {
   ShuffleDataset(const ShuffleDataset&) = delete;
   ShuffleDataset& operator=(const ShuffleDataset&) = delete;
 
-  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+  string_view name() const override { return "shuffle_dataset"; }
 
  private:
   friend class ShuffleDatasetIterator;
 
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
   void Destroy() override {
     internal::DestroyImpl<ShuffleDataset>(this, allocator_);
   }
@@ -74,8 +80,11 @@ class ShuffleDatasetIterator : public Iterator {
       : Iterator(),
         parent_dataset_(std::move(dataset)),
         input_iterator_(parent_dataset_->input_dataset_->MakeIterator(context)),
+        stage_(context.stage),
         random_(parent_dataset_->seed_, parent_dataset_->seed2_) {}
 
+  ~ShuffleDatasetIterator() override;
+
   // This class is not copyable or movable.
   ShuffleDatasetIterator(const ShuffleDatasetIterator&) = delete;
   ShuffleDatasetIterator& operator=(const ShuffleDatasetIterator&) = delete;
@@ -88,28 +97,24 @@ class ShuffleDatasetIterator : public Iterator {
                                                   parent_dataset_->allocator_);
   }
 
-  // This method ensures that the control flow (e.g. get value from the
-  // input_iterator_) is only executed by the thread that holds the token. It
-  // helps ensure in-order delivery while still allowing an unblocking
-  // GetNext(...) API.
-  void MaybeScheduleBackgroundTask(const ExecutionContext& exec_ctx,
-                                   bool is_token_owner, int callback_count)
-      TFRT_EXCLUDES(mu_);
+  // A node of the lock-free list of outputs returned by GetNext().
+  struct OutputNode {
+    IterationResult output;
+    OutputNode* next;
+  };
 
-  void HandleEofAvailableInput(IterationResult input, HostContext* host);
+  // Fills the outputs returned by GetNext() until there is no pending output.
+  // This method must only be called by the thread that holds the token, which
+  // ensures in-order delivery while still allowing an unblocking GetNext(...)
+  // API.
+  void FillOutputs(const ExecutionContext& exec_ctx, int callback_count);
 
-  int OutputBufferSize() TFRT_EXCLUDES(mu_) {
-    mutex_lock lock(mu_);
-    return output_buffer_.size();
-  }
+  // Forwards the eof-available `input` to the next output.
+  void HandleEofAvailableInput(IterationResult input, HostContext* host);
 
-  IterationResult DequeueOutputBuffer() TFRT_EXCLUDES(mu_) {
-    mutex_lock lock(mu_);
-    assert(!output_buffer_.empty());
-    auto value = std::move(output_buffer_.front());
-    output_buffer_.pop();
-    return value;
-  }
+  // Returns the next output returned by GetNext(). There must be at least one
+  // pending output.
+  IterationResult DequeueOutputBuffer();
 
   // If the last non-empty value in the circular buffer `num_shuffled_values_`
   // has reached EOF, remove this value from the circular buffer and set
@@ -118,11 +123,14 @@ class ShuffleDatasetIterator : public Iterator {
 
   RCReference<ShuffleDataset> parent_dataset_;
   RCReference<Iterator> input_iterator_;
+  // Null unless the pipeline records statistics.
+  RCReference<IteratorStats> stage_;
   random::PhiloxRandom random_;
 
+  // Guards the initialization of arity_.
   mutex mu_;
   // The number of values in the IterationResult returned by this iterator.
-  int arity_ = -1;
+  std::atomic<int> arity_{-1};
   // True iff the input_iterator_ has reached EOF.
   bool reached_eof_ = false;
   // A circular buffer of IterationResult from the `input_iterator_`.
@@ -131,19 +139,23 @@ class ShuffleDatasetIterator : public Iterator {
   size_t num_shuffled_values_ = 0;
   // The index of the first value in the circular shuffle_buffer_.
   size_t start_index_ = 0;
-  // A queue of IterationResult that have already been returned to the
-  // GetNext(...) caller.
-  std::queue<IterationResult> output_buffer_ TFRT_GUARDED_BY(mu_);
-
-  // This is a unique logical token for this iterator instance. It effectively
-  // acts as a lock to ensure in-order delivery of results by guaranteeing that
-  // at most one thread can take the next value from the input_iterator_ and
-  // update values in output_buffer_.
+  // A lock-free list of IterationResult that have already been returned to the
+  // GetNext(...) callers, in reverse order. GetNext() pushes to it and the
+  // token owner moves its values to output_buffer_.
+  std::atomic<OutputNode*> pending_outputs_{nullptr};
+  // A queue of IterationResult moved from pending_outputs_, in the order in
+  // which they were returned. Only the token owner can access it.
+  std::queue<IterationResult> output_buffer_;
+
+  // The number of outputs returned by GetNext() that are not filled yet. It
+  // also acts as a unique logical token for this iterator instance, which
+  // ensures in-order delivery of results by guaranteeing that at most one
+  // thread can take the next value from the input_iterator_ and fill outputs.
   //
-  // The thread which changes token_owned from false to true "holds" the token,
-  // and can pass it on to a thread that runs the callback it schedules. The
-  // token is released when token_owned_ is changed from true to false.
-  bool token_owned_ TFRT_GUARDED_BY(mu_) = false;
+  // The GetNext() caller which increments it from 0 "holds" the token, and can
+  // pass it on to a thread that runs the callback it schedules. The token is
+  // released when the token owner decrements it to 0.
+  std::atomic<int64_t> num_pending_outputs_{0};
 };
 
 }  // namespace data
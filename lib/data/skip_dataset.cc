@@ -25,7 +25,7 @@ namespace data {
 //===----------------------------------------------------------------------===//
 // SkipDataset methods
 //===----------------------------------------------------------------------===//
-RCReference<Iterator> SkipDataset::MakeIterator(
+RCReference<Iterator> SkipDataset::MakeIteratorInternal(
     const IteratorContext& context) {
   return TakeRef(host_->Construct<SkipDatasetIterator>(FormRef(this), context));
 }
@@ -42,11 +42,14 @@ class SkipDataset : public Dataset {
   SkipDataset(const SkipDataset&) = delete;
   SkipDataset& operator=(const SkipDataset&) = delete;
 
-  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+  string_view name() const override { return "skip_dataset"; }
 
  private:
   friend class SkipDatasetIterator;
 
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
   void Destroy() override {
     internal::DestroyImpl<SkipDataset>(this, allocator_);
   }
@@ -42,11 +42,14 @@ class SliceDataset : public Dataset {
   SliceDataset(const SliceDataset&) = delete;
   SliceDataset& operator=(const SliceDataset&) = delete;
 
-  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+  string_view name() const override { return "slice_dataset"; }
 
  private:
   friend class SliceDatasetIterator<T>;
 
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
   void Destroy() override {
     internal::DestroyImpl<SliceDataset<T>>(this, allocator_);
   }
@@ -113,7 +116,7 @@ inline IterationResult SliceDatasetIterator<DenseHostTensor>::GetNext(
 }
 
 template <typename T>
-RCReference<Iterator> SliceDataset<T>::MakeIterator(
+RCReference<Iterator> SliceDataset<T>::MakeIteratorInternal(
     const IteratorContext& context) {
   return TakeRef(host_->Construct<SliceDatasetIterator<T>>(
       FormRef(this), data_.begin(), data_.end()));
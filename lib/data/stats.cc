@@ -0,0 +1,177 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the data pipeline statistics.
+
+#include "tfrt/data/stats.h"
+
+#include <algorithm>
+
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/support/logging.h"
+#include "tfrt/support/string_util.h"
+
+namespace tfrt {
+namespace data {
+
+static std::string StagePath(string_view name, IteratorStats* parent) {
+  if (!parent) return name.str();
+  return StrCat(parent->path(), "/", name);
+}
+
+static metrics::Buckets BufferSizeBuckets() {
+  std::vector<double> bounds;
+  for (double bound = 1; bound <= 4096; bound *= 2) bounds.push_back(bound);
+  return metrics::Buckets::Explicit(std::move(bounds));
+}
+
+static double ToMilliseconds(IteratorStats::Duration duration) {
+  return duration.count() / 1e6;
+}
+
+// Returns the time that the consumer of `stage` waited for it minus the time
+// that it waited for its inputs.
+static IteratorStats::Duration SelfWait(const IteratorStats& stage) {
+  return std::max(stage.wait() - stage.input_wait(),
+                  IteratorStats::Duration::zero());
+}
+
+// Prints the stages whose parent is `parent` in creation order, each followed
+// by its children. Updates *slowest to the printed stage with the longest self
+// wait.
+static void PrintStages(ArrayRef<RCReference<IteratorStats>> stages,
+                        const IteratorStats* parent, int depth,
+                        llvm::raw_ostream& os, const IteratorStats** slowest) {
+  for (const auto& stage : stages) {
+    if (stage->parent() != parent) continue;
+    os.indent(2 * depth) << stage->name() << ": " << stage->num_elements()
+                         << " elements, " << stage->bytes() << " bytes";
+    os << ", wait " << llvm::format("%.3f", ToMilliseconds(stage->wait()))
+       << " ms";
+    os << ", input wait "
+       << llvm::format("%.3f", ToMilliseconds(stage->input_wait())) << " ms";
+    if (stage->function_time().count() > 0) {
+      os << ", function "
+         << llvm::format("%.3f", ToMilliseconds(stage->function_time()))
+         << " ms";
+    }
+    if (stage->max_buffer_size() > 0) {
+      os << ", buffer size "
+         << llvm::format("%.1f", stage->average_buffer_size()) << " avg "
+         << stage->max_buffer_size() << " max";
+    }
+    os << "\n";
+    if (!*slowest || SelfWait(*stage) > SelfWait(**slowest)) {
+      *slowest = stage.get();
+    }
+    PrintStages(stages, stage.get(), depth + 1, os, slowest);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// IteratorStats methods
+//===----------------------------------------------------------------------===//
+IteratorStats::IteratorStats(std::string name,
+                             RCReference<IteratorStats> parent,
+                             string_view pipeline_name)
+    : name_(std::move(name)),
+      parent_(std::move(parent)),
+      path_(StagePath(name_, parent_.get())) {
+  auto prefix = StrCat("/tfrt/data/", pipeline_name, "/", path_, "/");
+  elements_metric_ = metrics::NewCounter(StrCat(prefix, "elements"));
+  bytes_metric_ = metrics::NewCounter(StrCat(prefix, "bytes"));
+  wait_metric_ = metrics::NewCounter(StrCat(prefix, "wait_ns"));
+  input_wait_metric_ = metrics::NewCounter(StrCat(prefix, "input_wait_ns"));
+  function_metric_ = metrics::NewCounter(StrCat(prefix, "function_ns"));
+  buffer_size_metric_ =
+      metrics::NewHistogram(StrCat(prefix, "buffer_size"), BufferSizeBuckets());
+}
+
+void IteratorStats::RecordGetNext(Duration wait, bool is_element,
+                                  size_t bytes) {
+  wait_ns_.fetch_add(wait.count(), std::memory_order_relaxed);
+  wait_metric_->IncrementBy(wait.count());
+  // The consumer of this stage is its parent stage.
+  if (parent_) {
+    parent_->input_wait_ns_.fetch_add(wait.count(), std::memory_order_relaxed);
+    parent_->input_wait_metric_->IncrementBy(wait.count());
+  }
+  if (!is_element) return;
+  num_elements_.fetch_add(1, std::memory_order_relaxed);
+  elements_metric_->IncrementBy(1);
+  bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  bytes_metric_->IncrementBy(bytes);
+}
+
+void IteratorStats::RecordFunction(Duration duration) {
+  function_ns_.fetch_add(duration.count(), std::memory_order_relaxed);
+  function_metric_->IncrementBy(duration.count());
+}
+
+void IteratorStats::RecordBufferSize(size_t size) {
+  buffer_size_sum_.fetch_add(size, std::memory_order_relaxed);
+  num_buffer_samples_.fetch_add(1, std::memory_order_relaxed);
+  int64_t max_size = max_buffer_size_.load(std::memory_order_relaxed);
+  while (static_cast<int64_t>(size) > max_size &&
+         !max_buffer_size_.compare_exchange_weak(max_size, size,
+                                                 std::memory_order_relaxed)) {
+  }
+  buffer_size_metric_->Record(size);
+}
+
+double IteratorStats::average_buffer_size() const {
+  int64_t num_samples = num_buffer_samples_.load();
+  if (num_samples == 0) return 0;
+  return static_cast<double>(buffer_size_sum_.load()) / num_samples;
+}
+
+//===----------------------------------------------------------------------===//
+// PipelineStats methods
+//===----------------------------------------------------------------------===//
+PipelineStats::~PipelineStats() {
+  if (log_summary_) TFRT_LOG(INFO) << Summary();
+}
+
+RCReference<IteratorStats> PipelineStats::GetOrCreateStage(
+    string_view name, IteratorStats* parent) {
+  mutex_lock lock(mu_);
+  for (const auto& stage : stages_) {
+    if (stage->parent() == parent && stage->name() == name) return stage;
+  }
+  RCReference<IteratorStats> parent_ref;
+  if (parent) parent_ref = FormRef(parent);
+  stages_.push_back(
+      MakeRef<IteratorStats>(name.str(), std::move(parent_ref), name_));
+  return stages_.back();
+}
+
+std::string PipelineStats::Summary() const {
+  mutex_lock lock(mu_);
+  std::string summary;
+  llvm::raw_string_ostream os(summary);
+  os << "Data pipeline " << name_ << ":\n";
+
+  const IteratorStats* slowest = nullptr;
+  PrintStages(stages_, /*parent=*/nullptr, /*depth=*/1, os, &slowest);
+
+  if (slowest && SelfWait(*slowest).count() > 0) {
+    os << "Slowest stage: " << slowest->path() << " (self wait "
+       << llvm::format("%.3f", ToMilliseconds(SelfWait(*slowest))) << " ms)\n";
+  }
+  return os.str();
+}
+
+}  // namespace data
+}  // namespace tfrt
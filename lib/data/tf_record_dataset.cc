@@ -13,7 +13,7 @@
 // limitations under the License.
 
 // This file implements TFRecordDataset class which reads records from TFRecord
-// files into strings.
+// files into strings, or into slices of the memory-mapped files.
 
 #include "tf_record_dataset.h"
 
@@ -33,39 +33,104 @@ namespace data {
 // Implementation for TFRecordDataset member functions
 //===----------------------------------------------------------------------===//
 
-RCReference<Iterator> TFRecordDataset::MakeIterator(
+RCReference<Iterator> TFRecordDataset::MakeIteratorInternal(
     const IteratorContext& context) {
   return TakeRef(
       host_->Construct<TFRecordDatasetIterator>(FormRef(this), context));
 }
 
+RCReference<Dataset> TFRecordDataset::MakeShard(int64_t num_shards,
+                                                int64_t index) {
+  if (static_cast<int64_t>(paths_.size()) < num_shards) return {};
+  std::vector<std::string> shard_paths;
+  for (size_t i = index; i < paths_.size(); i += num_shards) {
+    shard_paths.push_back(paths_[i]);
+  }
+  return TakeRef(host_->Construct<TFRecordDataset>(
+      std::move(shard_paths), buffer_size_, max_prefetch_num_,
+      prefetch_threshold_, use_mmap_, verify_checksum_, host_));
+}
+
+llvm::Expected<std::vector<std::string>> ExpandFilePattern(
+    const std::string& pattern) {
+  if (pattern.find_first_of("*?[") == std::string::npos) {
+    return std::vector<std::string>{pattern};
+  }
+
+  auto* fs_registry = ::tfrt::io::FileSystemRegistry::Default();
+  auto* file_system = fs_registry->LookupForPath(pattern);
+  if (!file_system) {
+    return MakeStringError("No file system is found for the given scheme");
+  }
+  std::vector<std::string> paths;
+  if (auto error = file_system->GetMatchingPaths(pattern, &paths)) {
+    return std::move(error);
+  }
+  if (paths.empty()) {
+    return MakeStringError("no files match the pattern ", pattern);
+  }
+  return std::move(paths);
+}
+
 //===----------------------------------------------------------------------===//
 // Implementation for TFRecordDatasetIterator member functions
 //===----------------------------------------------------------------------===//
 IterationResult TFRecordDatasetIterator::GetNextElement(
     const ExecutionContext& exec_ctx) {
   HostContext* host = exec_ctx.host();
-  if (auto error = MaybeInitializeStream()) {
-    auto async_error = MakeErrorAsyncValueRef(StrCat(error));
-    return IterationResult::Error(std::move(async_error), 1);
-  }
+  while (file_index_ < parent_dataset_->paths_.size()) {
+    if (auto error = MaybeInitializeStream()) {
+      auto async_error = MakeErrorAsyncValueRef(StrCat(error));
+      return IterationResult::Error(std::move(async_error), 1);
+    }
+
+    bool eof = false;
+    auto result = ReadValue(&eof);
+    if (eof) {
+      NextFile();
+      continue;
+    }
+    if (!result) {
+      // Do not decode location or emit error because the local handler might
+      // have been freed.
+      auto error = MakeErrorAsyncValueRef(StrCat(result.takeError()));
+      return IterationResult::Error(std::move(error), 1);
+    }
 
-  bool eof = false;
-  auto result = ReadRecord(&eof);
+    llvm::SmallVector<RCReference<AsyncValue>, 4> values;
+    values.push_back(std::move(*result));
+    return IterationResult::Values(std::move(values), host);
+  }
+  return IterationResult::Eof(host, 1);
+}
 
-  if (eof) {
-    return IterationResult::Eof(host, 1);
+llvm::Expected<RCReference<AsyncValue>> TFRecordDatasetIterator::ReadValue(
+    bool* eof) {
+  if (parent_dataset_->use_mmap_) {
+    auto result = ReadMappedRecord(eof);
+    if (!result) return result.takeError();
+    if (*eof) return RCReference<AsyncValue>();
+    return RCReference<AsyncValue>(
+        MakeAvailableAsyncValueRef<RCReference<HostBuffer>>(
+            std::move(*result)));
   }
-  if (!result) {
-    // Do not decode location or emit error because the local handler might have
-    // been freed.
-    auto error = MakeErrorAsyncValueRef(StrCat(result.takeError()));
-    return IterationResult::Error(std::move(error), 1);
+
+  auto result = ReadRecord(eof);
+  if (*eof) {
+    // The caller should not process the record at eof.
+    llvm::consumeError(result.takeError());
+    return RCReference<AsyncValue>();
   }
+  if (!result) return result.takeError();
+  return RCReference<AsyncValue>(
+      MakeAvailableAsyncValueRef<std::string>(std::move(*result)));
+}
 
-  llvm::SmallVector<RCReference<AsyncValue>, 4> values;
-  values.push_back(MakeAvailableAsyncValueRef<std::string>(std::move(*result)));
-  return IterationResult::Values(std::move(values), host);
+void TFRecordDatasetIterator::NextFile() {
+  stream_.reset();
+  mapping_.reset();
+  mapped_pos_ = 0;
+  ++file_index_;
 }
 
 // Logic based on tensorflow/core/io/record_reader.*
@@ -117,23 +182,110 @@ llvm::Expected<std::string> TFRecordDatasetIterator::ReadRecord(bool* eof) {
   return body;
 }
 
+void TFRecordDatasetIterator::ParseMappedRecords() {
+  const char* data = static_cast<const char*>(mapping_->data());
+  const size_t size = mapping_->size();
+  const size_t header_size = sizeof(uint64_t) + sizeof(uint32_t);
+  const bool verify_checksum = parent_dataset_->verify_checksum_;
+
+  // Parse the headers first, so that the checksums of the record data are
+  // computed in one tight loop over the batch.
+  llvm::SmallVector<size_t, kMappedRecordBatchSize> positions;
+  llvm::SmallVector<MappedRecord, kMappedRecordBatchSize> records;
+  while (records.size() < kMappedRecordBatchSize && mapped_pos_ < size) {
+    const size_t pos = mapped_pos_;
+    if (size - pos < header_size) {
+      mapped_error_ = MakeStringError("truncated record at position ", pos);
+      break;
+    }
+    const char* header = data + pos;
+    if (verify_checksum &&
+        crc32c::Unmask(DecodeFixed32(header + sizeof(uint64_t))) !=
+            crc32c::Value(header, sizeof(uint64_t))) {
+      mapped_error_ = MakeStringError("data corruption at position ", pos);
+      break;
+    }
+    const uint64_t length = DecodeFixed64(header);
+    if (size - pos - header_size < sizeof(uint32_t) ||
+        size - pos - header_size - sizeof(uint32_t) < length) {
+      mapped_error_ = MakeStringError("truncated record at position ", pos);
+      break;
+    }
+    positions.push_back(pos);
+    records.push_back({pos + header_size, length});
+    mapped_pos_ = pos + header_size + length + sizeof(uint32_t);
+  }
+
+  size_t num_verified = records.size();
+  if (verify_checksum) {
+    for (size_t i = 0; i < records.size(); ++i) {
+      const char* record = data + records[i].offset;
+      const size_t length = records[i].length;
+      if (crc32c::Unmask(DecodeFixed32(record + length)) !=
+          crc32c::Value(record, length)) {
+        // Drop any header error of a later record in favor of this one.
+        llvm::consumeError(std::move(mapped_error_));
+        mapped_error_ =
+            MakeStringError("data corruption at position ", positions[i]);
+        num_verified = i;
+        break;
+      }
+    }
+  }
+  for (size_t i = 0; i < num_verified; ++i) mapped_records_.push(records[i]);
+  // Do not parse past the first error.
+  if (mapped_error_ || num_verified < records.size()) mapped_pos_ = size;
+}
+
+llvm::Expected<RCReference<HostBuffer>>
+TFRecordDatasetIterator::ReadMappedRecord(bool* eof) {
+  *eof = false;
+  if (mapped_records_.empty()) ParseMappedRecords();
+  if (mapped_records_.empty()) {
+    if (mapped_error_) return std::move(mapped_error_);
+    *eof = true;
+    return RCReference<HostBuffer>();
+  }
+  auto record = mapped_records_.front();
+  mapped_records_.pop();
+  return HostBuffer::CreateFromExternal(mapping_.CopyRef(), record.offset,
+                                        record.length);
+}
+
 llvm::Error TFRecordDatasetIterator::MaybeInitializeStream() {
   if (initialization_error_) {
     return MakeStringError(initialization_error_);
   }
 
-  if (stream_) return llvm::Error::success();
+  if (stream_ || mapping_) return llvm::Error::success();
+  const std::string& path = parent_dataset_->paths_[file_index_];
 
   auto* fs_registry = ::tfrt::io::FileSystemRegistry::Default();
-  auto* file_system = fs_registry->Lookup("");
+  auto* file_system = fs_registry->LookupForPath(path);
   if (!file_system) {
     initialization_error_ =
         MakeStringError("No file system is found for the given scheme");
     return MakeStringError(initialization_error_);
   }
 
+  if (parent_dataset_->use_mmap_) {
+    std::unique_ptr<::tfrt::io::ReadOnlyMemoryRegion> region;
+    auto error = file_system->NewReadOnlyMemoryRegion(path, &region);
+    if (error) {
+      initialization_error_ = MakeStringError(error);
+      return error;
+    }
+    void* data = const_cast<void*>(region->data());
+    size_t length = region->length();
+    mapping_ = HostBuffer::CreateFromExternal(
+        data, length, [region = std::move(region)](void*, size_t) mutable {
+          region.reset();
+        });
+    return llvm::Error::success();
+  }
+
   std::unique_ptr<::tfrt::io::RandomAccessFile> file;
-  auto error = file_system->NewRandomAccessFile(parent_dataset_->path_, &file);
+  auto error = file_system->NewRandomAccessFile(path, &file);
   if (error) {
     initialization_error_ = MakeStringError(error);
     return error;
@@ -141,9 +293,13 @@ llvm::Error TFRecordDatasetIterator::MaybeInitializeStream() {
 
   stream_ = std::make_unique<::tfrt::io::FileInputStream>(std::move(file));
   if (parent_dataset_->buffer_size_ > 0) {
+    // Records are read sequentially, so keep the next block in flight while
+    // the current one is parsed.
+    ::tfrt::io::ReadAheadOptions options;
+    options.block_size = parent_dataset_->buffer_size_;
+    options.depth = 2;
     stream_ = std::make_unique<::tfrt::io::BufferedInputStream>(
-        std::move(stream_), parent_dataset_->buffer_size_,
-        parent_dataset_->allocator_);
+        std::move(stream_), options, parent_dataset_->host_);
   }
   return llvm::Error::success();
 }
@@ -15,34 +15,49 @@
  */
 
 // This file declares TFRecordDataset class which reads records from TFRecord
-// files into strings.
+// files into strings, or into slices of the memory-mapped files.
 
 #ifndef TFRT_LIB_DATA_TF_RECORD_DATASET_H_
 #define TFRT_LIB_DATA_TF_RECORD_DATASET_H_
 
+#include <queue>
+#include <string>
+#include <vector>
+
 #include "io.h"
 #include "tfrt/data/dataset.h"
+#include "tfrt/host_context/host_buffer.h"
 #include "tfrt/io/input_stream.h"
 #include "tfrt/support/forward_decls.h"
 
 namespace tfrt {
 namespace data {
 
-// TFRecordDataset reads TFRecord bytes from a file.
+// TFRecordDataset reads TFRecord bytes from files, one file after another in
+// the order of `paths`.
+//
+// If `use_mmap` is true, the file is memory-mapped and each record is returned
+// as a RCReference<HostBuffer> slice of the mapping instead of a std::string.
+// The checksums of the mapped records are verified in batches, unless
+// `verify_checksum` is false for trusted data.
+//
+// The dataset is sharded at file granularity if it has at least as many files
+// as shards, so that each shard only reads its own files.
 //
 // TODO(rachelim): Consider using a custom data type to represent the
-// bytes read from a TFRecord file. This will make the code more type safe
-// and allow for future optimizations to use mmap instead of copying bytes
-// from the file onto the heap.
+// bytes read from a TFRecord file. This will make the code more type safe.
 class TFRecordDataset : public Dataset {
  public:
-  explicit TFRecordDataset(std::string path, int64_t buffer_size,
+  explicit TFRecordDataset(std::vector<std::string> paths, int64_t buffer_size,
                            int64_t max_prefetch_num, int64_t prefetch_threshold,
+                           bool use_mmap, bool verify_checksum,
                            HostContext* host)
-      : path_(std::move(path)),
+      : paths_(std::move(paths)),
         buffer_size_(buffer_size),
         max_prefetch_num_(max_prefetch_num),
         prefetch_threshold_(prefetch_threshold),
+        use_mmap_(use_mmap),
+        verify_checksum_(verify_checksum),
         host_(host),
         allocator_(host->allocator()) {
     assert(buffer_size_ >= 0);
@@ -52,19 +67,29 @@ class TFRecordDataset : public Dataset {
   TFRecordDataset(const TFRecordDataset&) = delete;
   TFRecordDataset& operator=(const TFRecordDataset&) = delete;
 
-  RCReference<Iterator> MakeIterator(const IteratorContext& context) override;
+  string_view name() const override { return "tf_record_dataset"; }
+
+  // Assigns every `num_shards`-th file to the shard, starting at the file
+  // `index`. Returns nullptr if there are fewer files than shards.
+  RCReference<Dataset> MakeShard(int64_t num_shards, int64_t index) override;
 
  private:
   friend class TFRecordDatasetIterator;
 
+  RCReference<Iterator> MakeIteratorInternal(
+      const IteratorContext& context) override;
+
   void Destroy() override {
     internal::DestroyImpl<TFRecordDataset>(this, allocator_);
   }
 
-  const std::string path_;
+  const std::vector<std::string> paths_;
   const int64_t buffer_size_;
   const int64_t max_prefetch_num_;
   const int64_t prefetch_threshold_;
+  const bool use_mmap_;
+  // Only used if use_mmap_ is true. The stream reader always verifies.
+  const bool verify_checksum_;
   HostContext* host_;
   HostAllocator* allocator_;
 };
@@ -87,6 +112,7 @@ class TFRecordDatasetIterator : public io::PrefetchingIterator {
   // the next record.
   IterationResult GetNextElement(const ExecutionContext& exec_ctx) final;
 
+  // Opens the current file if it is not open yet.
   llvm::Error MaybeInitializeStream();
 
  private:
@@ -111,11 +137,56 @@ class TFRecordDatasetIterator : public io::PrefetchingIterator {
   // return value.
   llvm::Expected<std::string> ReadRecord(bool* eof);
 
+  // Parses up to kMappedRecordBatchSize records of the mapped file into
+  // mapped_records_, and verifies their checksums in one pass. If a record is
+  // truncated or corrupted, only the records before it are queued, and the
+  // error is returned after them.
+  void ParseMappedRecords();
+
+  // Returns the next record of the mapped file. Updates *eof to true iff the
+  // end of the file is reached and there is no error.
+  llvm::Expected<RCReference<HostBuffer>> ReadMappedRecord(bool* eof);
+
+  // Reads the next record of the current file as a std::string, or as a
+  // RCReference<HostBuffer> if use_mmap_ is true. Updates *eof to true iff the
+  // end of the file is reached and there is no error.
+  llvm::Expected<RCReference<AsyncValue>> ReadValue(bool* eof);
+
+  // Closes the current file and moves on to the next one.
+  void NextFile();
+
+  // The number of records whose checksums are verified in one pass.
+  static constexpr size_t kMappedRecordBatchSize = 64;
+
+  struct MappedRecord {
+    // The offset and length of the record data in the mapped file.
+    size_t offset;
+    size_t length;
+  };
+
   RCReference<TFRecordDataset> parent_dataset_;
+  // The index of the current file in paths_.
+  size_t file_index_ = 0;
   std::unique_ptr<::tfrt::io::InputStream> stream_;
+  // The mapped file, if use_mmap_ is true. The returned records are slices of
+  // it, which keep the mapping alive.
+  RCReference<HostBuffer> mapping_;
+  // The offset of the first record of the mapped file that is not parsed yet.
+  size_t mapped_pos_ = 0;
+  // Parsed and verified records that are not returned yet.
+  std::queue<MappedRecord> mapped_records_;
+  // The error to return after mapped_records_ are returned.
+  llvm::Error mapped_error_ = llvm::Error::success();
   llvm::Error initialization_error_ = llvm::Error::success();
 };
 
+// Returns the paths of the files that match `pattern`, e.g.
+// "/data/train-*.tfrecord", sorted by name. A pattern without wildcards is
+// returned as is, without checking that the file exists. Returns an error if
+// no file matches.
+llvm::Expected<std::vector<std::string>> ExpandFilePattern(
+    const std::string& pattern);
+
 }  // namespace data
 }  // namespace tfrt
 
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//===- admission_control_request_handler.cc - Admission Control -*- C++ -*-===//
+//
+// This file contains the implementation of the admission control request
+// handler, which bounds the execute requests processed for each context.
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/FunctionExtras.h"
+#include "tfrt/distributed_runtime/remote_trace.h"
+#include "tfrt/distributed_runtime/request_handler_impl.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/string_util.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace {
+
+class AdmissionControlRequestHandler : public RequestHandlerInterface {
+ public:
+  AdmissionControlRequestHandler(
+      HostContext* host, std::unique_ptr<RequestHandlerInterface> handler,
+      int max_inflight_execute_requests, int max_queued_execute_requests)
+      : host_(host),
+        handler_(std::move(handler)),
+        max_inflight_(max_inflight_execute_requests),
+        max_queued_(max_queued_execute_requests) {}
+
+#define CONTROL_METHOD(method)                                             \
+  void Handle##method(const method##Request* request,                      \
+                      method##Response* response, CallbackFn done) final { \
+    handler_->Handle##method(request, response, std::move(done));          \
+  }
+
+  CONTROL_METHOD(GetDevices);
+  CONTROL_METHOD(CreateContext);
+  CONTROL_METHOD(CloseContext);
+  CONTROL_METHOD(SendReadyChains);
+  CONTROL_METHOD(SendData);
+  CONTROL_METHOD(DeleteRemoteObjects);
+  CONTROL_METHOD(KeepAlive);
+
+#undef CONTROL_METHOD
+
+#define EXECUTE_METHOD(method)                                             \
+  void Handle##method(const method##Request* request,                      \
+                      method##Response* response, CallbackFn done) final { \
+    StampReceiveTime(request, response);                                   \
+    Admit(request->context_id(),                                           \
+          [this, request, response](CallbackFn done) {                     \
+            handler_->Handle##method(request, response, std::move(done));  \
+          },                                                               \
+          std::move(done));                                                \
+  }
+
+  EXECUTE_METHOD(RegisterFunction);
+  EXECUTE_METHOD(RemoteExecute);
+  EXECUTE_METHOD(RemoteExecuteOp);
+
+#undef EXECUTE_METHOD
+
+ private:
+  // Traced calls include the time spent in the queue in their queueing time.
+  static void StampReceiveTime(const RegisterFunctionRequest* request,
+                               RegisterFunctionResponse* response) {}
+  template <typename Request, typename Response>
+  static void StampReceiveTime(const Request* request, Response* response) {
+    if (request->has_trace_context()) {
+      response->mutable_server_timing()->set_receive_time_us(
+          RemoteTraceMicros());
+    }
+  }
+
+  using HandleFn = llvm::unique_function<void(CallbackFn)>;
+
+  struct PendingRequest {
+    HandleFn handle;
+    CallbackFn done;
+  };
+
+  // Execute requests of one distributed context.
+  struct ContextRequests {
+    int inflight = 0;
+    std::deque<PendingRequest> queued;
+  };
+
+  // Runs `handle` now if the context has fewer than `max_inflight_` execute
+  // requests in flight, or queues it.
+  void Admit(uint64_t context_id, HandleFn handle, CallbackFn done) {
+    bool rejected = false;
+    {
+      mutex_lock lock(mu_);
+      ContextRequests& requests = contexts_[context_id];
+      if (requests.inflight < max_inflight_) {
+        ++requests.inflight;
+      } else if (requests.queued.size() < max_queued_) {
+        requests.queued.push_back({std::move(handle), std::move(done)});
+        return;
+      } else {
+        rejected = true;
+      }
+    }
+    if (rejected) {
+      // Tell the client to back off, instead of queueing without bound.
+      done(llvm::make_error<ResourceExhaustedErrorInfo>(
+          StrCat("Too many execute requests for distributed context ",
+                 context_id, ", retry later.")));
+      return;
+    }
+    Run(context_id, std::move(handle), std::move(done));
+  }
+
+  void Run(uint64_t context_id, HandleFn handle, CallbackFn done) {
+    handle([this, context_id, done = std::move(done)](Error e) mutable {
+      done(std::move(e));
+      Release(context_id);
+    });
+  }
+
+  // Starts the next queued execute request of the context, if any.
+  void Release(uint64_t context_id) {
+    PendingRequest next;
+    {
+      mutex_lock lock(mu_);
+      auto it = contexts_.find(context_id);
+      assert(it != contexts_.end());
+      ContextRequests& requests = it->second;
+      if (requests.queued.empty()) {
+        if (--requests.inflight == 0) contexts_.erase(it);
+        return;
+      }
+      next = std::move(requests.queued.front());
+      requests.queued.pop_front();
+    }
+    // Requests can complete synchronously, so start the next one on the work
+    // queue instead of recursing through the queue on this stack.
+    EnqueueWork(host_, [this, context_id, next = std::move(next)]() mutable {
+      Run(context_id, std::move(next.handle), std::move(next.done));
+    });
+  }
+
+  HostContext* const host_;
+  const std::unique_ptr<RequestHandlerInterface> handler_;
+  const int max_inflight_;
+  const size_t max_queued_;
+
+  mutex mu_;
+  llvm::DenseMap<uint64_t, ContextRequests> contexts_ TFRT_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+std::unique_ptr<RequestHandlerInterface> NewAdmissionControlRequestHandler(
+    HostContext* host, std::unique_ptr<RequestHandlerInterface> handler,
+    int max_inflight_execute_requests, int max_queued_execute_requests) {
+  return std::make_unique<AdmissionControlRequestHandler>(
+      host, std::move(handler), max_inflight_execute_requests,
+      max_queued_execute_requests);
+}
+
+}  // namespace tfrt
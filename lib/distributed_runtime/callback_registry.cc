@@ -20,26 +20,32 @@
 
 #include "tfrt/distributed_runtime/callback_registry.h"
 
+#include "llvm/ADT/Hashing.h"
 #include "tfrt/distributed_runtime/distributed_context.h"
 
 namespace tfrt {
 
+CallbackRegistry::Shard& CallbackRegistry::GetShard(const InstanceKey& key) {
+  return shards_[llvm::hash_value(key) % kNumShards];
+}
+
 void CallbackRegistry::SetValue(const InstanceKey& key, CallbackValue value) {
   bool execute_callback = false;
   Callback callback = nullptr;
   CallbackMap::iterator callback_iter;
   {
-    mutex_lock lock(hashmap_mutex_);
+    Shard& shard = GetShard(key);
+    mutex_lock lock(shard.hashmap_mutex);
 
     // If the callback for the key already exists, directly
     // execute the callback on the value.
-    callback_iter = callbacks_.find(key);
-    if (callback_iter == callbacks_.end()) {
-      values_.insert_or_assign(key, std::move(value));
+    callback_iter = shard.callbacks.find(key);
+    if (callback_iter == shard.callbacks.end()) {
+      shard.values.insert_or_assign(key, std::move(value));
     } else {
       execute_callback = true;
       callback = std::move(callback_iter->second);
-      callbacks_.erase(callback_iter);
+      shard.callbacks.erase(callback_iter);
     }
   }
 
@@ -59,17 +65,19 @@ void CallbackRegistry::SetCallback(const InstanceKey& key, Callback callback) {
   CallbackValue value = Payload({});
   CallbackMap::iterator callback_iter;
   {
-    mutex_lock lock(hashmap_mutex_);
+    Shard& shard = GetShard(key);
+    mutex_lock lock(shard.hashmap_mutex);
 
     // If the value for the key already exists, directly execute
     // the callback on the value.
-    auto value_iter = values_.find(key);
-    if (value_iter != values_.end()) {
+    auto value_iter = shard.values.find(key);
+    if (value_iter != shard.values.end()) {
       value = std::move(value_iter->second);
-      values_.erase(value_iter);
+      shard.values.erase(value_iter);
       execute_callback = true;
     } else {
-      auto insert_ret = callbacks_.insert_or_assign(key, std::move(callback));
+      auto insert_ret =
+          shard.callbacks.insert_or_assign(key, std::move(callback));
       callback_iter = insert_ret.first;
     }
   }
@@ -80,14 +88,16 @@ void CallbackRegistry::SetCallback(const InstanceKey& key, Callback callback) {
 }
 
 void CallbackRegistry::DebugDump() {
-  mutex_lock l(hashmap_mutex_);
-  TFRT_LOG(INFO) << "Callbacks waiting:";
-  for (const auto& p : callbacks_) {
-    TFRT_LOG(INFO) << "  this=" << this << " " << p.first();
-  }
-  TFRT_LOG(INFO) << "Values waiting:";
-  for (const auto& p : values_) {
-    TFRT_LOG(INFO) << "  this=" << this << " " << p.first();
+  for (Shard& shard : shards_) {
+    mutex_lock l(shard.hashmap_mutex);
+    TFRT_LOG(INFO) << "Callbacks waiting:";
+    for (const auto& p : shard.callbacks) {
+      TFRT_LOG(INFO) << "  this=" << this << " " << p.first();
+    }
+    TFRT_LOG(INFO) << "Values waiting:";
+    for (const auto& p : shard.values) {
+      TFRT_LOG(INFO) << "  this=" << this << " " << p.first();
+    }
   }
 }
 
@@ -0,0 +1,269 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//===- coalescing_remote_client.cc - Coalescing Remote Client -------------===//
+//
+// This file contains the implementation of the coalescing remote client.
+
+#include "tfrt/distributed_runtime/coalescing_remote_client.h"
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "llvm/ADT/FunctionExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/host_context/timer_queue.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace {
+
+// Requests of one type buffered for the same distributed context.
+template <typename Request>
+struct Batch {
+  std::unique_ptr<Request> request;  // nullptr if nothing is buffered
+  llvm::SmallVector<RemoteClientInterface::CallbackFn, 4> done;
+  uint64_t id = 0;  // identifies the batch to its flush timer
+};
+
+int BatchSize(const DeleteRemoteObjectsRequest& request) {
+  return request.input_size();
+}
+
+int BatchSize(const SendReadyChainsRequest& request) {
+  return request.ready_chains_size();
+}
+
+// Invokes all `done` callbacks with `error`.
+void Done(llvm::SmallVector<RemoteClientInterface::CallbackFn, 4> done,
+          Error error) {
+  if (!error) {
+    for (auto& callback : done) callback(Error::success());
+    return;
+  }
+  std::string message = toString(std::move(error));
+  for (auto& callback : done) callback(MakeStringError(message));
+}
+
+void Send(RemoteClientInterface* client,
+          std::unique_ptr<DeleteRemoteObjectsRequest> request,
+          llvm::SmallVector<RemoteClientInterface::CallbackFn, 4> done) {
+  auto response = std::make_unique<DeleteRemoteObjectsResponse>();
+  client->DeleteRemoteObjectsAsync(
+      RemoteCallContext::GetDefault(), request.get(), response.get(),
+      [request = std::move(request), response = std::move(response),
+       done = std::move(done)](Error e) mutable {
+        Done(std::move(done), std::move(e));
+      });
+}
+
+void Send(RemoteClientInterface* client,
+          std::unique_ptr<SendReadyChainsRequest> request,
+          llvm::SmallVector<RemoteClientInterface::CallbackFn, 4> done) {
+  auto response = std::make_unique<SendReadyChainsResponse>();
+  client->SendReadyChainsAsync(
+      RemoteCallContext::GetDefault(), request.get(), response.get(),
+      [request = std::move(request), response = std::move(response),
+       done = std::move(done)](Error e) mutable {
+        Done(std::move(done), std::move(e));
+      });
+}
+
+}  // namespace
+
+class CoalescingRemoteClient::Coalescer
+    : public ReferenceCounted<CoalescingRemoteClient::Coalescer> {
+ public:
+  Coalescer(HostContext* host, std::unique_ptr<RemoteClientInterface> client,
+            Options options)
+      : host_(host), client_(std::move(client)), options_(options) {}
+
+  RemoteClientInterface* client() const { return client_.get(); }
+
+  template <typename Request>
+  void Add(const Request& request, CallbackFn done) {
+    llvm::SmallVector<Batch<Request>, 2> ready;
+    bool schedule_flush = false;
+    uint64_t id;
+
+    {
+      mutex_lock lock(mu_);
+      Batch<Request>& batch = GetBatch<Request>();
+
+      // Requests for different contexts can't be coalesced.
+      if (batch.request && batch.request->context_id() != request.context_id())
+        ready.push_back(std::move(batch));
+
+      if (!batch.request) {
+        batch = Batch<Request>();
+        batch.request = std::make_unique<Request>();
+        batch.id = ++next_batch_id_;
+        schedule_flush = true;
+      }
+      id = batch.id;
+
+      batch.request->MergeFrom(request);
+      batch.done.push_back(std::move(done));
+      if (BatchSize(*batch.request) >= options_.max_batch_size) {
+        ready.push_back(std::move(batch));
+        batch = Batch<Request>();
+        schedule_flush = false;
+      }
+    }
+
+    for (Batch<Request>& batch : ready)
+      Send(client_.get(), std::move(batch.request), std::move(batch.done));
+
+    if (schedule_flush) {
+      host_->GetTimerQueue()->ScheduleTimer(
+          options_.window, [coalescer = FormRef(this), id]() {
+            coalescer->FlushBatch<Request>(id);
+          });
+    }
+  }
+
+  void Flush() {
+    FlushBatch<DeleteRemoteObjectsRequest>(/*id=*/0);
+    FlushBatch<SendReadyChainsRequest>(/*id=*/0);
+  }
+
+  using SendFn = llvm::unique_function<void(CallbackFn)>;
+
+  // Sends a request with `send`, and sends it again after a backoff while the
+  // remote task rejects it as overloaded.
+  void SendWithBackoff(std::shared_ptr<SendFn> send, CallbackFn done,
+                       int attempt = 0) {
+    (*send)([coalescer = FormRef(this), send, done = std::move(done),
+             attempt](Error e) mutable {
+      if (!e || !e.isA<ResourceExhaustedErrorInfo>() ||
+          attempt >= coalescer->options_.max_overload_retries) {
+        done(std::move(e));
+        return;
+      }
+      llvm::consumeError(std::move(e));
+      TimerQueue* timers = coalescer->host_->GetTimerQueue();
+      timers->ScheduleTimer(
+          coalescer->options_.overload_backoff * (1 << attempt),
+          [coalescer = std::move(coalescer), send = std::move(send),
+           done = std::move(done), attempt]() mutable {
+            coalescer->SendWithBackoff(std::move(send), std::move(done),
+                                       attempt + 1);
+          });
+    });
+  }
+
+ private:
+  template <typename Request>
+  Batch<Request>& GetBatch() TFRT_REQUIRES(mu_) {
+    return std::get<Batch<Request>>(batches_);
+  }
+
+  // Sends the buffered batch if it is batch `id`, or any buffered batch if
+  // `id` is 0.
+  template <typename Request>
+  void FlushBatch(uint64_t id) {
+    Batch<Request> batch;
+    {
+      mutex_lock lock(mu_);
+      Batch<Request>& buffered = GetBatch<Request>();
+      if (!buffered.request || (id != 0 && buffered.id != id)) return;
+      batch = std::move(buffered);
+      buffered = Batch<Request>();
+    }
+    Send(client_.get(), std::move(batch.request), std::move(batch.done));
+  }
+
+  HostContext* const host_;
+  const std::unique_ptr<RemoteClientInterface> client_;
+  const Options options_;
+
+  mutex mu_;
+  uint64_t next_batch_id_ TFRT_GUARDED_BY(mu_) = 0;
+  std::tuple<Batch<DeleteRemoteObjectsRequest>, Batch<SendReadyChainsRequest>>
+      batches_ TFRT_GUARDED_BY(mu_);
+};
+
+CoalescingRemoteClient::CoalescingRemoteClient(
+    HostContext* host, std::unique_ptr<RemoteClientInterface> client,
+    Options options)
+    : coalescer_(TakeRef(new Coalescer(host, std::move(client), options))) {}
+
+CoalescingRemoteClient::~CoalescingRemoteClient() { Flush(); }
+
+void CoalescingRemoteClient::Flush() { coalescer_->Flush(); }
+
+#define FORWARD_CLIENT_METHOD(method)                                       \
+  void CoalescingRemoteClient::method##Async(                               \
+      RemoteCallContext* call_ctx, const method##Request* request,          \
+      method##Response* response, CallbackFn done) {                        \
+    coalescer_->client()->method##Async(call_ctx, request, response,        \
+                                        std::move(done));                   \
+  }
+
+FORWARD_CLIENT_METHOD(GetDevices);
+FORWARD_CLIENT_METHOD(CreateContext);
+FORWARD_CLIENT_METHOD(CloseContext);
+FORWARD_CLIENT_METHOD(SendData);
+FORWARD_CLIENT_METHOD(KeepAlive);
+
+#undef FORWARD_CLIENT_METHOD
+
+#define BACKOFF_CLIENT_METHOD(method)                                       \
+  void CoalescingRemoteClient::method##Async(                               \
+      RemoteCallContext* call_ctx, const method##Request* request,          \
+      method##Response* response, CallbackFn done) {                        \
+    coalescer_->SendWithBackoff(                                            \
+        std::make_shared<Coalescer::SendFn>(                                \
+            [client = coalescer_->client(), call_ctx, request,              \
+             response](CallbackFn done) {                                   \
+              response->Clear();                                            \
+              client->method##Async(call_ctx, request, response,            \
+                                    std::move(done));                       \
+            }),                                                             \
+        std::move(done));                                                   \
+  }
+
+BACKOFF_CLIENT_METHOD(RegisterFunction);
+BACKOFF_CLIENT_METHOD(RemoteExecute);
+BACKOFF_CLIENT_METHOD(RemoteExecuteOp);
+
+#undef BACKOFF_CLIENT_METHOD
+
+void CoalescingRemoteClient::SendReadyChainsAsync(
+    RemoteCallContext* call_ctx, const SendReadyChainsRequest* request,
+    SendReadyChainsResponse* response, CallbackFn done) {
+  coalescer_->Add(*request, std::move(done));
+}
+
+void CoalescingRemoteClient::DeleteRemoteObjectsAsync(
+    RemoteCallContext* call_ctx, const DeleteRemoteObjectsRequest* request,
+    DeleteRemoteObjectsResponse* response, CallbackFn done) {
+  coalescer_->Add(*request, std::move(done));
+}
+
+void CoalescingRemoteClient::SendPayloadAsync(RemoteCallContext* call_ctx,
+                                              uint64_t context_id,
+                                              string_view instance_key,
+                                              Payload payload,
+                                              CallbackFn done) {
+  coalescer_->client()->SendPayloadAsync(call_ctx, context_id, instance_key,
+                                         std::move(payload), std::move(done));
+}
+
+}  // namespace tfrt
@@ -25,12 +25,16 @@
 #include "tfrt/bef_executor/bef_file.h"
 #include "tfrt/distributed_runtime/callback_registry.h"
 #include "tfrt/distributed_runtime/cluster_info.h"
+#include "tfrt/distributed_runtime/coalescing_remote_client.h"
 #include "tfrt/distributed_runtime/fabric_communicator.h"
 #include "tfrt/distributed_runtime/function_cache.h"
 #include "tfrt/distributed_runtime/proto/remote_message.pb.h"
 #include "tfrt/distributed_runtime/remote_client.h"
 #include "tfrt/distributed_runtime/remote_device.h"
 #include "tfrt/distributed_runtime/remote_object_manager.h"
+#include "tfrt/distributed_runtime/payload_codec.h"
+#include "tfrt/distributed_runtime/remote_input_cache.h"
+#include "tfrt/distributed_runtime/remote_op_cache.h"
 #include "tfrt/distributed_runtime/server_context.h"
 #include "tfrt/distributed_runtime/task_name_util.h"
 #include "tfrt/host_context/function.h"
@@ -52,7 +56,17 @@ DistributedContext::DistributedContext(
       remote_manager_(std::make_unique<RemoteObjectManager>(
           cluster_info_.GetTaskHandle(), GetHostContext())),
       callback_registry_(new CallbackRegistry()),
-      function_cache_(new FunctionCache(GetHostContext())) {
+      function_cache_(new FunctionCache(GetHostContext())),
+      remote_op_cache_(new RemoteOpCache()),
+      remote_input_cache_(
+          configuration.remote_input_cache_bytes() > 0
+              ? new RemoteInputCache(configuration.remote_input_cache_bytes())
+              : nullptr),
+      remote_input_store_(new RemoteInputStore()),
+      gradient_compressor_(new GradientCompressor(
+          configuration.gradient_codec() != PAYLOAD_CODEC_NONE
+              ? configuration.gradient_codec()
+              : configuration.payload_codec())) {
   TaskHandle task_handle = cluster_info_.GetTaskHandle();
   DeviceManager* local_device_mgr = GetHostContext()->GetDeviceManager();
   // For each local device, add a corresponding RemoveDevice instance with the
@@ -112,14 +126,32 @@ RemoteClientInterface* DistributedContext::GetRemoteClient(
   auto it = remote_clients_.find(task_handle);
   if (it == remote_clients_.end()) {
     auto* communicator = server_context_->GetOrCreateFabricCommunicator();
+    // Coalesce the small control plane requests sent to the same task.
     auto ret = remote_clients_.try_emplace(
-        task_handle, communicator->CreateRemoteClient(this, task_handle));
+        task_handle, std::make_unique<CoalescingRemoteClient>(
+                         GetHostContext(),
+                         communicator->CreateRemoteClient(this, task_handle)));
     assert(ret.second && "Failed to create remote client.");
     it = ret.first;
   }
   return it->second.get();
 }
 
+uint64_t DistributedContext::GetRemoteProgramHandle(TaskHandle task_handle,
+                                                   string_view program_name) {
+  mutex_lock l(remote_program_handles_mu_);
+  auto it = remote_program_handles_.find(task_handle);
+  if (it == remote_program_handles_.end()) return 0;
+  return it->second.lookup(program_name);
+}
+
+void DistributedContext::SetRemoteProgramHandle(TaskHandle task_handle,
+                                                string_view program_name,
+                                                uint64_t program_handle) {
+  mutex_lock l(remote_program_handles_mu_);
+  remote_program_handles_[task_handle][program_name] = program_handle;
+}
+
 void DistributedContext::GetRemoteDevices(
     DistributedContext::CallbackFn done_callback) {
   // Reference-counted done callback is invoked after all remote calls finish
@@ -33,8 +33,18 @@
 
 namespace tfrt {
 
-Error FunctionCache::Register(const std::string& program_name,
-                              BefBuffer bef_buffer) {
+FunctionCache::~FunctionCache() {
+  for (std::atomic<Chunk*>& chunk : chunks_) {
+    Chunk* entries = chunk.load(std::memory_order_relaxed);
+    if (entries == nullptr) break;
+    for (std::atomic<Entry*>& entry : *entries)
+      delete entry.load(std::memory_order_relaxed);
+    delete entries;
+  }
+}
+
+Expected<uint64_t> FunctionCache::Register(const std::string& program_name,
+                                           BefBuffer bef_buffer) {
   RCReference<BEFFile> bef_file =
       tfrt::BEFFile::Open(bef_buffer, host_->GetKernelRegistry(),
                           host_->diag_handler(), host_->allocator());
@@ -60,26 +70,54 @@ Error FunctionCache::Register(const std::string& program_name,
     require_preallocated_outputs = true;
   }
   mutex_lock lock(cached_bef_mutex_);
-  if (cached_bef_.find(program_name) != cached_bef_.end()) {
+  if (handles_.find(program_name) != handles_.end()) {
     return llvm::make_error<RemoteFunctionAlreadyExistsErrorInfo>(
         StrCat("Program ", program_name, " already registered."));
   }
-  auto& cached = cached_bef_[program_name];
-  cached.first = std::move(bef_buffer);
-  cached.second.bef_file = bef_file;
-  cached.second.require_distributed_context = require_distributed_context;
-  cached.second.require_preallocated_outputs = require_preallocated_outputs;
-  return Error::success();
+  if (num_entries_ == kChunkSize * kMaxChunks) {
+    return llvm::make_error<ResourceExhaustedErrorInfo>(
+        StrCat("Too many programs registered, can't register ", program_name,
+               "."));
+  }
+
+  auto entry = std::make_unique<Entry>();
+  entry->bef_buffer = std::move(bef_buffer);
+  entry->cached_bef.bef_file = bef_file;
+  entry->cached_bef.require_distributed_context = require_distributed_context;
+  entry->cached_bef.require_preallocated_outputs =
+      require_preallocated_outputs;
+
+  const uint64_t index = num_entries_++;
+  std::atomic<Chunk*>& chunk = chunks_[index / kChunkSize];
+  if (chunk.load(std::memory_order_relaxed) == nullptr)
+    chunk.store(new Chunk{}, std::memory_order_release);
+  (*chunk.load(std::memory_order_relaxed))[index % kChunkSize].store(
+      entry.release(), std::memory_order_release);
+
+  const uint64_t handle = index + 1;
+  handles_[program_name] = handle;
+  return handle;
 }
 
 FunctionCache::CachedBEF* FunctionCache::Prepare(
     const std::string& program_name) {
-  mutex_lock lock(cached_bef_mutex_);
-  auto iter = cached_bef_.find(program_name);
-  if (iter != cached_bef_.end()) {
-    return &iter->second.second;
+  uint64_t handle;
+  {
+    mutex_lock lock(cached_bef_mutex_);
+    auto iter = handles_.find(program_name);
+    if (iter == handles_.end()) return nullptr;
+    handle = iter->second;
   }
-  return nullptr;
+  return Prepare(handle);
+}
+
+FunctionCache::CachedBEF* FunctionCache::Prepare(uint64_t handle) {
+  if (handle == 0 || handle > kChunkSize * kMaxChunks) return nullptr;
+  const uint64_t index = handle - 1;
+  Chunk* chunk = chunks_[index / kChunkSize].load(std::memory_order_acquire);
+  if (chunk == nullptr) return nullptr;
+  Entry* entry = (*chunk)[index % kChunkSize].load(std::memory_order_acquire);
+  return entry ? &entry->cached_bef : nullptr;
 }
 
 }  // namespace tfrt
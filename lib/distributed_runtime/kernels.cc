@@ -14,9 +14,12 @@
 
 // This file implements kernels for distributed execution.
 
+#include <algorithm>
 #include <cstddef>
+#include <type_traits>
 #include <utility>
 
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "tfrt/core_runtime/tensor_handle.h"
@@ -25,17 +28,21 @@
 #include "tfrt/distributed_runtime/distributed_kernels.h"
 #include "tfrt/distributed_runtime/fabric_communicator.h"
 #include "tfrt/distributed_runtime/payload.h"
+#include "tfrt/distributed_runtime/payload_codec.h"
 #include "tfrt/distributed_runtime/proto/remote_message.pb.h"
 #include "tfrt/distributed_runtime/remote_chain_manager.h"
 #include "tfrt/distributed_runtime/remote_client.h"
 #include "tfrt/distributed_runtime/remote_execute.h"
+#include "tfrt/distributed_runtime/remote_input_cache.h"
 #include "tfrt/distributed_runtime/remote_object_manager.h"
 #include "tfrt/distributed_runtime/remote_tensor.h"
+#include "tfrt/distributed_runtime/remote_trace.h"
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/async_value_ref.h"
 #include "tfrt/host_context/kernel_utils.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/logging.h"
+#include "tfrt/support/ref_count.h"
 #include "tfrt/support/refcounted_callback.h"
 #include "tfrt/support/string_util.h"
 #include "tfrt/tensor/dense_host_tensor.h"
@@ -158,90 +165,101 @@ TaskHandle GetTaskHandle(Argument<DistributedContext> dist_context,
   return dist_context->GetTaskHandle(task_name.get());
 }
 
+// Returns the members of a collective group ordered so that tasks on the same
+// host are adjacent, keeping the group order within a host and ordering hosts
+// by their first member. Data passed around a ring then crosses host
+// boundaries once per host, instead of up to once per task. All members
+// compute the same order from the cluster configuration.
+llvm::SmallVector<TaskHandle, 8> TopologyOrder(
+    const DistributedContext& dist_ctx,
+    const llvm::SmallVector<TaskHandle, 8>& members) {
+  llvm::MapVector<string_view, llvm::SmallVector<TaskHandle, 8>> hosts;
+  for (TaskHandle task : members) {
+    string_view address = dist_ctx.GetRemoteAddress(task);
+    hosts[address.rsplit(':').first].push_back(task);
+  }
+  llvm::SmallVector<TaskHandle, 8> ordered;
+  ordered.reserve(members.size());
+  for (auto& host : hosts)
+    ordered.append(host.second.begin(), host.second.end());
+  return ordered;
+}
+
+// Sets `data` as the payload of `request`, whose instance key must be set.
+// Partial results of float32 all-reduce are encoded with the gradient
+// compressor, which may be lossy, and all other data with the lossless payload
+// codec, so that all tasks end up with the same result.
 template <typename T>
-void DoAllReduce(const ExecutionContext& exec_ctx,
-                 AsyncValueRef<DistributedContext> dist_ctx,
-                 const InstanceKey& instance_key,
-                 const std::string& collective_group_name,
-                 const DenseHostTensor& in_tensor,
-                 const DenseHostTensor& out_tensor,
-                 ElementWiseReductionFunction reduction_fn,
-                 ElementWiseFinalFunction final_fn,
-                 AsyncValueRef<Chain> out_chain) {
-  const auto& collective_group =
-      dist_ctx->GetCollectiveGroup(collective_group_name);
-  const int my_index =
-      FindMyIndex(collective_group.members, dist_ctx->GetTaskHandle());
-  if (my_index == -1) {
-    out_chain.SetError(StrCat("The current task ", dist_ctx->GetTaskName(),
-                              " is not part of the collective group ",
-                              collective_group_name));
-    return;
+void SetCollectivePayload(DistributedContext* dist_ctx, llvm::StringRef data,
+                          bool partial_result, SendDataRequest* request) {
+  if (partial_result && std::is_same<T, float>::value) {
+    dist_ctx->GetGradientCompressor()->SetPayload(request->instance_key(),
+                                                  data, request);
+  } else {
+    SetPayload(dist_ctx->GetPayloadCodec(), data, request);
   }
-  const size_t kGroupSize = collective_group.members.size();
+}
+
+// Sends `data` to `task` under `key`, and reports the result to `done`.
+template <typename T>
+void SendCollectiveData(DistributedContext* dist_ctx, TaskHandle task,
+                        const InstanceKey& key, llvm::StringRef data,
+                        bool partial_result,
+                        RCReference<RefCountedCallback> done) {
+  RemoteClientInterface* client = dist_ctx->GetRemoteClient(task);
+  auto request = std::make_unique<SendDataRequest>();
+  auto response = std::make_unique<SendDataResponse>();
+  request->set_context_id(dist_ctx->GetContextId());
+  request->set_instance_key(key);
+  SetCollectivePayload<T>(dist_ctx, data, partial_result, request.get());
+  SendDataRequest* request_ptr = request.get();
+  SendDataResponse* response_ptr = response.get();
+  client->SendDataAsync(
+      RemoteCallContext::GetDefault(), request_ptr, response_ptr,
+      [request = std::move(request), response = std::move(response),
+       done = std::move(done)](Error e) { done->UpdateState(std::move(e)); });
+}
+
+// Ring all-reduce of `data` among `members`: a reduce-scatter followed by an
+// all-gather, each taking `members.size() - 1` steps. Every task sends and
+// receives 2 * data.size() bytes regardless of the group size, so this is
+// used for large tensors.
+template <typename T>
+void DoRingAllReduce(DistributedContext* dist_ctx,
+                     const InstanceKey& instance_key,
+                     const std::string& collective_group_name,
+                     const llvm::SmallVector<TaskHandle, 8>& members,
+                     int my_index, llvm::StringRef in_tensor_ref,
+                     size_t num_elements,
+                     ElementWiseReductionFunction reduction_fn,
+                     ElementWiseFinalFunction final_fn,
+                     RCReference<RefCountedCallback> refcounted_done) {
+  const size_t kGroupSize = members.size();
   const size_t kLastScatterStep = kGroupSize - 1;
   const size_t kLastGatherStep = 2 * kGroupSize - 2;
   const auto kPrefix = collective_group_name;
   const int kTotalSteps = 2 * kGroupSize - 1;
 
-  const int neighbor_index = (my_index + 1) % collective_group.members.size();
-  const TaskHandle neighbor_task = collective_group.members[neighbor_index];
+  const int neighbor_index = (my_index + 1) % kGroupSize;
+  const TaskHandle neighbor_task = members[neighbor_index];
 
-  auto in_tensor_ref =
-      llvm::StringRef(reinterpret_cast<const char*>(in_tensor.data()),
-                      in_tensor.DataSizeInBytes());
   auto* callback_registry = dist_ctx->GetCallbackRegistry();
   RemoteClientInterface* neighbor_client =
       dist_ctx->GetRemoteClient(neighbor_task);
-
-  auto done = [out_chain = out_chain.CopyRef(),
-               dist_ctx = dist_ctx.CopyRef()](Error e) mutable {
-    if (e) {
-      out_chain.SetError(absl::InternalError(toString(std::move(e))));
-    } else {
-      out_chain.emplace();
-    }
-  };
-
-  // Ref counted callback to keep track of pending steps in all reduce.
-  // Add one ref before starting each step, and drop one ref when the step
-  // finishes (for steps with async RPCs, drop the reference when RPC finishes).
-  auto refcounted_done = TakeRef(
-      new RefCountedCallback([host = dist_ctx->GetHostContext(), exec_ctx,
-                              done = std::move(done)](Error e) mutable {
-        // NOTE: we might be executing this in either HostContext work queue
-        // threads or the FabricCommunicator callback threads. Must make sure
-        // AsyncValue Chain gets emplaced (or set error) in the work queue
-        // threadpool, so that:
-        //   * subsequent operations (i.e., AndThen) for this AsyncValue are
-        //     executed in the work queue threads;
-        //   * the AsyncValue drops its last ref and gets deallocated in the
-        //     work queue threads
-        // Otherwise, the HostContext might get destroyed before the AsyncValue
-        // is deallocated or finishes its AndThen work, leading to segfault.
-        if (host->IsInWorkerThread()) {
-          done(std::move(e));
-        } else {
-          EnqueueWork(exec_ctx,
-                      [done = std::move(done), e = std::move(e)]() mutable {
-                        done(std::move(e));
-                      });
-        }
-      }));
-
   for (int step = 0; step < kTotalSteps; ++step) {
     const InstanceKey step_key = StepKey(kPrefix, instance_key, step);
     const InstanceKey next_step_key = StepKey(kPrefix, instance_key, step + 1);
     const size_t split_id = SplitIndex(my_index, kGroupSize, step);
-    llvm::StringRef split_data = GetSplit<T>(in_tensor_ref, kGroupSize,
-                                             in_tensor.NumElements(), split_id);
+    llvm::StringRef split_data =
+        GetSplit<T>(in_tensor_ref, kGroupSize, num_elements, split_id);
     auto request = std::make_unique<SendDataRequest>();
     auto response = std::make_unique<SendDataResponse>();
     request->set_context_id(dist_ctx->GetContextId());
     request->set_instance_key(next_step_key);
 
     if (step == 0) {
-      request->add_payload(split_data.data(), split_data.size());
+      SetCollectivePayload<T>(dist_ctx, split_data, /*partial_result=*/true,
+                              request.get());
       neighbor_client->SendDataAsync(
           RemoteCallContext::GetDefault(), request.get(), response.get(),
           [request = std::move(request), response = std::move(response),
@@ -253,7 +271,7 @@ void DoAllReduce(const ExecutionContext& exec_ctx,
       // chunk with local buffer.
       callback_registry->SetCallback(
           step_key,
-          [step, in_split = split_data, out_split = split_data,
+          [dist_ctx, step, in_split = split_data, out_split = split_data,
            request = std::move(request), response = std::move(response),
            neighbor_client, reduction_fn, final_fn, kLastScatterStep,
            kGroupSize, refcounted_done = refcounted_done](
@@ -271,7 +289,11 @@ void DoAllReduce(const ExecutionContext& exec_ctx,
                         static_cast<char*>(data->data()) + data->size(),
                         const_cast<char*>(out_split.begin()));
             }
-            request->add_payload(data->data(), data->size());
+            // Partial results are sent until the last scatter step.
+            SetCollectivePayload<T>(
+                dist_ctx, llvm::StringRef(static_cast<char*>(data->data()),
+                                          data->size()),
+                /*partial_result=*/step < kLastScatterStep, request.get());
             neighbor_client->SendDataAsync(
                 RemoteCallContext::GetDefault(), request.get(), response.get(),
                 [request = std::move(request), response = std::move(response),
@@ -285,7 +307,7 @@ void DoAllReduce(const ExecutionContext& exec_ctx,
       // buffer and pass it to the neighbor as is.
       callback_registry->SetCallback(
           step_key,
-          [step, out_split = split_data, kLastGatherStep,
+          [dist_ctx, step, out_split = split_data, kLastGatherStep,
            request = std::move(request), response = std::move(response),
            neighbor_client, refcounted_done = refcounted_done](
               const InstanceKey&,
@@ -296,7 +318,11 @@ void DoAllReduce(const ExecutionContext& exec_ctx,
                       static_cast<char*>(data->data()) + data->size(),
                       const_cast<char*>(out_split.begin()));
             if (step < kLastGatherStep) {
-              request->add_payload(data->data(), data->size());
+              SetCollectivePayload<T>(
+                  dist_ctx,
+                  llvm::StringRef(static_cast<char*>(data->data()),
+                                  data->size()),
+                  /*partial_result=*/false, request.get());
               neighbor_client->SendDataAsync(
                   RemoteCallContext::GetDefault(), request.get(),
                   response.get(),
@@ -311,6 +337,197 @@ void DoAllReduce(const ExecutionContext& exec_ctx,
   }
 }
 
+// Binomial tree all-reduce of `data` among `members`: the data is reduced
+// towards the first member and the result is broadcast back along the same
+// tree. This takes 2 * log2(members.size()) steps instead of the
+// 2 * (members.size() - 1) steps of the ring, so it is used for tensors that
+// are small enough to be latency bound, or too small to be split in a ring.
+template <typename T>
+class TreeAllReduce : public ReferenceCounted<TreeAllReduce<T>> {
+ public:
+  TreeAllReduce(DistributedContext* dist_ctx, const InstanceKey& instance_key,
+                const std::string& collective_group_name,
+                llvm::SmallVector<TaskHandle, 8> members, int my_index,
+                llvm::StringRef data, ElementWiseReductionFunction reduction_fn,
+                ElementWiseFinalFunction final_fn,
+                RCReference<RefCountedCallback> done)
+      : dist_ctx_(dist_ctx),
+        key_prefix_(StrCat(collective_group_name, ":", instance_key)),
+        members_(std::move(members)),
+        rank_(my_index),
+        data_(const_cast<char*>(data.data())),
+        size_(data.size()),
+        reduction_fn_(std::move(reduction_fn)),
+        final_fn_(std::move(final_fn)),
+        done_(std::move(done)) {}
+
+  // Reduces the data of the subtrees rooted at this task, starting with the
+  // subtree of size `mask`.
+  void Reduce(int mask) {
+    const int group_size = members_.size();
+    for (; mask < group_size; mask <<= 1) {
+      if (rank_ & mask) {
+        // Send the reduced subtree to the parent and wait for the result.
+        Send(rank_ - mask, StrCat(key_prefix_, ":tree_reduce:", mask),
+             /*partial_result=*/true);
+        dist_ctx_->GetCallbackRegistry()->SetCallback(
+            StrCat(key_prefix_, ":tree_broadcast"),
+            [self = FormRef(this), mask](const InstanceKey&,
+                                         Payload payload) {
+              const HostBuffer& buffer = *payload.buffers[0];
+              std::copy(static_cast<const char*>(buffer.data()),
+                        static_cast<const char*>(buffer.data()) + self->size_,
+                        self->data_);
+              self->Broadcast(mask >> 1);
+            });
+        return;
+      }
+      if (rank_ + mask < group_size) {
+        // Reduce the subtree of the child, then continue with larger ones.
+        dist_ctx_->GetCallbackRegistry()->SetCallback(
+            StrCat(key_prefix_, ":tree_reduce:", mask),
+            [self = FormRef(this), mask](const InstanceKey&,
+                                         Payload payload) {
+              self->reduction_fn_(self->data_,
+                                  static_cast<const char*>(
+                                      payload.buffers[0]->data()),
+                                  self->size_);
+              self->Reduce(mask << 1);
+            });
+        return;
+      }
+    }
+    // This is the root, and the data of the whole group has been reduced.
+    final_fn_(data_, size_, group_size);
+    Broadcast(mask >> 1);
+  }
+
+ private:
+  // Sends the result to the children of this task, starting with the child
+  // at distance `mask`.
+  void Broadcast(int mask) {
+    for (; mask > 0; mask >>= 1) {
+      if (rank_ + mask < members_.size())
+        Send(rank_ + mask, StrCat(key_prefix_, ":tree_broadcast"),
+             /*partial_result=*/false);
+    }
+  }
+
+  void Send(int rank, const InstanceKey& key, bool partial_result) {
+    SendCollectiveData<T>(dist_ctx_, members_[rank], key,
+                          llvm::StringRef(data_, size_), partial_result,
+                          done_.CopyRef());
+  }
+
+  DistributedContext* dist_ctx_;
+  const std::string key_prefix_;
+  const llvm::SmallVector<TaskHandle, 8> members_;
+  const int rank_;
+  char* const data_;
+  const size_t size_;
+  ElementWiseReductionFunction reduction_fn_;
+  ElementWiseFinalFunction final_fn_;
+  RCReference<RefCountedCallback> done_;
+};
+
+// Tensors up to this size are reduced with the latency optimal tree
+// all-reduce, larger ones with the bandwidth optimal ring all-reduce.
+constexpr size_t kTreeAllReduceMaxBytes = 64 << 10;
+
+// Large tensors are reduced in up to this many chunks of at least
+// kMinPipelineChunkBytes, with a ring per chunk. The rings run concurrently,
+// so the reduction of one chunk overlaps with the transfer of the others.
+constexpr size_t kMaxPipelineChunks = 4;
+constexpr size_t kMinPipelineChunkBytes = 1 << 20;
+
+template <typename T>
+void DoAllReduce(const ExecutionContext& exec_ctx,
+                 AsyncValueRef<DistributedContext> dist_ctx,
+                 const InstanceKey& instance_key,
+                 const std::string& collective_group_name,
+                 const DenseHostTensor& in_tensor,
+                 const DenseHostTensor& out_tensor,
+                 ElementWiseReductionFunction reduction_fn,
+                 ElementWiseFinalFunction final_fn,
+                 AsyncValueRef<Chain> out_chain) {
+  const auto& collective_group =
+      dist_ctx->GetCollectiveGroup(collective_group_name);
+  const llvm::SmallVector<TaskHandle, 8> members =
+      TopologyOrder(dist_ctx.get(), collective_group.members);
+  const int my_index = FindMyIndex(members, dist_ctx->GetTaskHandle());
+  if (my_index == -1) {
+    out_chain.SetError(StrCat("The current task ", dist_ctx->GetTaskName(),
+                              " is not part of the collective group ",
+                              collective_group_name));
+    return;
+  }
+
+  auto done = [out_chain = out_chain.CopyRef(),
+               dist_ctx = dist_ctx.CopyRef()](Error e) mutable {
+    if (e) {
+      out_chain.SetError(absl::InternalError(toString(std::move(e))));
+    } else {
+      out_chain.emplace();
+    }
+  };
+
+  // Ref counted callback to keep track of pending steps in all reduce.
+  // Add one ref before starting each step, and drop one ref when the step
+  // finishes (for steps with async RPCs, drop the reference when RPC finishes).
+  auto refcounted_done = TakeRef(
+      new RefCountedCallback([host = dist_ctx->GetHostContext(), exec_ctx,
+                              done = std::move(done)](Error e) mutable {
+        // NOTE: we might be executing this in either HostContext work queue
+        // threads or the FabricCommunicator callback threads. Must make sure
+        // AsyncValue Chain gets emplaced (or set error) in the work queue
+        // threadpool, so that:
+        //   * subsequent operations (i.e., AndThen) for this AsyncValue are
+        //     executed in the work queue threads;
+        //   * the AsyncValue drops its last ref and gets deallocated in the
+        //     work queue threads
+        // Otherwise, the HostContext might get destroyed before the AsyncValue
+        // is deallocated or finishes its AndThen work, leading to segfault.
+        if (host->IsInWorkerThread()) {
+          done(std::move(e));
+        } else {
+          EnqueueWork(exec_ctx,
+                      [done = std::move(done), e = std::move(e)]() mutable {
+                        done(std::move(e));
+                      });
+        }
+      }));
+
+  auto in_tensor_ref =
+      llvm::StringRef(reinterpret_cast<const char*>(in_tensor.data()),
+                      in_tensor.DataSizeInBytes());
+  const size_t num_elements = in_tensor.NumElements();
+
+  // The ring needs at least one element per member.
+  if (in_tensor_ref.size() <= kTreeAllReduceMaxBytes ||
+      num_elements < members.size()) {
+    TakeRef(new TreeAllReduce<T>(dist_ctx.get(), instance_key,
+                                 collective_group_name, members, my_index,
+                                 in_tensor_ref, std::move(reduction_fn),
+                                 std::move(final_fn),
+                                 std::move(refcounted_done)))
+        ->Reduce(/*mask=*/1);
+    return;
+  }
+
+  size_t num_chunks = std::min(
+      kMaxPipelineChunks,
+      std::max<size_t>(1, in_tensor_ref.size() / kMinPipelineChunkBytes));
+  num_chunks = std::min(num_chunks, num_elements / members.size());
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    llvm::StringRef chunk_data =
+        GetSplit<T>(in_tensor_ref, num_chunks, num_elements, chunk);
+    DoRingAllReduce<T>(dist_ctx.get(), StrCat(instance_key, ":", chunk),
+                       collective_group_name, members, my_index, chunk_data,
+                       chunk_data.size() / sizeof(T), reduction_fn, final_fn,
+                       refcounted_done.CopyRef());
+  }
+}
+
 template <typename T>
 void AllReduce(Argument<DistributedContext> dist_context,
                Argument<std::string> collective_group_name,
@@ -377,6 +594,7 @@ void DoBroadcast(AsyncValueRef<DistributedContext> dist_ctx,
   auto* registry = dist_ctx->GetCallbackRegistry();
   RemoteClientInterface* neighbor_client =
       dist_ctx->GetRemoteClient(neighbor_task);
+  const PayloadCodec codec = dist_ctx->GetPayloadCodec();
 
   auto refcounted_done = TakeRef(
       new RefCountedCallback([out_chain = out_chain.CopyRef(),
@@ -397,7 +615,7 @@ void DoBroadcast(AsyncValueRef<DistributedContext> dist_ctx,
     if (my_task == sender) {
       // A Sender sends data to its neighbor.
       auto payload = GetSplit<T>(in_tensor, kGroupSize, num_elements, i);
-      request->add_payload(payload.data(), payload.size());
+      SetPayload(codec, payload, request.get());
       neighbor_client->SendDataAsync(
           RemoteCallContext::GetDefault(), request.get(), response.get(),
           [request = std::move(request), response = std::move(response),
@@ -407,8 +625,8 @@ void DoBroadcast(AsyncValueRef<DistributedContext> dist_ctx,
     } else {
       registry->SetCallback(
           StepKey(kPrefix, chunk_key, my_index),
-          [sender, i, in_tensor, kGroupSize, neighbor_task, num_elements,
-           neighbor_client, request = std::move(request),
+          [codec, sender, i, in_tensor, kGroupSize, neighbor_task,
+           num_elements, neighbor_client, request = std::move(request),
            response = std::move(response), refcounted_done = refcounted_done](
               const InstanceKey&,
               CallbackRegistry::CallbackValue callback_value) mutable {
@@ -420,7 +638,10 @@ void DoBroadcast(AsyncValueRef<DistributedContext> dist_ctx,
                           GetSplit<T>(in_tensor, kGroupSize, num_elements, i)
                               .begin()));
             if (neighbor_task != sender) {
-              request->add_payload(data->data(), data->size());
+              SetPayload(codec,
+                         string_view(static_cast<char*>(data->data()),
+                                     data->size()),
+                         request.get());
               neighbor_client->SendDataAsync(
                   RemoteCallContext::GetDefault(), request.get(),
                   response.get(),
@@ -500,6 +721,7 @@ void DoAllGather(
   auto* registry = dist_ctx->GetCallbackRegistry();
   RemoteClientInterface* neighbor_client =
       dist_ctx->GetRemoteClient(kNeighborId);
+  const PayloadCodec codec = dist_ctx->GetPayloadCodec();
 
   for (size_t ring_order = 0; ring_order < kGroupSize; ++ring_order) {
     const auto chunk_key = StepKey(kPrefix, instance_key, ring_order);
@@ -514,7 +736,7 @@ void DoAllGather(
                   out_tensor_ref + offsets[my_index][i] * sizeof(T));
         src_pos += step_sizes[my_index] * sizeof(T);
       }
-      request->add_payload(in_tensor_ref.data(), in_tensor_ref.size());
+      SetPayload(codec, in_tensor_ref, request.get());
       neighbor_client->SendDataAsync(
           RemoteCallContext::GetDefault(), request.get(), response.get(),
           [request = std::move(request), response = std::move(response),
@@ -525,8 +747,8 @@ void DoAllGather(
     } else {
       registry->SetCallback(
           StepKey(kPrefix, chunk_key, my_index),
-          [ring_order, offsets, step_sizes, out_tensor_ref, kNeighborIndex,
-           neighbor_client, request = std::move(request),
+          [codec, ring_order, offsets, step_sizes, out_tensor_ref,
+           kNeighborIndex, neighbor_client, request = std::move(request),
            response = std::move(response), refcounted_done = refcounted_done](
               const InstanceKey&,
               CallbackRegistry::CallbackValue callback_value) mutable {
@@ -539,7 +761,10 @@ void DoAllGather(
               src_pos += step_sizes[ring_order] * sizeof(T);
             }
             if (ring_order != kNeighborIndex) {
-              request->add_payload(data->data(), data->size());
+              SetPayload(codec,
+                         string_view(static_cast<char*>(data->data()),
+                                     data->size()),
+                         request.get());
               neighbor_client->SendDataAsync(
                   RemoteCallContext::GetDefault(), request.get(),
                   response.get(),
@@ -947,15 +1172,22 @@ void RemoteRegisterKernelHelper(Chain ch, DistributedContext* dist_context,
   results[0] = out;
 
   EnqueueWork(exec_ctx, [remote_client, request = std::move(request),
-                         dist_context, need_compilation, out = out]() mutable {
+                         dist_context, receiver, need_compilation,
+                         out = out]() mutable {
     auto response = std::make_unique<RegisterFunctionResponse>();
     remote_client->RegisterFunctionAsync(
         RemoteCallContext::GetDefault(), request.get(), response.get(),
         [request = std::move(request), response = std::move(response),
-         need_compilation, dist_context, out = out](Error e) mutable {
+         need_compilation, dist_context, receiver, out = out](Error e) mutable {
           if (e) {
             out->SetError(absl::InternalError(toString(std::move(e))));
           } else {
+            // Later remote executions refer to the program by its handle.
+            if (response->program_handle() != 0) {
+              dist_context->SetRemoteProgramHandle(
+                  receiver, request->program_name(),
+                  response->program_handle());
+            }
             if (need_compilation) {
               DeviceManager* manager = dist_context->GetRemoteDeviceManager();
               llvm::SmallVector<RCReference<Device>, 4> output_devices;
@@ -1014,6 +1246,45 @@ AsyncValueRef<RemoteExecuteSpec> CreateRemoteExecuteSpec(
       std::move(output_devices));
 }
 
+// Locally available inputs of at most this size are pushed with the remote
+// execute request.
+constexpr size_t kMaxInlineInputBytes = 1 << 20;
+
+// Pushes the input `index` with `request` if it is a DenseHostTensor that is
+// available locally, so that the remote task doesn't have to wait for it to be
+// transferred. If `input_cache` is set, inputs that `receiver` already keeps
+// are referred to by key instead, and the acquired keys are appended to
+// `cache_keys`.
+static void MaybeInlineInput(RemoteObjectManager* manager,
+                             RemoteInputCache* input_cache,
+                             TaskHandle receiver, const RemoteObjectId& id,
+                             int index, RemoteExecuteRequest* request,
+                             llvm::SmallVectorImpl<uint64_t>* cache_keys) {
+  RCReference<AsyncValue> value = manager->FindRemoteObject(id);
+  if (!value || !value->IsConcrete() || !value->IsType<DenseHostTensor>())
+    return;
+  const DenseHostTensor& dht = value->get<DenseHostTensor>();
+  if (dht.DataSizeInBytes() > kMaxInlineInputBytes) return;
+
+  auto* inline_input = request->add_inline_input();
+  inline_input->set_index(index);
+  if (input_cache) {
+    RemoteInputCache::Decision decision =
+        input_cache->Acquire(receiver, id, dht.DataSizeInBytes());
+    if (decision.action != RemoteInputCache::Action::kPush) {
+      cache_keys->push_back(decision.key);
+      inline_input->set_cache_key(decision.key);
+    }
+    if (decision.action == RemoteInputCache::Action::kReference) {
+      inline_input->set_cached(true);
+      return;
+    }
+  }
+  inline_input->set_metadata(SerializeTensorMetadata(dht.metadata()));
+  inline_input->set_data(static_cast<const char*>(dht.data()),
+                         dht.DataSizeInBytes());
+}
+
 void RemoteExecute(Chain ch, DistributedContext* dist_context,
                    const TaskHandle receiver, Argument<RemoteExecuteSpec> spec,
                    RemainingArguments inputs, RemainingResults results,
@@ -1027,14 +1298,23 @@ void RemoteExecute(Chain ch, DistributedContext* dist_context,
   // program_name will live as long as out_chain is not populated.
   request->set_context_id(dist_context->GetContextId());
   request->set_program_name(program_name.str());
+  request->set_program_handle(
+      dist_context->GetRemoteProgramHandle(receiver, program_name.get()));
   request->mutable_input()->Reserve(num_fn_inputs);
+  // Output metadata is streamed back as soon as each output is available.
+  request->set_stream_outputs_to(dist_context->GetTaskName().str());
 
+  RemoteObjectManager* manager = dist_context->GetRemoteObjectManager();
+  RemoteInputCache* input_cache = dist_context->GetRemoteInputCache();
+  llvm::SmallVector<uint64_t, 4> cache_keys;
   for (int i = 0; i < num_fn_inputs; ++i) {
     const RemoteObjectId& input = inputs[i]->get<RemoteObjectId>();
     auto* add_input = request->add_input();
     add_input->set_prefix_id(input.prefix_id);
     add_input->set_local_id(input.local_id);
     add_input->set_device(input.device->name().str());
+    MaybeInlineInput(manager, input_cache, receiver, input, i, request.get(),
+                     &cache_keys);
   }
   // First output: chain
   AsyncValueRef<Chain> out_chain = MakeConstructedAsyncValueRef<Chain>();
@@ -1048,6 +1328,9 @@ void RemoteExecute(Chain ch, DistributedContext* dist_context,
     out_chain.SetError(absl::InvalidArgumentError(StrCat(
         "Mismatch output devices size in RemoteExecuteSpec: ",
         spec->output_devices.size(), " expected: ", results.size() - 1)));
+    // The request is not sent, so the inputs were not pushed.
+    for (uint64_t key : cache_keys)
+      input_cache->Release(receiver, key, /*ok=*/false);
     return;
   }
 
@@ -1065,7 +1348,6 @@ void RemoteExecute(Chain ch, DistributedContext* dist_context,
   // If output id is allocated, we only return TensorHandles.
   const int th_output_idx = output_id_allocated ? 0 : num_fn_output;
   request->mutable_output()->Reserve(num_fn_output);
-  RemoteObjectManager* manager = dist_context->GetRemoteObjectManager();
   struct RemoteObjectAndMetadata {
     AsyncValueRef<RemoteObjectId> id;
     AsyncValueRef<RemoteTensor> tensor;
@@ -1108,34 +1390,72 @@ void RemoteExecute(Chain ch, DistributedContext* dist_context,
     add_output_id->set_device(out_id->device->name().str());
   }
 
+  // Propagate the streamed metadata of each output as soon as it arrives. An
+  // empty payload means that the metadata was not returned.
+  CallbackRegistry* registry = dist_context->GetCallbackRegistry();
+  for (RemoteObjectAndMetadata& obj : remote_objs) {
+    registry->SetCallback(
+        RemoteExecuteOutputKey(obj.id->prefix_id, obj.id->local_id),
+        [obj = RemoteObjectAndMetadata{obj.id.CopyRef(), obj.tensor.CopyRef(),
+                                       obj.metadata.CopyRef()}](
+            const InstanceKey& key, Payload value) mutable {
+          if (value.buffers.empty()) {
+            obj.metadata.SetError(absl::InternalError("Metadata not returned"));
+            obj.tensor.SetError(absl::InternalError("Metadata not returned"));
+            return;
+          }
+          const HostBuffer& buffer = *value.buffers[0];
+          auto metadata = DeserializeTensorMetadata(
+              string_view(static_cast<const char*>(buffer.data()),
+                          buffer.size()));
+          if (metadata) {
+            obj.metadata.emplace(metadata.get());
+            obj.tensor.emplace(std::move(metadata.get()), obj.id.get());
+          } else {
+            auto error = absl::InternalError(toString(metadata.takeError()));
+            obj.metadata.SetError(error);
+            obj.tensor.SetError(error);
+          }
+        });
+  }
+
+  if (input_cache) {
+    request->set_input_cache_id(dist_context->GetTaskHandle().get_value());
+    for (uint64_t key : input_cache->TakeEvictedKeys(receiver))
+      request->add_evicted_cache_keys(key);
+  }
+
   RemoteClientInterface* remote_client =
       dist_context->GetRemoteClient(receiver);
   EnqueueWork(exec_ctx, [remote_client, request = std::move(request),
-                         dist_context, out_chain = out_chain.CopyRef(),
-                         remote_objs = std::move(remote_objs)]() mutable {
+                         dist_context, receiver,
+                         out_chain = out_chain.CopyRef(),
+                         remote_objs = std::move(remote_objs),
+                         cache_keys = std::move(cache_keys)]() mutable {
     auto response = std::make_unique<RemoteExecuteResponse>();
+    RemoteCallTrace trace;
+    if (trace.IsActive()) trace.StartCall(request->mutable_trace_context());
     remote_client->RemoteExecuteAsync(
         RemoteCallContext::GetDefault(), request.get(), response.get(),
         [request = std::move(request), response = std::move(response),
          out_chain = out_chain.CopyRef(), remote_objs = std::move(remote_objs),
-         host_context = dist_context->GetHostContext()](Error e) mutable {
-          // Propagate metadata and output chain
-          const int num_metadata = response->metadata_size();
-          for (int i = 0; i < remote_objs.size(); ++i) {
-            auto& obj = remote_objs[i];
-            if (i >= num_metadata) {
-              obj.metadata.SetError(
-                  absl::InternalError("Metadata not returned"));
-              continue;
-            }
-            auto metadata = DeserializeTensorMetadata(response->metadata(i));
-            if (metadata) {
-              obj.metadata.emplace(metadata.get());
-              obj.tensor.emplace(std::move(metadata.get()), obj.id.get());
-            } else {
-              obj.tensor.SetError(
-                  absl::InternalError(toString(metadata.takeError())));
-            }
+         dist_context, receiver, cache_keys = std::move(cache_keys),
+         trace](Error e) mutable {
+          for (uint64_t key : cache_keys) {
+            dist_context->GetRemoteInputCache()->Release(receiver, key,
+                                                         /*ok=*/!e);
+          }
+          if (!e) {
+            trace.FinishCall(StrCat("RemoteExecute:", request->program_name()),
+                             response->server_timing());
+          }
+          // All streamed metadata has been delivered before the response.
+          // Fail the outputs whose metadata was not streamed.
+          for (auto& obj : remote_objs) {
+            if (!obj.metadata.IsUnavailable()) continue;
+            dist_context->GetCallbackRegistry()->SetValue(
+                RemoteExecuteOutputKey(obj.id->prefix_id, obj.id->local_id),
+                Payload({}));
           }
           if (e) {
             out_chain.SetError(absl::InternalError(toString(std::move(e))));
@@ -1202,20 +1522,16 @@ void SendBytes(Argument<DistributedContext> dist_context,
                Argument<InstanceKey> instance_key, Argument<Payload> serialized,
                Result<Chain> out_chain, const ExecutionContext& exec_ctx) {
   auto out_chain_indirect = out_chain.Allocate();
-  auto request = std::make_unique<SendDataRequest>();
-  auto response = std::make_unique<SendDataResponse>();
-  request->set_context_id(dist_context->GetContextId());
-  request->set_instance_key(*instance_key);
-  const int kNumBuffers = serialized->buffers.size();
-  for (size_t i = 0; i < kNumBuffers; ++i) {
-    request->add_payload(serialized->buffers[i]->data(),
-                         serialized->buffers[i]->size());
-  }
+  // Share the buffers with the remote client, which copies them only if it
+  // can't pass host buffers to the receiver.
+  llvm::SmallVector<RCReference<HostBuffer>, 4> buffers;
+  for (const RCReference<HostBuffer>& buffer : serialized->buffers)
+    buffers.push_back(buffer.CopyRef());
   dist_context->GetRemoteClient(*receiver_task)
-      ->SendDataAsync(
-          RemoteCallContext::GetDefault(), request.get(), response.get(),
-          [request = std::move(request), response = std::move(response),
-           dist_context = dist_context.ValueRef(),
+      ->SendPayloadAsync(
+          RemoteCallContext::GetDefault(), dist_context->GetContextId(),
+          *instance_key, Payload(std::move(buffers)),
+          [dist_context = dist_context.ValueRef(),
            out_chain = out_chain_indirect.CopyRef()](Error e) {
             if (e) {
               out_chain.SetError(absl::InternalError(toString(std::move(e))));
@@ -1249,6 +1565,10 @@ void Deserialize(Argument<Payload> serialized_dht, Result<DenseHostTensor> dht,
                  const ExecutionContext& exec_ctx) {
   auto t =
       DeserializeDenseHostTensor(serialized_dht.get().buffers, exec_ctx.host());
+  if (!t) {
+    dht.Set(EmitErrorAsync(exec_ctx, t.takeError()));
+    return;
+  }
   dht.Emplace(std::move(*t));
 }
 
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//===- payload_codec.cc - Payload Codec -----------------------------------===//
+//
+// This file contains the implementation of the payload codecs.
+
+#include "tfrt/distributed_runtime/payload_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "tfrt/support/bf16.h"
+#include "tfrt/support/fp16.h"
+#include "tfrt/support/string_util.h"
+#include "zlib.h"
+
+namespace tfrt {
+namespace {
+
+// ZLIB payloads start with the size of the decoded data.
+using DecodedSize = uint64_t;
+
+// INT8 payloads start with the scale of the quantized values.
+using Int8Scale = float;
+
+Error EncodeZlib(string_view data, std::string* output) {
+  const size_t offset = output->size();
+  uLongf size = compressBound(data.size());
+  output->resize(offset + sizeof(DecodedSize) + size);
+  DecodedSize decoded_size = data.size();
+  std::memcpy(&(*output)[offset], &decoded_size, sizeof(decoded_size));
+  int status = compress2(
+      reinterpret_cast<Bytef*>(&(*output)[offset + sizeof(DecodedSize)]),
+      &size, reinterpret_cast<const Bytef*>(data.data()), data.size(),
+      Z_BEST_SPEED);
+  if (status != Z_OK) {
+    output->resize(offset);
+    return llvm::make_error<UnknownErrorInfo>(
+        StrCat("zlib compression failed with status ", status));
+  }
+  output->resize(offset + sizeof(DecodedSize) + size);
+  return Error::success();
+}
+
+// Encodes float32 `values` with a lossy codec.
+void EncodeFloats(PayloadCodec codec, llvm::ArrayRef<float> values,
+                  std::string* output) {
+  const size_t offset = output->size();
+  switch (codec) {
+    case PAYLOAD_CODEC_BF16:
+      output->resize(offset + values.size() * sizeof(bf16));
+      ConvertBuffer(values.data(), reinterpret_cast<bf16*>(&(*output)[offset]),
+                    values.size());
+      return;
+    case PAYLOAD_CODEC_FP16:
+      output->resize(offset + values.size() * sizeof(fp16));
+      ConvertBuffer(values.data(), reinterpret_cast<fp16*>(&(*output)[offset]),
+                    values.size());
+      return;
+    case PAYLOAD_CODEC_INT8: {
+      float max_abs = 0;
+      for (float value : values) max_abs = std::max(max_abs, std::abs(value));
+      Int8Scale scale = max_abs / 127;
+      output->resize(offset + sizeof(scale) + values.size());
+      std::memcpy(&(*output)[offset], &scale, sizeof(scale));
+      auto* quantized =
+          reinterpret_cast<int8_t*>(&(*output)[offset + sizeof(scale)]);
+      const float inverse_scale = scale > 0 ? 1 / scale : 0;
+      for (size_t i = 0; i < values.size(); ++i)
+        quantized[i] = static_cast<int8_t>(std::lrint(
+            std::min(std::max(values[i] * inverse_scale, -127.f), 127.f)));
+      return;
+    }
+    default:
+      assert(false && "not a lossy payload codec");
+  }
+}
+
+// Returns the number of float32 values encoded in `data`.
+size_t NumEncodedFloats(PayloadCodec codec, string_view data) {
+  switch (codec) {
+    case PAYLOAD_CODEC_BF16:
+      return data.size() / sizeof(bf16);
+    case PAYLOAD_CODEC_FP16:
+      return data.size() / sizeof(fp16);
+    case PAYLOAD_CODEC_INT8:
+      return data.size() < sizeof(Int8Scale) ? 0
+                                             : data.size() - sizeof(Int8Scale);
+    default:
+      return 0;
+  }
+}
+
+// Decodes float32 values encoded with a lossy codec into `values`, which has
+// NumEncodedFloats() elements.
+void DecodeFloats(PayloadCodec codec, string_view data,
+                  llvm::MutableArrayRef<float> values) {
+  switch (codec) {
+    case PAYLOAD_CODEC_BF16: {
+      // Payloads of requests are not aligned.
+      std::vector<bf16> encoded(values.size());
+      std::memcpy(encoded.data(), data.data(), values.size() * sizeof(bf16));
+      ConvertBuffer(encoded.data(), values.data(), values.size());
+      return;
+    }
+    case PAYLOAD_CODEC_FP16: {
+      std::vector<fp16> encoded(values.size());
+      std::memcpy(encoded.data(), data.data(), values.size() * sizeof(fp16));
+      ConvertBuffer(encoded.data(), values.data(), values.size());
+      return;
+    }
+    case PAYLOAD_CODEC_INT8: {
+      Int8Scale scale;
+      std::memcpy(&scale, data.data(), sizeof(scale));
+      auto* quantized =
+          reinterpret_cast<const int8_t*>(data.data() + sizeof(scale));
+      for (size_t i = 0; i < values.size(); ++i)
+        values[i] = quantized[i] * scale;
+      return;
+    }
+    default:
+      assert(false && "not a lossy payload codec");
+  }
+}
+
+// Returns `data` as float32 values, copying it if it is not aligned.
+llvm::ArrayRef<float> AsFloats(string_view data, std::vector<float>* copy) {
+  const size_t num_values = data.size() / sizeof(float);
+  if (reinterpret_cast<uintptr_t>(data.data()) % alignof(float) == 0)
+    return {reinterpret_cast<const float*>(data.data()), num_values};
+  copy->resize(num_values);
+  std::memcpy(copy->data(), data.data(), num_values * sizeof(float));
+  return *copy;
+}
+
+Error CheckFloats(string_view data) {
+  if (data.size() % sizeof(float) == 0) return Error::success();
+  return llvm::make_error<InvalidArgumentErrorInfo>(
+      StrCat("lossy payload codecs require float32 data, got ", data.size(),
+             " bytes"));
+}
+
+}  // namespace
+
+bool IsLossyPayloadCodec(PayloadCodec codec) {
+  return codec == PAYLOAD_CODEC_BF16 || codec == PAYLOAD_CODEC_FP16 ||
+         codec == PAYLOAD_CODEC_INT8;
+}
+
+Error EncodePayload(PayloadCodec codec, string_view data, std::string* output) {
+  if (codec == PAYLOAD_CODEC_NONE) {
+    output->append(data.data(), data.size());
+    return Error::success();
+  }
+  if (codec == PAYLOAD_CODEC_ZLIB) return EncodeZlib(data, output);
+  if (!IsLossyPayloadCodec(codec)) {
+    return llvm::make_error<InvalidArgumentErrorInfo>(
+        StrCat("unknown payload codec ", codec));
+  }
+  if (auto error = CheckFloats(data)) return error;
+  std::vector<float> copy;
+  EncodeFloats(codec, AsFloats(data, &copy), output);
+  return Error::success();
+}
+
+Expected<RCReference<HostBuffer>> DecodePayload(PayloadCodec codec,
+                                                string_view data,
+                                                size_t alignment,
+                                                HostAllocator* allocator) {
+  if (codec == PAYLOAD_CODEC_NONE) {
+    auto buffer =
+        HostBuffer::CreateUninitialized(data.size(), alignment, allocator);
+    std::copy(data.begin(), data.end(), static_cast<char*>(buffer->data()));
+    return std::move(buffer);
+  }
+
+  if (codec == PAYLOAD_CODEC_ZLIB) {
+    DecodedSize decoded_size;
+    if (data.size() < sizeof(decoded_size))
+      return llvm::make_error<InvalidArgumentErrorInfo>("truncated payload");
+    std::memcpy(&decoded_size, data.data(), sizeof(decoded_size));
+    data = data.drop_front(sizeof(decoded_size));
+    auto buffer =
+        HostBuffer::CreateUninitialized(decoded_size, alignment, allocator);
+    uLongf size = decoded_size;
+    int status = uncompress(static_cast<Bytef*>(buffer->data()), &size,
+                            reinterpret_cast<const Bytef*>(data.data()),
+                            data.size());
+    if (status != Z_OK || size != decoded_size) {
+      return llvm::make_error<InvalidArgumentErrorInfo>(
+          StrCat("zlib decompression failed with status ", status));
+    }
+    return std::move(buffer);
+  }
+
+  if (!IsLossyPayloadCodec(codec)) {
+    return llvm::make_error<InvalidArgumentErrorInfo>(
+        StrCat("unknown payload codec ", codec));
+  }
+  const size_t num_values = NumEncodedFloats(codec, data);
+  auto buffer = HostBuffer::CreateUninitialized(num_values * sizeof(float),
+                                                alignment, allocator);
+  DecodeFloats(codec, data,
+               {static_cast<float*>(buffer->data()), num_values});
+  return std::move(buffer);
+}
+
+void SetPayload(PayloadCodec codec, string_view data,
+                SendDataRequest* request) {
+  assert(request->payload_size() == 0);
+  std::string* payload = request->add_payload();
+  if (codec != PAYLOAD_CODEC_NONE) {
+    if (auto error = EncodePayload(codec, data, payload)) {
+      llvm::consumeError(std::move(error));
+      payload->clear();
+    } else if (IsLossyPayloadCodec(codec) || payload->size() < data.size()) {
+      request->set_codec(codec);
+      return;
+    } else {
+      payload->clear();
+    }
+  }
+  payload->assign(data.data(), data.size());
+  request->set_codec(PAYLOAD_CODEC_NONE);
+}
+
+Expected<Payload> DecodePayloads(const SendDataRequest& request,
+                                 size_t alignment, HostAllocator* allocator) {
+  llvm::SmallVector<RCReference<HostBuffer>, 4> buffers;
+  for (const std::string& data : request.payload()) {
+    auto buffer = DecodePayload(request.codec(), data, alignment, allocator);
+    if (!buffer) return buffer.takeError();
+    buffers.push_back(std::move(*buffer));
+  }
+  return Payload(std::move(buffers));
+}
+
+void GradientCompressor::SetPayload(string_view key, string_view data,
+                                    SendDataRequest* request) {
+  if (!IsLossyPayloadCodec(codec_) || data.size() % sizeof(float) != 0) {
+    tfrt::SetPayload(codec_, data, request);
+    return;
+  }
+
+  std::vector<float>* residual;
+  {
+    mutex_lock lock(mu_);
+    residual = &residuals_[key];
+  }
+  const size_t num_values = data.size() / sizeof(float);
+  // The residual of a gradient with a different size is stale.
+  if (residual->size() != num_values) residual->assign(num_values, 0);
+
+  std::vector<float> values(num_values);
+  std::memcpy(values.data(), data.data(), data.size());
+  for (size_t i = 0; i < num_values; ++i) values[i] += (*residual)[i];
+
+  assert(request->payload_size() == 0);
+  std::string* payload = request->add_payload();
+  EncodeFloats(codec_, values, payload);
+  request->set_codec(codec_);
+
+  // Keep the compression error for the next gradient with this key.
+  DecodeFloats(codec_, *payload, *residual);
+  for (size_t i = 0; i < num_values; ++i)
+    (*residual)[i] = values[i] - (*residual)[i];
+}
+
+}  // namespace tfrt
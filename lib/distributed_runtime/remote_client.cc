@@ -0,0 +1,45 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//===- remote_client.cc - Remote Client -----------------------------------===//
+//
+// This file contains the default implementations of the remote client methods.
+
+#include "tfrt/distributed_runtime/remote_client.h"
+
+#include <memory>
+
+namespace tfrt {
+
+void RemoteClientInterface::SendPayloadAsync(RemoteCallContext* call_ctx,
+                                             uint64_t context_id,
+                                             string_view instance_key,
+                                             Payload payload, CallbackFn done) {
+  auto request = std::make_unique<SendDataRequest>();
+  auto response = std::make_unique<SendDataResponse>();
+  request->set_context_id(context_id);
+  request->set_instance_key(instance_key.str());
+  request->mutable_payload()->Reserve(payload.buffers.size());
+  for (const RCReference<HostBuffer>& buffer : payload.buffers)
+    request->add_payload(buffer->data(), buffer->size());
+
+  SendDataAsync(call_ctx, request.get(), response.get(),
+                [request = std::move(request), response = std::move(response),
+                 done = std::move(done)](Error e) mutable {
+                  done(std::move(e));
+                });
+}
+
+}  // namespace tfrt
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//===- remote_input_cache.cc - Remote Input Cache -------------------------===//
+//
+// This file contains the implementation of the remote input cache.
+
+#include "tfrt/distributed_runtime/remote_input_cache.h"
+
+#include <cassert>
+#include <iterator>
+
+namespace tfrt {
+
+RemoteInputCache::Decision RemoteInputCache::Acquire(TaskHandle task,
+                                                     const RemoteObjectId& id,
+                                                     size_t size_bytes) {
+  const ObjectKey object_key(id.prefix_id, id.local_id);
+  mutex_lock lock(mu_);
+  TaskCache& cache = tasks_[task];
+
+  auto found = cache.by_id.find(object_key);
+  if (found != cache.by_id.end()) {
+    auto it = found->second;
+    // The push of the input is still in flight, or the input is going away.
+    if (!it->resident || it->dropped) return {Action::kPush, 0};
+    ++it->num_pending;
+    cache.inputs.splice(cache.inputs.begin(), cache.inputs, it);
+    return {Action::kReference, it->key};
+  }
+
+  if (size_bytes > capacity_bytes_) return {Action::kPush, 0};
+
+  // Make room by evicting the least recently used inputs not in flight.
+  auto next = cache.inputs.end();
+  while (cache.size_bytes + size_bytes > capacity_bytes_ &&
+         next != cache.inputs.begin()) {
+    auto victim = std::prev(next);
+    if (victim->num_pending > 0) {
+      next = victim;
+      continue;
+    }
+    Evict(&cache, victim);
+  }
+  if (cache.size_bytes + size_bytes > capacity_bytes_)
+    return {Action::kPush, 0};
+
+  const uint64_t key = next_key_++;
+  cache.inputs.push_front(CachedInput{object_key, key, size_bytes});
+  auto it = cache.inputs.begin();
+  it->num_pending = 1;
+  cache.by_id[object_key] = it;
+  cache.by_key[key] = it;
+  cache.size_bytes += size_bytes;
+  return {Action::kPushAndCache, key};
+}
+
+void RemoteInputCache::Release(TaskHandle task, uint64_t key, bool ok) {
+  mutex_lock lock(mu_);
+  TaskCache& cache = tasks_[task];
+  auto found = cache.by_key.find(key);
+  if (found == cache.by_key.end()) return;
+  auto it = found->second;
+  assert(it->num_pending > 0);
+  --it->num_pending;
+  if (ok) {
+    it->resident = true;
+  } else {
+    it->dropped = true;
+  }
+  if (it->dropped && it->num_pending == 0) Evict(&cache, it);
+}
+
+std::vector<uint64_t> RemoteInputCache::TakeEvictedKeys(TaskHandle task) {
+  mutex_lock lock(mu_);
+  auto found = tasks_.find(task);
+  if (found == tasks_.end()) return {};
+  std::vector<uint64_t> keys;
+  keys.swap(found->second.evicted_keys);
+  return keys;
+}
+
+void RemoteInputCache::Erase(const RemoteObjectId& id) {
+  const ObjectKey object_key(id.prefix_id, id.local_id);
+  mutex_lock lock(mu_);
+  for (auto& task : tasks_) {
+    TaskCache& cache = task.second;
+    auto found = cache.by_id.find(object_key);
+    if (found == cache.by_id.end()) continue;
+    auto it = found->second;
+    it->dropped = true;
+    if (it->num_pending == 0) Evict(&cache, it);
+  }
+}
+
+void RemoteInputCache::Evict(TaskCache* cache,
+                             std::list<CachedInput>::iterator it) {
+  assert(it->num_pending == 0);
+  cache->size_bytes -= it->size_bytes;
+  cache->by_id.erase(it->id);
+  cache->by_key.erase(it->key);
+  cache->evicted_keys.push_back(it->key);
+  cache->inputs.erase(it);
+}
+
+void RemoteInputStore::Insert(uint64_t sender_id, uint64_t key,
+                              RCReference<AsyncValue> value) {
+  mutex_lock lock(mu_);
+  inputs_[{sender_id, key}] = std::move(value);
+}
+
+RCReference<AsyncValue> RemoteInputStore::Find(uint64_t sender_id,
+                                               uint64_t key) {
+  mutex_lock lock(mu_);
+  auto found = inputs_.find({sender_id, key});
+  if (found == inputs_.end()) return {};
+  return found->second.CopyRef();
+}
+
+void RemoteInputStore::Erase(uint64_t sender_id, ArrayRef<uint64_t> keys) {
+  mutex_lock lock(mu_);
+  for (uint64_t key : keys) inputs_.erase({sender_id, key});
+}
+
+}  // namespace tfrt
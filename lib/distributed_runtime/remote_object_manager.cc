@@ -43,25 +43,46 @@ void RemoteObjectManager::SetRemoteObject(const RemoteObjectId& id,
   cast<IndirectAsyncValue>(val.get())->ForwardTo(value);
 }
 
+RemoteObjectManager::Shard& RemoteObjectManager::GetShard(
+    const RemoteObjectId& id) {
+  return shards_[llvm::DenseMapInfo<RemoteObjectId>::getHashValue(id) %
+                 kNumShards];
+}
+
 RCReference<AsyncValue> RemoteObjectManager::GetRemoteObject(
     const RemoteObjectId& id) {
-  tfrt::mutex_lock lock(mutex_);
-  auto iter = object_maps_.find(id);
-  if (iter != object_maps_.end()) {
+  Shard& shard = GetShard(id);
+  tfrt::mutex_lock lock(shard.mutex);
+  auto iter = shard.object_maps.find(id);
+  if (iter != shard.object_maps.end()) {
     return iter->second;
   }
   RCReference<AsyncValue> value = MakeIndirectAsyncValue();
-  object_maps_[id] = value;
+  shard.object_maps[id] = value;
   return value;
 }
 
+RCReference<AsyncValue> RemoteObjectManager::FindRemoteObject(
+    const RemoteObjectId& id) {
+  Shard& shard = GetShard(id);
+  tfrt::mutex_lock lock(shard.mutex);
+  auto iter = shard.object_maps.find(id);
+  if (iter == shard.object_maps.end()) return {};
+  return iter->second;
+}
+
 // Delete the given remote object ids.
 Error RemoteObjectManager::DeleteRemoteObjects(
     const llvm::SmallVectorImpl<RemoteObjectId>& ids) {
-  tfrt::mutex_lock lock(mutex_);
   std::unique_ptr<ErrorCollection> errors;
   for (const RemoteObjectId& id : ids) {
-    if (!object_maps_.erase(id)) {
+    Shard& shard = GetShard(id);
+    bool erased;
+    {
+      tfrt::mutex_lock lock(shard.mutex);
+      erased = shard.object_maps.erase(id);
+    }
+    if (!erased) {
       if (!errors) {
         errors = std::make_unique<ErrorCollection>();
       }
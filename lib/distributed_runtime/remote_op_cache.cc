@@ -0,0 +1,38 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//===- remote_op_cache.cc - Remote Op Cache -------------------------------===//
+//
+// This file contains the implementation of the remote op cache.
+
+#include "tfrt/distributed_runtime/remote_op_cache.h"
+
+#include <utility>
+
+namespace tfrt {
+
+uint64_t RemoteOpCache::Register(std::unique_ptr<CachedOp> op) {
+  mutex_lock lock(mu_);
+  ops_.push_back(std::move(op));
+  return ops_.size();
+}
+
+const RemoteOpCache::CachedOp* RemoteOpCache::Lookup(uint64_t handle) {
+  mutex_lock lock(mu_);
+  if (handle == 0 || handle > ops_.size()) return nullptr;
+  return ops_[handle - 1].get();
+}
+
+}  // namespace tfrt
@@ -18,6 +18,10 @@
 //
 // This file contains an implementation of RemoteOpHandler.
 
+#include <utility>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "tfrt/core_runtime/core_runtime.h"
 #include "tfrt/core_runtime/op_attrs.h"
 #include "tfrt/core_runtime/op_handler.h"
@@ -27,9 +31,13 @@
 #include "tfrt/distributed_runtime/remote_device.h"
 #include "tfrt/distributed_runtime/remote_object_manager.h"
 #include "tfrt/distributed_runtime/remote_tensor.h"
+#include "tfrt/distributed_runtime/remote_trace.h"
 #include "tfrt/distributed_runtime/task_handle.h"
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/string_util.h"
+#include "tfrt/support/thread_annotations.h"
 #include "tfrt/tensor/tensor_serialize_utils.h"
 
 namespace tfrt {
@@ -100,9 +108,26 @@ class RemoteOpHandler : public OpHandler {
  private:
   void Execute(const std::string& op_name, const OpInvocation& invocation);
 
+  // Returns the handle of `op_name` with `attrs` on the remote task, or 0 if
+  // it is not registered yet. Sets `register_op` if the caller should register
+  // it, which is the case for the first caller only.
+  uint64_t GetOpHandle(const std::string& op_name, const OpAttrsRef& attrs,
+                       bool* register_op);
+
+  // Records the handle of `op_name` with `attrs` on the remote task.
+  void SetOpHandle(const std::string& op_name, const OpAttrsRef& attrs,
+                   uint64_t op_handle);
+
   DistributedContext* dist_ctx_;
   RemoteChainManager* remote_chain_manager_;
   RCReference<RemoteDevice> remote_device_;
+
+  mutex op_handles_mu_;
+  // Handles of the ops registered on the remote task, with their attributes.
+  // A handle of 0 means that the registration is in flight (or failed, in
+  // which case the op keeps being sent in full).
+  llvm::StringMap<llvm::SmallVector<std::pair<OpAttrsRef, uint64_t>, 1>>
+      op_handles_ TFRT_GUARDED_BY(op_handles_mu_);
 };
 
 RemoteOpHandler::RemoteOpHandler(DistributedContext* dist_ctx,
@@ -117,6 +142,29 @@ RemoteOpHandler::RemoteOpHandler(DistributedContext* dist_ctx,
 
 RemoteOpHandler::~RemoteOpHandler() {}
 
+uint64_t RemoteOpHandler::GetOpHandle(const std::string& op_name,
+                                      const OpAttrsRef& attrs,
+                                      bool* register_op) {
+  mutex_lock lock(op_handles_mu_);
+  auto& handles = op_handles_[op_name];
+  for (const auto& handle : handles) {
+    // Frozen attributes are interned, so this is a constant time comparison.
+    if (handle.first == attrs) return handle.second;
+  }
+  handles.emplace_back(attrs, 0);
+  *register_op = true;
+  return 0;
+}
+
+void RemoteOpHandler::SetOpHandle(const std::string& op_name,
+                                  const OpAttrsRef& attrs,
+                                  uint64_t op_handle) {
+  mutex_lock lock(op_handles_mu_);
+  for (auto& handle : op_handles_[op_name]) {
+    if (handle.first == attrs) handle.second = op_handle;
+  }
+}
+
 Expected<CoreRuntimeOp> RemoteOpHandler::MakeOp(string_view op_name) {
   return CoreRuntimeOp(
       [op_name = op_name.str(), this](const OpInvocation& invocation) {
@@ -149,8 +197,19 @@ void RemoteOpHandler::Execute(const std::string& op_name,
 
   auto request = std::make_unique<RemoteExecuteOpRequest>();
   request->set_context_id(dist_ctx_->GetContextId());
-  request->set_op_handler_name(remote_device_->name().str());
-  request->set_op_name(op_name);
+
+  // Ops are sent in full once, and by the handle of their registration on the
+  // remote task afterwards.
+  OpAttrsRef attrs = invocation.attrs.freeze();
+  bool register_op = false;
+  uint64_t op_handle = GetOpHandle(op_name, attrs, &register_op);
+  if (op_handle != 0) {
+    request->set_op_handle(op_handle);
+  } else {
+    request->set_op_handler_name(remote_device_->name().str());
+    request->set_op_name(op_name);
+    request->set_register_op(register_op);
+  }
 
   // Add output object ids to the request.
   // TODO(ayushd): optimize so that metadata is not always asynchronous.
@@ -184,8 +243,10 @@ void RemoteOpHandler::Execute(const std::string& op_name,
   remote_chain_manager_->SetRemoteChain(remote_task, out_chain_id);
 
   // Add op attributes to the request.
-  if (Error attr_error =
-          PopulateRequestAttrsProto(request.get(), invocation.attrs.freeze())) {
+  Error attr_error = Error::success();
+  if (op_handle == 0)
+    attr_error = PopulateRequestAttrsProto(request.get(), attrs);
+  if (attr_error) {
     auto status = absl::InternalError(toString(std::move(attr_error)));
     chain.SetError(status);
     for (auto& output_th : invocation.results) {
@@ -196,9 +257,9 @@ void RemoteOpHandler::Execute(const std::string& op_name,
 
   RunWhenReady(
       to_wait,
-      [dist_ctx = dist_ctx_, arguments = std::move(arguments),
+      [this, dist_ctx = dist_ctx_, arguments = std::move(arguments),
        results = std::move(results), request = std::move(request),
-       attrs = invocation.attrs.freeze(), remote_task = std::move(remote_task),
+       op_name, attrs = std::move(attrs), remote_task = std::move(remote_task),
        chain = std::move(chain)]() mutable {
         // Add input object ids to the request.
         for (auto& input : *arguments) {
@@ -216,11 +277,20 @@ void RemoteOpHandler::Execute(const std::string& op_name,
         auto response = std::make_unique<RemoteExecuteOpResponse>();
         RemoteClientInterface* remote_client =
             dist_ctx->GetRemoteClient(remote_task);
+        RemoteCallTrace trace;
+        if (trace.IsActive()) trace.StartCall(request->mutable_trace_context());
         remote_client->RemoteExecuteOpAsync(
             RemoteCallContext::GetDefault(), request.get(), response.get(),
-            [results = std::move(results), request = std::move(request),
-             response = std::move(response),
-             chain = chain.CopyRef()](Error e) mutable {
+            [this, results = std::move(results), request = std::move(request),
+             response = std::move(response), op_name = std::move(op_name),
+             attrs = std::move(attrs), chain = chain.CopyRef(),
+             trace](Error e) mutable {
+              if (!e) {
+                trace.FinishCall(StrCat("RemoteExecuteOp:", op_name),
+                                 response->server_timing());
+              }
+              if (response->op_handle() != 0)
+                SetOpHandle(op_name, attrs, response->op_handle());
               if (e) {
                 chain.SetError(absl::InternalError(toString(std::move(e))));
                 return;
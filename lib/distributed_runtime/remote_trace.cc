@@ -0,0 +1,104 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Latency breakdown tracing of remote calls
+//
+// This file contains the implementation of the remote call tracing helpers.
+
+#include "tfrt/distributed_runtime/remote_trace.h"
+
+#include <cassert>
+#include <chrono>
+#include <utility>
+
+#include "tfrt/support/random_util.h"
+#include "tfrt/support/string_util.h"
+#include "tfrt/tracing/tracing.h"
+
+namespace tfrt {
+
+int64_t RemoteTraceMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+RemoteCallTrace::RemoteCallTrace() {
+  if (!tracing::IsTracingEnabled(tracing::TracingLevel::Default)) return;
+  // Zero marks calls which are not traced.
+  do {
+    trace_id_ = random::New64();
+  } while (trace_id_ == 0);
+  start_us_ = RemoteTraceMicros();
+}
+
+void RemoteCallTrace::StartCall(TraceContext* trace_context) {
+  assert(IsActive());
+  trace_context->set_trace_id(trace_id_);
+  send_us_ = RemoteTraceMicros();
+}
+
+void RemoteCallTrace::FinishCall(string_view name,
+                                 const ServerTiming& server_timing) {
+  if (!IsActive()) return;
+  const int64_t receive_us = RemoteTraceMicros();
+  // The client and server clocks are not synchronized, so only durations
+  // measured on the same clock are compared. The network time is what remains
+  // of the round trip after the time spent on the server.
+  const int64_t server_us =
+      server_timing.send_time_us() - server_timing.receive_time_us();
+  TFRT_TRACE_EVENT(
+      Default,
+      StrCat(name, "#trace_id=", trace_id_,
+             ",serialization_us=", send_us_ - start_us_,
+             ",network_us=", (receive_us - send_us_) - server_us,
+             ",queueing_us=",
+             server_timing.start_time_us() - server_timing.receive_time_us(),
+             ",execution_us=",
+             server_timing.end_time_us() - server_timing.start_time_us(),
+             ",response_us=",
+             server_timing.send_time_us() - server_timing.end_time_us(),
+             ",total_us=", receive_us - start_us_, "#"));
+}
+
+llvm::unique_function<void(llvm::Error)> TraceServerCall(
+    string_view name, const TraceContext& trace_context,
+    ServerTiming* server_timing,
+    llvm::unique_function<void(llvm::Error)> done) {
+  const int64_t now_us = RemoteTraceMicros();
+  if (server_timing->receive_time_us() == 0)
+    server_timing->set_receive_time_us(now_us);
+  server_timing->set_start_time_us(now_us);
+  return [name = name.str(), trace_id = trace_context.trace_id(),
+          server_timing, done = std::move(done)](llvm::Error e) mutable {
+    // Calls which fail early never stamp the end time.
+    if (server_timing->end_time_us() == 0)
+      server_timing->set_end_time_us(RemoteTraceMicros());
+    server_timing->set_send_time_us(RemoteTraceMicros());
+    TFRT_TRACE_EVENT(
+        Default,
+        StrCat(name, "#trace_id=", trace_id, ",queueing_us=",
+               server_timing->start_time_us() -
+                   server_timing->receive_time_us(),
+               ",execution_us=",
+               server_timing->end_time_us() - server_timing->start_time_us(),
+               ",response_us=",
+               server_timing->send_time_us() - server_timing->end_time_us(),
+               "#"));
+    done(std::move(e));
+  };
+}
+
+}  // namespace tfrt
@@ -19,6 +19,7 @@
 // This file contains implementation of RequestHandler class.
 #include "tfrt/distributed_runtime/request_handler_impl.h"
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/raw_ostream.h"
 #include "tfrt/bef_converter/mlir_src_to_bef.h"
@@ -33,8 +34,14 @@
 #include "tfrt/distributed_runtime/distributed_context.h"
 #include "tfrt/distributed_runtime/distributed_init_helper.h"
 #include "tfrt/distributed_runtime/function_cache.h"
+#include "tfrt/distributed_runtime/payload_codec.h"
 #include "tfrt/distributed_runtime/proto/remote_message.pb.h"
+#include "tfrt/distributed_runtime/remote_client.h"
+#include "tfrt/distributed_runtime/remote_execute.h"
+#include "tfrt/distributed_runtime/remote_input_cache.h"
 #include "tfrt/distributed_runtime/remote_object_manager.h"
+#include "tfrt/distributed_runtime/remote_op_cache.h"
+#include "tfrt/distributed_runtime/remote_trace.h"
 #include "tfrt/distributed_runtime/request_handler.h"
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/concurrent_work_queue.h"
@@ -44,13 +51,18 @@
 #include "tfrt/host_context/host_context.h"
 #include "tfrt/support/error_util.h"
 #include "tfrt/support/forward_decls.h"
+#include "tfrt/support/refcounted_callback.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 #include "tfrt/tensor/tensor.h"
 #include "tfrt/tensor/tensor_serialize_utils.h"
+#include "tfrt/tracing/tracing.h"
 
 namespace tfrt {
 namespace {
 const char* kCompilerPassName = "tfrt";
+// The alignment of the received payload buffers, which is the alignment of
+// DenseHostTensor buffers.
+constexpr size_t kPayloadAlignment = 16;
 void ToProto(const RemoteObjectId& id, RemoteObjectIdProto* proto) {
   proto->set_prefix_id(id.prefix_id);
   proto->set_local_id(id.local_id);
@@ -241,20 +253,100 @@ void RequestHandler::HandleSendData(const SendDataRequest* request,
 
   InstanceKey key = request->instance_key();
   // TODO(ayushd): avoid string copy
-  llvm::SmallVector<RCReference<HostBuffer>, 4> buffers;
-  for (size_t i = 0; i < request->payload_size(); ++i) {
-    auto buffer = tfrt::HostBuffer::CreateUninitialized(
-        request->payload(i).size(), 1,
-        server_context_->GetHostContext()->allocator());
-    std::copy(request->payload(i).begin(), request->payload(i).end(),
-              static_cast<char*>(buffer->data()));
-    buffers.push_back(std::move(buffer));
-  }
-  dist_context->GetCallbackRegistry()->SetValue(key,
-                                                Payload(std::move(buffers)));
+  // The payloads may be deserialized into tensors that share the buffers, so
+  // they are aligned like the tensor buffers.
+  auto payload = DecodePayloads(*request, kPayloadAlignment,
+                                server_context_->GetHostContext()->allocator());
+  if (!payload) {
+    done(payload.takeError());
+    return;
+  }
+  dist_context->GetCallbackRegistry()->SetValue(key, std::move(*payload));
   done(Error::success());
 }
 
+// Deserializes a tensor pushed with a RemoteExecuteRequest.
+static Expected<DenseHostTensor> DeserializeInlineInput(
+    const RemoteExecuteInlineInput& input, HostContext* host) {
+  auto buffer = HostBuffer::CreateUninitialized(
+      input.data().size(), kPayloadAlignment, host->allocator());
+  if (!buffer) {
+    return llvm::make_error<UnknownErrorInfo>(
+        "Failed to allocate the inline input buffer");
+  }
+  std::copy(input.data().begin(), input.data().end(),
+            static_cast<char*>(buffer->data()));
+  return DeserializeDenseHostTensor(input.metadata(), std::move(buffer));
+}
+
+// Executes the program registered by `request` once with its warm-up inputs,
+// and calls `done` when all results are available.
+static void WarmUpProgram(HostContext* host, AsyncValue* dist_context_arg,
+                          const FunctionCache::CachedBEF& cached_bef,
+                          const RegisterFunctionRequest& request,
+                          llvm::unique_function<void(Error)> done) {
+  const Function* fn = cached_bef.bef_file->GetFunction(request.program_name());
+  if (fn == nullptr) {
+    done(llvm::make_error<InvalidArgumentErrorInfo>(
+        StrCat("Can't find function: [", request.program_name(), "]")));
+    return;
+  }
+  if (cached_bef.require_preallocated_outputs) {
+    done(llvm::make_error<InvalidArgumentErrorInfo>(
+        "Programs with preallocated outputs can't be warmed up"));
+    return;
+  }
+
+  llvm::SmallVector<AsyncValue*, 4> arguments;
+  llvm::SmallVector<RCReference<AsyncValue>, 4> arguments_ref;
+  if (cached_bef.require_distributed_context)
+    arguments.push_back(dist_context_arg);
+  if (fn->argument_types().size() !=
+      arguments.size() + request.warm_up_input_size()) {
+    done(llvm::make_error<InvalidArgumentErrorInfo>(
+        StrCat("Argument size mismatch: fn #arg: ", fn->argument_types().size(),
+               " Received #warm-up inputs: ", request.warm_up_input_size())));
+    return;
+  }
+  for (const RemoteExecuteInlineInput& input : request.warm_up_input()) {
+    auto dht = DeserializeInlineInput(input, host);
+    if (!dht) {
+      done(dht.takeError());
+      return;
+    }
+    arguments_ref.push_back(
+        MakeAvailableAsyncValueRef<DenseHostTensor>(std::move(*dht)));
+    arguments.push_back(arguments_ref.back().get());
+  }
+
+  ResourceContext resource_context;
+  Expected<RCReference<RequestContext>> req_ctx =
+      RequestContextBuilder(host, &resource_context).build();
+  if (!req_ctx) {
+    done(req_ctx.takeError());
+    return;
+  }
+  ExecutionContext exec_ctx{std::move(*req_ctx)};
+
+  auto results =
+      std::make_unique<llvm::SmallVector<RCReference<AsyncValue>, 4>>();
+  results->resize(fn->result_types().size());
+  fn->Execute(exec_ctx, arguments, *results);
+
+  auto results_ref = results.get();
+  RunWhenReady(*results_ref, [results = std::move(results),
+                              arguments_ref = std::move(arguments_ref),
+                              done = std::move(done)]() mutable {
+    for (const auto& result : *results) {
+      if (result->IsError()) {
+        done(MakeStringError(result->GetError().message()));
+        return;
+      }
+    }
+    done(Error::success());
+  });
+}
+
 void RequestHandler::HandleRegisterFunction(
     const RegisterFunctionRequest* request, RegisterFunctionResponse* response,
     CallbackFn done) {
@@ -304,13 +396,55 @@ void RequestHandler::HandleRegisterFunction(
     return;
   }
   FunctionCache* function_cache = dist_context->GetFunctionCache();
-  done(
-      function_cache->Register(request->program_name(), std::move(bef_buffer)));
+  Expected<uint64_t> program_handle =
+      function_cache->Register(request->program_name(), std::move(bef_buffer));
+  if (!program_handle) {
+    done(program_handle.takeError());
+    return;
+  }
+  response->set_program_handle(*program_handle);
+  if (!request->warm_up()) {
+    done(Error::success());
+    return;
+  }
+
+  AsyncValue* dist_context_arg =
+      server_context_->GetDistributedContextAsyncValue(request->context_id())
+          .GetAsyncValue();
+  WarmUpProgram(host_ctx(), dist_context_arg,
+                *function_cache->Prepare(*program_handle), *request,
+                [program_name = request->program_name(),
+                 done = std::move(done)](Error e) mutable {
+                  if (e) {
+                    TFRT_LOG(WARNING) << "Failed to warm up program "
+                                      << program_name << ": " << e;
+                  }
+                  done(Error::success());
+                });
+}
+
+// Serializes the metadata of the result `index` of `fn`.
+static Expected<std::string> SerializeResultMetadata(const Function* fn,
+                                                     int index,
+                                                     const AsyncValue& result) {
+  auto type_name = fn->result_types()[index].GetName();
+  if (type_name == "!t.tensor")
+    return SerializeTensorMetadata(result.get<Tensor>().metadata());
+  if (type_name == "!corert.tensorhandle")
+    return SerializeTensorMetadata(
+        result.get<TensorHandle>().GetAvailableMetadata());
+  return llvm::make_error<InvalidArgumentErrorInfo>(
+      StrCat("Invalid type ", type_name));
 }
 
 void RequestHandler::HandleRemoteExecute(const RemoteExecuteRequest* request,
                                          RemoteExecuteResponse* response,
                                          CallbackFn done) {
+  TFRT_TRACE_SCOPE(Default, "HandleRemoteExecute");
+  if (request->has_trace_context()) {
+    done = TraceServerCall("RemoteExecute", request->trace_context(),
+                           response->mutable_server_timing(), std::move(done));
+  }
   auto expected = server_context_->GetDistributedContext(request->context_id());
   if (!expected) {
     done(expected.takeError());
@@ -320,7 +454,9 @@ void RequestHandler::HandleRemoteExecute(const RemoteExecuteRequest* request,
 
   FunctionCache* function_cache = dist_context->GetFunctionCache();
   FunctionCache::CachedBEF* cached_bef =
-      function_cache->Prepare(request->program_name());
+      request->program_handle() != 0
+          ? function_cache->Prepare(request->program_handle())
+          : function_cache->Prepare(request->program_name());
   if (cached_bef == nullptr) {
     done(llvm::make_error<InvalidArgumentErrorInfo>(
         StrCat("Can't find program: [", request->program_name(), "]")));
@@ -394,7 +530,47 @@ void RequestHandler::HandleRemoteExecute(const RemoteExecuteRequest* request,
                " Received #inputs: ", request->input_size())));
     return;
   }
+  // Inputs pushed with the request are used as is, instead of waiting for
+  // the remote objects. Inputs the sender asked to cache are kept for its
+  // later requests, which refer to them by key.
+  RemoteInputStore* input_store = dist_context->GetRemoteInputStore();
+  if (request->evicted_cache_keys_size() > 0) {
+    input_store->Erase(request->input_cache_id(),
+                       llvm::makeArrayRef(request->evicted_cache_keys().data(),
+                                          request->evicted_cache_keys_size()));
+  }
+  llvm::SmallDenseMap<int, const RemoteExecuteInlineInput*, 4> inline_inputs;
+  for (const RemoteExecuteInlineInput& input : request->inline_input())
+    inline_inputs[input.index()] = &input;
   for (int i = 0; i < request->input_size(); ++i) {
+    auto inline_input = inline_inputs.find(i);
+    if (inline_input != inline_inputs.end()) {
+      const RemoteExecuteInlineInput& input = *inline_input->second;
+      RCReference<AsyncValue> val;
+      if (input.cached()) {
+        val = input_store->Find(request->input_cache_id(), input.cache_key());
+        if (!val) {
+          done(llvm::make_error<InvalidArgumentErrorInfo>(
+              StrCat("Can't find cached input: ", input.cache_key())));
+          return;
+        }
+      } else {
+        auto dht = DeserializeInlineInput(input, host_ctx());
+        if (!dht) {
+          done(dht.takeError());
+          return;
+        }
+        val = MakeAvailableAsyncValueRef<DenseHostTensor>(std::move(*dht));
+        if (input.cache_key() != 0) {
+          input_store->Insert(request->input_cache_id(), input.cache_key(),
+                              val.CopyRef());
+        }
+      }
+      arguments.push_back(val.get());
+      arguments_ref.push_back(std::move(val));
+      continue;
+    }
+
     auto& id = request->input(i);
 
     RCReference<Device> device =
@@ -431,32 +607,75 @@ void RequestHandler::HandleRemoteExecute(const RemoteExecuteRequest* request,
     manager->SetRemoteObject(output_id, (*results)[i]);
   }
 
+  // The response is sent once all results are available and all streamed
+  // metadata has been delivered.
+  auto rc_done = MakeRef<RefCountedCallback>(std::move(done));
+
+  // Stream the metadata of each output back to the caller as soon as the
+  // output is available, so that it can start working on it before the whole
+  // program completes. Outputs that fail are not streamed.
+  const bool stream_outputs = !request->stream_outputs_to().empty();
+  if (stream_outputs) {
+    RemoteClientInterface* caller = dist_context->GetRemoteClient(
+        dist_context->GetTaskHandle(request->stream_outputs_to()));
+    for (int i = 0; i < request->output_size(); ++i) {
+      if (!request->output(i).need_metadata()) continue;
+      const RemoteObjectIdProto& id = request->output(i).id();
+      RCReference<AsyncValue> result = (*results)[i];
+      AsyncValue* result_ptr = result.get();
+      result_ptr->AndThen([fn, i, result = std::move(result), caller,
+                           context_id = request->context_id(),
+                           key = RemoteExecuteOutputKey(id.prefix_id(),
+                                                        id.local_id()),
+                           host = host_ctx(), rc_done = rc_done.CopyRef()]() {
+        if (result->IsError()) return;
+        auto metadata = SerializeResultMetadata(fn, i, *result);
+        if (!metadata) {
+          rc_done->UpdateState(metadata.takeError());
+          return;
+        }
+        auto buffer = HostBuffer::CreateUninitialized(
+            metadata->size(), kPayloadAlignment, host->allocator());
+        std::copy(metadata->begin(), metadata->end(),
+                  static_cast<char*>(buffer->data()));
+        llvm::SmallVector<RCReference<HostBuffer>, 4> buffers;
+        buffers.push_back(std::move(buffer));
+        caller->SendPayloadAsync(
+            RemoteCallContext::GetDefault(), context_id, key,
+            Payload(std::move(buffers)),
+            [rc_done = rc_done.CopyRef()](Error e) mutable {
+              rc_done->UpdateState(std::move(e));
+            });
+      });
+    }
+  }
+
   // get the pointer of results before being moved on the lambda capture.
   auto result_ref = results.get();
   // Request will live as long as done is not called yet.
-  RunWhenReady(*result_ref, [fn, done = std::move(done), request, response,
+  RunWhenReady(*result_ref, [fn, rc_done = std::move(rc_done), request,
+                             response, stream_outputs,
                              results = std::move(results),
                              arguments = std::move(arguments),
                              arguments_ref =
                                  std::move(arguments_ref)]() mutable {
+    if (request->has_trace_context())
+      response->mutable_server_timing()->set_end_time_us(RemoteTraceMicros());
+    if (stream_outputs) {
+      rc_done.reset();
+      return;
+    }
     for (int i = 0; i < request->output_size(); ++i) {
       if (request->output(i).need_metadata()) {
-        if (fn->result_types()[i].GetName() == "!t.tensor") {
-          std::string serialized =
-              SerializeTensorMetadata((*results)[i]->get<Tensor>().metadata());
-          response->add_metadata(serialized);
-        } else if (fn->result_types()[i].GetName() == "!corert.tensorhandle") {
-          std::string serialized = SerializeTensorMetadata(
-              (*results)[i]->get<TensorHandle>().GetAvailableMetadata());
-          response->add_metadata(serialized);
-        } else {
-          done(llvm::make_error<InvalidArgumentErrorInfo>(
-              StrCat("Invalid type ", fn->result_types()[i].GetName())));
-          return;
+        auto metadata = SerializeResultMetadata(fn, i, *(*results)[i]);
+        if (!metadata) {
+          rc_done->UpdateState(metadata.takeError());
+          break;
         }
+        response->add_metadata(std::move(*metadata));
       }
     }
-    done(Error::success());
+    rc_done.reset();
   });
 }
 
@@ -496,6 +715,12 @@ void RequestHandler::HandleRemoteExecuteOp(
     const RemoteExecuteOpRequest* request, RemoteExecuteOpResponse* response,
     CallbackFn done) {
   TFRT_DLOG(INFO) << "HandleRemoteExecuteOp " << request->op_name();
+  TFRT_TRACE_SCOPE(Default, "HandleRemoteExecuteOp");
+  if (request->has_trace_context()) {
+    done = TraceServerCall(StrCat("RemoteExecuteOp:", request->op_name()),
+                           request->trace_context(),
+                           response->mutable_server_timing(), std::move(done));
+  }
   auto expected_dist_ctx =
       server_context_->GetDistributedContext(request->context_id());
   if (!expected_dist_ctx) {
@@ -510,16 +735,36 @@ void RequestHandler::HandleRemoteExecuteOp(
   DeviceManager* device_manager = dist_ctx->GetRemoteDeviceManager();
   RemoteObjectManager* object_manager = dist_ctx->GetRemoteObjectManager();
 
-  OpHandler* op_handler = corert->GetOpHandler(request->op_handler_name());
-  Expected<CoreRuntimeOp> expected_op =
-      corert->MakeOp(request->op_name(), op_handler);
-  if (!expected_op) {
-    done(expected_op.takeError());
-    TFRT_LOG(ERROR) << "Could not MakeOp in RemoteOpHandler "
-                    << request->op_name();
-    return;
+  // Resolve the op, or look it up by its handle if it was registered before.
+  std::unique_ptr<RemoteOpCache::CachedOp> uncached_op;
+  const RemoteOpCache::CachedOp* op;
+  if (request->op_handle() != 0) {
+    op = dist_ctx->GetRemoteOpCache()->Lookup(request->op_handle());
+    if (op == nullptr) {
+      done(llvm::make_error<InvalidArgumentErrorInfo>(
+          StrCat("Unknown op handle: ", request->op_handle())));
+      return;
+    }
+  } else {
+    OpHandler* op_handler = corert->GetOpHandler(request->op_handler_name());
+    Expected<CoreRuntimeOp> expected_op =
+        corert->MakeOp(request->op_name(), op_handler);
+    if (!expected_op) {
+      done(expected_op.takeError());
+      TFRT_LOG(ERROR) << "Could not MakeOp in RemoteOpHandler "
+                      << request->op_name();
+      return;
+    }
+    OpAttrs op_attrs;
+    ParseOpAttrs(*request, &op_attrs);
+    uncached_op = std::make_unique<RemoteOpCache::CachedOp>(
+        request->op_name(), std::move(expected_op.get()), op_attrs.freeze());
+    op = uncached_op.get();
+    if (request->register_op()) {
+      response->set_op_handle(
+          dist_ctx->GetRemoteOpCache()->Register(std::move(uncached_op)));
+    }
   }
-  auto op = std::move(expected_op.get());
   auto device =
       device_manager->GetDeviceRef<Device>(request->in_chain().device());
 
@@ -552,7 +797,8 @@ void RequestHandler::HandleRemoteExecuteOp(
                   << " wait for " << async_args->size() << " inputs";
   auto async_args_ref = async_args.get();
   RunWhenReady(*async_args_ref, [host_ctx, dist_ctx, request, response,
-                                 done = std::move(done), op = std::move(op),
+                                 done = std::move(done), op,
+                                 uncached_op = std::move(uncached_op),
                                  device = std::move(device),
                                  async_args = std::move(async_args)]() mutable {
     TFRT_DLOG(INFO) << "HandleRemoteExecuteOp " << request->op_name();
@@ -579,11 +825,7 @@ void RequestHandler::HandleRemoteExecuteOp(
     }
     tfrt::ExecutionContext exec_ctx{std::move(*req_ctx)};
 
-    // Setup op attributes.
-    OpAttrs op_attrs;
-    ParseOpAttrs(*request, &op_attrs);
-
-    op(exec_ctx, args, OpAttrsRef(op_attrs), results, &chain);
+    op->op(exec_ctx, args, op->attrs, results, &chain);
 
     // Set the output chain mapping in the remote object manager.
     RemoteObjectId out_chain_id(request->out_chain().prefix_id(),
@@ -625,6 +867,10 @@ void RequestHandler::HandleRemoteExecuteOp(
                                  results = std::move(results),
                                  done = std::move(done)]() mutable {
       TFRT_DLOG(INFO) << "HandleRemoteExecuteOp " << request->op_name();
+      if (request->has_trace_context()) {
+        response->mutable_server_timing()->set_end_time_us(
+            RemoteTraceMicros());
+      }
       if (chain.IsError()) {
         // TODO(ayushd): choose a more informative error code.
         done(llvm::make_error<UnknownErrorInfo>(chain.GetError().message()));
@@ -663,6 +909,10 @@ void RequestHandler::HandleDeleteRemoteObjects(
     }
     ids.emplace_back(id.prefix_id(), id.local_id(), device);
   }
+  // Deleted objects can't be read again, so the remote tasks can drop them.
+  if (RemoteInputCache* input_cache = dist_context->GetRemoteInputCache()) {
+    for (const RemoteObjectId& id : ids) input_cache->Erase(id);
+  }
   RemoteObjectManager* manager = dist_context->GetRemoteObjectManager();
   done(manager->DeleteRemoteObjects(ids));
 }
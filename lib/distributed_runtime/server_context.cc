@@ -42,6 +42,12 @@ ServerContext::ServerContext(HostContext* host_context,
       configuration_{std::move(configuration)},
       init_helper_{std::make_unique<DistributedInitHelper>(this)} {
   request_handler_ = NewRequestHandler(this);
+  if (configuration_.max_inflight_execute_requests > 0) {
+    request_handler_ = NewAdmissionControlRequestHandler(
+        host_context_, std::move(request_handler_),
+        configuration_.max_inflight_execute_requests,
+        configuration_.max_queued_execute_requests);
+  }
   GetOrCreateFabricCommunicator();
   GarbageCollectInactiveDistributedContexts(
       configuration_.context_gc_timeout_secs);
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+//===- shared_memory_communicator.cc - Shared Memory Communicator ---------===//
+//
+// This file contains the implementation of the shared memory fabric
+// communicator.
+
+#include "tfrt/distributed_runtime/shared_memory_communicator.h"
+
+#include <utility>
+
+#include "llvm/ADT/StringMap.h"
+#include "tfrt/distributed_runtime/callback_registry.h"
+#include "tfrt/distributed_runtime/distributed_context.h"
+#include "tfrt/distributed_runtime/remote_client.h"
+#include "tfrt/distributed_runtime/request_handler.h"
+#include "tfrt/distributed_runtime/server_context.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/string_util.h"
+
+namespace tfrt {
+namespace {
+
+// Server contexts with a shared memory communicator, by server address.
+class ServerRegistry {
+ public:
+  static ServerRegistry& Global() {
+    static auto* registry = new ServerRegistry;
+    return *registry;
+  }
+
+  void Register(string_view address, ServerContext* server) {
+    mutex_lock lock(mu_);
+    bool inserted = servers_.try_emplace(address, server).second;
+    if (!inserted) {
+      TFRT_LOG(WARNING) << "Shared memory communicator address " << address
+                        << " is already in use";
+    }
+  }
+
+  void Unregister(string_view address, ServerContext* server) {
+    mutex_lock lock(mu_);
+    auto it = servers_.find(address);
+    if (it != servers_.end() && it->second == server) servers_.erase(it);
+  }
+
+  ServerContext* Find(string_view address) {
+    mutex_lock lock(mu_);
+    auto it = servers_.find(address);
+    return it == servers_.end() ? nullptr : it->second;
+  }
+
+ private:
+  mutex mu_;
+  llvm::StringMap<ServerContext*> servers_ TFRT_GUARDED_BY(mu_);
+};
+
+class SharedMemoryRemoteClient : public RemoteClientInterface {
+ public:
+  explicit SharedMemoryRemoteClient(string_view address) : address_(address) {}
+
+#define CLIENT_METHOD(method)                                             \
+  void method##Async(RemoteCallContext* call_ctx,                         \
+                     const method##Request* request,                      \
+                     method##Response* response, CallbackFn done) final { \
+    Call(                                                                 \
+        [request, response](ServerContext* server, CallbackFn done) {     \
+          server->GetRequestHandler()->Handle##method(request, response,  \
+                                                      std::move(done));   \
+        },                                                                \
+        std::move(done));                                                 \
+  }
+
+  CLIENT_METHOD(GetDevices);
+  CLIENT_METHOD(CreateContext);
+  CLIENT_METHOD(CloseContext);
+  CLIENT_METHOD(SendReadyChains);
+  CLIENT_METHOD(SendData);
+  CLIENT_METHOD(RegisterFunction);
+  CLIENT_METHOD(RemoteExecute);
+  CLIENT_METHOD(RemoteExecuteOp);
+  CLIENT_METHOD(DeleteRemoteObjects);
+  CLIENT_METHOD(KeepAlive);
+
+#undef CLIENT_METHOD
+
+  // Hands the payload buffers to the receiver without copying them.
+  void SendPayloadAsync(RemoteCallContext* call_ctx, uint64_t context_id,
+                        string_view instance_key, Payload payload,
+                        CallbackFn done) final {
+    Call(
+        [context_id, instance_key = instance_key.str(),
+         payload = std::move(payload)](ServerContext* server,
+                                       CallbackFn done) mutable {
+          auto dist_context = server->GetDistributedContext(context_id);
+          if (!dist_context) return done(dist_context.takeError());
+          (*dist_context)
+              ->GetCallbackRegistry()
+              ->SetValue(instance_key, std::move(payload));
+          done(Error::success());
+        },
+        std::move(done));
+  }
+
+ private:
+  // Runs `handle` on the work queue of the peer server, like a request that
+  // arrived over the network.
+  void Call(llvm::unique_function<void(ServerContext*, CallbackFn)> handle,
+            CallbackFn done) {
+    ServerContext* server = ServerRegistry::Global().Find(address_);
+    if (server == nullptr) {
+      done(llvm::make_error<UnavailableErrorInfo>(
+          StrCat("No shared memory communicator at ", address_)));
+      return;
+    }
+    EnqueueWork(server->GetHostContext(),
+                [server, handle = std::move(handle),
+                 done = std::move(done)]() mutable {
+                  handle(server, std::move(done));
+                });
+  }
+
+  const std::string address_;
+};
+
+}  // namespace
+
+SharedMemoryFabricCommunicator::SharedMemoryFabricCommunicator(
+    ServerContext* server_context)
+    : FabricCommunicator(kSharedMemoryCommunicatorType, server_context),
+      server_address_(server_context->GetConfiguration()
+                          .fabric_configuration.server_address) {
+  ServerRegistry::Global().Register(server_address_, server_context);
+}
+
+SharedMemoryFabricCommunicator::~SharedMemoryFabricCommunicator() {
+  ServerRegistry::Global().Unregister(server_address_, server_context_);
+}
+
+std::unique_ptr<RemoteClientInterface>
+SharedMemoryFabricCommunicator::CreateRemoteClient(
+    DistributedContext* dist_context, TaskHandle task_handle) {
+  return std::make_unique<SharedMemoryRemoteClient>(
+      dist_context->GetRemoteAddress(task_handle));
+}
+
+FabricCommunicator* CreateSharedMemoryFabricCommunicator(
+    ServerContext* server_context) {
+  return new SharedMemoryFabricCommunicator(server_context);
+}
+
+}  // namespace tfrt
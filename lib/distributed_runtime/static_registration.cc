@@ -20,9 +20,13 @@
 
 #include "op_handler_kernels.h"
 #include "tfrt/distributed_runtime/remote_op_handler.h"
+#include "tfrt/distributed_runtime/shared_memory_communicator.h"
 
 namespace tfrt {
 
 TFRT_STATIC_KERNEL_REGISTRATION(RegisterRemoteOpHandlerKernels);
 
+TFRT_STATIC_FABRIC_COMMUNICATOR_REGISTRATION(
+    kSharedMemoryCommunicatorType, CreateSharedMemoryFabricCommunicator);
+
 }  // namespace tfrt
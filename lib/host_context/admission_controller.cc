@@ -0,0 +1,193 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file implements AdmissionController.
+
+#include "tfrt/host_context/admission_controller.h"
+
+#include <cassert>
+#include <vector>
+
+#include "absl/status/status.h"  // from @com_google_absl
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/string_util.h"
+
+namespace tfrt {
+namespace {
+
+metrics::Buckets QueueDelayBuckets() {
+  std::vector<double> bounds;
+  for (double bound = 100; bound <= 1e7; bound *= 2) bounds.push_back(bound);
+  return metrics::Buckets::Explicit(std::move(bounds));
+}
+
+std::string MetricName(string_view name, string_view metric) {
+  return StrCat("/tfrt/admission/", name, "/", metric);
+}
+
+}  // namespace
+
+void AdmissionToken::Release() {
+  if (controller_) std::exchange(controller_, nullptr)->Release();
+}
+
+AdmissionController::AdmissionController(HostContext* host, string_view name,
+                                         AdmissionOptions options)
+    : host_(host),
+      name_(name),
+      options_(options),
+      admitted_metric_(metrics::NewCounter(MetricName(name, "admitted"))),
+      rejected_metric_(metrics::NewCounter(MetricName(name, "rejected"))),
+      queued_metric_(metrics::NewCounter(MetricName(name, "queued"))),
+      in_flight_metric_(
+          metrics::NewGauge<int64_t>(MetricName(name, "in_flight"))),
+      queue_delay_metric_(metrics::NewHistogram(
+          MetricName(name, "queue_delay_us"), QueueDelayBuckets())) {
+  assert(options_.max_in_flight > 0);
+}
+
+AdmissionController::~AdmissionController() {
+  std::vector<AsyncValueRef<AdmissionToken>> waiters;
+  {
+    mutex_lock lock(mu_);
+    assert(in_flight_ == 0 && "AdmissionTokens outlive their controller");
+    for (auto& queue : waiters_) {
+      for (auto& waiter : queue) waiters.push_back(std::move(waiter.token));
+      queue.clear();
+    }
+    num_waiters_ = 0;
+  }
+  for (auto& waiter : waiters)
+    Reject(std::move(waiter), "the admission controller is destroyed");
+}
+
+Expected<AdmissionToken> AdmissionController::TryAdmit(TaskPriority priority) {
+  {
+    mutex_lock lock(mu_);
+    if (in_flight_ < options_.max_in_flight && !HasWaiters(priority)) {
+      in_flight_metric_->Set(++in_flight_);
+      admitted_metric_->IncrementBy(1);
+      return AdmissionToken(this);
+    }
+  }
+  rejected_metric_->IncrementBy(1);
+  return llvm::make_error<ResourceExhaustedErrorInfo>(
+      StrCat("Too many requests in flight for ", name_, ", retry later."));
+}
+
+AsyncValueRef<AdmissionToken> AdmissionController::Admit(
+    TaskPriority priority) {
+  auto token = MakeUnconstructedAsyncValueRef<AdmissionToken>();
+  AsyncValueRef<AdmissionToken> evicted;
+  {
+    mutex_lock lock(mu_);
+    if (in_flight_ < options_.max_in_flight && !HasWaiters(priority)) {
+      in_flight_metric_->Set(++in_flight_);
+      admitted_metric_->IncrementBy(1);
+      token.emplace(AdmissionToken(this));
+      return token;
+    }
+
+    if (num_waiters_ == options_.max_queued) {
+      // Evict the most recently queued request of the lowest priority that is
+      // lower than `priority`.
+      for (int p = kNumPriorities - 1; p > static_cast<int>(priority); --p) {
+        if (waiters_[p].empty()) continue;
+        evicted = std::move(waiters_[p].back().token);
+        waiters_[p].pop_back();
+        --num_waiters_;
+        break;
+      }
+    }
+    if (num_waiters_ < options_.max_queued) {
+      waiters_[static_cast<int>(priority)].push_back(
+          {token.CopyRef(), Clock::now()});
+      ++num_waiters_;
+      queued_metric_->IncrementBy(1);
+    } else {
+      evicted = token.CopyRef();
+    }
+  }
+  if (evicted) Reject(std::move(evicted), "the admission queue is full");
+  return token;
+}
+
+int AdmissionController::in_flight() const {
+  mutex_lock lock(mu_);
+  return in_flight_;
+}
+
+size_t AdmissionController::queued() const {
+  mutex_lock lock(mu_);
+  return num_waiters_;
+}
+
+bool AdmissionController::HasWaiters(TaskPriority priority) const {
+  for (int p = 0; p <= static_cast<int>(priority); ++p) {
+    if (!waiters_[p].empty()) return true;
+  }
+  return false;
+}
+
+void AdmissionController::Release() {
+  llvm::SmallVector<AsyncValueRef<AdmissionToken>, 4> stale;
+  AsyncValueRef<AdmissionToken> next;
+  {
+    mutex_lock lock(mu_);
+    const auto now = Clock::now();
+    for (auto& queue : waiters_) {
+      while (!next && !queue.empty()) {
+        Waiter waiter = std::move(queue.front());
+        queue.pop_front();
+        --num_waiters_;
+        auto delay = now - waiter.enqueue_time;
+        if (delay > options_.max_queue_delay) {
+          stale.push_back(std::move(waiter.token));
+          continue;
+        }
+        queue_delay_metric_->Record(
+            std::chrono::duration_cast<std::chrono::microseconds>(delay)
+                .count());
+        next = std::move(waiter.token);
+      }
+    }
+    // The slot passes to the next request, if any.
+    if (!next) in_flight_metric_->Set(--in_flight_);
+  }
+
+  for (auto& token : stale)
+    Reject(std::move(token), "the request waited too long for admission");
+
+  if (!next) return;
+  admitted_metric_->IncrementBy(1);
+  // Tokens are released when requests finish, so admit the next request on
+  // the work queue instead of running its continuation on this stack.
+  EnqueueWork(host_, [this, next = std::move(next)]() mutable {
+    next.emplace(AdmissionToken(this));
+  });
+}
+
+void AdmissionController::Reject(AsyncValueRef<AdmissionToken> token,
+                                 string_view reason) {
+  rejected_metric_->IncrementBy(1);
+  token.SetError(absl::ResourceExhaustedError(
+      StrCat("Request to ", name_, " rejected because ", reason)));
+}
+
+}  // namespace tfrt
@@ -0,0 +1,108 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements ArenaAllocator.
+
+#include "tfrt/host_context/arena_allocator.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "llvm/Support/MathExtras.h"
+
+namespace tfrt {
+
+ArenaAllocator::ArenaAllocator(HostAllocator* allocator, size_t block_size)
+    : allocator_(allocator), block_size_(block_size) {
+  assert(allocator_ != nullptr);
+}
+
+ArenaAllocator::~ArenaAllocator() {
+  mutex_lock lock(mu_);
+  while (blocks_) {
+    Block* next = blocks_->next;
+    allocator_->DeallocateBytes(blocks_, sizeof(Block) + blocks_->size);
+    blocks_ = next;
+  }
+}
+
+void* ArenaAllocator::TryAllocate(Block* block, size_t size,
+                                  size_t alignment) {
+  auto base = reinterpret_cast<uintptr_t>(block->data());
+  size_t offset = block->offset.load(std::memory_order_relaxed);
+  while (true) {
+    size_t aligned = llvm::alignTo(base + offset, alignment) - base;
+    if (aligned + size > block->size) return nullptr;
+    if (block->offset.compare_exchange_weak(offset, aligned + size,
+                                            std::memory_order_relaxed))
+      return block->data() + aligned;
+  }
+}
+
+void* ArenaAllocator::AllocateBytes(size_t size, size_t alignment) {
+  assert(llvm::isPowerOf2_64(alignment) && "alignment must be a power of 2");
+
+  // Every allocation keeps the arena alive until it is deallocated.
+  AddRef();
+
+  Block* block = current_.load(std::memory_order_acquire);
+  if (block) {
+    if (void* ptr = TryAllocate(block, size, alignment)) return ptr;
+  }
+
+  void* ptr = AllocateSlow(block, size, alignment);
+  if (!ptr) DropRef();
+  return ptr;
+}
+
+void* ArenaAllocator::AllocateSlow(Block* block, size_t size,
+                                   size_t alignment) {
+  mutex_lock lock(mu_);
+
+  // Large allocations get a dedicated block, so they do not waste the rest of
+  // the current block.
+  size_t padded_size = size + alignment;
+  if (padded_size > block_size_ / 4) {
+    Block* dedicated_block = NewBlock(padded_size);
+    if (!dedicated_block) return nullptr;
+    void* ptr = TryAllocate(dedicated_block, size, alignment);
+    assert(ptr && "dedicated block must fit the allocation");
+    return ptr;
+  }
+
+  // Some other thread might have already replaced the current block.
+  Block* current = current_.load(std::memory_order_acquire);
+  if (current != block && current != nullptr) {
+    if (void* ptr = TryAllocate(current, size, alignment)) return ptr;
+  }
+
+  Block* new_block = NewBlock(block_size_);
+  if (!new_block) return nullptr;
+  void* ptr = TryAllocate(new_block, size, alignment);
+  assert(ptr && "new block must fit the allocation");
+  current_.store(new_block, std::memory_order_release);
+  return ptr;
+}
+
+ArenaAllocator::Block* ArenaAllocator::NewBlock(size_t size) {
+  void* buf = allocator_->AllocateBytes(sizeof(Block) + size,
+                                        alignof(std::max_align_t));
+  if (!buf) return nullptr;
+  auto* block = new (buf) Block{blocks_, size, {0}};
+  blocks_ = block;
+  allocated_bytes_.fetch_add(size, std::memory_order_relaxed);
+  return block;
+}
+
+}  // namespace tfrt
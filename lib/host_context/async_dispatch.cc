@@ -20,10 +20,87 @@
 
 #include <utility>
 
+#include "llvm/ADT/SmallVector.h"
 #include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/host_counters.h"
 #include "tfrt/host_context/task_function.h"
 
 namespace tfrt {
+namespace {
+
+// Tasks enqueued by the current thread while an EnqueueWorkBatch is alive. All
+// tasks in the batch belong to the same work queue and have the same priority.
+struct PendingTasks {
+  int depth = 0;
+  ConcurrentWorkQueue* work_queue = nullptr;
+  TaskPriority priority = TaskPriority::kDefault;
+  llvm::SmallVector<TaskFunction, 8> tasks;
+};
+
+void SubmitTask(ConcurrentWorkQueue& work_queue, TaskFunction task,
+                TaskPriority priority) {
+  if (priority == TaskPriority::kDefault) {
+    work_queue.AddTask(std::move(task));
+  } else {
+    work_queue.AddTaskWithPriority(std::move(task), priority);
+  }
+}
+
+thread_local PendingTasks pending_tasks;
+
+void SubmitPendingTasks() {
+  if (pending_tasks.tasks.empty()) return;
+
+  // Submitting may run tasks in the caller thread, which in turn can enqueue
+  // more work, so detach the batch first.
+  ConcurrentWorkQueue* work_queue = pending_tasks.work_queue;
+  TaskPriority priority = pending_tasks.priority;
+  llvm::SmallVector<TaskFunction, 8> tasks = std::move(pending_tasks.tasks);
+  pending_tasks.tasks.clear();
+  pending_tasks.work_queue = nullptr;
+
+  if (tasks.size() == 1) {
+    SubmitTask(*work_queue, std::move(tasks.front()), priority);
+  } else if (priority == TaskPriority::kDefault) {
+    work_queue->AddTasks(tasks);
+  } else {
+    work_queue->AddTasksWithPriority(tasks, priority);
+  }
+}
+
+void BeginBatch() { ++pending_tasks.depth; }
+
+void EndBatch() {
+  assert(pending_tasks.depth > 0);
+  if (--pending_tasks.depth == 0) SubmitPendingTasks();
+}
+
+void AddTask(ConcurrentWorkQueue& work_queue, TaskFunction task,
+             TaskPriority priority) {
+  if (pending_tasks.depth == 0) {
+    SubmitTask(work_queue, std::move(task), priority);
+    return;
+  }
+
+  if (pending_tasks.work_queue != &work_queue ||
+      pending_tasks.priority != priority) {
+    SubmitPendingTasks();
+    pending_tasks.work_queue = &work_queue;
+    pending_tasks.priority = priority;
+  }
+  pending_tasks.tasks.push_back(std::move(task));
+}
+
+const bool waiter_batch_hooks_registered = [] {
+  AsyncValue::SetWaiterBatchHooks({BeginBatch, EndBatch});
+  return true;
+}();
+
+}  // namespace
+
+EnqueueWorkBatch::EnqueueWorkBatch() { BeginBatch(); }
+
+EnqueueWorkBatch::~EnqueueWorkBatch() { EndBatch(); }
 
 void Await(const ExecutionContext& exec_ctx,
            ArrayRef<RCReference<AsyncValue>> values) {
@@ -36,17 +113,31 @@ void Await(HostContext* host, ArrayRef<RCReference<AsyncValue>> values) {
 
 void EnqueueWork(const ExecutionContext& exec_ctx,
                  llvm::unique_function<void()> work) {
-  auto& work_queue = exec_ctx.work_queue();
-  work_queue.AddTask(TaskFunction(std::move(work)));
+  AddHostCounter(exec_ctx.request_ctx(), HostCounter::kTasks);
+  AddTask(exec_ctx.work_queue(), TaskFunction(std::move(work)),
+          exec_ctx.priority());
+}
+
+void EnqueueNextWork(const ExecutionContext& exec_ctx,
+                     llvm::unique_function<void()> work) {
+  if (pending_tasks.depth > 0 ||
+      exec_ctx.priority() != TaskPriority::kDefault) {
+    EnqueueWork(exec_ctx, std::move(work));
+    return;
+  }
+  AddHostCounter(exec_ctx.request_ctx(), HostCounter::kTasks);
+  exec_ctx.work_queue().AddNextTask(TaskFunction(std::move(work)));
 }
 
 void EnqueueWork(HostContext* host, llvm::unique_function<void()> work) {
-  auto& work_queue = host->work_queue();
-  work_queue.AddTask(TaskFunction(std::move(work)));
+  AddHostCounter(/*request=*/nullptr, HostCounter::kTasks);
+  AddTask(host->work_queue(), TaskFunction(std::move(work)),
+          TaskPriority::kDefault);
 }
 
 [[nodiscard]] bool EnqueueBlockingWork(HostContext* host,
                                        llvm::unique_function<void()> work) {
+  AddHostCounter(/*request=*/nullptr, HostCounter::kBlockingTasks);
   auto& work_queue = host->work_queue();
   Optional<TaskFunction> task = work_queue.AddBlockingTask(
       TaskFunction(std::move(work)), /*allow_queuing=*/true);
@@ -55,6 +146,7 @@ void EnqueueWork(HostContext* host, llvm::unique_function<void()> work) {
 
 [[nodiscard]] bool RunBlockingWork(HostContext* host,
                                    llvm::unique_function<void()> work) {
+  AddHostCounter(/*request=*/nullptr, HostCounter::kBlockingTasks);
   auto& work_queue = host->work_queue();
   Optional<TaskFunction> task = work_queue.AddBlockingTask(
       TaskFunction(std::move(work)), /*allow_queuing=*/false);
@@ -0,0 +1,372 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements a size-bucketed pool for tensor-sized host buffers.
+//
+// In steady state serving the same few buffer sizes are allocated and freed
+// over and over. The pool rounds allocations above the slab allocator range up
+// to a size class, four classes per power of two, and keeps freed blocks for
+// reuse instead of returning them to the underlying allocator. Each thread
+// keeps its own free lists up to a byte budget, so an allocation that follows
+// a deallocation of the same size class on the same thread does not take a
+// lock. Other freed blocks go to shared per-class free lists, and the blocks
+// that don't fit into the shared byte budget are released.
+//
+// A pool can also keep a profile of the number of blocks of every size class it
+// allocated in a file. A restarted process then allocates these blocks when it
+// creates the pool, instead of on the first requests it serves.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace {
+
+// Allocations in the (kMinPooledSize, kMaxPooledSize] range are pooled.
+constexpr int kMinPooledSizeLog2 = 9;
+constexpr int kMaxPooledSizeLog2 = 26;
+constexpr size_t kMinPooledSize = size_t{1} << kMinPooledSizeLog2;
+constexpr size_t kMaxPooledSize = size_t{1} << kMaxPooledSizeLog2;
+
+// Every power of two range (2^n, 2^(n+1)] is split into this many size
+// classes, so a block wastes at most 25% of its size.
+constexpr int kClassesPerPowerOfTwo = 4;
+constexpr int kNumSizeClasses =
+    (kMaxPooledSizeLog2 - kMinPooledSizeLog2) * kClassesPerPowerOfTwo;
+
+// Pooled blocks are allocated with at least this alignment, so that they can
+// be reused for any allocation that asks for no more.
+constexpr size_t kBlockAlignment = 64;
+
+// Maximum number of bytes kept in the free lists of one thread.
+constexpr size_t kThreadCacheBytes = 8 * 1024 * 1024;
+
+// Free blocks are linked through their first word.
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct FreeList {
+  FreeBlock* head = nullptr;
+
+  void Push(FreeBlock* block) {
+    block->next = head;
+    head = block;
+  }
+
+  FreeBlock* Pop() {
+    assert(head != nullptr);
+    FreeBlock* block = head;
+    head = block->next;
+    return block;
+  }
+};
+
+// Returns the size class index for an allocation of `size` bytes.
+int SizeClass(size_t size) {
+  assert(size > kMinPooledSize && size <= kMaxPooledSize);
+  // 2^log2 < size <= 2^(log2 + 1).
+  int log2 = llvm::Log2_64(size - 1);
+  size_t step = size_t{1} << (log2 - 2);
+  size_t sub_class = (size - (size_t{1} << log2) + step - 1) / step;
+  return (log2 - kMinPooledSizeLog2) * kClassesPerPowerOfTwo + sub_class - 1;
+}
+
+size_t BlockSize(int size_class) {
+  int log2 = size_class / kClassesPerPowerOfTwo + kMinPooledSizeLog2;
+  size_t step = size_t{1} << (log2 - 2);
+  return (size_t{1} << log2) + (size_class % kClassesPerPowerOfTwo + 1) * step;
+}
+
+bool IsPooled(size_t size) {
+  return size > kMinPooledSize && size <= kMaxPooledSize;
+}
+
+// Per-thread free lists. A thread caches blocks only for the buffer pool that
+// it used most recently, identified by a unique id, so a destroyed pool can't
+// be confused with a new pool at the same address.
+struct ThreadCache {
+  uint64_t allocator_id = 0;
+  size_t bytes = 0;
+  FreeList free_lists[kNumSizeClasses];
+};
+
+thread_local ThreadCache thread_cache;
+
+class BufferPoolAllocator;
+
+// Live buffer pools keyed by id. Used to return the blocks in a thread cache to
+// their pool when the thread switches to another pool.
+struct BufferPoolRegistry {
+  mutex mu;
+  llvm::DenseMap<uint64_t, BufferPoolAllocator*> allocators TFRT_GUARDED_BY(mu);
+
+  static BufferPoolRegistry& Get() {
+    static auto* registry = new BufferPoolRegistry();
+    return *registry;
+  }
+};
+
+class BufferPoolAllocator : public HostAllocator {
+ public:
+  BufferPoolAllocator(std::unique_ptr<HostAllocator> allocator,
+                      size_t max_cached_bytes, string_view profile_path)
+      : id_(next_id_.fetch_add(1, std::memory_order_relaxed)),
+        allocator_(std::move(allocator)),
+        max_cached_bytes_(max_cached_bytes),
+        profile_path_(profile_path) {
+    {
+      auto& registry = BufferPoolRegistry::Get();
+      mutex_lock lock(registry.mu);
+      registry.allocators[id_] = this;
+    }
+    if (!profile_path_.empty()) WarmUp();
+  }
+
+  ~BufferPoolAllocator() override {
+    // Blocks in the thread caches of other threads are released below together
+    // with all other blocks, the id of this pool will never be reused.
+    {
+      auto& registry = BufferPoolRegistry::Get();
+      mutex_lock lock(registry.mu);
+      registry.allocators.erase(id_);
+    }
+
+    mutex_lock lock(blocks_mu_);
+    if (!profile_path_.empty()) WriteProfile();
+    for (auto& block : blocks_)
+      allocator_->DeallocateBytes(block.first, block.second);
+  }
+
+  // Allocate the specified number of bytes with the specified alignment.
+  void* AllocateBytes(size_t size, size_t alignment) override {
+    if (!IsPooled(size)) return allocator_->AllocateBytes(size, alignment);
+
+    int size_class = SizeClass(size);
+
+    // Over-aligned allocations are rare, and always get a new block. The block
+    // joins the pool once it is deallocated.
+    if (LLVM_LIKELY(alignment <= kBlockAlignment)) {
+      ThreadCache& cache = GetThreadCache();
+      FreeList& free_list = cache.free_lists[size_class];
+      if (free_list.head != nullptr) {
+        cache.bytes -= BlockSize(size_class);
+        return free_list.Pop();
+      }
+      if (void* block = PopShared(size_class)) return block;
+    }
+
+    return AllocateBlock(size_class, std::max(alignment, kBlockAlignment));
+  }
+
+  // Deallocate the specified pointer that has the specified size.
+  void DeallocateBytes(void* ptr, size_t size) override {
+    if (!IsPooled(size)) return allocator_->DeallocateBytes(ptr, size);
+
+    int size_class = SizeClass(size);
+    size_t block_size = BlockSize(size_class);
+    auto* block = static_cast<FreeBlock*>(ptr);
+
+    ThreadCache& cache = GetThreadCache();
+    if (cache.bytes + block_size <= kThreadCacheBytes) {
+      cache.free_lists[size_class].Push(block);
+      cache.bytes += block_size;
+      return;
+    }
+    PushShared(size_class, block);
+  }
+
+ private:
+  struct SharedFreeList {
+    mutex mu;
+    FreeList free_list TFRT_GUARDED_BY(mu);
+  };
+
+  // Returns the calling thread cache, taking it over from another pool if
+  // needed.
+  ThreadCache& GetThreadCache() {
+    ThreadCache& cache = thread_cache;
+    if (LLVM_UNLIKELY(cache.allocator_id != id_)) TakeOver(&cache);
+    return cache;
+  }
+
+  // Returns the blocks in `cache` to the pool that owns them, unless it was
+  // already destroyed, and resets `cache` for this pool.
+  LLVM_ATTRIBUTE_NOINLINE void TakeOver(ThreadCache* cache) {
+    if (cache->allocator_id != 0) {
+      auto& registry = BufferPoolRegistry::Get();
+      mutex_lock lock(registry.mu);
+      auto it = registry.allocators.find(cache->allocator_id);
+      if (it != registry.allocators.end()) {
+        for (int i = 0; i < kNumSizeClasses; ++i) {
+          while (cache->free_lists[i].head != nullptr)
+            it->second->PushShared(i, cache->free_lists[i].Pop());
+        }
+      }
+    }
+    *cache = ThreadCache();
+    cache->allocator_id = id_;
+  }
+
+  // Allocates a new block from the underlying allocator.
+  LLVM_ATTRIBUTE_NOINLINE void* AllocateBlock(int size_class,
+                                              size_t alignment) {
+    size_t block_size = BlockSize(size_class);
+    void* block = allocator_->AllocateBytes(block_size, alignment);
+    if (block == nullptr) return nullptr;
+    mutex_lock lock(blocks_mu_);
+    blocks_[block] = block_size;
+    int num_blocks = ++num_blocks_[size_class];
+    peak_blocks_[size_class] = std::max(peak_blocks_[size_class], num_blocks);
+    return block;
+  }
+
+  // Allocates the blocks recorded in the profile into the shared free lists,
+  // up to max_cached_bytes_. The profile is best effort, a missing or invalid
+  // file leaves the pool empty.
+  void WarmUp() {
+    auto buffer = llvm::MemoryBuffer::getFile(profile_path_, /*IsText=*/true);
+    if (!buffer) return;
+
+    llvm::SmallVector<string_view, 64> lines;
+    (*buffer)->getBuffer().split(lines, '\n', /*MaxSplit=*/-1,
+                                 /*KeepEmpty=*/false);
+    for (string_view line : lines) {
+      size_t block_size, count;
+      auto fields = line.split(' ');
+      if (fields.first.getAsInteger(10, block_size) ||
+          fields.second.getAsInteger(10, count) || !IsPooled(block_size))
+        continue;
+
+      int size_class = SizeClass(block_size);
+      block_size = BlockSize(size_class);
+      for (size_t i = 0; i < count; ++i) {
+        if (cached_bytes_.load(std::memory_order_relaxed) + block_size >
+            max_cached_bytes_)
+          return;
+        void* block = AllocateBlock(size_class, kBlockAlignment);
+        if (block == nullptr) return;
+        PushShared(size_class, static_cast<FreeBlock*>(block));
+      }
+    }
+  }
+
+  // Writes the peak number of blocks of every size class to the profile. The
+  // file is replaced with a rename, so that concurrent readers never see a
+  // partial profile.
+  void WriteProfile() TFRT_REQUIRES(blocks_mu_) {
+    int fd;
+    llvm::SmallString<128> temp_path;
+    if (llvm::sys::fs::createUniqueFile(profile_path_ + ".tmp-%%%%%%", fd,
+                                        temp_path))
+      return;
+
+    {
+      llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+      for (int i = 0; i < kNumSizeClasses; ++i) {
+        if (peak_blocks_[i] > 0)
+          os << BlockSize(i) << ' ' << peak_blocks_[i] << '\n';
+      }
+      os.close();
+      if (os.has_error()) {
+        os.clear_error();
+        llvm::sys::fs::remove(temp_path);
+        return;
+      }
+    }
+
+    if (llvm::sys::fs::rename(temp_path, profile_path_))
+      llvm::sys::fs::remove(temp_path);
+  }
+
+  // Pops a block from the shared free list, or returns nullptr if it is empty.
+  void* PopShared(int size_class) {
+    SharedFreeList& shared = shared_free_lists_[size_class];
+    mutex_lock lock(shared.mu);
+    if (shared.free_list.head == nullptr) return nullptr;
+    cached_bytes_.fetch_sub(BlockSize(size_class), std::memory_order_relaxed);
+    return shared.free_list.Pop();
+  }
+
+  // Pushes a block to the shared free list, or releases it to the underlying
+  // allocator if the shared free lists are full.
+  LLVM_ATTRIBUTE_NOINLINE void PushShared(int size_class, FreeBlock* block) {
+    size_t block_size = BlockSize(size_class);
+    if (cached_bytes_.fetch_add(block_size, std::memory_order_relaxed) +
+            block_size <=
+        max_cached_bytes_) {
+      SharedFreeList& shared = shared_free_lists_[size_class];
+      mutex_lock lock(shared.mu);
+      shared.free_list.Push(block);
+      return;
+    }
+
+    cached_bytes_.fetch_sub(block_size, std::memory_order_relaxed);
+    {
+      mutex_lock lock(blocks_mu_);
+      blocks_.erase(block);
+      --num_blocks_[size_class];
+    }
+    allocator_->DeallocateBytes(block, block_size);
+  }
+
+  static std::atomic<uint64_t> next_id_;
+
+  const uint64_t id_;
+  std::unique_ptr<HostAllocator> allocator_;
+  const size_t max_cached_bytes_;
+  const std::string profile_path_;
+
+  // Number of bytes in the shared free lists.
+  std::atomic<size_t> cached_bytes_{0};
+  SharedFreeList shared_free_lists_[kNumSizeClasses];
+
+  // All blocks allocated from the underlying allocator and not yet released,
+  // with their sizes.
+  mutex blocks_mu_;
+  llvm::DenseMap<void*, size_t> blocks_ TFRT_GUARDED_BY(blocks_mu_);
+  // Current and peak number of blocks of every size class.
+  int num_blocks_[kNumSizeClasses] TFRT_GUARDED_BY(blocks_mu_) = {};
+  int peak_blocks_[kNumSizeClasses] TFRT_GUARDED_BY(blocks_mu_) = {};
+};
+
+std::atomic<uint64_t> BufferPoolAllocator::next_id_{1};
+
+}  // namespace
+
+std::unique_ptr<HostAllocator> CreateBufferPoolAllocator(
+    std::unique_ptr<HostAllocator> allocator, size_t max_cached_bytes,
+    string_view profile_path) {
+  return std::make_unique<BufferPoolAllocator>(
+      std::move(allocator), max_cached_bytes, profile_path);
+}
+
+}  // namespace tfrt
@@ -41,6 +41,24 @@ WorkQueueFactoryMap* GetWorkQueueFactories() {
 
 ConcurrentWorkQueue::~ConcurrentWorkQueue() = default;
 
+void ConcurrentWorkQueue::AddTasks(MutableArrayRef<TaskFunction> work) {
+  for (TaskFunction& task : work) AddTask(std::move(task));
+}
+
+void ConcurrentWorkQueue::AddTaskWithPriority(TaskFunction work,
+                                              TaskPriority priority) {
+  AddTask(std::move(work));
+}
+
+void ConcurrentWorkQueue::AddTasksWithPriority(
+    MutableArrayRef<TaskFunction> work, TaskPriority priority) {
+  AddTasks(work);
+}
+
+void ConcurrentWorkQueue::AddNextTask(TaskFunction work) {
+  AddTask(std::move(work));
+}
+
 void RegisterWorkQueueFactory(string_view name, WorkQueueFactory factory) {
   auto p = GetWorkQueueFactories()->try_emplace(name, std::move(factory));
   (void)p;
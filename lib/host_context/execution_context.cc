@@ -32,27 +32,49 @@ RequestContext::~RequestContext() {
   }
 }
 
-void RequestContext::Cancel() {
-  // Create an AsyncValue in error state for cancel.
-  auto* error_value =
+// All cancelled requests share a single error AsyncValue, which is never
+// freed, so that cancelling many requests at once, e.g. under overload, does
+// not allocate.
+static ErrorAsyncValue* GetCancelledError() {
+  static ErrorAsyncValue* const error_value =
       MakeErrorAsyncValueRef(absl::CancelledError("Cancelled")).release();
+  return error_value;
+}
+
+void RequestContext::Cancel() {
+  ErrorAsyncValue* error_value = GetCancelledError();
 
   ErrorAsyncValue* expected_value = nullptr;
   // Use memory_order_release for the success case so that error_value is
   // visible to other threads when they load with memory_order_acquire. For the
   // failure case, we do not care about expected_value, so we can use
   // memory_order_relaxed.
-  if (!cancel_value_.compare_exchange_strong(expected_value, error_value,
-                                             std::memory_order_release,
-                                             std::memory_order_relaxed)) {
-    error_value->DropRef();
+  if (cancel_value_.compare_exchange_strong(expected_value, error_value,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    error_value->AddRef();
   }
 }
 
 Expected<RCReference<RequestContext>> RequestContextBuilder::build() && {
-  return TakeRef(new RequestContext(host_, resource_context_,
-                                    std::move(context_data_), id_,
-                                    enable_cost_measurement_));
+  // Admit the request first, so that rejected requests are cheap.
+  if (!admission_token_ && admission_controller_) {
+    auto token = admission_controller_->TryAdmit(request_options_.priority);
+    if (!token) return token.takeError();
+    admission_token_ = std::move(*token);
+  }
+
+  RCReference<ArenaAllocator> arena;
+  if (arena_block_size_ > 0)
+    arena = TakeRef(new ArenaAllocator(host_->allocator(), arena_block_size_));
+
+  auto request = TakeRef(new RequestContext(
+      host_, resource_context_, std::move(context_data_), id_,
+      enable_cost_measurement_, std::move(arena), request_options_.priority));
+  if (SampleHostCounters())
+    request->host_counters_ = std::make_unique<HostCounters>();
+  request->admission_token_ = std::move(admission_token_);
+  return std::move(request);
 };
 
 ExecutionContext::ExecutionContext(RCReference<RequestContext> req_ctx,
@@ -61,4 +83,9 @@ ExecutionContext::ExecutionContext(RCReference<RequestContext> req_ctx,
       work_queue_(&host()->work_queue()),
       location_{location} {}
 
+HostAllocator* ExecutionContext::temporary_allocator() const {
+  if (auto* arena = request_ctx_->arena()) return arena;
+  return host()->allocator();
+}
+
 }  // namespace tfrt
@@ -39,6 +39,23 @@ class MallocAllocator : public HostAllocator {
 
 void HostAllocator::VtableAnchor() {}
 
+std::atomic<bool> AllocationSiteScope::kEnabled{false};
+
+static thread_local AllocationSiteScope* current_allocation_site = nullptr;
+
+void AllocationSiteScope::Push(llvm::function_ref<std::string()> get_name) {
+  get_name_ = get_name;
+  parent_ = current_allocation_site;
+  current_allocation_site = this;
+}
+
+void AllocationSiteScope::Pop() { current_allocation_site = parent_; }
+
+std::string AllocationSiteScope::CurrentName() {
+  if (current_allocation_site == nullptr) return {};
+  return current_allocation_site->get_name_();
+}
+
 std::unique_ptr<HostAllocator> CreateMallocAllocator() {
   return std::make_unique<MallocAllocator>();
 }
@@ -23,6 +23,7 @@
 #include "tfrt/host_context/concurrent_work_queue.h"
 #include "tfrt/host_context/function.h"
 #include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_counters.h"
 #include "tfrt/host_context/location.h"
 #include "tfrt/host_context/shared_context.h"
 #include "tfrt/support/string_util.h"
@@ -79,6 +80,7 @@ void HostContext::EmitError(const DecodedDiagnostic& diagnostic) {
 
 // Allocate the specified number of bytes at the specified alignment.
 void* HostContext::AllocateBytes(size_t size, size_t alignment) {
+  AddHostCounter(/*request=*/nullptr, HostCounter::kAllocatedBytes, size);
   return allocator_->AllocateBytes(size, alignment);
 }
 
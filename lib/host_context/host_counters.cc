@@ -0,0 +1,122 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file implements the host runtime counters.
+
+#include "tfrt/host_context/host_counters.h"
+
+#include <array>
+#include <string>
+
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/metrics/metrics.h"
+
+namespace tfrt {
+namespace internal {
+
+std::atomic<bool> host_counters_enabled{false};
+
+}  // namespace internal
+
+namespace {
+
+// Number of counted events after which a thread flushes its counts.
+constexpr int kFlushPeriod = 1024;
+
+std::atomic<int> sampling_period{0};
+std::atomic<uint64_t> num_requests{0};
+
+metrics::Counter* GetMetric(int index) {
+  static auto* counters = [] {
+    auto* counters = new std::array<metrics::Counter*, kNumHostCounters>;
+    for (int i = 0; i < kNumHostCounters; ++i) {
+      (*counters)[i] = metrics::NewCounter(
+          std::string("/tfrt/host_context/counters/") +
+          GetHostCounterName(static_cast<HostCounter>(i)));
+    }
+    return counters;
+  }();
+  return (*counters)[index];
+}
+
+// The counts of one thread which have not been flushed yet.
+struct ThreadCounts {
+  ~ThreadCounts() { Flush(); }
+
+  void Add(HostCounter counter, int64_t value) {
+    counts[static_cast<int>(counter)] += value;
+    if (++num_events == kFlushPeriod) Flush();
+  }
+
+  void Flush() {
+    for (int i = 0; i < kNumHostCounters; ++i) {
+      if (counts[i] == 0) continue;
+      GetMetric(i)->IncrementBy(counts[i]);
+      counts[i] = 0;
+    }
+    num_events = 0;
+  }
+
+  std::array<int64_t, kNumHostCounters> counts = {};
+  int num_events = 0;
+};
+
+ThreadCounts& GetThreadCounts() {
+  thread_local ThreadCounts counts;
+  return counts;
+}
+
+}  // namespace
+
+const char* GetHostCounterName(HostCounter counter) {
+  switch (counter) {
+    case HostCounter::kTasks:
+      return "tasks";
+    case HostCounter::kBlockingTasks:
+      return "blocking_tasks";
+    case HostCounter::kExecutors:
+      return "executors";
+    case HostCounter::kAllocatedBytes:
+      return "allocated_bytes";
+  }
+  return "unknown";
+}
+
+void SetHostCountersSamplingPeriod(int period) {
+  sampling_period.store(period, std::memory_order_relaxed);
+  internal::host_counters_enabled.store(period > 0, std::memory_order_relaxed);
+}
+
+bool SampleHostCounters() {
+  int period = sampling_period.load(std::memory_order_relaxed);
+  if (period <= 0) return false;
+  return num_requests.fetch_add(1, std::memory_order_relaxed) % period == 0;
+}
+
+void FlushHostCounters() { GetThreadCounts().Flush(); }
+
+namespace internal {
+
+void AddHostCounter(RequestContext* request, HostCounter counter,
+                    int64_t value) {
+  GetThreadCounts().Add(counter, value);
+  if (request == nullptr) return;
+  if (HostCounters* counters = request->host_counters())
+    counters->Add(counter, value);
+}
+
+}  // namespace internal
+}  // namespace tfrt
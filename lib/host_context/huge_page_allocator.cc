@@ -0,0 +1,215 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements a host allocator that backs large allocations with huge
+// pages.
+//
+// Allocations of at least one huge page (2 MiB) are served from huge page
+// aligned memory, so that large weight and activation buffers need few TLB
+// entries. They are carved from a reserved region if one was requested and it
+// has room, and otherwise mapped one by one and marked for transparent huge
+// pages. The reserved region is mapped from the hugetlbfs pool (1 GiB pages if
+// its size allows, then 2 MiB pages) when the system has reserved huge pages,
+// and from transparent huge pages otherwise. It is populated up front, so the
+// allocations served from it never page fault. Smaller allocations are
+// forwarded to the underlying allocator.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+
+#include "llvm/Support/MathExtras.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace tfrt {
+namespace {
+
+#if defined(__linux__)
+
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+constexpr size_t kGiantPageSize = 1024 * 1024 * 1024;
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+// Maps `size` bytes aligned to `alignment` with transparent huge pages enabled.
+// Returns nullptr on failure. Like in the NUMA allocator, the mapping is
+// over-mapped by the alignment and the unused head and tail are unmapped.
+void* MapAligned(size_t size, size_t alignment) {
+  size_t extra = alignment;
+  void* mapping = mmap(nullptr, size + extra, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) return nullptr;
+
+  auto* ptr = static_cast<char*>(mapping);
+  auto* aligned = reinterpret_cast<char*>(
+      llvm::alignTo(reinterpret_cast<uintptr_t>(ptr), alignment));
+  if (aligned > ptr) munmap(ptr, aligned - ptr);
+  size_t tail = extra - (aligned - ptr);
+  if (tail > 0) munmap(aligned + size, tail);
+
+  madvise(aligned, size, MADV_HUGEPAGE);
+  return aligned;
+}
+
+// Maps `size` bytes from the hugetlbfs pool with pages of `page_size`. Returns
+// nullptr if the system has no such pages reserved.
+void* MapHugeTlb(size_t size, size_t page_size) {
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE |
+              (llvm::Log2_64(page_size) << MAP_HUGE_SHIFT);
+  void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+  return mapping == MAP_FAILED ? nullptr : mapping;
+}
+
+#endif  // defined(__linux__)
+
+class HugePageAllocator : public HostAllocator {
+ public:
+  HugePageAllocator(std::unique_ptr<HostAllocator> allocator,
+                    size_t reserved_bytes)
+      : allocator_(std::move(allocator)) {
+#if defined(__linux__)
+    if (reserved_bytes > 0) Reserve(reserved_bytes);
+#endif
+  }
+
+#if defined(__linux__)
+  ~HugePageAllocator() override {
+    if (reserved_ != nullptr) munmap(reserved_, reserved_size_);
+  }
+
+  void* AllocateBytes(size_t size, size_t alignment) override {
+    if (size < kHugePageSize) return allocator_->AllocateBytes(size, alignment);
+
+    size_t mapped_size = MappedSize(size);
+    if (alignment <= kHugePageSize) {
+      if (void* ptr = AllocateReserved(mapped_size)) return ptr;
+    }
+    return MapAligned(mapped_size, std::max(alignment, kHugePageSize));
+  }
+
+  void DeallocateBytes(void* ptr, size_t size) override {
+    if (size < kHugePageSize) return allocator_->DeallocateBytes(ptr, size);
+
+    size_t mapped_size = MappedSize(size);
+    auto* p = static_cast<char*>(ptr);
+    if (p >= reserved_ && p < reserved_ + reserved_size_) {
+      DeallocateReserved(p - reserved_, mapped_size);
+      return;
+    }
+    munmap(ptr, mapped_size);
+  }
+#else
+  void* AllocateBytes(size_t size, size_t alignment) override {
+    return allocator_->AllocateBytes(size, alignment);
+  }
+
+  void DeallocateBytes(void* ptr, size_t size) override {
+    allocator_->DeallocateBytes(ptr, size);
+  }
+#endif
+
+ private:
+#if defined(__linux__)
+  static size_t MappedSize(size_t size) {
+    return llvm::alignTo(size, kHugePageSize);
+  }
+
+  // Maps the reserved region, preferring the largest available page size.
+  void Reserve(size_t reserved_bytes) {
+    if (reserved_bytes % kGiantPageSize == 0) {
+      reserved_ =
+          static_cast<char*>(MapHugeTlb(reserved_bytes, kGiantPageSize));
+    }
+    if (reserved_ == nullptr) {
+      reserved_bytes = MappedSize(reserved_bytes);
+      reserved_ = static_cast<char*>(MapHugeTlb(reserved_bytes, kHugePageSize));
+    }
+    if (reserved_ == nullptr) {
+      reserved_ = static_cast<char*>(MapAligned(reserved_bytes, kHugePageSize));
+      if (reserved_ == nullptr) return;
+      // Touch every page now, so that the first allocations from the region
+      // don't pay for page faults. MAP_POPULATE does this for hugetlbfs.
+      for (size_t i = 0; i < reserved_bytes; i += kHugePageSize)
+        reserved_[i] = 0;
+    }
+    reserved_size_ = reserved_bytes;
+    free_ranges_[0] = reserved_bytes;
+  }
+
+  // Returns the first free range of the reserved region that fits `size`
+  // bytes, or nullptr if there is none.
+  void* AllocateReserved(size_t size) {
+    if (reserved_ == nullptr) return nullptr;
+    mutex_lock lock(mu_);
+    for (auto it = free_ranges_.begin(); it != free_ranges_.end(); ++it) {
+      if (it->second < size) continue;
+      size_t offset = it->first;
+      size_t remaining = it->second - size;
+      free_ranges_.erase(it);
+      if (remaining > 0) free_ranges_[offset + size] = remaining;
+      return reserved_ + offset;
+    }
+    return nullptr;
+  }
+
+  // Returns the range at `offset` to the reserved region, merging it with the
+  // adjacent free ranges.
+  void DeallocateReserved(size_t offset, size_t size) {
+    mutex_lock lock(mu_);
+    auto next = free_ranges_.lower_bound(offset);
+    if (next != free_ranges_.end() && offset + size == next->first) {
+      size += next->second;
+      next = free_ranges_.erase(next);
+    }
+    if (next != free_ranges_.begin()) {
+      auto prev = std::prev(next);
+      if (prev->first + prev->second == offset) {
+        prev->second += size;
+        return;
+      }
+    }
+    free_ranges_[offset] = size;
+  }
+
+  char* reserved_ = nullptr;
+  size_t reserved_size_ = 0;
+
+  // Free ranges of the reserved region, keyed by offset.
+  mutex mu_;
+  std::map<size_t, size_t> free_ranges_ TFRT_GUARDED_BY(mu_);
+#endif
+
+  std::unique_ptr<HostAllocator> allocator_;
+};
+
+}  // namespace
+
+std::unique_ptr<HostAllocator> CreateHugePageAllocator(
+    std::unique_ptr<HostAllocator> allocator, size_t reserved_bytes) {
+  return std::make_unique<HugePageAllocator>(std::move(allocator),
+                                             reserved_bytes);
+}
+
+}  // namespace tfrt
@@ -16,11 +16,18 @@
 
 #include "tfrt/host_context/kernel_registry.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <string>
 #include <vector>
 
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/xxhash.h"
+#include "tfrt/host_context/native_function.h"
 #include "tfrt/host_context/type_name.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/mutex.h"
@@ -30,8 +37,117 @@ namespace tfrt {
 using llvm::StringMap;
 using llvm::StringSet;
 
+namespace {
+
+// Kernel implementations in a perfect hash table built with the "hash,
+// displace" scheme: every name hashes to a bucket, and every bucket has a seed
+// that maps the names in the bucket to distinct slots of the table. The names
+// are stored in a single buffer, so a lookup touches the seed, the slot and the
+// name, and does not allocate.
+class FrozenKernelTable {
+ public:
+  // Returns nullptr if no table could be built.
+  static std::unique_ptr<FrozenKernelTable> Build(
+      const StringMap<KernelImplementation>& implementations);
+
+  // Returns nullptr if there is no kernel with `name`.
+  const KernelImplementation* Find(string_view name) const {
+    uint64_t hash = llvm::xxHash64(name);
+    const Slot& slot = slots_[SlotIndex(hash, seeds_[hash & bucket_mask_])];
+    if (string_view(names_.data() + slot.name_offset, slot.name_size) != name ||
+        slot.implementation.is<Monostate>())
+      return nullptr;
+    return &slot.implementation;
+  }
+
+ private:
+  struct Slot {
+    uint32_t name_offset = 0;
+    uint32_t name_size = 0;
+    KernelImplementation implementation;
+  };
+
+  size_t SlotIndex(uint64_t hash, uint32_t seed) const {
+    // Mix the seed into the hash with the MurmurHash3 finalizer.
+    uint64_t x = hash ^ (seed * 0x9e3779b97f4a7c15ull);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    return x & slot_mask_;
+  }
+
+  uint64_t bucket_mask_ = 0;
+  uint64_t slot_mask_ = 0;
+  std::vector<uint32_t> seeds_;
+  std::vector<Slot> slots_;
+  std::string names_;
+};
+
+std::unique_ptr<FrozenKernelTable> FrozenKernelTable::Build(
+    const StringMap<KernelImplementation>& implementations) {
+  // Seeds to try for each bucket before giving up. With the table at most 80%
+  // full this is never reached in practice.
+  constexpr uint32_t kMaxSeed = 1 << 16;
+
+  auto table = std::make_unique<FrozenKernelTable>();
+  size_t num_kernels = std::max<size_t>(implementations.size(), 1);
+  size_t num_buckets = llvm::PowerOf2Ceil((num_kernels + 1) / 2);
+  size_t num_slots = llvm::PowerOf2Ceil(num_kernels + num_kernels / 4);
+  table->bucket_mask_ = num_buckets - 1;
+  table->slot_mask_ = num_slots - 1;
+  table->seeds_.resize(num_buckets);
+  table->slots_.resize(num_slots);
+
+  // Group the names by bucket, and place the largest buckets first.
+  std::vector<std::vector<string_view>> buckets(num_buckets);
+  for (const auto& entry : implementations)
+    buckets[llvm::xxHash64(entry.getKey()) & table->bucket_mask_].push_back(
+        entry.getKey());
+  std::vector<size_t> order(num_buckets);
+  for (size_t i = 0; i < num_buckets; ++i) order[i] = i;
+  llvm::stable_sort(order, [&](size_t a, size_t b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  std::vector<bool> used(num_slots);
+  std::vector<size_t> bucket_slots;
+  for (size_t bucket : order) {
+    if (buckets[bucket].empty()) break;
+
+    // Find a seed that maps all names of the bucket to distinct free slots.
+    uint32_t seed = 0;
+    for (;; ++seed) {
+      if (seed == kMaxSeed) return nullptr;
+      bucket_slots.clear();
+      for (string_view name : buckets[bucket]) {
+        size_t slot = table->SlotIndex(llvm::xxHash64(name), seed);
+        if (used[slot] || llvm::is_contained(bucket_slots, slot)) break;
+        bucket_slots.push_back(slot);
+      }
+      if (bucket_slots.size() == buckets[bucket].size()) break;
+    }
+
+    table->seeds_[bucket] = seed;
+    for (auto it : llvm::zip(buckets[bucket], bucket_slots)) {
+      string_view name = std::get<0>(it);
+      Slot& slot = table->slots_[std::get<1>(it)];
+      used[std::get<1>(it)] = true;
+      slot.name_offset = table->names_.size();
+      slot.name_size = name.size();
+      slot.implementation = implementations.find(name)->second;
+      table->names_.append(name.begin(), name.end());
+    }
+  }
+
+  return table;
+}
+
+}  // namespace
+
 struct KernelRegistry::Impl {
   StringMap<KernelImplementation> implementations;
+  // Built by Freeze(), and dropped when kernels are added.
+  std::unique_ptr<FrozenKernelTable> frozen;
   StringSet<> type_names TFRT_GUARDED_BY(mu);
   mutex mu;
 };
@@ -42,6 +158,7 @@ KernelRegistry::~KernelRegistry() {}
 
 void KernelRegistry::AddKernel(string_view kernel_name,
                                AsyncKernelImplementation fn) {
+  impl_->frozen.reset();
   bool added =
       impl_->implementations.try_emplace(kernel_name, KernelImplementation{fn})
           .second;
@@ -51,6 +168,7 @@ void KernelRegistry::AddKernel(string_view kernel_name,
 
 void KernelRegistry::AddSyncKernel(string_view kernel_name,
                                    SyncKernelImplementation fn) {
+  impl_->frozen.reset();
   bool added =
       impl_->implementations.try_emplace(kernel_name, KernelImplementation{fn})
           .second;
@@ -59,11 +177,20 @@ void KernelRegistry::AddSyncKernel(string_view kernel_name,
 }
 
 KernelImplementation KernelRegistry::GetKernel(string_view kernel_name) const {
+  if (impl_->frozen) {
+    const KernelImplementation* kernel = impl_->frozen->Find(kernel_name);
+    return kernel ? *kernel : KernelImplementation();
+  }
+
   auto it = impl_->implementations.find(kernel_name);
   return it == impl_->implementations.end() ? KernelImplementation()
                                             : it->second;
 }
 
+void KernelRegistry::Freeze() {
+  impl_->frozen = FrozenKernelTable::Build(impl_->implementations);
+}
+
 TypeName KernelRegistry::GetType(string_view type_name) const {
   mutex_lock lock(impl_->mu);
   auto it = impl_->type_names.insert(type_name).first;
@@ -84,6 +211,9 @@ void RegisterStaticKernels(KernelRegistry* kernel_reg) {
   for (auto func : *GetStaticKernelRegistrations()) {
     func(kernel_reg);
   }
+  kernel_reg->Freeze();
+  // Native functions are registered by static constructors as well.
+  NativeFunctionRegistry::GetGlobalRegistry().Freeze();
 }
 
 }  // namespace tfrt
@@ -0,0 +1,112 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements a host allocator that places large allocations on the
+// NUMA node of the calling thread.
+//
+// Large allocations are mapped directly from the kernel and bound to the node
+// that the calling worker thread runs on (see CreateNumaWorkQueue). The size
+// threshold matches the default mmap threshold of glibc malloc, so large
+// allocations cost about the same system calls as with malloc. Smaller
+// allocations are forwarded to the underlying allocator, and usually end up
+// on the right node anyway, because pinned worker threads touch them first.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "llvm/Support/MathExtras.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/support/numa.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace tfrt {
+namespace {
+
+class NumaAllocator : public HostAllocator {
+ public:
+  explicit NumaAllocator(std::unique_ptr<HostAllocator> allocator)
+      : allocator_(std::move(allocator)) {}
+
+#if defined(__linux__)
+  void* AllocateBytes(size_t size, size_t alignment) override {
+    if (size < kMinMappedSize)
+      return allocator_->AllocateBytes(size, alignment);
+
+    // Over-map by the alignment and unmap the unused head and tail, so that
+    // the mapping is exactly [ptr, ptr + MappedSize(size)).
+    size_t mapped_size = MappedSize(size);
+    size_t extra = alignment > page_size_ ? alignment : 0;
+    void* mapping = mmap(nullptr, mapped_size + extra, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) return nullptr;
+
+    auto* ptr = static_cast<char*>(mapping);
+    if (extra > 0) {
+      auto* aligned = reinterpret_cast<char*>(
+          llvm::alignTo(reinterpret_cast<uintptr_t>(ptr), alignment));
+      if (aligned > ptr) munmap(ptr, aligned - ptr);
+      size_t tail = extra - (aligned - ptr);
+      if (tail > 0) munmap(aligned + mapped_size, tail);
+      ptr = aligned;
+    }
+
+    // Pages are not allocated until they are touched, so binding the range
+    // before returning it places all of them on the node.
+    int node = numa::GetCurrentThreadNode();
+    if (node >= 0) numa::BindMemoryToNode(ptr, mapped_size, node);
+
+    return ptr;
+  }
+
+  void DeallocateBytes(void* ptr, size_t size) override {
+    if (size < kMinMappedSize) return allocator_->DeallocateBytes(ptr, size);
+    munmap(ptr, MappedSize(size));
+  }
+#else
+  void* AllocateBytes(size_t size, size_t alignment) override {
+    return allocator_->AllocateBytes(size, alignment);
+  }
+
+  void DeallocateBytes(void* ptr, size_t size) override {
+    allocator_->DeallocateBytes(ptr, size);
+  }
+#endif
+
+ private:
+  static constexpr size_t kMinMappedSize = 128 * 1024;
+
+#if defined(__linux__)
+  size_t MappedSize(size_t size) const {
+    return llvm::alignTo(size, page_size_);
+  }
+
+  const size_t page_size_ = sysconf(_SC_PAGESIZE);
+#endif
+
+  std::unique_ptr<HostAllocator> allocator_;
+};
+
+}  // namespace
+
+std::unique_ptr<HostAllocator> CreateNumaAllocator(
+    std::unique_ptr<HostAllocator> allocator) {
+  return std::make_unique<NumaAllocator>(std::move(allocator));
+}
+
+}  // namespace tfrt
@@ -18,6 +18,8 @@
 
 #include "tfrt/host_context/parallel_for.h"
 
+#include <algorithm>
+
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/chain.h"
 #include "tfrt/host_context/host_context.h"
@@ -30,26 +32,111 @@ using BlockSizes = ParallelFor::BlockSizes;
 // BlockSizes configures how a range is split into blocks executed in parallel.
 //===----------------------------------------------------------------------===//
 
+namespace {
+
+// Do not create too many small blocks.
+constexpr size_t kMaxOversharding = 4;
+
+// Cost model parameters (in cycles) borrowed from Eigen's TensorCostModel.
+//
+// Loading or storing a byte is assumed to cost 11/64 of a cycle, with data
+// that does not fit into the caches being bandwidth bound.
+constexpr double kLoadCycles = 11.0 / 64;
+constexpr double kStoreCycles = 11.0 / 64;
+// Cost of starting the parallel execution, and of using one more thread.
+constexpr double kStartupCycles = 100000;
+constexpr double kPerThreadCycles = 100000;
+// Cost of a single task that amortizes the cost of scheduling it.
+constexpr double kTaskSizeCycles = 40000;
+
+// Faster equivalent of `std::ceil((float) x / (float) y)`.
+size_t DivUp(size_t x, size_t y) {
+  assert(y > 0);
+  return (x + y - 1) / y;
+}
+
+// Returns the fraction of worker thread time used by `num_blocks` blocks of
+// equal size, if blocks are executed in rounds of `num_threads` blocks.
+double BlockEfficiency(size_t num_blocks, size_t num_threads) {
+  return static_cast<double>(num_blocks) /
+         (DivUp(num_blocks, num_threads) * num_threads);
+}
+
+}  // namespace
+
 BlockSizes ParallelFor::BlockSizes::Fixed(size_t n) {
-  return BlockSizes([n](size_t) { return n; });
+  return BlockSizes([n](size_t, size_t) { return n; });
 }
 
 BlockSizes ParallelFor::BlockSizes::Min(size_t min) {
-  return BlockSizes(
-      [min](size_t block_size) { return std::max(min, block_size); });
+  return BlockSizes([min](size_t num_worker_threads, size_t total_size) {
+    return std::max(min, DefaultBlockSize(num_worker_threads, total_size));
+  });
 }
 
-size_t ParallelFor::BlockSizes::GetBlockSize(size_t num_worker_threads,
-                                             size_t total_size) const {
-  // Do not create too many small blocks.
-  static constexpr size_t kMaxOversharding = 4;
+BlockSizes ParallelFor::BlockSizes::Cost(double bytes_loaded,
+                                         double bytes_stored,
+                                         double compute_cycles) {
+  const double cost = bytes_loaded * kLoadCycles + bytes_stored * kStoreCycles +
+                      compute_cycles;
+
+  return BlockSizes([cost](size_t num_worker_threads, size_t total_size) {
+    // The number of threads worth using for the whole range.
+    const double total_cost = cost * total_size;
+    const double threads = (total_cost - kStartupCycles) / kPerThreadCycles;
+    if (num_worker_threads <= 1 || threads + 0.9 < 2.0) return total_size;
+    const size_t num_threads =
+        std::min(num_worker_threads, static_cast<size_t>(threads + 0.9));
+
+    // Do not create blocks cheaper than a single task scheduling cost, and do
+    // not create too many blocks per thread.
+    const size_t task_size =
+        cost > 0 ? static_cast<size_t>(kTaskSizeCycles / cost) : total_size;
+    size_t block_size =
+        std::max(DivUp(total_size, kMaxOversharding * num_threads), task_size);
+    block_size = std::min(std::max<size_t>(block_size, 1), total_size);
+
+    // Make blocks coarser (up to 2x of the original size) if it improves the
+    // balance between the worker threads, e.g. prefer 4 blocks for 4 threads
+    // to 5 smaller blocks.
+    const size_t max_block_size = std::min(total_size, 2 * block_size);
+    size_t num_blocks = DivUp(total_size, block_size);
+    double max_efficiency = BlockEfficiency(num_blocks, num_threads);
+
+    for (size_t prev_num_blocks = num_blocks;
+         max_efficiency < 1.0 && prev_num_blocks > 1;) {
+      const size_t coarser_block_size = DivUp(total_size, prev_num_blocks - 1);
+      if (coarser_block_size > max_block_size) break;
+
+      const size_t coarser_num_blocks = DivUp(total_size, coarser_block_size);
+      prev_num_blocks = coarser_num_blocks;
+
+      // Slightly prefer fewer blocks at the same efficiency.
+      const double coarser_efficiency =
+          BlockEfficiency(coarser_num_blocks, num_threads);
+      if (coarser_efficiency + 0.01 >= max_efficiency) {
+        block_size = coarser_block_size;
+        max_efficiency = std::max(max_efficiency, coarser_efficiency);
+      }
+    }
 
+    return block_size;
+  });
+}
+
+size_t ParallelFor::BlockSizes::DefaultBlockSize(size_t num_worker_threads,
+                                                 size_t total_size) {
   // Split input range to assign `kMaxOversharding` tasks to each worker thread.
+  return total_size / (kMaxOversharding * num_worker_threads);
+}
+
+size_t ParallelFor::BlockSizes::GetBlockSize(size_t num_worker_threads,
+                                             size_t total_size) const {
   assert(total_size > 0 && "Illegal total size");
-  size_t block_size = total_size / (kMaxOversharding * num_worker_threads);
 
   // Compute final block sizes using implementation function if it is specified.
-  if (impl_) block_size = impl_(block_size);
+  size_t block_size = impl_ ? impl_(num_worker_threads, total_size)
+                            : DefaultBlockSize(num_worker_threads, total_size);
   assert(block_size >= 0 && "Illegal block size");
   block_size = std::min(block_size, total_size);
 
@@ -61,6 +148,15 @@ size_t ParallelFor::BlockSizes::GetBlockSize(size_t num_worker_threads,
 //===----------------------------------------------------------------------===//
 namespace {
 
+// The number of blocks of split ranges that the current thread is computing
+// (more than one if a block runs a nested ParallelFor).
+thread_local int parallel_region_depth = 0;
+
+struct ParallelRegion {
+  ParallelRegion() { ++parallel_region_depth; }
+  ~ParallelRegion() { --parallel_region_depth; }
+};
+
 // If ParallelFor will choose to execute the `compute` function asynchronously,
 // it will move all the arguments into this context, and will keep it on the
 // heap, until all submitted asynchronous work is completed.
@@ -81,27 +177,51 @@ class ParallelForExecutionContext {
   // evaluates a single block in the caller thread. Blocks to evaluate are
   // specified by the half-open interval [start_block, end_block).
   void EvalBlocks(size_t start_block, size_t end_block) {
-    while (end_block - start_block > 1) {
-      const size_t mid_block = start_block + (end_block - start_block) / 2;
-
-      // Evaluate [mid_block, end_block) blocks.
-      EnqueueWork(exec_ctx_, [this, mid_block, end_block]() {
-        EvalBlocks(mid_block, end_block);
-      });
-
-      // Current range becomes [start_block, mid_block).
-      end_block = mid_block;
+    {
+      // Submit all split ranges to the work queue at once.
+      EnqueueWorkBatch batch;
+      while (end_block - start_block > 1) {
+        const size_t mid_block = start_block + (end_block - start_block) / 2;
+
+        // Evaluate [mid_block, end_block) blocks.
+        EnqueueWork(exec_ctx_, [this, mid_block, end_block]() {
+          EvalBlocks(mid_block, end_block);
+        });
+
+        // Current range becomes [start_block, mid_block).
+        end_block = mid_block;
+      }
     }
 
     assert(end_block - start_block == 1);
 
     // Call `compute` for a single block.
-    compute_(start_block * block_size_, std::min(n_, end_block * block_size_));
+    {
+      ParallelRegion region;
+      compute_(start_block * block_size_,
+               std::min(n_, end_block * block_size_));
+    }
 
     // Delete this context if it was the last block.
     if (pending_blocks_.fetch_sub(1) == 1) delete this;
   }
 
+  // Splits the block range [start_block, end_block) in half and enqueues both
+  // halves to the HostContext, without evaluating any blocks in the caller
+  // thread. Each half is further split by EvalBlocks() in the worker threads.
+  void EnqueueBlocks(size_t start_block, size_t end_block) {
+    assert(end_block - start_block > 1);
+    const size_t mid_block = start_block + (end_block - start_block) / 2;
+
+    EnqueueWorkBatch batch;
+    EnqueueWork(exec_ctx_, [this, start_block, mid_block]() {
+      EvalBlocks(start_block, mid_block);
+    });
+    EnqueueWork(exec_ctx_, [this, mid_block, end_block]() {
+      EvalBlocks(mid_block, end_block);
+    });
+  }
+
   int PendingBlocks() { return pending_blocks_; }
 
  private:
@@ -118,12 +238,6 @@ class ParallelForExecutionContext {
 
   ~ParallelForExecutionContext() { on_done_(); }
 
-  // Faster equivalent of `std::ceil((float) x / (float) y)`.
-  static size_t DivUp(const size_t x, const size_t y) {
-    assert(y > 0);
-    return (x + y - 1) / y;
-  }
-
   ExecutionContext exec_ctx_;  // The data in exec_ctx_ must stay alive before
                                // the `on_done` is called
 
@@ -137,6 +251,8 @@ class ParallelForExecutionContext {
 
 }  // namespace
 
+bool ParallelFor::IsInParallelRegion() { return parallel_region_depth > 0; }
+
 void ParallelFor::Execute(size_t total_size, const BlockSizes& block_sizes,
                           llvm::unique_function<void(size_t, size_t)> compute,
                           llvm::unique_function<void()> on_done) const {
@@ -160,7 +276,14 @@ void ParallelFor::Execute(size_t total_size, const BlockSizes& block_sizes,
   ParallelForExecutionContext* ctx = ParallelForExecutionContext::Allocate(
       exec_ctx_, total_size, block_size, std::move(compute),
       std::move(on_done));
-  ctx->EvalBlocks(0, ctx->PendingBlocks());
+  switch (split_mode_) {
+    case SplitMode::kCaller:
+      ctx->EvalBlocks(0, ctx->PendingBlocks());
+      break;
+    case SplitMode::kWorkers:
+      ctx->EnqueueBlocks(0, ctx->PendingBlocks());
+      break;
+  }
 }
 
 AsyncValueRef<Chain> ParallelFor::Execute(
@@ -19,16 +19,141 @@
 
 #include "tfrt/host_context/profiled_allocator.h"
 
+#include <algorithm>
 #include <atomic>
+#include <cinttypes>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
 #include "tfrt/host_context/host_allocator.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/random_util.h"
+#include "tfrt/support/thread_annotations.h"
 
 namespace tfrt {
 
 namespace {
 
+class AllocationSampler {
+ public:
+  static AllocationSampler& Get() {
+    static auto* sampler = new AllocationSampler;
+    return *sampler;
+  }
+
+  void Enable(const AllocationSamplingOptions& options) {
+    sampling_bytes_.store(std::max<int64_t>(options.sampling_bytes, 1),
+                          std::memory_order_relaxed);
+    stack_traces_.store(options.stack_traces, std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_relaxed);
+    AllocationSiteScope::kEnabled.store(true, std::memory_order_relaxed);
+  }
+
+  void Disable() {
+    enabled_.store(false, std::memory_order_relaxed);
+    AllocationSiteScope::kEnabled.store(false, std::memory_order_relaxed);
+  }
+
+  bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  // Counts `size` bytes towards the sampling interval of the calling thread,
+  // and samples the allocation if the interval is over.
+  void MaybeSample(size_t size) {
+    thread_local ThreadState state;
+    const int64_t sampling_bytes =
+        sampling_bytes_.load(std::memory_order_relaxed);
+    if (LLVM_UNLIKELY(!state.initialized)) {
+      state.rng.seed(random::New64());
+      state.bytes_until_sample = NextInterval(state, sampling_bytes);
+      state.initialized = true;
+    }
+
+    state.bytes_until_sample -= size;
+    if (state.bytes_until_sample > 0) return;
+    state.bytes_until_sample = NextInterval(state, sampling_bytes);
+
+    // With exponential intervals an allocation of `size` bytes is sampled with
+    // probability 1 - exp(-size / sampling_bytes), each sample stands for the
+    // inverse of that.
+    double probability =
+        -std::expm1(-static_cast<double>(size) / sampling_bytes);
+    double weight = probability > 0 ? 1 / probability : 1;
+    Record(size, weight);
+  }
+
+  std::vector<AllocationSiteProfile> GetProfiles() {
+    std::vector<AllocationSiteProfile> profiles;
+    mutex_lock lock(mu_);
+    profiles.reserve(sites_.size());
+    for (const auto& entry : sites_) {
+      const Site& site = entry.second;
+      AllocationSiteProfile profile;
+      profile.site = std::string(entry.first());
+      profile.samples = site.samples;
+      profile.allocations = std::llround(site.allocations);
+      profile.bytes = std::llround(site.bytes);
+      profiles.push_back(std::move(profile));
+    }
+    std::sort(profiles.begin(), profiles.end(),
+              [](const auto& a, const auto& b) {
+                if (a.bytes != b.bytes) return a.bytes > b.bytes;
+                return a.site < b.site;
+              });
+    return profiles;
+  }
+
+ private:
+  struct ThreadState {
+    bool initialized = false;
+    int64_t bytes_until_sample = 0;
+    std::mt19937_64 rng;
+  };
+
+  struct Site {
+    int64_t samples = 0;
+    double allocations = 0;
+    double bytes = 0;
+  };
+
+  static int64_t NextInterval(ThreadState& state, int64_t sampling_bytes) {
+    std::exponential_distribution<double> interval(1.0 / sampling_bytes);
+    return static_cast<int64_t>(interval(state.rng)) + 1;
+  }
+
+  void Record(size_t size, double weight) {
+    std::string site = AllocationSiteScope::CurrentName();
+    if (site.empty() && stack_traces_.load(std::memory_order_relaxed)) {
+      llvm::raw_string_ostream os(site);
+      os << CreateStackTrace(/*skip_count=*/2);
+      os.flush();
+    }
+    if (site.empty()) site = "(unknown)";
+
+    mutex_lock lock(mu_);
+    Site& entry = sites_[site];
+    entry.samples += 1;
+    entry.allocations += weight;
+    entry.bytes += weight * size;
+  }
+
+  std::atomic<bool> enabled_{false};
+  std::atomic<int64_t> sampling_bytes_{1};
+  std::atomic<bool> stack_traces_{false};
+
+  mutex mu_;
+  llvm::StringMap<Site> sites_ TFRT_GUARDED_BY(mu_);
+};
+
 template <typename T>
 void AtomicUpdateMax(T const& value, std::atomic<T>* max_value) noexcept {
   T prev_max_value = *max_value;
@@ -52,6 +177,9 @@ class ProfiledAllocator : public HostAllocator {
   }
 
   void* AllocateBytes(size_t size, size_t alignment) override {
+    AllocationSampler& sampler = AllocationSampler::Get();
+    if (LLVM_UNLIKELY(sampler.IsEnabled())) sampler.MaybeSample(size);
+
     ++curr_num_allocations_;
     ++cum_num_allocations_;
     curr_num_bytes_allocated_.fetch_add(size);
@@ -82,6 +210,12 @@ class ProfiledAllocator : public HostAllocator {
            curr_num_bytes_allocated_.load());
     printf("Max number of bytes allocated = %" PRId64 "\n",
            max_num_bytes_allocated_.load());
+    if (AllocationSampler::Get().IsEnabled()) {
+      std::string profiles;
+      llvm::raw_string_ostream os(profiles);
+      PrintAllocationSiteProfiles(os);
+      printf("%s", os.str().c_str());
+    }
     fflush(stdout);
   }
 
@@ -125,4 +259,35 @@ std::unique_ptr<HostAllocator> CreateLeakCheckAllocator(
     std::unique_ptr<HostAllocator> allocator) {
   return std::make_unique<LeakCheckAllocator>(std::move(allocator));
 }
+
+void EnableAllocationSampling(const AllocationSamplingOptions& options) {
+  AllocationSampler::Get().Enable(options);
+}
+
+void DisableAllocationSampling() { AllocationSampler::Get().Disable(); }
+
+std::vector<AllocationSiteProfile> GetAllocationSiteProfiles() {
+  return AllocationSampler::Get().GetProfiles();
+}
+
+void PrintAllocationSiteProfiles(raw_ostream& os, int num_sites) {
+  std::vector<AllocationSiteProfile> profiles = GetAllocationSiteProfiles();
+  auto print = [&](const char* title) {
+    os << title << ":\n";
+    for (int i = 0; i < std::min<int>(num_sites, profiles.size()); ++i) {
+      const AllocationSiteProfile& profile = profiles[i];
+      os << llvm::format("%14" PRId64 " bytes %10" PRId64 " allocations  ",
+                         profile.bytes, profile.allocations)
+         << profile.site << "\n";
+    }
+  };
+
+  os << "Sampled allocation sites (estimated totals):\n";
+  print("Top allocation sites by bytes");
+  std::stable_sort(profiles.begin(), profiles.end(),
+                   [](const auto& a, const auto& b) {
+                     return a.allocations > b.allocations;
+                   });
+  print("Top allocation sites by count");
+}
 }  // namespace tfrt
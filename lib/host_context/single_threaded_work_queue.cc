@@ -38,11 +38,13 @@ class SingleThreadedWorkQueue : public ConcurrentWorkQueue {
   std::string name() const override { return "single-threaded"; }
 
   void AddTask(TaskFunction work) override;
+  void AddTasks(MutableArrayRef<TaskFunction> work) override;
   Optional<TaskFunction> AddBlockingTask(TaskFunction work,
                                          bool allow_queuing) override;
   void Quiesce() override;
   void Await(ArrayRef<RCReference<AsyncValue>> values) override;
   int GetParallelismLevel() const override { return 1; }
+  bool IsSingleThreaded() const override { return true; }
 
   // Given that this implementation does not spawn any threads to execute the
   // tasks it makes sense to always return `false`. However if the client uses
@@ -79,6 +81,13 @@ void SingleThreadedWorkQueue::AddTask(TaskFunction work) {
   cv_.notify_all();
 }
 
+// Enqueue a batch of work under a single lock.
+void SingleThreadedWorkQueue::AddTasks(MutableArrayRef<TaskFunction> work) {
+  mutex_lock l(mu_);
+  for (TaskFunction& task : work) work_items_.push_back(std::move(task));
+  cv_.notify_all();
+}
+
 // We put blocking tasks and non-blocking tasks in the same queue for
 // SingleThreadedWorkQueue. Note that this may cause deadlock when the blocking
 // task is used to model inter-kernel dependency, e.g. one kernel is blocked
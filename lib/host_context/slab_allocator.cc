@@ -0,0 +1,289 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements a thread-caching size-class slab allocator for small
+// host allocations.
+//
+// Small allocations are rounded up to a power-of-two size class and served
+// from slabs (large chunks carved into equal blocks) obtained from the
+// underlying allocator. Each thread keeps a short free list per size class, so
+// that most allocations and deallocations, including deallocations of blocks
+// allocated by another thread, do not take a lock. Free lists are moved in
+// batches between thread caches and the shared per-class free lists.
+//
+// Slabs are never returned to the underlying allocator before the slab
+// allocator itself is destroyed.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/MathExtras.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace {
+
+// Size classes are powers of two in the [kMinBlockSize, kMaxBlockSize] range.
+constexpr size_t kMinBlockSizeLog2 = 4;
+constexpr size_t kMaxBlockSizeLog2 = 9;
+constexpr size_t kMinBlockSize = size_t{1} << kMinBlockSizeLog2;
+constexpr size_t kMaxBlockSize = size_t{1} << kMaxBlockSizeLog2;
+constexpr int kNumSizeClasses = kMaxBlockSizeLog2 - kMinBlockSizeLog2 + 1;
+
+// Size of the chunk of memory that is carved into the blocks of one size
+// class. Chunks are aligned to kMaxBlockSize, so every block is naturally
+// aligned to its size.
+constexpr size_t kSlabSize = 64 * 1024;
+
+// Number of blocks moved between a thread cache and the shared free list.
+constexpr int kBatchSize = 32;
+
+// Maximum number of blocks kept in a thread cache for one size class.
+constexpr int kMaxCachedBlocks = 2 * kBatchSize;
+
+// Free blocks are linked through their first word.
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct FreeList {
+  FreeBlock* head = nullptr;
+  int size = 0;
+
+  void Push(FreeBlock* block) {
+    block->next = head;
+    head = block;
+    ++size;
+  }
+
+  FreeBlock* Pop() {
+    assert(head != nullptr);
+    FreeBlock* block = head;
+    head = block->next;
+    --size;
+    return block;
+  }
+};
+
+// Returns the size class index for an allocation of `size` bytes.
+int SizeClass(size_t size) {
+  size = std::max(size, kMinBlockSize);
+  return llvm::Log2_64_Ceil(size) - kMinBlockSizeLog2;
+}
+
+size_t BlockSize(int size_class) {
+  return kMinBlockSize << size_class;
+}
+
+// Per-thread free lists. A thread caches blocks only for the slab allocator
+// that it used most recently, identified by a unique id, so a destroyed
+// allocator can't be confused with a new allocator at the same address.
+struct ThreadCache {
+  uint64_t allocator_id = 0;
+  FreeList free_lists[kNumSizeClasses];
+};
+
+thread_local ThreadCache thread_cache;
+
+class SlabAllocator;
+
+// Live slab allocators keyed by id. Used to return the blocks in a thread
+// cache to their allocator when the thread switches to another allocator.
+struct SlabAllocatorRegistry {
+  mutex mu;
+  llvm::DenseMap<uint64_t, SlabAllocator*> allocators TFRT_GUARDED_BY(mu);
+
+  static SlabAllocatorRegistry& Get() {
+    static auto* registry = new SlabAllocatorRegistry();
+    return *registry;
+  }
+};
+
+class SlabAllocator : public HostAllocator {
+ public:
+  explicit SlabAllocator(std::unique_ptr<HostAllocator> allocator)
+      : id_(next_id_.fetch_add(1, std::memory_order_relaxed)),
+        allocator_(std::move(allocator)) {
+    auto& registry = SlabAllocatorRegistry::Get();
+    mutex_lock lock(registry.mu);
+    registry.allocators[id_] = this;
+  }
+
+  ~SlabAllocator() override {
+    // Blocks in the thread caches of other threads are dropped together with
+    // the slabs, the id of this allocator will never be reused.
+    {
+      auto& registry = SlabAllocatorRegistry::Get();
+      mutex_lock lock(registry.mu);
+      registry.allocators.erase(id_);
+    }
+
+    for (void* slab : slabs_) allocator_->DeallocateBytes(slab, kSlabSize);
+    for (auto& adopted : adopted_blocks_)
+      allocator_->DeallocateBytes(adopted.first, adopted.second);
+  }
+
+  // Allocate the specified number of bytes with the specified alignment.
+  void* AllocateBytes(size_t size, size_t alignment) override {
+    if (size > kMaxBlockSize) return allocator_->AllocateBytes(size, alignment);
+
+    // Over-aligned small allocations are rare. Allocate them from the
+    // underlying allocator with the size of the size class, so that the block
+    // can be safely reused by the size class once it is deallocated.
+    if (alignment > kMaxBlockSize) {
+      size_t block_size = BlockSize(SizeClass(size));
+      void* block = allocator_->AllocateBytes(block_size, alignment);
+      mutex_lock lock(slabs_mu_);
+      adopted_blocks_.emplace_back(block, block_size);
+      return block;
+    }
+
+    // Blocks are aligned to their size, so picking the size class by alignment
+    // guarantees the requested alignment. Such a block is later deallocated
+    // into the size class of `size`, which is also valid because it is larger
+    // and more aligned than the blocks of that size class.
+    int size_class = SizeClass(std::max(size, alignment));
+    FreeList& free_list = GetThreadCache().free_lists[size_class];
+    if (free_list.head == nullptr) Refill(size_class, &free_list);
+    return free_list.Pop();
+  }
+
+  // Deallocate the specified pointer that has the specified size.
+  void DeallocateBytes(void* ptr, size_t size) override {
+    if (size > kMaxBlockSize) return allocator_->DeallocateBytes(ptr, size);
+
+    int size_class = SizeClass(size);
+    FreeList& free_list = GetThreadCache().free_lists[size_class];
+    free_list.Push(static_cast<FreeBlock*>(ptr));
+    if (free_list.size > kMaxCachedBlocks) Flush(size_class, &free_list);
+  }
+
+ private:
+  struct SharedFreeList {
+    mutex mu;
+    FreeList free_list TFRT_GUARDED_BY(mu);
+  };
+
+  // Returns the calling thread cache, taking it over from another allocator if
+  // needed.
+  ThreadCache& GetThreadCache() {
+    ThreadCache& cache = thread_cache;
+    if (LLVM_UNLIKELY(cache.allocator_id != id_)) TakeOver(&cache);
+    return cache;
+  }
+
+  // Returns the blocks in `cache` to the allocator that owns them, unless it
+  // was already destroyed together with its slabs, and resets `cache` for this
+  // allocator.
+  LLVM_ATTRIBUTE_NOINLINE void TakeOver(ThreadCache* cache) {
+    if (cache->allocator_id != 0) {
+      auto& registry = SlabAllocatorRegistry::Get();
+      mutex_lock lock(registry.mu);
+      auto it = registry.allocators.find(cache->allocator_id);
+      if (it != registry.allocators.end()) {
+        for (int i = 0; i < kNumSizeClasses; ++i)
+          it->second->FlushAll(i, &cache->free_lists[i]);
+      }
+    }
+    *cache = ThreadCache();
+    cache->allocator_id = id_;
+  }
+
+  // Moves a batch of blocks from the shared free list into `free_list`,
+  // allocating a new slab if the shared free list is empty.
+  LLVM_ATTRIBUTE_NOINLINE void Refill(int size_class, FreeList* free_list) {
+    SharedFreeList& shared = shared_free_lists_[size_class];
+    {
+      mutex_lock lock(shared.mu);
+      while (shared.free_list.head != nullptr && free_list->size < kBatchSize)
+        free_list->Push(shared.free_list.Pop());
+    }
+    if (free_list->head != nullptr) return;
+
+    auto* slab = static_cast<char*>(
+        allocator_->AllocateBytes(kSlabSize, kMaxBlockSize));
+    {
+      mutex_lock lock(slabs_mu_);
+      slabs_.push_back(slab);
+    }
+
+    // Carve the slab in reverse order, so that blocks are handed out in the
+    // increasing address order. The first batch goes to the thread cache, and
+    // the rest of the slab to the shared free list.
+    size_t block_size = BlockSize(size_class);
+    size_t num_blocks = kSlabSize / block_size;
+    auto block = [&](size_t index) {
+      return reinterpret_cast<FreeBlock*>(slab + index * block_size);
+    };
+
+    size_t num_cached = std::min<size_t>(num_blocks, kBatchSize);
+    if (num_blocks > num_cached) {
+      mutex_lock lock(shared.mu);
+      for (size_t i = num_blocks; i > num_cached; --i)
+        shared.free_list.Push(block(i - 1));
+    }
+    for (size_t i = num_cached; i > 0; --i) free_list->Push(block(i - 1));
+  }
+
+  // Moves a batch of blocks from `free_list` to the shared free list.
+  LLVM_ATTRIBUTE_NOINLINE void Flush(int size_class, FreeList* free_list) {
+    SharedFreeList& shared = shared_free_lists_[size_class];
+    mutex_lock lock(shared.mu);
+    for (int i = 0; i < kBatchSize; ++i)
+      shared.free_list.Push(free_list->Pop());
+  }
+
+  // Moves all blocks from `free_list` to the shared free list.
+  void FlushAll(int size_class, FreeList* free_list) {
+    SharedFreeList& shared = shared_free_lists_[size_class];
+    mutex_lock lock(shared.mu);
+    while (free_list->head != nullptr) shared.free_list.Push(free_list->Pop());
+  }
+
+  static std::atomic<uint64_t> next_id_;
+
+  const uint64_t id_;
+  std::unique_ptr<HostAllocator> allocator_;
+
+  SharedFreeList shared_free_lists_[kNumSizeClasses];
+
+  mutex slabs_mu_;
+  std::vector<void*> slabs_ TFRT_GUARDED_BY(slabs_mu_);
+
+  // Over-aligned blocks allocated from the underlying allocator and their
+  // sizes. After deallocation they are reused as regular blocks, and released
+  // to the underlying allocator together with the slabs.
+  std::vector<std::pair<void*, size_t>> adopted_blocks_
+      TFRT_GUARDED_BY(slabs_mu_);
+};
+
+std::atomic<uint64_t> SlabAllocator::next_id_{1};
+
+}  // namespace
+
+std::unique_ptr<HostAllocator> CreateSlabAllocator(
+    std::unique_ptr<HostAllocator> allocator) {
+  return std::make_unique<SlabAllocator>(std::move(allocator));
+}
+
+}  // namespace tfrt
@@ -16,7 +16,11 @@
 #include <cstddef>
 #include <string>
 #include <thread>
+#include <vector>
 
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "tfrt/host_context/concurrent_work_queue.h"
 #include "tfrt/support/logging.h"
 
@@ -39,58 +43,132 @@ std::unique_ptr<ConcurrentWorkQueue> SingleThreadedWorkQueueFactory(
 }
 
 struct MakeMultiThreadedWorkQueue {
-  static std::unique_ptr<ConcurrentWorkQueue> make(int num_nonblocking_threads,
-                                                   int num_blocking_threads) {
+  static std::unique_ptr<ConcurrentWorkQueue> make(
+      int num_nonblocking_threads, int num_blocking_threads,
+      SpinWaitMode spin_wait_mode) {
     return CreateMultiThreadedWorkQueue(num_nonblocking_threads,
-                                        num_blocking_threads);
+                                        num_blocking_threads, spin_wait_mode);
   }
 };
 
+struct MakeNumaWorkQueue {
+  static std::unique_ptr<ConcurrentWorkQueue> make(
+      int num_nonblocking_threads, int num_blocking_threads,
+      SpinWaitMode spin_wait_mode) {
+    return CreateNumaWorkQueue(num_nonblocking_threads, num_blocking_threads,
+                               spin_wait_mode);
+  }
+};
+
+llvm::Optional<SpinWaitMode> ParseSpinWaitMode(llvm::StringRef mode) {
+  if (mode == "fixed") return SpinWaitMode::kFixed;
+  if (mode == "adaptive") return SpinWaitMode::kAdaptive;
+  if (mode == "low_power") return SpinWaitMode::kLowPower;
+  return llvm::None;
+}
+
 // Factory function for a multi-threaded thread pool.  Parses the given argument
-// to determine the construction parameters.  The argument must be either "X" or
-// "X,Y", where X and Y are integers. X will determine the number of threads to
-// use for blocking work, and Y will determine the number of threads for
-// nonblocking work. If X is not specified, the pool will use a number of
-// threads based on the number of CPUs in the system. Y is not specified, a
-// `kDefaultNumBlockingThreads` of threads will be used for blocking work.
+// to determine the construction parameters.  The argument must be either empty,
+// "X", "X,Y" or "X,Y,MODE", where X and Y are integers. X will determine the
+// number of threads to use for nonblocking work, and Y will determine the
+// number of threads for blocking work. If X is not specified, the pool will use
+// a number of threads based on the number of CPUs in the system. If Y is not
+// specified, a `kDefaultNumBlockingThreads` of threads will be used for
+// blocking work. MODE is the spin wait mode of the nonblocking threads, one of
+// "fixed" (default), "adaptive" or "low_power".
 template <typename MakeWorkQueue>
 std::unique_ptr<ConcurrentWorkQueue> MultiThreadedWorkQueueFactory(
     string_view arg) {
-  if (arg.empty()) {
-    int num_nonblocking = std::thread::hardware_concurrency();
-    int num_blocking = kDefaultNumBlockingThreads;
-    return MakeWorkQueue::make(num_nonblocking, num_blocking);
-  } else {
-    size_t comma = arg.find(',');
-    int num_threads;
-    int num_blocking = kDefaultNumBlockingThreads;
-    if (comma == std::string::npos) {
-      size_t pos;
-      num_threads = std::stoi(std::string(arg), &pos);
-      if (pos != arg.size()) {
-        TFRT_LOG(ERROR) << "Invalid argument for mstd work queue: "
-                        << std::string(arg);
-        return nullptr;
-      }
+  int num_threads = std::thread::hardware_concurrency();
+  int num_blocking = kDefaultNumBlockingThreads;
+  SpinWaitMode spin_wait_mode = SpinWaitMode::kFixed;
+
+  if (!arg.empty()) {
+    llvm::SmallVector<llvm::StringRef, 3> args;
+    llvm::StringRef(arg.data(), arg.size()).split(args, ',');
+
+    llvm::Optional<SpinWaitMode> mode = spin_wait_mode;
+    if (args.size() > 2) mode = ParseSpinWaitMode(args[2]);
+
+    if (args.size() > 3 || args[0].getAsInteger(10, num_threads) ||
+        (args.size() > 1 && args[1].getAsInteger(10, num_blocking)) ||
+        !mode.has_value()) {
+      TFRT_LOG(ERROR) << "Invalid argument for mstd work queue: "
+                      << std::string(arg);
+      return nullptr;
+    }
+    spin_wait_mode = *mode;
+  }
+
+  return MakeWorkQueue::make(num_threads, num_blocking, spin_wait_mode);
+}
+
+// Parses a CPU list like "0-3,8,10-11" into `cpus`. Returns false if the list
+// is invalid.
+bool ParseCpuList(llvm::StringRef list, std::vector<int>* cpus) {
+  llvm::SmallVector<llvm::StringRef, 4> ranges;
+  list.split(ranges, ',');
+  for (llvm::StringRef range : ranges) {
+    auto bounds = range.split('-');
+    int first, last;
+    if (bounds.first.getAsInteger(10, first)) return false;
+    last = first;
+    if (!bounds.second.empty() && bounds.second.getAsInteger(10, last))
+      return false;
+    if (first < 0 || last < first) return false;
+    for (int cpu = first; cpu <= last; ++cpu) cpus->push_back(cpu);
+  }
+  return !cpus->empty();
+}
+
+// Factory function for a tenant thread pool, see CreateTenantWorkQueue(). The
+// argument is a list of "KEY=VALUE" options separated by semicolons, e.g.
+// "cpus=0-3,8-11;share=serving". The options are:
+//   threads: the number of threads for nonblocking work, one per CPU by
+//     default.
+//   blocking: the number of threads for blocking work,
+//     `kDefaultNumBlockingThreads` by default.
+//   spin: the spin wait mode of the nonblocking threads, see
+//     MultiThreadedWorkQueueFactory.
+//   cpus: the CPUs to pin the nonblocking threads to, a comma separated list
+//     of CPUs and ranges of CPUs. Not pinned by default.
+//   share: the share group of the pool. Not shared by default.
+std::unique_ptr<ConcurrentWorkQueue> TenantWorkQueueFactory(string_view arg) {
+  TenantWorkQueueOptions options;
+  options.num_blocking_threads = kDefaultNumBlockingThreads;
+
+  llvm::SmallVector<llvm::StringRef, 4> args;
+  llvm::StringRef(arg.data(), arg.size())
+      .split(args, ';', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (llvm::StringRef option : args) {
+    auto key_value = option.split('=');
+    llvm::StringRef key = key_value.first, value = key_value.second;
+    bool valid = !value.empty();
+    if (key == "threads") {
+      valid = valid && !value.getAsInteger(10, options.num_threads) &&
+              options.num_threads > 0;
+    } else if (key == "blocking") {
+      valid = valid && !value.getAsInteger(10, options.num_blocking_threads) &&
+              options.num_blocking_threads > 0;
+    } else if (key == "spin") {
+      llvm::Optional<SpinWaitMode> mode = ParseSpinWaitMode(value);
+      valid = valid && mode.has_value();
+      if (valid) options.spin_wait_mode = *mode;
+    } else if (key == "cpus") {
+      valid = valid && ParseCpuList(value, &options.cpus);
+    } else if (key == "share") {
+      options.share_group = value.str();
     } else {
-      size_t pos;
-      num_threads =
-          std::stoi(std::string(arg.data(), arg.data() + comma), &pos);
-      if (pos != comma) {
-        TFRT_LOG(ERROR) << "Invalid argument for mstd work queue: "
-                        << std::string(arg);
-        return nullptr;
-      }
-      num_blocking = std::stoi(
-          std::string(arg.data() + comma + 1, arg.data() + arg.size()), &pos);
-      if (pos != arg.size() - comma - 1) {
-        TFRT_LOG(ERROR) << "Invalid argument for mstd work queue: "
-                        << std::string(arg);
-        return nullptr;
-      }
+      valid = false;
+    }
+    if (!valid) {
+      TFRT_LOG(ERROR) << "Invalid argument for tenant work queue: "
+                      << std::string(arg);
+      return nullptr;
     }
-    return MakeWorkQueue::make(num_threads, num_blocking);
   }
+
+  return CreateTenantWorkQueue(options);
 }
 
 }  // namespace
@@ -98,5 +176,8 @@ std::unique_ptr<ConcurrentWorkQueue> MultiThreadedWorkQueueFactory(
 TFRT_WORK_QUEUE_FACTORY("s", SingleThreadedWorkQueueFactory);
 TFRT_WORK_QUEUE_FACTORY(
     "mstd", MultiThreadedWorkQueueFactory<MakeMultiThreadedWorkQueue>);
+TFRT_WORK_QUEUE_FACTORY("numa",
+                        MultiThreadedWorkQueueFactory<MakeNumaWorkQueue>);
+TFRT_WORK_QUEUE_FACTORY("tenant", TenantWorkQueueFactory);
 
 }  // namespace tfrt
@@ -18,77 +18,212 @@
 
 #include "tfrt/host_context/timer_queue.h"
 
+#include <algorithm>
+#include <functional>
+
+#include "llvm/Support/MathExtras.h"
+
 namespace tfrt {
 
-TimerQueue::TimerQueue() {
+namespace {
+
+// Returns the distance from the slot `index` to the next occupied slot (in the
+// next rotation of the wheel if it is the `index` slot itself). Occupied mask
+// must not be empty.
+int NextOccupiedSlot(uint64_t occupied, int index) {
+  assert(occupied != 0);
+  const int shift = (index + 1) & 63;
+  const uint64_t rotated =
+      shift == 0 ? occupied : (occupied >> shift) | (occupied << (64 - shift));
+  return llvm::countTrailingZeros(rotated) + 1;
+}
+
+// Returns the index of the insertion shard for the calling thread.
+int ShardIndex(int num_shards) {
+  static thread_local const size_t hash =
+      std::hash<std::thread::id>()(std::this_thread::get_id());
+  return hash % num_shards;
+}
+
+}  // namespace
+
+TimerQueue::TimerQueue() : current_tick_(NowTick()) {
   // Start the timer thread.
   // TODO(tfrt-devs): use alternative to std::thread in google-internal build.
   timer_thread_ = std::thread([this]() { TimerThreadRun(); });
 }
 
 TimerQueue::~TimerQueue() {
-  mu_.lock();
-  // Cancel every timer in the queue.
-  while (!timers_.empty()) {
-    timers_.pop();
+  {
+    mutex_lock lock(mu_);
+    stop_ = true;
+    // Notify the timer thread we are done.
+    cv_.notify_one();
   }
-  stop_.store(true, std::memory_order_release);
-  // Notify the timer thread we are done cleaning up.
-  cv_.notify_one();
-  mu_.unlock();
   assert(timer_thread_.joinable());
   timer_thread_.join();
+  // Timers left in the shards and in the timing wheel are cancelled when
+  // destroyed together with the queue.
+}
+
+int64_t TimerQueue::DeadlineTick(TimePoint deadline) {
+  // Round up, so that timers never expire before their deadline.
+  const int64_t nanos = deadline.time_since_epoch().count();
+  const int64_t tick_nanos = kTickDuration.count();
+  return nanos / tick_nanos + (nanos % tick_nanos > 0 ? 1 : 0);
+}
+
+int64_t TimerQueue::NowTick() {
+  TimePoint now = Clock::now();
+  return now.time_since_epoch().count() / kTickDuration.count();
 }
 
 void TimerQueue::TimerThreadRun() {
-  mutex_lock lock(mu_);
-  while (!stop_.load(std::memory_order_acquire)) {
-    const TimerEntry* top_entry = getTopTimer();
-    if (!top_entry) {
-      cv_.wait(lock);
-    } else {
-      // Wait till the timer expires.
-      cv_.wait_until(lock, top_entry->deadline_);
+  while (true) {
+    DrainShards();
+    AdvanceTo(NowTick());
+
+    // Run callbacks of the expired timers, unless they were cancelled.
+    for (RCReference<TimerEntry>& timer : expired_) {
+      auto pending = TimerEntry::State::kPending;
+      if (timer->state_.compare_exchange_strong(pending,
+                                                TimerEntry::State::kExpired)) {
+        timer->timer_callback_();
+        timer->timer_callback_ = nullptr;
+      }
     }
-    while (!timers_.empty() && timers_.top()->deadline_ <= Clock::now()) {
-      const auto top_entry = timers_.top();
-      timers_.pop();
-      mu_.unlock();
-      // If timer is not cancelled, run the callback.
-      if (!top_entry->cancelled_) {
-        top_entry->timer_callback_();
+    const bool has_expired = !expired_.empty();
+    expired_.clear();
+    // Callbacks might take time, check for newly expired timers.
+    if (has_expired) continue;
+
+    mutex_lock lock(mu_);
+    if (stop_) return;
+
+    // Publish the wake up time before checking the insertion shards, so that
+    // concurrent ScheduleTimerAt() either observes it and notifies the timer
+    // thread, or its timer is observed here.
+    const int64_t wakeup_tick = NextEventTick();
+    next_wakeup_tick_.store(wakeup_tick);
+    if (num_pending_.load() == 0) {
+      if (wakeup_tick == kNever) {
+        cv_.wait(lock);
+      } else {
+        cv_.wait_until(lock, TimePoint(wakeup_tick * kTickDuration));
       }
-      mu_.lock();
     }
+    next_wakeup_tick_.store(kAwake);
+    if (stop_) return;
+  }
+}
+
+void TimerQueue::DrainShards() {
+  std::vector<RCReference<TimerEntry>> timers;
+  for (Shard& shard : shards_) {
+    {
+      mutex_lock lock(shard.mu);
+      if (shard.timers.empty()) continue;
+      std::swap(timers, shard.timers);
+    }
+    num_pending_.fetch_sub(timers.size());
+    for (RCReference<TimerEntry>& timer : timers) AddToWheel(std::move(timer));
+    timers.clear();
+  }
+}
+
+void TimerQueue::AddToWheel(RCReference<TimerEntry> timer) {
+  // Cancelled timers are dropped as soon as they are seen by the timer thread.
+  if (timer->state_.load(std::memory_order_relaxed) !=
+      TimerEntry::State::kPending)
+    return;
+
+  const int64_t tick = DeadlineTick(timer->deadline_);
+  const int64_t delta = tick - current_tick_;
+  if (delta <= 0) {
+    expired_.push_back(std::move(timer));
+    return;
+  }
+
+  // Find the lowest level that covers the deadline. Timers that are beyond the
+  // range of the wheel are put into the last visited slot of the highest
+  // level, and are re-inserted when that slot is visited.
+  int level = 0;
+  while (level < kNumLevels - 1 &&
+         delta >= (int64_t{1} << (kSlotsLog2 * (level + 1))))
+    ++level;
+
+  int slot;
+  if (delta >= (int64_t{1} << (kSlotsLog2 * kNumLevels))) {
+    slot = ((current_tick_ >> (kSlotsLog2 * level)) - 1) & (kNumSlots - 1);
+  } else {
+    slot = (tick >> (kSlotsLog2 * level)) & (kNumSlots - 1);
   }
+
+  levels_[level].slots[slot].push_back(std::move(timer));
+  levels_[level].occupied |= uint64_t{1} << slot;
 }
 
-TimerQueue::TimerEntry* TimerQueue::getTopTimer() TFRT_REQUIRES(mu_) {
-  while (!timers_.empty()) {
-    if (timers_.top()->cancelled_) {
-      // Timer is cancelled, discard.
-      timers_.pop();
-    } else {
-      return timers_.top().get();
+int64_t TimerQueue::NextEventTick() const {
+  int64_t next = kNever;
+  for (int level = 0; level < kNumLevels; ++level) {
+    if (levels_[level].occupied == 0) continue;
+    // The slot at level `L` is visited at the first tick of its 64^L range.
+    const int shift = kSlotsLog2 * level;
+    const int64_t block = current_tick_ >> shift;
+    const int distance = NextOccupiedSlot(levels_[level].occupied,
+                                          block & (kNumSlots - 1));
+    next = std::min(next, (block + distance) << shift);
+  }
+  return next;
+}
+
+void TimerQueue::AdvanceTo(int64_t now_tick) {
+  while (current_tick_ < now_tick) {
+    const int64_t next = NextEventTick();
+    if (next > now_tick) {
+      current_tick_ = now_tick;
+      return;
+    }
+    current_tick_ = next;
+
+    // Move timers from the higher levels slots that start at this tick to the
+    // lower levels.
+    for (int level = 1; level < kNumLevels; ++level) {
+      const int shift = kSlotsLog2 * level;
+      if (next & ((int64_t{1} << shift) - 1)) break;
+      const int slot = (next >> shift) & (kNumSlots - 1);
+      std::vector<RCReference<TimerEntry>> timers;
+      std::swap(timers, levels_[level].slots[slot]);
+      levels_[level].occupied &= ~(uint64_t{1} << slot);
+      for (RCReference<TimerEntry>& timer : timers)
+        AddToWheel(std::move(timer));
     }
+
+    // Expire timers in the lowest level slot.
+    const int slot = next & (kNumSlots - 1);
+    for (RCReference<TimerEntry>& timer : levels_[0].slots[slot])
+      expired_.push_back(std::move(timer));
+    levels_[0].slots[slot].clear();
+    levels_[0].occupied &= ~(uint64_t{1} << slot);
   }
-  // No active timer found. Return a nullptr.
-  return nullptr;
 }
 
 TimerQueue::TimerHandle TimerQueue::ScheduleTimerAt(TimePoint deadline,
                                                     TimerCallback callback) {
   TimerHandle th = TimerEntry::Create(deadline, std::move(callback));
-  bool notify = false;
   {
+    Shard& shard = shards_[ShardIndex(kNumShards)];
+    mutex_lock lock(shard.mu);
+    shard.timers.push_back(th);
+  }
+  num_pending_.fetch_add(1);
+
+  // Only notify the timer thread if it waits, and the new timer's deadline is
+  // earlier than its wake up time.
+  if (DeadlineTick(deadline) < next_wakeup_tick_.load()) {
     mutex_lock lock(mu_);
-    // Only notify timer thread when the queue is empty, or when the newly added
-    // timer's deadline is shorter.
-    notify = timers_.empty() || timers_.top()->deadline_ > deadline;
-    timers_.push(th);
+    cv_.notify_one();
   }
-  // Notify the timer thread that a new timer is added.
-  if (notify) cv_.notify_one();
   return th;
 }
 
@@ -102,7 +237,13 @@ void TimerQueue::CancelTimer(const TimerQueue::TimerHandle& timer_handle) {
   // TODO(tfrt-dev): make the semantic of CancelTimer() so that if the timer
   // callback has started execution, the CancelTimer() will block until
   // the execution finishes.
-  timer_handle->cancelled_.store(true, std::memory_order_release);
+  auto pending = TimerEntry::State::kPending;
+  if (timer_handle->state_.compare_exchange_strong(
+          pending, TimerEntry::State::kCancelled)) {
+    // Release resources captured by the callback without waiting for the
+    // timer thread to drop the cancelled timer.
+    timer_handle->timer_callback_ = nullptr;
+  }
 }
 
 }  // namespace tfrt
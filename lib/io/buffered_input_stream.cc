@@ -16,11 +16,176 @@
 
 #include "tfrt/io/buffered_input_stream.h"
 
+#include <vector>
+
+#include "llvm/ADT/Optional.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+
 namespace tfrt {
 namespace io {
 
+// A ring of blocks which are read from the underlying stream in order. The
+// reads run on the blocking work queue and hold a reference to the ring, so
+// that the BufferedInputStream does not wait for them on destruction.
+class BufferedInputStream::ReadAhead
+    : public std::enable_shared_from_this<ReadAhead> {
+ public:
+  ReadAhead(std::unique_ptr<InputStream> input_stream,
+            const ReadAheadOptions& options, HostContext* host)
+      : input_stream_(std::move(input_stream)),
+        block_size_(options.block_size),
+        host_(host),
+        blocks_(options.depth) {
+    assert(block_size_ > 0);
+    assert(!blocks_.empty());
+    for (auto& block : blocks_)
+      block.data = host_->allocator()->Allocate<char>(block_size_);
+  }
+
+  ~ReadAhead() {
+    for (auto& block : blocks_) {
+      if (block.limit && !*block.limit)
+        consumeError(block.limit->takeError());
+      host_->allocator()->Deallocate(block.data, block_size_);
+    }
+  }
+
+  // Releases the block being consumed and returns the next one, waiting until
+  // it is read. Returns an empty block at the end of the stream.
+  llvm::Expected<string_view> NextBlock();
+
+  // Stops reading ahead. Reads in flight are completed and dropped.
+  void Cancel() {
+    mutex_lock lock(mu_);
+    cancelled_ = true;
+  }
+
+ private:
+  enum class FillState { kIdle, kQueued, kRunning };
+
+  struct Block {
+    char* data = nullptr;
+    // The number of valid bytes in `data`, or the error of the read. Set when
+    // the block is ready.
+    llvm::Optional<llvm::Expected<size_t>> limit;
+  };
+
+  // Enqueues the read of the next block if there is a free one.
+  void ScheduleFill() TFRT_REQUIRES(mu_);
+  // Reads the next block into `block`, whose fill state is kRunning.
+  void Fill(Block* block) TFRT_EXCLUDES(mu_);
+
+  std::unique_ptr<InputStream> input_stream_;
+  const size_t block_size_;
+  HostContext* const host_;
+
+  mutex mu_;
+  condition_variable cv_;
+  std::vector<Block> blocks_ TFRT_GUARDED_BY(mu_);
+  // The index of the block being consumed, or to be consumed next.
+  size_t consume_index_ TFRT_GUARDED_BY(mu_) = 0;
+  // The index of the next block to read.
+  size_t fill_index_ TFRT_GUARDED_BY(mu_) = 0;
+  // The number of blocks read and not yet released by the consumer.
+  size_t num_ready_ TFRT_GUARDED_BY(mu_) = 0;
+  bool consuming_ TFRT_GUARDED_BY(mu_) = false;
+  FillState fill_state_ TFRT_GUARDED_BY(mu_) = FillState::kIdle;
+  // Set when a read returns an error or reaches the end of the stream.
+  bool done_ TFRT_GUARDED_BY(mu_) = false;
+  bool cancelled_ TFRT_GUARDED_BY(mu_) = false;
+};
+
+void BufferedInputStream::ReadAhead::ScheduleFill() {
+  if (fill_state_ != FillState::kIdle || done_ || cancelled_ ||
+      num_ready_ == blocks_.size())
+    return;
+  fill_state_ = FillState::kQueued;
+  bool enqueued = EnqueueBlockingWork(host_, [self = shared_from_this()] {
+    Block* block;
+    {
+      mutex_lock lock(self->mu_);
+      // The consumer may have taken over the read.
+      if (self->fill_state_ != FillState::kQueued || self->cancelled_) return;
+      self->fill_state_ = FillState::kRunning;
+      block = &self->blocks_[self->fill_index_];
+    }
+    self->Fill(block);
+  });
+  // The consumer reads the block itself when it needs it.
+  if (!enqueued) fill_state_ = FillState::kIdle;
+}
+
+void BufferedInputStream::ReadAhead::Fill(Block* block) {
+  // Only one read runs at a time, and the consumer does not access the block
+  // until it is ready.
+  auto limit = input_stream_->Read(block->data, block_size_);
+
+  mutex_lock lock(mu_);
+  if (!limit || *limit < block_size_) done_ = true;
+  block->limit.emplace(std::move(limit));
+  fill_index_ = (fill_index_ + 1) % blocks_.size();
+  ++num_ready_;
+  fill_state_ = FillState::kIdle;
+  cv_.notify_all();
+  ScheduleFill();
+}
+
+llvm::Expected<string_view> BufferedInputStream::ReadAhead::NextBlock() {
+  for (;;) {
+    Block* block;
+    {
+      mutex_lock lock(mu_);
+      if (consuming_) {
+        blocks_[consume_index_].limit.reset();
+        consume_index_ = (consume_index_ + 1) % blocks_.size();
+        --num_ready_;
+        consuming_ = false;
+      }
+      ScheduleFill();
+
+      Block& next = blocks_[consume_index_];
+      cv_.wait(lock, [&]() TFRT_REQUIRES(mu_) {
+        return next.limit || fill_state_ != FillState::kRunning;
+      });
+      if (next.limit) {
+        consuming_ = true;
+        if (!*next.limit) {
+          // Retry from the underlying stream on the next call, as reads
+          // without read-ahead do.
+          done_ = false;
+          return next.limit->takeError();
+        }
+        return string_view(next.data, **next.limit);
+      }
+      if (done_) return string_view();
+
+      // Read the block on this thread instead of waiting for the queue.
+      fill_state_ = FillState::kRunning;
+      block = &blocks_[fill_index_];
+    }
+    Fill(block);
+  }
+}
+
+BufferedInputStream::BufferedInputStream(
+    std::unique_ptr<InputStream> input_stream, const ReadAheadOptions& options,
+    HostContext* host)
+    : allocator_(host->allocator()),
+      read_ahead_(std::make_shared<ReadAhead>(std::move(input_stream), options,
+                                              host)) {}
+
+BufferedInputStream::~BufferedInputStream() {
+  // Drop the error of the last read if it was not returned.
+  if (!buffer_limit_) consumeError(buffer_limit_.takeError());
+  if (read_ahead_) read_ahead_->Cancel();
+  if (buffer_) allocator_->Deallocate(buffer_, buffer_size_);
+}
+
 llvm::Expected<size_t> BufferedInputStream::Read(char* buf, size_t max_count) {
   if (max_count < 0) return MakeStringError("max_count should not be negative");
+  if (read_ahead_) return ReadFromBlocks(buf, max_count);
 
   if (!buffer_limit_) {
     auto error = buffer_limit_.takeError();
@@ -50,6 +215,25 @@ llvm::Expected<size_t> BufferedInputStream::Read(char* buf, size_t max_count) {
   return actual_count;
 }
 
+llvm::Expected<size_t> BufferedInputStream::ReadFromBlocks(char* buf,
+                                                           size_t max_count) {
+  size_t actual_count = 0;
+  while (actual_count < max_count) {
+    if (block_.empty()) {
+      auto block = read_ahead_->NextBlock();
+      if (!block) return block.takeError();
+      block_ = *block;
+      if (block_.empty()) break;
+    }
+    size_t read_cnt = std::min(block_.size(), max_count - actual_count);
+    std::memcpy(buf + actual_count, block_.data(), read_cnt);
+    block_ = block_.drop_front(read_cnt);
+    actual_count += read_cnt;
+  }
+  stream_pos_ += actual_count;
+  return actual_count;
+}
+
 llvm::Expected<size_t> BufferedInputStream::Tell() { return stream_pos_; }
 
 }  // namespace io
@@ -14,13 +14,33 @@
  * limitations under the License.
  */
 
-// This file implements the FileSystemRegistry class.
+// This file implements the FileSystemRegistry class and the default
+// RandomAccessFile::ReadAsync().
 
 #include "tfrt/io/file_system.h"
 
+#include "tfrt/host_context/async_dispatch.h"
+
 namespace tfrt {
 namespace io {
 
+AsyncValueRef<size_t> RandomAccessFile::ReadAsync(char* buf, size_t max_count,
+                                                  size_t offset,
+                                                  HostContext* host) const {
+  auto result = MakeUnconstructedAsyncValueRef<size_t>();
+  auto read = [this, buf, max_count, offset, result = result.CopyRef()]() {
+    auto count = Read(buf, max_count, offset);
+    if (!count) {
+      result.SetError(absl::InternalError(toString(count.takeError())));
+      return;
+    }
+    result.emplace(*count);
+  };
+  // Read() blocks, so it should not run on the non-blocking work queue.
+  if (!EnqueueBlockingWork(host, read)) read();
+  return result;
+}
+
 void FileSystemRegistry::Register(const std::string& scheme,
                                   std::unique_ptr<FileSystem> file_system) {
   assert(file_system);
@@ -36,5 +56,10 @@ FileSystem* FileSystemRegistry::Lookup(const std::string& scheme) {
   return file_systems_[scheme].get();
 }
 
+FileSystem* FileSystemRegistry::LookupForPath(const std::string& path) {
+  auto pos = path.find("://");
+  return Lookup(pos == std::string::npos ? "" : path.substr(0, pos));
+}
+
 }  // namespace io
 }  // namespace tfrt
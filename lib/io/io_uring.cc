@@ -0,0 +1,249 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the IoUring class.
+
+#include "io_uring.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define TFRT_HAS_IO_URING 1
+#endif
+#endif
+
+#ifdef TFRT_HAS_IO_URING
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/string_util.h"
+#endif
+
+namespace tfrt {
+namespace io {
+
+#ifndef TFRT_HAS_IO_URING
+
+IoUring* IoUring::Get() { return nullptr; }
+
+AsyncValueRef<size_t> IoUring::Read(int fd, char* buf, size_t max_count,
+                                    size_t offset) {
+  return {};
+}
+
+#else
+
+namespace {
+
+// The number of submission queue entries. The kernel sizes the completion
+// queue to twice this number.
+constexpr unsigned kNumEntries = 256;
+
+}  // namespace
+
+struct IoUring::Ring {
+  int fd;
+  // Submission queue.
+  unsigned* sq_tail;
+  unsigned sq_mask;
+  unsigned* sq_array;
+  io_uring_sqe* sqes;
+  // Completion queue.
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned cq_mask;
+  io_uring_cqe* cqes;
+  unsigned cq_entries;
+
+  // Serializes submissions.
+  mutex mu;
+  // The number of submitted reads without completion. It is bounded by
+  // cq_entries so that the completion queue never overflows.
+  std::atomic<unsigned> num_in_flight{0};
+};
+
+struct IoUring::ReadRequest {
+  int fd;
+  char* buf;
+  size_t max_count;
+  size_t offset;
+  // The number of bytes read so far.
+  size_t count = 0;
+  // Points into buf, past the bytes read so far.
+  iovec iov;
+  AsyncValueRef<size_t> result;
+};
+
+IoUring* IoUring::Get() {
+  static IoUring* io_uring = []() -> IoUring* {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = syscall(__NR_io_uring_setup, kNumEntries, &params);
+    if (fd < 0) return nullptr;
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) sq_size = cq_size = std::max(sq_size, cq_size);
+
+    void* sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    void* cq_ptr = single_mmap ? sq_ptr
+                               : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_POPULATE, fd,
+                                      IORING_OFF_CQ_RING);
+    void* sqes = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe),
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                      IORING_OFF_SQES);
+    if (sq_ptr == MAP_FAILED || cq_ptr == MAP_FAILED || sqes == MAP_FAILED) {
+      close(fd);
+      return nullptr;
+    }
+
+    auto* sq = static_cast<char*>(sq_ptr);
+    auto* cq = static_cast<char*>(cq_ptr);
+    auto* ring = new Ring;
+    ring->fd = fd;
+    ring->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    ring->sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    ring->sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    ring->sqes = static_cast<io_uring_sqe*>(sqes);
+    ring->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    ring->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    ring->cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    ring->cq_entries = params.cq_entries;
+
+    auto* io_uring = new IoUring(ring);
+    std::thread([io_uring] { io_uring->RunCompletionLoop(); }).detach();
+    return io_uring;
+  }();
+  return io_uring;
+}
+
+AsyncValueRef<size_t> IoUring::Read(int fd, char* buf, size_t max_count,
+                                    size_t offset) {
+  unsigned num_in_flight = ring_->num_in_flight.load(std::memory_order_relaxed);
+  do {
+    if (num_in_flight >= ring_->cq_entries) return {};
+  } while (!ring_->num_in_flight.compare_exchange_weak(
+      num_in_flight, num_in_flight + 1, std::memory_order_relaxed));
+
+  auto* request = new ReadRequest;
+  request->fd = fd;
+  request->buf = buf;
+  request->max_count = max_count;
+  request->offset = offset;
+  request->result = MakeUnconstructedAsyncValueRef<size_t>();
+  auto result = request->result.CopyRef();
+  if (max_count == 0) {
+    HandleCompletion(request, 0);
+  } else if (!Submit(request)) {
+    ring_->num_in_flight.fetch_sub(1, std::memory_order_relaxed);
+    delete request;
+    return {};
+  }
+  return result;
+}
+
+bool IoUring::Submit(ReadRequest* request) {
+  // Some kernels reject reads that do not fit in a 32-bit integer.
+  size_t request_count = std::min<size_t>(request->max_count - request->count,
+                                          std::numeric_limits<int32_t>::max());
+  request->iov.iov_base = request->buf + request->count;
+  request->iov.iov_len = request_count;
+
+  mutex_lock lock(ring_->mu);
+  // Without SQPOLL, io_uring_enter() consumes the submitted entry before it
+  // returns, so there is always a free entry.
+  unsigned tail = *ring_->sq_tail;
+  unsigned index = tail & ring_->sq_mask;
+  io_uring_sqe* sqe = &ring_->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READV;
+  sqe->fd = request->fd;
+  sqe->addr = reinterpret_cast<uint64_t>(&request->iov);
+  sqe->len = 1;
+  sqe->off = request->offset + request->count;
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  ring_->sq_array[index] = index;
+  __atomic_store_n(ring_->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  while (true) {
+    int submitted =
+        syscall(__NR_io_uring_enter, ring_->fd, 1, 0, 0, nullptr, 0);
+    if (submitted == 1) return true;
+    if (submitted < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+    // Remove the entry that the kernel did not consume.
+    __atomic_store_n(ring_->sq_tail, tail, __ATOMIC_RELEASE);
+    return false;
+  }
+}
+
+void IoUring::RunCompletionLoop() {
+  while (true) {
+    // Errors such as EINTR are handled by checking for completions again.
+    syscall(__NR_io_uring_enter, ring_->fd, 0, 1, IORING_ENTER_GETEVENTS,
+            nullptr, 0);
+
+    unsigned head = *ring_->cq_head;
+    unsigned tail = __atomic_load_n(ring_->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+      const io_uring_cqe& cqe = ring_->cqes[head & ring_->cq_mask];
+      auto* request = reinterpret_cast<ReadRequest*>(cqe.user_data);
+      int res = cqe.res;
+      // Release the entry before handling it, since a resubmission may need
+      // completion queue space.
+      __atomic_store_n(ring_->cq_head, head + 1, __ATOMIC_RELEASE);
+      HandleCompletion(request, res);
+    }
+  }
+}
+
+void IoUring::HandleCompletion(ReadRequest* request, int res) {
+  if (res > 0) request->count += res;
+  // A short read is not necessarily the end of the file. Read the rest, like
+  // the blocking read does.
+  if (res == -EINTR || res == -EAGAIN ||
+      (res > 0 && request->count < request->max_count)) {
+    if (Submit(request)) return;
+    res = -EIO;
+  }
+
+  if (res < 0) {
+    request->result.SetError(absl::InternalError(
+        StrCat("failed to read file due to error: ", strerror(-res))));
+  } else {
+    request->result.emplace(request->count);
+  }
+  ring_->num_in_flight.fetch_sub(1, std::memory_order_relaxed);
+  delete request;
+}
+
+#endif  // TFRT_HAS_IO_URING
+
+}  // namespace io
+}  // namespace tfrt
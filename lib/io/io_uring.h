@@ -0,0 +1,73 @@
+/*
+ * Copyright 2020 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file declares the IoUring class, which reads files asynchronously with
+// Linux io_uring.
+
+#ifndef TFRT_LIB_IO_IO_URING_H_
+#define TFRT_LIB_IO_IO_URING_H_
+
+#include <cstddef>
+
+#include "tfrt/host_context/async_value_ref.h"
+
+namespace tfrt {
+namespace io {
+
+// IoUring submits reads to a Linux io_uring instance and completes them on a
+// dedicated completion thread, so that many reads can be outstanding without
+// blocking a thread each. The continuations of the returned values run on the
+// completion thread and should not block.
+//
+// The ring is set up without any third party library, through the raw system
+// calls. It is unavailable on other platforms, and on kernels without io_uring
+// support.
+class IoUring {
+ public:
+  // Returns the process-wide instance, or nullptr if io_uring is unavailable.
+  static IoUring* Get();
+
+  // Reads up to `max_count` bytes from `fd` starting at `offset` into `buf`,
+  // with the semantics of RandomAccessFile::Read(). Returns a null
+  // AsyncValueRef if the read can not be submitted, e.g. because too many reads
+  // are already outstanding; the caller should fall back to a blocking read.
+  AsyncValueRef<size_t> Read(int fd, char* buf, size_t max_count,
+                             size_t offset);
+
+ private:
+  struct Ring;
+  struct ReadRequest;
+
+  explicit IoUring(Ring* ring) : ring_(ring) {}
+
+  // Submits the remaining part of `request` to the ring.
+  bool Submit(ReadRequest* request);
+
+  // Waits for completions and handles them. Never returns.
+  void RunCompletionLoop();
+
+  // Completes `request` with the result `res` of its last submission, or
+  // resubmits its remaining part after a short read.
+  void HandleCompletion(ReadRequest* request, int res);
+
+  // Owned, never destroyed.
+  Ring* ring_;
+};
+
+}  // namespace io
+}  // namespace tfrt
+
+#endif  // TFRT_LIB_IO_IO_URING_H_
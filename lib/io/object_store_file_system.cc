@@ -0,0 +1,388 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the ObjectStoreFileSystem class.
+
+#include "tfrt/io/object_store_file_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <utility>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/GlobPattern.h"
+#include "tfrt/host_context/async_dispatch.h"
+#include "tfrt/support/latch.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/string_util.h"
+#include "tfrt/support/thread_annotations.h"
+
+namespace tfrt {
+namespace io {
+namespace {
+
+// Splits `path` of the form "<scheme>://<bucket>/<object>".
+llvm::Error ParsePath(string_view scheme, string_view path,
+                      std::string* bucket, std::string* object) {
+  string_view rest = path;
+  if (!rest.consume_front(scheme) || !rest.consume_front("://"))
+    return MakeStringError("path ", path, " does not start with ", scheme,
+                           "://");
+  auto parts = rest.split('/');
+  if (parts.first.empty())
+    return MakeStringError("path ", path, " does not name a bucket");
+  *bucket = parts.first.str();
+  *object = parts.second.str();
+  return llvm::Error::success();
+}
+
+// A pool of at most `max_connections` connections to the object store.
+class ConnectionPool {
+ public:
+  ConnectionPool(ObjectStoreFileSystem::ConnectionFactory factory,
+                 int max_connections)
+      : factory_(std::move(factory)), max_connections_(max_connections) {
+    assert(max_connections_ > 0);
+  }
+
+  // Returns an idle connection. Opens a new connection if there is none and
+  // the pool is not full, and otherwise waits for a connection to be released.
+  llvm::Expected<std::unique_ptr<ObjectStoreConnection>> Acquire() {
+    {
+      mutex_lock lock(mu_);
+      cv_.wait(lock, [this]() TFRT_REQUIRES(mu_) {
+        return !idle_.empty() || num_connections_ < max_connections_;
+      });
+      if (!idle_.empty()) {
+        auto connection = std::move(idle_.back());
+        idle_.pop_back();
+        return std::move(connection);
+      }
+      ++num_connections_;
+    }
+    auto connection = factory_();
+    if (!connection) Close(nullptr);
+    return connection;
+  }
+
+  // Returns `connection` to the pool. A connection whose last request failed
+  // is closed instead, because it may be in an unknown state.
+  void Release(std::unique_ptr<ObjectStoreConnection> connection, bool ok) {
+    if (!ok) return Close(std::move(connection));
+    mutex_lock lock(mu_);
+    idle_.push_back(std::move(connection));
+    cv_.notify_one();
+  }
+
+ private:
+  void Close(std::unique_ptr<ObjectStoreConnection> connection) {
+    connection.reset();
+    mutex_lock lock(mu_);
+    --num_connections_;
+    cv_.notify_one();
+  }
+
+  const ObjectStoreFileSystem::ConnectionFactory factory_;
+  const int max_connections_;
+
+  mutex mu_;
+  condition_variable cv_;
+  std::vector<std::unique_ptr<ObjectStoreConnection>> idle_
+      TFRT_GUARDED_BY(mu_);
+  // The number of open connections, idle or in use.
+  int num_connections_ TFRT_GUARDED_BY(mu_) = 0;
+};
+
+// A least recently used cache of object ranges, holding at most `capacity`
+// bytes.
+class RangeCache {
+ public:
+  using Range = std::shared_ptr<const std::string>;
+
+  explicit RangeCache(size_t capacity) : capacity_(capacity) {}
+
+  // Returns the range cached for `key`, or null.
+  Range Lookup(const std::string& key) {
+    if (capacity_ == 0) return nullptr;
+    mutex_lock lock(mu_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return nullptr;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->range;
+  }
+
+  void Insert(const std::string& key, Range range) {
+    if (capacity_ == 0 || range->size() > capacity_) return;
+    // Evicted ranges are destroyed outside of the lock.
+    std::vector<Range> evicted;
+    mutex_lock lock(mu_);
+    // Another read may have inserted the range concurrently.
+    auto inserted = entries_.try_emplace(key, lru_.end());
+    if (!inserted.second) return;
+    size_ += range->size();
+    lru_.push_front({key, std::move(range)});
+    inserted.first->second = lru_.begin();
+    while (size_ > capacity_) {
+      Entry& entry = lru_.back();
+      size_ -= entry.range->size();
+      evicted.push_back(std::move(entry.range));
+      entries_.erase(entry.key);
+      lru_.pop_back();
+    }
+  }
+
+ private:
+  struct Entry {
+    std::string key;
+    Range range;
+  };
+
+  const size_t capacity_;
+
+  mutex mu_;
+  // The cached ranges, most recently used first.
+  std::list<Entry> lru_ TFRT_GUARDED_BY(mu_);
+  llvm::StringMap<std::list<Entry>::iterator> entries_ TFRT_GUARDED_BY(mu_);
+  size_t size_ TFRT_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace
+
+class ObjectStoreFileSystem::Impl {
+ public:
+  class File;
+
+  Impl(std::string scheme, ConnectionFactory factory,
+       const ObjectStoreOptions& options, HostContext* host)
+      : scheme_(std::move(scheme)),
+        range_size_(options.range_size),
+        max_connections_(options.max_connections),
+        host_(host),
+        pool_(std::move(factory), options.max_connections),
+        cache_(options.cache_size) {
+    assert(range_size_ > 0);
+  }
+
+  const std::string& scheme() const { return scheme_; }
+  ConnectionPool& pool() { return pool_; }
+
+  // Reads up to `max_count` bytes at `offset` of `object`, which has
+  // `object_size` bytes.
+  llvm::Expected<size_t> Read(const std::string& bucket,
+                              const std::string& object, size_t object_size,
+                              char* buf, size_t max_count, size_t offset);
+
+ private:
+  // The state of a read shared with the range requests on the blocking work
+  // queue, which may run after the read returns.
+  struct ReadState {
+    ReadState(size_t num_ranges, std::vector<size_t> missing_ranges)
+        : ranges(num_ranges),
+          missing(std::move(missing_ranges)),
+          done(missing.size()) {}
+
+    std::vector<RangeCache::Range> ranges;
+    // The indices of the ranges which are not cached.
+    const std::vector<size_t> missing;
+    // The index into `missing` of the next range to request.
+    std::atomic<size_t> next_missing{0};
+    // Counts down when a missing range is read or fails.
+    latch done;
+    mutex mu;
+    llvm::Error error TFRT_GUARDED_BY(mu) = llvm::Error::success();
+  };
+
+  std::string RangeKey(const std::string& bucket, const std::string& object,
+                       size_t index) const {
+    return StrCat(bucket, "/", object, "@", index);
+  }
+
+  const std::string scheme_;
+  const size_t range_size_;
+  const int max_connections_;
+  HostContext* const host_;
+  ConnectionPool pool_;
+  RangeCache cache_;
+};
+
+llvm::Expected<size_t> ObjectStoreFileSystem::Impl::Read(
+    const std::string& bucket, const std::string& object, size_t object_size,
+    char* buf, size_t max_count, size_t offset) {
+  if (offset >= object_size) return 0;
+  max_count = std::min(max_count, object_size - offset);
+  if (max_count == 0) return 0;
+
+  size_t first = offset / range_size_;
+  size_t num_ranges = (offset + max_count - 1) / range_size_ - first + 1;
+  std::vector<RangeCache::Range> cached(num_ranges);
+  std::vector<size_t> missing;
+  for (size_t i = 0; i < num_ranges; ++i) {
+    cached[i] = cache_.Lookup(RangeKey(bucket, object, first + i));
+    if (!cached[i]) missing.push_back(i);
+  }
+
+  auto state = std::make_shared<ReadState>(num_ranges, std::move(missing));
+  state->ranges = std::move(cached);
+
+  // Requests the missing ranges until none is left. Runs on the calling thread
+  // and on up to `max_connections_ - 1` threads of the blocking work queue, so
+  // that the read completes even if the queue is busy.
+  auto request_ranges = [this, &bucket, &object, object_size,
+                         first](ReadState* state) {
+    size_t next;
+    while ((next = state->next_missing++) < state->missing.size()) {
+      size_t index = state->missing[next];
+      size_t begin = (first + index) * range_size_;
+      size_t count = std::min(range_size_, object_size - begin);
+      auto range = std::make_shared<std::string>(count, '\0');
+      auto read = [&]() -> llvm::Expected<size_t> {
+        auto connection = pool_.Acquire();
+        if (!connection) return connection.takeError();
+        auto read_count = (*connection)->ReadRange(bucket, object, begin,
+                                                   count, &(*range)[0]);
+        pool_.Release(std::move(*connection), static_cast<bool>(read_count));
+        return read_count;
+      }();
+      if (read) {
+        range->resize(*read);
+        cache_.Insert(RangeKey(bucket, object, first + index), range);
+        state->ranges[index] = std::move(range);
+      } else {
+        mutex_lock lock(state->mu);
+        state->error = llvm::joinErrors(std::move(state->error),
+                                        read.takeError());
+      }
+      state->done.count_down();
+    }
+  };
+
+  size_t num_requesters = std::min<size_t>(state->missing.size(),
+                                           max_connections_);
+  for (size_t i = 1; i < num_requesters; ++i) {
+    // The state is only accessed through `request_ranges` while some range is
+    // not requested, i.e. before the read returns.
+    bool enqueued = EnqueueBlockingWork(
+        host_, [state, request_ranges] { request_ranges(state.get()); });
+    if (!enqueued) break;
+  }
+  request_ranges(state.get());
+  state->done.wait();
+
+  {
+    mutex_lock lock(state->mu);
+    if (state->error) return std::move(state->error);
+  }
+
+  // Copy the ranges, stopping at a range cut short by the end of the object.
+  size_t count = 0;
+  for (size_t i = 0; i < num_ranges && count < max_count; ++i) {
+    const std::string& range = *state->ranges[i];
+    size_t start = offset + count - (first + i) * range_size_;
+    if (start >= range.size()) break;
+    size_t n = std::min(range.size() - start, max_count - count);
+    std::memcpy(buf + count, range.data() + start, n);
+    count += n;
+    if (range.size() < range_size_) break;
+  }
+  return count;
+}
+
+// This class is used to read an object as a random access file.
+class ObjectStoreFileSystem::Impl::File : public RandomAccessFile {
+ public:
+  File(Impl* file_system, std::string bucket, std::string object, size_t size)
+      : file_system_(file_system),
+        bucket_(std::move(bucket)),
+        object_(std::move(object)),
+        size_(size) {}
+
+  // This class is not copyable or movable.
+  File(const File&) = delete;
+  File& operator=(const File&) = delete;
+
+  llvm::Expected<size_t> Read(char* buf, size_t max_count,
+                              size_t offset) const override {
+    return file_system_->Read(bucket_, object_, size_, buf, max_count, offset);
+  }
+
+ private:
+  Impl* const file_system_;
+  const std::string bucket_;
+  const std::string object_;
+  const size_t size_;
+};
+
+ObjectStoreFileSystem::ObjectStoreFileSystem(std::string scheme,
+                                             ConnectionFactory factory,
+                                             const ObjectStoreOptions& options,
+                                             HostContext* host)
+    : impl_(std::make_unique<Impl>(std::move(scheme), std::move(factory),
+                                   options, host)) {}
+
+ObjectStoreFileSystem::~ObjectStoreFileSystem() = default;
+
+llvm::Error ObjectStoreFileSystem::NewRandomAccessFile(
+    const std::string& path, std::unique_ptr<RandomAccessFile>* file) {
+  file->reset();
+  std::string bucket, object;
+  if (auto error = ParsePath(impl_->scheme(), path, &bucket, &object))
+    return error;
+
+  auto connection = impl_->pool().Acquire();
+  if (!connection) return connection.takeError();
+  auto size = (*connection)->GetObjectSize(bucket, object);
+  impl_->pool().Release(std::move(*connection), static_cast<bool>(size));
+  if (!size) return size.takeError();
+
+  *file = std::make_unique<Impl::File>(
+      impl_.get(), std::move(bucket), std::move(object), *size);
+  return llvm::Error::success();
+}
+
+llvm::Error ObjectStoreFileSystem::GetMatchingPaths(
+    const std::string& pattern, std::vector<std::string>* results) {
+  results->clear();
+  std::string bucket, object_pattern;
+  if (auto error = ParsePath(impl_->scheme(), pattern, &bucket,
+                             &object_pattern))
+    return error;
+  auto glob = llvm::GlobPattern::create(object_pattern);
+  if (!glob) return glob.takeError();
+
+  // Only list the objects starting with the part before the first wildcard.
+  std::string prefix =
+      object_pattern.substr(0, object_pattern.find_first_of("*?["));
+  std::vector<std::string> objects;
+  auto connection = impl_->pool().Acquire();
+  if (!connection) return connection.takeError();
+  auto error = (*connection)->ListObjects(bucket, prefix, &objects);
+  impl_->pool().Release(std::move(*connection), !error);
+  if (error) return error;
+
+  // Wildcards do not match the `/` separator, so a matching object has as
+  // many separators as the pattern.
+  auto num_separators = llvm::count(object_pattern, '/');
+  for (const auto& object : objects) {
+    if (llvm::count(object, '/') != num_separators || !glob->match(object))
+      continue;
+    results->push_back(StrCat(impl_->scheme(), "://", bucket, "/", object));
+  }
+  llvm::sort(*results);
+  return llvm::Error::success();
+}
+
+}  // namespace io
+}  // namespace tfrt
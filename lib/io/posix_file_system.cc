@@ -20,10 +20,14 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <glob.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <limits>
 
+#include "io_uring.h"
 #include "llvm_derived/Support/raw_ostream.h"
 
 namespace tfrt {
@@ -45,6 +49,11 @@ class PosixRandomAccessFile : public RandomAccessFile {
   llvm::Expected<size_t> Read(char* buf, size_t max_count,
                               size_t offset) const override;
 
+  // Reads with io_uring if it is available, and otherwise falls back to the
+  // blocking work queue.
+  AsyncValueRef<size_t> ReadAsync(char* buf, size_t max_count, size_t offset,
+                                  HostContext* host) const override;
+
  private:
   int fd_;
   const std::string path_;
@@ -81,6 +90,48 @@ llvm::Expected<size_t> PosixRandomAccessFile::Read(char* buf, size_t max_count,
 
   return actual_count;
 }
+
+AsyncValueRef<size_t> PosixRandomAccessFile::ReadAsync(
+    char* buf, size_t max_count, size_t offset, HostContext* host) const {
+  if (auto* io_uring = IoUring::Get(); io_uring && fd_ >= 0) {
+    if (auto result = io_uring->Read(fd_, buf, max_count, offset)) {
+      return result;
+    }
+  }
+  return RandomAccessFile::ReadAsync(buf, max_count, offset, host);
+}
+
+// This class is used to keep a read-only memory-mapped file alive.
+class PosixReadOnlyMemoryRegion : public ReadOnlyMemoryRegion {
+ public:
+  explicit PosixReadOnlyMemoryRegion(const void* address, size_t length,
+                                     const std::string& path)
+      : address_(address), length_(length), path_(path) {}
+
+  ~PosixReadOnlyMemoryRegion() override;
+
+  // This class is not copyable or movable.
+  PosixReadOnlyMemoryRegion(const PosixReadOnlyMemoryRegion&) = delete;
+  PosixReadOnlyMemoryRegion operator=(const PosixReadOnlyMemoryRegion&) =
+      delete;
+
+  const void* data() const override { return address_; }
+  size_t length() const override { return length_; }
+
+ private:
+  const void* address_;
+  size_t length_;
+  const std::string path_;
+};
+
+PosixReadOnlyMemoryRegion::~PosixReadOnlyMemoryRegion() {
+  // Empty files are not mapped.
+  if (length_ == 0) return;
+  if (munmap(const_cast<void*>(address_), length_) < 0) {
+    tfrt::errs() << "failed to unmap file " << path_
+                 << " due to error: " << strerror(errno) << "\n";
+  }
+}
 }  // namespace
 
 llvm::Error PosixFileSystem::NewRandomAccessFile(
@@ -95,6 +146,56 @@ llvm::Error PosixFileSystem::NewRandomAccessFile(
   return llvm::Error::success();
 }
 
+llvm::Error PosixFileSystem::NewReadOnlyMemoryRegion(
+    const std::string& path, std::unique_ptr<ReadOnlyMemoryRegion>* region) {
+  region->reset();
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return MakeStringError("failed to open file ", path,
+                           " due to error: ", strerror(errno));
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return MakeStringError("failed to stat file ", path,
+                           " due to error: ", strerror(errno));
+  }
+
+  // mmap() fails for zero-length mappings, so empty files get an empty region.
+  size_t length = st.st_size;
+  const void* address = nullptr;
+  if (length > 0) {
+    address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+      close(fd);
+      return MakeStringError("failed to map file ", path,
+                             " due to error: ", strerror(errno));
+    }
+  }
+
+  // The mapping keeps the file alive, so the descriptor is not needed anymore.
+  close(fd);
+  *region = std::make_unique<PosixReadOnlyMemoryRegion>(address, length, path);
+  return llvm::Error::success();
+}
+
+llvm::Error PosixFileSystem::GetMatchingPaths(
+    const std::string& pattern, std::vector<std::string>* results) {
+  results->clear();
+  glob_t matches;
+  // glob() sorts the matches by name unless GLOB_NOSORT is set.
+  int status = glob(pattern.c_str(), GLOB_ERR, /*errfunc=*/nullptr, &matches);
+  if (status == GLOB_NOMATCH) return llvm::Error::success();
+  if (status != 0) {
+    globfree(&matches);
+    return MakeStringError("failed to match file pattern ", pattern);
+  }
+  results->assign(matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+  globfree(&matches);
+  return llvm::Error::success();
+}
+
 void RegisterFileSystem(FileSystemRegistry* registry) {
   auto file_system = std::make_unique<PosixFileSystem>();
   // The scheme is an empty string to be backward-compatible with TF.
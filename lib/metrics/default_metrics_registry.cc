@@ -0,0 +1,337 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file implements the default, in-memory MetricsRegistry.
+
+#include "tfrt/metrics/default_metrics_registry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MathExtras.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace tfrt {
+namespace metrics {
+namespace {
+
+// Number of shards of counters and histograms, must be a power of two. CPUs
+// beyond this number share shards.
+constexpr int kNumShards = 16;
+
+// Returns the shard for the calling thread: the CPU it is running on if that
+// is known, so that threads on different CPUs update different cache lines.
+int CurrentShard() {
+#if defined(__linux__)
+  int cpu = sched_getcpu();
+  if (cpu >= 0) return cpu & (kNumShards - 1);
+#endif
+  static std::atomic<int> next_shard{0};
+  thread_local int shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) & (kNumShards - 1);
+  return shard;
+}
+
+struct alignas(64) CounterShard {
+  std::atomic<int64_t> value{0};
+};
+
+// Adds `value` to an atomic double. Shards are rarely contended, so the
+// compare-exchange loop almost always succeeds at the first attempt.
+void AtomicAdd(std::atomic<double>& sum, double value) {
+  double current = sum.load(std::memory_order_relaxed);
+  while (!sum.compare_exchange_weak(current, current + value,
+                                    std::memory_order_relaxed)) {
+  }
+}
+
+// Returns `name` with the characters that are not valid in Prometheus metric
+// names replaced with '_', and the leading '/' of TFRT metric names removed.
+std::string PrometheusName(llvm::StringRef name) {
+  name.consume_front("/");
+  std::string result(name);
+  for (int i = 0; i < result.size(); ++i) {
+    char c = result[i];
+    bool valid = llvm::isAlpha(c) || c == '_' || c == ':' ||
+                 (i > 0 && llvm::isDigit(c));
+    if (!valid) result[i] = '_';
+  }
+  if (result.empty()) result = "_";
+  return result;
+}
+
+// Escapes a Prometheus label value.
+std::string EscapeLabelValue(llvm::StringRef value) {
+  std::string result;
+  result.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\') {
+      result += "\\\\";
+    } else if (c == '"') {
+      result += "\\\"";
+    } else if (c == '\n') {
+      result += "\\n";
+    } else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+void WriteDouble(llvm::raw_ostream& os, double value) {
+  os << llvm::format("%.17g", value);
+}
+
+}  // namespace
+
+class DefaultMetricsRegistry::Metric {
+ public:
+  enum class Kind { kCounter, kIntGauge, kStringGauge, kHistogram };
+
+  explicit Metric(Kind kind) : kind_(kind) {}
+  virtual ~Metric() = default;
+
+  Kind kind() const { return kind_; }
+
+  // Writes the samples of the metric named `name`, without the TYPE line.
+  virtual void Write(llvm::raw_ostream& os, llvm::StringRef name) const = 0;
+
+ private:
+  const Kind kind_;
+};
+
+namespace {
+
+using Kind = DefaultMetricsRegistry::Metric::Kind;
+
+class ShardedCounter : public DefaultMetricsRegistry::Metric, public Counter {
+ public:
+  ShardedCounter() : Metric(Kind::kCounter) {}
+
+  void IncrementBy(int64_t value) override {
+    shards_[CurrentShard()].value.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  void Write(llvm::raw_ostream& os, llvm::StringRef name) const override {
+    int64_t value = 0;
+    for (const CounterShard& shard : shards_)
+      value += shard.value.load(std::memory_order_relaxed);
+    os << name << ' ' << value << '\n';
+  }
+
+ private:
+  CounterShard shards_[kNumShards];
+};
+
+class AtomicIntGauge : public DefaultMetricsRegistry::Metric,
+                       public Gauge<int64_t> {
+ public:
+  AtomicIntGauge() : Metric(Kind::kIntGauge) {}
+
+  void Set(int64_t value) override {
+    value_.store(value, std::memory_order_relaxed);
+  }
+
+  void Write(llvm::raw_ostream& os, llvm::StringRef name) const override {
+    os << name << ' ' << value_.load(std::memory_order_relaxed) << '\n';
+  }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+class StringGauge : public DefaultMetricsRegistry::Metric,
+                    public Gauge<std::string> {
+ public:
+  StringGauge() : Metric(Kind::kStringGauge) {}
+
+  void Set(std::string value) override {
+    mutex_lock lock(mu_);
+    value_ = std::move(value);
+  }
+
+  void Write(llvm::raw_ostream& os, llvm::StringRef name) const override {
+    mutex_lock lock(mu_);
+    os << name << "{value=\"" << EscapeLabelValue(value_) << "\"} 1\n";
+  }
+
+ private:
+  mutable mutex mu_;
+  std::string value_ TFRT_GUARDED_BY(mu_);
+};
+
+class ShardedHistogram : public DefaultMetricsRegistry::Metric,
+                         public Histogram {
+ public:
+  explicit ShardedHistogram(const Buckets& buckets)
+      : Metric(Kind::kHistogram),
+        bounds_(buckets.explicit_bounds()),
+        shard_stride_(RoundUpToCacheLine(bounds_.size() + 1)),
+        counts_(new std::atomic<int64_t>[kNumShards * shard_stride_]),
+        sums_(new SumShard[kNumShards]) {
+    for (int i = 0; i < kNumShards * shard_stride_; ++i)
+      counts_[i].store(0, std::memory_order_relaxed);
+  }
+
+  void Record(double value) override {
+    // Bucket `i` counts the values in [bounds[i - 1], bounds[i]), bucket 0
+    // is the underflow and the last bucket is the overflow bucket.
+    size_t bucket = std::upper_bound(bounds_.begin(), bounds_.end(), value) -
+                    bounds_.begin();
+    int shard = CurrentShard();
+    counts_[shard * shard_stride_ + bucket].fetch_add(
+        1, std::memory_order_relaxed);
+    AtomicAdd(sums_[shard].sum, value);
+  }
+
+  void Write(llvm::raw_ostream& os, llvm::StringRef name) const override {
+    std::vector<int64_t> counts(bounds_.size() + 1, 0);
+    double sum = 0;
+    for (int shard = 0; shard < kNumShards; ++shard) {
+      for (int i = 0; i < counts.size(); ++i) {
+        counts[i] += counts_[shard * shard_stride_ + i].load(
+            std::memory_order_relaxed);
+      }
+      sum += sums_[shard].sum.load(std::memory_order_relaxed);
+    }
+
+    // Prometheus buckets are cumulative.
+    int64_t count = 0;
+    for (int i = 0; i < bounds_.size(); ++i) {
+      count += counts[i];
+      os << name << "_bucket{le=\"";
+      WriteDouble(os, bounds_[i]);
+      os << "\"} " << count << '\n';
+    }
+    count += counts.back();
+    os << name << "_bucket{le=\"+Inf\"} " << count << '\n';
+    os << name << "_sum ";
+    WriteDouble(os, sum);
+    os << '\n' << name << "_count " << count << '\n';
+  }
+
+ private:
+  struct alignas(64) SumShard {
+    std::atomic<double> sum{0};
+  };
+
+  // Returns the number of counters rounded up to whole cache lines, so that
+  // shards don't share cache lines.
+  static size_t RoundUpToCacheLine(size_t num_counters) {
+    constexpr size_t kCountersPerLine = 64 / sizeof(std::atomic<int64_t>);
+    return llvm::alignTo(num_counters, kCountersPerLine);
+  }
+
+  const std::vector<double> bounds_;
+  const size_t shard_stride_;
+  std::unique_ptr<std::atomic<int64_t>[]> counts_;
+  std::unique_ptr<SumShard[]> sums_;
+};
+
+const char* PrometheusType(Kind kind) {
+  switch (kind) {
+    case Kind::kCounter:
+      return "counter";
+    case Kind::kIntGauge:
+    case Kind::kStringGauge:
+      return "gauge";
+    case Kind::kHistogram:
+      return "histogram";
+  }
+  return "untyped";
+}
+
+}  // namespace
+
+DefaultMetricsRegistry::DefaultMetricsRegistry() = default;
+DefaultMetricsRegistry::~DefaultMetricsRegistry() = default;
+
+template <typename T>
+T* DefaultMetricsRegistry::GetOrCreate(std::string name,
+                                       std::unique_ptr<T> metric) {
+  mutex_lock lock(mu_);
+  auto it = metrics_.try_emplace(name, nullptr).first;
+  if (it->second == nullptr) {
+    T* result = metric.get();
+    it->second = std::move(metric);
+    return result;
+  }
+  if (it->second->kind() == metric->kind())
+    return static_cast<T*>(it->second.get());
+
+  T* result = metric.get();
+  unexported_.push_back(std::move(metric));
+  return result;
+}
+
+Gauge<std::string>* DefaultMetricsRegistry::NewStringGauge(std::string name) {
+  return GetOrCreate(std::move(name), std::make_unique<StringGauge>());
+}
+
+Gauge<int64_t>* DefaultMetricsRegistry::NewIntGauge(std::string name) {
+  return GetOrCreate(std::move(name), std::make_unique<AtomicIntGauge>());
+}
+
+Histogram* DefaultMetricsRegistry::NewHistogram(std::string name,
+                                                const Buckets& buckets) {
+  return GetOrCreate(std::move(name),
+                     std::make_unique<ShardedHistogram>(buckets));
+}
+
+Counter* DefaultMetricsRegistry::NewCounter(std::string name) {
+  return GetOrCreate(std::move(name), std::make_unique<ShardedCounter>());
+}
+
+void DefaultMetricsRegistry::WritePrometheusText(llvm::raw_ostream& os) const {
+  mutex_lock lock(mu_);
+
+  std::vector<const llvm::StringMapEntry<std::unique_ptr<Metric>>*> entries;
+  for (const auto& entry : metrics_) entries.push_back(&entry);
+  llvm::sort(entries, [](const auto* a, const auto* b) {
+    return a->getKey() < b->getKey();
+  });
+
+  for (const auto* entry : entries) {
+    std::string name = PrometheusName(entry->getKey());
+    os << "# TYPE " << name << ' ' << PrometheusType(entry->second->kind())
+       << '\n';
+    entry->second->Write(os, name);
+  }
+}
+
+DefaultMetricsRegistry* RegisterDefaultMetricsRegistry() {
+  static DefaultMetricsRegistry* registry = [] {
+    auto* registry = new DefaultMetricsRegistry;
+    RegisterMetricsRegistry(registry);
+    return registry;
+  }();
+  return registry;
+}
+
+}  // namespace metrics
+}  // namespace tfrt
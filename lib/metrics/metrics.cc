@@ -30,6 +30,14 @@ class DummyGauge : public Gauge<T> {
   void Set(T value) override {}
 };
 
+// A dummy implementation of the Counter metric interface.
+class DummyCounter : public Counter {
+ public:
+  DummyCounter() {}
+
+  void IncrementBy(int64_t value) override {}
+};
+
 // A dummy implementation of the Histogram metric interface.
 class DummyHistogram : public Histogram {
  public:
@@ -45,6 +53,23 @@ Gauge<std::string>* NewGauge(std::string name) {
   return new DummyGauge<std::string>();
 }
 
+template <>
+Gauge<int64_t>* NewGauge(std::string name) {
+  if (internal::kMetricsRegistry != nullptr) {
+    if (auto* gauge = internal::kMetricsRegistry->NewIntGauge(name))
+      return gauge;
+  }
+  return new DummyGauge<int64_t>();
+}
+
+Counter* NewCounter(std::string name) {
+  if (internal::kMetricsRegistry != nullptr) {
+    if (auto* counter = internal::kMetricsRegistry->NewCounter(name))
+      return counter;
+  }
+  return new DummyCounter();
+}
+
 Histogram* NewHistogram(std::string name, const Buckets& buckets) {
   if (internal::kMetricsRegistry != nullptr)
     return internal::kMetricsRegistry->NewHistogram(name, buckets);
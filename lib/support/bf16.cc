@@ -0,0 +1,132 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the bulk conversions between float and bf16.
+
+#include "tfrt/support/bf16.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define TFRT_BF16_AVX512 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define TFRT_BF16_AVX2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TFRT_BF16_NEON 1
+#endif
+
+namespace tfrt {
+
+// bf16 is the upper half of a float. Rounds to the nearest even value by
+// adding 0x7fff plus the lowest bit that is kept, and keeps NaNs quiet.
+static uint16_t FloatToBf16(float f) {
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  if (f != f) return static_cast<uint16_t>((bits >> 16) | 0x40);
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return static_cast<uint16_t>(bits >> 16);
+}
+
+static float Bf16ToFloat(uint16_t v) {
+  uint32_t bits = static_cast<uint32_t>(v) << 16;
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+void ConvertBuffer(const float* src, bf16* dst, size_t n) {
+  size_t i = 0;
+#if defined(TFRT_BF16_AVX512)
+  const __m512i rounding_bias = _mm512_set1_epi32(0x7fff);
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i quiet_bit = _mm512_set1_epi32(0x40);
+  for (; i + 16 <= n; i += 16) {
+    __m512 value = _mm512_loadu_ps(src + i);
+    __m512i bits = _mm512_castps_si512(value);
+    __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(bits, 16), one);
+    __m512i rounded = _mm512_srli_epi32(
+        _mm512_add_epi32(_mm512_add_epi32(bits, rounding_bias), lsb), 16);
+    __m512i nan = _mm512_or_si512(_mm512_srli_epi32(bits, 16), quiet_bit);
+    __mmask16 is_nan = _mm512_cmp_ps_mask(value, value, _CMP_UNORD_Q);
+    __m512i result = _mm512_mask_blend_epi32(is_nan, rounded, nan);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm512_cvtepi32_epi16(result));
+  }
+#elif defined(TFRT_BF16_AVX2)
+  const __m256i rounding_bias = _mm256_set1_epi32(0x7fff);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i quiet_bit = _mm256_set1_epi32(0x40);
+  for (; i + 8 <= n; i += 8) {
+    __m256 value = _mm256_loadu_ps(src + i);
+    __m256i bits = _mm256_castps_si256(value);
+    __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+    __m256i rounded = _mm256_srli_epi32(
+        _mm256_add_epi32(_mm256_add_epi32(bits, rounding_bias), lsb), 16);
+    __m256i nan = _mm256_or_si256(_mm256_srli_epi32(bits, 16), quiet_bit);
+    __m256i is_nan =
+        _mm256_castps_si256(_mm256_cmp_ps(value, value, _CMP_UNORD_Q));
+    __m256i result = _mm256_blendv_epi8(rounded, nan, is_nan);
+    // packus interleaves the 128-bit lanes; permute them back in order.
+    __m256i packed = _mm256_permute4x64_epi64(
+        _mm256_packus_epi32(result, result), 0xd8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm256_castsi256_si128(packed));
+  }
+#elif defined(TFRT_BF16_NEON)
+  const uint32x4_t rounding_bias = vdupq_n_u32(0x7fff);
+  const uint32x4_t one = vdupq_n_u32(1);
+  const uint32x4_t quiet_bit = vdupq_n_u32(0x40);
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t value = vld1q_f32(src + i);
+    uint32x4_t bits = vreinterpretq_u32_f32(value);
+    uint32x4_t lsb = vandq_u32(vshrq_n_u32(bits, 16), one);
+    uint32x4_t rounded =
+        vshrq_n_u32(vaddq_u32(vaddq_u32(bits, rounding_bias), lsb), 16);
+    uint32x4_t nan = vorrq_u32(vshrq_n_u32(bits, 16), quiet_bit);
+    uint32x4_t is_not_nan = vceqq_f32(value, value);
+    uint32x4_t result = vbslq_u32(is_not_nan, rounded, nan);
+    vst1_u16(reinterpret_cast<uint16_t*>(dst + i), vmovn_u32(result));
+  }
+#endif
+  for (; i < n; ++i) dst[i] = bf16(FloatToBf16(src[i]));
+}
+
+void ConvertBuffer(const bf16* src, float* dst, size_t n) {
+  size_t i = 0;
+#if defined(TFRT_BF16_AVX512)
+  for (; i + 16 <= n; i += 16) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    __m512i bits = _mm512_slli_epi32(_mm512_cvtepu16_epi32(v), 16);
+    _mm512_storeu_ps(dst + i, _mm512_castsi512_ps(bits));
+  }
+#elif defined(TFRT_BF16_AVX2)
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m256i bits = _mm256_slli_epi32(_mm256_cvtepu16_epi32(v), 16);
+    _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(bits));
+  }
+#elif defined(TFRT_BF16_NEON)
+  for (; i + 4 <= n; i += 4) {
+    uint16x4_t v = vld1_u16(reinterpret_cast<const uint16_t*>(src + i));
+    vst1q_f32(dst + i, vreinterpretq_f32_u32(vshll_n_u16(v, 16)));
+  }
+#endif
+  for (; i < n; ++i) dst[i] = Bf16ToFloat(src[i].value);
+}
+
+}  // namespace tfrt
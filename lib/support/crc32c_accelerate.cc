@@ -42,14 +42,26 @@
 #undef USE_SSE_CRC32C
 #endif
 
+// ARMv8 accelerated CRC32c.
+
+// See if the ARMv8 crc32c instructions are available. They are optional in
+// ARMv8.0 and mandatory from ARMv8.1, so the target has to enable them (e.g.
+// -march=armv8-a+crc or -mcpu=neoverse-n1).
+#undef USE_ARM_CRC32C
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define USE_ARM_CRC32C 1
+#endif
+
 #ifdef USE_SSE_CRC32C
 #include <nmmintrin.h>
+#elif defined(USE_ARM_CRC32C)
+#include <arm_acle.h>
 #endif
 
 namespace tfrt {
 namespace crc32c {
 
-#ifndef USE_SSE_CRC32C
+#if !defined(USE_SSE_CRC32C) && !defined(USE_ARM_CRC32C)
 
 bool CanAccelerate() { return false; }
 uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
@@ -59,9 +71,133 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
 
 #else
 
+#ifdef USE_SSE_CRC32C
+
 // SSE4.2 optimized crc32c computation.
 bool CanAccelerate() { return __builtin_cpu_supports("sse4.2"); }
 
+static inline uint32_t Crc32cU8(uint32_t crc, uint8_t value) {
+  return _mm_crc32_u8(crc, value);
+}
+static inline uint32_t Crc32cU64(uint32_t crc, uint64_t value) {
+  return static_cast<uint32_t>(_mm_crc32_u64(crc, value));
+}
+
+#else
+
+// ARMv8 optimized crc32c computation. The target enables the instructions, so
+// every CPU it runs on supports them.
+bool CanAccelerate() { return true; }
+
+static inline uint32_t Crc32cU8(uint32_t crc, uint8_t value) {
+  return __crc32cb(crc, value);
+}
+static inline uint32_t Crc32cU64(uint32_t crc, uint64_t value) {
+  return __crc32cd(crc, value);
+}
+
+#endif
+
+// The crc32c instructions have a latency of three cycles, but can start one
+// per cycle. Large buffers are therefore split into three streams which are
+// computed in an interleaved way and combined afterwards. Combining the crc of
+// a stream with the crc of the stream that follows it requires shifting the
+// former over the length of the latter, i.e. appending as many zero bytes.
+// This is a linear operator in GF(2), which is precomputed into tables for the
+// two stream lengths used (see crc32c.c by Mark Adler).
+static constexpr size_t kLongStream = 8192;
+static constexpr size_t kShortStream = 256;
+
+// CRC-32C polynomial, bit-reflected.
+static constexpr uint32_t kPoly = 0x82f63b78;
+
+static uint32_t Gf2MatrixTimes(const uint32_t *mat, uint32_t vec) {
+  uint32_t sum = 0;
+  for (; vec; vec >>= 1, ++mat)
+    if (vec & 1) sum ^= *mat;
+  return sum;
+}
+
+static void Gf2MatrixSquare(uint32_t *square, const uint32_t *mat) {
+  for (int n = 0; n < 32; ++n) square[n] = Gf2MatrixTimes(mat, mat[n]);
+}
+
+// Computes the operator which appends `len` zero bytes to a crc. `len` must be
+// a power of two.
+static void ZerosOperator(uint32_t *even, size_t len) {
+  // Operator for one zero bit in odd.
+  uint32_t odd[32];
+  odd[0] = kPoly;
+  for (int n = 1; n < 32; ++n) odd[n] = 1u << (n - 1);
+
+  // Operators for two and four zero bits.
+  Gf2MatrixSquare(even, odd);
+  Gf2MatrixSquare(odd, even);
+
+  // Each square doubles the number of zero bits, starting with one byte.
+  do {
+    Gf2MatrixSquare(even, odd);
+    len >>= 1;
+    if (len == 0) return;
+    Gf2MatrixSquare(odd, even);
+    len >>= 1;
+  } while (len);
+
+  for (int n = 0; n < 32; ++n) even[n] = odd[n];
+}
+
+namespace {
+
+// Table to append a fixed number of zero bytes to a crc, one byte at a time.
+struct ShiftTable {
+  explicit ShiftTable(size_t len) {
+    uint32_t op[32];
+    ZerosOperator(op, len);
+    for (uint32_t n = 0; n < 256; ++n) {
+      for (int i = 0; i < 4; ++i) table[i][n] = Gf2MatrixTimes(op, n << 8 * i);
+    }
+  }
+
+  uint32_t Shift(uint32_t crc) const {
+    return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^
+           table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+  }
+
+  uint32_t table[4][256];
+};
+
+}  // namespace
+
+static const ShiftTable &LongShiftTable() {
+  static const ShiftTable *table = new ShiftTable(kLongStream);
+  return *table;
+}
+
+static const ShiftTable &ShortShiftTable() {
+  static const ShiftTable *table = new ShiftTable(kShortStream);
+  return *table;
+}
+
+// Computes the crc of `num_blocks` blocks of three interleaved streams of
+// `len` bytes each, starting at the 8-byte aligned `p`.
+static uint32_t ExtendThreeStreams(uint32_t crc, const uint8_t *&p,
+                                   size_t num_blocks, size_t len,
+                                   const ShiftTable &shift) {
+  for (; num_blocks > 0; --num_blocks) {
+    uint32_t crc1 = 0, crc2 = 0;
+    const uint8_t *end = p + len;
+    for (; p < end; p += 8) {
+      crc = Crc32cU64(crc, *reinterpret_cast<const uint64_t *>(p));
+      crc1 = Crc32cU64(crc1, *reinterpret_cast<const uint64_t *>(p + len));
+      crc2 = Crc32cU64(crc2, *reinterpret_cast<const uint64_t *>(p + 2 * len));
+    }
+    crc = shift.Shift(crc) ^ crc1;
+    crc = shift.Shift(crc) ^ crc2;
+    p += 2 * len;
+  }
+  return crc;
+}
+
 uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
   const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
   const uint8_t *e = p + size;
@@ -75,23 +211,33 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
   if (x <= e) {
     // Process bytes until finished or p is 8-byte aligned
     while (p != x) {
-      l = _mm_crc32_u8(l, *p);
+      l = Crc32cU8(l, *p);
       p++;
     }
   }
 
+  // Process large buffers in three streams.
+  size_t remaining = e - p;
+  if (remaining >= 3 * kLongStream) {
+    l = ExtendThreeStreams(l, p, remaining / (3 * kLongStream), kLongStream,
+                           LongShiftTable());
+    remaining = e - p;
+  }
+  if (remaining >= 3 * kShortStream) {
+    l = ExtendThreeStreams(l, p, remaining / (3 * kShortStream), kShortStream,
+                           ShortShiftTable());
+  }
+
   // Process bytes 16 at a time
-  uint64_t l64 = l;
   while ((e - p) >= 16) {
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p));
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p + 8));
+    l = Crc32cU64(l, *reinterpret_cast<const uint64_t *>(p));
+    l = Crc32cU64(l, *reinterpret_cast<const uint64_t *>(p + 8));
     p += 16;
   }
 
   // Process remaining bytes one at a time.
-  l = l64;
   while (p < e) {
-    l = _mm_crc32_u8(l, *p);
+    l = Crc32cU8(l, *p);
     p++;
   }
 
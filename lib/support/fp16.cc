@@ -0,0 +1,141 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the bulk conversions between float and fp16.
+
+#include "tfrt/support/fp16.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define TFRT_FP16_AVX512 1
+#elif defined(__AVX2__) && defined(__F16C__)
+#include <immintrin.h>
+#define TFRT_FP16_AVX2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TFRT_FP16_NEON 1
+#endif
+
+namespace tfrt {
+
+static uint32_t FloatBits(float f) {
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+static float BitsToFloat(uint32_t bits) {
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+// Rounds to the nearest even value. Values that overflow become infinities
+// and NaNs stay quiet NaNs.
+static uint16_t FloatToHalf(float f) {
+  constexpr uint32_t kFloatInf = 255u << 23;
+  // The smallest float that rounds to the half infinity.
+  constexpr uint32_t kHalfOverflow = (127 + 16) << 23;
+  // The smallest float that is a normal half.
+  constexpr uint32_t kHalfMinNormal = 113u << 23;
+  // Adding 0.5 aligns the subnormal half mantissa to the low bits of the
+  // float mantissa, and the float addition rounds it.
+  constexpr uint32_t kDenormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+
+  uint32_t x = FloatBits(f);
+  const uint32_t sign = x & 0x80000000u;
+  x ^= sign;
+
+  uint16_t half;
+  if (x >= kHalfOverflow) {
+    half = x > kFloatInf ? 0x7e00 : 0x7c00;
+  } else if (x < kHalfMinNormal) {
+    float rounded = BitsToFloat(x) + BitsToFloat(kDenormMagic);
+    half = static_cast<uint16_t>(FloatBits(rounded) - kDenormMagic);
+  } else {
+    const uint32_t mant_odd = (x >> 13) & 1;
+    // Rebias the exponent and round the mantissa.
+    x += (static_cast<uint32_t>(15 - 127) << 23) + 0xfff;
+    x += mant_odd;
+    half = static_cast<uint16_t>(x >> 13);
+  }
+  return half | static_cast<uint16_t>(sign >> 16);
+}
+
+static float HalfToFloat(uint16_t half) {
+  constexpr uint32_t kShiftedExp = 0x7c00 << 13;
+  const float kMagic = BitsToFloat(113u << 23);
+
+  uint32_t x = static_cast<uint32_t>(half & 0x7fff) << 13;
+  const uint32_t exp = x & kShiftedExp;
+  x += (127 - 15) << 23;
+  if (exp == kShiftedExp) {
+    // Infinity or NaN.
+    x += (128 - 16) << 23;
+  } else if (exp == 0) {
+    // Zero or subnormal, which is normal as a float.
+    x = FloatBits(BitsToFloat(x + (1 << 23)) - kMagic);
+  }
+  return BitsToFloat(x | (static_cast<uint32_t>(half & 0x8000) << 16));
+}
+
+void ConvertBuffer(const float* src, fp16* dst, size_t n) {
+  size_t i = 0;
+#if defined(TFRT_FP16_AVX512)
+  for (; i + 16 <= n; i += 16) {
+    __m256i half = _mm512_cvtps_ph(_mm512_loadu_ps(src + i),
+                                   _MM_FROUND_TO_NEAREST_INT);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), half);
+  }
+#elif defined(TFRT_FP16_AVX2)
+  for (; i + 8 <= n; i += 8) {
+    __m128i half =
+        _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), half);
+  }
+#elif defined(TFRT_FP16_NEON)
+  for (; i + 4 <= n; i += 4) {
+    float16x4_t half = vcvt_f16_f32(vld1q_f32(src + i));
+    vst1_u16(reinterpret_cast<uint16_t*>(dst + i), vreinterpret_u16_f16(half));
+  }
+#endif
+  for (; i < n; ++i) dst[i] = fp16(FloatToHalf(src[i]));
+}
+
+void ConvertBuffer(const fp16* src, float* dst, size_t n) {
+  size_t i = 0;
+#if defined(TFRT_FP16_AVX512)
+  for (; i + 16 <= n; i += 16) {
+    __m256i half =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(half));
+  }
+#elif defined(TFRT_FP16_AVX2)
+  for (; i + 8 <= n; i += 8) {
+    __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(half));
+  }
+#elif defined(TFRT_FP16_NEON)
+  for (; i + 4 <= n; i += 4) {
+    uint16x4_t half = vld1_u16(reinterpret_cast<const uint16_t*>(src + i));
+    vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(half)));
+  }
+#endif
+  for (; i < n; ++i) dst[i] = HalfToFloat(src[i].value);
+}
+
+}  // namespace tfrt
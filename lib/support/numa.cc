@@ -0,0 +1,125 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements NUMA topology discovery and placement helpers.
+
+#include "tfrt/support/numa.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace tfrt {
+namespace numa {
+namespace {
+
+// Parses a sysfs CPU list like "0-3,8-11". Returns false on malformed input.
+bool ParseCpuList(llvm::StringRef list, std::vector<int>* cpus) {
+  llvm::SmallVector<llvm::StringRef, 8> ranges;
+  list.trim().split(ranges, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (llvm::StringRef range : ranges) {
+    auto bounds = range.split('-');
+    int first, last;
+    if (bounds.first.getAsInteger(10, first)) return false;
+    if (bounds.second.empty()) {
+      last = first;
+    } else if (bounds.second.getAsInteger(10, last) || last < first) {
+      return false;
+    }
+    for (int cpu = first; cpu <= last; ++cpu) cpus->push_back(cpu);
+  }
+  return true;
+}
+
+std::vector<std::vector<int>> DiscoverNodeCpus() {
+  std::vector<std::vector<int>> nodes;
+
+#if defined(__linux__)
+  // Node numbers are dense on all practical systems, stop at the first gap.
+  for (int node = 0;; ++node) {
+    auto file = llvm::MemoryBuffer::getFileAsStream(
+        "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (!file) break;
+
+    std::vector<int> cpus;
+    if (!ParseCpuList((*file)->getBuffer(), &cpus)) break;
+    if (!cpus.empty()) nodes.push_back(std::move(cpus));
+  }
+#endif
+
+  // Fall back to a single node with all CPUs.
+  if (nodes.empty()) {
+    nodes.emplace_back();
+    int num_cpus = std::max(1u, std::thread::hardware_concurrency());
+    for (int cpu = 0; cpu < num_cpus; ++cpu) nodes.back().push_back(cpu);
+  }
+  return nodes;
+}
+
+thread_local int current_thread_node = -1;
+
+}  // namespace
+
+const std::vector<std::vector<int>>& GetNodeCpus() {
+  static const auto* node_cpus =
+      new std::vector<std::vector<int>>(DiscoverNodeCpus());
+  return *node_cpus;
+}
+
+bool PinCurrentThreadToCpus(llvm::ArrayRef<int> cpus) {
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &cpu_set);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) ==
+         0;
+#else
+  return false;
+#endif
+}
+
+int GetCurrentThreadNode() { return current_thread_node; }
+
+void SetCurrentThreadNode(int node) { current_thread_node = node; }
+
+bool BindMemoryToNode(void* ptr, size_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+  // Use the raw system call to avoid a dependency on libnuma. MPOL_PREFERRED
+  // falls back to other nodes when `node` runs out of memory.
+  constexpr int kMpolPreferred = 1;
+  constexpr int kMaxNodes = 8 * sizeof(unsigned long);
+  if (node < 0 || node >= kMaxNodes) return false;
+  unsigned long node_mask = 1ul << node;
+  return syscall(SYS_mbind, ptr, size, kMpolPreferred, &node_mask,
+                 kMaxNodes + 1, 0) == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace numa
+}  // namespace tfrt
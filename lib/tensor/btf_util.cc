@@ -16,13 +16,30 @@
 
 #include "tfrt/tensor/btf_util.h"
 
+#include <cstring>
 #include <iostream>
+#include <memory>
+
+#include "llvm/Support/FileSystem.h"
 
 namespace tfrt {
 namespace {
 
 constexpr size_t kBtfAlignment = 8;
 
+// Reads a T at `offset` of a mapped BTF-file. Returns false if the file is too
+// short.
+template <typename T>
+bool ReadBuffer(const HostBuffer& file, uint64_t offset, T* value,
+                size_t n = 1) {
+  if (offset > file.size() || (file.size() - offset) / sizeof(T) < n) {
+    return false;
+  }
+  std::memcpy(value, static_cast<const char*>(file.data()) + offset,
+              n * sizeof(T));
+  return true;
+}
+
 size_t Pad(size_t n) {
   const size_t remainder = n % kBtfAlignment;
   if (remainder == 0) return 0;
@@ -98,6 +115,93 @@ Expected<DenseHostTensor> ReadDHTFromBTF(std::istream* stream, uint64_t offset,
   return std::move(dht);
 }
 
+Expected<RCReference<HostBuffer>> MapBTFFile(const std::string& path) {
+  auto fd = llvm::sys::fs::openNativeFileForRead(path);
+  if (!fd) {
+    return MakeStringError("failed to open file ", path, ": ",
+                           llvm::toString(fd.takeError()));
+  }
+  llvm::sys::fs::file_status status;
+  std::error_code error = llvm::sys::fs::status(*fd, status);
+  if (error) {
+    llvm::sys::fs::closeFile(*fd);
+    return MakeStringError("failed to stat file ", path, ": ",
+                           error.message());
+  }
+  const size_t size = status.getSize();
+  if (size == 0) {
+    llvm::sys::fs::closeFile(*fd);
+    return MakeStringError("empty BTF file ", path);
+  }
+
+  // A private mapping, so that writes to the tensors do not modify the file.
+  auto region = std::make_unique<llvm::sys::fs::mapped_file_region>(
+      *fd, llvm::sys::fs::mapped_file_region::priv, size, /*offset=*/0, error);
+  // The mapping keeps the file alive, so the descriptor is not needed anymore.
+  llvm::sys::fs::closeFile(*fd);
+  if (error) {
+    return MakeStringError("failed to map file ", path, ": ", error.message());
+  }
+  void* data = region->data();
+  return HostBuffer::CreateFromExternal(
+      data, size,
+      [region = std::move(region)](void*, size_t) mutable { region.reset(); });
+}
+
+Expected<std::vector<uint64_t>> ReadBTFOffsets(const HostBuffer& file) {
+  uint64_t num_tensors;
+  if (!ReadBuffer(file, 0, &num_tensors)) {
+    return MakeStringError("failed to read num_tensors");
+  }
+  if (num_tensors > file.size() / sizeof(uint64_t)) {
+    return MakeStringError("failed to read tensor record offsets");
+  }
+  std::vector<uint64_t> offsets;
+  offsets.resize(num_tensors);
+  if (!ReadBuffer(file, sizeof(uint64_t), offsets.data(), num_tensors)) {
+    return MakeStringError("failed to read tensor record offsets");
+  }
+  return offsets;
+}
+
+Expected<DenseHostTensor> ReadDHTFromBTF(const RCReference<HostBuffer>& file,
+                                         uint64_t offset) {
+  btf::TensorHeader header;
+  if (!ReadBuffer(*file, offset, &header)) {
+    return MakeStringError("failed to read tensor header at offset ", offset);
+  }
+  if (header.layout != btf::TensorLayout::kRMD) {
+    return MakeStringError("unexpected tensor layout ", header.layout);
+  }
+  const uint64_t dims_offset = offset + sizeof(btf::TensorHeader);
+  if (header.rank > file->size() / sizeof(uint64_t)) {
+    return MakeStringError("failed to read tensor dims at offset ", offset);
+  }
+  llvm::SmallVector<Index, 4> dims;
+  dims.resize(header.rank);
+  if (!ReadBuffer(*file, dims_offset, dims.data(), header.rank)) {
+    return MakeStringError("failed to read tensor dims at offset ", offset);
+  }
+  const TensorMetadata metadata(DType(ToDTypeKind(header.dtype)),
+                                TensorShape(dims));
+
+  const uint64_t data_offset = dims_offset + header.rank * sizeof(uint64_t);
+  const size_t nbytes = metadata.GetHostSizeInBytes();
+  if (data_offset > file->size() || file->size() - data_offset < nbytes) {
+    return MakeStringError("failed to read tensor data at offset ", offset);
+  }
+  // The writer pads the records to kBtfAlignment, which only guarantees the
+  // alignment of the data if the file itself is mapped at an aligned address.
+  const auto* data = static_cast<const char*>(file->data()) + data_offset;
+  if (reinterpret_cast<uintptr_t>(data) % GetHostAlignment(metadata.dtype) !=
+      0) {
+    return MakeStringError("misaligned tensor data at offset ", offset);
+  }
+  return DenseHostTensor(
+      metadata, HostBuffer::CreateFromExternal(file.CopyRef(), data_offset,
+                                               nbytes));
+}
+
 Error WriteTensorsToBTF(std::ostream* stream, ArrayRef<const Tensor*> tensors) {
   const uint64_t num_tensors = tensors.size();
   if (!WriteStream(stream, &num_tensors, 1)) {
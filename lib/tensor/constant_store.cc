@@ -0,0 +1,162 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file implements ConstantStore.
+
+#include "tfrt/tensor/constant_store.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/hash_util.h"
+#include "tfrt/tensor/btf_util.h"
+
+namespace tfrt {
+namespace {
+
+uint64_t HashTensor(const TensorMetadata& metadata, const void* data) {
+  uint64_t hash = Hash64(static_cast<const char*>(data),
+                         metadata.GetHostSizeInBytes());
+  hash = Hash64Combine(hash, static_cast<uint64_t>(metadata.dtype));
+  for (int i = 0; i < metadata.shape.GetRank(); ++i)
+    hash = Hash64Combine(hash, metadata.shape.GetDimensionSize(i));
+  return hash;
+}
+
+// Allocates shared tensors, which outlive the HostContext that created them.
+HostAllocator* GetSharedAllocator() {
+  static HostAllocator* allocator = CreateMallocAllocator().release();
+  return allocator;
+}
+
+}  // namespace
+
+ConstantStore& ConstantStore::Global() {
+  static auto* store = new ConstantStore;
+  return *store;
+}
+
+Expected<DenseHostTensor> ConstantStore::GetOrCopy(const DenseView& view,
+                                                   HostContext* host) {
+  const TensorMetadata& metadata = view.metadata();
+  const size_t size = metadata.GetHostSizeInBytes();
+  const bool shared = size >= kMinSharedSizeInBytes;
+
+  if (shared) {
+    uint64_t hash = HashTensor(metadata, view.data());
+    mutex_lock lock(mutex_);
+    if (const Entry* entry = Find(hash, metadata, view.data()))
+      return DenseHostTensor(metadata, entry->buffer.CopyRef());
+  }
+
+  // Copy the tensor outside of the lock.
+  auto tensor = shared ? DenseHostTensor::CreateUninitialized(
+                             metadata, GetSharedAllocator())
+                       : DenseHostTensor::CreateUninitialized(metadata, host);
+  if (!tensor) return MakeStringError("error creating DenseHostTensor");
+  std::memcpy(tensor->data(), view.data(), size);
+  if (!shared) return std::move(*tensor);
+
+  return GetOrInsert(std::move(*tensor));
+}
+
+DenseHostTensor ConstantStore::GetOrInsert(DenseHostTensor tensor) {
+  if (tensor.DataSizeInBytes() < kMinSharedSizeInBytes) return tensor;
+  uint64_t hash = HashTensor(tensor.metadata(), tensor.data());
+
+  // Declared before the lock, so that pruned buffers are released after the
+  // lock is released.
+  std::vector<RCReference<HostBuffer>> pruned;
+  mutex_lock lock(mutex_);
+  if (const Entry* entry = Find(hash, tensor.metadata(), tensor.data()))
+    return DenseHostTensor(tensor.metadata(), entry->buffer.CopyRef());
+
+  entries_[hash].push_back({tensor.metadata(), tensor.buffer().CopyRef()});
+  if (++num_entries_ >= prune_size_) pruned = Prune();
+  return tensor;
+}
+
+Expected<RCReference<HostBuffer>> ConstantStore::MapBTFFile(
+    const std::string& path) {
+  {
+    mutex_lock lock(mutex_);
+    auto it = files_.find(path);
+    if (it != files_.end()) return it->second.CopyRef();
+  }
+
+  // Map the file outside of the lock.
+  auto file = ::tfrt::MapBTFFile(path);
+  if (!file) return file.takeError();
+
+  std::vector<RCReference<HostBuffer>> pruned;
+  mutex_lock lock(mutex_);
+  // If the file was mapped concurrently, keep the first mapping.
+  auto it = files_.try_emplace(path, std::move(*file)).first;
+  if (files_.size() >= prune_size_) pruned = Prune();
+  return it->second.CopyRef();
+}
+
+size_t ConstantStore::size() const {
+  mutex_lock lock(mutex_);
+  return num_entries_;
+}
+
+const ConstantStore::Entry* ConstantStore::Find(
+    uint64_t hash, const TensorMetadata& metadata, const void* data) const {
+  auto it = entries_.find(hash);
+  if (it == entries_.end()) return nullptr;
+  for (const Entry& entry : it->second) {
+    if (entry.metadata == metadata &&
+        std::memcmp(entry.buffer->data(), data,
+                    metadata.GetHostSizeInBytes()) == 0)
+      return &entry;
+  }
+  return nullptr;
+}
+
+std::vector<RCReference<HostBuffer>> ConstantStore::Prune() {
+  std::vector<RCReference<HostBuffer>> pruned;
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    auto& bucket = it->second;
+    for (Entry& entry : bucket) {
+      if (entry.buffer->IsUnique()) pruned.push_back(std::move(entry.buffer));
+    }
+    llvm::erase_if(bucket, [](const Entry& entry) { return !entry.buffer; });
+    if (bucket.empty()) entries_.erase(it);
+  }
+  num_entries_ = 0;
+  for (const auto& bucket : entries_) num_entries_ += bucket.second.size();
+
+  // Files are referenced by the tensors pointing into them, so a file is only
+  // pruned once all of its tensors have been pruned.
+  for (auto it = files_.begin(); it != files_.end();) {
+    auto current = it++;
+    if (!current->second->IsUnique()) continue;
+    pruned.push_back(std::move(current->second));
+    files_.erase(current);
+  }
+
+  prune_size_ = std::max<size_t>(
+      kMinPruneSize, 2 * std::max<size_t>(num_entries_, files_.size()));
+  return pruned;
+}
+
+}  // namespace tfrt
@@ -16,6 +16,9 @@
 
 #include "tfrt/tensor/coo_host_tensor.h"
 
+#include <algorithm>
+#include <array>
+
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include "tfrt/dtype/dtype_formatter.h"
@@ -31,25 +34,82 @@
 namespace tfrt {
 
 namespace {
+// Scatters the values into the zero-filled result. The strides are computed
+// once, so that the offset of each element is a dot product of its indices
+// and the strides. With a compile-time `Rank` the dot product is unrolled,
+// and the loop over the elements only loads contiguous indices and values.
+template <typename DType, size_t Rank>
+void ScatterValues(const int64_t *indices, const DType *values, Index nnz,
+                   const std::array<Index, Rank> &strides, DType *result) {
+  for (Index i = 0; i != nnz; ++i) {
+    const int64_t *element_indices = indices + i * Rank;
+    Index offset = 0;
+    for (size_t j = 0; j != Rank; ++j) {
+      offset += element_indices[j] * strides[j];
+    }
+    result[offset] = values[i];
+  }
+}
+
+template <typename DType>
+void ScatterValues(const int64_t *indices, const DType *values, Index nnz,
+                   ArrayRef<Index> strides, DType *result) {
+  const size_t rank = strides.size();
+  for (Index i = 0; i != nnz; ++i) {
+    const int64_t *element_indices = indices + i * rank;
+    Index offset = 0;
+    for (size_t j = 0; j != rank; ++j) {
+      offset += element_indices[j] * strides[j];
+    }
+    result[offset] = values[i];
+  }
+}
+
 template <typename DType>
 void ConvertToDHTTensorHelper(const DenseHostTensor &indices,
                               const DenseHostTensor &values,
                               DenseHostTensor *result_tensor) {
   auto result_tensor_view = MutableDHTArrayView<DType>(result_tensor);
-  const TensorMetadata &result_metadata = result_tensor->metadata();
-  const auto &result_shape = result_metadata.shape;
+  const auto &result_shape = result_tensor->metadata().shape;
   result_tensor_view.Fill(DType(0));
-  auto indices_view = DHTIndexableView<int64_t, 2>(&indices);
-  auto values_view = DHTIndexableView<DType, 1>(&values);
-  for (int i = 0, e = values_view.FixedShape().GetNumElements(); i != e; ++i) {
-    size_t offset = 0;
-    size_t stride = 1;
-    for (int j = result_shape.GetRank() - 1; j >= 0; --j) {
-      assert(indices_view.ElementAt(i, j) < result_shape.GetDimensionSize(j));
-      offset += stride * indices_view.ElementAt(i, j);
-      stride *= result_shape.GetDimensionSize(j);
+
+  const int rank = result_shape.GetRank();
+  llvm::SmallVector<Index, 4> strides(rank);
+  Index stride = 1;
+  for (int j = rank - 1; j >= 0; --j) {
+    strides[j] = stride;
+    stride *= result_shape.GetDimensionSize(j);
+  }
+
+  const auto *indices_data = static_cast<const int64_t *>(indices.data());
+  const auto *values_data = static_cast<const DType *>(values.data());
+  auto *result_data = result_tensor_view.data();
+  const Index nnz = values.NumElements();
+#ifndef NDEBUG
+  for (Index i = 0; i != nnz; ++i) {
+    for (int j = 0; j != rank; ++j) {
+      assert(indices_data[i * rank + j] < result_shape.GetDimensionSize(j));
     }
-    result_tensor_view[offset] = values_view.ElementAt(i);
+  }
+#endif
+
+  switch (rank) {
+#define SCATTER_VALUES_FOR_RANK(RANK)                                     \
+  case RANK: {                                                            \
+    std::array<Index, RANK> fixed_strides;                                \
+    std::copy(strides.begin(), strides.end(), fixed_strides.begin());     \
+    ScatterValues<DType, RANK>(indices_data, values_data, nnz,            \
+                               fixed_strides, result_data);               \
+    break;                                                                \
+  }
+    SCATTER_VALUES_FOR_RANK(1)
+    SCATTER_VALUES_FOR_RANK(2)
+    SCATTER_VALUES_FOR_RANK(3)
+    SCATTER_VALUES_FOR_RANK(4)
+#undef SCATTER_VALUES_FOR_RANK
+    default:
+      ScatterValues<DType>(indices_data, values_data, nnz, strides,
+                           result_data);
   }
 }
 }  // namespace
@@ -16,6 +16,8 @@
 
 #include "tfrt/host_context/kernel_utils.h"
 #include "tfrt/tensor/coo_host_tensor.h"
+#include "tfrt/tensor/csr_host_tensor.h"
+#include "tfrt/tensor/dense_host_tensor_view.h"
 #include "tfrt/tensor/dense_tensor_utils.h"
 
 namespace tfrt {
@@ -98,6 +100,78 @@ static void ConvertFromDHT(ArgumentView<MutableDHTIndexableView<T, Rank>> in,
   out_chain.Set(in_chain);
 }
 
+// Converts a rank-2 sparse tensor in COO layout to CSR layout.
+template <typename T>
+static void ConvertCooToCsr(Argument<CooHostTensor> in,
+                            Argument<Chain> in_chain, Result<CsrHostTensor> out,
+                            Result<Chain> out_chain, AsyncKernelFrame* frame) {
+  auto csr = AsyncValueRef<CsrHostTensor>(
+      ConvertTensorOnHost(frame->GetExecutionContext(), in.get(),
+                          CsrHostTensor::kTensorType)
+          .ReleaseRCRef());
+  out.Set(std::move(csr));
+  out_chain.Set(in_chain);
+}
+
+// Converts a sparse tensor in CSR layout to a DenseHostTensor.
+template <typename T>
+static void ConvertCsrToDHT(Argument<CsrHostTensor> in,
+                            Argument<Chain> in_chain,
+                            Result<DenseHostTensor> out,
+                            Result<Chain> out_chain, AsyncKernelFrame* frame) {
+  auto dht = AsyncValueRef<DenseHostTensor>(
+      ConvertTensorOnHost(frame->GetExecutionContext(), in.get(),
+                          DenseHostTensor::kTensorType)
+          .ReleaseRCRef());
+  out.Set(std::move(dht));
+  out_chain.Set(in_chain);
+}
+
+// Computes the product of a [M, K] CSR matrix and a [K, N] dense matrix.
+// Each row of the result is a sum of the rows of the dense matrix selected by
+// the non-zero elements of the sparse row, scaled by their values. Both the
+// rows of the dense matrix and the row of the result are contiguous, so the
+// inner loop vectorizes.
+template <typename T>
+static void CsrMatMul(Argument<CsrHostTensor> a,
+                      ArgumentView<DHTIndexableView<T, 2>> b,
+                      Argument<Chain> in_chain, Result<DenseHostTensor> out,
+                      Result<Chain> out_chain, KernelErrorHandler handler,
+                      AsyncKernelFrame* frame) {
+  const Index m = a->shape().GetDimensionSize(0);
+  const Index k = a->shape().GetDimensionSize(1);
+  const Index n = b->FixedShape()[1];
+  if (b->FixedShape()[0] != k) {
+    handler.ReportError("csr_matmul: inner dimensions do not match: ", k,
+                        " vs ", b->FixedShape()[0]);
+    return;
+  }
+  auto result = DenseHostTensor::CreateUninitialized<T>(
+      TensorShape({m, n}), frame->GetHostContext());
+  if (!result.has_value()) {
+    handler.ReportError("Cannot allocate result tensor");
+    return;
+  }
+
+  const auto* offsets = static_cast<const int64_t*>(a->RowOffsets()->data());
+  const auto* col_indices =
+      static_cast<const int64_t*>(a->ColIndices()->data());
+  const auto* values = static_cast<const T*>(a->Values()->data());
+  const T* b_data = b->data();
+  auto* result_data = static_cast<T*>(result->data());
+  for (Index row = 0; row != m; ++row) {
+    T* __restrict result_row = result_data + row * n;
+    std::fill(result_row, result_row + n, T(0));
+    for (int64_t i = offsets[row], e = offsets[row + 1]; i != e; ++i) {
+      const T value = values[i];
+      const T* __restrict b_row = b_data + col_indices[i] * n;
+      for (Index j = 0; j != n; ++j) result_row[j] += value * b_row[j];
+    }
+  }
+  out.Emplace(std::move(*result));
+  out_chain.Set(in_chain);
+}
+
 template <typename T, size_t Rank>
 void RegisterCooHostTensorKernelsForTypeAndRank(KernelRegistry* registry,
                                                 const std::string& t_name) {
@@ -117,6 +191,11 @@ void RegisterCooHostTensorKernelsForType(KernelRegistry* registry,
   RegisterCooHostTensorKernelsForTypeAndRank<T, 1>(registry, t_name);
   RegisterCooHostTensorKernelsForTypeAndRank<T, 2>(registry, t_name);
   RegisterCooHostTensorKernelsForTypeAndRank<T, 3>(registry, t_name);
+  registry->AddKernel("coo.convert_coo_to_csr." + t_name,
+                      TFRT_KERNEL(ConvertCooToCsr<T>));
+  registry->AddKernel("coo.convert_csr_to_dht." + t_name,
+                      TFRT_KERNEL(ConvertCsrToDHT<T>));
+  registry->AddKernel("coo.csr_matmul." + t_name, TFRT_KERNEL(CsrMatMul<T>));
 }
 
 void RegisterCooHostTensorKernels(KernelRegistry* registry) {
@@ -0,0 +1,182 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the CsrHostTensor class.
+
+#include "tfrt/tensor/csr_host_tensor.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/dtype/dtype_formatter.h"
+#include "tfrt/host_context/async_value_ref.h"
+#include "tfrt/host_context/device.h"
+#include "tfrt/host_context/execution_context.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/tensor/conversion_registry.h"
+#include "tfrt/tensor/conversion_utils.h"
+#include "tfrt/tensor/coo_host_tensor.h"
+#include "tfrt/tensor/dense_host_tensor_view.h"
+
+namespace tfrt {
+
+llvm::Optional<CsrHostTensor> CsrHostTensor::CreateFromCoo(
+    const CooHostTensor& coo, HostContext* host) {
+  assert(coo.shape().GetRank() == 2);
+  const Index rows = coo.shape().GetDimensionSize(0);
+  const Index nnz = coo.Values()->NumElements();
+  const size_t element_size = GetHostSize(coo.dtype());
+
+  auto row_offsets = DenseHostTensor::CreateUninitialized<int64_t>(
+      TensorShape(std::array<Index, 1>{rows + 1}), host);
+  auto col_indices = DenseHostTensor::CreateUninitialized<int64_t>(
+      TensorShape(std::array<Index, 1>{nnz}), host);
+  auto values = DenseHostTensor::CreateUninitialized(
+      TensorMetadata(coo.dtype(), std::array<Index, 1>{nnz}), host);
+  if (!row_offsets || !col_indices || !values) return llvm::None;
+
+  // Counting sort of the elements by row, which keeps the order of the
+  // elements of a row.
+  const auto* coo_indices = static_cast<const int64_t*>(coo.Indices()->data());
+  auto* offsets = static_cast<int64_t*>(row_offsets->data());
+  std::fill(offsets, offsets + rows + 1, 0);
+  for (Index i = 0; i != nnz; ++i) ++offsets[coo_indices[2 * i] + 1];
+  for (Index row = 0; row != rows; ++row) offsets[row + 1] += offsets[row];
+
+  llvm::SmallVector<int64_t, 16> next(offsets, offsets + rows);
+  auto* cols = static_cast<int64_t*>(col_indices->data());
+  const auto* coo_values = static_cast<const char*>(coo.Values()->data());
+  auto* csr_values = static_cast<char*>(values->data());
+  for (Index i = 0; i != nnz; ++i) {
+    const int64_t position = next[coo_indices[2 * i]]++;
+    cols[position] = coo_indices[2 * i + 1];
+    std::memcpy(csr_values + position * element_size,
+                coo_values + i * element_size, element_size);
+  }
+
+  // COO tensors are usually in row-major order already, in which case each
+  // row is sorted and this is a linear scan.
+  llvm::SmallVector<int64_t, 16> permutation;
+  llvm::SmallVector<char, 64> sorted_values;
+  for (Index row = 0; row != rows; ++row) {
+    int64_t begin = offsets[row], end = offsets[row + 1];
+    if (std::is_sorted(cols + begin, cols + end)) continue;
+    permutation.resize(end - begin);
+    for (int64_t i = 0; i != end - begin; ++i) permutation[i] = begin + i;
+    std::stable_sort(permutation.begin(), permutation.end(),
+                     [&](int64_t a, int64_t b) { return cols[a] < cols[b]; });
+    sorted_values.resize((end - begin) * element_size);
+    llvm::SmallVector<int64_t, 16> sorted_cols(end - begin);
+    for (int64_t i = 0; i != end - begin; ++i) {
+      sorted_cols[i] = cols[permutation[i]];
+      std::memcpy(&sorted_values[i * element_size],
+                  csr_values + permutation[i] * element_size, element_size);
+    }
+    std::copy(sorted_cols.begin(), sorted_cols.end(), cols + begin);
+    std::memcpy(csr_values + begin * element_size, sorted_values.data(),
+                sorted_values.size());
+  }
+
+  return CsrHostTensor(coo.shape(), coo.dtype(), std::move(*row_offsets),
+                       std::move(*col_indices), std::move(*values));
+}
+
+void CsrHostTensor::Print(raw_ostream& os) const {
+  os << "CsrHostTensor dtype = " << dtype() << ", shape = " << shape();
+  os << ", row_offsets = [";
+  llvm::interleaveComma(DHTArrayView<int64_t>(RowOffsets()).Elements(), os);
+  os << "], col_indices = [";
+  llvm::interleaveComma(DHTArrayView<int64_t>(ColIndices()).Elements(), os);
+  os << "], values = [";
+
+  auto element_size = GetHostSize(dtype());
+  auto* data_ptr = static_cast<const char*>(Values()->data());
+  for (Index i = 0, e = Values()->NumElements(); i != e; ++i) {
+    if (i != 0) os << ", ";
+    os << FormatDType(dtype(), data_ptr + i * element_size);
+  }
+  os << "]\n";
+}
+
+namespace {
+template <typename DType>
+void ConvertToDHTTensorHelper(const CsrHostTensor& csr,
+                              DenseHostTensor* result_tensor) {
+  auto result_view = MutableDHTArrayView<DType>(result_tensor);
+  result_view.Fill(DType(0));
+  const Index rows = csr.shape().GetDimensionSize(0);
+  const Index cols = csr.shape().GetDimensionSize(1);
+  const auto* offsets = static_cast<const int64_t*>(csr.RowOffsets()->data());
+  const auto* col_indices =
+      static_cast<const int64_t*>(csr.ColIndices()->data());
+  const auto* values = static_cast<const DType*>(csr.Values()->data());
+  DType* result = result_view.data();
+  for (Index row = 0; row != rows; ++row) {
+    DType* result_row = result + row * cols;
+    for (int64_t i = offsets[row], e = offsets[row + 1]; i != e; ++i) {
+      result_row[col_indices[i]] = values[i];
+    }
+  }
+}
+}  // namespace
+
+static AsyncValueRef<CsrHostTensor> ConvertCooHostTensorToCsrHostTensor(
+    const CooHostTensor& tensor, const CpuDevice& src, const CpuDevice& dst,
+    const ExecutionContext& exec_ctx) {
+  if (tensor.shape().GetRank() != 2) {
+    return MakeErrorAsyncValueRef(
+        "only rank-2 coo tensors can be converted to csr tensors");
+  }
+  auto result = CsrHostTensor::CreateFromCoo(tensor, exec_ctx.host());
+  if (!result) {
+    return MakeErrorAsyncValueRef(
+        "out of memory converting coo tensor to csr tensor");
+  }
+  return MakeAvailableAsyncValueRef<CsrHostTensor>(std::move(*result));
+}
+
+static AsyncValueRef<DenseHostTensor> ConvertCsrHostTensorToDenseHostTensor(
+    const CsrHostTensor& tensor, const CpuDevice& src, const CpuDevice& dst,
+    const ExecutionContext& exec_ctx) {
+  auto result_alloc =
+      DenseHostTensor::CreateUninitialized(tensor.metadata(), exec_ctx.host());
+  if (!result_alloc) {
+    return MakeErrorAsyncValueRef(
+        "out of memory converting csr tensor to dht tensor");
+  }
+  auto& result_tensor = result_alloc.getValue();
+
+  switch (tensor.dtype()) {
+    default:
+      llvm_unreachable("can't happen");
+#define DTYPE_NUMERIC(ENUM)                                                    \
+  case DType::ENUM:                                                            \
+    ConvertToDHTTensorHelper<TypeForDTypeKind<DType::ENUM>>(tensor,            \
+                                                            &result_tensor);   \
+    break;
+#include "tfrt/dtype/dtype.def"  // NOLINT
+  }
+  return MakeAvailableAsyncValueRef<DenseHostTensor>(std::move(result_tensor));
+}
+
+void RegisterCsrHostTensorConversionFn(TensorConversionFnRegistry* registry) {
+  registry->AddTensorConversionFn(
+      TFRT_CONVERSION(ConvertCooHostTensorToCsrHostTensor));
+  registry->AddTensorConversionFn(
+      TFRT_CONVERSION(ConvertCsrHostTensorToDenseHostTensor));
+}
+
+}  // namespace tfrt
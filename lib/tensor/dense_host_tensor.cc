@@ -43,10 +43,8 @@ llvm::Optional<DenseHostTensor> DenseHostTensor::CreateUninitialized(
     const TensorMetadata& metadata, HostAllocator* allocator) {
   size_t alignment =
       std::max(GetHostAlignment(metadata.dtype), kTensorBufferAlignment);
-  auto& shape = metadata.shape;
-  auto data = HostBuffer::CreateUninitialized(
-      GetHostSize(metadata.dtype) * shape.GetNumElements(), alignment,
-      allocator);
+  auto data = HostBuffer::CreateUninitialized(metadata.GetHostSizeInBytes(),
+                                              alignment, allocator);
   if (!data) return llvm::None;
   return DenseHostTensor(metadata, std::move(data));
 }
@@ -77,7 +75,13 @@ void DenseHostTensor::Print(raw_ostream& os) const {
   os << ", values = [";
   for (Index i = 0, e = std::min(kThreshold, NumElements()); i != e; ++i) {
     if (i != 0) os << ", ";
-    os << FormatDType(dtype(), data_ptr + i * element_size);
+    if (dtype() == DType::I4) {
+      os << GetPackedInt4<int4>(data_ptr, i);
+    } else if (dtype() == DType::UI4) {
+      os << GetPackedInt4<uint4>(data_ptr, i);
+    } else {
+      os << FormatDType(dtype(), data_ptr + i * element_size);
+    }
   }
   if (NumElements() > kThreshold) {
     os << ", ... ";
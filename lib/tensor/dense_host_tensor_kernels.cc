@@ -17,6 +17,7 @@
 #include "tfrt/tensor/dense_host_tensor_kernels.h"
 
 #include <algorithm>
+#include <cmath>
 #include <complex>
 
 #include "llvm/ADT/STLExtras.h"
@@ -279,6 +280,147 @@ static void PrintBuffer(Argument<RCReference<HostBuffer>> buffer,
   chain_out.Set(chain_in);
 }
 
+// Encodes and decodes the values of the low-precision dtypes. A real value x
+// is stored as Encode(x / scale + zero_point), so that it is approximately
+// (Decode(stored) - zero_point) * scale.
+template <typename T>
+struct LowPrecisionCodec;
+
+template <bool Signed>
+struct LowPrecisionCodec<Int4<Signed>> {
+  using T = Int4<Signed>;
+  static void Store(void* data, Index index, float value) {
+    float rounded = std::nearbyint(value);
+    rounded = std::min<float>(std::max<float>(rounded, T::kMin), T::kMax);
+    SetPackedInt4(data, index,
+                  T(static_cast<typename T::UnderlyingT>(rounded)));
+  }
+  static float Load(const void* data, Index index) {
+    return GetPackedInt4<T>(data, index).value;
+  }
+};
+
+template <typename T>
+struct Fp8Codec {
+  static void Store(void* data, Index index, float value) {
+    static_cast<T*>(data)[index] = T::FromFloat(value);
+  }
+  static float Load(const void* data, Index index) {
+    return static_cast<const T*>(data)[index].ToFloat();
+  }
+};
+
+template <>
+struct LowPrecisionCodec<f8e4m3fn> : Fp8Codec<f8e4m3fn> {};
+template <>
+struct LowPrecisionCodec<f8e5m2> : Fp8Codec<f8e5m2> {};
+
+static Error CheckDType(const DenseHostTensor& tensor, DType expected) {
+  if (tensor.dtype() == expected) return Error::success();
+  return MakeStringError("expected a ", expected, " tensor, got ",
+                         tensor.dtype());
+}
+
+// Quantizes a f32 tensor to the low-precision dtype of T.
+template <typename T>
+static void QuantizeTensor(Argument<DenseHostTensor> in,
+                           Argument<Chain> chain_in,
+                           Result<DenseHostTensor> out,
+                           Result<Chain> chain_out, Attribute<float> scale,
+                           Attribute<int32_t> zero_point,
+                           KernelErrorHandler handler,
+                           const ExecutionContext& exec_ctx) {
+  if (auto error = CheckDType(*in, DType::F32)) {
+    handler.ReportError(toString(std::move(error)));
+    return;
+  }
+  auto result = DenseHostTensor::CreateUninitialized(
+      TensorMetadata(GetDType<T>(), in->shape()), exec_ctx.host());
+  if (!result) {
+    handler.ReportError("Cannot allocate tensor");
+    return;
+  }
+  // Zero the padding nibble of an odd number of packed values.
+  std::fill_n(static_cast<char*>(result->data()), result->DataSizeInBytes(), 0);
+  const auto* values = static_cast<const float*>(in->data());
+  const float inverse_scale = 1.0f / *scale;
+  for (Index i = 0, e = in->NumElements(); i != e; ++i) {
+    LowPrecisionCodec<T>::Store(result->data(), i,
+                                values[i] * inverse_scale + *zero_point);
+  }
+  out.Emplace(std::move(*result));
+  chain_out.Set(chain_in);
+}
+
+// Dequantizes a tensor of the low-precision dtype of T to f32.
+template <typename T>
+static void DequantizeTensor(Argument<DenseHostTensor> in,
+                             Argument<Chain> chain_in,
+                             Result<DenseHostTensor> out,
+                             Result<Chain> chain_out, Attribute<float> scale,
+                             Attribute<int32_t> zero_point,
+                             KernelErrorHandler handler,
+                             const ExecutionContext& exec_ctx) {
+  if (auto error = CheckDType(*in, GetDType<T>())) {
+    handler.ReportError(toString(std::move(error)));
+    return;
+  }
+  auto result = DenseHostTensor::CreateUninitialized<float>(in->shape(),
+                                                            exec_ctx.host());
+  if (!result) {
+    handler.ReportError("Cannot allocate tensor");
+    return;
+  }
+  auto* values = static_cast<float*>(result->data());
+  for (Index i = 0, e = in->NumElements(); i != e; ++i) {
+    values[i] = (LowPrecisionCodec<T>::Load(in->data(), i) - *zero_point) *
+                *scale;
+  }
+  out.Emplace(std::move(*result));
+  chain_out.Set(chain_in);
+}
+
+// Converts a tensor of the low-precision dtype of T to new quantization
+// parameters without materializing a f32 tensor.
+template <typename T>
+static void RequantizeTensor(
+    Argument<DenseHostTensor> in, Argument<Chain> chain_in,
+    Result<DenseHostTensor> out, Result<Chain> chain_out,
+    Attribute<float> in_scale, Attribute<int32_t> in_zero_point,
+    Attribute<float> out_scale, Attribute<int32_t> out_zero_point,
+    KernelErrorHandler handler, const ExecutionContext& exec_ctx) {
+  if (auto error = CheckDType(*in, GetDType<T>())) {
+    handler.ReportError(toString(std::move(error)));
+    return;
+  }
+  auto result =
+      DenseHostTensor::CreateUninitialized(in->metadata(), exec_ctx.host());
+  if (!result) {
+    handler.ReportError("Cannot allocate tensor");
+    return;
+  }
+  std::fill_n(static_cast<char*>(result->data()), result->DataSizeInBytes(), 0);
+  const float ratio = *in_scale / *out_scale;
+  for (Index i = 0, e = in->NumElements(); i != e; ++i) {
+    float value = LowPrecisionCodec<T>::Load(in->data(), i) - *in_zero_point;
+    LowPrecisionCodec<T>::Store(result->data(), i,
+                                value * ratio + *out_zero_point);
+  }
+  out.Emplace(std::move(*result));
+  chain_out.Set(chain_in);
+}
+
+template <typename T>
+static void RegisterLowPrecisionKernelsForType(KernelRegistry* registry,
+                                               const std::string& t_name) {
+  registry->AddKernel("tfrt_dht.quantize." + t_name,
+                      TFRT_KERNEL(QuantizeTensor<T>));
+  registry->AddKernel("tfrt_dht.dequantize." + t_name,
+                      TFRT_KERNEL(DequantizeTensor<T>));
+  registry->AddKernel("tfrt_dht.requantize." + t_name,
+                      TFRT_KERNEL(RequantizeTensor<T>));
+}
+
 template <typename T, size_t Rank>
 static void RegisterDhtCreationKernelsForTypeAndRank(
     KernelRegistry* registry, const std::string& t_name) {
@@ -365,6 +507,10 @@ void RegisterDenseHostTensorKernels(KernelRegistry* registry) {
   // depend on TF due to b/161569340.
   RegisterDhtCreationKernelsForType<fp16>(registry, "f16");
   RegisterDhtCreationKernelsForType<bf16>(registry, "bf16");
+  RegisterLowPrecisionKernelsForType<int4>(registry, "i4");
+  RegisterLowPrecisionKernelsForType<uint4>(registry, "u4");
+  RegisterLowPrecisionKernelsForType<f8e4m3fn>(registry, "f8e4m3fn");
+  RegisterLowPrecisionKernelsForType<f8e5m2>(registry, "f8e5m2");
 
   registry->AddKernel("tfrt_dht.allocate_buffer", TFRT_KERNEL(AllocateBuffer));
   registry->AddSyncKernel("tfrt_dht_sync.allocate_buffer",
@@ -0,0 +1,90 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements class StridedDenseView.
+
+#include "tfrt/tensor/dense_view.h"
+
+namespace tfrt {
+
+StridedDenseView::StridedDenseView(const DenseView& dense_view)
+    : metadata_(dense_view.metadata()), data_(dense_view.data()) {
+  dense_view.shape().GetStrides(&strides_);
+}
+
+StridedDenseView::StridedDenseView(DType dtype, ArrayRef<Index> shape,
+                                   ArrayRef<Index> strides, const void* data)
+    : metadata_(dtype, shape),
+      strides_(strides.begin(), strides.end()),
+      data_(data) {
+  assert(shape.size() == strides.size());
+}
+
+bool StridedDenseView::IsContiguous() const {
+  Index expected_stride = 1;
+  for (int i = shape().GetRank() - 1; i >= 0; --i) {
+    Index dim = shape().GetDimensionSize(i);
+    // The stride of a dimension of size 1 does not matter.
+    if (dim != 1 && strides_[i] != expected_stride) return false;
+    expected_stride *= dim;
+  }
+  return true;
+}
+
+StridedDenseView StridedDenseView::Slice(ArrayRef<Index> begin,
+                                         ArrayRef<Index> sizes) const {
+  assert(begin.size() == strides_.size());
+  assert(sizes.size() == strides_.size());
+  Index offset = 0;
+  for (size_t i = 0; i < begin.size(); ++i) {
+    assert(begin[i] >= 0 && sizes[i] >= 0);
+    assert(begin[i] + sizes[i] <= shape().GetDimensionSize(i));
+    offset += begin[i] * strides_[i];
+  }
+  const char* data =
+      static_cast<const char*>(data_) + offset * GetHostSize(dtype());
+  return StridedDenseView(dtype(), sizes, strides_, data);
+}
+
+StridedDenseView StridedDenseView::Transpose(ArrayRef<int> perm) const {
+  assert(perm.size() == strides_.size());
+  llvm::SmallVector<Index, 4> shape, strides;
+  for (int dim : perm) {
+    shape.push_back(this->shape().GetDimensionSize(dim));
+    strides.push_back(strides_[dim]);
+  }
+  return StridedDenseView(dtype(), shape, strides, data_);
+}
+
+llvm::Optional<StridedDenseView> StridedDenseView::BroadcastTo(
+    const TensorShape& shape) const {
+  const int rank = shape.GetRank();
+  const int offset = rank - this->shape().GetRank();
+  if (offset < 0) return llvm::None;
+
+  llvm::SmallVector<Index, 4> dims, strides;
+  shape.GetDimensions(&dims);
+  strides.resize(rank, 0);
+  for (int i = offset; i < rank; ++i) {
+    Index dim = this->shape().GetDimensionSize(i - offset);
+    if (dim == dims[i]) {
+      strides[i] = strides_[i - offset];
+    } else if (dim != 1) {
+      return llvm::None;
+    }
+  }
+  return StridedDenseView(dtype(), dims, strides, data_);
+}
+
+}  // namespace tfrt
@@ -0,0 +1,136 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements PackedStringHostTensor.
+
+#include "tfrt/tensor/packed_string_host_tensor.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/host_context/host_context.h"
+#include "tfrt/tensor/conversion_registry.h"
+#include "tfrt/tensor/conversion_utils.h"
+#include "tfrt/tensor/string_host_tensor.h"
+#include "tfrt/tensor/tensor_metadata.h"
+
+namespace tfrt {
+
+template <typename StringT>
+static llvm::Optional<PackedStringHostTensor> CreatePacked(
+    const TensorShape& shape, ArrayRef<StringT> strings, HostContext* host) {
+  assert(strings.size() == shape.GetNumElements());
+  auto offsets = HostBuffer::CreateUninitialized(
+      (strings.size() + 1) * sizeof(uint64_t), alignof(uint64_t),
+      host->allocator());
+  if (!offsets) return llvm::None;
+
+  auto* offsets_data = static_cast<uint64_t*>(offsets->data());
+  uint64_t size = 0;
+  offsets_data[0] = 0;
+  for (size_t i = 0; i < strings.size(); ++i) {
+    size += strings[i].size();
+    offsets_data[i + 1] = size;
+  }
+
+  RCReference<HostBuffer> chars;
+  if (size > 0) {
+    chars = HostBuffer::CreateUninitialized(size, alignof(char),
+                                            host->allocator());
+    if (!chars) return llvm::None;
+    auto* chars_data = static_cast<char*>(chars->data());
+    for (size_t i = 0; i < strings.size(); ++i) {
+      std::memcpy(chars_data + offsets_data[i], strings[i].data(),
+                  strings[i].size());
+    }
+  }
+  return PackedStringHostTensor(shape, std::move(chars), std::move(offsets));
+}
+
+llvm::Optional<PackedStringHostTensor> PackedStringHostTensor::Create(
+    const TensorShape& shape, ArrayRef<string_view> strings,
+    HostContext* host) {
+  return CreatePacked(shape, strings, host);
+}
+
+llvm::Optional<PackedStringHostTensor> PackedStringHostTensor::Create(
+    const StringHostTensor& tensor, HostContext* host) {
+  return CreatePacked(tensor.shape(), tensor.strings(), host);
+}
+
+void PackedStringHostTensor::Print(raw_ostream& os) const {
+  os << "PackedStringHostTensor shape = " << shape();
+
+  static constexpr size_t kThreshold = 16;
+
+  os << ", values = [";
+  // Print at most kThreshold elements for a tensor.
+  for (size_t i = 0, e = std::min<size_t>(kThreshold, NumElements()); i != e;
+       ++i) {
+    if (i != 0) os << ", ";
+    os << '"' << (*this)[i] << '"';
+  }
+
+  if (NumElements() > kThreshold) {
+    os << ", ... ";
+  }
+
+  os << ']';
+}
+
+static AsyncValueRef<PackedStringHostTensor>
+ConvertPackedStringHostTensorToPackedStringHostTensor(
+    const PackedStringHostTensor& tensor, const CpuDevice& src,
+    const CpuDevice& dst, const ExecutionContext& exec_ctx) {
+  // The buffers are immutable, so the result can share them.
+  return MakeAvailableAsyncValueRef<PackedStringHostTensor>(tensor.CopyRef());
+}
+
+static AsyncValueRef<StringHostTensor>
+ConvertPackedStringHostTensorToStringHostTensor(
+    const PackedStringHostTensor& tensor, const CpuDevice& src,
+    const CpuDevice& dst, const ExecutionContext& exec_ctx) {
+  auto result =
+      StringHostTensor::CreateUninitialized(tensor.metadata(), exec_ctx.host());
+  if (!result) return MakeErrorAsyncValueRef("out of memory copying tensor");
+
+  auto strings = result->strings();
+  for (size_t i = 0, e = strings.size(); i != e; ++i) {
+    strings[i] = std::string(tensor[i]);
+  }
+  return MakeAvailableAsyncValueRef<StringHostTensor>(std::move(*result));
+}
+
+static AsyncValueRef<PackedStringHostTensor>
+ConvertStringHostTensorToPackedStringHostTensor(
+    const StringHostTensor& tensor, const CpuDevice& src, const CpuDevice& dst,
+    const ExecutionContext& exec_ctx) {
+  auto result = PackedStringHostTensor::Create(tensor, exec_ctx.host());
+  if (!result) return MakeErrorAsyncValueRef("out of memory copying tensor");
+  return MakeAvailableAsyncValueRef<PackedStringHostTensor>(
+      std::move(*result));
+}
+
+void RegisterPackedStringHostTensorConversionFn(
+    TensorConversionFnRegistry* registry) {
+  registry->AddTensorConversionFn(TFRT_CONVERSION(
+      ConvertPackedStringHostTensorToPackedStringHostTensor));
+  registry->AddTensorConversionFn(
+      TFRT_CONVERSION(ConvertPackedStringHostTensorToStringHostTensor));
+  registry->AddTensorConversionFn(
+      TFRT_CONVERSION(ConvertStringHostTensorToPackedStringHostTensor));
+}
+
+}  // namespace tfrt
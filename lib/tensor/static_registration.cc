@@ -19,8 +19,10 @@
 #include "tfrt/host_context/kernel_registry.h"
 #include "tfrt/tensor/conversion_registry.h"
 #include "tfrt/tensor/coo_host_tensor.h"
+#include "tfrt/tensor/csr_host_tensor.h"
 #include "tfrt/tensor/dense_host_tensor.h"
 #include "tfrt/tensor/dense_host_tensor_kernels.h"
+#include "tfrt/tensor/packed_string_host_tensor.h"
 #include "tfrt/tensor/scalar_host_tensor.h"
 #include "tfrt/tensor/string_host_tensor.h"
 #include "tfrt/tensor/string_host_tensor_kernels.h"
@@ -41,8 +43,10 @@ TFRT_STATIC_KERNEL_REGISTRATION(Register);
 // TODO(fishx): Create a macro for this registration.
 static bool host_conversion_fn_registration = []() {
   AddStaticTensorConversionFn(RegisterCooHostTensorConversionFn);
+  AddStaticTensorConversionFn(RegisterCsrHostTensorConversionFn);
   AddStaticTensorConversionFn(RegisterDenseHostTensorConversionFn);
   AddStaticTensorConversionFn(RegisterStringHostTensorConversionFn);
+  AddStaticTensorConversionFn(RegisterPackedStringHostTensorConversionFn);
   AddStaticTensorConversionFn(RegisterScalarHostTensorConversionFn);
   return true;
 }();
@@ -16,9 +16,17 @@
 
 #include "tfrt/tensor/string_host_tensor_kernels.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <tuple>
+#include <vector>
+
 #include "tfrt/host_context/kernel_utils.h"
 #include "tfrt/host_context/sync_kernel_utils.h"
 #include "tfrt/support/error_util.h"
+#include "tfrt/support/hash_util.h"
+#include "tfrt/tensor/dense_host_tensor.h"
 #include "tfrt/tensor/string_host_tensor.h"
 
 namespace tfrt {
@@ -54,6 +62,130 @@ static Expected<StringHostTensor> CreateUninitializedStringTensor(
   return std::move(*result);
 }
 
+// Converts the ASCII letters of the strings to lower case.
+static Expected<StringHostTensor> StringLower(
+    const StringHostTensor& input, const ExecutionContext& exec_ctx) {
+  auto result =
+      StringHostTensor::CreateUninitialized(input.metadata(), exec_ctx.host());
+  if (!result) return MakeStringError("Cannot allocate tensor");
+
+  auto strings = result->strings();
+  for (size_t i = 0; i < strings.size(); ++i) {
+    const std::string& in = input.strings()[i];
+    std::string& out = strings[i];
+    out.resize(in.size());
+    // Branch-free, so that the compiler vectorizes the loop.
+    for (size_t j = 0; j < in.size(); ++j) {
+      auto c = static_cast<unsigned char>(in[j]);
+      out[j] = static_cast<char>(c + ((c - 'A' < 26u) << 5));
+    }
+  }
+  return std::move(*result);
+}
+
+// Joins the strings along the innermost dimension with `separator`.
+static Expected<StringHostTensor> StringJoin(const StringHostTensor& input,
+                                             StringAttribute separator,
+                                             const ExecutionContext& exec_ctx) {
+  const TensorShape& shape = input.shape();
+  if (shape.GetRank() == 0)
+    return MakeStringError("Cannot join the strings of a scalar tensor");
+
+  llvm::SmallVector<Index, 4> dims;
+  shape.GetDimensions(&dims);
+  Index row_size = dims.back();
+  dims.pop_back();
+  auto result = StringHostTensor::CreateUninitialized(TensorShape(dims),
+                                                      exec_ctx.host());
+  if (!result) return MakeStringError("Cannot allocate tensor");
+
+  string_view sep = separator.get();
+  ArrayRef<std::string> strings = input.strings();
+  auto joined = result->strings();
+  for (size_t row = 0; row < joined.size(); ++row) {
+    auto row_strings = strings.slice(row * row_size, row_size);
+    size_t size = row_size > 0 ? (row_size - 1) * sep.size() : 0;
+    for (const auto& str : row_strings) size += str.size();
+    std::string& out = joined[row];
+    out.clear();
+    out.reserve(size);
+    for (size_t i = 0; i < row_strings.size(); ++i) {
+      if (i > 0) out.append(sep.data(), sep.size());
+      out.append(row_strings[i]);
+    }
+  }
+  return std::move(*result);
+}
+
+// Splits each string at the characters in `delimiter`, skipping empty tokens.
+// Returns the tokens of all strings as a 1-D tensor, and the i64 row splits:
+// the tokens of string `i` are the tokens `row_splits[i]` to
+// `row_splits[i + 1]`.
+static Expected<std::tuple<StringHostTensor, DenseHostTensor>> StringSplit(
+    const StringHostTensor& input, StringAttribute delimiter,
+    const ExecutionContext& exec_ctx) {
+  string_view delim = delimiter.get();
+  if (delim.empty()) return MakeStringError("Delimiter must not be empty");
+
+  ArrayRef<std::string> strings = input.strings();
+  Index num_splits = strings.size() + 1;
+  auto row_splits = DenseHostTensor::CreateUninitialized<int64_t>(
+      TensorShape(ArrayRef<Index>(num_splits)), exec_ctx.host());
+  if (!row_splits) return MakeStringError("Cannot allocate tensor");
+  int64_t* splits = row_splits->data<int64_t>();
+
+  std::array<bool, 256> is_delimiter = {};
+  for (char c : delim) is_delimiter[static_cast<unsigned char>(c)] = true;
+
+  std::vector<string_view> tokens;
+  splits[0] = 0;
+  for (size_t i = 0; i < strings.size(); ++i) {
+    const char* begin = strings[i].data();
+    const char* end = begin + strings[i].size();
+    while (begin != end) {
+      // A single delimiter is searched with memchr, which is vectorized.
+      const char* pos =
+          delim.size() == 1
+              ? static_cast<const char*>(memchr(begin, delim[0], end - begin))
+              : std::find_if(begin, end, [&](char c) {
+                  return is_delimiter[static_cast<unsigned char>(c)];
+                });
+      if (!pos) pos = end;
+      if (pos != begin) tokens.emplace_back(begin, pos - begin);
+      begin = pos == end ? end : pos + 1;
+    }
+    splits[i + 1] = tokens.size();
+  }
+
+  Index num_tokens = tokens.size();
+  auto values = StringHostTensor::CreateUninitialized(
+      TensorShape(ArrayRef<Index>(num_tokens)), exec_ctx.host());
+  if (!values) return MakeStringError("Cannot allocate tensor");
+  auto token_strings = values->strings();
+  for (size_t i = 0; i < tokens.size(); ++i)
+    token_strings[i].assign(tokens[i].data(), tokens[i].size());
+
+  return std::make_tuple(std::move(*values), std::move(*row_splits));
+}
+
+// Hashes the strings into `num_buckets` buckets with Hash64.
+static Expected<DenseHostTensor> StringToHashBucketFast(
+    const StringHostTensor& input, Attribute<int64_t> num_buckets,
+    const ExecutionContext& exec_ctx) {
+  if (*num_buckets <= 0)
+    return MakeStringError("num_buckets must be positive, got ", *num_buckets);
+  auto result = DenseHostTensor::CreateUninitialized<int64_t>(input.shape(),
+                                                              exec_ctx.host());
+  if (!result) return MakeStringError("Cannot allocate tensor");
+
+  uint64_t buckets = *num_buckets;
+  int64_t* data = result->data<int64_t>();
+  ArrayRef<std::string> strings = input.strings();
+  for (size_t i = 0; i < strings.size(); ++i)
+    data[i] = Hash64(strings[i]) % buckets;
+  return std::move(*result);
+}
+
 }  // namespace
 
 void RegisterStringHostTensorKernels(KernelRegistry* registry) {
@@ -63,6 +195,17 @@ void RegisterStringHostTensorKernels(KernelRegistry* registry) {
                           TFRT_SYNC_KERNEL(CreateStringTensor));
   registry->AddSyncKernel("tfrt_sht_sync.create_uninitialized_tensor",
                           TFRT_SYNC_KERNEL(CreateUninitializedStringTensor));
+
+  registry->AddKernel("tfrt_sht.lower", TFRT_KERNEL(StringLower));
+  registry->AddKernel("tfrt_sht.join", TFRT_KERNEL(StringJoin));
+  registry->AddKernel("tfrt_sht.split", TFRT_KERNEL(StringSplit));
+  registry->AddKernel("tfrt_sht.to_hash_bucket_fast",
+                      TFRT_KERNEL(StringToHashBucketFast));
+  registry->AddSyncKernel("tfrt_sht_sync.lower", TFRT_SYNC_KERNEL(StringLower));
+  registry->AddSyncKernel("tfrt_sht_sync.join", TFRT_SYNC_KERNEL(StringJoin));
+  registry->AddSyncKernel("tfrt_sht_sync.split", TFRT_SYNC_KERNEL(StringSplit));
+  registry->AddSyncKernel("tfrt_sht_sync.to_hash_bucket_fast",
+                          TFRT_SYNC_KERNEL(StringToHashBucketFast));
 }
 
 }  // namespace tfrt
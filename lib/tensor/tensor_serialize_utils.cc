@@ -103,6 +103,9 @@ std::string SerializeTensorMetadata(const TensorMetadata& md) {
 llvm::Expected<TensorMetadata> DeserializeTensorMetadataInternal(
     const char* pos, size_t size) {
   ASSERT_LITTLE_ENDIAN();
+  if (size < sizeof(uint64_t) || size % sizeof(uint64_t) != 0) {
+    return MakeStringError("invalid serialized tensor metadata size ", size);
+  }
   DType kind = static_cast<DType>(*reinterpret_cast<const uint64_t*>(pos));
   pos += sizeof(uint64_t);
   const int num_dimensions = size / 8 - 1;
@@ -148,11 +151,39 @@ SerializeDenseHostTensor(const DenseHostTensor& dht, HostContext* host) {
 llvm::Expected<DenseHostTensor> DeserializeDenseHostTensor(
     const llvm::SmallVector<RCReference<HostBuffer>, 4>& serialized,
     HostContext* host) {
-  TensorMetadata md =
-      DeserializeTensorMetadataInternal(
-          static_cast<char*>(serialized[0]->data()), serialized[0]->size())
-          .get();
-  auto dht = DenseHostTensor(md, serialized[1]);
-  return std::move(dht);
+  if (serialized.size() != 2) {
+    return MakeStringError("expected 2 buffers for a DenseHostTensor, got ",
+                           serialized.size());
+  }
+  return DeserializeDenseHostTensor(
+      string_view(static_cast<const char*>(serialized[0]->data()),
+                  serialized[0]->size()),
+      serialized[1]);
+}
+
+llvm::Expected<DenseHostTensor> DeserializeDenseHostTensor(
+    string_view serialized_metadata, RCReference<HostBuffer> data) {
+  auto md = DeserializeTensorMetadata(serialized_metadata);
+  if (!md) return md.takeError();
+  if (!data || data->size() != md->GetHostSizeInBytes()) {
+    return MakeStringError("expected ", md->GetHostSizeInBytes(),
+                           " bytes of DenseHostTensor data, got ",
+                           data ? data->size() : 0);
+  }
+  if (reinterpret_cast<uintptr_t>(data->data()) %
+          GetHostAlignment(md->dtype) !=
+      0) {
+    return MakeStringError("misaligned DenseHostTensor data");
+  }
+  return DenseHostTensor(*md, std::move(data));
+}
+
+llvm::Expected<RCReference<HostBuffer>> AllocateDenseHostTensorData(
+    string_view serialized_metadata, HostContext* host) {
+  auto md = DeserializeTensorMetadata(serialized_metadata);
+  if (!md) return md.takeError();
+  auto dht = DenseHostTensor::CreateUninitialized(*md, host);
+  if (!dht) return MakeStringError("cannot allocate DenseHostTensor data");
+  return dht->ReleaseBuffer();
 }
 }  // namespace tfrt
@@ -103,9 +103,7 @@ Index TensorShape::GetNumElements() const {
       }
 
     case RepKind::kRepExternal:
-      for (size_t i = 0, e = GetRank(); i != e; ++i)
-        result *= representation_.rep_external.dims[i];
-      return result;
+      return representation_.rep_external.dims[GetRank()];
   }
 }
 
@@ -14,9 +14,16 @@
 
 // This file implements ops for benchmarking BEFExecutor
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cstdint>
 #include <ctime>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "llvm/ADT/FunctionExtras.h"
 #include "llvm/Support/raw_ostream.h"
@@ -29,8 +36,11 @@
 #include "tfrt/host_context/host_context.h"
 #include "tfrt/host_context/kernel_utils.h"
 #include "tfrt/host_context/sync_kernel_utils.h"
+#include "tfrt/host_context/task_function.h"
 #include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
 #include "tfrt/support/ref_count.h"
+#include "tfrt/support/thread_annotations.h"
 #include "tfrt/test_kernels.h"
 
 namespace tfrt {
@@ -218,6 +228,204 @@ class AsyncBenchmarkRunner {
   // Clean up function to run after the end of the benchmark.
   llvm::unique_function<void()> clean_up_;
 };
+
+// Latencies of the executions of a load test.
+struct LatencyStats {
+  void Append(const LatencyStats& other) {
+    latencies.insert(latencies.end(), other.latencies.begin(),
+                     other.latencies.end());
+    num_errors += other.num_errors;
+  }
+
+  // Prints the stats of the executions that completed within `elapsed`.
+  void Summarize(string_view name, int target_qps,
+                 std::chrono::nanoseconds elapsed) {
+    if (latencies.empty()) return;
+    std::sort(latencies.begin(), latencies.end());
+
+    auto percentile = [&](double p) {
+      size_t index = std::min(static_cast<size_t>(latencies.size() * p),
+                              latencies.size() - 1);
+      return std::chrono::duration_cast<std::chrono::microseconds>(
+                 latencies[index])
+          .count();
+    };
+    double seconds = std::chrono::duration<double>(elapsed).count();
+
+    // BM: prefix is added to make grepping results from lit output easier.
+    std::string prefix;
+    llvm::raw_string_ostream(prefix) << "BM:" << name << ':';
+
+    tfrt::outs() << prefix << "Target QPS: " << target_qps << '\n';
+    tfrt::outs() << prefix << "Achieved QPS: "
+                 << static_cast<int64_t>(latencies.size() / seconds) << '\n';
+    tfrt::outs() << prefix << "Count: " << latencies.size() << '\n';
+    tfrt::outs() << prefix << "Errors: " << num_errors << '\n';
+    tfrt::outs() << prefix << "Latency 50%(us): " << percentile(0.5) << '\n';
+    tfrt::outs() << prefix << "Latency 99%(us): " << percentile(0.99) << '\n';
+    tfrt::outs() << prefix << "Latency 99.9%(us): " << percentile(0.999)
+                 << '\n';
+    tfrt::outs() << prefix << "Latency Max(us): " << percentile(1.0) << '\n';
+    tfrt::outs().flush();
+  }
+
+  std::vector<std::chrono::nanoseconds> latencies;
+  int64_t num_errors = 0;
+};
+
+struct LoadTestOptions {
+  std::string name;
+  int qps;
+  int num_clients;
+  int high_priority_percent;
+  std::chrono::nanoseconds duration;
+};
+
+// Executes a function from many client threads at a target rate, and records
+// the latencies of the executions.
+class LoadTestRunner {
+ public:
+  LoadTestRunner(LoadTestOptions options, const Function* func,
+                 ArrayRef<AsyncValue*> args, const ExecutionContext& exec_ctx)
+      : options_(std::move(options)),
+        func_{FormRef(func)},
+        args_{args.begin(), args.end()},
+        exec_ctx_(exec_ctx) {
+    // AddRef on the arg AsyncValue to take an ownership ref.
+    for (auto& arg : args_) {
+      arg->AddRef();
+    }
+  }
+
+  LoadTestRunner(const LoadTestRunner&) = delete;
+  LoadTestRunner& operator=(const LoadTestRunner&) = delete;
+
+  ~LoadTestRunner() {
+    // DropRef on the arg AsyncValue to release the ownership ref.
+    for (auto& arg : args_) {
+      arg->DropRef();
+    }
+  }
+
+  // Runs the load test in a separate thread, and calls `clean_up` once all
+  // executions completed and the results are printed.
+  void Start(llvm::unique_function<void()> clean_up) {
+    clean_up_ = std::move(clean_up);
+    std::thread([this] { Run(); }).detach();
+  }
+
+ private:
+  void Run() {
+    start_ = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> clients;
+    for (int i = 0; i < options_.num_clients; ++i)
+      clients.emplace_back([this, i] { RunClient(i); });
+    for (auto& client : clients) client.join();
+
+    {
+      mutex_lock lock(mu_);
+      cv_.wait(lock,
+               [this]() TFRT_REQUIRES(mu_) { return num_pending_ == 0; });
+      std::chrono::nanoseconds elapsed = last_completion_ - start_;
+
+      LatencyStats all;
+      all.Append(high_priority_);
+      all.Append(default_priority_);
+      all.Summarize(options_.name, options_.qps, elapsed);
+      if (options_.high_priority_percent > 0) {
+        high_priority_.Summarize(options_.name + "/high", options_.qps,
+                                 elapsed);
+        default_priority_.Summarize(options_.name + "/default", options_.qps,
+                                    elapsed);
+      }
+    }
+
+    clean_up_();
+  }
+
+  // Issues executions at exponentially distributed arrival times, without
+  // waiting for the earlier executions to complete.
+  void RunClient(int client) {
+    std::mt19937_64 rng(client);
+    double client_qps =
+        static_cast<double>(options_.qps) / options_.num_clients;
+    std::exponential_distribution<double> interarrival_secs(client_qps);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    const auto end = start_ + options_.duration;
+    auto arrival = start_;
+    while (true) {
+      arrival += std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::duration<double>(interarrival_secs(rng)));
+      if (arrival >= end) break;
+      std::this_thread::sleep_until(arrival);
+      Execute(arrival, percent(rng) < options_.high_priority_percent);
+    }
+  }
+
+  // Executes the function in a new request. The latency is measured from the
+  // scheduled `arrival`, so that it includes the delay of a client that falls
+  // behind its schedule.
+  void Execute(std::chrono::steady_clock::time_point arrival,
+               bool high_priority) {
+    RequestOptions request_options;
+    request_options.priority =
+        high_priority ? TaskPriority::kHigh : TaskPriority::kDefault;
+    Expected<RCReference<RequestContext>> req_ctx =
+        RequestContextBuilder(exec_ctx_.host(), exec_ctx_.resource_context())
+            .set_request_options(request_options)
+            .build();
+    if (!req_ctx) {
+      consumeError(req_ctx.takeError());
+      mutex_lock lock(mu_);
+      ++Stats(high_priority).num_errors;
+      return;
+    }
+    ExecutionContext exec_ctx(std::move(*req_ctx));
+
+    {
+      mutex_lock lock(mu_);
+      ++num_pending_;
+    }
+
+    RCReference<AsyncValue> result;
+    func_->Execute(exec_ctx, /*arguments=*/args_, /*results=*/result);
+
+    auto* result_ptr = result.release();
+    result_ptr->AndThen([this, result_ptr, arrival, high_priority] {
+      auto now = std::chrono::steady_clock::now();
+      bool is_error = result_ptr->IsError();
+      result_ptr->DropRef();
+
+      mutex_lock lock(mu_);
+      LatencyStats& stats = Stats(high_priority);
+      stats.latencies.push_back(now - arrival);
+      if (is_error) ++stats.num_errors;
+      last_completion_ = std::max(last_completion_, now);
+      if (--num_pending_ == 0) cv_.notify_all();
+    });
+  }
+
+  LatencyStats& Stats(bool high_priority) TFRT_REQUIRES(mu_) {
+    return high_priority ? high_priority_ : default_priority_;
+  }
+
+  const LoadTestOptions options_;
+  RCReference<const Function> func_;
+  llvm::SmallVector<AsyncValue*, 4> args_;
+  ExecutionContext exec_ctx_;
+  // Clean up function to run after the end of the load test.
+  llvm::unique_function<void()> clean_up_;
+  std::chrono::steady_clock::time_point start_;
+
+  mutex mu_;
+  condition_variable cv_;
+  int64_t num_pending_ TFRT_GUARDED_BY(mu_) = 0;
+  std::chrono::steady_clock::time_point last_completion_ TFRT_GUARDED_BY(mu_);
+  LatencyStats high_priority_ TFRT_GUARDED_BY(mu_);
+  LatencyStats default_priority_ TFRT_GUARDED_BY(mu_);
+};
 }  // namespace
 
 // This op benchmarks the input BEF function by running the function in a loop
@@ -257,6 +465,45 @@ static void TestAsyncBenchmark(RemainingArguments args, Result<Chain> chain,
   });
 }
 
+// This op measures the latency of the input BEF function under an open-loop
+// load, see LoadTestOp in test_kernels.td. The function is executed from
+// dedicated client threads, so the work queue should be multi-threaded.
+//
+// Attributes:
+// duration_secs: Load test duration in seconds.
+// high_priority_percent: Percent of executions in high priority requests.
+// name: The name used to tag the load test results.
+// num_clients: Number of client threads.
+// qps: Target number of executions per second of all clients.
+// fn_const: The input function to be executed.
+static void TestLoadTest(RemainingArguments args, Result<Chain> chain,
+                         Attribute<int32_t> duration_secs,
+                         Attribute<int32_t> high_priority_percent,
+                         StringAttribute name, Attribute<int32_t> num_clients,
+                         Attribute<int32_t> qps, Attribute<Function> fn_const,
+                         KernelErrorHandler handler,
+                         const ExecutionContext& exec_ctx) {
+  const Function* fn = &(*fn_const);
+
+  if (fn->result_types().size() != 1) {
+    handler.ReportError(
+        "Load test op requires the input function have exactly one return "
+        "value");
+    return;
+  }
+
+  LoadTestOptions options{name.str(), *qps, *num_clients,
+                          *high_priority_percent,
+                          std::chrono::seconds(*duration_secs)};
+  auto runner = new LoadTestRunner(std::move(options), fn, args.values(),
+                                   exec_ctx);
+
+  runner->Start([runner, chain = chain.Allocate()] {
+    chain.emplace();
+    delete runner;
+  });
+}
+
 // This op benchmarks the input BEF function by running the function in a loop
 // up to a max count or max time as specified in the function's attributes.
 //
@@ -314,6 +561,7 @@ static Error TestSyncBenchmark(RemainingSyncArguments args,
 
 void RegisterBenchmarkKernels(KernelRegistry* registry) {
   registry->AddKernel("tfrt_test.benchmark", TFRT_KERNEL(TestAsyncBenchmark));
+  registry->AddKernel("tfrt_test.load_test", TFRT_KERNEL(TestLoadTest));
   registry->AddSyncKernel("tfrt_test.sync_benchmark",
                           TFRT_SYNC_KERNEL(TestSyncBenchmark));
 }
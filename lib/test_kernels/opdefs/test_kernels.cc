@@ -16,6 +16,9 @@
 
 #include "tfrt/test_kernels/opdefs/test_kernels.h"
 
+#include <cstdint>
+#include <utility>
+
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinOps.h"
@@ -136,13 +139,16 @@ LogicalResult DoAsyncOp::verify() {
 // BenchmarkOp
 //===----------------------------------------------------------------------===//
 
-// Parse the BenchmarkOp in the following format
+// Parse an op with a benchmarked region in the following format
 // tfrt_test.benchmark "add.i32"(%c : i32, %d : f32)
 //       max_count = 100, duration_secs = 1 {
 // ...
 // }
-
-ParseResult BenchmarkOp::parse(OpAsmParser &parser, OperationState &result) {
+//
+// `defaults` are the values of the integer attributes which may be omitted.
+static ParseResult ParseBenchmarkRegionOp(
+    OpAsmParser &parser, OperationState &result,
+    ArrayRef<std::pair<const char *, int>> defaults) {
   StringAttr nameAttr;
   if (parser.parseAttribute(nameAttr, "name", result.attributes))
     return failure();
@@ -204,8 +210,10 @@ ParseResult BenchmarkOp::parse(OpAsmParser &parser, OperationState &result) {
     }
   };
 
-  // Set the default attribute num_warmup_runs to 1 if unset
-  setDefaultAttrIfUnset("num_warmup_runs", 1);
+  // Kernels take the attributes in name order, so optional attributes must be
+  // set explicitly.
+  for (const auto &attr : defaults)
+    setDefaultAttrIfUnset(attr.first, attr.second);
 
   Region *target = result.addRegion();
   SmallVector<OpAsmParser::Argument> args;
@@ -213,21 +221,22 @@ ParseResult BenchmarkOp::parse(OpAsmParser &parser, OperationState &result) {
   return parser.parseRegion(*target, args, /*enableNameShadowing=*/true);
 }
 
-// Print the BenchmarkOp in the following format
+// Print an op with a benchmarked region in the following format
 // tfrt_test.benchmark "add.i32"(%c : i32, %d : f32)
 //       max_count = 100, duration_secs = 1 {
 // ...
 // }
-void BenchmarkOp::print(OpAsmPrinter &p) {
+static void PrintBenchmarkRegionOp(Operation *op, Region &region,
+                                   OpAsmPrinter &p) {
   p << " ";
 
   // Print the name attribute, e.g "add.i32"
-  auto name_attr = (*this)->getAttr("name");
+  auto name_attr = op->getAttr("name");
   p << name_attr;
 
   // Print the operands and types, e.g. (%c : i32, %d : f32)
   p << '(';
-  llvm::interleaveComma(llvm::zip(getOperands(), getOperandTypes()), p,
+  llvm::interleaveComma(llvm::zip(op->getOperands(), op->getOperandTypes()), p,
                         [&](const auto &it) {
                           p << std::get<0>(it) << " : " << std::get<1>(it);
                         });
@@ -236,7 +245,7 @@ void BenchmarkOp::print(OpAsmPrinter &p) {
   bool need_comma = false;
 
   // Print the attributes, e.g. max_count = 100, duration_secs = 1
-  for (auto &name_attr : (*this)->getAttrs()) {
+  for (auto &name_attr : op->getAttrs()) {
     auto id = name_attr.getName().getValue();
     if (id == "name") continue;
 
@@ -248,7 +257,7 @@ void BenchmarkOp::print(OpAsmPrinter &p) {
     if (auto int_attr = attr.dyn_cast<IntegerAttr>()) {
       int_attr.getValue().print(p.getStream(), /*isSigned=*/false);
     } else {
-      emitOpError("Unexpected attribute");
+      op->emitOpError("Unexpected attribute");
     }
 
     need_comma = true;
@@ -259,27 +268,61 @@ void BenchmarkOp::print(OpAsmPrinter &p) {
   // Print the region
   // Reuse the argument names provided to the op for the bbarg names within
   // the region.
-  p.shadowRegionArgs(getRegion(), getOperands());
+  p.shadowRegionArgs(region, op->getOperands());
   p << ' ';
-  p.printRegion(getRegion(), /*printEntryBlockArgs=*/false);
+  p.printRegion(region, /*printEntryBlockArgs=*/false);
 }
 
-LogicalResult BenchmarkOp::verify() {
-  BenchmarkOp op = *this;
-  // Verify that the target benchmark region has exactly one return value.
-  auto &region = op.getRegion();
+// Verify that the benchmarked region has exactly one return value.
+static LogicalResult VerifyBenchmarkRegion(Operation *op, Region &region) {
   auto &last_op = region.front().back();
   if (last_op.getName().getStringRef() != "tfrt.return") {
-    return op.emitOpError("missing return statement");
+    return op->emitOpError("missing return statement");
   }
   if (last_op.getNumOperands() != 1) {
-    return op.emitOpError(
+    return op->emitOpError(
         "incorrect number of return values. One return value is expected");
   }
 
   return success();
 }
 
+ParseResult BenchmarkOp::parse(OpAsmParser &parser, OperationState &result) {
+  return ParseBenchmarkRegionOp(parser, result, {{"num_warmup_runs", 1}});
+}
+
+void BenchmarkOp::print(OpAsmPrinter &p) {
+  PrintBenchmarkRegionOp(*this, getRegion(), p);
+}
+
+LogicalResult BenchmarkOp::verify() {
+  return VerifyBenchmarkRegion(*this, getRegion());
+}
+
+//===----------------------------------------------------------------------===//
+// LoadTestOp
+//===----------------------------------------------------------------------===//
+
+ParseResult LoadTestOp::parse(OpAsmParser &parser, OperationState &result) {
+  return ParseBenchmarkRegionOp(
+      parser, result, {{"high_priority_percent", 0}, {"num_clients", 1}});
+}
+
+void LoadTestOp::print(OpAsmPrinter &p) {
+  PrintBenchmarkRegionOp(*this, getRegion(), p);
+}
+
+LogicalResult LoadTestOp::verify() {
+  // I32 attributes are returned as unsigned values.
+  if (static_cast<int32_t>(getQps()) <= 0)
+    return emitOpError("qps must be positive");
+  if (static_cast<int32_t>(getNumClients()) <= 0)
+    return emitOpError("num_clients must be positive");
+  if (getHighPriorityPercent() > 100)
+    return emitOpError("high_priority_percent must be in [0, 100]");
+  return VerifyBenchmarkRegion(*this, getRegion());
+}
+
 //===----------------------------------------------------------------------===//
 // SyncBenchmarkOp
 //===----------------------------------------------------------------------===//
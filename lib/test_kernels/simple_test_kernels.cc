@@ -324,6 +324,17 @@ static void TestSyncSumAttributes(SyncKernelFrame* frame) {
   frame->EmplaceResultAt<int>(0, sum);
 }
 
+// For testing last use arguments. Returns a mask of the arguments that are the
+// last use of their register.
+static void TestSyncLastUses(SyncKernelFrame* frame) {
+  int mask = 0;
+  for (int i = 0; i < frame->GetNumArgs(); ++i) {
+    if (frame->IsLastUse(i)) mask |= 1 << i;
+  }
+
+  frame->EmplaceResultAt<int>(0, mask);
+}
+
 // For testing that invocations of this kernel with different name get
 // different locations.
 static llvm::Expected<Chain> TestUniqueLoc(StringAttribute name,
@@ -491,6 +502,7 @@ void RegisterSimpleTestKernels(KernelRegistry* registry) {
                           TFRT_SYNC_KERNEL(TestSyncSum2));
   registry->AddSyncKernel("tfrt_test.sync_sum_attributes",
                           TestSyncSumAttributes);
+  registry->AddSyncKernel("tfrt_test.sync_last_uses", TestSyncLastUses);
 }
 
 }  // namespace tfrt
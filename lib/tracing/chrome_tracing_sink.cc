@@ -13,35 +13,62 @@
 // limitations under the License.
 
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <utility>
 
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Twine.h"
 #include "tfrt/support/error_util.h"
+#include "tfrt/tracing/perf_counters.h"
 #include "tfrt/tracing/tracing.h"
 
 // This file implements a tracing sink which produces activities that can be
-// loaded in chrome://tracing. If run as part of a test, a trace.json file
-// is written as undeclared test output. Otherwise it is written to stdout.
+// loaded in chrome://tracing or Perfetto. The trace is written to the file
+// named by the TFRT_TRACING_FILE environment variable, or if run as part of a
+// test, to a trace.json file as undeclared test output. Otherwise it is
+// written to stdout when tracing is disabled.
+//
+// Traces written to a file are streamed: a background thread appends the
+// recorded activities to the file every kFlushInterval, so that memory usage
+// doesn't grow with the length of the trace. If the TFRT_TRACING_MAX_FILE_BYTES
+// environment variable is set, the trace is split into files of about that
+// size, trace.json, trace.1.json, trace.2.json, etc., each of which can be
+// loaded on its own.
 //
 // Usage: replace simple_tracing_sink dependency of bef_executor target with
 // chrome_tracing_sink and run with --enable_tracing.
+//
+// If the TFRT_TRACING_PERF_COUNTERS environment variable is set to 1, the
+// hardware performance counters (see perf_counters.h) are read at the
+// boundaries of tracing scopes and the counts are attached to the activities
+// as args. Counts are inclusive of nested scopes, like durations.
 
 namespace tfrt {
 namespace tracing {
 
 class ChromeTracingSink : public TracingSink {
   using Clock = std::chrono::high_resolution_clock;
-  using Start = std::pair<std::string, Clock::time_point>;
+
+  struct Start {
+    std::string name;
+    Clock::time_point begin;
+    llvm::Optional<PerfCounterValues> counters;
+  };
 
   struct Entry {
     std::string name;
     Clock::time_point begin, end;
     std::thread::id tid;
+    llvm::Optional<PerfCounterValues> counters;
     std::unique_ptr<Entry> next;
   };
 
@@ -64,50 +91,222 @@ class ChromeTracingSink : public TracingSink {
   };
 
  public:
-  ~ChromeTracingSink() override { delete head_.exchange(nullptr); }
+  ChromeTracingSink() {
+    const char* perf_counters = std::getenv("TFRT_TRACING_PERF_COUNTERS");
+    perf_counters_enabled_ =
+        perf_counters != nullptr && std::string(perf_counters) == "1";
+    if (const char* file = std::getenv("TFRT_TRACING_FILE")) {
+      path_ = file;
+    } else if (const char* dir = std::getenv("TEST_UNDECLARED_OUTPUTS_DIR")) {
+      path_ = dir + std::string("/trace.json");
+    }
+    if (const char* max_bytes = std::getenv("TFRT_TRACING_MAX_FILE_BYTES"))
+      max_file_bytes_ = std::strtoull(max_bytes, nullptr, 10);
+  }
+
+  ~ChromeTracingSink() override {
+    StopWriter();
+    DeleteEntries(head_.exchange(nullptr));
+  }
 
   Error RequestTracing(bool enable) override {
-    if (enable) return Error::success();
-    std::unique_ptr<Entry> head(head_.exchange(nullptr));
-    std::ofstream ofs;
-    if (const char* dir = std::getenv("TEST_UNDECLARED_OUTPUTS_DIR"))
-      ofs.open(dir + std::string("/trace.json"));
-    std::ostream& os = ofs ? ofs : std::cout;
-    os << "{\n  \"traceEvents\": [\n";
-    for (; head; head = std::move(head->next)) {
-      os << R"(    {"ph": "X", "name": ")" << head->name;
-      os << R"(", "pid": 0, "tid": )" << head->tid;
-      os << R"(, "ts": )" << Duration(head->begin - start_);
-      os << R"(, "dur": )" << Duration(head->end - head->begin) << "},\n";
+    if (path_.empty()) {
+      // Without a file, the trace is written to stdout at the end, so that it
+      // is not interleaved with the output of the program.
+      if (!enable) WriteTrace(std::cout, TakeEntries());
+      return Error::success();
     }
-    os << "    {}\n  ],\n  \"displayTimeUnit\": \"ns\"\n}\n";
+    if (!enable) {
+      StopWriter();
+      return Error::success();
+    }
+    file_index_ = 0;
+    if (!OpenFile())
+      return MakeStringError("Failed to open trace file ", path_);
+    stop_writer_ = false;
+    writer_ = std::thread([this] { WriterLoop(); });
     return Error::success();
   }
 
   void RecordTracingEvent(TracingSink::NameGenerator name_gen) override {
     auto now = Clock::now();
-    auto entry = new Entry{name_gen(), now, now, std::this_thread::get_id()};
+    auto entry = new Entry{name_gen(), now, now, std::this_thread::get_id(),
+                           llvm::None};
     entry->next.reset(head_.exchange(entry));
   }
 
   void PushTracingScope(TracingSink::NameGenerator name_gen) override {
-    stack_.emplace_back(name_gen(), Clock::now());
+    auto name = name_gen();
+    // Read the counters last and the clock first when popping, to exclude the
+    // overhead of the sink as far as possible.
+    auto counters = ReadPerfCounters();
+    stack_.push_back({std::move(name), Clock::now(), counters});
   }
 
   void PopTracingScope() override {
+    auto counters = ReadPerfCounters();
     auto now = Clock::now();
-    auto entry = new Entry{std::move(stack_.back().first), stack_.back().second,
-                           now, std::this_thread::get_id()};
+    Start& start = stack_.back();
+    if (counters && start.counters) {
+      counters = *counters - *start.counters;
+    } else {
+      counters = llvm::None;
+    }
+    auto entry = new Entry{std::move(start.name), start.begin, now,
+                           std::this_thread::get_id(), counters};
     entry->next.reset(head_.exchange(entry));
     stack_.pop_back();
   }
 
+ private:
+  static constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+
+  // Takes the activities recorded so far, most recent first.
+  std::unique_ptr<Entry> TakeEntries() {
+    return std::unique_ptr<Entry>(head_.exchange(nullptr));
+  }
+
+  // Deletes the list iteratively, long lists would overflow the stack.
+  static void DeleteEntries(Entry* head) {
+    std::unique_ptr<Entry> entry(head);
+    while (entry) entry = std::move(entry->next);
+  }
+
+  void WriteEntry(std::ostream& os, const Entry& entry) const {
+    os << R"(    {"ph": "X", "name": ")" << entry.name;
+    os << R"(", "pid": 0, "tid": )" << entry.tid;
+    os << R"(, "ts": )" << Duration(entry.begin - start_);
+    os << R"(, "dur": )" << Duration(entry.end - entry.begin);
+    if (const auto& counters = entry.counters) {
+      os << R"(, "args": {"cycles": )" << counters->cycles;
+      os << R"(, "instructions": )" << counters->instructions;
+      os << R"(, "llc_misses": )" << counters->llc_misses;
+      os << R"(, "branch_misses": )" << counters->branch_misses << "}";
+    }
+    os << "},\n";
+  }
+
+  static void WriteHeader(std::ostream& os) {
+    os << "{\n  \"traceEvents\": [\n";
+  }
+
+  static void WriteTrailer(std::ostream& os) {
+    os << "    {}\n  ],\n  \"displayTimeUnit\": \"ns\"\n}\n";
+  }
+
+  void WriteTrace(std::ostream& os, std::unique_ptr<Entry> head) const {
+    WriteHeader(os);
+    for (; head; head = std::move(head->next)) WriteEntry(os, *head);
+    WriteTrailer(os);
+  }
+
+  // Returns the path of the trace file with the given index: `path_` for the
+  // first one, and e.g. trace.1.json for the second one.
+  std::string GetFilePath(int index) const {
+    if (index == 0) return path_;
+    llvm::StringRef path(path_);
+    llvm::StringRef stem = path;
+    if (path.endswith(".json")) stem = path.drop_back(5);
+    return (stem + "." + llvm::Twine(index) + ".json").str();
+  }
+
+  bool OpenFile() {
+    file_.open(GetFilePath(file_index_), std::ios::out | std::ios::trunc);
+    if (!file_) return false;
+    WriteHeader(file_);
+    return true;
+  }
+
+  void CloseFile() {
+    WriteTrailer(file_);
+    file_.close();
+  }
+
+  // Appends the recorded activities to the trace file, and starts a new file
+  // whenever the current one exceeds `max_file_bytes_`.
+  void WriteToFile(std::unique_ptr<Entry> head) {
+    for (; head && file_; head = std::move(head->next)) {
+      WriteEntry(file_, *head);
+      if (max_file_bytes_ > 0 &&
+          static_cast<uint64_t>(file_.tellp()) >= max_file_bytes_) {
+        CloseFile();
+        ++file_index_;
+        if (!OpenFile()) {
+          std::cerr << "Failed to open trace file "
+                    << GetFilePath(file_index_) << "\n";
+        }
+      }
+    }
+    // Drop the rest if the file couldn't be written.
+    DeleteEntries(head.release());
+    file_.flush();
+  }
+
+  void WriterLoop() {
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    while (!stop_writer_) {
+      writer_cv_.wait_for(lock, kFlushInterval, [&] { return stop_writer_; });
+      WriteToFile(TakeEntries());
+    }
+  }
+
+  // Stops the writer thread, if running, and completes the trace file.
+  void StopWriter() {
+    if (!writer_.joinable()) return;
+    {
+      std::lock_guard<std::mutex> lock(writer_mutex_);
+      stop_writer_ = true;
+    }
+    writer_cv_.notify_one();
+    writer_.join();
+    WriteToFile(TakeEntries());
+    if (file_.is_open()) CloseFile();
+  }
+
+  // Returns the hardware performance counters of the calling thread, or None
+  // if they are disabled or not available.
+  llvm::Optional<PerfCounterValues> ReadPerfCounters() {
+    if (!perf_counters_enabled_.load(std::memory_order_relaxed))
+      return llvm::None;
+    if (!perf_counters_) {
+      auto counters = PerfCounters::Create();
+      if (!counters) {
+        // Counters are unavailable for the whole process, don't retry.
+        if (perf_counters_enabled_.exchange(false)) {
+          std::cerr << "Hardware performance counters are not available: "
+                    << llvm::toString(counters.takeError()) << "\n";
+        } else {
+          consumeError(counters.takeError());
+        }
+        return llvm::None;
+      }
+      perf_counters_ = std::move(*counters);
+    }
+    return perf_counters_->Read();
+  }
+
   const Clock::time_point start_ = Clock::now();
+  std::atomic<bool> perf_counters_enabled_;
   static thread_local std::vector<Start> stack_;
+  static thread_local std::unique_ptr<PerfCounters> perf_counters_;
   std::atomic<Entry*> head_ = {nullptr};
+
+  // The trace file, and the maximum size of each file if the trace is split.
+  std::string path_;
+  uint64_t max_file_bytes_ = 0;
+
+  // Only accessed by the writer thread while it is running.
+  std::ofstream file_;
+  int file_index_ = 0;
+
+  std::thread writer_;
+  std::mutex writer_mutex_;
+  std::condition_variable writer_cv_;
+  bool stop_writer_ = false;
 };
 
 thread_local std::vector<ChromeTracingSink::Start> ChromeTracingSink::stack_;
+thread_local std::unique_ptr<PerfCounters> ChromeTracingSink::perf_counters_;
 
 static const bool kRegisterTracingSink = []() {
   RegisterTracingSink(new ChromeTracingSink);
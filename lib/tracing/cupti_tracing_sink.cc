@@ -0,0 +1,395 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// CUPTI tracing sink
+//
+// This file implements a tracing sink which records host activities together
+// with the GPU activities they launched, collected with the CUPTI activity API.
+
+#include "tfrt/tracing/cupti_tracing_sink.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cupti.h"  // from @cuda_headers
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/support/alloc.h"
+#include "tfrt/support/error_util.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+#include "tfrt/tracing/tracing.h"
+
+namespace tfrt {
+namespace tracing {
+namespace {
+
+// Size of the buffers handed to CUPTI to record device activities.
+constexpr size_t kActivityBufferSize = 1 << 20;
+
+// CUPTI functions used by the sink, loaded from libcupti.so.
+struct CuptiApi {
+  // Returns the loaded functions, or nullptr if libcupti.so or any of the
+  // functions can't be loaded.
+  static const CuptiApi* Get();
+
+  decltype(&cuptiActivityRegisterCallbacks) register_callbacks;
+  decltype(&cuptiActivityEnable) enable;
+  decltype(&cuptiActivityDisable) disable;
+  decltype(&cuptiActivityFlushAll) flush_all;
+  decltype(&cuptiActivityGetNextRecord) get_next_record;
+  decltype(&cuptiActivityPushExternalCorrelationId) push_external_id;
+  decltype(&cuptiActivityPopExternalCorrelationId) pop_external_id;
+  decltype(&cuptiGetTimestamp) get_timestamp;
+};
+
+const CuptiApi* CuptiApi::Get() {
+  static const CuptiApi* api = []() -> const CuptiApi* {
+    auto library =
+        llvm::sys::DynamicLibrary::getPermanentLibrary("libcupti.so");
+    if (!library.isValid()) return nullptr;
+    auto* api = new CuptiApi;
+    bool found = true;
+    auto load = [&](auto& func, const char* name) {
+      using Func = std::remove_reference_t<decltype(func)>;
+      func = reinterpret_cast<Func>(library.getAddressOfSymbol(name));
+      found &= func != nullptr;
+    };
+    load(api->register_callbacks, "cuptiActivityRegisterCallbacks");
+    load(api->enable, "cuptiActivityEnable");
+    load(api->disable, "cuptiActivityDisable");
+    load(api->flush_all, "cuptiActivityFlushAll");
+    load(api->get_next_record, "cuptiActivityGetNextRecord");
+    load(api->push_external_id, "cuptiActivityPushExternalCorrelationId");
+    load(api->pop_external_id, "cuptiActivityPopExternalCorrelationId");
+    load(api->get_timestamp, "cuptiGetTimestamp");
+    if (found) return api;
+    delete api;
+    return nullptr;
+  }();
+  return api;
+}
+
+// Activity kinds recorded while tracing is enabled. Driver and runtime API
+// activities are only enabled because CUPTI emits the external correlation
+// records together with them, they are not written to the trace.
+constexpr CUpti_ActivityKind kActivityKinds[] = {
+    CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL,
+    CUPTI_ACTIVITY_KIND_MEMCPY,
+    CUPTI_ACTIVITY_KIND_MEMSET,
+    CUPTI_ACTIVITY_KIND_DRIVER,
+    CUPTI_ACTIVITY_KIND_RUNTIME,
+    CUPTI_ACTIVITY_KIND_EXTERNAL_CORRELATION,
+};
+
+// Host activity. Instant events have begin == end and no external id.
+struct HostEvent {
+  std::string name;
+  uint64_t begin, end;  // CUPTI timestamps in ns
+  uint64_t tid;
+  uint64_t external_id;
+};
+
+// Kernel, memcpy or memset executed on a device.
+struct DeviceEvent {
+  std::string name;
+  uint64_t begin, end;  // CUPTI timestamps in ns
+  uint32_t device_id;
+  uint32_t stream_id;
+  uint32_t correlation_id;
+};
+
+const char* GetMemcpyName(uint8_t kind) {
+  switch (kind) {
+    case CUPTI_ACTIVITY_MEMCPY_KIND_HTOD:
+      return "Memcpy HtoD";
+    case CUPTI_ACTIVITY_MEMCPY_KIND_DTOH:
+      return "Memcpy DtoH";
+    case CUPTI_ACTIVITY_MEMCPY_KIND_DTOD:
+      return "Memcpy DtoD";
+    default:
+      return "Memcpy";
+  }
+}
+
+class CuptiTracingSink : public TracingSink {
+  struct Start {
+    std::string name;
+    uint64_t begin;
+    uint64_t external_id;
+  };
+
+ public:
+  static CuptiTracingSink* Get() {
+    static auto* sink = new CuptiTracingSink;
+    return sink;
+  }
+
+  Error RequestTracing(bool enable) override {
+    if (!enable) {
+      Disable();
+      std::string path;
+      if (const char* dir = std::getenv("TEST_UNDECLARED_OUTPUTS_DIR"))
+        path = dir + std::string("/trace.json");
+      std::error_code error;
+      llvm::raw_fd_ostream ofs(path.empty() ? "-" : path, error);
+      WriteTrace(error ? llvm::outs() : ofs);
+      mutex_lock lock(mutex_);
+      host_events_.clear();
+      device_events_.clear();
+      external_ids_.clear();
+      return Error::success();
+    }
+
+    api_ = CuptiApi::Get();
+    if (api_ == nullptr) return MakeStringError("Failed to load libcupti.so.");
+    if (CUptiResult result =
+            api_->register_callbacks(RequestBuffer, CompleteBuffer)) {
+      return MakeStringError("Failed to register CUPTI callbacks: ", result);
+    }
+    for (CUpti_ActivityKind kind : kActivityKinds) {
+      if (CUptiResult result = api_->enable(kind)) {
+        Disable();
+        return MakeStringError("Failed to enable CUPTI activity ", kind, ": ",
+                               result);
+      }
+    }
+    api_->get_timestamp(&start_);
+    return Error::success();
+  }
+
+  void RecordTracingEvent(TracingSink::NameGenerator name_gen) override {
+    uint64_t now = GetTimestamp();
+    HostEvent event{name_gen(), now, now, llvm::get_threadid(), 0};
+    mutex_lock lock(mutex_);
+    host_events_.push_back(std::move(event));
+  }
+
+  void PushTracingScope(TracingSink::NameGenerator name_gen) override {
+    uint64_t external_id = next_external_id_.fetch_add(1) + 1;
+    stack_.push_back({name_gen(), GetTimestamp(), external_id});
+    api_->push_external_id(CUPTI_EXTERNAL_CORRELATION_KIND_CUSTOM0,
+                           external_id);
+  }
+
+  void PopTracingScope() override {
+    uint64_t last_id;
+    api_->pop_external_id(CUPTI_EXTERNAL_CORRELATION_KIND_CUSTOM0, &last_id);
+    Start& start = stack_.back();
+    HostEvent event{std::move(start.name), start.begin, GetTimestamp(),
+                    llvm::get_threadid(), start.external_id};
+    stack_.pop_back();
+    mutex_lock lock(mutex_);
+    host_events_.push_back(std::move(event));
+  }
+
+  void WriteTrace(raw_ostream& os) {
+    if (api_ != nullptr) api_->flush_all(CUPTI_ACTIVITY_FLAG_FLUSH_FORCED);
+
+    mutex_lock lock(mutex_);
+    auto to_us = [&](uint64_t ns) { return (ns - start_) * 1e-3; };
+
+    // The host scope which launched each device activity, by external id.
+    llvm::DenseMap<uint64_t, const HostEvent*> scopes;
+    for (const HostEvent& event : host_events_)
+      if (event.external_id != 0) scopes[event.external_id] = &event;
+    auto get_scope = [&](const DeviceEvent& event) -> const HostEvent* {
+      auto it = external_ids_.find(event.correlation_id);
+      if (it == external_ids_.end()) return nullptr;
+      return scopes.lookup(it->second);
+    };
+
+    llvm::json::OStream json(os);
+    json.object([&] {
+      json.attributeArray("traceEvents", [&] {
+        for (const HostEvent& event : host_events_) {
+          json.object([&] {
+            json.attribute("name", event.name);
+            json.attribute("pid", 0);
+            json.attribute("tid", event.tid);
+            json.attribute("ts", to_us(event.begin));
+            if (event.external_id == 0) {
+              json.attribute("ph", "i");
+              json.attribute("s", "t");
+            } else {
+              json.attribute("ph", "X");
+              json.attribute("dur", to_us(event.end) - to_us(event.begin));
+            }
+          });
+        }
+        llvm::DenseMap<uint32_t, bool> devices;
+        for (const DeviceEvent& event : device_events_) {
+          devices[event.device_id] = true;
+          const HostEvent* scope = get_scope(event);
+          json.object([&] {
+            json.attribute("name", event.name);
+            json.attribute("ph", "X");
+            json.attribute("pid", event.device_id + 1);
+            json.attribute("tid", event.stream_id);
+            json.attribute("ts", to_us(event.begin));
+            json.attribute("dur", to_us(event.end) - to_us(event.begin));
+            json.attributeObject("args", [&] {
+              json.attribute("correlation_id", event.correlation_id);
+              if (scope) json.attribute("host_scope", scope->name);
+            });
+          });
+          if (!scope) continue;
+          // Flow arrow from the launching host scope to the device activity.
+          json.object([&] {
+            json.attribute("name", "launch");
+            json.attribute("cat", "launch");
+            json.attribute("ph", "s");
+            json.attribute("id", event.correlation_id);
+            json.attribute("pid", 0);
+            json.attribute("tid", scope->tid);
+            json.attribute("ts", to_us(scope->begin));
+          });
+          json.object([&] {
+            json.attribute("name", "launch");
+            json.attribute("cat", "launch");
+            json.attribute("ph", "f");
+            json.attribute("bp", "e");
+            json.attribute("id", event.correlation_id);
+            json.attribute("pid", event.device_id + 1);
+            json.attribute("tid", event.stream_id);
+            json.attribute("ts", to_us(event.begin));
+          });
+        }
+        auto process_name = [&](uint32_t pid, const std::string& name) {
+          json.object([&] {
+            json.attribute("name", "process_name");
+            json.attribute("ph", "M");
+            json.attribute("pid", pid);
+            json.attributeObject("args",
+                                 [&] { json.attribute("name", name); });
+          });
+        };
+        process_name(0, "Host");
+        for (const auto& device : devices)
+          process_name(device.first + 1, "GPU " + std::to_string(device.first));
+      });
+      json.attribute("displayTimeUnit", "ns");
+    });
+    os << "\n";
+    os.flush();
+  }
+
+ private:
+  CuptiTracingSink() = default;
+
+  uint64_t GetTimestamp() const {
+    uint64_t timestamp = 0;
+    api_->get_timestamp(&timestamp);
+    return timestamp;
+  }
+
+  void Disable() {
+    if (api_ == nullptr) return;
+    for (CUpti_ActivityKind kind : kActivityKinds) api_->disable(kind);
+  }
+
+  static void RequestBuffer(uint8_t** buffer, size_t* size,
+                            size_t* max_num_records) {
+    *buffer = static_cast<uint8_t*>(AlignedAlloc(8, kActivityBufferSize));
+    *size = kActivityBufferSize;
+    *max_num_records = 0;  // As many as fit into the buffer.
+  }
+
+  static void CompleteBuffer(CUcontext context, uint32_t stream_id,
+                             uint8_t* buffer, size_t size, size_t valid_size) {
+    Get()->AddRecords(buffer, valid_size);
+    AlignedFree(buffer);
+  }
+
+  void AddRecords(uint8_t* buffer, size_t valid_size) {
+    mutex_lock lock(mutex_);
+    CUpti_Activity* record = nullptr;
+    while (api_->get_next_record(buffer, valid_size, &record) ==
+           CUPTI_SUCCESS) {
+      switch (record->kind) {
+        case CUPTI_ACTIVITY_KIND_KERNEL:
+        case CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL: {
+          auto* kernel = reinterpret_cast<CUpti_ActivityKernel4*>(record);
+          device_events_.push_back({kernel->name, kernel->start, kernel->end,
+                                    kernel->deviceId, kernel->streamId,
+                                    kernel->correlationId});
+          break;
+        }
+        case CUPTI_ACTIVITY_KIND_MEMCPY: {
+          auto* memcpy = reinterpret_cast<CUpti_ActivityMemcpy*>(record);
+          device_events_.push_back({GetMemcpyName(memcpy->copyKind),
+                                    memcpy->start, memcpy->end,
+                                    memcpy->deviceId, memcpy->streamId,
+                                    memcpy->correlationId});
+          break;
+        }
+        case CUPTI_ACTIVITY_KIND_MEMSET: {
+          auto* memset = reinterpret_cast<CUpti_ActivityMemset*>(record);
+          device_events_.push_back({"Memset", memset->start, memset->end,
+                                    memset->deviceId, memset->streamId,
+                                    memset->correlationId});
+          break;
+        }
+        case CUPTI_ACTIVITY_KIND_EXTERNAL_CORRELATION: {
+          auto* correlation =
+              reinterpret_cast<CUpti_ActivityExternalCorrelation*>(record);
+          if (correlation->externalKind ==
+              CUPTI_EXTERNAL_CORRELATION_KIND_CUSTOM0) {
+            external_ids_[correlation->correlationId] =
+                correlation->externalId;
+          }
+          break;
+        }
+        default:
+          break;
+      }
+    }
+  }
+
+  const CuptiApi* api_ = nullptr;
+  uint64_t start_ = 0;
+  std::atomic<uint64_t> next_external_id_ = {0};
+  static thread_local std::vector<Start> stack_;
+
+  mutex mutex_;
+  std::vector<HostEvent> host_events_ TFRT_GUARDED_BY(mutex_);
+  std::vector<DeviceEvent> device_events_ TFRT_GUARDED_BY(mutex_);
+  // External (i.e. host scope) id of the CUDA API calls, by correlation id.
+  llvm::DenseMap<uint32_t, uint64_t> external_ids_ TFRT_GUARDED_BY(mutex_);
+};
+
+thread_local std::vector<CuptiTracingSink::Start> CuptiTracingSink::stack_;
+
+}  // namespace
+
+void WriteCuptiTrace(raw_ostream& os) {
+  CuptiTracingSink::Get()->WriteTrace(os);
+}
+
+static const bool kRegisterTracingSink = []() {
+  RegisterTracingSink(CuptiTracingSink::Get());
+  return true;
+}();
+
+}  // namespace tracing
+}  // namespace tfrt
@@ -0,0 +1,93 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements the hardware performance counters with perf_event.
+
+#include "tfrt/tracing/perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include "tfrt/support/error_util.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace tfrt {
+namespace tracing {
+
+#if defined(__linux__)
+// Opens a user space hardware counter of the calling thread on any CPU.
+static int OpenCounter(uint64_t config, int group_fd) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return syscall(SYS_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1, group_fd,
+                 /*flags=*/0);
+}
+#endif
+
+Expected<std::unique_ptr<PerfCounters>> PerfCounters::Create() {
+#if defined(__linux__)
+  static constexpr uint64_t kConfigs[] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+  std::unique_ptr<PerfCounters> counters(new PerfCounters);
+  int leader = OpenCounter(kConfigs[0], /*group_fd=*/-1);
+  if (leader < 0)
+    return MakeStringError("perf_event_open failed: ", std::strerror(errno));
+  counters->fds_[0] = leader;
+  for (size_t i = 1; i < counters->fds_.size(); ++i)
+    counters->fds_[i] = OpenCounter(kConfigs[i], leader);
+  return std::move(counters);
+#else
+  return MakeStringError("hardware performance counters are not supported");
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+  // Close the group leader last.
+  for (int i = fds_.size() - 1; i >= 0; --i)
+    if (fds_[i] >= 0) close(fds_[i]);
+#endif
+}
+
+PerfCounterValues PerfCounters::Read() const {
+  PerfCounterValues result;
+#if defined(__linux__)
+  // Reading the group leader returns the number of counters in the group,
+  // followed by their values in the order they were opened.
+  uint64_t buffer[1 + 4];
+  ssize_t size = read(fds_[0], buffer, sizeof(buffer));
+  if (size < static_cast<ssize_t>(sizeof(uint64_t))) return result;
+  uint64_t* values[] = {&result.cycles, &result.instructions,
+                        &result.llc_misses, &result.branch_misses};
+  for (size_t i = 0, j = 1; i < fds_.size() && j <= buffer[0]; ++i)
+    if (fds_[i] >= 0) *values[i] = buffer[j++];
+#endif
+  return result;
+}
+
+}  // namespace tracing
+}  // namespace tfrt
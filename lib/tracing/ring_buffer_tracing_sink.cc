@@ -0,0 +1,302 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Ring buffer tracing sink
+//
+// This file implements a tracing sink which records activities into per-thread
+// ring buffers, to be exported on demand.
+
+#include "tfrt/tracing/ring_buffer_tracing_sink.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#endif
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+#include "tfrt/tracing/tracing.h"
+
+namespace tfrt {
+namespace tracing {
+namespace {
+
+// Returns the current time in ticks of the time stamp counter, which is
+// cheaper to read than std::chrono clocks. Ticks are converted to time when
+// the trace is exported.
+uint64_t ReadTicks() {
+#if defined(__x86_64__) || defined(_M_X64)
+  return __rdtsc();
+#else
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// Name id of activities recorded after kRingBufferMaxNames names.
+constexpr uint32_t kOverflowNameId = 0;
+
+// Interned activity names, shared by all threads.
+class NameTable {
+ public:
+  NameTable() { names_.push_back("<overflow>"); }
+
+  uint32_t Intern(const std::string& name) {
+    mutex_lock lock(mu_);
+    auto it = ids_.find(name);
+    if (it != ids_.end()) return it->second;
+    if (names_.size() >= kRingBufferMaxNames) return kOverflowNameId;
+    uint32_t id = names_.size();
+    ids_.try_emplace(name, id);
+    names_.push_back(name);
+    return id;
+  }
+
+  std::vector<std::string> GetNames() const {
+    mutex_lock lock(mu_);
+    return names_;
+  }
+
+ private:
+  mutable mutex mu_;
+  llvm::StringMap<uint32_t> ids_ TFRT_GUARDED_BY(mu_);
+  std::vector<std::string> names_ TFRT_GUARDED_BY(mu_);
+};
+
+// One activity. The fields are atomic because snapshots read them while the
+// owning thread may overwrite them.
+struct Event {
+  std::atomic<uint64_t> begin{0};
+  std::atomic<uint64_t> end{0};
+  std::atomic<uint32_t> name_id{0};
+};
+
+struct EventCopy {
+  uint64_t begin;
+  uint64_t end;
+  uint32_t name_id;
+};
+
+// Ring buffer of the activities of one thread. Written by the owning thread
+// only, read by snapshots from any thread.
+class ThreadBuffer {
+ public:
+  explicit ThreadBuffer(int tid)
+      : tid_(tid), events_(new Event[kRingBufferEventsPerThread]) {}
+
+  int tid() const { return tid_; }
+
+  void Record(uint64_t begin, uint64_t end, uint32_t name_id) {
+    uint64_t index = claimed_.load(std::memory_order_relaxed);
+    // Announce that the slot of event `index - capacity` is being
+    // overwritten before writing it, like the sequence number of a seqlock.
+    claimed_.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    Event& event = events_[index % kRingBufferEventsPerThread];
+    event.begin.store(begin, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    event.name_id.store(name_id, std::memory_order_relaxed);
+    published_.store(index + 1, std::memory_order_release);
+  }
+
+  // Returns the events in the buffer, oldest first.
+  std::vector<EventCopy> Copy() const {
+    uint64_t end = published_.load(std::memory_order_acquire);
+    uint64_t begin = end > kRingBufferEventsPerThread
+                         ? end - kRingBufferEventsPerThread
+                         : 0;
+    std::vector<EventCopy> result;
+    result.reserve(end - begin);
+    for (uint64_t index = begin; index < end; ++index) {
+      const Event& event = events_[index % kRingBufferEventsPerThread];
+      result.push_back({event.begin.load(std::memory_order_relaxed),
+                        event.end.load(std::memory_order_relaxed),
+                        event.name_id.load(std::memory_order_relaxed)});
+    }
+    // Drop the events which may have been overwritten while they were copied.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t claimed = claimed_.load(std::memory_order_relaxed);
+    uint64_t valid_begin = claimed > kRingBufferEventsPerThread
+                               ? claimed - kRingBufferEventsPerThread
+                               : 0;
+    if (valid_begin > begin) {
+      size_t num_overwritten = std::min(valid_begin, end) - begin;
+      result.erase(result.begin(), result.begin() + num_overwritten);
+    }
+    return result;
+  }
+
+ private:
+  const int tid_;
+  std::unique_ptr<Event[]> events_;
+  // Number of events which have started writing.
+  std::atomic<uint64_t> claimed_{0};
+  // Number of events which have completed writing.
+  std::atomic<uint64_t> published_{0};
+};
+
+class RingBufferTracingSink : public TracingSink {
+ public:
+  static RingBufferTracingSink* Get() {
+    static auto* sink = new RingBufferTracingSink;
+    return sink;
+  }
+
+  Error RequestTracing(bool enable) override { return Error::success(); }
+
+  void RecordTracingEvent(TracingSink::NameGenerator gen_name) override {
+    ThreadState& state = GetThreadState();
+    uint64_t now = ReadTicks();
+    state.buffer->Record(now, now, GetNameId(state, gen_name()));
+  }
+
+  void PushTracingScope(TracingSink::NameGenerator gen_name) override {
+    ThreadState& state = GetThreadState();
+    uint32_t name_id = GetNameId(state, gen_name());
+    state.scopes.emplace_back(ReadTicks(), name_id);
+  }
+
+  void PopTracingScope() override {
+    ThreadState& state = GetThreadState();
+    if (state.scopes.empty()) return;
+    std::pair<uint64_t, uint32_t> scope = state.scopes.pop_back_val();
+    state.buffer->Record(scope.first, ReadTicks(), scope.second);
+  }
+
+  void WriteSnapshot(raw_ostream& os) {
+    std::vector<ThreadBuffer*> buffers;
+    {
+      mutex_lock lock(mu_);
+      buffers = all_buffers_;
+    }
+    std::vector<std::string> names = names_.GetNames();
+    for (std::string& name : names) {
+      if (!llvm::json::isUTF8(name)) name = llvm::json::fixUTF8(name);
+    }
+
+    // Convert ticks to microseconds since the sink was created, calibrating
+    // the tick rate against the steady clock.
+    uint64_t ticks = ReadTicks();
+    auto time = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(time - start_time_)
+                    .count();
+    double us_per_tick =
+        ticks > start_ticks_ ? ns * 1e-3 / (ticks - start_ticks_) : 1e-3;
+    auto to_us = [&](uint64_t ticks) {
+      return ticks > start_ticks_ ? (ticks - start_ticks_) * us_per_tick : 0;
+    };
+
+    llvm::json::OStream json(os);
+    json.object([&] {
+      json.attributeArray("traceEvents", [&] {
+        for (ThreadBuffer* buffer : buffers) {
+          for (const EventCopy& event : buffer->Copy()) {
+            json.object([&] {
+              json.attribute("name", names[event.name_id]);
+              json.attribute("pid", 0);
+              json.attribute("tid", buffer->tid());
+              json.attribute("ts", to_us(event.begin));
+              if (event.begin == event.end) {
+                json.attribute("ph", "i");
+                json.attribute("s", "t");
+              } else {
+                json.attribute("ph", "X");
+                json.attribute("dur", to_us(event.end) - to_us(event.begin));
+              }
+            });
+          }
+        }
+      });
+      json.attribute("displayTimeUnit", "ns");
+    });
+  }
+
+ private:
+  struct ThreadState {
+    ~ThreadState() { RingBufferTracingSink::Get()->ReleaseBuffer(buffer); }
+
+    ThreadBuffer* buffer = RingBufferTracingSink::Get()->AcquireBuffer();
+    // Thread local cache of the name table.
+    llvm::StringMap<uint32_t> name_ids;
+    // Begin ticks and name id of the open scopes.
+    llvm::SmallVector<std::pair<uint64_t, uint32_t>, 16> scopes;
+  };
+
+  static ThreadState& GetThreadState() {
+    static thread_local ThreadState state;
+    return state;
+  }
+
+  uint32_t GetNameId(ThreadState& state, const std::string& name) {
+    auto it = state.name_ids.find(name);
+    if (it != state.name_ids.end()) return it->second;
+    uint32_t id = names_.Intern(name);
+    if (id != kOverflowNameId && state.name_ids.size() < kRingBufferMaxNames)
+      state.name_ids.try_emplace(name, id);
+    return id;
+  }
+
+  // Buffers of exited threads are reused, so the number of buffers is bounded
+  // by the number of threads which record activities concurrently. Reused
+  // buffers keep the activities of their previous thread.
+  ThreadBuffer* AcquireBuffer() {
+    mutex_lock lock(mu_);
+    if (!free_buffers_.empty()) return free_buffers_.pop_back_val();
+    all_buffers_.push_back(new ThreadBuffer(all_buffers_.size()));
+    return all_buffers_.back();
+  }
+
+  void ReleaseBuffer(ThreadBuffer* buffer) {
+    mutex_lock lock(mu_);
+    free_buffers_.push_back(buffer);
+  }
+
+  const uint64_t start_ticks_ = ReadTicks();
+  const std::chrono::steady_clock::time_point start_time_ =
+      std::chrono::steady_clock::now();
+
+  NameTable names_;
+
+  mutex mu_;
+  // Buffers are never deleted, so snapshots can read them without the lock.
+  std::vector<ThreadBuffer*> all_buffers_ TFRT_GUARDED_BY(mu_);
+  llvm::SmallVector<ThreadBuffer*, 8> free_buffers_ TFRT_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+void WriteRingBufferTracingSnapshot(raw_ostream& os) {
+  RingBufferTracingSink::Get()->WriteSnapshot(os);
+}
+
+static const bool kRegisterTracingSink = []() {
+  RegisterTracingSink(RingBufferTracingSink::Get());
+  return true;
+}();
+
+}  // namespace tracing
+}  // namespace tfrt
@@ -14,11 +14,16 @@
 
 #include "tfrt/utils/kernel_runner.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
 #include <cstring>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "llvm/Support/Format.h"
 #include "llvm/Support/MathExtras.h"
 #include "tfrt/host_context/async_dispatch.h"
 #include "tfrt/host_context/concurrent_work_queue.h"
@@ -36,12 +41,39 @@
 namespace tfrt {
 namespace {
 
-std::unique_ptr<HostContext> CreateDefaultHostContext() {
+// Forwards to a malloc allocator and counts the allocations.
+class CountingAllocator : public HostAllocator {
+ public:
+  CountingAllocator(std::atomic<int64_t>* allocations,
+                    std::atomic<int64_t>* bytes)
+      : allocator_(CreateMallocAllocator()),
+        allocations_(allocations),
+        bytes_(bytes) {}
+
+  void* AllocateBytes(size_t size, size_t alignment) override {
+    allocations_->fetch_add(1, std::memory_order_relaxed);
+    bytes_->fetch_add(size, std::memory_order_relaxed);
+    return allocator_->AllocateBytes(size, alignment);
+  }
+
+  void DeallocateBytes(void* ptr, size_t size) override {
+    allocator_->DeallocateBytes(ptr, size);
+  }
+
+ private:
+  std::unique_ptr<HostAllocator> allocator_;
+  std::atomic<int64_t>* allocations_;
+  std::atomic<int64_t>* bytes_;
+};
+
+std::unique_ptr<HostContext> CreateDefaultHostContext(
+    std::atomic<int64_t>* allocations, std::atomic<int64_t>* bytes) {
   auto host = std::make_unique<HostContext>(
       [&](const DecodedDiagnostic& diag) {
         llvm::errs() << "Diagnostic: " << diag << "\n";
       },
-      CreateMallocAllocator(), CreateMultiThreadedWorkQueue(4, 4));
+      std::make_unique<CountingAllocator>(allocations, bytes),
+      CreateMultiThreadedWorkQueue(4, 4));
 
   RegisterStaticKernels(host->GetMutableRegistry());
 
@@ -51,7 +83,10 @@ std::unique_ptr<HostContext> CreateDefaultHostContext() {
 }  // namespace
 
 KernelRunner::KernelRunner(string_view name, HostContext* host)
-    : default_host_context_{host ? nullptr : CreateDefaultHostContext()},
+    : default_host_context_{host ? nullptr
+                                 : CreateDefaultHostContext(
+                                       &allocation_counts_.allocations,
+                                       &allocation_counts_.bytes)},
       host_{host ? host : default_host_context_.get()},
       kernel_fn_{[this, name]() -> KernelImplementation {
         const KernelRegistry& reg = host_->GetKernelRegistry();
@@ -86,6 +121,66 @@ void KernelRunner::Run(size_t num_results) {
   }
 }
 
+KernelBenchmarkStats KernelRunner::Benchmark(size_t num_results, int num_runs,
+                                             int num_warmup_runs) {
+  assert(num_runs > 0);
+  for (int i = 0; i < num_warmup_runs; ++i) Run(num_results);
+
+  std::vector<double> run_ns;
+  run_ns.reserve(num_runs);
+  int64_t allocations = 0, bytes = 0;
+  for (int i = 0; i < num_runs; ++i) {
+    // Release the results of the previous run outside of the measurement.
+    results_.clear();
+    sync_results_.clear();
+
+    int64_t start_allocations = allocation_counts_.allocations.load();
+    int64_t start_bytes = allocation_counts_.bytes.load();
+    auto start = std::chrono::steady_clock::now();
+    Run(num_results);
+    auto end = std::chrono::steady_clock::now();
+    allocations += allocation_counts_.allocations.load() - start_allocations;
+    bytes += allocation_counts_.bytes.load() - start_bytes;
+    run_ns.push_back(
+        std::chrono::duration<double, std::nano>(end - start).count());
+  }
+
+  KernelBenchmarkStats stats;
+  stats.num_runs = num_runs;
+  std::sort(run_ns.begin(), run_ns.end());
+  stats.min_ns = run_ns.front();
+  stats.median_ns = run_ns[num_runs / 2];
+  stats.p90_ns = run_ns[std::min(num_runs - 1, num_runs * 9 / 10)];
+  stats.max_ns = run_ns.back();
+  double sum = 0, sum_squares = 0;
+  for (double ns : run_ns) {
+    sum += ns;
+    sum_squares += ns * ns;
+  }
+  stats.mean_ns = sum / num_runs;
+  stats.stddev_ns = std::sqrt(
+      std::max(0.0, sum_squares / num_runs - stats.mean_ns * stats.mean_ns));
+  if (default_host_context_) {
+    stats.allocations_per_run = static_cast<double>(allocations) / num_runs;
+    stats.allocated_bytes_per_run = static_cast<double>(bytes) / num_runs;
+  }
+  return stats;
+}
+
+raw_ostream& operator<<(raw_ostream& os, const KernelBenchmarkStats& stats) {
+  os << llvm::format(
+      "runs: %d, min: %.0f ns, median: %.0f ns, p90: %.0f ns, max: %.0f ns, "
+      "mean: %.0f ns, stddev: %.0f ns",
+      stats.num_runs, stats.min_ns, stats.median_ns, stats.p90_ns,
+      stats.max_ns, stats.mean_ns, stats.stddev_ns);
+  if (stats.allocations_per_run >= 0) {
+    os << llvm::format(", allocations: %.1f (%.0f bytes) per run",
+                       stats.allocations_per_run,
+                       stats.allocated_bytes_per_run);
+  }
+  return os;
+}
+
 KernelRunner& KernelRunner::AddDenseAttribute(const DenseHostTensor& dht) {
   attr_offsets_.emplace_back(
       SerializeDenseHostTensorToDenseAttr(dht, &bef_attr_encoder_));
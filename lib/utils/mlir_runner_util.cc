@@ -41,13 +41,14 @@ namespace tfrt {
 namespace testing {
 namespace {
 
-std::unique_ptr<HostContext> CreateHostContext() {
+std::unique_ptr<HostContext> CreateHostContext(string_view work_queue_config) {
   auto decoded_diagnostic_handler = [&](const DecodedDiagnostic& diag) {
     TFRT_LOG(FATAL) << "Encountered error while executing, aborting: "
                     << diag.message();
   };
   std::unique_ptr<ConcurrentWorkQueue> work_queue =
-      CreateSingleThreadedWorkQueue();
+      CreateWorkQueue(work_queue_config);
+  assert(work_queue && "Invalid work queue config.");
   std::unique_ptr<HostAllocator> host_allocator = CreateMallocAllocator();
   auto host_ctx = std::make_unique<HostContext>(decoded_diagnostic_handler,
                                                 std::move(host_allocator),
@@ -58,7 +59,7 @@ std::unique_ptr<HostContext> CreateHostContext() {
 
 }  // namespace
 
-TfrtMlirRunner::Builder::Builder() : host_context_(CreateHostContext()) {}
+TfrtMlirRunner::Builder::Builder() : host_context_(CreateHostContext("s")) {}
 
 TfrtMlirRunner TfrtMlirRunner::Builder::Compile() {
   assert(!mlir_input_.empty() &&
@@ -76,15 +77,17 @@ TfrtMlirRunner TfrtMlirRunner::Builder::Compile() {
                     host_context_->diag_handler(), host_context_->allocator());
   assert((bef_file->GetFunction(fn_name_)->num_arguments() == inputs_.size()) &&
          "Incorrect number of arguments set.");
-  return TfrtMlirRunner(fn_name_, std::move(bef_buffer), std::move(inputs_));
+  return TfrtMlirRunner(fn_name_, std::move(bef_buffer), std::move(inputs_),
+                        work_queue_config_);
 }
 
 TfrtMlirRunner::TfrtMlirRunner(const std::string& fn_name, BefBuffer bef_buffer,
-                               std::vector<RCReference<AsyncValue>> inputs)
+                               std::vector<RCReference<AsyncValue>> inputs,
+                               string_view work_queue_config)
     : fn_name_(fn_name),
       inputs_(std::move(inputs)),
       bef_buffer_(bef_buffer),
-      host_context_(CreateHostContext()),
+      host_context_(CreateHostContext(work_queue_config)),
       execution_context_(*tfrt::RequestContextBuilder(host_context_.get(),
                                                       resource_context_.get())
                               .build()) {
@@ -101,6 +104,7 @@ llvm::SmallVector<RCReference<AsyncValue>> TfrtMlirRunner::Run() {
   llvm::SmallVector<RCReference<AsyncValue>, 4> results;
   results.resize(func_->result_types().size());
   func_->Execute(execution_context_, input_ptrs_, results);
+  host_context_->Await(results);
   return std::move(results);
 }
 
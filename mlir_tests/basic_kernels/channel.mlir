@@ -0,0 +1,75 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: bef_executor %s.bef | FileCheck %s
+// RUN: bef_executor -work_queue_type=mstd %s.bef | FileCheck %s
+
+// CHECK-LABEL: --- Running 'channel.send_receive'
+func.func @channel.send_receive() -> !tfrt.chain {
+  %ch0 = tfrt.new.chain
+  %channel = tfrt.channel.create { capacity = 1 : i32 }
+
+  %one = tfrt.constant.i32 1
+  %two = tfrt.constant.i32 2
+
+  %ch1 = tfrt.channel.send %channel, %one, %ch0 : i32
+  // The channel is full, so the second value is only accepted once the first
+  // value has been received.
+  %ch2 = tfrt.channel.send %channel, %two, %ch1 : i32
+
+  %x = tfrt.channel.receive %channel, %ch0 : i32
+  %y = tfrt.channel.receive %channel, %ch2 : i32
+
+  // CHECK: int32 = 1
+  %ch3 = tfrt.print.i32 %x, %ch0
+  // CHECK: int32 = 2
+  %ch4 = tfrt.print.i32 %y, %ch3
+
+  %ch5 = tfrt.channel.close %channel, %ch4
+  tfrt.return %ch5 : !tfrt.chain
+}
+
+func.func @produce(%channel : !tfrt.channel, %value : i32) -> !tfrt.chain {
+  %ch0 = tfrt.new.chain
+  %ch1 = tfrt.channel.send %channel, %value, %ch0 : i32
+  %one = tfrt.constant.i32 1
+  %next = tfrt.add.i32 %value, %one
+  %ch2 = tfrt.channel.send %channel, %next, %ch1 : i32
+  %ch3 = tfrt.channel.close %channel, %ch2
+  tfrt.return %ch3 : !tfrt.chain
+}
+
+func.func @consume(%channel : !tfrt.channel) -> i32 {
+  %ch0 = tfrt.new.chain
+  %x = tfrt.channel.receive %channel, %ch0 : i32
+  %ch1 = tfrt.merge.chains %x : i32
+  %y = tfrt.channel.receive %channel, %ch1 : i32
+  %sum = tfrt.add.i32 %x, %y
+  tfrt.return %sum : i32
+}
+
+// CHECK-LABEL: --- Running 'channel.pipeline'
+func.func @channel.pipeline() -> !tfrt.chain {
+  %ch0 = tfrt.new.chain
+  %channel = tfrt.channel.create { capacity = 1 : i32 }
+  %start = tfrt.constant.i32 20
+
+  %sum = tfrt.call @consume(%channel) : (!tfrt.channel) -> i32
+  %done = tfrt.call @produce(%channel, %start)
+      : (!tfrt.channel, i32) -> !tfrt.chain
+
+  // CHECK: int32 = 41
+  %ch1 = tfrt.print.i32 %sum, %done
+  tfrt.return %ch1 : !tfrt.chain
+}
@@ -89,3 +89,37 @@ func.func @parallel_call.fixed_block_size.async() -> !tfrt.chain {
 
   tfrt.return %ch3 : !tfrt.chain
 }
+
+// CHECK-LABEL: --- Running 'parallel_for.nested'
+func.func @parallel_for.nested() -> !tfrt.chain {
+  %start      = tfrt.constant.i32 0
+  %end        = tfrt.constant.i32 10
+  %block_size = tfrt.constant.i32 1
+
+  %cnt = "tfrt_test.atomic.create.i32"() : () -> !test.atomic.i32
+
+  %done = tfrt.parallel_for.i32 %start to %end fixed %block_size, %cnt
+          : !test.atomic.i32 {
+    %s = tfrt.constant.i32 0
+    %e = tfrt.constant.i32 10
+    %bs = tfrt.constant.i32 1
+
+    %inner = tfrt.parallel_for.i32 %s to %e fixed %bs, %cnt
+             : !test.atomic.i32 {
+      %ch0 = tfrt.new.chain
+      %ch1 = "tfrt_test.atomic.add.i32"(%cnt, %s, %ch0)
+             : (!test.atomic.i32, i32, !tfrt.chain) -> !tfrt.chain
+      tfrt.return %ch1 : !tfrt.chain
+    }
+
+    tfrt.return %inner : !tfrt.chain
+  }
+
+  %v, %ch0 = "tfrt_test.atomic.get.i32"(%cnt, %done)
+     : (!test.atomic.i32, !tfrt.chain) -> (i32, !tfrt.chain)
+
+  // CHECK: int32 = 450
+  %ch1 = tfrt.print.i32 %v, %ch0
+
+  tfrt.return %ch1 : !tfrt.chain
+}
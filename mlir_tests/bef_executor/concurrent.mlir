@@ -16,6 +16,10 @@
 
 // RUN: bef_executor_lite %s.bef | FileCheck %s
 // RUN: bef_executor_lite -work_queue_type=mstd %s.bef | FileCheck %s
+// RUN: bef_executor_lite -work_queue_type=mstd -work_stealing %s.bef | FileCheck %s
+// RUN: bef_executor_lite -work_queue_type=mstd:4,4,adaptive %s.bef | FileCheck %s
+// RUN: bef_executor_lite -work_queue_type=mstd:4,4,low_power %s.bef | FileCheck %s
+// RUN: bef_executor_lite -work_queue_type=numa -host_allocator_type=numa_allocator %s.bef | FileCheck %s
 
 // Asynchronously increment %counter once.
 // CHECK-LABEL: async_incs
@@ -143,3 +147,21 @@ func.func @repeated_blocking_sleep2() -> i32 {
   // CHECK: Slept for 1299 microseconds
   tfrt.return %a1 : i32
 }
+
+// Kernels that become ready after the execution is cancelled are short
+// circuited to the cancellation error without running them.
+// CHECK-LABEL: --- Running 'cancelled_fan_out'
+func.func @cancelled_fan_out() -> !tfrt.chain {
+  %ch0 = tfrt.new.chain
+  %x, %ch1 = "tfrt_test.cancel"(%ch0) : (!tfrt.chain) -> (i32, !tfrt.chain)
+
+  // CHECK-NOT: int32 = 0
+  %ch2 = tfrt.print.i32 %x, %ch1
+  %ch3 = tfrt.print.i32 %x, %ch1
+  %ch4 = tfrt.print.i32 %x, %ch1
+  %ch5 = tfrt.print.i32 %x, %ch1
+
+  %ch6 = tfrt.merge.chains %ch2, %ch3, %ch4, %ch5 : !tfrt.chain, !tfrt.chain, !tfrt.chain, !tfrt.chain
+  tfrt.return %ch6 : !tfrt.chain
+}
+// CHECK: 'cancelled_fan_out' returned <<error: Cancelled>>
@@ -0,0 +1,44 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: bef_executor_lite -work_queue_type=mstd %s.bef | FileCheck %s
+// RUN: tfrt_opt %s | tfrt_opt
+
+// A function to demonstrate the use of the load test kernel with requests of
+// mixed priorities.
+
+// CHECK-LABEL: --- Running 'load_test'
+func.func @load_test() {
+  // CHECK: BM:add.i32:Target QPS: 1000
+  // CHECK: BM:add.i32:Achieved QPS:
+  // CHECK: BM:add.i32:Count:
+  // CHECK: BM:add.i32:Errors: 0
+  // CHECK: BM:add.i32:Latency 50%(us):
+  // CHECK: BM:add.i32:Latency 99%(us):
+  // CHECK: BM:add.i32:Latency 99.9%(us):
+  // CHECK: BM:add.i32:Latency Max(us):
+  // CHECK: BM:add.i32/high:Target QPS: 1000
+  // CHECK: BM:add.i32/default:Target QPS: 1000
+
+  %c = tfrt.constant.i32 42
+
+  tfrt_test.load_test "add.i32"(%c : i32)
+    duration_secs = 1, qps = 1000, num_clients = 4, high_priority_percent = 50
+  {
+    %x = "tfrt_test.async_add.i32"(%c, %c) : (i32, i32) -> i32
+    tfrt.return %x : i32
+  }
+
+  tfrt.return
+}
@@ -59,3 +59,16 @@ func.func @strict_kernel_with_error_input() -> (i32, !tfrt.chain) {
 }
 // CHECK-NEXT: int32 = 1
 // CHECK-NEXT: 'strict_kernel_with_error_input' returned <<error: something bad happened>>
+
+// CHECK-LABEL: --- Running 'diamond_with_async_inputs'
+func.func @diamond_with_async_inputs() -> i32 {
+  %one = "tfrt_test.async_constant.i32"() { value = 1 : i32 } : () -> i32
+  %two = "tfrt_test.async_constant.i32"() { value = 2 : i32 } : () -> i32
+
+  %three = tfrt.add.i32 %one, %two
+  %four = tfrt.add.i32 %one, %three
+  %seven = tfrt.add.i32 %three, %four
+
+  tfrt.return %seven : i32
+}
+// CHECK-NEXT: 'diamond_with_async_inputs' returned 7
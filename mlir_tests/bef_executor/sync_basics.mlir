@@ -124,6 +124,33 @@ func.func @test_many_attributes() -> i32 attributes {tfrt.sync} {
   tfrt.return %x : i32
 }
 
+// CHECK-LABEL: --- Running 'test_unused_result'
+func.func @test_unused_result() -> i32 attributes {tfrt.sync} {
+  %0 = "tfrt.constant_s.i32"() {value = 2 : i32} : () -> i32
+  %1 = "tfrt.constant_s.i32"() {value = 3 : i32} : () -> i32
+
+  %unused = "tfrt.add_s.i32"(%0, %1) : (i32, i32) -> i32
+  %x = "tfrt.mul_s.i32"(%0, %1) : (i32, i32) -> i32
+
+  // CHECK-NEXT: 'test_unused_result' returned 6
+  tfrt.return %x : i32
+}
+
+// CHECK-LABEL: --- Running 'test_last_use_args'
+func.func @test_last_use_args() -> i32 attributes {tfrt.sync} {
+  %0 = "tfrt.constant_s.i32"() {value = 0 : i32} : () -> i32
+  %1 = "tfrt.constant_s.i32"() {value = 1 : i32} : () -> i32
+
+  // %0 is used again below, and only the second use of %1 is its last use.
+  %x = "tfrt_test.sync_last_uses"(%0, %1, %1) : (i32, i32, i32) -> i32
+  // %x is used again below.
+  %y = "tfrt_test.sync_last_uses"(%0, %x) : (i32, i32) -> i32
+  %z = "tfrt.add_s.i32"(%x, %y) : (i32, i32) -> i32
+
+  // CHECK-NEXT: 'test_last_use_args' returned 5
+  tfrt.return %z : i32
+}
+
 func.func @test_sync_add(%a: i32, %b: i32) -> i32 attributes {tfrt.sync} {
   %c = "tfrt.add_s.i32"(%a, %b) : (i32, i32) -> i32
   tfrt.return %c : i32
@@ -0,0 +1,207 @@
+# Copyright 2020 The TensorFlow Runtime Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+r"""BEF Executor scaling benchmark driver.
+
+This program runs the benchmark functions in the input MLIR code (see
+bef_perf.py) with work queues of increasing thread counts, and prints a scaling
+report: for each benchmark and work queue type, the median wall time of one
+run, and the speedup and parallel efficiency relative to the smallest thread
+count.
+
+The benchmarks in the report are generated by gen_benchmark_mlir.py. Graphs
+with little parallelism (fully_serial, diamond) show the scheduling overhead,
+graphs with a lot of parallelism (wide_fan_out, random_dag) show how far the
+executor scales.
+
+Usage:
+
+  # Example commands:
+  $ bef_perf=mlir_tests/bef_perf
+  $ bazel build $bef_perf/...
+  $ bazel-bin/$bef_perf/bef_perf_scaling --num_threads=1,2,4,8,16,32,64 \
+      --work_queue_types=mstd,numa --json_output=/tmp/scaling.json \
+      bazel-bin/$bef_perf/*.mlir
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import collections
+import json
+import os
+import sys
+
+from mlir_tests.bef_perf.benchmark_utils import Env  # from @tf_runtime
+
+assert sys.version_info >= (3, 5), \
+    'Detected Python version %s. Please use Python >= 3.5.' % sys.version
+
+BUILD_DIR = 'bazel-bin'
+
+# The metric the scaling report is computed from.
+TIME_METRIC = 'Time 50%(ns)'
+
+
+def _comma_separated(value):
+  return [v for v in value.split(',') if v]
+
+
+def run_scaling_benchmarks(args, mlirs):
+  """Run the benchmarks for all work queue types and thread counts.
+
+  Args:
+    args: The parsed command line arguments.
+    mlirs: A list of MLIR code strings containing the benchmark functions.
+
+  Returns:
+    A dict {benchmark name: {work queue type: {num threads: metrics}}}, where
+    metrics is the performance result dict of one run of the benchmark.
+  """
+  results = collections.defaultdict(lambda: collections.defaultdict(dict))
+  for work_queue_type in args.work_queue_types:
+    for num_threads in args.num_threads:
+      # Blocking threads are not used by the benchmark kernels.
+      config = '{}:{},1'.format(work_queue_type, num_threads)
+      print('Running benchmarks with work queue', config)
+      env = Env(args.tfrt_translate, args.bef_executor,
+                args.host_allocator_type, config)
+      for mlir in mlirs:
+        for name, metrics in env.run_mlir(mlir).items():
+          results[name][work_queue_type][num_threads] = metrics
+  return results
+
+
+def scaling_report(results):
+  """Compute the scaling report from the benchmark results.
+
+  Args:
+    results: The results returned by run_scaling_benchmarks().
+
+  Returns:
+    A list of report rows, one for each benchmark, work queue type and thread
+    count, sorted in this order.
+  """
+  rows = []
+  for name in sorted(results):
+    for work_queue_type in sorted(results[name]):
+      by_threads = results[name][work_queue_type]
+      base_threads = min(by_threads)
+      base_time = int(by_threads[base_threads][TIME_METRIC])
+      for num_threads in sorted(by_threads):
+        time_ns = int(by_threads[num_threads][TIME_METRIC])
+        speedup = base_time / time_ns if time_ns else 0.0
+        rows.append({
+            'benchmark': name,
+            'work_queue_type': work_queue_type,
+            'num_threads': num_threads,
+            'time_ns': time_ns,
+            'speedup': speedup,
+            'efficiency': speedup * base_threads / num_threads,
+        })
+  return rows
+
+
+def print_scaling_report(rows, cpu_info):
+  """Print the scaling report in tabular format.
+
+  An example output is as follows:
+
+  CPU Info: Intel(R) Xeon(R) CPU @ 2.20GHz
+  Num cores: 8
+  Benchmark                 Work queue   Threads   Time 50%(ns)  Speedup ...
+  BM_wide_fan_out_1000         mstd         1        412345       1.00
+  BM_wide_fan_out_1000         mstd         2        213456       1.93
+
+  Args:
+    rows: The rows returned by scaling_report().
+    cpu_info: A dict of cpu info, see Env.get_cpu_info().
+  """
+  print('CPU Info: {}'.format(cpu_info['cpu_info']))
+  print('Num cores: {}'.format(cpu_info['num_cpus']))
+
+  header = ['Work queue', 'Threads', TIME_METRIC, 'Speedup', 'Efficiency']
+  row_format = '{:<30}' + '{:^15}' * len(header)
+  print(row_format.format('Benchmark', *header))
+  for row in rows:
+    print(
+        row_format.format(row['benchmark'], row['work_queue_type'],
+                          row['num_threads'], row['time_ns'],
+                          '{:.2f}'.format(row['speedup']),
+                          '{:.2f}'.format(row['efficiency'])))
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description='Run benchmark functions in the input mlir files with '
+      'increasing numbers of threads and print a scaling report.')
+  parser.add_argument(
+      'mlirs',
+      metavar='MLIRS',
+      nargs='*',
+      type=argparse.FileType('r'),
+      default=[sys.stdin],
+      help='MLIR code containing the functions to be '
+      'benchmarked. Default: STDIN.')
+  parser.add_argument(
+      '--num_threads',
+      type=lambda v: [int(n) for n in _comma_separated(v)],
+      default=[1, 2, 4, 8],
+      help='Comma separated numbers of non-blocking work queue threads.')
+  parser.add_argument(
+      '--work_queue_types',
+      type=_comma_separated,
+      default=['mstd'],
+      help='Comma separated types of multi-threaded work queues (mstd, numa).')
+  parser.add_argument(
+      '--host_allocator_type',
+      default='malloc',
+      help='Type of host allocator (malloc, ...)')
+  parser.add_argument(
+      '--json_output',
+      default='',
+      help='If set, also write the scaling report as JSON to this file.')
+  parser.add_argument(
+      '--tfrt_translate',
+      default=os.path.join(BUILD_DIR, 'tools/tfrt_translate'),
+      help='Path to tfrt_translate')
+  parser.add_argument(
+      '--bef_executor',
+      default=os.path.join(BUILD_DIR, 'tools/bef_executor'),
+      help='Path to bef_executor')
+
+  args = parser.parse_args()
+
+  mlirs = [in_file.read() for in_file in args.mlirs]
+  print('-' * 40)
+  results = run_scaling_benchmarks(args, mlirs)
+  print('-' * 40)
+
+  if not results:
+    print(
+        'Empty result. Please check if MLIR file is correct.', file=sys.stderr)
+    return
+
+  cpu_info = Env.get_cpu_info()
+  rows = scaling_report(results)
+  print_scaling_report(rows, cpu_info)
+
+  if args.json_output:
+    with open(args.json_output, 'w') as f:
+      json.dump({'cpu_info': cpu_info, 'results': rows}, f, indent=2)
+
+
+if __name__ == '__main__':
+  main()
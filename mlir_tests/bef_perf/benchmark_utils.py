@@ -52,6 +52,20 @@ class Env:
       from bef_executor. example:
       {"fully_serial_100" : {"Min(us)" : "252"}, {"50%(us)" : "259"}}
     """
+    return self.parse_bm_output(
+        self.run_mlir_raw(in_str, additional_executor_flags))
+
+  def run_mlir_raw(self, in_str, additional_executor_flags=''):
+    """Execute the given mlir and return the output of bef_executor.
+
+    Args:
+      in_str: an input string, which contains MLIR to be executed.
+      additional_executor_flags: a string, which is the flag being passed to the
+        bef_executor binary.
+
+    Returns:
+      The stdout of bef_executor as a string.
+    """
     cmd = ('{} -mlir-to-bef | {} {} --host_allocator_type={} '
            '--work_queue_type={}').format(self.tfrt_translate,
                                           self.bef_executor,
@@ -66,7 +80,7 @@ class Env:
         stdout=subprocess.PIPE,
         stderr=subprocess.PIPE)
 
-    return self._parse_bm_output(proc.stdout.decode(STR_ENCODING))
+    return proc.stdout.decode(STR_ENCODING)
 
   @staticmethod
   def get_cpu_info():
@@ -95,7 +109,24 @@ class Env:
     return cpu_info
 
   @staticmethod
-  def _parse_bm_output(output: str):
+  def parse_peak_bytes(output: str):
+    """Parse the peak memory usage from the output of bef_executor.
+
+    Args:
+      output: Raw output from bef_executor run with the profiled allocator.
+
+    Returns:
+      The maximum number of bytes allocated by the host allocator, or None if
+      the output has no allocator profile.
+    """
+    # An example output line is:
+    #   Max number of bytes allocated = 1048576
+    match = re.search(r'^Max number of bytes allocated = (\d+)$', output,
+                      re.MULTILINE)
+    return int(match.group(1)) if match else None
+
+  @staticmethod
+  def parse_bm_output(output: str):
     """Parse the output of benchmark kernel.
 
     Args:
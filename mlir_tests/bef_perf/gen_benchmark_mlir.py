@@ -29,6 +29,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import random
+
 from mlir_tests.bef_perf.gen_benchmark_mlir_lib import gen_benchmark_mlir_main  # from @tf_runtime
 from mlir_tests.bef_perf.gen_benchmark_mlir_lib import generate_benchmark_mlir  # from @tf_runtime
 
@@ -207,12 +209,171 @@ def generate_host_tensor(num_kernels):
   return generate_benchmark_mlir('BM_HostTensor_{}'.format(num_kernels), body)
 
 
+def _async_add_line(result, lhs, rhs):
+  return '  %{} = "tfrt_test.async_add.i32"(%{}, %{}) : (i32, i32) -> i32'.format(
+      result, lhs, rhs)
+
+
+def _sum_tree_lines(values, prefix):
+  """Return the lines reducing values with a tree of adds, and the result."""
+  lines = []
+  level = 0
+  while len(values) > 1:
+    reduced = []
+    for i in range(0, len(values) - 1, 2):
+      result = '{}{}_{}'.format(prefix, level, i // 2)
+      lines.append('  %{} = "tfrt.add.i32"(%{}, %{}) : (i32, i32) -> i32'.format(
+          result, values[i], values[i + 1]))
+      reduced.append(result)
+    if len(values) % 2:
+      reduced.append(values[-1])
+    values = reduced
+    level += 1
+  return lines, values[0]
+
+
+def generate_wide_fan_out_mlir(num_kernels):
+  """Generate a wide fan-out DAG with a tree fan-in for benchmarking."""
+
+  body = """
+  // The pseudo-code for this mlir function is as follows:
+  //
+  // c0 = 0
+  // c1 = c0 + c0
+  // c2 = c0 + c0
+  // ...
+  // s = (c1 + c2) + (c3 + c4) + ...
+  //
+  // All c_i's are computed in parallel, and are reduced by a tree of adds
+  // which has a depth logarithmic in the number of c_i's.
+
+  %c0 = tfrt.constant.i32 0
+"""
+
+  values = ['c{}'.format(c + 1) for c in range(num_kernels)]
+  lines = [_async_add_line(v, 'c0', 'c0') for v in values]
+  sum_lines, result = _sum_tree_lines(values, 's')
+  body += '\n'.join(lines + sum_lines)
+  body += '\n  tfrt.return %{} : i32'.format(result)
+
+  return generate_benchmark_mlir('BM_wide_fan_out_{}'.format(num_kernels),
+                                 body)
+
+
+def generate_diamond_mlir(num_kernels):
+  """Generate a chain of diamonds for benchmarking BEFExecutor."""
+
+  body = """
+  // The pseudo-code for this mlir function is as follows:
+  //
+  // d0 = 0
+  // l1 = d0 + d0
+  // r1 = d0 + d0
+  // d1 = l1 + r1
+  // l2 = d1 + d1
+  // ...
+  //
+  // Each diamond forks into two parallel kernels and joins them, so the
+  // executor alternates between one and two ready kernels.
+
+  %d0 = tfrt.constant.i32 0
+"""
+
+  num_diamonds = max(1, num_kernels // 3)
+  lines = []
+  for d in range(num_diamonds):
+    prev = 'd{}'.format(d)
+    lines.append(_async_add_line('l{}'.format(d + 1), prev, prev))
+    lines.append(_async_add_line('r{}'.format(d + 1), prev, prev))
+    lines.append(
+        _async_add_line('d{}'.format(d + 1), 'l{}'.format(d + 1),
+                        'r{}'.format(d + 1)))
+  body += '\n'.join(lines)
+  body += '\n  tfrt.return %d{} : i32'.format(num_diamonds)
+
+  return generate_benchmark_mlir('BM_diamond_{}'.format(num_kernels), body)
+
+
+def generate_random_dag_mlir(num_kernels, window=16):
+  """Generate a random DAG for benchmarking BEFExecutor."""
+
+  body = """
+  // The pseudo-code for this mlir function is as follows:
+  //
+  // c0 = 0
+  // c_i = c_j + c_k for random j, k in [i - window, i)
+  // s = sum of the c_i's which are not used by other kernels
+  //
+  // The DAG is generated with a fixed seed, so that results are comparable
+  // across runs. The window bounds the distance of the dependencies, and
+  // thereby the parallelism of the DAG.
+
+  %c0 = tfrt.constant.i32 0
+"""
+
+  rng = random.Random(num_kernels)
+  used = set()
+  lines = []
+  for c in range(1, num_kernels + 1):
+    lhs = rng.randrange(max(0, c - window), c)
+    rhs = rng.randrange(max(0, c - window), c)
+    used.update([lhs, rhs])
+    lines.append(
+        _async_add_line('c{}'.format(c), 'c{}'.format(lhs), 'c{}'.format(rhs)))
+  sinks = ['c{}'.format(c) for c in range(1, num_kernels + 1) if c not in used]
+  sum_lines, result = _sum_tree_lines(sinks, 's')
+  body += '\n'.join(lines + sum_lines)
+  body += '\n  tfrt.return %{} : i32'.format(result)
+
+  return generate_benchmark_mlir('BM_random_dag_{}'.format(num_kernels), body)
+
+
+def generate_nested_control_flow_mlir(num_kernels):
+  """Generate tfrt.if nested in tfrt.repeat for benchmarking BEFExecutor."""
+
+  body = """
+  // The pseudo-code for this mlir function is as follows:
+  //
+  // v = 0
+  // repeat n times:
+  //   if cond:
+  //     v = (v + 0) + (v + 0)
+  //
+  // Each iteration runs a function for the loop body and one for the taken
+  // branch, which measures the overhead of control flow kernels.
+
+  %v0 = tfrt.constant.i32 0
+  %zero = tfrt.constant.i32 0
+  %cond = tfrt.constant.i1 1
+  %count = tfrt.constant.i32 {count}
+  %res:3 = tfrt.repeat.i32 %count, %v0, %zero, %cond : i32, i32, i1 {{
+    %v1 = tfrt.if %cond, %v0, %zero : (i32, i32) -> (i32) {{
+      %a = "tfrt_test.async_add.i32"(%v0, %zero) : (i32, i32) -> i32
+      %b = "tfrt_test.async_add.i32"(%v0, %zero) : (i32, i32) -> i32
+      %c = "tfrt.add.i32"(%a, %b) : (i32, i32) -> i32
+      tfrt.return %c : i32
+    }} else {{
+      tfrt.return %v0 : i32
+    }}
+    tfrt.return %v1, %zero, %cond : i32, i32, i1
+  }}
+  tfrt.return %res#0 : i32
+""".format(count=max(1, num_kernels // 3))
+
+  return generate_benchmark_mlir(
+      'BM_nested_control_flow_{}'.format(num_kernels), body)
+
+
 def main():
   generator_map = {
       'fully_serial': generate_fully_serial_mlir,
       'fully_parallel': generate_fully_parallel_mlir,
       'star': generate_star_mlir,
       'dense_host_tensor': generate_dense_host_tensor,
+      'wide_fan_out': generate_wide_fan_out_mlir,
+      'diamond': generate_diamond_mlir,
+      'random_dag': generate_random_dag_mlir,
+      'nested_control_flow': generate_nested_control_flow_mlir,
   }
   gen_benchmark_mlir_main(generator_map)
 
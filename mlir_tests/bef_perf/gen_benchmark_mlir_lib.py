@@ -23,13 +23,17 @@ from __future__ import division
 from __future__ import print_function
 
 import argparse
+import textwrap
 
 
 def _indent_lines(s, indentation):
-  """Indent lines in s with the given indentation."""
+  """Indent lines in s with the given indentation.
+
+  The relative indentation of the lines, e.g. of nested regions, is kept.
+  """
   lines = []
-  for line in s.strip().split('\n'):
-    stripped = line.strip()
+  for line in textwrap.dedent(s).strip('\n').split('\n'):
+    stripped = line.rstrip()
     if stripped:
       lines.append(' ' * indentation + stripped)
     else:
@@ -0,0 +1,227 @@
+# Copyright 2022 The TensorFlow Runtime Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+r"""End-to-end model performance regression suite.
+
+This program runs the model benchmarks of the integration tests and the
+backends through bef_executor, and reports for each model:
+  - the steady-state latency percentiles of one request, at batch 1 and batch
+    32 where the model has batch variants,
+  - the throughput with increasing numbers of concurrent requests,
+  - the peak host memory usage, as reported by the profiled allocator,
+  - the BEF load time of the integration test models.
+
+The requests of the integration test models are timed by bef_executor
+--benchmark_runs, the backend benchmarks are timed by the tfrt_test.benchmark
+kernel in the MLIR code. The report is written as JSON with --json_output, so
+that the results of two revisions can be compared.
+
+Usage:
+
+  # Example commands:
+  $ bazel build mlir_tests/bef_perf:model_perf
+  $ bazel-bin/mlir_tests/bef_perf/model_perf --backends=cpu \
+      --in_flight=1,4,16 --json_output=/tmp/model_perf.json
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import collections
+import json
+import os
+import sys
+
+from mlir_tests.bef_perf.benchmark_utils import Env  # from @tf_runtime
+
+assert sys.version_info >= (3, 5), \
+    'Detected Python version %s. Please use Python >= 3.5.' % sys.version
+
+BUILD_DIR = 'bazel-bin'
+
+# A model benchmark of the suite.
+#   name: the name of the model in the report.
+#   backend: cpu, gpu or jitrt.
+#   mlir: the path of the MLIR code, relative to the workspace root.
+#   functions: the functions to time with bef_executor --benchmark_runs, or
+#     None if the functions time themselves with tfrt_test.benchmark.
+#   init_function: the test init function, e.g. to register op handlers.
+Model = collections.namedtuple(
+    'Model', ['name', 'backend', 'mlir', 'functions', 'init_function'])
+
+MODELS = [
+    Model('mnist', 'cpu', 'integrationtest/mnist/mnist.benchmarks.mlir',
+          ['mnist_inference_batch_1', 'mnist_inference_batch_32'], ''),
+    Model('fused_matmul', 'cpu',
+          'backends/cpu/mlir_tests/core_runtime/tf_fusedmatmul.benchmark.mlir',
+          None, 'register_op_handlers_cpu'),
+    Model('conv2d', 'gpu',
+          'backends/gpu/mlir_tests/core_runtime/tf_conv2d.benchmark.mlir',
+          None, 'register_op_handlers_gpu'),
+    Model('fused_batch_norm', 'gpu',
+          'backends/gpu/mlir_tests/core_runtime/'
+          'tf_fusedbatchnorm.benchmark.mlir', None, 'register_op_handlers_gpu'),
+    Model('compile_corert', 'jitrt',
+          'backends/jitrt/mlir_tests/jitrt/benchmark.compile.corert.mlir',
+          None, 'register_op_handlers_cpu'),
+]
+
+
+def _comma_separated(value):
+  return [v for v in value.split(',') if v]
+
+
+def run_model(args, env, model, in_flight):
+  """Run the benchmarks of one model with `in_flight` concurrent requests.
+
+  Args:
+    args: The parsed command line arguments.
+    env: The Env to run the model with.
+    model: The Model to run.
+    in_flight: The maximum number of requests in flight.
+
+  Returns:
+    A dict {benchmark name: metrics}, where 'host_allocator' holds the peak
+    memory usage and, for the models timed by bef_executor, 'bef_file' the
+    load time.
+  """
+  flags = []
+  if model.init_function:
+    flags.append('--test_init_function=' + model.init_function)
+  if model.functions:
+    flags.append('--functions=' + ','.join(model.functions))
+    flags.append('--benchmark_runs={}'.format(args.benchmark_runs))
+    flags.append('--max_in_flight={}'.format(in_flight))
+
+  with open(model.mlir) as f:
+    output = env.run_mlir_raw(f.read(), ' '.join(flags))
+
+  results = Env.parse_bm_output(output)
+  peak_bytes = Env.parse_peak_bytes(output)
+  if peak_bytes is not None:
+    results['host_allocator']['Peak Bytes'] = peak_bytes
+  return results
+
+
+def run_suite(args):
+  """Run the model benchmarks of the selected backends.
+
+  Args:
+    args: The parsed command line arguments.
+
+  Returns:
+    A list of report rows, one for each model and number of requests in
+    flight, with the metrics of all benchmarks of the model.
+  """
+  translates = {
+      'cpu': args.tfrt_translate,
+      'gpu': args.tfrt_gpu_translate,
+      'jitrt': args.tfrt_translate,
+  }
+  rows = []
+  for model in MODELS:
+    if model.backend not in args.backends:
+      continue
+    env = Env(translates[model.backend], args.bef_executor,
+              'profiled_allocator', args.work_queue_type)
+    # The backend benchmarks don't depend on the number of requests in flight.
+    for in_flight in args.in_flight if model.functions else [1]:
+      print('Running', model.name, 'with', in_flight, 'in flight')
+      rows.append({
+          'model': model.name,
+          'backend': model.backend,
+          'in_flight': in_flight,
+          'results': run_model(args, env, model, in_flight),
+      })
+  return rows
+
+
+def print_report(rows, cpu_info):
+  """Print the report rows, one line per benchmark metric."""
+  print('CPU Info: {}'.format(cpu_info['cpu_info']))
+  print('Num cores: {}'.format(cpu_info['num_cpus']))
+  row_format = '{:<20}{:^8}{:^10}{:<35}{:<25}{:>15}'
+  print(
+      row_format.format('Model', 'Backend', 'In flight', 'Benchmark', 'Metric',
+                        'Value'))
+  for row in rows:
+    for name, metrics in row['results'].items():
+      for metric, value in metrics.items():
+        print(
+            row_format.format(row['model'], row['backend'], row['in_flight'],
+                              name, metric, value))
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description='Run the model benchmarks and report latency, throughput, '
+      'peak memory and load time.')
+  parser.add_argument(
+      '--backends',
+      type=_comma_separated,
+      default=['cpu'],
+      help='Comma separated backends to run the models of (cpu, gpu, jitrt).')
+  parser.add_argument(
+      '--in_flight',
+      type=lambda v: [int(n) for n in _comma_separated(v)],
+      default=[1, 4, 16],
+      help='Comma separated numbers of concurrent requests.')
+  parser.add_argument(
+      '--benchmark_runs',
+      type=int,
+      default=1000,
+      help='Number of timed requests of each model function.')
+  parser.add_argument(
+      '--work_queue_type',
+      default='mstd',
+      help='Type of work queue (s, mstd, ...)')
+  parser.add_argument(
+      '--json_output',
+      default='',
+      help='If set, also write the report as JSON to this file.')
+  parser.add_argument(
+      '--tfrt_translate',
+      default=os.path.join(BUILD_DIR, 'tools/tfrt_translate'),
+      help='Path to tfrt_translate')
+  parser.add_argument(
+      '--tfrt_gpu_translate',
+      default=os.path.join(BUILD_DIR, 'backends/gpu/tfrt_gpu_translate'),
+      help='Path to tfrt_gpu_translate, used for the gpu models')
+  parser.add_argument(
+      '--bef_executor',
+      default=os.path.join(BUILD_DIR, 'tools/bef_executor'),
+      help='Path to bef_executor')
+
+  args = parser.parse_args()
+
+  print('-' * 40)
+  rows = run_suite(args)
+  print('-' * 40)
+
+  if not rows:
+    print('No models to run. Please check --backends.', file=sys.stderr)
+    return
+
+  cpu_info = Env.get_cpu_info()
+  print_report(rows, cpu_info)
+
+  if args.json_output:
+    with open(args.json_output, 'w') as f:
+      json.dump({'cpu_info': cpu_info, 'results': rows}, f, indent=2)
+
+
+if __name__ == '__main__':
+  main()
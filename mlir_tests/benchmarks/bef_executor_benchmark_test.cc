@@ -0,0 +1,171 @@
+/*
+ * Copyright 2022 The TensorFlow Runtime Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks of the per-kernel overhead of the BEFExecutor.
+//
+// Run with --benchmark_out=<file> --benchmark_out_format=json to record the
+// results for regression tracking. items_per_second is the number of executed
+// kernels per second.
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "llvm/Support/raw_ostream.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "tfrt/basic_kernels/opdefs/tfrt_base.h"
+#include "tfrt/support/forward_decls.h"
+#include "tfrt/test_kernels/opdefs/test_kernels.h"
+#include "tfrt/utils/mlir_runner_util.h"
+
+namespace tfrt {
+namespace testing {
+namespace {
+
+// Kernel that returns its result synchronously.
+constexpr char kSyncAdd[] = "tfrt.add.i32";
+// Kernel that computes its result in a task enqueued to the work queue.
+constexpr char kAsyncAdd[] = "tfrt_test.async_add.i32";
+
+constexpr char kSingleThreaded[] = "s";
+constexpr char kMultiThreaded[] = "mstd:4,1";
+
+// Cost threshold that merges all kernels of a function into one stream, so
+// that they are all executed inline by the thread running the function.
+constexpr int64_t kInlineCostThreshold = 1 << 30;
+
+// Prints `kernel` adding `lhs` and `rhs` into `result`.
+static void PrintAdd(raw_ostream& os, string_view kernel, string_view result,
+                     string_view lhs, string_view rhs) {
+  os << "  " << result << " = \"" << kernel << "\"(" << lhs << ", " << rhs
+     << ") : (i32, i32) -> i32\n";
+}
+
+// Returns a function running a chain of `num_kernels` dependent kernels.
+static std::string KernelChain(string_view kernel, int num_kernels) {
+  std::string mlir;
+  llvm::raw_string_ostream os(mlir);
+  os << "func.func @main(%arg0: i32) -> i32 {\n";
+  std::string prev = "%arg0";
+  for (int i = 0; i < num_kernels; ++i) {
+    std::string value = "%v" + std::to_string(i);
+    PrintAdd(os, kernel, value, prev, "%arg0");
+    prev = value;
+  }
+  os << "  tfrt.return " << prev << " : i32\n}\n";
+  return os.str();
+}
+
+// Returns a function running `width` independent kernels whose results are
+// reduced by a tree of `width - 1` kernels. With `outline`, the independent
+// kernels are put in separate streams, and all but one are enqueued to the
+// work queue.
+static std::string FanOutFanIn(string_view kernel, int width, bool outline) {
+  std::string mlir;
+  llvm::raw_string_ostream os(mlir);
+  int64_t cost_threshold = outline ? 1 : kInlineCostThreshold;
+  os << "module attributes {tfrt.cost_threshold = " << cost_threshold
+     << " : i64} {\n";
+  os << "func.func @main(%arg0: i32) -> i32 {\n";
+  std::vector<std::string> values;
+  for (int i = 0; i < width; ++i) {
+    values.push_back("%v" + std::to_string(i));
+    PrintAdd(os, kernel, values.back(), "%arg0", "%arg0");
+  }
+  for (int i = 0; values.size() > 1; ++i) {
+    std::vector<std::string> reduced;
+    for (size_t j = 0; j + 1 < values.size(); j += 2) {
+      reduced.push_back("%r" + std::to_string(i) + "_" + std::to_string(j));
+      PrintAdd(os, kSyncAdd, reduced.back(), values[j], values[j + 1]);
+    }
+    if (values.size() % 2) reduced.push_back(values.back());
+    values = std::move(reduced);
+  }
+  os << "  tfrt.return " << values[0] << " : i32\n}\n}\n";
+  return os.str();
+}
+
+// Runs the `main` function of `mlir_input` in each iteration, and reports
+// `num_kernels` processed items per iteration.
+static void RunFunction(benchmark::State& state, const std::string& mlir_input,
+                        string_view work_queue_config, int num_kernels) {
+  mlir::MLIRContext context;
+  mlir::DialectRegistry registry;
+  registry.insert<compiler::TFRTDialect, mlir::func::FuncDialect,
+                  test::TestDialect>();
+  context.appendDialectRegistry(registry);
+
+  TfrtMlirRunner::Builder builder;
+  builder.set_mlir_fn_name("main")
+      .set_mlir_input(mlir_input)
+      .set_work_queue_config(work_queue_config)
+      .add_input<int32_t>(0)
+      .set_mlir_context(&context);
+  TfrtMlirRunner runner = builder.Compile();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(runner.Run());
+  }
+  state.SetItemsProcessed(state.iterations() * num_kernels);
+}
+
+void BM_SyncKernelChain(benchmark::State& state) {
+  int num_kernels = state.range(0);
+  RunFunction(state, KernelChain(kSyncAdd, num_kernels), kSingleThreaded,
+              num_kernels);
+}
+BENCHMARK(BM_SyncKernelChain)->Arg(1)->Arg(100);
+
+void BM_AsyncKernelChain(benchmark::State& state) {
+  int num_kernels = state.range(0);
+  RunFunction(state, KernelChain(kAsyncAdd, num_kernels), kSingleThreaded,
+              num_kernels);
+}
+BENCHMARK(BM_AsyncKernelChain)->Arg(1)->Arg(100);
+
+void BM_AsyncKernelChainMultiThreaded(benchmark::State& state) {
+  int num_kernels = state.range(0);
+  RunFunction(state, KernelChain(kAsyncAdd, num_kernels), kMultiThreaded,
+              num_kernels);
+}
+BENCHMARK(BM_AsyncKernelChainMultiThreaded)->Arg(1)->Arg(100);
+
+void BM_InlineFanOutFanIn(benchmark::State& state) {
+  int width = state.range(0);
+  RunFunction(state, FanOutFanIn(kSyncAdd, width, /*outline=*/false),
+              kMultiThreaded, 2 * width - 1);
+}
+BENCHMARK(BM_InlineFanOutFanIn)->Arg(8)->Arg(64);
+
+void BM_OutlineFanOutFanIn(benchmark::State& state) {
+  int width = state.range(0);
+  RunFunction(state, FanOutFanIn(kSyncAdd, width, /*outline=*/true),
+              kMultiThreaded, 2 * width - 1);
+}
+BENCHMARK(BM_OutlineFanOutFanIn)->Arg(8)->Arg(64);
+
+void BM_AsyncFanOutFanIn(benchmark::State& state) {
+  int width = state.range(0);
+  RunFunction(state, FanOutFanIn(kAsyncAdd, width, /*outline=*/true),
+              kMultiThreaded, 2 * width - 1);
+}
+BENCHMARK(BM_AsyncFanOutFanIn)->Arg(8)->Arg(64);
+
+}  // namespace
+}  // namespace testing
+}  // namespace tfrt
@@ -0,0 +1,70 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_opt -tfrt-fuse-sync-kernels %s | FileCheck %s
+
+// CHECK-LABEL: func @chain
+// CHECK-SAME: ([[ch:%.*]]: !tfrt.chain, [[x:%.*]]: i32)
+func.func @chain(%ch: !tfrt.chain, %x: i32) -> (!tfrt.chain, i32) {
+  // CHECK-NEXT: [[r:%.*]]:2 = tfrt.call @chain_fused([[x]]) : (i32) -> (i32, i32)
+  %one = tfrt.constant.i32 1
+  %a = "tfrt.add.i32"(%x, %one) : (i32, i32) -> i32
+  %b = "tfrt.mul.i32"(%a, %a) : (i32, i32) -> i32
+  %c = "tfrt.add.i32"(%b, %one) : (i32, i32) -> i32
+
+  // CHECK-NEXT: [[ch1:%.*]] = tfrt.print.i32 [[r]]#0, [[ch]]
+  %ch1 = tfrt.print.i32 %a, %ch
+
+  // CHECK-NEXT: tfrt.return [[ch1]], [[r]]#1 : !tfrt.chain, i32
+  tfrt.return %ch1, %c : !tfrt.chain, i32
+}
+
+// CHECK: func @chain_fused([[arg:%.*]]: i32) -> (i32, i32) attributes {tfrt.sync}
+// CHECK-NEXT: [[one:%.*]] = "tfrt.constant_s.i32"() {value = 1 : i32} : () -> i32
+// CHECK-NEXT: [[a:%.*]] = "tfrt.add_s.i32"([[arg]], [[one]])
+// CHECK-NEXT: [[b:%.*]] = "tfrt.mul_s.i32"([[a]], [[a]])
+// CHECK-NEXT: [[c:%.*]] = "tfrt.add_s.i32"([[b]], [[one]])
+// CHECK-NEXT: tfrt.return [[a]], [[c]] : i32, i32
+
+// A single kernel is not worth a call.
+// CHECK-LABEL: func @single
+func.func @single(%x: i32) -> i32 {
+  // CHECK-NEXT: "tfrt.add.i32"
+  %a = "tfrt.add.i32"(%x, %x) : (i32, i32) -> i32
+  tfrt.return %a : i32
+}
+
+// Kernels without sync implementations split chains.
+// CHECK-LABEL: func @split
+func.func @split(%ch: !tfrt.chain) -> !tfrt.chain {
+  // CHECK-NEXT: [[x:%.*]] = tfrt.call @split_fused() : () -> i32
+  %one = tfrt.constant.i32 1
+  %x = "tfrt.add.i32"(%one, %one) : (i32, i32) -> i32
+  // CHECK-NEXT: tfrt.print.i32 [[x]]
+  %ch1 = tfrt.print.i32 %x, %ch
+  // CHECK-NEXT: tfrt.call @split_fused_0([[x]]) : (i32) -> i32
+  %two = tfrt.constant.i32 2
+  %y = "tfrt.mul.i32"(%x, %two) : (i32, i32) -> i32
+  %ch2 = tfrt.print.i32 %y, %ch1
+  tfrt.return %ch2 : !tfrt.chain
+}
+
+// Sync functions are left alone.
+// CHECK-LABEL: func @sync
+func.func @sync(%x: i32) -> i32 attributes {tfrt.sync} {
+  // CHECK-NEXT: "tfrt.constant_s.i32"
+  %one = "tfrt.constant_s.i32"() {value = 1 : i32} : () -> i32
+  %a = "tfrt.add_s.i32"(%x, %one) : (i32, i32) -> i32
+  tfrt.return %a : i32
+}
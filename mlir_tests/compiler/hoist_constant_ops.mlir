@@ -0,0 +1,50 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_opt -tfrt-hoist-constant-corert-ops %s | FileCheck %s
+
+// CHECK-LABEL: func @weights
+// CHECK-SAME: ([[ch0:%.*]]: !tfrt.chain, [[x:%.*]]: !corert.tensorhandle)
+func.func @weights(%ch0: !tfrt.chain, %x: !corert.tensorhandle) -> !corert.tensorhandle {
+  // CHECK-NEXT: [[cpu:%.*]] = corert.get_op_handler [[ch0]] "cpu"
+  %cpu = corert.get_op_handler %ch0 "cpu"
+
+  // CHECK-NEXT: [[w:%.*]] = tfrt.once @weights_once([[cpu]]) : (!corert.ophandler) -> (!corert.tensorhandle)
+  %w = corert.const_dense_tensor dense<[1.0, 2.0, 3.0, 4.0]> : tensor<4xf32>
+  %shape = corert.const_dense_tensor dense<[2, 2]> : tensor<2xi64>
+  %r = corert.executeop(%cpu) "tf.Reshape"(%w, %shape) : 1
+  %t = corert.executeop(%cpu) "tf.Transpose"(%r) : 1
+
+  // CHECK-NEXT: [[y:%.*]] = corert.executeop([[cpu]]) "tf.MatMul"([[x]], [[w]])
+  %y = corert.executeop(%cpu) "tf.MatMul"(%x, %t) : 1
+
+  // CHECK-NEXT: tfrt.return [[y]]
+  tfrt.return %y : !corert.tensorhandle
+}
+
+// CHECK: func @weights_once([[arg:%.*]]: !corert.ophandler) -> !corert.tensorhandle
+// CHECK-NEXT: [[w:%.*]] = corert.const_dense_tensor
+// CHECK-NEXT: [[shape:%.*]] = corert.const_dense_tensor
+// CHECK-NEXT: [[r:%.*]] = corert.executeop([[arg]]) "tf.Reshape"([[w]], [[shape]])
+// CHECK-NEXT: [[t:%.*]] = corert.executeop([[arg]]) "tf.Transpose"([[r]])
+// CHECK-NEXT: tfrt.return [[t]]
+
+// Ops with non-constant operands are left alone.
+// CHECK-LABEL: func @no_constants
+func.func @no_constants(%ch0: !tfrt.chain, %x: !corert.tensorhandle) -> !corert.tensorhandle {
+  // CHECK-NOT: tfrt.once
+  %cpu = corert.get_op_handler %ch0 "cpu"
+  %y = corert.executeop(%cpu) "tf.Relu"(%x) : 1
+  tfrt.return %y : !corert.tensorhandle
+}
@@ -0,0 +1,91 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_opt -tfrt-inline-trivial-branches %s | FileCheck %s
+
+// CHECK-LABEL: func @if_add
+// CHECK-SAME: ([[cond:%.*]]: i1, [[x:%.*]]: i32, [[y:%.*]]: i32)
+func.func @if_add(%cond: i1, %x: i32, %y: i32) -> i32 {
+  // CHECK-NEXT: [[sum:%.*]] = tfrt.add.i32 [[x]], [[y]]
+  // CHECK-NEXT: [[res:%.*]] = tfrt.select [[cond]], [[sum]], [[x]] : i32
+  // CHECK-NEXT: tfrt.return [[res]] : i32
+  %res = tfrt.if %cond, %x, %y : (i32, i32) -> (i32) {
+    %sum = tfrt.add.i32 %x, %y
+    tfrt.return %sum : i32
+  } else {
+    tfrt.return %x : i32
+  }
+  tfrt.return %res : i32
+}
+
+// CHECK-LABEL: func @if_same_value
+// CHECK-SAME: ([[cond:%.*]]: i1, [[ch:%.*]]: !tfrt.chain)
+func.func @if_same_value(%cond: i1, %ch: !tfrt.chain) -> !tfrt.chain {
+  // CHECK-NEXT: tfrt.return [[ch]] : !tfrt.chain
+  %res = tfrt.if %cond, %ch : (!tfrt.chain) -> (!tfrt.chain) {
+    tfrt.return %ch : !tfrt.chain
+  } else {
+    tfrt.return %ch : !tfrt.chain
+  }
+  tfrt.return %res : !tfrt.chain
+}
+
+func.func @true_fn(%x: i32) -> i32 {
+  %one = tfrt.constant.i32 1
+  %res = tfrt.add.i32 %x, %one
+  tfrt.return %res : i32
+}
+
+func.func @false_fn(%x: i32) -> i32 {
+  tfrt.return %x : i32
+}
+
+// CHECK-LABEL: func @cond
+// CHECK-SAME: ([[cond:%.*]]: i1, [[x:%.*]]: i32)
+func.func @cond(%cond: i1, %x: i32) -> i32 {
+  // CHECK-NEXT: [[one:%.*]] = tfrt.constant.i32 1
+  // CHECK-NEXT: [[inc:%.*]] = tfrt.add.i32 [[x]], [[one]]
+  // CHECK-NEXT: [[res:%.*]] = tfrt.select [[cond]], [[inc]], [[x]] : i32
+  // CHECK-NEXT: tfrt.return [[res]] : i32
+  %res = tfrt.cond %cond @true_fn @false_fn (%x) : (i32) -> (i32)
+  tfrt.return %res : i32
+}
+
+// CHECK-LABEL: func @side_effects
+func.func @side_effects(%cond: i1, %ch: !tfrt.chain, %x: i32) -> !tfrt.chain {
+  // CHECK: tfrt.if
+  %res = tfrt.if %cond, %ch, %x : (!tfrt.chain, i32) -> (!tfrt.chain) {
+    %ch1 = tfrt.print.i32 %x, %ch
+    tfrt.return %ch1 : !tfrt.chain
+  } else {
+    tfrt.return %ch : !tfrt.chain
+  }
+  tfrt.return %res : !tfrt.chain
+}
+
+// CHECK-LABEL: func @too_large
+func.func @too_large(%cond: i1, %x: i32) -> i32 {
+  // CHECK: tfrt.if
+  %res = tfrt.if %cond, %x : (i32) -> (i32) {
+    %0 = tfrt.add.i32 %x, %x
+    %1 = tfrt.add.i32 %0, %0
+    %2 = tfrt.add.i32 %1, %1
+    %3 = tfrt.add.i32 %2, %2
+    %4 = tfrt.add.i32 %3, %3
+    tfrt.return %4 : i32
+  } else {
+    tfrt.return %x : i32
+  }
+  tfrt.return %res : i32
+}
@@ -0,0 +1,71 @@
+// Copyright 2021 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tfrt_opt -tfrt-optimize-chains="read-only-ops=tf.ReadVariableOp" %s | FileCheck %s
+
+// CHECK-LABEL: func @flatten_merges
+// CHECK-SAME: ([[a:%.*]]: !tfrt.chain, [[b:%.*]]: !tfrt.chain, [[c:%.*]]: !tfrt.chain)
+func.func @flatten_merges(%a: !tfrt.chain, %b: !tfrt.chain, %c: !tfrt.chain) -> !tfrt.chain {
+  // CHECK-NEXT: [[m:%.*]] = tfrt.merge.chains [[a]], [[b]], [[c]] : !tfrt.chain, !tfrt.chain, !tfrt.chain
+  // CHECK-NEXT: tfrt.return [[m]]
+  %new = tfrt.new.chain
+  %ab = tfrt.merge.chains %a, %b, %new : !tfrt.chain, !tfrt.chain, !tfrt.chain
+  %bc = tfrt.merge.chains %b, %c : !tfrt.chain, !tfrt.chain
+  %abc = tfrt.merge.chains %ab, %bc, %a : !tfrt.chain, !tfrt.chain, !tfrt.chain
+  tfrt.return %abc : !tfrt.chain
+}
+
+// CHECK-LABEL: func @forward_single_chain
+// CHECK-SAME: ([[a:%.*]]: !tfrt.chain)
+func.func @forward_single_chain(%a: !tfrt.chain) -> !tfrt.chain {
+  // CHECK-NEXT: tfrt.return [[a]]
+  %new = tfrt.new.chain
+  %m0 = tfrt.merge.chains %a, %a : !tfrt.chain, !tfrt.chain
+  %m1 = tfrt.merge.chains %m0, %new : !tfrt.chain, !tfrt.chain
+  tfrt.return %m1 : !tfrt.chain
+}
+
+// CHECK-LABEL: func @remove_unused_chains
+func.func @remove_unused_chains(%a: !tfrt.chain, %x: i32) -> !tfrt.chain {
+  // CHECK-NEXT: [[m:%.*]] = tfrt.merge.chains %arg1 : i32
+  // CHECK-NEXT: tfrt.return [[m]]
+  %new = tfrt.new.chain
+  %unused = tfrt.merge.chains %a, %new : !tfrt.chain, !tfrt.chain
+  %m = tfrt.merge.chains %x : i32
+  tfrt.return %m : !tfrt.chain
+}
+
+// CHECK-LABEL: func @relax_reads
+// CHECK-SAME: ([[ch0:%.*]]: !tfrt.chain, [[v:%.*]]: !corert.tensorhandle)
+func.func @relax_reads(%ch0: !tfrt.chain, %v: !corert.tensorhandle) -> !tfrt.chain {
+  // CHECK-NEXT: [[cpu:%.*]] = corert.get_op_handler
+  %cpu = corert.get_op_handler %ch0 "cpu"
+
+  // CHECK-NEXT: [[w0:%.*]] = corert.executeop.seq([[cpu]], [[ch0]]) "tf.AssignVariableOp"
+  %ch1 = corert.executeop.seq(%cpu, %ch0) "tf.AssignVariableOp"(%v, %v) : 0
+
+  // CHECK-NEXT: [[r0:%.*]], {{.*}} = corert.executeop.seq([[cpu]], [[w0]]) "tf.ReadVariableOp"
+  // CHECK-NEXT: [[r1:%.*]], {{.*}} = corert.executeop.seq([[cpu]], [[w0]]) "tf.ReadVariableOp"
+  // CHECK-NEXT: [[r2:%.*]], {{.*}} = corert.executeop.seq([[cpu]], [[w0]]) "tf.ReadVariableOp"
+  // CHECK-NEXT: [[m:%.*]] = tfrt.merge.chains [[r0]], [[r1]], [[r2]]
+  %ch2, %r0 = corert.executeop.seq(%cpu, %ch1) "tf.ReadVariableOp"(%v) : 1
+  %ch3, %r1 = corert.executeop.seq(%cpu, %ch2) "tf.ReadVariableOp"(%v) : 1
+  %ch4, %r2 = corert.executeop.seq(%cpu, %ch3) "tf.ReadVariableOp"(%v) : 1
+
+  // CHECK-NEXT: [[w1:%.*]] = corert.executeop.seq([[cpu]], [[m]]) "tf.AssignVariableOp"
+  %ch5 = corert.executeop.seq(%cpu, %ch4) "tf.AssignVariableOp"(%v, %r2) : 0
+
+  // CHECK-NEXT: tfrt.return [[w1]]
+  tfrt.return %ch5 : !tfrt.chain
+}
@@ -0,0 +1,47 @@
+// Copyright 2020 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: bef_executor %s.bef 2>&1 | FileCheck %s
+
+// CHECK-LABEL: --- Not running 'register_op_handlers' because it has arguments.
+func.func @register_op_handlers(%ch0: !tfrt.chain) -> !tfrt.chain {
+  %null = "corert.create_null_op_handler"() : () -> !corert.ophandler
+  %cpu = "corert.create_cpu_op_handler"(%null) : (!corert.ophandler) -> !corert.ophandler
+  %op_handler = "corert.create_sampled_logging_op_handler"(%cpu) {sample_rate=1 : i32} : (!corert.ophandler) -> !corert.ophandler
+  %ch = corert.register_op_handler %op_handler "sampled_logging"
+  tfrt.return %ch : !tfrt.chain
+}
+
+// CHECK-LABEL: --- Running 'test_sampled_logger'
+func.func @test_sampled_logger() -> !tfrt.chain {
+  %ch0 = tfrt.new.chain
+  %ch1 = tfrt.call @register_op_handlers(%ch0) : (!tfrt.chain) -> !tfrt.chain
+  %log = corert.get_op_handler %ch1 "sampled_logging"
+
+  // The sampled mode does not log the tensor contents.
+  // CHECK-NOT: dispatch 'tfrt_test.create_dense_tensor'
+  %a_handle = corert.executeop(%log)
+      "tfrt_test.create_dense_tensor"() { shape = [5], values = [1 : i32, 2 : i32, 3 : i32, 4 : i32, 5 : i32] } : 1
+
+  %b_handle = corert.executeop(%log) "tfrt_test.odd_collector"(%a_handle) : 1
+
+  // CHECK: DenseHostTensor dtype = i32, shape = [3], values = [1, 3, 5]
+  %ch3 = "corert.print_tensorhandle"(%b_handle, %ch0) : (!corert.tensorhandle, !tfrt.chain) -> !tfrt.chain
+
+  tfrt.return %ch3 : !tfrt.chain
+}
+
+// Samples are logged when the op handler is destroyed at the latest.
+// CHECK: [sampled] 'tfrt_test.create_dense_tensor' device CPU:0, inputs ()
+// CHECK: [sampled] 'tfrt_test.odd_collector' device CPU:0, inputs (i32 [5])
@@ -98,3 +98,33 @@ func.func @basic_f32_tensor() {
 
   tfrt.return
 }
+
+// CHECK-LABEL: --- Running 'csr_tensor'
+func.func @csr_tensor() {
+  %c0 = tfrt.new.chain
+
+  %a = tfrt_dht.create_uninitialized_tensor.f32.2 [2 : i64, 3 : i64]
+  %c1 = tfrt_dht.set_tensor_with_constant_values.f32 %a, %c0
+    [0.0 : f32, 2.0 : f32, 0.0 : f32, 1.0 : f32, 0.0 : f32, 3.0 : f32]
+  %s, %c2 = coo.convert_dht_to_coo.f32.2 %a, %c1
+  %csr, %c3 = coo.convert_coo_to_csr.f32 %s, %c2
+
+  // CHECK: CsrHostTensor dtype = f32, shape = [2, 3], row_offsets = [0, 1, 3], col_indices = [1, 0, 2], values = [2.000000e+00, 1.000000e+00, 3.000000e+00]
+  %c4 = tfrt_dht.print_tensor %csr, %c3
+
+  %d, %c5 = coo.convert_csr_to_dht.f32 %csr, %c4
+  %cmp, %c6 = tfrt_dht.tensor_equal.f32 %a, %d, %c5
+
+  // CHECK: int1 = 1
+  %c7 = "tfrt.print.i1"(%cmp, %c6) : (i1, !tfrt.chain) -> (!tfrt.chain)
+
+  %b = tfrt_dht.create_uninitialized_tensor.f32.2 [3 : i64, 2 : i64]
+  %c8 = tfrt_dht.set_tensor_with_constant_values.f32 %b, %c7
+    [1.0 : f32, 2.0 : f32, 3.0 : f32, 4.0 : f32, 5.0 : f32, 6.0 : f32]
+  %p, %c9 = coo.csr_matmul.f32 %csr, %b, %c8
+
+  // CHECK: DenseHostTensor dtype = f32, shape = [2, 2], values = [6.000000e+00, 8.000000e+00, 1.600000e+01, 2.000000e+01]
+  %c10 = tfrt_dht.print_tensor %p, %c9
+
+  tfrt.return
+}
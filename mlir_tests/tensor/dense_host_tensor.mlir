@@ -245,3 +245,42 @@ func.func @test_type_parsing() {
 
   tfrt.return
 }
+
+// CHECK-LABEL: --- Running 'quantize_int4'
+func.func @quantize_int4() {
+  %c0 = tfrt.new.chain
+
+  %a = tfrt_dht.create_uninitialized_tensor.f32.1 [5 : i64]
+  %c1 = tfrt_dht.set_tensor_with_constant_values.f32 %a, %c0
+    [1.0 : f32, -2.0 : f32, 3.5 : f32, 100.0 : f32, -100.0 : f32]
+
+  %q, %c2 = tfrt_dht.quantize.i4 %a, %c1 {scale = 0.5 : f32, zero_point = 0 : i32}
+  // CHECK: DenseHostTensor dtype = i4, shape = [5], values = [i4(2), i4(-4), i4(7), i4(7), i4(-8)]
+  %c3 = tfrt_dht.print_tensor %q, %c2
+
+  %r, %c4 = tfrt_dht.requantize.i4 %q, %c3 {in_scale = 0.5 : f32, in_zero_point = 0 : i32, out_scale = 1.0 : f32, out_zero_point = 0 : i32}
+  // CHECK: DenseHostTensor dtype = i4, shape = [5], values = [i4(1), i4(-2), i4(4), i4(4), i4(-4)]
+  %c5 = tfrt_dht.print_tensor %r, %c4
+
+  %d, %c6 = tfrt_dht.dequantize.i4 %q, %c5 {scale = 0.5 : f32, zero_point = 0 : i32}
+  // CHECK: DenseHostTensor dtype = f32, shape = [5], values = [1.000000e+00, -2.000000e+00, 3.500000e+00, 3.500000e+00, -4.000000e+00]
+  %c7 = tfrt_dht.print_tensor %d, %c6
+
+  tfrt.return
+}
+
+// CHECK-LABEL: --- Running 'quantize_fp8'
+func.func @quantize_fp8() {
+  %c0 = tfrt.new.chain
+
+  %a = tfrt_dht.create_uninitialized_tensor.f32.1 [3 : i64]
+  %c1 = tfrt_dht.set_tensor_with_constant_values.f32 %a, %c0
+    [1.0 : f32, -0.3 : f32, 1000.0 : f32]
+
+  %q, %c2 = tfrt_dht.quantize.f8e4m3fn %a, %c1 {scale = 1.0 : f32, zero_point = 0 : i32}
+  %d, %c3 = tfrt_dht.dequantize.f8e4m3fn %q, %c2 {scale = 1.0 : f32, zero_point = 0 : i32}
+  // CHECK: DenseHostTensor dtype = f32, shape = [3], values = [1.000000e+00, -3.125000e-01, 4.480000e+02]
+  %c4 = tfrt_dht.print_tensor %d, %c3
+
+  tfrt.return
+}
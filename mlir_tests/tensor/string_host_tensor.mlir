@@ -42,3 +42,55 @@ func.func @sync_basic() attributes {tfrt.sync} {
 
   tfrt.return
 }
+
+// CHECK-LABEL: --- Running 'lower_and_join'
+func.func @lower_and_join() {
+  %c0 = tfrt.new.chain
+
+  %a = "tfrt_sht.create_tensor"()
+    {shape = [2, 2], values = ["Hello", "WORLD", "TFRT", "rocks!"]}
+    : () -> !t.tensor
+  %b = "tfrt_sht.lower"(%a) : (!t.tensor) -> !t.tensor
+
+  // CHECK: shape = [2, 2], values = ["hello", "world", "tfrt", "rocks!"]
+  %c1 = tfrt_dht.print_tensor %b, %c0
+
+  %c = "tfrt_sht.join"(%b) {separator = ", "} : (!t.tensor) -> !t.tensor
+
+  // CHECK: shape = [2], values = ["hello, world", "tfrt, rocks!"]
+  %c2 = tfrt_dht.print_tensor %c, %c1
+
+  tfrt.return
+}
+
+// CHECK-LABEL: --- Running 'split'
+func.func @split() {
+  %c0 = tfrt.new.chain
+
+  %a = "tfrt_sht.create_tensor"()
+    {shape = [3], values = ["a b  c", "", " d "]} : () -> !t.tensor
+  %tokens, %row_splits = "tfrt_sht.split"(%a) {delimiter = " "}
+    : (!t.tensor) -> (!t.tensor, !t.tensor)
+
+  // CHECK: shape = [4], values = ["a", "b", "c", "d"]
+  %c1 = tfrt_dht.print_tensor %tokens, %c0
+  // CHECK: shape = [4], values = [0, 3, 3, 4]
+  %c2 = tfrt_dht.print_tensor %row_splits, %c1
+
+  tfrt.return
+}
+
+// CHECK-LABEL: --- Running 'to_hash_bucket_fast'
+func.func @to_hash_bucket_fast() {
+  %c0 = tfrt.new.chain
+
+  %a = "tfrt_sht.create_tensor"()
+    {shape = [3], values = ["hello", "world", "tfrt"]} : () -> !t.tensor
+  %b = "tfrt_sht.to_hash_bucket_fast"(%a) {num_buckets = 10 : i64}
+    : (!t.tensor) -> !t.tensor
+
+  // CHECK: shape = [3], values = [8, 1, 9]
+  %c1 = tfrt_dht.print_tensor %b, %c0
+
+  tfrt.return
+}
@@ -6,10 +6,13 @@
 
 #include "blocking_work_queue.h"
 
+#include <atomic>
+
 #include "benchmark/benchmark.h"
 #include "gtest/gtest.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "tfrt/host_context/task_function.h"
+#include "tfrt/metrics/histogram.h"
 #include "tfrt/support/latch.h"
 #include "tfrt/support/thread_environment.h"
 
@@ -90,6 +93,36 @@ TEST(BlockingWorkQueueTest, Quiescing) {
   ASSERT_FALSE(quiescing.HasPendingTasks());
 }
 
+class CountingHistogram : public metrics::Histogram {
+ public:
+  void Record(double value) override { num_values.fetch_add(1); }
+  std::atomic<int> num_values{0};
+};
+
+TEST(BlockingWorkQueueTest, Stats) {
+  auto quiescing_state = std::make_unique<internal::QuiescingState>();
+  WorkQueue work_queue(quiescing_state.get(), 2, 0);
+
+  CountingHistogram latency;
+  work_queue.SetTaskLatencyHistogram(&latency);
+
+  const int num_tasks = 10;
+  latch executed(num_tasks);
+  for (int i = 0; i < num_tasks; ++i) {
+    auto rejected = work_queue.EnqueueBlockingTask(
+        TaskFunction([&]() { executed.count_down(); }));
+    ASSERT_FALSE(rejected.has_value());
+  }
+  executed.wait();
+  work_queue.Quiesce();
+
+  internal::WorkQueueStats stats = work_queue.Stats();
+  EXPECT_EQ(stats.num_tasks, num_tasks);
+  EXPECT_EQ(stats.queue_depth, 0);
+  EXPECT_EQ(stats.busy_nanos.size(), 2);
+  EXPECT_EQ(latency.num_values, num_tasks);
+}
+
 // -------------------------------------------------------------------------- //
 // Performance benchmarks.
 // -------------------------------------------------------------------------- //
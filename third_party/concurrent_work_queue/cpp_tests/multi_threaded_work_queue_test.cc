@@ -5,6 +5,9 @@
 // Unit tests and benchmarks for MultiThreadedWorkQueue.
 
 #include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "tfrt/host_context/async_dispatch.h"
@@ -12,6 +15,8 @@
 #include "tfrt/host_context/diagnostic.h"
 #include "tfrt/host_context/host_allocator.h"
 #include "tfrt/host_context/host_context.h"
+#include "tfrt/support/latch.h"
+#include "tfrt/support/numa.h"
 
 namespace tfrt {
 namespace {
@@ -50,5 +55,198 @@ TEST(MultiThreadedWorkQueueTest, PingPong) {
   ASSERT_EQ(last_executed_task, num_tasks - 1);
 }
 
+TEST(MultiThreadedWorkQueueTest, SpinWaitModes) {
+  for (SpinWaitMode mode : {SpinWaitMode::kFixed, SpinWaitMode::kAdaptive,
+                            SpinWaitMode::kLowPower}) {
+    auto work_queue = CreateMultiThreadedWorkQueue(4, 4, mode);
+
+    // Submit tasks in bursts separated by pauses, so that worker threads go
+    // through spinning and parking.
+    std::atomic<int> num_executed_tasks = 0;
+    for (int burst = 0; burst < 10; ++burst) {
+      for (int i = 0; i < 100; ++i)
+        work_queue->AddTask([&]() { ++num_executed_tasks; });
+      std::this_thread::sleep_for(std::chrono::microseconds(100 * burst));
+    }
+
+    work_queue->Quiesce();
+    ASSERT_EQ(num_executed_tasks, 1000);
+  }
+}
+
+TEST(MultiThreadedWorkQueueTest, AddTasks) {
+  auto host = CreateTestHostContext(4);
+
+  std::atomic<int> num_executed_tasks = 0;
+  const int num_batches = 100;
+  const int batch_size = 37;
+
+  // Submit half of the batches from a worker thread, and the other half from
+  // the caller thread.
+  auto add_batch = [&]() {
+    std::vector<TaskFunction> tasks;
+    for (int i = 0; i < batch_size; ++i)
+      tasks.emplace_back([&]() { ++num_executed_tasks; });
+    host->work_queue().AddTasks(tasks);
+  };
+
+  for (int i = 0; i < num_batches / 2; ++i) {
+    EnqueueWork(host.get(), add_batch);
+    add_batch();
+  }
+
+  host->Quiesce();
+  ASSERT_EQ(num_executed_tasks, num_batches * batch_size);
+}
+
+TEST(MultiThreadedWorkQueueTest, CurrentWorkerThreadId) {
+  auto host = CreateTestHostContext(4);
+  ASSERT_EQ(host->work_queue().CurrentWorkerThreadId(), -1);
+
+  std::atomic<int> num_valid_ids = 0;
+  for (int i = 0; i < 100; ++i) {
+    EnqueueWork(host.get(), [&]() {
+      int id = host->work_queue().CurrentWorkerThreadId();
+      if (id >= 0 && id < 4) ++num_valid_ids;
+    });
+  }
+
+  host->Quiesce();
+  ASSERT_EQ(num_valid_ids, 100);
+}
+
+TEST(MultiThreadedWorkQueueTest, AddNextTask) {
+  auto host = CreateTestHostContext(4);
+  const int num_chains = 100;
+
+  // Each task adds its continuation as the next task of its worker thread,
+  // and a few more tasks that can be stolen by other worker threads.
+  std::atomic<int> num_same_thread = 0;
+  std::atomic<int> num_executed_tasks = 0;
+  for (int i = 0; i < num_chains; ++i) {
+    EnqueueWork(host.get(), [&]() {
+      for (int j = 0; j < 3; ++j)
+        host->work_queue().AddTask([&]() { ++num_executed_tasks; });
+
+      std::thread::id producer = std::this_thread::get_id();
+      host->work_queue().AddNextTask([&, producer]() {
+        if (std::this_thread::get_id() == producer) ++num_same_thread;
+        ++num_executed_tasks;
+      });
+    });
+  }
+
+  // Next tasks added outside of worker threads are added as usual.
+  latch done(1);
+  host->work_queue().AddNextTask([&]() { done.count_down(); });
+  done.wait();
+
+  host->Quiesce();
+  ASSERT_EQ(num_executed_tasks, 4 * num_chains);
+  ASSERT_EQ(num_same_thread, num_chains);
+}
+
+TEST(MultiThreadedWorkQueueTest, TaskPriority) {
+  auto host = CreateTestHostContext(1);
+  ConcurrentWorkQueue& work_queue = host->work_queue();
+
+  // Keep the only worker thread busy until all tasks are enqueued. Wait for
+  // the tasks on a latch, Quiesce() would execute some of them in the caller
+  // thread.
+  tfrt::latch enqueued(1);
+  tfrt::latch executed_all(4);
+  work_queue.AddTask([&]() { enqueued.wait(); });
+
+  std::vector<TaskPriority> executed;
+  auto record = [&](TaskPriority priority) {
+    return [&, priority]() {
+      executed.push_back(priority);
+      executed_all.count_down();
+    };
+  };
+
+  work_queue.AddTaskWithPriority(record(TaskPriority::kLow),
+                                 TaskPriority::kLow);
+  work_queue.AddTask(record(TaskPriority::kDefault));
+  work_queue.AddTaskWithPriority(record(TaskPriority::kHigh),
+                                 TaskPriority::kHigh);
+  work_queue.AddTaskWithPriority(record(TaskPriority::kCritical),
+                                 TaskPriority::kCritical);
+  enqueued.count_down();
+
+  executed_all.wait();
+  EXPECT_EQ(executed,
+            std::vector<TaskPriority>({TaskPriority::kCritical,
+                                       TaskPriority::kHigh,
+                                       TaskPriority::kDefault,
+                                       TaskPriority::kLow}));
+}
+
+TEST(MultiThreadedWorkQueueTest, NumaWorkQueue) {
+  auto host = std::make_unique<HostContext>([](const DecodedDiagnostic&) {},
+                                            CreateMallocAllocator(),
+                                            CreateNumaWorkQueue(4, 4));
+
+  // Tasks enqueued by worker threads fan out recursively. Worker threads must
+  // be assigned to a NUMA node, Quiesce() also runs tasks in the caller thread.
+  std::atomic<int> num_executed_tasks = 0;
+  std::atomic<int> num_tasks_without_node = 0;
+  llvm::unique_function<void(int)> fan_out;
+  fan_out = [&](int depth) {
+    ++num_executed_tasks;
+    if (host->work_queue().IsInWorkerThread() &&
+        numa::GetCurrentThreadNode() < 0)
+      ++num_tasks_without_node;
+    if (depth == 0) return;
+    for (int i = 0; i < 2; ++i)
+      EnqueueWork(host.get(), [&, depth]() { fan_out(depth - 1); });
+  };
+
+  EnqueueWork(host.get(), [&]() { fan_out(10); });
+  host->Quiesce();
+  EXPECT_EQ(num_executed_tasks, (1 << 11) - 1);
+  EXPECT_EQ(num_tasks_without_node, 0);
+}
+
+TEST(MultiThreadedWorkQueueTest, TenantWorkQueueConfig) {
+  EXPECT_NE(CreateWorkQueue("tenant"), nullptr);
+  EXPECT_NE(CreateWorkQueue("tenant:threads=2;blocking=2;spin=adaptive"),
+            nullptr);
+  EXPECT_NE(CreateWorkQueue("tenant:cpus=0,0-0;share=config_test"), nullptr);
+
+  EXPECT_EQ(CreateWorkQueue("tenant:threads=0"), nullptr);
+  EXPECT_EQ(CreateWorkQueue("tenant:cpus=3-1"), nullptr);
+  EXPECT_EQ(CreateWorkQueue("tenant:spin=sometimes"), nullptr);
+  EXPECT_EQ(CreateWorkQueue("tenant:pool=1"), nullptr);
+}
+
+TEST(MultiThreadedWorkQueueTest, TenantWorkQueueShareGroup) {
+  TenantWorkQueueOptions options;
+  options.num_threads = 1;
+  options.num_blocking_threads = 1;
+  options.share_group = "share_group_test";
+  auto busy = CreateTenantWorkQueue(options);
+  auto idle = CreateTenantWorkQueue(options);
+
+  // The only worker thread of the busy queue is blocked, so the tasks of the
+  // busy queue must be run by the worker thread of the idle queue.
+  latch unblock(1);
+  busy->AddTask([&]() { unblock.wait(); });
+
+  const int num_tasks = 100;
+  latch executed(num_tasks);
+  for (int i = 0; i < num_tasks; ++i)
+    busy->AddTask([&]() { executed.count_down(); });
+
+  // Wake up the worker thread of the idle queue. It borrows the tasks of the
+  // busy queue when it runs out of its own tasks.
+  idle->AddTask([]() {});
+  executed.wait();
+
+  unblock.count_down();
+  busy->Quiesce();
+  idle->Quiesce();
+}
+
 }  // namespace
 }  // namespace tfrt
@@ -74,6 +74,7 @@ class BlockingWorkQueue
   using Base::IsNotifyParkedThreadRequired;
   using Base::IsQuiescing;
   using Base::WithPendingTaskCounter;
+  using Base::WithTaskLatency;
 
   using Base::coprimes_;
   using Base::event_count_;
@@ -142,6 +143,7 @@ BlockingWorkQueue<ThreadingEnvironment>::EnqueueBlockingTask(
     TaskFunction task) {
   // In quiescing mode we count the number of pending tasks, and are allowed to
   // execute tasks in the caller thread.
+  task = WithTaskLatency(std::move(task));
   const bool is_quiescing = IsQuiescing();
   if (is_quiescing) task = WithPendingTaskCounter(std::move(task));
 
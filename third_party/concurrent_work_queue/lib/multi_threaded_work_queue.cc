@@ -18,12 +18,14 @@
 #include "tfrt/support/ref_count.h"
 #include "tfrt/support/string_util.h"
 #include "tfrt/support/thread_environment.h"
+#include "work_queue_metrics.h"
 
 namespace tfrt {
 
 class MultiThreadedWorkQueue : public ConcurrentWorkQueue {
  public:
-  MultiThreadedWorkQueue(int num_threads, int num_blocking_threads);
+  MultiThreadedWorkQueue(int num_threads, int num_blocking_threads,
+                         SpinWaitMode spin_wait_mode);
   ~MultiThreadedWorkQueue() override;
 
   std::string name() const override {
@@ -34,12 +36,21 @@ class MultiThreadedWorkQueue : public ConcurrentWorkQueue {
   int GetParallelismLevel() const final { return num_threads_; }
 
   void AddTask(TaskFunction task) final;
+  void AddTasks(MutableArrayRef<TaskFunction> tasks) final;
+  void AddTaskWithPriority(TaskFunction task, TaskPriority priority) final;
+  void AddTasksWithPriority(MutableArrayRef<TaskFunction> tasks,
+                            TaskPriority priority) final;
+  void AddNextTask(TaskFunction task) final;
   Optional<TaskFunction> AddBlockingTask(TaskFunction task,
                                          bool allow_queuing) final;
   void Quiesce() final;
   void Await(ArrayRef<RCReference<AsyncValue>> values) final;
 
   bool IsInWorkerThread() const final;
+  int CurrentWorkerThreadId() const final;
+
+  void ExportMetrics() final;
+  void EnableTaskLatencyMetrics(bool enable) final;
 
  private:
   const int num_threads_;
@@ -48,14 +59,20 @@ class MultiThreadedWorkQueue : public ConcurrentWorkQueue {
   std::unique_ptr<internal::QuiescingState> quiescing_state_;
   internal::NonBlockingWorkQueue<ThreadingEnvironment> non_blocking_work_queue_;
   internal::BlockingWorkQueue<ThreadingEnvironment> blocking_work_queue_;
+
+  internal::WorkQueueMetrics non_blocking_metrics_{
+      "/tfrt/work_queue/non_blocking/"};
+  internal::WorkQueueMetrics blocking_metrics_{"/tfrt/work_queue/blocking/"};
 };
 
 MultiThreadedWorkQueue::MultiThreadedWorkQueue(int num_threads,
-                                               int num_blocking_threads)
+                                               int num_blocking_threads,
+                                               SpinWaitMode spin_wait_mode)
     : num_threads_(num_threads),
       num_blocking_threads_(num_blocking_threads),
       quiescing_state_(std::make_unique<internal::QuiescingState>()),
-      non_blocking_work_queue_(quiescing_state_.get(), num_threads),
+      non_blocking_work_queue_(quiescing_state_.get(), num_threads,
+                               /*hooks=*/{}, spin_wait_mode),
       blocking_work_queue_(quiescing_state_.get(), num_blocking_threads) {}
 
 MultiThreadedWorkQueue::~MultiThreadedWorkQueue() {
@@ -68,6 +85,24 @@ void MultiThreadedWorkQueue::AddTask(TaskFunction task) {
   non_blocking_work_queue_.AddTask(std::move(task));
 }
 
+void MultiThreadedWorkQueue::AddTasks(MutableArrayRef<TaskFunction> tasks) {
+  non_blocking_work_queue_.AddTasks(tasks);
+}
+
+void MultiThreadedWorkQueue::AddTaskWithPriority(TaskFunction task,
+                                                 TaskPriority priority) {
+  non_blocking_work_queue_.AddTask(std::move(task), priority);
+}
+
+void MultiThreadedWorkQueue::AddTasksWithPriority(
+    MutableArrayRef<TaskFunction> tasks, TaskPriority priority) {
+  non_blocking_work_queue_.AddTasks(tasks, priority);
+}
+
+void MultiThreadedWorkQueue::AddNextTask(TaskFunction task) {
+  non_blocking_work_queue_.AddNextTask(std::move(task));
+}
+
 Optional<TaskFunction> MultiThreadedWorkQueue::AddBlockingTask(
     TaskFunction task, bool allow_queuing) {
   if (allow_queuing) {
@@ -118,11 +153,27 @@ bool MultiThreadedWorkQueue::IsInWorkerThread() const {
   return non_blocking_work_queue_.IsInWorkerThread();
 }
 
+int MultiThreadedWorkQueue::CurrentWorkerThreadId() const {
+  return non_blocking_work_queue_.CurrentThreadId();
+}
+
+void MultiThreadedWorkQueue::ExportMetrics() {
+  non_blocking_metrics_.Export(non_blocking_work_queue_.Stats());
+  blocking_metrics_.Export(blocking_work_queue_.Stats());
+}
+
+void MultiThreadedWorkQueue::EnableTaskLatencyMetrics(bool enable) {
+  non_blocking_work_queue_.SetTaskLatencyHistogram(
+      enable ? non_blocking_metrics_.task_latency_histogram() : nullptr);
+  blocking_work_queue_.SetTaskLatencyHistogram(
+      enable ? blocking_metrics_.task_latency_histogram() : nullptr);
+}
+
 std::unique_ptr<ConcurrentWorkQueue> CreateMultiThreadedWorkQueue(
-    int num_threads, int num_blocking_threads) {
+    int num_threads, int num_blocking_threads, SpinWaitMode spin_wait_mode) {
   assert(num_threads > 0 && num_blocking_threads > 0);
-  return std::make_unique<MultiThreadedWorkQueue>(num_threads,
-                                                  num_blocking_threads);
+  return std::make_unique<MultiThreadedWorkQueue>(
+      num_threads, num_blocking_threads, spin_wait_mode);
 }
 
 }  // namespace tfrt
@@ -10,11 +10,15 @@
 // Work queue implementation based on non-blocking concurrency primitives
 // optimized for CPU intensive non-blocking compute tasks.
 //
-// This work queue uses TaskDeque for storing pending tasks. Thread tries to
-// pop a task from the front of its own queue, and in a steal loop it tries to
-// steal a task from the back of another thread pending tasks queue. This gives
-// mostly LIFO task execution order, which is optimal for cache locality for
-// compute intensive tasks.
+// This work queue uses TaskPriorityDeque for storing pending tasks. Thread
+// tries to pop a task from the front of its own queue, and in a steal loop it
+// tries to steal a task from the back of another thread pending tasks queue.
+// This gives mostly LIFO task execution order, which is optimal for cache
+// locality for compute intensive tasks. Within each thread queue tasks of a
+// higher priority are always popped (and stolen) first.
+//
+// A task can also hand off its continuation to the next task slot of its
+// thread with AddNextTask(), to run it right after the task on the same core.
 //
 // Work stealing algorithm is based on:
 //
@@ -24,8 +28,10 @@
 #ifndef TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_NON_BLOCKING_WORK_QUEUE_H_
 #define TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_NON_BLOCKING_WORK_QUEUE_H_
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Compiler.h"
-#include "task_deque.h"
+#include "task_priority_deque.h"
 #include "tfrt/host_context/task_function.h"
 #include "work_queue_base.h"
 
@@ -39,7 +45,7 @@ template <typename ThreadingEnvironmentTy>
 struct WorkQueueTraits<NonBlockingWorkQueue<ThreadingEnvironmentTy>> {
   using ThreadingEnvironment = ThreadingEnvironmentTy;
   using Thread = typename ThreadingEnvironment::Thread;
-  using Queue = ::tfrt::internal::TaskDeque;
+  using Queue = ::tfrt::internal::TaskPriorityDeque;
 };
 
 template <typename ThreadingEnvironment>
@@ -54,11 +60,26 @@ class NonBlockingWorkQueue
 
  public:
   explicit NonBlockingWorkQueue(QuiescingState* quiescing_state,
-                                int num_threads);
+                                int num_threads, WorkerHooks hooks = {},
+                                SpinWaitMode spin_wait_mode =
+                                    SpinWaitMode::kFixed);
   ~NonBlockingWorkQueue() = default;
 
-  void AddTask(TaskFunction task);
+  void AddTask(TaskFunction task,
+               TaskPriority priority = TaskPriority::kDefault);
+
+  // Adds a batch of tasks, distributed round robin across the worker queues,
+  // and wakes up parked threads once for the whole batch.
+  void AddTasks(MutableArrayRef<TaskFunction> tasks,
+                TaskPriority priority = TaskPriority::kDefault);
+
+  // Adds a task that runs right after the current task of the calling worker
+  // thread, ahead of the tasks in its queue. If the next task slot is already
+  // taken, the previous next task is pushed to the front of the thread queue.
+  // Tasks added from other threads are added with AddTask().
+  void AddNextTask(TaskFunction task);
 
+  using Base::CurrentThreadId;
   using Base::Steal;
 
  private:
@@ -70,7 +91,9 @@ class NonBlockingWorkQueue
   using Base::GetPerThread;
   using Base::IsNotifyParkedThreadRequired;
   using Base::IsQuiescing;
+  using Base::NotifyParkedThreads;
   using Base::WithPendingTaskCounter;
+  using Base::WithTaskLatency;
 
   using Base::coprimes_;
   using Base::event_count_;
@@ -84,12 +107,17 @@ class NonBlockingWorkQueue
 
 template <typename ThreadingEnvironment>
 NonBlockingWorkQueue<ThreadingEnvironment>::NonBlockingWorkQueue(
-    QuiescingState* quiescing_state, int num_threads)
+    QuiescingState* quiescing_state, int num_threads, WorkerHooks hooks,
+    SpinWaitMode spin_wait_mode)
     : WorkQueueBase<NonBlockingWorkQueue>(quiescing_state, kThreadNamePrefix,
-                                          num_threads) {}
+                                          num_threads, std::move(hooks),
+                                          spin_wait_mode) {}
 
 template <typename ThreadingEnvironment>
-void NonBlockingWorkQueue<ThreadingEnvironment>::AddTask(TaskFunction task) {
+void NonBlockingWorkQueue<ThreadingEnvironment>::AddTask(
+    TaskFunction task, TaskPriority priority) {
+  task = WithTaskLatency(std::move(task));
+
   // Keep track of the number of pending tasks.
   if (IsQuiescing()) task = WithPendingTaskCounter(std::move(task));
 
@@ -109,12 +137,12 @@ void NonBlockingWorkQueue<ThreadingEnvironment>::AddTask(TaskFunction task) {
   if (pt->parent == this) {
     // Worker thread of this pool, push onto the thread's queue.
     Queue& q = thread_data_[pt->thread_id].queue;
-    inline_task = q.PushFront(std::move(task));
+    inline_task = q.PushFront(std::move(task), priority);
   } else {
     // A free-standing thread (or worker of another pool).
     unsigned rnd = FastReduce(pt->rng(), num_threads_);
     Queue& q = thread_data_[rnd].queue;
-    inline_task = q.PushBack(std::move(task));
+    inline_task = q.PushBack(std::move(task), priority);
   }
   // Note: below we touch `*this` after making `task` available to worker
   // threads. Strictly speaking, this can lead to a racy-use-after-free.
@@ -132,6 +160,81 @@ void NonBlockingWorkQueue<ThreadingEnvironment>::AddTask(TaskFunction task) {
   }
 }
 
+template <typename ThreadingEnvironment>
+void NonBlockingWorkQueue<ThreadingEnvironment>::AddTasks(
+    MutableArrayRef<TaskFunction> tasks, TaskPriority priority) {
+  if (tasks.empty()) return;
+
+  // Tasks that did not fit into the worker queues are executed in the current
+  // thread after the notification.
+  llvm::SmallVector<TaskFunction, 4> inline_tasks;
+
+  // Worker threads of this pool start with their own queue, and push to its
+  // front as in AddTask(). The rest of the batch goes to the back of the
+  // other queues, where it can be picked up by their owners, or stolen.
+  PerThread* pt = GetPerThread();
+  bool is_worker = pt->parent == this;
+  unsigned start = is_worker ? static_cast<unsigned>(pt->thread_id)
+                             : FastReduce(pt->rng(), num_threads_);
+
+  unsigned index = start;
+  for (TaskFunction& task : tasks) {
+    task = WithTaskLatency(std::move(task));
+
+    // Keep track of the number of pending tasks.
+    if (IsQuiescing()) task = WithPendingTaskCounter(std::move(task));
+
+    Queue& q = thread_data_[index].queue;
+    llvm::Optional<TaskFunction> inline_task =
+        is_worker && index == start ? q.PushFront(std::move(task), priority)
+                                    : q.PushBack(std::move(task), priority);
+    if (inline_task.has_value())
+      inline_tasks.push_back(std::move(*inline_task));
+
+    if (++index == num_threads_) index = 0;
+  }
+
+  // See the note in AddTask() about touching `*this` after making tasks
+  // available to worker threads.
+  NotifyParkedThreads(tasks.size() - inline_tasks.size());
+
+  for (TaskFunction& task : inline_tasks) task();
+}
+
+template <typename ThreadingEnvironment>
+void NonBlockingWorkQueue<ThreadingEnvironment>::AddNextTask(
+    TaskFunction task) {
+  PerThread* pt = GetPerThread();
+  if (pt->parent != this) {
+    AddTask(std::move(task));
+    return;
+  }
+
+  task = WithTaskLatency(std::move(task));
+
+  // Keep track of the number of pending tasks.
+  if (IsQuiescing()) task = WithPendingTaskCounter(std::move(task));
+
+  ThreadData& thread_data = thread_data_[pt->thread_id];
+  if (!thread_data.next_task.has_value()) {
+    // The worker thread checks its next task slot before parking, so there is
+    // no need to notify parked threads.
+    thread_data.next_task = std::move(task);
+    return;
+  }
+
+  // Replace the previous next task, and make it available to other threads.
+  std::swap(*thread_data.next_task, task);
+  llvm::Optional<TaskFunction> inline_task =
+      thread_data.queue.PushFront(std::move(task), TaskPriority::kDefault);
+  if (!inline_task.has_value()) {
+    if (IsNotifyParkedThreadRequired())
+      event_count_.Notify(/*notify_all=*/false);
+  } else {
+    (*inline_task)();  // Push failed, execute directly.
+  }
+}
+
 template <typename ThreadingEnvironment>
 [[nodiscard]] Optional<TaskFunction>
 NonBlockingWorkQueue<ThreadingEnvironment>::NextTask(Queue* queue) {
@@ -0,0 +1,269 @@
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// NUMA-aware Concurrent Work Queue implementation composed from a non-blocking
+// work queue per NUMA node and a shared blocking work queue.
+//
+// Worker threads of a node are pinned to the CPUs of that node. Tasks added by
+// a worker thread stay on its node, and tasks added by other threads are
+// distributed round robin across nodes. Worker threads steal from the workers
+// of their own node first, and only then from the other nodes.
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "blocking_work_queue.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "non_blocking_work_queue.h"
+#include "tfrt/host_context/async_value.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/task_function.h"
+#include "tfrt/support/latch.h"
+#include "tfrt/support/numa.h"
+#include "tfrt/support/ref_count.h"
+#include "tfrt/support/string_util.h"
+#include "tfrt/support/thread_environment.h"
+#include "work_queue_metrics.h"
+
+namespace tfrt {
+
+class NumaWorkQueue : public ConcurrentWorkQueue {
+  using NodeQueue = internal::NonBlockingWorkQueue<ThreadingEnvironment>;
+
+ public:
+  NumaWorkQueue(int num_threads, int num_blocking_threads,
+                SpinWaitMode spin_wait_mode);
+  ~NumaWorkQueue() override;
+
+  std::string name() const override {
+    return StrCat("NUMA-aware C++ work queue (", node_queues_.size(),
+                  " nodes, ", num_threads_, " threads, ",
+                  num_blocking_threads_, " blocking threads)");
+  }
+
+  int GetParallelismLevel() const final { return num_threads_; }
+
+  void AddTask(TaskFunction task) final;
+  void AddTasks(MutableArrayRef<TaskFunction> tasks) final;
+  void AddTaskWithPriority(TaskFunction task, TaskPriority priority) final;
+  void AddTasksWithPriority(MutableArrayRef<TaskFunction> tasks,
+                            TaskPriority priority) final;
+  void AddNextTask(TaskFunction task) final;
+  Optional<TaskFunction> AddBlockingTask(TaskFunction task,
+                                         bool allow_queuing) final;
+  void Quiesce() final;
+  void Await(ArrayRef<RCReference<AsyncValue>> values) final;
+
+  bool IsInWorkerThread() const final;
+  int CurrentWorkerThreadId() const final;
+
+  void ExportMetrics() final;
+  void EnableTaskLatencyMetrics(bool enable) final;
+
+ private:
+  // Returns the queue of the node of the calling worker thread, or the next
+  // node in round robin order for other threads.
+  NodeQueue& SelectNodeQueue();
+
+  // Steals a task from the nodes other than `node`.
+  Optional<TaskFunction> StealRemote(int node);
+
+  const int num_threads_;
+  const int num_blocking_threads_;
+
+  std::unique_ptr<internal::QuiescingState> quiescing_state_;
+  std::vector<std::unique_ptr<NodeQueue>> node_queues_;
+  internal::BlockingWorkQueue<ThreadingEnvironment> blocking_work_queue_;
+
+  // Worker threads start before all node queues are constructed, and keep
+  // running while node queues are destroyed, so remote steals are enabled
+  // only while all node queues are alive.
+  std::atomic<bool> remote_steal_enabled_{false};
+  std::atomic<unsigned> next_node_{0};
+
+  // Statistics of all nodes are exported together.
+  internal::WorkQueueMetrics non_blocking_metrics_{
+      "/tfrt/work_queue/non_blocking/"};
+  internal::WorkQueueMetrics blocking_metrics_{"/tfrt/work_queue/blocking/"};
+};
+
+NumaWorkQueue::NumaWorkQueue(int num_threads, int num_blocking_threads,
+                             SpinWaitMode spin_wait_mode)
+    : num_threads_(num_threads),
+      num_blocking_threads_(num_blocking_threads),
+      quiescing_state_(std::make_unique<internal::QuiescingState>()),
+      blocking_work_queue_(quiescing_state_.get(), num_blocking_threads) {
+  const auto& node_cpus = numa::GetNodeCpus();
+  const int num_nodes = std::min<int>(node_cpus.size(), num_threads);
+
+  // Split the worker threads evenly between the nodes.
+  node_queues_.resize(num_nodes);
+  for (int node = 0; node < num_nodes; ++node) {
+    int node_threads =
+        num_threads / num_nodes + (node < num_threads % num_nodes ? 1 : 0);
+
+    internal::WorkerHooks hooks;
+    hooks.on_thread_start = [node, cpus = node_cpus[node]](int) {
+      numa::SetCurrentThreadNode(node);
+      numa::PinCurrentThreadToCpus(cpus);
+    };
+    if (num_nodes > 1)
+      hooks.steal_remote = [this, node]() { return StealRemote(node); };
+
+    node_queues_[node] = std::make_unique<NodeQueue>(
+        quiescing_state_.get(), node_threads, std::move(hooks), spin_wait_mode);
+  }
+
+  remote_steal_enabled_.store(true, std::memory_order_release);
+}
+
+NumaWorkQueue::~NumaWorkQueue() {
+  // Pending tasks in the underlying queues might submit new tasks to each other
+  // during destruction.
+  Quiesce();
+
+  remote_steal_enabled_.store(false, std::memory_order_release);
+  for (auto& node_queue : node_queues_) node_queue.reset();
+}
+
+NumaWorkQueue::NodeQueue& NumaWorkQueue::SelectNodeQueue() {
+  int node = numa::GetCurrentThreadNode();
+  if (node < 0 || node >= node_queues_.size() ||
+      !node_queues_[node]->IsInWorkerThread()) {
+    node = next_node_.fetch_add(1, std::memory_order_relaxed) %
+           node_queues_.size();
+  }
+  return *node_queues_[node];
+}
+
+Optional<TaskFunction> NumaWorkQueue::StealRemote(int node) {
+  if (!remote_steal_enabled_.load(std::memory_order_acquire)) return llvm::None;
+
+  // Quiesce() checks node queues one by one, and a task stolen from a node
+  // that was already checked could run unnoticed, so during quiescing tasks
+  // are executed only by the workers of their own node.
+  if (quiescing_state_->num_quiescing.load(std::memory_order_relaxed) > 0)
+    return llvm::None;
+
+  const int num_nodes = node_queues_.size();
+  for (int i = 1; i < num_nodes; ++i) {
+    Optional<TaskFunction> task =
+        node_queues_[(node + i) % num_nodes]->Steal();
+    if (task.has_value()) return task;
+  }
+  return llvm::None;
+}
+
+void NumaWorkQueue::AddTask(TaskFunction task) {
+  SelectNodeQueue().AddTask(std::move(task));
+}
+
+void NumaWorkQueue::AddTasks(MutableArrayRef<TaskFunction> tasks) {
+  SelectNodeQueue().AddTasks(tasks);
+}
+
+void NumaWorkQueue::AddTaskWithPriority(TaskFunction task,
+                                        TaskPriority priority) {
+  SelectNodeQueue().AddTask(std::move(task), priority);
+}
+
+void NumaWorkQueue::AddTasksWithPriority(MutableArrayRef<TaskFunction> tasks,
+                                         TaskPriority priority) {
+  SelectNodeQueue().AddTasks(tasks, priority);
+}
+
+void NumaWorkQueue::AddNextTask(TaskFunction task) {
+  SelectNodeQueue().AddNextTask(std::move(task));
+}
+
+Optional<TaskFunction> NumaWorkQueue::AddBlockingTask(TaskFunction task,
+                                                      bool allow_queuing) {
+  if (allow_queuing) {
+    return blocking_work_queue_.EnqueueBlockingTask(std::move(task));
+  } else {
+    return blocking_work_queue_.RunBlockingTask(std::move(task));
+  }
+}
+
+void NumaWorkQueue::Quiesce() {
+  // Turn on pending tasks counter inside all work queues.
+  auto quiescing = internal::Quiescing::Start(quiescing_state_.get());
+
+  auto quiesce_all = [&]() {
+    for (auto& node_queue : node_queues_) node_queue->Quiesce();
+    blocking_work_queue_.Quiesce();
+  };
+
+  // Node queues share the quiescing state, so pending tasks of any node keep
+  // us in the loop.
+  quiesce_all();
+  while (quiescing.HasPendingTasks()) quiesce_all();
+
+  // The last pending task might have completed in a node that was quiesced
+  // earlier in the pass, check all nodes once more to synchronize with its
+  // worker thread.
+  quiesce_all();
+}
+
+void NumaWorkQueue::Await(ArrayRef<RCReference<AsyncValue>> values) {
+  // We might block on a latch waiting for the completion of all tasks, and
+  // this is not allowed to do inside non blocking work queue.
+  for (auto& node_queue : node_queues_)
+    node_queue->CheckCallerThread("NumaWorkQueue::Await");
+
+  // We are done when values_remaining drops to zero.
+  tfrt::latch values_remaining(values.size());
+
+  // As each value becomes available, we decrement the count.
+  for (auto& value : values) {
+    value->AndThen([&values_remaining]() { values_remaining.count_down(); });
+  }
+
+  // Wait until all values are resolved.
+  values_remaining.wait();
+}
+
+bool NumaWorkQueue::IsInWorkerThread() const {
+  return std::any_of(
+      node_queues_.begin(), node_queues_.end(),
+      [](const auto& node_queue) { return node_queue->IsInWorkerThread(); });
+}
+
+int NumaWorkQueue::CurrentWorkerThreadId() const {
+  // Worker threads are numbered consecutively across the nodes.
+  int first_thread_id = 0;
+  for (const auto& node_queue : node_queues_) {
+    int thread_id = node_queue->CurrentThreadId();
+    if (thread_id >= 0) return first_thread_id + thread_id;
+    first_thread_id += node_queue->NumThreads();
+  }
+  return -1;
+}
+
+void NumaWorkQueue::ExportMetrics() {
+  internal::WorkQueueStats stats;
+  for (auto& node_queue : node_queues_) stats.Add(node_queue->Stats());
+  non_blocking_metrics_.Export(stats);
+  blocking_metrics_.Export(blocking_work_queue_.Stats());
+}
+
+void NumaWorkQueue::EnableTaskLatencyMetrics(bool enable) {
+  for (auto& node_queue : node_queues_) {
+    node_queue->SetTaskLatencyHistogram(
+        enable ? non_blocking_metrics_.task_latency_histogram() : nullptr);
+  }
+  blocking_work_queue_.SetTaskLatencyHistogram(
+      enable ? blocking_metrics_.task_latency_histogram() : nullptr);
+}
+
+std::unique_ptr<ConcurrentWorkQueue> CreateNumaWorkQueue(
+    int num_threads, int num_blocking_threads, SpinWaitMode spin_wait_mode) {
+  assert(num_threads > 0 && num_blocking_threads > 0);
+  return std::make_unique<NumaWorkQueue>(num_threads, num_blocking_threads,
+                                         spin_wait_mode);
+}
+
+}  // namespace tfrt
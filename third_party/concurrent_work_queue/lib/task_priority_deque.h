@@ -40,12 +40,7 @@
 namespace tfrt {
 namespace internal {
 
-enum class TaskPriority : int8_t {
-  kCritical = 0,
-  kHigh = 1,
-  kDefault = 2,
-  kLow = 3
-};
+using TaskPriority = ::tfrt::TaskPriority;
 
 class TaskPriorityDeque {
   static constexpr uint64_t kCounterBits = 10;  // capacity = 1024
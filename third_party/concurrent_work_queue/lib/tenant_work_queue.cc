@@ -0,0 +1,308 @@
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// Concurrent Work Queue implementation for one tenant of a process that serves
+// several tenants, composed from a non-blocking work queue with worker threads
+// pinned to the CPUs of the tenant and a blocking work queue.
+//
+// Work queues of a share group lend idle worker threads to each other: a worker
+// thread that runs out of tasks steals from the other queues of the group
+// before it parks. Tasks lent to another queue are counted, so that Quiesce()
+// of the owning queue waits for them.
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "blocking_work_queue.h"
+#include "llvm/ADT/StringMap.h"
+#include "non_blocking_work_queue.h"
+#include "tfrt/host_context/async_value.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
+#include "tfrt/host_context/task_function.h"
+#include "tfrt/support/latch.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/numa.h"
+#include "tfrt/support/ref_count.h"
+#include "tfrt/support/string_util.h"
+#include "tfrt/support/thread_annotations.h"
+#include "tfrt/support/thread_environment.h"
+#include "work_queue_metrics.h"
+
+namespace tfrt {
+
+class TenantWorkQueue;
+
+namespace {
+
+// The work queues of a share group.
+struct ShareGroup {
+  mutex mu;
+  std::vector<TenantWorkQueue*> members TFRT_GUARDED_BY(mu);
+  // Worker threads start looking for tasks at different members.
+  unsigned next_member TFRT_GUARDED_BY(mu) = 0;
+};
+
+// Share groups are never destroyed, so that queues can keep pointers to them.
+ShareGroup* GetShareGroup(string_view name) {
+  static mutex* mu = new mutex;
+  static auto* groups = new llvm::StringMap<std::unique_ptr<ShareGroup>>;
+  mutex_lock lock(*mu);
+  auto& group = (*groups)[name];
+  if (!group) group = std::make_unique<ShareGroup>();
+  return group.get();
+}
+
+}  // namespace
+
+class TenantWorkQueue : public ConcurrentWorkQueue {
+ public:
+  TenantWorkQueue(int num_threads, const TenantWorkQueueOptions& options);
+  ~TenantWorkQueue() override;
+
+  std::string name() const override {
+    return StrCat("Tenant C++ work queue (", num_threads_, " threads on ",
+                  num_cpus_ > 0 ? StrCat(num_cpus_) : "all", " cpus, ",
+                  num_blocking_threads_, " blocking threads",
+                  share_group_name_.empty() ? "" : ", share group ",
+                  share_group_name_, ")");
+  }
+
+  int GetParallelismLevel() const final { return num_threads_; }
+
+  void AddTask(TaskFunction task) final;
+  void AddTasks(MutableArrayRef<TaskFunction> tasks) final;
+  void AddTaskWithPriority(TaskFunction task, TaskPriority priority) final;
+  void AddTasksWithPriority(MutableArrayRef<TaskFunction> tasks,
+                            TaskPriority priority) final;
+  void AddNextTask(TaskFunction task) final;
+  Optional<TaskFunction> AddBlockingTask(TaskFunction task,
+                                         bool allow_queuing) final;
+  void Quiesce() final;
+  void Await(ArrayRef<RCReference<AsyncValue>> values) final;
+
+  bool IsInWorkerThread() const final;
+  int CurrentWorkerThreadId() const final;
+
+  void ExportMetrics() final;
+  void EnableTaskLatencyMetrics(bool enable) final;
+
+ private:
+  // Steals a task from the other queues of the share group.
+  Optional<TaskFunction> Borrow();
+
+  // Steals a task for a worker thread of another queue of the share group.
+  // Requires the lock of the share group, which keeps `*this` alive.
+  Optional<TaskFunction> Lend();
+
+  const int num_threads_;
+  const int num_blocking_threads_;
+  const int num_cpus_;
+  const std::string share_group_name_;
+  ShareGroup* const share_group_;
+
+  // Number of tasks of this queue run by the worker threads of other queues.
+  std::atomic<int> num_lent_tasks_{0};
+
+  std::unique_ptr<internal::QuiescingState> quiescing_state_;
+  internal::NonBlockingWorkQueue<ThreadingEnvironment> non_blocking_work_queue_;
+  internal::BlockingWorkQueue<ThreadingEnvironment> blocking_work_queue_;
+
+  internal::WorkQueueMetrics non_blocking_metrics_{
+      "/tfrt/work_queue/non_blocking/"};
+  internal::WorkQueueMetrics blocking_metrics_{"/tfrt/work_queue/blocking/"};
+};
+
+TenantWorkQueue::TenantWorkQueue(int num_threads,
+                                 const TenantWorkQueueOptions& options)
+    : num_threads_(num_threads),
+      num_blocking_threads_(options.num_blocking_threads),
+      num_cpus_(options.cpus.size()),
+      share_group_name_(options.share_group),
+      share_group_(options.share_group.empty()
+                       ? nullptr
+                       : GetShareGroup(options.share_group)),
+      quiescing_state_(std::make_unique<internal::QuiescingState>()),
+      non_blocking_work_queue_(
+          quiescing_state_.get(), num_threads,
+          [&] {
+            internal::WorkerHooks hooks;
+            if (!options.cpus.empty()) {
+              hooks.on_thread_start = [cpus = options.cpus](int) {
+                numa::PinCurrentThreadToCpus(cpus);
+              };
+            }
+            if (share_group_)
+              hooks.steal_remote = [this]() { return Borrow(); };
+            return hooks;
+          }(),
+          options.spin_wait_mode),
+      blocking_work_queue_(quiescing_state_.get(),
+                           options.num_blocking_threads) {
+  // Other members steal from this queue only once it is fully constructed.
+  if (share_group_) {
+    mutex_lock lock(share_group_->mu);
+    share_group_->members.push_back(this);
+  }
+}
+
+TenantWorkQueue::~TenantWorkQueue() {
+  // Pending tasks in the underlying queues might submit new tasks to each other
+  // during destruction.
+  Quiesce();
+
+  // Stop lending tasks before the queues are destroyed. Worker threads keep
+  // borrowing until they are joined, and members of the group are only
+  // accessed with the lock held.
+  if (share_group_) {
+    mutex_lock lock(share_group_->mu);
+    auto& members = share_group_->members;
+    members.erase(std::find(members.begin(), members.end(), this));
+  }
+}
+
+Optional<TaskFunction> TenantWorkQueue::Borrow() {
+  mutex_lock lock(share_group_->mu);
+  const auto& members = share_group_->members;
+  const unsigned num_members = members.size();
+  if (num_members < 2) return llvm::None;
+
+  const unsigned start = share_group_->next_member++;
+  for (unsigned i = 0; i < num_members; ++i) {
+    TenantWorkQueue* member = members[(start + i) % num_members];
+    if (member == this) continue;
+    if (Optional<TaskFunction> task = member->Lend()) return task;
+  }
+  return llvm::None;
+}
+
+Optional<TaskFunction> TenantWorkQueue::Lend() {
+  // Quiesce() only waits for the tasks added after it started, and for the
+  // lent tasks. Count the task before checking for quiescing, so that either
+  // Quiesce() sees the lent task or we see that the queue is quiescing.
+  num_lent_tasks_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (quiescing_state_->num_quiescing.load(std::memory_order_relaxed) > 0) {
+    num_lent_tasks_.fetch_sub(1, std::memory_order_release);
+    return llvm::None;
+  }
+
+  Optional<TaskFunction> task = non_blocking_work_queue_.Steal();
+  if (!task.has_value()) {
+    num_lent_tasks_.fetch_sub(1, std::memory_order_release);
+    return llvm::None;
+  }
+  return TaskFunction([this, task = std::move(*task)]() mutable {
+    task();
+    // Quiesce() might return and the queue might be destroyed right after
+    // the count drops, so this must be the last access to `this`.
+    num_lent_tasks_.fetch_sub(1, std::memory_order_release);
+  });
+}
+
+void TenantWorkQueue::AddTask(TaskFunction task) {
+  non_blocking_work_queue_.AddTask(std::move(task));
+}
+
+void TenantWorkQueue::AddTasks(MutableArrayRef<TaskFunction> tasks) {
+  non_blocking_work_queue_.AddTasks(tasks);
+}
+
+void TenantWorkQueue::AddTaskWithPriority(TaskFunction task,
+                                          TaskPriority priority) {
+  non_blocking_work_queue_.AddTask(std::move(task), priority);
+}
+
+void TenantWorkQueue::AddTasksWithPriority(MutableArrayRef<TaskFunction> tasks,
+                                           TaskPriority priority) {
+  non_blocking_work_queue_.AddTasks(tasks, priority);
+}
+
+void TenantWorkQueue::AddNextTask(TaskFunction task) {
+  non_blocking_work_queue_.AddNextTask(std::move(task));
+}
+
+Optional<TaskFunction> TenantWorkQueue::AddBlockingTask(TaskFunction task,
+                                                        bool allow_queuing) {
+  if (allow_queuing) {
+    return blocking_work_queue_.EnqueueBlockingTask(std::move(task));
+  } else {
+    return blocking_work_queue_.RunBlockingTask(std::move(task));
+  }
+}
+
+void TenantWorkQueue::Quiesce() {
+  // Turn on pending tasks counter inside both work queues.
+  auto quiescing = internal::Quiescing::Start(quiescing_state_.get());
+  // Pairs with the fence in Lend().
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  auto has_lent_tasks = [this] {
+    return num_lent_tasks_.load(std::memory_order_acquire) > 0;
+  };
+
+  non_blocking_work_queue_.Quiesce();
+  blocking_work_queue_.Quiesce();
+
+  // Tasks lent before quiescing started run in the worker threads of other
+  // queues, and might add more tasks to this queue.
+  while (quiescing.HasPendingTasks() || has_lent_tasks()) {
+    if (!quiescing.HasPendingTasks()) std::this_thread::yield();
+    non_blocking_work_queue_.Quiesce();
+    blocking_work_queue_.Quiesce();
+  }
+}
+
+void TenantWorkQueue::Await(ArrayRef<RCReference<AsyncValue>> values) {
+  // We might block on a latch waiting for the completion of all tasks, and
+  // this is not allowed to do inside non blocking work queue.
+  non_blocking_work_queue_.CheckCallerThread("TenantWorkQueue::Await");
+
+  // We are done when values_remaining drops to zero.
+  tfrt::latch values_remaining(values.size());
+
+  // As each value becomes available, we decrement the count.
+  for (auto& value : values) {
+    value->AndThen([&values_remaining]() { values_remaining.count_down(); });
+  }
+
+  // Wait until all values are resolved.
+  values_remaining.wait();
+}
+
+bool TenantWorkQueue::IsInWorkerThread() const {
+  return non_blocking_work_queue_.IsInWorkerThread();
+}
+
+int TenantWorkQueue::CurrentWorkerThreadId() const {
+  return non_blocking_work_queue_.CurrentThreadId();
+}
+
+void TenantWorkQueue::ExportMetrics() {
+  non_blocking_metrics_.Export(non_blocking_work_queue_.Stats());
+  blocking_metrics_.Export(blocking_work_queue_.Stats());
+}
+
+void TenantWorkQueue::EnableTaskLatencyMetrics(bool enable) {
+  non_blocking_work_queue_.SetTaskLatencyHistogram(
+      enable ? non_blocking_metrics_.task_latency_histogram() : nullptr);
+  blocking_work_queue_.SetTaskLatencyHistogram(
+      enable ? blocking_metrics_.task_latency_histogram() : nullptr);
+}
+
+std::unique_ptr<ConcurrentWorkQueue> CreateTenantWorkQueue(
+    const TenantWorkQueueOptions& options) {
+  int num_threads = options.num_threads;
+  if (num_threads == 0) {
+    num_threads = options.cpus.empty() ? std::thread::hardware_concurrency()
+                                       : options.cpus.size();
+  }
+  assert(num_threads > 0 && options.num_blocking_threads > 0);
+  return std::make_unique<TenantWorkQueue>(num_threads, options);
+}
+
+}  // namespace tfrt
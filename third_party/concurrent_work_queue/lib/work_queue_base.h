@@ -15,6 +15,14 @@
 // queue first, if the queue is empty it's going into a steal loop, and tries to
 // steal the next task from the other thread pending tasks queue.
 //
+// Each thread also has a "next task" slot, that a task running in the thread
+// can fill with its continuation (see NonBlockingWorkQueue::AddNextTask). The
+// thread runs the next task right after the current one, before the tasks in
+// its queue, so the continuation runs on the core that has its inputs in the
+// cache. The slot is private to its thread and can't be stolen. To prevent
+// starvation of the queued tasks, after `kMaxNextTasks` next tasks in a row
+// the thread takes a task from its queue first.
+//
 // If a thread was not able to find the next task function to execute, it's
 // parked on a conditional variable, and waits for the notification from the
 // new task added to the queue.
@@ -23,7 +31,9 @@
 // (controlled by `kMaxSpinningThreads` constant), and execute steal loop for a
 // fixed number of iterations. This allows to skip expensive park/unpark
 // operations, and reduces latency. Increasing `kMaxSpinningThreads` improves
-// latency at the cost of burned CPU cycles.
+// latency at the cost of burned CPU cycles. The spin loop can also be bounded
+// by a duration adapted to the recent task arrival rate, or disabled (see
+// SpinWaitMode).
 //
 // See derived work queue implementation for more details about work stealing.
 //
@@ -49,15 +59,21 @@
 #ifndef TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_WORK_QUEUE_BASE_H_
 #define TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_WORK_QUEUE_BASE_H_
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "event_count.h"
 #include "llvm/Support/Compiler.h"
 #include "task_queue.h"
+#include "tfrt/host_context/concurrent_work_queue.h"
 #include "tfrt/host_context/task_function.h"
+#include "tfrt/metrics/histogram.h"
 #include "tfrt/support/forward_decls.h"
 #include "tfrt/support/logging.h"
 #include "tfrt/support/mutex.h"
@@ -173,6 +189,46 @@ class PendingTask {
   QuiescingState* state_;
 };
 
+//===----------------------------------------------------------------------===//
+// Optional callbacks that customize worker threads of a work queue.
+//===----------------------------------------------------------------------===//
+struct WorkerHooks {
+  // Called in each worker thread before it starts executing tasks.
+  std::function<void(int thread_id)> on_thread_start;
+
+  // Called when a worker thread didn't find a task to steal in the queues of
+  // its own work queue, before it starts spinning or parks. Can return a task
+  // from other work queues, e.g. queues running on another NUMA node.
+  std::function<llvm::Optional<TaskFunction>()> steal_remote;
+};
+
+//===----------------------------------------------------------------------===//
+// Scheduler statistics of a work queue, aggregated from the per-worker
+// counters when they are read.
+//===----------------------------------------------------------------------===//
+struct WorkQueueStats {
+  int64_t num_tasks = 0;    // tasks executed by the worker threads
+  int64_t num_steals = 0;   // tasks found outside of the worker own queue
+  int64_t num_parks = 0;    // times a worker thread parked waiting for work
+  int64_t num_unparks = 0;  // times a parked worker thread was woken up
+  int64_t queue_depth = 0;  // estimated number of pending tasks
+
+  // Time spent by each worker thread between getting a task from its own
+  // queue and running out of them (running tasks, not stealing or parked).
+  std::vector<int64_t> busy_nanos;
+
+  // Adds statistics of another work queue, e.g. of another NUMA node.
+  void Add(const WorkQueueStats& other) {
+    num_tasks += other.num_tasks;
+    num_steals += other.num_steals;
+    num_parks += other.num_parks;
+    num_unparks += other.num_unparks;
+    queue_depth += other.queue_depth;
+    busy_nanos.insert(busy_nanos.end(), other.busy_nanos.begin(),
+                      other.busy_nanos.end());
+  }
+};
+
 //===----------------------------------------------------------------------===//
 // Work queue base class (derived by non-blocking and blocking work queues).
 //===----------------------------------------------------------------------===//
@@ -238,9 +294,26 @@ class WorkQueueBase {
     return per_thread->parent == &derived_;
   }
 
+  // Returns the number of worker threads managed by this work queue.
+  int NumThreads() const { return num_threads_; }
+
   // Stop all threads managed by this work queue.
   void Cancel();
 
+  // Returns the scheduler statistics accumulated since the work queue was
+  // created. Worker threads update their own counters without
+  // synchronization, so the statistics are a consistent snapshot only if the
+  // work queue is quiescent.
+  WorkQueueStats Stats() const;
+
+  // If `histogram` is not null, records the time in microseconds from adding
+  // each task to the work queue to starting it. This adds a clock read and a
+  // histogram update to every task, and is off by default. The histogram must
+  // outlive the work queue.
+  void SetTaskLatencyHistogram(metrics::Histogram* histogram) {
+    task_latency_histogram_.store(histogram, std::memory_order_relaxed);
+  }
+
  private:
   template <typename ThreadingEnvironment>
   friend class BlockingWorkQueue;
@@ -255,10 +328,31 @@ class WorkQueueBase {
     int thread_id;  // Worker thread index in the workers queue
   };
 
+  // Counters of a single worker thread. Only the owning thread updates them,
+  // so they are incremented without read-modify-write operations, and kept on
+  // their own cache line to avoid false sharing with the other workers.
+  struct alignas(64) WorkerStats {
+    static void Add(std::atomic<int64_t>& counter, int64_t value) {
+      counter.store(counter.load(std::memory_order_relaxed) + value,
+                    std::memory_order_relaxed);
+    }
+
+    std::atomic<int64_t> num_tasks{0};
+    std::atomic<int64_t> num_steals{0};
+    std::atomic<int64_t> num_parks{0};
+    std::atomic<int64_t> num_unparks{0};
+    std::atomic<int64_t> busy_nanos{0};
+    // Start of the current busy period, or -1 if the worker is idle.
+    std::atomic<int64_t> busy_since{-1};
+  };
+
   struct ThreadData {
     ThreadData() : thread(), queue() {}
     std::unique_ptr<Thread> thread;
     Queue queue;
+    WorkerStats stats;
+    // Accessed only by the owning worker thread.
+    llvm::Optional<TaskFunction> next_task;
   };
 
   // Returns a TaskFunction with an attached pending tasks counter, if the
@@ -270,6 +364,19 @@ class WorkQueueBase {
         });
   }
 
+  // Returns a TaskFunction that records its enqueue-to-start latency, if the
+  // task latency histogram is set.
+  TaskFunction WithTaskLatency(TaskFunction task) {
+    metrics::Histogram* histogram =
+        task_latency_histogram_.load(std::memory_order_relaxed);
+    if (histogram == nullptr) return task;
+    return TaskFunction([task = std::move(task), histogram,
+                         enqueued = NowNanos()]() mutable {
+      histogram->Record((NowNanos() - enqueued) / 1000.0);
+      task();
+    });
+  }
+
   // TODO(ezhulenev): Make this a runtime parameter? More spinning threads help
   // to reduce latency at the cost of wasted CPU cycles.
   static constexpr int kMaxSpinningThreads = 1;
@@ -288,8 +395,24 @@ class WorkQueueBase {
   // will be unparked, however this should be very rare in practice.
   static constexpr int kMinActiveThreadsToStartSpinning = 4;
 
+  // The maximum number of tasks a worker thread takes from its next task slot
+  // in a row, before it takes a task from its own queue.
+  static constexpr int kMaxNextTasks = 8;
+
+  // In SpinWaitMode::kAdaptive the spinning thread spins for twice the
+  // estimated idle time (from running out of tasks to getting the next one),
+  // and does not spin at all if the estimate exceeds the maximum spin time.
+  // Parking and unparking a thread takes tens of microseconds.
+  static constexpr int64_t kMaxAdaptiveSpinNanos = 50000;
+  static constexpr int64_t kInitialIdleNanos = kMaxAdaptiveSpinNanos / 4;
+
+  // Weight of the most recent idle time in the estimate, as a power of two.
+  static constexpr int kIdleNanosWeightLog2 = 3;
+
   explicit WorkQueueBase(QuiescingState* quiescing_state,
-                         string_view name_prefix, int num_threads);
+                         string_view name_prefix, int num_threads,
+                         WorkerHooks hooks = {},
+                         SpinWaitMode spin_wait_mode = SpinWaitMode::kFixed);
   ~WorkQueueBase();
 
   // Main worker thread loop.
@@ -299,6 +422,7 @@ class WorkQueueBase {
   // is time to exit (returns false). Can optionally return a task to execute in
   // `task` (in such case `task.has_value() == true` on return).
   [[nodiscard]] bool WaitForWork(EventCount::Waiter* waiter,
+                                 WorkerStats* stats,
                                  llvm::Optional<TaskFunction>* task);
 
   // StartSpinning() checks if the number of threads in the spin loop is less
@@ -314,6 +438,20 @@ class WorkQueueBase {
   // caller thread might have to call Steal() one more time.
   [[nodiscard]] bool StopSpinning();
 
+  // Returns the duration of the spin loop for SpinWaitMode::kAdaptive, zero if
+  // the spinning thread should park right away.
+  [[nodiscard]] int64_t AdaptiveSpinNanos() const;
+
+  // Updates the estimated idle time of the spinning threads with the time
+  // between running out of tasks and getting the next one.
+  void RecordIdleNanos(int64_t idle_nanos);
+
+  static int64_t NowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
   // IsNotifyParkedThreadRequired() returns true if parked thread must be
   // notified about new added task. If there are threads spinning in the steal
   // loop, there is no need to unpark any of the waiting threads, the task will
@@ -322,6 +460,11 @@ class WorkQueueBase {
 
   void Notify() { event_count_.Notify(false); }
 
+  // NotifyParkedThreads() wakes up parked threads after `num_tasks` tasks were
+  // added to the worker queues, at most one thread per task, skipping the
+  // tasks that will be picked up by the spinning threads.
+  void NotifyParkedThreads(int num_tasks);
+
   // Returns current thread id if the caller thread is managed by `this`,
   // returns `-1` otherwise.
   int CurrentThreadId() const;
@@ -340,6 +483,13 @@ class WorkQueueBase {
   unsigned NumActiveThreads() const { return num_threads_ - blocked_.load(); }
 
   const int num_threads_;
+  const WorkerHooks hooks_;
+  const SpinWaitMode spin_wait_mode_;
+
+  // Estimated idle time of the spinning threads for SpinWaitMode::kAdaptive.
+  std::atomic<int64_t> idle_nanos_;
+
+  std::atomic<metrics::Histogram*> task_latency_histogram_{nullptr};
 
   std::vector<ThreadData> thread_data_;
   std::vector<unsigned> coprimes_;
@@ -426,8 +576,13 @@ inline std::vector<unsigned> ComputeCoprimes(int n) {
 
 template <typename Derived>
 WorkQueueBase<Derived>::WorkQueueBase(QuiescingState* quiescing_state,
-                                      string_view name_prefix, int num_threads)
+                                      string_view name_prefix, int num_threads,
+                                      WorkerHooks hooks,
+                                      SpinWaitMode spin_wait_mode)
     : num_threads_(num_threads),
+      hooks_(std::move(hooks)),
+      spin_wait_mode_(spin_wait_mode),
+      idle_nanos_(kInitialIdleNanos),
       thread_data_(num_threads),
       coprimes_(ComputeCoprimes(num_threads)),
       blocked_(0),
@@ -528,7 +683,11 @@ void WorkQueueBase<Derived>::WorkerLoop(int thread_id) {
   pt->rng = FastRng(ThreadingEnvironment::ThisThreadIdHash());
   pt->thread_id = thread_id;
 
+  if (hooks_.on_thread_start) hooks_.on_thread_start(thread_id);
+
   Queue* q = &(thread_data_[thread_id].queue);
+  WorkerStats* stats = &(thread_data_[thread_id].stats);
+  Optional<TaskFunction>* next_task = &(thread_data_[thread_id].next_task);
   EventCount::Waiter* waiter = event_count_.waiter(thread_id);
 
   // TODO(dvyukov,rmlarsen): The time spent in NonEmptyQueueIndex() is
@@ -537,18 +696,56 @@ void WorkQueueBase<Derived>::WorkerLoop(int thread_id) {
   // constant was picked based on a fair dice roll, tune it.
   const int spin_count = num_threads_ > 0 ? kSpinCount / num_threads_ : 0;
 
+  const bool adaptive = spin_wait_mode_ == SpinWaitMode::kAdaptive;
+  const bool low_power = spin_wait_mode_ == SpinWaitMode::kLowPower;
+
+  // In the adaptive mode, the time when the thread ran out of tasks, if it
+  // was the spinning thread (other idle threads don't predict the arrival of
+  // the next task). Negative if the idle time is not measured.
+  int64_t idle_start = -1;
+
+  // Busy time is accounted when the worker runs out of tasks in its own queue,
+  // so that the clock is not read for every task.
+  int64_t busy_start = -1;
+
+  // The number of tasks taken from the next task slot in a row.
+  int num_next_tasks = 0;
+
   while (!cancelled_) {
-    Optional<TaskFunction> t = derived_.NextTask(q);
+    Optional<TaskFunction> t;
+    if (next_task->has_value() && num_next_tasks < kMaxNextTasks) {
+      ++num_next_tasks;
+      std::swap(t, *next_task);
+    } else {
+      num_next_tasks = 0;
+      t = derived_.NextTask(q);
+      // The next task slot is not visible to other threads, so we must not
+      // steal or park while it is occupied.
+      if (!t.has_value()) std::swap(t, *next_task);
+    }
     if (!t.has_value()) {
+      if (busy_start >= 0) {
+        WorkerStats::Add(stats->busy_nanos, NowNanos() - busy_start);
+        stats->busy_since.store(-1, std::memory_order_relaxed);
+        busy_start = -1;
+      }
+
       t = Steal();
+      if (!t.has_value() && hooks_.steal_remote) t = hooks_.steal_remote();
       if (!t.has_value()) {
         // Maybe leave thread spinning. This reduces latency.
-        const bool start_spinning = StartSpinning();
-        if (start_spinning) {
+        const bool start_spinning = !low_power && StartSpinning();
+        if (start_spinning && adaptive) {
+          if (idle_start < 0) idle_start = NowNanos();
+          const int64_t deadline = idle_start + AdaptiveSpinNanos();
+          while (!t.has_value() && NowNanos() < deadline) t = Steal();
+        } else if (start_spinning) {
           for (int i = 0; i < spin_count && !t.has_value(); ++i) {
             t = Steal();
           }
+        }
 
+        if (start_spinning) {
           const bool stopped_spinning = StopSpinning();
           // If a task was submitted to the queue without a call to
           // `event_count_.Notify()`, and we didn't steal anything above, we
@@ -561,13 +758,23 @@ void WorkQueueBase<Derived>::WorkerLoop(int thread_id) {
         }
 
         if (!t.has_value()) {
-          if (!WaitForWork(waiter, &t)) {
+          if (!WaitForWork(waiter, stats, &t)) {
             return;
           }
         }
       }
+      if (t.has_value()) WorkerStats::Add(stats->num_steals, 1);
     }
     if (t.has_value()) {
+      if (busy_start < 0) {
+        busy_start = NowNanos();
+        stats->busy_since.store(busy_start, std::memory_order_relaxed);
+        if (idle_start >= 0) {
+          RecordIdleNanos(busy_start - idle_start);
+          idle_start = -1;
+        }
+      }
+      WorkerStats::Add(stats->num_tasks, 1);
       (*t)();  // Execute a task.
     }
   }
@@ -575,6 +782,7 @@ void WorkQueueBase<Derived>::WorkerLoop(int thread_id) {
 
 template <typename Derived>
 bool WorkQueueBase<Derived>::WaitForWork(EventCount::Waiter* waiter,
+                                         WorkerStats* stats,
                                          llvm::Optional<TaskFunction>* task) {
   assert(!task->has_value());
   // We already did best-effort emptiness check in Steal, so prepare for
@@ -625,7 +833,9 @@ bool WorkQueueBase<Derived>::WaitForWork(EventCount::Waiter* waiter,
     return false;
   }
 
+  WorkerStats::Add(stats->num_parks, 1);
   event_count_.CommitWait(waiter);
+  WorkerStats::Add(stats->num_unparks, 1);
   blocked_.fetch_sub(1);
   return true;
 }
@@ -651,6 +861,22 @@ bool WorkQueueBase<Derived>::StartSpinning() {
   }
 }
 
+template <typename Derived>
+int64_t WorkQueueBase<Derived>::AdaptiveSpinNanos() const {
+  int64_t idle_nanos = idle_nanos_.load(std::memory_order_relaxed);
+  if (idle_nanos > kMaxAdaptiveSpinNanos) return 0;
+  return std::min(2 * idle_nanos, kMaxAdaptiveSpinNanos);
+}
+
+template <typename Derived>
+void WorkQueueBase<Derived>::RecordIdleNanos(int64_t idle_nanos) {
+  // Exponential moving average. Concurrent updates might be lost, which is
+  // fine for an estimate.
+  int64_t estimate = idle_nanos_.load(std::memory_order_relaxed);
+  estimate += (idle_nanos - estimate) >> kIdleNanosWeightLog2;
+  idle_nanos_.store(estimate, std::memory_order_relaxed);
+}
+
 template <typename Derived>
 bool WorkQueueBase<Derived>::StopSpinning() {
   uint64_t spinning = spinning_state_.load(std::memory_order_relaxed);
@@ -692,6 +918,21 @@ bool WorkQueueBase<Derived>::IsNotifyParkedThreadRequired() {
   }
 }
 
+template <typename Derived>
+void WorkQueueBase<Derived>::NotifyParkedThreads(int num_tasks) {
+  int num_notifications = 0;
+  for (int i = 0; i < num_tasks && num_notifications < num_threads_; ++i) {
+    if (IsNotifyParkedThreadRequired()) ++num_notifications;
+  }
+
+  if (num_notifications == num_threads_) {
+    event_count_.Notify(/*notify_all=*/true);
+    return;
+  }
+  for (int i = 0; i < num_notifications; ++i)
+    event_count_.Notify(/*notify_all=*/false);
+}
+
 template <typename Derived>
 int WorkQueueBase<Derived>::NonEmptyQueueIndex() {
   PerThread* pt = GetPerThread();
@@ -720,6 +961,28 @@ int WorkQueueBase<Derived>::CurrentThreadId() const {
   }
 }
 
+template <typename Derived>
+WorkQueueStats WorkQueueBase<Derived>::Stats() const {
+  WorkQueueStats stats;
+  stats.busy_nanos.reserve(num_threads_);
+  const int64_t now = NowNanos();
+  for (const ThreadData& thread_data : thread_data_) {
+    const WorkerStats& worker = thread_data.stats;
+    stats.num_tasks += worker.num_tasks.load(std::memory_order_relaxed);
+    stats.num_steals += worker.num_steals.load(std::memory_order_relaxed);
+    stats.num_parks += worker.num_parks.load(std::memory_order_relaxed);
+    stats.num_unparks += worker.num_unparks.load(std::memory_order_relaxed);
+    stats.queue_depth += thread_data.queue.Size();
+
+    // Include the current busy period of the workers that are running tasks.
+    int64_t busy_nanos = worker.busy_nanos.load(std::memory_order_relaxed);
+    int64_t busy_since = worker.busy_since.load(std::memory_order_relaxed);
+    if (busy_since >= 0) busy_nanos += std::max<int64_t>(0, now - busy_since);
+    stats.busy_nanos.push_back(busy_nanos);
+  }
+  return stats;
+}
+
 template <typename Derived>
 void WorkQueueBase<Derived>::Cancel() {
   cancelled_ = true;
@@ -0,0 +1,87 @@
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// WorkQueueMetrics definitions.
+
+#include "work_queue_metrics.h"
+
+#include <string>
+#include <utility>
+
+#include "llvm/ADT/StringMap.h"
+#include "tfrt/metrics/metrics.h"
+#include "tfrt/support/string_util.h"
+
+namespace tfrt {
+namespace internal {
+
+// Metrics are created once per name and shared by all work queues, because
+// they are never destroyed.
+static metrics::Counter* GetCounter(const std::string& name) {
+  static auto* mu = new mutex;
+  static auto* counters = new llvm::StringMap<metrics::Counter*>;
+  mutex_lock lock(*mu);
+  metrics::Counter*& counter = (*counters)[name];
+  if (counter == nullptr) counter = metrics::NewCounter(name);
+  return counter;
+}
+
+static metrics::Gauge<int64_t>* GetGauge(const std::string& name) {
+  static auto* mu = new mutex;
+  static auto* gauges = new llvm::StringMap<metrics::Gauge<int64_t>*>;
+  mutex_lock lock(*mu);
+  metrics::Gauge<int64_t>*& gauge = (*gauges)[name];
+  if (gauge == nullptr) gauge = metrics::NewGauge<int64_t>(name);
+  return gauge;
+}
+
+static metrics::Histogram* GetLatencyHistogram(const std::string& name) {
+  static auto* mu = new mutex;
+  static auto* histograms = new llvm::StringMap<metrics::Histogram*>;
+  mutex_lock lock(*mu);
+  metrics::Histogram*& histogram = (*histograms)[name];
+  if (histogram == nullptr) {
+    histogram = metrics::NewHistogram(
+        name, metrics::Buckets::Explicit({1, 2, 5, 10, 20, 50, 100, 200, 500,
+                                          1000, 2000, 5000, 10000, 100000}));
+  }
+  return histogram;
+}
+
+WorkQueueMetrics::WorkQueueMetrics(std::string prefix)
+    : prefix_(std::move(prefix)),
+      task_latency_histogram_(
+          GetLatencyHistogram(StrCat(prefix_, "task_latency_us"))) {}
+
+void WorkQueueMetrics::Export(const WorkQueueStats& stats) {
+  mutex_lock lock(mu_);
+
+  // Busy time of a running worker is an estimate, and might be smaller than
+  // the previously exported one, counters never go back.
+  auto increment = [&](string_view name, int64_t value, int64_t& exported) {
+    if (value <= exported) return;
+    GetCounter(StrCat(prefix_, name))->IncrementBy(value - exported);
+    exported = value;
+  };
+
+  increment("tasks", stats.num_tasks, exported_.tasks);
+  increment("steals", stats.num_steals, exported_.steals);
+  increment("parks", stats.num_parks, exported_.parks);
+  increment("unparks", stats.num_unparks, exported_.unparks);
+  GetGauge(StrCat(prefix_, "queue_depth"))->Set(stats.queue_depth);
+
+  if (exported_.worker_busy_us.size() < stats.busy_nanos.size())
+    exported_.worker_busy_us.resize(stats.busy_nanos.size());
+
+  int64_t busy_us = 0;
+  for (int i = 0; i < stats.busy_nanos.size(); ++i) {
+    increment(StrCat("worker_", i, "/busy_us"), stats.busy_nanos[i] / 1000,
+              exported_.worker_busy_us[i]);
+    busy_us += exported_.worker_busy_us[i];
+  }
+  increment("busy_us", busy_us, exported_.busy_us);
+}
+
+}  // namespace internal
+}  // namespace tfrt
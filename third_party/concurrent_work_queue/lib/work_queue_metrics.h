@@ -0,0 +1,67 @@
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// Exports scheduler statistics of a work queue to the metrics registry.
+//
+// Worker threads keep their statistics in per-worker counters (see
+// WorkQueueStats), and they are aggregated and pushed to the metrics registry
+// only when exported. Metric counters are incremented by the difference from
+// the previous export, so that work queues exporting under the same prefix
+// add up.
+
+#ifndef TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_WORK_QUEUE_METRICS_H_
+#define TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_WORK_QUEUE_METRICS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tfrt/metrics/histogram.h"
+#include "tfrt/support/mutex.h"
+#include "tfrt/support/thread_annotations.h"
+#include "work_queue_base.h"
+
+namespace tfrt {
+namespace internal {
+
+class WorkQueueMetrics {
+ public:
+  // Exports the following metrics under `prefix`, e.g.
+  // "/tfrt/work_queue/non_blocking/":
+  //
+  //   tasks, steals, parks, unparks, busy_us   counters
+  //   worker_<i>/busy_us                       counter for each worker thread
+  //   queue_depth                              gauge
+  //   task_latency_us                          histogram, see below
+  explicit WorkQueueMetrics(std::string prefix);
+
+  void Export(const WorkQueueStats& stats);
+
+  // Returns the histogram for WorkQueueBase::SetTaskLatencyHistogram().
+  metrics::Histogram* task_latency_histogram() const {
+    return task_latency_histogram_;
+  }
+
+ private:
+  const std::string prefix_;
+  metrics::Histogram* const task_latency_histogram_;
+
+  // Values of the counters at the previous export.
+  struct Exported {
+    int64_t tasks = 0;
+    int64_t steals = 0;
+    int64_t parks = 0;
+    int64_t unparks = 0;
+    int64_t busy_us = 0;
+    std::vector<int64_t> worker_busy_us;
+  };
+
+  mutex mu_;
+  Exported exported_ TFRT_GUARDED_BY(mu_);
+};
+
+}  // namespace internal
+}  // namespace tfrt
+
+#endif  // TFRT_THIRD_PARTY_CONCURRENT_WORK_QUEUE_WORK_QUEUE_METRICS_H_
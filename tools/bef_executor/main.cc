@@ -20,8 +20,11 @@
 #include <string>
 
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "tfrt/bef_executor/kernel_profiler.h"
 #include "tfrt/bef_executor_driver/bef_executor_driver.h"
 #include "tfrt/host_context/host_allocator.h"
+#include "tfrt/host_context/profiled_allocator.h"
 #include "tfrt/tracing/tracing.h"
 
 static llvm::cl::opt<std::string> cl_input_filename(  // NOLINT
@@ -60,7 +63,16 @@ static llvm::cl::opt<tfrt::HostAllocatorType> cl_host_allocator_type(  // NOLINT
         clEnumValN(tfrt::HostAllocatorType::kProfiledMalloc,
                    "profiled_allocator", "Malloc with metric profiling."),
         clEnumValN(tfrt::HostAllocatorType::kLeakCheckMalloc,
-                   "leak_check_allocator", "Malloc with memory leak check.")),
+                   "leak_check_allocator", "Malloc with memory leak check."),
+        clEnumValN(tfrt::HostAllocatorType::kSlab, "slab_allocator",
+                   "Slab allocator for small allocations."),
+        clEnumValN(tfrt::HostAllocatorType::kNuma, "numa_allocator",
+                   "NUMA node local allocator for large allocations."),
+        clEnumValN(tfrt::HostAllocatorType::kBufferPool,
+                   "buffer_pool_allocator",
+                   "Size-bucketed pool for tensor buffers."),
+        clEnumValN(tfrt::HostAllocatorType::kHugePage, "huge_page_allocator",
+                   "Huge page backed allocator for large allocations.")),
     llvm::cl::init(tfrt::HostAllocatorType::kLeakCheckMalloc));
 
 // Enable aggregate op handler types to be specified on the command line.
@@ -82,6 +94,63 @@ static llvm::cl::opt<bool> cl_print_error_code(  // NOLINT
     llvm::cl::desc("Print error code if there's any error."),
     llvm::cl::Optional, llvm::cl::ValueDisallowed);
 
+// Schedule outline kernels with work stealing in BEFExecutor.
+static llvm::cl::opt<bool> cl_work_stealing(  // NOLINT
+    "work_stealing",
+    llvm::cl::desc("Steal ready outline kernels between BEFExecutor workers."),
+    llvm::cl::Optional, llvm::cl::ValueDisallowed);
+
+// Profile the kernels executed by BEFExecutor.
+static llvm::cl::opt<bool> cl_profile_kernels(  // NOLINT
+    "profile_kernels",
+    llvm::cl::desc("Print a per-kernel profile of the executed functions."),
+    llvm::cl::Optional, llvm::cl::ValueDisallowed);
+
+static llvm::cl::list<std::string> cl_profile_functions(  // NOLINT
+    "profile_functions",
+    llvm::cl::desc("Only profile the kernels of these functions (and of the "
+                   "functions they call)."),
+    llvm::cl::ZeroOrMore, llvm::cl::MiscFlags::CommaSeparated);
+
+static llvm::cl::opt<int> cl_profile_sampling_period(  // NOLINT
+    "profile_sampling_period",
+    llvm::cl::desc("Profile one out of this many function executions."),
+    llvm::cl::init(1));
+
+static llvm::cl::opt<std::string> cl_kernel_cost_profile(  // NOLINT
+    "kernel_cost_profile",
+    llvm::cl::desc("Profile the kernels and write their mean time by location "
+                   "to this file, to be used by stream analysis through the "
+                   "tfrt.cost_profile module attribute."),
+    llvm::cl::init(""));
+
+// Sample the allocations of the profiled allocators by allocation site.
+static llvm::cl::opt<int64_t> cl_allocation_sampling_bytes(  // NOLINT
+    "allocation_sampling_bytes",
+    llvm::cl::desc("Sample one allocation per this many allocated bytes and "
+                   "print the top allocation sites with the allocator "
+                   "profile. Requires a profiled or leak check allocator."),
+    llvm::cl::init(0));
+
+static llvm::cl::opt<bool> cl_allocation_sampling_stack_traces(  // NOLINT
+    "allocation_sampling_stack_traces",
+    llvm::cl::desc("Attribute sampled allocations outside of kernels to their "
+                   "call stack."),
+    llvm::cl::Optional, llvm::cl::ValueDisallowed);
+
+// Run the functions repeatedly and print their throughput and latency.
+static llvm::cl::opt<int> cl_benchmark_runs(  // NOLINT
+    "benchmark_runs",
+    llvm::cl::desc("Run each function this many more times after the first "
+                   "run and print a latency summary."),
+    llvm::cl::init(0));
+
+static llvm::cl::opt<int> cl_max_in_flight(  // NOLINT
+    "max_in_flight",
+    llvm::cl::desc("Maximum number of benchmark runs of a function in flight "
+                   "at the same time."),
+    llvm::cl::init(1));
+
 //===----------------------------------------------------------------------===//
 // Driver main
 //===----------------------------------------------------------------------===//
@@ -98,10 +167,42 @@ int main(int argc, char** argv) {
   run_config.work_queue_type = cl_work_queue_type;
   run_config.host_allocator_type = cl_host_allocator_type;
   run_config.print_error_code = cl_print_error_code;
+  run_config.work_stealing = cl_work_stealing;
+  run_config.num_benchmark_runs = cl_benchmark_runs;
+  run_config.max_in_flight = cl_max_in_flight;
 
   llvm::Optional<tfrt::tracing::TracingRequester> tracing;
   if (cl_enable_tracing) tracing.emplace();
   tfrt::tracing::SetTracingLevel(cl_tracing_level);
 
-  return RunBefExecutor(run_config);
+  bool profile_kernels = cl_profile_kernels || !cl_kernel_cost_profile.empty();
+  if (profile_kernels) {
+    tfrt::KernelProfilerOptions options;
+    options.functions = cl_profile_functions;
+    options.sampling_period = cl_profile_sampling_period;
+    tfrt::EnableKernelProfiler(options);
+  }
+
+  if (cl_allocation_sampling_bytes > 0) {
+    tfrt::AllocationSamplingOptions options;
+    options.sampling_bytes = cl_allocation_sampling_bytes;
+    options.stack_traces = cl_allocation_sampling_stack_traces;
+    tfrt::EnableAllocationSampling(options);
+  }
+
+  int result = RunBefExecutor(run_config);
+
+  if (profile_kernels) tfrt::DisableKernelProfiler();
+  if (cl_profile_kernels) tfrt::PrintKernelProfiles(llvm::outs());
+  if (!cl_kernel_cost_profile.empty()) {
+    std::error_code error;
+    llvm::raw_fd_ostream os(cl_kernel_cost_profile, error);
+    if (error) {
+      llvm::errs() << "Failed to open " << cl_kernel_cost_profile << ": "
+                   << error.message() << "\n";
+      return 1;
+    }
+    tfrt::WriteKernelCostProfile(os);
+  }
+  return result;
 }